@@ -18,6 +18,9 @@ BINROOT="$ROOT/bin"
 COORD="oss"      # Coordinator type: oss or rlec
 DEBUG=0          # Debug build flag
 PROFILE=0        # Profile build flag
+LTO=0            # Link-time optimization, across the C/C++ and Rust code
+PGO=""           # Profile-guided optimization: gen (instrument) or use (optimize)
+PGO_DATA=""      # Merged profile to optimize with. Defaults to bin/pgo/redisearch.profdata
 FORCE=0          # Force clean build flag
 VERBOSE=0        # Verbose output flag
 QUICK=${QUICK:-0} # Quick test mode (subset of tests)
@@ -60,6 +63,18 @@ parse_arguments() {
       PROFILE|profile)
         PROFILE=1
         ;;
+      LTO|lto|LTO=1)
+        LTO=1
+        ;;
+      LTO=0)
+        LTO=0
+        ;;
+      PGO=*)
+        PGO="${arg#*=}"
+        ;;
+      PGO_DATA=*)
+        PGO_DATA="${arg#*=}"
+        ;;
       TESTS|tests)
         BUILD_TESTS=1
         ;;
@@ -180,6 +195,15 @@ setup_build_environment() {
   else
     FLAVOR="release"
   fi
+  # LTO and PGO builds are kept apart from the regular ones, and the instrumented one from both
+  if [[ "$LTO" == "1" ]]; then
+    FLAVOR="${FLAVOR}-lto"
+  fi
+  if [[ "$PGO" == "gen" ]]; then
+    FLAVOR="${FLAVOR}-pgo-gen"
+  elif [[ "$PGO" == "use" ]]; then
+    FLAVOR="${FLAVOR}-pgo"
+  fi
 
   # Determine the correct Rust profile for both build and tests
   # Only set RUST_PROFILE if it wasn't already set by the user
@@ -323,6 +347,27 @@ prepare_cmake_arguments() {
     fi
   fi
 
+  if [[ "$LTO" == "1" || -n "$PGO" ]]; then
+    if [[ "$DEBUG" == "1" ]]; then
+      echo "Error: Cannot run LTO or PGO builds with debug/sanitizer/coverage"
+      exit 1
+    fi
+    if [[ -n "$PGO" && "$PGO" != "gen" && "$PGO" != "use" ]]; then
+      echo "Error: PGO should be either gen or use"
+      exit 1
+    fi
+    # The C/C++ code is compiled by clang, so its bitcode and profiles can be combined with those
+    # of rustc
+    CMAKE_BASIC_ARGS="$CMAKE_BASIC_ARGS -DCMAKE_C_COMPILER=${CC:-clang} -DCMAKE_CXX_COMPILER=${CXX:-clang++}"
+    if [[ "$LTO" == "1" ]]; then
+      CMAKE_BASIC_ARGS="$CMAKE_BASIC_ARGS -DLTO=ON"
+    fi
+    if [[ -n "$PGO" ]]; then
+      CMAKE_BASIC_ARGS="$CMAKE_BASIC_ARGS -DPGO=$PGO -DPGO_RAW_DIR=$BINROOT/pgo/raw"
+      CMAKE_BASIC_ARGS="$CMAKE_BASIC_ARGS -DPGO_DATA=${PGO_DATA:-$BINROOT/pgo/redisearch.profdata}"
+    fi
+  fi
+
   # Set build type
   if [[ "$DEBUG" == "1" ]]; then
     CMAKE_BASIC_ARGS="$CMAKE_BASIC_ARGS -DCMAKE_BUILD_TYPE=Debug"
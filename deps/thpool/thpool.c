@@ -29,6 +29,8 @@
   }
 
 #define MAX_THPOOL_NAME_BUFFER_SIZE 11
+/* The maximal number of jobs a thread takes from the job queue at once, into its local job queue */
+#define THPOOL_LOCAL_BATCH 8
 /* ========================== ENUMS ============================ */
 
 typedef enum {
@@ -69,21 +71,29 @@ typedef struct {
   job *last_job;
 } jobsChain;
 
+/* Job queue */
 typedef struct {
+  job *front; /* pointer to front of queue */
+  job *rear;  /* pointer to rear  of queue */
+  int len;    /* number of jobs in queue   */
+} jobqueue;
+
+typedef struct threadCtx {
   ThreadState thread_state;
+  /* The jobs the thread took from the job queue in a batch, run before it pulls again. Only the
+   * thread pushes to it, while idle threads steal from it (holding the job queue lock) */
+  jobqueue local_jobqueue;
+  pthread_mutex_t local_lock;
+  struct threadCtx *next; /* next thread alive, guarded by the job queue lock */
+#if defined(__linux__)
+  clockid_t cpu_clock;    /* the CPU time clock of the thread */
+#endif
 } threadCtx;
 
 typedef struct {
   void *arg;
   threadCtx *thread_ctx;
 } adminJobArg;
-
-/* Job queue */
-typedef struct {
-  job *front; /* pointer to front of queue */
-  job *rear;  /* pointer to rear  of queue */
-  int len;    /* number of jobs in queue   */
-} jobqueue;
 typedef struct priority_queue {
   jobqueue high_priority_jobqueue;  /* job queue for high priority tasks */
   jobqueue low_priority_jobqueue;   /* job queue for low priority tasks */
@@ -99,6 +109,12 @@ typedef struct priority_queue {
   volatile atomic_size_t num_jobs_in_progress; /* threads currently working */
   volatile JobqueueState state; /* Indicates whether the threads should pull
                                    jobs from the jobq or sleep */
+  threadCtx *threads;           /* the threads alive, to steal jobs from */
+  size_t n_threads;             /* number of threads in `threads` */
+  size_t n_threads_waiting;     /* number of threads waiting on `has_jobs` */
+  volatile atomic_size_t num_local_jobs;   /* jobs in the local job queues of the threads */
+  volatile atomic_size_t lock_contentions; /* times the lock was found taken */
+  volatile atomic_size_t stolen_jobs;      /* jobs taken from the local job queue of another thread */
 } priorityJobqueue;
 
 /* Threadpool */
@@ -108,6 +124,7 @@ typedef struct redisearch_thpool_t {
   ThpoolState state;                          /* threadpool state, accessed only by the main thread */
   priorityJobqueue jobqueues;                 /* job queue                 */
   LogFunc log;                                /* log callback              */
+  ThreadStartFunc on_thread_start;            /* called by every thread when it starts */
   volatile atomic_size_t total_jobs_done;     /* statistics for observability */
   char name[MAX_THPOOL_NAME_BUFFER_SIZE];     /* thpool identifier to name its threads.
                                                 limited to 11 bytes length (including the
@@ -145,9 +162,15 @@ static void priority_queue_push_chain_unsafe(priorityJobqueue *priority_queue_p,
                                              job *first_newjob,
                                              job *last_newjob, size_t num,
                                              thpool_priority priority);
-static priorityJobCtx priority_queue_pull(priorityJobqueue *priority_queue_p);
-static inline priorityJobCtx priority_queue_pull_from_queues_unsafe(priorityJobqueue *priority_queue_p);
-static priorityJobCtx priority_queue_pull_no_wait(priorityJobqueue *priority_queue_p);
+static void priority_queue_lock(priorityJobqueue *priority_queue_p);
+static priorityJobCtx priority_queue_pull(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx);
+static inline priorityJobCtx priority_queue_pull_from_queues_unsafe(priorityJobqueue *priority_queue_p,
+                                                                    threadCtx *thread_ctx);
+static priorityJobCtx priority_queue_pull_no_wait(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx);
+static void priority_queue_fill_local_unsafe(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx,
+                                             bool prefer_high);
+static job *priority_queue_steal_unsafe(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx);
+static job *local_queue_pop(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx, bool ignore_pause);
 static void priority_queue_destroy(priorityJobqueue *priority_queue_p);
 static size_t priority_queue_len(priorityJobqueue *priority_queue_p);
 static size_t priority_queue_len_unsafe(priorityJobqueue *priority_queue_p);
@@ -168,7 +191,7 @@ static bool priority_queue_is_empty_unsafe(priorityJobqueue *jobqueue_p);
  * THREAD_RUNNING -> Standard pull function.
  * THREAD_TERMINATE_WHEN_EMPTY -> Modified pull function that returns immediately if the job queue is empty.
  */
-static priorityJobCtx (*const pull_and_execute_ht[2])(priorityJobqueue *) = {
+static priorityJobCtx (*const pull_and_execute_ht[2])(priorityJobqueue *, threadCtx *) = {
     priority_queue_pull, // THREAD_RUNNING
     priority_queue_pull_no_wait // THREAD_TERMINATE_WHEN_EMPTY
 
@@ -201,6 +224,7 @@ struct redisearch_thpool_t *redisearch_thpool_create(size_t num_threads, size_t
     return NULL;
   }
   thpool_p->log = log;
+  thpool_p->on_thread_start = NULL;
   thpool_p->n_threads = num_threads;
   thpool_p->num_threads_alive = 0;
   thpool_p->state = THPOOL_UNINITIALIZED;
@@ -570,16 +594,45 @@ thpool_stats redisearch_thpool_get_stats(redisearch_thpool_t *thpool_p) {
           thpool_p->jobqueues.low_priority_jobqueue.len,
       .admin_priority_pending_jobs =
           thpool_p->jobqueues.admin_priority_jobqueue.len,
-      .total_pending_jobs = priority_queue_len_unsafe(&thpool_p->jobqueues),
+      .total_pending_jobs = priority_queue_len_unsafe(&thpool_p->jobqueues) +
+                            thpool_p->jobqueues.num_local_jobs,
+      .local_pending_jobs = thpool_p->jobqueues.num_local_jobs,
       .num_threads_alive = thpool_p->num_threads_alive,
+      .lock_contentions = thpool_p->jobqueues.lock_contentions,
+      .stolen_jobs = thpool_p->jobqueues.stolen_jobs,
   };
   redisearch_thpool_unlock(thpool_p);
   return res;
 }
 
+size_t redisearch_thpool_get_threads_cpu_time(redisearch_thpool_t *thpool_p, uint64_t *cpu_time_ns,
+                                              size_t max) {
+  redisearch_thpool_lock(thpool_p);
+  size_t n = 0;
+  for (threadCtx *t = thpool_p->jobqueues.threads; t; t = t->next, n++) {
+    if (n >= max) {
+      continue;
+    }
+    cpu_time_ns[n] = 0;
+#if defined(__linux__)
+    /* The thread unregisters (under the lock) before it exits, so its clock is still valid */
+    struct timespec ts;
+    if (t->cpu_clock != (clockid_t)-1 && clock_gettime(t->cpu_clock, &ts) == 0) {
+      cpu_time_ns[n] = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+#endif
+  }
+  redisearch_thpool_unlock(thpool_p);
+  return n;
+}
+
+void redisearch_thpool_set_on_thread_start(redisearch_thpool_t *thpool_p, ThreadStartFunc cb) {
+  thpool_p->on_thread_start = cb;
+}
+
 /* ============ INTERNAL UTILS ============ */
 static void redisearch_thpool_lock(redisearch_thpool_t *thpool_p) {
-  pthread_mutex_lock(&thpool_p->jobqueues.lock);
+  priority_queue_lock(&thpool_p->jobqueues);
 }
 
 static void redisearch_thpool_unlock(redisearch_thpool_t *thpool_p) {
@@ -599,6 +652,12 @@ void redisearch_thpool_pause_threads(redisearch_thpool_t *thpool_p) {
 void redisearch_thpool_pause_threads_no_wait(redisearch_thpool_t *thpool_p) {
   redisearch_thpool_lock(thpool_p);
   thpool_p->jobqueues.state = JOBQ_PAUSED;
+  /* Threads pop their local jobs without the job queue lock. Once we went through their local
+   * locks, any thread which didn't see the new state is already counted in progress */
+  for (threadCtx *t = thpool_p->jobqueues.threads; t; t = t->next) {
+    pthread_mutex_lock(&t->local_lock);
+    pthread_mutex_unlock(&t->local_lock);
+  }
   redisearch_thpool_unlock(thpool_p);
 }
 
@@ -662,15 +721,32 @@ static void *thread_do(redisearch_thpool_t *thpool_p) {
 
   LOG_IF_EXISTS("verbose", "Creating background thread: %s", thread_name)
 
+  if (thpool_p->on_thread_start) {
+    thpool_p->on_thread_start();
+  }
+
+  threadCtx thread_ctx = {.thread_state = THREAD_RUNNING};
+#if defined(__linux__)
+  if (pthread_getcpuclockid(pthread_self(), &thread_ctx.cpu_clock) != 0) {
+    thread_ctx.cpu_clock = (clockid_t)-1;
+  }
+#endif
+  jobqueue_init(&thread_ctx.local_jobqueue);
+  pthread_mutex_init(&thread_ctx.local_lock, NULL);
+  redisearch_thpool_lock(thpool_p);
+  thread_ctx.next = thpool_p->jobqueues.threads;
+  thpool_p->jobqueues.threads = &thread_ctx;
+  thpool_p->jobqueues.n_threads++;
+  redisearch_thpool_unlock(thpool_p);
+
   /* Mark thread as alive (initialized) */
   thpool_p->num_threads_alive += 1;
-  threadCtx thread_ctx = {.thread_state = THREAD_RUNNING};
 
   while (true) {
     /** Read job from queue and execute it.
      * @note At this point the thread state can be either RUNNING or TERMINATE_WHEN_EMPTY which
      * are the only valid indices of pull_and_execute_ht. */
-    priorityJobCtx job_ctx = pull_and_execute_ht[thread_ctx.thread_state](&thpool_p->jobqueues);
+    priorityJobCtx job_ctx = pull_and_execute_ht[thread_ctx.thread_state](&thpool_p->jobqueues, &thread_ctx);
     if (job_ctx.job) {
       job *job_p = job_ctx.job;
       void *arg = job_p->arg;
@@ -711,6 +787,16 @@ static void *thread_do(redisearch_thpool_t *thpool_p) {
   }
 
   LOG_IF_EXISTS("verbose", "Terminating thread %s", thread_name)
+  /* A thread pulls from the job queue only once its local job queue is empty, so no job is left
+   * behind in it */
+  for (threadCtx **t = &thpool_p->jobqueues.threads; *t; t = &(*t)->next) {
+    if (*t == &thread_ctx) {
+      *t = thread_ctx.next;
+      break;
+    }
+  }
+  thpool_p->jobqueues.n_threads--;
+  pthread_mutex_destroy(&thread_ctx.local_lock);
   thpool_p->num_threads_alive--;
   redisearch_thpool_unlock(thpool_p);
 
@@ -847,6 +933,12 @@ static int priority_queue_init(priorityJobqueue *priority_queue_p,
   priority_queue_p->high_priority_tickets = high_priority_bias_threshold;
   priority_queue_p->state = JOBQ_RUNNING;
   priority_queue_p->num_jobs_in_progress = 0;
+  priority_queue_p->threads = NULL;
+  priority_queue_p->n_threads = 0;
+  priority_queue_p->n_threads_waiting = 0;
+  priority_queue_p->num_local_jobs = 0;
+  priority_queue_p->lock_contentions = 0;
+  priority_queue_p->stolen_jobs = 0;
   pthread_cond_init(&(priority_queue_p->has_jobs), NULL);
 
   return 0;
@@ -883,27 +975,64 @@ static void priority_queue_push_chain_unsafe(priorityJobqueue *priority_queue_p,
   }
 }
 
-static priorityJobCtx priority_queue_pull_no_wait(priorityJobqueue *priority_queue_p) {
-  priorityJobCtx job_ctx;
-  pthread_mutex_lock(&priority_queue_p->lock);
-  job_ctx = priority_queue_pull_from_queues_unsafe(priority_queue_p);
+static void priority_queue_lock(priorityJobqueue *priority_queue_p) {
+  if (pthread_mutex_trylock(&priority_queue_p->lock) != 0) {
+    priority_queue_p->lock_contentions++;
+    pthread_mutex_lock(&priority_queue_p->lock);
+  }
+}
+
+/* Wake up a waiting thread if there are jobs left it could take, from the job queue or from the
+ * local job queue of another thread. Must hold the lock */
+static void priority_queue_wake_idle_unsafe(priorityJobqueue *priority_queue_p) {
+  if (priority_queue_p->n_threads_waiting &&
+      (priority_queue_len_unsafe(priority_queue_p) || priority_queue_p->num_local_jobs)) {
+    pthread_cond_signal(&priority_queue_p->has_jobs);
+  }
+}
+
+static priorityJobCtx priority_queue_pull_no_wait(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx) {
+  priorityJobCtx job_ctx = {.job = local_queue_pop(priority_queue_p, thread_ctx, true)};
+  if (job_ctx.job) return job_ctx;
+
+  priority_queue_lock(priority_queue_p);
+  if (priority_queue_len_unsafe(priority_queue_p)) {
+    job_ctx = priority_queue_pull_from_queues_unsafe(priority_queue_p, thread_ctx);
+  } else {
+    job_ctx.job = priority_queue_steal_unsafe(priority_queue_p, thread_ctx);
+  }
   pthread_mutex_unlock(&priority_queue_p->lock);
   return job_ctx;
 }
-static priorityJobCtx priority_queue_pull(priorityJobqueue *priority_queue_p) {
-  priorityJobCtx job_ctx;
-  pthread_mutex_lock(&priority_queue_p->lock);
-  while (priority_queue_len_unsafe(priority_queue_p) == 0 ||
-         (priority_queue_p->state == JOBQ_PAUSED)) {
+static priorityJobCtx priority_queue_pull(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx) {
+  priorityJobCtx job_ctx = {.job = local_queue_pop(priority_queue_p, thread_ctx, false)};
+  if (job_ctx.job) return job_ctx;
+
+  priority_queue_lock(priority_queue_p);
+  while (true) {
+    if (priority_queue_p->state != JOBQ_PAUSED) {
+      /* Local jobs may be left if the queue was paused */
+      job_ctx.job = local_queue_pop(priority_queue_p, thread_ctx, false);
+      if (job_ctx.job) break;
+      if (priority_queue_len_unsafe(priority_queue_p)) {
+        job_ctx = priority_queue_pull_from_queues_unsafe(priority_queue_p, thread_ctx);
+        break;
+      }
+      job_ctx.job = priority_queue_steal_unsafe(priority_queue_p, thread_ctx);
+      if (job_ctx.job) break;
+    }
+    priority_queue_p->n_threads_waiting++;
     pthread_cond_wait(&priority_queue_p->has_jobs, &priority_queue_p->lock);
+    priority_queue_p->n_threads_waiting--;
   }
 
-  job_ctx = priority_queue_pull_from_queues_unsafe(priority_queue_p);
+  priority_queue_wake_idle_unsafe(priority_queue_p);
   pthread_mutex_unlock(&priority_queue_p->lock);
   return job_ctx;
 }
-static inline priorityJobCtx priority_queue_pull_from_queues_unsafe(priorityJobqueue *priority_queue_p) {
-  bool is_admin = true, has_priority_ticket = false;
+static inline priorityJobCtx priority_queue_pull_from_queues_unsafe(priorityJobqueue *priority_queue_p,
+                                                                    threadCtx *thread_ctx) {
+  bool is_admin = true, has_priority_ticket = false, prefer_high = false;
   job *job_p = NULL;
   /* Pull from the admin queue first */
   job_p = jobqueue_pull(&priority_queue_p->admin_priority_jobqueue);
@@ -912,7 +1041,8 @@ static inline priorityJobCtx priority_queue_pull_from_queues_unsafe(priorityJobq
     is_admin = false;
     /* When taking a high priority ticket, we must hold the lock
      (read-and-then-update not atomic) */
-    if (priority_queue_p->high_priority_tickets > 0) {
+    prefer_high = priority_queue_p->high_priority_tickets > 0;
+    if (prefer_high) {
       /* Prefer high priority jobs, try taking from the high priority queue. */
       job_p = jobqueue_pull(&priority_queue_p->high_priority_jobqueue);
       if (job_p) {
@@ -948,6 +1078,9 @@ static inline priorityJobCtx priority_queue_pull_from_queues_unsafe(priorityJobq
    * from the queue since we may want to check the jobq length and
    * num_jobs_in_progress together. */
   if (job_p) priority_queue_p->num_jobs_in_progress++;
+  if (job_p && !is_admin) {
+    priority_queue_fill_local_unsafe(priority_queue_p, thread_ctx, prefer_high);
+  }
   priorityJobCtx job_ctx = {
       .job = job_p,
       .is_admin = is_admin,
@@ -956,6 +1089,97 @@ static inline priorityJobCtx priority_queue_pull_from_queues_unsafe(priorityJobq
   return job_ctx;
 }
 
+/* When the backlog has a job for each thread, take a share of it to the local job queue of the
+ * thread (up to THPOOL_LOCAL_BATCH jobs with the one pulled), so that a busy pool takes the lock
+ * once per batch. The jobs are taken in the order the thread would have pulled them one by one,
+ * though only the first of them holds a priority ticket. Must hold the lock */
+static void priority_queue_fill_local_unsafe(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx,
+                                             bool prefer_high) {
+  jobqueue *high = &priority_queue_p->high_priority_jobqueue;
+  jobqueue *low = &priority_queue_p->low_priority_jobqueue;
+  size_t backlog = high->len + low->len;
+  size_t n_threads = priority_queue_p->n_threads;
+  if (!n_threads || backlog < n_threads) return;
+  size_t n = backlog / n_threads;
+  if (n > THPOOL_LOCAL_BATCH - 1) n = THPOOL_LOCAL_BATCH - 1;
+
+  pthread_mutex_lock(&thread_ctx->local_lock);
+  for (size_t i = 0; i < n; i++) {
+    job *job_p;
+    if (prefer_high || priority_queue_p->alternating_pulls % 2 == 0) {
+      job_p = jobqueue_pull(high);
+      if (!job_p) job_p = jobqueue_pull(low);
+    } else {
+      job_p = jobqueue_pull(low);
+      if (!job_p) job_p = jobqueue_pull(high);
+    }
+    if (!prefer_high) priority_queue_p->alternating_pulls++;
+    jobqueue_push_chain(&thread_ctx->local_jobqueue, job_p, job_p, 1);
+    priority_queue_p->num_local_jobs++;
+  }
+  pthread_mutex_unlock(&thread_ctx->local_lock);
+}
+
+/* Steal half of the local jobs of the thread with the most of them. The first one is returned for
+ * the thread to run, the others are moved to its own local job queue (which is empty). Must hold
+ * the lock, so that a single thread steals at a time */
+static job *priority_queue_steal_unsafe(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx) {
+  threadCtx *victim = NULL;
+  int max_len = 0;
+  for (threadCtx *t = priority_queue_p->threads; t; t = t->next) {
+    if (t == thread_ctx) continue;
+    pthread_mutex_lock(&t->local_lock);
+    int len = t->local_jobqueue.len;
+    pthread_mutex_unlock(&t->local_lock);
+    if (len > max_len) {
+      victim = t;
+      max_len = len;
+    }
+  }
+  if (!victim) return NULL;
+
+  job *job_p = NULL;
+  jobqueue stolen;
+  jobqueue_init(&stolen);
+  pthread_mutex_lock(&victim->local_lock);
+  /* The victim may have run some of its jobs since */
+  size_t n = (victim->local_jobqueue.len + 1) / 2;
+  if (n) {
+    job_p = jobqueue_pull(&victim->local_jobqueue);
+    for (size_t i = 1; i < n; i++) {
+      job *stolen_p = jobqueue_pull(&victim->local_jobqueue);
+      jobqueue_push_chain(&stolen, stolen_p, stolen_p, 1);
+    }
+    /* Counted in progress before it leaves the local jobs, so the incomplete jobs never dip */
+    priority_queue_p->num_jobs_in_progress++;
+    priority_queue_p->num_local_jobs--;
+    priority_queue_p->stolen_jobs += n;
+  }
+  pthread_mutex_unlock(&victim->local_lock);
+
+  if (stolen.len) {
+    pthread_mutex_lock(&thread_ctx->local_lock);
+    jobqueue_push_chain(&thread_ctx->local_jobqueue, stolen.front, stolen.rear, stolen.len);
+    pthread_mutex_unlock(&thread_ctx->local_lock);
+  }
+  return job_p;
+}
+
+/* Pop the next job of the local job queue of the thread, unless the queue is paused */
+static job *local_queue_pop(priorityJobqueue *priority_queue_p, threadCtx *thread_ctx, bool ignore_pause) {
+  job *job_p = NULL;
+  pthread_mutex_lock(&thread_ctx->local_lock);
+  if (ignore_pause || priority_queue_p->state != JOBQ_PAUSED) {
+    job_p = jobqueue_pull(&thread_ctx->local_jobqueue);
+    if (job_p) {
+      priority_queue_p->num_jobs_in_progress++;
+      priority_queue_p->num_local_jobs--;
+    }
+  }
+  pthread_mutex_unlock(&thread_ctx->local_lock);
+  return job_p;
+}
+
 static void priority_queue_destroy(priorityJobqueue *priority_queue_p) {
   jobqueue_destroy(&priority_queue_p->high_priority_jobqueue);
   jobqueue_destroy(&priority_queue_p->low_priority_jobqueue);
@@ -989,7 +1213,7 @@ static size_t priority_queue_num_incomplete_jobs(priorityJobqueue *priority_queu
   size_t ret = 0;
   pthread_mutex_lock(&priority_queue_p->lock);
   ret = priority_queue_len_unsafe(priority_queue_p) +
-        priority_queue_p->num_jobs_in_progress;
+        priority_queue_p->num_jobs_in_progress + priority_queue_p->num_local_jobs;
   pthread_mutex_unlock(&priority_queue_p->lock);
   return ret;
 }
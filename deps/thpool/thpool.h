@@ -7,6 +7,7 @@
 #ifndef _THPOOL_
 #define _THPOOL_
 #include <stddef.h>
+#include <stdint.h>
 
 #define DEFAULT_HIGH_PRIORITY_BIAS_THRESHOLD 1
 
@@ -31,11 +32,16 @@ typedef struct {
   unsigned long high_priority_pending_jobs;
   unsigned long low_priority_pending_jobs;
   unsigned long admin_priority_pending_jobs;
+  unsigned long local_pending_jobs;  // taken by the threads in batches, included in total_pending_jobs
   unsigned long num_threads_alive;
+  unsigned long lock_contentions;    // times a thread or a producer found the job queue locked
+  unsigned long stolen_jobs;         // jobs an idle thread took from the local jobs of another
 } thpool_stats;
 
 // A callback to call redis log.
 typedef void (*LogFunc)(const char *, const char *, ...);
+/* Called by a thread of the pool when it starts */
+typedef void (*ThreadStartFunc)(void);
 
 /**
  * @brief  Create a new threadpool (without initializing the threads)
@@ -296,6 +302,24 @@ thpool_stats redisearch_thpool_get_stats(redisearch_thpool_t *);
 
 size_t redisearch_thpool_get_num_threads(redisearch_thpool_t *);
 
+/**
+ * @brief Get the CPU time the threads of the pool consumed
+ *
+ * Fills `cpu_time_ns` with the CPU time (in nanoseconds) of up to `max` of the threads alive, which
+ * is 0 on systems where it is not available.
+ *
+ * @return the number of threads alive
+ */
+size_t redisearch_thpool_get_threads_cpu_time(redisearch_thpool_t *, uint64_t *cpu_time_ns, size_t max);
+
+/**
+ * @brief Set a function every thread of the pool calls when it starts, before it runs any job
+ *
+ * Applies to the threads started after the call, so it should be set before the pool is
+ * initialized (e.g. to pin the threads to some CPUs).
+ */
+void redisearch_thpool_set_on_thread_start(redisearch_thpool_t *, ThreadStartFunc cb);
+
 #ifdef __cplusplus
 }
 #endif
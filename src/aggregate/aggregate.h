@@ -22,6 +22,7 @@
 #include "vector_index.h"
 #include "hybrid/vector_query_utils.h"
 #include "slot_ranges.h"
+#include "util/arena.h"
 
 #include "rmutil/rm_assert.h"
 
@@ -35,6 +36,8 @@ extern "C" {
 typedef struct {
   RLookup *lastLookup;
   const PLN_ArrangeStep *lastAstp;
+  struct BinaryRowsWriter *binaryRows;  // Set when the rows are sent in the binary encoding
+  struct ArrowExportWriter *arrowExport;  // Set on FT.EXPORT, see AREQ::arrowExport
 } cachedVars;
 
 typedef struct Grouper Grouper;
@@ -119,6 +122,21 @@ typedef enum {
   // Currently only used in when QEXEC_F_IS_HYBRID_TAIL is set - i.e this is the tail part
   QEXEC_F_NO_SORT = 0x4000000,
 
+  // Send the fields of the rows in the binary encoding of binary_rows.h rather than in RESP
+  // (coordinator only, with QEXEC_F_TYPED)
+  QEXEC_F_BINARY_ROWS = 0x8000000,
+
+  // Send the revision of the index after the cursor id of each chunk (coordinator only, to
+  // invalidate the rows it cached)
+  QEXEC_F_SEND_REVISION = 0x10000000,
+
+  // The query is profiled into the totals of the sampled profile (see info/profile_stats.h),
+  // without replying with its profile
+  QEXEC_F_PROFILE_SAMPLED = 0x20000000,
+
+  // The terms of the ranked query may be read from their impact postings (see impact_postings.h)
+  QEXEC_F_IMPACT_POSTINGS = 0x40000000,
+
   // The query is for debugging. Note that this is the last bit of uint32_t
   QEXEC_F_DEBUG = 0x80000000,
 
@@ -195,9 +213,20 @@ typedef struct AREQ {
   /** Parsed query tree */
   QueryAST ast;
 
+  /** The objects which live as long as the request (so far, the nodes of its query tree) */
+  Arena arena;
+
   /** Root iterator. This is owned by the request */
   QueryIterator *rootiter;
 
+  /** The root iterators of the other doc-id ranges, when the ranges of the query are read in
+   *  parallel (see `RPQueryRanges`), as an array. NULL otherwise. These are owned by the request */
+  QueryIterator **rangeRoots;
+
+  /** The estimated cost of the query (see `QueryAdmission_Cost`), set once its iterators are built
+   *  when the admission control of heavy queries is enabled */
+  size_t estimatedCost;
+
   /** Context, owned by request */
   RedisSearchCtx *sctx;
 
@@ -257,6 +286,20 @@ typedef struct AREQ {
 
   // The offset of the prefixes in the command
   size_t prefixesOffset;
+
+  // Sent by the coordinator with `_SCORE_THRESHOLD`: a search sorted by score only returns the
+  // results scoring at least this much, as the others can't make it into its top results
+  double scoreThreshold;
+  bool hasScoreThreshold;
+
+  // For a query of a FT.SEARCH batch, the parameter set to one of the values of `BATCH`, added to
+  // those of `PARAMS`. Only read while the request is prepared
+  RedisModuleString *batchParam;
+  RedisModuleString *batchValue;
+
+  // Set on FT.EXPORT, which replies with the rows as an Arrow IPC stream split between the chunks
+  // of the reply. Owned by the request, as it keeps the schema of the stream for the later chunks
+  struct ArrowExportWriter *arrowExport;
 } AREQ;
 
 /**
@@ -351,6 +394,15 @@ static inline RedisSearchCtx *AREQ_SearchCtx(AREQ *req) {
   return req->sctx;
 }
 
+/* Set the token cancelling the query, checked by its result processors and (through its search
+ * context) by its iterators */
+static inline void AREQ_SetCancelToken(AREQ *req, const QueryCancelToken *token) {
+  req->pipeline.qctx.cancel = token;
+  if (req->sctx) {
+    req->sctx->time.cancel = token;
+  }
+}
+
 static inline AGGPlan *AREQ_AGGPlan(AREQ *req) {
   return &req->pipeline.ap;
 }
@@ -403,12 +455,32 @@ void Grouper_Free(Grouper *g);
  */
 ResultProcessor *Grouper_GetRP(Grouper *gr);
 
+/**
+ * Whether the result processor of a grouper has grouped all of its upstream, and is yielding its
+ * groups
+ */
+bool Grouper_HoldsAllResults(const ResultProcessor *rp);
+
 /**
  * Adds a reducer to the grouper. This must be called before any results are
  * processed by the grouper.
  */
 void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dst);
 
+/**
+ * Declares that the results reach the grouper sorted by its keys, so that the
+ * results of each group are contiguous. Each group is then yielded as soon as
+ * a result of the next group is read, rather than once all the results are
+ * accumulated.
+ */
+void Grouper_SetSortedInput(Grouper *g);
+
+/**
+ * Replies with the names of the reducers of the grouper result processor which
+ * approximated their results to stay within their memory budget, if any
+ */
+void Grouper_ReplyApproximated(RedisModule_Reply *reply, const ResultProcessor *rp);
+
 void AREQ_Execute(AREQ *req, RedisModuleCtx *outctx);
 int prepareExecutionPlan(AREQ *req, QueryError *status);
 void sendChunk(AREQ *req, RedisModule_Reply *reply, size_t limit);
@@ -447,6 +519,13 @@ int parseValueFormat(uint32_t *flags, ArgsCursor *ac, QueryError *status);
 int parseTimeout(long long *timeout, ArgsCursor *ac, QueryError *status);
 int SetValueFormat(bool is_resp3, bool is_json, uint32_t *flags, QueryError *status);
 void SetSearchCtx(RedisSearchCtx *sctx, const AREQ *req);
+
+#define SEARCH_BATCH_MAX_VALUES 1024
+
+/* The offset of `BATCH <param> <count> <value>...` at the end of a FT.SEARCH command, which runs its
+ * query once for each of the values of the parameter, or 0 when the command has none */
+int AREQ_SearchBatchOffset(RedisModuleString **argv, int argc);
+
 int prepareRequest(AREQ **r_ptr, RedisModuleCtx *ctx, RedisModuleString **argv, int argc, CommandType type, int execOptions, QueryError *status);
 
 
@@ -21,6 +21,8 @@
 #include "resp3.h"
 #include "query_error.h"
 #include "info/global_stats.h"
+#include "info/latency_stats.h"
+#include "info/profile_stats.h"
 #include "aggregate_debug.h"
 #include "info/info_redis/block_client.h"
 #include "info/info_redis/threads/current_thread.h"
@@ -29,12 +31,22 @@
 #include "hybrid/hybrid_request.h"
 #include "module.h"
 #include "result_processor.h"
+#include "query_admission.h"
+#include "binary_rows.h"
+#include "arrow_export.h"
+#include "param.h"
+#include "geo_index.h"
+#include "aggregate/expr/expression.h"
+#include "search_cache.h"
+#include "slowlog.h"
+#include "hiredis/sds.h"
 
 typedef enum {
   EXEC_NO_FLAGS = 0x00,
   EXEC_WITH_PROFILE = 0x01,
   EXEC_WITH_PROFILE_LIMITED = 0x02,
   EXEC_DEBUG = 0x04,
+  EXEC_ARROW_EXPORT = 0x08,
 } ExecOptions;
 
 // Multi threading data structure
@@ -42,9 +54,16 @@ typedef struct {
   AREQ *req;
   RedisModuleBlockedClient *blockedClient;
   WeakRef spec_ref;
+  // Whether the query was admitted to run in its cost class (see `QueryAdmission_Enter`)
+  QueryCostClass costClass;
+  bool admitted;
+  // The reference keeping the spec alive while the query waits to be admitted
+  StrongRef parked_ref;
+  // When the query was added to the queue of the workers
+  rs_wall_clock queuedClock;
 } blockedClientReqCtx;
 
-static void runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num);
+static bool runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num, bool readAhead);
 
 /**
  * Get the sorting key of the result. This will be the sorting key of the last
@@ -107,8 +126,158 @@ static void reeval_key(RedisModule_Reply *reply, const RSValue *key) {
   }
 }
 
-static size_t serializeResult(AREQ *req, RedisModule_Reply *reply, const SearchResult *r,
-                              const cachedVars *cv) {
+/* The value of a field to reply with. Which value of a trio is used depends on the format */
+static const RSValue *replyFieldValue(const RSValue *v, SendReplyFlags flags, unsigned int apiVersion) {
+  if (RSValue_IsTrio(v)) {
+    // Which value to use for duo value
+    if (!(flags & SENDREPLY_FLAG_EXPAND)) {
+      // STRING
+      if (apiVersion >= APIVERSION_RETURN_MULTI_CMP_FIRST) {
+        // Multi
+        v = RSValue_Trio_GetMiddle(v);
+      } else {
+        // Single
+        v = RSValue_Trio_GetLeft(v);
+      }
+    } else {
+      // EXPAND
+      v = RSValue_Trio_GetRight(v);
+    }
+  }
+  return v;
+}
+
+/* Whether the rows of the request are sent in the binary encoding. Only the fields of the rows
+ * are encoded, so it is used when nothing else is sent with them */
+static bool useBinaryRows(const AREQ *req) {
+  const uint32_t options = AREQ_RequestFlags(req);
+  return !req->arrowExport && (options & QEXEC_F_BINARY_ROWS) && (options & QEXEC_F_TYPED) &&
+         !(options & (QEXEC_F_IS_SEARCH | QEXEC_F_SEND_SCORES | QEXEC_F_SENDRAWIDS |
+                      QEXEC_F_SEND_PAYLOADS | QEXEC_F_SEND_SORTKEYS | QEXEC_F_REQUIRED_FIELDS |
+                      QEXEC_F_SEND_NOFIELDS));
+}
+
+/* Add the fields of the result to the binary rows of the chunk, as serializeResult() replies
+ * with them */
+static void serializeBinaryResult(AREQ *req, const SearchResult *r, const cachedVars *cv) {
+  BinaryRowsWriter *w = cv->binaryRows;
+  if (!(SearchResult_GetFlags(r) & Result_ExpiredDoc)) {
+    const RLookup *lk = cv->lastLookup;
+    RedisSearchCtx *sctx = AREQ_SearchCtx(req);
+    SchemaRule *rule = (sctx && sctx->spec) ? sctx->spec->rule : NULL;
+    int requiredFlags = (req->outFields.explicitReturn ? RLOOKUP_F_EXPLICITRETURN : 0);
+    int skipFieldIndex[lk->rowlen]; // Array has `0` for fields which will be skipped
+    memset(skipFieldIndex, 0, lk->rowlen * sizeof(*skipFieldIndex));
+    RLookup_GetLength(lk, SearchResult_GetRowData(r), skipFieldIndex, requiredFlags, RLOOKUP_F_HIDDEN, rule);
+
+    SendReplyFlags flags = (AREQ_RequestFlags(req) & QEXEC_FORMAT_EXPAND) ? SENDREPLY_FLAG_EXPAND : 0;
+    int i = 0;
+    for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
+      if (!kk->name || !skipFieldIndex[i++]) {
+        continue;
+      }
+      const RSValue *v = RLookup_GetItem(kk, SearchResult_GetRowData(r));
+      RS_LOG_ASSERT(v, "v was found in RLookup_GetLength iteration")
+      BinaryRowsWriter_AddValue(w, i - 1, kk, replyFieldValue(v, flags, sctx->apiVersion));
+    }
+  }
+  BinaryRowsWriter_EndRow(w);
+}
+
+/* Add the fields of the result to the record batch of the chunk of a FT.EXPORT, as
+ * serializeBinaryResult() does */
+static void serializeArrowResult(AREQ *req, const SearchResult *r, const cachedVars *cv) {
+  ArrowExportWriter *w = cv->arrowExport;
+  if (!(SearchResult_GetFlags(r) & Result_ExpiredDoc)) {
+    const RLookup *lk = cv->lastLookup;
+    RedisSearchCtx *sctx = AREQ_SearchCtx(req);
+    SchemaRule *rule = (sctx && sctx->spec) ? sctx->spec->rule : NULL;
+    int requiredFlags = (req->outFields.explicitReturn ? RLOOKUP_F_EXPLICITRETURN : 0);
+    int skipFieldIndex[lk->rowlen]; // Array has `0` for fields which will be skipped
+    memset(skipFieldIndex, 0, lk->rowlen * sizeof(*skipFieldIndex));
+    RLookup_GetLength(lk, SearchResult_GetRowData(r), skipFieldIndex, requiredFlags, RLOOKUP_F_HIDDEN, rule);
+
+    SendReplyFlags flags = (AREQ_RequestFlags(req) & QEXEC_FORMAT_EXPAND) ? SENDREPLY_FLAG_EXPAND : 0;
+    int i = 0;
+    for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
+      if (!kk->name || !skipFieldIndex[i++]) {
+        continue;
+      }
+      const RSValue *v = RLookup_GetItem(kk, SearchResult_GetRowData(r));
+      ArrowExportWriter_AddValue(w, i - 1, replyFieldValue(v, flags, sctx->apiVersion));
+    }
+  }
+  ArrowExportWriter_EndRow(w);
+}
+
+/* Export the fields of the last lookup which the rows are replied with, as RLookup_GetLength()
+ * selects them. The fields are known once the first chunk is read, since the lookup may get the
+ * fields of `LOAD *` as it loads them */
+static void addArrowColumns(AREQ *req, const cachedVars *cv) {
+  const RLookup *lk = cv->lastLookup;
+  RedisSearchCtx *sctx = AREQ_SearchCtx(req);
+  SchemaRule *rule = (sctx && sctx->spec) ? sctx->spec->rule : NULL;
+  const bool explicitReturn = req->outFields.explicitReturn;
+  int i = 0;
+  for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
+    if (!kk->name) {
+      continue;
+    }
+    const uint32_t pos = i++;
+    if ((explicitReturn && !(kk->flags & RLOOKUP_F_EXPLICITRETURN)) ||
+        (kk->flags & RLOOKUP_F_HIDDEN)) {
+      continue;
+    }
+    if (rule && ((rule->lang_field && strcmp(kk->name, rule->lang_field) == 0) ||
+                 (rule->score_field && strcmp(kk->name, rule->score_field) == 0) ||
+                 (rule->payload_field && strcmp(kk->name, rule->payload_field) == 0))) {
+      continue;
+    }
+    ArrowExportWriter_AddColumn(cv->arrowExport, pos, kk->name, kk->name_len);
+  }
+}
+
+/* Reply with the part of the Arrow stream of the chunk, if any: the schema on the first chunk,
+ * the record batch of its rows, and the end of the stream on the last chunk */
+static size_t replyArrowChunk(AREQ *req, RedisModule_Reply *reply, const cachedVars *cv, bool eos) {
+  ArrowExportWriter *w = cv->arrowExport;
+  if (!ArrowExportWriter_HasSchema(w)) {
+    addArrowColumns(req, cv);
+  }
+  Buffer buf = {0};
+  Buffer_Init(&buf, 1024);
+  ArrowExportWriter_Finish(w, eos, &buf);
+  size_t n = 0;
+  if (buf.offset) {
+    RedisModule_Reply_StringBuffer(reply, buf.data, buf.offset);
+    n = 1;
+  }
+  Buffer_Free(&buf);
+  return n;
+}
+
+/* Reply with the binary rows of the chunk, if any */
+static size_t replyBinaryRows(RedisModule_Reply *reply, BinaryRowsWriter *w) {
+  if (!BinaryRowsWriter_NumRows(w)) {
+    return 0;
+  }
+  Buffer buf = {0};
+  BinaryRowsWriter_Finish(w, &buf);
+  RedisModule_Reply_StringBuffer(reply, buf.data, buf.offset);
+  Buffer_Free(&buf);
+  return 1;
+}
+
+static size_t serializeResultInner(AREQ *req, RedisModule_Reply *reply, const SearchResult *r,
+                                   const cachedVars *cv) {
+  if (cv->binaryRows) {
+    serializeBinaryResult(req, r, cv);
+    return 0;
+  } else if (cv->arrowExport) {
+    serializeArrowResult(req, r, cv);
+    return 0;
+  }
+
   const uint32_t options = AREQ_RequestFlags(req);
   const RSDocumentMetadata *dmd = SearchResult_GetDocumentMetadata(r);
   size_t count0 = RedisModule_Reply_LocalCount(reply);
@@ -235,39 +404,21 @@ static size_t serializeResult(AREQ *req, RedisModule_Reply *reply, const SearchR
       memset(skipFieldIndex, 0, lk->rowlen * sizeof(*skipFieldIndex));
       size_t nfields = RLookup_GetLength(lk, SearchResult_GetRowData(r), skipFieldIndex, requiredFlags, excludeFlags, rule);
 
+      SendReplyFlags flags = (options & QEXEC_F_TYPED) ? SENDREPLY_FLAG_TYPED : 0;
+      flags |= (options & QEXEC_FORMAT_EXPAND) ? SENDREPLY_FLAG_EXPAND : 0;
+      const RLookupRow *row = SearchResult_GetRowData(r);
+
       RedisModule_Reply_Map(reply);
         int i = 0;
         for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
           if (!kk->name || !skipFieldIndex[i++]) {
             continue;
           }
-          const RSValue *v = RLookup_GetItem(kk, SearchResult_GetRowData(r));
+          const RSValue *v = RLookup_GetItem(kk, row);
           RS_LOG_ASSERT(v, "v was found in RLookup_GetLength iteration")
 
           RedisModule_Reply_StringBuffer(reply, kk->name, kk->name_len);
-
-          QEFlags reqFlags = AREQ_RequestFlags(req);
-          SendReplyFlags flags = (reqFlags & QEXEC_F_TYPED) ? SENDREPLY_FLAG_TYPED : 0;
-          flags |= (reqFlags & QEXEC_FORMAT_EXPAND) ? SENDREPLY_FLAG_EXPAND : 0;
-
-          unsigned int apiVersion = sctx->apiVersion;
-          if (RSValue_IsTrio(v)) {
-            // Which value to use for duo value
-            if (!(flags & SENDREPLY_FLAG_EXPAND)) {
-              // STRING
-              if (apiVersion >= APIVERSION_RETURN_MULTI_CMP_FIRST) {
-                // Multi
-                v = RSValue_Trio_GetMiddle(v);
-              } else {
-                // Single
-                v = RSValue_Trio_GetLeft(v);
-              }
-            } else {
-              // EXPAND
-              v = RSValue_Trio_GetRight(v);
-            }
-          }
-          RedisModule_Reply_RSValue(reply, v, flags);
+          RedisModule_Reply_RSValue(reply, replyFieldValue(v, flags, sctx->apiVersion), flags);
         }
       RedisModule_Reply_MapEnd(reply);
     }
@@ -284,6 +435,15 @@ static size_t serializeResult(AREQ *req, RedisModule_Reply *reply, const SearchR
   return RedisModule_Reply_LocalCount(reply) - count0;
 }
 
+static size_t serializeResult(AREQ *req, RedisModule_Reply *reply, const SearchResult *r,
+                              const cachedVars *cv) {
+  rs_wall_clock replyClock;
+  rs_wall_clock_init(&replyClock);
+  const size_t n = serializeResultInner(req, reply, r, cv);
+  AREQ_QueryProcessingCtx(req)->replyTime += rs_wall_clock_elapsed_ns(&replyClock);
+  return n;
+}
+
 static size_t getResultsFactor(AREQ *req) {
   size_t count = 0;
   QEFlags reqFlags = AREQ_RequestFlags(req);
@@ -337,8 +497,7 @@ static int populateReplyWithResults(RedisModule_Reply *reply,
     int len = array_len(results);
     array_foreach(results, res, {
       serializeResult(req, reply, res, cv);
-      SearchResult_Destroy(res);
-      rm_free(res);
+      SearchResult_Free(res);
     });
     array_free(results);
     return len;
@@ -373,6 +532,9 @@ static void finishSendChunk(AREQ *req, SearchResult **results, SearchResult *r,
   if (QueryError_IsOk(qctx->err) || hasTimeoutError(qctx->err)) {
     rs_wall_clock_ns_t duration = rs_wall_clock_elapsed_ns(&req->initClock);
     TotalGlobalStats_CountQuery(AREQ_RequestFlags(req), duration);
+    if (SlowLog_Enabled()) {
+      SlowLog_CountQuery(req, duration);
+    }
   }
 
   // Reset the total results length:
@@ -380,6 +542,16 @@ static void finishSendChunk(AREQ *req, SearchResult **results, SearchResult *r,
   QueryError_ClearError(qctx->err);
 }
 
+/* The revision of the index sent with the chunk, when the coordinator asked for it. It is read
+ * before the rows, so that the writes the rows may have missed are in a newer revision */
+static uint64_t chunkIndexRevision(AREQ *req) {
+  RedisSearchCtx *sctx = AREQ_SearchCtx(req);
+  if (!(AREQ_RequestFlags(req) & QEXEC_F_SEND_REVISION) || !sctx || !sctx->spec) {
+    return 0;
+  }
+  return __atomic_load_n(&sctx->spec->revision, __ATOMIC_RELAXED);
+}
+
 /**
  * Sends a chunk of <n> rows in the resp2 format
 */
@@ -392,6 +564,7 @@ static void sendChunk_Resp2(AREQ *req, RedisModule_Reply *reply, size_t limit,
     SearchResult **results = NULL;
     long nelem = 0, resultsLen = REDISMODULE_POSTPONED_ARRAY_LEN;
     bool cursor_done = false;
+    const uint64_t revision = chunkIndexRevision(req);
 
     startPipeline(req, rp, &results, &r, &rc);
 
@@ -455,12 +628,17 @@ static void sendChunk_Resp2(AREQ *req, RedisModule_Reply *reply, size_t limit,
     }
 
 done_2:
-    RedisModule_Reply_ArrayEnd(reply);    // </results>
-
     cursor_done = (rc != RS_RESULT_OK
                    && !(rc == RS_RESULT_TIMEDOUT
                         && req->reqConfig.timeoutPolicy == TimeoutPolicy_Return));
 
+    if (cv.binaryRows) {
+      nelem += replyBinaryRows(reply, cv.binaryRows);
+    } else if (cv.arrowExport) {
+      nelem += replyArrowChunk(req, reply, &cv, cursor_done || !(AREQ_RequestFlags(req) & QEXEC_F_IS_CURSOR));
+    }
+    RedisModule_Reply_ArrayEnd(reply);    // </results>
+
     bool has_timedout = (rc == RS_RESULT_TIMEDOUT) || hasTimeoutError(qctx->err);
 
     // Prepare profile printer context
@@ -486,6 +664,9 @@ done_2:
           RedisModule_Reply_Null(reply);
         }
       }
+      if (AREQ_RequestFlags(req) & QEXEC_F_SEND_REVISION) {
+        RedisModule_Reply_LongLong(reply, revision);
+      }
       RedisModule_Reply_ArrayEnd(reply);
     } else if (IsProfile(req)) {
       req->profile(reply, &profileCtx);
@@ -512,6 +693,7 @@ static void sendChunk_Resp3(AREQ *req, RedisModule_Reply *reply, size_t limit,
     ResultProcessor *rp = qctx->endProc;
     SearchResult **results = NULL;
     bool cursor_done = false;
+    const uint64_t revision = chunkIndexRevision(req);
 
     startPipeline(req, rp, &results, &r, &rc);
 
@@ -578,6 +760,15 @@ static void sendChunk_Resp3(AREQ *req, RedisModule_Reply *reply, size_t limit,
     }
 
 done_3:
+    cursor_done = (rc != RS_RESULT_OK
+                   && !(rc == RS_RESULT_TIMEDOUT
+                        && req->reqConfig.timeoutPolicy == TimeoutPolicy_Return));
+
+    if (cv.binaryRows) {
+      replyBinaryRows(reply, cv.binaryRows);
+    } else if (cv.arrowExport) {
+      replyArrowChunk(req, reply, &cv, cursor_done || !(AREQ_RequestFlags(req) & QEXEC_F_IS_CURSOR));
+    }
     RedisModule_Reply_ArrayEnd(reply); // >results
 
     // <total_results>
@@ -602,10 +793,6 @@ done_3:
     }
     RedisModule_Reply_ArrayEnd(reply); // >warnings
 
-    cursor_done = (rc != RS_RESULT_OK
-                   && !(rc == RS_RESULT_TIMEDOUT
-                        && req->reqConfig.timeoutPolicy == TimeoutPolicy_Return));
-
     bool has_timedout = (rc == RS_RESULT_TIMEDOUT) || hasTimeoutError(qctx->err);
 
     // Prepare profile printer context
@@ -632,6 +819,9 @@ done_3:
       } else {
         RedisModule_Reply_LongLong(reply, req->cursor_id);
       }
+      if (AREQ_RequestFlags(req) & QEXEC_F_SEND_REVISION) {
+        RedisModule_Reply_LongLong(reply, revision);
+      }
       RedisModule_Reply_ArrayEnd(reply);
     }
 
@@ -639,6 +829,21 @@ done_3_err:
     finishSendChunk(req, results, &r, cursor_done);
 }
 
+/* Count the time the chunk spent in each stage of the pipeline. The time which was not spent
+ * loading, sorting or replying was spent reading the iterators, or in the other processors */
+static void countChunkStages(const QueryProcessingCtx *qctx, rs_wall_clock_ns_t chunkTime) {
+  // The rows of the coordinator are read from the shards, which count their own stages
+  if (qctx->rootProc && qctx->rootProc->type == RP_NETWORK) {
+    LatencyStats_CountStage(LATENCY_STAGE_REPLY, qctx->replyTime);
+    return;
+  }
+  const rs_wall_clock_ns_t timed = qctx->loadTime + qctx->sortTime + qctx->replyTime;
+  LatencyStats_CountStage(LATENCY_STAGE_ITERATORS, chunkTime > timed ? chunkTime - timed : 0);
+  LatencyStats_CountStage(LATENCY_STAGE_LOAD, qctx->loadTime);
+  LatencyStats_CountStage(LATENCY_STAGE_SORT, qctx->sortTime);
+  LatencyStats_CountStage(LATENCY_STAGE_REPLY, qctx->replyTime);
+}
+
 /**
  * Sends a chunk of <n> rows, optionally also sending the preamble
  */
@@ -653,21 +858,36 @@ void sendChunk(AREQ *req, RedisModule_Reply *reply, size_t limit) {
   }
 
   AGGPlan *plan = AREQ_AGGPlan(req);
+  BinaryRowsWriter binaryRows;
   cachedVars cv = {
     .lastLookup = AGPLN_GetLookup(plan, NULL, AGPLN_GETLOOKUP_LAST),
-    .lastAstp = AGPLN_GetArrangeStep(plan)
+    .lastAstp = AGPLN_GetArrangeStep(plan),
+    .binaryRows = useBinaryRows(req) ? &binaryRows : NULL,
+    .arrowExport = req->arrowExport,
   };
+  if (cv.binaryRows) {
+    BinaryRowsWriter_Init(cv.binaryRows, reply->resp3);
+  }
 
   // Set the chunk size limit for the query
   QueryProcessingCtx *qctx = AREQ_QueryProcessingCtx(req);
   qctx->resultLimit = limit;
 
+  rs_wall_clock_init(&qctx->chunkClock);
+
   if (reply->resp3) {
     sendChunk_Resp3(req, reply, limit, cv);
   } else {
     sendChunk_Resp2(req, reply, limit, cv);
   }
 
+  countChunkStages(qctx, rs_wall_clock_elapsed_ns(&qctx->chunkClock));
+  qctx->loadTime = qctx->sortTime = qctx->replyTime = qctx->lockWaitTime = 0;
+
+  if (cv.binaryRows) {
+    BinaryRowsWriter_Free(cv.binaryRows);
+  }
+
   if (sctx->spec) {
     IndexSpec_DecrActiveQueries(sctx->spec);
   }
@@ -686,6 +906,10 @@ static blockedClientReqCtx *blockedClientReqCtx_New(AREQ *req,
   ret->req = req;
   ret->blockedClient = blockedClient;
   ret->spec_ref = StrongRef_Demote(spec);
+  ret->costClass = QUERY_CLASS_CHEAP;
+  ret->admitted = false;
+  ret->parked_ref = (StrongRef){0};
+  rs_wall_clock_init(&ret->queuedClock);
   return ret;
 }
 
@@ -705,11 +929,68 @@ static void blockedClientReqCtx_destroy(blockedClientReqCtx *BCRctx) {
   void *privdata = RedisModule_BlockClientGetPrivateData(BCRctx->blockedClient);
   RedisModule_UnblockClient(BCRctx->blockedClient, privdata);
   WeakRef_Release(BCRctx->spec_ref);
+  if (BCRctx->admitted) {
+    QueryAdmission_Exit(BCRctx->costClass);
+  }
   rm_free(BCRctx);
 }
 
+/* Resume a query which waited to be admitted. Its pipeline is built, and its root locks the spec
+ * again (and revalidates the iterators) when it is first read */
+static void AREQ_ExecuteAdmitted_Callback(blockedClientReqCtx *BCRctx) {
+  AREQ *req = blockedClientReqCtx_getRequest(BCRctx);
+  RedisModuleCtx *outctx = RedisModule_GetThreadSafeContext(BCRctx->blockedClient);
+  StrongRef parked_ref = BCRctx->parked_ref;
+  BCRctx->admitted = true;
+
+  StrongRef execution_ref = IndexSpecRef_Promote(BCRctx->spec_ref);
+  if (!StrongRef_Get(execution_ref)) {
+    // The index was dropped while the query was waiting
+    QueryError status = QueryError_Default();
+    QueryError_SetCode(&status, QUERY_ERROR_CODE_DROPPED_BACKGROUND);
+    QueryError_ReplyAndClear(outctx, &status);
+  } else {
+    AREQ_SearchCtx(req)->redisCtx = outctx;
+    AREQ_Execute(req, outctx);
+    blockedClientReqCtx_setRequest(BCRctx, NULL);
+    IndexSpecRef_Release(execution_ref);
+  }
+
+  RedisModule_FreeThreadSafeContext(outctx);
+  blockedClientReqCtx_destroy(BCRctx);
+  // Released last, as the request of a dropped index is freed with the context
+  IndexSpecRef_Release(parked_ref);
+}
+
+/* Admit the query to run in the class of its cost. Returns false if it was queued (and is then
+ * resumed by `AREQ_ExecuteAdmitted_Callback`) or rejected (and `status` is set).
+ * A heavy query may be resumed on another thread as soon as it is queued, so it gives up the spec
+ * lock beforehand, and its request must not be touched once it is queued */
+static bool admitQuery(blockedClientReqCtx *BCRctx, StrongRef execution_ref, QueryError *status) {
+  AREQ *req = blockedClientReqCtx_getRequest(BCRctx);
+  BCRctx->costClass = QueryAdmission_Classify(req->estimatedCost);
+  if (BCRctx->costClass == QUERY_CLASS_HEAVY) {
+    RedisSearchCtx_UnlockSpec(AREQ_SearchCtx(req));
+    BCRctx->parked_ref = execution_ref;
+  }
+  switch (QueryAdmission_Enter(BCRctx->costClass, (redisearch_thpool_proc)AREQ_ExecuteAdmitted_Callback,
+                               BCRctx)) {
+    case QUERY_ADMIT_RUN:
+      BCRctx->admitted = true;
+      return true;
+    case QUERY_ADMIT_WAIT:
+      return false;
+    case QUERY_ADMIT_REJECT:
+    default:
+      QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+        "Too many %s queries are waiting to run", QueryAdmission_ClassName(BCRctx->costClass));
+      return false;
+  }
+}
+
 void AREQ_Execute_Callback(blockedClientReqCtx *BCRctx) {
   AREQ *req = blockedClientReqCtx_getRequest(BCRctx);
+  LatencyStats_CountStage(LATENCY_STAGE_QUEUE, rs_wall_clock_elapsed_ns(&BCRctx->queuedClock));
   RedisModuleCtx *outctx = RedisModule_GetThreadSafeContext(BCRctx->blockedClient);
   QueryError status = QueryError_Default();
 
@@ -730,8 +1011,14 @@ void AREQ_Execute_Callback(blockedClientReqCtx *BCRctx) {
     sctx->redisCtx = outctx;
   }
 
+  // Stop the query if the client disconnects while it runs
+  AREQ_SetCancelToken(req, BlockedQueryClient_CancelToken(BCRctx->blockedClient));
+
   // lock spec
+  rs_wall_clock lockClock;
+  rs_wall_clock_init(&lockClock);
   RedisSearchCtx_LockSpecRead(sctx);
+  AREQ_QueryProcessingCtx(req)->lockWaitTime += rs_wall_clock_elapsed_ns(&lockClock);
   if (prepareExecutionPlan(req, &status) != REDISMODULE_OK) {
     goto error;
   }
@@ -744,6 +1031,13 @@ void AREQ_Execute_Callback(blockedClientReqCtx *BCRctx) {
       goto error;
     }
   } else {
+    if (!admitQuery(BCRctx, execution_ref, &status)) {
+      if (QueryError_HasError(&status)) {
+        goto error;
+      }
+      RedisModule_FreeThreadSafeContext(outctx);
+      return;
+    }
     AREQ_Execute(req, outctx);
   }
 
@@ -764,12 +1058,152 @@ cleanup:
   blockedClientReqCtx_destroy(BCRctx);
 }
 
+// Only queries matching at least this number of documents per range are read in parallel ranges
+#define QUERY_RANGE_MIN_RESULTS 16384
+
+static int isNotVectorNode(QueryNode *node, QueryNode *q, void *ctx) {
+  return node->type != QN_VECTOR;
+}
+
+/* The number of doc-id ranges the root of the query is split into, to be read in parallel (see
+ * `RPQueryRanges`), or 0 to read it with a single root iterator. Only large aggregations running in
+ * the background are split, as long as nothing uses the index results of the root (scores,
+ * vector distances or the profile of the iterators). */
+static size_t numQueryRanges(AREQ *req) {
+  const QEFlags flags = AREQ_RequestFlags(req);
+  if (RSGlobalConfig.parallelQueryRanges < 2 || !(flags & QEXEC_F_IS_AGGREGATE) ||
+      !(flags & QEXEC_F_RUN_IN_BACKGROUND)) {
+    return 0;
+  }
+  if (flags & (QEXEC_F_IS_CURSOR | QEXEC_F_PROFILE | QEXEC_F_PROFILE_SAMPLED | QEXEC_OPTIMIZE |
+               QEXEC_F_DEBUG | QEXEC_F_SEND_SCORES | QEXEC_F_SEND_SCORES_AS_FIELD |
+               QEXEC_F_SEND_SCOREEXPLAIN)) {
+    return 0;
+  }
+  if (req->slotRanges || isTrimming || AREQ_SearchCtx(req)->spec->diskSpec || req->ast.metricRequests ||
+      !QueryNode_ForEach(req->ast.root, isNotVectorNode, NULL, 0)) {
+    return 0;
+  }
+  // The nearest documents of a geo filter are read at once, and not by ranges
+  if (req->ast.root->type == QN_GEO && req->ast.root->gn.nearest) {
+    return 0;
+  }
+  size_t numRanges = MIN(RSGlobalConfig.parallelQueryRanges,
+                         req->rootiter->NumEstimated(req->rootiter) / QUERY_RANGE_MIN_RESULTS);
+  return numRanges > 1 ? numRanges : 0;
+}
+
+/* Whether the expression is `geodistance(@field, lon, lat)` or `geodistance(@field, "lon,lat")`,
+ * with the field and the center of the geo filter */
+static bool isFilterDistance(const RSExpr *e, const GeoFilter *gf) {
+  if (e->t != RSExpr_Function || strcasecmp(e->func.name, "geodistance")) {
+    return false;
+  }
+  const RSArgList *args = e->func.args;
+  if (args->len < 2 || args->len > 3 || args->args[0]->t != RSExpr_Property) {
+    return false;
+  }
+  const char *key = args->args[0]->property.key;
+  if (HiddenString_CompareC(gf->fieldSpec->fieldName, key, strlen(key))) {
+    return false;
+  }
+  double lon, lat;
+  const RSValue *v1 = &args->args[1]->literal;
+  if (args->args[1]->t != RSExpr_Literal) {
+    return false;
+  }
+  if (args->len == 2) {
+    size_t len;
+    const char *p = RSValue_IsAnyString(v1) ? RSValue_StringPtrLen(v1, &len) : NULL;
+    QueryError status = QueryError_Default();
+    const bool parsed = p && parseGeo(p, len, &lon, &lat, &status) == REDISMODULE_OK;
+    QueryError_ClearError(&status);
+    if (!parsed) {
+      return false;
+    }
+  } else {
+    const RSValue *v2 = &args->args[2]->literal;
+    if (args->args[2]->t != RSExpr_Literal || !RSValue_IsNumber(v1) || !RSValue_IsNumber(v2)) {
+      return false;
+    }
+    lon = RSValue_Number_Get(v1);
+    lat = RSValue_Number_Get(v2);
+  }
+  return lon == gf->lon && lat == gf->lat;
+}
+
+/* The number of the documents closest to the center of the geo filter of the query, if it only
+ * returns them, or 0. That is the case of the aggregations of a geo filter which are sorted by
+ * the distance to its center first, and limited:
+ *   FT.AGGREGATE idx "@loc:[lon lat radius unit]"
+ *     APPLY "geodistance(@loc, lon, lat)" AS dist SORTBY 2 @dist ASC LIMIT offset num
+ * Only APPLY and LOAD steps may come before the sort, as they don't drop or reorder the rows. */
+static size_t geoNearestCount(AREQ *req) {
+  const QueryNode *root = req->ast.root;
+  if (!(AREQ_RequestFlags(req) & QEXEC_F_IS_AGGREGATE) || !root || root->type != QN_GEO ||
+      !root->gn.gf || !root->gn.gf->fieldSpec) {
+    return 0;
+  }
+  AGGPlan *pln = AREQ_AGGPlan(req);
+  const PLN_ArrangeStep *arng = NULL;
+  for (const DLLIST_node *nn = pln->firstStep_s.base.llnodePln.next; nn != &pln->steps; nn = nn->next) {
+    const PLN_BaseStep *stp = DLLIST_ITEM(nn, PLN_BaseStep, llnodePln);
+    if (stp->type == PLN_T_ARRANGE) {
+      arng = (const PLN_ArrangeStep *)stp;
+      break;
+    } else if (stp->type != PLN_T_APPLY && stp->type != PLN_T_LOAD) {
+      return 0;
+    }
+  }
+  if (!arng || !arng->isLimited || !arng->limit || !arng->sortKeys || !array_len(arng->sortKeys) ||
+      !SORTASCMAP_GETASC(arng->sortAscMap, 0)) {
+    return 0;
+  }
+
+  // The last APPLY step of the alias is the one the sort reads
+  const PLN_MapFilterStep *apply = NULL;
+  for (const DLLIST_node *nn = arng->base.llnodePln.prev; nn != &pln->steps; nn = nn->prev) {
+    const PLN_BaseStep *stp = DLLIST_ITEM(nn, PLN_BaseStep, llnodePln);
+    if (stp->type == PLN_T_APPLY && !strcmp(stp->alias, arng->sortKeys[0])) {
+      apply = (const PLN_MapFilterStep *)stp;
+      break;
+    }
+  }
+  if (!apply) {
+    return 0;
+  }
+  // The expressions are only parsed when the pipeline is built, after the iterators
+  QueryError status = QueryError_Default();
+  RSExpr *expr = ExprAST_Parse(apply->expr, &status);
+  QueryError_ClearError(&status);
+  if (!expr) {
+    return 0;
+  }
+  const bool nearest = isFilterDistance(expr, root->gn.gf);
+  ExprAST_Free(expr);
+  return nearest ? arng->offset + arng->limit : 0;
+}
+
+// Whether the rows of the query may be replayed from (or recorded into) the result cache of its
+// index. Only plain FT.SEARCH queries whose reply is read at once, and only depends on the
+// documents of the index, are cached
+static bool useSearchResultCache(AREQ *req) {
+  const IndexSpec *sp = AREQ_SearchCtx(req)->spec;
+  const uint32_t uncached = QEXEC_F_IS_CURSOR | QEXEC_F_PROFILE | QEXEC_F_PROFILE_SAMPLED |
+                            QEXEC_F_DEBUG | QEXEC_F_SEND_SCOREEXPLAIN | QEXEC_OPTIMIZE;
+  return RSGlobalConfig.searchResultCacheBytes && IsSearch(req) && !(req->reqflags & uncached) &&
+         !req->batchParam && sp && sp->searchResults && !sp->diskSpec &&
+         !(sp->docs.ttl && sp->monitorFieldExpiration);
+}
+
 // Assumes the spec is guarded (by its own lock for read or by the global lock)
 int prepareExecutionPlan(AREQ *req, QueryError *status) {
   int rc = REDISMODULE_ERR;
   RedisSearchCtx *sctx = AREQ_SearchCtx(req);
   RSSearchOptions *opts = &req->searchopts;
   QueryAST *ast = &req->ast;
+  rs_wall_clock planClock;
+  rs_wall_clock_init(&planClock);
 
   // Set timeout for the query execution
   // TODO: this should be done in `AREQ_execute`, but some of the iterators needs the timeout's
@@ -777,6 +1211,17 @@ int prepareExecutionPlan(AREQ *req, QueryError *status) {
   // Setting the timeout context should be done in the same thread that executes the query.
   SearchCtx_UpdateTime(sctx, req->reqConfig.queryTimeoutMS);
 
+  if (ast->root && ast->root->type == QN_GEO) {
+    ast->root->gn.nearest = geoNearestCount(req);
+  }
+  if (IsOptimized(req) && QOptimizer_CanReadImpactPostings(req, req->optimizer)) {
+    AREQ_AddRequestFlags(req, QEXEC_F_IMPACT_POSTINGS);
+  }
+  if (opts->sampleCount) {
+    // The count is sampled out of the documents of this index, hence of each shard in a cluster
+    const size_t numDocs = sctx->spec->stats.numDocuments;
+    opts->sampleRatio = numDocs > opts->sampleCount ? (double)opts->sampleCount / numDocs : 1;
+  }
   req->rootiter = QAST_Iterate(ast, opts, sctx, AREQ_RequestFlags(req), status);
 
   // check possible optimization after creation of QueryIterator tree
@@ -792,9 +1237,29 @@ int prepareExecutionPlan(AREQ *req, QueryError *status) {
     return REDISMODULE_ERR;
   }
 
-  if (IsProfile(req)) {
+  if (RSGlobalConfig.heavyQueryCost) {
+    req->estimatedCost = QueryAdmission_Cost(req->rootiter, AREQ_AGGPlan(req));
+  }
+
+  if (!IsProfile(req) && ProfileStats_ShouldSample()) {
+    AREQ_AddRequestFlags(req, QEXEC_F_PROFILE_SAMPLED);
+  }
+
+  // Clone the iterator tree for every other range of the query, if it is read in parallel
+  const size_t numRanges = numQueryRanges(req);
+  if (numRanges) {
+    req->rangeRoots = array_new(QueryIterator *, numRanges - 1);
+    for (size_t i = 1; i < numRanges; i++) {
+      array_append(req->rangeRoots, QAST_Iterate(ast, opts, sctx, AREQ_RequestFlags(req), status));
+    }
+  }
+
+  if (AREQ_RequestFlags(req) & (QEXEC_F_PROFILE | QEXEC_F_PROFILE_SAMPLED)) {
     // Add a Profile iterators before every iterator in the tree
     Profile_AddIters(&req->rootiter);
+  } else if (SlowLog_Enabled()) {
+    // Count the reads of the iterators, to tell how far they were from their estimates
+    Profile_AddCounters(&req->rootiter);
   }
 
   rs_wall_clock parseClock;
@@ -807,6 +1272,15 @@ int prepareExecutionPlan(AREQ *req, QueryError *status) {
 
   rc = AREQ_BuildPipeline(req, status);
 
+  if (rc == REDISMODULE_OK && useSearchResultCache(req)) {
+    IndexSpec *sp = sctx->spec;
+    ResultProcessor *rp = RPSearchResultCache_New(
+        sp->searchResults, __atomic_load_n(&sp->revision, __ATOMIC_RELAXED),
+        SearchResultCache_Key(req->protocol, req->args, req->nargs), &sp->docs,
+        AGPLN_GetLookup(AREQ_AGGPlan(req), NULL, AGPLN_GETLOOKUP_LAST));
+    QITR_PushRP(AREQ_QueryProcessingCtx(req), rp);
+  }
+
   if (is_profile) {
     req->profilePipelineBuildTime = rs_wall_clock_elapsed_ns(&parseClock);
   }
@@ -818,9 +1292,26 @@ int prepareExecutionPlan(AREQ *req, QueryError *status) {
     }
   }
 
+  if (rc == REDISMODULE_OK) {
+    LatencyStats_CountStage(LATENCY_STAGE_PLAN, rs_wall_clock_elapsed_ns(&planClock));
+  }
   return rc;
 }
 
+// Set the parameter of a query of a FT.SEARCH batch to its value
+static int addBatchParam(AREQ *req, QueryError *status) {
+  if (!req->searchopts.params) {
+    req->searchopts.params = Param_DictCreate();
+  }
+  size_t len;
+  const char *value = RedisModule_StringPtrLen(req->batchValue, &len);
+  if (Param_DictAdd(req->searchopts.params, RedisModule_StringPtrLen(req->batchParam, NULL), value, len,
+                    status) == DICT_ERR) {
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
 static int buildRequest(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, int type,
                         QueryError *status, AREQ **r) {
   int rc = REDISMODULE_ERR;
@@ -841,6 +1332,9 @@ static int buildRequest(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
     RS_LOG_ASSERT(QueryError_HasError(status), "Query has error");
     goto done;
   }
+  if ((*r)->batchParam && addBatchParam(*r, status) != REDISMODULE_OK) {
+    goto done;
+  }
 
   (*r)->protocol = is_resp3(ctx) ? 3 : 2;
 
@@ -897,21 +1391,28 @@ int prepareRequest(AREQ **r_ptr, RedisModuleCtx *ctx, RedisModuleString **argv,
   if (RedisModule_StringPtrLen(argv[0], NULL)[0] == '_') {
     AREQ_AddRequestFlags(r, QEXEC_F_INTERNAL);
   }
+  if (execOptions & EXEC_ARROW_EXPORT) {
+    r->arrowExport = ArrowExportWriter_New();
+  }
 
   parseProfile(r, execOptions);
 
+  // The duration of the command is counted by the slow log, for internal commands as well
+  rs_wall_clock_init(&r->initClock);
   if (!IsInternal(r) || IsProfile(r)) {
     // We currently don't need to measure the time for internal and non-profile commands
-    rs_wall_clock_init(&r->initClock);
     rs_wall_clock_init(&AREQ_QueryProcessingCtx(r)->initTime);
   }
 
+  rs_wall_clock parseClock;
+  rs_wall_clock_init(&parseClock);
   // This function also builds the RedisSearchCtx
   // It will search for the spec according to the name given in the argv array,
   // and ensure the spec is valid.
   if (buildRequest(ctx, argv, argc, type, status, r_ptr) != REDISMODULE_OK) {
     return REDISMODULE_ERR;
   }
+  LatencyStats_CountStage(LATENCY_STAGE_PARSE, rs_wall_clock_elapsed_ns(&parseClock));
 
   SET_DIALECT(AREQ_SearchCtx(r)->spec->used_dialects, r->reqConfig.dialectVersion);
   SET_DIALECT(RSGlobalStats.totalStats.used_dialects, r->reqConfig.dialectVersion);
@@ -1000,11 +1501,149 @@ error:
   return QueryError_ReplyAndClear(ctx, &status);
 }
 
+int AREQ_SearchBatchOffset(RedisModuleString **argv, int argc) {
+  // The index and the query come first, and the values of the batch last
+  for (int i = 3; i + 2 < argc; i++) {
+    long long count;
+    if (RMUtil_StringEqualsCaseC(argv[i], "BATCH") &&
+        RedisModule_StringToLongLong(argv[i + 2], &count) == REDISMODULE_OK && count == argc - i - 3) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+/* The queries of a FT.SEARCH batch, which run one after the other in a single job of the workers */
+typedef struct {
+  arrayof(AREQ *) reqs;
+  RedisModuleBlockedClient *blockedClient;
+  WeakRef spec_ref;
+} blockedClientBatchCtx;
+
+static void searchBatch_Free(arrayof(AREQ *) reqs) {
+  array_foreach(reqs, req, if (req) AREQ_Free(req));
+  array_free(reqs);
+}
+
+/* Run the queries of the batch, replying with an array of their results in the order of the values.
+ * A query which fails has its error in the array instead. Frees the requests */
+static void searchBatch_Execute(arrayof(AREQ *) reqs, RedisModuleCtx *ctx, const QueryCancelToken *cancel) {
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  RedisModule_Reply_Array(reply);
+  for (size_t i = 0; i < array_len(reqs); i++) {
+    AREQ *req = reqs[i];
+    reqs[i] = NULL;
+    RedisSearchCtx *sctx = AREQ_SearchCtx(req);
+    sctx->redisCtx = ctx;
+    if (cancel) {
+      AREQ_SetCancelToken(req, cancel);
+    }
+    QueryError status = QueryError_Default();
+    // Unlocked when the request is freed
+    RedisSearchCtx_LockSpecRead(sctx);
+    if (prepareExecutionPlan(req, &status) == REDISMODULE_OK) {
+      sendChunk(req, reply, UINT64_MAX);
+    } else {
+      RedisModule_Reply_QueryError(reply, &status);
+      QueryError_ClearError(&status);
+    }
+    AREQ_Free(req);
+  }
+  RedisModule_Reply_ArrayEnd(reply);
+  RedisModule_EndReply(reply);
+  array_free(reqs);
+}
+
+static void searchBatch_Execute_Callback(blockedClientBatchCtx *BCBctx) {
+  RedisModuleCtx *outctx = RedisModule_GetThreadSafeContext(BCBctx->blockedClient);
+  StrongRef execution_ref = IndexSpecRef_Promote(BCBctx->spec_ref);
+  if (!StrongRef_Get(execution_ref)) {
+    // The index was dropped while the batch was in the job queue
+    QueryError status = QueryError_Default();
+    QueryError_SetCode(&status, QUERY_ERROR_CODE_DROPPED_BACKGROUND);
+    QueryError_ReplyAndClear(outctx, &status);
+    searchBatch_Free(BCBctx->reqs);
+  } else {
+    searchBatch_Execute(BCBctx->reqs, outctx, BlockedQueryClient_CancelToken(BCBctx->blockedClient));
+    IndexSpecRef_Release(execution_ref);
+  }
+  RedisModule_FreeThreadSafeContext(outctx);
+
+  RedisModule_BlockedClientMeasureTimeEnd(BCBctx->blockedClient);
+  void *privdata = RedisModule_BlockClientGetPrivateData(BCBctx->blockedClient);
+  RedisModule_UnblockClient(BCBctx->blockedClient, privdata);
+  WeakRef_Release(BCBctx->spec_ref);
+  rm_free(BCBctx);
+}
+
+/* FT.SEARCH with `BATCH <param> <count> <value>...`. Each value gets a request of its own, as the
+ * parameter is resolved when the query is parsed, but the requests are prepared together, and run
+ * one after the other in a single job of the workers, replying once */
+static int execSearchBatch(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, int batchOffset) {
+  QueryError status = QueryError_Default();
+  const size_t numValues = argc - batchOffset - 3;
+  if (numValues == 0 || numValues > SEARCH_BATCH_MAX_VALUES) {
+    QueryError_SetWithoutUserDataFmt(&status, QUERY_ERROR_CODE_LIMIT,
+      "BATCH takes between 1 and %d values", SEARCH_BATCH_MAX_VALUES);
+    return QueryError_ReplyAndClear(ctx, &status);
+  }
+
+  // Memory guardrail
+  if (QueryMemoryGuard(ctx)) {
+    RedisModule_Log(ctx, "notice", "Not enough memory available to execute the query");
+    QueryError_SetCode(&status, QUERY_ERROR_CODE_OUT_OF_MEMORY);
+    return QueryError_ReplyAndClear(ctx, &status);
+  }
+
+  arrayof(AREQ *) reqs = array_new(AREQ *, numValues);
+  for (size_t i = 0; i < numValues; i++) {
+    AREQ *r = AREQ_New();
+    r->batchParam = argv[batchOffset + 1];
+    r->batchValue = argv[batchOffset + 3 + i];
+    if (prepareRequest(&r, ctx, argv, batchOffset, COMMAND_SEARCH, EXEC_NO_FLAGS, &status) != REDISMODULE_OK) {
+      if (r) {
+        AREQ_Free(r);
+      }
+      searchBatch_Free(reqs);
+      return QueryError_ReplyAndClear(ctx, &status);
+    }
+    array_append(reqs, r);
+    CurrentThread_ClearIndexSpec();
+  }
+
+  RedisSearchCtx *sctx = AREQ_SearchCtx(reqs[0]);
+  StrongRef spec_ref = IndexSpec_GetStrongRefUnsafe(sctx->spec);
+  if (RunInThread()) {
+    blockedClientBatchCtx *BCBctx = rm_new(blockedClientBatchCtx);
+    BCBctx->reqs = reqs;
+    BCBctx->blockedClient = BlockQueryClient(ctx, spec_ref, reqs[0], 0);
+    BCBctx->spec_ref = StrongRef_Demote(spec_ref);
+    array_foreach(reqs, req, AREQ_AddRequestFlags(req, QEXEC_F_RUN_IN_BACKGROUND));
+    const int rc = workersThreadPool_AddWork((redisearch_thpool_proc)searchBatch_Execute_Callback, BCBctx);
+    RS_ASSERT(rc == 0);
+  } else {
+    CurrentThread_SetIndexSpec(spec_ref);
+    searchBatch_Execute(reqs, ctx, NULL);
+    CurrentThread_ClearIndexSpec();
+  }
+  return REDISMODULE_OK;
+}
+
 int RSAggregateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return execCommandCommon(ctx, argv, argc, COMMAND_AGGREGATE, EXEC_NO_FLAGS);
 }
 
+/* FT.EXPORT {index} {query} [AGGREGATE options...]
+ * Run the aggregation, replying with its rows as an Arrow IPC stream */
+int RSExportCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  return execCommandCommon(ctx, argv, argc, COMMAND_AGGREGATE, EXEC_ARROW_EXPORT);
+}
+
 int RSSearchCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  const int batchOffset = AREQ_SearchBatchOffset(argv, argc);
+  if (batchOffset) {
+    return execSearchBatch(ctx, argv, argc, batchOffset);
+  }
   return execCommandCommon(ctx, argv, argc, COMMAND_SEARCH, EXEC_NO_FLAGS);
 }
 
@@ -1058,8 +1697,41 @@ int RSProfileCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return REDISMODULE_OK;
 }
 
+// The decisions of the planner and the estimated number of results of each iterator, against the
+// number each one read once the iterators are run to the end. Runs the iterators of the request
+static char *explainCost(AREQ *r, const char *explain) {
+  if (!r->rootiter) {
+    return rm_strdup(explain);
+  }
+  // The slow log may have counted them already
+  if (r->rootiter->type != PROFILE_ITERATOR) {
+    Profile_AddCounters(&r->rootiter);
+  }
+  const size_t cost = QueryAdmission_Cost(r->rootiter, AREQ_AGGPlan(r));
+  size_t numResults = 0;
+  while (r->rootiter->Read(r->rootiter) == ITERATOR_OK) {
+    numResults++;
+  }
+
+  sds s = sdscatprintf(sdsnew(explain),
+                       "COST {\n  Optimizer mode: %s\n  Estimated cost: %zu\n  Results: %zu\n",
+                       IsOptimized(r) ? QOptimizer_PrintType(r->optimizer) : "No optimization",
+                       cost, numResults);
+  // One iterator per line, indented by its depth
+  char *iterators = Profile_DescribeIterators(r->rootiter);
+  for (char *line = iterators, *end; (end = strchr(line, '\n')); line = end + 1) {
+    s = sdscatlen(sdscatlen(s, "  ", 2), line, end - line + 1);
+  }
+  rm_free(iterators);
+  s = sdscat(s, "}\n");
+
+  char *ret = rm_strndup(s, sdslen(s));
+  sdsfree(s);
+  return ret;
+}
+
 char *RS_GetExplainOutput(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
-                          QueryError *status) {
+                          bool withCost, QueryError *status) {
   AREQ *r = AREQ_New();
   if (buildRequest(ctx, argv, argc, COMMAND_EXPLAIN, status, &r) != REDISMODULE_OK) {
     return NULL;
@@ -1070,6 +1742,11 @@ char *RS_GetExplainOutput(RedisModuleCtx *ctx, RedisModuleString **argv, int arg
     return NULL;
   }
   char *ret = QAST_DumpExplain(&r->ast, AREQ_SearchCtx(r)->spec);
+  if (withCost) {
+    char *explain = ret;
+    ret = explainCost(r, explain);
+    rm_free(explain);
+  }
   AREQ_Free(r);
   CurrentThread_ClearIndexSpec();
   return ret;
@@ -1083,16 +1760,73 @@ int AREQ_StartCursor(AREQ *r, RedisModule_Reply *reply, StrongRef spec_ref, Quer
   }
   cursor->execState = r;
   r->cursor_id = cursor->id;
-  runCursor(reply, cursor, 0);
+  runCursor(reply, cursor, 0, false);
   return REDISMODULE_OK;
 }
 
-// Assumes that the cursor has a strong ref to the relevant spec and that it is already locked.
-static void runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num) {
+/* When all the remaining rows of a cursor are held by a sorter or a grouper, which only the
+ * pager, the filters and the projections follow, drain them into a spilled rows processor and
+ * release the processors and the iterators below, so that the paused cursor only costs its rows.
+ * The rows are kept as they are replied, so nothing else can be sent with them */
+static void spillCursorResults(AREQ *req) {
+  QueryProcessingCtx *qctx = AREQ_QueryProcessingCtx(req);
+  RedisSearchCtx *sctx = AREQ_SearchCtx(req);
+  if (IsProfile(req) || !sctx || !sctx->spec || !qctx->rootProc || qctx->rootProc->type == RP_NETWORK ||
+      (sctx->spec->rule && sctx->spec->rule->type == DocumentType_Json) ||
+      (AREQ_RequestFlags(req) & (QEXEC_FORMAT_EXPAND | QEXEC_F_IS_SEARCH | QEXEC_F_SEND_SCORES |
+                                 QEXEC_F_SENDRAWIDS | QEXEC_F_SEND_PAYLOADS |
+                                 QEXEC_F_SEND_SORTKEYS | QEXEC_F_REQUIRED_FIELDS))) {
+    return;
+  }
+
+  // Find the processor holding the rows, and the one reading from it
+  ResultProcessor *downstream = NULL, *held = qctx->endProc;
+  while (held && (held->type == RP_PROJECTOR || held->type == RP_FILTER ||
+                  held->type == RP_PAGER_LIMITER)) {
+    downstream = held;
+    held = held->upstream;
+  }
+  if (!held || held == qctx->rootProc || !RP_HoldsAllResults(held)) {
+    return;
+  }
+
+  RLookup *lk = AGPLN_GetLookup(AREQ_AGGPlan(req), NULL, AGPLN_GETLOOKUP_LAST);
+  ResultProcessor *spilled = RPSpilledRows_New(held, lk);
+  spilled->parent = qctx;
+  if (downstream) {
+    downstream->upstream = spilled;
+  } else {
+    qctx->endProc = spilled;
+  }
+  qctx->rootProc = spilled;
+
+  // The iterators are freed with the query iterator processor, which owns them
+  for (ResultProcessor *rp = held; rp;) {
+    ResultProcessor *next = rp->upstream;
+    rp->Free(rp);
+    rp = next;
+  }
+  req->stateflags &= ~QEXEC_S_HAS_LOAD;
+}
+
+/* Whether the next chunk of the cursor may be read ahead of its client. Results which are all
+ * aggregated before the reply are not read ahead, nor are profiles */
+static bool canReadCursorAhead(const Cursor *cursor, const AREQ *req) {
+  return RSGlobalConfig.cursorReadAheadBytes && !cursor->is_coord && !IsProfile(req) &&
+         req->reqConfig.timeoutPolicy != TimeoutPolicy_Fail &&
+         req->reqConfig.oomPolicy != OomPolicy_Fail;
+}
+
+/* Assumes that the cursor has a strong ref to the relevant spec and that it is already locked.
+ * If `readAhead` is set and the cursor is not done, it is kept taken for the next chunk to be read
+ * ahead, and true is returned */
+static bool runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num, bool readAhead) {
   AREQ *req = cursor->execState;
 
   // update timeout for current cursor read
   SearchCtx_UpdateTime(AREQ_SearchCtx(req), req->reqConfig.queryTimeoutMS);
+  // the read stops early if the cursor is deleted meanwhile (e.g. by a coordinator whose client left)
+  AREQ_SetCancelToken(req, &cursor->cancel);
 
   if (!num) {
     num = req->cursorConfig.chunkSize;
@@ -1107,13 +1841,20 @@ static void runCursor(RedisModule_Reply *reply, Cursor *cursor, size_t num) {
 
   if (req->stateflags & QEXEC_S_ITERDONE) {
     Cursor_Free(cursor);
+  } else if (readAhead && canReadCursorAhead(cursor, req)) {
+    Cursor_StartReadAhead(cursor);
+    return true;
   } else {
+    if (RSGlobalConfig.spillIdleCursors) {
+      spillCursorResults(req);
+    }
     // Update the idle timeout
     Cursor_Pause(cursor);
   }
+  return false;
 }
 
-static QueryProcessingCtx *prepareForCursorRead(Cursor *cursor, bool *hasLoader, bool *initClock, QEFlags *reqFlags, QueryError *status) {
+static QueryProcessingCtx *prepareForCursorRead(Cursor *cursor, bool *hasLoader, QEFlags *reqFlags, QueryError *status) {
   AREQ *req = cursor->execState;
   QueryProcessingCtx *qctx = NULL;
   if (req) {
@@ -1121,7 +1862,6 @@ static QueryProcessingCtx *prepareForCursorRead(Cursor *cursor, bool *hasLoader,
     AREQ_RemoveRequestFlags(req, QEXEC_F_IS_AGGREGATE); // Second read was not triggered by FT.AGGREGATE
     *reqFlags = AREQ_RequestFlags(req);
     *hasLoader = HasLoader(req);
-    *initClock = IsProfile(req) || !IsInternal(req);
   } else {
     HybridRequest *hreq = StrongRef_Get(cursor->hybrid_ref);
     *reqFlags = hreq->reqflags;
@@ -1134,15 +1874,15 @@ static QueryProcessingCtx *prepareForCursorRead(Cursor *cursor, bool *hasLoader,
   return qctx;
 }
 
-static void cursorRead(RedisModule_Reply *reply, Cursor *cursor, size_t count, bool bg) {
+/* Returns true if the cursor is to be read ahead, see runCursor() */
+static bool cursorRead(RedisModule_Reply *reply, Cursor *cursor, size_t count, bool bg) {
 
   QueryError status = QueryError_Default();
 
   QEFlags reqFlags = 0;
   bool hasLoader = false;
-  bool initClock = false;
   AREQ *req = cursor->execState;
-  QueryProcessingCtx *qctx = prepareForCursorRead(cursor, &hasLoader, &initClock, &reqFlags, &status);
+  QueryProcessingCtx *qctx = prepareForCursorRead(cursor, &hasLoader, &reqFlags, &status);
   StrongRef execution_ref;
   bool has_spec = cursor_HasSpecWeakRef(cursor);
   // If the cursor is associated with a spec, e.g a coordinator ctx.
@@ -1152,7 +1892,7 @@ static void cursorRead(RedisModule_Reply *reply, Cursor *cursor, size_t count, b
       // The index was dropped while the cursor was idle.
       // Notify the client that the query was aborted.
       RedisModule_Reply_Error(reply, "The index was dropped while the cursor was idle");
-      return;
+      return false;
     }
 
     if (hasLoader) { // Quick check if the cursor has loaders.
@@ -1171,18 +1911,20 @@ static void cursorRead(RedisModule_Reply *reply, Cursor *cursor, size_t count, b
     }
   }
 
-  if (initClock) {
+  if (req) {
     rs_wall_clock_init(&req->initClock); // Reset the clock for the current cursor read
   }
 
+  bool readAhead = false;
   if (req) {
-    runCursor(reply, cursor, count);
+    readAhead = runCursor(reply, cursor, count, bg && has_spec);
   } else {
     // TODO: run hybrid cursor - this needs to be implemented for the coordinator
   }
   if (has_spec) {
     IndexSpecRef_Release(execution_ref);
   }
+  return readAhead;
 }
 
 typedef struct {
@@ -1191,16 +1933,45 @@ typedef struct {
   size_t count;
 } CursorReadCtx;
 
+/* Read the next chunk of the cursor into its pipeline, once its client got the previous one.
+ * Returns the read of the client which came meanwhile, if any */
+static CursorReadCtx *cursorReadAhead(Cursor *cursor, size_t count) {
+  StrongRef execution_ref = IndexSpecRef_Promote(cursor->spec_ref);
+  if (StrongRef_Get(execution_ref)) {
+    AREQ *req = cursor->execState;
+    RedisSearchCtx *sctx = AREQ_SearchCtx(req);
+    QueryError status = QueryError_Default();
+    QueryProcessingCtx *qctx = AREQ_QueryProcessingCtx(req);
+    qctx->err = &status;
+    SearchCtx_UpdateTime(sctx, req->reqConfig.queryTimeoutMS);
+    AREQ_SetCancelToken(req, &cursor->cancel);
+    IndexSpec_IncrActiveQueries(sctx->spec);
+    RPReadAhead_Fill(qctx, req->cursorConfig.chunkSize, RSGlobalConfig.cursorReadAheadBytes);
+    IndexSpec_DecrActiveQueries(sctx->spec);
+    RedisSearchCtx_UnlockSpec(sctx);
+    QueryError_ClearError(&status);
+    IndexSpecRef_Release(execution_ref);
+  }
+  // If the index was dropped meanwhile, the next read fails as it would have
+  return Cursor_EndReadAhead(cursor);
+}
+
 static void cursorRead_ctx(CursorReadCtx *cr_ctx) {
-  RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(cr_ctx->bc);
-  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
-  cursorRead(reply, cr_ctx->cursor, cr_ctx->count, true);
-  RedisModule_EndReply(reply);
-  RedisModule_FreeThreadSafeContext(ctx);
-  RedisModule_BlockedClientMeasureTimeEnd(cr_ctx->bc);
-  void *privdata = RedisModule_BlockClientGetPrivateData(cr_ctx->bc);
-  RedisModule_UnblockClient(cr_ctx->bc, privdata);
-  rm_free(cr_ctx);
+  // Serve the reads which came while the cursor was read ahead, in turn
+  while (cr_ctx) {
+    Cursor *cursor = cr_ctx->cursor;
+    size_t count = cr_ctx->count;
+    RedisModuleCtx *ctx = RedisModule_GetThreadSafeContext(cr_ctx->bc);
+    RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+    bool readAhead = cursorRead(reply, cursor, count, true);
+    RedisModule_EndReply(reply);
+    RedisModule_FreeThreadSafeContext(ctx);
+    RedisModule_BlockedClientMeasureTimeEnd(cr_ctx->bc);
+    void *privdata = RedisModule_BlockClientGetPrivateData(cr_ctx->bc);
+    RedisModule_UnblockClient(cr_ctx->bc, privdata);
+    rm_free(cr_ctx);
+    cr_ctx = readAhead ? cursorReadAhead(cursor, count) : NULL;
+  }
 }
 
 /**
@@ -1246,20 +2017,27 @@ int RSCursorCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
       }
     }
 
-    Cursor *cursor = Cursors_TakeForExecution(GetGlobalCursor(cid), cid);
+    // We have to check that we are not blocked yet from elsewhere (e.g. coordinator)
+    bool inThread = RunInThread() && !RedisModule_GetBlockedClientHandle(ctx);
+    // A cursor read ahead by a worker is only read in a worker
+    bool queued = false;
+    Cursor *cursor = inThread ? Cursors_TakeForRead(GetGlobalCursor(cid), cid, &queued)
+                              : Cursors_TakeForExecution(GetGlobalCursor(cid), cid);
     if (cursor == NULL) {
       RedisModule_ReplyWithErrorFormat(ctx, "Cursor not found, id: %d", cid);
       RedisModule_EndReply(reply);
       return REDISMODULE_OK;
     }
 
-    // We have to check that we are not blocked yet from elsewhere (e.g. coordinator)
-    if (RunInThread() && !RedisModule_GetBlockedClientHandle(ctx)) {
+    if (inThread) {
       CursorReadCtx *cr_ctx = rm_new(CursorReadCtx);
       cr_ctx->bc = BlockCursorClient(ctx, cursor, count, 0);
       cr_ctx->cursor = cursor;
       cr_ctx->count = count;
-      workersThreadPool_AddWork((redisearch_thpool_proc)cursorRead_ctx, cr_ctx);
+      // The worker reading the cursor ahead serves the read once done
+      if (!queued || !Cursor_QueueRead(cursor, cr_ctx)) {
+        workersThreadPool_AddWork((redisearch_thpool_proc)cursorRead_ctx, cr_ctx);
+      }
     } else {
       cursorRead(reply, cursor, count, false);
     }
@@ -37,8 +37,7 @@
  void destroyResults(SearchResult **results) {
    if (results) {
      for (size_t i = 0; i < array_len(results); i++) {
-       SearchResult_Destroy(results[i]);
-       rm_free(results[i]);
+       SearchResult_Free(results[i]);
      }
      array_free(results);
    }
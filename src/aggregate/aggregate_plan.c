@@ -9,8 +9,12 @@
 #include "aggregate_plan.h"
 #include "reducer.h"
 #include "expr/expression.h"
+#include "query.h"
+#include "spec.h"
+#include "numeric_filter.h"
 #include <util/arr.h>
 #include <ctype.h>
+#include <math.h>
 
 static const char *steptypeToString(PLN_StepType type) {
   switch (type) {
@@ -266,6 +270,176 @@ RLookup *AGPLN_GetLookup(const AGGPlan *pln, const PLN_BaseStep *bstp, AGPLNGetL
   return NULL;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+// Gets the indexed NUMERIC field that the expression is a property of, or NULL
+static const FieldSpec *pushdownField(const IndexSpec *spec, const RSExpr *e) {
+  if (e->t != RSExpr_Property) {
+    return NULL;
+  }
+  const FieldSpec *fs = IndexSpec_GetFieldWithLength(spec, e->property.key, strlen(e->property.key));
+  if (!fs || !FIELD_IS(fs, INDEXFLD_T_NUMERIC) || !FieldSpec_IsIndexable(fs)) {
+    return NULL;
+  }
+  return fs;
+}
+
+static bool pushdownNumber(const RSExpr *e, double *num) {
+  if (e->t != RSExpr_Literal || !RSValue_IsNumber(&e->literal)) {
+    return false;
+  }
+  *num = RSValue_Number_Get(&e->literal);
+  return !isnan(*num);
+}
+
+// Splits a comparison of a field and a number into both, with the field on the left hand side
+static bool pushdownComparison(const IndexSpec *spec, const RSExpr *e, const FieldSpec **fs,
+                               RSCondition *cond, double *num) {
+  if (e->t != RSExpr_Predicate || !e->pred.left || !e->pred.right) {
+    return false;
+  }
+  *cond = e->pred.cond;
+  if ((*fs = pushdownField(spec, e->pred.left)) && pushdownNumber(e->pred.right, num)) {
+    return true;
+  }
+  if (!(*fs = pushdownField(spec, e->pred.right)) || !pushdownNumber(e->pred.left, num)) {
+    return false;
+  }
+  switch (*cond) {
+    case RSCondition_Lt: *cond = RSCondition_Gt; break;
+    case RSCondition_Le: *cond = RSCondition_Ge; break;
+    case RSCondition_Gt: *cond = RSCondition_Lt; break;
+    case RSCondition_Ge: *cond = RSCondition_Le; break;
+    default: break;
+  }
+  return true;
+}
+
+// Collects the values of an IN-list, i.e. equalities of the same field joined by `||`
+static bool pushdownInList(const IndexSpec *spec, const RSExpr *e, const FieldSpec **fs,
+                           arrayof(double) *values) {
+  if (e->t == RSExpr_Predicate && e->pred.cond == RSCondition_Or) {
+    return e->pred.left && e->pred.right &&
+           pushdownInList(spec, e->pred.left, fs, values) &&
+           pushdownInList(spec, e->pred.right, fs, values);
+  }
+  const FieldSpec *cur;
+  RSCondition cond;
+  double num;
+  if (!pushdownComparison(spec, e, &cur, &cond, &num) || cond != RSCondition_Eq ||
+      (*fs && *fs != cur)) {
+    return false;
+  }
+  *fs = cur;
+  array_append(*values, num);
+  return true;
+}
+
+static int cmpDouble(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x > y ? 1 : (x < y ? -1 : 0);
+}
+
+static void addFailingRange(QueryNode *un, const FieldSpec *fs, double min, double max,
+                            bool inclusiveMin, bool inclusiveMax) {
+  QueryNode *n = NewQueryNode(QN_NUMERIC);
+  n->nn.nf = NewNumericFilter(min, max, inclusiveMin, inclusiveMax, true, fs);
+  QueryNode_AddChild(un, n);
+}
+
+// Builds the union of the ranges of values for which the predicate is false, or NULL if the
+// predicate is not a comparison or an IN-list of an indexed numeric field
+static QueryNode *pushdownFailingRanges(const IndexSpec *spec, const RSExpr *e) {
+  const FieldSpec *fs = NULL;
+  RSCondition cond;
+  double num;
+  QueryNode *un = NULL;
+
+  if (pushdownComparison(spec, e, &fs, &cond, &num) && cond != RSCondition_Eq) {
+    un = NewUnionNode();
+    switch (cond) {
+      case RSCondition_Gt: addFailingRange(un, fs, -INFINITY, num, true, true); break;
+      case RSCondition_Ge: addFailingRange(un, fs, -INFINITY, num, true, false); break;
+      case RSCondition_Lt: addFailingRange(un, fs, num, INFINITY, true, true); break;
+      case RSCondition_Le: addFailingRange(un, fs, num, INFINITY, false, true); break;
+      case RSCondition_Ne: addFailingRange(un, fs, num, num, true, true); break;
+      default:
+        QueryNode_Free(un);
+        return NULL;
+    }
+    return un;
+  }
+
+  // A single equality is an IN-list of one value
+  fs = NULL;
+  arrayof(double) values = array_new(double, 4);
+  if (pushdownInList(spec, e, &fs, &values)) {
+    qsort(values, array_len(values), sizeof(*values), cmpDouble);
+    un = NewUnionNode();
+    // The gaps before, between and after the listed values
+    double prev = -INFINITY;
+    for (size_t ii = 0; ii < array_len(values); ++ii) {
+      if (values[ii] > prev) {
+        addFailingRange(un, fs, prev, values[ii], ii == 0, false);
+      }
+      prev = values[ii];
+    }
+    if (prev < INFINITY) {
+      addFailingRange(un, fs, prev, INFINITY, false, true);
+    }
+  }
+  array_free(values);
+  return un;
+}
+
+void AGPLN_PushDownFilters(const AGGPlan *pln, const IndexSpec *spec, QueryAST *ast) {
+  // Find the first FILTER, which must see every row the root produces
+  const PLN_MapFilterStep *fstp = NULL;
+  DLLIST_FOREACH(nn, &pln->steps) {
+    const PLN_BaseStep *stp = DLLIST_ITEM(nn, PLN_BaseStep, llnodePln);
+    if (stp->type == PLN_T_ROOT) {
+      continue;
+    } else if (stp->type == PLN_T_FILTER) {
+      fstp = (const PLN_MapFilterStep *)stp;
+      break;
+    } else if (stp->type != PLN_T_LOAD) {
+      return;
+    }
+    // An aliased LOAD may hide the indexed field behind the name the FILTER uses
+    const PLN_LoadStep *lstp = (const PLN_LoadStep *)stp;
+    for (size_t ii = 0; ii < lstp->args.argc; ++ii) {
+      if (!strcasecmp(AC_StringArg(&lstp->args, ii), "AS")) {
+        return;
+      }
+    }
+  }
+  if (!fstp) {
+    return;
+  }
+
+  QueryError status = QueryError_Default();
+  RSExpr *root = ExprAST_Parse(fstp->expr, &status);
+  if (!root) {
+    // The pipeline reports the error when it parses the expression again
+    QueryError_ClearError(&status);
+    return;
+  }
+
+  // `&&` does not evaluate its right hand side once its left one is false, and so this is the
+  // only conjunct whose failure never hides an error
+  const RSExpr *e = root;
+  while (e->t == RSExpr_Predicate && e->pred.cond == RSCondition_And && e->pred.left) {
+    e = e->pred.left;
+  }
+
+  QueryNode *failing = pushdownFailingRanges(spec, e);
+  if (failing) {
+    // Rows missing the field are still filtered (and fail) as before
+    SetFilterNode(ast, NewNotNode(failing));
+  }
+  ExprAST_Free(root);
+}
+
 void AGPLN_FreeSteps(AGGPlan *pln) {
   DLLIST_node *nn = pln->steps.next;
   while (nn && nn != &pln->steps) {
@@ -291,6 +291,20 @@ typedef enum {
  */
 RLookup *AGPLN_GetLookup(const AGGPlan *pln, const PLN_BaseStep *bstp, AGPLNGetLookupMode mode);
 
+struct QueryAST;
+struct IndexSpec;
+
+/**
+ * Narrow the query by the first FILTER of the plan, if only LOAD steps precede it and its
+ * leading conjunct compares an indexed NUMERIC field with a number, or lists the numbers the
+ * field is in (`@f == 1 || @f == 2`). The documents whose indexed value fails the predicate are
+ * then excluded by the iterators, and are never loaded.
+ *
+ * The FILTER step is kept as is, so that it still evaluates (and reports errors for) every
+ * other row, such as those missing the field.
+ */
+void AGPLN_PushDownFilters(const AGGPlan *pln, const struct IndexSpec *spec, struct QueryAST *ast);
+
 /**
  * @brief Dumps the contents of an aggregation plan to stdout for debugging.
  *
@@ -8,12 +8,14 @@
 */
 #include "aggregate.h"
 #include "reducer.h"
+#include "arrow_export.h"
 
 #include <query.h>
 #include <extension.h>
 #include <result_processor.h>
 #include <util/arr.h>
 #include <rmutil/util.h>
+#include <math.h>
 #include "ext/default.h"
 #include "extension.h"
 #include "profile.h"
@@ -24,6 +26,7 @@
 #include "obfuscation/hidden.h"
 #include "hybrid/vector_query_utils.h"
 #include "vector_index.h"
+#include "query_plan_cache.h"
 
 extern RSConfig RSGlobalConfig;
 
@@ -318,6 +321,10 @@ static int handleCommonArgs(ParseAggPlanContext *papCtx, ArgsCursor *ac, QueryEr
     }
   } else if (AC_AdvanceIfMatch(ac, "_NUM_SSTRING")) {
     REQFLAGS_AddFlags(papCtx->reqflags, QEXEC_F_TYPED);
+  } else if (AC_AdvanceIfMatch(ac, "_BINARY_ROWS")) {
+    REQFLAGS_AddFlags(papCtx->reqflags, QEXEC_F_BINARY_ROWS);
+  } else if (AC_AdvanceIfMatch(ac, "_INDEX_REVISION")) {
+    REQFLAGS_AddFlags(papCtx->reqflags, QEXEC_F_SEND_REVISION);
   } else if (AC_AdvanceIfMatch(ac, "WITHRAWIDS")) {
     REQFLAGS_AddFlags(papCtx->reqflags, QEXEC_F_SENDRAWIDS);
   } else if (AC_AdvanceIfMatch(ac, "PARAMS")) {
@@ -572,6 +579,20 @@ static int parseQueryArgs(ArgsCursor *ac, AREQ *req, RSSearchOptions *searchOpts
       if (rv == ARG_ERROR) {
         return REDISMODULE_ERR;
       }
+    } else if ((AREQ_RequestFlags(req) & QEXEC_F_IS_SEARCH) &&
+               AC_AdvanceIfMatch(ac, "_SCORE_THRESHOLD")) {
+      if (AC_GetDouble(ac, &req->scoreThreshold, 0) != AC_OK) {
+        QueryError_SetError(status, QUERY_ERROR_CODE_PARSE_ARGS, "Bad arguments for _SCORE_THRESHOLD");
+        return REDISMODULE_ERR;
+      }
+      req->hasScoreThreshold = true;
+    } else if ((AREQ_RequestFlags(req) & QEXEC_F_IS_SEARCH) &&
+               AC_AdvanceIfMatch(ac, "_KNN_DISTANCE_BOUND")) {
+      if (AC_GetDouble(ac, &searchOpts->knnDistanceBound, 0) != AC_OK) {
+        QueryError_SetError(status, QUERY_ERROR_CODE_PARSE_ARGS, "Bad arguments for _KNN_DISTANCE_BOUND");
+        return REDISMODULE_ERR;
+      }
+      searchOpts->hasKnnDistanceBound = true;
     } else if (AC_AdvanceIfMatch(ac, "WITHCOUNT")) {
       AREQ_RemoveRequestFlags(req, QEXEC_OPTIMIZE);
       optimization_specified = true;
@@ -896,6 +917,27 @@ error:
 
 
 
+// SAMPLE {ratio | count}: a ratio in (0, 1] of the results, or an integral count of documents
+static int parseSample(RSSearchOptions *opts, ArgsCursor *ac, QueryError *status) {
+  double value;
+  if (opts->sampleRatio > 0 || opts->sampleCount) {
+    QueryError_SetError(status, QUERY_ERROR_CODE_PARSE_ARGS, "SAMPLE specified more than once");
+    return REDISMODULE_ERR;
+  }
+  if (AC_GetDouble(ac, &value, 0) != AC_OK || !(value > 0) ||
+      (value > 1 && (value != floor(value) || value > SIZE_MAX))) {
+    QueryError_SetError(status, QUERY_ERROR_CODE_PARSE_ARGS,
+                        "SAMPLE requires a ratio between 0 and 1, or a positive count");
+    return REDISMODULE_ERR;
+  }
+  if (value <= 1) {
+    opts->sampleRatio = value;
+  } else {
+    opts->sampleCount = value;
+  }
+  return REDISMODULE_OK;
+}
+
 static int handleLoad(AGGPlan *plan, uint32_t *reqflags, ArgsCursor *ac, QueryError *status) {
   ArgsCursor loadfields = {0};
   int rc = AC_GetVarArgs(ac, &loadfields);
@@ -982,6 +1024,11 @@ int parseAggPlan(ParseAggPlanContext *papCtx, ArgsCursor *ac, QueryError *status
       if (handleApplyOrFilter(papCtx->plan, ac, status, 0) != REDISMODULE_OK) {
         return REDISMODULE_ERR;
       }
+    } else if (AC_AdvanceIfMatch(ac, "SAMPLE")) {
+      if (!ensureExtendedMode(papCtx->reqflags, "SAMPLE", status) ||
+          parseSample(papCtx->searchopts, ac, status) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+      }
     } else {
       QueryError_FmtUnknownArg(status, ac, "<main>");
         return REDISMODULE_ERR;
@@ -1216,6 +1263,94 @@ static int applyVectorQuery(AREQ *req, RedisSearchCtx *sctx, QueryAST *ast, Quer
   return REDISMODULE_OK;
 }
 
+// Parse the query of the request into its tree, or copy the tree cached by a previous request with
+// the same query string, before its parameters are bound
+static int parseQueryTree(AREQ *req, RedisSearchCtx *sctx, unsigned int dialectVersion,
+                          QueryError *status) {
+  const RSSearchOptions *opts = &req->searchopts;
+  QueryAST *ast = &req->ast;
+  const size_t len = strlen(req->query);
+  QueryPlanCache *cache = sctx->spec->queryPlans;
+  const size_t capacity = RSGlobalConfig.queryPlanCacheEntries;
+  if (!capacity || !cache || !QueryPlanCache_IsCacheable(req->query, len)) {
+    return QAST_Parse(ast, sctx, opts, req->query, len, dialectVersion, status);
+  }
+
+  sds key = QueryPlanCache_Key(req->query, len, dialectVersion, !(opts->flags & Search_NoStopWords));
+  int rc = REDISMODULE_OK;
+  if (QueryPlanCache_Get(cache, key, ast)) {
+    if (!ast->query) {
+      ast->query = rm_strndup(req->query, len);
+      ast->nquery = len;
+    }
+  } else {
+    rc = QAST_Parse(ast, sctx, opts, req->query, len, dialectVersion, status);
+    if (rc == REDISMODULE_OK) {
+      QueryPlanCache_Put(cache, key, ast, capacity);
+    }
+  }
+  sdsfree(key);
+  return rc;
+}
+
+// Parse the query of the request into its tree, and apply the options and optimizations to it
+static int applyQueryTree(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
+  IndexSpec *index = sctx->spec;
+  RSSearchOptions *opts = &req->searchopts;
+  QueryAST *ast = &req->ast;
+
+  unsigned long dialectVersion = req->reqConfig.dialectVersion;
+
+  int rv = parseQueryTree(req, sctx, dialectVersion, status);
+  if (rv != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+
+  if (req->parsedVectorData) {
+    int rv = applyVectorQuery(req, sctx, ast, status);
+    if (rv != REDISMODULE_OK) {
+      return REDISMODULE_ERR;
+    }
+  }
+
+  if (QAST_EvalParams(ast, opts, dialectVersion, status) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  if (applyGlobalFilters(opts, ast, sctx, dialectVersion, status) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+
+  if (QAST_CheckIsValid(ast, AREQ_SearchCtx(req)->spec, opts, status) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+
+  if (!(opts->flags & Search_Verbatim)) {
+    if (QAST_Expand(ast, opts->expanderName, opts, sctx, status) != REDISMODULE_OK) {
+      return REDISMODULE_ERR;
+    }
+  }
+
+  // Let the iterators drop the documents a leading FILTER rejects. A KNN query takes its
+  // neighbours before filtering them, and the scores depend on the query nodes, so leave both be
+  if (!IsHybrid(req) && !IsScorerNeeded(req) && !isSpecJson(index) &&
+      ast->root && ast->root->type != QN_VECTOR) {
+    AGPLN_PushDownFilters(AREQ_AGGPlan(req), index, ast);
+  }
+
+  // set queryAST configuration parameters
+  iteratorsConfig_init(&ast->config);
+
+  QAST_Canonicalize(ast, opts);
+
+  if (IsOptimized(req)) {
+    // parse inputs for optimizations
+    QOptimizer_Parse(req);
+    // check possible optimization after creation of QueryNode tree
+    QOptimizer_QueryNodes(req->ast.root, req->optimizer);
+  }
+  return REDISMODULE_OK;
+}
+
 int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   // Sort through the applicable options:
   IndexSpec *index = sctx->spec;
@@ -1282,50 +1417,12 @@ int AREQ_ApplyContext(AREQ *req, RedisSearchCtx *sctx, QueryError *status) {
   req->slotRanges = Slots_GetLocalSlots();
 
   SetSearchCtx(sctx, req);
-  QueryAST *ast = &req->ast;
-
-  unsigned long dialectVersion = req->reqConfig.dialectVersion;
-
-  int rv = QAST_Parse(ast, sctx, opts, req->query, strlen(req->query), dialectVersion, status);
-  if (rv != REDISMODULE_OK) {
-    return REDISMODULE_ERR;
-  }
-
-  if (req->parsedVectorData) {
-    int rv = applyVectorQuery(req, sctx, ast, status);
-    if (rv != REDISMODULE_OK) {
-      return REDISMODULE_ERR;
-    }
-  }
-
-  if (QAST_EvalParams(ast, opts, dialectVersion, status) != REDISMODULE_OK) {
-    return REDISMODULE_ERR;
-  }
-  if (applyGlobalFilters(opts, ast, sctx, dialectVersion, status) != REDISMODULE_OK) {
-    return REDISMODULE_ERR;
-  }
-
-  if (QAST_CheckIsValid(ast, AREQ_SearchCtx(req)->spec, opts, status) != REDISMODULE_OK) {
-    return REDISMODULE_ERR;
-  }
-
-  if (!(opts->flags & Search_Verbatim)) {
-    if (QAST_Expand(ast, opts->expanderName, opts, sctx, status) != REDISMODULE_OK) {
-      return REDISMODULE_ERR;
-    }
-  }
-
-  // set queryAST configuration parameters
-  iteratorsConfig_init(&ast->config);
 
-  if (IsOptimized(req)) {
-    // parse inputs for optimizations
-    QOptimizer_Parse(req);
-    // check possible optimization after creation of QueryNode tree
-    QOptimizer_QueryNodes(req->ast.root, req->optimizer);
-  }
-
-  if (QueryError_HasError(status)) {
+  // The query tree lives as long as the request, so its nodes are taken from the request's arena
+  Arena *prevArena = Arena_SetCurrent(&req->arena);
+  int rc = applyQueryTree(req, sctx, status);
+  Arena_SetCurrent(prevArena);
+  if (rc != REDISMODULE_OK || QueryError_HasError(status)) {
     return REDISMODULE_ERR;
   }
 
@@ -1338,6 +1435,10 @@ void AREQ_Free(AREQ *req) {
   // was created to take ownership of it.
   bool rootiterNeedsFreeing = (req->rootiter != NULL && req->pipeline.qctx.rootProc == NULL);
 
+  if (AREQ_RequestFlags(req) & QEXEC_F_PROFILE_SAMPLED) {
+    Profile_CountSampled(&req->pipeline.qctx);
+  }
+
   // First, free the pipeline
   Pipeline_Clean(&req->pipeline);
 
@@ -1349,6 +1450,13 @@ void AREQ_Free(AREQ *req) {
     req->rootiter->Free(req->rootiter);
   }
   req->rootiter = NULL;
+  if (req->rangeRoots) {
+    for (size_t i = 0; i < array_len(req->rangeRoots); i++) {
+      req->rangeRoots[i]->Free(req->rangeRoots[i]);
+    }
+    array_free(req->rangeRoots);
+    req->rangeRoots = NULL;
+  }
   if (req->optimizer) {
     QOptimizer_Free(req->optimizer);
   }
@@ -1407,7 +1515,12 @@ void AREQ_Free(AREQ *req) {
     req->parsedVectorData = NULL;
   }
 
+  if (req->arrowExport) {
+    ArrowExportWriter_Free(req->arrowExport);
+  }
+
   rm_free(req->args);
+  Arena_Free(&req->arena);
   rm_free(req);
 }
 
@@ -1425,11 +1538,13 @@ int AREQ_BuildPipeline(AREQ *req, QueryError *status) {
       },
       .ast = &req->ast,
       .rootiter = req->rootiter,
+      .rangeRoots = req->rangeRoots,
       .slotRanges = req->slotRanges,
       .scorerName = req->searchopts.scorerName,
       .reqConfig = &req->reqConfig,
     };
     req->rootiter = NULL; // Ownership of the root iterator is now with the params.
+    req->rangeRoots = NULL;
     req->slotRanges = NULL; // Ownership of the slot ranges is now with the params.
     Pipeline_BuildQueryPart(&req->pipeline, &params);
     if (QueryError_HasError(status)) {
@@ -1447,6 +1562,9 @@ int AREQ_BuildPipeline(AREQ *req, QueryError *status) {
     .outFields = &req->outFields,
     .maxResultsLimit = IsSearch(req) ? req->maxSearchResults : req->maxAggregateResults,
     .language = req->searchopts.language,
+    .scoreThreshold = req->hasScoreThreshold ? &req->scoreThreshold : NULL,
+    // The coordinator only adds up the values its shards scaled up
+    .sampleRatio = AREQ_RequestFlags(req) & QEXEC_F_BUILDPIPELINE_NO_ROOT ? 0 : req->searchopts.sampleRatio,
   };
   return Pipeline_BuildAggregationPart(&req->pipeline, &params, &req->stateflags);
 }
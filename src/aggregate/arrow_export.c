@@ -0,0 +1,460 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "arrow_export.h"
+#include "rmalloc.h"
+
+#include <string.h>
+
+/* Each message of the stream is:
+ *   u32 0xFFFFFFFF continuation marker
+ *   i32 length of the metadata, padded to 8 bytes
+ *   the metadata: a FlatBuffers `Message` table (see Message.fbs and Schema.fbs of Arrow)
+ *   the body: the buffers of the columns, each padded to 8 bytes
+ * and the stream ends with a continuation marker followed by a zero length.
+ *
+ * The FlatBuffers are laid out front to back: a table is written before the tables, vectors and
+ * strings it refers to, so that their offsets (which are unsigned) point forward, and its vtable
+ * is written just before it. Like the rest of the stream, they are in little endian, the byte
+ * order of the hosts the module runs on */
+
+#define ARROW_CONTINUATION 0xFFFFFFFF
+#define ARROW_METADATA_V5 4
+#define ARROW_ALIGNMENT 8
+
+// The members of the unions, and the values of the enums, of the Arrow schema
+enum { MESSAGE_HEADER_SCHEMA = 1, MESSAGE_HEADER_RECORD_BATCH = 3 };
+enum { TYPE_FLOATING_POINT = 3, TYPE_UTF8 = 5 };
+enum { PRECISION_DOUBLE = 2 };
+enum { ENDIANNESS_LITTLE = 0 };
+
+typedef enum { KIND_NULL = 0, KIND_NUMBER, KIND_STRING } ValueKind;
+
+static void put(Buffer *b, const void *data, size_t len) {
+  if (!len) {
+    return;
+  }
+  BufferWriter bw = NewBufferWriter(b);
+  Buffer_Write(&bw, data, len);
+}
+
+static void putByte(Buffer *b, uint8_t c) {
+  put(b, &c, 1);
+}
+
+static void putU32(Buffer *b, uint32_t n) {
+  put(b, &n, sizeof(n));
+}
+
+static void padTo(Buffer *b, size_t alignment) {
+  static const char zeros[ARROW_ALIGNMENT] = {0};
+  put(b, zeros, (alignment - b->offset % alignment) % alignment);
+}
+
+/******************************************************************************
+ * FlatBuffers
+ ******************************************************************************/
+
+typedef enum {
+  FB_ABSENT = 0,  // Left to its default value
+  FB_U8,
+  FB_I16,
+  FB_I64,
+  FB_OFFSET,      // To an object written later, see fbSetOffset()
+} FbFieldKind;
+
+typedef struct {
+  FbFieldKind kind;
+  int64_t value;
+} FbField;
+
+static const uint8_t fbFieldSize[] = {
+  [FB_ABSENT] = 0, [FB_U8] = 1, [FB_I16] = 2, [FB_I64] = 8, [FB_OFFSET] = 4,
+};
+
+/* Write a table with the fields (by their id), and its vtable. The position of each of its
+ * FB_OFFSET fields is written to `slots`, for fbSetOffset(). Returns the position of the table */
+static size_t fbTable(Buffer *b, const FbField *fields, uint16_t n, size_t *slots) {
+  // The fields are laid out from the largest, so that each is aligned on its size
+  static const FbFieldKind order[] = {FB_I64, FB_OFFSET, FB_I16, FB_U8};
+  uint16_t voffsets[n ? n : 1];
+  uint16_t size = 4;  // The offset to the vtable
+  bool hasI64 = false;
+  for (size_t k = 0; k < sizeof(order) / sizeof(*order); k++) {
+    for (uint16_t i = 0; i < n; i++) {
+      if (fields[i].kind == order[k]) {
+        voffsets[i] = size;
+        size += fbFieldSize[order[k]];
+        hasI64 |= order[k] == FB_I64;
+      }
+    }
+  }
+  for (uint16_t i = 0; i < n; i++) {
+    if (fields[i].kind == FB_ABSENT) {
+      voffsets[i] = 0;
+    }
+  }
+
+  padTo(b, 4);
+  const size_t vtable = b->offset;
+  uint16_t header[2] = {4 + 2 * n, size};
+  put(b, header, sizeof(header));
+  put(b, voffsets, n * sizeof(*voffsets));
+  // The 8 byte fields come right after the offset to the vtable
+  padTo(b, 4);
+  if (hasI64 && b->offset % 8 != 4) {
+    putU32(b, 0);
+  }
+  const size_t table = b->offset;
+  int32_t soffset = table - vtable;
+  put(b, &soffset, sizeof(soffset));
+  for (size_t k = 0; k < sizeof(order) / sizeof(*order); k++) {
+    for (uint16_t i = 0; i < n; i++) {
+      if (fields[i].kind != order[k]) {
+        continue;
+      }
+      if (order[k] == FB_OFFSET) {
+        *slots++ = b->offset;
+      }
+      // The values are written in little endian, as their lowest bytes
+      put(b, &fields[i].value, fbFieldSize[order[k]]);
+    }
+  }
+  return table;
+}
+
+// Point the offset written at `slot` to the object at `target`
+static void fbSetOffset(Buffer *b, size_t slot, size_t target) {
+  uint32_t off = target - slot;
+  memcpy(b->data + slot, &off, sizeof(off));
+}
+
+// Write a vector of `n` offsets, to be set later. Returns the position of the first one
+static size_t fbOffsetVector(Buffer *b, uint32_t n) {
+  padTo(b, 4);
+  putU32(b, n);
+  const size_t first = b->offset;
+  for (uint32_t i = 0; i < n; i++) {
+    putU32(b, 0);
+  }
+  return first;
+}
+
+// Write the length of a vector of structs of 8 byte members, which follow it
+static size_t fbStructVector(Buffer *b, uint32_t n) {
+  padTo(b, 4);
+  if (b->offset % 8 != 4) {
+    putU32(b, 0);
+  }
+  const size_t pos = b->offset;
+  putU32(b, n);
+  return pos;
+}
+
+static size_t fbString(Buffer *b, const char *s, size_t len) {
+  padTo(b, 4);
+  const size_t pos = b->offset;
+  putU32(b, len);
+  put(b, s, len);
+  putByte(b, 0);
+  return pos;
+}
+
+/* Write the Message table with the header of the given type, after the root offset. Returns the
+ * slot of the offset to the header */
+static size_t fbMessage(Buffer *b, uint8_t headerType, int64_t bodyLength) {
+  size_t root = b->offset, slot;
+  putU32(b, 0);
+  FbField message[] = {
+    {FB_I16, ARROW_METADATA_V5},  // version
+    {FB_U8, headerType},          // header_type
+    {FB_OFFSET},                  // header
+    {FB_I64, bodyLength},         // bodyLength
+  };
+  fbSetOffset(b, root, fbTable(b, message, sizeof(message) / sizeof(*message), &slot));
+  return slot;
+}
+
+// Append the metadata of a message, then its body
+static void writeMessage(Buffer *out, Buffer *metadata, const Buffer *body) {
+  padTo(metadata, ARROW_ALIGNMENT);
+  putU32(out, ARROW_CONTINUATION);
+  putU32(out, metadata->offset);
+  put(out, metadata->data, metadata->offset);
+  if (body) {
+    put(out, body->data, body->offset);
+  }
+}
+
+/******************************************************************************
+ * Messages
+ ******************************************************************************/
+
+static bool isExported(const ArrowExportColumn *col) {
+  return col->name != NULL;
+}
+
+static void writeSchema(ArrowExportWriter *w, Buffer *out) {
+  uint32_t numFields = 0;
+  for (uint32_t i = 0; i < array_len(w->columns); i++) {
+    numFields += isExported(&w->columns[i]);
+  }
+
+  Buffer fb = {0};
+  Buffer_Init(&fb, 256 + numFields * 128);
+  size_t slot = fbMessage(&fb, MESSAGE_HEADER_SCHEMA, 0);
+  FbField schema[] = {
+    {FB_I16, ENDIANNESS_LITTLE},  // endianness
+    {FB_OFFSET},                  // fields
+  };
+  size_t fieldsSlot;
+  fbSetOffset(&fb, slot, fbTable(&fb, schema, sizeof(schema) / sizeof(*schema), &fieldsSlot));
+  size_t fieldSlot = fbOffsetVector(&fb, numFields);
+  fbSetOffset(&fb, fieldsSlot, fieldSlot - 4);
+
+  for (uint32_t i = 0; i < array_len(w->columns); i++) {
+    ArrowExportColumn *col = &w->columns[i];
+    if (!isExported(col)) {
+      continue;
+    }
+    const bool isFloat = col->type == ARROW_EXPORT_FLOAT64;
+    FbField field[] = {
+      {FB_OFFSET},                                        // name
+      {FB_U8, 1},                                         // nullable
+      {FB_U8, isFloat ? TYPE_FLOATING_POINT : TYPE_UTF8},  // type_type
+      {FB_OFFSET},                                        // type
+      {FB_ABSENT},                                        // dictionary
+      {FB_OFFSET},                                        // children
+    };
+    size_t slots[3];
+    fbSetOffset(&fb, fieldSlot, fbTable(&fb, field, sizeof(field) / sizeof(*field), slots));
+    fieldSlot += 4;
+    fbSetOffset(&fb, slots[0], fbString(&fb, col->name, col->nameLen));
+    FbField floatingPoint[] = {{FB_I16, PRECISION_DOUBLE}};  // precision
+    fbSetOffset(&fb, slots[1], fbTable(&fb, floatingPoint, isFloat ? 1 : 0, NULL));
+    fbSetOffset(&fb, slots[2], fbOffsetVector(&fb, 0) - 4);
+  }
+
+  writeMessage(out, &fb, NULL);
+  Buffer_Free(&fb);
+}
+
+typedef struct {
+  int64_t offset;
+  int64_t length;
+} BodyBuffer;
+
+// Append the data to the body, and describe it as the next of its buffers
+static void addBodyBuffer(Buffer *body, arrayof(BodyBuffer) *buffers, const void *data, size_t len) {
+  BodyBuffer bb = {.offset = body->offset, .length = len};
+  put(body, data, len);
+  padTo(body, ARROW_ALIGNMENT);
+  array_append(*buffers, bb);
+}
+
+/* Add the validity bitmap of the column to the body, or an empty one if it has no nulls. Returns
+ * the number of nulls */
+static int64_t addValidity(Buffer *body, arrayof(BodyBuffer) *buffers, const ArrowExportColumn *col) {
+  const uint8_t *kinds = (const uint8_t *)col->kinds.data;
+  // The strings are null in a Float64 column, the numbers are formatted in a Utf8 one
+  const uint8_t invalid = col->type == ARROW_EXPORT_FLOAT64 ? (1 << KIND_NULL | 1 << KIND_STRING)
+                                                            : (1 << KIND_NULL);
+  int64_t nulls = 0;
+  for (uint32_t i = 0; i < col->numRows; i++) {
+    nulls += (invalid >> kinds[i]) & 1;
+  }
+  if (!nulls) {
+    addBodyBuffer(body, buffers, NULL, 0);
+    return 0;
+  }
+  const size_t len = (col->numRows + 7) / 8;
+  uint8_t *bitmap = rm_calloc(len, 1);
+  for (uint32_t i = 0; i < col->numRows; i++) {
+    bitmap[i / 8] |= !((invalid >> kinds[i]) & 1) << (i % 8);
+  }
+  addBodyBuffer(body, buffers, bitmap, len);
+  rm_free(bitmap);
+  return nulls;
+}
+
+static void writeRecordBatch(ArrowExportWriter *w, Buffer *out) {
+  Buffer body = {0};
+  Buffer_Init(&body, 1024);
+  arrayof(BodyBuffer) buffers = array_new(BodyBuffer, 3 * array_len(w->columns));
+  arrayof(BodyBuffer) nodes = array_new(BodyBuffer, array_len(w->columns));
+
+  for (uint32_t i = 0; i < array_len(w->columns); i++) {
+    ArrowExportColumn *col = &w->columns[i];
+    if (!isExported(col)) {
+      continue;
+    }
+    BodyBuffer node = {.offset = col->numRows};  // length and null_count
+    node.length = addValidity(&body, &buffers, col);
+    array_append(nodes, node);
+    if (col->type == ARROW_EXPORT_FLOAT64) {
+      addBodyBuffer(&body, &buffers, col->doubles.data, col->doubles.offset);
+    } else {
+      const int32_t end = col->chars.offset;
+      put(&col->offsets, &end, sizeof(end));
+      addBodyBuffer(&body, &buffers, col->offsets.data, col->offsets.offset);
+      addBodyBuffer(&body, &buffers, col->chars.data, col->chars.offset);
+    }
+  }
+
+  Buffer fb = {0};
+  Buffer_Init(&fb, 256 + array_len(buffers) * sizeof(BodyBuffer));
+  size_t slot = fbMessage(&fb, MESSAGE_HEADER_RECORD_BATCH, body.offset);
+  FbField batch[] = {
+    {FB_I64, w->numRows},  // length
+    {FB_OFFSET},           // nodes
+    {FB_OFFSET},           // buffers
+  };
+  size_t slots[2];
+  fbSetOffset(&fb, slot, fbTable(&fb, batch, sizeof(batch) / sizeof(*batch), slots));
+  // The FieldNode and Buffer structs are both a pair of int64
+  fbSetOffset(&fb, slots[0], fbStructVector(&fb, array_len(nodes)));
+  put(&fb, nodes, array_len(nodes) * sizeof(*nodes));
+  fbSetOffset(&fb, slots[1], fbStructVector(&fb, array_len(buffers)));
+  put(&fb, buffers, array_len(buffers) * sizeof(*buffers));
+
+  writeMessage(out, &fb, &body);
+  Buffer_Free(&fb);
+  Buffer_Free(&body);
+  array_free(buffers);
+  array_free(nodes);
+}
+
+/******************************************************************************
+ * Writer
+ ******************************************************************************/
+
+ArrowExportWriter *ArrowExportWriter_New(void) {
+  return rm_calloc(1, sizeof(ArrowExportWriter));
+}
+
+static void columnClearRows(ArrowExportColumn *col) {
+  col->numRows = 0;
+  col->kinds.offset = col->doubles.offset = col->offsets.offset = col->chars.offset = 0;
+}
+
+void ArrowExportWriter_Free(ArrowExportWriter *w) {
+  for (uint32_t i = 0; i < array_len(w->columns); i++) {
+    ArrowExportColumn *col = &w->columns[i];
+    rm_free(col->name);
+    Buffer_Free(&col->kinds);
+    Buffer_Free(&col->doubles);
+    Buffer_Free(&col->offsets);
+    Buffer_Free(&col->chars);
+  }
+  array_free(w->columns);
+  rm_free(w);
+}
+
+static ArrowExportColumn *getColumn(ArrowExportWriter *w, uint32_t pos) {
+  if (!w->columns) {
+    w->columns = array_new(ArrowExportColumn, pos + 1);
+  }
+  while (array_len(w->columns) <= pos) {
+    array_append(w->columns, (ArrowExportColumn){0});
+  }
+  return &w->columns[pos];
+}
+
+void ArrowExportWriter_AddColumn(ArrowExportWriter *w, uint32_t pos, const char *name, size_t len) {
+  RS_ASSERT(!w->schemaWritten);
+  ArrowExportColumn *col = getColumn(w, pos);
+  rm_free(col->name);
+  col->name = rm_strndup(name, len);
+  col->nameLen = len;
+}
+
+static void appendValue(ArrowExportColumn *col, ValueKind kind, double d, const char *s, size_t len) {
+  putByte(&col->kinds, kind);
+  if (col->type != ARROW_EXPORT_UTF8) {
+    put(&col->doubles, &d, sizeof(d));
+  }
+  if (col->type != ARROW_EXPORT_FLOAT64) {
+    const int32_t start = col->chars.offset;
+    put(&col->offsets, &start, sizeof(start));
+    put(&col->chars, s, len);
+  }
+  col->numRows++;
+}
+
+// Add the missing values of the column up to `numRows`
+static void padColumn(ArrowExportColumn *col, uint32_t numRows) {
+  while (col->numRows < numRows) {
+    appendValue(col, KIND_NULL, 0, NULL, 0);
+  }
+}
+
+void ArrowExportWriter_AddValue(ArrowExportWriter *w, uint32_t pos, const RSValue *v) {
+  if (w->schemaWritten && (pos >= array_len(w->columns) || !isExported(&w->columns[pos]))) {
+    return;
+  }
+  ArrowExportColumn *col = getColumn(w, pos);
+  padColumn(col, w->numRows);
+
+  v = RSValue_Dereference(v);
+  switch (RSValue_Type(v)) {
+    case RSValueType_Number: {
+      char buf[128];
+      size_t len = col->type == ARROW_EXPORT_FLOAT64 ? 0 : RSValue_NumToString(v, buf);
+      appendValue(col, KIND_NUMBER, RSValue_Number_Get(v), buf, len);
+      col->sawNumber = true;
+      break;
+    }
+    case RSValueType_String:
+    case RSValueType_RedisString:
+    case RSValueType_OwnRstring: {
+      size_t len;
+      const char *s = RSValue_StringPtrLen(v, &len);
+      appendValue(col, KIND_STRING, 0, s, len);
+      col->sawString = true;
+      break;
+    }
+    default:
+      appendValue(col, KIND_NULL, 0, NULL, 0);
+      break;
+  }
+}
+
+void ArrowExportWriter_EndRow(ArrowExportWriter *w) {
+  w->numRows++;
+}
+
+void ArrowExportWriter_Finish(ArrowExportWriter *w, bool eos, Buffer *out) {
+  if (!w->schemaWritten) {
+    for (uint32_t i = 0; i < array_len(w->columns); i++) {
+      ArrowExportColumn *col = &w->columns[i];
+      col->type = col->sawNumber && !col->sawString ? ARROW_EXPORT_FLOAT64 : ARROW_EXPORT_UTF8;
+    }
+    writeSchema(w, out);
+    w->schemaWritten = true;
+  }
+
+  if (w->numRows) {
+    for (uint32_t i = 0; i < array_len(w->columns); i++) {
+      ArrowExportColumn *col = &w->columns[i];
+      if (!isExported(col)) {
+        continue;
+      }
+      padColumn(col, w->numRows);
+    }
+    writeRecordBatch(w, out);
+  }
+  for (uint32_t i = 0; i < array_len(w->columns); i++) {
+    columnClearRows(&w->columns[i]);
+  }
+  w->numRows = 0;
+
+  if (eos) {
+    putU32(out, ARROW_CONTINUATION);
+    putU32(out, 0);
+  }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "buffer/buffer.h"
+#include "value.h"
+#include "util/arr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The rows of a FT.EXPORT, written as an Arrow IPC stream: a schema message, then a record batch
+ * message per chunk of rows, then the end-of-stream marker. The stream is split between the
+ * chunks of the reply, as the bulk strings of their results, so that the client reads it by
+ * concatenating them.
+ *
+ * The columns are the fields of the rows. A column whose values in the first chunk are all
+ * numbers is a Float64 one, the others are Utf8 ones. The types are fixed by the schema, so the
+ * later values which are not numbers are null in a Float64 column, and the numbers of a Utf8
+ * column are formatted as they are in the RESP replies. The missing values, and the arrays and
+ * maps, are null. */
+
+typedef enum {
+  ARROW_EXPORT_UNKNOWN = 0,  // Until the schema is written
+  ARROW_EXPORT_FLOAT64,
+  ARROW_EXPORT_UTF8,
+} ArrowExportType;
+
+typedef struct {
+  char *name;       // NULL for the positions which are not exported
+  size_t nameLen;
+  ArrowExportType type;
+  bool sawNumber;   // Of the first chunk, which sets the type of the column
+  bool sawString;
+
+  // The values of the rows of the current chunk
+  uint32_t numRows;
+  Buffer kinds;     // A byte per row: null, number or string
+  Buffer doubles;   // Unless a Utf8 column
+  Buffer offsets;   // Unless a Float64 column, the int32 start of each string in `chars`
+  Buffer chars;
+} ArrowExportColumn;
+
+typedef struct ArrowExportWriter {
+  arrayof(ArrowExportColumn) columns;  // Indexed by the position of their key in the lookup
+  uint32_t numRows;
+  bool schemaWritten;
+} ArrowExportWriter;
+
+ArrowExportWriter *ArrowExportWriter_New(void);
+void ArrowExportWriter_Free(ArrowExportWriter *w);
+
+static inline bool ArrowExportWriter_HasSchema(const ArrowExportWriter *w) {
+  return w->schemaWritten;
+}
+
+/* Export the column of the field at `pos` in the lookup. The columns are added before the schema
+ * is written, and the values of the fields which are not exported are ignored */
+void ArrowExportWriter_AddColumn(ArrowExportWriter *w, uint32_t pos, const char *name, size_t len);
+
+/* Write the value of the field at `pos` to the current row */
+void ArrowExportWriter_AddValue(ArrowExportWriter *w, uint32_t pos, const RSValue *v);
+
+/* Done with the current row. The columns it has no value for are null in it */
+void ArrowExportWriter_EndRow(ArrowExportWriter *w);
+
+static inline uint32_t ArrowExportWriter_NumRows(const ArrowExportWriter *w) {
+  return w->numRows;
+}
+
+/* Append the messages of the chunk to `out`: the schema on the first chunk, then the record batch
+ * of the rows written since the last chunk, if any, then the end of the stream if `eos` */
+void ArrowExportWriter_Finish(ArrowExportWriter *w, bool eos, Buffer *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "binary_rows.h"
+#include "varint.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+
+/* The encoded rows are:
+ *   u8 version
+ *   varint rows
+ *   varint dictionary entries, and for each: varint length, bytes
+ *   varint columns, and for each: varint name length, name, u8 kind, varint data length, data
+ *
+ * The data of a BR_COLUMN_NUMBERS column is a double per row. The data of a BR_COLUMN_TAGGED
+ * column is a tagged value per row, a BR_ABSENT tag when the row has no value for the column.
+ * The doubles are in the byte order of the host, which is shared by the nodes of a cluster */
+
+typedef enum {
+  BR_ABSENT = 0,
+  BR_NULL,
+  BR_NUMBER,       // double
+  BR_DICT_STRING,  // varint index in the dictionary
+  BR_STRING,       // varint length, bytes
+  BR_ARRAY,        // varint length, values
+  BR_MAP,          // varint entries, key and value of each
+} BinaryRowsTag;
+
+typedef enum {
+  BR_COLUMN_NUMBERS = 0,
+  BR_COLUMN_TAGGED,
+} BinaryRowsColumnKind;
+
+#define DICT_MIN_CAP 64
+// A dictionary value is replaced by a new one once this many rows share it, far from the limit of
+// the refcount
+#define DICT_VALUE_MAX_REFS (1 << 14)
+
+static void put(Buffer *b, const void *data, size_t len) {
+  BufferWriter bw = NewBufferWriter(b);
+  Buffer_Write(&bw, data, len);
+}
+
+static void putByte(Buffer *b, uint8_t c) {
+  put(b, &c, 1);
+}
+
+static void putVarint(Buffer *b, uint32_t n) {
+  BufferWriter bw = NewBufferWriter(b);
+  WriteVarint(n, &bw);
+}
+
+/******************************************************************************
+ * Writer
+ ******************************************************************************/
+
+void BinaryRowsWriter_Init(BinaryRowsWriter *w, bool resp3) {
+  *w = (BinaryRowsWriter){.resp3 = resp3};
+}
+
+void BinaryRowsWriter_Free(BinaryRowsWriter *w) {
+  for (uint32_t i = 0; i < array_len(w->columns); i++) {
+    Buffer_Free(&w->columns[i].data);
+  }
+  array_free(w->columns);
+  array_free(w->dict);
+  Buffer_Free(&w->strings);
+  rm_free(w->slots);
+  *w = (BinaryRowsWriter){0};
+}
+
+static uint32_t dictProbe(const BinaryRowsWriter *w, uint64_t hash, const char *s, size_t len) {
+  uint32_t mask = w->cap - 1;
+  uint32_t i = (uint32_t)(hash ^ hash >> 32) & mask;
+  for (uint32_t e; (e = w->slots[i]); i = (i + 1) & mask) {
+    const BinaryRowsDictEntry *de = &w->dict[e - 1];
+    if (de->hash == hash && de->len == len && !memcmp(w->strings.data + de->offset, s, len)) {
+      break;
+    }
+  }
+  return i;
+}
+
+static void dictGrow(BinaryRowsWriter *w) {
+  rm_free(w->slots);
+  w->cap = w->cap ? w->cap * 2 : DICT_MIN_CAP;
+  w->slots = rm_calloc(w->cap, sizeof(*w->slots));
+  for (uint32_t i = 0; i < array_len(w->dict); i++) {
+    const BinaryRowsDictEntry *de = &w->dict[i];
+    w->slots[dictProbe(w, de->hash, w->strings.data + de->offset, de->len)] = i + 1;
+  }
+}
+
+/* The index of the string in the dictionary, where it is added if missing. -1 once the dictionary
+ * is full */
+static int64_t dictIndex(BinaryRowsWriter *w, const char *s, size_t len) {
+  uint64_t hash = fnv_64a_buf((void *)s, len, 0);
+  if (!w->cap) {
+    dictGrow(w);
+  }
+  uint32_t i = dictProbe(w, hash, s, len);
+  if (w->slots[i]) {
+    return w->slots[i] - 1;
+  }
+  uint32_t n = array_len(w->dict);
+  if (n >= BINARY_ROWS_DICT_MAX_ENTRIES) {
+    return -1;
+  }
+  BinaryRowsDictEntry de = {.offset = w->strings.offset, .len = len, .hash = hash};
+  put(&w->strings, s, len);
+  if (!w->dict) {
+    w->dict = array_new(BinaryRowsDictEntry, DICT_MIN_CAP);
+  }
+  array_append(w->dict, de);
+  // Keep the table at most half full
+  if ((n + 1) * 2 > w->cap) {
+    dictGrow(w);
+  } else {
+    w->slots[i] = n + 1;
+  }
+  return n;
+}
+
+static void writeValue(BinaryRowsWriter *w, Buffer *b, const RSValue *v) {
+  v = RSValue_Dereference(v);
+  switch (RSValue_Type(v)) {
+    case RSValueType_String:
+    case RSValueType_RedisString:
+    case RSValueType_OwnRstring: {
+      size_t len;
+      const char *s = RSValue_StringPtrLen(v, &len);
+      int64_t idx = len <= BINARY_ROWS_DICT_MAX_LEN ? dictIndex(w, s, len) : -1;
+      if (idx >= 0) {
+        putByte(b, BR_DICT_STRING);
+        putVarint(b, idx);
+      } else {
+        putByte(b, BR_STRING);
+        putVarint(b, len);
+        put(b, s, len);
+      }
+      break;
+    }
+    case RSValueType_Number: {
+      double d = RSValue_Number_Get(v);
+      putByte(b, BR_NUMBER);
+      put(b, &d, sizeof(d));
+      break;
+    }
+    case RSValueType_Trio:
+      writeValue(w, b, RSValue_Trio_GetMiddle(v));
+      break;
+    case RSValueType_Array:
+      putByte(b, BR_ARRAY);
+      putVarint(b, RSValue_ArrayLen(v));
+      for (uint32_t i = 0; i < RSValue_ArrayLen(v); i++) {
+        writeValue(w, b, RSValue_ArrayItem(v, i));
+      }
+      break;
+    case RSValueType_Map: {
+      uint32_t n = RSValue_Map_Len(v);
+      if (w->resp3) {
+        putByte(b, BR_MAP);
+        putVarint(b, n);
+      } else {
+        putByte(b, BR_ARRAY);
+        putVarint(b, n * 2);
+      }
+      for (uint32_t i = 0; i < n; i++) {
+        RSValue *key, *val;
+        RSValue_Map_GetEntry(v, i, &key, &val);
+        writeValue(w, b, key);
+        writeValue(w, b, val);
+      }
+      break;
+    }
+    default:
+      putByte(b, BR_NULL);
+      break;
+  }
+}
+
+/* Mark the column absent from the rows it has no value for, up to `numRows` */
+static void padColumn(BinaryRowsColumn *col, uint32_t numRows) {
+  for (; col->numRows < numRows; col->numRows++) {
+    putByte(&col->data, BR_ABSENT);
+    col->mixed = true;
+  }
+}
+
+void BinaryRowsWriter_AddValue(BinaryRowsWriter *w, uint32_t pos, const RLookupKey *key,
+                               const RSValue *v) {
+  BinaryRowsColumn *col = array_ensure_at(&w->columns, pos, BinaryRowsColumn);
+  col->key = key;
+  padColumn(col, w->numRows);
+  size_t start = col->data.offset;
+  writeValue(w, &col->data, v);
+  col->mixed |= col->data.data[start] != BR_NUMBER;
+  col->numRows++;
+}
+
+void BinaryRowsWriter_EndRow(BinaryRowsWriter *w) {
+  w->numRows++;
+}
+
+void BinaryRowsWriter_Finish(BinaryRowsWriter *w, Buffer *out) {
+  putByte(out, BINARY_ROWS_VERSION);
+  putVarint(out, w->numRows);
+
+  putVarint(out, array_len(w->dict));
+  for (uint32_t i = 0; i < array_len(w->dict); i++) {
+    putVarint(out, w->dict[i].len);
+    put(out, w->strings.data + w->dict[i].offset, w->dict[i].len);
+  }
+
+  uint32_t numColumns = 0;
+  for (uint32_t i = 0; i < array_len(w->columns); i++) {
+    numColumns += !!w->columns[i].key;
+  }
+  putVarint(out, numColumns);
+  for (uint32_t i = 0; i < array_len(w->columns); i++) {
+    BinaryRowsColumn *col = &w->columns[i];
+    if (!col->key) {
+      continue;
+    }
+    padColumn(col, w->numRows);
+    putVarint(out, col->key->name_len);
+    put(out, col->key->name, col->key->name_len);
+    if (!col->mixed) {
+      // Only numbers, drop their tags
+      putByte(out, BR_COLUMN_NUMBERS);
+      putVarint(out, w->numRows * sizeof(double));
+      for (uint32_t row = 0; row < w->numRows; row++) {
+        put(out, col->data.data + row * (1 + sizeof(double)) + 1, sizeof(double));
+      }
+    } else {
+      putByte(out, BR_COLUMN_TAGGED);
+      putVarint(out, col->data.offset);
+      put(out, col->data.data, col->data.offset);
+    }
+  }
+}
+
+/******************************************************************************
+ * Reader
+ ******************************************************************************/
+
+void BinaryRowsReader_Init(BinaryRowsReader *r, const char *data, size_t len, RLookup *lk) {
+  BinaryRowsReader_Free(r);
+
+  Buffer buf = {.data = (char *)data, .cap = len, .offset = len};
+  BufferReader br = NewBufferReader(&buf);
+  uint8_t version = Buffer_ReadU8(&br);
+  RS_LOG_ASSERT_FMT(version == BINARY_ROWS_VERSION, "unknown binary rows version %u", version);
+  r->numRows = ReadVarint(&br);
+
+  r->dictLen = ReadVarint(&br);
+  r->dict = r->dictLen ? rm_malloc(r->dictLen * sizeof(*r->dict)) : NULL;
+  for (uint32_t i = 0; i < r->dictLen; i++) {
+    uint32_t n = ReadVarint(&br);
+    r->dict[i] = RSValue_NewCopiedString(BufferReader_Current(&br), n);
+    Buffer_Skip(&br, n);
+  }
+
+  r->numColumns = ReadVarint(&br);
+  r->columns = r->numColumns ? rm_calloc(r->numColumns, sizeof(*r->columns)) : NULL;
+  for (uint32_t i = 0; i < r->numColumns; i++) {
+    BinaryRowsReaderColumn *col = &r->columns[i];
+    uint32_t n = ReadVarint(&br);
+    col->key = RLookup_GetKeyByName(lk, BufferReader_Current(&br), n);
+    Buffer_Skip(&br, n);
+    col->kind = Buffer_ReadU8(&br);
+    n = ReadVarint(&br);
+    col->data = (Buffer){.data = BufferReader_Current(&br), .cap = n, .offset = n};
+    col->reader = NewBufferReader(&col->data);
+    Buffer_Skip(&br, n);
+  }
+  RS_LOG_ASSERT(br.pos == len, "invalid binary rows");
+}
+
+void BinaryRowsReader_Free(BinaryRowsReader *r) {
+  for (uint32_t i = 0; i < r->dictLen; i++) {
+    RSValue_DecrRef(r->dict[i]);
+  }
+  rm_free(r->dict);
+  rm_free(r->columns);
+  *r = (BinaryRowsReader){0};
+}
+
+static RSValue *dictValue(BinaryRowsReader *r, uint32_t idx) {
+  RS_LOG_ASSERT(idx < r->dictLen, "invalid binary rows dictionary index");
+  RSValue *v = r->dict[idx];
+  if (__atomic_load_n(&v->_refcount, __ATOMIC_RELAXED) >= DICT_VALUE_MAX_REFS) {
+    size_t len;
+    const char *s = RSValue_StringPtrLen(v, &len);
+    r->dict[idx] = RSValue_NewCopiedString(s, len);
+    RSValue_DecrRef(v);
+    v = r->dict[idx];
+  }
+  return RSValue_IncrRef(v);
+}
+
+/* The next value of the reader, NULL if absent */
+static RSValue *readValue(BinaryRowsReader *r, BufferReader *br) {
+  switch (Buffer_ReadU8(br)) {
+    case BR_ABSENT:
+      return NULL;
+    case BR_NULL:
+      return RSValue_NullStatic();
+    case BR_NUMBER: {
+      double d;
+      Buffer_Read(br, &d, sizeof(d));
+      return RSValue_NewNumber(d);
+    }
+    case BR_DICT_STRING:
+      return dictValue(r, ReadVarint(br));
+    case BR_STRING: {
+      uint32_t n = ReadVarint(br);
+      RSValue *v = RSValue_NewCopiedString(BufferReader_Current(br), n);
+      Buffer_Skip(br, n);
+      return v;
+    }
+    case BR_ARRAY: {
+      uint32_t n = ReadVarint(br);
+      RSValue **arr = RSValue_AllocateArray(n);
+      for (uint32_t i = 0; i < n; i++) {
+        arr[i] = readValue(r, br);
+      }
+      return RSValue_NewArray(arr, n);
+    }
+    case BR_MAP: {
+      uint32_t n = ReadVarint(br);
+      RSValueMap map = RSValueMap_AllocUninit(n);
+      for (uint32_t i = 0; i < n; i++) {
+        RSValue *key = readValue(r, br);
+        RSValueMap_SetEntry(&map, i, key, readValue(r, br));
+      }
+      return RSValue_NewMap(map);
+    }
+    default:
+      RS_LOG_ASSERT(0, "invalid binary rows value");
+      return RSValue_NullStatic();
+  }
+}
+
+void BinaryRowsReader_Next(BinaryRowsReader *r, RLookupRow *row) {
+  for (uint32_t i = 0; i < r->numColumns; i++) {
+    BinaryRowsReaderColumn *col = &r->columns[i];
+    RSValue *v;
+    if (col->kind == BR_COLUMN_NUMBERS) {
+      double d;
+      Buffer_Read(&col->reader, &d, sizeof(d));
+      v = RSValue_NewNumber(d);
+    } else if (!(v = readValue(r, &col->reader))) {
+      continue;
+    }
+    RLookup_WriteOwnKey(col->key, row, v);
+  }
+  r->curRow++;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "buffer/buffer.h"
+#include "rlookup.h"
+#include "value.h"
+#include "util/arr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A compact encoding of the rows of a chunk of a shard reply, which the coordinator asks for with
+ * `_BINARY_ROWS` and which replaces the RESP rows of the reply by a single bulk string.
+ *
+ * The rows are encoded column by column. The values of a column which only holds numbers are
+ * written as plain doubles, the others are tagged. The strings of up to
+ * BINARY_ROWS_DICT_MAX_LEN bytes are written once in a dictionary shared by the columns and
+ * referred to by their index, so that the coordinator creates a single value for all their rows.
+ * The values are decoded as they would be from the RESP reply of a `_NUM_SSTRING` request. */
+
+#define BINARY_ROWS_VERSION 1
+#define BINARY_ROWS_DICT_MAX_LEN 64
+#define BINARY_ROWS_DICT_MAX_ENTRIES (1 << 16)
+
+typedef struct {
+  const RLookupKey *key;
+  Buffer data;
+  uint32_t numRows;  // The rows written to the column, the later ones are absent from it
+  bool mixed;        // Whether the column holds anything but numbers
+} BinaryRowsColumn;
+
+typedef struct {
+  uint32_t offset;  // Of the string in `strings`
+  uint32_t len;
+  uint64_t hash;
+} BinaryRowsDictEntry;
+
+typedef struct BinaryRowsWriter {
+  arrayof(BinaryRowsColumn) columns;  // Indexed by the position of their key in the lookup
+  uint32_t numRows;
+  bool resp3;  // Maps are sent as flat arrays on RESP2, as RedisModule_Reply_RSValue() does
+
+  // The string dictionary
+  arrayof(BinaryRowsDictEntry) dict;
+  Buffer strings;
+  uint32_t *slots;  // Open addressing table of the entries, holding their index plus one
+  uint32_t cap;
+} BinaryRowsWriter;
+
+void BinaryRowsWriter_Init(BinaryRowsWriter *w, bool resp3);
+void BinaryRowsWriter_Free(BinaryRowsWriter *w);
+
+/* Write the value of the key to the current row. `pos` is the position of the key among the
+ * fields of the lookup, which identifies its column */
+void BinaryRowsWriter_AddValue(BinaryRowsWriter *w, uint32_t pos, const RLookupKey *key,
+                               const RSValue *v);
+
+/* Done with the current row. The columns it has no value for are absent from it */
+void BinaryRowsWriter_EndRow(BinaryRowsWriter *w);
+
+static inline uint32_t BinaryRowsWriter_NumRows(const BinaryRowsWriter *w) {
+  return w->numRows;
+}
+
+/* Append the encoding of the rows written to `out` */
+void BinaryRowsWriter_Finish(BinaryRowsWriter *w, Buffer *out);
+
+typedef struct {
+  const RLookupKey *key;
+  uint8_t kind;
+  Buffer data;  // Points into the encoded rows
+  BufferReader reader;
+} BinaryRowsReaderColumn;
+
+typedef struct {
+  BinaryRowsReaderColumn *columns;
+  uint32_t numColumns;
+  uint32_t numRows;
+  uint32_t curRow;
+  RSValue **dict;
+  uint32_t dictLen;
+} BinaryRowsReader;
+
+/* Start reading the encoded rows, whose columns are written to the keys of the same names in the
+ * lookup (created if missing). The rows must outlive the reader */
+void BinaryRowsReader_Init(BinaryRowsReader *r, const char *data, size_t len, RLookup *lk);
+void BinaryRowsReader_Free(BinaryRowsReader *r);
+
+static inline bool BinaryRowsReader_AtEnd(const BinaryRowsReader *r) {
+  return r->curRow >= r->numRows;
+}
+
+/* Write the values of the next row into `row` */
+void BinaryRowsReader_Next(BinaryRowsReader *r, RLookupRow *row);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "bytecode.h"
+#include "rlookup.h"
+#include "search_result.h"
+#include "util/arr.h"
+#include "rmalloc.h"
+
+#include <math.h>
+
+typedef enum {
+  EXPR_OP_CONST,  // the constant `num`
+  EXPR_OP_LOAD,   // the numeric value of `key` in the row
+  EXPR_OP_ADD,
+  EXPR_OP_SUB,
+  EXPR_OP_MUL,
+  EXPR_OP_DIV,
+  EXPR_OP_MOD,
+  EXPR_OP_POW,
+  EXPR_OP_EQ,
+  EXPR_OP_NE,
+  EXPR_OP_LT,
+  EXPR_OP_LE,
+  EXPR_OP_GT,
+  EXPR_OP_GE,
+  EXPR_OP_AND,
+  EXPR_OP_OR,
+  EXPR_OP_NOT,    // unary, on `a`
+} ExprOpcode;
+
+// Every instruction writes the register of its own index, and reads registers of lower indexes
+typedef struct {
+  ExprOpcode code;
+  uint32_t a;
+  uint32_t b;
+  union {
+    double num;
+    const RLookupKey *key;
+  };
+} ExprInstr;
+
+struct ExprProgram {
+  ExprInstr *code;
+  uint32_t out;     // register holding the value of the expression
+
+  // Registers of the last run, each holding one value per row
+  double *regs;
+  bool *ok;         // whether the program could evaluate the row
+  size_t n;
+  size_t cap;
+};
+
+// Compares like RSValue_Cmp does for two numbers
+static inline int numCmp(double a, double b) {
+  return a > b ? 1 : (a < b ? -1 : 0);
+}
+
+static inline double applyOp(ExprOpcode code, double a, double b) {
+  switch (code) {
+    case EXPR_OP_ADD: return a + b;
+    case EXPR_OP_SUB: return a - b;
+    case EXPR_OP_MUL: return a * b;
+    case EXPR_OP_DIV: return a / b;
+    case EXPR_OP_MOD: return fmod(a, b);
+    case EXPR_OP_POW: return pow(a, b);
+    case EXPR_OP_EQ:  return numCmp(a, b) == 0;
+    case EXPR_OP_NE:  return numCmp(a, b) != 0;
+    case EXPR_OP_LT:  return numCmp(a, b) < 0;
+    case EXPR_OP_LE:  return numCmp(a, b) <= 0;
+    case EXPR_OP_GT:  return numCmp(a, b) > 0;
+    case EXPR_OP_GE:  return numCmp(a, b) >= 0;
+    case EXPR_OP_AND: return a != 0 && b != 0;
+    case EXPR_OP_OR:  return a != 0 || b != 0;
+    case EXPR_OP_NOT: return a == 0;
+    case EXPR_OP_CONST:
+    case EXPR_OP_LOAD:
+      break;
+  }
+  RS_ABORT("not an operator");
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+// A compiled sub-expression, either a constant or a register
+typedef struct {
+  bool isConst;
+  double num;
+  uint32_t reg;
+} Operand;
+
+static uint32_t emit(ExprProgram *prog, ExprInstr ins) {
+  array_append(prog->code, ins);
+  return array_len(prog->code) - 1;
+}
+
+static uint32_t materialize(ExprProgram *prog, Operand op) {
+  if (op.isConst) {
+    return emit(prog, (ExprInstr){.code = EXPR_OP_CONST, .num = op.num});
+  }
+  return op.reg;
+}
+
+static bool opcodeOfOp(unsigned char op, ExprOpcode *code) {
+  switch (op) {
+    case '+': *code = EXPR_OP_ADD; return true;
+    case '-': *code = EXPR_OP_SUB; return true;
+    case '*': *code = EXPR_OP_MUL; return true;
+    case '/': *code = EXPR_OP_DIV; return true;
+    case '%': *code = EXPR_OP_MOD; return true;
+    case '^': *code = EXPR_OP_POW; return true;
+  }
+  return false;
+}
+
+static ExprOpcode opcodeOfCondition(RSCondition cond) {
+  switch (cond) {
+    case RSCondition_Eq:  return EXPR_OP_EQ;
+    case RSCondition_Ne:  return EXPR_OP_NE;
+    case RSCondition_Lt:  return EXPR_OP_LT;
+    case RSCondition_Le:  return EXPR_OP_LE;
+    case RSCondition_Gt:  return EXPR_OP_GT;
+    case RSCondition_Ge:  return EXPR_OP_GE;
+    case RSCondition_And: return EXPR_OP_AND;
+    case RSCondition_Or:  return EXPR_OP_OR;
+  }
+  RS_ABORT("invalid RSCondition");
+  return EXPR_OP_EQ;
+}
+
+static bool compileExpr(ExprProgram *prog, const RSExpr *e, Operand *out);
+
+static bool compileBinary(ExprProgram *prog, ExprOpcode code, const RSExpr *left,
+                          const RSExpr *right, Operand *out) {
+  Operand l, r;
+  if (!left || !right || !compileExpr(prog, left, &l) || !compileExpr(prog, right, &r)) {
+    return false;
+  }
+  if (l.isConst && r.isConst) {
+    *out = (Operand){.isConst = true, .num = applyOp(code, l.num, r.num)};
+    return true;
+  }
+  uint32_t a = materialize(prog, l);
+  uint32_t b = materialize(prog, r);
+  *out = (Operand){.reg = emit(prog, (ExprInstr){.code = code, .a = a, .b = b})};
+  return true;
+}
+
+static bool compileExpr(ExprProgram *prog, const RSExpr *e, Operand *out) {
+  ExprOpcode code;
+  switch (e->t) {
+    case RSExpr_Literal:
+      if (!RSValue_IsNumber(&e->literal)) {
+        return false;
+      }
+      *out = (Operand){.isConst = true, .num = RSValue_Number_Get(&e->literal)};
+      return true;
+
+    case RSExpr_Property:
+      if (!e->property.lookupObj) {
+        return false;
+      }
+      *out = (Operand){.reg = emit(prog, (ExprInstr){.code = EXPR_OP_LOAD, .key = e->property.lookupObj})};
+      return true;
+
+    case RSExpr_Op:
+      if (!opcodeOfOp(e->op.op, &code)) {
+        return false;
+      }
+      return compileBinary(prog, code, e->op.left, e->op.right, out);
+
+    case RSExpr_Predicate:
+      return compileBinary(prog, opcodeOfCondition(e->pred.cond), e->pred.left, e->pred.right, out);
+
+    case RSExpr_Inverted: {
+      Operand child;
+      if (!e->inverted.child || !compileExpr(prog, e->inverted.child, &child)) {
+        return false;
+      }
+      if (child.isConst) {
+        *out = (Operand){.isConst = true, .num = applyOp(EXPR_OP_NOT, child.num, 0)};
+      } else {
+        *out = (Operand){.reg = emit(prog, (ExprInstr){.code = EXPR_OP_NOT, .a = child.reg})};
+      }
+      return true;
+    }
+
+    case RSExpr_Function:
+      return false;
+  }
+  return false;
+}
+
+ExprProgram *ExprProgram_Compile(const RSExpr *root) {
+  // A bare literal or property is as cheap to evaluate as it is, and need not be a number
+  if (!root || root->t == RSExpr_Literal || root->t == RSExpr_Property) {
+    return NULL;
+  }
+
+  ExprProgram *prog = rm_calloc(1, sizeof(*prog));
+  prog->code = array_new(ExprInstr, 8);
+  Operand res;
+  if (!compileExpr(prog, root, &res)) {
+    ExprProgram_Free(prog);
+    return NULL;
+  }
+  prog->out = materialize(prog, res);
+  return prog;
+}
+
+void ExprProgram_Free(ExprProgram *prog) {
+  array_free(prog->code);
+  rm_free(prog->regs);
+  rm_free(prog->ok);
+  rm_free(prog);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+#define RUN_UNARY(code)                                \
+  for (size_t i = 0; i < n; i++) {                     \
+    dst[i] = applyOp(code, a[i], 0);                   \
+  }
+
+#define RUN_BINARY(code)                               \
+  for (size_t i = 0; i < n; i++) {                     \
+    dst[i] = applyOp(code, a[i], b[i]);                \
+  }
+
+void ExprProgram_Run(ExprProgram *prog, const SearchResult *res, size_t n) {
+  size_t numRegs = array_len(prog->code);
+  if (n > prog->cap) {
+    prog->regs = rm_realloc(prog->regs, numRegs * n * sizeof(*prog->regs));
+    prog->ok = rm_realloc(prog->ok, n * sizeof(*prog->ok));
+    prog->cap = n;
+  }
+  prog->n = n;
+  for (size_t i = 0; i < n; i++) {
+    prog->ok[i] = true;
+  }
+
+  // Run the program one instruction at a time over all the rows
+  for (uint32_t ii = 0; ii < numRegs; ii++) {
+    const ExprInstr *ins = &prog->code[ii];
+    double *dst = prog->regs + ii * n;
+    const double *a = prog->regs + ins->a * n;
+    const double *b = prog->regs + ins->b * n;
+
+    switch (ins->code) {
+      case EXPR_OP_CONST:
+        for (size_t i = 0; i < n; i++) {
+          dst[i] = ins->num;
+        }
+        break;
+
+      case EXPR_OP_LOAD:
+        for (size_t i = 0; i < n; i++) {
+          const RSValue *v = RLookup_GetItem(ins->key, SearchResult_GetRowData(&res[i]));
+          v = v ? RSValue_Dereference(v) : NULL;
+          if (RSValue_IsNumber(v)) {
+            dst[i] = RSValue_Number_Get(v);
+          } else {
+            dst[i] = 0;
+            prog->ok[i] = false;
+          }
+        }
+        break;
+
+      // Spell out each operator so that its loop is compiled for it alone
+      case EXPR_OP_ADD: RUN_BINARY(EXPR_OP_ADD); break;
+      case EXPR_OP_SUB: RUN_BINARY(EXPR_OP_SUB); break;
+      case EXPR_OP_MUL: RUN_BINARY(EXPR_OP_MUL); break;
+      case EXPR_OP_DIV: RUN_BINARY(EXPR_OP_DIV); break;
+      case EXPR_OP_MOD: RUN_BINARY(EXPR_OP_MOD); break;
+      case EXPR_OP_POW: RUN_BINARY(EXPR_OP_POW); break;
+      case EXPR_OP_EQ:  RUN_BINARY(EXPR_OP_EQ);  break;
+      case EXPR_OP_NE:  RUN_BINARY(EXPR_OP_NE);  break;
+      case EXPR_OP_LT:  RUN_BINARY(EXPR_OP_LT);  break;
+      case EXPR_OP_LE:  RUN_BINARY(EXPR_OP_LE);  break;
+      case EXPR_OP_GT:  RUN_BINARY(EXPR_OP_GT);  break;
+      case EXPR_OP_GE:  RUN_BINARY(EXPR_OP_GE);  break;
+      case EXPR_OP_AND: RUN_BINARY(EXPR_OP_AND); break;
+      case EXPR_OP_OR:  RUN_BINARY(EXPR_OP_OR);  break;
+      case EXPR_OP_NOT: RUN_UNARY(EXPR_OP_NOT);  break;
+    }
+  }
+}
+
+bool ExprProgram_Result(const ExprProgram *prog, size_t i, double *value) {
+  RS_ASSERT(i < prog->n);
+  if (!prog->ok[i]) {
+    return false;
+  }
+  *value = prog->regs[prog->out * prog->n + i];
+  return true;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "expression.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A flat program computing a numeric expression over a batch of results.
+ *
+ * Only expressions made of number literals, properties, arithmetic operators, predicates and
+ * inversions are compiled. Every register holds a double, so the program is evaluated without
+ * creating any RSValue. A result whose properties are not all numbers cannot be evaluated by the
+ * program, and is left for the AST evaluator, which then produces the same value or error it
+ * always has.
+ */
+typedef struct ExprProgram ExprProgram;
+
+/**
+ * Compile the expression, whose lookup keys are already resolved. Sub-expressions that do not
+ * depend on a property are folded into constants.
+ * Returns NULL if the expression cannot be compiled
+ */
+ExprProgram *ExprProgram_Compile(const RSExpr *root);
+
+void ExprProgram_Free(ExprProgram *prog);
+
+/**
+ * Run the program over the rows of the `n` results. The value of each row is then available
+ * with ExprProgram_Result
+ */
+void ExprProgram_Run(ExprProgram *prog, const SearchResult *res, size_t n);
+
+/**
+ * Get the value of row `i` of the last run. Returns false if the program could not evaluate
+ * the row, in which case it should be evaluated with ExprEval_Eval
+ */
+bool ExprProgram_Result(const ExprProgram *prog, size_t i, double *value);
+
+#ifdef __cplusplus
+}
+#endif
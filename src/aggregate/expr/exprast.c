@@ -98,6 +98,7 @@ RSExpr *RS_NewFunc(RSFunctionInfo *cb, RSArgList *args) {
   e->func.args = args;
   e->func.name = cb->name;
   e->func.Call = cb->f;
+  e->func.memoizable = cb->memoizable;
   return e;
 }
 
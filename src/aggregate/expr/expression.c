@@ -7,9 +7,15 @@
  * GNU Affero General Public License v3 (AGPLv3).
 */
 #include "expression.h"
+#include "exprast.h"
+#include "bytecode.h"
 #include "result_processor.h"
 #include "rlookup.h"
 #include "profile.h"
+#include "config.h"
+#include "util/arr.h"
+#include "util/fnv.h"
+#include "hiredis/sds.h"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -41,7 +47,104 @@ static int evalFuncCase(ExprEval *eval, const RSFunctionExpr *f, RSValue *result
   return rc;
 }
 
-static int evalFunc(ExprEval *eval, const RSFunctionExpr *f, RSValue *result) {
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  const RSFunctionExpr *f;
+  sds args;         // the serialized arguments of the call
+  RSValue *value;
+} ExprMemoSlot;
+
+// Direct-mapped table of the recent results of memoizable functions
+struct ExprMemo {
+  size_t size;
+  sds args;         // the serialized arguments of the call being looked up
+  ExprMemoSlot slots[];
+};
+
+static struct ExprMemo *ExprMemo_New(size_t size) {
+  struct ExprMemo *memo = rm_calloc(1, sizeof(*memo) + size * sizeof(*memo->slots));
+  memo->size = size;
+  memo->args = sdsempty();
+  return memo;
+}
+
+static void ExprMemo_Free(struct ExprMemo *memo) {
+  for (size_t ii = 0; ii < memo->size; ii++) {
+    if (memo->slots[ii].value) {
+      sdsfree(memo->slots[ii].args);
+      RSValue_DecrRef(memo->slots[ii].value);
+    }
+  }
+  sdsfree(memo->args);
+  rm_free(memo);
+}
+
+// Serializes the arguments into `memo->args`. Returns false if one is neither a number nor a
+// string, as only those are cheap to compare
+static bool memoSerializeArgs(struct ExprMemo *memo, RSValue *args, size_t nargs) {
+  sds s = memo->args;
+  sdsclear(s);
+  for (size_t ii = 0; ii < nargs; ii++) {
+    const RSValue *v = RSValue_Dereference(&args[ii]);
+    // Functions may check the exact type of their arguments, and so must the key
+    unsigned char t = RSValue_Type(v);
+    s = sdscatlen(s, &t, 1);
+    if (RSValue_IsNumber(v)) {
+      double d = RSValue_Number_Get(v);
+      s = sdscatlen(s, &d, sizeof(d));
+    } else if (RSValue_IsAnyString(v)) {
+      size_t len;
+      const char *str = RSValue_StringPtrLen(v, &len);
+      s = sdscatlen(s, &len, sizeof(len));
+      s = sdscatlen(s, str, len);
+    } else {
+      memo->args = s;
+      return false;
+    }
+  }
+  memo->args = s;
+  return true;
+}
+
+// Calls the memoizable function `f`, or reuses the value of an earlier call with the same
+// arguments
+static int memoCall(ExprEval *eval, const RSFunctionExpr *f, RSValue *args, size_t nargs,
+                    RSValue *result) {
+  struct ExprMemo *memo = eval->memo;
+  if (!memoSerializeArgs(memo, args, nargs)) {
+    return f->Call(eval, args, nargs, result);
+  }
+  uint32_t h = rs_fnv_32a_buf(&f, sizeof(f), 0);
+  h = rs_fnv_32a_buf(memo->args, sdslen(memo->args), h);
+  ExprMemoSlot *slot = &memo->slots[h % memo->size];
+  if (slot->value && slot->f == f && sdslen(slot->args) == sdslen(memo->args) &&
+      !memcmp(slot->args, memo->args, sdslen(memo->args))) {
+    setReferenceValue(result, slot->value);
+    return EXPR_EVAL_OK;
+  }
+
+  RSValue *v = RSValue_NewWithType(RSValueType_Undef);
+  int rc = f->Call(eval, args, nargs, v);
+  if (rc != EXPR_EVAL_OK) {
+    // Errors are reported per call, and are not memoized
+    RSValue_DecrRef(v);
+    return rc;
+  }
+  if (slot->value) {
+    RSValue_DecrRef(slot->value);
+    sdsclear(slot->args);
+    slot->args = sdscatsds(slot->args, memo->args);
+  } else {
+    slot->args = sdsdup(memo->args);
+  }
+  slot->f = f;
+  slot->value = v;
+  setReferenceValue(result, v);
+  return EXPR_EVAL_OK;
+}
+
+static int evalFuncCall(ExprEval *eval, const RSFunctionExpr *f, RSValue *result) {
   int rc = EXPR_EVAL_ERR;
 
   // Special handling for func_case. The condition is evaluated to determine
@@ -71,7 +174,11 @@ static int evalFunc(ExprEval *eval, const RSFunctionExpr *f, RSValue *result) {
     nusedargs++;
   }
 
-  rc = f->Call(eval, args, nargs, result);
+  if (eval->memo && f->memoizable) {
+    rc = memoCall(eval, f, args, nargs, result);
+  } else {
+    rc = f->Call(eval, args, nargs, result);
+  }
 
 cleanup:
   for (size_t ii = 0; ii < nusedargs; ii++) {
@@ -80,6 +187,28 @@ cleanup:
   return rc;
 }
 
+static int evalFunc(ExprEval *eval, const RSFunctionExpr *f, RSValue *result) {
+  if (!f->cacheKey || !eval->srcrow) {
+    return evalFuncCall(eval, f, result);
+  }
+
+  // The call is shared with other steps, which may have evaluated it for this row already
+  RSValue *v = RLookup_GetItem(f->cacheKey, eval->srcrow);
+  if (v) {
+    setReferenceValue(result, v);
+    return EXPR_EVAL_OK;
+  }
+  v = RSValue_NewWithType(RSValueType_Undef);
+  int rc = evalFuncCall(eval, f, v);
+  if (rc == EXPR_EVAL_OK) {
+    // The hidden key is written by the calls sharing it alone, never by a step
+    RLookup_WriteKey(f->cacheKey, (RLookupRow *)eval->srcrow, v);
+    setReferenceValue(result, v);
+  }
+  RSValue_DecrRef(v);
+  return rc;
+}
+
 static int evalOp(ExprEval *eval, const RSExprOp *op, RSValue *result) {
   RSValue l = RSValue_Undefined(), r = RSValue_Undefined();
   int rc = EXPR_EVAL_ERR;
@@ -309,6 +438,168 @@ int ExprAST_GetLookupKeys(RSExpr *expr, RLookup *lookup, QueryError *err) {
   return EXPR_EVAL_OK;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ExprCSEEntry {
+  RSExpr *expr;       // the first call of its kind
+  char **props;       // the properties the call reads
+};
+
+static bool literalEqual(const RSValue *a, const RSValue *b) {
+  if (RSValue_Type(a) != RSValue_Type(b)) {
+    return false;
+  }
+  if (RSValue_IsNumber(a)) {
+    double x = RSValue_Number_Get(a), y = RSValue_Number_Get(b);
+    return !memcmp(&x, &y, sizeof(x));
+  }
+  if (RSValue_IsAnyString(a)) {
+    size_t la, lb;
+    const char *sa = RSValue_StringPtrLen(a, &la);
+    const char *sb = RSValue_StringPtrLen(b, &lb);
+    return la == lb && !memcmp(sa, sb, la);
+  }
+  return RSValue_IsNull(a);
+}
+
+// Whether both expressions are written the same, and so have the same value for a row
+static bool exprEqual(const RSExpr *a, const RSExpr *b) {
+  if (!a || !b) {
+    return a == b;
+  }
+  if (a->t != b->t) {
+    return false;
+  }
+  switch (a->t) {
+    case RSExpr_Literal:
+      return literalEqual(&a->literal, &b->literal);
+    case RSExpr_Property:
+      return !strcmp(a->property.key, b->property.key);
+    case RSExpr_Function:
+      if (a->func.Call != b->func.Call || a->func.args->len != b->func.args->len) {
+        return false;
+      }
+      for (size_t ii = 0; ii < a->func.args->len; ii++) {
+        if (!exprEqual(a->func.args->args[ii], b->func.args->args[ii])) {
+          return false;
+        }
+      }
+      return true;
+    case RSExpr_Op:
+      return a->op.op == b->op.op && exprEqual(a->op.left, b->op.left) &&
+             exprEqual(a->op.right, b->op.right);
+    case RSExpr_Predicate:
+      return a->pred.cond == b->pred.cond && exprEqual(a->pred.left, b->pred.left) &&
+             exprEqual(a->pred.right, b->pred.right);
+    case RSExpr_Inverted:
+      return exprEqual(a->inverted.child, b->inverted.child);
+  }
+  return false;
+}
+
+static void cseEntryFree(struct ExprCSEEntry *entry) {
+  array_free_ex(entry->props, rm_free(*(char **)ptr));
+  rm_free(entry);
+}
+
+// Shares the call with an equal one seen before. Returns false if the call is the first of its
+// kind, in which case it is tracked
+static bool cseShare(ExprCSE *cse, RSExpr *e) {
+  for (size_t ii = 0; ii < array_len(cse->entries); ii++) {
+    struct ExprCSEEntry *entry = cse->entries[ii];
+    if (!exprEqual(entry->expr, e)) {
+      continue;
+    }
+    RSFunctionExpr *first = &entry->expr->func;
+    if (!first->cacheKey) {
+      char name[32];
+      snprintf(name, sizeof(name), "__cse_%u", cse->numKeys++);
+      first->cacheKey = RLookup_GetKey_Write(cse->lookup, name, RLOOKUP_F_HIDDEN | RLOOKUP_F_NAMEALLOC);
+      if (!first->cacheKey) {
+        // Taken by a field of the pipeline
+        return false;
+      }
+    }
+    e->func.cacheKey = first->cacheKey;
+    return true;
+  }
+
+  struct ExprCSEEntry *entry = rm_malloc(sizeof(*entry));
+  entry->expr = e;
+  entry->props = array_new(char *, 1);
+  RSExpr_GetProperties(e, &entry->props);
+  array_append(cse->entries, entry);
+  return false;
+}
+
+static void cseAdd(ExprCSE *cse, RSExpr *e) {
+  if (!e) {
+    return;
+  }
+  switch (e->t) {
+    case RSExpr_Function:
+      // The arguments of a shared call are only evaluated with it. exists() is cheaper than
+      // its key, and clears the error of its missing argument
+      if (e->func.Call == func_exists || !cseShare(cse, e)) {
+        for (size_t ii = 0; ii < e->func.args->len; ii++) {
+          cseAdd(cse, e->func.args->args[ii]);
+        }
+      }
+      break;
+    case RSExpr_Op:
+      cseAdd(cse, e->op.left);
+      cseAdd(cse, e->op.right);
+      break;
+    case RSExpr_Predicate:
+      cseAdd(cse, e->pred.left);
+      cseAdd(cse, e->pred.right);
+      break;
+    case RSExpr_Inverted:
+      cseAdd(cse, e->inverted.child);
+      break;
+    case RSExpr_Literal:
+    case RSExpr_Property:
+      break;
+  }
+}
+
+void ExprCSE_Add(ExprCSE *cse, RSExpr *root, RLookup *lookup) {
+  if (cse->lookup != lookup) {
+    // The calls of another lookup are evaluated over other rows
+    ExprCSE_Invalidate(cse, NULL);
+    cse->lookup = lookup;
+  }
+  if (!cse->entries) {
+    cse->entries = array_new(struct ExprCSEEntry *, 4);
+  }
+  cseAdd(cse, root);
+}
+
+void ExprCSE_Invalidate(ExprCSE *cse, const char *name) {
+  size_t kept = 0;
+  for (size_t ii = 0; ii < array_len(cse->entries); ii++) {
+    struct ExprCSEEntry *entry = cse->entries[ii];
+    bool reads = !name;
+    for (size_t jj = 0; !reads && jj < array_len(entry->props); jj++) {
+      reads = !strcmp(entry->props[jj], name);
+    }
+    if (reads) {
+      cseEntryFree(entry);
+    } else {
+      cse->entries[kept++] = entry;
+    }
+  }
+  if (cse->entries) {
+    array_trimm(cse->entries, kept);
+  }
+}
+
+void ExprCSE_Free(ExprCSE *cse) {
+  ExprCSE_Invalidate(cse, NULL);
+  array_free(cse->entries);
+  cse->entries = NULL;
+}
+
 /* Allocate some memory for a function that can be freed automatically when the execution is done */
 void *ExprEval_UnalignedAlloc(ExprEval *ctx, size_t sz) {
   return BlkAlloc_Alloc(&ctx->stralloc, sz, MAX(sz, 1024));
@@ -421,6 +712,7 @@ typedef struct RPEvaluator RPEvaluator;
 struct RPEvaluator {
   ResultProcessor base;
   ExprEval eval;
+  ExprProgram *prog;  // compiled form of the expression, if it is numeric
   RSValue *val;
   const RLookupKey *outkey;
   int isFilter;
@@ -428,13 +720,8 @@ struct RPEvaluator {
 
 #define RESULT_EVAL_ERR RS_RESULT_MAX + 1
 
-static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
-  /** Get the upstream result */
-  int rc = pc->base.upstream->Next(pc->base.upstream, r);
-  if (rc != RS_RESULT_OK) {
-    return rc;
-  }
-
+// Evaluates the expression over `r` into `pc->val`
+static int rpevalEval(RPEvaluator *pc, SearchResult *r) {
   pc->eval.res = r;
   pc->eval.srcrow = SearchResult_GetRowData(r);
 
@@ -445,13 +732,74 @@ static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
     pc->val = RSValue_NewWithType(RSValueType_Undef);
   }
 
-  rc = ExprEval_Eval(&pc->eval, pc->val);
+  int rc = ExprEval_Eval(&pc->eval, pc->val);
   if (rc != EXPR_EVAL_OK) {
     return RS_RESULT_ERROR;
   }
   return RS_RESULT_OK;
 }
 
+// Runs the compiled program over the `n` results. Returns false if they should be evaluated
+// with the AST instead
+static bool rpevalRunProgram(RPEvaluator *pc, const SearchResult *res, size_t n) {
+  // A predicate fails once an error is set, which only the AST evaluator follows
+  QueryError *err = pc->base.parent->err;
+  if (!pc->prog || (err && !QueryError_IsOk(err))) {
+    return false;
+  }
+  ExprProgram_Run(pc->prog, res, n);
+  return true;
+}
+
+// Evaluates the expression over result `i` of the last program run, into `pc->val`
+static int rpevalEvalRun(RPEvaluator *pc, SearchResult *r, bool ran, size_t i) {
+  double num;
+  if (!ran || !ExprProgram_Result(pc->prog, i, &num)) {
+    return rpevalEval(pc, r);
+  }
+  if (!pc->val) {
+    pc->val = RSValue_NewNumber(num);
+  } else {
+    RSValue_Clear(pc->val);
+    RSValue_IntoNumber(pc->val, num);
+  }
+  return RS_RESULT_OK;
+}
+
+static int rpevalCommon(RPEvaluator *pc, SearchResult *r) {
+  /** Get the upstream result */
+  int rc = pc->base.upstream->Next(pc->base.upstream, r);
+  if (rc != RS_RESULT_OK) {
+    return rc;
+  }
+  bool ran = rpevalRunProgram(pc, r, 1);
+  return rpevalEvalRun(pc, r, ran, 0);
+}
+
+// Writes the evaluated value into the row of `r`
+static void rpevalProject(RPEvaluator *pc, SearchResult *r) {
+  RLookup_WriteOwnKey(pc->outkey, SearchResult_GetRowDataMut(r), pc->val);
+  pc->val = NULL;
+}
+
+// Tests the evaluated value. Returns false if `r` is filtered out, in which case it is cleared
+static bool rpevalFilter(RPEvaluator *pc, SearchResult *r) {
+  // Check if it's a boolean result!
+  int boolrv = RSValue_BoolTest(pc->val);
+  RSValue_Clear(pc->val);
+
+  if (boolrv) {
+    return true;
+  }
+
+  // Reduce the total number of results
+  RS_ASSERT(pc->base.parent->totalResults > 0);
+  pc->base.parent->totalResults--;
+  // Otherwise, the result must be filtered out.
+  SearchResult_Clear(r);
+  return false;
+}
+
 static int rpevalNext_project(ResultProcessor *rp, SearchResult *r) {
   RPEvaluator *pc = (RPEvaluator *)rp;
   int rc = rpevalCommon(pc, r);
@@ -459,8 +807,7 @@ static int rpevalNext_project(ResultProcessor *rp, SearchResult *r) {
   if (rc != RS_RESULT_OK) {
     return rc;
   }
-  RLookup_WriteOwnKey(pc->outkey, SearchResult_GetRowDataMut(r), pc->val);
-  pc->val = NULL;
+  rpevalProject(pc, r);
   return RS_RESULT_OK;
 }
 
@@ -468,39 +815,102 @@ static int rpevalNext_filter(ResultProcessor *rp, SearchResult *r) {
   RPEvaluator *pc = (RPEvaluator *)rp;
   int rc;
   while ((rc = rpevalCommon(pc, r)) == RS_RESULT_OK) {
-    // Check if it's a boolean result!
-    int boolrv = RSValue_BoolTest(pc->val);
-    RSValue_Clear(pc->val);
-
-    if (boolrv) {
+    if (rpevalFilter(pc, r)) {
       return RS_RESULT_OK;
     }
-
-    // Reduce the total number of results
-    RS_ASSERT(rp->parent->totalResults > 0);
-    rp->parent->totalResults--;
-    // Otherwise, the result must be filtered out.
-    SearchResult_Clear(r);
   }
   return rc;
 }
 
+static int rpevalNextBatch(ResultProcessor *rp, SearchResult *res, size_t cap, size_t *len) {
+  RPEvaluator *pc = (RPEvaluator *)rp;
+  int rc;
+  size_t n, kept;
+
+  do {
+    rc = RP_NextBatch(rp->upstream, res, cap, &n);
+    bool ran = n && rpevalRunProgram(pc, res, n);
+    // Evaluate the batch in place, moving the filtered out results to its end
+    kept = 0;
+    for (size_t i = 0; i < n; i++) {
+      if (rpevalEvalRun(pc, &res[i], ran, i) != RS_RESULT_OK) {
+        // Drop the failing result along with the ones that follow it
+        for (size_t j = i; j < n; j++) {
+          SearchResult_Clear(&res[j]);
+        }
+        *len = kept;
+        return RS_RESULT_ERROR;
+      }
+      if (pc->isFilter) {
+        if (!rpevalFilter(pc, &res[i])) {
+          continue;
+        }
+      } else {
+        rpevalProject(pc, &res[i]);
+      }
+      RP_BatchSwap(res, kept++, i);
+    }
+  } while (kept == 0 && rc == RS_RESULT_OK);
+
+  *len = kept;
+  return rc;
+}
+
 static void rpevalFree(ResultProcessor *rp) {
   RPEvaluator *ee = (RPEvaluator *)rp;
   if (ee->val) {
     RSValue_DecrRef(ee->val);
   }
+  if (ee->prog) {
+    ExprProgram_Free(ee->prog);
+  }
+  if (ee->eval.memo) {
+    ExprMemo_Free(ee->eval.memo);
+  }
   BlkAlloc_FreeAll(&ee->eval.stralloc, NULL, NULL, 0);
   rm_free(ee);
 }
+static bool hasMemoizableCall(const RSExpr *e) {
+  if (!e) {
+    return false;
+  }
+  switch (e->t) {
+    case RSExpr_Function:
+      if (e->func.memoizable) {
+        return true;
+      }
+      for (size_t ii = 0; ii < e->func.args->len; ii++) {
+        if (hasMemoizableCall(e->func.args->args[ii])) {
+          return true;
+        }
+      }
+      return false;
+    case RSExpr_Op:
+      return hasMemoizableCall(e->op.left) || hasMemoizableCall(e->op.right);
+    case RSExpr_Predicate:
+      return hasMemoizableCall(e->pred.left) || hasMemoizableCall(e->pred.right);
+    case RSExpr_Inverted:
+      return hasMemoizableCall(e->inverted.child);
+    case RSExpr_Literal:
+    case RSExpr_Property:
+      return false;
+  }
+  return false;
+}
+
 static ResultProcessor *RPEvaluator_NewCommon(const RSExpr *ast, const RLookup *lookup,
                                               const RLookupKey *dstkey, int isFilter) {
   RPEvaluator *rp = rm_calloc(1, sizeof(*rp));
   rp->base.Next = isFilter ? rpevalNext_filter : rpevalNext_project;
+  rp->base.NextBatch = rpevalNextBatch;
   rp->base.Free = rpevalFree;
   rp->base.type = isFilter ? RP_FILTER : RP_PROJECTOR;
   rp->eval.lookup = lookup;
   rp->eval.root = ast;
+  rp->prog = ExprProgram_Compile(ast);
+  if (RSGlobalConfig.exprFunctionMemoSize && hasMemoizableCall(ast)) {
+    rp->eval.memo = ExprMemo_New(RSGlobalConfig.exprFunctionMemoSize);
+  }
   rp->outkey = dstkey;
   BlkAlloc_Init(&rp->eval.stralloc);
   return &rp->base;
@@ -95,6 +95,9 @@ typedef struct {
   const char *name;
   RSArgList *args;
   RSFunction Call;
+  bool memoizable;
+  // Hidden key in which the row keeps the value of a call that other steps share, see ExprCSE
+  const RLookupKey *cacheKey;
 } RSFunctionExpr;
 
 typedef struct {
@@ -125,6 +128,7 @@ typedef struct ExprEval {
   const RLookupRow *srcrow;
   const RSExpr *root;
   BlkAlloc stralloc; // Optional. YNOT?
+  struct ExprMemo *memo; // Optional. Recent results of memoizable functions
 } ExprEval;
 
 #define EXPR_EVAL_ERR 0
@@ -174,6 +178,28 @@ RSExpr *ExprAST_Parse(const HiddenString* expr, QueryError *status);
 RSExpr *RSExpr_Parse(const char *expr, size_t len, char **err);
 void RSExpr_Free(RSExpr *e);
 
+/**
+ * Tracks the function calls of the APPLY and FILTER steps that run over the rows of one lookup.
+ * A call equal to one of an earlier step (or of the same one) is given a hidden key, in which
+ * whichever of the equal calls runs first leaves its value for the others to read.
+ */
+typedef struct {
+  RLookup *lookup;
+  struct ExprCSEEntry **entries;
+  unsigned numKeys;
+} ExprCSE;
+
+/** Track the calls of `root`, whose keys are already looked up in `lookup` */
+void ExprCSE_Add(ExprCSE *cse, RSExpr *root, RLookup *lookup);
+
+/**
+ * Stop sharing the calls that read `name`, as a step writes it. All the calls are forgotten if
+ * `name` is NULL
+ */
+void ExprCSE_Invalidate(ExprCSE *cse, const char *name);
+
+void ExprCSE_Free(ExprCSE *cse);
+
 /**
  * Helper functions for the evaluator context:
  */
@@ -277,16 +277,16 @@ err:
 }
 
 void RegisterDateFunctions() {
-  RSFunctionRegistry_RegisterFunction("timefmt", timeFormat, RSValueType_String, 1, 2);
-  RSFunctionRegistry_RegisterFunction("parsetime", parseTime, RSValueType_Number, 2, 2);
-  RSFunctionRegistry_RegisterFunction("hour", func_hour, RSValueType_Number, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("timefmt", timeFormat, RSValueType_String, 1, 2);
+  RSFunctionRegistry_RegisterMemoizableFunction("parsetime", parseTime, RSValueType_Number, 2, 2);
+  RSFunctionRegistry_RegisterMemoizableFunction("hour", func_hour, RSValueType_Number, 1, 1);
   RSFunctionRegistry_RegisterFunction("minute", func_minute, RSValueType_Number, 1, 1);
-  RSFunctionRegistry_RegisterFunction("day", func_day, RSValueType_Number, 1, 1);
-  RSFunctionRegistry_RegisterFunction("month", func_month, RSValueType_Number, 1, 1);
-  RSFunctionRegistry_RegisterFunction("monthofyear", func_monthofyear, RSValueType_Number, 1, 1);
-
-  RSFunctionRegistry_RegisterFunction("year", func_year, RSValueType_Number, 1, 1);
-  RSFunctionRegistry_RegisterFunction("dayofmonth", func_dayofmonth, RSValueType_Number, 1, 1);
-  RSFunctionRegistry_RegisterFunction("dayofweek", func_dayofweek, RSValueType_Number, 1, 1);
-  RSFunctionRegistry_RegisterFunction("dayofyear", func_dayofyear, RSValueType_Number, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("day", func_day, RSValueType_Number, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("month", func_month, RSValueType_Number, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("monthofyear", func_monthofyear, RSValueType_Number, 1, 1);
+
+  RSFunctionRegistry_RegisterMemoizableFunction("year", func_year, RSValueType_Number, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("dayofmonth", func_dayofmonth, RSValueType_Number, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("dayofweek", func_dayofweek, RSValueType_Number, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("dayofyear", func_dayofyear, RSValueType_Number, 1, 1);
 }
@@ -32,10 +32,18 @@ int RSFunctionRegistry_RegisterFunction(const char *name, RSFunction f, RSValueT
   functions_g.funcs[functions_g.len].retType = retType;
   functions_g.funcs[functions_g.len].minArgs = minArgs;
   functions_g.funcs[functions_g.len].maxArgs = maxArgs;
+  functions_g.funcs[functions_g.len].memoizable = false;
   functions_g.len++;
   return 1;
 }
 
+int RSFunctionRegistry_RegisterMemoizableFunction(const char *name, RSFunction f, RSValueType retType,
+                                                  uint8_t minArgs, uint16_t maxArgs) {
+  RSFunctionRegistry_RegisterFunction(name, f, retType, minArgs, maxArgs);
+  functions_g.funcs[functions_g.len - 1].memoizable = true;
+  return 1;
+}
+
 void RegisterAllFunctions() {
   RegisterMathFunctions();
   RegisterDateFunctions();
@@ -61,6 +61,7 @@ typedef struct RSFunctionInfo {
   RSValueType retType;
   uint8_t minArgs;
   uint16_t maxArgs;
+  bool memoizable;  // The result depends on the arguments alone, and is costly enough to reuse
 } RSFunctionInfo;
 
 typedef struct {
@@ -75,6 +76,13 @@ RSFunctionInfo *RSFunctionRegistry_Get(const char *name, size_t len);
 
 int RSFunctionRegistry_RegisterFunction(const char *name, RSFunction f, RSValueType retType, uint8_t minArgs, uint16_t maxArgs);
 
+/**
+ * Register a function whose result depends on its arguments alone, so that an evaluator may
+ * reuse it for later calls with the same arguments (see _EXPR_FUNCTION_MEMO_SIZE)
+ */
+int RSFunctionRegistry_RegisterMemoizableFunction(const char *name, RSFunction f, RSValueType retType,
+                                                  uint8_t minArgs, uint16_t maxArgs);
+
 void RegisterMathFunctions();
 void RegisterStringFunctions();
 void RegisterDateFunctions();
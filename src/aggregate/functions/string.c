@@ -373,11 +373,11 @@ static int stringfunc_strlen(ExprEval *ctx, RSValue *argv, size_t argc, RSValue
 }
 
 void RegisterStringFunctions() {
-  RSFunctionRegistry_RegisterFunction("lower", stringfunc_tolower, RSValueType_String, 1, 1);
-  RSFunctionRegistry_RegisterFunction("upper", stringfunc_toupper, RSValueType_String, 1, 1);
-  RSFunctionRegistry_RegisterFunction("substr", stringfunc_substr, RSValueType_String, 3, 3);
-  RSFunctionRegistry_RegisterFunction("format", stringfunc_format, RSValueType_String, 1, -1);
-  RSFunctionRegistry_RegisterFunction("split", stringfunc_split, RSValueType_Array, 1, 3);
+  RSFunctionRegistry_RegisterMemoizableFunction("lower", stringfunc_tolower, RSValueType_String, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("upper", stringfunc_toupper, RSValueType_String, 1, 1);
+  RSFunctionRegistry_RegisterMemoizableFunction("substr", stringfunc_substr, RSValueType_String, 3, 3);
+  RSFunctionRegistry_RegisterMemoizableFunction("format", stringfunc_format, RSValueType_String, 1, -1);
+  RSFunctionRegistry_RegisterMemoizableFunction("split", stringfunc_split, RSValueType_Array, 1, 3);
   RSFunctionRegistry_RegisterFunction("matched_terms", func_matchedTerms, RSValueType_Array, 0, 1);
   RSFunctionRegistry_RegisterFunction("to_number", func_to_number, RSValueType_Number, 1, 1);
   RSFunctionRegistry_RegisterFunction("to_str", func_to_str, RSValueType_String, 1, 1);
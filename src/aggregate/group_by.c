@@ -9,9 +9,14 @@
 #include <redisearch.h>
 #include <result_processor.h>
 #include <util/block_alloc.h>
-#include <util/khash.h>
+#include <util/minmax.h>
+#include <util/workers.h>
+#include "config.h"
 #include "reducer.h"
 
+#include <pthread.h>
+#include <stdatomic.h>
+
 /**
  * A group represents the allocated context of all reducers in a group, and the
  * selected values of that group.
@@ -31,31 +36,47 @@ typedef struct {
   void *accumdata[0];
 } Group;
 
-#define kh_set(kname, hash, key, val)   \
-  ({                                    \
-    int ret;                            \
-    k = kh_put(kname, hash, key, &ret); \
-    kh_value(hash, k) = val;            \
-    ret;                                \
-  })
+/**
+ * A slot of the group table. The hash of the group values is kept next to the group, so that
+ * probing never reads a group whose hash differs.
+ */
+typedef struct {
+  uint64_t hash;
+  Group *group;  // NULL if the slot is empty
+} GroupSlot;
+
+/**
+ * Open addressing table of the groups, by the hash of their values. The groups themselves are
+ * allocated from the table's arena.
+ *
+ * Groups are placed, probed and moved when growing the same way a khash map does, so that they
+ * are yielded in the order GROUPBY always returned them.
+ */
+typedef struct {
+  GroupSlot *slots;
+  uint32_t cap;      // a power of two, or 0 before the first group
+  uint32_t size;
+  uint32_t maxSize;  // the table grows when more groups are added
+  BlkAlloc alloc;    // arena of the groups
+} GroupTable;
 
-static const int khid = 33;
-KHASH_MAP_INIT_INT64(khid, Group *);
+#define GROUP_TABLE_MIN_CAP 4
+#define GROUP_TABLE_MAX_LOAD 0.77
+#define GROUP_BUCKET(hash, mask) ((uint32_t)((hash) >> 33 ^ (hash) ^ (hash) << 11) & (mask))
 
 #define GROUPER_NREDUCERS(g) (array_len((g)->reducers))
 #define GROUP_BYTESIZE(parent) (sizeof(Group) + (sizeof(void *) * GROUPER_NREDUCERS(parent)))
 #define GROUPS_PER_BLOCK 1024
 #define GROUPER_NSRCKEYS(g) ((g)->nkeys)
+// The number of results read for each partition before they are accumulated in parallel
+#define GROUPER_ROWS_PER_PARTITION (16 * RP_BATCH_SIZE)
 
 typedef struct Grouper {
   // Result processor base, for use in row processing
   ResultProcessor base;
 
-  // Map of group_name => `Group` structure
-  khash_t(khid) * groups;
-
-  // Backing store for the groups themselves
-  BlkAlloc groupsAlloc;
+  // Table of group values hash => `Group` structure
+  GroupTable groups;
 
   /**
    * Keys to group by. Both srckeys and dstkeys are used because different lookups
@@ -69,9 +90,36 @@ typedef struct Grouper {
 
   // array of reducers
   Reducer **reducers;
+  // The number of reducers which add arrays of numbers (see Reducer::AddNumbers)
+  size_t nnumeric;
+
+  // Results read from upstream in batches, if it supports it (allocated lazily)
+  SearchResult *batch;
+
+  /**
+   * When the results are accumulated on several threads, each of them but the
+   * grouper's own thread has a table of its partition of the results. These are
+   * merged into `groups` once all the results are read.
+   */
+  GroupTable *partitions;
+  size_t npartitions;
+
+  // Results read for all the partitions at once (allocated lazily)
+  SearchResult *rows;
+
+  // Serializes the creation of reducer instances across the partitions, and
+  // signals the partitions that are done
+  pthread_mutex_t lock;
+  pthread_cond_t done;
 
   // Used for maintaining state when yielding groups
-  khiter_t iter;
+  uint32_t iter;
+
+  // When the results are sorted by the group keys, the only group being accumulated, and the
+  // result read from upstream which starts the next one
+  Group *current;
+  SearchResult next;
+  uint32_t nyielded;
 } Grouper;
 
 /**
@@ -81,15 +129,22 @@ typedef struct Grouper {
  *
  * These will be placed in the output row.
  */
-static Group *createGroup(Grouper *g, const RSValue **groupvals, size_t ngrpvals) {
+static Group *createGroup(Grouper *g, GroupTable *t, const RSValue **groupvals, size_t ngrpvals) {
   size_t numReducers = array_len(g->reducers);
   size_t elemSize = GROUP_BYTESIZE(g);
-  Group *group = BlkAlloc_Alloc(&g->groupsAlloc, elemSize, GROUPS_PER_BLOCK * elemSize);
+  Group *group = BlkAlloc_Alloc(&t->alloc, elemSize, GROUPS_PER_BLOCK * elemSize);
   memset(group, 0, elemSize);
 
+  // The instances of a reducer share its allocator
+  if (g->npartitions) {
+    pthread_mutex_lock(&g->lock);
+  }
   for (size_t ii = 0; ii < numReducers; ++ii) {
     group->accumdata[ii] = g->reducers[ii]->NewInstance(g->reducers[ii]);
   }
+  if (g->npartitions) {
+    pthread_mutex_unlock(&g->lock);
+  }
 
   /** Initialize the row data! */
   for (size_t ii = 0; ii < ngrpvals; ++ii) {
@@ -109,22 +164,161 @@ static void writeGroupValues(const Grouper *g, const Group *gr, SearchResult *r)
   }
 }
 
+/**
+ * Whether the group of a single key holds the value `v`, whose hash is the group's. Numbers
+ * and strings are compared, so that two distinct ones never share a group. Other values are
+ * still told apart by their hash alone.
+ */
+static bool groupHasValue(const Grouper *g, const Group *gr, const RSValue *v) {
+  const RSValue *gv = RSValue_Dereference(RLookup_GetItem(g->dstkeys[0], &gr->rowdata));
+  v = RSValue_Dereference(v);
+  if (v == gv) {
+    // The rows of an interned string share its value
+    return true;
+  }
+  if (RSValue_IsNumber(v) && RSValue_IsNumber(gv)) {
+    // Compare like the hash does, so that NaN is a single group
+    double a = RSValue_Number_Get(v), b = RSValue_Number_Get(gv);
+    return !memcmp(&a, &b, sizeof(a));
+  }
+  RSValueType vt = RSValue_Type(v), gt = RSValue_Type(gv);
+  bool vstr = vt == RSValueType_String || vt == RSValueType_RedisString || vt == RSValueType_OwnRstring;
+  bool gstr = gt == RSValueType_String || gt == RSValueType_RedisString || gt == RSValueType_OwnRstring;
+  if (vstr && gstr) {
+    size_t vlen, glen;
+    const char *vs = RSValue_StringPtrLen(v, &vlen);
+    const char *gs = RSValue_StringPtrLen(gv, &glen);
+    return vlen == glen && !memcmp(vs, gs, vlen);
+  }
+  return true;
+}
+
+/**
+ * Find the slot of the group with the hash `hval`, or the empty slot where it belongs.
+ * `key` is the value of a single key grouper, which is verified, or NULL
+ */
+static uint32_t GroupTable_Probe(const Grouper *g, const GroupTable *t, uint64_t hval,
+                                 const RSValue *key) {
+  uint32_t mask = t->cap - 1;
+  uint32_t i = GROUP_BUCKET(hval, mask);
+  for (uint32_t step = 0; t->slots[i].group; i = (i + (++step)) & mask) {
+    if (t->slots[i].hash == hval && (!key || groupHasValue(g, t->slots[i].group, key))) {
+      break;
+    }
+  }
+  return i;
+}
+
+static void GroupTable_Grow(GroupTable *t) {
+  uint32_t cap = t->cap ? t->cap * 2 : GROUP_TABLE_MIN_CAP;
+  uint32_t mask = cap - 1;
+  GroupSlot *slots = rm_calloc(cap, sizeof(*slots));
+
+  // Move the groups in slot order. A moved group takes the place of the group still in its new
+  // slot, which is moved next
+  for (uint32_t j = 0; j < t->cap; j++) {
+    GroupSlot cur = t->slots[j];
+    t->slots[j].group = NULL;
+    while (cur.group) {
+      uint32_t i = GROUP_BUCKET(cur.hash, mask);
+      for (uint32_t step = 0; slots[i].group; i = (i + (++step)) & mask) {
+      }
+      slots[i] = cur;
+      cur.group = NULL;
+      if (i < t->cap && t->slots[i].group) {
+        cur = t->slots[i];
+        t->slots[i].group = NULL;
+      }
+    }
+  }
+
+  rm_free(t->slots);
+  t->slots = slots;
+  t->cap = cap;
+  t->maxSize = (uint32_t)(cap * GROUP_TABLE_MAX_LOAD + 0.5);
+}
+
+// Find the group of `hval` in the table, or NULL. `key` is as in GroupTable_Probe()
+static Group *GroupTable_Find(const Grouper *g, const GroupTable *t, uint64_t hval,
+                              const RSValue *key, uint32_t *slot) {
+  if (!t->cap) {
+    return NULL;
+  }
+  *slot = GroupTable_Probe(g, t, hval, key);
+  return t->slots[*slot].group;
+}
+
+// Add a group to the table, at the slot GroupTable_Find() did not find it in
+static void GroupTable_Add(const Grouper *g, GroupTable *t, uint32_t slot, uint64_t hval,
+                           const RSValue *key, Group *group) {
+  if (t->size >= t->maxSize) {
+    GroupTable_Grow(t);
+    slot = GroupTable_Probe(g, t, hval, key);
+  }
+  t->slots[slot] = (GroupSlot){.hash = hval, .group = group};
+  t->size++;
+}
+
+/**
+ * Get the group of the values from the table, creating it if there is none. `hval` is the hash of
+ * the values
+ */
+static Group *getGroup(Grouper *g, GroupTable *t, const RSValue **xarr, size_t xlen,
+                       uint64_t hval) {
+  const RSValue *key = xlen == 1 ? xarr[0] : NULL;
+  uint32_t slot = 0;
+  Group *group = GroupTable_Find(g, t, hval, key, &slot);
+  if (!group) {
+    group = createGroup(g, t, xarr, xlen);
+    GroupTable_Add(g, t, slot, hval, key, group);
+  }
+  return group;
+}
+
+static void GroupTable_Free(const Grouper *g, GroupTable *t) {
+  for (uint32_t ii = 0; ii < t->cap; ++ii) {
+    Group *gr = t->slots[ii].group;
+    if (!gr) {
+      continue;
+    }
+    RLookupRow_Reset(&gr->rowdata);
+    // Call the reducer's FreeInstance
+    for (size_t jj = 0; jj < GROUPER_NREDUCERS(g); ++jj) {
+      Reducer *rr = g->reducers[jj];
+      if (rr->FreeInstance) {
+        rr->FreeInstance(rr, gr->accumdata[jj]);
+      }
+    }
+  }
+  rm_free(t->slots);
+  t->slots = NULL;
+  t->cap = t->size = t->maxSize = 0;
+}
+
+// Write the outputs of the reducers of the group, with the errors of those estimated from a sample
+static void writeReducerValues(Grouper *g, Group *gr, RLookupRow *row) {
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    Reducer *rd = g->reducers[ii];
+    RSValue *v = rd->Finalize(rd, gr->accumdata[ii]);
+    RLookup_WriteOwnKey(rd->dstkey, row, v);
+    if (rd->errkey) {
+      RLookup_WriteOwnKey(rd->errkey, row, RSValue_NewNumber(rd->StdError(rd, gr->accumdata[ii])));
+    }
+  }
+}
+
 static int Grouper_rpYield(ResultProcessor *base, SearchResult *r) {
   Grouper *g = (Grouper *)base;
 
-  while (g->iter != kh_end(g->groups)) {
-    if (!kh_exist(g->groups, g->iter)) {
+  while (g->iter < g->groups.cap) {
+    Group *gr = g->groups.slots[g->iter].group;
+    if (!gr) {
       g->iter++;
       continue;
     }
 
-    Group *gr = kh_value(g->groups, g->iter);
     writeGroupValues(g, gr, r);
-    for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
-      Reducer *rd = g->reducers[ii];
-      RSValue *v = rd->Finalize(rd, gr->accumdata[ii]);
-      RLookup_WriteOwnKey(rd->dstkey, SearchResult_GetRowDataMut(r), v);
-    }
+    writeReducerValues(g, gr, SearchResult_GetRowDataMut(r));
     ++g->iter;
     return RS_RESULT_OK;
   }
@@ -139,11 +333,22 @@ static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
   }
 }
 
+// Invoke the reducers which are added one row at a time
+static void invokeRowReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
+  size_t nreducers = GROUPER_NREDUCERS(g);
+  for (size_t ii = 0; ii < nreducers; ii++) {
+    if (!g->reducers[ii]->AddNumbers) {
+      g->reducers[ii]->Add(g->reducers[ii], gr->accumdata[ii], srcrow);
+    }
+  }
+}
+
 /**
  * This function recursively descends into each value within a group and invokes
  * Add() for each cartesian product of the current row.
  *
  * @param g the grouper
+ * @param t the table of the groups
  * @param xarr the array of 'x' values - i.e. the raw results received from the
  *  upstream result processor. The number of results can be found via
  *  the `GROUPER_NSRCKEYS(g)` macro
@@ -153,22 +358,12 @@ static void invokeReducers(Grouper *g, Group *gr, RLookupRow *srcrow) {
  *  are not hashed together.
  * @param res the row is passed to each reducer
  */
-static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t xlen, uint64_t hval, RLookupRow *res) {
+static void extractGroups(Grouper *g, GroupTable *t, const RSValue **xarr, size_t xpos, size_t xlen,
+                          uint64_t hval, RLookupRow *res) {
   // end of the line - create/add to group
   if (xpos == xlen) {
-    Group *group = NULL;
-
-    // Get or create the group
-    khiter_t k = kh_get(khid, g->groups, hval);  // first have to get ieter
-    if (k == kh_end(g->groups)) {                // k will be equal to kh_end if key not present
-      group = createGroup(g, xarr, xlen);
-      kh_set(khid, g->groups, hval, group);
-    } else {
-      group = kh_value(g->groups, k);
-    }
-
     // send the result to the group and its reducers
-    invokeReducers(g, group, res);
+    invokeReducers(g, getGroup(g, t, xarr, xlen, hval), res);
     return;
   }
 
@@ -177,13 +372,13 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
   // regular value - just move one step -- increment XPOS
   if (!RSValue_IsArray(v)) {
     hval = RSValue_Hash(v, hval);
-    extractGroups(g, xarr, xpos + 1, xlen, hval, res);
+    extractGroups(g, t, xarr, xpos + 1, xlen, hval, res);
   } else if (RSValue_ArrayLen(v) == 0) {
     // Empty array - hash as null
     hval = RSValue_Hash(RSValue_NullStatic(), hval);
     const RSValue *array = xarr[xpos];
     xarr[xpos] = RSValue_NullStatic();
-    extractGroups(g, xarr, xpos + 1, xlen, hval, res);
+    extractGroups(g, t, xarr, xpos + 1, xlen, hval, res);
     xarr[xpos] = array;
   } else {
     // Array value. Replace current XPOS with child temporarily.
@@ -194,13 +389,18 @@ static void extractGroups(Grouper *g, const RSValue **xarr, size_t xpos, size_t
       // hash the element, even if it's an array
       uint64_t hh = RSValue_Hash(elem, hval);
       xarr[xpos] = elem;
-      extractGroups(g, xarr, xpos + 1, xlen, hh, res);
+      extractGroups(g, t, xarr, xpos + 1, xlen, hh, res);
     }
     xarr[xpos] = array;
   }
 }
 
-static void invokeGroupReducers(Grouper *g, RLookupRow *srcrow) {
+/**
+ * Get the group of the row. A row with array values belongs to a group for each combination of
+ * their elements, so it is passed to all the reducers of these groups right away, and NULL is
+ * returned
+ */
+static Group *rowGroup(Grouper *g, GroupTable *t, RLookupRow *srcrow) {
   uint64_t hval = 0;
   size_t nkeys = GROUPER_NSRCKEYS(g);
   const RSValue *groupvals[nkeys];
@@ -213,7 +413,368 @@ static void invokeGroupReducers(Grouper *g, RLookupRow *srcrow) {
     }
     groupvals[ii] = v;
   }
-  extractGroups(g, groupvals, 0, nkeys, 0, srcrow);
+  if (nkeys == 1 && !RSValue_IsArray(RSValue_Dereference(groupvals[0]))) {
+    // A single plain value is its group's only key
+    return getGroup(g, t, groupvals, 1, RSValue_Hash(groupvals[0], 0));
+  }
+  // Hash the values as extractGroups() does
+  for (size_t ii = 0; ii < nkeys; ++ii) {
+    const RSValue *v = RSValue_Dereference(groupvals[ii]);
+    if (RSValue_IsArray(v)) {
+      extractGroups(g, t, groupvals, 0, nkeys, 0, srcrow);
+      return NULL;
+    }
+    hval = RSValue_Hash(v, hval);
+  }
+  return getGroup(g, t, groupvals, nkeys, hval);
+}
+
+static void invokeGroupReducers(Grouper *g, GroupTable *t, RLookupRow *srcrow) {
+  Group *gr = rowGroup(g, t, srcrow);
+  if (gr) {
+    invokeReducers(g, gr, srcrow);
+  }
+}
+
+/**
+ * Pass the numbers of the key of the reducer of index `idx` to its AddNumbers(), an array for
+ * each run of consecutive rows of the same group. `groups` are the groups of the rows, as
+ * returned by rowGroup()
+ */
+static void addNumberRuns(Reducer *r, size_t idx, Group **groups, SearchResult *rows, size_t n) {
+  double vals[RP_BATCH_SIZE];
+  size_t i = 0;
+  while (i < n) {
+    Group *gr = groups[i];
+    if (!gr) {
+      i++;
+      continue;
+    }
+    size_t nvals = 0;
+    for (; i < n && groups[i] == gr; i++) {
+      const RLookupRow *row = SearchResult_GetRowData(&rows[i]);
+      const RSValue *v = RLookup_GetItem(r->srckey, row);
+      const RSValue *num = v ? RSValue_Dereference(v) : NULL;
+      if (RSValue_IsNumber(num)) {
+        vals[nvals++] = RSValue_Number_Get(num);
+      } else if (v) {
+        r->Add(r, gr->accumdata[idx], row);
+      }
+    }
+    if (nvals) {
+      r->AddNumbers(r, gr->accumdata[idx], vals, nvals);
+    }
+  }
+}
+
+static void accumRows(Grouper *g, GroupTable *t, SearchResult *rows, size_t nrows) {
+  if (!g->nnumeric) {
+    for (size_t i = 0; i < nrows; i++) {
+      invokeGroupReducers(g, t, SearchResult_GetRowDataMut(&rows[i]));
+    }
+    return;
+  }
+
+  // Find the groups of a batch of rows first, then pass the numbers of each of their runs to the
+  // reducers which add arrays of numbers
+  for (size_t start = 0; start < nrows; start += RP_BATCH_SIZE) {
+    size_t n = MIN(RP_BATCH_SIZE, nrows - start);
+    SearchResult *batch = rows + start;
+    Group *groups[RP_BATCH_SIZE];
+    for (size_t i = 0; i < n; i++) {
+      RLookupRow *row = SearchResult_GetRowDataMut(&batch[i]);
+      groups[i] = rowGroup(g, t, row);
+      if (groups[i]) {
+        invokeRowReducers(g, groups[i], row);
+      }
+    }
+    for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+      if (g->reducers[ii]->AddNumbers) {
+        addNumberRuns(g->reducers[ii], ii, groups, batch, n);
+      }
+    }
+  }
+}
+
+/**
+ * The number of threads to accumulate the results on. Only reducers that can be merged are
+ * accumulated in parallel, on the workers thread pool
+ */
+static size_t Grouper_NumPartitions(const Grouper *g) {
+  if (RSGlobalConfig.groupByPartitions < 2 || !RSGlobalConfig.numWorkerThreads) {
+    return 1;
+  }
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    if (!g->reducers[ii]->Merge) {
+      return 1;
+    }
+  }
+  return MIN(RSGlobalConfig.groupByPartitions, workersThreadPool_NumThreads() + 1);
+}
+
+typedef enum {
+  GROUP_JOB_PENDING,
+  GROUP_JOB_RUNNING,
+  GROUP_JOB_DONE,
+} GroupJobState;
+
+/**
+ * The accumulation of a partition of the results, queued on the workers thread pool.
+ *
+ * The grouper runs the jobs no worker has started yet by itself, rather than waiting behind
+ * other work in the pool's queue. A job is shared by the grouper and by its queued work, and
+ * freed by whichever releases it last.
+ */
+typedef struct {
+  Grouper *g;
+  GroupTable *table;
+  SearchResult *rows;
+  size_t nrows;
+  atomic_int state;
+  atomic_int refcount;
+} GroupJob;
+
+static void GroupJob_Release(GroupJob *job) {
+  if (atomic_fetch_sub(&job->refcount, 1) == 1) {
+    rm_free(job);
+  }
+}
+
+static bool GroupJob_Claim(GroupJob *job) {
+  int expected = GROUP_JOB_PENDING;
+  return atomic_compare_exchange_strong(&job->state, &expected, GROUP_JOB_RUNNING);
+}
+
+static void GroupJob_Run(void *arg) {
+  GroupJob *job = arg;
+  if (GroupJob_Claim(job)) {
+    Grouper *g = job->g;
+    accumRows(g, job->table, job->rows, job->nrows);
+    pthread_mutex_lock(&g->lock);
+    atomic_store(&job->state, GROUP_JOB_DONE);
+    pthread_cond_broadcast(&g->done);
+    pthread_mutex_unlock(&g->lock);
+  }
+  GroupJob_Release(job);
+}
+
+// Accumulate the first `nrows` of `g->rows`, split into a partition for each thread
+static void accumPartitions(Grouper *g, size_t nrows) {
+  if (nrows <= RP_BATCH_SIZE) {
+    // Not worth waking up the workers
+    accumRows(g, &g->groups, g->rows, nrows);
+    return;
+  }
+
+  size_t nparts = g->npartitions + 1;
+  size_t perPart = (nrows + nparts - 1) / nparts;
+  GroupJob *jobs[nparts];
+  size_t njobs = 0;
+  for (size_t p = 1; p < nparts && p * perPart < nrows; p++) {
+    GroupJob *job = rm_malloc(sizeof(*job));
+    job->g = g;
+    job->table = &g->partitions[p - 1];
+    job->rows = g->rows + p * perPart;
+    job->nrows = MIN(perPart, nrows - p * perPart);
+    atomic_init(&job->state, GROUP_JOB_PENDING);
+    atomic_init(&job->refcount, 2);
+    if (workersThreadPool_AddWork(GroupJob_Run, job) != 0) {
+      // Not queued, so run below
+      atomic_store(&job->refcount, 1);
+    }
+    jobs[njobs++] = job;
+  }
+
+  accumRows(g, &g->groups, g->rows, perPart);
+  for (size_t i = 0; i < njobs; i++) {
+    if (GroupJob_Claim(jobs[i])) {
+      accumRows(g, jobs[i]->table, jobs[i]->rows, jobs[i]->nrows);
+      atomic_store(&jobs[i]->state, GROUP_JOB_DONE);
+    }
+  }
+
+  pthread_mutex_lock(&g->lock);
+  for (size_t i = 0; i < njobs; i++) {
+    while (atomic_load(&jobs[i]->state) != GROUP_JOB_DONE) {
+      pthread_cond_wait(&g->done, &g->lock);
+    }
+  }
+  pthread_mutex_unlock(&g->lock);
+  for (size_t i = 0; i < njobs; i++) {
+    GroupJob_Release(jobs[i]);
+  }
+}
+
+// Read all the results from upstream, a round of rows for all the partitions at a time
+static int Grouper_AccumParallel(Grouper *g) {
+  ResultProcessor *upstream = g->base.upstream;
+  size_t cap = (g->npartitions + 1) * GROUPER_ROWS_PER_PARTITION;
+  if (!g->rows) {
+    g->rows = rm_calloc(cap, sizeof(*g->rows));
+  }
+  int rc;
+  do {
+    size_t nrows = 0, len;
+    do {
+      rc = RP_NextBatch(upstream, g->rows + nrows, MIN(RP_BATCH_SIZE, cap - nrows), &len);
+      nrows += len;
+    } while (rc == RS_RESULT_OK && nrows < cap);
+
+    accumPartitions(g, nrows);
+    for (size_t i = 0; i < nrows; i++) {
+      SearchResult_Clear(&g->rows[i]);
+    }
+  } while (rc == RS_RESULT_OK);
+  return rc;
+}
+
+// Merge the groups of the partitions into the grouper's table
+static void Grouper_MergePartitions(Grouper *g) {
+  GroupTable *dst = &g->groups;
+  for (size_t p = 0; p < g->npartitions; p++) {
+    GroupTable *t = &g->partitions[p];
+    for (uint32_t ii = 0; ii < t->cap; ++ii) {
+      Group *src = t->slots[ii].group;
+      if (!src) {
+        continue;
+      }
+      uint64_t hval = t->slots[ii].hash;
+      const RSValue *key = g->nkeys == 1 ? RLookup_GetItem(g->dstkeys[0], &src->rowdata) : NULL;
+      uint32_t slot = 0;
+      Group *gr = GroupTable_Find(g, dst, hval, key, &slot);
+      if (!gr) {
+        // The group stays in the arena of the partition
+        GroupTable_Add(g, dst, slot, hval, key, src);
+        t->slots[ii].group = NULL;
+        continue;
+      }
+      for (size_t jj = 0; jj < GROUPER_NREDUCERS(g); ++jj) {
+        Reducer *rr = g->reducers[jj];
+        rr->Merge(rr, gr->accumdata[jj], src->accumdata[jj]);
+      }
+    }
+    // Free what was merged
+    GroupTable_Free(g, t);
+  }
+}
+
+// Whether the row belongs to the group, compared the way the sorter upstream orders the rows
+static bool groupHasRow(const Grouper *g, const Group *gr, const RLookupRow *row) {
+  for (size_t ii = 0; ii < g->nkeys; ++ii) {
+    const RSValue *v = RLookup_GetItem(g->srckeys[ii], row);
+    const RSValue *gv = RLookup_GetItem(g->dstkeys[ii], &gr->rowdata);
+    if (!RSValue_Equal(v ? v : RSValue_NullStatic(), gv ? gv : RSValue_NullStatic(), NULL)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Start the group of the row, as the only group of a sorted grouper
+static void startSortedGroup(Grouper *g, RLookupRow *row) {
+  size_t nkeys = GROUPER_NSRCKEYS(g);
+  const RSValue *groupvals[nkeys];
+  for (size_t ii = 0; ii < nkeys; ++ii) {
+    const RSValue *v = RLookup_GetItem(g->srckeys[ii], row);
+    groupvals[ii] = v ? v : RSValue_NullStatic();
+  }
+  g->current = createGroup(g, &g->groups, groupvals, nkeys);
+  invokeReducers(g, g->current, row);
+}
+
+// Free the group of a sorted grouper, recycling the memory of the group and its reducers
+static void endSortedGroup(Grouper *g) {
+  Group *gr = g->current;
+  RLookupRow_Reset(&gr->rowdata);
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    Reducer *rr = g->reducers[ii];
+    if (rr->FreeInstance) {
+      rr->FreeInstance(rr, gr->accumdata[ii]);
+    }
+    BlkAlloc_Clear(&rr->alloc, NULL, NULL, 0);
+  }
+  BlkAlloc_Clear(&g->groups.alloc, NULL, NULL, 0);
+  g->current = NULL;
+}
+
+static int Grouper_rpSortedEOF(ResultProcessor *base, SearchResult *res) {
+  return RS_RESULT_EOF;
+}
+
+/**
+ * Yield the groups of results sorted by the group keys. A group is complete once a result of
+ * another group is read, so a single group is held at a time.
+ */
+static int Grouper_rpSorted(ResultProcessor *base, SearchResult *res) {
+  Grouper *g = (Grouper *)base;
+  ResultProcessor *upstream = base->upstream;
+  uint32_t chunkLimit = base->parent->resultLimit;
+  base->parent->resultLimit = UINT32_MAX; // a group may span any number of results
+  int rc;
+  while ((rc = upstream->Next(upstream, &g->next)) == RS_RESULT_OK) {
+    RLookupRow *row = SearchResult_GetRowDataMut(&g->next);
+    if (g->current && !groupHasRow(g, g->current, row)) {
+      break;
+    }
+    if (g->current) {
+      invokeReducers(g, g->current, row);
+    } else {
+      startSortedGroup(g, row);
+    }
+    SearchResult_Clear(&g->next);
+  }
+  base->parent->resultLimit = chunkLimit; // restore the limit
+
+  if (rc != RS_RESULT_OK && rc != RS_RESULT_EOF) {
+    return rc;
+  }
+  if (!g->current) {
+    base->Next = Grouper_rpSortedEOF;
+    return RS_RESULT_EOF;
+  }
+
+  writeGroupValues(g, g->current, res);
+  writeReducerValues(g, g->current, SearchResult_GetRowDataMut(res));
+  endSortedGroup(g);
+  base->parent->totalResults = ++g->nyielded;
+
+  if (rc == RS_RESULT_OK) {
+    // The result that ended the group starts the next one
+    startSortedGroup(g, SearchResult_GetRowDataMut(&g->next));
+    SearchResult_Clear(&g->next);
+  } else {
+    base->Next = Grouper_rpSortedEOF;
+  }
+  return RS_RESULT_OK;
+}
+
+/**
+ * Whether the grouper only needs the number of results of the root of the query: it has no keys,
+ * and all of its reducers can add results by their number (see Reducer::AddCount)
+ */
+static bool Grouper_CountsRoot(const Grouper *g) {
+  if (g->nkeys || !GROUPER_NREDUCERS(g) || g->base.upstream->type != RP_INDEX) {
+    return false;
+  }
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    if (!g->reducers[ii]->AddCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Add the results counted by the root of the query to the only group of a grouper without keys
+static int Grouper_AccumCount(Grouper *g) {
+  size_t count;
+  int rc = RPQueryIterator_Count(g->base.upstream, &count);
+  if (count) {
+    Group *gr = getGroup(g, &g->groups, NULL, 0, 0);
+    for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+      g->reducers[ii]->AddCount(g->reducers[ii], gr->accumdata[ii], count);
+    }
+  }
+  return rc;
 }
 
 static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
@@ -221,45 +782,79 @@ static int Grouper_rpAccum(ResultProcessor *base, SearchResult *res) {
   uint32_t chunkLimit = base->parent->resultLimit;
   base->parent->resultLimit = UINT32_MAX; // we want to accumulate all the results
   int rc;
+  bool countsRoot = Grouper_CountsRoot(g);
+
+  if (!countsRoot && !g->partitions && !g->batch) {
+    size_t nparts = Grouper_NumPartitions(g);
+    if (nparts > 1) {
+      g->npartitions = nparts - 1;
+      g->partitions = rm_calloc(g->npartitions, sizeof(*g->partitions));
+      for (size_t p = 0; p < g->npartitions; p++) {
+        BlkAlloc_Init(&g->partitions[p].alloc);
+      }
+    }
+  }
 
-  while ((rc = base->upstream->Next(base->upstream, res)) == RS_RESULT_OK) {
-    invokeGroupReducers(g, SearchResult_GetRowDataMut(res));
-    SearchResult_Clear(res);
+  if (countsRoot) {
+    rc = Grouper_AccumCount(g);
+  } else if (g->npartitions) {
+    rc = Grouper_AccumParallel(g);
+  } else if (base->upstream->NextBatch) {
+    // Read whole batches when the upstream can produce them
+    if (!g->batch) {
+      g->batch = RP_NewBatch();
+    }
+    size_t len;
+    do {
+      rc = base->upstream->NextBatch(base->upstream, g->batch, RP_BATCH_SIZE, &len);
+      accumRows(g, &g->groups, g->batch, len);
+      for (size_t i = 0; i < len; i++) {
+        SearchResult_Clear(&g->batch[i]);
+      }
+    } while (rc == RS_RESULT_OK);
+  } else {
+    while ((rc = base->upstream->Next(base->upstream, res)) == RS_RESULT_OK) {
+      invokeGroupReducers(g, &g->groups, SearchResult_GetRowDataMut(res));
+      SearchResult_Clear(res);
+    }
   }
   base->parent->resultLimit = chunkLimit; // restore the limit
   if (rc == RS_RESULT_EOF) {
+    Grouper_MergePartitions(g);
     base->Next = Grouper_rpYield;
-    base->parent->totalResults = kh_size(g->groups);
-    g->iter = kh_begin(khid);
+    base->parent->totalResults = g->groups.size;
+    g->iter = 0;
     return Grouper_rpYield(base, res);
   } else {
     return rc;
   }
 }
 
-static void cleanCallback(void *ptr, void *arg) {
-  Group *group = ptr;
-  Grouper *parent = arg;
-  // Call the reducer's FreeInstance
-  for (size_t ii = 0; ii < GROUPER_NREDUCERS(parent); ++ii) {
-    Reducer *rr = parent->reducers[ii];
-    if (rr->FreeInstance) {
-      rr->FreeInstance(rr, group->accumdata[ii]);
-    }
-  }
-}
-
 static void Grouper_rpFree(ResultProcessor *grrp) {
   Grouper *g = (Grouper *)grrp;
-  for (khiter_t it = kh_begin(g->groups); it != kh_end(g->groups); ++it) {
-    if (!kh_exist(g->groups, it)) {
-      continue;
+  if (g->current) {
+    endSortedGroup(g);
+  }
+  SearchResult_Destroy(&g->next);
+  // Free all the groups before the arenas, as merged groups are in the arenas of the partitions
+  GroupTable_Free(g, &g->groups);
+  for (size_t p = 0; p < g->npartitions; p++) {
+    GroupTable_Free(g, &g->partitions[p]);
+  }
+  BlkAlloc_FreeAll(&g->groups.alloc, NULL, NULL, 0);
+  for (size_t p = 0; p < g->npartitions; p++) {
+    BlkAlloc_FreeAll(&g->partitions[p].alloc, NULL, NULL, 0);
+  }
+  rm_free(g->partitions);
+  if (g->rows) {
+    size_t cap = (g->npartitions + 1) * GROUPER_ROWS_PER_PARTITION;
+    for (size_t i = 0; i < cap; i++) {
+      SearchResult_Destroy(&g->rows[i]);
     }
-    Group *gr = kh_value(g->groups, it);
-    RLookupRow_Reset(&gr->rowdata);
+    rm_free(g->rows);
   }
-  kh_destroy(khid, g->groups);
-  BlkAlloc_FreeAll(&g->groupsAlloc, cleanCallback, g, GROUP_BYTESIZE(g));
+  pthread_mutex_destroy(&g->lock);
+  pthread_cond_destroy(&g->done);
 
   for (size_t i = 0; i < GROUPER_NREDUCERS(g); i++) {
     g->reducers[i]->Free(g->reducers[i]);
@@ -267,6 +862,7 @@ static void Grouper_rpFree(ResultProcessor *grrp) {
   if (g->reducers) {
     array_free(g->reducers);
   }
+  RP_FreeBatch(g->batch);
   rm_free(g->srckeys);
   rm_free(g->dstkeys);
   rm_free(g);
@@ -278,8 +874,9 @@ void Grouper_Free(Grouper *g) {
 
 Grouper *Grouper_New(const RLookupKey **srckeys, const RLookupKey **dstkeys, size_t nkeys) {
   Grouper *g = rm_calloc(1, sizeof(*g));
-  BlkAlloc_Init(&g->groupsAlloc);
-  g->groups = kh_init(khid);
+  BlkAlloc_Init(&g->groups.alloc);
+  pthread_mutex_init(&g->lock, NULL);
+  pthread_cond_init(&g->done, NULL);
 
   g->nkeys = nkeys;
   if (nkeys) {
@@ -299,8 +896,38 @@ void Grouper_AddReducer(Grouper *g, Reducer *r, RLookupKey *dstkey) {
   Reducer **rpp = array_ensure_tail(&g->reducers, Reducer *);
   *rpp = r;
   r->dstkey = dstkey;
+  if (r->AddNumbers) {
+    g->nnumeric++;
+  }
+}
+
+void Grouper_SetSortedInput(Grouper *g) {
+  g->base.Next = Grouper_rpSorted;
 }
 
 ResultProcessor *Grouper_GetRP(Grouper *g) {
   return &g->base;
 }
+
+bool Grouper_HoldsAllResults(const ResultProcessor *rp) {
+  return rp->Next == Grouper_rpYield;
+}
+
+void Grouper_ReplyApproximated(RedisModule_Reply *reply, const ResultProcessor *rp) {
+  const Grouper *g = (const Grouper *)rp;
+  bool any = false;
+  for (size_t ii = 0; ii < GROUPER_NREDUCERS(g); ++ii) {
+    const Reducer *r = g->reducers[ii];
+    if (!r->approximated) {
+      continue;
+    }
+    if (!any) {
+      RedisModule_ReplyKV_Array(reply, "Approximated reducers");
+      any = true;
+    }
+    RedisModule_Reply_StringBuffer(reply, r->dstkey->name, r->dstkey->name_len);
+  }
+  if (any) {
+    RedisModule_Reply_ArrayEnd(reply);
+  }
+}
@@ -29,10 +29,16 @@ static const FuncEntry globalRegistry[] = {
   {"FIRST_VALUE", RDCRFirstValue_New},
   {"RANDOM_SAMPLE", RDCRRandomSample_New},
   {"HLL", RDCRHLL_New},
-  {"HLL_SUM", RDCRHLLSum_New}
+  {"HLL_SUM", RDCRHLLSum_New},
+  {"__STDDEV_STATE", RDCRStdDevState_New},
+  {"__STDDEV_MERGE", RDCRStdDevMerge_New},
+  {"__COUNT_DISTINCT_STATE", RDCRCountDistinctState_New},
+  {"__COUNT_DISTINCT_MERGE", RDCRCountDistinctMerge_New},
+  {"__QUANTILE_STATE", RDCRQuantileState_New},
+  {"__QUANTILE_MERGE", RDCRQuantileMerge_New},
 };
 
-#define REGISTRY_SIZE 14
+#define REGISTRY_SIZE 20
 static_assert(sizeof(globalRegistry) == sizeof(FuncEntry) * REGISTRY_SIZE);
 
 ReducerFactory RDCR_GetFactory(const char *name) {
@@ -85,3 +91,56 @@ int ReducerOpts_EnsureArgsConsumed(const ReducerOptions *options) {
 void *Reducer_BlkAlloc(Reducer *r, size_t elemsz, size_t blksz) {
   return BlkAlloc_Alloc(&r->alloc, elemsz, blksz);
 }
+
+// A reducer which outputs the serialized state of each group, rather than its result
+static Reducer *newStateReducer(const ReducerOptions *options, ReducerFactory factory) {
+  Reducer *r = factory(options);
+  if (r) {
+    r->Finalize = r->SerializeState;
+  }
+  return r;
+}
+
+static int mergeStateAdd(Reducer *r, void *instance, const RLookupRow *srcrow) {
+  const RSValue *v = RLookup_GetItem(r->srckey, srcrow);
+  if (v == NULL || !RSValue_IsAnyString(v)) {
+    return 0;
+  }
+  size_t len;
+  const char *buf = RSValue_StringPtrLen(v, &len);
+  return r->MergeState(r, instance, buf, len);
+}
+
+// A reducer which merges the states serialized by the state reducer of the same factory
+static Reducer *newMergeStateReducer(const ReducerOptions *options, ReducerFactory factory) {
+  Reducer *r = factory(options);
+  if (r) {
+    r->Add = mergeStateAdd;
+    r->AddNumbers = NULL;
+  }
+  return r;
+}
+
+Reducer *RDCRStdDevState_New(const ReducerOptions *options) {
+  return newStateReducer(options, RDCRStdDev_New);
+}
+
+Reducer *RDCRStdDevMerge_New(const ReducerOptions *options) {
+  return newMergeStateReducer(options, RDCRStdDev_New);
+}
+
+Reducer *RDCRCountDistinctState_New(const ReducerOptions *options) {
+  return newStateReducer(options, RDCRCountDistinct_New);
+}
+
+Reducer *RDCRCountDistinctMerge_New(const ReducerOptions *options) {
+  return newMergeStateReducer(options, RDCRCountDistinct_New);
+}
+
+Reducer *RDCRQuantileState_New(const ReducerOptions *options) {
+  return newStateReducer(options, RDCRQuantileDigest_New);
+}
+
+Reducer *RDCRQuantileMerge_New(const ReducerOptions *options) {
+  return newMergeStateReducer(options, RDCRQuantileDigest_New);
+}
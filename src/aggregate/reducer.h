@@ -57,6 +57,22 @@ typedef struct Reducer {
   /** Numeric ID identifying this reducer */
   uint32_t reducerId;
 
+  /**
+   * Set once the reducer approximated a result to stay within its memory
+   * budget (see the _REDUCER_MEMORY_BUDGET config), which FT.PROFILE reports
+   */
+  bool approximated;
+
+  /**
+   * The ratio the results were sampled at (see the SAMPLE option of FT.AGGREGATE), by which the
+   * reducers having StdError() divide their outputs, estimating those of all the results. 0 if
+   * the results were not sampled
+   */
+  double sampleRatio;
+
+  /** Optional. Destination key of the standard error of the estimated output */
+  RLookupKey *errkey;
+
   /**
    * Creates a new per-group instance of this reducer. This is used to create
    * actual data. The reducer structure itself, on the other hand, may be
@@ -73,15 +89,59 @@ typedef struct Reducer {
    */
   int (*Add)(struct Reducer *parent, void *instance, const RLookupRow *srcrow);
 
+  /**
+   * Optional. Adds the numbers of `srckey` of `n` results to the instance at
+   * once, as Add() would add the results one at a time. The grouper gathers
+   * the numbers of consecutive results of the same group into a contiguous
+   * array, and still calls Add() for the results whose value is not a number.
+   */
+  void (*AddNumbers)(struct Reducer *parent, void *instance, const double *vals, size_t n);
+
+  /**
+   * Optional. Adds `n` results to the instance at once, for the reducers which
+   * only depend on the number of results. A grouper without keys whose
+   * reducers all have it only counts the results of the root of the query.
+   */
+  void (*AddCount)(struct Reducer *parent, void *instance, size_t n);
+
   /**
    * Called when Add() has been invoked for the last time. This is used to
    * populate the result of the reduce function.
    */
   RSValue *(*Finalize)(struct Reducer *parent, void *instance);
 
+  /**
+   * Optional. For the reducers estimating a total out of sampled results (see `sampleRatio`), the
+   * standard error of the output of the instance.
+   */
+  double (*StdError)(struct Reducer *parent, void *instance);
+
   /** Frees the object created by NewInstance() */
   void (*FreeInstance)(struct Reducer *parent, void *instance);
 
+  /**
+   * Optional. Merges the state of `other`, accumulated from other results of
+   * the same group, into `instance`. `other` is then freed by FreeInstance().
+   *
+   * The grouper reads its results on several threads only if all of its
+   * reducers can be merged.
+   */
+  void (*Merge)(struct Reducer *parent, void *instance, void *other);
+
+  /**
+   * Optional. Serializes the state of the instance into a binary string, which
+   * MergeState() merges into an instance of the same reducer. This is how the
+   * shards ship their partial results of a distributed GROUPBY to the
+   * coordinator, see the `__<NAME>_STATE` and `__<NAME>_MERGE` reducers.
+   */
+  RSValue *(*SerializeState)(struct Reducer *parent, void *instance);
+
+  /**
+   * Merges a state serialized by SerializeState() into the instance. Returns 0
+   * if `buf` is not a valid state
+   */
+  int (*MergeState)(struct Reducer *parent, void *instance, const char *buf, size_t len);
+
   /**
    * Frees the global reducer struct (this object)
    */
@@ -169,6 +229,14 @@ Reducer *RDCRFirstValue_New(const ReducerOptions *);
 Reducer *RDCRRandomSample_New(const ReducerOptions *);
 Reducer *RDCRHLL_New(const ReducerOptions *);
 Reducer *RDCRHLLSum_New(const ReducerOptions *);
+Reducer *RDCRStdDevState_New(const ReducerOptions *);
+Reducer *RDCRStdDevMerge_New(const ReducerOptions *);
+Reducer *RDCRCountDistinctState_New(const ReducerOptions *);
+Reducer *RDCRCountDistinctMerge_New(const ReducerOptions *);
+// QUANTILE estimated with a t-digest, whatever the configured backend
+Reducer *RDCRQuantileDigest_New(const ReducerOptions *);
+Reducer *RDCRQuantileState_New(const ReducerOptions *);
+Reducer *RDCRQuantileMerge_New(const ReducerOptions *);
 
 typedef Reducer *(*ReducerFactory)(const ReducerOptions *);
 ReducerFactory RDCR_GetFactory(const char *name);
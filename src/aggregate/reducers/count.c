@@ -8,6 +8,7 @@
 */
 #include <aggregate/reducer.h>
 #include <util/block_alloc.h>
+#include <math.h>
 
 typedef struct {
   size_t count;
@@ -26,9 +27,23 @@ static int counterAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void counterAddCount(Reducer *r, void *ctx, size_t n) {
+  ((counterData *)ctx)->count += n;
+}
+
+static void counterMerge(Reducer *r, void *instance, void *other) {
+  ((counterData *)instance)->count += ((counterData *)other)->count;
+}
+
 static RSValue *counterFinalize(Reducer *r, void *instance) {
   counterData *dd = instance;
-  return RSValue_NewNumber(dd->count);
+  return RSValue_NewNumber(r->sampleRatio ? dd->count / r->sampleRatio : dd->count);
+}
+
+static double counterStdError(Reducer *r, void *instance) {
+  // Every result is sampled independently, so the count of the sampled ones is binomial
+  const double n = ((counterData *)instance)->count, p = r->sampleRatio;
+  return sqrt(n * (1 - p)) / p;
 }
 
 Reducer *RDCRCount_New(const ReducerOptions *options) {
@@ -38,7 +53,10 @@ Reducer *RDCRCount_New(const ReducerOptions *options) {
   }
   Reducer *r = rm_calloc(1, sizeof(*r));
   r->Add = counterAdd;
+  r->AddCount = counterAddCount;
   r->Finalize = counterFinalize;
+  r->StdError = counterStdError;
+  r->Merge = counterMerge;
   r->Free = Reducer_GenericFree;
   r->NewInstance = counterNewInstance;
   return r;
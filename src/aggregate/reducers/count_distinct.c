@@ -11,27 +11,89 @@
 #include "util/khash.h"
 #include "util/fnv.h"
 #include "hll/hll.h"
+#include "config.h"
+
+#include <stdatomic.h>
 
 #define HLL_PRECISION_BITS 8
+// The precision of the HLL a COUNT_DISTINCT counter switches to over its memory budget
+#define DISTINCT_HLL_BITS 10
 #define INSTANCE_BLOCK_NUM 1024
 
 static const int khid = 35;
 KHASH_SET_INIT_INT64(khid);
 
+/** Serialized HLL format */
+typedef struct __attribute__((packed)) {
+  uint32_t flags;  // Currently unused
+  uint8_t bits;
+  // uint32_t size -- NOTE - always 1<<bits
+} HLLSerializedHeader;
+
 typedef struct {
-  size_t count;
-  khash_t(khid) * dedup;
+  Reducer base;
+  size_t budget;  // in bytes, or 0 if unlimited
+  // The memory of the hash tables of all the instances, added from all the partitions
+  atomic_size_t used;
+  atomic_bool overBudget;
+} distinctReducer;
+
+typedef struct {
+  khash_t(khid) * dedup;  // NULL once the count is estimated by `hll`
+  struct HLL hll;
 } distinctCounter;
 
+// The memory of the keys of the table, and of their two bits of flags
+static inline size_t dedupBytes(const khash_t(khid) * dedup) {
+  return dedup->n_buckets * sizeof(uint64_t) + dedup->n_buckets / 4;
+}
+
+static inline uint32_t foldHash(uint64_t hval) {
+  return (uint32_t)hval ^ (uint32_t)(hval >> 32);
+}
+
 static void *distinctNewInstance(Reducer *r) {
   BlkAlloc *ba = &r->alloc;
   distinctCounter *ctr =
       BlkAlloc_Alloc(ba, sizeof(*ctr), INSTANCE_BLOCK_NUM * sizeof(*ctr));  // malloc(sizeof(*ctr));
-  ctr->count = 0;
   ctr->dedup = kh_init(khid);
   return ctr;
 }
 
+// Estimate the count of the instance with a HLL from now on, instead of keeping all the hashes
+static void distinctApproximate(distinctCounter *ctr) {
+  hll_init(&ctr->hll, DISTINCT_HLL_BITS);
+  for (khiter_t k = kh_begin(ctr->dedup); k != kh_end(ctr->dedup); ++k) {
+    if (kh_exist(ctr->dedup, k)) {
+      hll_add_hash(&ctr->hll, foldHash(kh_key(ctr->dedup, k)));
+    }
+  }
+  kh_destroy(khid, ctr->dedup);
+  ctr->dedup = NULL;
+}
+
+static void distinctAddHash(distinctReducer *dr, distinctCounter *ctr, uint64_t hval) {
+  if (!ctr->dedup) {
+    hll_add_hash(&ctr->hll, foldHash(hval));
+    return;
+  }
+  size_t before = dedupBytes(ctr->dedup);
+  int ret;
+  kh_put(khid, ctr->dedup, hval, &ret);
+  if (!dr->budget) {
+    return;
+  }
+  size_t after = dedupBytes(ctr->dedup);
+  if (after != before && atomic_fetch_add(&dr->used, after - before) + after - before > dr->budget) {
+    atomic_store(&dr->overBudget, true);
+  }
+  // Once over the budget, every table which grows larger than a HLL is replaced by one, so that
+  // the memory of the reducer stays bounded by its number of groups
+  if (after >= (1 << DISTINCT_HLL_BITS) && atomic_load(&dr->overBudget)) {
+    distinctApproximate(ctr);
+  }
+}
+
 static int distinctAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   distinctCounter *ctr = ctx;
   const RSValue *val = RLookup_GetItem(r->srckey, srcrow);
@@ -39,37 +101,113 @@ static int distinctAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
     return 1;
   }
 
-  uint64_t hval = RSValue_Hash(val, 0);
+  distinctAddHash((distinctReducer *)r, ctr, RSValue_Hash(val, 0));
+  return 1;
+}
+
+static void distinctMerge(Reducer *r, void *instance, void *other) {
+  distinctCounter *ctr = instance, *oth = other;
+  if (!oth->dedup) {
+    if (ctr->dedup) {
+      distinctApproximate(ctr);
+    }
+    hll_merge(&ctr->hll, &oth->hll);
+    return;
+  }
+  for (khiter_t k = kh_begin(oth->dedup); k != kh_end(oth->dedup); ++k) {
+    if (kh_exist(oth->dedup, k)) {
+      distinctAddHash((distinctReducer *)r, ctr, kh_key(oth->dedup, k));
+    }
+  }
+}
+
+// The state is serialized as the hashes of the distinct values, or as the HLL of an estimated
+// count, prefixed by its header. A HLL state is never a multiple of 8 bytes long
+static RSValue *distinctSerializeState(Reducer *r, void *instance) {
+  distinctCounter *ctr = instance;
+  if (!ctr->dedup) {
+    r->approximated = true;
+    HLLSerializedHeader hdr = {.flags = 0, .bits = ctr->hll.bits};
+    char *buf = rm_malloc(sizeof(hdr) + ctr->hll.size);
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy(buf + sizeof(hdr), ctr->hll.registers, ctr->hll.size);
+    return RSValue_NewString(buf, sizeof(hdr) + ctr->hll.size);
+  }
 
-  khiter_t k = kh_get(khid, ctr->dedup, hval);  // first have to get ieter
-  if (k == kh_end(ctr->dedup)) {
-    ctr->count++;
-    int ret;
-    kh_put(khid, ctr->dedup, hval, &ret);
+  size_t len = kh_size(ctr->dedup) * sizeof(uint64_t);
+  char *buf = rm_malloc(len);
+  char *pos = buf;
+  for (khiter_t k = kh_begin(ctr->dedup); k != kh_end(ctr->dedup); ++k) {
+    if (kh_exist(ctr->dedup, k)) {
+      uint64_t hval = kh_key(ctr->dedup, k);
+      memcpy(pos, &hval, sizeof(hval));
+      pos += sizeof(hval);
+    }
+  }
+  return RSValue_NewString(buf, len);
+}
+
+static int distinctMergeState(Reducer *r, void *instance, const char *buf, size_t len) {
+  distinctCounter *ctr = instance;
+  if (len % sizeof(uint64_t)) {
+    HLLSerializedHeader hdr;
+    if (len < sizeof(hdr)) {
+      return 0;
+    }
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (hdr.bits != DISTINCT_HLL_BITS || len - sizeof(hdr) != (1 << DISTINCT_HLL_BITS)) {
+      return 0;
+    }
+    if (ctr->dedup) {
+      distinctApproximate(ctr);
+    }
+    struct HLL tmphll = {
+        .bits = hdr.bits, .size = 1 << hdr.bits, .registers = (uint8_t *)buf + sizeof(hdr)};
+    return hll_merge(&ctr->hll, &tmphll) == 0;
+  }
+  for (size_t off = 0; off < len; off += sizeof(uint64_t)) {
+    uint64_t hval;
+    memcpy(&hval, buf + off, sizeof(hval));
+    distinctAddHash((distinctReducer *)r, ctr, hval);
   }
   return 1;
 }
 
-static RSValue *distinctFinalize(Reducer *parent, void *ctx) {
+static RSValue *distinctFinalize(Reducer *r, void *ctx) {
   distinctCounter *ctr = ctx;
-  return RSValue_NewNumber(ctr->count);
+  if (!ctr->dedup) {
+    r->approximated = true;
+    return RSValue_NewNumber((uint64_t)hll_count(&ctr->hll));
+  }
+  return RSValue_NewNumber(kh_size(ctr->dedup));
 }
 
 static void distinctFreeInstance(Reducer *r, void *p) {
   distinctCounter *ctr = p;
-  // we only destroy the hash table. The object itself is allocated from a block and needs no
-  // freeing
-  kh_destroy(khid, ctr->dedup);
+  // we only destroy the hash table or the HLL. The object itself is allocated from a block and
+  // needs no freeing
+  if (ctr->dedup) {
+    kh_destroy(khid, ctr->dedup);
+  } else {
+    hll_destroy(&ctr->hll);
+  }
 }
 
 Reducer *RDCRCountDistinct_New(const ReducerOptions *options) {
-  Reducer *r = rm_calloc(1, sizeof(*r));
+  distinctReducer *dr = rm_calloc(1, sizeof(*dr));
+  Reducer *r = &dr->base;
   if (!ReducerOpts_GetKey(options, &r->srckey)) {
-    rm_free(r);
+    rm_free(dr);
     return NULL;
   }
+  dr->budget = (size_t)RSGlobalConfig.reducerMemoryBudget * 1024;
+  atomic_init(&dr->used, 0);
+  atomic_init(&dr->overBudget, false);
   r->Add = distinctAdd;
   r->Finalize = distinctFinalize;
+  r->Merge = distinctMerge;
+  r->SerializeState = distinctSerializeState;
+  r->MergeState = distinctMergeState;
   r->Free = Reducer_GenericFree;
   r->FreeInstance = distinctFreeInstance;
   r->NewInstance = distinctNewInstance;
@@ -109,18 +247,15 @@ static RSValue *distinctishFinalize(Reducer *parent, void *instance) {
   return RSValue_NewNumber((uint64_t)hll_count(&ctr->hll));
 }
 
+static void distinctishMerge(Reducer *r, void *instance, void *other) {
+  hll_merge(&((distinctishCounter *)instance)->hll, &((distinctishCounter *)other)->hll);
+}
+
 static void distinctishFreeInstance(Reducer *r, void *p) {
   distinctishCounter *ctr = p;
   hll_destroy(&ctr->hll);
 }
 
-/** Serialized HLL format */
-typedef struct __attribute__((packed)) {
-  uint32_t flags;  // Currently unused
-  uint8_t bits;
-  // uint32_t size -- NOTE - always 1<<bits
-} HLLSerializedHeader;
-
 static RSValue *hllFinalize(Reducer *parent, void *ctx) {
   distinctishCounter *ctr = ctx;
 
@@ -144,6 +279,7 @@ static Reducer *newHllCommon(const ReducerOptions *options, int isRaw) {
   r->Free = Reducer_GenericFree;
   r->FreeInstance = distinctishFreeInstance;
   r->NewInstance = distinctishNewInstance;
+  r->Merge = distinctishMerge;
 
   if (isRaw) {
     r->reducerId = REDUCER_T_HLL;
@@ -227,6 +363,21 @@ static void *hllsumNewInstance(Reducer *r) {
   return ctr;
 }
 
+static void hllsumMerge(Reducer *r, void *instance, void *other) {
+  hllSumCtx *ctr = instance, *oth = other;
+  if (!oth->bits) {
+    return;
+  }
+  if (!ctr->bits) {
+    // Take over the registers, which are then no longer freed with `other`
+    hllSumCtx tmp = *ctr;
+    *ctr = *oth;
+    *oth = tmp;
+  } else if (ctr->bits == oth->bits) {
+    hll_merge(ctr, oth);
+  }
+}
+
 static void hllsumFreeInstance(Reducer *r, void *p) {
   hllSumCtx *ctr = p;
   hll_destroy(ctr);
@@ -243,6 +394,7 @@ Reducer *RDCRHLLSum_New(const ReducerOptions *options) {
   r->Finalize = hllsumFinalize;
   r->NewInstance = hllsumNewInstance;
   r->FreeInstance = hllsumFreeInstance;
+  r->Merge = hllsumMerge;
   r->Free = Reducer_GenericFree;
   return r;
 }
@@ -8,6 +8,7 @@
 */
 #include <aggregate/reducer.h>
 #include <math.h>
+#include "util/numeric_kernels.h"
 
 typedef struct {
   size_t n;
@@ -59,6 +60,59 @@ static int stddevAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   return 1;
 }
 
+static void stddevMerge(Reducer *r, void *instance, void *other) {
+  devCtx *a = instance, *b = other;
+  if (!b->n) {
+    return;
+  }
+  if (!a->n) {
+    *a = *b;
+    return;
+  }
+  // Combine the two partial results, as in Chan et al's parallel algorithm
+  size_t n = a->n + b->n;
+  double delta = b->M - a->M;
+  a->M += delta * b->n / n;
+  a->S += b->S + delta * delta * a->n * b->n / n;
+  a->n = n;
+}
+
+// The numbers are summarized by their own mean and sum of squared deviations, in two passes over
+// the array, which are then combined with the instance
+static void stddevAddNumbers(Reducer *r, void *ctx, const double *vals, size_t n) {
+  if (!n) {
+    return;
+  }
+  double mean = NumericKernel_Sum(vals, n) / n;
+  devCtx other = {.n = n, .M = mean, .S = NumericKernel_SumSquaredDeviations(vals, n, mean)};
+  stddevMerge(r, ctx, &other);
+}
+
+// The serialized state, in the byte order of the host as all the shards share it
+typedef struct __attribute__((packed)) {
+  uint64_t n;
+  double M, S;
+} devState;
+
+static RSValue *stddevSerializeState(Reducer *r, void *instance) {
+  devCtx *dctx = instance;
+  devState st = {.n = dctx->n, .M = dctx->M, .S = dctx->S};
+  char *buf = rm_malloc(sizeof(st));
+  memcpy(buf, &st, sizeof(st));
+  return RSValue_NewString(buf, sizeof(st));
+}
+
+static int stddevMergeState(Reducer *r, void *instance, const char *buf, size_t len) {
+  devState st;
+  if (len != sizeof(st)) {
+    return 0;
+  }
+  memcpy(&st, buf, sizeof(st));
+  devCtx other = {.n = st.n, .M = st.M, .S = st.S};
+  stddevMerge(r, instance, &other);
+  return 1;
+}
+
 static RSValue *stddevFinalize(Reducer *parent, void *instance) {
   devCtx *dctx = instance;
   double variance = ((dctx->n > 1) ? dctx->S / (dctx->n - 1) : 0.0);
@@ -73,7 +127,11 @@ Reducer *RDCRStdDev_New(const ReducerOptions *options) {
     return NULL;
   }
   r->Add = stddevAdd;
+  r->AddNumbers = stddevAddNumbers;
   r->Finalize = stddevFinalize;
+  r->Merge = stddevMerge;
+  r->SerializeState = stddevSerializeState;
+  r->MergeState = stddevMergeState;
   r->Free = Reducer_GenericFree;
   r->NewInstance = stddevNewInstance;
   r->reducerId = REDUCER_T_STDDEV;
@@ -8,6 +8,8 @@
 */
 #include <aggregate/reducer.h>
 #include <float.h>
+#include <math.h>
+#include "util/numeric_kernels.h"
 
 typedef struct {
   double val;
@@ -17,7 +19,8 @@ static int minAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   minmaxCtx *m = ctx;
   double val;
   RSValue *v = RLookup_GetItem(r->srckey, srcrow);
-  if (RSValue_ToNumber(v, &val)) {
+  // NaNs are ignored, as NumericKernel_Min() does
+  if (RSValue_ToNumber(v, &val) && !isnan(val)) {
     m->val = MIN(m->val, val);
   }
   return 1;
@@ -27,18 +30,33 @@ static int maxAdd(Reducer *r, void *ctx, const RLookupRow *srcrow) {
   minmaxCtx *m = ctx;
   double val;
   RSValue *v = RLookup_GetItem(r->srckey, srcrow);
-  if (RSValue_ToNumber(v, &val)) {
+  if (RSValue_ToNumber(v, &val) && !isnan(val)) {
     m->val = MAX(m->val, val);
   }
   return 1;
 }
 
+static void minAddNumbers(Reducer *r, void *ctx, const double *vals, size_t n) {
+  minmaxCtx *m = ctx;
+  m->val = MIN(m->val, NumericKernel_Min(vals, n));
+}
+
+static void maxAddNumbers(Reducer *r, void *ctx, const double *vals, size_t n) {
+  minmaxCtx *m = ctx;
+  m->val = MAX(m->val, NumericKernel_Max(vals, n));
+}
+
 static void *minmaxNewInstance(Reducer *r) {
   minmaxCtx *m = BlkAlloc_Alloc(&r->alloc, sizeof(*m), 1024);
   m->val = r->Add == maxAdd ? -INFINITY : INFINITY;
   return m;
 }
 
+static void minmaxMerge(Reducer *r, void *instance, void *other) {
+  minmaxCtx *m = instance, *o = other;
+  m->val = r->Add == maxAdd ? MAX(m->val, o->val) : MIN(m->val, o->val);
+}
+
 static RSValue *minmaxFinalize(Reducer *parent, void *instance) {
   minmaxCtx *ctx = instance;
   return RSValue_NewNumber(ctx->val);
@@ -54,7 +72,9 @@ static Reducer *newMinMax(const ReducerOptions *options, ReducerAddFunc modeAdd)
   }
   r->NewInstance = minmaxNewInstance;
   r->Add = modeAdd;
+  r->AddNumbers = modeAdd == minAdd ? minAddNumbers : maxAddNumbers;
   r->Finalize = minmaxFinalize;
+  r->Merge = minmaxMerge;
   r->Free = Reducer_GenericFree;
   r->reducerId = modeAdd == minAdd ? REDUCER_T_MIN : REDUCER_T_MAX;
   return r;
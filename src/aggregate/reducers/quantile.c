@@ -8,22 +8,35 @@
 */
 #include <aggregate/reducer.h>
 #include "util/quantile.h"
+#include "util/tdigest.h"
+#include "config.h"
 
 typedef struct {
   Reducer base;
   double pct;
-  unsigned resolution;
+  unsigned resolution;   // of the sample stream
+  unsigned compression;  // of the t-digest, or 0 to use a sample stream
 } QTLReducer;
 
 static void *quantileNewInstance(Reducer *parent) {
   QTLReducer *qt = (QTLReducer *)parent;
+  if (qt->compression) {
+    return NewTDigest(qt->compression);
+  }
   return NewQuantileStream(NULL, 0, qt->resolution);
 }
 
+static inline void quantileInsert(QTLReducer *qt, void *ctx, double d) {
+  if (qt->compression) {
+    TD_Add(ctx, d, 1);
+  } else {
+    QS_Insert(ctx, d);
+  }
+}
+
 static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
   double d;
   QTLReducer *qt = (QTLReducer *)rbase;
-  QuantStream *qs = ctx;
   RSValue *v = RLookup_GetItem(rbase->srckey, row);
   if (!v) {
     return 1;
@@ -31,13 +44,13 @@ static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
 
   if (!RSValue_IsArray(v)) {
     if (RSValue_ToNumber(v, &d)) {
-      QS_Insert(qs, d);
+      quantileInsert(qt, ctx, d);
     }
   } else {
     uint32_t sz = RSValue_ArrayLen(v);
     for (uint32_t i = 0; i < sz; i++) {
       if (RSValue_ToNumber(RSValue_ArrayItem(v, i), &d)) {
-        QS_Insert(qs, d);
+        quantileInsert(qt, ctx, d);
       }
     }
   }
@@ -45,19 +58,39 @@ static int quantileAdd(Reducer *rbase, void *ctx, const RLookupRow *row) {
 }
 
 static RSValue *quantileFinalize(Reducer *r, void *ctx) {
-  QuantStream *qs = ctx;
   QTLReducer *qt = (QTLReducer *)r;
-  double value = QS_Query(qs, qt->pct);
+  double value = qt->compression ? TD_Quantile(ctx, qt->pct) : QS_Query(ctx, qt->pct);
   return RSValue_NewNumber(value);
 }
 
-static void quantileFreeInstance(Reducer *unused, void *p) {
-  QS_Free(p);
+static void quantileFreeInstance(Reducer *r, void *p) {
+  if (((QTLReducer *)r)->compression) {
+    TD_Free(p);
+  } else {
+    QS_Free(p);
+  }
 }
 
-Reducer *RDCRQuantile_New(const ReducerOptions *options) {
+static void digestMerge(Reducer *r, void *instance, void *other) {
+  TD_Merge(instance, other);
+}
+
+static RSValue *digestSerializeState(Reducer *r, void *instance) {
+  char *buf;
+  size_t len = TD_Serialize(instance, &buf);
+  return RSValue_NewString(buf, len);
+}
+
+static int digestMergeState(Reducer *r, void *instance, const char *buf, size_t len) {
+  return TD_MergeSerialized(instance, buf, len);
+}
+
+// The trailing hidden argument is the resolution of the sample stream, or the compression of the
+// t-digest
+static Reducer *newQuantile(const ReducerOptions *options, unsigned compression) {
   QTLReducer *r = rm_calloc(1, sizeof(*r));
   r->resolution = 500;  // Fixed, i guess?
+  r->compression = compression;
 
   if (!ReducerOptions_GetKey(options, &r->base.srckey)) {
     goto error;
@@ -74,14 +107,22 @@ Reducer *RDCRQuantile_New(const ReducerOptions *options) {
 
   if (!AC_IsAtEnd(options->args)) {
     // TODO: why do we need this hidden option? why isn't it available in cluster mode?
-    if ((rv = AC_GetUnsigned(options->args, &r->resolution, 0)) != AC_OK) {
+    unsigned param;
+    if ((rv = AC_GetUnsigned(options->args, &param, 0)) != AC_OK) {
       QERR_MKBADARGS_AC(options->status, "<resolution>", rv);
       goto error;
     }
-    if (r->resolution < 1 || r->resolution > MAX_SAMPLE_SIZE) {
-      QueryError_SetError(options->status, QUERY_ERROR_CODE_PARSE_ARGS, "Invalid resolution");
+    unsigned maxParam = r->compression ? MAX_QUANTILE_COMPRESSION : MAX_SAMPLE_SIZE;
+    if (param < 1 || param > maxParam) {
+      QueryError_SetError(options->status, QUERY_ERROR_CODE_PARSE_ARGS,
+                          r->compression ? "Invalid compression" : "Invalid resolution");
       goto error;
     }
+    if (r->compression) {
+      r->compression = param;
+    } else {
+      r->resolution = param;
+    }
   }
 
   if (!ReducerOpts_EnsureArgsConsumed(options)) {
@@ -93,9 +134,23 @@ Reducer *RDCRQuantile_New(const ReducerOptions *options) {
   r->base.Free = Reducer_GenericFree;
   r->base.FreeInstance = quantileFreeInstance;
   r->base.Finalize = quantileFinalize;
+  if (r->compression) {
+    r->base.Merge = digestMerge;
+    r->base.SerializeState = digestSerializeState;
+    r->base.MergeState = digestMergeState;
+  }
   return &r->base;
 
 error:
   rm_free(r);
   return NULL;
 }
+
+Reducer *RDCRQuantile_New(const ReducerOptions *options) {
+  return newQuantile(options, RSGlobalConfig.quantileCompression);
+}
+
+Reducer *RDCRQuantileDigest_New(const ReducerOptions *options) {
+  unsigned compression = RSGlobalConfig.quantileCompression;
+  return newQuantile(options, compression ? compression : TDIGEST_DEFAULT_COMPRESSION);
+}
@@ -7,10 +7,13 @@
  * GNU Affero General Public License v3 (AGPLv3).
 */
 #include <aggregate/reducer.h>
+#include "util/numeric_kernels.h"
+#include <math.h>
 
 typedef struct {
   size_t count;
   double total;
+  double squares;  // sum of the squared values, only if the results are sampled
 } sumCtx;
 
 typedef struct {
@@ -24,6 +27,7 @@ static void *sumNewInstance(Reducer *r) {
   sumCtx *ctx = BlkAlloc_Alloc(&r->alloc, sizeof(*ctx), BLOCK_SIZE);
   ctx->count = 0;
   ctx->total = 0;
+  ctx->squares = 0;
   return ctx;
 }
 
@@ -34,10 +38,29 @@ static int sumAdd(Reducer *r, void *instance, const RLookupRow *row) {
   if (RSValue_ToNumber(v, &d)) {
     ctr->total += d;
     ctr->count++;
+    if (r->sampleRatio) {
+      ctr->squares += d * d;
+    }
   }
   return 1;
 }
 
+static void sumAddNumbers(Reducer *r, void *instance, const double *vals, size_t n) {
+  sumCtx *ctr = instance;
+  ctr->total += NumericKernel_Sum(vals, n);
+  ctr->count += n;
+  if (r->sampleRatio) {
+    ctr->squares += NumericKernel_SumSquaredDeviations(vals, n, 0);
+  }
+}
+
+static void sumMerge(Reducer *r, void *instance, void *other) {
+  sumCtx *ctr = instance, *oth = other;
+  ctr->total += oth->total;
+  ctr->count += oth->count;
+  ctr->squares += oth->squares;
+}
+
 static RSValue *sumFinalize(Reducer *baseparent, void *instance) {
   sumCtx *ctr = instance;
   SumReducer *parent = (SumReducer *)baseparent;
@@ -46,12 +69,20 @@ static RSValue *sumFinalize(Reducer *baseparent, void *instance) {
     if (parent->isAvg) {
       v = ctr->total / ctr->count;
     } else {
-      v = ctr->total;
+      v = baseparent->sampleRatio ? ctr->total / baseparent->sampleRatio : ctr->total;
     }
   }
   return RSValue_NewNumber(v);
 }
 
+static double sumStdError(Reducer *r, void *instance) {
+  // The sum of values sampled independently at ratio p, scaled by 1/p, has a variance of
+  // (1-p)/p^2 times the sum of their squares
+  const sumCtx *ctr = instance;
+  const double p = r->sampleRatio;
+  return sqrt((1 - p) * ctr->squares) / p;
+}
+
 static Reducer *newReducerCommon(const ReducerOptions *options, bool isAvg) {
   SumReducer *r = rm_calloc(1, sizeof(*r));
   if (!ReducerOpts_GetKey(options, &r->base.srckey)) {
@@ -60,9 +91,15 @@ static Reducer *newReducerCommon(const ReducerOptions *options, bool isAvg) {
   }
   r->base.NewInstance = sumNewInstance;
   r->base.Add = sumAdd;
+  r->base.AddNumbers = sumAddNumbers;
   r->base.Finalize = sumFinalize;
+  r->base.Merge = sumMerge;
   r->base.Free = Reducer_GenericFree;
   r->isAvg = isAvg;
+  if (!isAvg) {
+    // The average of sampled results needs no scaling up
+    r->base.StdError = sumStdError;
+  }
   return &r->base;
 }
 
@@ -7,6 +7,15 @@
  * GNU Affero General Public License v3 (AGPLv3).
 */
 #include <aggregate/reducer.h>
+#include "config.h"
+
+typedef struct {
+  Reducer base;
+  size_t budget;  // in bytes, or 0 if unlimited
+  // The memory of the values of all the instances. TOLIST cannot be merged, so its instances are
+  // never accumulated on several threads
+  size_t used;
+} ToListReducer;
 
 static uint64_t hashFunction_RSValue(const void *key) {
   return RSValue_Hash(key, 0);
@@ -35,7 +44,30 @@ static void *tolistNewInstance(Reducer *rbase) {
   return values;
 }
 
+// The memory a value keeps in a list: its entry, its bucket, and the value it holds a reference to
+static size_t tolistValueBytes(const RSValue *v) {
+  size_t len = 0;
+  if (RSValue_IsAnyString(v)) {
+    RSValue_StringPtrLen(v, &len);
+  }
+  return sizeof(dictEntry) + sizeof(dictEntry *) + sizeof(RSValue) + len;
+}
+
+static void tolistAddValue(ToListReducer *tl, dict *values, RSValue *v) {
+  if (tl->budget && tl->used > tl->budget) {
+    // Over the budget, the lists keep the values they already hold and no other one
+    if (!dictFind(values, v)) {
+      tl->base.approximated = true;
+    }
+    return;
+  }
+  if (dictAdd(values, v, NULL) == DICT_OK && tl->budget) {
+    tl->used += tolistValueBytes(v);
+  }
+}
+
 static int tolistAdd(Reducer *rbase, void *ctx, const RLookupRow *srcrow) {
+  ToListReducer *tl = (ToListReducer *)rbase;
   dict *values = ctx;
   RSValue *v = RLookup_GetItem(rbase->srckey, srcrow);
   if (!v) {
@@ -44,11 +76,11 @@ static int tolistAdd(Reducer *rbase, void *ctx, const RLookupRow *srcrow) {
 
   // for non array values we simply add the value to the list */
   if (!RSValue_IsArray(v)) {
-    dictAdd(values, v, NULL);
+    tolistAddValue(tl, values, v);
   } else {  // For array values we add each distinct element to the list
     uint32_t len = RSValue_ArrayLen(v);
     for (uint32_t i = 0; i < len; i++) {
-      dictAdd(values, RSValue_ArrayItem(v, i), NULL);
+      tolistAddValue(tl, values, RSValue_ArrayItem(v, i));
     }
   }
   return 1;
@@ -74,11 +106,13 @@ static void tolistFreeInstance(Reducer *parent, void *p) {
 }
 
 Reducer *RDCRToList_New(const ReducerOptions *opts) {
-  Reducer *r = rm_calloc(1, sizeof(*r));
+  ToListReducer *tl = rm_calloc(1, sizeof(*tl));
+  Reducer *r = &tl->base;
   if (!ReducerOptions_GetKey(opts, &r->srckey)) {
-    rm_free(r);
+    rm_free(tl);
     return NULL;
   }
+  tl->budget = (size_t)RSGlobalConfig.reducerMemoryBudget * 1024;
   r->Add = tolistAdd;
   r->Finalize = tolistFinalize;
   r->Free = Reducer_GenericFree;
@@ -36,6 +36,7 @@
 #define RS_ALIASDEL_IF_EX RS_CMD_WRITE_PREFIX "._ALIASDELIFX"        // for replica of support
 #define RS_ALIASUPDATE RS_CMD_WRITE_PREFIX ".ALIASUPDATE"
 #define RS_RESTORE_IF_NX RS_CMD_WRITE_PREFIX "._RESTOREIFNX"         // for replica of support (Currently there is no FT.RESTORE command)
+#define RS_INDEX_DELTA_CMD RS_CMD_WRITE_PREFIX "._INDEXDELTA"        // for replica of support
 
 // Legacy write commands that are key-bounded (+ extra legacy commands that have to be registered for enterprise)
 #define RS_ADD_CMD "FT.ADD"
@@ -57,6 +58,8 @@
 #define RS_DICT_DUMP "FT.DICTDUMP"
 #define RS_SYNDUMP_CMD "FT.SYNDUMP"
 #define RS_INDEX_LIST_CMD "FT._LIST"
+#define RS_SLOWLOG_CMD "FT.SLOWLOG"
+#define RS_MEMORY_CMD "FT.MEMORY"
 #define RS_SYNADD_CMD "FT.SYNADD" // Deprecated, always returns an error
 
 // read commands
@@ -64,6 +67,7 @@
 #define RS_SEARCH_CMD RS_CMD_READ_PREFIX ".SEARCH"
 #define RS_HYBRID_CMD RS_CMD_READ_PREFIX ".HYBRID"
 #define RS_AGGREGATE_CMD RS_CMD_READ_PREFIX ".AGGREGATE"
+#define RS_EXPORT_CMD RS_CMD_READ_PREFIX ".EXPORT"
 #define RS_PROFILE_CMD RS_CMD_READ_PREFIX ".PROFILE"
 #define RS_MGET_CMD RS_CMD_READ_PREFIX ".MGET"
 #define RS_TAGVALS_CMD RS_CMD_READ_PREFIX ".TAGVALS"
@@ -46,6 +46,8 @@ typedef struct ConcurrentCmdCtx {
   int argc;
   int options;
   WeakRef spec_ref;
+  // The private data of the blocked client, set when the client disconnects
+  QueryCancelToken *cancel;
 } ConcurrentCmdCtx;
 
 /* Run a function on the concurrent thread pool */
@@ -65,7 +67,8 @@ static void threadHandleCommand(void *p) {
 
   RedisModule_BlockedClientMeasureTimeEnd(ctx->bc);
 
-  RedisModule_UnblockClient(ctx->bc, NULL);
+  // The token is freed with the blocked client, as it may still be cancelled until then
+  RedisModule_UnblockClient(ctx->bc, ctx->cancel);
   rm_free(ctx->argv);
   rm_free(p);
 }
@@ -78,12 +81,30 @@ WeakRef ConcurrentCmdCtx_GetWeakRef(ConcurrentCmdCtx *cctx) {
   return cctx->spec_ref;
 }
 
+const QueryCancelToken *ConcurrentCmdCtx_GetCancelToken(ConcurrentCmdCtx *cctx) {
+  return cctx->cancel;
+}
+
+static void cancelCommandOnDisconnect(RedisModuleCtx *ctx, RedisModuleBlockedClient *bc) {
+  QueryCancelToken *cancel = RedisModule_BlockClientGetPrivateData(bc);
+  if (cancel) {
+    QueryCancelToken_Cancel(cancel);
+  }
+}
+
+static void freeCancelToken(RedisModuleCtx *ctx, void *cancel) {
+  rm_free(cancel);
+}
+
 int ConcurrentSearch_HandleRedisCommandEx(int poolType, ConcurrentCmdHandler handler,
                                           RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
                                           WeakRef spec_ref) {
   ConcurrentCmdCtx *cmdCtx = rm_malloc(sizeof(*cmdCtx));
 
-  cmdCtx->bc = RedisModule_BlockClient(ctx, NULL, NULL, NULL, 0);
+  cmdCtx->bc = RedisModule_BlockClient(ctx, NULL, NULL, freeCancelToken, 0);
+  cmdCtx->cancel = rm_calloc(1, sizeof(*cmdCtx->cancel));
+  RedisModule_BlockClientSetPrivateData(cmdCtx->bc, cmdCtx->cancel);
+  RedisModule_SetDisconnectCallback(cmdCtx->bc, cancelCommandOnDisconnect);
   cmdCtx->argc = argc;
   cmdCtx->spec_ref = spec_ref;
   cmdCtx->ctx = RedisModule_GetThreadSafeContext(cmdCtx->bc);
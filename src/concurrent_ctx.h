@@ -13,6 +13,7 @@
 #include "redismodule.h"
 #include "thpool/thpool.h"
 #include "util/references.h"
+#include "util/timeout.h"
 
 /** Concurrent Search Execution Context.
  */
@@ -50,6 +51,9 @@ void ConcurrentCmdCtx_KeepRedisCtx(struct ConcurrentCmdCtx *ctx);
 // Returns the WeakRef held in the context.
 WeakRef ConcurrentCmdCtx_GetWeakRef(struct ConcurrentCmdCtx *cctx);
 
+// Returns the token set when the client of the command disconnects. It lives until the command is done
+const QueryCancelToken *ConcurrentCmdCtx_GetCancelToken(struct ConcurrentCmdCtx *cctx);
+
 /* Same as handleRedis command, but set flags for the concurrent context */
 int ConcurrentSearch_HandleRedisCommandEx(int poolType, ConcurrentCmdHandler handler,
                                           RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
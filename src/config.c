@@ -23,6 +23,7 @@
 #include "resp3.h"
 #include "util/workers.h"
 #include "module.h"
+#include "util/cpu_affinity.h"
 
 #define __STRINGIFY(x) #x
 #define STRINGIFY(x) __STRINGIFY(x)
@@ -49,6 +50,7 @@ configPair_t __configPairs[] = {
   {"BG_INDEX_SLEEP_GAP",              "search-bg-index-sleep-gap"},
   {"CONN_PER_SHARD",                  "search-conn-per-shard"},
   {"CURSOR_MAX_IDLE",                 "search-cursor-max-idle"},
+  {"CURSOR_READ_AHEAD",               "search-cursor-read-ahead"},
   {"CURSOR_REPLY_THRESHOLD",          "search-cursor-reply-threshold"},
   {"DEFAULT_DIALECT",                 "search-default-dialect"},
   {"DEFAULT_SCORER",                  "search-default-scorer"},
@@ -90,6 +92,56 @@ configPair_t __configPairs[] = {
   {"BM25STD_TANH_FACTOR",             "search-bm25std-tanh-factor"},
   {"_BG_INDEX_OOM_PAUSE_TIME",         "search-_bg-index-oom-pause-time"},
   {"INDEXER_YIELD_EVERY_OPS",         "search-indexer-yield-every-ops"},
+  {"_INDEX_READER_PREFETCH_DISTANCE", "search-_index-reader-prefetch-distance"},
+  {"_PARALLEL_QUERY_RANGES",          "search-_parallel-query-ranges"},
+  {"_HEAVY_QUERY_COST",               "search-_heavy-query-cost"},
+  {"_MAX_RUNNING_HEAVY_QUERIES",      "search-_max-running-heavy-queries"},
+  {"_MAX_WAITING_HEAVY_QUERIES",      "search-_max-waiting-heavy-queries"},
+  {"_EXPR_FUNCTION_MEMO_SIZE",        "search-_expr-function-memo-size"},
+  {"_GROUPBY_PARTITIONS",             "search-_groupby-partitions"},
+  {"_QUANTILE_COMPRESSION",           "search-_quantile-compression"},
+  {"_REDUCER_MEMORY_BUDGET",          "search-_reducer-memory-budget"},
+  {"_NUMERIC_BITMAP_UNION_RANGES",    "search-_numeric-bitmap-union-ranges"},
+  {"_NUMERIC_MERGE_UNION_RANGES",     "search-_numeric-merge-union-ranges"},
+  {"_NUMERIC_HLL_PRECISION",          "search-_numeric-hll-precision"},
+  {"_TAG_COMPACT_THRESHOLD",          "search-_tag-compact-threshold"},
+  {"_TAG_SET_MIN_VALUES",             "search-_tag-set-min-values"},
+  {"_SHARD_WINDOW_TARGET_RECALL",     "search-_shard-window-target-recall"},
+  {"_COORD_RESULT_CACHE_TTL_MS",      "search-_coord-result-cache-ttl-ms"},
+  {"_SCORE_THRESHOLD_MIN_RESULTS",    "search-_score-threshold-min-results"},
+  {"_HYBRID_FILTER_IDS_MAX",          "search-_hybrid-filter-ids-max"},
+  {"_KNN_RESULT_CACHE_ENTRIES",       "search-_knn-result-cache-entries"},
+  {"_SEARCH_RESULT_CACHE_BYTES",      "search-_search-result-cache-bytes"},
+  {"_QUERY_PLAN_CACHE_ENTRIES",       "search-_query-plan-cache-entries"},
+  {"_FILTER_CACHE_MIN_USES",          "search-_filter-cache-min-uses"},
+  {"_SNIPPET_CACHE_BYTES",            "search-_snippet-cache-bytes"},
+  {"_CURSOR_READ_AHEAD_BYTES",        "search-_cursor-read-ahead-bytes"},
+  {"_IMPACT_POSTINGS_MIN_DOCS",       "search-_impact-postings-min-docs"},
+  {"_IMPACT_POSTINGS_SIZE",           "search-_impact-postings-size"},
+  {"_TERM_TIERING_IDLE_CYCLES",       "search-_term-tiering-idle-cycles"},
+  {"_SLOWLOG_THRESHOLD_MS",           "search-_slowlog-threshold-ms"},
+  {"_SLOWLOG_MAX_LEN",                "search-_slowlog-max-len"},
+  {"_PROFILE_SAMPLE_RATE",            "search-_profile-sample-rate"},
+  {"_NUMERIC_EXACT_CARDINALITY",      "search-_numeric-exact-cardinality"},
+  {"_SUFFIX_ARRAY",                   "search-_suffix-array"},
+  {"_FORK_GC_CYCLE_BUDGET_MS",        "search-_fork-gc-cycle-budget-ms"},
+  {"_FORK_GC_APPLY_THREADS",          "search-_fork-gc-apply-threads"},
+  {"_WORKERS_CPUS",                   "search-_workers-cpus"},
+  {"_IO_THREADS_CPUS",                "search-_io-threads-cpus"},
+  {"_FORK_GC_CPUS",                   "search-_fork-gc-cpus"},
+  {"_BINARY_SHARD_ROWS",              "search-_binary-shard-rows"},
+  {"_HEDGE_SHARD_REQUESTS",           "search-_hedge-shard-requests"},
+  {"_SHARD_WINDOW_SECOND_ROUND",      "search-_shard-window-second-round"},
+  {"_GEO_CELL_COVERING",              "search-_geo-cell-covering"},
+  {"_PERSIST_INDEXES",                "search-_persist-indexes"},
+  {"_INDEX_SEGMENTS",                 "search-_index-segments"},
+  {"_LAZY_INDEX_LOADING",             "search-_lazy-index-loading"},
+  {"_PROFILE_HW_COUNTERS",            "search-_profile-hw-counters"},
+  {"_SPILL_IDLE_CURSORS",             "search-_spill-idle-cursors"},
+  {"_SPELLCHECK_DELETE_INDEX",        "search-_spellcheck-delete-index"},
+  {"_SKIP_UNCHANGED_DOCS",            "search-_skip-unchanged-docs"},
+  {"_INDEX_DELTA_REPLICATION",        "search-_index-delta-replication"},
+  {"_HOT_INDEXES",                    "search-_hot-indexes"},
   {"ON_OOM",                          "search-on-oom"},
 };
 
@@ -676,6 +728,97 @@ RedisModuleString * get_friso_ini(const char *name, void *privdata) {
   return config_friso_ini;
 }
 
+// _WORKERS_CPUS, _IO_THREADS_CPUS, _FORK_GC_CPUS
+static int setCPUList(const char **field, const char *name, ArgsCursor *ac, QueryError *status) {
+  const char *list;
+  int acrc = AC_GetString(ac, &list, NULL, 0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (!CPUList_IsValid(list)) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_PARSE_ARGS,
+      "%s must be a list of CPUs and CPU ranges, e.g. 0-3,8", name);
+    return REDISMODULE_ERR;
+  }
+  rm_free((void *)*field);
+  *field = rm_strdup(list);
+  return REDISMODULE_OK;
+}
+
+static sds getCPUList(const char *list) {
+  return list && *list ? sdsnew(list) : NULL;
+}
+
+CONFIG_SETTER(setWorkersCPUs) {
+  return setCPUList(&config->workersCPUs, "_WORKERS_CPUS", ac, status);
+}
+CONFIG_GETTER(getWorkersCPUs) {
+  return getCPUList(config->workersCPUs);
+}
+
+CONFIG_SETTER(setIOThreadsCPUs) {
+  return setCPUList(&config->ioThreadsCPUs, "_IO_THREADS_CPUS", ac, status);
+}
+CONFIG_GETTER(getIOThreadsCPUs) {
+  return getCPUList(config->ioThreadsCPUs);
+}
+
+CONFIG_SETTER(setForkGCCPUs) {
+  return setCPUList(&config->forkGCCPUs, "_FORK_GC_CPUS", ac, status);
+}
+CONFIG_GETTER(getForkGCCPUs) {
+  return getCPUList(config->forkGCCPUs);
+}
+
+// _HOT_INDEXES
+CONFIG_SETTER(setHotIndexes) {
+  const char *list;
+  int acrc = AC_GetString(ac, &list, NULL, 0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  rm_free((void *)config->hotIndexes);
+  config->hotIndexes = rm_strdup(list);
+  return REDISMODULE_OK;
+}
+CONFIG_GETTER(getHotIndexes) {
+  return config->hotIndexes && *config->hotIndexes ? sdsnew(config->hotIndexes) : NULL;
+}
+
+RedisModuleString *get_hot_indexes_config(const char *name, void *privdata) {
+  const char *str = *(const char **)privdata;
+  if (str == NULL) {
+    return NULL;
+  }
+  if (config_hot_indexes) {
+    RedisModule_FreeString(NULL, config_hot_indexes);
+  }
+  config_hot_indexes = RedisModule_CreateString(NULL, str, strlen(str));
+  return config_hot_indexes;
+}
+
+// search-_workers-cpus, search-_io-threads-cpus, search-_fork-gc-cpus
+int set_cpu_list_config(const char *name, RedisModuleString *val, void *privdata,
+                        RedisModuleString **err) {
+  if (!CPUList_IsValid(RedisModule_StringPtrLen(val, NULL))) {
+    *err = RedisModule_CreateStringPrintf(NULL,
+      "%s must be a list of CPUs and CPU ranges, e.g. 0-3,8", name);
+    return REDISMODULE_ERR;
+  }
+  return set_immutable_string_config(name, val, privdata, err);
+}
+
+RedisModuleString *get_cpu_list_config(const char *name, void *privdata) {
+  const char *str = *(const char **)privdata;
+  RedisModuleString **cached = privdata == &RSGlobalConfig.workersCPUs ? &config_workers_cpus :
+                               privdata == &RSGlobalConfig.ioThreadsCPUs ? &config_io_threads_cpus :
+                                                                           &config_fork_gc_cpus;
+  if (str == NULL) {
+    return NULL;
+  }
+  if (*cached) {
+    RedisModule_FreeString(NULL, *cached);
+  }
+  *cached = RedisModule_CreateString(NULL, str, strlen(str));
+  return *cached;
+}
+
 RedisModuleString *get_default_scorer_config(const char *name, void *privdata) {
   char *str = *(char **)privdata;
   RS_ASSERT(str != NULL);
@@ -794,6 +937,36 @@ CONFIG_GETTER(getForkGcRetryInterval) {
   return sdscatprintf(ss, "%lu", config->gcConfigParams.forkGc.forkGcRetryInterval);
 }
 
+// _FORK_GC_CYCLE_BUDGET_MS
+CONFIG_SETTER(setForkGcCycleBudget) {
+  int acrc = AC_GetSize(ac, &config->gcConfigParams.forkGc.forkGcCycleBudgetMs, AC_F_GE0);
+  RETURN_STATUS(acrc);
+}
+
+CONFIG_GETTER(getForkGcCycleBudget) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->gcConfigParams.forkGc.forkGcCycleBudgetMs);
+}
+
+// _FORK_GC_APPLY_THREADS
+CONFIG_SETTER(setForkGcApplyThreads) {
+  size_t threads;
+  int acrc = AC_GetSize(ac, &threads, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (threads > MAX_FORK_GC_APPLY_THREADS) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_FORK_GC_APPLY_THREADS must be between 0 and %d inclusive", MAX_FORK_GC_APPLY_THREADS);
+    return REDISMODULE_ERR;
+  }
+  config->gcConfigParams.forkGc.forkGcApplyThreads = threads;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getForkGcApplyThreads) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%lu", config->gcConfigParams.forkGc.forkGcApplyThreads);
+}
+
 // UNION_ITERATOR_HEAP
 CONFIG_SETTER(setMinUnionIteratorHeap) {
   int acrc = AC_GetLongLong(ac, &config->iteratorsConfigParams.minUnionIterHeap, AC_F_GE1);
@@ -921,6 +1094,8 @@ CONFIG_SETTER(setGcPolicy) {
   CHECK_RETURN_PARSE_ERROR(acrc);
   if (!strcasecmp(policy, "DEFAULT") || !strcasecmp(policy, "FORK")) {
     config->gcConfigParams.gcPolicy = GCPolicy_Fork;
+  } else if (!strcasecmp(policy, "INCREMENTAL")) {
+    config->gcConfigParams.gcPolicy = GCPolicy_Incremental;
   } else if (!strcasecmp(policy, "LEGACY")) {
     QueryError_SetError(status, QUERY_ERROR_CODE_PARSE_ARGS, "Legacy GC policy is no longer supported (since 2.6.0)");
     return REDISMODULE_ERR;
@@ -1066,174 +1241,786 @@ CONFIG_GETTER(getIndexerYieldEveryOps) {
   return sdscatprintf(ss, "%u", config->indexerYieldEveryOpsWhileLoading);
 }
 
-// ON_OOM
-CONFIG_SETTER(setOnOom) {
-  size_t len;
-  const char *policy;
-  int acrc = AC_GetString(ac, &policy, &len, 0);
+// _INDEX_READER_PREFETCH_DISTANCE
+CONFIG_SETTER(setIndexReaderPrefetchDistance) {
+  uint32_t distance;
+  int acrc = AC_GetU32(ac, &distance, AC_F_GE0);
   CHECK_RETURN_PARSE_ERROR(acrc);
-  RSOomPolicy oom = OomPolicy_Parse(policy, len);
-  if (oom == OomPolicy_Invalid) {
-    QueryError_SetError(status, QUERY_ERROR_CODE_BAD_VAL, "Invalid ON_OOM value");
+  config->indexReaderPrefetchDistance = distance;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getIndexReaderPrefetchDistance) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->indexReaderPrefetchDistance);
+}
+
+// _PARALLEL_QUERY_RANGES
+CONFIG_SETTER(setParallelQueryRanges) {
+  uint32_t ranges;
+  int acrc = AC_GetU32(ac, &ranges, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (ranges > MAX_PARALLEL_QUERY_RANGES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_PARALLEL_QUERY_RANGES must be between 0 and %d inclusive", MAX_PARALLEL_QUERY_RANGES);
     return REDISMODULE_ERR;
   }
-  config->requestConfigParams.oomPolicy = oom;
+  config->parallelQueryRanges = ranges;
   return REDISMODULE_OK;
 }
 
-CONFIG_GETTER(getOnOom) {
-  return sdsnew(OomPolicy_ToString(config->requestConfigParams.oomPolicy));
+CONFIG_GETTER(getParallelQueryRanges) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->parallelQueryRanges);
 }
 
-// on-oom
-int set_on_oom(const char *name, int val, void *privdata,
-               RedisModuleString **err) {
-  REDISMODULE_NOT_USED(name);
-  REDISMODULE_NOT_USED(err);
-  *((RSOomPolicy *)privdata) = (RSOomPolicy)val;
+// _HEAVY_QUERY_COST
+CONFIG_SETTER(setHeavyQueryCost) {
+  uint32_t cost;
+  int acrc = AC_GetU32(ac, &cost, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  config->heavyQueryCost = cost;
   return REDISMODULE_OK;
 }
 
-int get_on_oom(const char *name, void *privdata){
-  REDISMODULE_NOT_USED(name);
-  return *((RSOomPolicy *)privdata);
+CONFIG_GETTER(getHeavyQueryCost) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->heavyQueryCost);
 }
 
-RSConfig RSGlobalConfig = RS_DEFAULT_CONFIG;
+// _MAX_RUNNING_HEAVY_QUERIES
+CONFIG_SETTER(setMaxRunningHeavyQueries) {
+  uint32_t max;
+  int acrc = AC_GetU32(ac, &max, AC_F_GE1);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (max > MAX_MAX_RUNNING_HEAVY_QUERIES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_MAX_RUNNING_HEAVY_QUERIES must be between 1 and %d inclusive", MAX_MAX_RUNNING_HEAVY_QUERIES);
+    return REDISMODULE_ERR;
+  }
+  config->maxRunningHeavyQueries = max;
+  return REDISMODULE_OK;
+}
 
-static RSConfigVar *findConfigVar(const RSConfigOptions *config, const char *name) {
-  for (; config; config = config->next) {
-    const RSConfigVar *vars = config->vars;
-    for (; vars->name != NULL; vars++) {
-      if (!strcasecmp(name, vars->name)) {
-        return (RSConfigVar *)vars;
-      }
-    }
+CONFIG_GETTER(getMaxRunningHeavyQueries) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->maxRunningHeavyQueries);
+}
+
+// _MAX_WAITING_HEAVY_QUERIES
+CONFIG_SETTER(setMaxWaitingHeavyQueries) {
+  uint32_t max;
+  int acrc = AC_GetU32(ac, &max, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  config->maxWaitingHeavyQueries = max;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getMaxWaitingHeavyQueries) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->maxWaitingHeavyQueries);
+}
+
+// _EXPR_FUNCTION_MEMO_SIZE
+CONFIG_SETTER(setExprFunctionMemoSize) {
+  uint32_t size;
+  int acrc = AC_GetU32(ac, &size, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (size > MAX_EXPR_FUNCTION_MEMO_SIZE) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_EXPR_FUNCTION_MEMO_SIZE must be between 0 and %d inclusive", MAX_EXPR_FUNCTION_MEMO_SIZE);
+    return REDISMODULE_ERR;
   }
-  return NULL;
+  config->exprFunctionMemoSize = size;
+  return REDISMODULE_OK;
 }
 
-static void LogWarningDeprecatedModuleArgs(const char *name) {
-  const char *configName = FTConfigNameToConfigName(name);
-  if (configName != NULL && strlen(configName) > 0) {
-    RedisModule_Log(RSDummyContext, "warning",
-      "`%s` was set, but module arguments are deprecated, consider using CONFIG parameter `%s` instead",
-      name, configName);
-  } else {
-    RedisModule_Log(RSDummyContext, "warning",
-      "`%s` was set, but module arguments are deprecated", name);
+CONFIG_GETTER(getExprFunctionMemoSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->exprFunctionMemoSize);
+}
+
+// _GROUPBY_PARTITIONS
+CONFIG_SETTER(setGroupByPartitions) {
+  uint32_t partitions;
+  int acrc = AC_GetU32(ac, &partitions, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (partitions > MAX_GROUPBY_PARTITIONS) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_GROUPBY_PARTITIONS must be between 0 and %d inclusive", MAX_GROUPBY_PARTITIONS);
+    return REDISMODULE_ERR;
   }
+  config->groupByPartitions = partitions;
+  return REDISMODULE_OK;
 }
 
-void LogWarningDeprecatedFTConfig(RedisModuleCtx *ctx, const char *action,
-                                  const char *name) {
-  const char *configName = FTConfigNameToConfigName(name);
-  if (configName != NULL && strlen(configName) > 0) {
-    RedisModule_Log(ctx, "warning",
-      "FT.CONFIG is deprecated, please use CONFIG %s %s instead", action, configName);
-  } else {
-    RedisModule_Log(ctx, "warning",
-      "FT.CONFIG is deprecated and its parameter `%s` is deprecated", name);
+CONFIG_GETTER(getGroupByPartitions) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->groupByPartitions);
+}
+
+// _QUANTILE_COMPRESSION
+CONFIG_SETTER(setQuantileCompression) {
+  uint32_t compression;
+  int acrc = AC_GetU32(ac, &compression, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (compression > MAX_QUANTILE_COMPRESSION) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_QUANTILE_COMPRESSION must be between 0 and %d inclusive", MAX_QUANTILE_COMPRESSION);
+    return REDISMODULE_ERR;
   }
+  config->quantileCompression = compression;
+  return REDISMODULE_OK;
 }
 
-int ReadConfig(RedisModuleString **argv, int argc, char **err) {
-  *err = NULL;
-  QueryError status = QueryError_Default();
+CONFIG_GETTER(getQuantileCompression) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->quantileCompression);
+}
 
-  if (RedisModule_GetServerVersion) {   // for rstest
-    RSGlobalConfig.serverVersion = RedisModule_GetServerVersion();
+// _REDUCER_MEMORY_BUDGET
+CONFIG_SETTER(setReducerMemoryBudget) {
+  uint32_t budget;
+  int acrc = AC_GetU32(ac, &budget, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (budget > MAX_REDUCER_MEMORY_BUDGET) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_REDUCER_MEMORY_BUDGET must be between 0 and %d inclusive", MAX_REDUCER_MEMORY_BUDGET);
+    return REDISMODULE_ERR;
   }
+  config->reducerMemoryBudget = budget;
+  return REDISMODULE_OK;
+}
 
-  ArgsCursor ac = {0};
-  ArgsCursor_InitRString(&ac, argv, argc);
-  while (!AC_IsAtEnd(&ac)) {
-    const char *name = AC_GetStringNC(&ac, NULL);
-    RSConfigVar *curVar = findConfigVar(&RSGlobalConfigOptions, name);
-    if (curVar == NULL) {
-      rm_asprintf(err, "No such configuration option `%s`", name);
-      return REDISMODULE_ERR;
-    }
-    if (curVar->setValue == NULL) {
-      rm_asprintf(err, "%s: Option is read-only", name);
-      return REDISMODULE_ERR;
-    }
+CONFIG_GETTER(getReducerMemoryBudget) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->reducerMemoryBudget);
+}
 
-    // `triggerId` is set by the coordinator when it registers a trigger for a configuration.
-    // If we don't have a coordinator or this configuration has no trigger, this value
-    // is meaningless and should be ignored
-    if (curVar->setValue(&RSGlobalConfig, &ac, curVar->triggerId, &status) != REDISMODULE_OK) {
-      *err = rm_strdup(QueryError_GetUserError(&status));
-      QueryError_ClearError(&status);
-      return REDISMODULE_ERR;
-    }
-    // Mark the option as having been modified
-    curVar->flags |= RSCONFIGVAR_F_MODIFIED;
-    LogWarningDeprecatedModuleArgs(name);
+// _NUMERIC_BITMAP_UNION_RANGES
+CONFIG_SETTER(setNumericBitmapUnionRanges) {
+  uint32_t ranges;
+  int acrc = AC_GetU32(ac, &ranges, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (ranges > MAX_NUMERIC_BITMAP_UNION_RANGES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_NUMERIC_BITMAP_UNION_RANGES must be between 0 and %d inclusive", MAX_NUMERIC_BITMAP_UNION_RANGES);
+    return REDISMODULE_ERR;
   }
+  config->numericBitmapUnionRanges = ranges;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getNumericBitmapUnionRanges) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->numericBitmapUnionRanges);
+}
 
+// _NUMERIC_MERGE_UNION_RANGES
+CONFIG_SETTER(setNumericMergeUnionRanges) {
+  uint32_t ranges;
+  int acrc = AC_GetU32(ac, &ranges, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (ranges > MAX_NUMERIC_MERGE_UNION_RANGES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_NUMERIC_MERGE_UNION_RANGES must be between 0 and %d inclusive", MAX_NUMERIC_MERGE_UNION_RANGES);
+    return REDISMODULE_ERR;
+  }
+  config->numericMergeUnionRanges = ranges;
   return REDISMODULE_OK;
 }
 
-RSConfigOptions RSGlobalConfigOptions = {
-    .vars = {
-        {.name = "EXTLOAD",
-         .helpText = "Load extension scoring/expansion module",
-         .setValue = setExtLoad,
-         .getValue = getExtLoad,
-         .flags = RSCONFIGVAR_F_IMMUTABLE},
-        {.name = "NOGC",
-         .helpText = "Disable garbage collection (for this process)",
-         .setValue = setNoGc,
-         .getValue = getNoGc,
-         .flags = RSCONFIGVAR_F_FLAG | RSCONFIGVAR_F_IMMUTABLE},
-        {.name = "MINPREFIX",
-         .helpText = "Set the minimum prefix for expansions (`*`)",
-         .setValue = setMinPrefix,
-         .getValue = getMinPrefix},
-        {.name = "MINSTEMLEN",
-         .helpText = "Set the minimum word length to stem (default 4)",
-         .setValue = setMinStemLen,
-         .getValue = getMinStemLen},
-        {.name = "FORKGC_SLEEP_BEFORE_EXIT",
-         .helpText = "set the amount of seconds for the fork GC to sleep before exists, should "
-                     "always be set to 0 (other then on tests).",
-         .setValue = setForkGCSleep,
-         .getValue = getForkGCSleep},
-        {.name = "MAXDOCTABLESIZE",
-         .helpText = "Maximum runtime document table size (for this process)",
-         .setValue = setMaxDocTableSize,
-         .getValue = getMaxDocTableSize,
-         .flags = RSCONFIGVAR_F_IMMUTABLE},
-        {.name = "MAXSEARCHRESULTS",
-         .helpText = "Maximum number of results from ft.search command",
-         .setValue = setMaxSearchResults,
-         .getValue = getMaxSearchResults},
-        {.name = "MAXAGGREGATERESULTS",
-         .helpText = "Maximum number of results from ft.aggregate command",
-         .setValue = setMaxAggregateResults,
-         .getValue = getMaxAggregateResults},
-        {.name = "MAXEXPANSIONS",
-         .helpText = "Maximum prefix expansions to be used in a query",
-         .setValue = setMaxExpansions,
-         .getValue = getMaxExpansions},
-        {.name = "MAXPREFIXEXPANSIONS",
-         .helpText = "Maximum prefix expansions to be used in a query",
-         .setValue = setMaxExpansions,
-         .getValue = getMaxExpansions},
-        {.name = "TIMEOUT",
-         .helpText = "Query (search) timeout",
-         .setValue = setTimeout,
-         .getValue = getTimeout},
-        {.name = "WORKERS",
-         .helpText = "Number of worker threads to use for query processing and background tasks. Default is 0."
-                     " This configuration also affects the number of connections per shard. See CONN_PER_SHARD."
-         ,
-         .setValue = setWorkThreads,
-         .getValue = getWorkThreads,
-        },
-        {.name = "MIN_OPERATION_WORKERS",
-         .helpText = "Number of worker threads to use for background tasks when the server is in an operation event. "
+CONFIG_GETTER(getNumericMergeUnionRanges) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->numericMergeUnionRanges);
+}
+
+// _NUMERIC_HLL_PRECISION
+CONFIG_SETTER(setNumericHllPrecision) {
+  uint32_t bits;
+  int acrc = AC_GetU32(ac, &bits, AC_F_GE1);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (bits < MIN_NUMERIC_HLL_PRECISION || bits > MAX_NUMERIC_HLL_PRECISION) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_NUMERIC_HLL_PRECISION must be between %d and %d inclusive", MIN_NUMERIC_HLL_PRECISION,
+      MAX_NUMERIC_HLL_PRECISION);
+    return REDISMODULE_ERR;
+  }
+  config->numericHllPrecision = bits;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getNumericHllPrecision) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->numericHllPrecision);
+}
+
+// _NUMERIC_EXACT_CARDINALITY
+CONFIG_BOOLEAN_SETTER(set_NumericExactCardinality, numericExactCardinality)
+CONFIG_BOOLEAN_GETTER(get_NumericExactCardinality, numericExactCardinality, 0)
+
+// _SUFFIX_ARRAY
+CONFIG_BOOLEAN_SETTER(set_SuffixArray, suffixArray)
+CONFIG_BOOLEAN_GETTER(get_SuffixArray, suffixArray, 0)
+
+// _BINARY_SHARD_ROWS
+CONFIG_BOOLEAN_SETTER(set_BinaryShardRows, binaryShardRows)
+CONFIG_BOOLEAN_GETTER(get_BinaryShardRows, binaryShardRows, 0)
+
+// _HEDGE_SHARD_REQUESTS
+CONFIG_BOOLEAN_SETTER(set_HedgeShardRequests, hedgeShardRequests)
+CONFIG_BOOLEAN_GETTER(get_HedgeShardRequests, hedgeShardRequests, 0)
+
+// _SHARD_WINDOW_SECOND_ROUND
+CONFIG_BOOLEAN_SETTER(set_ShardWindowSecondRound, shardWindowSecondRound)
+CONFIG_BOOLEAN_GETTER(get_ShardWindowSecondRound, shardWindowSecondRound, 0)
+
+// _GEO_CELL_COVERING
+CONFIG_BOOLEAN_SETTER(set_GeoCellCovering, geoCellCovering)
+CONFIG_BOOLEAN_GETTER(get_GeoCellCovering, geoCellCovering, 0)
+
+// _PERSIST_INDEXES
+CONFIG_BOOLEAN_SETTER(set_PersistIndexes, persistIndexes)
+CONFIG_BOOLEAN_GETTER(get_PersistIndexes, persistIndexes, 0)
+
+// _INDEX_SEGMENTS
+CONFIG_BOOLEAN_SETTER(set_IndexSegments, indexSegments)
+CONFIG_BOOLEAN_GETTER(get_IndexSegments, indexSegments, 0)
+
+// _LAZY_INDEX_LOADING
+CONFIG_BOOLEAN_SETTER(set_LazyIndexLoading, lazyIndexLoading)
+CONFIG_BOOLEAN_GETTER(get_LazyIndexLoading, lazyIndexLoading, 0)
+
+// _PROFILE_HW_COUNTERS
+CONFIG_BOOLEAN_SETTER(set_ProfileHWCounters, profileHWCounters)
+CONFIG_BOOLEAN_GETTER(get_ProfileHWCounters, profileHWCounters, 0)
+
+// _SPILL_IDLE_CURSORS
+CONFIG_BOOLEAN_SETTER(set_SpillIdleCursors, spillIdleCursors)
+CONFIG_BOOLEAN_GETTER(get_SpillIdleCursors, spillIdleCursors, 0)
+
+// _SPELLCHECK_DELETE_INDEX
+CONFIG_BOOLEAN_SETTER(set_SpellCheckDeleteIndex, spellCheckDeleteIndex)
+CONFIG_BOOLEAN_GETTER(get_SpellCheckDeleteIndex, spellCheckDeleteIndex, 0)
+
+// _SKIP_UNCHANGED_DOCS
+CONFIG_BOOLEAN_SETTER(set_SkipUnchangedDocs, skipUnchangedDocs)
+CONFIG_BOOLEAN_GETTER(get_SkipUnchangedDocs, skipUnchangedDocs, 0)
+
+// _INDEX_DELTA_REPLICATION
+CONFIG_BOOLEAN_SETTER(set_IndexDeltaReplication, indexDeltaReplication)
+CONFIG_BOOLEAN_GETTER(get_IndexDeltaReplication, indexDeltaReplication, 0)
+
+// _TAG_COMPACT_THRESHOLD
+CONFIG_SETTER(setTagCompactThreshold) {
+  uint32_t threshold;
+  int acrc = AC_GetU32(ac, &threshold, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (threshold > MAX_TAG_COMPACT_THRESHOLD) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_TAG_COMPACT_THRESHOLD must be between 0 and %d inclusive", MAX_TAG_COMPACT_THRESHOLD);
+    return REDISMODULE_ERR;
+  }
+  config->tagCompactThreshold = threshold;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getTagCompactThreshold) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->tagCompactThreshold);
+}
+
+// _TAG_SET_MIN_VALUES
+CONFIG_SETTER(setTagSetMinValues) {
+  uint32_t values;
+  int acrc = AC_GetU32(ac, &values, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (values > MAX_TAG_SET_MIN_VALUES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_TAG_SET_MIN_VALUES must be between 0 and %d inclusive", MAX_TAG_SET_MIN_VALUES);
+    return REDISMODULE_ERR;
+  }
+  config->tagSetMinValues = values;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getTagSetMinValues) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->tagSetMinValues);
+}
+
+// _SHARD_WINDOW_TARGET_RECALL
+CONFIG_SETTER(setShardWindowTargetRecall) {
+  uint32_t recall;
+  int acrc = AC_GetU32(ac, &recall, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (recall > MAX_SHARD_WINDOW_TARGET_RECALL) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_SHARD_WINDOW_TARGET_RECALL must be between 0 and %d inclusive", MAX_SHARD_WINDOW_TARGET_RECALL);
+    return REDISMODULE_ERR;
+  }
+  config->shardWindowTargetRecall = recall;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getShardWindowTargetRecall) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->shardWindowTargetRecall);
+}
+
+// _COORD_RESULT_CACHE_TTL_MS
+CONFIG_SETTER(setCoordResultCacheTTL) {
+  uint32_t ttl;
+  int acrc = AC_GetU32(ac, &ttl, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (ttl > MAX_COORD_RESULT_CACHE_TTL_MS) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_COORD_RESULT_CACHE_TTL_MS must be between 0 and %d inclusive", MAX_COORD_RESULT_CACHE_TTL_MS);
+    return REDISMODULE_ERR;
+  }
+  config->coordResultCacheTTL = ttl;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getCoordResultCacheTTL) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->coordResultCacheTTL);
+}
+
+// _SCORE_THRESHOLD_MIN_RESULTS
+CONFIG_SETTER(setScoreThresholdMinResults) {
+  uint32_t minResults;
+  int acrc = AC_GetU32(ac, &minResults, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (minResults > MAX_SCORE_THRESHOLD_MIN_RESULTS) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_SCORE_THRESHOLD_MIN_RESULTS must be between 0 and %d inclusive", MAX_SCORE_THRESHOLD_MIN_RESULTS);
+    return REDISMODULE_ERR;
+  }
+  config->scoreThresholdMinResults = minResults;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getScoreThresholdMinResults) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->scoreThresholdMinResults);
+}
+
+// _HYBRID_FILTER_IDS_MAX
+CONFIG_SETTER(setHybridFilterIdsMax) {
+  uint32_t maxIds;
+  int acrc = AC_GetU32(ac, &maxIds, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (maxIds > MAX_HYBRID_FILTER_IDS_MAX) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_HYBRID_FILTER_IDS_MAX must be between 0 and %d inclusive", MAX_HYBRID_FILTER_IDS_MAX);
+    return REDISMODULE_ERR;
+  }
+  config->hybridFilterIdsMax = maxIds;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getHybridFilterIdsMax) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->hybridFilterIdsMax);
+}
+
+// _KNN_RESULT_CACHE_ENTRIES
+CONFIG_SETTER(setKnnResultCacheEntries) {
+  uint32_t entries;
+  int acrc = AC_GetU32(ac, &entries, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (entries > MAX_KNN_RESULT_CACHE_ENTRIES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_KNN_RESULT_CACHE_ENTRIES must be between 0 and %d inclusive", MAX_KNN_RESULT_CACHE_ENTRIES);
+    return REDISMODULE_ERR;
+  }
+  config->knnResultCacheEntries = entries;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getKnnResultCacheEntries) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->knnResultCacheEntries);
+}
+
+// _SEARCH_RESULT_CACHE_BYTES
+CONFIG_SETTER(setSearchResultCacheBytes) {
+  uint32_t bytes;
+  int acrc = AC_GetU32(ac, &bytes, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (bytes > MAX_SEARCH_RESULT_CACHE_BYTES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_SEARCH_RESULT_CACHE_BYTES must be between 0 and %d inclusive", MAX_SEARCH_RESULT_CACHE_BYTES);
+    return REDISMODULE_ERR;
+  }
+  config->searchResultCacheBytes = bytes;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getSearchResultCacheBytes) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->searchResultCacheBytes);
+}
+
+// _QUERY_PLAN_CACHE_ENTRIES
+CONFIG_SETTER(setQueryPlanCacheEntries) {
+  uint32_t entries;
+  int acrc = AC_GetU32(ac, &entries, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (entries > MAX_QUERY_PLAN_CACHE_ENTRIES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_QUERY_PLAN_CACHE_ENTRIES must be between 0 and %d inclusive", MAX_QUERY_PLAN_CACHE_ENTRIES);
+    return REDISMODULE_ERR;
+  }
+  config->queryPlanCacheEntries = entries;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getQueryPlanCacheEntries) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->queryPlanCacheEntries);
+}
+
+// _FILTER_CACHE_MIN_USES
+CONFIG_SETTER(setFilterCacheMinUses) {
+  uint32_t uses;
+  int acrc = AC_GetU32(ac, &uses, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (uses > MAX_FILTER_CACHE_MIN_USES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_FILTER_CACHE_MIN_USES must be between 0 and %d inclusive", MAX_FILTER_CACHE_MIN_USES);
+    return REDISMODULE_ERR;
+  }
+  config->filterCacheMinUses = uses;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getFilterCacheMinUses) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->filterCacheMinUses);
+}
+
+// _SNIPPET_CACHE_BYTES
+CONFIG_SETTER(setSnippetCacheBytes) {
+  uint32_t bytes;
+  int acrc = AC_GetU32(ac, &bytes, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (bytes > MAX_SNIPPET_CACHE_BYTES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_SNIPPET_CACHE_BYTES must be between 0 and %d inclusive", MAX_SNIPPET_CACHE_BYTES);
+    return REDISMODULE_ERR;
+  }
+  config->snippetCacheBytes = bytes;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getSnippetCacheBytes) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->snippetCacheBytes);
+}
+
+// _CURSOR_READ_AHEAD_BYTES
+CONFIG_SETTER(setCursorReadAheadBytes) {
+  uint32_t bytes;
+  int acrc = AC_GetU32(ac, &bytes, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (bytes > MAX_CURSOR_READ_AHEAD_BYTES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_CURSOR_READ_AHEAD_BYTES must be between 0 and %d inclusive", MAX_CURSOR_READ_AHEAD_BYTES);
+    return REDISMODULE_ERR;
+  }
+  config->cursorReadAheadBytes = bytes;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getCursorReadAheadBytes) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->cursorReadAheadBytes);
+}
+
+// _IMPACT_POSTINGS_MIN_DOCS
+CONFIG_SETTER(setImpactPostingsMinDocs) {
+  uint32_t docs;
+  int acrc = AC_GetU32(ac, &docs, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (docs > MAX_IMPACT_POSTINGS_MIN_DOCS) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_IMPACT_POSTINGS_MIN_DOCS must be between 0 and %d inclusive", MAX_IMPACT_POSTINGS_MIN_DOCS);
+    return REDISMODULE_ERR;
+  }
+  config->impactPostingsMinDocs = docs;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getImpactPostingsMinDocs) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->impactPostingsMinDocs);
+}
+
+// _IMPACT_POSTINGS_SIZE
+CONFIG_SETTER(setImpactPostingsSize) {
+  uint32_t size;
+  int acrc = AC_GetU32(ac, &size, AC_F_GE1);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (size > MAX_IMPACT_POSTINGS_SIZE) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_IMPACT_POSTINGS_SIZE must be between 1 and %d inclusive", MAX_IMPACT_POSTINGS_SIZE);
+    return REDISMODULE_ERR;
+  }
+  config->impactPostingsSize = size;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getImpactPostingsSize) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->impactPostingsSize);
+}
+
+// _TERM_TIERING_IDLE_CYCLES
+CONFIG_SETTER(setTermTieringIdleCycles) {
+  uint32_t cycles;
+  int acrc = AC_GetU32(ac, &cycles, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (cycles > MAX_TERM_TIERING_IDLE_CYCLES) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_TERM_TIERING_IDLE_CYCLES must be between 0 and %d inclusive", MAX_TERM_TIERING_IDLE_CYCLES);
+    return REDISMODULE_ERR;
+  }
+  config->termTieringIdleCycles = cycles;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getTermTieringIdleCycles) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->termTieringIdleCycles);
+}
+
+// _SLOWLOG_THRESHOLD_MS
+CONFIG_SETTER(setSlowlogThreshold) {
+  uint32_t ms;
+  int acrc = AC_GetU32(ac, &ms, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (ms > MAX_SLOWLOG_THRESHOLD_MS) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_SLOWLOG_THRESHOLD_MS must be between 0 and %d inclusive", MAX_SLOWLOG_THRESHOLD_MS);
+    return REDISMODULE_ERR;
+  }
+  config->slowlogThresholdMS = ms;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getSlowlogThreshold) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->slowlogThresholdMS);
+}
+
+// _SLOWLOG_MAX_LEN
+CONFIG_SETTER(setSlowlogMaxLen) {
+  uint32_t len;
+  int acrc = AC_GetU32(ac, &len, AC_F_GE1);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (len > MAX_SLOWLOG_MAX_LEN) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_SLOWLOG_MAX_LEN must be between 1 and %d inclusive", MAX_SLOWLOG_MAX_LEN);
+    return REDISMODULE_ERR;
+  }
+  config->slowlogMaxLen = len;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getSlowlogMaxLen) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->slowlogMaxLen);
+}
+
+// _PROFILE_SAMPLE_RATE
+CONFIG_SETTER(setProfileSampleRate) {
+  uint32_t rate;
+  int acrc = AC_GetU32(ac, &rate, AC_F_GE0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (rate > MAX_PROFILE_SAMPLE_RATE) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "_PROFILE_SAMPLE_RATE must be between 0 and %d inclusive", MAX_PROFILE_SAMPLE_RATE);
+    return REDISMODULE_ERR;
+  }
+  config->profileSampleRate = rate;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getProfileSampleRate) {
+  sds ss = sdsempty();
+  return sdscatprintf(ss, "%u", config->profileSampleRate);
+}
+
+// ON_OOM
+CONFIG_SETTER(setOnOom) {
+  size_t len;
+  const char *policy;
+  int acrc = AC_GetString(ac, &policy, &len, 0);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  RSOomPolicy oom = OomPolicy_Parse(policy, len);
+  if (oom == OomPolicy_Invalid) {
+    QueryError_SetError(status, QUERY_ERROR_CODE_BAD_VAL, "Invalid ON_OOM value");
+    return REDISMODULE_ERR;
+  }
+  config->requestConfigParams.oomPolicy = oom;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getOnOom) {
+  return sdsnew(OomPolicy_ToString(config->requestConfigParams.oomPolicy));
+}
+
+// on-oom
+int set_on_oom(const char *name, int val, void *privdata,
+               RedisModuleString **err) {
+  REDISMODULE_NOT_USED(name);
+  REDISMODULE_NOT_USED(err);
+  *((RSOomPolicy *)privdata) = (RSOomPolicy)val;
+  return REDISMODULE_OK;
+}
+
+int get_on_oom(const char *name, void *privdata){
+  REDISMODULE_NOT_USED(name);
+  return *((RSOomPolicy *)privdata);
+}
+
+RSConfig RSGlobalConfig = RS_DEFAULT_CONFIG;
+
+static RSConfigVar *findConfigVar(const RSConfigOptions *config, const char *name) {
+  for (; config; config = config->next) {
+    const RSConfigVar *vars = config->vars;
+    for (; vars->name != NULL; vars++) {
+      if (!strcasecmp(name, vars->name)) {
+        return (RSConfigVar *)vars;
+      }
+    }
+  }
+  return NULL;
+}
+
+static void LogWarningDeprecatedModuleArgs(const char *name) {
+  const char *configName = FTConfigNameToConfigName(name);
+  if (configName != NULL && strlen(configName) > 0) {
+    RedisModule_Log(RSDummyContext, "warning",
+      "`%s` was set, but module arguments are deprecated, consider using CONFIG parameter `%s` instead",
+      name, configName);
+  } else {
+    RedisModule_Log(RSDummyContext, "warning",
+      "`%s` was set, but module arguments are deprecated", name);
+  }
+}
+
+void LogWarningDeprecatedFTConfig(RedisModuleCtx *ctx, const char *action,
+                                  const char *name) {
+  const char *configName = FTConfigNameToConfigName(name);
+  if (configName != NULL && strlen(configName) > 0) {
+    RedisModule_Log(ctx, "warning",
+      "FT.CONFIG is deprecated, please use CONFIG %s %s instead", action, configName);
+  } else {
+    RedisModule_Log(ctx, "warning",
+      "FT.CONFIG is deprecated and its parameter `%s` is deprecated", name);
+  }
+}
+
+int ReadConfig(RedisModuleString **argv, int argc, char **err) {
+  *err = NULL;
+  QueryError status = QueryError_Default();
+
+  if (RedisModule_GetServerVersion) {   // for rstest
+    RSGlobalConfig.serverVersion = RedisModule_GetServerVersion();
+  }
+
+  ArgsCursor ac = {0};
+  ArgsCursor_InitRString(&ac, argv, argc);
+  while (!AC_IsAtEnd(&ac)) {
+    const char *name = AC_GetStringNC(&ac, NULL);
+    RSConfigVar *curVar = findConfigVar(&RSGlobalConfigOptions, name);
+    if (curVar == NULL) {
+      rm_asprintf(err, "No such configuration option `%s`", name);
+      return REDISMODULE_ERR;
+    }
+    if (curVar->setValue == NULL) {
+      rm_asprintf(err, "%s: Option is read-only", name);
+      return REDISMODULE_ERR;
+    }
+
+    // `triggerId` is set by the coordinator when it registers a trigger for a configuration.
+    // If we don't have a coordinator or this configuration has no trigger, this value
+    // is meaningless and should be ignored
+    if (curVar->setValue(&RSGlobalConfig, &ac, curVar->triggerId, &status) != REDISMODULE_OK) {
+      *err = rm_strdup(QueryError_GetUserError(&status));
+      QueryError_ClearError(&status);
+      return REDISMODULE_ERR;
+    }
+    // Mark the option as having been modified
+    curVar->flags |= RSCONFIGVAR_F_MODIFIED;
+    LogWarningDeprecatedModuleArgs(name);
+  }
+
+  return REDISMODULE_OK;
+}
+
+RSConfigOptions RSGlobalConfigOptions = {
+    .vars = {
+        {.name = "EXTLOAD",
+         .helpText = "Load extension scoring/expansion module",
+         .setValue = setExtLoad,
+         .getValue = getExtLoad,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "NOGC",
+         .helpText = "Disable garbage collection (for this process)",
+         .setValue = setNoGc,
+         .getValue = getNoGc,
+         .flags = RSCONFIGVAR_F_FLAG | RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "MINPREFIX",
+         .helpText = "Set the minimum prefix for expansions (`*`)",
+         .setValue = setMinPrefix,
+         .getValue = getMinPrefix},
+        {.name = "MINSTEMLEN",
+         .helpText = "Set the minimum word length to stem (default 4)",
+         .setValue = setMinStemLen,
+         .getValue = getMinStemLen},
+        {.name = "FORKGC_SLEEP_BEFORE_EXIT",
+         .helpText = "set the amount of seconds for the fork GC to sleep before exists, should "
+                     "always be set to 0 (other then on tests).",
+         .setValue = setForkGCSleep,
+         .getValue = getForkGCSleep},
+        {.name = "MAXDOCTABLESIZE",
+         .helpText = "Maximum runtime document table size (for this process)",
+         .setValue = setMaxDocTableSize,
+         .getValue = getMaxDocTableSize,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "MAXSEARCHRESULTS",
+         .helpText = "Maximum number of results from ft.search command",
+         .setValue = setMaxSearchResults,
+         .getValue = getMaxSearchResults},
+        {.name = "MAXAGGREGATERESULTS",
+         .helpText = "Maximum number of results from ft.aggregate command",
+         .setValue = setMaxAggregateResults,
+         .getValue = getMaxAggregateResults},
+        {.name = "MAXEXPANSIONS",
+         .helpText = "Maximum prefix expansions to be used in a query",
+         .setValue = setMaxExpansions,
+         .getValue = getMaxExpansions},
+        {.name = "MAXPREFIXEXPANSIONS",
+         .helpText = "Maximum prefix expansions to be used in a query",
+         .setValue = setMaxExpansions,
+         .getValue = getMaxExpansions},
+        {.name = "TIMEOUT",
+         .helpText = "Query (search) timeout",
+         .setValue = setTimeout,
+         .getValue = getTimeout},
+        {.name = "WORKERS",
+         .helpText = "Number of worker threads to use for query processing and background tasks. Default is 0."
+                     " This configuration also affects the number of connections per shard. See CONN_PER_SHARD."
+         ,
+         .setValue = setWorkThreads,
+         .getValue = getWorkThreads,
+        },
+        {.name = "MIN_OPERATION_WORKERS",
+         .helpText = "Number of worker threads to use for background tasks when the server is in an operation event. "
                      "Default is " STRINGIFY(MIN_OPERATION_WORKERS),
          .setValue = setMinOperationWorkers,
          .getValue = getMinOperationWorkers,
@@ -1288,7 +2075,8 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setOnTimeout,
          .getValue = getOnTimeout},
         {.name = "GCSCANSIZE",
-         .helpText = "Scan this many documents at a time during every GC iteration",
+         .helpText = "Scan this many inverted index blocks at a time during every tick of the "
+                     "incremental gc",
          .setValue = setGcScanSize,
          .getValue = getGcScanSize},
         {.name = "MIN_PHONETIC_TERM_LEN",
@@ -1296,7 +2084,8 @@ RSConfigOptions RSGlobalConfigOptions = {
          .setValue = setMinPhoneticTermLen,
          .getValue = getMinPhoneticTermLen},
         {.name = "GC_POLICY",
-         .helpText = "gc policy to use (DEFAULT/LEGACY)",
+         .helpText = "gc policy to use (DEFAULT/FORK/INCREMENTAL). The incremental gc collects the "
+                     "garbage in the main process, a few blocks at a time, rather than in a fork",
          .setValue = setGcPolicy,
          .getValue = getGcPolicy,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
@@ -1314,13 +2103,25 @@ RSConfigOptions RSGlobalConfigOptions = {
          .helpText = "interval (in seconds) in which to retry running the forkgc after failure.",
          .setValue = setForkGcRetryInterval,
          .getValue = getForkGcRetryInterval},
+        {.name = "_FORK_GC_CYCLE_BUDGET_MS",
+         .helpText = "The time (in milliseconds) after which the fork gc stops scanning the inverted "
+                     "indexes of a cycle, which it visits from the one with the most deleted "
+                     "documents. The next cycle has no budget. 0 disables it",
+         .setValue = setForkGcCycleBudget,
+         .getValue = getForkGcCycleBudget},
+        {.name = "_FORK_GC_APPLY_THREADS",
+         .helpText = "The number of threads on which the fork gc applies the repaired inverted "
+                     "indexes of a batch together, under a single hold of the index write lock. "
+                     "0 applies them on the gc thread",
+         .setValue = setForkGcApplyThreads,
+         .getValue = getForkGcApplyThreads},
         {.name = "FORK_GC_CLEAN_NUMERIC_EMPTY_NODES",
-         .helpText = "clean empty nodes from numeric tree",
+         .helpText = "clean empty nodes from numeric tree, and rebalance skewed trees",
          .setValue = setForkGCCleanNumericEmptyNodes,
          .getValue = getForkGCCleanNumericEmptyNodes,
          .flags = RSCONFIGVAR_F_FLAG},
         {.name = "_FORK_GC_CLEAN_NUMERIC_EMPTY_NODES",
-         .helpText = "clean empty nodes from numeric tree",
+         .helpText = "clean empty nodes from numeric tree, and rebalance skewed trees",
          .setValue = set_ForkGCCleanNumericEmptyNodes,
          .getValue = get_ForkGCCleanNumericEmptyNodes},
         {.name = "UNION_ITERATOR_HEAP",
@@ -1354,7 +2155,7 @@ RSConfigOptions RSGlobalConfigOptions = {
          .getValue = getUpgradeIndex,
          .flags = RSCONFIGVAR_F_IMMUTABLE},
         {.name = "_NUMERIC_COMPRESS",
-         .helpText = "Enable legacy compression of double to float.",
+         .helpText = "Enable legacy compression of double to float, and the packing of full numeric index blocks.",
          .setValue = setNumericCompress,
          .getValue = getNumericCompress},
         {.name = "_FREE_RESOURCE_ON_THREAD",
@@ -1430,6 +2231,290 @@ RSConfigOptions RSGlobalConfigOptions = {
          .helpText = "The number of operations to perform before yielding to Redis during indexing while loading",
          .setValue = setIndexerYieldEveryOps,
          .getValue = getIndexerYieldEveryOps},
+        {.name = "_INDEX_READER_PREFETCH_DISTANCE",
+         .helpText = "The number of entries before the end of an inverted index block at which readers prefetch "
+                     "the next block. 0 disables prefetching",
+         .setValue = setIndexReaderPrefetchDistance,
+         .getValue = getIndexReaderPrefetchDistance},
+        {.name = "_PARALLEL_QUERY_RANGES",
+         .helpText = "The number of doc-id ranges the root iterators of an aggregation are split into, to be "
+                     "read in parallel. 0 or 1 disables the parallel execution",
+         .setValue = setParallelQueryRanges,
+         .getValue = getParallelQueryRanges},
+        {.name = "_HEAVY_QUERY_COST",
+         .helpText = "The estimated cost (documents read, times the passes over the rows) from which a query "
+                     "running on the workers is heavy. 0 disables the admission control of heavy queries",
+         .setValue = setHeavyQueryCost,
+         .getValue = getHeavyQueryCost},
+        {.name = "_MAX_RUNNING_HEAVY_QUERIES",
+         .helpText = "The maximum number of heavy queries running on the workers at once",
+         .setValue = setMaxRunningHeavyQueries,
+         .getValue = getMaxRunningHeavyQueries},
+        {.name = "_MAX_WAITING_HEAVY_QUERIES",
+         .helpText = "The maximum number of heavy queries waiting for another to finish. Heavy queries are "
+                     "rejected past it",
+         .setValue = setMaxWaitingHeavyQueries,
+         .getValue = getMaxWaitingHeavyQueries},
+        {.name = "_EXPR_FUNCTION_MEMO_SIZE",
+         .helpText = "The number of recent results of date and string functions each APPLY or FILTER step keeps, "
+                     "to reuse for rows with the same arguments. 0 disables the memoization",
+         .setValue = setExprFunctionMemoSize,
+         .getValue = getExprFunctionMemoSize},
+        {.name = "_GROUPBY_PARTITIONS",
+         .helpText = "The maximum number of worker threads a GROUPBY step accumulates its results on. "
+                     "0 or 1 disables the parallel execution",
+         .setValue = setGroupByPartitions,
+         .getValue = getGroupByPartitions},
+        {.name = "_QUANTILE_COMPRESSION",
+         .helpText = "The compression of the t-digest the QUANTILE reducer estimates its quantiles with. "
+                     "0 uses a sample stream instead, which cannot be merged across shards",
+         .setValue = setQuantileCompression,
+         .getValue = getQuantileCompression},
+        {.name = "_REDUCER_MEMORY_BUDGET",
+         .helpText = "The memory, in kilobytes, each COUNT_DISTINCT and TOLIST reducer of a query may use "
+                     "for all its groups. Over it, COUNT_DISTINCT estimates its counts and TOLIST stops "
+                     "adding values. 0 means unlimited",
+         .setValue = setReducerMemoryBudget,
+         .getValue = getReducerMemoryBudget},
+        {.name = "_NUMERIC_BITMAP_UNION_RANGES",
+         .helpText = "The number of ranges a numeric filter of a query selects from which their documents "
+                     "are read into a bitmap at once, rather than merged by a union iterator. 0 disables it",
+         .setValue = setNumericBitmapUnionRanges,
+         .getValue = getNumericBitmapUnionRanges},
+        {.name = "_NUMERIC_MERGE_UNION_RANGES",
+         .helpText = "The number of ranges a numeric filter of a query selects from which the batches of "
+                     "their documents are merged, rather than their iterators advanced one document at "
+                     "a time. 0 disables it",
+         .setValue = setNumericMergeUnionRanges,
+         .getValue = getNumericMergeUnionRanges},
+        {.name = "_NUMERIC_HLL_PRECISION",
+         .helpText = "The number of bits of the register index of the HLL estimating the cardinality of "
+                     "the ranges of the numeric trees created from now on, between 4 and 12",
+         .setValue = setNumericHllPrecision,
+         .getValue = getNumericHllPrecision},
+        {.name = "_NUMERIC_EXACT_CARDINALITY",
+         .helpText = "The ranges of the numeric trees created from now on count their distinct values "
+                     "exactly while they have a few hundred of them, rather than estimating them with "
+                     "their HLL, so that they split at more accurate cardinalities",
+         .setValue = set_NumericExactCardinality,
+         .getValue = get_NumericExactCardinality},
+        {.name = "_SUFFIX_ARRAY",
+         .helpText = "The indexes created from now on keep the suffixes of the terms of their TEXT "
+                     "fields WITHSUFFIXTRIE in segmented suffix arrays rather than in a trie, which "
+                     "take a fraction of its memory",
+         .setValue = set_SuffixArray,
+         .getValue = get_SuffixArray},
+        {.name = "_TAG_COMPACT_THRESHOLD",
+         .helpText = "The number of values added to a tag field since its last compaction from which "
+                     "the GC moves all its values into a front-coded sorted dictionary, which takes "
+                     "less memory than the trie. 0 disables it",
+         .setValue = setTagCompactThreshold,
+         .getValue = getTagCompactThreshold},
+        {.name = "_TAG_SET_MIN_VALUES",
+         .helpText = "The number of values of a tag clause from which the documents of all its values are "
+                     "read at once into a cached list of ids, when the clause does not take part in the "
+                     "scores (weight 0 or under a negation). 0 disables it",
+         .setValue = setTagSetMinValues,
+         .getValue = getTagSetMinValues},
+        {.name = "_SHARD_WINDOW_TARGET_RECALL",
+         .helpText = "The percentage of the KNN queries of the coordinator whose top results should not "
+                     "miss any result of a shard. The number of results asked from the shards is then "
+                     "learned per index, from how many of them made it to the top results. 0 disables it",
+         .setValue = setShardWindowTargetRecall,
+         .getValue = getShardWindowTargetRecall},
+        {.name = "_COORD_RESULT_CACHE_TTL_MS",
+         .helpText = "How long, in milliseconds, the coordinator caches the rows the shards sent for an "
+                     "FT.AGGREGATE query, which an identical query then reads instead of asking the "
+                     "shards again. Entries are dropped earlier when the index changed. 0 disables it",
+         .setValue = setCoordResultCacheTTL,
+         .getValue = getCoordResultCacheTTL},
+        {.name = "_SCORE_THRESHOLD_MIN_RESULTS",
+         .helpText = "The number of top results (offset plus limit) of a distributed FT.SEARCH sorted by "
+                     "score from which the coordinator first asks the shards for the scores of a part of "
+                     "them, and then only for the results scoring at least as much as the last of the "
+                     "top results among those. 0 disables it",
+         .setValue = setScoreThresholdMinResults,
+         .getValue = getScoreThresholdMinResults},
+        {.name = "_HYBRID_FILTER_IDS_MAX",
+         .helpText = "The most results of the filter of a hybrid KNN query run in batches which are read "
+                     "once into a list of document ids, which the batches of vectors are then matched "
+                     "against instead of reading the filter again for each batch. Only applies when the "
+                     "query doesn't need the scores of the filter. 0 disables it",
+         .setValue = setHybridFilterIdsMax,
+         .getValue = getHybridFilterIdsMax},
+        {.name = "_KNN_RESULT_CACHE_ENTRIES",
+         .helpText = "The number of KNN queries without a filter whose results each index caches, "
+                     "keyed on their vector field, query vector, K and parameters, so that repeating "
+                     "one doesn't search the vector index again. The cache is dropped whenever the "
+                     "index changes. 0 disables it",
+         .setValue = setKnnResultCacheEntries,
+         .getValue = getKnnResultCacheEntries},
+        {.name = "_SEARCH_RESULT_CACHE_BYTES",
+         .helpText = "The memory each index may take to cache the results of its FT.SEARCH queries, "
+                     "keyed on their arguments, so that repeating one replies with the same rows "
+                     "without running it again. The least recently used results are evicted first, "
+                     "and all of them once the index changes. 0 disables it",
+         .setValue = setSearchResultCacheBytes,
+         .getValue = getSearchResultCacheBytes},
+        {.name = "_QUERY_PLAN_CACHE_ENTRIES",
+         .helpText = "The number of parsed query strings each index caches, keyed on the string and "
+                     "its dialect, so that a query sent again with other PARAMS values binds them "
+                     "to a copy of the cached tree instead of parsing it again. 0 disables it",
+         .setValue = setQueryPlanCacheEntries,
+         .getValue = getQueryPlanCacheEntries},
+        {.name = "_FILTER_CACHE_MIN_USES",
+         .helpText = "The number of times the TAG, NUMERIC and GEO filters intersected by a query "
+                     "must be evaluated before their documents are cached by the index as a list of "
+                     "ids, until it changes. Only queries that don't score their results use it. "
+                     "0 disables it",
+         .setValue = setFilterCacheMinUses,
+         .getValue = getFilterCacheMinUses},
+        {.name = "_SNIPPET_CACHE_BYTES",
+         .helpText = "The memory each index may take to cache the fields it highlighted or "
+                     "summarized, keyed on the document, the field, the matched terms and the "
+                     "HIGHLIGHT and SUMMARIZE options, so that a popular document returned again "
+                     "by the same query is not fragmented again. 0 disables it",
+         .setValue = setSnippetCacheBytes,
+         .getValue = getSnippetCacheBytes},
+        {.name = "_CURSOR_READ_AHEAD_BYTES",
+         .helpText = "With worker threads, the worker which replied to FT.CURSOR READ goes on to "
+                     "read the next chunk of the cursor, so that the next read is served from it. "
+                     "The rows read ahead of each cursor may take up to this memory. 0 disables it",
+         .setValue = setCursorReadAheadBytes,
+         .getValue = getCursorReadAheadBytes},
+        {.name = "_IMPACT_POSTINGS_MIN_DOCS",
+         .helpText = "A TEXT term in at least this number of documents keeps a second, truncated "
+                     "posting of the documents it weighs the most in, which the ranked FT.SEARCH "
+                     "queries with WITHOUTCOUNT read in place of its full inverted index. 0 "
+                     "disables it",
+         .setValue = setImpactPostingsMinDocs,
+         .getValue = getImpactPostingsMinDocs},
+        {.name = "_IMPACT_POSTINGS_SIZE",
+         .helpText = "The number of the top documents of a term kept in its truncated posting, "
+                     "see _IMPACT_POSTINGS_MIN_DOCS",
+         .setValue = setImpactPostingsSize,
+         .getValue = getImpactPostingsSize},
+        {.name = "_TERM_TIERING_IDLE_CYCLES",
+         .helpText = "The number of GC cycles of an index in memory during which a TEXT term is not "
+                     "read after which the blocks of its inverted index are moved to the disk "
+                     "database, until it is read or written again. Only when the disk database "
+                     "stores postings. 0 disables it",
+         .setValue = setTermTieringIdleCycles,
+         .getValue = getTermTieringIdleCycles},
+        {.name = "_SLOWLOG_THRESHOLD_MS",
+         .helpText = "The duration in milliseconds from which a query (or a chunk of a cursor) is "
+                     "recorded in FT.SLOWLOG, with its plan. While it is set, the iterators of the "
+                     "queries count their reads. 0 disables the slow log",
+         .setValue = setSlowlogThreshold,
+         .getValue = getSlowlogThreshold},
+        {.name = "_SLOWLOG_MAX_LEN",
+         .helpText = "The number of the most recent slow queries FT.SLOWLOG keeps",
+         .setValue = setSlowlogMaxLen,
+         .getValue = getSlowlogMaxLen},
+        {.name = "_PROFILE_SAMPLE_RATE",
+         .helpText = "Profile one in this number of queries, adding the time of their iterators and "
+                     "result processors to the totals of their types in INFO search. 0 disables it",
+         .setValue = setProfileSampleRate,
+         .getValue = getProfileSampleRate},
+        {.name = "_WORKERS_CPUS",
+         .helpText = "The CPUs the worker threads are pinned to, as a list of CPUs and CPU ranges "
+                     "(e.g. 0-3,8). Empty by default, leaving them unpinned",
+         .setValue = setWorkersCPUs,
+         .getValue = getWorkersCPUs,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "_IO_THREADS_CPUS",
+         .helpText = "The CPUs the coordinator IO threads are pinned to, as a list of CPUs and CPU "
+                     "ranges (e.g. 0-3,8). Empty by default, leaving them unpinned",
+         .setValue = setIOThreadsCPUs,
+         .getValue = getIOThreadsCPUs,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "_FORK_GC_CPUS",
+         .helpText = "The CPUs the fork GC child process is pinned to, as a list of CPUs and CPU "
+                     "ranges (e.g. 0-3,8). Empty by default, leaving it unpinned",
+         .setValue = setForkGCCPUs,
+         .getValue = getForkGCCPUs,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
+        {.name = "_BINARY_SHARD_ROWS",
+         .helpText = "The coordinator asks the shards to send the rows of FT.AGGREGATE in a compact "
+                     "columnar binary encoding rather than in RESP, which it decodes faster. To be "
+                     "disabled while some shards run a version which does not support it",
+         .setValue = set_BinaryShardRows,
+         .getValue = get_BinaryShardRows},
+        {.name = "_HEDGE_SHARD_REQUESTS",
+         .helpText = "The coordinator sends the FT.SEARCH request of a shard which is slower to reply "
+                     "than 95% of its recent requests to a replica of the shard as well, and takes "
+                     "the first reply. Only for the replicas which may serve reads",
+         .setValue = set_HedgeShardRequests,
+         .getValue = get_HedgeShardRequests},
+        {.name = "_SHARD_WINDOW_SECOND_ROUND",
+         .helpText = "When the shards were asked for a window of the K results of a KNN query and "
+                     "all those of a shard made it to the top K, the coordinator asks the shards "
+                     "for the full K, reading only the results closer than the K-th one found",
+         .setValue = set_ShardWindowSecondRound,
+         .getValue = get_ShardWindowSecondRound},
+        {.name = "_GEO_CELL_COVERING",
+         .helpText = "Geo radius queries read the geohash cells four times finer than the nine "
+                     "around the circle which it touches, and check the distance only of the "
+                     "documents of the cells it does not contain",
+         .setValue = set_GeoCellCovering,
+         .getValue = get_GeoCellCovering},
+        {.name = "_PERSIST_INDEXES",
+         .helpText = "The RDB holds the inverted indexes, numeric trees, tag indexes, terms and "
+                     "document table of the indexes over TEXT, TAG, NUMERIC and GEO fields of "
+                     "hashes, which are loaded as they are rather than by indexing the documents "
+                     "again. The RDB can only be loaded by a version which reads them",
+         .setValue = set_PersistIndexes,
+         .getValue = get_PersistIndexes},
+        {.name = "_INDEX_SEGMENTS",
+         .helpText = "With _PERSIST_INDEXES, a snapshot writes the blocks of the inverted indexes "
+                     "to a segment file next to the RDB, which is mapped read-only as the RDB is "
+                     "loaded, rather than to the RDB itself",
+         .setValue = set_IndexSegments,
+         .getValue = get_IndexSegments},
+        {.name = "_LAZY_INDEX_LOADING",
+         .helpText = "The documents of the indexes whose contents are not loaded from the RDB are "
+                     "not indexed as their keys are loaded. Each index is built by a background "
+                     "scan once it is first used, or once loading ends if it is one of _HOT_INDEXES",
+         .setValue = set_LazyIndexLoading,
+         .getValue = get_LazyIndexLoading},
+        {.name = "_PROFILE_HW_COUNTERS",
+         .helpText = "FT.PROFILE also reports the CPU cycles, instructions, last level cache misses "
+                     "and branch misses of each iterator and result processor, read from the "
+                     "hardware counters of the thread (Linux only). Reading them makes the profiled "
+                     "query much slower",
+         .setValue = set_ProfileHWCounters,
+         .getValue = get_ProfileHWCounters},
+        {.name = "_SPILL_IDLE_CURSORS",
+         .helpText = "A cursor whose rows are all held by a sorter or a group-by when it is paused "
+                     "keeps its remaining rows in a compact encoding, and releases the iterators "
+                     "and the processors below them until it is read again or expires",
+         .setValue = set_SpillIdleCursors,
+         .getValue = get_SpillIdleCursors},
+        {.name = "_SPELLCHECK_DELETE_INDEX",
+         .helpText = "FT.SPELLCHECK looks up the suggestions of a term within a distance of up to 2 "
+                     "in an index of the deletions of the index terms, built on its first use and "
+                     "kept along with them, rather than walking the trie of the terms. It takes "
+                     "memory in proportion to the square of the term lengths",
+         .setValue = set_SpellCheckDeleteIndex,
+         .getValue = get_SpellCheckDeleteIndex},
+        {.name = "_SKIP_UNCHANGED_DOCS",
+         .helpText = "A document written again with the same indexed contents, score, language, "
+                     "payload and expiration keeps its document ID and is not indexed again. Its "
+                     "terms are then not counted again, so the scores of its matches do not change",
+         .setValue = set_SkipUnchangedDocs,
+         .getValue = get_SkipUnchangedDocs},
+        {.name = "_INDEX_DELTA_REPLICATION",
+         .helpText = "A primary replicates the terms it found in the text fields of each written "
+                     "document, and a replica writes them to its index rather than tokenizing "
+                     "the fields again. It must be set alike on the primary and its replicas",
+         .setValue = set_IndexDeltaReplication,
+         .getValue = get_IndexDeltaReplication},
+        {.name = "_HOT_INDEXES",
+         .helpText = "With _LAZY_INDEX_LOADING, a comma separated list of the indexes which are "
+                     "built in this order once loading ends, rather than when first used",
+         .setValue = setHotIndexes,
+         .getValue = getHotIndexes,
+         .flags = RSCONFIGVAR_F_IMMUTABLE},
         {.name = "ON_OOM",
          .helpText = "Action to perform when search OOM is exceeded (choose RETURN, FAIL or IGNORE)",
          .setValue = setOnOom,
@@ -1564,384 +2649,672 @@ static void dumpConfigOption(const RSConfig *config, const RSConfigVar *var, Red
                              bool isHelp) {
   sds currValue = var->getValue(config);
 
-  if (!reply->resp3) {
-    RedisModule_Reply_Array(reply);
-  }
+  if (!reply->resp3) {
+    RedisModule_Reply_Array(reply);
+  }
+
+  RedisModule_Reply_SimpleString(reply, var->name);
+
+  if (isHelp) {
+    if (reply->resp3) {
+      RedisModule_Reply_Map(reply);
+    }
+
+    RedisModule_ReplyKV_SimpleString(reply, "Description", var->helpText);
+    RedisModule_Reply_SimpleString(reply, "Value");
+    if (currValue) {
+      RedisModule_Reply_StringBuffer(reply, currValue, sdslen(currValue));
+    } else {
+      RedisModule_Reply_Null(reply);
+    }
+
+    if (reply->resp3) {
+      RedisModule_Reply_MapEnd(reply);
+    }
+  } else {
+    if (currValue) {
+      RedisModule_Reply_StringBuffer(reply, currValue, sdslen(currValue));
+    } else {
+      RedisModule_Reply_Null(reply);
+    }
+  }
+
+  sdsfree(currValue);
+  if (!reply->resp3) {
+    RedisModule_Reply_ArrayEnd(reply);
+  }
+}
+
+void RSConfig_DumpProto(const RSConfig *config, const RSConfigOptions *options, const char *name,
+                        RedisModule_Reply *reply, bool isHelp) {
+  RedisModule_Reply_Map(reply);
+    if (!strcmp("*", name)) {
+      for (const RSConfigOptions *curOpts = options; curOpts; curOpts = curOpts->next) {
+        for (const RSConfigVar *cur = &curOpts->vars[0]; cur->name; cur++) {
+          dumpConfigOption(config, cur, reply, isHelp);
+        }
+      }
+    } else {
+      const RSConfigVar *v = findConfigVar(options, name);
+      if (v) {
+        dumpConfigOption(config, v, reply, isHelp);
+      }
+    }
+  RedisModule_Reply_MapEnd(reply);
+}
+
+int RSConfig_SetOption(RSConfig *config, RSConfigOptions *options, const char *name,
+                       RedisModuleString **argv, int argc, size_t *offset, QueryError *status) {
+  RSConfigVar *var = findConfigVar(options, name);
+  if (!var) {
+    QueryError_SetError(status, QUERY_ERROR_CODE_NO_OPTION, NULL);
+    return REDISMODULE_ERR;
+  }
+  if (var->flags & RSCONFIGVAR_F_IMMUTABLE) {
+    QueryError_SetError(status, QUERY_ERROR_CODE_INVAL, "Not modifiable at runtime");
+    return REDISMODULE_ERR;
+  }
+  ArgsCursor ac;
+  ArgsCursor_InitRString(&ac, argv + *offset, argc - *offset);
+  int rc = var->setValue(config, &ac, var->triggerId, status);
+  *offset += ac.offset;
+  return rc;
+}
+
+const char *TimeoutPolicy_ToString(RSTimeoutPolicy policy) {
+  // Assert policy is valid
+  RS_ASSERT(policy < TimeoutPolicy_Invalid);
+  return on_timeout_vals[policy];
+}
+
+RSTimeoutPolicy TimeoutPolicy_Parse(const char *s, size_t n) {
+  if (STR_EQCASE(s, n, on_timeout_vals[TimeoutPolicy_Return])) {
+    return TimeoutPolicy_Return;
+  } else if (STR_EQCASE(s, n, on_timeout_vals[TimeoutPolicy_Fail])) {
+    return TimeoutPolicy_Fail;
+  } else {
+    return TimeoutPolicy_Invalid;
+  }
+}
+
+const char *OomPolicy_ToString(RSOomPolicy policy) {
+  // Assert policy is valid
+  RS_ASSERT(policy < OomPolicy_Invalid);
+  return on_oom_vals[policy];
+}
+
+RSOomPolicy OomPolicy_Parse(const char *s, size_t n) {
+  if (STR_EQCASE(s, n, on_oom_vals[OomPolicy_Return])) {
+    return OomPolicy_Return;
+  } else if (STR_EQCASE(s, n, on_oom_vals[OomPolicy_Fail])) {
+    return OomPolicy_Fail;
+  } else if (STR_EQCASE(s, n, on_oom_vals[OomPolicy_Ignore])) {
+    return OomPolicy_Ignore;
+  } else {
+    return OomPolicy_Invalid;
+  }
+}
+
+void iteratorsConfig_init(IteratorsConfig *config) {
+  *config = RSGlobalConfig.iteratorsConfigParams;
+}
+
+
+int RegisterModuleConfig(RedisModuleCtx *ctx) {
+  // Numeric parameters
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-_numeric-ranges-parents", 0,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      NR_MAX_DEPTH_BALANCE, get_size_t_numeric_config,
+      set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.numericTreeMaxDepthRange)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-bg-index-sleep-gap", DEFAULT_BG_INDEX_SLEEP_GAP,
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 1,
+      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.numBGIndexingIterationsBeforeSleep)
+  )
+)
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-default-dialect", DEFAULT_DIALECT_VERSION,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      MIN_DIALECT_VERSION, MAX_DIALECT_VERSION,
+      get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.requestConfigParams.dialectVersion)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig (
+      ctx, "search-fork-gc-clean-threshold", DEFAULT_FORK_GC_CLEAN_THRESHOLD,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcCleanThreshold)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig (
+      ctx, "search-fork-gc-retry-interval", DEFAULT_FORK_GC_RETRY_INTERVAL,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcRetryInterval)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig (
+      ctx, "search-_fork-gc-cycle-budget-ms", DEFAULT_FORK_GC_CYCLE_BUDGET_MS,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcCycleBudgetMs)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig (
+      ctx, "search-_fork-gc-apply-threads", DEFAULT_FORK_GC_APPLY_THREADS,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_FORK_GC_APPLY_THREADS, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcApplyThreads)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-fork-gc-run-interval", DEFAULT_FORK_GC_RUN_INTERVAL,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcRunIntervalSec)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-fork-gc-sleep-before-exit", 0,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcSleepBeforeExit)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-gc-scan-size", DEFAULT_GC_SCANSIZE,
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.gcConfigParams.gcScanSize)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-index-cursor-limit", DEFAULT_INDEX_CURSOR_LIMIT,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.indexCursorLimit)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-max-aggregate-results", DEFAULT_MAX_AGGREGATE_REQUEST_RESULTS,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_AGGREGATE_REQUEST_RESULTS, get_size_t_numeric_config, set_size_t_numeric_config,
+      NULL, (void *)&(RSGlobalConfig.maxAggregateResults)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-max-prefix-expansions", DEFAULT_MAX_PREFIX_EXPANSIONS,
+      REDISMODULE_CONFIG_UNPREFIXED, 1, LLONG_MAX,
+      get_long_numeric_config, set_long_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.iteratorsConfigParams.maxPrefixExpansions)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-max-doctablesize", DEFAULT_DOC_TABLE_SIZE,
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 1,
+      MAX_DOC_TABLE_SIZE, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.maxDocTableSize)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-cursor-max-idle", DEFAULT_MAX_CURSOR_IDLE,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.cursorMaxIdle)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-max-search-results", DEFAULT_MAX_SEARCH_REQUEST_RESULTS,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_SEARCH_REQUEST_RESULTS, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.maxSearchResults)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-min-operation-workers", MIN_OPERATION_WORKERS,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      MAX_WORKER_THREADS, get_min_operation_workers,
+      set_min_operation_workers, NULL,
+      (void *)&(RSGlobalConfig.minOperationWorkers)
+    )
+  )
 
-  RedisModule_Reply_SimpleString(reply, var->name);
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-min-phonetic-term-len", DEFAULT_MIN_PHONETIC_TERM_LEN,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.minPhoneticTermLen)
+    )
+  )
 
-  if (isHelp) {
-    if (reply->resp3) {
-      RedisModule_Reply_Map(reply);
-    }
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-min-prefix", DEFAULT_MIN_TERM_PREFIX,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.iteratorsConfigParams.minTermPrefix)
+    )
+  )
 
-    RedisModule_ReplyKV_SimpleString(reply, "Description", var->helpText);
-    RedisModule_Reply_SimpleString(reply, "Value");
-    if (currValue) {
-      RedisModule_Reply_StringBuffer(reply, currValue, sdslen(currValue));
-    } else {
-      RedisModule_Reply_Null(reply);
-    }
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-min-stem-len", DEFAULT_MIN_STEM_LENGTH,
+      REDISMODULE_CONFIG_UNPREFIXED, 2,
+      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.iteratorsConfigParams.minStemLength)
+    )
+  )
 
-    if (reply->resp3) {
-      RedisModule_Reply_MapEnd(reply);
-    }
-  } else {
-    if (currValue) {
-      RedisModule_Reply_StringBuffer(reply, currValue, sdslen(currValue));
-    } else {
-      RedisModule_Reply_Null(reply);
-    }
-  }
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-multi-text-slop", DEFAULT_MULTI_TEXT_SLOP,
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 1,
+      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.multiTextOffsetDelta)
+    )
+  )
 
-  sdsfree(currValue);
-  if (!reply->resp3) {
-    RedisModule_Reply_ArrayEnd(reply);
-  }
-}
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-tiered-hnsw-buffer-limit", DEFAULT_BLOCK_SIZE,
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.tieredVecSimIndexBufferLimit)
+    )
+  )
 
-void RSConfig_DumpProto(const RSConfig *config, const RSConfigOptions *options, const char *name,
-                        RedisModule_Reply *reply, bool isHelp) {
-  RedisModule_Reply_Map(reply);
-    if (!strcmp("*", name)) {
-      for (const RSConfigOptions *curOpts = options; curOpts; curOpts = curOpts->next) {
-        for (const RSConfigVar *cur = &curOpts->vars[0]; cur->name; cur++) {
-          dumpConfigOption(config, cur, reply, isHelp);
-        }
-      }
-    } else {
-      const RSConfigVar *v = findConfigVar(options, name);
-      if (v) {
-        dumpConfigOption(config, v, reply, isHelp);
-      }
-    }
-  RedisModule_Reply_MapEnd(reply);
-}
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-timeout", DEFAULT_QUERY_TIMEOUT_MS,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.requestConfigParams.queryTimeoutMS)
+    )
+  )
 
-int RSConfig_SetOption(RSConfig *config, RSConfigOptions *options, const char *name,
-                       RedisModuleString **argv, int argc, size_t *offset, QueryError *status) {
-  RSConfigVar *var = findConfigVar(options, name);
-  if (!var) {
-    QueryError_SetError(status, QUERY_ERROR_CODE_NO_OPTION, NULL);
-    return REDISMODULE_ERR;
-  }
-  if (var->flags & RSCONFIGVAR_F_IMMUTABLE) {
-    QueryError_SetError(status, QUERY_ERROR_CODE_INVAL, "Not modifiable at runtime");
-    return REDISMODULE_ERR;
-  }
-  ArgsCursor ac;
-  ArgsCursor_InitRString(&ac, argv + *offset, argc - *offset);
-  int rc = var->setValue(config, &ac, var->triggerId, status);
-  *offset += ac.offset;
-  return rc;
-}
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-union-iterator-heap", DEFAULT_UNION_ITERATOR_HEAP,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.iteratorsConfigParams.minUnionIterHeap)
+    )
+  )
 
-const char *TimeoutPolicy_ToString(RSTimeoutPolicy policy) {
-  // Assert policy is valid
-  RS_ASSERT(policy < TimeoutPolicy_Invalid);
-  return on_timeout_vals[policy];
-}
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-vss-max-resize", DEFAULT_VSS_MAX_RESIZE,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.vssMaxResize)
+    )
+  )
 
-RSTimeoutPolicy TimeoutPolicy_Parse(const char *s, size_t n) {
-  if (STR_EQCASE(s, n, on_timeout_vals[TimeoutPolicy_Return])) {
-    return TimeoutPolicy_Return;
-  } else if (STR_EQCASE(s, n, on_timeout_vals[TimeoutPolicy_Fail])) {
-    return TimeoutPolicy_Fail;
-  } else {
-    return TimeoutPolicy_Invalid;
-  }
-}
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-workers", DEFAULT_WORKER_THREADS,
+      REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_WORKER_THREADS, get_workers, set_workers, NULL,
+      (void *)&RSGlobalConfig
+    )
+  )
 
-const char *OomPolicy_ToString(RSOomPolicy policy) {
-  // Assert policy is valid
-  RS_ASSERT(policy < OomPolicy_Invalid);
-  return on_oom_vals[policy];
-}
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-workers-priority-bias-threshold",
+      DEFAULT_HIGH_PRIORITY_BIAS_THRESHOLD,
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.highPriorityBiasNum)
+    )
+  )
 
-RSOomPolicy OomPolicy_Parse(const char *s, size_t n) {
-  if (STR_EQCASE(s, n, on_oom_vals[OomPolicy_Return])) {
-    return OomPolicy_Return;
-  } else if (STR_EQCASE(s, n, on_oom_vals[OomPolicy_Fail])) {
-    return OomPolicy_Fail;
-  } else if (STR_EQCASE(s, n, on_oom_vals[OomPolicy_Ignore])) {
-    return OomPolicy_Ignore;
-  } else {
-    return OomPolicy_Invalid;
-  }
-}
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-_bg-index-mem-pct-thr",
+      DEFAULT_INDEXING_MEMORY_LIMIT,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      100, get_uint8_numeric_config, set_uint8_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.indexingMemoryLimit)
+    )
+  )
 
-void iteratorsConfig_init(IteratorsConfig *config) {
-  *config = RSGlobalConfig.iteratorsConfigParams;
-}
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-bm25std-tanh-factor",
+      DEFAULT_BM25STD_TANH_FACTOR,
+      REDISMODULE_CONFIG_UNPREFIXED, BM25STD_TANH_FACTOR_MIN, BM25STD_TANH_FACTOR_MAX,
+      get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.requestConfigParams.BM25STD_TanhFactor)
+    )
+  )
 
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-_bg-index-oom-pause-time",
+      IsEnterprise() ? DEFAULT_BG_OOM_PAUSE_TIME_BEFOR_RETRY : 0,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.bgIndexingOomPauseTimeBeforeRetry)
+    )
+  )
 
-int RegisterModuleConfig(RedisModuleCtx *ctx) {
-  // Numeric parameters
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-_numeric-ranges-parents", 0,
-      REDISMODULE_CONFIG_UNPREFIXED, 0,
-      NR_MAX_DEPTH_BALANCE, get_size_t_numeric_config,
-      set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.numericTreeMaxDepthRange)
+      ctx, "search-indexer-yield-every-ops", DEFAULT_INDEXER_YIELD_EVERY_OPS,
+      REDISMODULE_CONFIG_UNPREFIXED, 1,
+      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.indexerYieldEveryOpsWhileLoading)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-bg-index-sleep-gap", DEFAULT_BG_INDEX_SLEEP_GAP,
-      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 1,
+      ctx, "search-_index-reader-prefetch-distance", DEFAULT_INDEX_READER_PREFETCH_DISTANCE,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
       UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.numBGIndexingIterationsBeforeSleep)
+      (void *)&(RSGlobalConfig.indexReaderPrefetchDistance)
+    )
   )
-)
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-default-dialect", DEFAULT_DIALECT_VERSION,
-      REDISMODULE_CONFIG_UNPREFIXED,
-      MIN_DIALECT_VERSION, MAX_DIALECT_VERSION,
-      get_uint_numeric_config, set_uint_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.requestConfigParams.dialectVersion)
+      ctx, "search-_parallel-query-ranges", DEFAULT_PARALLEL_QUERY_RANGES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_PARALLEL_QUERY_RANGES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.parallelQueryRanges)
     )
   )
 
   RM_TRY(
-    RedisModule_RegisterNumericConfig (
-      ctx, "search-fork-gc-clean-threshold", DEFAULT_FORK_GC_CLEAN_THRESHOLD,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcCleanThreshold)
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-_heavy-query-cost", DEFAULT_HEAVY_QUERY_COST,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.heavyQueryCost)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-_max-running-heavy-queries", DEFAULT_MAX_RUNNING_HEAVY_QUERIES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 1,
+      MAX_MAX_RUNNING_HEAVY_QUERIES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.maxRunningHeavyQueries)
     )
   )
 
   RM_TRY(
-    RedisModule_RegisterNumericConfig (
-      ctx, "search-fork-gc-retry-interval", DEFAULT_FORK_GC_RETRY_INTERVAL,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcRetryInterval)
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-_max-waiting-heavy-queries", DEFAULT_MAX_WAITING_HEAVY_QUERIES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.maxWaitingHeavyQueries)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-fork-gc-run-interval", DEFAULT_FORK_GC_RUN_INTERVAL,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcRunIntervalSec)
+      ctx, "search-_expr-function-memo-size", DEFAULT_EXPR_FUNCTION_MEMO_SIZE,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_EXPR_FUNCTION_MEMO_SIZE, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.exprFunctionMemoSize)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-fork-gc-sleep-before-exit", 0,
-      REDISMODULE_CONFIG_UNPREFIXED, 0,
-      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.gcConfigParams.forkGc.forkGcSleepBeforeExit)
+      ctx, "search-_groupby-partitions", DEFAULT_GROUPBY_PARTITIONS,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_GROUPBY_PARTITIONS, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.groupByPartitions)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-gc-scan-size", DEFAULT_GC_SCANSIZE,
-      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.gcConfigParams.gcScanSize)
+      ctx, "search-_quantile-compression", DEFAULT_QUANTILE_COMPRESSION,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_QUANTILE_COMPRESSION, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.quantileCompression)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-index-cursor-limit", DEFAULT_INDEX_CURSOR_LIMIT,
-      REDISMODULE_CONFIG_UNPREFIXED, 0,
-      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.indexCursorLimit)
+      ctx, "search-_reducer-memory-budget", DEFAULT_REDUCER_MEMORY_BUDGET,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_REDUCER_MEMORY_BUDGET, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.reducerMemoryBudget)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-max-aggregate-results", DEFAULT_MAX_AGGREGATE_REQUEST_RESULTS,
-      REDISMODULE_CONFIG_UNPREFIXED, 0,
-      MAX_AGGREGATE_REQUEST_RESULTS, get_size_t_numeric_config, set_size_t_numeric_config,
-      NULL, (void *)&(RSGlobalConfig.maxAggregateResults)
+      ctx, "search-_numeric-bitmap-union-ranges", DEFAULT_NUMERIC_BITMAP_UNION_RANGES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_NUMERIC_BITMAP_UNION_RANGES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.numericBitmapUnionRanges)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-max-prefix-expansions", DEFAULT_MAX_PREFIX_EXPANSIONS,
-      REDISMODULE_CONFIG_UNPREFIXED, 1, LLONG_MAX,
-      get_long_numeric_config, set_long_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.iteratorsConfigParams.maxPrefixExpansions)
+      ctx, "search-_numeric-merge-union-ranges", DEFAULT_NUMERIC_MERGE_UNION_RANGES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_NUMERIC_MERGE_UNION_RANGES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.numericMergeUnionRanges)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-max-doctablesize", DEFAULT_DOC_TABLE_SIZE,
-      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 1,
-      MAX_DOC_TABLE_SIZE, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.maxDocTableSize)
+      ctx, "search-_numeric-hll-precision", DEFAULT_NUMERIC_HLL_PRECISION,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, MIN_NUMERIC_HLL_PRECISION,
+      MAX_NUMERIC_HLL_PRECISION, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.numericHllPrecision)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-cursor-max-idle", DEFAULT_MAX_CURSOR_IDLE,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.cursorMaxIdle)
+      ctx, "search-_tag-compact-threshold", DEFAULT_TAG_COMPACT_THRESHOLD,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_TAG_COMPACT_THRESHOLD, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.tagCompactThreshold)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-max-search-results", DEFAULT_MAX_SEARCH_REQUEST_RESULTS,
-      REDISMODULE_CONFIG_UNPREFIXED, 0,
-      MAX_SEARCH_REQUEST_RESULTS, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.maxSearchResults)
+      ctx, "search-_tag-set-min-values", DEFAULT_TAG_SET_MIN_VALUES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_TAG_SET_MIN_VALUES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.tagSetMinValues)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-min-operation-workers", MIN_OPERATION_WORKERS,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      MAX_WORKER_THREADS, get_min_operation_workers,
-      set_min_operation_workers, NULL,
-      (void *)&(RSGlobalConfig.minOperationWorkers)
+      ctx, "search-_shard-window-target-recall", DEFAULT_SHARD_WINDOW_TARGET_RECALL,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_SHARD_WINDOW_TARGET_RECALL, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.shardWindowTargetRecall)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-min-phonetic-term-len", DEFAULT_MIN_PHONETIC_TERM_LEN,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.minPhoneticTermLen)
+      ctx, "search-_coord-result-cache-ttl-ms", DEFAULT_COORD_RESULT_CACHE_TTL_MS,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_COORD_RESULT_CACHE_TTL_MS, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.coordResultCacheTTL)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-min-prefix", DEFAULT_MIN_TERM_PREFIX,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.iteratorsConfigParams.minTermPrefix)
+      ctx, "search-_score-threshold-min-results", DEFAULT_SCORE_THRESHOLD_MIN_RESULTS,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_SCORE_THRESHOLD_MIN_RESULTS, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.scoreThresholdMinResults)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-min-stem-len", DEFAULT_MIN_STEM_LENGTH,
-      REDISMODULE_CONFIG_UNPREFIXED, 2,
-      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.iteratorsConfigParams.minStemLength)
+      ctx, "search-_hybrid-filter-ids-max", DEFAULT_HYBRID_FILTER_IDS_MAX,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_HYBRID_FILTER_IDS_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.hybridFilterIdsMax)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-multi-text-slop", DEFAULT_MULTI_TEXT_SLOP,
-      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 1,
-      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.multiTextOffsetDelta)
+      ctx, "search-_knn-result-cache-entries", DEFAULT_KNN_RESULT_CACHE_ENTRIES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_KNN_RESULT_CACHE_ENTRIES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.knnResultCacheEntries)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-tiered-hnsw-buffer-limit", DEFAULT_BLOCK_SIZE,
-      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 0,
-      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.tieredVecSimIndexBufferLimit)
+      ctx, "search-_search-result-cache-bytes", DEFAULT_SEARCH_RESULT_CACHE_BYTES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_SEARCH_RESULT_CACHE_BYTES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.searchResultCacheBytes)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-timeout", DEFAULT_QUERY_TIMEOUT_MS,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.requestConfigParams.queryTimeoutMS)
+      ctx, "search-_query-plan-cache-entries", DEFAULT_QUERY_PLAN_CACHE_ENTRIES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_QUERY_PLAN_CACHE_ENTRIES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.queryPlanCacheEntries)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-union-iterator-heap", DEFAULT_UNION_ITERATOR_HEAP,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      LLONG_MAX, get_long_numeric_config, set_long_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.iteratorsConfigParams.minUnionIterHeap)
+      ctx, "search-_filter-cache-min-uses", DEFAULT_FILTER_CACHE_MIN_USES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_FILTER_CACHE_MIN_USES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.filterCacheMinUses)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-vss-max-resize", DEFAULT_VSS_MAX_RESIZE,
-      REDISMODULE_CONFIG_UNPREFIXED, 0,
-      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.vssMaxResize)
+      ctx, "search-_snippet-cache-bytes", DEFAULT_SNIPPET_CACHE_BYTES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_SNIPPET_CACHE_BYTES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.snippetCacheBytes)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-workers", DEFAULT_WORKER_THREADS,
-      REDISMODULE_CONFIG_UNPREFIXED, 0,
-      MAX_WORKER_THREADS, get_workers, set_workers, NULL,
-      (void *)&RSGlobalConfig
+      ctx, "search-_cursor-read-ahead-bytes", DEFAULT_CURSOR_READ_AHEAD_BYTES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_CURSOR_READ_AHEAD_BYTES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.cursorReadAheadBytes)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-workers-priority-bias-threshold",
-      DEFAULT_HIGH_PRIORITY_BIAS_THRESHOLD,
-      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED, 0,
-      LLONG_MAX, get_size_t_numeric_config, set_size_t_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.highPriorityBiasNum)
+      ctx, "search-_impact-postings-min-docs", DEFAULT_IMPACT_POSTINGS_MIN_DOCS,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_IMPACT_POSTINGS_MIN_DOCS, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.impactPostingsMinDocs)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-_bg-index-mem-pct-thr",
-      DEFAULT_INDEXING_MEMORY_LIMIT,
-      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
-      100, get_uint8_numeric_config, set_uint8_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.indexingMemoryLimit)
+      ctx, "search-_impact-postings-size", DEFAULT_IMPACT_POSTINGS_SIZE,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 1,
+      MAX_IMPACT_POSTINGS_SIZE, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.impactPostingsSize)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-bm25std-tanh-factor",
-      DEFAULT_BM25STD_TANH_FACTOR,
-      REDISMODULE_CONFIG_UNPREFIXED, BM25STD_TANH_FACTOR_MIN, BM25STD_TANH_FACTOR_MAX,
-      get_uint_numeric_config, set_uint_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.requestConfigParams.BM25STD_TanhFactor)
+      ctx, "search-_term-tiering-idle-cycles", DEFAULT_TERM_TIERING_IDLE_CYCLES,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_TERM_TIERING_IDLE_CYCLES, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.termTieringIdleCycles)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-_bg-index-oom-pause-time",
-      IsEnterprise() ? DEFAULT_BG_OOM_PAUSE_TIME_BEFOR_RETRY : 0,
+      ctx, "search-_slowlog-threshold-ms", DEFAULT_SLOWLOG_THRESHOLD_MS,
       REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
-      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.bgIndexingOomPauseTimeBeforeRetry)
+      MAX_SLOWLOG_THRESHOLD_MS, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.slowlogThresholdMS)
     )
   )
 
   RM_TRY(
     RedisModule_RegisterNumericConfig(
-      ctx, "search-indexer-yield-every-ops", DEFAULT_INDEXER_YIELD_EVERY_OPS,
-      REDISMODULE_CONFIG_UNPREFIXED, 1,
-      UINT32_MAX, get_uint_numeric_config, set_uint_numeric_config, NULL,
-      (void *)&(RSGlobalConfig.indexerYieldEveryOpsWhileLoading)
+      ctx, "search-_slowlog-max-len", DEFAULT_SLOWLOG_MAX_LEN,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 1,
+      MAX_SLOWLOG_MAX_LEN, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.slowlogMaxLen)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterNumericConfig(
+      ctx, "search-_profile-sample-rate", DEFAULT_PROFILE_SAMPLE_RATE,
+      REDISMODULE_CONFIG_DEFAULT | REDISMODULE_CONFIG_UNPREFIXED, 0,
+      MAX_PROFILE_SAMPLE_RATE, get_uint_numeric_config, set_uint_numeric_config, NULL,
+      (void *)&(RSGlobalConfig.profileSampleRate)
     )
   )
 
@@ -1964,6 +3337,33 @@ int RegisterModuleConfig(RedisModuleCtx *ctx) {
     )
   )
 
+  RM_TRY(
+    RedisModule_RegisterStringConfig(
+      ctx, "search-_workers-cpus", "",
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED,
+      get_cpu_list_config, set_cpu_list_config, NULL,
+      (void *)&(RSGlobalConfig.workersCPUs)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterStringConfig(
+      ctx, "search-_io-threads-cpus", "",
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED,
+      get_cpu_list_config, set_cpu_list_config, NULL,
+      (void *)&(RSGlobalConfig.ioThreadsCPUs)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterStringConfig(
+      ctx, "search-_fork-gc-cpus", "",
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED,
+      get_cpu_list_config, set_cpu_list_config, NULL,
+      (void *)&(RSGlobalConfig.forkGCCPUs)
+    )
+  )
+
   RM_TRY(
     RedisModule_RegisterStringConfig(
       ctx, "search-default-scorer", DEFAULT_SCORER_NAME,
@@ -2031,6 +3431,141 @@ int RegisterModuleConfig(RedisModuleCtx *ctx) {
     )
   )
 
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_numeric-exact-cardinality", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.numericExactCardinality)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_binary-shard-rows", 1,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.binaryShardRows)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_hedge-shard-requests", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.hedgeShardRequests)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_shard-window-second-round", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.shardWindowSecondRound)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_geo-cell-covering", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.geoCellCovering)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_persist-indexes", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.persistIndexes)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_index-segments", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.indexSegments)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_lazy-index-loading", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.lazyIndexLoading)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_profile-hw-counters", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.profileHWCounters)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_spill-idle-cursors", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.spillIdleCursors)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_spellcheck-delete-index", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.spellCheckDeleteIndex)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_skip-unchanged-docs", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.skipUnchangedDocs)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_index-delta-replication", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.indexDeltaReplication)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterStringConfig(
+      ctx, "search-_hot-indexes", "",
+      REDISMODULE_CONFIG_IMMUTABLE | REDISMODULE_CONFIG_UNPREFIXED,
+      get_hot_indexes_config, set_immutable_string_config, NULL,
+      (void *)&(RSGlobalConfig.hotIndexes)
+    )
+  )
+
+  RM_TRY(
+    RedisModule_RegisterBoolConfig(
+      ctx, "search-_suffix-array", 0,
+      REDISMODULE_CONFIG_UNPREFIXED,
+      get_bool_config, set_bool_config, NULL,
+      (void *)&(RSGlobalConfig.suffixArray)
+    )
+  )
+
   RM_TRY(
     RedisModule_RegisterBoolConfig(
       ctx, "search-no-mem-pools", 0,
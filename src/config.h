@@ -49,7 +49,7 @@ static const char *on_oom_vals[3] = {
 };
 
 
-typedef enum { GCPolicy_Fork = 0 } GCPolicy;
+typedef enum { GCPolicy_Fork = 0, GCPolicy_Incremental = 1 } GCPolicy;
 
 const char *TimeoutPolicy_ToString(RSTimeoutPolicy);
 const char *OomPolicy_ToString(RSOomPolicy);
@@ -64,6 +64,8 @@ static inline const char *GCPolicy_ToString(GCPolicy policy) {
   switch (policy) {
     case GCPolicy_Fork:
       return "fork";
+    case GCPolicy_Incremental:
+      return "incremental";
     default:          // LCOV_EXCL_LINE cannot be reached
       return "huh?";  // LCOV_EXCL_LINE cannot be reached
   }
@@ -73,6 +75,10 @@ typedef struct {
   size_t forkGcCleanThreshold;
   size_t forkGcRetryInterval;
   size_t forkGcSleepBeforeExit;
+  // The time budget of the scan of a cycle in milliseconds, 0 for none
+  size_t forkGcCycleBudgetMs;
+  // The number of threads applying the repaired inverted indexes, 0 to apply them on the gc thread
+  size_t forkGcApplyThreads;
   int forkGCCleanNumericEmptyNodes;
 } forkGcConfig;
 
@@ -121,6 +127,11 @@ typedef struct {
   const char *extLoad;
   // Path to friso.ini for chinese dictionary file
   const char *frisoIni;
+  // The CPUs the worker threads, the coordinator IO threads and the fork GC child are pinned to,
+  // as lists of CPUs and CPU ranges ("0-3,8"). NULL or empty leaves them unpinned
+  const char *workersCPUs;
+  const char *ioThreadsCPUs;
+  const char *forkGCCPUs;
   // Default scorer name to use when no scorer is specified (default: BM25STD)
   const char *defaultScorer;
 
@@ -158,7 +169,7 @@ typedef struct {
 
   // free resource on shutdown
   bool freeResourcesThread;
-  // compress double to float
+  // compress double to float, and pack the full blocks of numeric indexes
   bool numericCompress;
   // keep numeric ranges in parents of leafs
   size_t numericTreeMaxDepthRange;
@@ -181,6 +192,118 @@ typedef struct {
   bool prioritizeIntersectUnionChildren;
     // The number of indexing operations per field to perform before yielding to Redis during indexing while loading (so redis can be responsive)
   unsigned int indexerYieldEveryOpsWhileLoading;
+  // The number of entries before the end of an inverted index block at which readers prefetch the
+  // next block. 0 disables prefetching
+  unsigned int indexReaderPrefetchDistance;
+  // The number of doc-id ranges the root iterators of an aggregation are split into, to be read in
+  // parallel. 0 or 1 disables the parallel execution
+  unsigned int parallelQueryRanges;
+  // The estimated cost from which a query running on the workers is heavy, and the number of heavy
+  // queries which may run at once and wait for them. 0 disables the admission control
+  unsigned int heavyQueryCost;
+  unsigned int maxRunningHeavyQueries;
+  unsigned int maxWaitingHeavyQueries;
+  // The number of recent results of memoizable functions each expression evaluator keeps. 0
+  // disables the memoization
+  unsigned int exprFunctionMemoSize;
+  // The maximum number of threads a GROUPBY step accumulates its results on. 0 or 1 disables the
+  // parallel execution
+  unsigned int groupByPartitions;
+  // The compression of the t-digest of the QUANTILE reducer. 0 uses a sample stream instead
+  unsigned int quantileCompression;
+  // The memory in KB each COUNT_DISTINCT and TOLIST reducer of a query may use before it
+  // approximates its results. 0 means unlimited
+  unsigned int reducerMemoryBudget;
+  // The number of ranges a numeric filter selects from which they are read into a bitmap rather
+  // than merged by a union iterator. 0 disables it
+  unsigned int numericBitmapUnionRanges;
+  // The number of ranges a numeric filter selects from which the batches of their documents are
+  // merged, rather than their iterators advanced one document at a time. 0 disables it
+  unsigned int numericMergeUnionRanges;
+  // The precision of the HLLs estimating the cardinality of the ranges of new numeric trees
+  unsigned int numericHllPrecision;
+  // Whether the ranges of new numeric trees count their few distinct values exactly
+  bool numericExactCardinality;
+  // Whether the suffixes of the TEXT fields of new indexes are kept in suffix arrays rather than a trie
+  bool suffixArray;
+  // Whether the coordinator asks the shards for the rows of FT.AGGREGATE in the binary encoding
+  bool binaryShardRows;
+  // Whether the coordinator also sends the FT.SEARCH requests of slow shards to their replicas
+  bool hedgeShardRequests;
+  // Whether the coordinator asks the shards again for the full K of a KNN query with a distance
+  // bound, when some shard may have had more results than the window it was asked for
+  bool shardWindowSecondRound;
+  // Whether geo radius queries read the finer cells which cover the circle, and check the distance
+  // only of the documents in the cells on its boundary
+  bool geoCellCovering;
+  // Whether the RDB holds the contents of the indexes, loaded instead of indexing the documents again
+  bool persistIndexes;
+  // Whether the persisted inverted indexes are written to a segment file, mapped as it is loaded
+  bool indexSegments;
+  // Whether the indexes not loaded with their contents are built when first used rather than as
+  // their keys are loaded
+  bool lazyIndexLoading;
+  // Whether FT.PROFILE reads the hardware counters of the iterators and the result processors
+  bool profileHWCounters;
+  // Whether a paused cursor replaces the processors holding its remaining rows by their encoding
+  bool spillIdleCursors;
+  // Whether FT.SPELLCHECK finds the suggestions of the index terms in a symmetric-delete index of
+  // them, rather than walking their trie
+  bool spellCheckDeleteIndex;
+  // Whether a document written again without any change to its indexed contents is not reindexed
+  bool skipUnchangedDocs;
+  // Whether the terms of the written documents are replicated, for the replicas not to tokenize them
+  bool indexDeltaReplication;
+  // The comma separated names of the indexes built as soon as loading ends, with lazyIndexLoading
+  const char *hotIndexes;
+  // The number of values added to a tag field since its last compaction from which the GC compacts
+  // it. 0 disables it
+  unsigned int tagCompactThreshold;
+  // The number of values of a tag clause from which they are read at once into a cached list of ids.
+  // 0 disables it
+  unsigned int tagSetMinValues;
+  // The percentage of the coordinator KNN queries whose top results should not miss a result of a
+  // shard, from which the per-shard K of the index is learned. 0 disables it
+  unsigned int shardWindowTargetRecall;
+  // How long the coordinator caches the shard rows of an FT.AGGREGATE query, in milliseconds.
+  // 0 disables it
+  unsigned int coordResultCacheTTL;
+  // The number of top results of a distributed search sorted by score from which the coordinator
+  // pushes a score threshold to the shards. 0 disables it
+  unsigned int scoreThresholdMinResults;
+  // The most results of the filter of a hybrid KNN query which are read once into a list of ids,
+  // rather than read again for each batch of vectors. 0 disables it
+  unsigned int hybridFilterIdsMax;
+  // The number of results of unfiltered KNN queries each vector field of an index caches, until
+  // the index changes. 0 disables it
+  unsigned int knnResultCacheEntries;
+  // The memory each index may take to cache the results of its FT.SEARCH queries, until it changes.
+  // 0 disables it
+  unsigned int searchResultCacheBytes;
+  // The number of parsed query strings each index caches. 0 disables it
+  unsigned int queryPlanCacheEntries;
+  // The number of uses after which the filters of a query are materialized. 0 disables it
+  unsigned int filterCacheMinUses;
+  // The memory each index may take to cache the highlighted and summarized fields of its
+  // documents. 0 disables it
+  unsigned int snippetCacheBytes;
+  // The memory the rows of the next chunk of a cursor, read ahead by a worker, may take. 0 disables
+  // reading ahead
+  unsigned int cursorReadAheadBytes;
+  // The number of documents from which a TEXT term keeps impact-ordered postings, read by ranked
+  // queries in place of its full inverted index, and the number of the top documents they keep.
+  // 0 disables them
+  unsigned int impactPostingsMinDocs;
+  unsigned int impactPostingsSize;
+  // The number of GC cycles without a read after which the blocks of a term of an index in memory
+  // are moved to the disk database. 0 disables it
+  unsigned int termTieringIdleCycles;
+  // The duration from which a query is recorded in the slow log, and the number of the queries it
+  // keeps. 0 disables it
+  unsigned int slowlogThresholdMS;
+  unsigned int slowlogMaxLen;
+  // One in this number of queries is profiled into the totals of INFO search. 0 disables it
+  unsigned int profileSampleRate;
   // Limit the number of cursors that can be created for a single index
   long long indexCursorLimit;
   // The maximum ratio between current memory and max memory for which background indexing is allowed
@@ -224,6 +347,10 @@ extern RSConfigOptions RSGlobalConfigOptions;
 extern RedisModuleString *config_ext_load;
 extern RedisModuleString *config_friso_ini;
 extern RedisModuleString *config_default_scorer;
+extern RedisModuleString *config_workers_cpus;
+extern RedisModuleString *config_io_threads_cpus;
+extern RedisModuleString *config_fork_gc_cpus;
+extern RedisModuleString *config_hot_indexes;
 
 /**
  * Add new configuration options to the chain of already recognized options
@@ -288,6 +415,9 @@ char *getRedisConfigValue(RedisModuleCtx *ctx, const char* confName);
 #define DEFAULT_FORK_GC_CLEAN_THRESHOLD 100
 #define DEFAULT_FORK_GC_RETRY_INTERVAL 5
 #define DEFAULT_FORK_GC_RUN_INTERVAL 30
+#define DEFAULT_FORK_GC_CYCLE_BUDGET_MS 0
+#define DEFAULT_FORK_GC_APPLY_THREADS 0
+#define MAX_FORK_GC_APPLY_THREADS 16
 #define DEFAULT_INDEX_CURSOR_LIMIT 128
 #define MAX_AGGREGATE_REQUEST_RESULTS (1ULL << 31)
 #define DEFAULT_MAX_AGGREGATE_REQUEST_RESULTS MAX_AGGREGATE_REQUEST_RESULTS
@@ -314,14 +444,77 @@ char *getRedisConfigValue(RedisModuleCtx *ctx, const char* confName);
 #define BM25STD_TANH_FACTOR_MIN 1
 #define DEFAULT_BG_OOM_PAUSE_TIME_BEFOR_RETRY 5
 #define DEFAULT_INDEXER_YIELD_EVERY_OPS 1000
+#define DEFAULT_INDEX_READER_PREFETCH_DISTANCE 16
+#define DEFAULT_PARALLEL_QUERY_RANGES 0
+#define MAX_PARALLEL_QUERY_RANGES 16
+#define DEFAULT_HEAVY_QUERY_COST 0
+#define DEFAULT_MAX_RUNNING_HEAVY_QUERIES 1
+#define MAX_MAX_RUNNING_HEAVY_QUERIES 1024
+#define DEFAULT_MAX_WAITING_HEAVY_QUERIES 256
+#define DEFAULT_EXPR_FUNCTION_MEMO_SIZE 0
+#define MAX_EXPR_FUNCTION_MEMO_SIZE 4096
+#define DEFAULT_GROUPBY_PARTITIONS 0
+#define MAX_GROUPBY_PARTITIONS 64
+#define DEFAULT_QUANTILE_COMPRESSION 0
+#define MAX_QUANTILE_COMPRESSION 1000
+#define DEFAULT_REDUCER_MEMORY_BUDGET 0
+#define MAX_REDUCER_MEMORY_BUDGET (1 << 20)
+#define DEFAULT_NUMERIC_BITMAP_UNION_RANGES 0
+#define MAX_NUMERIC_BITMAP_UNION_RANGES 65536
+#define DEFAULT_NUMERIC_MERGE_UNION_RANGES 0
+#define MAX_NUMERIC_MERGE_UNION_RANGES 65536
+#define DEFAULT_NUMERIC_HLL_PRECISION 6
+#define MIN_NUMERIC_HLL_PRECISION 4
+#define MAX_NUMERIC_HLL_PRECISION 12
+#define DEFAULT_TAG_COMPACT_THRESHOLD 0
+#define MAX_TAG_COMPACT_THRESHOLD (1 << 30)
+#define DEFAULT_TAG_SET_MIN_VALUES 0
+#define MAX_TAG_SET_MIN_VALUES 65536
+#define DEFAULT_SHARD_WINDOW_TARGET_RECALL 0
+#define MAX_SHARD_WINDOW_TARGET_RECALL 100
+#define DEFAULT_COORD_RESULT_CACHE_TTL_MS 0
+#define MAX_COORD_RESULT_CACHE_TTL_MS (60 * 60 * 1000)
+#define DEFAULT_SCORE_THRESHOLD_MIN_RESULTS 0
+#define MAX_SCORE_THRESHOLD_MIN_RESULTS (1 << 30)
+#define DEFAULT_HYBRID_FILTER_IDS_MAX 0
+#define MAX_HYBRID_FILTER_IDS_MAX (1 << 26)
+#define DEFAULT_KNN_RESULT_CACHE_ENTRIES 0
+#define MAX_KNN_RESULT_CACHE_ENTRIES 4096
+#define DEFAULT_SEARCH_RESULT_CACHE_BYTES 0
+#define MAX_SEARCH_RESULT_CACHE_BYTES (1 << 30)
+#define DEFAULT_QUERY_PLAN_CACHE_ENTRIES 0
+#define MAX_QUERY_PLAN_CACHE_ENTRIES 4096
+#define DEFAULT_FILTER_CACHE_MIN_USES 0
+#define MAX_FILTER_CACHE_MIN_USES 1024
+#define DEFAULT_SNIPPET_CACHE_BYTES 0
+#define MAX_SNIPPET_CACHE_BYTES (1 << 30)
+#define DEFAULT_CURSOR_READ_AHEAD_BYTES 0
+#define MAX_CURSOR_READ_AHEAD_BYTES (1 << 30)
+#define DEFAULT_IMPACT_POSTINGS_MIN_DOCS 0
+#define MAX_IMPACT_POSTINGS_MIN_DOCS (1 << 30)
+#define DEFAULT_IMPACT_POSTINGS_SIZE 1000
+#define MAX_IMPACT_POSTINGS_SIZE (1 << 20)
+#define DEFAULT_TERM_TIERING_IDLE_CYCLES 0
+#define MAX_TERM_TIERING_IDLE_CYCLES UINT16_MAX
+#define DEFAULT_SLOWLOG_THRESHOLD_MS 0
+#define MAX_SLOWLOG_THRESHOLD_MS (24 * 60 * 60 * 1000)
+#define DEFAULT_SLOWLOG_MAX_LEN 128
+#define MAX_SLOWLOG_MAX_LEN 65536
+#define DEFAULT_PROFILE_SAMPLE_RATE 0
+#define MAX_PROFILE_SAMPLE_RATE 1000000
 #define DEFAULT_SHARD_WINDOW_RATIO 1.0
 #define MIN_SHARD_WINDOW_RATIO 0.0  // Exclusive minimum (must be > 0.0)
 #define MAX_SHARD_WINDOW_RATIO 1.0
+#define DEFAULT_RERANK_FACTOR 1.0
+#define MAX_RERANK_FACTOR 100.0
 
 // default configuration
 #define RS_DEFAULT_CONFIG {                                                    \
     .extLoad = NULL,                                                           \
     .frisoIni = NULL,                                                          \
+    .workersCPUs = NULL,                                                       \
+    .ioThreadsCPUs = NULL,                                                     \
+    .forkGCCPUs = NULL,                                                        \
     .defaultScorer = NULL,                                                     \
     .gcConfigParams.enableGC = 1,                                              \
     .iteratorsConfigParams.minTermPrefix = DEFAULT_MIN_TERM_PREFIX,            \
@@ -343,6 +536,8 @@ char *getRedisConfigValue(RedisModuleCtx *ctx, const char* confName);
     .gcConfigParams.forkGc.forkGcSleepBeforeExit = 0,                          \
     .gcConfigParams.forkGc.forkGcRetryInterval = DEFAULT_FORK_GC_RETRY_INTERVAL,\
     .gcConfigParams.forkGc.forkGcCleanThreshold = DEFAULT_FORK_GC_CLEAN_THRESHOLD,\
+    .gcConfigParams.forkGc.forkGcCycleBudgetMs = DEFAULT_FORK_GC_CYCLE_BUDGET_MS,\
+    .gcConfigParams.forkGc.forkGcApplyThreads = DEFAULT_FORK_GC_APPLY_THREADS, \
     .noMemPool = 0,                                                            \
     .filterCommands = 0,                                                       \
     .maxSearchResults = DEFAULT_MAX_SEARCH_REQUEST_RESULTS,                    \
@@ -366,6 +561,51 @@ char *getRedisConfigValue(RedisModuleCtx *ctx, const char* confName);
     .requestConfigParams.BM25STD_TanhFactor = DEFAULT_BM25STD_TANH_FACTOR,     \
     .bgIndexingOomPauseTimeBeforeRetry = DEFAULT_BG_OOM_PAUSE_TIME_BEFOR_RETRY,    \
     .indexerYieldEveryOpsWhileLoading = DEFAULT_INDEXER_YIELD_EVERY_OPS,       \
+    .indexReaderPrefetchDistance = DEFAULT_INDEX_READER_PREFETCH_DISTANCE,     \
+    .parallelQueryRanges = DEFAULT_PARALLEL_QUERY_RANGES,                      \
+    .heavyQueryCost = DEFAULT_HEAVY_QUERY_COST,                                \
+    .maxRunningHeavyQueries = DEFAULT_MAX_RUNNING_HEAVY_QUERIES,               \
+    .maxWaitingHeavyQueries = DEFAULT_MAX_WAITING_HEAVY_QUERIES,               \
+    .exprFunctionMemoSize = DEFAULT_EXPR_FUNCTION_MEMO_SIZE,                   \
+    .groupByPartitions = DEFAULT_GROUPBY_PARTITIONS,                           \
+    .quantileCompression = DEFAULT_QUANTILE_COMPRESSION,                       \
+    .reducerMemoryBudget = DEFAULT_REDUCER_MEMORY_BUDGET,                      \
+    .numericBitmapUnionRanges = DEFAULT_NUMERIC_BITMAP_UNION_RANGES,           \
+    .numericMergeUnionRanges = DEFAULT_NUMERIC_MERGE_UNION_RANGES,             \
+    .numericHllPrecision = DEFAULT_NUMERIC_HLL_PRECISION,                      \
+    .numericExactCardinality = false,                                          \
+    .suffixArray = false,                                                      \
+    .binaryShardRows = true,                                                   \
+    .hedgeShardRequests = false,                                               \
+    .shardWindowSecondRound = false,                                           \
+    .geoCellCovering = false,                                                  \
+    .persistIndexes = false,                                                   \
+    .indexSegments = false,                                                    \
+    .lazyIndexLoading = false,                                                 \
+    .profileHWCounters = false,                                                \
+    .spillIdleCursors = false,                                                 \
+    .spellCheckDeleteIndex = false,                                            \
+    .skipUnchangedDocs = false,                                                \
+    .indexDeltaReplication = false,                                            \
+    .hotIndexes = NULL,                                                        \
+    .tagCompactThreshold = DEFAULT_TAG_COMPACT_THRESHOLD,                      \
+    .tagSetMinValues = DEFAULT_TAG_SET_MIN_VALUES,                             \
+    .shardWindowTargetRecall = DEFAULT_SHARD_WINDOW_TARGET_RECALL,             \
+    .coordResultCacheTTL = DEFAULT_COORD_RESULT_CACHE_TTL_MS,                  \
+    .scoreThresholdMinResults = DEFAULT_SCORE_THRESHOLD_MIN_RESULTS,           \
+    .hybridFilterIdsMax = DEFAULT_HYBRID_FILTER_IDS_MAX,                       \
+    .knnResultCacheEntries = DEFAULT_KNN_RESULT_CACHE_ENTRIES,                 \
+    .searchResultCacheBytes = DEFAULT_SEARCH_RESULT_CACHE_BYTES,               \
+    .queryPlanCacheEntries = DEFAULT_QUERY_PLAN_CACHE_ENTRIES,                 \
+    .filterCacheMinUses = DEFAULT_FILTER_CACHE_MIN_USES,                       \
+    .snippetCacheBytes = DEFAULT_SNIPPET_CACHE_BYTES,                          \
+    .cursorReadAheadBytes = DEFAULT_CURSOR_READ_AHEAD_BYTES,                   \
+    .impactPostingsMinDocs = DEFAULT_IMPACT_POSTINGS_MIN_DOCS,                 \
+    .impactPostingsSize = DEFAULT_IMPACT_POSTINGS_SIZE,                        \
+    .termTieringIdleCycles = DEFAULT_TERM_TIERING_IDLE_CYCLES,                 \
+    .slowlogThresholdMS = DEFAULT_SLOWLOG_THRESHOLD_MS,                        \
+    .slowlogMaxLen = DEFAULT_SLOWLOG_MAX_LEN,                                  \
+    .profileSampleRate = DEFAULT_PROFILE_SAMPLE_RATE,                          \
     .requestConfigParams.oomPolicy = OomPolicy_Ignore,                         \
   }
 
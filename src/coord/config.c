@@ -142,6 +142,41 @@ long long get_cursor_reply_threshold(const char *name, void *privdata) {
   return (long long)realConfig->cursorReplyThreshold;
 }
 
+// CURSOR_READ_AHEAD
+CONFIG_SETTER(setCursorReadAhead) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  size_t readAhead;
+  int acrc = AC_GetSize(ac, &readAhead, AC_F_GE1);
+  CHECK_RETURN_PARSE_ERROR(acrc);
+  if (readAhead > MAX_CURSOR_READ_AHEAD) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_LIMIT,
+      "CURSOR_READ_AHEAD must be between 1 and %d inclusive", MAX_CURSOR_READ_AHEAD);
+    return REDISMODULE_ERR;
+  }
+  realConfig->cursorReadAhead = readAhead;
+  return REDISMODULE_OK;
+}
+
+CONFIG_GETTER(getCursorReadAhead) {
+  SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
+  return sdsfromlonglong(realConfig->cursorReadAhead);
+}
+
+// search-cursor-read-ahead
+int set_cursor_read_ahead(const char *name, long long val, void *privdata,
+  RedisModuleString **err) {
+  RSConfig *config = (RSConfig *)privdata;
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  realConfig->cursorReadAhead = (size_t)val;
+  return REDISMODULE_OK;
+}
+
+long long get_cursor_read_ahead(const char *name, void *privdata) {
+  RSConfig *config = (RSConfig *)privdata;
+  SearchClusterConfig *realConfig = getOrCreateRealConfig(config);
+  return (long long)realConfig->cursorReadAhead;
+}
+
 // SEARCH_THREADS
 CONFIG_SETTER(setSearchThreads) {
   SearchClusterConfig *realConfig = getOrCreateRealConfig((RSConfig *)config);
@@ -252,6 +287,11 @@ static RSConfigOptions clusterOptions_g = {
              .helpText = "Maximum number of replies to accumulate before triggering `_FT.CURSOR READ` on the shards",
              .setValue = setCursorReplyThreshold,
              .getValue = getCursorReplyThreshold,},
+            {.name = "CURSOR_READ_AHEAD",
+             .helpText = "Number of replies of a shard cursor to read ahead of the client in cursor mode. "
+                         "Default to 1, which reads the shards when the previous replies are consumed",
+             .setValue = setCursorReadAhead,
+             .getValue = getCursorReadAhead,},
             {.name = "SEARCH_THREADS",
              .helpText = "Sets the number of search threads in the coordinator thread pool",
              .setValue = setSearchThreads,
@@ -346,6 +386,15 @@ int RegisterClusterModuleConfig(RedisModuleCtx *ctx) {
     )
   )
 
+  RM_TRY(
+    RedisModule_RegisterNumericConfig (
+      ctx, "search-cursor-read-ahead", DEFAULT_CURSOR_READ_AHEAD,
+      REDISMODULE_CONFIG_UNPREFIXED, 1, MAX_CURSOR_READ_AHEAD,
+      get_cursor_read_ahead, set_cursor_read_ahead, NULL,
+      (void*)&RSGlobalConfig
+    )
+  )
+
   RM_TRY(
     RedisModule_RegisterNumericConfig (
       ctx, "search-conn-per-shard", DEFAULT_CONN_PER_SHARD,
@@ -22,6 +22,7 @@ typedef struct {
   int timeoutMS;
   size_t connPerShard;
   size_t cursorReplyThreshold;
+  size_t cursorReadAhead; // replies of a shard cursor to read before the client asks for them
   size_t coordinatorPoolSize; // number of threads in the coordinator thread pool
   size_t coordinatorIOThreads; // number of I/O threads in the coordinator
   size_t topologyValidationTimeoutMS;
@@ -37,6 +38,8 @@ extern RedisModuleString *config_dummy_password;
 #define COORDINATOR_IO_THREADS_DEFAULT_SIZE 1
 #define DEFAULT_TOPOLOGY_VALIDATION_TIMEOUT 30000
 #define DEFAULT_CURSOR_REPLY_THRESHOLD 1
+#define DEFAULT_CURSOR_READ_AHEAD 1
+#define MAX_CURSOR_READ_AHEAD 1024
 #define DEFAULT_CONN_PER_SHARD 0
 
 #define DEFAULT_CLUSTER_CONFIG                                                 \
@@ -45,6 +48,7 @@ extern RedisModuleString *config_dummy_password;
     .type = DetectClusterType(),                                               \
     .timeoutMS = 0,                                                            \
     .cursorReplyThreshold = DEFAULT_CURSOR_REPLY_THRESHOLD,                    \
+    .cursorReadAhead = DEFAULT_CURSOR_READ_AHEAD,                              \
     .coordinatorPoolSize = COORDINATOR_POOL_DEFAULT_SIZE,                      \
     .coordinatorIOThreads = COORDINATOR_IO_THREADS_DEFAULT_SIZE,               \
     .topologyValidationTimeoutMS = DEFAULT_TOPOLOGY_VALIDATION_TIMEOUT,        \
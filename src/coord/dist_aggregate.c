@@ -11,6 +11,7 @@
 #include "rmutil/util.h"
 #include "commands.h"
 #include "aggregate/aggregate.h"
+#include "aggregate/arrow_export.h"
 #include "dist_plan.h"
 #include "module.h"
 #include "profile.h"
@@ -49,6 +50,10 @@ void processResultFormat(uint32_t *flags, MRReply *map) {
 
 static int rpnetNext_Start(ResultProcessor *rp, SearchResult *r) {
   RPNet *nc = (RPNet *)rp;
+  if (nc->useCache && RPNet_ReadFromCache(nc)) {
+    // The shards are not asked at all
+    return nc->base.Next(rp, r);
+  }
   MRIterator *it = MR_Iterate(&nc->cmd, netCursorCallback);
   if (!it) {
     return RS_RESULT_ERROR;
@@ -60,7 +65,8 @@ static int rpnetNext_Start(ResultProcessor *rp, SearchResult *r) {
 }
 
 static void buildMRCommand(RedisModuleString **argv, int argc, int profileArgs,
-                           AREQDIST_UpstreamInfo *us, MRCommand *xcmd, IndexSpec *sp, specialCaseCtx *knnCtx) {
+                           AREQDIST_UpstreamInfo *us, MRCommand *xcmd, IndexSpec *sp, specialCaseCtx *knnCtx,
+                           bool useCache) {
   // We need to prepend the array with the command, index, and query that
   // we want to use.
   const char **tmparr = array_new(const char *, array_len(us->serialized));
@@ -84,6 +90,14 @@ static void buildMRCommand(RedisModuleString **argv, int argc, int profileArgs,
   array_append(tmparr, "WITHCURSOR");
   // Numeric responses are encoded as simple strings.
   array_append(tmparr, "_NUM_SSTRING");
+  if (RSGlobalConfig.binaryShardRows) {
+    // The fields of the rows are sent in a binary encoding, decoded by RPNet
+    array_append(tmparr, "_BINARY_ROWS");
+  }
+  if (useCache) {
+    // The revisions of the shards' index tell when the cached rows are stale
+    array_append(tmparr, "_INDEX_REVISION");
+  }
 
   // Add the index prefixes to the command, for validation in the shard
   array_append(tmparr, "_INDEX_PREFIXES");
@@ -170,6 +184,14 @@ static void buildMRCommand(RedisModuleString **argv, int argc, int profileArgs,
     MRCommand_AppendRstr(xcmd, argv[bm25std_tanh_factor_index + 4 + profileArgs]);
   }
 
+  // The shards sample their own results, and scale up their partial COUNT and SUM values, which
+  // the coordinator then only adds up
+  int sample_index = RMUtil_ArgIndex("SAMPLE", argv + 3 + profileArgs, argc - 4 - profileArgs);
+  if (sample_index != -1) {
+    MRCommand_AppendRstr(xcmd, argv[sample_index + 3 + profileArgs]);
+    MRCommand_AppendRstr(xcmd, argv[sample_index + 4 + profileArgs]);
+  }
+
   MRCommand_SetPrefix(xcmd, "_FT");
 
   rm_free(n_prefixes);
@@ -196,6 +218,10 @@ static void buildDistRPChain(AREQ *r, MRCommand *xcmd, AREQDIST_UpstreamInfo *us
     if (!rp->upstream) {
       rp->upstream = IsProfile(r) ? rpProfile : &rpRoot->base;
       found = 1;
+      // Each reply of a shard carries the next of its rows, in the order the sorter wants them
+      if (rp->type == RP_SORTER && us->sortedRows && !IsProfile(r)) {
+        RPSorter_SetSortedRuns(rp, RPNet_SkipShard);
+      }
       break;
     }
   }
@@ -248,6 +274,15 @@ static int parseProfile(RedisModuleString **argv, int argc, AREQ *r) {
   return profileArgs;
 }
 
+/* Whether the rows the shards send for the query may be read from, and stored into, the result
+ * cache. The cursors are read in chunks, and the profile is of the shards' execution. On RESP2, the
+ * shards don't tell about their partial results unless timing out fails the query */
+static bool useResultCache(AREQ *r, RedisModuleCtx *ctx) {
+  return RSGlobalConfig.coordResultCacheTTL &&
+         !(AREQ_RequestFlags(r) & (QEXEC_F_IS_CURSOR | QEXEC_F_PROFILE | QEXEC_F_DEBUG)) &&
+         (is_resp3(ctx) || r->reqConfig.timeoutPolicy == TimeoutPolicy_Fail);
+}
+
 static int prepareForExecution(AREQ *r, RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
                          IndexSpec *sp, specialCaseCtx **knnCtx_ptr, QueryError *status) {
   AREQ_QueryProcessingCtx(r)->err = status;
@@ -290,7 +325,8 @@ static int prepareForExecution(AREQ *r, RedisModuleCtx *ctx, RedisModuleString *
 
   // Construct the command string
   MRCommand xcmd;
-  buildMRCommand(argv , argc, profileArgs, &us, &xcmd, sp, knnCtx);
+  const bool useCache = useResultCache(r, ctx);
+  buildMRCommand(argv , argc, profileArgs, &us, &xcmd, sp, knnCtx, useCache);
   xcmd.protocol = is_resp3(ctx) ? 3 : 2;
   xcmd.forCursor = AREQ_RequestFlags(r) & QEXEC_F_IS_CURSOR;
   xcmd.forProfiling = IsProfile(r);
@@ -298,6 +334,11 @@ static int prepareForExecution(AREQ *r, RedisModuleCtx *ctx, RedisModuleString *
 
   // Build the result processor chain
   buildDistRPChain(r, &xcmd, &us, rpnetNext_Start);
+  if (useCache) {
+    RPNet *rpnet = (RPNet *)AREQ_QueryProcessingCtx(r)->rootProc;
+    rpnet->useCache = true;
+    rpnet->localRevision = __atomic_load_n(&sp->revision, __ATOMIC_RELAXED);
+  }
 
   if (IsProfile(r)) r->profileParseTime = rs_wall_clock_elapsed_ns(&r->initClock);
 
@@ -363,6 +404,12 @@ void RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
   if (prepareForExecution(r, ctx, argv, argc, sp, &knnCtx, &status) != REDISMODULE_OK) {
     goto err;
   }
+  // The shards reply to FT.EXPORT as to FT.AGGREGATE, and the rows are exported here
+  if (RMUtil_StringEqualsCaseC(argv[0], "FT.EXPORT")) {
+    r->arrowExport = ArrowExportWriter_New();
+  }
+  // Stop reading from the shards (and delete their cursors) if the client disconnects
+  AREQ_SetCancelToken(r, ConcurrentCmdCtx_GetCancelToken(cmdCtx));
 
   if (executePlan(r, cmdCtx, reply, &status) != REDISMODULE_OK) {
     goto err;
@@ -411,6 +458,7 @@ void DEBUG_RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, in
   if (prepareForExecution(r, ctx, argv, argc - debug_argv_count, sp, &knnCtx, &status) != REDISMODULE_OK) {
     goto err;
   }
+  AREQ_SetCancelToken(r, ConcurrentCmdCtx_GetCancelToken(cmdCtx));
 
   // rpnet now owns the command
   MRCommand *cmd = &(((RPNet *)AREQ_QueryProcessingCtx(r)->rootProc)->cmd);
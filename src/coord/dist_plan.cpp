@@ -12,8 +12,10 @@
 #include "pipeline/pipeline_construction.h"
 #include "aggregate/reducer.h"
 #include "util/arr.h"
+#include "config.h"
 #include "dist_plan.h"
 
+#include <cstring>
 #include <vector>
 #include <string>
 #include <sstream>
@@ -244,12 +246,25 @@ static int distributeSingleArgSelf(ReducerDistCtx *rdctx, QueryError *status) {
 #define STRINGIFY__(a) #a
 #define RANDOM_SAMPLE_SIZE_STR STRINGIFY_(RANDOM_SAMPLE_SIZE)
 
-/* Distribute QUANTILE into remote RANDOM_SAMPLE and local QUANTILE */
+/* Distribute QUANTILE into the t-digests of each group when it is estimated with a t-digest, or
+ * into remote RANDOM_SAMPLE and local QUANTILE otherwise */
 static int distributeQuantile(ReducerDistCtx *rdctx, QueryError *status) {
   PLN_Reducer *src = rdctx->srcReducer;
   CHECK_ARG_COUNT(2);
   const char *alias = NULL;
 
+  if (RSGlobalConfig.quantileCompression) {
+    if (!rdctx->addRemote("__QUANTILE_STATE", &alias, status, "2", rdctx->srcarg(0),
+                          rdctx->srcarg(1))) {
+      return REDISMODULE_ERR;
+    }
+    if (!rdctx->addLocal("__QUANTILE_MERGE", status, "2", alias, rdctx->srcarg(1), "AS",
+                         src->alias)) {
+      return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+  }
+
   if (!rdctx->addRemote("RANDOM_SAMPLE", &alias, status, "2", rdctx->srcarg(0),
                         RANDOM_SAMPLE_SIZE_STR)) {
     return REDISMODULE_ERR;
@@ -262,21 +277,32 @@ static int distributeQuantile(ReducerDistCtx *rdctx, QueryError *status) {
   return REDISMODULE_OK;
 }
 
-/* Distribute STDDEV into remote RANDOM_SAMPLE and local STDDEV */
-static int distributeStdDev(ReducerDistCtx *rdctx, QueryError *status) {
+/* Distribute a single argument reducer into a remote reducer serializing the state of each group,
+ * and a local one merging these states (see Reducer::SerializeState) */
+static int distributeState(ReducerDistCtx *rdctx, const char *remoteName, const char *localName,
+                           QueryError *status) {
   PLN_Reducer *src = rdctx->srcReducer;
   const char *alias = NULL;
   CHECK_ARG_COUNT(1);
-  if (!rdctx->addRemote("RANDOM_SAMPLE", &alias, status, "2", rdctx->srcarg(0),
-                        RANDOM_SAMPLE_SIZE_STR)) {
+  if (!rdctx->addRemote(remoteName, &alias, status, "1", rdctx->srcarg(0))) {
     return REDISMODULE_ERR;
   }
-  if (!rdctx->addLocal("STDDEV", status, "1", alias, "AS", src->alias)) {
+  if (!rdctx->addLocal(localName, status, "1", alias, "AS", src->alias)) {
     return REDISMODULE_ERR;
   }
   return REDISMODULE_OK;
 }
 
+/* Distribute STDDEV into the partial count, mean and sum of squares of each group */
+static int distributeStdDev(ReducerDistCtx *rdctx, QueryError *status) {
+  return distributeState(rdctx, "__STDDEV_STATE", "__STDDEV_MERGE", status);
+}
+
+/* Distribute COUNT_DISTINCT into the hashes of the distinct values of each group */
+static int distributeCountDistinct(ReducerDistCtx *rdctx, QueryError *status) {
+  return distributeState(rdctx, "__COUNT_DISTINCT_STATE", "__COUNT_DISTINCT_MERGE", status);
+}
+
 /* Distribute COUNT_DISTINCTISH into HLL and MERGE_HLL */
 static int distributeCountDistinctish(ReducerDistCtx *rdctx, QueryError *status) {
   PLN_Reducer *src = rdctx->srcReducer;
@@ -345,6 +371,7 @@ static struct {
     {"AVG", distributeAvg},
     {"TOLIST", distributeSingleArgSelf},
     {"STDDEV", distributeStdDev},
+    {"COUNT_DISTINCT", distributeCountDistinct},
     {"COUNT_DISTINCTISH", distributeCountDistinctish},
     {"QUANTILE", distributeQuantile},
 
@@ -568,6 +595,29 @@ static void finalize_distribution(AGGPlan *local, AGGPlan *remote, PLN_Distribut
   AGPLN_Serialize(dstp->plan, &dstp->serialized);
 }
 
+// The rows of the shards come sorted by the keys of the first local step when it is an arrange
+// step which was distributed last, and none of its keys is loaded by the shards after sorting
+static bool shardsSortRows(const PLN_DistributeStep *dstp,
+                           const std::vector<const RLookupKey *> &loadFields) {
+  const PLN_BaseStep *last = PLN_PREV_STEP(PLN_END_STEP(dstp->plan));
+  if (last->type != PLN_T_ARRANGE) {
+    return false;
+  }
+  const PLN_ArrangeStep *astp = (const PLN_ArrangeStep *)last;
+  if (!astp->sortKeys || !array_len(astp->sortKeys)) {
+    return false;
+  }
+  for (auto kk : loadFields) {
+    for (size_t ii = 0; ii < array_len(astp->sortKeys); ++ii) {
+      if (strlen(astp->sortKeys[ii]) == kk->name_len &&
+          !strncmp(astp->sortKeys[ii], kk->name, kk->name_len)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 int AREQ_BuildDistributedPipeline(AREQ *r, AREQDIST_UpstreamInfo *us, QueryError *status) {
 
   auto dstp = (PLN_DistributeStep *)AGPLN_FindStep(AREQ_AGGPlan(r), NULL, NULL, PLN_T_DISTRIBUTE);
@@ -599,5 +649,6 @@ int AREQ_BuildDistributedPipeline(AREQ *r, AREQDIST_UpstreamInfo *us, QueryError
 
   us->lookup = &dstp->lk;
   us->serialized = dstp->serialized;
+  us->sortedRows = shardsSortRows(dstp, loadFields);
   return REDISMODULE_OK;
 }
@@ -32,6 +32,8 @@ typedef struct {
   arrayof(char*) serialized;
   // The lookup structure containing the fields that are to be received from upstream
   RLookup *lookup;
+  // Whether the shards send their rows sorted as the first local step sorts them
+  bool sortedRows;
 } AREQDIST_UpstreamInfo;
 
 /**
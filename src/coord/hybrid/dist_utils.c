@@ -43,8 +43,9 @@ void netCursorCallback(MRIteratorCallbackCtx *ctx, MRReply *rep) {
   if (cmd->protocol == 3) {
     // RESP3 reply structure:
     // [map, cursor] - map contains the results, cursor is the next cursor id
+    // [map, cursor, revision] - when the command asked for the revision of the index
     RS_ASSERT(MRReply_Type(rep) == MR_REPLY_ARRAY);
-    RS_ASSERT(MRReply_Length(rep) == 2);
+    RS_ASSERT(MRReply_Length(rep) == 2 || MRReply_Length(rep) == 3);
     RS_ASSERT(MRReply_Type(MRReply_ArrayElement(rep, 0)) == MR_REPLY_MAP);
     RS_ASSERT(MRReply_Type(MRReply_ArrayElement(rep, 1)) == MR_REPLY_INTEGER);
     MRReply *map = MRReply_ArrayElement(rep, 0);
@@ -90,8 +91,9 @@ void netCursorCallback(MRIteratorCallbackCtx *ctx, MRReply *rep) {
       }
     } else {
       // If the command is not for profiling, the reply should contain 2 elements:
-      // [results, cursor]
-      RS_ASSERT(MRReply_Length(rep) == 2);
+      // [results, cursor], or 3 when the command asked for the revision of the index:
+      // [results, cursor, revision]
+      RS_ASSERT(MRReply_Length(rep) == 2 || MRReply_Length(rep) == 3);
       RS_ASSERT(MRReply_Type(MRReply_ArrayElement(rep, 0)) == MR_REPLY_ARRAY);
       RS_ASSERT(MRReply_Type(MRReply_ArrayElement(rep, 1)) == MR_REPLY_INTEGER);
     }
@@ -103,18 +105,20 @@ void netCursorCallback(MRIteratorCallbackCtx *ctx, MRReply *rep) {
 
   // rewrite and resend the cursor command if needed
   // should only be determined based on the cursor and not on the set of results we get
-  if (!getCursorCommand(cursorId, cmd, MRIteratorCallback_GetCtx(ctx))) {
+  if (!getCursorCommand(cursorId, cmd, MRIteratorCallback_GetCtx(ctx),
+                        MRIteratorCallback_IsStopped(ctx))) {
     MRIteratorCallback_Done(ctx, 0);
   } else if (cmd->forCursor) {
-    MRIteratorCallback_ProcessDone(ctx);
+    MRIteratorCallback_CursorReplyDone(ctx);
   } else if (MRIteratorCallback_ResendCommand(ctx) == REDIS_ERR) {
     MRIteratorCallback_Done(ctx, 1);
   }
 }
 
-// Get cursor command using a cursor id and an existing aggregate command
+// Get cursor command using a cursor id and an existing aggregate command.
+// `stopped` is set when the reader needs no more results from this shard.
 // Returns true if the cursor is not done (i.e., not depleted)
-bool getCursorCommand(long long cursorId, MRCommand *cmd, MRIteratorCtx *ctx) {
+bool getCursorCommand(long long cursorId, MRCommand *cmd, MRIteratorCtx *ctx, bool stopped) {
   if (cursorId == CURSOR_EOF) {
     // Cursor was set to 0, end of reply chain. cmd->depleted will be set in `MRIteratorCallback_Done`.
     return false;
@@ -124,6 +128,9 @@ bool getCursorCommand(long long cursorId, MRCommand *cmd, MRIteratorCtx *ctx) {
 
   // Check if the coordinator experienced a timeout or not
   bool timedout = MRIteratorCallback_GetTimedOut(ctx);
+  // Not in cursor mode, the cursor is deleted instead of read when we timed out, or when the
+  // rest of its results are not needed (here we know it has more results)
+  bool del = (timedout || stopped) && !cmd->forCursor;
 
   if (cmd->rootCommand == C_AGG) {
     MRCommand newCmd;
@@ -131,9 +138,7 @@ bool getCursorCommand(long long cursorId, MRCommand *cmd, MRIteratorCtx *ctx) {
     sprintf(buf, "%lld", cursorId);
     // AGGREGATE commands has the index name at position 1
     const char *idx = MRCommand_ArgStringPtrLen(cmd, 1, NULL);
-    // If we timed out and not in cursor mode, we want to send the shard a DEL
-    // command instead of a READ command (here we know it has more results)
-    if (timedout && !cmd->forCursor) {
+    if (del) {
       newCmd = MR_NewCommand(4, "_FT.CURSOR", "DEL", idx, buf);
       // Mark that the last command was a DEL command
       newCmd.rootCommand = C_DEL;
@@ -157,9 +162,7 @@ bool getCursorCommand(long long cursorId, MRCommand *cmd, MRIteratorCtx *ctx) {
     RS_ASSERT(STR_EQ(cmd->strs[1], cmd->lens[1], "READ"));
     RS_ASSERT(atoll(cmd->strs[3]) == cursorId);
 
-    // If we timed out and not in cursor mode, we want to send the shard a DEL
-    // command instead of a READ command (here we know it has more results)
-    if (timedout && !cmd->forCursor) {
+    if (del) {
       MRCommand_ReplaceArg(cmd, 1, "DEL", 3);
       cmd->rootCommand = C_DEL;
     }
@@ -18,7 +18,7 @@ extern "C" {
 #endif
 
 void netCursorCallback(MRIteratorCallbackCtx *ctx, MRReply *rep);
-bool getCursorCommand(long long cursorId, MRCommand *cmd, MRIteratorCtx *ctx);
+bool getCursorCommand(long long cursorId, MRCommand *cmd, MRIteratorCtx *ctx, bool stopped);
 
 #ifdef __cplusplus
 }
@@ -10,6 +10,8 @@
 #include "resp3.h"
 #include "info/field_spec_info.h"
 #include "../src/reply_macros.h"
+#include "config.h"
+#include "result_cache.h"
 
 // Type of field returned in INFO
 typedef enum {
@@ -47,6 +49,7 @@ static InfoFieldSpec toplevelSpecs_g[] = {
     {.name = "offset_bits_per_record_avg", .type = InfoField_DoubleAverage},
     {.name = "indexing", .type = InfoField_WholeSum},
     {.name = "percent_indexed", .type = InfoField_DoubleAverage},
+    {.name = "cold", .type = InfoField_WholeSum},
     {.name = "hash_indexing_failures", .type = InfoField_WholeSum},
     {.name = "number_of_uses", .type = InfoField_Max},
     {.name = "cleaning", .type = InfoField_WholeSum}};
@@ -367,6 +370,11 @@ static void generateFieldsReply(InfoFields *fields, RedisModule_Reply *reply, bo
   replyKvArray(reply, fields, fields->cursorValues, cursorSpecs, NUM_CURSOR_FIELDS_SPEC);
   RedisModule_Reply_MapEnd(reply);
 
+  // The result cache is of the coordinator, its statistics are not merged from the shards
+  if (fields->indexName && RSGlobalConfig.coordResultCacheTTL) {
+    CoordResultCache_ReplyIndexStats(reply, fields->indexName, fields->indexNameLen);
+  }
+
   if (fields->stopWordList) {
     RedisModule_ReplyKV_MRReply(reply, "stopwords_list", fields->stopWordList);
   }
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "result_cache.h"
+#include "config.h"
+#include "rmalloc.h"
+#include "rs_wall_clock.h"
+#include "util/dict.h"
+#include "info/global_stats.h"
+#include <pthread.h>
+#include <string.h>
+
+struct CoordCachedResult {
+  sds key;
+  char *index;
+  uint64_t localRevision;
+  arrayof(uint64_t) revisions;  // The revision vector the rows were read at
+  arrayof(CoordCachedColumn) columns;
+  arrayof(CoordCachedRow) rows;
+  size_t totalResults;
+  size_t bytes;
+  rs_wall_clock_ns_t expires;
+  bool hasFormat;
+  bool formatExpand;
+  uint32_t refcount;  // One is held by the cache while the entry is in it
+  struct CoordCachedResult *prev, *next;  // In the order of insertion, for the eviction
+};
+
+typedef struct {
+  arrayof(uint64_t) revisions;  // The latest revision each shard sent, plus one. 0 if none yet
+  size_t hits;
+  size_t misses;
+  size_t entries;
+  size_t bytes;
+} IndexCacheState;
+
+static uint64_t sdsHashFunction(const void *key) {
+  return RS_dictGenHashFunction(key, sdslen((sds)key));
+}
+
+static int sdsKeyCompare(void *privdata, const void *key1, const void *key2) {
+  size_t l1 = sdslen((sds)key1), l2 = sdslen((sds)key2);
+  return l1 == l2 && !memcmp(key1, key2, l1);
+}
+
+// The entries own their keys
+static dictType entriesDictType = {
+  .hashFunction = sdsHashFunction,
+  .keyCompare = sdsKeyCompare,
+};
+
+static struct {
+  dict *entries;  // Key -> CoordCachedResult
+  dict *indexes;  // Index name -> IndexCacheState
+  CoordCachedResult *head, *tail;
+  size_t bytes;
+} cache_g;
+static pthread_mutex_t cacheLock_g = PTHREAD_MUTEX_INITIALIZER;
+
+sds CoordResultCache_Key(const MRCommand *cmd) {
+  sds key = sdscatlen(sdsempty(), &cmd->protocol, sizeof(cmd->protocol));
+  for (int i = 0; i < cmd->num; i++) {
+    uint32_t len = cmd->lens[i];
+    key = sdscatlen(key, &len, sizeof(len));
+    key = sdscatlen(key, cmd->strs[i], len);
+  }
+  return key;
+}
+
+static void freeRows(arrayof(CoordCachedRow) rows) {
+  for (size_t i = 0; i < array_len(rows); i++) {
+    for (uint32_t j = 0; j < rows[i].numValues; j++) {
+      if (rows[i].values[j]) {
+        RSValue_DecrRef(rows[i].values[j]);
+      }
+    }
+    rm_free(rows[i].values);
+  }
+  array_free(rows);
+}
+
+// Both revision vectors are complete, so that a shard which did not reply yet never matches
+static bool sameRevisions(arrayof(uint64_t) a, arrayof(uint64_t) b) {
+  return array_len(a) == array_len(b) && !memcmp(a, b, array_len(a) * sizeof(*a));
+}
+
+// The cache must be locked
+static IndexCacheState *indexState(const char *index) {
+  if (!cache_g.indexes) {
+    cache_g.indexes = dictCreate(&dictTypeHeapStrings, NULL);
+    cache_g.entries = dictCreate(&entriesDictType, NULL);
+  }
+  IndexCacheState *st = dictFetchValue(cache_g.indexes, index);
+  if (!st) {
+    st = rm_calloc(1, sizeof(*st));
+    st->revisions = array_new(uint64_t, 4);
+    dictAdd(cache_g.indexes, (void *)index, st);
+  }
+  return st;
+}
+
+static void setRevision(arrayof(uint64_t) *revisions, size_t shard, uint64_t revision) {
+  while (array_len(*revisions) <= shard) {
+    array_append(*revisions, 0);
+  }
+  (*revisions)[shard] = revision + 1;
+}
+
+void CoordResultCache_Release(CoordCachedResult *e) {
+  if (__atomic_sub_fetch(&e->refcount, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  freeRows(e->rows);
+  for (size_t i = 0; i < array_len(e->columns); i++) {
+    rm_free(e->columns[i].name);
+  }
+  array_free(e->columns);
+  array_free(e->revisions);
+  rm_free(e->index);
+  sdsfree(e->key);
+  rm_free(e);
+}
+
+// The cache must be locked
+static void removeEntry(CoordCachedResult *e) {
+  dictDelete(cache_g.entries, e->key);
+  if (e->prev) {
+    e->prev->next = e->next;
+  } else {
+    cache_g.head = e->next;
+  }
+  if (e->next) {
+    e->next->prev = e->prev;
+  } else {
+    cache_g.tail = e->prev;
+  }
+  cache_g.bytes -= e->bytes;
+  IndexCacheState *st = indexState(e->index);
+  st->entries--;
+  st->bytes -= e->bytes;
+  TotalGlobalStats_UpdateResultCacheBytes(-(ssize_t)e->bytes);
+  CoordResultCache_Release(e);
+}
+
+// The cache must be locked
+static bool isFresh(CoordCachedResult *e, IndexCacheState *st, uint64_t localRevision,
+                    rs_wall_clock_ns_t now) {
+  return now < e->expires && e->localRevision == localRevision &&
+         sameRevisions(e->revisions, st->revisions);
+}
+
+CoordCachedResult *CoordResultCache_Get(const char *index, const sds key, uint64_t localRevision) {
+  rs_wall_clock_ns_t now = rs_wall_clock_now_ns();
+  pthread_mutex_lock(&cacheLock_g);
+  IndexCacheState *st = indexState(index);
+  CoordCachedResult *e = dictFetchValue(cache_g.entries, key);
+  if (e && !isFresh(e, st, localRevision, now)) {
+    removeEntry(e);
+    e = NULL;
+  }
+  if (e) {
+    __atomic_add_fetch(&e->refcount, 1, __ATOMIC_RELAXED);
+    st->hits++;
+  } else {
+    st->misses++;
+  }
+  pthread_mutex_unlock(&cacheLock_g);
+  TotalGlobalStats_CountResultCacheLookup(e != NULL);
+  return e;
+}
+
+const CoordCachedRow *CoordCachedResult_Rows(const CoordCachedResult *e, size_t *numRows) {
+  *numRows = array_len(e->rows);
+  return e->rows;
+}
+
+const CoordCachedColumn *CoordCachedResult_Columns(const CoordCachedResult *e, size_t *numColumns) {
+  *numColumns = array_len(e->columns);
+  return e->columns;
+}
+
+size_t CoordCachedResult_TotalResults(const CoordCachedResult *e) {
+  return e->totalResults;
+}
+
+bool CoordCachedResult_Format(const CoordCachedResult *e, bool *expand) {
+  *expand = e->formatExpand;
+  return e->hasFormat;
+}
+
+void CoordResultCache_ObserveRevision(const char *index, size_t shard, uint64_t revision) {
+  pthread_mutex_lock(&cacheLock_g);
+  setRevision(&indexState(index)->revisions, shard, revision);
+  pthread_mutex_unlock(&cacheLock_g);
+}
+
+CoordResultRecorder *CoordResultRecorder_New(const char *index, sds key, uint64_t localRevision) {
+  CoordResultRecorder *rec = rm_calloc(1, sizeof(*rec));
+  rec->key = key;
+  rec->index = rm_strdup(index);
+  rec->localRevision = localRevision;
+  rec->keys = array_new(const RLookupKey *, 8);
+  rec->rows = array_new(CoordCachedRow, 16);
+  rec->revisions = array_new(uint64_t, 4);
+  return rec;
+}
+
+static uint32_t columnOf(CoordResultRecorder *rec, const RLookupKey *key) {
+  for (uint32_t i = 0; i < array_len(rec->keys); i++) {
+    if (rec->keys[i] == key) {
+      return i;
+    }
+  }
+  array_append(rec->keys, key);
+  return array_len(rec->keys) - 1;
+}
+
+bool CoordResultRecorder_AddRow(CoordResultRecorder *rec, const RLookup *lk, const RLookupRow *row) {
+  CoordCachedRow cr = {0};
+  size_t bytes = sizeof(cr);
+  for (const RLookupKey *k = lk->head; k; k = k->next) {
+    RSValue *v = RLookup_GetItem(k, row);
+    if (!v) {
+      continue;
+    }
+    uint32_t col = columnOf(rec, k);
+    if (col >= cr.numValues) {
+      cr.values = rm_realloc(cr.values, array_len(rec->keys) * sizeof(*cr.values));
+      memset(cr.values + cr.numValues, 0, (array_len(rec->keys) - cr.numValues) * sizeof(*cr.values));
+      cr.numValues = array_len(rec->keys);
+    }
+    cr.values[col] = RSValue_IncrRef(v);
+    bytes += sizeof(v) + RSValue_MemoryUsage(v);
+  }
+  array_append(rec->rows, cr);
+  rec->bytes += bytes;
+  return rec->bytes <= COORD_RESULT_CACHE_MAX_ENTRY_BYTES;
+}
+
+void CoordResultRecorder_AddRevision(CoordResultRecorder *rec, size_t shard, uint64_t revision) {
+  setRevision(&rec->revisions, shard, revision);
+}
+
+void CoordResultRecorder_Free(CoordResultRecorder *rec) {
+  freeRows(rec->rows);
+  array_free(rec->keys);
+  array_free(rec->revisions);
+  rm_free(rec->index);
+  sdsfree(rec->key);
+  rm_free(rec);
+}
+
+void CoordResultRecorder_Store(CoordResultRecorder *rec, size_t numShards) {
+  const unsigned int ttl = RSGlobalConfig.coordResultCacheTTL;
+  bool complete = ttl && array_len(rec->revisions) == numShards;
+  for (size_t i = 0; complete && i < numShards; i++) {
+    complete = rec->revisions[i] != 0;
+  }
+  if (!complete) {
+    CoordResultRecorder_Free(rec);
+    return;
+  }
+
+  CoordCachedResult *e = rm_calloc(1, sizeof(*e));
+  e->key = rec->key;
+  e->index = rec->index;
+  e->localRevision = rec->localRevision;
+  e->revisions = rec->revisions;
+  e->rows = rec->rows;
+  e->totalResults = rec->totalResults;
+  e->hasFormat = rec->hasFormat;
+  e->formatExpand = rec->formatExpand;
+  e->columns = array_new(CoordCachedColumn, array_len(rec->keys));
+  size_t bytes = sizeof(*e) + sdslen(e->key);
+  for (size_t i = 0; i < array_len(rec->keys); i++) {
+    const RLookupKey *k = rec->keys[i];
+    CoordCachedColumn col = {.name = rm_strndup(k->name, k->name_len), .len = k->name_len};
+    array_append(e->columns, col);
+    bytes += sizeof(col) + col.len;
+  }
+  e->bytes = rec->bytes + bytes;
+  e->refcount = 1;
+  e->expires = rs_wall_clock_now_ns() + (rs_wall_clock_ns_t)ttl * 1000000;
+  array_free(rec->keys);
+  rm_free(rec);
+
+  pthread_mutex_lock(&cacheLock_g);
+  IndexCacheState *st = indexState(e->index);
+  // The shards beyond the ones of this query are gone
+  if (array_len(st->revisions) > numShards) {
+    st->revisions = array_trimm_len(st->revisions, array_len(st->revisions) - numShards);
+  }
+  // Another query may have read newer revisions of some shards in the meantime
+  if (!sameRevisions(e->revisions, st->revisions)) {
+    pthread_mutex_unlock(&cacheLock_g);
+    CoordResultCache_Release(e);
+    return;
+  }
+
+  CoordCachedResult *old = dictFetchValue(cache_g.entries, e->key);
+  if (old) {
+    removeEntry(old);
+  }
+  // The entries expire in the order of insertion, as long as the TTL was not changed
+  rs_wall_clock_ns_t now = rs_wall_clock_now_ns();
+  while (cache_g.head &&
+         (cache_g.head->expires <= now || cache_g.bytes + e->bytes > COORD_RESULT_CACHE_MAX_BYTES)) {
+    removeEntry(cache_g.head);
+  }
+
+  dictAdd(cache_g.entries, e->key, e);
+  e->prev = cache_g.tail;
+  if (cache_g.tail) {
+    cache_g.tail->next = e;
+  } else {
+    cache_g.head = e;
+  }
+  cache_g.tail = e;
+  cache_g.bytes += e->bytes;
+  st->entries++;
+  st->bytes += e->bytes;
+  TotalGlobalStats_UpdateResultCacheBytes(e->bytes);
+  pthread_mutex_unlock(&cacheLock_g);
+}
+
+void CoordResultCache_ReplyIndexStats(RedisModule_Reply *reply, const char *index, size_t len) {
+  char *name = rm_strndup(index, len);
+  pthread_mutex_lock(&cacheLock_g);
+  IndexCacheState st = {0};
+  IndexCacheState *found = cache_g.indexes ? dictFetchValue(cache_g.indexes, name) : NULL;
+  if (found) {
+    st = *found;
+  }
+  pthread_mutex_unlock(&cacheLock_g);
+  rm_free(name);
+
+  RedisModule_ReplyKV_Map(reply, "result_cache_stats");
+  RedisModule_ReplyKV_LongLong(reply, "hits", st.hits);
+  RedisModule_ReplyKV_LongLong(reply, "misses", st.misses);
+  RedisModule_ReplyKV_LongLong(reply, "entries", st.entries);
+  RedisModule_ReplyKV_LongLong(reply, "bytes", st.bytes);
+  RedisModule_Reply_MapEnd(reply);
+}
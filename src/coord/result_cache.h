@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "rlookup.h"
+#include "value.h"
+#include "rmr/command.h"
+#include "reply.h"
+#include "util/arr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The coordinator result cache, enabled by _COORD_RESULT_CACHE_TTL_MS.
+ *
+ * It holds the rows the shards sent for an FT.AGGREGATE command, keyed on the command sent to the
+ * shards (the distributed part of the query, with its parameters), so that an identical query
+ * replays them to the coordinator steps instead of fanning out again.
+ *
+ * The shards send the revision of their index with their replies (`_INDEX_REVISION`). The latest
+ * revisions seen by the coordinator for each index form its revision vector, and an entry is only
+ * read while the vector is the one its rows were read at, and until its TTL expired. The revision
+ * of the local index is also checked on each lookup. */
+
+#define COORD_RESULT_CACHE_MAX_BYTES (64 << 20)
+// The entries whose rows take more than this are not cached
+#define COORD_RESULT_CACHE_MAX_ENTRY_BYTES (COORD_RESULT_CACHE_MAX_BYTES / 16)
+
+typedef struct CoordCachedResult CoordCachedResult;
+
+typedef struct {
+  char *name;
+  size_t len;
+} CoordCachedColumn;
+
+typedef struct {
+  RSValue **values;  // Indexed by column, NULL when the row has no value for it
+  uint32_t numValues;
+} CoordCachedRow;
+
+/* The rows of a query, recorded as they are read from the shards */
+typedef struct {
+  sds key;
+  char *index;
+  uint64_t localRevision;
+  arrayof(const RLookupKey *) keys;  // The key of each column
+  arrayof(CoordCachedRow) rows;
+  arrayof(uint64_t) revisions;       // Of the shards, plus one, 0 until the shard replied
+  size_t totalResults;
+  size_t bytes;
+  bool hasFormat;                    // Whether a shard reply set the format of the results
+  bool formatExpand;
+} CoordResultRecorder;
+
+/* The key of the command in the cache */
+sds CoordResultCache_Key(const MRCommand *cmd);
+
+/* Get the entry of the key, counting a hit or a miss. NULL if there's none, or if it is stale. The
+ * entry must be released with CoordResultCache_Release() */
+CoordCachedResult *CoordResultCache_Get(const char *index, const sds key, uint64_t localRevision);
+void CoordResultCache_Release(CoordCachedResult *e);
+
+/* The rows and results of the entry. The rows are read-only, as they are shared by the queries */
+const CoordCachedRow *CoordCachedResult_Rows(const CoordCachedResult *e, size_t *numRows);
+const CoordCachedColumn *CoordCachedResult_Columns(const CoordCachedResult *e, size_t *numColumns);
+size_t CoordCachedResult_TotalResults(const CoordCachedResult *e);
+/* Whether the shard replies set the format of the results, and to which */
+bool CoordCachedResult_Format(const CoordCachedResult *e, bool *expand);
+
+/* Record the revision a shard sent for the index with a reply, updating the revision vector of
+ * the index */
+void CoordResultCache_ObserveRevision(const char *index, size_t shard, uint64_t revision);
+
+/* Start recording the rows of a query. Takes ownership of `key` */
+CoordResultRecorder *CoordResultRecorder_New(const char *index, sds key, uint64_t localRevision);
+/* Record the values the lookup keys have in the row. Returns false when the rows grew too large
+ * for the cache, and the recorder should be freed */
+bool CoordResultRecorder_AddRow(CoordResultRecorder *rec, const RLookup *lk, const RLookupRow *row);
+/* Record the revision a shard sent with the rows */
+void CoordResultRecorder_AddRevision(CoordResultRecorder *rec, size_t shard, uint64_t revision);
+/* Done reading the replies of all the `numShards` shards. Moves the rows to the cache and frees
+ * the recorder */
+void CoordResultRecorder_Store(CoordResultRecorder *rec, size_t numShards);
+void CoordResultRecorder_Free(CoordResultRecorder *rec);
+
+/* Reply with the result cache statistics of the index, for FT.INFO */
+void CoordResultCache_ReplyIndexStats(RedisModule_Reply *reply, const char *index, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
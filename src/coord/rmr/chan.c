@@ -12,6 +12,7 @@
 
 typedef struct chanItem {
   void *ptr;
+  size_t tag;
   struct chanItem *next;
 } chanItem;
 
@@ -54,9 +55,14 @@ size_t MRChannel_Size(MRChannel *chan) {
 }
 
 void MRChannel_Push(MRChannel *chan, void *ptr) {
+  MRChannel_PushTagged(chan, ptr, 0);
+}
+
+void MRChannel_PushTagged(MRChannel *chan, void *ptr, size_t tag) {
   chanItem *item = rm_malloc(sizeof(*item));
   item->next = NULL;
   item->ptr = ptr;
+  item->tag = tag;
   pthread_mutex_lock(&chan->lock);
   if (chan->tail) {
     // make it the next of the current tail
@@ -87,6 +93,10 @@ void *MRChannel_UnsafeForcePop(MRChannel *chan) {
 }
 
 void *MRChannel_Pop(MRChannel *chan) {
+  return MRChannel_PopTagged(chan, NULL);
+}
+
+void *MRChannel_PopTagged(MRChannel *chan, size_t *tag) {
   pthread_mutex_lock(&chan->lock);
   while (!chan->size) {
     if (!chan->wait) {
@@ -105,6 +115,9 @@ void *MRChannel_Pop(MRChannel *chan) {
   pthread_mutex_unlock(&chan->lock);
   // discard the item (TODO: recycle items)
   void *ret = item->ptr;
+  if (tag) {
+    *tag = item->tag;
+  }
   rm_free(item);
   return ret;
 }
@@ -17,10 +17,16 @@ MRChannel *MR_NewChannel();
 // Push an item to the channel. Succeeds even if the channel is closed.
 void MRChannel_Push(MRChannel *chan, void *ptr);
 
+// Same as MRChannel_Push, attaching a tag to the item which is returned by MRChannel_PopTagged.
+void MRChannel_PushTagged(MRChannel *chan, void *ptr, size_t tag);
+
 /* Pop an item, or wait until there is an item to pop or until the channel is closed.
  * Return NULL if the channel is empty and MRChannel_Unblock was called by another thread */
 void *MRChannel_Pop(MRChannel *chan);
 
+// Same as MRChannel_Pop, also setting `*tag` to the tag of the popped item (0 if pushed untagged).
+void *MRChannel_PopTagged(MRChannel *chan, size_t *tag);
+
 // Same as MRChannel_Pop, but does not lock the channel nor wait for results if it's empty.
 // This is unsafe, and should only be used when the caller is sure that the channel is not being used by other threads.
 void *MRChannel_UnsafeForcePop(MRChannel *chan);
@@ -12,6 +12,10 @@
 
 #include <stdlib.h>
 #include "rq.h"
+#include "reply.h"
+#include "info/global_stats.h"
+#include <string.h>
+#include <sys/param.h>
 
 /* Initialize the MapReduce engine with a node provider */
 MRCluster *MR_NewCluster(MRClusterTopology *initialTopology, size_t conn_pool_size, size_t num_io_threads) {
@@ -73,6 +77,158 @@ int MRCluster_FanoutCommand(IORuntimeCtx *ioRuntime,
   return ret;
 }
 
+// A shard request is hedged once it waited for longer than this share of the recent replies of the
+// shard took
+#define HEDGE_PERCENTILE 0.95
+// The replies of a shard needed before its requests are hedged, and between two updates of the delay
+#define HEDGE_MIN_SAMPLES 16
+#define HEDGE_UPDATE_INTERVAL 8
+#define HEDGE_MIN_DELAY_US 1000
+
+static int cmpLatency(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void recordLatency(MRShardLatency *lat, uint64_t elapsedNS) {
+  uint64_t us = elapsedNS / 1000;
+  lat->samples[lat->count++ % MR_SHARD_LATENCY_SAMPLES] = us > UINT32_MAX ? UINT32_MAX : us;
+  if (lat->count < HEDGE_MIN_SAMPLES || lat->count % HEDGE_UPDATE_INTERVAL) {
+    return;
+  }
+  uint32_t n = MIN(lat->count, MR_SHARD_LATENCY_SAMPLES);
+  uint32_t sorted[MR_SHARD_LATENCY_SAMPLES];
+  memcpy(sorted, lat->samples, n * sizeof(*sorted));
+  qsort(sorted, n, sizeof(*sorted), cmpLatency);
+  lat->hedgeDelayUS = MAX(sorted[(uint32_t)((n - 1) * HEDGE_PERCENTILE)], HEDGE_MIN_DELAY_US);
+}
+
+static MRShardLatency *getShardLatency(IORuntimeCtx *ioRuntime, uint32_t shard) {
+  // The shards are told apart by their index, the latencies start over when their number changes
+  if (ioRuntime->numShardLatency != ioRuntime->topo->numShards) {
+    rm_free(ioRuntime->shardLatency);
+    ioRuntime->numShardLatency = ioRuntime->topo->numShards;
+    ioRuntime->shardLatency = rm_calloc(ioRuntime->numShardLatency, sizeof(MRShardLatency));
+  }
+  return &ioRuntime->shardLatency[shard];
+}
+
+/* The request of a fanout to a shard, which is also sent to a replica of the shard when it is not
+ * replied within the usual latency of the shard. The caller gets the first reply, the other one is
+ * dropped when it arrives */
+typedef struct {
+  IORuntimeCtx *ioRuntime;
+  MRCommand *cmd;
+  redisCallbackFn *fn;
+  void *privdata;
+  uint32_t shard;
+  char *nodeId;       // Of the master of the shard, which may change with the topology
+  uint64_t start;
+  uv_timer_t timer;
+  uint8_t pending;    // The requests sent and not replied yet
+  bool replied;       // Whether the caller got its reply
+  bool timerClosed;
+} MRHedgedRequest;
+
+static void hedgedRequest_MaybeFree(MRHedgedRequest *req) {
+  if (!req->pending && req->timerClosed) {
+    rm_free(req->nodeId);
+    rm_free(req);
+  }
+}
+
+static void hedgeTimerClosed(uv_handle_t *handle) {
+  MRHedgedRequest *req = handle->data;
+  req->timerClosed = true;
+  hedgedRequest_MaybeFree(req);
+}
+
+static void hedgedReply(MRHedgedRequest *req, redisAsyncContext *c, MRReply *r, bool fromReplica) {
+  req->pending--;
+  if (!fromReplica && r && req->shard < req->ioRuntime->topo->numShards &&
+      !strcmp(req->ioRuntime->topo->shards[req->shard].node.id, req->nodeId)) {
+    recordLatency(getShardLatency(req->ioRuntime, req->shard), uv_hrtime() - req->start);
+  }
+  if (req->replied) {
+    MRReply_Free(r);
+    hedgedRequest_MaybeFree(req);
+    return;
+  }
+  if (!r && req->pending) {
+    // The other request may still be replied
+    return;
+  }
+  req->replied = true;
+  if (fromReplica) {
+    TotalGlobalStats_CountHedgeWon();
+  }
+  // Stops the timer if it was not fired yet. The command may not be used anymore once replied
+  uv_close((uv_handle_t *)&req->timer, hedgeTimerClosed);
+  req->fn(c, r, req->privdata);
+}
+
+static void hedgedMasterCallback(redisAsyncContext *c, void *r, void *privdata) {
+  hedgedReply(privdata, c, r, false);
+}
+
+static void hedgedReplicaCallback(redisAsyncContext *c, void *r, void *privdata) {
+  hedgedReply(privdata, c, r, true);
+}
+
+static void hedgeTimerCB(uv_timer_t *timer) {
+  MRHedgedRequest *req = timer->data;
+  MRClusterTopology *topo = req->ioRuntime->topo;
+  // The shard index may stand for another shard since the topology changed
+  if (req->shard >= topo->numShards || strcmp(topo->shards[req->shard].node.id, req->nodeId) ||
+      !topo->shards[req->shard].replica.id) {
+    return;
+  }
+  MRConn *conn = MRConn_Get(&req->ioRuntime->conn_mgr, topo->shards[req->shard].replica.id);
+  if (conn && MRConn_SendReplicaCommand(conn, req->cmd, hedgedReplicaCallback, req) != REDIS_ERR) {
+    req->pending++;
+    TotalGlobalStats_CountHedgedRequest();
+  }
+}
+
+int MRCluster_HedgedFanoutCommand(IORuntimeCtx *ioRuntime,
+                                  MRCommand *cmd,
+                                  redisCallbackFn *fn,
+                                  void *privdata) {
+  struct MRClusterTopology *topo = ioRuntime->topo;
+  int ret = 0;
+  for (uint32_t i = 0; i < topo->numShards; i++) {
+    MRClusterShard *sh = &topo->shards[i];
+    MRConn *conn = MRConn_Get(&ioRuntime->conn_mgr, sh->node.id);
+    if (!conn) {
+      continue;
+    }
+    MRHedgedRequest *req = rm_new(MRHedgedRequest);
+    *req = (MRHedgedRequest){
+        .ioRuntime = ioRuntime,
+        .cmd = cmd,
+        .fn = fn,
+        .privdata = privdata,
+        .shard = i,
+        .nodeId = rm_strdup(sh->node.id),
+        .start = uv_hrtime(),
+        .pending = 1,
+    };
+    if (MRConn_SendCommand(conn, cmd, hedgedMasterCallback, req) == REDIS_ERR) {
+      rm_free(req->nodeId);
+      rm_free(req);
+      continue;
+    }
+    ret++;
+    uv_timer_init(&ioRuntime->uv_runtime.loop, &req->timer);
+    req->timer.data = req;
+    uint32_t delayUS = getShardLatency(ioRuntime, i)->hedgeDelayUS;
+    if (delayUS && sh->replica.id) {
+      uv_timer_start(&req->timer, hedgeTimerCB, (delayUS + 999) / 1000, 0);
+    }
+  }
+  return ret;
+}
+
 void MRCluster_Free(MRCluster *cl) {
   if (cl) {
     // First, fire the shutdown event for all runtimes
@@ -99,6 +255,21 @@ size_t MRCluster_AssignRoundRobinIORuntimeIdx(MRCluster *cl) {
   return idx;
 }
 
+size_t MRCluster_AssignIORuntimeIdx(MRCluster *cl) {
+  size_t start = MRCluster_AssignRoundRobinIORuntimeIdx(cl);
+  size_t best = start;
+  size_t bestLoad = IORuntimeCtx_Load(cl->io_runtimes_pool[start]);
+  for (size_t i = 1; i < cl->num_io_threads && bestLoad; i++) {
+    size_t idx = (start + i) % cl->num_io_threads;
+    size_t load = IORuntimeCtx_Load(cl->io_runtimes_pool[idx]);
+    if (load < bestLoad) {
+      best = idx;
+      bestLoad = load;
+    }
+  }
+  return best;
+}
+
 IORuntimeCtx *MRCluster_GetIORuntimeCtx(const MRCluster *cl, size_t idx) {
   RS_ASSERT(idx < cl->num_io_threads);
   return cl->io_runtimes_pool[idx];
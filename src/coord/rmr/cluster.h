@@ -35,6 +35,11 @@ typedef struct {
  * return value is the number of nodes we managed to successfully send the command to */
 int MRCluster_FanoutCommand(IORuntimeCtx *ioRuntime, MRCommand *cmd, redisCallbackFn *fn, void *privdata);
 
+/* Like MRCluster_FanoutCommand, but the request of a shard which takes longer to reply than most
+ * of its recent requests is sent to a replica of the shard as well, and `fn` gets the first of the
+ * two replies */
+int MRCluster_HedgedFanoutCommand(IORuntimeCtx *ioRuntime, MRCommand *cmd, redisCallbackFn *fn, void *privdata);
+
 /* Send a command to its appropriate shard, selecting a node based on the coordination strategy.
  * Returns REDIS_OK on success, REDIS_ERR on failure. Notice that that send is asynchronous so even
  * though we signal for success, the request may fail */
@@ -47,6 +52,10 @@ void MRCluster_Free(MRCluster *cl);
 
 size_t MRCluster_AssignRoundRobinIORuntimeIdx(MRCluster *cl);
 
+/* Pick the runtime of a new request: the least loaded one (see IORuntimeCtx_Load), looking from
+ * the next one in round robin order, so that the runtimes which are as loaded share the requests */
+size_t MRCluster_AssignIORuntimeIdx(MRCluster *cl);
+
 IORuntimeCtx *MRCluster_GetIORuntimeCtx(const MRCluster *cl, size_t idx);
 
 #ifdef __cplusplus
@@ -44,6 +44,10 @@ MRClusterTopology *MRClusterTopology_Clone(MRClusterTopology *t) {
     new_shard.node.id = rm_strdup(original_shard->node.id);
     MREndpoint_Copy(&new_shard.node.endpoint, &original_shard->node.endpoint);
     new_shard.node.endpoint.port = original_shard->node.endpoint.port;
+    if (original_shard->replica.id) {
+      new_shard.replica.id = rm_strdup(original_shard->replica.id);
+      MREndpoint_Copy(&new_shard.replica.endpoint, &original_shard->replica.endpoint);
+    }
 
     MRClusterTopology_AddShard(topo, &new_shard);
   }
@@ -58,6 +62,9 @@ void MRClusterNode_Free(MRClusterNode *n) {
 void MRClusterTopology_Free(MRClusterTopology *t) {
   for (int s = 0; s < t->numShards; s++) {
     MRClusterNode_Free(&t->shards[s].node);
+    if (t->shards[s].replica.id) {
+      MRClusterNode_Free(&t->shards[s].replica);
+    }
   }
   rm_free(t->shards);
   rm_free(t);
@@ -20,6 +20,9 @@ extern "C" {
 /* A "shard" represents a slot set of the cluster, with its associated node (we keep a single node per shard) */
 typedef struct {
   MRClusterNode node;
+  // An online replica of the shard, which its slow requests may be hedged to. Its id is NULL when
+  // the shard has none
+  MRClusterNode replica;
 } MRClusterShard;
 
 /* Create a new cluster shard to be added to a topology */
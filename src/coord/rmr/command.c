@@ -64,6 +64,7 @@ static void MRCommand_Init(MRCommand *cmd, size_t len) {
   cmd->depleted = false;
   cmd->forCursor = false;
   cmd->forProfiling = false;
+  cmd->hedgeable = false;
 }
 
 MRCommand MR_NewCommandArgv(int argc, const char **argv) {
@@ -85,6 +86,7 @@ MRCommand MRCommand_Copy(const MRCommand *cmd) {
   ret.forProfiling = cmd->forProfiling;
   ret.rootCommand = cmd->rootCommand;
   ret.depleted = cmd->depleted;
+  ret.hedgeable = cmd->hedgeable;
   ret.targetShard = cmd->targetShard;
   for (int i = 0; i < cmd->num; i++) {
     copyStr(&ret, i, cmd, i);
@@ -47,6 +47,10 @@ typedef struct {
   /* Whether the command chain is depleted - don't resend */
   bool depleted;
 
+  /* Whether the command is read only, so that the fanout may hedge it to the replicas of the
+   * shards which are slow to reply */
+  bool hedgeable;
+
   // Root command for current response
   MRRootCommand rootCommand;
 
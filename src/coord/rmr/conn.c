@@ -28,6 +28,10 @@ typedef struct MRConn{
   void *timer;
   int protocol; // 0 (undetermined), 2, or 3
   uv_loop_t *loop;
+  size_t inflight;     // Commands sent on the current context and not replied yet
+  size_t maxInflight;  // The most commands in flight at once
+  size_t sent;         // Commands sent since the connection was created
+  bool readonly;       // Whether the current context was sent READONLY, for reading from a replica
 } MRConn;
 
 
@@ -43,6 +47,13 @@ static int MRConn_SendAuth(MRConn *conn);
 
 #define RSCONN_RECONNECT_TIMEOUT 250
 #define RSCONN_REAUTH_TIMEOUT 1000
+// A pool gets another connection when the least busy of its connections has this many commands
+// in flight, up to MRCONN_POOL_MAX_GROWTH times the configured number
+#define MRCONN_POOL_GROW_INFLIGHT 32
+#define MRCONN_POOL_MAX_GROWTH 4
+// The connections a pool got this way are closed one at a time, once it was not that busy for
+// this long
+#define MRCONN_POOL_SHRINK_IDLE_MS 10000
 #define INTERNALAUTH_USERNAME "internal connection"
 #define UNUSED(x) (void)(x)
 
@@ -61,6 +72,9 @@ static redisAsyncContext *detachFromConn(MRConn *conn, bool shouldFree) {
   //Freeing the cbData, not the connection or the uvloop
   ac->data = NULL;
   conn->conn = NULL;
+  // The replies of the commands in flight on the old context are not counted anymore
+  conn->inflight = 0;
+  conn->readonly = false;
   if (shouldFree) {
     redisAsyncFree(ac);
     return NULL;
@@ -73,6 +87,7 @@ typedef struct {
   size_t num;
   size_t rr;  // round robin counter
   MRConn **conns;
+  uint64_t lastBusy;  // When the pool last had all its connections busy, in loop time
 } MRConnPool;
 
 static MRConnPool *_MR_NewConnPool(MREndpoint *ep, size_t num, uv_loop_t *loop) {
@@ -102,20 +117,50 @@ static void MRConnPool_Free(void *privdata, void *p) {
   rm_free(pool);
 }
 
-/* Get a connection from the connection pool. We select the next available connected connection with
- * a round robin selector */
-static MRConn *MRConnPool_Get(MRConnPool *pool) {
-
+/* Get a connection from the connection pool. We select the connected connection with the fewest
+ * commands in flight, the next one with a round robin selector among equally busy ones.
+ * `nodeConns` is the configured number of connections of the pool, which grows past it while all
+ * its connections are busy, and shrinks back once they are not */
+static MRConn *MRConnPool_Get(MRConnPool *pool, size_t nodeConns) {
+  MRConn *best = NULL;
+  size_t bestIdx = 0;
   for (size_t i = 0; i < pool->num; i++) {
-
-    MRConn *conn = pool->conns[pool->rr];
-    // increase the round-robin counter
-    pool->rr = (pool->rr + 1) % pool->num;
-    if (conn->state == MRConn_Connected) {
-      return conn;
+    size_t idx = (pool->rr + i) % pool->num;
+    MRConn *conn = pool->conns[idx];
+    if (conn->state == MRConn_Connected && (!best || conn->inflight < best->inflight)) {
+      best = conn;
+      bestIdx = idx;
+      if (!conn->inflight) {
+        break;
+      }
     }
   }
-  return NULL;
+  if (!best) {
+    return NULL;
+  }
+  // increase the round-robin counter
+  pool->rr = (bestIdx + 1) % pool->num;
+
+  MRConn *last = pool->conns[pool->num - 1];
+  uv_loop_t *loop = last->loop;
+  uint64_t now = uv_now(loop);
+  if (best->inflight >= MRCONN_POOL_GROW_INFLIGHT) {
+    pool->lastBusy = now;
+    // One connection at a time, once the previous one is connected
+    if (pool->num < nodeConns * MRCONN_POOL_MAX_GROWTH && last->state == MRConn_Connected) {
+      pool->conns = rm_realloc(pool->conns, (pool->num + 1) * sizeof(MRConn *));
+      pool->conns[pool->num] = MR_NewConn(&last->ep, loop);
+      MRConn_StartNewConnection(pool->conns[pool->num]);
+      pool->num++;
+    }
+  } else if (pool->num > nodeConns && last != best &&
+             now - pool->lastBusy >= MRCONN_POOL_SHRINK_IDLE_MS) {
+    MRConn_Stop(last);
+    pool->num--;
+    pool->rr %= pool->num;
+    pool->lastBusy = now;
+  }
+  return best;
 }
 
 static dictType nodeIdToConnPoolType = {
@@ -131,12 +176,14 @@ static dictType nodeIdToConnPoolType = {
 void MRConnManager_Init(MRConnManager *mgr, int nodeConns) {
   /* Create the connection map */
   mgr->map = dictCreate(&nodeIdToConnPoolType, NULL);
+  mgr->pending = dictCreate(&nodeIdToConnPoolType, NULL);
   mgr->nodeConns = nodeConns;
 }
 
 /* Free the entire connection manager */
 void MRConnManager_Free(MRConnManager *mgr) {
   dictRelease(mgr->map);
+  dictRelease(mgr->pending);
 }
 
 void MRConnManager_ReplyState(dict *stateDict, RedisModuleCtx *ctx) {
@@ -202,10 +249,13 @@ void MRConnManager_FillStateDict(MRConnManager *mgr, dict *stateDict) {
       newList[i] = rm_strdup(existingList[i]);
     }
 
-    // Add connection states from this pool
+    // Add connection states from this pool, with the commands they queue
     for (size_t i = 0; i < pool->num; i++) {
-      const char *stateStr = MRConnState_Str(pool->conns[i]->state);
-      newList[existingCount + i] = rm_strdup(stateStr);
+      const MRConn *conn = pool->conns[i];
+      char state[128];
+      snprintf(state, sizeof(state), "%s, in flight: %zu, max in flight: %zu, sent: %zu",
+               MRConnState_Str(conn->state), conn->inflight, conn->maxInflight, conn->sent);
+      newList[existingCount + i] = rm_strdup(state);
     }
 
     // NULL terminate the list
@@ -232,12 +282,30 @@ MRConn *MRConn_Get(MRConnManager *mgr, const char *id) {
   dictEntry *ptr = dictFind(mgr->map, id);
   if (ptr) {
     MRConnPool *pool = dictGetVal(ptr);
-    return MRConnPool_Get(pool);
+    return MRConnPool_Get(pool, mgr->nodeConns);
   }
   return NULL;
 }
 
-/* Send a command to the connection */
+// The callback of a command, wrapped to count it in flight on its connection until it is replied
+typedef struct {
+  redisCallbackFn *fn;
+  void *privdata;
+} MRConnCallback;
+
+static void MRConn_ReplyCallback(redisAsyncContext *c, void *r, void *privdata) {
+  MRConnCallback cb = *(MRConnCallback *)privdata;
+  rm_free(privdata);
+  // NULL once the connection is detached from the context
+  MRConn *conn = c->data;
+  if (conn && conn->inflight) {
+    conn->inflight--;
+  }
+  cb.fn(c, r, cb.privdata);
+}
+
+/* Send a command to the connection. Commands are pipelined: they are written right away, and
+ * their replies are matched to them in order */
 int MRConn_SendCommand(MRConn *c, MRCommand *cmd, redisCallbackFn *fn, void *privdata) {
 
   /* Only send to connected nodes */
@@ -254,7 +322,41 @@ int MRConn_SendCommand(MRConn *c, MRCommand *cmd, redisCallbackFn *fn, void *pri
     int rc = redisAsyncCommand(c->conn, NULL, NULL, "HELLO %d", cmd->protocol);
     c->protocol = cmd->protocol;
   }
-  return redisAsyncFormattedCommand(c->conn, fn, privdata, cmd->cmd, sdslen(cmd->cmd));
+  if (!fn) {
+    return redisAsyncFormattedCommand(c->conn, NULL, privdata, cmd->cmd, sdslen(cmd->cmd));
+  }
+  MRConnCallback *cb = rm_new(MRConnCallback);
+  *cb = (MRConnCallback){.fn = fn, .privdata = privdata};
+  if (redisAsyncFormattedCommand(c->conn, MRConn_ReplyCallback, cb, cmd->cmd, sdslen(cmd->cmd)) ==
+      REDIS_ERR) {
+    rm_free(cb);
+    return REDIS_ERR;
+  }
+  c->sent++;
+  c->inflight++;
+  c->maxInflight = MAX(c->maxInflight, c->inflight);
+  return REDIS_OK;
+}
+
+static void MRConn_FreeReplyCallback(redisAsyncContext *c, void *r, void *privdata) {
+  MRReply_Free(r);
+}
+
+int MRConn_SendReplicaCommand(MRConn *c, MRCommand *cmd, redisCallbackFn *fn, void *privdata) {
+  if (c->state == MRConn_Connected && !c->readonly) {
+    // In cluster mode, a replica redirects the commands on the keys of its shard to its master
+    // until asked to serve them
+    if (redisAsyncCommand(c->conn, MRConn_FreeReplyCallback, NULL, "READONLY") == REDIS_ERR) {
+      return REDIS_ERR;
+    }
+    c->readonly = true;
+  }
+  return MRConn_SendCommand(c, cmd, fn, privdata);
+}
+
+static bool MRConnPool_HasEndpoint(const MRConnPool *pool, const MREndpoint *ep) {
+  const MRConn *conn = pool->conns[0];
+  return !strcmp(conn->ep.host, ep->host) && conn->ep.port == ep->port;
 }
 
 /* Add a node to the connection manager. Return 1 if it's been added or 0 if it hasn't */
@@ -262,11 +364,8 @@ int MRConnManager_Add(MRConnManager *m, uv_loop_t *loop, const char *id, MREndpo
   /* First try to see if the connection is already in the manager */
   dictEntry *ptr = dictFind(m->map, id);
   if (ptr) {
-    MRConnPool *pool = dictGetVal(ptr);
-
-    MRConn *conn = pool->conns[0];
     // the node hasn't changed address, we don't need to do anything */
-    if (!strcmp(conn->ep.host, ep->host) && conn->ep.port == ep->port) {
+    if (MRConnPool_HasEndpoint(dictGetVal(ptr), ep)) {
       return 0;
     }
 
@@ -316,6 +415,56 @@ int MRConnManager_ConnectAll(MRConnManager *m) {
   return n;
 }
 
+void MRConnManager_Prepare(MRConnManager *m, uv_loop_t *loop, const char *id, MREndpoint *ep) {
+  dictEntry *ptr = dictFind(m->map, id);
+  if (ptr && MRConnPool_HasEndpoint(dictGetVal(ptr), ep)) {
+    // Kept as is by the new topology
+    dictDelete(m->pending, id);
+    return;
+  }
+  ptr = dictFind(m->pending, id);
+  if (ptr && MRConnPool_HasEndpoint(dictGetVal(ptr), ep)) {
+    return;
+  }
+
+  MRConnPool *pool = _MR_NewConnPool(ep, m->nodeConns, loop);
+  for (size_t i = 0; i < pool->num; i++) {
+    MRConn_StartNewConnection(pool->conns[i]);
+  }
+  dictReplace(m->pending, (void *)id, pool);
+}
+
+bool MRConnManager_PendingConnected(MRConnManager *m) {
+  bool connected = true;
+  dictIterator *it = dictGetIterator(m->pending);
+  dictEntry *entry;
+  while (connected && (entry = dictNext(it))) {
+    MRConnPool *pool = dictGetVal(entry);
+    connected = false;
+    for (size_t i = 0; i < pool->num && !connected; i++) {
+      connected = pool->conns[i]->state == MRConn_Connected;
+    }
+  }
+  dictReleaseIterator(it);
+  return connected;
+}
+
+void MRConnManager_CommitPending(MRConnManager *m) {
+  dictIterator *it = dictGetIterator(m->pending);
+  dictEntry *entry;
+  while ((entry = dictNext(it))) {
+    // Frees the pool the node had at its previous endpoint, if any
+    dictReplace(m->map, dictGetKey(entry), dictGetVal(entry));
+    dictSetVal(m->pending, entry, NULL);
+  }
+  dictReleaseIterator(it);
+  dictEmpty(m->pending, NULL);
+}
+
+void MRConnManager_ClearPending(MRConnManager *m) {
+  dictEmpty(m->pending, NULL);
+}
+
 /* Explicitly disconnect a connection and remove it from the connection pool */
 int MRConnManager_Disconnect(MRConnManager *m, const char *id) {
   if (dictDelete(m->map, id)) {
@@ -328,12 +477,13 @@ int MRConnManager_Disconnect(MRConnManager *m, const char *id) {
 // Shrink the connection pool to the given number of connections
 // Assumes that the number of connections is less than the current number of connections,
 // and that the new number of connections is greater than 0
-void MRConnManager_Shrink(MRConnManager *m, size_t num) {
-  dictIterator *it = dictGetIterator(m->map);
+static void shrinkPools(dict *pools, size_t num) {
+  dictIterator *it = dictGetIterator(pools);
   dictEntry *entry;
   while ((entry = dictNext(it))) {
     MRConnPool *pool = dictGetVal(entry);
 
+    // Including the connections the pool got while busy
     for (size_t i = num; i < pool->num; i++) {
       MRConn_Stop(pool->conns[i]);
     }
@@ -342,17 +492,26 @@ void MRConnManager_Shrink(MRConnManager *m, size_t num) {
     pool->rr %= num; // set the round robin counter to the new pool size bound
     pool->conns = rm_realloc(pool->conns, num * sizeof(MRConn *));
   }
-  m->nodeConns = num;
   dictReleaseIterator(it);
 }
 
+void MRConnManager_Shrink(MRConnManager *m, size_t num) {
+  shrinkPools(m->map, num);
+  shrinkPools(m->pending, num);
+  m->nodeConns = num;
+}
+
 // Expand the connection pool to the given number of connections
 // Assumes that the number of connections is greater than the current number of connections
-void MRConnManager_Expand(MRConnManager *m, size_t num, uv_loop_t *loop) {
-  dictIterator *it = dictGetIterator(m->map);
+static void expandPools(dict *pools, size_t num, uv_loop_t *loop) {
+  dictIterator *it = dictGetIterator(pools);
   dictEntry *entry;
   while ((entry = dictNext(it))) {
     MRConnPool *pool = dictGetVal(entry);
+    if (pool->num >= num) {
+      // The pool already grew while busy
+      continue;
+    }
 
     pool->conns = rm_realloc(pool->conns, num * sizeof(MRConn *));
     // Use the first connection's endpoint to create new connections
@@ -364,10 +523,15 @@ void MRConnManager_Expand(MRConnManager *m, size_t num, uv_loop_t *loop) {
     }
     pool->num = num;
   }
-  m->nodeConns = num;
   dictReleaseIterator(it);
 }
 
+void MRConnManager_Expand(MRConnManager *m, size_t num, uv_loop_t *loop) {
+  expandPools(m->map, num, loop);
+  expandPools(m->pending, num, loop);
+  m->nodeConns = num;
+}
+
 static void MRConn_Stop(MRConn *conn) {
   CONN_LOG(conn, "Requesting to stop");
   MRConn_SwitchState(conn, MRConn_Freeing);
@@ -16,6 +16,7 @@
 #include "command.h"
 #include "util/dict.h"
 #include <uv.h>
+#include <stdbool.h>
 
 /*
  * The state of the connection.
@@ -59,6 +60,9 @@ typedef struct MRConn MRConn;
 /* A pool indexes connections by the node id */
 typedef struct {
   dict *map;
+  // The pools connecting to the nodes of a topology which is not applied yet, by node id. They
+  // are moved to `map` once it is
+  dict *pending;
   int nodeConns;
 } MRConnManager;
 
@@ -83,6 +87,10 @@ MRConn *MRConn_Get(MRConnManager *mgr, const char *id);
 
 int MRConn_SendCommand(MRConn *c, MRCommand *cmd, redisCallbackFn *fn, void *privdata);
 
+/* Send a read only command to a connection to a replica, which is asked to serve the reads of its
+ * shard first */
+int MRConn_SendReplicaCommand(MRConn *c, MRCommand *cmd, redisCallbackFn *fn, void *privdata);
+
 /* Add a node to the connection manager */
 int MRConnManager_Add(MRConnManager *m, uv_loop_t *loop, const char *id, MREndpoint *ep, int connect);
 
@@ -92,6 +100,19 @@ int MRConnManager_ConnectAll(MRConnManager *m);
 /* Disconnect a node */
 int MRConnManager_Disconnect(MRConnManager *m, const char *id);
 
+/* Start connecting to a node of a topology which is not applied yet, unless the manager is already
+ * connected to it at the same endpoint. The connections of the current topology are not touched */
+void MRConnManager_Prepare(MRConnManager *m, uv_loop_t *loop, const char *id, MREndpoint *ep);
+
+/* Whether every node being prepared has a connected connection */
+bool MRConnManager_PendingConnected(MRConnManager *m);
+
+/* Move the prepared connections to the manager, replacing the ones of their nodes */
+void MRConnManager_CommitPending(MRConnManager *m);
+
+/* Drop the prepared connections */
+void MRConnManager_ClearPending(MRConnManager *m);
+
 /*
  * Set number of connections to each node to `num`, disconnect from extras.
  * Assumes that `num` is less than the current number of connections and non-zero
@@ -16,6 +16,7 @@
 #include "cluster.h"
 #include <rmutil/rm_assert.h>  // Include the assertion header
 #include "../config.h"
+#include "util/cpu_affinity.h"
 
 // Atomically exchange the pending topology with a new topology.
 // Returns the old pending topology (or NULL if there was no pending topology).
@@ -56,6 +57,27 @@ static void rqAsyncCb(uv_async_t *async) {
 
 extern RedisModuleCtx *RSDummyContext;
 
+// The upper bounds of the loop lag buckets but the last one, which counts the longer lags
+static const uint32_t loopLagBoundsMS[MR_LOOP_LAG_BUCKETS - 1] = {1, 2, 5, 10, 50, 100, 500};
+
+static void loopLagCB(uv_timer_t *timer) {
+  IORuntimeCtx *io_runtime_ctx = (IORuntimeCtx *)timer->data;
+  MRLoopLag *lag = &io_runtime_ctx->loopLag;
+  uint64_t now = uv_hrtime();
+  uint64_t lagUS = now > io_runtime_ctx->loopLagDue ? (now - io_runtime_ctx->loopLagDue) / 1000 : 0;
+  io_runtime_ctx->loopLagDue = now + MR_LOOP_LAG_INTERVAL_MS * 1000000ULL;
+
+  size_t b = 0;
+  while (b < MR_LOOP_LAG_BUCKETS - 1 && lagUS > loopLagBoundsMS[b] * 1000ULL) {
+    b++;
+  }
+  __atomic_add_fetch(&lag->buckets[b], 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&lag->lastUS, lagUS, __ATOMIC_RELAXED);
+  if (lagUS > lag->maxUS) {
+    __atomic_store_n(&lag->maxUS, lagUS, __ATOMIC_RELAXED);
+  }
+}
+
 static void topologyFailureCB(uv_timer_t *timer) {
   IORuntimeCtx *io_runtime_ctx = (IORuntimeCtx *)timer->data;
   RedisModule_Log(RSDummyContext, "warning", "IORuntime ID %zu: Topology validation failed: not all nodes connected", io_runtime_ctx->queue->id);
@@ -97,12 +119,19 @@ static void topologyAsyncCB(uv_async_t *async) {
   if (task) {
     // Apply new topology
     RedisModule_Log(RSDummyContext, "verbose", "IORuntime ID %zu: Applying new topology", io_runtime_ctx->queue->id);
-    // Mark the event loop thread as not ready. This will ensure that the next event on the event loop
-    // will be the topology check. If the topology hasn't changed, the topology check will quickly
-    // mark the event loop thread as ready again.
-    io_runtime_ctx->uv_runtime.loop_th_ready = false;
     task->cb(task->privdata);
     rm_free(task);
+    if (io_runtime_ctx->topo && CheckTopologyConnections(io_runtime_ctx->topo, io_runtime_ctx) == REDIS_OK) {
+      // The connections to the nodes of the topology were kept, or the requests are still sent to
+      // the nodes of the previous topology while the new nodes are connected to
+      uv_timer_stop(&io_runtime_ctx->uv_runtime.topologyValidationTimer);
+      uv_timer_stop(&io_runtime_ctx->uv_runtime.topologyFailureTimer);
+      io_runtime_ctx->uv_runtime.loop_th_ready = true;
+      triggerPendingItems(io_runtime_ctx);
+      return;
+    }
+    // Mark the event loop thread as not ready, so that the requests wait for the topology check
+    io_runtime_ctx->uv_runtime.loop_th_ready = false;
     // Finish this round of topology checks to give the topology connections a chance to connect.
     // Schedule connectivity check immediately with a 1ms repeat interval
     uv_timer_start(&io_runtime_ctx->uv_runtime.topologyValidationTimer, topologyTimerCB, 0, 1);
@@ -145,9 +174,15 @@ static void sideThread(void *arg) {
   RedisModule_Log(RSDummyContext, "verbose",
       "sideThread(): pthread_setname_np is not supported on this system");
 #endif
+  if (!CPUList_PinCurrentThread(RSGlobalConfig.ioThreadsCPUs)) {
+    RedisModule_Log(RSDummyContext, "warning", "IORuntime ID %zu: Could not pin the thread to CPUs %s",
+                    io_runtime_ctx->queue->id, RSGlobalConfig.ioThreadsCPUs);
+  }
   // loop is initialized and handles are ready
   //io_runtime_ctx->loop_th_ready = false; // Until topology is validated, no requests are allowed (will be accumulated in the pending queue)
   uv_async_send(&io_runtime_ctx->uv_runtime.topologyAsync); // start the topology check
+  io_runtime_ctx->loopLagDue = uv_hrtime() + MR_LOOP_LAG_INTERVAL_MS * 1000000ULL;
+  uv_timer_start(&io_runtime_ctx->uv_runtime.loopLagTimer, loopLagCB, MR_LOOP_LAG_INTERVAL_MS, MR_LOOP_LAG_INTERVAL_MS);
   // Run the event loop
   RedisModule_Log(RSDummyContext, "verbose", "IORuntime ID %zu: Running event loop", io_runtime_ctx->queue->id);
   uv_run(&io_runtime_ctx->uv_runtime.loop, UV_RUN_DEFAULT);
@@ -189,6 +224,12 @@ void IORuntimeCtx_UpdateNodes(IORuntimeCtx *ioRuntime) {
     MRConnManager_Add(&ioRuntime->conn_mgr, &ioRuntime->uv_runtime.loop, node->id, &node->endpoint, 0);
     /* This node is still valid, remove it from the nodes to delete list */
     dictDelete(nodesToDisconnect, node->id);
+    // The replicas are only connected to for hedging the requests of their shard
+    MRClusterNode *replica = &topo->shards[sh].replica;
+    if (RSGlobalConfig.hedgeShardRequests && replica->id) {
+      MRConnManager_Add(&ioRuntime->conn_mgr, &ioRuntime->uv_runtime.loop, replica->id, &replica->endpoint, 0);
+      dictDelete(nodesToDisconnect, replica->id);
+    }
   }
 
   // if we didn't remove the node from the original nodes map copy, it means it's not in the new topology,
@@ -207,6 +248,74 @@ int IORuntimeCtx_UpdateNodesAndConnectAll(IORuntimeCtx *ioRuntime) {
   return REDIS_OK;
 }
 
+static void applyTopology(IORuntimeCtx *ioRuntime, struct MRClusterTopology *topo) {
+  // The connections prepared for the new nodes replace those to their previous endpoints, and
+  // those to the nodes which left the topology are dropped
+  MRConnManager_CommitPending(&ioRuntime->conn_mgr);
+  struct MRClusterTopology *old_topo = ioRuntime->topo;
+  ioRuntime->topo = topo;
+  IORuntimeCtx_UpdateNodesAndConnectAll(ioRuntime);
+  if (old_topo) {
+    MRClusterTopology_Free(old_topo);
+  }
+}
+
+static void topologyWarmupCB(uv_timer_t *timer) {
+  IORuntimeCtx *ioRuntime = (IORuntimeCtx *)timer->data;
+  bool connected = MRConnManager_PendingConnected(&ioRuntime->conn_mgr);
+  uint64_t elapsed = uv_now(&ioRuntime->uv_runtime.loop) - ioRuntime->warmingSince;
+  if (!connected && (!clusterConfig.topologyValidationTimeoutMS ||
+                     elapsed < clusterConfig.topologyValidationTimeoutMS)) {
+    return;
+  }
+  if (!connected) {
+    RedisModule_Log(RSDummyContext, "warning", "IORuntime ID %zu: Applying the new topology before all its new nodes connected",
+                    ioRuntime->queue->id);
+  }
+  uv_timer_stop(timer);
+  struct MRClusterTopology *topo = ioRuntime->warmingTopo;
+  ioRuntime->warmingTopo = NULL;
+  applyTopology(ioRuntime, topo);
+}
+
+void IORuntimeCtx_UpdateTopology(IORuntimeCtx *ioRuntime, struct MRClusterTopology *topo) {
+  if (ioRuntime->warmingTopo) {
+    // Superseded before its nodes connected
+    uv_timer_stop(&ioRuntime->uv_runtime.topologyWarmupTimer);
+    MRClusterTopology_Free(ioRuntime->warmingTopo);
+    ioRuntime->warmingTopo = NULL;
+  }
+  MRConnManager_ClearPending(&ioRuntime->conn_mgr);
+
+  const struct MRClusterTopology *cur = ioRuntime->topo;
+  if (!ioRuntime->uv_runtime.loop_th_ready || !cur || !cur->numShards ||
+      CheckTopologyConnections(cur, ioRuntime) != REDIS_OK) {
+    // There are no connected nodes to keep sending the requests to meanwhile
+    applyTopology(ioRuntime, topo);
+    return;
+  }
+
+  uv_loop_t *loop = &ioRuntime->uv_runtime.loop;
+  for (uint32_t sh = 0; sh < topo->numShards; sh++) {
+    MRClusterNode *node = &topo->shards[sh].node;
+    MRConnManager_Prepare(&ioRuntime->conn_mgr, loop, node->id, &node->endpoint);
+    MRClusterNode *replica = &topo->shards[sh].replica;
+    if (RSGlobalConfig.hedgeShardRequests && replica->id) {
+      MRConnManager_Prepare(&ioRuntime->conn_mgr, loop, replica->id, &replica->endpoint);
+    }
+  }
+  if (MRConnManager_PendingConnected(&ioRuntime->conn_mgr)) {
+    // No new node to connect to
+    applyTopology(ioRuntime, topo);
+    return;
+  }
+  RedisModule_Log(RSDummyContext, "verbose", "IORuntime ID %zu: Connecting to the new nodes of the topology",
+                  ioRuntime->queue->id);
+  ioRuntime->warmingTopo = topo;
+  ioRuntime->warmingSince = uv_now(loop);
+  uv_timer_start(&ioRuntime->uv_runtime.topologyWarmupTimer, topologyWarmupCB, 1, 1);
+}
+
 static void UV_Init(IORuntimeCtx *io_runtime_ctx) {
   io_runtime_ctx->uv_runtime.loop_th_ready = false;
   io_runtime_ctx->uv_runtime.io_runtime_started_or_starting = false;
@@ -220,8 +329,12 @@ static void UV_Init(IORuntimeCtx *io_runtime_ctx) {
   io_runtime_ctx->uv_runtime.topologyAsync.data = io_runtime_ctx;
   io_runtime_ctx->uv_runtime.topologyFailureTimer.data = io_runtime_ctx;
   io_runtime_ctx->uv_runtime.topologyValidationTimer.data = io_runtime_ctx;
+  io_runtime_ctx->uv_runtime.topologyWarmupTimer.data = io_runtime_ctx;
+  io_runtime_ctx->uv_runtime.loopLagTimer.data = io_runtime_ctx;
   uv_timer_init(&io_runtime_ctx->uv_runtime.loop, &io_runtime_ctx->uv_runtime.topologyValidationTimer);
   uv_timer_init(&io_runtime_ctx->uv_runtime.loop, &io_runtime_ctx->uv_runtime.topologyFailureTimer);
+  uv_timer_init(&io_runtime_ctx->uv_runtime.loop, &io_runtime_ctx->uv_runtime.topologyWarmupTimer);
+  uv_timer_init(&io_runtime_ctx->uv_runtime.loop, &io_runtime_ctx->uv_runtime.loopLagTimer);
   uv_async_init(&io_runtime_ctx->uv_runtime.loop, &io_runtime_ctx->uv_runtime.async, rqAsyncCb);
   uv_async_init(&io_runtime_ctx->uv_runtime.loop, &io_runtime_ctx->uv_runtime.shutdownAsync, shutdown_cb);
   uv_async_init(&io_runtime_ctx->uv_runtime.loop, &io_runtime_ctx->uv_runtime.topologyAsync, topologyAsyncCB);
@@ -231,6 +344,8 @@ static void UV_Close(IORuntimeCtx *io_runtime_ctx) {
   // Close all handles when thread wasn't initialized
   uv_close((uv_handle_t*)&io_runtime_ctx->uv_runtime.topologyValidationTimer, NULL);
   uv_close((uv_handle_t*)&io_runtime_ctx->uv_runtime.topologyFailureTimer, NULL);
+  uv_close((uv_handle_t*)&io_runtime_ctx->uv_runtime.topologyWarmupTimer, NULL);
+  uv_close((uv_handle_t*)&io_runtime_ctx->uv_runtime.loopLagTimer, NULL);
   uv_close((uv_handle_t*)&io_runtime_ctx->uv_runtime.async, NULL);
   uv_close((uv_handle_t*)&io_runtime_ctx->uv_runtime.shutdownAsync, NULL);
   uv_close((uv_handle_t*)&io_runtime_ctx->uv_runtime.topologyAsync, NULL);
@@ -247,6 +362,12 @@ IORuntimeCtx *IORuntimeCtx_Create(size_t conn_pool_size, struct MRClusterTopolog
   io_runtime_ctx->queue = RQ_New(io_runtime_ctx->conn_mgr.nodeConns * PENDING_FACTOR, id);
   io_runtime_ctx->pendingTopo = NULL;
   io_runtime_ctx->pendingItems = false;
+  io_runtime_ctx->warmingTopo = NULL;
+  io_runtime_ctx->warmingSince = 0;
+  io_runtime_ctx->shardLatency = NULL;
+  io_runtime_ctx->numShardLatency = 0;
+  io_runtime_ctx->loopLag = (MRLoopLag){0};
+  io_runtime_ctx->loopLagDue = 0;
 
   if (take_topo_ownership) {
     io_runtime_ctx->topo = initialTopology;
@@ -294,6 +415,10 @@ void IORuntimeCtx_Free(IORuntimeCtx *io_runtime_ctx) {
   if (io_runtime_ctx->topo) {
     MRClusterTopology_Free(io_runtime_ctx->topo);
   }
+  if (io_runtime_ctx->warmingTopo) {
+    MRClusterTopology_Free(io_runtime_ctx->warmingTopo);
+  }
+  rm_free(io_runtime_ctx->shardLatency);
 
   // Destroy synchronization primitives
   uv_mutex_destroy(&io_runtime_ctx->uv_runtime.loop_th_created_mutex);
@@ -382,3 +507,31 @@ void IORuntimeCtx_UpdateConnPoolSize(IORuntimeCtx *ioRuntime, size_t new_conn_po
     MRConnManager_Expand(&ioRuntime->conn_mgr, new_conn_pool_size, IORuntimeCtx_GetLoop(ioRuntime));
   }
 }
+
+size_t IORuntimeCtx_Load(IORuntimeCtx *io_runtime_ctx) {
+  MRWorkQueue *q = io_runtime_ctx->queue;
+  size_t inFlight = __atomic_load_n(&q->sz, __ATOMIC_RELAXED) +
+                    __atomic_load_n(&q->pending, __ATOMIC_RELAXED);
+  return inFlight + __atomic_load_n(&io_runtime_ctx->loopLag.lastUS, __ATOMIC_RELAXED) / MR_LOOP_LAG_PER_REQUEST_US;
+}
+
+void IORuntimeCtx_AddToInfo(IORuntimeCtx *io_runtime_ctx, RedisModuleInfoCtx *ctx) {
+  const MRLoopLag *lag = &io_runtime_ctx->loopLag;
+  char field[64];
+  snprintf(field, sizeof(field), "io_thread_%zu", io_runtime_ctx->queue->id);
+  RedisModule_InfoBeginDictField(ctx, field);
+  for (size_t b = 0; b < MR_LOOP_LAG_BUCKETS; b++) {
+    if (b < MR_LOOP_LAG_BUCKETS - 1) {
+      snprintf(field, sizeof(field), "lag_le_%ums", loopLagBoundsMS[b]);
+    } else {
+      snprintf(field, sizeof(field), "lag_gt_%ums", loopLagBoundsMS[b - 1]);
+    }
+    RedisModule_InfoAddFieldULongLong(ctx, field, __atomic_load_n(&lag->buckets[b], __ATOMIC_RELAXED));
+  }
+  RedisModule_InfoAddFieldULongLong(ctx, "lag_last_us", __atomic_load_n(&lag->lastUS, __ATOMIC_RELAXED));
+  RedisModule_InfoAddFieldULongLong(ctx, "lag_max_us", __atomic_load_n(&lag->maxUS, __ATOMIC_RELAXED));
+  RedisModule_InfoAddFieldULongLong(ctx, "requests_in_flight",
+                                    __atomic_load_n(&io_runtime_ctx->queue->sz, __ATOMIC_RELAXED) +
+                                    __atomic_load_n(&io_runtime_ctx->queue->pending, __ATOMIC_RELAXED));
+  RedisModule_InfoEndDictField(ctx);
+}
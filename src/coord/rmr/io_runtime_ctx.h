@@ -33,6 +33,8 @@ typedef struct {
   uv_loop_t loop;
   uv_thread_t loop_th;
   uv_timer_t topologyValidationTimer, topologyFailureTimer;
+  uv_timer_t topologyWarmupTimer;
+  uv_timer_t loopLagTimer;
   uv_async_t topologyAsync;
   uv_async_t shutdownAsync;
 
@@ -43,11 +45,37 @@ typedef struct {
   uv_cond_t loop_th_created_cond;
 } UVRuntime;
 
+#define MR_SHARD_LATENCY_SAMPLES 64
+
+/* The latest reply latencies of a shard, from which the delay of its hedged requests is derived */
+typedef struct {
+  uint32_t samples[MR_SHARD_LATENCY_SAMPLES];  // In microseconds, as a ring buffer
+  uint32_t count;                               // The samples recorded so far
+  uint32_t hedgeDelayUS;                        // 0 while there are too few samples
+} MRShardLatency;
+
+#define MR_LOOP_LAG_INTERVAL_MS 10
+#define MR_LOOP_LAG_BUCKETS 8
+// Each such lag of the loop weighs like a request in flight when picking the runtime of a request
+#define MR_LOOP_LAG_PER_REQUEST_US 1000
+
+/* How late the lag timer of the event loop fires, which is how long the loop thread is busy
+ * before it gets to a new event. Written by the loop thread, read atomically by any thread */
+typedef struct {
+  uint64_t buckets[MR_LOOP_LAG_BUCKETS];  // Sample counts, by upper bound (see IORuntimeCtx_AddToInfo)
+  uint64_t lastUS;                        // The latest sample
+  uint64_t maxUS;
+} MRLoopLag;
+
 //Structure to encapsulate the IO Runtime context for MR operations to take place
 typedef struct {
   // Connectivity / topology structures
   MRConnManager conn_mgr;
   struct MRClusterTopology *topo;
+  // A new topology whose new nodes are being connected to, while the requests are still sent to
+  // the nodes of `topo`. NULL unless warming up
+  struct MRClusterTopology *warmingTopo;
+  uint64_t warmingSince;  // In loop time
 
   // Request queue and topology requests
   MRWorkQueue *queue;
@@ -57,6 +85,13 @@ typedef struct {
   //UV runtime
   UVRuntime uv_runtime;
 
+  // The reply latencies of the shards of the topology, by shard index. Only used by the loop thread
+  MRShardLatency *shardLatency;
+  uint32_t numShardLatency;
+
+  MRLoopLag loopLag;
+  uint64_t loopLagDue;  // When the lag timer should fire next, in uv_hrtime() nanoseconds
+
 } IORuntimeCtx;
 
 struct UpdateTopologyCtx {
@@ -82,9 +117,21 @@ void IORuntimeCtx_UpdateNodes(IORuntimeCtx *ioRuntime);
 /* Update the topology by calling the topology provider explicitly with ctx. If ctx is NULL, the
  * provider's current context is used. Otherwise, we call its function with the given context */
 int IORuntimeCtx_UpdateNodesAndConnectAll(IORuntimeCtx *ioRuntime);
+/* Apply a new topology, taking its ownership. While all the nodes of the current topology are
+ * connected, the requests keep being sent to them until the new nodes of `topo` are connected as
+ * well (or until the topology validation timeout), and the connections to the nodes of both
+ * topologies are kept. Otherwise the topology is applied right away. Called from the loop thread */
+void IORuntimeCtx_UpdateTopology(IORuntimeCtx *ioRuntime, struct MRClusterTopology *topo);
 void IORuntimeCtx_Schedule_Topology(IORuntimeCtx *io_runtime_ctx, MRQueueCallback cb, struct MRClusterTopology *topo, bool take_topo_ownership);
 void IORuntimeCtx_UpdateConnPoolSize(IORuntimeCtx *ioRuntime, size_t new_conn_pool_size);
 
+/* The load of the runtime, to pick the runtime of a new request by: its requests queued or in
+ * flight, plus one per MR_LOOP_LAG_PER_REQUEST_US of the latest lag of its loop. Can be called
+ * from any thread */
+size_t IORuntimeCtx_Load(IORuntimeCtx *io_runtime_ctx);
+/* Add the loop lag histogram of the runtime to the INFO reply, as a dict field */
+void IORuntimeCtx_AddToInfo(IORuntimeCtx *io_runtime_ctx, RedisModuleInfoCtx *ctx);
+
 #ifdef __cplusplus
 }
 #endif
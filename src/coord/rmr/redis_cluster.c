@@ -91,6 +91,39 @@ static void parseMasterNode(RedisModuleCallReply *nodes, MRClusterNode *n) {
   RS_ABORT_ALWAYS("No master node found in shard");
 }
 
+// Return the value of a field of a node of CLUSTER SHARDS, or NULL if it has none
+static const char *nodeField(RedisModuleCallReply *node, const char *field, size_t *len) {
+  const size_t node_len = RedisModule_CallReplyLength(node);
+  for (size_t j = 0; j + 1 < node_len; j += 2) {
+    size_t key_len;
+    const char *key_str = RedisModule_CallReplyStringPtr(RedisModule_CallReplyArrayElement(node, j), &key_len);
+    if (STR_EQ(key_str, key_len, field)) {
+      RedisModuleCallReply *val = RedisModule_CallReplyArrayElement(node, j + 1);
+      if (RedisModule_CallReplyType(val) != REDISMODULE_REPLY_STRING) {
+        return NULL;
+      }
+      return RedisModule_CallReplyStringPtr(val, len);
+    }
+  }
+  return NULL;
+}
+
+// Parse the first online replica of the shard, if any. Its id is left NULL otherwise
+static void parseReplicaNode(RedisModuleCallReply *nodes, MRClusterNode *n) {
+  const size_t numNodes = RedisModule_CallReplyLength(nodes);
+
+  for (size_t i = 0; i < numNodes; i++) {
+    RedisModuleCallReply *node = RedisModule_CallReplyArrayElement(nodes, i);
+    size_t role_len, health_len;
+    const char *role = nodeField(node, "role", &role_len);
+    const char *health = nodeField(node, "health", &health_len);
+    if (role && STR_EQ(role, role_len, "replica") && health && STR_EQ(health, health_len, "online")) {
+      parseNode(node, n);
+      return;
+    }
+  }
+}
+
 static bool hasSlots(RedisModuleCallReply *shard) {
   ASSERT_KEY(shard, 0, "slots");
   RedisModuleCallReply *slots = RedisModule_CallReplyArrayElement(shard, 1);
@@ -185,6 +218,7 @@ static MRClusterTopology *RedisCluster_GetTopology(RedisModuleCtx *ctx) {
     RS_ASSERT(RedisModule_CallReplyType(nodes) == REDISMODULE_REPLY_ARRAY);
     // parse and store the master
     parseMasterNode(nodes, &topo->shards[i].node);
+    parseReplicaNode(nodes, &topo->shards[i].replica);
   }
 
   // Sort shards by the port of their first node (master), to have a stable order
@@ -222,6 +222,15 @@ inline MRReply *MRReply_ArrayElement(const MRReply *reply, size_t idx) {
   return reply->element[idx];
 }
 
+char *MRReply_TakeString(MRReply *reply, size_t *len) {
+  RS_ASSERT(reply->type == MR_REPLY_STRING || reply->type == MR_REPLY_STATUS);
+  char *str = reply->str;
+  if (len) *len = reply->len;
+  reply->str = NULL;
+  reply->len = 0;
+  return str;
+}
+
 inline MRReply *MRReply_TakeArrayElement(const MRReply *reply, size_t idx) {
   RS_ASSERT(reply->elements > idx);
   MRReply *ret = reply->element[idx];
@@ -50,6 +50,11 @@ int MRReply_StringEquals(MRReply *r, const char *s, int caseSensitive);
 
 const char *MRReply_String(const MRReply *reply, size_t *len);
 
+// Take ownership of the string of a string or status reply, leaving the reply without it (NULL).
+// The string is NUL-terminated and is freed with rm_free, as hiredis allocates with the module
+// allocator (see setHiredisAllocators())
+char *MRReply_TakeString(MRReply *reply, size_t *len);
+
 MRReply *MRReply_ArrayElement(const MRReply *reply, size_t idx);
 // Same as `MRReply_ArrayElement`, but takes ownership of the element.
 MRReply *MRReply_TakeArrayElement(const MRReply *reply, size_t idx);
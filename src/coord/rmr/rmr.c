@@ -17,6 +17,8 @@
 #include "rmutil/rm_assert.h"
 #include "resp3.h"
 #include "coord/config.h"
+#include "info/global_stats.h"
+#include "info/latency_stats.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -94,7 +96,7 @@ MRCtx *MR_CreateCtx(RedisModuleCtx *ctx, RedisModuleBlockedClient *bc, void *pri
   ret->bc = bc;
   RS_ASSERT(ctx || bc);
   ret->fn = NULL;
-  ret->ioRuntime = MRCluster_GetIORuntimeCtx(cluster_g, MRCluster_AssignRoundRobinIORuntimeIdx(cluster_g));
+  ret->ioRuntime = MRCluster_GetIORuntimeCtx(cluster_g, MRCluster_AssignIORuntimeIdx(cluster_g));
   return ret;
 }
 
@@ -206,7 +208,12 @@ static void uvFanoutRequest(void *p) {
   MRCtx *mrctx = p;
   IORuntimeCtx *ioRuntime = mrctx->ioRuntime;
 
-  mrctx->numExpected = MRCluster_FanoutCommand(ioRuntime, &mrctx->cmd, fanoutCallback, mrctx);
+  if (mrctx->cmd.hedgeable && RSGlobalConfig.hedgeShardRequests) {
+    mrctx->numExpected = MRCluster_HedgedFanoutCommand(ioRuntime, &mrctx->cmd, fanoutCallback, mrctx);
+  } else {
+    mrctx->numExpected = MRCluster_FanoutCommand(ioRuntime, &mrctx->cmd, fanoutCallback, mrctx);
+  }
+  TotalGlobalStats_CountShardRequests(mrctx->numExpected);
 
   if (mrctx->numExpected == 0) {
     RedisModuleBlockedClient *bc = mrctx->bc;
@@ -237,14 +244,8 @@ int MR_Fanout(struct MRCtx *mrctx, MRReduceFunc reducer, MRCommand cmd, bool blo
 /* on-loop update topology request. This can't be done from the main thread */
 static void uvUpdateTopologyRequest(void *p) {
   struct UpdateTopologyCtx *ctx = p;
-  IORuntimeCtx *ioRuntime = ctx->ioRuntime;
-  MRClusterTopology *old_topo = ioRuntime->topo;
-  ioRuntime->topo = ctx->new_topo;
-  IORuntimeCtx_UpdateNodesAndConnectAll(ioRuntime);
+  IORuntimeCtx_UpdateTopology(ctx->ioRuntime, ctx->new_topo);
   rm_free(ctx);
-  if (old_topo) {
-    MRClusterTopology_Free(old_topo);
-  }
 }
 
 /* Set a new topology for the cluster.*/
@@ -357,6 +358,14 @@ void MR_GetConnectionPoolState(RedisModuleCtx *ctx) {
   }
 }
 
+void MR_AddToInfo_IOThreads(RedisModuleInfoCtx *ctx) {
+  if (!cluster_g) return;
+  RedisModule_InfoAddSection(ctx, "coordinator_io_threads");
+  for (size_t i = 0; i < cluster_g->num_io_threads; i++) {
+    IORuntimeCtx_AddToInfo(cluster_g->io_runtimes_pool[i], ctx);
+  }
+}
+
 static void uvReplyClusterInfo(void *p) {
   struct ReplyClusterInfoCtx *replyClusterInfoCtx = p;
   IORuntimeCtx *ioRuntime = replyClusterInfoCtx->ioRuntime;
@@ -424,12 +433,18 @@ struct MRIteratorCtx {
   // When it reaches 0, both readers and the writer agree that the iterator can be released
   int8_t itRefCount;
   IORuntimeCtx *ioRuntime;
+  size_t readAhead; // In cursor mode, the replies of a command to read before the reader needs them
+  rs_wall_clock createdAt; // When the iterator was created, until its commands are all sent
 };
 
 struct MRIteratorCallbackCtx {
   MRIterator *it;
   MRCommand cmd;
   void *privateData;
+  bool stopped;  // Set by the reader once it needs no more replies for this command
+  size_t buffered;  // The replies of the command in the channel, not read yet
+  bool paused;      // Set once the command stopped reading ahead, until it is sent again
+  rs_wall_clock sentAt;  // When the command was last sent, until its shard replies
 };
 
 struct MRIterator {
@@ -445,13 +460,18 @@ static void mrIteratorRedisCB(redisAsyncContext *c, void *r, void *privdata) {
     // ctx->numErrored++;
     // TODO: report error
   } else {
+    LatencyStats_CountStage(LATENCY_STAGE_SHARD_WAIT, rs_wall_clock_elapsed_ns(&ctx->sentAt));
     ctx->it->ctx.cb(ctx, r);
   }
 }
 
+static int sendIteratorCommand(MRIteratorCallbackCtx *ctx) {
+  rs_wall_clock_init(&ctx->sentAt);
+  return MRCluster_SendCommand(ctx->it->ctx.ioRuntime, &ctx->cmd, mrIteratorRedisCB, ctx);
+}
+
 int MRIteratorCallback_ResendCommand(MRIteratorCallbackCtx *ctx) {
-  IORuntimeCtx *io_runtime_ctx = ctx->it->ctx.ioRuntime;
-  return MRCluster_SendCommand(io_runtime_ctx, &ctx->cmd, mrIteratorRedisCB, ctx);
+  return sendIteratorCommand(ctx);
 }
 
 // Use after modifying `pending` (or any other variable of the iterator) to make sure it's visible
@@ -520,7 +540,37 @@ MRIteratorCtx *MRIteratorCallback_GetCtx(MRIteratorCallbackCtx *ctx) {
 }
 
 void MRIteratorCallback_AddReply(MRIteratorCallbackCtx *ctx, MRReply *rep) {
-  MRChannel_Push(ctx->it->ctx.chan, rep);
+  // Counted before the push, so that the reader never reads it first
+  __atomic_add_fetch(&ctx->buffered, 1, __ATOMIC_SEQ_CST);
+  MRChannel_PushTagged(ctx->it->ctx.chan, rep, ctx - ctx->it->cbxs);
+}
+
+static bool unpauseCommand(MRIteratorCallbackCtx *ctx) {
+  bool paused = true;
+  return __atomic_compare_exchange_n(&ctx->paused, &paused, false, false, __ATOMIC_SEQ_CST,
+                                     __ATOMIC_SEQ_CST);
+}
+
+void MRIteratorCallback_CursorReplyDone(MRIteratorCallbackCtx *ctx) {
+  const size_t readAhead = ctx->it->ctx.readAhead;
+  if (readAhead > 1 && !MRIteratorCallback_IsStopped(ctx)) {
+    // Pause the command before checking how many of its replies are waiting, while the reader
+    // counts the reply it read before checking whether the command is paused. So either we see
+    // there's room for another reply, or the reader sees the command paused and resumes it.
+    __atomic_store_n(&ctx->paused, true, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ctx->buffered, __ATOMIC_SEQ_CST) < readAhead && unpauseCommand(ctx)) {
+      // Still in process
+      if (MRIteratorCallback_ResendCommand(ctx) == REDIS_ERR) {
+        MRIteratorCallback_Done(ctx, 1);
+      }
+      return;
+    }
+  }
+  MRIteratorCallback_ProcessDone(ctx);
+}
+
+bool MRIteratorCallback_IsStopped(MRIteratorCallbackCtx *ctx) {
+  return __atomic_load_n(&ctx->stopped, __ATOMIC_RELAXED);
 }
 
 void *MRIteratorCallback_GetPrivateData(MRIteratorCallbackCtx *ctx) {
@@ -547,15 +597,18 @@ void iterStartCb(void *p) {
     // Set each command to target a different shard
     it->cbxs[i].cmd.targetShard = i;
     it->cbxs[i].privateData = MRIteratorCallback_GetPrivateData(&it->cbxs[0]);
+    it->cbxs[i].stopped = false;
+    it->cbxs[i].buffered = 0;
+    it->cbxs[i].paused = false;
   }
 
   // This implies that every connection to each shard will work inside a single IO thread
   for (size_t i = 0; i < it->len; i++) {
-    if (MRCluster_SendCommand(io_runtime_ctx, &it->cbxs[i].cmd,
-                              mrIteratorRedisCB, &it->cbxs[i]) == REDIS_ERR) {
+    if (sendIteratorCommand(&it->cbxs[i]) == REDIS_ERR) {
       MRIteratorCallback_Done(&it->cbxs[i], 1);
     }
   }
+  LatencyStats_CountStage(LATENCY_STAGE_FANOUT, rs_wall_clock_elapsed_ns(&it->ctx.createdAt));
 
   // Clean up the data structure
   rm_free(data);
@@ -578,7 +631,6 @@ void iterCursorMappingCb(void *p) {
     return;
   }
 
-  IORuntimeCtx *io_runtime_ctx = it->ctx.ioRuntime;
   const size_t numShardsWithMapping = array_len(vsimOrSearch->mappings);
   RS_ASSERT(numShardsWithMapping > 0);
   it->len = numShardsWithMapping;
@@ -598,6 +650,9 @@ void iterCursorMappingCb(void *p) {
   for (size_t i = 1; i < numShardsWithMapping; i++) {
     it->cbxs[i].it = it;
     it->cbxs[i].privateData = MRIteratorCallback_GetPrivateData(&it->cbxs[0]);
+    it->cbxs[i].stopped = false;
+    it->cbxs[i].buffered = 0;
+    it->cbxs[i].paused = false;
 
     it->cbxs[i].cmd = MRCommand_Copy(cmd);
 
@@ -610,11 +665,11 @@ void iterCursorMappingCb(void *p) {
 
   // Send commands to all shards
   for (size_t i = 0; i < it->len; i++) {
-    if (MRCluster_SendCommand(io_runtime_ctx, &it->cbxs[i].cmd,
-                              mrIteratorRedisCB, &it->cbxs[i]) == REDIS_ERR) {
+    if (sendIteratorCommand(&it->cbxs[i]) == REDIS_ERR) {
       MRIteratorCallback_Done(&it->cbxs[i], 1);
     }
   }
+  LatencyStats_CountStage(LATENCY_STAGE_FANOUT, rs_wall_clock_elapsed_ns(&it->ctx.createdAt));
 
   //Clean up the StrongRef and allocated memory
   StrongRef_Release(mappingsRef);
@@ -624,17 +679,52 @@ void iterCursorMappingCb(void *p) {
 // This function already runs in one of the IO threads. We need to make sure that the adequate RuntimeCtx is used. This info can be found in the MRIterator ctx
 void iterManualNextCb(void *p) {
   MRIterator *it = p;
-  IORuntimeCtx *io_runtime_ctx = it->ctx.ioRuntime;
   for (size_t i = 0; i < it->len; i++) {
     if (!it->cbxs[i].cmd.depleted) {
-      if (MRCluster_SendCommand(io_runtime_ctx, &it->cbxs[i].cmd,
-                                mrIteratorRedisCB, &it->cbxs[i]) == REDIS_ERR) {
+      if (sendIteratorCommand(&it->cbxs[i]) == REDIS_ERR) {
         MRIteratorCallback_Done(&it->cbxs[i], 1);
       }
     }
   }
 }
 
+// Sends a command resumed by the reader while other commands of the iterator were in process
+static void iterResumeCb(void *p) {
+  MRIteratorCallbackCtx *ctx = p;
+  if (sendIteratorCommand(ctx) == REDIS_ERR) {
+    MRIteratorCallback_Done(ctx, 1);
+  }
+  // The request of the iterator is completed once no command is in process, not by this one
+  IORuntimeCtx_RequestCompleted(ctx->it->ctx.ioRuntime);
+}
+
+// Sends a command resumed by the reader while no command of the iterator was in process, starting
+// a new request of the iterator (like iterManualNextCb)
+static void iterResumeFirstCb(void *p) {
+  MRIteratorCallbackCtx *ctx = p;
+  if (sendIteratorCommand(ctx) == REDIS_ERR) {
+    MRIteratorCallback_Done(ctx, 1);
+  }
+}
+
+// The reader read a reply of the command at `idx`. Resume the command if it stopped reading ahead
+static void MRIterator_ReplyRead(MRIterator *it, size_t idx) {
+  MRIteratorCallbackCtx *ctx = &it->cbxs[idx];
+  const size_t buffered = __atomic_sub_fetch(&ctx->buffered, 1, __ATOMIC_SEQ_CST);
+  if (it->ctx.readAhead <= 1 || buffered >= it->ctx.readAhead || !unpauseCommand(ctx)) {
+    return;
+  }
+  IORuntimeCtx *ioRuntime = it->ctx.ioRuntime;
+  if (__atomic_add_fetch(&it->ctx.inProcess, 1, __ATOMIC_ACQ_REL) == 1) {
+    // The writers released their reference once no command was in process
+    int8_t refCount = MRIterator_IncreaseRefCount(it);
+    REFCOUNT_INCR_MSG("MRIterator_ReplyRead", refCount);
+    IORuntimeCtx_Schedule(ioRuntime, iterResumeFirstCb, ctx);
+  } else {
+    IORuntimeCtx_Schedule(ioRuntime, iterResumeCb, ctx);
+  }
+}
+
 bool MR_ManuallyTriggerNextIfNeeded(MRIterator *it, size_t channelThreshold) {
   // We currently trigger the next batch of commands only when no commands are in process,
   // regardless of the number of replies we have in the channel.
@@ -653,6 +743,10 @@ bool MR_ManuallyTriggerNextIfNeeded(MRIterator *it, size_t channelThreshold) {
   if (it->ctx.pending) {
     // We have more commands to send
     it->ctx.inProcess = it->ctx.pending;
+    // All the commands are sent again, none is left for MRIterator_ReplyRead() to resume
+    for (size_t i = 0; i < it->len; i++) {
+      __atomic_store_n(&it->cbxs[i].paused, false, __ATOMIC_SEQ_CST);
+    }
     // All reader have marked that they are done with the current command batch (decreased inProcess)
     // However, they may still hold the iterator reference.
     // We need to take a reference to the iterator for the next batch of commands.
@@ -688,10 +782,12 @@ MRIterator *MR_IterateWithPrivateData(const MRCommand *cmd, MRIteratorCallback c
       .inProcess = 1,
       .timedOut = false,
       .itRefCount = 2,
-      .ioRuntime = MRCluster_GetIORuntimeCtx(cluster_g, MRCluster_AssignRoundRobinIORuntimeIdx(cluster_g)),
+      .ioRuntime = MRCluster_GetIORuntimeCtx(cluster_g, MRCluster_AssignIORuntimeIdx(cluster_g)),
+      .readAhead = clusterConfig.cursorReadAhead,
     },
     .cbxs = rm_new(MRIteratorCallbackCtx),
   };
+  rs_wall_clock_init(&ret->ctx.createdAt);
   // Initialize the first command
   *ret->cbxs = (MRIteratorCallbackCtx){
     .cmd = MRCommand_Copy(cmd),
@@ -715,7 +811,34 @@ MRIteratorCtx *MRIterator_GetCtx(MRIterator *it) {
 }
 
 MRReply *MRIterator_Next(MRIterator *it) {
-  return MRChannel_Pop(it->ctx.chan);
+  return MRIterator_NextFrom(it, NULL);
+}
+
+MRReply *MRIterator_NextFrom(MRIterator *it, size_t *idx) {
+  size_t tag;
+  MRReply *rep = MRChannel_PopTagged(it->ctx.chan, &tag);
+  if (rep) {
+    MRIterator_ReplyRead(it, tag);
+    if (idx) {
+      *idx = tag;
+    }
+  }
+  return rep;
+}
+
+// The commands are all set up before the first reply is pushed, so `cbxs` is stable once the
+// reader got a reply for `idx`
+void MRIterator_StopCommand(MRIterator *it, size_t idx) {
+  RS_ASSERT(idx < it->len);
+  __atomic_store_n(&it->cbxs[idx].stopped, true, __ATOMIC_RELAXED);
+}
+
+bool MRIterator_IsCommandStopped(MRIterator *it, size_t idx) {
+  return MRIteratorCallback_IsStopped(&it->cbxs[idx]);
+}
+
+size_t MRIterator_NumCommands(MRIterator *it) {
+  return it->len;
 }
 
 // Assumes no other thread is using the iterator, the channel, or any of the commands and contexts
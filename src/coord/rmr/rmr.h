@@ -49,6 +49,9 @@ void MR_GetConnectionPoolState(RedisModuleCtx *ctx);
 
 void MR_uvReplyClusterInfo(RedisModuleCtx *ctx);
 
+/* Add the state of the IO threads (the loop lag histograms, the requests in flight) to INFO */
+void MR_AddToInfo_IOThreads(RedisModuleInfoCtx *ctx);
+
 void MR_UpdateConnPoolSize(size_t conn_pool_size);
 
 void MR_Debug_ClearPendingTopo();
@@ -85,6 +88,17 @@ bool MR_ManuallyTriggerNextIfNeeded(MRIterator *it, size_t channelThreshold);
 
 MRReply *MRIterator_Next(MRIterator *it);
 
+// Same as MRIterator_Next, also setting `*idx` to the index of the command the reply is for
+MRReply *MRIterator_NextFrom(MRIterator *it, size_t *idx);
+
+// No longer read the cursor of the command at `idx`: its next cursor READ is replaced by a DEL
+void MRIterator_StopCommand(MRIterator *it, size_t idx);
+
+bool MRIterator_IsCommandStopped(MRIterator *it, size_t idx);
+
+// The number of commands of the iterator, one per shard. Set once the reader got a reply
+size_t MRIterator_NumCommands(MRIterator *it);
+
 MRIterator *MR_Iterate(const MRCommand *cmd, MRIteratorCallback cb);
 
 MRIterator *MR_IterateWithPrivateData(const MRCommand *cmd, MRIteratorCallback cb, void *cbPrivateData, void (*iterStartCb)(void *) ,StrongRef *iterStartCbPrivateData);
@@ -97,6 +111,8 @@ void *MRIteratorCallback_GetPrivateData(MRIteratorCallbackCtx *ctx);
 
 void MRIteratorCallback_AddReply(MRIteratorCallbackCtx *ctx, MRReply *rep);
 
+bool MRIteratorCallback_IsStopped(MRIteratorCallbackCtx *ctx);
+
 bool MRIteratorCallback_GetTimedOut(MRIteratorCtx *ctx);
 
 void MRIteratorCallback_SetTimedOut(MRIteratorCtx *ctx);
@@ -107,6 +123,11 @@ void MRIteratorCallback_Done(MRIteratorCallbackCtx *ctx, int error);
 
 void MRIteratorCallback_ProcessDone(MRIteratorCallbackCtx *ctx);
 
+// Done with a reply of a cursor command which has more results, in cursor mode. The next READ of
+// the cursor is sent right away while fewer than CURSOR_READ_AHEAD of its replies wait for the
+// reader, otherwise the command waits until the reader resumes it
+void MRIteratorCallback_CursorReplyDone(MRIteratorCallbackCtx *ctx);
+
 int MRIteratorCallback_ResendCommand(MRIteratorCallbackCtx *ctx);
 
 MRIteratorCtx *MRIterator_GetCtx(MRIterator *it);
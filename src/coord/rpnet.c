@@ -25,7 +25,14 @@ static RSValue *MRReply_ToValue(MRReply *r) {
     case MR_REPLY_STRING: {
       size_t l;
       const char *s = MRReply_String(r, &l);
-      v = RSValue_NewCopiedString(s, l);
+      if (l <= RSVALUE_INLINE_STR_MAX) {
+        // Copied into the allocation of the value
+        v = RSValue_NewCopiedString(s, l);
+      } else {
+        // The rows are read once, so the value takes the string of the reply instead of a copy
+        char *str = MRReply_TakeString(r, &l);
+        v = RSValue_NewString(str, l);
+      }
       break;
     }
     case MR_REPLY_ERROR: {
@@ -74,6 +81,29 @@ static RSValue *MRReply_ToValue(MRReply *r) {
 }
 
 
+static void stopRecording(RPNet *nc) {
+  if (nc->cacheRecorder) {
+    CoordResultRecorder_Free(nc->cacheRecorder);
+    nc->cacheRecorder = NULL;
+  }
+}
+
+// The shards send the revision of their index after the cursor id, for the result cache
+static void observeRevision(RPNet *nc, MRReply *root, size_t shard) {
+  if (MRReply_Length(root) < 3) {
+    return;
+  }
+  MRReply *revision = MRReply_ArrayElement(root, 2);
+  if (MRReply_Type(revision) != MR_REPLY_INTEGER) {
+    return;
+  }
+  const uint64_t rev = MRReply_Integer(revision);
+  CoordResultCache_ObserveRevision(MRCommand_ArgStringPtrLen(&nc->cmd, 1, NULL), shard, rev);
+  if (nc->cacheRecorder) {
+    CoordResultRecorder_AddRevision(nc->cacheRecorder, shard, rev);
+  }
+}
+
 static int getNextReply(RPNet *nc) {
   if (nc->cmd.forCursor) {
     // if there are no more than `clusterConfig.cursorReplyThreshold` replies, trigger READs at the shards.
@@ -84,7 +114,8 @@ static int getNextReply(RPNet *nc) {
       return 0;
     }
   }
-  MRReply *root = MRIterator_Next(nc->it);
+  size_t shard;
+  MRReply *root = MRIterator_NextFrom(nc->it, &shard);
 
   if (root == NULL) {
     // No more replies
@@ -94,6 +125,7 @@ static int getNextReply(RPNet *nc) {
 
   // Check if an error was returned
   if(MRReply_Type(root) == MR_REPLY_ERROR) {
+    stopRecording(nc);
     nc->current.root = root;
     // If for profiling, clone and append the error
     if (nc->cmd.forProfiling) {
@@ -134,6 +166,10 @@ static int getNextReply(RPNet *nc) {
     }
   }
 
+  if (nc->useCache) {
+    observeRevision(nc, root, shard);
+  }
+
   MRReply *rows = NULL, *meta = NULL;
   if (nc->cmd.protocol == 3) { // RESP3
     meta = MRReply_ArrayElement(root, 0);
@@ -158,6 +194,7 @@ static int getNextReply(RPNet *nc) {
   nc->current.root = root;
   nc->current.rows = rows;
   nc->current.meta = meta;
+  nc->current.shard = shard;
   return 1;
 }
 
@@ -209,9 +246,16 @@ void rpnetFree(ResultProcessor *rp) {
   if (nc->mappings.rm) {
     StrongRef_Release(nc->mappings);
   }
+  BinaryRowsReader_Free(&nc->binaryRows);
   MRReply_Free(nc->current.root);
   MRCommand_Free(&nc->cmd);
 
+  stopRecording(nc);
+  if (nc->cached) {
+    CoordResultCache_Release(nc->cached);
+    array_free(nc->cachedKeys);
+  }
+
   rm_free(rp);
 }
 
@@ -227,7 +271,77 @@ RPNet *RPNet_New(const MRCommand *cmd, int (*nextFunc)(ResultProcessor *, Search
   return nc;
 }
 
+void RPNet_SkipShard(ResultProcessor *rp) {
+  RPNet *nc = (RPNet *)rp;
+  // The rows recorded for the cache must be all the rows of the shards
+  if (!nc->current.rows || nc->cacheRecorder) {
+    return;
+  }
+  BinaryRowsReader_Free(&nc->binaryRows);
+  nc->curIdx = MRReply_Length(nc->current.rows);
+  MRIterator_StopCommand(nc->it, nc->current.shard);
+}
+
+static int rpnetNext_Cached(ResultProcessor *self, SearchResult *r) {
+  RPNet *nc = (RPNet *)self;
+  size_t numRows;
+  const CoordCachedRow *rows = CoordCachedResult_Rows(nc->cached, &numRows);
+  if (nc->curIdx == numRows) {
+    return RS_RESULT_EOF;
+  }
+  const CoordCachedRow *row = &rows[nc->curIdx++];
+  RLookupRow *dst = SearchResult_GetRowDataMut(r);
+  for (uint32_t i = 0; i < row->numValues; i++) {
+    if (row->values[i]) {
+      RLookup_WriteKey(nc->cachedKeys[i], dst, row->values[i]);
+    }
+  }
+  return RS_RESULT_OK;
+}
+
+bool RPNet_ReadFromCache(RPNet *nc) {
+  const char *index = MRCommand_ArgStringPtrLen(&nc->cmd, 1, NULL);
+  sds key = CoordResultCache_Key(&nc->cmd);
+  nc->cached = CoordResultCache_Get(index, key, nc->localRevision);
+  if (!nc->cached) {
+    nc->cacheRecorder = CoordResultRecorder_New(index, key, nc->localRevision);
+    return false;
+  }
+  sdsfree(key);
+
+  size_t numColumns;
+  const CoordCachedColumn *columns = CoordCachedResult_Columns(nc->cached, &numColumns);
+  nc->cachedKeys = array_new(RLookupKey *, numColumns);
+  for (size_t i = 0; i < numColumns; i++) {
+    array_append(nc->cachedKeys, RLookup_GetKeyByName(nc->lookup, columns[i].name, columns[i].len));
+  }
+  nc->base.parent->totalResults += CoordCachedResult_TotalResults(nc->cached);
+  // As processResultFormat() set it from the shard replies
+  bool expand;
+  if (CoordCachedResult_Format(nc->cached, &expand)) {
+    if (expand) {
+      nc->areq->reqflags |= QEXEC_FORMAT_EXPAND;
+    } else {
+      nc->areq->reqflags &= ~QEXEC_FORMAT_EXPAND;
+    }
+    nc->areq->reqflags &= ~QEXEC_FORMAT_DEFAULT;
+  }
+  nc->curIdx = 0;
+  nc->base.Next = rpnetNext_Cached;
+  return true;
+}
+
+// Done with a row read from the shards
+static int rowRead(RPNet *nc, SearchResult *r) {
+  if (nc->cacheRecorder &&
+      !CoordResultRecorder_AddRow(nc->cacheRecorder, nc->lookup, SearchResult_GetRowData(r))) {
+    stopRecording(nc);
+  }
+  return RS_RESULT_OK;
+}
+
 void RPNet_resetCurrent(RPNet *nc) {
+    BinaryRowsReader_Free(&nc->binaryRows);
     nc->current.root = NULL;
     nc->current.rows = NULL;
     nc->current.meta = NULL;
@@ -263,6 +377,8 @@ int rpnetNext(ResultProcessor *self, SearchResult *r) {
         if (resp3) {
           MRReply *warning = MRReply_MapElement(nc->current.meta, "warning");
           if (MRReply_Length(warning) > 0) {
+            // The rows may be partial
+            stopRecording(nc);
             const char *warning_str = MRReply_String(MRReply_ArrayElement(warning, 0), NULL);
             // Set an error to be later picked up and sent as a warning
             if (!strcmp(warning_str, QueryError_Strerror(QUERY_ERROR_CODE_TIMED_OUT))) {
@@ -290,12 +406,14 @@ int rpnetNext(ResultProcessor *self, SearchResult *r) {
 
   // get the next reply from the channel
   while (!root) {
-    if (TimedOut(&nc->areq->sctx->time.timeout)) {
+    if (TimedOut(&nc->areq->sctx->time.timeout) ||
+        QueryCancelToken_IsCancelled(AREQ_QueryProcessingCtx(nc->areq)->cancel)) {
       // Set the `timedOut` flag in the MRIteratorCtx, later to be read by the
       // callback so that a `CURSOR DEL` command will be dispatched instead of
-      // a `CURSOR READ` command.
+      // a `CURSOR READ` command. The DEL also cancels the reads in progress on the shards.
       MRIteratorCallback_SetTimedOut(MRIterator_GetCtx(nc->it));
 
+      stopRecording(nc);
       return RS_RESULT_TIMEDOUT;
     } else if (MRIteratorCallback_GetTimedOut(MRIterator_GetCtx(nc->it))) {
       // if timeout was set in previous reads, reset it
@@ -303,6 +421,10 @@ int rpnetNext(ResultProcessor *self, SearchResult *r) {
     }
 
     if (!getNextReply(nc)) {
+      if (nc->cacheRecorder) {
+        CoordResultRecorder_Store(nc->cacheRecorder, MRIterator_NumCommands(nc->it));
+        nc->cacheRecorder = NULL;
+      }
       return RS_RESULT_EOF;
     }
 
@@ -336,17 +458,49 @@ int rpnetNext(ResultProcessor *self, SearchResult *r) {
 
   // invariant: at least one row exists
   if (new_reply) {
+    nc->curIdx = resp3 ? 0 : 1;
+    // The binary rows are sent as a single string instead of the rows
+    MRReply *first = MRReply_ArrayElement(rows, nc->curIdx);
+    bool binary = MRReply_Type(first) == MR_REPLY_STRING;
+    if (binary) {
+      size_t len;
+      const char *data = MRReply_String(first, &len);
+      BinaryRowsReader_Init(&nc->binaryRows, data, len, nc->lookup);
+      RS_LOG_ASSERT(!BinaryRowsReader_AtEnd(&nc->binaryRows), "empty binary rows");
+    }
+    size_t totalResults;
     if (resp3) { // RESP3
-      nc->curIdx = 0;
-      nc->base.parent->totalResults += MRReply_Length(rows);
+      totalResults = binary ? nc->binaryRows.numRows : MRReply_Length(rows);
       processResultFormat(&nc->areq->reqflags, nc->current.meta);
+      if (nc->cacheRecorder) {
+        nc->cacheRecorder->hasFormat = true;
+        nc->cacheRecorder->formatExpand = nc->areq->reqflags & QEXEC_FORMAT_EXPAND;
+      }
     } else { // RESP2
       // Get the index from the first
-      nc->base.parent->totalResults += MRReply_Integer(MRReply_ArrayElement(rows, 0));
-      nc->curIdx = 1;
+      totalResults = MRReply_Integer(MRReply_ArrayElement(rows, 0));
+    }
+    nc->base.parent->totalResults += totalResults;
+    if (nc->cacheRecorder) {
+      nc->cacheRecorder->totalResults += totalResults;
+    }
+    if (MRIterator_IsCommandStopped(nc->it, nc->current.shard)) {
+      // The reply was sent before its shard was stopped
+      RPNet_SkipShard(self);
+      return rpnetNext(self, r);
     }
   }
 
+  if (!BinaryRowsReader_AtEnd(&nc->binaryRows)) {
+    BinaryRowsReader_Next(&nc->binaryRows, SearchResult_GetRowDataMut(r));
+    if (BinaryRowsReader_AtEnd(&nc->binaryRows)) {
+      // Done with the string of the rows
+      BinaryRowsReader_Free(&nc->binaryRows);
+      nc->curIdx++;
+    }
+    return rowRead(nc, r);
+  }
+
   MRReply *score = NULL;
   MRReply *fields = MRReply_ArrayElement(rows, nc->curIdx++);
   if (resp3) {
@@ -375,7 +529,7 @@ int rpnetNext(ResultProcessor *self, SearchResult *r) {
     RSValue *v = MRReply_ToValue(val);
     RLookup_WriteOwnKeyByName(nc->lookup, field, len, SearchResult_GetRowDataMut(r), v);
   }
-  return RS_RESULT_OK;
+  return rowRead(nc, r);
 }
 
 int rpnetNext_EOF(ResultProcessor *self, SearchResult *r) {
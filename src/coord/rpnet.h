@@ -14,7 +14,9 @@
 #include "result_processor.h"
 #include "rmr/rmr.h"
 #include "aggregate/aggregate.h"
+#include "aggregate/binary_rows.h"
 #include "hybrid/hybrid_cursor_mappings.h"
+#include "result_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,10 +28,14 @@ typedef struct {
     MRReply *root;  // Root reply. We need to free this when done with the rows
     MRReply *rows;  // Array containing reply rows for quick access
     MRReply *meta;  // Metadata for the current reply, if any (RESP3)
+    size_t shard;   // Index of the command of the iterator the reply is for
   } current;
   // Lookup - the rows are written in here
   RLookup *lookup;
   size_t curIdx;
+  // The rows of the current reply when the shard sent them in the binary encoding. They are all
+  // in the element of `current.rows` at `curIdx`
+  BinaryRowsReader binaryRows;
   MRIterator *it;
   MRCommand cmd;
   AREQ *areq;
@@ -39,6 +45,14 @@ typedef struct {
 
   // profile vars
   arrayof(MRReply *) shardsProfile;
+
+  // The result cache, when the query may use it. The rows are either replayed from a cached entry,
+  // or recorded into a new one as they are read from the shards
+  bool useCache;
+  uint64_t localRevision;  // Of the local index, when the query was parsed
+  CoordResultRecorder *cacheRecorder;
+  CoordCachedResult *cached;
+  arrayof(RLookupKey *) cachedKeys;  // The key of each column of the cached rows
 } RPNet;
 
 
@@ -49,6 +63,14 @@ int rpnetNext(ResultProcessor *self, SearchResult *r);
 int rpnetNext_EOF(ResultProcessor *self, SearchResult *r);
 int rpnetNext_StartWithMappings(ResultProcessor *rp, SearchResult *r);
 
+/* Drops the rest of the rows of the current reply, along with the next replies of its shard,
+ * whose cursor is deleted instead of read on. Used by a sorter on top of the shards' sorted rows */
+void RPNet_SkipShard(ResultProcessor *rp);
+
+/* Look the rows of the command up in the result cache. Returns true on a hit, after which the rows
+ * are replayed from the cache. Otherwise they are recorded as they are read from the shards */
+bool RPNet_ReadFromCache(RPNet *nc);
+
 
 #ifdef __cplusplus
 }
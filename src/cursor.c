@@ -244,12 +244,8 @@ done:
   return cur;
 }
 
-int Cursor_Pause(Cursor *cur) {
-  CursorList *cl = getCursorList(cur->is_coord);
-
-  CursorList_Lock(cl);
-  CursorList_IncrCounter(cl);
-
+// The cursors list is assumed to be locked upon calling this function
+static void Cursor_PauseInternal(CursorList *cl, Cursor *cur) {
   if (cur->delete_mark) {
     // Cursor is marked for deletion, we need to free it.
     Cursor_FreeInternal(cur);
@@ -266,11 +262,55 @@ int Cursor_Pause(Cursor *cur) {
     cur->pos = ARRAY_GETSIZE_AS(&cl->idle, Cursor **);
     *(Cursor **)(ARRAY_ADD_AS(&cl->idle, Cursor *)) = cur;
   }
+}
+
+int Cursor_Pause(Cursor *cur) {
+  CursorList *cl = getCursorList(cur->is_coord);
 
+  CursorList_Lock(cl);
+  CursorList_IncrCounter(cl);
+  Cursor_PauseInternal(cl, cur);
   CursorList_Unlock(cl);
   return REDISMODULE_OK;
 }
 
+void Cursor_StartReadAhead(Cursor *cur) {
+  CursorList *cl = getCursorList(cur->is_coord);
+  CursorList_Lock(cl);
+  cur->readingAhead = true;
+  CursorList_Unlock(cl);
+}
+
+void *Cursor_EndReadAhead(Cursor *cur) {
+  CursorList *cl = getCursorList(cur->is_coord);
+  CursorList_Lock(cl);
+  CursorList_IncrCounter(cl);
+
+  cur->readingAhead = false;
+  void *read = cur->queuedRead;
+  if (cur->readQueued) {
+    // The reader runs the read itself if it did not hand it off yet
+    cur->readQueued = false;
+    cur->queuedRead = NULL;
+  } else {
+    Cursor_PauseInternal(cl, cur);
+  }
+
+  CursorList_Unlock(cl);
+  return read;
+}
+
+bool Cursor_QueueRead(Cursor *cur, void *read) {
+  CursorList *cl = getCursorList(cur->is_coord);
+  CursorList_Lock(cl);
+  bool queued = cur->readingAhead;
+  if (queued) {
+    cur->queuedRead = read;
+  }
+  CursorList_Unlock(cl);
+  return queued;
+}
+
 Cursor *Cursors_TakeForExecution(CursorList *cl, uint64_t cid) {
   CursorList_Lock(cl);
   CursorList_IncrCounter(cl);
@@ -292,6 +332,30 @@ Cursor *Cursors_TakeForExecution(CursorList *cl, uint64_t cid) {
   return cur;
 }
 
+Cursor *Cursors_TakeForRead(CursorList *cl, uint64_t cid, bool *queued) {
+  CursorList_Lock(cl);
+  CursorList_IncrCounter(cl);
+
+  Cursor *cur = NULL;
+  *queued = false;
+  khiter_t iter = kh_get(cursors, cl->lookup, cid);
+  if (iter != kh_end(cl->lookup)) {
+    cur = kh_value(cl->lookup, iter);
+    if (Cursor_IsIdle(cur)) {
+      Cursor_RemoveFromIdle(cur);
+    } else if (cur->readingAhead && !cur->readQueued && !cur->delete_mark) {
+      // The worker reading ahead keeps the cursor taken for this read
+      cur->readQueued = true;
+      *queued = true;
+    } else {
+      cur = NULL;
+    }
+  }
+
+  CursorList_Unlock(cl);
+  return cur;
+}
+
 int Cursors_Purge(CursorList *cl, uint64_t cid) {
   CursorList_Lock(cl);
   CursorList_IncrCounter(cl);
@@ -308,6 +372,7 @@ int Cursors_Purge(CursorList *cl, uint64_t cid) {
       // Cursor is not idle, and we don't own it. We need to mark it for deletion.
       // This is used when the cursor is still in use by another connection.
       cur->delete_mark = true;
+      QueryCancelToken_Cancel(&cur->cancel);
     }
     rc = REDISMODULE_OK;
   } else {
@@ -376,6 +441,7 @@ void CursorList_Empty(CursorList *cl) {
       // Since the cursor is not idle, we mark it for deletion.
       // The next time the cursor is accessed, it will be freed.
       cur->delete_mark = true;
+      QueryCancelToken_Cancel(&cur->cancel);
     }
   }
   CursorList_Unlock(cl);
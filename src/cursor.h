@@ -58,6 +58,16 @@ typedef struct Cursor {
   /** If true, a call to `Cursor_Pause` should drop it instead.
    *  Should only be accessed under cursor list lock */
   bool delete_mark;
+
+  /** Stops the read in progress when the cursor is marked for deletion */
+  QueryCancelToken cancel;
+
+  /** Set while a worker reads the next chunk of the cursor ahead of its client, and whether a
+   *  read of the cursor came meanwhile, which is then queued on it.
+   *  Should only be accessed under cursor list lock */
+  bool readingAhead;
+  bool readQueued;
+  void *queuedRead;
 } Cursor;
 
 KHASH_MAP_INIT_INT64(cursors, Cursor *);
@@ -171,6 +181,33 @@ Cursor *Cursors_Reserve(CursorList *cl, StrongRef global_spec_ref, unsigned time
  */
 Cursor *Cursors_TakeForExecution(CursorList *cl, uint64_t cid);
 
+/**
+ * Retrieve a cursor for a read. Like Cursors_TakeForExecution(), unless a worker is reading the
+ * cursor ahead: the cursor is then returned with `*queued` set, and the caller must hand the read
+ * off with Cursor_QueueRead()
+ */
+Cursor *Cursors_TakeForRead(CursorList *cl, uint64_t cid, bool *queued);
+
+/**
+ * Hand off a read queued by Cursors_TakeForRead() to the worker reading the cursor ahead. Returns
+ * false if the worker is done already, in which case the cursor is taken for the caller to run the
+ * read
+ */
+bool Cursor_QueueRead(Cursor *cur, void *read);
+
+/**
+ * Keep a taken cursor from being paused while its next chunk is read ahead, so that a read of the
+ * cursor meanwhile is queued rather than failing
+ */
+void Cursor_StartReadAhead(Cursor *cur);
+
+/**
+ * Done reading the cursor ahead. If a read was queued meanwhile, the cursor stays taken, and the
+ * read is returned for the caller to run if it was handed off already. Otherwise the cursor is
+ * paused, and NULL is returned
+ */
+void *Cursor_EndReadAhead(Cursor *cur);
+
 /**
  * Pause a cursor, setting it to idle and placing it back in the cursor
  * list
@@ -29,6 +29,7 @@
 #include "reply_macros.h"
 #include "obfuscation/obfuscation_api.h"
 #include "info/info_command.h"
+#include "info/profile_stats.h"
 #include "iterators/inverted_index_iterator.h"
 
 DebugCTX globalDebugCtx = {0};
@@ -589,7 +590,7 @@ DEBUG_COMMAND(DumpTagIndex) {
     goto end;
   }
 
-  TrieMapIterator *iter = TrieMap_Iterate(tagIndex->values);
+  TagValuesIterator *iter = TagIndex_IterateValues(tagIndex, NULL, 0, TM_PREFIX_MODE);
 
   char *tag;
   tm_len_t len;
@@ -597,7 +598,7 @@ DEBUG_COMMAND(DumpTagIndex) {
 
   size_t resultSize = 0;
   RedisModule_ReplyWithArray(sctx->redisCtx, REDISMODULE_POSTPONED_ARRAY_LEN);
-  while (TrieMapIterator_Next(iter, &tag, &len, (void **)&iv)) {
+  while (TagValuesIterator_Next(iter, &tag, &len, &iv)) {
     RedisModule_ReplyWithArray(sctx->redisCtx, 2);
     RedisModule_ReplyWithStringBuffer(sctx->redisCtx, tag, len);
     IndexDecoderCtx decoderCtx = {.field_mask_tag = IndexDecoderCtx_FieldMask, .field_mask = RS_FIELDMASK_ALL};
@@ -609,7 +610,7 @@ DEBUG_COMMAND(DumpTagIndex) {
     ++resultSize;
   }
   RedisModule_ReplySetArrayLength(sctx->redisCtx, resultSize);
-  TrieMapIterator_Free(iter);
+  TagValuesIterator_Free(iter);
 
 end:
   SearchCtx_Free(sctx);
@@ -1071,13 +1072,13 @@ typedef struct {
   const char *prefix;
 } DumpOptions;
 
-static void seekTagIterator(TrieMapIterator *it, size_t offset) {
+static void seekTagIterator(TagValuesIterator *it, size_t offset) {
   char *tag;
   tm_len_t len;
   InvertedIndex *iv;
 
   for (size_t n = 0; n < offset; n++) {
-    if (!TrieMapIterator_Next(it, &tag, &len, (void **)&iv)) {
+    if (!TagValuesIterator_Next(it, &tag, &len, &iv)) {
       break;
     }
   }
@@ -1130,7 +1131,7 @@ DEBUG_COMMAND(InfoTagIndex) {
   size_t nelem = 0;
   RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
   RedisModule_ReplyWithLiteral(ctx, "num_values");
-  RedisModule_ReplyWithLongLong(ctx, TrieMap_NUniqueKeys(idx->values));
+  RedisModule_ReplyWithLongLong(ctx, TagIndex_NumValues(idx));
   nelem += 2;
 
   if (options.dumpIdEntries) {
@@ -1142,7 +1143,7 @@ DEBUG_COMMAND(InfoTagIndex) {
   }
 
   size_t limit = options.limit ? options.limit : 0;
-  TrieMapIterator *iter = TrieMap_Iterate(idx->values);
+  TagValuesIterator *iter = TagIndex_IterateValues(idx, NULL, 0, TM_PREFIX_MODE);
   char *tag;
   tm_len_t len;
   InvertedIndex *iv;
@@ -1153,7 +1154,7 @@ DEBUG_COMMAND(InfoTagIndex) {
 
   seekTagIterator(iter, options.offset);
   size_t nvalues = 0;
-  while (nvalues++ < limit && TrieMapIterator_Next(iter, &tag, &len, (void **)&iv)) {
+  while (nvalues++ < limit && TagValuesIterator_Next(iter, &tag, &len, &iv)) {
     size_t nsubelem = 8;
     if (!options.dumpIdEntries) {
       nsubelem -= 2;
@@ -1181,7 +1182,7 @@ DEBUG_COMMAND(InfoTagIndex) {
 
     RedisModule_ReplySetArrayLength(ctx, nsubelem);
   }
-  TrieMapIterator_Free(iter);
+  TagValuesIterator_Free(iter);
   RedisModule_ReplySetArrayLength(ctx, nvalues - 1);
 
 reply_done:
@@ -1490,6 +1491,9 @@ DEBUG_COMMAND(WorkerThreadsSwitch) {
     REPLY_WITH_LONG_LONG("highPriorityPendingJobs", stats.high_priority_pending_jobs, ARRAY_LEN_VAR(num_stats_fields));
     REPLY_WITH_LONG_LONG("lowPriorityPendingJobs", stats.low_priority_pending_jobs, ARRAY_LEN_VAR(num_stats_fields));
     REPLY_WITH_LONG_LONG("numThreadsAlive", stats.num_threads_alive, ARRAY_LEN_VAR(num_stats_fields));
+    REPLY_WITH_LONG_LONG("localPendingJobs", stats.local_pending_jobs, ARRAY_LEN_VAR(num_stats_fields));
+    REPLY_WITH_LONG_LONG("lockContentions", stats.lock_contentions, ARRAY_LEN_VAR(num_stats_fields));
+    REPLY_WITH_LONG_LONG("stolenJobs", stats.stolen_jobs, ARRAY_LEN_VAR(num_stats_fields));
     END_POSTPONED_LEN_ARRAY(num_stats_fields);
     return REDISMODULE_OK;
   }  else if (!strcasecmp(op, "n_threads")) {
@@ -2054,6 +2058,31 @@ DEBUG_COMMAND(DumpSchema) {
   return REDISMODULE_OK;
 }
 
+/**
+ * FT.DEBUG PROFILE_STATS [RESET]
+ * Reply with the totals of the sampled profile of the queries (see _PROFILE_SAMPLE_RATE), or reset
+ * them.
+ */
+DEBUG_COMMAND(ProfileStats) {
+  if (!debugCommandsEnabled(ctx)) {
+    return RedisModule_ReplyWithError(ctx, NODEBUG_ERR);
+  }
+  if (argc > 3) {
+    return RedisModule_WrongArity(ctx);
+  }
+  if (argc == 3) {
+    if (strcasecmp(RedisModule_StringPtrLen(argv[2], NULL), "RESET")) {
+      return RedisModule_ReplyWithError(ctx, "Invalid argument. Expected RESET");
+    }
+    ProfileStats_Reset();
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+  }
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  ProfileStats_Reply(reply);
+  RedisModule_EndReply(reply);
+  return REDISMODULE_OK;
+}
+
 DebugCommandType commands[] = {{"DUMP_INVIDX", DumpInvertedIndex}, // Print all the inverted index entries.
                                {"DUMP_NUMIDX", DumpNumericIndex}, // Print all the headers (optional) + entries of the numeric tree.
                                {"DUMP_NUMIDXTREE", DumpNumericIndexTree}, // Print tree general info, all leaves + nodes + stats
@@ -2093,6 +2122,7 @@ DebugCommandType commands[] = {{"DUMP_INVIDX", DumpInvertedIndex}, // Print all
                                {"INDEXER_SLEEP_BEFORE_YIELD_MICROS", IndexerSleepBeforeYieldMicros},
                                {"QUERY_CONTROLLER", queryController},
                                {"DUMP_SCHEMA", DumpSchema},
+                               {"PROFILE_STATS", ProfileStats},
                                /**
                                 * The following commands are for debugging distributed search/aggregation.
                                 */
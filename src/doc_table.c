@@ -12,12 +12,19 @@
 #include <stdio.h>
 #include "redismodule.h"
 #include "util/fnv.h"
-#include "triemap.h"
 #include "sortable.h"
 #include "rmalloc.h"
+#include "util/slab.h"
 #include "spec.h"
 #include "config.h"
 
+// The metadata of all the documents, shared by all the tables since a metadata may outlive its table
+static Slab dmdSlab = SLAB_INITIALIZER(sizeof(RSDocumentMetadata));
+
+RSDocumentMetadata *DMD_Alloc(void) {
+  return Slab_Alloc(&dmdSlab);
+}
+
 /* Creates a new DocTable with a given capacity */
 DocTable NewDocTable(size_t cap, size_t max_size) {
   DocTable ret = {
@@ -53,10 +60,8 @@ static RSDocumentMetadata *DocTable_GetOwn(const DocTable *t, t_docId docId) {
   // While we iterate over the chain, we have locked the index spec (R/W), so we either a writer alone or
   // multiple readers. In any case, we can safely iterate over the chain without a lock and
   // increment the ref count of the document metadata when we find it.
-  DMDChain *dmdChain = &t->buckets[bucketIndex];
-  DLLIST2_FOREACH(it, &dmdChain->lroot) {
-    RSDocumentMetadata *dmd = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-
+  // Until the ids wrap around the maximum size of the table, the bucket holds a single document.
+  for (RSDocumentMetadata *dmd = t->buckets[bucketIndex].head; dmd; dmd = dmd->next) {
     if (dmd->id == docId) {
       if (dmd->flags & Document_Deleted) {
         return NULL;
@@ -75,22 +80,30 @@ const RSDocumentMetadata *DocTable_Borrow(const DocTable *t, t_docId docId) {
   return dmd;
 }
 
+const RSDocumentMetadata *DocTable_Lookup(const DocTable *t, t_docId docId) {
+  return DocTable_GetOwn(t, docId);
+}
+
 bool DocTable_Exists(const DocTable *t, t_docId docId) {
-  if (!docId || docId > t->maxDocId) {
-    return 0;
-  }
-  uint32_t ix = DocTable_GetBucket(t, docId);
-  if (ix >= t->cap) {
-    return 0;
-  }
-  const DMDChain *chain = t->buckets + ix;
-  if (chain == NULL) {
+  return DocTable_GetOwn(t, docId) != NULL;
+}
+
+t_docId DocTable_NextId(const DocTable *t, t_docId docId) {
+  docId = MAX(docId, 1);
+  if (t->maxDocId < t->maxSize) {
+    // Until the ids wrap around, the bucket of an id only holds its own document, so the empty
+    // buckets of the deleted documents are skipped without looking at any document
+    for (t_docId end = MIN(t->maxDocId + 1, t->cap); docId < end; docId++) {
+      const RSDocumentMetadata *dmd = t->buckets[docId].head;
+      if (dmd && !(dmd->flags & Document_Deleted)) {
+        return docId;
+      }
+    }
     return 0;
   }
-  DLLIST2_FOREACH(it, &chain->lroot) {
-    const RSDocumentMetadata *md = DLLIST2_ITEM(it, RSDocumentMetadata, llnode);
-    if (md->id == docId) {
-      return !(md->flags & Document_Deleted);
+  for (; docId <= t->maxDocId; docId++) {
+    if (DocTable_GetOwn(t, docId)) {
+      return docId;
     }
   }
   return 0;
@@ -135,8 +148,9 @@ static inline void DocTable_Set(DocTable *t, t_docId docId, RSDocumentMetadata *
   DMDChain *chain = &t->buckets[bucket];
   dmd->ref_count = 1; // Index reference
 
-  // Adding the dmd to the chain
-  dllist2_append(&chain->lroot, &dmd->llnode);
+  // Adding the dmd to the head of the chain, where the most recent documents are looked up first
+  dmd->next = chain->head;
+  chain->head = dmd;
 }
 
 /** Get the docId of a key if it exists in the table, or 0 if it doesn't */
@@ -198,10 +212,17 @@ int DocTable_SetSortingVector(DocTable *t, RSDocumentMetadata *dmd, RSSortingVec
   dmd->sortVector = v;
   dmd->flags |= Document_HasSortVector;
   t->sortablesSize += RSSortingVector_GetMemorySize(v);
+  RSSortingColumns_Set(&t->sortingColumns, dmd->id, v, t->maxSize);
 
   return 1;
 }
 
+void DocTable_SortingVectorUpdated(DocTable *t, const RSDocumentMetadata *dmd) {
+  if (dmd->sortVector) {
+    RSSortingColumns_Set(&t->sortingColumns, dmd->id, dmd->sortVector, t->maxSize);
+  }
+}
+
 void DocTable_SetByteOffsets(RSDocumentMetadata *dmd, RSByteOffsets *v) {
   if (!dmd) {
     return;
@@ -218,6 +239,12 @@ void DocTable_UpdateExpiration(DocTable *t, RSDocumentMetadata* dmd, t_expiratio
   }
 }
 
+void DocTable_AddFieldExpirations(DocTable *t, RSDocumentMetadata *dmd, arrayof(FieldExpiration) sortedById) {
+  dmd->flags |= Document_HasExpiration;
+  TimeToLiveTable_VerifyInit(&t->ttl);
+  TimeToLiveTable_AddFields(t->ttl, dmd->id, sortedById);
+}
+
 bool DocTable_IsDocExpired(DocTable* t, const RSDocumentMetadata* dmd, struct timespec* expirationPoint) {
   if (!hasExpirationTimeInformation(dmd->flags)) {
       return false;
@@ -240,15 +267,10 @@ RSDocumentMetadata *DocTable_Put(DocTable *t, const char *s, size_t n, double sc
   }
   t_docId docId = ++t->maxDocId;
 
-  RSDocumentMetadata *dmd;
+  RSDocumentMetadata *dmd = DMD_Alloc();
+  t->memsize += Slab_ObjectSize(&dmdSlab);
   if (payload && payloadSize) {
-    dmd = rm_calloc(1, sizeof(*dmd));
     flags |= Document_HasPayload;
-    t->memsize += sizeof(RSDocumentMetadata);
-  } else {
-    size_t leanSize = sizeof(*dmd) - sizeof(RSPayload *);
-    dmd = rm_calloc(1, leanSize);
-    t->memsize += leanSize;
   }
 
   sds keyPtr = sdsnewlen(s, n);
@@ -274,7 +296,7 @@ RSDocumentMetadata *DocTable_Put(DocTable *t, const char *s, size_t n, double sc
   DocTable_Set(t, docId, dmd);
   ++t->size;
   t->memsize += sdsAllocSize(keyPtr);
-  DocIdMap_Put(&t->dim, s, n, docId);
+  DocIdMap_Put(&t->dim, keyPtr, docId);
   DMD_Incref(dmd); // Reference for the caller
   return dmd;
 }
@@ -319,31 +341,33 @@ void DMD_Free(const RSDocumentMetadata *cmd) {
     md->flags &= ~Document_HasOffsetVector;
   }
   sdsfree(md->keyPtr);
-  rm_free(md);
+  Slab_Free(&dmdSlab, md);
 }
 
 void DocTable_Free(DocTable *t) {
-  for (int i = 0; i < t->cap; ++i) {
-    DMDChain *chain = &t->buckets[i];
-    if (DLLIST2_IS_EMPTY(&chain->lroot)) {
-      continue;
-    }
-    DLLIST2_node *nn = chain->lroot.head;
-    while (nn) {
-      RSDocumentMetadata *md = DLLIST2_ITEM(nn, RSDocumentMetadata, llnode);
-      nn = nn->next;
+  for (size_t i = 0; i < t->cap; ++i) {
+    RSDocumentMetadata *md = t->buckets[i].head;
+    while (md) {
+      RSDocumentMetadata *next = md->next;
+      md->next = NULL;
       DMD_Return(md);
+      md = next;
     }
   }
   rm_free(t->buckets);
   TimeToLiveTable_Destroy(&t->ttl);
   DocIdMap_Free(&t->dim);
+  RSSortingColumns_Free(&t->sortingColumns);
 }
 
 static void DocTable_DmdUnchain(DocTable *t, RSDocumentMetadata *md) {
   uint32_t bucketIndex = DocTable_GetBucket(t, md->id);
-  DMDChain *dmdChain = &t->buckets[bucketIndex];
-  dllist2_delete(&dmdChain->lroot, &md->llnode);
+  RSDocumentMetadata **link = &t->buckets[bucketIndex].head;
+  while (*link != md) {
+    link = &(*link)->next;
+  }
+  *link = md->next;
+  md->next = NULL;
 }
 
 int DocTable_Delete(DocTable *t, const char *s, size_t n) {
@@ -376,15 +400,13 @@ RSDocumentMetadata *DocTable_Pop(DocTable *t, const char *s, size_t n) {
     // all the next operations don't need to be atomic
     md->flags |= Document_Deleted;
 
-    t->memsize -= sdsAllocSize(md->keyPtr);
-    if (!hasPayload(md->flags)) {
-      t->memsize -= sizeof(RSDocumentMetadata) - sizeof(RSPayload *);
-    } else {
-      t->memsize -= sizeof(RSDocumentMetadata);
+    t->memsize -= sdsAllocSize(md->keyPtr) + Slab_ObjectSize(&dmdSlab);
+    if (hasPayload(md->flags)) {
       t->memsize -= md->payload->len + sizeof(RSPayload);
     }
     if (md->sortVector) {
       t->sortablesSize -= RSSortingVector_GetMemorySize(md->sortVector);
+      RSSortingColumns_Clear(&t->sortingColumns, md->id);
     }
 
     DocTable_DmdUnchain(t, md);
@@ -405,12 +427,12 @@ int DocTable_Replace(DocTable *t, const char *from_str, size_t from_len, const c
     return REDISMODULE_ERR;
   }
   DocIdMap_Delete(&t->dim, from_str, from_len);
-  DocIdMap_Put(&t->dim, to_str, to_len, id);
   RSDocumentMetadata *dmd = DocTable_GetOwn(t, id);
   t->memsize -= sdsAllocSize(dmd->keyPtr);
   sdsfree(dmd->keyPtr);
   dmd->keyPtr = sdsnewlen(to_str, to_len);
   t->memsize += sdsAllocSize(dmd->keyPtr);
+  DocIdMap_Put(&t->dim, dmd->keyPtr, id);
   return REDISMODULE_OK;
 }
 
@@ -443,7 +465,7 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
   for (size_t i = 1; i < t->size; i++) {
     size_t len;
 
-    RSDocumentMetadata *dmd = rm_calloc(1, sizeof(RSDocumentMetadata));
+    RSDocumentMetadata *dmd = DMD_Alloc();
     char *tmpPtr = RedisModule_LoadStringBuffer(rdb, &len);
     if (encver < INDEX_MIN_BINKEYS_VERSION) {
       // Previous versions would encode the NUL byte
@@ -502,47 +524,155 @@ void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver) {
       ++deletedElements;
       DMD_Free(dmd);
     } else {
-      DocIdMap_Put(&t->dim, dmd->keyPtr, sdslen(dmd->keyPtr), dmd->id);
+      DocIdMap_Put(&t->dim, dmd->keyPtr, dmd->id);
       DocTable_Set(t, dmd->id, dmd);
-      t->memsize += sizeof(RSDocumentMetadata) + len;
+      t->memsize += Slab_ObjectSize(&dmdSlab) + len;
+      if (dmd->sortVector) {
+        RSSortingColumns_Set(&t->sortingColumns, dmd->id, dmd->sortVector, t->maxSize);
+      }
     }
   }
   t->size -= deletedElements;
 }
 
-DocIdMap NewDocIdMap() {
-
-  TrieMap *m = NewTrieMap();
-  return (DocIdMap){m};
+void DocTable_RdbSave(const DocTable *t, RedisModuleIO *rdb) {
+  size_t numDocs = 0;
+  DOCTABLE_FOREACH(t, numDocs++);
+  RedisModule_SaveUnsigned(rdb, numDocs);
+  RedisModule_SaveUnsigned(rdb, t->maxDocId);
+  RedisModule_SaveUnsigned(rdb, t->maxSize);
+  DOCTABLE_FOREACH(t, {
+    RSDocumentFlags flags = dmd->flags;
+    if (!dmd->sortVector) flags &= ~Document_HasSortVector;
+    if (!dmd->byteOffsets) flags &= ~Document_HasOffsetVector;
+    RedisModule_SaveStringBuffer(rdb, dmd->keyPtr, sdslen(dmd->keyPtr));
+    RedisModule_SaveUnsigned(rdb, dmd->id);
+    RedisModule_SaveUnsigned(rdb, flags);
+    RedisModule_SaveUnsigned(rdb, dmd->maxFreq);
+    RedisModule_SaveUnsigned(rdb, dmd->len);
+    RedisModule_SaveUnsigned(rdb, dmd->type);
+    RedisModule_SaveUnsigned(rdb, dmd->digest);
+    RedisModule_SaveFloat(rdb, dmd->score);
+    if (hasPayload(dmd->flags)) {
+      RedisModule_SaveStringBuffer(rdb, dmd->payload->data, dmd->payload->len);
+    }
+    if (flags & Document_HasSortVector) {
+      SortingVector_RdbSave(rdb, dmd->sortVector);
+    }
+    if (flags & Document_HasOffsetVector) {
+      Buffer b;
+      Buffer_Init(&b, 16);
+      RSByteOffsets_Serialize(dmd->byteOffsets, &b);
+      RedisModule_SaveStringBuffer(rdb, b.data, b.offset);
+      Buffer_Free(&b);
+    }
+  });
 }
 
-t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n) {
+int DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb) {
+  const size_t numDocs = RedisModule_LoadUnsigned(rdb);
+  t->maxDocId = RedisModule_LoadUnsigned(rdb);
+  t->maxSize = RedisModule_LoadUnsigned(rdb);
+  if (RedisModule_IsIOError(rdb)) {
+    return REDISMODULE_ERR;
+  }
 
-  void *val = TrieMap_Find(m->tm, (char *)s, n);
-  if (val && val != TRIEMAP_NOTFOUND) {
-    return *((t_docId *)val);
+  if (t->maxDocId > t->maxSize) {
+    // As in DocTable_LegacyRdbLoad(), every bucket may be looked up
+    t->memsize -= t->cap * sizeof(DMDChain);
+    t->cap = t->maxSize;
+    rm_free(t->buckets);
+    t->buckets = rm_calloc(t->cap, sizeof(*t->buckets));
+    t->memsize += t->cap * sizeof(DMDChain);
   }
-  return 0;
-}
 
-void *_docIdMap_replace(void *oldval, void *newval) {
-  if (oldval) {
-    rm_free(oldval);
+  for (size_t i = 0; i < numDocs; i++) {
+    size_t len;
+    char *key = RedisModule_LoadStringBuffer(rdb, &len);
+    if (RedisModule_IsIOError(rdb)) {
+      return REDISMODULE_ERR;
+    }
+    RSDocumentMetadata *dmd = DMD_Alloc();
+    dmd->keyPtr = sdsnewlen(key, len);
+    RedisModule_Free(key);
+    dmd->id = RedisModule_LoadUnsigned(rdb);
+    dmd->flags = RedisModule_LoadUnsigned(rdb);
+    dmd->maxFreq = RedisModule_LoadUnsigned(rdb);
+    dmd->len = RedisModule_LoadUnsigned(rdb);
+    dmd->type = RedisModule_LoadUnsigned(rdb);
+    dmd->digest = RedisModule_LoadUnsigned(rdb);
+    dmd->score = RedisModule_LoadFloat(rdb);
+    if (hasPayload(dmd->flags)) {
+      // NUL terminated, as DocTable_Put() copies it
+      size_t payloadLen;
+      char *payload = RedisModule_LoadStringBuffer(rdb, &payloadLen);
+      dmd->payload = rm_malloc(sizeof(RSPayload));
+      dmd->payload->data = rm_calloc(1, payloadLen + 1);
+      dmd->payload->len = payloadLen;
+      if (payload) {
+        memcpy(dmd->payload->data, payload, payloadLen);
+        RedisModule_Free(payload);
+      }
+      t->memsize += payloadLen + sizeof(RSPayload);
+    }
+    if (dmd->flags & Document_HasSortVector) {
+      dmd->sortVector = SortingVector_RdbLoad(rdb);
+      if (dmd->sortVector) {
+        t->sortablesSize += RSSortingVector_GetMemorySize(dmd->sortVector);
+      }
+    }
+    if (dmd->flags & Document_HasOffsetVector) {
+      size_t nTmp = 0;
+      char *tmp = RedisModule_LoadStringBuffer(rdb, &nTmp);
+      if (tmp) {
+        Buffer *bufTmp = Buffer_Wrap(tmp, nTmp);
+        dmd->byteOffsets = LoadByteOffsets(bufTmp);
+        rm_free(bufTmp);
+        RedisModule_Free(tmp);
+      } else {
+        dmd->flags &= ~Document_HasOffsetVector;
+      }
+    }
+    if (RedisModule_IsIOError(rdb)) {
+      DMD_Free(dmd);
+      return REDISMODULE_ERR;
+    }
+
+    DocIdMap_Put(&t->dim, dmd->keyPtr, dmd->id);
+    DocTable_Set(t, dmd->id, dmd);
+    ++t->size;
+    t->memsize += Slab_ObjectSize(&dmdSlab) + sdsAllocSize(dmd->keyPtr);
+    if (dmd->sortVector) {
+      RSSortingColumns_Set(&t->sortingColumns, dmd->id, dmd->sortVector, t->maxSize);
+    }
   }
-  return newval;
+  return REDISMODULE_OK;
 }
 
-void DocIdMap_Put(DocIdMap *m, const char *s, size_t n, t_docId docId) {
+DocIdMap NewDocIdMap() {
+  KeyIdMap *m = rm_malloc(sizeof(*m));
+  KeyIdMap_Init(m);
+  return (DocIdMap){m};
+}
 
-  t_docId *pd = rm_malloc(sizeof(t_docId));
-  *pd = docId;
-  TrieMap_Add(m->tm, s, n, pd, _docIdMap_replace);
+t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n) {
+  return KeyIdMap_Get(m->map, s, n);
+}
+
+void DocIdMap_Put(DocIdMap *m, sds key, t_docId docId) {
+  KeyIdMap_Put(m->map, key, docId);
 }
 
 void DocIdMap_Free(DocIdMap *m) {
-  TrieMap_Free(m->tm, rm_free);
+  KeyIdMap_Destroy(m->map);
+  rm_free(m->map);
+  m->map = NULL;
 }
 
 int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n) {
-  return TrieMap_Delete(m->tm, s, n, rm_free);
+  return KeyIdMap_Delete(m->map, s, n);
+}
+
+size_t DocIdMap_MemUsage(const DocIdMap *m) {
+  return KeyIdMap_MemUsage(m->map);
 }
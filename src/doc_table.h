@@ -18,6 +18,7 @@
 #include "hiredis/sds.h"
 #include "rmutil/rm_assert.h"
 #include "ttl_table.h"
+#include "util/key_id_map.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,22 +37,27 @@ static inline RedisModuleString *DMD_CreateKeyString(const RSDocumentMetadata *d
   return RedisModule_CreateString(ctx, dmd->keyPtr, sdslen(dmd->keyPtr));
 }
 
-/* Map between external id an incremental id */
+/* Map between external id an incremental id. The map holds the keys of the documents by
+ * reference, so each key must stay valid while it is mapped */
 typedef struct {
-  TrieMap *tm;
+  KeyIdMap *map;
 } DocIdMap;
 
 DocIdMap NewDocIdMap();
 /* Get docId from a did-map. Returns 0  if the key is not in the map */
 t_docId DocIdMap_Get(const DocIdMap *m, const char *s, size_t n);
 
-/* Put a new doc id in the map if it does not already exist */
-void DocIdMap_Put(DocIdMap *m, const char *s, size_t n, t_docId docId);
+/* Put a new doc id in the map, or replace the id of the key if it is already in the map. The key
+ * is not copied, and is usually the key of the document metadata */
+void DocIdMap_Put(DocIdMap *m, sds key, t_docId docId);
 
 int DocIdMap_Delete(DocIdMap *m, const char *s, size_t n);
 /* Free the doc id map */
 void DocIdMap_Free(DocIdMap *m);
 
+/* The memory used by the map, excluding the keys which are accounted for by the table */
+size_t DocIdMap_MemUsage(const DocIdMap *m);
+
 /* The DocTable is a simple mapping between incremental ids and the original document key and
  * metadata. It is also responsible for storing the id incrementor for the index and assigning
  * new
@@ -61,8 +67,12 @@ void DocIdMap_Free(DocIdMap *m);
  * the
  * same key. This may result in document duplication in results  */
 
+/* A bucket of the table. The documents are stored in the bucket of their id, modulo the maximum
+ * size of the table, so that the buckets are directly indexed by the ids and hold a single document
+ * until the ids wrap around the maximum size. The documents of a bucket are chained through their
+ * `next` pointer, the most recently added first */
 typedef struct {
-  DLLIST2 lroot;
+  RSDocumentMetadata *head;
 } DMDChain;
 
 typedef struct {
@@ -76,18 +86,14 @@ typedef struct {
   DMDChain *buckets;
   DocIdMap dim;             // Mapping between document name to internal id
   TimeToLiveTable* ttl;
+  RSSortingColumns sortingColumns; // The numbers of the sorting vectors, by column
 } DocTable;
 
-#define DOCTABLE_FOREACH(dt, code)                                           \
-  for (size_t i = 0; i < dt->cap; ++i) {                                     \
-    DMDChain *chain = &dt->buckets[i];                                       \
-    if (DLLIST2_IS_EMPTY(&chain->lroot)) {                                   \
-      continue;                                                              \
-    }                                                                        \
-    DLLIST2_FOREACH(it, &chain->lroot) {                                     \
-      RSDocumentMetadata *dmd = DLLIST_ITEM(it, RSDocumentMetadata, llnode); \
-      code;                                                                  \
-    }                                                                        \
+#define DOCTABLE_FOREACH(dt, code)                                                   \
+  for (size_t i = 0; i < dt->cap; ++i) {                                             \
+    for (RSDocumentMetadata *dmd = dt->buckets[i].head; dmd; dmd = dmd->next) {      \
+      code;                                                                          \
+    }                                                                                \
   }
 
 /* Creates a new DocTable with a given capacity */
@@ -99,6 +105,10 @@ DocTable NewDocTable(size_t cap, size_t max_size);
  * If docId is not inside the table, we return NULL */
 const RSDocumentMetadata *DocTable_Borrow(const DocTable *t, t_docId docId);
 
+/* Get the metadata for a doc Id without taking a reference to it. The metadata is only valid
+ * while the spec stays locked, unless the caller takes a reference with DMD_Incref */
+const RSDocumentMetadata *DocTable_Lookup(const DocTable *t, t_docId docId);
+
 const RSDocumentMetadata *DocTable_BorrowByKeyR(const DocTable *r, RedisModuleString *s);
 
 /* Put a new document into the table, assign it an incremental id and store the metadata in the
@@ -122,10 +132,24 @@ int DocTable_SetPayload(DocTable *t, RSDocumentMetadata *dmd, const char *data,
 
 bool DocTable_Exists(const DocTable *t, t_docId docId);
 
+/* Returns the smallest id from `docId` on of a document in the table, or 0 if there is none up to
+ * the maximal id. Used to skip the ids of the deleted documents */
+t_docId DocTable_NextId(const DocTable *t, t_docId docId);
+
 /* Set the sorting vector for a document. If the vector is NULL we mark the doc as not having a
  * vector. Returns 1 on success, 0 if the document does not exist. No further validation is done */
 int DocTable_SetSortingVector(DocTable *t, RSDocumentMetadata *dmd, RSSortingVector *v);
 
+/* Updates the sorting columns of the table after the sorting vector of a document was modified in
+ * place */
+void DocTable_SortingVectorUpdated(DocTable *t, const RSDocumentMetadata *dmd);
+
+/* Returns the number of a document at a sortable index, or NaN if it is not in the sorting columns
+ * and has to be read from the sorting vector of the document */
+static inline double DocTable_GetSortingNumber(const DocTable *t, size_t idx, t_docId docId) {
+  return RSSortingColumns_GetNum(&t->sortingColumns, idx, docId);
+}
+
 /* Set the offset vector for a document. This contains the byte offsets of each token found in
  * the document. This is used for highlighting
  */
@@ -133,6 +157,10 @@ void DocTable_SetByteOffsets(RSDocumentMetadata *dmd, RSByteOffsets *offsets);
 
 void DocTable_UpdateExpiration(DocTable *t, RSDocumentMetadata* dmd, t_expirationTimePoint ttl, arrayof(FieldExpiration) allFieldSorted);
 
+/* Add the expiration times of fields which were not indexed for the document yet. Takes ownership
+ * of the array */
+void DocTable_AddFieldExpirations(DocTable *t, RSDocumentMetadata *dmd, arrayof(FieldExpiration) sortedById);
+
 typedef struct {
   FieldMaskOrIndex field;
   // our field expiration predicate
@@ -210,6 +238,10 @@ int DocTable_Replace(DocTable *t, const char *from_str, size_t from_len, const c
     RS_LOG_ASSERT(count < (1 << 16) - 1, "overflow of dmd ref_count");        \
   })
 
+/* Allocate a zeroed metadata from the slab of all the metadata. It is freed by DMD_Return once its
+ * ref count drops to zero */
+RSDocumentMetadata *DMD_Alloc(void);
+
 /* don't use this function directly. Use DMD_Return */
 void DMD_Free(const RSDocumentMetadata *);
 
@@ -223,6 +255,13 @@ static inline void DMD_Return(const RSDocumentMetadata *cdmd) {
 
 void DocTable_LegacyRdbLoad(DocTable *t, RedisModuleIO *rdb, int encver);
 
+/* Save the metadata of all the documents of the table to the RDB */
+void DocTable_RdbSave(const DocTable *t, RedisModuleIO *rdb);
+
+/* Load the documents saved by DocTable_RdbSave() into an empty table. Returns REDISMODULE_ERR on a
+ * short read, leaving the documents loaded so far in the table */
+int DocTable_RdbLoad(DocTable *t, RedisModuleIO *rdb);
+
 #ifdef __cplusplus
 }
 #endif
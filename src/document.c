@@ -28,6 +28,9 @@
 #include "redis_index.h"
 #include "fast_float/fast_float_strtod.h"
 #include "obfuscation/obfuscation_api.h"
+#include "util/fnv.h"
+#include "search_disk.h"
+#include "index_delta.h"
 
 // Memory pool for RSAddDocumentContext contexts
 static mempool_t *actxPool_g = NULL;
@@ -58,6 +61,92 @@ static void freeDocumentContext(void *p) {
 #define FIELD_IS_VALID(aCtx, ix) ((aCtx)->fspecs[ix].fieldName != NULL)
 #define FIELD_IS_NULL(aCtx, ix) ((aCtx)->fdatas[ix].isNull)
 
+// Hashes the value of a field, or returns 0 if its type has no digest
+static uint64_t fieldDigest(const DocumentField *f, t_fieldIndex index) {
+  uint64_t h = fnv_64a_buf(&index, sizeof(index), 0);
+  h = fnv_64a_buf(&f->indexAs, sizeof(f->indexAs), h);
+  h = fnv_64a_buf(&f->unionType, sizeof(f->unionType), h);
+  switch (f->unionType) {
+    case FLD_VAR_T_RMS: {
+      size_t len;
+      const char *s = RedisModule_StringPtrLen(f->text, &len);
+      return fnv_64a_buf(s, len, h);
+    }
+    case FLD_VAR_T_CSTR:
+      return fnv_64a_buf(f->strval, f->strlen, h);
+    case FLD_VAR_T_NUM:
+      return fnv_64a_buf(&f->numval, sizeof(f->numval), h);
+    case FLD_VAR_T_GEO:
+      h = fnv_64a_buf(&f->lon, sizeof(f->lon), h);
+      return fnv_64a_buf(&f->lat, sizeof(f->lat), h);
+    case FLD_VAR_T_BLOB_ARRAY:
+      return fnv_64a_buf(f->blobArr, f->blobSize * f->blobArrLen, h);
+    case FLD_VAR_T_NULL:
+      return h;
+    case FLD_VAR_T_ARRAY:
+      if (f->indexAs & (INDEXFLD_T_FULLTEXT | INDEXFLD_T_TAG | INDEXFLD_T_GEO)) {
+        for (size_t i = 0; i < f->arrayLen; i++) {
+          // The length separates the values, so that ["ab", "c"] and ["a", "bc"] differ
+          size_t len = strlen(f->multiVal[i]);
+          h = fnv_64a_buf(&len, sizeof(len), h);
+          h = fnv_64a_buf(f->multiVal[i], len, h);
+        }
+        return h;
+      } else if (f->indexAs & INDEXFLD_T_NUMERIC) {
+        return fnv_64a_buf(f->arrNumval, array_len(f->arrNumval) * sizeof(*f->arrNumval), h);
+      }
+      return 0;
+    case FLD_VAR_T_GEOMETRY:
+      return 0;
+  }
+  return 0;
+}
+
+// Computes the digest of the indexed content of the document: the values of its schema fields and
+// the attributes stored in its metadata. Fields which are not in the schema are left out, so that
+// an update of the other fields of a hash leaves the digest unchanged, and so are the values of
+// the fields updated in place.
+static uint64_t AddDocumentCtx_Digest(RSAddDocumentCtx *aCtx) {
+  const Document *doc = aCtx->doc;
+  aCtx->hasInPlaceFields = false;
+  // The field digests are summed, as the order of the fields does not matter
+  uint64_t fields = 0;
+  for (size_t i = 0; i < doc->numFields; i++) {
+    if (!FIELD_IS_VALID(aCtx, i)) {
+      continue;
+    }
+    const FieldSpec *fs = aCtx->fspecs + i;
+    uint64_t h;
+    if ((fs->types & DOCUMENT_IN_PLACE_TYPES) && FieldSpec_IsIndexable(fs)) {
+      // Only the field having a value is part of the digest, as its missing and existing
+      // documents are not updated in place
+      h = fnv_64a_buf(&fs->index, sizeof(fs->index), 0);
+      aCtx->hasInPlaceFields = true;
+    } else if (!(h = fieldDigest(doc->fields + i, fs->index))) {
+      return 0;
+    }
+    fields += h;
+  }
+
+  uint64_t h = fnv_64a_buf(&fields, sizeof(fields), 0);
+  // A field added to the schema may index the document even if it has no value for it
+  h = fnv_64a_buf(&aCtx->spec->numFields, sizeof(aCtx->spec->numFields), h);
+  h = fnv_64a_buf(&doc->type, sizeof(doc->type), h);
+  h = fnv_64a_buf(&doc->language, sizeof(doc->language), h);
+  h = fnv_64a_buf(&doc->score, sizeof(doc->score), h);
+  h = fnv_64a_buf(&doc->docExpirationTime, sizeof(doc->docExpirationTime), h);
+  for (size_t i = 0; doc->fieldExpirations && i < array_len(doc->fieldExpirations); i++) {
+    const FieldExpiration *fe = doc->fieldExpirations + i;
+    h = fnv_64a_buf(&fe->index, sizeof(fe->index), h);
+    h = fnv_64a_buf(&fe->point, sizeof(fe->point), h);
+  }
+  if (doc->payload) {
+    h = fnv_64a_buf(doc->payload, doc->payloadSize, h);
+  }
+  // 0 stands for an unknown digest
+  return h ? h : 1;
+}
+
 static int AddDocumentCtx_SetDocument(RSAddDocumentCtx *aCtx, IndexSpec *sp) {
   Document *doc = aCtx->doc;
   aCtx->stateFlags &= ~ACTX_F_INDEXABLES;
@@ -163,6 +252,8 @@ static int AddDocumentCtx_SetDocument(RSAddDocumentCtx *aCtx, IndexSpec *sp) {
     }
     RSByteOffsets_ReserveFields(aCtx->byteOffsets, numTextIndexable);
   }
+
+  aCtx->digest = AddDocumentCtx_Digest(aCtx);
   return 0;
 }
 
@@ -186,6 +277,9 @@ RSAddDocumentCtx *NewAddDocumentCtx(IndexSpec *sp, Document *doc, QueryError *st
   aCtx->specFlags = sp->flags;
   aCtx->spec = sp;
   aCtx->oldMd = NULL;
+  aCtx->failedField = NULL;
+  aCtx->indexDelta = NULL;
+  aCtx->fromDelta = false;
   if (aCtx->specFlags & Index_Async) {
     HiddenString_Clone(sp->specName, &aCtx->specName);
   }
@@ -299,7 +393,9 @@ void AddDocumentCtx_Submit(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, uint32_
 
   // We actually modify (!) the strings in the document, so we always require
   // ownership
-  Document_MakeStringsOwner(aCtx->doc);
+  if (!(aCtx->stateFlags & ACTX_F_PREPROCESSED)) {
+    Document_MakeStringsOwner(aCtx->doc);
+  }
   aCtx->sctx = sctx;
   Document_AddToIndexes(aCtx, sctx);
 }
@@ -406,7 +502,7 @@ FIELD_PREPROCESSOR(fulltextPreprocessor) {
     }
   }
 
-  if (FieldSpec_IsIndexable(fs)) {
+  if (FieldSpec_IsIndexable(fs) && !aCtx->fromDelta) {
     ForwardIndexTokenizerCtx tokCtx;
     ByteOffsetWriter *curOffsetWriter = NULL;
     RSByteOffsetField *curOffsetField = NULL;
@@ -602,6 +698,18 @@ FIELD_BULK_INDEXER(numericIndexer) {
   return 0;
 }
 
+// The NUMERIC fields of the disk indexes are written to the disk database, when it supports them
+FIELD_BULK_INDEXER(diskNumericIndexer) {
+  const double *values = fdata->isMulti ? fdata->arrNumeric : &fdata->numeric;
+  size_t n = fdata->isMulti ? array_len(fdata->arrNumeric) : 1;
+  if (!SearchDisk_IndexNumeric(ctx->spec->diskSpec, fs->index, aCtx->doc->docId, values, n)) {
+    QueryError_SetError(status, QUERY_ERROR_CODE_GENERIC, "Could not write numeric index to disk");
+    return -1;
+  }
+  ctx->spec->stats.numRecords += n;
+  return 0;
+}
+
 FIELD_PREPROCESSOR(vectorPreprocessor) {
   fdata->numVec = 0;
   if (field->unionType == FLD_VAR_T_RMS) {
@@ -769,6 +877,16 @@ FIELD_BULK_INDEXER(tagIndexer) {
   return 0;
 }
 
+FIELD_BULK_INDEXER(diskTagIndexer) {
+  size_t n = array_len(fdata->tags);
+  if (!SearchDisk_IndexTags(ctx->spec->diskSpec, fs->index, aCtx->doc->docId, (const char **)fdata->tags, n)) {
+    QueryError_SetError(status, QUERY_ERROR_CODE_GENERIC, "Could not write tag index to disk");
+    return -1;
+  }
+  ctx->spec->stats.numRecords++;
+  return 0;
+}
+
 static PreprocessorFunc preprocessorMap[] = {
     // nl break
     [IXFLDPOS_FULLTEXT] = fulltextPreprocessor,
@@ -788,9 +906,19 @@ int IndexerBulkAdd(RSAddDocumentCtx *cur, RedisSearchCtx *sctx,
     if (field->indexAs & INDEXTYPE_FROM_POS(ii)) {
       switch (ii) {
         case IXFLDPOS_TAG:
-          rc = tagIndexer(cur, sctx, field, fs, fdata, status);
+          if (sctx->spec->diskSpec && SearchDisk_HasTags()) {
+            rc = diskTagIndexer(cur, sctx, field, fs, fdata, status);
+          } else {
+            rc = tagIndexer(cur, sctx, field, fs, fdata, status);
+          }
           break;
         case IXFLDPOS_NUMERIC:
+          // The GEO fields of disk indexes stay in memory
+          if (sctx->spec->diskSpec && SearchDisk_HasNumeric()) {
+            rc = diskNumericIndexer(cur, sctx, field, fs, fdata, status);
+            break;
+          }
+          // fallthrough
         case IXFLDPOS_GEO:
           rc = numericIndexer(cur, sctx, field, fs, fdata, status);
           break;
@@ -812,10 +940,9 @@ int IndexerBulkAdd(RSAddDocumentCtx *cur, RedisSearchCtx *sctx,
   return rc;
 }
 
-int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+// Runs the preprocessors of all the fields. Returns the field whose preprocessor failed, if any
+static const FieldSpec *preprocessFields(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
   Document *doc = aCtx->doc;
-  int ourRv = REDISMODULE_OK;
-
   for (size_t i = 0; i < doc->numFields; i++) {
     const FieldSpec *fs = aCtx->fspecs + i;
     DocumentField *ff = doc->fields + i;
@@ -828,10 +955,7 @@ int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
 
       PreprocessorFunc pp = preprocessorMap[ii];
       if (pp(aCtx, sctx, ff, fs, fdata, &aCtx->status) != 0) {
-        IndexError_AddQueryError(&aCtx->spec->stats.indexError, &aCtx->status, doc->docKey);
-        FieldSpec_AddQueryError(&aCtx->spec->fields[fs->index], &aCtx->status, doc->docKey);
-        ourRv = REDISMODULE_ERR;
-        goto cleanup;
+        return fs;
       }
       if (!(fs->options & FieldSpec_Dynamic)) {
         // Non-dynamic fields are only indexed as a single type.
@@ -840,23 +964,127 @@ int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
       }
     }
   }
+  return NULL;
+}
 
-  if (IndexDocument(aCtx) != 0) {
-    ourRv = REDISMODULE_ERR;
-    goto cleanup;
+void AddDocumentCtx_Preprocess(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  RS_ASSERT(!(aCtx->stateFlags & ACTX_F_PREPROCESSED));
+  Document_MakeStringsOwner(aCtx->doc);
+  aCtx->stateFlags |= ACTX_F_PREPROCESSED;
+  // The terms replicated by the primary, if they are the ones of the document, are not found again
+  aCtx->fromDelta = aCtx->indexDelta && IndexDelta_Read(aCtx, aCtx->indexDelta);
+  // The error, if any, is recorded once the document is submitted
+  aCtx->failedField = preprocessFields(aCtx, sctx);
+}
+
+// Returns false if a field of the document could not be preprocessed, after recording the error
+static bool AddDocumentCtx_CheckPreprocessed(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  const FieldSpec *failedField = (aCtx->stateFlags & ACTX_F_PREPROCESSED)
+                                     ? aCtx->failedField
+                                     : preprocessFields(aCtx, sctx);
+  if (failedField) {
+    IndexError_AddQueryError(&aCtx->spec->stats.indexError, &aCtx->status, aCtx->doc->docKey);
+    FieldSpec_AddQueryError(&aCtx->spec->fields[failedField->index], &aCtx->status, aCtx->doc->docKey);
+    return false;
+  }
+  return true;
+}
+
+static void AddDocumentCtx_Abort(RSAddDocumentCtx *aCtx) {
+  // if a document did not load properly, it is deleted
+  // to prevent mismatch of index and hash
+  Document *doc = aCtx->doc;
+  t_docId docId = DocTable_GetIdR(&aCtx->spec->docs, doc->docKey);
+  if (docId)
+    IndexSpec_DeleteDoc_Unsafe(aCtx->spec, RSDummyContext, doc->docKey, docId);
+
+  QueryError_SetCode(&aCtx->status, QUERY_ERROR_CODE_GENERIC);
+  AddDocumentCtx_Finish(aCtx);
+}
+
+bool AddDocumentCtx_IsUnchanged(const RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  if (!aCtx->digest || sctx->spec->diskSpec) {
+    return false;
+  }
+  const RSDocumentMetadata *dmd = DocTable_BorrowByKeyR(&sctx->spec->docs, aCtx->doc->docKey);
+  if (!dmd) {
+    return false;
+  }
+  bool unchanged = dmd->digest == aCtx->digest;
+  DMD_Return(dmd);
+  return unchanged;
+}
+
+void AddDocumentCtx_UpdateInPlace(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  aCtx->sctx = sctx;
+  if (!AddDocumentCtx_CheckPreprocessed(aCtx, sctx)) {
+    AddDocumentCtx_Abort(aCtx);
+    return;
   }
+  aCtx->doc->docId = DocTable_GetIdR(&sctx->spec->docs, aCtx->doc->docKey);
+  RS_LOG_ASSERT(aCtx->doc->docId, "The document must be in the index");
+  IndexDocumentInPlace(aCtx, sctx);
+  AddDocumentCtx_Finish(aCtx);
+}
 
-cleanup:
-  if (ourRv != REDISMODULE_OK) {
-    // if a document did not load properly, it is deleted
-    // to prevent mismatch of index and hash
-    t_docId docId = DocTable_GetIdR(&aCtx->spec->docs, doc->docKey);
-    if (docId)
-      IndexSpec_DeleteDoc_Unsafe(aCtx->spec, RSDummyContext, doc->docKey, docId);
+int Document_AddToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  if (!AddDocumentCtx_CheckPreprocessed(aCtx, sctx) || IndexDocument(aCtx) != 0) {
+    AddDocumentCtx_Abort(aCtx);
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+void AddDocumentCtx_SubmitBatch(RSAddDocumentCtx **ctxs, size_t n, RedisSearchCtx *sctx,
+                                uint32_t options) {
+  RS_ASSERT(!(options & DOCUMENT_ADD_PARTIAL));
+  RSAddDocumentCtx *chain = NULL, **tail = &chain;
+  for (size_t i = 0; i < n; i++) {
+    RSAddDocumentCtx *aCtx = ctxs[i];
+    aCtx->options = options;
+    if (!(aCtx->stateFlags & ACTX_F_PREPROCESSED)) {
+      Document_MakeStringsOwner(aCtx->doc);
+    }
+    aCtx->sctx = sctx;
+    if (!AddDocumentCtx_CheckPreprocessed(aCtx, sctx)) {
+      AddDocumentCtx_Abort(aCtx);
+      continue;
+    }
+    aCtx->next = NULL;
+    *tail = aCtx;
+    tail = &aCtx->next;
+  }
+  if (chain) {
+    IndexDocuments(chain);
+  }
+}
 
-    QueryError_SetCode(&aCtx->status, QUERY_ERROR_CODE_GENERIC);
-    AddDocumentCtx_Finish(aCtx);
+int Document_AddFieldsToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, t_docId docId) {
+  Document *doc = aCtx->doc;
+  IndexSpec *spec = sctx->spec;
+  int ourRv = REDISMODULE_OK;
+  aCtx->sctx = sctx;
+  doc->docId = docId;
+
+  const FieldSpec *failedField = preprocessFields(aCtx, sctx);
+  if (failedField) {
+    IndexError_AddQueryError(&spec->stats.indexError, &aCtx->status, doc->docKey);
+    FieldSpec_AddQueryError(&spec->fields[failedField->index], &aCtx->status, doc->docKey);
+    // As if the document was indexed with the field, it is deleted from the index
+    IndexSpec_DeleteDoc_Unsafe(spec, RSDummyContext, doc->docKey, docId);
+    array_free(doc->fieldExpirations);
+    doc->fieldExpirations = NULL;
+    ourRv = REDISMODULE_ERR;
+  } else {
+    IndexDocumentFields(aCtx, sctx);
+    if (doc->fieldExpirations) {
+      RSDocumentMetadata *md = (RSDocumentMetadata *)DocTable_Borrow(&spec->docs, docId);
+      DocTable_AddFieldExpirations(&spec->docs, md, doc->fieldExpirations);
+      doc->fieldExpirations = NULL;
+      DMD_Return(md);
+    }
   }
+  AddDocumentCtx_Free(aCtx);
   return ourRv;
 }
 
@@ -938,6 +1166,8 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
     BAIL("Couldn't load document metadata");
   }
 
+  // The metadata no longer matches the digest of the indexed content
+  md->digest = 0;
   // Update the score
   md->score = doc->score;
   // Set the payload if needed
@@ -996,6 +1226,9 @@ static void AddDocumentCtx_UpdateNoIndex(RSAddDocumentCtx *aCtx, RedisSearchCtx
   }
 
 done:
+  if (md && (aCtx->stateFlags & ACTX_F_SORTABLES)) {
+    DocTable_SortingVectorUpdated(&sctx->spec->docs, md);
+  }
   DMD_Return(md);
   if (aCtx->donecb) {
     aCtx->donecb(aCtx, sctx->redisCtx, aCtx->donecbData);
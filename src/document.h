@@ -206,6 +206,13 @@ void Document_Clear(Document *doc);
 int Document_LoadSchemaFieldHash(Document *doc, RedisSearchCtx *sctx, QueryError* status);
 int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx, QueryError* status);
 
+/**
+ * Load the fields of the schema from the field at index `from` on, according to the type of the
+ * document. Used to index the fields added to the schema for the documents already in the index
+ */
+int Document_LoadSchemaFieldsFrom(Document *doc, RedisSearchCtx *sctx, t_fieldIndex from,
+                                  QueryError *status);
+
 /**
  * Load all the fields into the document.
  */
@@ -254,11 +261,18 @@ struct FieldIndexerData;
 // The content has sortable fields
 #define ACTX_F_SORTABLES 0x10
 
+// The fields have been preprocessed by AddDocumentCtx_Preprocess
+#define ACTX_F_PREPROCESSED 0x20
+
 // Document is entirely empty (no sortables, indexables)
 #define ACTX_F_EMPTY 0x40
 
 #define ACTX_F_NOFREEDOC 0x80
 
+// The types of the fields whose indexes are keyed by the document id rather than ordered by it. The
+// values of these fields are replaced in place, without assigning the document a new id.
+#define DOCUMENT_IN_PLACE_TYPES (INDEXFLD_T_VECTOR | INDEXFLD_T_GEOMETRY)
+
 /** Context used when indexing documents */
 typedef struct RSAddDocumentCtx {
   struct RSAddDocumentCtx *next;  // Next context in the queue
@@ -292,8 +306,20 @@ typedef struct RSAddDocumentCtx {
   // New flags to assign to the document
   RSDocumentFlags docFlags;
 
+  // Digest of the indexed content of the document, or 0 if it cannot be computed. The values of
+  // the fields of DOCUMENT_IN_PLACE_TYPES are left out of it.
+  uint64_t digest;
+  // Whether the document has values for fields of DOCUMENT_IN_PLACE_TYPES
+  bool hasInPlaceFields;
+  // The forward index of the document replicated by the primary (see index_delta.h), or NULL
+  RedisModuleString *indexDelta;
+  // Whether the forward index was read from `indexDelta`, so the text fields are not tokenized
+  bool fromDelta;
+
   // Scratch space used by per-type field preprocessors (see the source)
   struct FieldIndexerData *fdatas;
+  // The field whose preprocessing by AddDocumentCtx_Preprocess failed, reported on submission
+  const FieldSpec *failedField;
   QueryError status;     // Error message is placed here if there is an error during processing
   uint32_t totalTokens;  // Number of tokens, used for offset vector
   uint32_t specFlags;    // Cached index flags
@@ -303,6 +329,21 @@ typedef struct RSAddDocumentCtx {
   void *donecbData;
 } RSAddDocumentCtx;
 
+/**
+ * Returns true if the document of the context is indexed with the same content already, apart from
+ * the values of its fields of DOCUMENT_IN_PLACE_TYPES. Indexing it again would only assign it a new
+ * id, so it is either skipped, with _SKIP_UNCHANGED_DOCS, or updated in place with
+ * AddDocumentCtx_UpdateInPlace. Requires the spec lock.
+ */
+bool AddDocumentCtx_IsUnchanged(const RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx);
+
+/**
+ * Replaces the values of the fields of DOCUMENT_IN_PLACE_TYPES of a document for which
+ * AddDocumentCtx_IsUnchanged holds, keeping its id, and frees the context. The context must have
+ * been preprocessed. Requires the spec write lock.
+ */
+void AddDocumentCtx_UpdateInPlace(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx);
+
 /**
  * Creates a new context used for adding documents. Once created, call
  * Document_AddToIndexes on it.
@@ -325,6 +366,16 @@ RSAddDocumentCtx *NewAddDocumentCtx(IndexSpec *sp, Document *base, QueryError *s
  */
 void AddDocumentCtx_Submit(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, uint32_t options);
 
+/**
+ * Preprocesses the fields of the document (tokenizing the text fields, parsing the numeric ones
+ * and so on) ahead of AddDocumentCtx_Submit, which then only writes them to the index. This only
+ * reads the spec, so it may be called while the spec is locked for read, leaving the write lock
+ * to the writes themselves. It uses no Redis API besides reading the strings of the document, so
+ * it may also be called without the GIL, once the context was created with it. Errors are recorded
+ * on submission. Must not be used for partial updates.
+ */
+void AddDocumentCtx_Preprocess(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx);
+
 /**
  * Indicate that processing is finished on the current document
  */
@@ -340,6 +391,21 @@ void AddDocumentCtx_Finish(RSAddDocumentCtx *aCtx);
  */
 int Document_AddToIndexes(RSAddDocumentCtx *ctx, RedisSearchCtx *sctx);
 
+/**
+ * Submit several documents at once, as if each one was submitted with AddDocumentCtx_Submit. Their
+ * terms are written to the inverted indexes together, see IndexDocuments(). Partial updates are not
+ * supported.
+ */
+void AddDocumentCtx_SubmitBatch(RSAddDocumentCtx **ctxs, size_t n, RedisSearchCtx *sctx,
+                                uint32_t options);
+
+/**
+ * Index the fields of the document for `docId`, the id of the document in the index, without
+ * re-indexing it. The document only holds the fields added to the schema since it was indexed.
+ * Should be called under the write lock of the spec. The context is freed.
+ */
+int Document_AddFieldsToIndexes(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx, t_docId docId);
+
 /**
  * Free the AddDocumentCtx. Should be done once AddToIndexes() completes; or
  * when the client is unblocked.
@@ -129,7 +129,8 @@ static inline t_expirationTimePoint getDocExpirationTime(RedisModuleCtx* ctx, Re
   return result;
 }
 
-int Document_LoadSchemaFieldHash(Document *doc, RedisSearchCtx *sctx, QueryError *status) {
+static int loadSchemaFieldsHash(Document *doc, RedisSearchCtx *sctx, t_fieldIndex from,
+                                QueryError *status) {
   // must happen before opening the key, in case the call will cause a lazy expiration
   IndexSpec *spec = sctx->spec;
   RedisModuleKey *k = RedisModule_OpenKey(sctx->redisCtx, doc->docKey, DOCUMENT_OPEN_KEY_INDEXING_FLAGS);
@@ -140,7 +141,7 @@ int Document_LoadSchemaFieldHash(Document *doc, RedisSearchCtx *sctx, QueryError
     goto done;
   }
 
-  size_t nitems = sctx->spec->numFields;
+  size_t nitems = sctx->spec->numFields - from;
   SchemaRule *rule = spec->rule;
   RS_ASSERT(rule);
   RedisModuleString *payload_rms = NULL;
@@ -160,7 +161,7 @@ int Document_LoadSchemaFieldHash(Document *doc, RedisSearchCtx *sctx, QueryError
   const bool hasExpireTimeOnFields = spec->monitorFieldExpiration && RedisModule_HashFieldMinExpire(k) != REDISMODULE_NO_EXPIRE;
   // Load indexed fields from the document
   doc->fields = rm_calloc(nitems, sizeof(*doc->fields));
-  for (size_t ii = 0; ii < spec->numFields; ++ii) {
+  for (size_t ii = from; ii < spec->numFields; ++ii) {
     FieldSpec *field = &spec->fields[ii];
     RedisModuleString *v = NULL;
     RedisModule_HashGet(k, REDISMODULE_HASH_CFIELDS, HiddenString_GetUnsafe(field->fieldPath, NULL), &v, NULL);
@@ -196,7 +197,8 @@ done:
   return rv;
 }
 
-int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx, QueryError* status) {
+static int loadSchemaFieldsJson(Document *doc, RedisSearchCtx *sctx, t_fieldIndex from,
+                                QueryError *status) {
   int rv = REDISMODULE_ERR;
   if (!japi) {
     RedisModule_Log(sctx->redisCtx, "warning", "cannot operate on a JSON index as RedisJSON is not loaded");
@@ -206,8 +208,9 @@ int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx, QueryError
   IndexSpec *spec = sctx->spec;
   SchemaRule *rule = spec->rule;
   RedisModuleCtx *ctx = sctx->redisCtx;
-  size_t nitems = sctx->spec->numFields;
+  size_t nitems = sctx->spec->numFields - from;
   JSONResultsIterator jsonIter = NULL;
+  JSONPathReader reader = {0};
 
   RedisModuleKey *k = RedisModule_OpenKey(sctx->redisCtx, doc->docKey, DOCUMENT_OPEN_KEY_INDEXING_FLAGS);
   if (!k) {
@@ -233,12 +236,13 @@ int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx, QueryError
   doc->score = SchemaRule_JsonScore(sctx->redisCtx, rule, jsonRoot, keyName);
   // No payload on JSON as RedisJSON does not support binary fields
 
+  JSONPathReader_Init(&reader, jsonRoot);
   doc->fields = rm_calloc(nitems, sizeof(*doc->fields));
-  size_t ii = 0;
-  for (; ii < spec->numFields; ++ii) {
+  for (size_t ii = from; ii < spec->numFields; ++ii) {
     FieldSpec *field = &spec->fields[ii];
 
-    jsonIter = japi->get(jsonRoot, HiddenString_GetUnsafe(field->fieldPath, NULL));
+    jsonIter = JSONPathReader_Get(&reader, HiddenString_GetUnsafe(field->fieldPath, NULL),
+                                  field->jsonParentLen);
     // if field does not exist or is empty (can happen after JSON.DEL)
     if (!jsonIter) {
         continue;
@@ -272,9 +276,32 @@ done:
   if (jsonIter) {
     japi->freeIter(jsonIter);
   }
+  JSONPathReader_Free(&reader);
   return rv;
 }
 
+int Document_LoadSchemaFieldHash(Document *doc, RedisSearchCtx *sctx, QueryError *status) {
+  return loadSchemaFieldsHash(doc, sctx, 0, status);
+}
+
+int Document_LoadSchemaFieldJson(Document *doc, RedisSearchCtx *sctx, QueryError *status) {
+  return loadSchemaFieldsJson(doc, sctx, 0, status);
+}
+
+int Document_LoadSchemaFieldsFrom(Document *doc, RedisSearchCtx *sctx, t_fieldIndex from,
+                                  QueryError *status) {
+  switch (doc->type) {
+  case DocumentType_Hash:
+    return loadSchemaFieldsHash(doc, sctx, from, status);
+  case DocumentType_Json:
+    return loadSchemaFieldsJson(doc, sctx, from, status);
+  case DocumentType_Unsupported:
+    break;
+  }
+  RS_ABORT("Should receive valid type");
+  return REDISMODULE_ERR;
+}
+
 /* used only by unit tests */
 int Document_LoadAllFields(Document *doc, RedisModuleCtx *ctx) {
   int rc = REDISMODULE_ERR;
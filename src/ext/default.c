@@ -144,17 +144,23 @@ static double TFIDFNormDocLenScorer(const ScoringFunctionArgs *ctx, const RSInde
  *
  ******************************************************************************************/
 
-/* recursively calculate score for each token, summing up sub tokens */
-static double bm25Recursive(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
-                            const RSDocumentMetadata *dmd, RSScoreExplain *scrExp) {
+/* The length normalization of the term frequencies. It only depends on the average length, so it
+ * is the same for all the tokens of a query */
+static inline double bm25LengthNorm(double avgDocLen) {
   static const float b = 0.5;
   static const float k1 = 1.2;
+  return k1 * (1.0f - b + b * avgDocLen);
+}
+
+/* recursively calculate score for each token, summing up sub tokens */
+static double bm25Recursive(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
+                            const RSDocumentMetadata *dmd, double lenNorm, RSScoreExplain *scrExp) {
   double f = (double)r->freq;
   double ret = 0;
   if (r->data.tag == RSResultData_Term) {
     RSQueryTerm *term = IndexResult_QueryTermRef(r);
     double idf = (term ? term->idf : 0);
-    ret = r->weight * idf * f / (f + k1 * (1.0f - b + b * ctx->indexStats.avgDocLen));
+    ret = r->weight * idf * f / (f + lenNorm);
     EXPLAIN(scrExp,
             "(%.2f = Weight %.2f * IDF %.2f * F %d / (F %d + k1 1.2 * (1 - b 0.5 + b 0.5 * Average Len %.2f)))",
             ret, r->weight, idf, r->freq, r->freq, ctx->indexStats.avgDocLen);
@@ -166,7 +172,7 @@ static double bm25Recursive(const ScoringFunctionArgs *ctx, const RSIndexResult
     if (!scrExp) {
       AggregateRecordsSlice children = AggregateResult_GetRecordsSlice(agg);
       for (int i = 0; i < children.len; i++) {
-        ret += bm25Recursive(ctx, children.ptr[i], dmd, NULL);
+        ret += bm25Recursive(ctx, children.ptr[i], dmd, lenNorm, NULL);
       }
     } else {
       size_t numChildren = AggregateResult_NumChildren(agg);
@@ -175,14 +181,14 @@ static double bm25Recursive(const ScoringFunctionArgs *ctx, const RSIndexResult
 
       AggregateRecordsSlice children = AggregateResult_GetRecordsSlice(agg);
       for (int i = 0; i < children.len; i++) {
-        ret += bm25Recursive(ctx, children.ptr[i], dmd, &scrExp->children[i]);
+        ret += bm25Recursive(ctx, children.ptr[i], dmd, lenNorm, &scrExp->children[i]);
       }
 
       EXPLAIN(scrExp, "(Weight %.2f * children BM25 %.2f)", r->weight, ret);
     }
     ret *= r->weight;
   } else if (f) {  // default for virtual type -just disregard the idf
-    ret = r->weight * f / (f + k1 * (1.0f - b + b * ctx->indexStats.avgDocLen));
+    ret = r->weight * f / (f + lenNorm);
     EXPLAIN(
         scrExp,
         "(%.2f = Weight %.2f * F %d / (F %d + k1 1.2 * (1 - b 0.5 + b 0.5 * Average Len %.2f)))",
@@ -198,7 +204,7 @@ static double bm25Recursive(const ScoringFunctionArgs *ctx, const RSIndexResult
 static double BM25Scorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
                          const RSDocumentMetadata *dmd, double minScore) {
   RSScoreExplain *scrExp = (RSScoreExplain *)ctx->scrExp;
-  double bm25res = bm25Recursive(ctx, r, dmd, scrExp);
+  double bm25res = bm25Recursive(ctx, r, dmd, bm25LengthNorm(ctx->indexStats.avgDocLen), scrExp);
   double score = dmd->score * bm25res;
   strExpCreateParent(ctx, &scrExp);
 
@@ -222,9 +228,18 @@ static double BM25Scorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
  *
  ******************************************************************************************/
 
-static double inline CalculateBM25Std(float b, float k1, double idf, double f, int doc_len,
+static const float bm25StdB = 0.75f;
+static const float bm25StdK1 = 1.2f;
+
+/* The length normalization of the term frequencies in a document, `k1 * (1 - b + b * len / avg)`,
+ * which all of its tokens share. It is computed once per document, rather than per token */
+static inline double bm25StdLengthNorm(int doc_len, double avg_doc_len) {
+  return bm25StdK1 * (1.0f - bm25StdB + bm25StdB * (float)doc_len/avg_doc_len);
+}
+
+static double inline CalculateBM25Std(double idf, double f, double lenNorm, int doc_len,
                                       double avg_doc_len, double weight, RSScoreExplain *scrExp, const char *term) {
-  double ret = weight * idf * f * (k1 + 1) / (f + k1 * (1.0f - b + b * (float)doc_len/avg_doc_len));
+  double ret = weight * idf * f * (bm25StdK1 + 1) / (f + lenNorm);
   EXPLAIN(scrExp,
           "%s: (%.2f = Weight %.2f * IDF %.2f * (F %.2f * (k1 1.2 + 1)) / (F %.2f + k1 1.2 * (1 - b 0.75 + b 0.75 *"
           " Doc Len %d / Average Doc Len %.2f)))",
@@ -232,18 +247,28 @@ static double inline CalculateBM25Std(float b, float k1, double idf, double f, i
   return ret;
 }
 
+double BM25Std_TermImpact(uint32_t freq, uint32_t docLen, double avgDocLen) {
+  double f = (double)freq;
+  return f * (bm25StdK1 + 1) / (f + bm25StdLengthNorm(docLen, avgDocLen));
+}
+
+double BM25Std_TermUpperBound(double idf, double weight, uint32_t maxFreq) {
+  // The score grows with the frequency and shrinks with the document length, so the bound is
+  // reached at the maximal frequency and a document of length 0
+  double f = (double)maxFreq;
+  return weight * idf * f * (bm25StdK1 + 1) / (f + bm25StdLengthNorm(0, 1));
+}
+
 /* recursively calculate score for each token, summing up sub tokens */
 static double bm25StdRecursive(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
-                            const RSDocumentMetadata *dmd, RSScoreExplain *scrExp) {
-  static const float b = 0.75f;
-  static const float k1 = 1.2f;
+                            const RSDocumentMetadata *dmd, double lenNorm, RSScoreExplain *scrExp) {
   double f = (double)r->freq;
   double ret = 0;
   if (r->data.tag == RSResultData_Term) {
     // Compute IDF based on total number of docs in the index and the term's total frequency.
     RSQueryTerm *term = IndexResult_QueryTermRef(r);
     double idf = term->bm25_idf;
-    ret = CalculateBM25Std(b, k1, idf, f, dmd->len, ctx->indexStats.avgDocLen, r->weight, scrExp,
+    ret = CalculateBM25Std(idf, f, lenNorm, dmd->len, ctx->indexStats.avgDocLen, r->weight, scrExp,
                            term->str);
   } else if (r->data.tag & (RSResultData_Intersection | RSResultData_Union | RSResultData_HybridMetric)) {
     // SAFETY: We checked the tag above, so we can safely assume that r is an aggregate result
@@ -252,7 +277,7 @@ static double bm25StdRecursive(const ScoringFunctionArgs *ctx, const RSIndexResu
     if (!scrExp) {
       AggregateRecordsSlice children = AggregateResult_GetRecordsSlice(agg);
       for (int i = 0; i < children.len; i++) {
-        ret += bm25StdRecursive(ctx, children.ptr[i], dmd, NULL);
+        ret += bm25StdRecursive(ctx, children.ptr[i], dmd, lenNorm, NULL);
       }
     } else {
       size_t numChildren = AggregateResult_NumChildren(agg);
@@ -261,7 +286,7 @@ static double bm25StdRecursive(const ScoringFunctionArgs *ctx, const RSIndexResu
 
       AggregateRecordsSlice children = AggregateResult_GetRecordsSlice(agg);
       for (int i = 0; i < children.len; i++) {
-        ret += bm25StdRecursive(ctx, children.ptr[i], dmd, &scrExp->children[i]);
+        ret += bm25StdRecursive(ctx, children.ptr[i], dmd, lenNorm, &scrExp->children[i]);
       }
 
       EXPLAIN(scrExp, "(Weight %.2f * children BM25 %.2f)", r->weight, ret);
@@ -271,7 +296,8 @@ static double bm25StdRecursive(const ScoringFunctionArgs *ctx, const RSIndexResu
     // For wildcard, score should be determined only by the weight
     // and the document's length (so we set idf and f to be 1).
     double idf = 1.0;
-    ret = CalculateBM25Std(b, k1, idf, 1, dmd->len, ctx->indexStats.avgDocLen, r->weight, scrExp, "*");
+    ret = CalculateBM25Std(idf, 1, lenNorm, dmd->len, ctx->indexStats.avgDocLen, r->weight, scrExp,
+                           "*");
   } else {
     // Record is either optional term with no match or non text token.
     // For optional term with no match - we would expect 0 contribution to the score
@@ -286,7 +312,8 @@ static double bm25StdRecursive(const ScoringFunctionArgs *ctx, const RSIndexResu
 static double BM25StdScorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
                          const RSDocumentMetadata *dmd, double minScore) {
   RSScoreExplain *scrExp = (RSScoreExplain *)ctx->scrExp;
-  double bm25res = bm25StdRecursive(ctx, r, dmd, scrExp);
+  double lenNorm = bm25StdLengthNorm(dmd->len, ctx->indexStats.avgDocLen);
+  double bm25res = bm25StdRecursive(ctx, r, dmd, lenNorm, scrExp);
   double score = dmd->score * bm25res;
   strExpCreateParent(ctx, &scrExp);
 
@@ -320,7 +347,8 @@ static inline double tanhStretched(double x, double stretch) {
 static double BM25StdTanhScorer(const ScoringFunctionArgs *ctx, const RSIndexResult *r,
                          const RSDocumentMetadata *dmd, double minScore) {
   RSScoreExplain *scrExp = (RSScoreExplain *)ctx->scrExp;
-  double bm25res = bm25StdRecursive(ctx, r, dmd, scrExp);
+  double lenNorm = bm25StdLengthNorm(dmd->len, ctx->indexStats.avgDocLen);
+  double bm25res = bm25StdRecursive(ctx, r, dmd, lenNorm, scrExp);
   double score = dmd->score * bm25res;
   strExpCreateParent(ctx, &scrExp);
 
@@ -351,6 +379,14 @@ static double DocScoreScorer(const ScoringFunctionArgs *ctx, const RSIndexResult
   return dmd->score;
 }
 
+static void DocScoreBatchScorer(const ScoringFunctionArgs *ctx,
+                                const RSDocumentMetadata *const *dmds, size_t n, double minScore,
+                                double *scores) {
+  for (size_t i = 0; i < n; i++) {
+    scores[i] = dmds[i]->score;
+  }
+}
+
 /******************************************************************************************
  *
  * DISMAX-style scorer
@@ -477,6 +513,15 @@ static double HammingDistanceScorer(const ScoringFunctionArgs *ctx, const RSInde
   return result;
 }
 
+/* The distance only depends on the payload of the document, so the index results are not read */
+static void HammingDistanceBatchScorer(const ScoringFunctionArgs *ctx,
+                                       const RSDocumentMetadata *const *dmds, size_t n,
+                                       double minScore, double *scores) {
+  for (size_t i = 0; i < n; i++) {
+    scores[i] = HammingDistanceScorer(ctx, NULL, dmds[i], minScore);
+  }
+}
+
 typedef struct {
   int isCn;
   union {
@@ -550,11 +595,11 @@ int StemmerExpander(RSQueryExpanderCtx *ctx, RSToken *token) {
     return REDISMODULE_OK;
   }
 
-  const sb_symbol *b = (const sb_symbol *)token->str;
-  const sb_symbol *stemmed = sb_stemmer_stem(sb, b, token->len);
+  size_t stemLen;
+  const char *stemmed = SnowballStemmer_Stem(sb, ctx->language, token->str, token->len, &stemLen);
 
   if (stemmed) {
-    int sl = sb_stemmer_length(sb);
+    int sl = stemLen;
 
     // Make a copy of the stemmed buffer with the + prefix given to stems
     char *dup = rm_malloc(sl + 2);
@@ -751,6 +796,8 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
 
   /* Register HAMMING scorer */
   if (ctx->RegisterScoringFunction(HAMMINGDISTANCE_SCORER, HammingDistanceScorer, NULL, NULL) ==
+      REDISEARCH_ERR ||
+      ctx->RegisterBatchScoringFunction(HAMMINGDISTANCE_SCORER, HammingDistanceBatchScorer) ==
       REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
@@ -761,7 +808,8 @@ int DefaultExtensionInit(RSExtensionCtx *ctx) {
   }
 
   /* Register DOCSCORE scorer */
-  if (ctx->RegisterScoringFunction(DOCSCORE_SCORER, DocScoreScorer, NULL, NULL) == REDISEARCH_ERR) {
+  if (ctx->RegisterScoringFunction(DOCSCORE_SCORER, DocScoreScorer, NULL, NULL) == REDISEARCH_ERR ||
+      ctx->RegisterBatchScoringFunction(DOCSCORE_SCORER, DocScoreBatchScorer) == REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
 
@@ -28,4 +28,12 @@
 
 int DefaultExtensionInit(RSExtensionCtx *ctx);
 
+/* An upper bound of the BM25STD contribution of a term with the given IDF and weight, for any
+ * document in which the term frequency is at most `maxFreq`. Used for top-k pruning */
+double BM25Std_TermUpperBound(double idf, double weight, uint32_t maxFreq);
+
+/* The BM25STD contribution of a term to the score of a document, regardless of its IDF and weight.
+ * The documents of a term rank by it */
+double BM25Std_TermImpact(uint32_t freq, uint32_t docLen, double avgDocLen);
+
 #endif
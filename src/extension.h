@@ -28,6 +28,8 @@ typedef struct {
   RSScoringFunction sf;
   RSFreeFunction ff;
   void *privdata;
+  // Optional, the batch version of `sf`
+  RSBatchScoringFunction bsf;
 } ExtScoringFunctionCtx;
 
 /* Context for saving the a token expander and its free / privdata */
@@ -14,6 +14,7 @@
 #include "VecSim/vec_sim.h"
 #include "geometry/geometry_types.h"
 #include "info/index_error.h"
+#include "info/vector_index_stats.h"
 #include "obfuscation/hidden.h"
 
 #ifdef __cplusplus
@@ -70,6 +71,7 @@ typedef enum {
   FieldSpec_UndefinedOrder = 0x80,
   FieldSpec_IndexEmpty = 0x100,       // Index empty values (i.e., empty strings)
   FieldSpec_IndexMissing = 0x200,     // Index missing values (non-existing field)
+  FieldSpec_Stored = 0x400,           // Sortable UNF, so that loads are served by the sorting vector
 } FieldSpecOptions;
 
 RS_ENUM_BITWISE_HELPER(FieldSpecOptions)
@@ -114,6 +116,8 @@ typedef struct FieldSpec {
       VecSimParams vecSimParams;
       // expected size of vector blob.
       size_t expBlobSize;
+      // What the queries of the field did, updated as they run
+      VectorQueryStats queryStats;
     } vectorOpts;
     struct {
       // Geometry index parameters
@@ -125,6 +129,9 @@ typedef struct FieldSpec {
   double ftWeight;
   // ID used to identify the field within the field mask
   t_fieldId ftId;
+  // Length of the parent JSONPath that this field shares with other fields of the schema, like
+  // `$.user` for `$.user.name` and `$.user.age`, or 0. See JSONPathReader
+  uint16_t jsonParentLen;
 
   // The index error for this field
   IndexError indexError;
@@ -146,6 +153,7 @@ typedef struct FieldSpec {
 #define FieldSpec_IndexesEmpty(fs) ((fs)->options & FieldSpec_IndexEmpty)
 #define FieldSpec_IndexesMissing(fs) ((fs)->options & FieldSpec_IndexMissing)
 #define FieldSpec_IsUnf(fs) ((fs)->options & FieldSpec_UNF)
+#define FieldSpec_IsStored(fs) ((fs)->options & FieldSpec_Stored)
 
 void FieldSpec_SetSortable(FieldSpec* fs);
 void FieldSpec_Cleanup(FieldSpec* fs);
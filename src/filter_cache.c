@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "filter_cache.h"
+#include "rmalloc.h"
+#include "util/dict.h"
+#include "iterators/idlist_iterator.h"
+#include "iterators/empty_iterator.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct {
+  uint64_t hash;          // Of the key, compared before the key itself
+  sds key;                // NULL for a free slot
+  size_t uses;
+  bool materialized;
+  bool tooLarge;          // the filter matches more than FILTER_CACHE_MAX_IDS documents
+  t_docId *ids;
+  size_t numIds;
+  uint64_t lastUsed;
+} FilterCacheEntry;
+
+struct FilterCache {
+  pthread_mutex_t lock;
+  FilterCacheEntry entries[FILTER_CACHE_CAPACITY];
+  uint64_t revision;      // The revision of the cached ids
+  uint64_t clock;         // ticks on every access, for the LRU order
+};
+
+FilterCache *NewFilterCache(void) {
+  FilterCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  return cache;
+}
+
+static void FilterCacheEntry_Clear(FilterCacheEntry *e) {
+  sdsfree(e->key);
+  rm_free(e->ids);
+  memset(e, 0, sizeof(*e));
+}
+
+void FilterCache_Free(FilterCache *cache) {
+  if (!cache) return;
+  for (size_t i = 0; i < FILTER_CACHE_CAPACITY; i++) {
+    FilterCacheEntry_Clear(&cache->entries[i]);
+  }
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+// Drop the ids of older revisions, along with the uses counted at them. The cache must be locked
+static void FilterCache_Sync(FilterCache *cache, uint64_t revision) {
+  if (revision > cache->revision) {
+    for (size_t i = 0; i < FILTER_CACHE_CAPACITY; i++) {
+      FilterCacheEntry_Clear(&cache->entries[i]);
+    }
+    cache->revision = revision;
+  }
+}
+
+// Find the entry of the key. The cache must be locked
+static FilterCacheEntry *FilterCache_Find(FilterCache *cache, const sds key, uint64_t hash) {
+  size_t len = sdslen(key);
+  for (size_t i = 0; i < FILTER_CACHE_CAPACITY; i++) {
+    FilterCacheEntry *e = &cache->entries[i];
+    if (e->key && e->hash == hash && sdslen(e->key) == len && !memcmp(e->key, key, len)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+static QueryIterator *newCachedIterator(const FilterCacheEntry *e, double weight) {
+  if (e->numIds == 0) {
+    return NewEmptyIterator();
+  }
+  // The iterator owns its ids, so it gets a copy
+  t_docId *ids = rm_malloc(e->numIds * sizeof(*ids));
+  memcpy(ids, e->ids, e->numIds * sizeof(*ids));
+  return NewIdListIterator(ids, e->numIds, weight);
+}
+
+QueryIterator *FilterCache_Get(FilterCache *cache, uint64_t revision, const sds key, double weight) {
+  QueryIterator *ret = NULL;
+  uint64_t hash = RS_dictGenHashFunction(key, sdslen(key));
+  pthread_mutex_lock(&cache->lock);
+  FilterCache_Sync(cache, revision);
+  FilterCacheEntry *e = revision == cache->revision ? FilterCache_Find(cache, key, hash) : NULL;
+  if (e && e->materialized) {
+    e->uses++;
+    e->lastUsed = ++cache->clock;
+    ret = newCachedIterator(e, weight);
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return ret;
+}
+
+// Get the entry of the key, taking the slot of the least recently used one if it is not tracked.
+// The cache must be locked
+static FilterCacheEntry *FilterCache_Track(FilterCache *cache, const sds key, uint64_t hash) {
+  FilterCacheEntry *e = FilterCache_Find(cache, key, hash);
+  if (!e) {
+    e = &cache->entries[0];
+    for (size_t i = 0; i < FILTER_CACHE_CAPACITY && e->key; i++) {
+      FilterCacheEntry *cur = &cache->entries[i];
+      if (!cur->key || cur->lastUsed < e->lastUsed) {
+        e = cur;
+      }
+    }
+    FilterCacheEntry_Clear(e);
+    e->key = sdsdup(key);
+    e->hash = hash;
+  }
+  e->lastUsed = ++cache->clock;
+  return e;
+}
+
+QueryIterator *FilterCache_Materialize(FilterCache *cache, uint64_t revision, const sds key,
+                                       QueryIterator *it, size_t minUses, double weight) {
+  uint64_t hash = RS_dictGenHashFunction(key, sdslen(key));
+  pthread_mutex_lock(&cache->lock);
+  FilterCache_Sync(cache, revision);
+  bool materialize = false;
+  if (revision == cache->revision) {
+    FilterCacheEntry *e = FilterCache_Track(cache, key, hash);
+    materialize = ++e->uses >= minUses && !e->tooLarge && !e->materialized;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  if (!materialize) {
+    return it;
+  }
+
+  // Drain the filter outside the lock, as concurrent queries may do the same
+  size_t cap = 64, numIds = 0;
+  t_docId *ids = rm_malloc(cap * sizeof(*ids));
+  IteratorStatus rc;
+  while ((rc = it->Read(it)) == ITERATOR_OK && numIds < FILTER_CACHE_MAX_IDS) {
+    if (numIds == cap) {
+      cap *= 2;
+      ids = rm_realloc(ids, cap * sizeof(*ids));
+    }
+    ids[numIds++] = it->lastDocId;
+  }
+  if (rc != ITERATOR_EOF && rc != ITERATOR_OK) {
+    // Timed out, the ids are partial
+    rm_free(ids);
+    it->Rewind(it);
+    return it;
+  }
+
+  bool tooLarge = rc == ITERATOR_OK;
+  QueryIterator *ret = NULL;
+  pthread_mutex_lock(&cache->lock);
+  FilterCache_Sync(cache, revision);
+  if (revision == cache->revision) {
+    FilterCacheEntry *e = FilterCache_Track(cache, key, hash);
+    if (tooLarge) {
+      e->tooLarge = true;
+    } else if (!e->materialized) {
+      e->materialized = true;
+      e->ids = ids;
+      e->numIds = numIds;
+      ids = NULL;
+    }
+    if (e->materialized) {
+      ret = newCachedIterator(e, weight);
+    }
+  }
+  pthread_mutex_unlock(&cache->lock);
+  rm_free(ids);
+
+  if (!ret) {
+    it->Rewind(it);
+    return it;
+  }
+  it->Free(it);
+  return ret;
+}
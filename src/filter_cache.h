@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "redisearch.h"
+#include "iterators/iterator_api.h"
+#include "hiredis/sds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of filters each index keeps track of, materialized or not
+#define FILTER_CACHE_CAPACITY 32
+// Filters matching more documents than this are not materialized
+#define FILTER_CACHE_MAX_IDS (1 << 20)
+
+/**
+ * A small LRU cache of the document ids matched by the hot TAG, NUMERIC and GEO filters of an
+ * index, such as the `@tenant:{abc} @visible:[1 1]` of every query of a tenant, so that they are
+ * iterated as a sorted id list instead of intersecting their readers again. Once a filter was
+ * evaluated `_FILTER_CACHE_MIN_USES` times, its ids are materialized.
+ *
+ * The entries are keyed on the filters (see Query_EvalPhraseNode()) and stamped with the revision
+ * of the index, which is bumped whenever a document is added or deleted, and the whole cache is
+ * dropped once it is read at a newer revision. The ids carry no term data, so the caller may only
+ * use it for queries that don't need rich results. Lookups may run concurrently (under the spec
+ * read lock), and are serialized by the cache itself.
+ */
+typedef struct FilterCache FilterCache;
+
+FilterCache *NewFilterCache(void);
+void FilterCache_Free(FilterCache *cache);
+
+/**
+ * Get an iterator over the ids cached for the filter at `revision`, yielding results with the
+ * given weight.
+ * @returns NULL if they are not materialized
+ */
+QueryIterator *FilterCache_Get(FilterCache *cache, uint64_t revision, const sds key, double weight);
+
+/**
+ * Count a use of the filter at `revision`, and materialize the ids of `it`, its iterator, once it
+ * was used `minUses` times.
+ * Takes ownership of `it`, and returns the iterator to use in its place: an iterator over the
+ * cached ids, or `it` itself (rewound if it was read) if its ids were not cached.
+ */
+QueryIterator *FilterCache_Materialize(FilterCache *cache, uint64_t revision, const sds key,
+                                       QueryIterator *it, size_t minUses, double weight);
+
+#ifdef __cplusplus
+}
+#endif
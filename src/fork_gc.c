@@ -15,13 +15,18 @@
 #include "redis_index.h"
 #include "numeric_index.h"
 #include "tag_index.h"
+#include "geometry_index.h"
 #include "time_sample.h"
+#include "rs_wall_clock.h"
 #include <stdlib.h>
+#include <stdio.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/param.h>
 #include <poll.h>
 #include "rwlock.h"
 #include "hll/hll.h"
@@ -29,18 +34,38 @@
 #include "module.h"
 #include "rmutil/rm_assert.h"
 #include "suffix.h"
+#include "spell_delete_index.h"
+#include "term_index_cache.h"
+#include "term_tiers.h"
 #include "resp3.h"
 #include "info/global_stats.h"
 #include "info/info_redis/threads/current_thread.h"
 #include "obfuscation/obfuscation_api.h"
 #include "obfuscation/hidden.h"
 #include "util/redis_mem_info.h"
+#include "util/cpu_affinity.h"
 
 #define GC_WRITERFD 1
 #define GC_READERFD 0
 // Number of attempts to wait for the child to exit gracefully before trying to terminate it
 #define GC_WAIT_ATTEMPTS 4
 
+// The maximal number of deleted documents whose ids are kept between two cycles
+#define FGC_MAX_DELETED_IDS (1 << 20)
+
+// The size of the region in which the child writes its results. Its pages are only allocated once
+// the child writes to them, and the results past its end go through the pipe
+#define FGC_SHARED_SIZE ((size_t)64 << 20)
+// The offset of a chunk whose results follow it in the pipe
+#define FGC_INLINE_CHUNK SIZE_MAX
+
+/* The results of the child between `offset` and `offset + len` in the shared region. This is all
+ * the child sends through the pipe, unless the region is full */
+typedef struct {
+  size_t offset;
+  size_t len;
+} FGCSharedChunk;
+
 typedef enum {
   // Terms have been collected
   FGC_COLLECTED,
@@ -65,9 +90,18 @@ static void FGC_updateStats(ForkGC *gc, RedisSearchCtx *sctx,
   gc->stats.gcBlocksDenied += blocksDenied;
 }
 
-// Buff shouldn't be NULL.
-static void FGC_sendFixed(ForkGC *fgc, const void *buff, size_t len) {
-  RS_LOG_ASSERT(len > 0, "buffer length cannot be 0");
+// Lock the spec for the parent to apply results, counting how long it holds the lock
+static void FGC_lockSpecWrite(ForkGC *gc, RedisSearchCtx *sctx) {
+  RedisSearchCtx_LockSpecWrite(sctx);
+  gc->writeLockedAtNs = rs_wall_clock_now_ns();
+}
+
+static void FGC_unlockSpec(ForkGC *gc, RedisSearchCtx *sctx) {
+  gc->stats.lastWriteLockUs += (rs_wall_clock_now_ns() - gc->writeLockedAtNs) / 1000;
+  RedisSearchCtx_UnlockSpec(sctx);
+}
+
+static void FGC_pipeWrite(ForkGC *fgc, const void *buff, size_t len) {
   ssize_t size = write(fgc->pipe_write_fd, buff, len);
   if (size != len) {
     perror("broken pipe, exiting GC fork: write() failed");
@@ -77,6 +111,35 @@ static void FGC_sendFixed(ForkGC *fgc, const void *buff, size_t len) {
   }
 }
 
+// Send the position of the results the child wrote to the shared region since the last flush
+static void FGC_flushShared(ForkGC *fgc) {
+  if (fgc->sharedEnd == fgc->sharedPos) {
+    return;
+  }
+  FGCSharedChunk chunk = {.offset = fgc->sharedPos, .len = fgc->sharedEnd - fgc->sharedPos};
+  FGC_pipeWrite(fgc, &chunk, sizeof chunk);
+  fgc->sharedPos = fgc->sharedEnd;
+}
+
+// Buff shouldn't be NULL.
+static void FGC_sendFixed(ForkGC *fgc, const void *buff, size_t len) {
+  RS_LOG_ASSERT(len > 0, "buffer length cannot be 0");
+  if (!fgc->shared) {
+    FGC_pipeWrite(fgc, buff, len);
+    return;
+  }
+  if (FGC_SHARED_SIZE - fgc->sharedEnd >= len) {
+    memcpy(fgc->shared + fgc->sharedEnd, buff, len);
+    fgc->sharedEnd += len;
+    return;
+  }
+  // The region is full, so the results follow in the pipe
+  FGC_flushShared(fgc);
+  FGCSharedChunk chunk = {.offset = FGC_INLINE_CHUNK, .len = len};
+  FGC_pipeWrite(fgc, &chunk, sizeof chunk);
+  FGC_pipeWrite(fgc, buff, len);
+}
+
 #define FGC_SEND_VAR(fgc, v) FGC_sendFixed(fgc, &v, sizeof v)
 
 static void FGC_sendBuffer(ForkGC *fgc, const void *buff, size_t len) {
@@ -96,7 +159,7 @@ static void FGC_sendTerminator(ForkGC *fgc) {
   FGC_SEND_VAR(fgc, smax);
 }
 
-static int __attribute__((warn_unused_result)) FGC_recvFixed(ForkGC *fgc, void *buf, size_t len) {
+static int __attribute__((warn_unused_result)) FGC_pipeRead(ForkGC *fgc, void *buf, size_t len) {
   // poll the pipe, so that we don't block while read, with timeout of 3 minutes
   while (poll(fgc->pollfd_read, 1, 180000) == 1) {
     ssize_t nrecvd = read(fgc->pipe_read_fd, buf, len);
@@ -115,6 +178,46 @@ static int __attribute__((warn_unused_result)) FGC_recvFixed(ForkGC *fgc, void *
   return REDISMODULE_ERR;
 }
 
+static int __attribute__((warn_unused_result)) FGC_recvFixed(ForkGC *fgc, void *buf, size_t len) {
+  fgc->stats.lastBytesReceived += len;
+  if (!fgc->shared) {
+    return FGC_pipeRead(fgc, buf, len);
+  }
+  char *dst = buf;
+  while (len > 0) {
+    if (fgc->sharedPos < fgc->sharedEnd) {
+      size_t n = MIN(len, fgc->sharedEnd - fgc->sharedPos);
+      memcpy(dst, fgc->shared + fgc->sharedPos, n);
+      fgc->sharedPos += n;
+      dst += n;
+      len -= n;
+    } else if (fgc->inlineLeft > 0) {
+      size_t n = MIN(len, fgc->inlineLeft);
+      if (FGC_pipeRead(fgc, dst, n) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+      }
+      fgc->inlineLeft -= n;
+      dst += n;
+      len -= n;
+    } else {
+      FGCSharedChunk chunk;
+      if (FGC_pipeRead(fgc, &chunk, sizeof chunk) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+      }
+      if (chunk.offset == FGC_INLINE_CHUNK) {
+        fgc->inlineLeft = chunk.len;
+      } else if (chunk.offset <= FGC_SHARED_SIZE && chunk.len <= FGC_SHARED_SIZE - chunk.offset) {
+        fgc->sharedPos = chunk.offset;
+        fgc->sharedEnd = chunk.offset + chunk.len;
+      } else {
+        RedisModule_Log(fgc->ctx, "warning", "ForkGC - got an invalid chunk of the shared region");
+        return REDISMODULE_ERR;
+      }
+    }
+  }
+  return REDISMODULE_OK;
+}
+
 #define TRY_RECV_FIXED(gc, obj, len)                   \
   if (FGC_recvFixed(gc, obj, len) != REDISMODULE_OK) { \
     return REDISMODULE_ERR;                            \
@@ -168,6 +271,8 @@ static void sendHeaderString(void* ptrCtx) {
 }
 
 static void FGC_reportProgress(ForkGC *gc) {
+  // let the parent apply the results of the indexes scanned so far
+  FGC_flushShared(gc);
   RedisModule_SendChildHeartbeat(gc->progress);
 }
 
@@ -176,7 +281,91 @@ static void FGC_setProgress(ForkGC *gc, float progress) {
   FGC_reportProgress(gc);
 }
 
+static int cmpDocIds(const void *a, const void *b) {
+  t_docId ia = *(const t_docId *)a, ib = *(const t_docId *)b;
+  return ia < ib ? -1 : ia > ib;
+}
+
+// The position of the first of the sorted ids in [from, to) which is at least `id`
+static size_t lowerBoundId(const t_docId *ids, size_t from, size_t to, t_docId id) {
+  while (from < to) {
+    size_t mid = from + (to - from) / 2;
+    if (ids[mid] < id) {
+      from = mid + 1;
+    } else {
+      to = mid;
+    }
+  }
+  return from;
+}
+
+/* The number of the documents deleted since the last complete cycle whose ids fall within the
+ * blocks of the inverted index, which bounds the number of entries it has to collect. The child
+ * doesn't scan the indexes for which it is 0 */
+static size_t FGC_childEstimateGarbage(ForkGC *gc, const InvertedIndex *idx) {
+  if (gc->scanAll) {
+    return SIZE_MAX;
+  }
+  size_t n = array_len(gc->deletedIds);
+  size_t numBlocks = InvertedIndex_NumBlocks(idx);
+  size_t garbage = 0;
+  size_t pos = 0;
+  for (size_t i = 0; i < numBlocks && pos < n; i++) {
+    const IndexBlock *blk = InvertedIndex_BlockRef(idx, i);
+    pos = lowerBoundId(gc->deletedIds, pos, n, IndexBlock_FirstId(blk));
+    size_t end = lowerBoundId(gc->deletedIds, pos, n, IndexBlock_LastId(blk) + 1);
+    garbage += end - pos;
+    pos = end;
+  }
+  return garbage;
+}
+
+// Whether the child ran out of its time budget, after which it skips the remaining indexes
+static bool FGC_childOutOfBudget(ForkGC *gc) {
+  if (!gc->cycleCut && gc->cycleBudgetMs) {
+    TimeSample ts = {.startTime = gc->scanStart};
+    TimeSampler_End(&ts);
+    gc->cycleCut = TimeSampler_DurationMS(&ts) >= gc->cycleBudgetMs;
+  }
+  return gc->cycleCut;
+}
+
+/* An inverted index the child has to scan */
+typedef struct {
+  size_t garbage;
+  InvertedIndex *idx;
+  // The term or tag value of the index (owned), or the numeric node it belongs to
+  char *key;
+  size_t keyLen;
+  NumericRangeNode *node;
+} FGCCandidate;
+
+// The indexes with the most garbage first, so that those are collected when the budget runs out
+static int cmpCandidates(const void *a, const void *b) {
+  size_t ga = ((const FGCCandidate *)a)->garbage, gb = ((const FGCCandidate *)b)->garbage;
+  return ga > gb ? -1 : ga < gb;
+}
+
+// Keep the index for the scan if it may have garbage. Returns false if it is clean
+static bool FGC_childAddCandidate(ForkGC *gc, arrayof(FGCCandidate) *candidates, FGCCandidate c) {
+  c.garbage = FGC_childEstimateGarbage(gc, c.idx);
+  if (!c.garbage) {
+    return false;
+  }
+  array_append(*candidates, c);
+  return true;
+}
+
+static void FGC_childSortCandidates(arrayof(FGCCandidate) candidates) {
+  qsort(candidates, array_len(candidates), sizeof(*candidates), cmpCandidates);
+}
+
+static void freeCandidateKey(void *p) {
+  rm_free(((FGCCandidate *)p)->key);
+}
+
 static void FGC_childCollectTerms(ForkGC *gc, RedisSearchCtx *sctx) {
+  arrayof(FGCCandidate) candidates = array_new(FGCCandidate, 16);
   TrieIterator *iter = Trie_Iterate(sctx->spec->terms, "", 0, 0, 1);
   rune *rstr = NULL;
   t_len slen = 0;
@@ -185,25 +374,33 @@ static void FGC_childCollectTerms(ForkGC *gc, RedisSearchCtx *sctx) {
   while (TrieIterator_Next(iter, &rstr, &slen, NULL, &score, &dist)) {
     size_t termLen;
     char *term = runesToStr(rstr, slen, &termLen);
-    InvertedIndex *idx = Redis_OpenInvertedIndex(sctx, term, strlen(term), DONT_CREATE_INDEX, NULL);
-    if (idx) {
-      struct iovec iov = {.iov_base = (void *)term, termLen};
+    // The blocks of the cold terms are collected once they are back in memory
+    bool isCold;
+    InvertedIndex *idx = Redis_PeekInvertedIndex(sctx, term, strlen(term), &isCold);
+    if (!idx || isCold || !FGC_childAddCandidate(gc, &candidates,
+                                       (FGCCandidate){.idx = idx, .key = term, .keyLen = termLen})) {
+      rm_free(term);
+    }
+  }
+  TrieIterator_Free(iter);
 
-      CTX_II_GC_Callback cbCtx = { .gc = gc, .hdrarg = &iov };
-      II_GCCallback cb = { .ctx = &cbCtx, .call = sendHeaderString };
+  FGC_childSortCandidates(candidates);
+  for (uint32_t i = 0; i < array_len(candidates) && !FGC_childOutOfBudget(gc); i++) {
+    struct iovec iov = {.iov_base = (void *)candidates[i].key, candidates[i].keyLen};
 
-      II_GCWriter wr = { .ctx = gc, .write = pipe_write_cb };
+    CTX_II_GC_Callback cbCtx = { .gc = gc, .hdrarg = &iov };
+    II_GCCallback cb = { .ctx = &cbCtx, .call = sendHeaderString };
 
-      InvertedIndex_GcDelta_Scan(
-          &wr, sctx, idx,
-          &cb, NULL
-      );
+    II_GCWriter wr = { .ctx = gc, .write = pipe_write_cb };
 
-      FGC_reportProgress(gc);
-    }
-    rm_free(term);
+    InvertedIndex_GcDelta_Scan(
+        &wr, sctx, candidates[i].idx,
+        &cb, NULL
+    );
+
+    FGC_reportProgress(gc);
   }
-  TrieIterator_Free(iter);
+  array_free_ex(candidates, freeCandidateKey(ptr));
 
   // we are done with terms
   FGC_sendTerminator(gc);
@@ -275,6 +472,7 @@ static FGCError recvNumericTagHeader(ForkGC *fgc, char **fieldName, size_t *fiel
 
 static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
   arrayof(FieldSpec*) numericFields = getFieldsByType(sctx->spec, INDEXFLD_T_NUMERIC | INDEXFLD_T_GEO);
+  arrayof(FGCCandidate) candidates = array_new(FGCCandidate, 16);
 
   for (int i = 0; i < array_len(numericFields); ++i) {
     RedisModuleString *keyName = IndexSpec_GetFormattedKey(sctx->spec, numericFields[i], INDEXFLD_T_NUMERIC);
@@ -286,26 +484,32 @@ static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
     }
 
     NumericRangeTreeIterator *gcIterator = NumericRangeTreeIterator_New(rt);
-
     NumericRangeNode *currNode = NULL;
+    array_clear(candidates);
+    while ((currNode = NumericRangeTreeIterator_Next(gcIterator))) {
+      if (currNode->range) {
+        FGC_childAddCandidate(gc, &candidates,
+                              (FGCCandidate){.idx = currNode->range->entries, .node = currNode});
+      }
+    }
+    NumericRangeTreeIterator_Free(gcIterator);
+    FGC_childSortCandidates(candidates);
+
     tagNumHeader header = {.type = RSFLDTYPE_NUMERIC,
                            .field = HiddenString_GetUnsafe(numericFields[i]->fieldName, NULL),
                            .uniqueId = rt->uniqueId};
 
     numCbCtx nctx;
     IndexRepairParams params = {.repair_callback = countRemain, .repair_arg = &nctx};
-    hll_init(&nctx.majority_card, NR_BIT_PRECISION);
-    hll_init(&nctx.last_block_card, NR_BIT_PRECISION);
-    while ((currNode = NumericRangeTreeIterator_Next(gcIterator))) {
-      if (!currNode->range) {
-        continue;
-      }
+    hll_init(&nctx.majority_card, rt->hllBits);
+    hll_init(&nctx.last_block_card, rt->hllBits);
+    for (uint32_t j = 0; j < array_len(candidates) && !FGC_childOutOfBudget(gc); j++) {
       nctx.last_block = NULL;
       hll_clear(&nctx.majority_card);
       hll_clear(&nctx.last_block_card);
 
-      InvertedIndex *idx = currNode->range->entries;
-      header.curPtr = currNode;
+      InvertedIndex *idx = candidates[j].idx;
+      header.curPtr = candidates[j].node;
 
       CTX_II_GC_Callback cbCtx = { .gc = gc, .hdrarg = &header };
       II_GCCallback cb = { .ctx = &cbCtx, .call = sendNumericTagHeader };
@@ -324,8 +528,9 @@ static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
         // as the cardinality WITHOUT the last block's cardinality. This way, the main process can
         // choose which registers to use without having to merge them itself.
         hll_merge(&nctx.last_block_card, &nctx.majority_card);
-        FGC_sendFixed(gc, nctx.last_block_card.registers, NR_REG_SIZE);
-        FGC_sendFixed(gc, nctx.majority_card.registers, NR_REG_SIZE);
+        FGC_sendFixed(gc, &nctx.majority_card.size, sizeof(nctx.majority_card.size));
+        FGC_sendFixed(gc, nctx.last_block_card.registers, nctx.majority_card.size);
+        FGC_sendFixed(gc, nctx.majority_card.registers, nctx.majority_card.size);
       }
       FGC_reportProgress(gc);
     }
@@ -339,10 +544,9 @@ static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
       void *pdummy = NULL;
       FGC_SEND_VAR(gc, pdummy);
     }
-
-    NumericRangeTreeIterator_Free(gcIterator);
   }
 
+  array_free(candidates);
   array_free(numericFields);
   // we are done with numeric fields
   FGC_sendTerminator(gc);
@@ -350,6 +554,7 @@ static void FGC_childCollectNumeric(ForkGC *gc, RedisSearchCtx *sctx) {
 
 static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
   arrayof(FieldSpec*) tagFields = getFieldsByType(sctx->spec, INDEXFLD_T_TAG);
+  arrayof(FGCCandidate) candidates = array_new(FGCCandidate, 16);
   if (array_len(tagFields) != 0) {
     for (int i = 0; i < array_len(tagFields); ++i) {
       RedisModuleString *keyName = IndexSpec_GetFormattedKey(sctx->spec, tagFields[i], INDEXFLD_T_TAG);
@@ -362,14 +567,27 @@ static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
                              .field = HiddenString_GetUnsafe(tagFields[i]->fieldName, NULL),
                              .uniqueId = tagIdx->uniqueId};
 
-      TrieMapIterator *iter = TrieMap_Iterate(tagIdx->values);
+      TagValuesIterator *iter = TagIndex_IterateValues(tagIdx, NULL, 0, TM_PREFIX_MODE);
       char *ptr;
       tm_len_t len;
       InvertedIndex *value;
-      while (TrieMapIterator_Next(iter, &ptr, &len, (void **)&value)) {
-        header.curPtr = value;
-        header.tagValue = ptr;
-        header.tagLen = len;
+      while (TagValuesIterator_Next(iter, &ptr, &len, &value)) {
+        // the value is copied only if the index is kept
+        size_t garbage = FGC_childEstimateGarbage(gc, value);
+        if (garbage) {
+          char *tagValue = rm_malloc(len);
+          memcpy(tagValue, ptr, len);
+          FGCCandidate c = {.garbage = garbage, .idx = value, .key = tagValue, .keyLen = len};
+          array_append(candidates, c);
+        }
+      }
+      TagValuesIterator_Free(iter);
+      FGC_childSortCandidates(candidates);
+
+      for (uint32_t j = 0; j < array_len(candidates) && !FGC_childOutOfBudget(gc); j++) {
+        header.curPtr = candidates[j].idx;
+        header.tagValue = candidates[j].key;
+        header.tagLen = candidates[j].keyLen;
 
         // send repaired data
 
@@ -379,12 +597,14 @@ static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
         II_GCWriter wr = { .ctx = gc, .write = pipe_write_cb };
 
         InvertedIndex_GcDelta_Scan(
-            &wr, sctx, value,
+            &wr, sctx, candidates[j].idx,
             &cb, NULL
         );
 
         FGC_reportProgress(gc);
       }
+      array_foreach(candidates, c, rm_free(c.key));
+      array_clear(candidates);
 
       // we are done with the current field
       if (header.sentFieldName) {
@@ -394,6 +614,7 @@ static void FGC_childCollectTags(ForkGC *gc, RedisSearchCtx *sctx) {
     }
   }
 
+  array_free(candidates);
   array_free(tagFields);
   // we are done with tag fields
   FGC_sendTerminator(gc);
@@ -407,7 +628,8 @@ static void FGC_childCollectMissingDocs(ForkGC *gc, RedisSearchCtx *sctx) {
   while ((entry = dictNext(iter))) {
     const HiddenString *hiddenFieldName = dictGetKey(entry);
     InvertedIndex *idx = dictGetVal(entry);
-    if(idx) {
+    // There are a few of these, one per field, so they are scanned in the order of the dict
+    if(idx && FGC_childEstimateGarbage(gc, idx) && !FGC_childOutOfBudget(gc)) {
       size_t length;
       const char* fieldName = HiddenString_GetUnsafe(hiddenFieldName, &length);
       struct iovec iov = {.iov_base = (void *)fieldName, length};
@@ -435,7 +657,7 @@ static void FGC_childCollectExistingDocs(ForkGC *gc, RedisSearchCtx *sctx) {
   IndexSpec *spec = sctx->spec;
 
   InvertedIndex *idx = spec->existingDocs;
-  if (idx) {
+  if (idx && FGC_childEstimateGarbage(gc, idx) && !FGC_childOutOfBudget(gc)) {
     struct iovec iov = {.iov_base = (void *)"", 0};
 
     CTX_II_GC_Callback cbCtx = { .gc = gc, .hdrarg = &iov };
@@ -453,11 +675,31 @@ static void FGC_childCollectExistingDocs(ForkGC *gc, RedisSearchCtx *sctx) {
   FGC_sendTerminator(gc);
 }
 
+/* The private pages of the child, most of which it copied on write from the parent as the
+ * allocations of the scan touched them. 0 where /proc/self/smaps_rollup isn't available */
+static size_t FGC_childCowBytes() {
+  FILE *f = fopen("/proc/self/smaps_rollup", "r");
+  if (!f) {
+    return 0;
+  }
+  char line[256];
+  size_t kb, total = 0;
+  while (fgets(line, sizeof line, f)) {
+    if (sscanf(line, "Private_Dirty: %zu kB", &kb) == 1) {
+      total += kb;
+    }
+  }
+  fclose(f);
+  return total * 1024;
+}
+
 static void FGC_childScanIndexes(ForkGC *gc, IndexSpec *spec) {
   RedisSearchCtx sctx = SEARCH_CTX_STATIC(gc->ctx, spec);
   const char* indexName = IndexSpec_FormatName(spec, RSGlobalConfig.hideUserDataFromLog);
   RedisModule_Log(sctx.redisCtx, "debug", "ForkGC in index %s - child scanning indexes start", indexName);
   FGC_setProgress(gc, 0);
+  clock_gettime(CLOCK_REALTIME, &gc->scanStart);
+  qsort(gc->deletedIds, array_len(gc->deletedIds), sizeof(*gc->deletedIds), cmpDocIds);
   FGC_childCollectTerms(gc, &sctx);
   FGC_setProgress(gc, 0.2);
   FGC_childCollectNumeric(gc, &sctx);
@@ -467,6 +709,10 @@ static void FGC_childScanIndexes(ForkGC *gc, IndexSpec *spec) {
   FGC_childCollectMissingDocs(gc, &sctx);
   FGC_setProgress(gc, 0.8);
   FGC_childCollectExistingDocs(gc, &sctx);
+  // let the parent know whether it can forget the deleted documents of the cycle
+  FGC_SEND_VAR(gc, gc->cycleCut);
+  size_t cowBytes = FGC_childCowBytes();
+  FGC_SEND_VAR(gc, cowBytes);
   FGC_setProgress(gc, 1);
   RedisModule_Log(sctx.redisCtx, "debug", "ForkGC in index %s - child scanning indexes end", indexName);
 }
@@ -477,15 +723,28 @@ typedef struct {
   InvertedIndexGcDelta* delta;
   II_GCScanStats info;
 
+  // Allocated for the largest HLL precision, of which `registersSize` are used by the tree
+  uint32_t registersSize;
   void *registersWithLastBlock;
   void *registersWithoutLastBlock; // In case the last block was modified
+
+  // The last block seen by the child, and the blocks added to the range since the fork, recorded
+  // before the delta is applied (which frees it)
+  size_t lastBlockIdx;
+  size_t blocksSinceFork;
 } NumGcInfo;
 
+#define NUM_GC_MAX_REG_SIZE (1 << MAX_NUMERIC_HLL_PRECISION)
+
 static int recvRegisters(ForkGC *fgc, NumGcInfo *ninfo) {
-  if (FGC_recvFixed(fgc, ninfo->registersWithLastBlock, NR_REG_SIZE) != REDISMODULE_OK) {
+  if (FGC_recvFixed(fgc, &ninfo->registersSize, sizeof(ninfo->registersSize)) != REDISMODULE_OK ||
+      ninfo->registersSize > NUM_GC_MAX_REG_SIZE) {
     return REDISMODULE_ERR;
   }
-  return FGC_recvFixed(fgc, ninfo->registersWithoutLastBlock, NR_REG_SIZE);
+  if (FGC_recvFixed(fgc, ninfo->registersWithLastBlock, ninfo->registersSize) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  return FGC_recvFixed(fgc, ninfo->registersWithoutLastBlock, ninfo->registersSize);
 }
 
 static FGCError recvNumIdx(ForkGC *gc, NumGcInfo *ninfo) {
@@ -513,17 +772,18 @@ error:
 }
 
 static void resetCardinality(NumGcInfo *info, NumericRange *range, size_t blocksSinceFork) {
+  // The exact distinct values may include collected ones
+  NumericRange_DropExactValues(range);
   if (info->info.blocks_ignored == 0) {
-    hll_set_registers(&range->hll, info->registersWithLastBlock, NR_REG_SIZE);
+    hll_set_registers(&range->hll, info->registersWithLastBlock, info->registersSize);
     if (blocksSinceFork == 0) {
       return; // No blocks were added since the fork. We're done
     }
   } else {
-    hll_set_registers(&range->hll, info->registersWithoutLastBlock, NR_REG_SIZE);
+    hll_set_registers(&range->hll, info->registersWithoutLastBlock, info->registersSize);
   }
   // Add the entries that were added since the fork to the HLL
-  size_t startIdx = GcScanDelta_LastBlockIdx(info->delta);
-  const IndexBlock *startBlock = InvertedIndex_BlockRef(range->entries, startIdx);
+  const IndexBlock *startBlock = InvertedIndex_BlockRef(range->entries, info->lastBlockIdx);
   t_docId startId = IndexBlock_FirstId(startBlock);
   IndexDecoderCtx decoderCtx = {.tag = IndexDecoderCtx_None};
   IndexReader *reader = NewIndexReader(range->entries, decoderCtx);
@@ -541,76 +801,63 @@ static void resetCardinality(NumGcInfo *info, NumericRange *range, size_t blocks
   IndexResult_Free(res);
 }
 
-static void applyNumIdx(ForkGC *gc, RedisSearchCtx *sctx, NumGcInfo *ninfo) {
-  NumericRangeNode *currNode = ninfo->node;
-  InvertedIndexGcDelta *delta = ninfo->delta;
-  II_GCScanStats *info = &ninfo->info;
-  size_t blocksSinceFork = InvertedIndex_NumBlocks(currNode->range->entries) - GcScanDelta_LastBlockIdx(delta) - 1; // record before applying changes
-  InvertedIndex_ApplyGcDelta(currNode->range->entries, delta, info);
-  currNode->range->invertedIndexSize += info->bytes_allocated;
-  currNode->range->invertedIndexSize -= info->bytes_freed;
-
-  FGC_updateStats(gc, sctx, info->entries_removed, info->bytes_freed, info->bytes_allocated, info->blocks_ignored);
-
-  resetCardinality(ninfo, currNode->range, blocksSinceFork);
-}
-
-static FGCError FGC_parentHandleTerms(ForkGC *gc) {
-  FGCError status = FGC_COLLECTED;
-  size_t len;
-  char *term = NULL;
-  if (FGC_recvBuffer(gc, (void **)&term, &len) != REDISMODULE_OK) {
-    return FGC_CHILD_ERROR;
-  }
-
-  if (term == RECV_BUFFER_EMPTY) {
-    return FGC_DONE;
+static void applyNumIdxJob(void *arg) {
+  NumGcInfo *ninfo = arg;
+  if (ninfo->node) {
+    InvertedIndex_ApplyGcDelta(ninfo->node->range->entries, ninfo->delta, &ninfo->info);
+    ninfo->delta = NULL; // ownership passed to InvertedIndex_ApplyGcDelta
   }
+}
 
-  II_GCScanStats info = {0};
-  II_GCReader rd = { .ctx = gc, .read = pipe_read_cb };
-
-  InvertedIndexGcDelta *delta = InvertedIndex_GcDelta_Read(&rd);
-  bool shouldFreeDeltas = true;
-
-  if (delta == NULL) {
-    rm_free(term);
-    return FGC_CHILD_ERROR;
-  }
+// The inverted indexes the parent receives before applying them under a single hold of the write
+// lock, on the apply threads if there are any (see `_FORK_GC_APPLY_THREADS`)
+#define FGC_APPLY_BATCH 64
 
-  StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
-  IndexSpec *sp = StrongRef_Get(spec_ref);
-  if (!sp) {
-    status = FGC_SPEC_DELETED;
-    goto cleanup;
+/* A received inverted index of a term or a tag value, which the parent applies */
+typedef struct {
+  // Resolved by the parent under the write lock, NULL if the index is not applied
+  InvertedIndex *idx;
+  InvertedIndexGcDelta *delta;
+  II_GCScanStats info;
+  char *key;
+  size_t keyLen;
+} FGCApplyJob;
+
+static void FGC_applyJob(void *arg) {
+  FGCApplyJob *job = arg;
+  if (job->idx) {
+    InvertedIndex_ApplyGcDelta(job->idx, job->delta, &job->info);
+    job->delta = NULL; // ownership passed to InvertedIndex_ApplyGcDelta
   }
+}
 
-  RedisSearchCtx sctx_ = SEARCH_CTX_STATIC(gc->ctx, sp);
-  RedisSearchCtx *sctx = &sctx_;
-
-  RedisSearchCtx_LockSpecWrite(sctx);
-
-  InvertedIndex *idx = Redis_OpenInvertedIndex(sctx, term, len, DONT_CREATE_INDEX, NULL);
-
-  if (idx == NULL) {
-    status = FGC_PARENT_ERROR;
-    goto cleanup;
+static void FGC_freeApplyJobs(FGCApplyJob *jobs, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    if (jobs[i].delta) {
+      InvertedIndex_GcDelta_Free(jobs[i].delta);
+    }
+    rm_free(jobs[i].key);
   }
+}
 
-  InvertedIndex_ApplyGcDelta(idx, delta, &info);
-  shouldFreeDeltas = false; // ownership passed to InvertedIndex_ApplyGcDelta
+static void FGC_parentCleanTerm(ForkGC *gc, RedisSearchCtx *sctx, FGCApplyJob *job) {
+  const char *term = job->key;
+  size_t len = job->keyLen;
+  II_GCScanStats *info = &job->info;
+  sctx->spec->revision++;
 
-  if (InvertedIndex_NumDocs(idx) == 0) {
+  if (InvertedIndex_NumDocs(job->idx) == 0) {
 
     // inverted index was cleaned entirely lets free it
     RedisModuleString *termKey = fmtRedisTermKey(sctx, term, len);
     size_t formatedTremLen;
     const char *formatedTrem = RedisModule_StringPtrLen(termKey, &formatedTremLen);
+    TermIndexCache_Remove(sctx->spec->termIndexes, term, len);
     if (sctx->spec->keysDict) {
       // get memory before deleting the inverted index
-      size_t inv_idx_size = InvertedIndex_MemUsage(idx);
+      size_t inv_idx_size = InvertedIndex_MemUsage(job->idx);
       if (dictDelete(sctx->spec->keysDict, termKey) == DICT_OK) {
-        info.bytes_freed += inv_idx_size;
+        info->bytes_freed += inv_idx_size;
       }
     }
 
@@ -622,218 +869,350 @@ static FGCError FGC_parentHandleTerms(ForkGC *gc) {
     sctx->spec->stats.numTerms--;
     sctx->spec->stats.termsSize -= len;
     RedisModule_FreeString(sctx->redisCtx, termKey);
+    if (sctx->spec->spellDeletes) {
+      SpellDeleteIndex_Remove(sctx->spec->spellDeletes, term, len);
+    }
     if (sctx->spec->suffix) {
       deleteSuffixTrie(sctx->spec->suffix, term, len);
+    } else if (sctx->spec->suffixArray) {
+      SuffixArray_Delete(sctx->spec->suffixArray, term, len);
     }
   }
 
-  FGC_updateStats(gc, sctx, info.entries_removed, info.bytes_freed, info.bytes_allocated, info.blocks_ignored);
-
-cleanup:
+  FGC_updateStats(gc, sctx, info->entries_removed, info->bytes_freed, info->bytes_allocated, info->blocks_ignored);
+}
 
-  if (sp) {
-    RedisSearchCtx_UnlockSpec(sctx);
-    IndexSpecRef_Release(spec_ref);
+/* Apply a batch of terms. The indexes are independent of each other, so only their cleanup, which
+ * updates the structures of the spec, is serial */
+static FGCError FGC_parentApplyTerms(ForkGC *gc, FGCApplyJob *jobs, size_t n) {
+  FGCError status = FGC_COLLECTED;
+  StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    FGC_freeApplyJobs(jobs, n);
+    return FGC_SPEC_DELETED;
   }
-  rm_free(term);
 
-  if (shouldFreeDeltas) {
-    InvertedIndex_GcDelta_Free(delta);
+  RedisSearchCtx sctx_ = SEARCH_CTX_STATIC(gc->ctx, sp);
+  RedisSearchCtx *sctx = &sctx_;
+
+  FGC_lockSpecWrite(gc, sctx);
+
+  for (size_t i = 0; i < n; ++i) {
+    jobs[i].idx = Redis_OpenInvertedIndex(sctx, jobs[i].key, jobs[i].keyLen, DONT_CREATE_INDEX, NULL);
+    if (jobs[i].idx == NULL) {
+      status = FGC_PARENT_ERROR;
+    }
   }
+  GC_RunApplyJobs(FGC_applyJob, jobs, sizeof(*jobs), n);
+  for (size_t i = 0; i < n; ++i) {
+    if (jobs[i].idx) {
+      FGC_parentCleanTerm(gc, sctx, &jobs[i]);
+    }
+  }
+
+  FGC_unlockSpec(gc, sctx);
+  IndexSpecRef_Release(spec_ref);
+  FGC_freeApplyJobs(jobs, n);
   return status;
 }
 
-static FGCError FGC_parentHandleNumeric(ForkGC *gc) {
-  size_t fieldNameLen;
-  char *fieldName = NULL;
-  const FieldSpec *fs = NULL;
-  RedisModuleString *keyName = NULL;
-  uint64_t rtUniqueId;
-  NumericRangeTree *rt = NULL;
-  FGCError status = recvNumericTagHeader(gc, &fieldName, &fieldNameLen, &rtUniqueId);
-  bool initialized = false;
-  if (status == FGC_DONE) {
-    return FGC_DONE;
-  }
+static FGCError FGC_parentHandleTerms(ForkGC *gc) {
+  FGCError status = FGC_COLLECTED;
+  FGCApplyJob jobs[FGC_APPLY_BATCH];
+  size_t n = 0;
 
-  NumGcInfo ninfo = {
-    .registersWithLastBlock = rm_malloc(NR_REG_SIZE),
-    .registersWithoutLastBlock = rm_malloc(NR_REG_SIZE),
-  };
-  while (status == FGC_COLLECTED) {
-    // Read from GC process
-    FGCError status2 = recvNumIdx(gc, &ninfo);
-    bool shouldFreeDeltas = true;
-    if (status2 == FGC_DONE) {
-      break;
-    } else if (status2 != FGC_COLLECTED) {
-      status = status2;
+  while (n < FGC_APPLY_BATCH) {
+    size_t len;
+    char *term = NULL;
+    if (FGC_recvBuffer(gc, (void **)&term, &len) != REDISMODULE_OK) {
+      status = FGC_CHILD_ERROR;
       break;
     }
 
-    StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
-    IndexSpec *sp = StrongRef_Get(spec_ref);
-    if (!sp) {
-      status = FGC_SPEC_DELETED;
-      goto loop_cleanup;
+    if (term == RECV_BUFFER_EMPTY) {
+      status = FGC_DONE;
+      break;
     }
-    RedisSearchCtx _sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
-    RedisSearchCtx *sctx = &_sctx;
-
-    RedisSearchCtx_LockSpecWrite(sctx);
 
-    if (!initialized) {
-      fs = IndexSpec_GetFieldWithLength(sctx->spec, fieldName, fieldNameLen);
-      keyName = IndexSpec_GetFormattedKey(sctx->spec, fs, fs->types);
-      rt = openNumericKeysDict(sctx->spec, keyName, DONT_CREATE_INDEX);
-      initialized = true;
+    II_GCReader rd = { .ctx = gc, .read = pipe_read_cb };
+    InvertedIndexGcDelta *delta = InvertedIndex_GcDelta_Read(&rd);
+    if (delta == NULL) {
+      rm_free(term);
+      status = FGC_CHILD_ERROR;
+      break;
     }
+    jobs[n++] = (FGCApplyJob){.delta = delta, .key = term, .keyLen = len};
+  }
 
-    if (rt->uniqueId != rtUniqueId) {
-      status = FGC_PARENT_ERROR;
-      goto loop_cleanup;
+  if (n) {
+    FGCError rc = FGC_parentApplyTerms(gc, jobs, n);
+    if (rc != FGC_COLLECTED && status != FGC_CHILD_ERROR) {
+      status = rc;
     }
+  }
+  return status;
+}
 
-    if (!ninfo.node->range) {
-      gc->stats.gcNumericNodesMissed++;
-      goto loop_cleanup;
-    }
+/* Apply a batch of the nodes of a numeric tree. The nodes split since the fork are skipped */
+static FGCError FGC_parentApplyNumeric(ForkGC *gc, const char *fieldName, size_t fieldNameLen,
+                                       uint64_t rtUniqueId, NumericRangeTree **rtp,
+                                       NumGcInfo *batch, size_t n) {
+  FGCError status = FGC_COLLECTED;
+  StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    status = FGC_SPEC_DELETED;
+    goto cleanup;
+  }
+  RedisSearchCtx _sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
+  RedisSearchCtx *sctx = &_sctx;
+
+  FGC_lockSpecWrite(gc, sctx);
+
+  if (!*rtp) {
+    const FieldSpec *fs = IndexSpec_GetFieldWithLength(sctx->spec, fieldName, fieldNameLen);
+    RedisModuleString *keyName = IndexSpec_GetFormattedKey(sctx->spec, fs, fs->types);
+    *rtp = openNumericKeysDict(sctx->spec, keyName, DONT_CREATE_INDEX);
+  }
+  NumericRangeTree *rt = *rtp;
 
-    applyNumIdx(gc, sctx, &ninfo);
-    shouldFreeDeltas = false; // ownership passed to applyNumIdx
-    rt->numEntries -= ninfo.info.entries_removed;
-    rt->invertedIndexesSize -= ninfo.info.bytes_freed;
-    rt->invertedIndexesSize += ninfo.info.bytes_allocated;
+  if (rt->uniqueId != rtUniqueId) {
+    status = FGC_PARENT_ERROR;
+    FGC_unlockSpec(gc, sctx);
+    goto cleanup;
+  }
 
-    if (InvertedIndex_NumDocs(ninfo.node->range->entries) == 0) {
+  for (size_t i = 0; i < n; ++i) {
+    NumGcInfo *ninfo = &batch[i];
+    if (!ninfo->node->range) {
+      gc->stats.gcNumericNodesMissed++;
+      ninfo->node = NULL;
+      continue;
+    }
+    // record before applying changes
+    ninfo->lastBlockIdx = GcScanDelta_LastBlockIdx(ninfo->delta);
+    ninfo->blocksSinceFork = InvertedIndex_NumBlocks(ninfo->node->range->entries) -
+                             ninfo->lastBlockIdx - 1;
+  }
+  GC_RunApplyJobs(applyNumIdxJob, batch, sizeof(*batch), n);
+  for (size_t i = 0; i < n; ++i) {
+    NumGcInfo *ninfo = &batch[i];
+    if (!ninfo->node) {
+      continue;
+    }
+    NumericRange *range = ninfo->node->range;
+    II_GCScanStats *info = &ninfo->info;
+    range->invertedIndexSize += info->bytes_allocated;
+    range->invertedIndexSize -= info->bytes_freed;
+    FGC_updateStats(gc, sctx, info->entries_removed, info->bytes_freed, info->bytes_allocated, info->blocks_ignored);
+    resetCardinality(ninfo, range, ninfo->blocksSinceFork);
+
+    rt->numEntries -= info->entries_removed;
+    rt->invertedIndexesSize -= info->bytes_freed;
+    rt->invertedIndexesSize += info->bytes_allocated;
+
+    if (InvertedIndex_NumDocs(range->entries) == 0) {
       rt->emptyLeaves++;
     }
+  }
+  FGC_unlockSpec(gc, sctx);
+
+cleanup:
+  for (size_t i = 0; i < n; ++i) {
+    if (batch[i].delta) {
+      InvertedIndex_GcDelta_Free(batch[i].delta);
+      batch[i].delta = NULL;
+    }
+  }
+  if (sp) {
+    IndexSpecRef_Release(spec_ref);
+  }
+  return status;
+}
+
+static FGCError FGC_parentHandleNumeric(ForkGC *gc) {
+  size_t fieldNameLen;
+  char *fieldName = NULL;
+  uint64_t rtUniqueId;
+  NumericRangeTree *rt = NULL;
+  FGCError status = recvNumericTagHeader(gc, &fieldName, &fieldNameLen, &rtUniqueId);
+  if (status == FGC_DONE) {
+    return FGC_DONE;
+  }
 
-  loop_cleanup:
-    if (shouldFreeDeltas) {
-      InvertedIndex_GcDelta_Free(ninfo.delta);
+  NumGcInfo *batch = rm_calloc(FGC_APPLY_BATCH, sizeof(*batch));
+  char *registers = rm_malloc(2 * FGC_APPLY_BATCH * NUM_GC_MAX_REG_SIZE);
+  for (size_t i = 0; i < FGC_APPLY_BATCH; ++i) {
+    batch[i].registersWithLastBlock = registers + 2 * i * NUM_GC_MAX_REG_SIZE;
+    batch[i].registersWithoutLastBlock = registers + (2 * i + 1) * NUM_GC_MAX_REG_SIZE;
+  }
+  bool fieldDone = false;
+  while (status == FGC_COLLECTED && !fieldDone) {
+    // Read from GC process
+    size_t n = 0;
+    while (n < FGC_APPLY_BATCH) {
+      batch[n].delta = NULL;
+      batch[n].info = (II_GCScanStats){0};
+      FGCError status2 = recvNumIdx(gc, &batch[n]);
+      if (status2 == FGC_DONE) {
+        fieldDone = true;
+        break;
+      } else if (status2 != FGC_COLLECTED) {
+        status = status2;
+        break;
+      }
+      ++n;
     }
-    if (sp) {
-      RedisSearchCtx_UnlockSpec(sctx);
-      IndexSpecRef_Release(spec_ref);
+    if (n) {
+      FGCError rc = FGC_parentApplyNumeric(gc, fieldName, fieldNameLen, rtUniqueId, &rt, batch, n);
+      if (rc != FGC_COLLECTED && status == FGC_COLLECTED) {
+        status = rc;
+      }
     }
   }
 
-  rm_free(ninfo.registersWithLastBlock);
-  rm_free(ninfo.registersWithoutLastBlock);
+  rm_free(registers);
+  rm_free(batch);
   rm_free(fieldName);
 
-  if (status == FGC_COLLECTED && rt && gc->cleanNumericEmptyNodes) {
+  if (status == FGC_COLLECTED && rt) {
     // We need to have a valid strong reference to the spec in order to dereference rt
     StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
     IndexSpec *sp = StrongRef_Get(spec_ref);
     if (!sp) return FGC_SPEC_DELETED;
     RedisSearchCtx sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
-    RedisSearchCtx_LockSpecWrite(&sctx);
-    if (rt->emptyLeaves >= rt->numLeaves / 2) {
+    FGC_lockSpecWrite(gc, &sctx);
+    if (gc->cleanNumericEmptyNodes && rt->emptyLeaves >= rt->numLeaves / 2) {
       NRN_AddRv rv = NumericRangeTree_TrimEmptyLeaves(rt);
       // rv.sz is the number of bytes added. Since we are cleaning empty leaves, it should be negative
       FGC_updateStats(gc, &sctx, 0, -rv.sz, 0, 0);
     }
-    RedisSearchCtx_UnlockSpec(&sctx);
+    if (gc->cleanNumericEmptyNodes) {
+      NRN_AddRv rv = NumericRangeTree_Rebalance(rt);
+      // Merging leaves frees memory, while the ranges of rebuilt inner nodes may take more
+      FGC_updateStats(gc, &sctx, -rv.numRecords, rv.sz < 0 ? -rv.sz : 0, rv.sz > 0 ? rv.sz : 0, 0);
+    }
+    // The histogram still counts the collected entries
+    NumericRangeTree_RebuildHistogram(rt);
+    FGC_unlockSpec(gc, &sctx);
     IndexSpecRef_Release(spec_ref);
   }
 
   return status;
 }
 
-static FGCError FGC_parentHandleTags(ForkGC *gc) {
-  size_t fieldNameLen;
-  char *fieldName;
-  uint64_t tagUniqueId;
-  InvertedIndex *value = NULL;
-  FGCError status = recvNumericTagHeader(gc, &fieldName, &fieldNameLen, &tagUniqueId);
+/* Apply a batch of the values of a tag field */
+static FGCError FGC_parentApplyTags(ForkGC *gc, const char *fieldName, uint64_t tagUniqueId,
+                                    FGCApplyJob *jobs, size_t n) {
+  FGCError status = FGC_COLLECTED;
+  StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    FGC_freeApplyJobs(jobs, n);
+    return FGC_SPEC_DELETED;
+  }
+  RedisSearchCtx _sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
+  RedisSearchCtx *sctx = &_sctx;
 
-  while (status == FGC_COLLECTED) {
-    InvertedIndexGcDelta *delta = NULL;
-    II_GCScanStats info = {0};
-    RedisModuleString *keyName = NULL;
-    TagIndex *tagIdx = NULL;
-    char *tagVal = NULL;
-    size_t tagValLen;
+  FGC_lockSpecWrite(gc, sctx);
 
-    if (FGC_recvFixed(gc, &value, sizeof value) != REDISMODULE_OK) {
-      status = FGC_CHILD_ERROR;
-      break;
-    }
+  RedisModuleString *keyName = IndexSpec_GetFormattedKeyByName(sctx->spec, fieldName, INDEXFLD_T_TAG);
+  TagIndex *tagIdx = TagIndex_Open(sctx->spec, keyName, DONT_CREATE_INDEX);
 
-    // No more tags values in tag field
-    if (value == NULL) {
-      RS_LOG_ASSERT(status == FGC_COLLECTED, "GC status is COLLECTED");
-      break;
-    }
+  if (tagIdx->uniqueId != tagUniqueId) {
+    status = FGC_CHILD_ERROR;
+    goto unlock;
+  }
 
-    StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
-    IndexSpec *sp = StrongRef_Get(spec_ref);
-    if (!sp) {
-      status = FGC_SPEC_DELETED;
-      break;
+  for (size_t i = 0; i < n; ++i) {
+    // The child sent the index it scanned, which must still be the one of the value
+    InvertedIndex *value = jobs[i].idx;
+    size_t dummy_size;
+    InvertedIndex *idx = TagIndex_OpenIndex(tagIdx, jobs[i].key, jobs[i].keyLen, DONT_CREATE_INDEX, &dummy_size);
+    if (idx == TRIEMAP_NOTFOUND || idx != value) {
+      jobs[i].idx = NULL;
+      status = FGC_PARENT_ERROR;
     }
-    RedisSearchCtx _sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
-    RedisSearchCtx *sctx = &_sctx;
+  }
+  GC_RunApplyJobs(FGC_applyJob, jobs, sizeof(*jobs), n);
 
-    if (FGC_recvBuffer(gc, (void **)&tagVal, &tagValLen) != REDISMODULE_OK) {
-      status = FGC_CHILD_ERROR;
-      goto loop_cleanup;
+  for (size_t i = 0; i < n; ++i) {
+    FGCApplyJob *job = &jobs[i];
+    if (!job->idx) {
+      continue;
     }
+    tagIdx->revision++;  // the cached sets may hold the collected documents
 
-    II_GCReader rd = { .ctx = gc, .read = pipe_read_cb };
-    delta = InvertedIndex_GcDelta_Read(&rd);
-    bool shouldFreeDeltas = true;
+    // if tag value is empty, let's remove it.
+    if (InvertedIndex_NumDocs(job->idx) == 0) {
+      // get memory before deleting the inverted index
+      job->info.bytes_freed += InvertedIndex_MemUsage(job->idx);
+      TagIndex_DeleteValue(tagIdx, job->key, job->keyLen);
 
-    if (delta == NULL) {
-      status = FGC_CHILD_ERROR;
-      goto loop_cleanup;
+      if (tagIdx->suffix) {
+        deleteSuffixTrieMap(tagIdx->suffix, job->key, job->keyLen);
+      }
     }
 
-    RedisSearchCtx_LockSpecWrite(sctx);
-
-    keyName = IndexSpec_GetFormattedKeyByName(sctx->spec, fieldName, INDEXFLD_T_TAG);
-    tagIdx = TagIndex_Open(sctx->spec, keyName, DONT_CREATE_INDEX);
+    FGC_updateStats(gc, sctx, job->info.entries_removed, job->info.bytes_freed,
+                    job->info.bytes_allocated, job->info.blocks_ignored);
+  }
 
-    if (tagIdx->uniqueId != tagUniqueId) {
-      status = FGC_CHILD_ERROR;
-      goto loop_cleanup;
-    }
+unlock:
+  FGC_unlockSpec(gc, sctx);
+  IndexSpecRef_Release(spec_ref);
+  FGC_freeApplyJobs(jobs, n);
+  return status;
+}
 
-    size_t dummy_size;
-    InvertedIndex *idx = TagIndex_OpenIndex(tagIdx, tagVal, tagValLen, DONT_CREATE_INDEX, &dummy_size);
-    if (idx == TRIEMAP_NOTFOUND || idx != value) {
-      status = FGC_PARENT_ERROR;
-      goto loop_cleanup;
-    }
+static FGCError FGC_parentHandleTags(ForkGC *gc) {
+  size_t fieldNameLen;
+  char *fieldName;
+  uint64_t tagUniqueId;
+  FGCError status = recvNumericTagHeader(gc, &fieldName, &fieldNameLen, &tagUniqueId);
+  bool fieldDone = false;
 
-    InvertedIndex_ApplyGcDelta(idx, delta, &info);
-    shouldFreeDeltas = false; // ownership passed to InvertedIndex_ApplyGcDelta
+  while (status == FGC_COLLECTED && !fieldDone) {
+    FGCApplyJob jobs[FGC_APPLY_BATCH];
+    size_t n = 0;
 
-    // if tag value is empty, let's remove it.
-    if (InvertedIndex_NumDocs(idx) == 0) {
-      // get memory before deleting the inverted index
-      info.bytes_freed += InvertedIndex_MemUsage(idx);
-      TrieMap_Delete(tagIdx->values, tagVal, tagValLen, (void (*)(void *))InvertedIndex_Free);
+    while (n < FGC_APPLY_BATCH) {
+      InvertedIndex *value = NULL;
+      char *tagVal = NULL;
+      size_t tagValLen;
 
-      if (tagIdx->suffix) {
-        deleteSuffixTrieMap(tagIdx->suffix, tagVal, tagValLen);
+      if (FGC_recvFixed(gc, &value, sizeof value) != REDISMODULE_OK) {
+        status = FGC_CHILD_ERROR;
+        break;
       }
-    }
 
-    FGC_updateStats(gc, sctx, info.entries_removed, info.bytes_freed, info.bytes_allocated, info.blocks_ignored);
+      // No more tags values in tag field
+      if (value == NULL) {
+        fieldDone = true;
+        break;
+      }
 
-  loop_cleanup:
-    RedisSearchCtx_UnlockSpec(sctx);
-    IndexSpecRef_Release(spec_ref);
+      if (FGC_recvBuffer(gc, (void **)&tagVal, &tagValLen) != REDISMODULE_OK) {
+        status = FGC_CHILD_ERROR;
+        break;
+      }
 
-    if (shouldFreeDeltas) {
-      InvertedIndex_GcDelta_Free(delta);
+      II_GCReader rd = { .ctx = gc, .read = pipe_read_cb };
+      InvertedIndexGcDelta *delta = InvertedIndex_GcDelta_Read(&rd);
+      if (delta == NULL) {
+        rm_free(tagVal);
+        status = FGC_CHILD_ERROR;
+        break;
+      }
+      jobs[n++] = (FGCApplyJob){.idx = value, .delta = delta, .key = tagVal, .keyLen = tagValLen};
     }
 
-    if (tagVal) {
-      rm_free(tagVal);
+    if (n) {
+      FGCError rc = FGC_parentApplyTags(gc, fieldName, tagUniqueId, jobs, n);
+      if (rc != FGC_COLLECTED && status == FGC_COLLECTED) {
+        status = rc;
+      }
     }
   }
 
@@ -875,7 +1254,7 @@ static FGCError FGC_parentHandleMissingDocs(ForkGC *gc) {
   RedisSearchCtx sctx_ = SEARCH_CTX_STATIC(gc->ctx, sp);
   RedisSearchCtx *sctx = &sctx_;
 
-  RedisSearchCtx_LockSpecWrite(sctx);
+  FGC_lockSpecWrite(gc, sctx);
   InvertedIndex *idx = dictFetchValue(sctx->spec->missingFieldDict, fieldName);
 
   if (idx == NULL) {
@@ -896,7 +1275,7 @@ static FGCError FGC_parentHandleMissingDocs(ForkGC *gc) {
 cleanup:
 
   if (sp) {
-    RedisSearchCtx_UnlockSpec(sctx);
+    FGC_unlockSpec(gc, sctx);
     IndexSpecRef_Release(spec_ref);
   }
   HiddenString_Free(fieldName, false);
@@ -943,7 +1322,7 @@ static FGCError FGC_parentHandleExistingDocs(ForkGC *gc) {
   RedisSearchCtx sctx_ = SEARCH_CTX_STATIC(gc->ctx, sp);
   RedisSearchCtx *sctx = &sctx_;
 
-  RedisSearchCtx_LockSpecWrite(sctx);
+  FGC_lockSpecWrite(gc, sctx);
 
   InvertedIndex *idx = sp->existingDocs;
 
@@ -964,7 +1343,7 @@ static FGCError FGC_parentHandleExistingDocs(ForkGC *gc) {
 cleanup:
   rm_free(empty_indicator);
   if (sp) {
-    RedisSearchCtx_UnlockSpec(sctx);
+    FGC_unlockSpec(gc, sctx);
     IndexSpecRef_Release(spec_ref);
   }
 
@@ -975,6 +1354,47 @@ cleanup:
   return status;
 }
 
+// Compact the tag indexes to which many values were added since their last compaction
+static void FGC_parentCompactTags(ForkGC *gc) {
+  if (!gc->tagCompactThreshold) {
+    return;
+  }
+  StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    return;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
+  FGC_lockSpecWrite(gc, &sctx);
+  arrayof(FieldSpec*) tagFields = getFieldsByType(sp, INDEXFLD_T_TAG);
+  for (int i = 0; i < array_len(tagFields); ++i) {
+    RedisModuleString *keyName = IndexSpec_GetFormattedKey(sp, tagFields[i], INDEXFLD_T_TAG);
+    TagIndex *tagIdx = TagIndex_Open(sp, keyName, DONT_CREATE_INDEX);
+    if (tagIdx && TrieMap_NUniqueKeys(tagIdx->values) >= gc->tagCompactThreshold) {
+      TagIndex_Compact(tagIdx);
+    }
+  }
+  array_free(tagFields);
+  FGC_unlockSpec(gc, &sctx);
+  IndexSpecRef_Release(spec_ref);
+}
+
+// Pack again the R-trees of the geometry indexes which changed much since they were last packed
+static void FGC_parentRepackGeometry(ForkGC *gc) {
+  StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    return;
+  }
+  if (sp->flags & Index_HasGeometry) {
+    RedisSearchCtx sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
+    FGC_lockSpecWrite(gc, &sctx);
+    GeometryIndex_Repack(sp, false);
+    FGC_unlockSpec(gc, &sctx);
+  }
+  IndexSpecRef_Release(spec_ref);
+}
+
 FGCError FGC_parentHandleFromChild(ForkGC *gc) {
   FGCError status = FGC_COLLECTED;
   RedisModule_Log(gc->ctx, "debug", "ForkGC - parent start applying changes");
@@ -991,6 +1411,12 @@ FGCError FGC_parentHandleFromChild(ForkGC *gc) {
   COLLECT_FROM_CHILD(FGC_parentHandleTags(gc));
   COLLECT_FROM_CHILD(FGC_parentHandleMissingDocs(gc));
   COLLECT_FROM_CHILD(FGC_parentHandleExistingDocs(gc));
+  if (FGC_recvFixed(gc, &gc->cycleCut, sizeof(gc->cycleCut)) != REDISMODULE_OK ||
+      FGC_recvFixed(gc, &gc->stats.lastCowBytes, sizeof(gc->stats.lastCowBytes)) != REDISMODULE_OK) {
+    return FGC_CHILD_ERROR;
+  }
+  FGC_parentCompactTags(gc);
+  FGC_parentRepackGeometry(gc);
   RedisModule_Log(gc->ctx, "debug", "ForkGC - parent ends applying changes");
 
   return status;
@@ -1005,6 +1431,57 @@ static inline bool isOutOfMemory(RedisModuleCtx *ctx) {
   return used_memory_ratio > 1;
 }
 
+/* Map the region in which the child writes its results. If it can't be mapped, they all go through
+ * the pipe */
+static void FGC_mapShared(ForkGC *gc) {
+  gc->sharedPos = gc->sharedEnd = gc->inlineLeft = 0;
+  gc->shared = mmap(NULL, FGC_SHARED_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (gc->shared == MAP_FAILED) {
+    RedisModule_Log(gc->ctx, "notice", "ForkGC - couldn't map a shared region (errno %d), using the pipe", errno);
+    gc->shared = NULL;
+  }
+}
+
+static void FGC_unmapShared(ForkGC *gc) {
+  if (gc->shared) {
+    munmap(gc->shared, FGC_SHARED_SIZE);
+    gc->shared = NULL;
+  }
+}
+
+// Any of the ids deleted from now on is looked for by the next cycle. GIL must be held
+static void FGC_forgetDeletedIds(ForkGC *gc) {
+  array_free(gc->deletedIds);
+  gc->deletedIds = NULL;
+  gc->deletedIdsOverflow = true;
+}
+
+// Set the scan of the cycle the child is about to run. GIL must be held
+static void FGC_startCycle(ForkGC *gc) {
+  gc->deletedIdsOfCycle = array_len(gc->deletedIds);
+  gc->scanAll = gc->deletedIdsOverflow;
+  gc->deletedIdsOverflow = false;
+  gc->cycleCut = false;
+  gc->cycleBudgetMs = gc->lastCycleCut ? 0 : RSGlobalConfig.gcConfigParams.forkGc.forkGcCycleBudgetMs;
+}
+
+/* Forget the deleted documents of the cycle if it collected all their entries. Otherwise the next
+ * cycle looks for them again. GIL must be held */
+static void FGC_endCycle(ForkGC *gc, bool complete) {
+  gc->lastCycleCut = gc->cycleCut;
+  if (complete) {
+    if (!gc->deletedIdsOverflow && gc->deletedIdsOfCycle) {
+      size_t n = gc->deletedIdsOfCycle;
+      memmove(gc->deletedIds, gc->deletedIds + n, (array_len(gc->deletedIds) - n) * sizeof(t_docId));
+      gc->deletedIds = array_trimm_len(gc->deletedIds, n);
+    }
+  } else if (gc->scanAll) {
+    // The ids of the documents deleted before the cycle were not kept
+    FGC_forgetDeletedIds(gc);
+  }
+  gc->deletedIdsOfCycle = 0;
+}
+
 static int periodicCb(void *privdata) {
   ForkGC *gc = privdata;
   RedisModuleCtx *ctx = gc->ctx;
@@ -1027,7 +1504,7 @@ static int periodicCb(void *privdata) {
 
   if (gc->deletedDocsFromLastRun < RSGlobalConfig.gcConfigParams.forkGc.forkGcCleanThreshold) {
     IndexSpecRef_Release(early_check);
-    return 1;
+    return TermTiers_RunCycle(gc->index);
   }
 
   int gcrv = 1;
@@ -1071,12 +1548,21 @@ static int periodicCb(void *privdata) {
   }
 
   gc->execState = FGC_STATE_SCANNING;
+  FGC_startCycle(gc);
+  FGC_mapShared(gc);
+  gc->stats.lastBytesReceived = gc->stats.lastCowBytes = 0;
+  gc->stats.lastWriteLockUs = 0;
 
+  rs_wall_clock forkStart;
+  rs_wall_clock_init(&forkStart);
   cpid = RedisModule_Fork(NULL, NULL);  // duplicate the current process
+  gc->stats.lastForkUs = rs_wall_clock_elapsed_ns(&forkStart) / 1000;
 
   if (cpid == -1) {
     RedisModule_Log(ctx, "warning", "fork failed - got errno %d, aborting fork GC", errno);
     gc->retryInterval.tv_sec = RSGlobalConfig.gcConfigParams.forkGc.forkGcRetryInterval;
+    gc->deletedIdsOverflow = gc->scanAll;
+    FGC_unmapShared(gc);
     IndexSpecRef_Release(early_check);
 
     RedisModule_ThreadSafeContextUnlock(ctx);
@@ -1100,6 +1586,9 @@ static int periodicCb(void *privdata) {
   if (cpid == 0) {
     // fork process
     setpriority(PRIO_PROCESS, getpid(), 19);
+    // The child is single threaded, so this keeps its scan off the CPUs of the main thread and
+    // the workers. It scans just as well where it is if it can't be pinned
+    CPUList_PinCurrentThread(RSGlobalConfig.forkGCCPUs);
     close(gc->pipe_read_fd);
     // Pass the index to the child process
     FGC_childScanIndexes(gc, StrongRef_Get(early_check));
@@ -1119,10 +1608,22 @@ static int periodicCb(void *privdata) {
 
     gc->execState = FGC_STATE_APPLYING;
     gc->cleanNumericEmptyNodes = RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes;
-    if (FGC_parentHandleFromChild(gc) == FGC_SPEC_DELETED) {
+    gc->tagCompactThreshold = RSGlobalConfig.tagCompactThreshold;
+    uint64_t blocksDenied = gc->stats.gcBlocksDenied;
+    uint64_t nodesMissed = gc->stats.gcNumericNodesMissed;
+    rs_wall_clock applyStart;
+    rs_wall_clock_init(&applyStart);
+    FGCError status = FGC_parentHandleFromChild(gc);
+    gc->stats.lastApplyUs = rs_wall_clock_elapsed_ns(&applyStart) / 1000;
+    if (status == FGC_SPEC_DELETED) {
       gcrv = 0;
     }
+    // The entries of the deleted documents remain in the blocks that changed since the fork
+    bool complete = status == FGC_DONE && !gc->cycleCut &&
+                    gc->stats.gcBlocksDenied == blocksDenied &&
+                    gc->stats.gcNumericNodesMissed == nodesMissed;
     close(gc->pipe_read_fd);
+    FGC_unmapShared(gc);
     // give the child some time to exit gracefully
     for (int attempt = 0; attempt < GC_WAIT_ATTEMPTS; ++attempt) {
       if (waitpid(cpid, NULL, WNOHANG) == 0) {
@@ -1134,11 +1635,15 @@ static int periodicCb(void *privdata) {
     // out of file descriptor
     RedisModule_ThreadSafeContextLock(ctx);
     RedisModule_KillForkChild(cpid);
+    FGC_endCycle(gc, complete);
     RedisModule_ThreadSafeContextUnlock(ctx);
 
     if (gcrv) {
       gcrv = VecSim_CallTieredIndexesGC(gc->index);
     }
+    if (gcrv) {
+      gcrv = TermTiers_RunCycle(gc->index);
+    }
   }
 
   IndexsGlobalStats_UpdateLogicallyDeleted(-num_docs_to_clean);
@@ -1192,6 +1697,7 @@ void FGC_Apply(ForkGC *gc) NO_TSAN_CHECK {
 static void onTerminateCb(void *privdata) {
   ForkGC *gc = privdata;
   IndexsGlobalStats_UpdateLogicallyDeleted(-gc->deletedDocsFromLastRun);
+  array_free(gc->deletedIds);
   WeakRef_Release(gc->index);
   RedisModule_FreeThreadSafeContext(gc->ctx);
   rm_free(gc);
@@ -1225,10 +1731,18 @@ static void statsForInfoCb(RedisModuleInfoCtx *ctx, void *gcCtx) {
 }
 #endif
 
-static void deleteCb(void *ctx) {
+static void deleteCb(void *ctx, t_docId docId) {
   ForkGC *gc = ctx;
   ++gc->deletedDocsFromLastRun;
   IndexsGlobalStats_UpdateLogicallyDeleted(1);
+  if (gc->deletedIdsOverflow) {
+    return;
+  }
+  if (array_len(gc->deletedIds) == FGC_MAX_DELETED_IDS) {
+    FGC_forgetDeletedIds(gc);
+  } else {
+    array_ensure_append_1(gc->deletedIds, docId);
+  }
 }
 
 static struct timespec getIntervalCb(void *ctx) {
@@ -1246,6 +1760,7 @@ ForkGC *FGC_New(StrongRef spec_ref, GCCallbacks *callbacks) {
   forkGc->retryInterval.tv_nsec = 0;
 
   forkGc->cleanNumericEmptyNodes = RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes;
+  forkGc->tagCompactThreshold = RSGlobalConfig.tagCompactThreshold;
   forkGc->ctx = RedisModule_GetDetachedThreadSafeContext(RSDummyContext);
 
   callbacks->onTerm = onTerminateCb;
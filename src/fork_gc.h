@@ -13,7 +13,9 @@
 #include "redismodule.h"
 #include "gc.h"
 #include "VecSim/vec_sim.h"
+#include "util/arr.h"
 #include <poll.h>
+#include <time.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +34,13 @@ typedef struct {
 
   uint64_t gcNumericNodesMissed;
   uint64_t gcBlocksDenied;
+
+  // The costs of the last cycle, for the benchmarks
+  long long lastForkUs;        // RedisModule_Fork, under the GIL
+  long long lastApplyUs;       // receiving and applying the results of the child
+  long long lastWriteLockUs;   // holding the write lock of the spec while applying
+  size_t lastBytesReceived;    // the results received from the child, in the pipe or shared region
+  size_t lastCowBytes;         // the pages the child copied on write, 0 if it can't tell
 } ForkGCStats;
 
 /* Internal definition of the garbage collector context (each index has one) */
@@ -49,15 +58,46 @@ typedef struct ForkGC {
   int pipe_write_fd;
   struct pollfd pollfd_read[1]; // pollfd to poll the read pipe so that we don't block while read
 
+  // The region shared with the child of the running cycle, into which it writes its results. It
+  // only sends their positions through the pipe. NULL if they all go through the pipe
+  char *shared;
+  // In the child, the results in [sharedPos, sharedEnd) are not sent yet. In the parent, they are
+  // the ones left of the chunk it reads
+  size_t sharedPos;
+  size_t sharedEnd;
+  // The results the parent has left to read from the pipe, once the region was full
+  size_t inlineLeft;
+
   volatile uint32_t pauseState;
   volatile uint32_t execState;
 
   struct timespec retryInterval;
   volatile size_t deletedDocsFromLastRun;
 
+  // The ids of the documents deleted since the last complete cycle, by order of deletion. The child
+  // only scans the inverted indexes with a block spanning some of them
+  arrayof(t_docId) deletedIds;
+  // Too many documents were deleted to keep their ids, so the next cycle scans all the indexes
+  bool deletedIdsOverflow;
+  // The number of the first `deletedIds` the running cycle collects
+  size_t deletedIdsOfCycle;
+  // The running cycle scans all the indexes
+  bool scanAll;
+  // The time budget of the scan of the running cycle, in milliseconds, or 0 if it has none
+  size_t cycleBudgetMs;
+  // The scan of the running cycle ran out of its budget and skipped the remaining indexes
+  bool cycleCut;
+  // The last cycle was cut, so the next one has no budget and reaches the indexes it skipped
+  bool lastCycleCut;
+  struct timespec scanStart;
+  // When the parent locked the spec for write, to count how long it holds the lock
+  uint64_t writeLockedAtNs;
+
   // current value of RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes
   // This value is updated during the periodic callback execution.
   int cleanNumericEmptyNodes;
+  // current value of RSGlobalConfig.tagCompactThreshold, updated as cleanNumericEmptyNodes is
+  unsigned int tagCompactThreshold;
   // a variable to store a percentage of the progress of the child process, used to send heartbeats
   float progress;
 } ForkGC;
@@ -19,8 +19,10 @@ typedef struct {
   ForwardIndexEntry ent;
 } khIdxEntry;
 
-#define ENTRIES_PER_BLOCK 32
-#define TERM_BLOCK_SIZE 128
+// The entries and the copied terms of a document live in blocks which are recycled by
+// ForwardIndex_Reset, so a pooled forward index stops allocating once its blocks fit the documents
+#define ENTRIES_PER_BLOCK 128
+#define TERM_BLOCK_SIZE 1024
 
 static int khtCompare(const KHTableEntry *entBase, const void *s, size_t n, uint32_t h) {
   khIdxEntry *ee = (khIdxEntry *)entBase;
@@ -223,6 +225,29 @@ static void ForwardIndex_HandleToken(ForwardIndex *idx, const char *tok, size_t
 
 }
 
+ForwardIndexEntry *ForwardIndex_Put(ForwardIndex *idx, const char *term, size_t len, uint32_t freq,
+                                     t_fieldMask fieldMask) {
+  int isNew = 0;
+  uint32_t hash = hashKey(term, len);
+  ForwardIndexEntry *h = &makeEntry(idx, term, len, hash, &isNew)->ent;
+  if (!isNew) {
+    return NULL;
+  }
+  h->next = NULL;
+  h->hash = hash;
+  h->term = copyTempString(idx, term, len);
+  h->len = len;
+  h->freq = freq;
+  h->fieldMask = fieldMask;
+  if (hasOffsets(idx)) {
+    h->vw = mempool_get(idx->vvwPool);
+    VVW_Reset(h->vw);
+  } else {
+    h->vw = NULL;
+  }
+  return h;
+}
+
 /**
  * Token processing function for forward index construction.
  *
@@ -87,6 +87,12 @@ ForwardIndexEntry *ForwardIndexIterator_Next(ForwardIndexIterator *iter);
 // Find an existing entry within the index
 ForwardIndexEntry *ForwardIndex_Find(ForwardIndex *i, const char *s, size_t n, uint32_t hash);
 
+/* Add an entry of the term with its frequency and fields, as tokenizing the document would have.
+ * Its offsets, if the index stores them, are written to its `vw` by the caller, and the totals of
+ * the index are left to it. Returns NULL if the term has an entry already */
+ForwardIndexEntry *ForwardIndex_Put(ForwardIndex *idx, const char *term, size_t len, uint32_t freq,
+                                     t_fieldMask fieldMask);
+
 /* Write a ForwardIndexEntry into an indexWriter. Returns the number of bytes written to the index
  */
 size_t InvertedIndex_WriteForwardIndexEntry(InvertedIndex *idx, ForwardIndexEntry *ent);
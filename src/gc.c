@@ -12,16 +12,21 @@
 
 #include "gc.h"
 #include "fork_gc.h"
+#include "incremental_gc.h"
 #include "config.h"
 #include "redismodule.h"
 #include "rmalloc.h"
 #include "module.h"
 #include "spec.h"
+#include "search_ctx.h"
 #include "thpool/thpool.h"
 #include "rmutil/rm_assert.h"
 #include "util/logging.h"
 
 static redisearch_thpool_t *gcThreadpool_g = NULL;
+// Created on the first use of the apply threads, and resized to the config by the next ones
+static redisearch_thpool_t *gcApplyThreadpool_g = NULL;
+static size_t gcApplyThreads_g = 0;
 
 typedef struct GCDebugTask {
   GCContext* gc;
@@ -41,6 +46,9 @@ GCContext* GCContext_CreateGC(StrongRef spec_ref, uint32_t gcPolicy) {
     case GCPolicy_Fork:
       ret->gcCtx = FGC_New(spec_ref, &ret->callbacks);
       break;
+    case GCPolicy_Incremental:
+      ret->gcCtx = IGC_New(spec_ref, &ret->callbacks);
+      break;
   }
   return ret;
 }
@@ -51,8 +59,11 @@ static long long getNextPeriod(GCContext* gc) {
   struct timespec interval = gc->callbacks.getInterval(gc->gcCtx);
   long long ms = interval.tv_sec * 1000 + interval.tv_nsec / 1000000;  // convert to millisecond
 
-  // add randomness to avoid congestion by multiple GCs from different shards
-  ms += (rand() % interval.tv_sec) * 1000;
+  // add randomness to avoid congestion by multiple GCs from different shards. The sub-second
+  // intervals between the ticks of an incremental collection are kept as they are
+  if (interval.tv_sec) {
+    ms += (rand() % interval.tv_sec) * 1000;
+  }
 
   return ms;
 }
@@ -66,6 +77,7 @@ static RedisModuleTimerID scheduleNext(GCContext *gc) {
 
 static void taskCallback(void* data) {
   GCContext* gc = data;
+  RedisSearchCtx_MarkGCThread();
 
   int ret = gc->callbacks.periodicCallback(gc->gcCtx);
 
@@ -92,8 +104,10 @@ static void debugTaskCallback(void* data) {
   GCDebugTask *task = data;
   GCContext* gc = task->gc;
   RedisModuleBlockedClient* bc = task->bClient;
+  RedisSearchCtx_MarkGCThread();
 
-  int ret = gc->callbacks.periodicCallback(gc->gcCtx);
+  int ret = gc->callbacks.forceCallback ? gc->callbacks.forceCallback(gc->gcCtx)
+                                        : gc->callbacks.periodicCallback(gc->gcCtx);
 
   // if GC was invoke by debug command, we release the client
   // and terminate without rescheduling the task again.
@@ -144,9 +158,9 @@ void GCContext_RenderStatsForInfo(GCContext* gc, RedisModuleInfoCtx* ctx) {
 }
 #endif
 
-void GCContext_OnDelete(GCContext* gc) {
+void GCContext_OnDelete(GCContext* gc, t_docId docId) {
   if (gc->callbacks.onDelete) {
-    gc->callbacks.onDelete(gc->gcCtx);
+    gc->callbacks.onDelete(gc->gcCtx, docId);
   }
 }
 
@@ -186,4 +200,44 @@ void GC_ThreadPoolDestroy() {
     gcThreadpool_g = NULL;
     RedisModule_ThreadSafeContextLock(RSDummyContext);
   }
+  if (gcApplyThreadpool_g != NULL) {
+    redisearch_thpool_destroy(gcApplyThreadpool_g);
+    gcApplyThreadpool_g = NULL;
+    gcApplyThreads_g = 0;
+  }
+}
+
+void GC_RunApplyJobs(void (*fn)(void *), void *jobs, size_t jobSize, size_t n) {
+  size_t numThreads = RSGlobalConfig.gcConfigParams.forkGc.forkGcApplyThreads;
+  if (numThreads == 0 || n < 2) {
+    for (size_t i = 0; i < n; ++i) {
+      fn((char *)jobs + i * jobSize);
+    }
+    return;
+  }
+
+  if (gcApplyThreadpool_g == NULL) {
+    gcApplyThreadpool_g = redisearch_thpool_create(numThreads, DEFAULT_HIGH_PRIORITY_BIAS_THRESHOLD,
+                                                   LogCallback, "gc-apply");
+  } else if (numThreads > gcApplyThreads_g) {
+    redisearch_thpool_add_threads(gcApplyThreadpool_g, numThreads - gcApplyThreads_g);
+  } else if (numThreads < gcApplyThreads_g) {
+    redisearch_thpool_remove_threads(gcApplyThreadpool_g, gcApplyThreads_g - numThreads);
+  }
+  gcApplyThreads_g = numThreads;
+
+  redisearch_thpool_work_t *work = rm_malloc(n * sizeof(*work));
+  for (size_t i = 0; i < n; ++i) {
+    work[i] = (redisearch_thpool_work_t){.function_p = fn, .arg_p = (char *)jobs + i * jobSize};
+  }
+  int rc = redisearch_thpool_add_n_work(gcApplyThreadpool_g, work, n, THPOOL_PRIORITY_HIGH);
+  rm_free(work);
+  if (rc != 0) {
+    // The jobs could not be queued
+    for (size_t i = 0; i < n; ++i) {
+      fn((char *)jobs + i * jobSize);
+    }
+    return;
+  }
+  redisearch_thpool_wait(gcApplyThreadpool_g);
 }
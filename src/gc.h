@@ -11,6 +11,7 @@
 #define SRC_GC_H_
 
 #include "reply.h"
+#include "redisearch.h"
 
 #include "redismodule.h"
 #include "util/dllist.h"
@@ -25,9 +26,12 @@ extern "C" {
 
 typedef struct GCCallbacks {
   int  (*periodicCallback)(void* gcCtx);
+  // Run a whole collection when it is forced by a debug command. Optional, `periodicCallback` is
+  // used if it is not set
+  int  (*forceCallback)(void* gcCtx);
   void (*renderStats)(RedisModule_Reply* reply, void* gc);
   void (*renderStatsForInfo)(RedisModuleInfoCtx* ctx, void* gc);
-  void (*onDelete)(void* ctx);
+  void (*onDelete)(void* ctx, t_docId docId);
   void (*onTerm)(void* ctx);
   struct timespec (*getInterval)(void* ctx);
 } GCCallbacks;
@@ -48,7 +52,7 @@ void GCContext_RenderStats(GCContext* gc, RedisModule_Reply* ctx);
 #ifdef FTINFO_FOR_INFO_MODULES
 void GCContext_RenderStatsForInfo(GCContext* gc, RedisModuleInfoCtx* ctx);
 #endif
-void GCContext_OnDelete(GCContext* gc);
+void GCContext_OnDelete(GCContext* gc, t_docId docId);
 void GCContext_ForceInvoke(GCContext* gc, RedisModuleBlockedClient* bc);
 void GCContext_ForceBGInvoke(GCContext* gc);
 void GCContext_WaitForAllOperations(RedisModuleBlockedClient* bc);
@@ -56,6 +60,12 @@ void GCContext_WaitForAllOperations(RedisModuleBlockedClient* bc);
 void GC_ThreadPoolStart();
 void GC_ThreadPoolDestroy();
 
+/* Run `fn` on each of the `n` jobs of `jobSize` bytes of the `jobs` array, on the
+ * `_FORK_GC_APPLY_THREADS` apply threads, and wait for them to finish. They run on the calling
+ * thread if there are no apply threads. Only called from the gc thread, as the jobs may run while
+ * it holds the write lock of an index, which they must not take */
+void GC_RunApplyJobs(void (*fn)(void *), void *jobs, size_t jobSize, size_t n);
+
 #ifdef __cplusplus
 }
 #endif
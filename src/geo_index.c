@@ -14,6 +14,11 @@
 #include "query_node.h"
 #include "query_param.h"
 #include "iterators/union_iterator.h"
+#include "iterators/idlist_iterator.h"
+#include "config.h"
+#include "util/arr.h"
+
+#include <math.h>
 
 static double extractUnitFactor(GeoDistance unit);
 
@@ -84,7 +89,7 @@ int GeoFilter_LegacyParse(LegacyGeoFilter *gf, ArgsCursor *ac, bool *hasEmptyFil
 
 void GeoFilter_Free(GeoFilter *gf) {
   if (gf->numericFilters) {
-    for (int i = 0; i < GEO_RANGE_COUNT; ++i) {
+    for (int i = 0; i < GEO_COVER_MAX_RANGES; ++i) {
       if (gf->numericFilters[i])
         NumericFilter_Free(gf->numericFilters[i]);
     }
@@ -108,13 +113,35 @@ QueryIterator *NewGeoRangeIterator(const RedisSearchCtx *ctx, const GeoFilter *g
     return NULL;
   }
 
-  GeoHashRange ranges[GEO_RANGE_COUNT] = {{0}};
   double radius_meter = gf->radius * extractUnitFactor(gf->unitType);
+  // Room for the filters of either kind of ranges, see GeoFilter_Free
+  ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_COVER_MAX_RANGES, sizeof(*gf->numericFilters));
+  FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index = gf->fieldSpec->index}}, .predicate = FIELD_EXPIRATION_DEFAULT};
+
+  if (RSGlobalConfig.geoCellCovering) {
+    GeoCoverRange cover[GEO_COVER_MAX_RANGES];
+    size_t n = calcCovering(gf->lon, gf->lat, radius_meter, cover);
+    QueryIterator **iters = rm_calloc(n ? n : 1, sizeof(*iters));
+    for (size_t ii = 0; ii < n; ++ii) {
+      NumericFilter *filt;
+      if (cover[ii].inner) {
+        // All the documents of the cells are in the circle, only their score is checked
+        filt = NewNumericFilter(cover[ii].range.min, cover[ii].range.max, 1, 0, true, NULL);
+      } else {
+        filt = NewNumericFilter(cover[ii].range.min, cover[ii].range.max, 1, 1, true, NULL);
+        filt->geoFilter = gf;
+      }
+      filt->fieldSpec = gf->fieldSpec;
+      gf->numericFilters[ii] = filt;
+      iters[ii] = NewNumericFilterIterator(ctx, filt, INDEXFLD_T_GEO, config, &filterCtx);
+    }
+    return NewUnionIterator(iters, n, true, 1, QN_GEO, NULL, config);
+  }
+
+  GeoHashRange ranges[GEO_RANGE_COUNT] = {{0}};
   calcRanges(gf->lon, gf->lat, radius_meter, ranges);
 
   QueryIterator **iters = rm_calloc(GEO_RANGE_COUNT, sizeof(*iters));
-  ((GeoFilter *)gf)->numericFilters = rm_calloc(GEO_RANGE_COUNT, sizeof(*gf->numericFilters));
-  FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index = gf->fieldSpec->index}}, .predicate = FIELD_EXPIRATION_DEFAULT};
   for (size_t ii = 0; ii < GEO_RANGE_COUNT; ++ii) {
     if (ranges[ii].min != ranges[ii].max) {
       NumericFilter *filt = gf->numericFilters[ii] =
@@ -128,6 +155,74 @@ QueryIterator *NewGeoRangeIterator(const RedisSearchCtx *ctx, const GeoFilter *g
   return NewUnionIterator(iters, GEO_RANGE_COUNT, true, 1, QN_GEO, NULL, config);
 }
 
+/* Read the documents of the filter within `radius` meters of its center, into `ids`. Returns the
+ * number of them, and sets `closer` to the number of those closer than the radius by more than
+ * GEO_NEAREST_MARGIN_METERS. Returns -1 if the read did not complete */
+static ssize_t readGeoRing(const RedisSearchCtx *ctx, const GeoFilter *gf, double radius,
+                           IteratorsConfig *config, t_docId **ids, size_t *closer) {
+  GeoFilter *ring = rm_malloc(sizeof(*ring));
+  *ring = *gf;
+  ring->radius = radius / extractUnitFactor(gf->unitType);
+  ring->numericFilters = NULL;
+  QueryIterator *it = NewGeoRangeIterator(ctx, ring, config);
+
+  ssize_t n = 0;
+  *closer = 0;
+  IteratorStatus rc;
+  while ((rc = it->Read(it)) == ITERATOR_OK) {
+    const RSIndexResult *res = it->current;
+    if (IndexResult_IsAggregate(res)) {
+      res = AggregateResult_Get(IndexResult_AggregateRef(res), 0);
+    }
+    // The numeric results of a geo filter hold their distance from its center
+    if (IndexResult_NumValue(res) <= radius - GEO_NEAREST_MARGIN_METERS) {
+      ++*closer;
+    }
+    array_append(*ids, it->lastDocId);
+    ++n;
+  }
+  it->Free(it);
+  GeoFilter_Free(ring);
+  return rc == ITERATOR_EOF ? n : -1;
+}
+
+QueryIterator *NewGeoNearestIterator(const RedisSearchCtx *ctx, const GeoFilter *gf, size_t nearest,
+                                     IteratorsConfig *config) {
+  QueryIterator *all = NewGeoRangeIterator(ctx, gf, config);
+  if (!all) {
+    return NULL;
+  }
+  // The estimate counts the documents of the geohash ranges, which cover more than the circle
+  size_t estimated = all->NumEstimated(all);
+  if (estimated <= GEO_NEAREST_MIN_RATIO * nearest) {
+    return all;
+  }
+
+  // Start from the radius of the circle that holds `nearest` documents, if they are spread evenly
+  const double full = gf->radius * extractUnitFactor(gf->unitType);
+  double radius = full * sqrt((double)GEO_NEAREST_MIN_RATIO * nearest / estimated) +
+                  GEO_NEAREST_MARGIN_METERS;
+  t_docId *ids = array_new(t_docId, nearest);
+  for (; radius < full; radius *= 2) {
+    array_clear(ids);
+    size_t closer;
+    ssize_t n = readGeoRing(ctx, gf, radius, config, &ids, &closer);
+    if (n < 0) {
+      break;
+    }
+    if (closer >= nearest) {
+      // Every document outside of the ring is farther than the `nearest` closest ones
+      all->Free(all);
+      t_docId *docIds = rm_malloc(n * sizeof(*docIds));
+      memcpy(docIds, ids, n * sizeof(*docIds));
+      array_free(ids);
+      return NewIdListIterator(docIds, n, 1);
+    }
+  }
+  array_free(ids);
+  return all;
+}
+
 GeoDistance GeoDistance_Parse(const char *s) {
 #define X(c, val)            \
   if (!strcasecmp(val, s)) { \
@@ -81,6 +81,19 @@ void GeoFilter_Free(GeoFilter *gf);
 void LegacyGeoFilter_Free(LegacyGeoFilter *gf);
 QueryIterator *NewGeoRangeIterator(const RedisSearchCtx *ctx, const GeoFilter *gf, IteratorsConfig *config);
 
+/* The margin between the distance of the `nearest` documents and the radius of the ring they are
+ * read from, wider than the precision of their geohash and of the rounding of `geodistance()` */
+#define GEO_NEAREST_MARGIN_METERS 1
+// The first ring is expected to hold this many times more documents than the nearest ones
+#define GEO_NEAREST_MIN_RATIO 2
+
+/* An iterator on the documents of the filter that has at least the `nearest` ones closest to its
+ * center, for the queries that only return those. It reads the documents of rings growing from
+ * the center, until one holds `nearest` of them, so that it doesn't read all the documents of a
+ * large radius. The order of the results stays the one of their ids */
+QueryIterator *NewGeoNearestIterator(const RedisSearchCtx *ctx, const GeoFilter *gf, size_t nearest,
+                                     IteratorsConfig *config);
+
 /*****************************************************************************/
 
 #define INVALID_GEOHASH -1.0
@@ -66,6 +66,9 @@ namespace {
         return nullptr;                                                                     \
     }                                                                                       \
   }                                                                                         \
+  bool Index_##variant##_Repack(GeometryIndex *idx, bool force) {                           \
+    return std::get<rtree_ptr<variant>>(idx->index)->repack(force);                         \
+  }                                                                                         \
   void Index_##variant##_Dump(const GeometryIndex *idx, RedisModuleCtx *ctx) {              \
     std::get<rtree_ptr<variant>>(idx->index)->dump(ctx);                                    \
   }                                                                                         \
@@ -77,6 +80,7 @@ namespace {
       .addGeomStr = Index_##variant##_Insert,                                               \
       .delGeom = Index_##variant##_Remove,                                                  \
       .query = Index_##variant##_Query,                                                     \
+      .repack = Index_##variant##_Repack,                                                   \
       .dump = Index_##variant##_Dump,                                                       \
       .report = Index_##variant##_Report,                                                   \
   };                                                                                        \
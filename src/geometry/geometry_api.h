@@ -29,6 +29,9 @@ struct GeometryApi {
   QueryIterator *(*query)(const RedisSearchCtx *sctx, const FieldFilterContext*,
                           const GeometryIndex *index, QueryType queryType, GEOMETRY_FORMAT format,
                           const char *str, size_t len, RedisModuleString **err_msg);
+  // Pack the R-tree again if enough of it changed since it was last packed, or if any did with
+  // `force`. Returns whether it was repacked
+  bool (*repack)(GeometryIndex *index, bool force);
   void (*dump)(const GeometryIndex *index, RedisModuleCtx *ctx);
   size_t (*report)(const GeometryIndex *index);
 };
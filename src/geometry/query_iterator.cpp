@@ -122,6 +122,7 @@ QueryIterator CPPQueryIterator::init_base() {
       .Revalidate = Default_Revalidate,
       .Free = QIter_Free,
       .Rewind = QIter_Rewind,
+      .ReadBatch = Default_ReadBatch,
   };
 }
 }  // namespace GeoShape
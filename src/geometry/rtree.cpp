@@ -14,6 +14,7 @@
 #include <exception>  // std::exception
 #include <execution>  // std::unseq
 #include <numeric>    // std::transform_reduce
+#include <type_traits>  // std::is_same_v
 
 namespace RediSearch {
 namespace GeoShape {
@@ -156,13 +157,36 @@ constexpr auto within_filter = overload{
 template <typename cs>
 constexpr auto intersects_filter =
     [](auto const& geom1, auto const& geom2) -> bool { return bg::intersects(geom1, geom2); };
+
+// Polygons with more points than this are first tested by their bounding box
+constexpr std::size_t MBR_SHORTCUT_MIN_POINTS = 16;
+
+// A geometry is within the query polygon if its bounding box is, which tests a polygon of 5 points
+// instead of all of its own. Only cartesian boxes are polygons: the sides of geographic ones
+// follow the parallels, where the edges of polygons are geodesics.
+template <typename cs>
+auto mbr_within(rect_type<cs> const& mbr, geom_type<cs> const& geom, geom_type<cs> const& query_geom) -> bool {
+  if constexpr (!std::is_same_v<cs, Cartesian>) {
+    return false;
+  } else {
+    const auto poly = std::get_if<poly_type<cs>>(&geom);
+    const auto query_poly = std::get_if<poly_type<cs>>(&query_geom);
+    if (!poly || !query_poly || bg::num_points(*poly) <= MBR_SHORTCUT_MIN_POINTS) {
+      return false;
+    }
+    auto mbr_poly = poly_type<cs>{};
+    bg::convert(mbr, mbr_poly);
+    return bg::within(mbr_poly, *query_poly);
+  }
+}
 }  // anonymous namespace
 
 template <typename cs>
 RTree<cs>::RTree()
     : allocated_{sizeof *this},
       rtree_{{}, {}, {}, doc_alloc{allocated_}},
-      docLookup_{0, lookup_alloc{allocated_}} {
+      docLookup_{0, lookup_alloc{allocated_}},
+      changes_{0} {
 }
 
 template <typename cs>
@@ -182,6 +206,7 @@ void RTree<cs>::insert(geom_type const& geom, t_docId id) {
   docLookup_.insert(lookup_type{id, geom});
   rtree_.insert(make_doc<cs>(geom, id));
   allocated_ += std::visit(geometry_reporter<cs>, geom);
+  ++changes_;
 }
 
 template <typename cs>
@@ -204,14 +229,30 @@ bool RTree<cs>::remove(t_docId id) {
         allocated_ -= std::visit(geometry_reporter<cs>, geom);
         rtree_.remove(make_doc<cs>(geom, id));
         docLookup_.erase(id);
+        ++changes_;
         return true;
       })
       .value_or(false);
 }
 
+template <typename cs>
+bool RTree<cs>::repack(bool force) {
+  if (!changes_ || (!force && (changes_ < REPACK_MIN_CHANGES ||
+                               changes_ * REPACK_CHANGES_RATIO < rtree_.size()))) {
+    return false;
+  }
+  // The packing constructor sorts the entries along each axis in turn and tiles them into full
+  // nodes (as Sort-Tile-Recursive does), where the insertions one by one leave the nodes of a
+  // large tree overlapping. The new tree is tracked by the same allocator as the old one.
+  auto packed = rtree_type{rtree_.begin(), rtree_.end(), {}, {}, {}, doc_alloc{allocated_}};
+  rtree_.swap(packed);
+  changes_ = 0;
+  return true;
+}
+
 template <typename cs>
 void RTree<cs>::dump(RedisModuleCtx* ctx) const {
-  RedisModule_ReplyWithArray(ctx, 8);
+  RedisModule_ReplyWithArray(ctx, 10);
 
   RedisModule_ReplyWithStringBuffer(ctx, "type", std::strlen("type"));
   RedisModule_ReplyWithStringBuffer(ctx, "boost_rtree", std::strlen("boost_rtree"));
@@ -224,6 +265,9 @@ void RTree<cs>::dump(RedisModuleCtx* ctx) const {
   const auto len = static_cast<long long>(rtree_.size());
   RedisModule_ReplyWithLongLong(ctx, len);
 
+  RedisModule_ReplyWithStringBuffer(ctx, "unpacked_changes", std::strlen("unpacked_changes"));
+  RedisModule_ReplyWithLongLong(ctx, static_cast<long long>(changes_));
+
   RedisModule_ReplyWithStringBuffer(ctx, "docs", std::strlen("docs"));
   RedisModule_ReplyWithArray(ctx, len);
 
@@ -257,7 +301,9 @@ template <typename Predicate, typename Filter>
 auto RTree<cs>::apply_intersection_of_predicates(Predicate predicate, Filter filter) const -> query_results {
   return rtree_.qbegin(predicate &&
                        bgi::satisfies([this, f = std::move(filter)](doc_type const& doc) -> bool {
-                         return lookup(doc).map(f).value_or(false);
+                         return lookup(doc)
+                             .map([&](geom_type const& geom) { return f(get_rect<cs>(doc), geom); })
+                             .value_or(false);
                        }));
 }
 template <typename cs>
@@ -274,12 +320,12 @@ auto RTree<cs>::query_begin(QueryType query_type, geom_type const& query_geom) c
   auto const query_mbr = get_rect<cs>(make_doc<cs>(query_geom));
   switch (query_type) {
     case QueryType::CONTAINS:  // contains(g1, g2) == within(g2, g1)
-      return apply_intersection_of_predicates(bgi::contains(query_mbr), [query_geom](auto const& geom) -> bool {
+      return apply_intersection_of_predicates(bgi::contains(query_mbr), [query_geom](auto const&, auto const& geom) -> bool {
         return std::visit(within_filter<cs>, query_geom, geom);
       });
     case QueryType::WITHIN:
-      return apply_intersection_of_predicates(bgi::within(query_mbr), [query_geom](auto const& geom) -> bool {
-        return std::visit(within_filter<cs>, geom, query_geom);
+      return apply_intersection_of_predicates(bgi::within(query_mbr), [query_geom](auto const& mbr, auto const& geom) -> bool {
+        return mbr_within<cs>(mbr, geom, query_geom) || std::visit(within_filter<cs>, geom, query_geom);
       });
     case QueryType::DISJOINT:  // disjoint(g1, g2) == !intersects(g1, g2)
       return apply_union_of_predicates([query_mbr](auto const& mbr) -> bool {
@@ -288,8 +334,8 @@ auto RTree<cs>::query_begin(QueryType query_type, geom_type const& query_geom) c
         return std::visit(std::not_fn(intersects_filter<cs>), geom, query_geom);
       });
     case QueryType::INTERSECTS:
-      return apply_intersection_of_predicates(bgi::intersects(query_mbr), [query_geom](auto const& geom) -> bool {
-        return std::visit(intersects_filter<cs>, geom, query_geom);
+      return apply_intersection_of_predicates(bgi::intersects(query_mbr), [query_geom](auto const& mbr, auto const& geom) -> bool {
+        return mbr_within<cs>(mbr, geom, query_geom) || std::visit(intersects_filter<cs>, geom, query_geom);
       });
     default:
       throw std::runtime_error{"unknown query"};
@@ -56,10 +56,15 @@ class RTree {
 
   using query_results = rtree_type::const_query_iterator;
 
+  // The tree is repacked by the GC once this many and a quarter of its entries changed
+  static constexpr std::size_t REPACK_MIN_CHANGES = 1024;
+  static constexpr std::size_t REPACK_CHANGES_RATIO = 4;
+
  private:
   mutable std::size_t allocated_;
   rtree_type rtree_;
   LUT_type docLookup_;
+  std::size_t changes_;  // Insertions and removals since the tree was last packed
 
  public:
   explicit RTree();
@@ -69,6 +74,10 @@ class RTree {
   [[nodiscard]] auto query(const RedisSearchCtx *sctx, const FieldFilterContext* filterCtx, std::string_view wkt, QueryType query_type,
                            RedisModuleString** err_msg) const -> QueryIterator*;
 
+  // Rebuild the tree from its entries with the packing algorithm, if enough of them changed since
+  // it was last packed, or if any did with `force`. Returns whether the tree was rebuilt
+  bool repack(bool force);
+
   void dump(RedisModuleCtx* ctx) const;
   [[nodiscard]] std::size_t report() const noexcept;
 
@@ -66,3 +66,15 @@ void GeometryIndex_RemoveId(IndexSpec *spec, t_docId id) {
     }
   }
 }
+
+void GeometryIndex_Repack(IndexSpec *spec, bool force) {
+  for (int i = 0; i < spec->numFields; ++i) {
+    const FieldSpec *fs = spec->fields + i;
+    if (FIELD_IS(fs, INDEXFLD_T_GEOMETRY)) {
+      GeometryIndex *idx = OpenGeometryIndex(spec, fs, DONT_CREATE_INDEX);
+      if (idx) {
+        GeometryApi_Get(idx)->repack(idx, force);
+      }
+    }
+  }
+}
@@ -27,3 +27,7 @@ RedisModuleString *fmtRedisGeometryIndexKey(const RedisSearchCtx *ctx, const Hid
 
 // Remove indexed data for the given document ID
 void GeometryIndex_RemoveId(IndexSpec *spec, t_docId id);
+
+// Pack again the R-trees of the geometry fields which changed enough since they were last packed,
+// or all those which changed with `force`. Called with the spec write lock
+void GeometryIndex_Repack(IndexSpec *spec, bool force);
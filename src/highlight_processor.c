@@ -11,6 +11,8 @@
 #include "value.h"
 #include "util/minmax.h"
 #include "toksep.h"
+#include "config.h"
+#include "snippet_cache.h"
 #include <ctype.h>
 
 typedef struct {
@@ -18,6 +20,7 @@ typedef struct {
   int fragmentizeOptions;
   const FieldList *fields;
   const RLookup *lookup;
+  SnippetCache *snippets;  // NULL unless enabled
 } HlpProcessor;
 
 /**
@@ -37,6 +40,9 @@ typedef struct {
 
   RLookupRow *row;
 
+  // The key of the document and its matched terms in the snippet cache, if it is used
+  sds snippetKey;
+
 } hlpDocContext;
 
 /**
@@ -259,6 +265,59 @@ static void resetIovsArr(Array **iovsArrp, size_t *curSize, size_t newSize) {
   *curSize = newSize;
 }
 
+static sds appendKeyString(sds key, const char *s) {
+  size_t len = s ? strlen(s) : SIZE_MAX;
+  key = sdscatlen(key, &len, sizeof(len));
+  return s ? sdscatlen(key, s, len) : key;
+}
+
+// Append the terms matched by the result, and what the fragmenter ranks and highlights them by
+static sds appendMatchedTerms(sds key, const RSIndexResult *r) {
+  switch (r->data.tag) {
+    case RSResultData_Intersection:
+    case RSResultData_Union:
+    {
+      AggregateRecordsSlice children = AggregateResult_GetRecordsSlice(IndexResult_AggregateRefUnchecked(r));
+      for (size_t i = 0; i < children.len; i++) {
+        key = appendMatchedTerms(key, children.ptr[i]);
+      }
+      break;
+    }
+    case RSResultData_Term:
+    {
+      const RSQueryTerm *term = IndexResult_QueryTermRef(r);
+      if (term) {
+        key = sdscatlen(key, &term->id, sizeof(term->id));
+        key = sdscatlen(key, &term->idf, sizeof(term->idf));
+        key = sdscatlen(key, &term->len, sizeof(term->len));
+        if (term->str) {
+          key = sdscatlen(key, term->str, term->len);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return key;
+}
+
+// The key of the field of the document in the snippet cache: the document and its matched terms,
+// followed by the field and how it is summarized
+static sds snippetKey(const HlpProcessor *hlp, const hlpDocContext *docParams,
+                      const ReturnedField *spec, size_t fieldLen) {
+  sds key = sdsdup(docParams->snippetKey);
+  key = appendKeyString(key, spec->name);
+  key = sdscatlen(key, &fieldLen, sizeof(fieldLen));
+  key = sdscatlen(key, &spec->mode, sizeof(spec->mode));
+  key = sdscatlen(key, &hlp->fragmentizeOptions, sizeof(hlp->fragmentizeOptions));
+  key = sdscatlen(key, &spec->summarizeSettings.contextLen, sizeof(spec->summarizeSettings.contextLen));
+  key = sdscatlen(key, &spec->summarizeSettings.numFrags, sizeof(spec->summarizeSettings.numFrags));
+  key = appendKeyString(key, spec->summarizeSettings.separator);
+  key = appendKeyString(key, spec->highlightSettings.openTag);
+  return appendKeyString(key, spec->highlightSettings.closeTag);
+}
+
 static void processField(HlpProcessor *hlpCtx, hlpDocContext *docParams, ReturnedField *spec) {
   const char *fName = spec->name;
   const RSValue *fieldValue = RLookup_GetItem(spec->lookupKey, docParams->row);
@@ -266,8 +325,25 @@ static void processField(HlpProcessor *hlpCtx, hlpDocContext *docParams, Returne
   if (fieldValue == NULL || !RSValue_IsAnyString(fieldValue)) {
     return;
   }
-  RSValue *v = summarizeField(hlpCtx->lookup, spec, fName, fieldValue, docParams,
-                              hlpCtx->fragmentizeOptions);
+  sds key = NULL;
+  RSValue *v = NULL;
+  if (docParams->snippetKey) {
+    size_t fieldLen;
+    RSValue_StringPtrLen(fieldValue, &fieldLen);
+    key = snippetKey(hlpCtx, docParams, spec, fieldLen);
+    if (SnippetCache_Get(hlpCtx->snippets, key, &v)) {
+      sdsfree(key);
+      key = NULL;
+      goto write;
+    }
+  }
+  v = summarizeField(hlpCtx->lookup, spec, fName, fieldValue, docParams,
+                     hlpCtx->fragmentizeOptions);
+  if (key) {
+    SnippetCache_Put(hlpCtx->snippets, key, v);
+  }
+
+write:
   if (v) {
     RLookup_WriteOwnKey(spec->lookupKey, docParams->row, v);
   }
@@ -322,6 +398,10 @@ static int hlpNext(ResultProcessor *rbase, SearchResult *r) {
                              .iovsArr = NULL,
                              .indexResult = ir,
                              .row = SearchResult_GetRowDataMut(r)};
+  if (hlp->snippets && RSGlobalConfig.snippetCacheBytes) {
+    t_docId docId = SearchResult_GetDocId(r);
+    docParams.snippetKey = appendMatchedTerms(sdscatlen(sdsempty(), &docId, sizeof(docId)), ir);
+  }
 
   if (fields->numFields) {
     for (size_t ii = 0; ii < fields->numFields; ++ii) {
@@ -352,6 +432,7 @@ static int hlpNext(ResultProcessor *rbase, SearchResult *r) {
     Array_Free(&docParams.iovsArr[ii]);
   }
   rm_free(docParams.iovsArr);
+  sdsfree(docParams.snippetKey);
   return RS_RESULT_OK;
 }
 
@@ -360,7 +441,7 @@ static void hlpFree(ResultProcessor *p) {
 }
 
 ResultProcessor *RPHighlighter_New(RSLanguage language, const FieldList *fields,
-                                   const RLookup *lookup) {
+                                   const RLookup *lookup, struct SnippetCache *snippets) {
   HlpProcessor *hlp = rm_calloc(1, sizeof(*hlp));
   if (language == RS_LANG_CHINESE) {
     hlp->fragmentizeOptions = FRAGMENTIZE_TOKLEN_EXACT;
@@ -369,6 +450,7 @@ ResultProcessor *RPHighlighter_New(RSLanguage language, const FieldList *fields,
   hlp->base.Free = hlpFree;
   hlp->fields = fields;
   hlp->lookup = lookup;
+  hlp->snippets = snippets;
   hlp->base.type = RP_HIGHLIGHTER;
   return &hlp->base;
 }
@@ -9,16 +9,182 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <stdbool.h>
 
 #include <stdio.h>
 
 #include "util/fnv.h"
+#include "util/cpu_dispatch.h"
 #include "hll.h"
 
 #include "rmalloc.h"
 
 #define INVALID_CACHE_CARDINALITY SIZE_MAX
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HLL_KERNELS_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define HLL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+// The highest rank the estimator tells apart. The ranks `hll_add` sets are at most 29, higher
+// registers may only come from corrupt input
+#define HLL_MAX_RANK 63
+
+#define INV_POW2(r) (1.0 / (double)(1ULL << (r)))
+#define INV_POW2_8(r)                                                                            \
+  INV_POW2(r), INV_POW2(r + 1), INV_POW2(r + 2), INV_POW2(r + 3), INV_POW2(r + 4),               \
+      INV_POW2(r + 5), INV_POW2(r + 6), INV_POW2(r + 7)
+
+// 2^-r for every rank r
+static const double inversePowers[HLL_MAX_RANK + 1] = {
+  INV_POW2_8(0), INV_POW2_8(8), INV_POW2_8(16), INV_POW2_8(24),
+  INV_POW2_8(32), INV_POW2_8(40), INV_POW2_8(48), INV_POW2_8(56),
+};
+
+/* The kernels below return the sum of 2^-r over the registers, and count the zero registers in
+ * `zeros`. The terms are powers of two of at least 2^-29 and there are at most 2^20 of them, so
+ * their sum is exact in any order, and every implementation gives the same estimate. */
+
+static double hllSumScalar(const uint8_t *regs, uint32_t n, uint32_t *zeros) {
+  double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  uint32_t z = 0, i = 0;
+  for (; i + 4 <= n; i += 4) {
+    z += (regs[i] == 0) + (regs[i + 1] == 0) + (regs[i + 2] == 0) + (regs[i + 3] == 0);
+    s0 += inversePowers[regs[i] < HLL_MAX_RANK ? regs[i] : HLL_MAX_RANK];
+    s1 += inversePowers[regs[i + 1] < HLL_MAX_RANK ? regs[i + 1] : HLL_MAX_RANK];
+    s2 += inversePowers[regs[i + 2] < HLL_MAX_RANK ? regs[i + 2] : HLL_MAX_RANK];
+    s3 += inversePowers[regs[i + 3] < HLL_MAX_RANK ? regs[i + 3] : HLL_MAX_RANK];
+  }
+  for (; i < n; i++) {
+    z += regs[i] == 0;
+    s0 += inversePowers[regs[i] < HLL_MAX_RANK ? regs[i] : HLL_MAX_RANK];
+  }
+  *zeros += z;
+  return (s0 + s1) + (s2 + s3);
+}
+
+// Set every register of `dst` to the maximum of it and that of `src`, and return whether any
+// changed. Branch free, so that compilers vectorize it for the baseline of the architecture
+static bool hllMergeScalar(uint8_t *dst, const uint8_t *src, uint32_t n) {
+  uint8_t changed = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    uint8_t m = dst[i] < src[i] ? src[i] : dst[i];
+    changed |= m ^ dst[i];
+    dst[i] = m;
+  }
+  return changed;
+}
+
+#ifdef HLL_KERNELS_AVX2
+// 2^-r of the 4 ranks in the low bytes of `r`, by writing 1023 - r to the exponent of a double
+__attribute__((target("avx2")))
+static inline __m256d inversePowersAVX2(__m128i r) {
+  __m256i e = _mm256_sub_epi64(_mm256_set1_epi64x(1023), _mm256_cvtepu8_epi64(r));
+  return _mm256_castsi256_pd(_mm256_slli_epi64(e, 52));
+}
+
+__attribute__((target("avx2")))
+static double hllSumAVX2(const uint8_t *regs, uint32_t n, uint32_t *zeros) {
+  const __m128i maxRank = _mm_set1_epi8(HLL_MAX_RANK);
+  __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+  __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+  uint32_t z = 0, i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i r = _mm_min_epu8(_mm_loadu_si128((const __m128i *)(regs + i)), maxRank);
+    z += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(r, _mm_setzero_si128())));
+    s0 = _mm256_add_pd(s0, inversePowersAVX2(r));
+    s1 = _mm256_add_pd(s1, inversePowersAVX2(_mm_srli_si128(r, 4)));
+    s2 = _mm256_add_pd(s2, inversePowersAVX2(_mm_srli_si128(r, 8)));
+    s3 = _mm256_add_pd(s3, inversePowersAVX2(_mm_srli_si128(r, 12)));
+  }
+  __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+  __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+  *zeros += z;
+  return _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h))) + hllSumScalar(regs + i, n - i, zeros);
+}
+
+__attribute__((target("avx2")))
+static bool hllMergeAVX2(uint8_t *dst, const uint8_t *src, uint32_t n) {
+  __m256i changed = _mm256_setzero_si256();
+  uint32_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+    __m256i m = _mm256_max_epu8(d, _mm256_loadu_si256((const __m256i *)(src + i)));
+    changed = _mm256_or_si256(changed, _mm256_xor_si256(m, d));
+    _mm256_storeu_si256((__m256i *)(dst + i), m);
+  }
+  bool tailChanged = hllMergeScalar(dst + i, src + i, n - i);
+  return !_mm256_testz_si256(changed, changed) || tailChanged;
+}
+#endif
+
+#ifdef HLL_KERNELS_NEON
+// 2^-r of the 2 ranks of `r`, by writing 1023 - r to the exponent of a double
+static inline float64x2_t inversePowersNEON(uint32x2_t r) {
+  uint64x2_t e = vsubq_u64(vdupq_n_u64(1023), vmovl_u32(r));
+  return vreinterpretq_f64_u64(vshlq_n_u64(e, 52));
+}
+
+static double hllSumNEON(const uint8_t *regs, uint32_t n, uint32_t *zeros) {
+  const uint8x16_t maxRank = vdupq_n_u8(HLL_MAX_RANK);
+  float64x2_t s0 = vdupq_n_f64(0), s1 = vdupq_n_f64(0), s2 = vdupq_n_f64(0), s3 = vdupq_n_f64(0);
+  uint32_t z = 0, i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t r = vminq_u8(vld1q_u8(regs + i), maxRank);
+    z += vaddvq_u8(vandq_u8(vceqzq_u8(r), vdupq_n_u8(1)));
+    uint16x8_t lo = vmovl_u8(vget_low_u8(r)), hi = vmovl_u8(vget_high_u8(r));
+    uint32x4_t r0 = vmovl_u16(vget_low_u16(lo)), r1 = vmovl_u16(vget_high_u16(lo));
+    uint32x4_t r2 = vmovl_u16(vget_low_u16(hi)), r3 = vmovl_u16(vget_high_u16(hi));
+    s0 = vaddq_f64(vaddq_f64(s0, inversePowersNEON(vget_low_u32(r0))), inversePowersNEON(vget_high_u32(r0)));
+    s1 = vaddq_f64(vaddq_f64(s1, inversePowersNEON(vget_low_u32(r1))), inversePowersNEON(vget_high_u32(r1)));
+    s2 = vaddq_f64(vaddq_f64(s2, inversePowersNEON(vget_low_u32(r2))), inversePowersNEON(vget_high_u32(r2)));
+    s3 = vaddq_f64(vaddq_f64(s3, inversePowersNEON(vget_low_u32(r3))), inversePowersNEON(vget_high_u32(r3)));
+  }
+  *zeros += z;
+  return vaddvq_f64(vaddq_f64(vaddq_f64(s0, s1), vaddq_f64(s2, s3))) +
+         hllSumScalar(regs + i, n - i, zeros);
+}
+
+static bool hllMergeNEON(uint8_t *dst, const uint8_t *src, uint32_t n) {
+  uint8x16_t changed = vdupq_n_u8(0);
+  uint32_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t d = vld1q_u8(dst + i);
+    uint8x16_t m = vmaxq_u8(d, vld1q_u8(src + i));
+    changed = vorrq_u8(changed, veorq_u8(m, d));
+    vst1q_u8(dst + i, m);
+  }
+  bool tailChanged = hllMergeScalar(dst + i, src + i, n - i);
+  return vmaxvq_u8(changed) || tailChanged;
+}
+#endif
+
+// Selected by `hll_select_kernels`
+static double (*hllSumImpl)(const uint8_t *, uint32_t, uint32_t *) = hllSumScalar;
+static bool (*hllMergeImpl)(uint8_t *, const uint8_t *, uint32_t) = hllMergeScalar;
+
+const char *hll_select_kernels(uint32_t features) {
+#if defined(HLL_KERNELS_AVX2)
+  if (features & CPU_FEATURE_AVX2) {
+    hllSumImpl = hllSumAVX2;
+    hllMergeImpl = hllMergeAVX2;
+    return "avx2";
+  }
+#elif defined(HLL_KERNELS_NEON)
+  if (features & CPU_FEATURE_NEON) {
+    hllSumImpl = hllSumNEON;
+    hllMergeImpl = hllMergeNEON;
+    return "neon";
+  }
+#endif
+  hllSumImpl = hllSumScalar;
+  hllMergeImpl = hllMergeScalar;
+  return "scalar";
+}
+
 static inline uint8_t _hll_rank(uint32_t hash, uint8_t max) {
   uint8_t rank = hash ? __builtin_ctz(hash) : 32; // index of first set bit
   return (rank > max ? max : rank) + 1;
@@ -89,20 +255,13 @@ size_t hll_count(const struct HLL *hll) {
 
   alpha_mm *= hll->size * hll->size;
 
-  double sum = 0;
-  for (uint32_t i = 0; i < hll->size; i++) {
-    sum += 1.0 / (1 << hll->registers[i]);
-  }
+  // The zero registers are counted in the same pass, for the small range correction
+  uint32_t zeros = 0;
+  double sum = hllSumImpl(hll->registers, hll->size, &zeros);
 
   double estimate = alpha_mm / sum;
 
   if (estimate <= 5.0 / 2.0 * hll->size) {
-    int zeros = 0;
-
-    for (uint32_t i = 0; i < hll->size; i++)
-      if (hll->registers[i] == 0)
-        zeros++;
-
     if (zeros)
       estimate = hll->size * log((double)hll->size / zeros);
 
@@ -119,12 +278,9 @@ int hll_merge(struct HLL *dst, const struct HLL *src) {
     return -1;
   }
 
-  for (uint32_t i = 0; i < src->size; i++) {
-    if (dst->registers[i] < src->registers[i]) {
-      dst->registers[i] = src->registers[i];
-      // New max rank, invalidate the cached cardinality
-      dst->cachedCard = INVALID_CACHE_CARDINALITY;
-    }
+  if (hllMergeImpl(dst->registers, src->registers, src->size)) {
+    // New max rank, invalidate the cached cardinality
+    dst->cachedCard = INVALID_CACHE_CARDINALITY;
   }
   return 0;
 }
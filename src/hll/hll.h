@@ -43,6 +43,9 @@ size_t hll_count(const struct HLL *hll);
 int hll_set_registers(struct HLL *hll, const void *registers, uint32_t size);
 /* Clear the HLL registers, reset the cardinality to 0 */
 void hll_clear(struct HLL *hll);
+/* Select the implementation of the merge and of the estimate for the CPU features (see
+   util/cpu_dispatch.h). Returns the name of the implementation */
+const char *hll_select_kernels(uint32_t features);
 
 #ifdef __cplusplus
 }
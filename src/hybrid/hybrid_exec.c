@@ -200,8 +200,7 @@ static int HREQ_populateReplyWithResults(RedisModule_Reply *reply,
     int len = array_len(results);
     array_foreach(results, res, {
       serializeResult_hybrid(hreq, reply, res, cv);
-      SearchResult_Destroy(res);
-      rm_free(res);
+      SearchResult_Free(res);
     });
     array_free(results);
     return len;
@@ -42,7 +42,7 @@ double HybridRRFScore(HybridScoringContext *scoringCtx, const double *ranks, con
     double score = 0.0;
     for (size_t i = 0; i < num_sources; ++i) {
         if (has_rank[i]) {
-            score += 1.0 / (scoringCtx->rrfCtx.constant + ranks[i]);
+            score += HybridScore_Contribution(scoringCtx, i, ranks[i]);
         }
     }
     return score;
@@ -74,7 +74,7 @@ double HybridLinearScore(HybridScoringContext *scoringCtx, const double *scores,
     double score = 0.0;
     for (size_t i = 0; i < num_sources; ++i) {
         if (has_score[i]) {
-            score += scoringCtx->linearCtx.linearWeights[i] * scores[i];
+            score += HybridScore_Contribution(scoringCtx, i, scores[i]);
         }
     }
     return score;
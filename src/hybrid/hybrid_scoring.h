@@ -50,6 +50,15 @@ typedef double (*HybridScoringFunction)(HybridScoringContext *scoringCtx, const
  /* Get scoring function based on scoring type */
 HybridScoringFunction GetScoringFunction(HybridScoringType scoringType);
 
+/* The term of the value (a rank for RRF, a score for Linear) of a source in the hybrid score, which
+ * sums the terms of the sources having the document */
+static inline double HybridScore_Contribution(const HybridScoringContext *scoringCtx, size_t source, double value) {
+  if (scoringCtx->scoringType == HYBRID_SCORING_RRF) {
+    return 1.0 / (scoringCtx->rrfCtx.constant + value);
+  }
+  return scoringCtx->linearCtx.linearWeights[source] * value;
+}
+
 double HybridRRFScore(HybridScoringContext *scoringCtx, const double *ranks, const bool *has_rank, const size_t num_sources);
 
 double HybridLinearScore(HybridScoringContext *scoringCtx, const double *scores, const bool *has_score, const size_t num_sources);
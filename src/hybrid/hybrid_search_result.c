@@ -18,18 +18,16 @@
 
 /**
  * Constructor for HybridSearchResult.
- * Allocates memory for storing SearchResults from numSources sources.
+ * Allocates memory for storing SearchResults from numSources sources, along with the structure, as
+ * the merger creates one for every document it reads.
  */
 HybridSearchResult* HybridSearchResult_New(size_t numSources) {
   RS_ASSERT(numSources > 0);
 
-  HybridSearchResult* result = rm_calloc(1, sizeof(HybridSearchResult));
-  result->searchResults = array_newlen(SearchResult*, numSources);
-  result->hasResults = array_newlen(bool, numSources);
-  for (size_t i = 0; i < numSources; ++i) {
-    result->searchResults[i] = NULL;
-    result->hasResults[i] = false;
-  }
+  HybridSearchResult* result = rm_calloc(1, sizeof(HybridSearchResult) +
+                                            numSources * (sizeof(SearchResult*) + sizeof(bool)));
+  result->searchResults = (SearchResult**)(result + 1);
+  result->hasResults = (bool*)(result->searchResults + numSources);
   result->numSources = numSources;
   return result;
 }
@@ -43,17 +41,9 @@ void HybridSearchResult_Free(HybridSearchResult* result) {
     return;
   }
 
-  // Free individual SearchResults with array_free_ex
-  array_free_ex(result->searchResults, {
-    SearchResult **sr = (SearchResult**)ptr;
-    if (*sr) {
-      SearchResult_Destroy(*sr);
-      rm_free(*sr);
-    }
-  });
-
-  array_free(result->hasResults);
-
+  for (size_t i = 0; i < result->numSources; ++i) {
+    SearchResult_Free(result->searchResults[i]);
+  }
   rm_free(result);
 }
 
@@ -78,24 +68,15 @@ void HybridSearchResult_StoreResult(HybridSearchResult* hybridResult, SearchResu
 double calculateHybridScore(HybridSearchResult *hybridResult, HybridScoringContext *scoringCtx) {
   RS_ASSERT(scoringCtx && hybridResult)
 
-  // Extract values from SearchResults
-  arrayof(double) values = array_newlen(double, hybridResult->numSources);
+  double result = 0.0;
   for (size_t i = 0; i < hybridResult->numSources; i++) {
     if (hybridResult->hasResults[i]) {
       RS_ASSERT(hybridResult->searchResults[i]);
       // Note: SearchResult->score contains ranks for RRF, scores for Linear
       // This is set correctly by upstream processors based on scoring type
-      values[i] = SearchResult_GetScore(hybridResult->searchResults[i]);
-    } else {
-      values[i] = 0.0;  // Default value for missing results
+      result += HybridScore_Contribution(scoringCtx, i, SearchResult_GetScore(hybridResult->searchResults[i]));
     }
   }
-
-  // Calculate hybrid score using generic scoring function
-  HybridScoringFunction scoringFunc = GetScoringFunction(scoringCtx->scoringType);
-  double result = scoringFunc(scoringCtx, values, hybridResult->hasResults, hybridResult->numSources);
-
-  array_free(values);
   return result;
 }
 
@@ -23,8 +23,8 @@ extern "C" {
  * HybridSearchResult structure that stores SearchResults from multiple sources.
  */
 typedef struct {
-  arrayof(SearchResult*) searchResults;  // Array of SearchResults from each source
-  arrayof(bool) hasResults;              // Result availability flags
+  SearchResult **searchResults;  // The SearchResult from each source, allocated with the struct
+  bool *hasResults;              // Result availability flags, allocated with the struct
   size_t numSources;                     // Number of sources
 } HybridSearchResult;
 
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "impact_postings.h"
+#include "spec.h"
+#include "config.h"
+#include "doc_table.h"
+#include "ext/default.h"
+#include "iterators/inverted_index_iterator.h"
+#include "util/dict.h"
+#include "rmalloc.h"
+
+#include <string.h>
+
+// Longer terms are not looked up. They are hardly ever common
+#define IMPACT_POSTINGS_MAX_TERM_LEN 128
+
+typedef struct {
+  const InvertedIndex *source;  // The full inverted index of the term
+  InvertedIndex *top;
+  size_t memsize;
+} impactPosting;
+
+struct ImpactPostings {
+  dict *terms;  // Term -> impactPosting
+  size_t memsize;
+};
+
+// A document of a term, while its top documents are selected
+typedef struct {
+  double impact;
+  t_docId docId;
+} impactCandidate;
+
+ImpactPostings *NewImpactPostings(void) {
+  ImpactPostings *ip = rm_calloc(1, sizeof(*ip));
+  ip->terms = dictCreate(&dictTypeHeapStrings, NULL);
+  return ip;
+}
+
+static void impactPosting_Free(impactPosting *p) {
+  InvertedIndex_Free(p->top);
+  rm_free(p);
+}
+
+static void ImpactPostings_Clear(ImpactPostings *ip) {
+  dictIterator *iter = dictGetIterator(ip->terms);
+  dictEntry *entry;
+  while ((entry = dictNext(iter))) {
+    impactPosting_Free(dictGetVal(entry));
+  }
+  dictReleaseIterator(iter);
+  dictEmpty(ip->terms, NULL);
+  ip->memsize = 0;
+}
+
+void ImpactPostings_Free(ImpactPostings *ip) {
+  if (!ip) return;
+  ImpactPostings_Clear(ip);
+  dictRelease(ip->terms);
+  rm_free(ip);
+}
+
+size_t ImpactPostings_MemUsage(const ImpactPostings *ip) {
+  return ip ? ip->memsize : 0;
+}
+
+// Copy the term to `buf` as the key of the dict. Returns false if it is too long to have postings
+static inline bool termKey(char *buf, const char *term, size_t len) {
+  if (len > IMPACT_POSTINGS_MAX_TERM_LEN) {
+    return false;
+  }
+  memcpy(buf, term, len);
+  buf[len] = '\0';
+  return true;
+}
+
+// A min-heap of the candidates with the highest impacts so far
+static void candidatesSiftDown(impactCandidate *heap, size_t n, size_t i) {
+  while (true) {
+    size_t min = i, l = 2 * i + 1, r = l + 1;
+    if (l < n && heap[l].impact < heap[min].impact) min = l;
+    if (r < n && heap[r].impact < heap[min].impact) min = r;
+    if (min == i) return;
+    impactCandidate tmp = heap[i];
+    heap[i] = heap[min];
+    heap[min] = tmp;
+    i = min;
+  }
+}
+
+static void candidatesPush(impactCandidate *heap, size_t *n, impactCandidate c) {
+  size_t i = (*n)++;
+  heap[i] = c;
+  while (i && heap[(i - 1) / 2].impact > heap[i].impact) {
+    impactCandidate tmp = heap[i];
+    heap[i] = heap[(i - 1) / 2];
+    heap[(i - 1) / 2] = tmp;
+    i = (i - 1) / 2;
+  }
+}
+
+static int cmpCandidateIds(const void *a, const void *b) {
+  t_docId x = ((const impactCandidate *)a)->docId, y = ((const impactCandidate *)b)->docId;
+  return x < y ? -1 : x > y;
+}
+
+// Write the entries of the `size` documents of `idx` in which the term weighs the most to a new
+// inverted index, in the order of their ids. The deleted documents are left out
+static InvertedIndex *selectTop(IndexSpec *spec, const InvertedIndex *idx, size_t size,
+                                size_t *memsize) {
+  RSIndexStats stats;
+  IndexSpec_GetStats(spec, &stats);
+  double avgDocLen = stats.avgDocLen ? stats.avgDocLen : 1;
+
+  impactCandidate *heap = rm_malloc(size * sizeof(*heap));
+  size_t n = 0;
+  QueryIterator *it = NewInvIndIterator_TermFull(idx);
+  while (it->Read(it) == ITERATOR_OK) {
+    const RSDocumentMetadata *dmd = DocTable_Lookup(&spec->docs, it->lastDocId);
+    if (!dmd || (dmd->flags & Document_Deleted)) {
+      continue;
+    }
+    impactCandidate c = {
+      .impact = BM25Std_TermImpact(it->current->freq, dmd->len, avgDocLen),
+      .docId = it->lastDocId,
+    };
+    if (n < size) {
+      candidatesPush(heap, &n, c);
+    } else if (c.impact > heap[0].impact) {
+      heap[0] = c;
+      candidatesSiftDown(heap, n, 0);
+    }
+  }
+  qsort(heap, n, sizeof(*heap), cmpCandidateIds);
+
+  InvertedIndex *top = NewInvertedIndex(InvertedIndex_Flags(idx), memsize);
+  it->Rewind(it);
+  for (size_t i = 0; i < n; i++) {
+    if (it->SkipTo(it, heap[i].docId) != ITERATOR_OK) {
+      continue;
+    }
+    const RSIndexResult *cur = it->current;
+    RSIndexResult rec = {.data.term_tag = RSResultData_Term,
+                         .docId = cur->docId,
+                         .freq = cur->freq,
+                         .fieldMask = cur->fieldMask};
+    uint32_t len;
+    const char *offsets = RSOffsetVector_GetData(IndexResult_TermOffsetsRef(cur), &len);
+    RSOffsetVector_SetData(IndexResult_TermOffsetsRefMut(&rec), offsets, len);
+    *memsize += InvertedIndex_WriteEntryGeneric(top, &rec);
+  }
+  it->Free(it);
+  rm_free(heap);
+  return top;
+}
+
+void ImpactPostings_Write(IndexSpec *spec, const InvertedIndex *idx,
+                          const ForwardIndexEntry *entry) {
+  ImpactPostings *ip = spec->impactPostings;
+  uint32_t minDocs = RSGlobalConfig.impactPostingsMinDocs;
+  if (!ip || !dictSize(ip->terms)) {
+    if (!ip || !minDocs || InvertedIndex_NumDocs(idx) < minDocs) {
+      return;
+    }
+  } else if (!minDocs) {
+    ImpactPostings_Clear(ip);
+    return;
+  }
+
+  char key[IMPACT_POSTINGS_MAX_TERM_LEN + 1];
+  if (!termKey(key, entry->term, entry->len)) {
+    return;
+  }
+  impactPosting *p = dictFetchValue(ip->terms, key);
+  if (InvertedIndex_NumDocs(idx) < minDocs) {
+    // The term is not common anymore. Its postings would miss this document
+    if (p) {
+      ip->memsize -= p->memsize;
+      dictDelete(ip->terms, key);
+      impactPosting_Free(p);
+    }
+    return;
+  }
+
+  size_t size = RSGlobalConfig.impactPostingsSize;
+  if (p && p->source == idx && InvertedIndex_NumDocs(p->top) < 2 * size) {
+    size_t sz = InvertedIndex_WriteForwardIndexEntry(p->top, (ForwardIndexEntry *)entry);
+    p->memsize += sz;
+    ip->memsize += sz;
+    return;
+  }
+
+  // The top documents are selected again from the full inverted index, which has the entry
+  if (!p) {
+    p = rm_calloc(1, sizeof(*p));
+    dictAdd(ip->terms, key, p);
+  } else {
+    ip->memsize -= p->memsize;
+    InvertedIndex_Free(p->top);
+  }
+  p->source = idx;
+  p->top = selectTop(spec, idx, size, &p->memsize);
+  ip->memsize += p->memsize;
+}
+
+InvertedIndex *ImpactPostings_Get(const ImpactPostings *ip, const char *term, size_t len,
+                                  const InvertedIndex *idx) {
+  uint32_t minDocs = RSGlobalConfig.impactPostingsMinDocs;
+  if (!ip || !minDocs || !dictSize(ip->terms) || InvertedIndex_NumDocs(idx) < minDocs) {
+    return NULL;
+  }
+  char key[IMPACT_POSTINGS_MAX_TERM_LEN + 1];
+  if (!termKey(key, term, len)) {
+    return NULL;
+  }
+  impactPosting *p = dictFetchValue(ip->terms, key);
+  // The full inverted index may have been freed by the GC and created again since
+  return p && p->source == idx ? p->top : NULL;
+}
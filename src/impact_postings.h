@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include "inverted_index.h"
+#include "forward_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct IndexSpec;
+
+/**
+ * The impact-ordered postings of the common TEXT terms of an index. A term in at least
+ * `_IMPACT_POSTINGS_MIN_DOCS` documents keeps a second inverted index, of the
+ * `_IMPACT_POSTINGS_SIZE` documents in which it weighs the most in BM25STD (its frequency,
+ * normalized by the length of the document), followed by all the documents written to the term
+ * since. Once that tail is as long as the top documents, they are selected again.
+ *
+ * Ranked queries that only return their top results read it in place of the full inverted index of
+ * the term, while filters and counts keep reading the full one. The postings are only changed with
+ * the spec locked for write.
+ */
+typedef struct ImpactPostings ImpactPostings;
+
+ImpactPostings *NewImpactPostings(void);
+void ImpactPostings_Free(ImpactPostings *ip);
+
+/* Account for the entry of a document just written to `idx`, the inverted index of its term: add
+ * it to the impact postings of the term, or select the top documents of the term if it has become
+ * common or its tail is too long */
+void ImpactPostings_Write(struct IndexSpec *spec, const InvertedIndex *idx,
+                          const ForwardIndexEntry *entry);
+
+/* Get the impact postings of the term whose full inverted index is `idx`.
+ * @returns NULL if the term has none, or they are disabled */
+InvertedIndex *ImpactPostings_Get(const ImpactPostings *ip, const char *term, size_t len,
+                                  const InvertedIndex *idx);
+
+/* The memory taken by the impact postings of all the terms */
+size_t ImpactPostings_MemUsage(const ImpactPostings *ip);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,762 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "incremental_gc.h"
+#include "config.h"
+#include "spec.h"
+#include "search_ctx.h"
+#include "redis_index.h"
+#include "inverted_index.h"
+#include "numeric_index.h"
+#include "tag_index.h"
+#include "geometry_index.h"
+#include "suffix.h"
+#include "spell_delete_index.h"
+#include "term_index_cache.h"
+#include "term_tiers.h"
+#include "vector_index.h"
+#include "time_sample.h"
+#include "module.h"
+#include "rmalloc.h"
+#include "trie/trie.h"
+#include "trie/trie_type.h"
+#include "hll/hll.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "info/global_stats.h"
+#include "obfuscation/obfuscation_api.h"
+#include "obfuscation/hidden.h"
+#include <sys/param.h>
+
+// The initial capacity of the scratch buffer of a pass
+#define IGC_SCRATCH_INITIAL_CAP 4096
+
+/* An inverted index scanned by a tick, and its repair */
+typedef struct {
+  // The term, tag value or field name of the index, if it has one
+  char *key;
+  size_t keyLen;
+  InvertedIndex *idx;
+  // The node and range of a numeric index
+  NumericRangeNode *node;
+  NumericRange *range;
+  InvertedIndexGcDelta *delta;
+} IGCItem;
+
+/* The inverted indexes scanned under one hold of the read lock. Only the ones with garbage are kept */
+typedef struct {
+  IncrementalGC *gc;
+  RedisSearchCtx *sctx;
+  IGCItem items[IGC_BATCH_SIZE];
+  size_t numItems;
+  size_t numScanned;
+  size_t blocks;
+  size_t budget;
+  // The batch was filled before the end of the phase (or of the field)
+  bool full;
+} IGCBatch;
+
+/* Identifies the numeric tree or the tag index the items of a batch come from */
+typedef struct {
+  RedisModuleString *keyName;
+  uint32_t uniqueId;
+} IGCFieldIndex;
+
+typedef void (*IGCApplyFn)(IncrementalGC *gc, RedisSearchCtx *sctx, IGCItem *item, void *arg);
+
+// Assumes the spec is locked.
+static void IGC_updateStats(IncrementalGC *gc, RedisSearchCtx *sctx,
+            size_t recordsRemoved, size_t bytesCollected, size_t bytesAdded, uint64_t blocksDenied) {
+  sctx->spec->stats.numRecords -= recordsRemoved;
+  sctx->spec->stats.invertedSize += bytesAdded;
+  sctx->spec->stats.invertedSize -= bytesCollected;
+  gc->stats.totalCollected += bytesCollected;
+  gc->stats.totalCollected -= bytesAdded;
+  gc->stats.gcBlocksDenied += blocksDenied;
+}
+
+// glue to use the scratch buffer as writer for II GC delta info
+static void buffer_write_cb(void *ctx, const void *buf, size_t len) {
+  BufferWriter *bw = ctx;
+  Buffer_Write(bw, buf, len);
+}
+
+// glue to use the scratch buffer as reader for II GC delta info
+static int buffer_read_cb(void *ctx, void *buf, size_t len) {
+  BufferReader *br = ctx;
+  if (br->buf->offset - br->pos < len) {
+    return REDISMODULE_ERR;
+  }
+  Buffer_Read(br, buf, len);
+  return REDISMODULE_OK;
+}
+
+static void noHeader(void *ctx) {
+}
+
+/* Scan an inverted index for garbage. Returns its repair, or NULL if there is nothing to collect.
+ * Assumes the spec is locked */
+static InvertedIndexGcDelta *IGC_scanIndex(IncrementalGC *gc, RedisSearchCtx *sctx,
+                                           InvertedIndex *idx) {
+  gc->scratch.offset = 0;
+  BufferWriter bw = NewBufferWriter(&gc->scratch);
+  II_GCWriter wr = { .ctx = &bw, .write = buffer_write_cb };
+  II_GCCallback cb = { .ctx = NULL, .call = noHeader };
+  if (!InvertedIndex_GcDelta_Scan(&wr, sctx, idx, &cb, NULL)) {
+    return NULL;
+  }
+  BufferReader br = NewBufferReader(&gc->scratch);
+  II_GCReader rd = { .ctx = &br, .read = buffer_read_cb };
+  return InvertedIndex_GcDelta_Read(&rd);
+}
+
+static bool IGCBatch_IsFull(const IGCBatch *b) {
+  return b->numScanned == IGC_BATCH_SIZE || b->blocks >= b->budget;
+}
+
+/* Scan an inverted index into the batch. Returns false if it has nothing to collect, in which case
+ * the item is not kept */
+static bool IGCBatch_Scan(IGCBatch *b, InvertedIndex *idx, IGCItem item) {
+  b->numScanned++;
+  b->blocks += InvertedIndex_NumBlocks(idx);
+  item.idx = idx;
+  item.delta = IGC_scanIndex(b->gc, b->sctx, idx);
+  if (!item.delta) {
+    return false;
+  }
+  b->items[b->numItems++] = item;
+  return true;
+}
+
+/* Apply the repairs of the batch, each under its own hold of the write lock, so that the queries
+ * and the writes interleave with them */
+static void IGCBatch_Apply(IGCBatch *b, IGCApplyFn apply, void *arg) {
+  for (size_t i = 0; i < b->numItems; i++) {
+    RedisSearchCtx_LockSpecWrite(b->sctx);
+    apply(b->gc, b->sctx, &b->items[i], arg);
+    RedisSearchCtx_UnlockSpec(b->sctx);
+    rm_free(b->items[i].key);
+  }
+  b->numItems = 0;
+}
+
+static char *copyKey(const char *key, size_t len) {
+  char *ret = rm_malloc(len + 1);
+  memcpy(ret, key, len);
+  ret[len] = '\0';
+  return ret;
+}
+
+static void IGC_nextField(IncrementalGC *gc) {
+  gc->field++;
+  gc->fieldPos = 0;
+  gc->fieldCollected = false;
+}
+
+static int collectTermCb(const rune *r, size_t n, void *ctx, void *payload) {
+  IGCBatch *b = ctx;
+  if (IGCBatch_IsFull(b)) {
+    b->full = true;
+    return REDISEARCH_ERR;
+  }
+
+  IncrementalGC *gc = b->gc;
+  gc->termCursor = rm_realloc(gc->termCursor, n * sizeof(*r));
+  memcpy(gc->termCursor, r, n * sizeof(*r));
+  gc->termCursorLen = n;
+
+  size_t len;
+  char *term = runesToStr(r, n, &len);
+  // The blocks of the cold terms are collected once they are back in memory
+  bool isCold;
+  InvertedIndex *idx = Redis_PeekInvertedIndex(b->sctx, term, len, &isCold);
+  if (!idx || isCold || !IGCBatch_Scan(b, idx, (IGCItem){.key = term, .keyLen = len})) {
+    rm_free(term);
+  }
+  return REDISEARCH_OK;
+}
+
+static void IGC_applyTerm(IncrementalGC *gc, RedisSearchCtx *sctx, IGCItem *item, void *arg) {
+  const char *term = item->key;
+  size_t len = item->keyLen;
+  InvertedIndex *idx = Redis_OpenInvertedIndex(sctx, term, len, DONT_CREATE_INDEX, NULL);
+  if (idx != item->idx) {
+    InvertedIndex_GcDelta_Free(item->delta);
+    return;
+  }
+
+  II_GCScanStats info = {0};
+  InvertedIndex_ApplyGcDelta(idx, item->delta, &info);
+  sctx->spec->revision++;
+
+  if (InvertedIndex_NumDocs(idx) == 0) {
+    // inverted index was cleaned entirely lets free it
+    RedisModuleString *termKey = fmtRedisTermKey(sctx, term, len);
+    TermIndexCache_Remove(sctx->spec->termIndexes, term, len);
+    if (sctx->spec->keysDict) {
+      // get memory before deleting the inverted index
+      size_t inv_idx_size = InvertedIndex_MemUsage(idx);
+      if (dictDelete(sctx->spec->keysDict, termKey) == DICT_OK) {
+        info.bytes_freed += inv_idx_size;
+      }
+    }
+
+    if (!Trie_Delete(sctx->spec->terms, term, len)) {
+      const char* name = IndexSpec_FormatName(sctx->spec, RSGlobalConfig.hideUserDataFromLog);
+      RedisModule_Log(sctx->redisCtx, "warning", "RedisSearch incremental GC: deleting a term '%s' from"
+                      " trie in index '%s' failed", RSGlobalConfig.hideUserDataFromLog ? Obfuscate_Text(term) : term, name);
+    }
+    sctx->spec->stats.numTerms--;
+    sctx->spec->stats.termsSize -= len;
+    RedisModule_FreeString(sctx->redisCtx, termKey);
+    if (sctx->spec->spellDeletes) {
+      SpellDeleteIndex_Remove(sctx->spec->spellDeletes, term, len);
+    }
+    if (sctx->spec->suffix) {
+      deleteSuffixTrie(sctx->spec->suffix, term, len);
+    } else if (sctx->spec->suffixArray) {
+      SuffixArray_Delete(sctx->spec->suffixArray, term, len);
+    }
+  }
+
+  IGC_updateStats(gc, sctx, info.entries_removed, info.bytes_freed, info.bytes_allocated, info.blocks_ignored);
+}
+
+/* The terms are visited in lexicographic order from the last one visited, which is found again by
+ * a range iteration of the trie, so the terms removed or added in between don't disturb the pass */
+static size_t IGC_collectTerms(IncrementalGC *gc, RedisSearchCtx *sctx, size_t budget) {
+  IGCBatch b = {.gc = gc, .sctx = sctx, .budget = budget};
+  RedisSearchCtx_LockSpecRead(sctx);
+  if (sctx->spec->terms) {
+    TrieNode_IterateRange(sctx->spec->terms->root, gc->termCursor,
+                          gc->termCursor ? gc->termCursorLen : -1, false, NULL, -1, false,
+                          collectTermCb, &b);
+  }
+  RedisSearchCtx_UnlockSpec(sctx);
+
+  IGCBatch_Apply(&b, IGC_applyTerm, NULL);
+  if (!b.full) {
+    gc->phase = IGC_PHASE_NUMERIC;
+  }
+  return b.blocks;
+}
+
+/* The HLL of the range still counts the values of the collected entries */
+static void IGC_resetCardinality(NumericRange *range) {
+  NumericRange_DropExactValues(range);
+  hll_clear(&range->hll);
+  IndexDecoderCtx decoderCtx = {.tag = IndexDecoderCtx_None};
+  IndexReader *reader = NewIndexReader(range->entries, decoderCtx);
+  RSIndexResult *res = NewNumericResult();
+  while (IndexReader_Next(reader, res)) {
+    double value = IndexResult_NumValue(res);
+    hll_add(&range->hll, &value, sizeof(value));
+  }
+  IndexReader_Free(reader);
+  IndexResult_Free(res);
+}
+
+static void IGC_applyNumeric(IncrementalGC *gc, RedisSearchCtx *sctx, IGCItem *item, void *arg) {
+  IGCFieldIndex *fi = arg;
+  NumericRangeTree *rt = openNumericKeysDict(sctx->spec, fi->keyName, DONT_CREATE_INDEX);
+  if (!rt || rt->uniqueId != fi->uniqueId) {
+    InvertedIndex_GcDelta_Free(item->delta);
+    return;
+  }
+  // The range of a node is only ever freed by a split, never replaced
+  NumericRange *range = item->node->range;
+  if (range != item->range) {
+    gc->stats.gcNumericNodesMissed++;
+    InvertedIndex_GcDelta_Free(item->delta);
+    return;
+  }
+
+  II_GCScanStats info = {0};
+  InvertedIndex_ApplyGcDelta(range->entries, item->delta, &info);
+  range->invertedIndexSize += info.bytes_allocated;
+  range->invertedIndexSize -= info.bytes_freed;
+  IGC_resetCardinality(range);
+
+  rt->numEntries -= info.entries_removed;
+  rt->invertedIndexesSize -= info.bytes_freed;
+  rt->invertedIndexesSize += info.bytes_allocated;
+  if (InvertedIndex_NumDocs(range->entries) == 0) {
+    rt->emptyLeaves++;
+  }
+  gc->fieldCollected = true;
+
+  IGC_updateStats(gc, sctx, info.entries_removed, info.bytes_freed, info.bytes_allocated, info.blocks_ignored);
+}
+
+static void IGC_finishNumericField(IncrementalGC *gc, RedisSearchCtx *sctx, IGCFieldIndex *fi) {
+  RedisSearchCtx_LockSpecWrite(sctx);
+  NumericRangeTree *rt = openNumericKeysDict(sctx->spec, fi->keyName, DONT_CREATE_INDEX);
+  if (rt && rt->uniqueId == fi->uniqueId) {
+    if (RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes &&
+        rt->emptyLeaves >= rt->numLeaves / 2) {
+      NRN_AddRv rv = NumericRangeTree_TrimEmptyLeaves(rt);
+      // rv.sz is the number of bytes added. Since we are cleaning empty leaves, it should be negative
+      IGC_updateStats(gc, sctx, 0, -rv.sz, 0, 0);
+    }
+    if (RSGlobalConfig.gcConfigParams.forkGc.forkGCCleanNumericEmptyNodes) {
+      NRN_AddRv rv = NumericRangeTree_Rebalance(rt);
+      // Merging leaves frees memory, while the ranges of rebuilt inner nodes may take more
+      IGC_updateStats(gc, sctx, -rv.numRecords, rv.sz < 0 ? -rv.sz : 0, rv.sz > 0 ? rv.sz : 0, 0);
+    }
+    // The histogram still counts the collected entries
+    NumericRangeTree_RebuildHistogram(rt);
+  }
+  RedisSearchCtx_UnlockSpec(sctx);
+}
+
+/* The nodes of a numeric tree are visited in the iteration order from the position of the last one
+ * visited. A node split in between may shift them, so that a range is skipped by the pass, or
+ * scanned again */
+static size_t IGC_collectNumeric(IncrementalGC *gc, RedisSearchCtx *sctx, size_t budget) {
+  IGCBatch b = {.gc = gc, .sctx = sctx, .budget = budget};
+  IGCFieldIndex fi = {0};
+
+  RedisSearchCtx_LockSpecRead(sctx);
+  arrayof(FieldSpec*) numericFields = getFieldsByType(sctx->spec, INDEXFLD_T_NUMERIC | INDEXFLD_T_GEO);
+  if (gc->field >= array_len(numericFields)) {
+    array_free(numericFields);
+    RedisSearchCtx_UnlockSpec(sctx);
+    gc->phase = IGC_PHASE_TAGS;
+    gc->field = 0;
+    gc->fieldPos = 0;
+    return 0;
+  }
+  fi.keyName = IndexSpec_GetFormattedKey(sctx->spec, numericFields[gc->field], INDEXFLD_T_NUMERIC);
+  array_free(numericFields);
+
+  // No entries were added to the numeric field, hence the tree was not initialized
+  NumericRangeTree *rt = openNumericKeysDict(sctx->spec, fi.keyName, DONT_CREATE_INDEX);
+  if (rt) {
+    fi.uniqueId = rt->uniqueId;
+    NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+    NumericRangeNode *node;
+    size_t pos = 0;
+    while ((node = NumericRangeTreeIterator_Next(iter))) {
+      if (pos < gc->fieldPos) {
+        pos++;
+        continue;
+      }
+      if (IGCBatch_IsFull(&b)) {
+        b.full = true;
+        break;
+      }
+      pos++;
+      if (node->range) {
+        IGCBatch_Scan(&b, node->range->entries, (IGCItem){.node = node, .range = node->range});
+      }
+    }
+    NumericRangeTreeIterator_Free(iter);
+    gc->fieldPos = pos;
+  }
+  RedisSearchCtx_UnlockSpec(sctx);
+
+  IGCBatch_Apply(&b, IGC_applyNumeric, &fi);
+  if (!b.full) {
+    if (rt && gc->fieldCollected) {
+      IGC_finishNumericField(gc, sctx, &fi);
+    }
+    IGC_nextField(gc);
+  }
+  return b.blocks;
+}
+
+static void IGC_applyTag(IncrementalGC *gc, RedisSearchCtx *sctx, IGCItem *item, void *arg) {
+  IGCFieldIndex *fi = arg;
+  TagIndex *tagIdx = TagIndex_Open(sctx->spec, fi->keyName, DONT_CREATE_INDEX);
+  if (!tagIdx || tagIdx->uniqueId != fi->uniqueId) {
+    InvertedIndex_GcDelta_Free(item->delta);
+    return;
+  }
+  size_t dummy_size;
+  InvertedIndex *idx = TagIndex_OpenIndex(tagIdx, item->key, item->keyLen, DONT_CREATE_INDEX, &dummy_size);
+  if (idx == TRIEMAP_NOTFOUND || idx != item->idx) {
+    InvertedIndex_GcDelta_Free(item->delta);
+    return;
+  }
+
+  II_GCScanStats info = {0};
+  InvertedIndex_ApplyGcDelta(idx, item->delta, &info);
+  tagIdx->revision++;  // the cached sets may hold the collected documents
+
+  // if tag value is empty, let's remove it.
+  if (InvertedIndex_NumDocs(idx) == 0) {
+    // get memory before deleting the inverted index
+    info.bytes_freed += InvertedIndex_MemUsage(idx);
+    TagIndex_DeleteValue(tagIdx, item->key, item->keyLen);
+
+    if (tagIdx->suffix) {
+      deleteSuffixTrieMap(tagIdx->suffix, item->key, item->keyLen);
+    }
+  }
+
+  IGC_updateStats(gc, sctx, info.entries_removed, info.bytes_freed, info.bytes_allocated, info.blocks_ignored);
+}
+
+// Compact the tag index if many values were added to it since its last compaction
+static void IGC_finishTagField(IncrementalGC *gc, RedisSearchCtx *sctx, IGCFieldIndex *fi) {
+  unsigned int threshold = RSGlobalConfig.tagCompactThreshold;
+  if (!threshold) {
+    return;
+  }
+  RedisSearchCtx_LockSpecWrite(sctx);
+  TagIndex *tagIdx = TagIndex_Open(sctx->spec, fi->keyName, DONT_CREATE_INDEX);
+  if (tagIdx && tagIdx->uniqueId == fi->uniqueId && TrieMap_NUniqueKeys(tagIdx->values) >= threshold) {
+    TagIndex_Compact(tagIdx);
+  }
+  RedisSearchCtx_UnlockSpec(sctx);
+}
+
+/* The values of a tag index are visited in the iteration order from the position of the last one
+ * visited, walking over the values before it again. A value removed in between shifts them, so
+ * that a value is skipped by the pass */
+static size_t IGC_collectTags(IncrementalGC *gc, RedisSearchCtx *sctx, size_t budget) {
+  IGCBatch b = {.gc = gc, .sctx = sctx, .budget = budget};
+  IGCFieldIndex fi = {0};
+
+  RedisSearchCtx_LockSpecRead(sctx);
+  arrayof(FieldSpec*) tagFields = getFieldsByType(sctx->spec, INDEXFLD_T_TAG);
+  if (gc->field >= array_len(tagFields)) {
+    array_free(tagFields);
+    RedisSearchCtx_UnlockSpec(sctx);
+    gc->phase = IGC_PHASE_MISSING_DOCS;
+    gc->field = 0;
+    gc->fieldPos = 0;
+    return 0;
+  }
+  fi.keyName = IndexSpec_GetFormattedKey(sctx->spec, tagFields[gc->field], INDEXFLD_T_TAG);
+  array_free(tagFields);
+
+  TagIndex *tagIdx = TagIndex_Open(sctx->spec, fi.keyName, DONT_CREATE_INDEX);
+  if (tagIdx) {
+    fi.uniqueId = tagIdx->uniqueId;
+    TagValuesIterator *iter = TagIndex_IterateValues(tagIdx, NULL, 0, TM_PREFIX_MODE);
+    char *ptr;
+    tm_len_t len;
+    InvertedIndex *value;
+    size_t pos = 0;
+    while (TagValuesIterator_Next(iter, &ptr, &len, &value)) {
+      if (pos < gc->fieldPos) {
+        pos++;
+        continue;
+      }
+      if (IGCBatch_IsFull(&b)) {
+        b.full = true;
+        break;
+      }
+      pos++;
+      char *key = copyKey(ptr, len);
+      if (!IGCBatch_Scan(&b, value, (IGCItem){.key = key, .keyLen = len})) {
+        rm_free(key);
+      }
+    }
+    TagValuesIterator_Free(iter);
+    gc->fieldPos = pos;
+  }
+  RedisSearchCtx_UnlockSpec(sctx);
+
+  IGCBatch_Apply(&b, IGC_applyTag, &fi);
+  if (!b.full) {
+    if (tagIdx) {
+      IGC_finishTagField(gc, sctx, &fi);
+    }
+    IGC_nextField(gc);
+  }
+  return b.blocks;
+}
+
+static void IGC_applyMissingDocs(IncrementalGC *gc, RedisSearchCtx *sctx, IGCItem *item, void *arg) {
+  HiddenString *fieldName = NewHiddenString(item->key, item->keyLen, false);
+  InvertedIndex *idx = dictFetchValue(sctx->spec->missingFieldDict, fieldName);
+  if (idx != item->idx) {
+    InvertedIndex_GcDelta_Free(item->delta);
+    HiddenString_Free(fieldName, false);
+    return;
+  }
+
+  II_GCScanStats info = {0};
+  InvertedIndex_ApplyGcDelta(idx, item->delta, &info);
+  if (InvertedIndex_NumDocs(idx) == 0) {
+    // inverted index was cleaned entirely lets free it
+    info.bytes_freed += InvertedIndex_MemUsage(idx);
+    dictDelete(sctx->spec->missingFieldDict, fieldName);
+  }
+  IGC_updateStats(gc, sctx, info.entries_removed, info.bytes_freed, info.bytes_allocated, info.blocks_ignored);
+  HiddenString_Free(fieldName, false);
+}
+
+static size_t IGC_collectMissingDocs(IncrementalGC *gc, RedisSearchCtx *sctx, size_t budget) {
+  IGCBatch b = {.gc = gc, .sctx = sctx, .budget = budget};
+
+  RedisSearchCtx_LockSpecRead(sctx);
+  dictIterator* iter = dictGetIterator(sctx->spec->missingFieldDict);
+  dictEntry* entry = NULL;
+  size_t pos = 0;
+  while ((entry = dictNext(iter))) {
+    if (pos < gc->fieldPos) {
+      pos++;
+      continue;
+    }
+    if (IGCBatch_IsFull(&b)) {
+      b.full = true;
+      break;
+    }
+    pos++;
+    InvertedIndex *idx = dictGetVal(entry);
+    if (idx) {
+      size_t length;
+      const char *fieldName = HiddenString_GetUnsafe(dictGetKey(entry), &length);
+      char *key = copyKey(fieldName, length);
+      if (!IGCBatch_Scan(&b, idx, (IGCItem){.key = key, .keyLen = length})) {
+        rm_free(key);
+      }
+    }
+  }
+  dictReleaseIterator(iter);
+  gc->fieldPos = pos;
+  RedisSearchCtx_UnlockSpec(sctx);
+
+  IGCBatch_Apply(&b, IGC_applyMissingDocs, NULL);
+  if (!b.full) {
+    gc->phase = IGC_PHASE_EXISTING_DOCS;
+    gc->fieldPos = 0;
+  }
+  return b.blocks;
+}
+
+static void IGC_applyExistingDocs(IncrementalGC *gc, RedisSearchCtx *sctx, IGCItem *item, void *arg) {
+  IndexSpec *sp = sctx->spec;
+  InvertedIndex *idx = sp->existingDocs;
+  if (idx != item->idx) {
+    InvertedIndex_GcDelta_Free(item->delta);
+    return;
+  }
+
+  II_GCScanStats info = {0};
+  InvertedIndex_ApplyGcDelta(idx, item->delta, &info);
+
+  // We don't count the records that we removed, because we also don't count
+  // their addition (they are duplications so we have no such desire).
+
+  if (InvertedIndex_NumDocs(idx) == 0) {
+    // inverted index was cleaned entirely, let's free it
+    info.bytes_freed += InvertedIndex_MemUsage(idx);
+    InvertedIndex_Free(idx);
+    sp->existingDocs = NULL;
+  }
+  IGC_updateStats(gc, sctx, 0, info.bytes_freed, info.bytes_allocated, info.blocks_ignored);
+}
+
+static size_t IGC_collectExistingDocs(IncrementalGC *gc, RedisSearchCtx *sctx, size_t budget) {
+  IGCBatch b = {.gc = gc, .sctx = sctx, .budget = budget};
+
+  RedisSearchCtx_LockSpecRead(sctx);
+  if (sctx->spec->existingDocs) {
+    IGCBatch_Scan(&b, sctx->spec->existingDocs, (IGCItem){0});
+  }
+  RedisSearchCtx_UnlockSpec(sctx);
+
+  IGCBatch_Apply(&b, IGC_applyExistingDocs, NULL);
+
+  // The R-trees of the geometry fields are not collected, but repacked once they changed much
+  if (sctx->spec->flags & Index_HasGeometry) {
+    RedisSearchCtx_LockSpecWrite(sctx);
+    GeometryIndex_Repack(sctx->spec, false);
+    RedisSearchCtx_UnlockSpec(sctx);
+  }
+  gc->phase = IGC_PHASE_DONE;
+  return b.blocks;
+}
+
+// Scan up to `budget` blocks at the position of the pass. Returns the number of blocks scanned
+static size_t IGC_step(IncrementalGC *gc, RedisSearchCtx *sctx, size_t budget) {
+  switch (gc->phase) {
+    case IGC_PHASE_TERMS:
+      return IGC_collectTerms(gc, sctx, budget);
+    case IGC_PHASE_NUMERIC:
+      return IGC_collectNumeric(gc, sctx, budget);
+    case IGC_PHASE_TAGS:
+      return IGC_collectTags(gc, sctx, budget);
+    case IGC_PHASE_MISSING_DOCS:
+      return IGC_collectMissingDocs(gc, sctx, budget);
+    case IGC_PHASE_EXISTING_DOCS:
+      return IGC_collectExistingDocs(gc, sctx, budget);
+    case IGC_PHASE_DONE:
+      break;
+  }
+  return 0;
+}
+
+static void IGC_resetPosition(IncrementalGC *gc) {
+  gc->field = 0;
+  gc->fieldPos = 0;
+  gc->fieldCollected = false;
+  rm_free(gc->termCursor);
+  gc->termCursor = NULL;
+  gc->termCursorLen = 0;
+}
+
+static void IGC_startPass(IncrementalGC *gc) {
+  // Take the deleted documents as the fork GC does when it forks
+  RedisModule_ThreadSafeContextLock(gc->ctx);
+  gc->deletedDocsOfPass = gc->deletedDocsFromLastRun;
+  gc->deletedDocsFromLastRun = 0;
+  RedisModule_ThreadSafeContextUnlock(gc->ctx);
+
+  IGC_resetPosition(gc);
+  gc->phase = IGC_PHASE_TERMS;
+  gc->passMSRun = 0;
+  Buffer_Init(&gc->scratch, IGC_SCRATCH_INITIAL_CAP);
+  gc->retryInterval.tv_sec = 0;
+  gc->retryInterval.tv_nsec = IGC_TICK_INTERVAL_MS * 1000000;
+}
+
+static int IGC_endPass(IncrementalGC *gc) {
+  IGC_resetPosition(gc);
+  Buffer_Free(&gc->scratch);
+  IndexsGlobalStats_UpdateLogicallyDeleted(-gc->deletedDocsOfPass);
+  gc->deletedDocsOfPass = 0;
+
+  gc->stats.numCycles++;
+  gc->stats.lastRunTimeMs = gc->passMSRun;
+  gc->retryInterval.tv_sec = RSGlobalConfig.gcConfigParams.forkGc.forkGcRunIntervalSec;
+  gc->retryInterval.tv_nsec = 0;
+  return VecSim_CallTieredIndexesGC(gc->index) && TermTiers_RunCycle(gc->index);
+}
+
+// Run a tick of the current pass, or start a pass if enough documents were deleted
+static int periodicCb(void *privdata) {
+  IncrementalGC *gc = privdata;
+
+  StrongRef spec_ref = IndexSpecRef_Promote(gc->index);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    // Index was deleted
+    return 0;
+  }
+
+  if (gc->phase == IGC_PHASE_DONE) {
+    if (gc->deletedDocsFromLastRun < RSGlobalConfig.gcConfigParams.forkGc.forkGcCleanThreshold) {
+      IndexSpecRef_Release(spec_ref);
+      return TermTiers_RunCycle(gc->index);
+    }
+    IGC_startPass(gc);
+  }
+
+  TimeSample ts;
+  TimeSampler_Start(&ts);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(gc->ctx, sp);
+  size_t budget = MAX(RSGlobalConfig.gcConfigParams.gcScanSize, 1);
+  size_t scanned = 0;
+  while (gc->phase != IGC_PHASE_DONE && scanned < budget) {
+    scanned += IGC_step(gc, &sctx, budget - scanned);
+  }
+  IndexSpecRef_Release(spec_ref);
+  TimeSampler_End(&ts);
+  long long msRun = TimeSampler_DurationMS(&ts);
+  gc->stats.totalMSRun += msRun;
+  gc->passMSRun += msRun;
+
+  if (gc->phase == IGC_PHASE_DONE) {
+    return IGC_endPass(gc);
+  }
+  return 1;
+}
+
+/* Run a whole pass at once. If a pass was in progress, it is completed first, and another one
+ * collects the documents deleted from the indexes it had already visited */
+static int forceCb(void *privdata) {
+  IncrementalGC *gc = privdata;
+  int passes = gc->phase == IGC_PHASE_DONE ? 1 : 2;
+  int rv = 1;
+  for (int i = 0; i < passes && rv; i++) {
+    do {
+      rv = periodicCb(gc);
+    } while (rv && gc->phase != IGC_PHASE_DONE);
+  }
+  return rv;
+}
+
+static void onTerminateCb(void *privdata) {
+  IncrementalGC *gc = privdata;
+  IndexsGlobalStats_UpdateLogicallyDeleted(-(gc->deletedDocsFromLastRun + gc->deletedDocsOfPass));
+  if (gc->phase != IGC_PHASE_DONE) {
+    Buffer_Free(&gc->scratch);
+  }
+  rm_free(gc->termCursor);
+  WeakRef_Release(gc->index);
+  RedisModule_FreeThreadSafeContext(gc->ctx);
+  rm_free(gc);
+}
+
+static void statsCb(RedisModule_Reply *reply, void *gcCtx) {
+#define REPLY_KVNUM(k, v) RedisModule_ReplyKV_Double(reply, (k), (v))
+  IncrementalGC *gc = gcCtx;
+  if (!gc) return;
+  REPLY_KVNUM("bytes_collected", gc->stats.totalCollected);
+  REPLY_KVNUM("total_ms_run", gc->stats.totalMSRun);
+  REPLY_KVNUM("total_cycles", gc->stats.numCycles);
+  REPLY_KVNUM("average_cycle_time_ms", (double)gc->stats.totalMSRun / gc->stats.numCycles);
+  REPLY_KVNUM("last_run_time_ms", (double)gc->stats.lastRunTimeMs);
+  REPLY_KVNUM("gc_numeric_trees_missed", (double)gc->stats.gcNumericNodesMissed);
+  REPLY_KVNUM("gc_blocks_denied", (double)gc->stats.gcBlocksDenied);
+}
+
+#ifdef FTINFO_FOR_INFO_MODULES
+static void statsForInfoCb(RedisModuleInfoCtx *ctx, void *gcCtx) {
+  IncrementalGC *gc = gcCtx;
+  RedisModule_InfoBeginDictField(ctx, "gc_stats");
+  RedisModule_InfoAddFieldLongLong(ctx, "bytes_collected", gc->stats.totalCollected);
+  RedisModule_InfoAddFieldLongLong(ctx, "total_ms_run", gc->stats.totalMSRun);
+  RedisModule_InfoAddFieldLongLong(ctx, "total_cycles", gc->stats.numCycles);
+  RedisModule_InfoAddFieldDouble(ctx, "average_cycle_time_ms", (double)gc->stats.totalMSRun / gc->stats.numCycles);
+  RedisModule_InfoAddFieldDouble(ctx, "last_run_time_ms", (double)gc->stats.lastRunTimeMs);
+  RedisModule_InfoAddFieldDouble(ctx, "gc_numeric_trees_missed", (double)gc->stats.gcNumericNodesMissed);
+  RedisModule_InfoAddFieldDouble(ctx, "gc_blocks_denied", (double)gc->stats.gcBlocksDenied);
+  RedisModule_InfoEndDictField(ctx);
+}
+#endif
+
+static void deleteCb(void *ctx, t_docId docId) {
+  IncrementalGC *gc = ctx;
+  ++gc->deletedDocsFromLastRun;
+  IndexsGlobalStats_UpdateLogicallyDeleted(1);
+}
+
+static struct timespec getIntervalCb(void *ctx) {
+  IncrementalGC *gc = ctx;
+  return gc->retryInterval;
+}
+
+IncrementalGC *IGC_New(StrongRef spec_ref, GCCallbacks *callbacks) {
+  IncrementalGC *gc = rm_calloc(1, sizeof(*gc));
+  *gc = (IncrementalGC){
+      .index = StrongRef_Demote(spec_ref),
+      .deletedDocsFromLastRun = 0,
+      .phase = IGC_PHASE_DONE,
+  };
+  gc->retryInterval.tv_sec = RSGlobalConfig.gcConfigParams.forkGc.forkGcRunIntervalSec;
+  gc->retryInterval.tv_nsec = 0;
+  gc->ctx = RedisModule_GetDetachedThreadSafeContext(RSDummyContext);
+
+  callbacks->onTerm = onTerminateCb;
+  callbacks->periodicCallback = periodicCb;
+  callbacks->forceCallback = forceCb;
+  callbacks->renderStats = statsCb;
+  #ifdef FTINFO_FOR_INFO_MODULES
+  callbacks->renderStatsForInfo = statsForInfoCb;
+  #endif
+  callbacks->getInterval = getIntervalCb;
+  callbacks->onDelete = deleteCb;
+
+  return gc;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#ifndef SRC_INCREMENTAL_GC_H_
+#define SRC_INCREMENTAL_GC_H_
+
+#include "redismodule.h"
+#include "gc.h"
+#include "fork_gc.h"
+#include "buffer/buffer.h"
+#include "trie/rune_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The interval between the ticks of a collection pass, in milliseconds
+#define IGC_TICK_INTERVAL_MS 10
+// The maximal number of inverted indexes scanned under a single hold of the read lock
+#define IGC_BATCH_SIZE 32
+
+/* The kinds of inverted indexes a pass goes through, in order */
+typedef enum {
+  IGC_PHASE_TERMS = 0,
+  IGC_PHASE_NUMERIC,
+  IGC_PHASE_TAGS,
+  IGC_PHASE_MISSING_DOCS,
+  IGC_PHASE_EXISTING_DOCS,
+  IGC_PHASE_DONE,
+} IGCPhase;
+
+/* The garbage collector of the GC_POLICY INCREMENTAL policy (each index has one).
+ *
+ * Rather than forking to scan all the inverted indexes of the index at once, it goes through them
+ * in passes of many short ticks, run by the GC thread pool in the main process. Each tick scans
+ * about GCSCANSIZE blocks, a batch of inverted indexes at a time under the read lock, and then
+ * applies the repair of each index under the write lock, as the fork GC applies the ones sent by
+ * its child. An inverted index is always scanned as a whole, so a tick goes over the budget by up
+ * to the blocks of its last index.
+ *
+ * A pass starts once FORK_GC_CLEAN_THRESHOLD documents were deleted, checked every
+ * FORK_GC_RUN_INTERVAL seconds, and its ticks follow each other every IGC_TICK_INTERVAL_MS.
+ * The documents deleted during a pass are collected from the indexes it didn't reach yet, and by
+ * the next pass from the others */
+typedef struct IncrementalGC {
+  // owner of the gc
+  WeakRef index;
+
+  RedisModuleCtx *ctx;
+
+  // statistics for reporting. A cycle is a whole pass
+  ForkGCStats stats;
+
+  struct timespec retryInterval;
+  volatile size_t deletedDocsFromLastRun;
+  // The deleted documents the current pass collects
+  size_t deletedDocsOfPass;
+  // The time spent by the ticks of the current pass
+  long long passMSRun;
+
+  // The position of the current pass, `IGC_PHASE_DONE` between passes
+  IGCPhase phase;
+  // The field of the numeric and tag phases
+  uint32_t field;
+  // The number of numeric nodes or tag values of the field visited by the pass
+  size_t fieldPos;
+  // Whether a range of the numeric field was collected by the pass
+  bool fieldCollected;
+  // The last term visited by the pass, or NULL before the first
+  rune *termCursor;
+  size_t termCursorLen;
+
+  // Holds the repair of an inverted index between its scan and its application
+  Buffer scratch;
+} IncrementalGC;
+
+IncrementalGC *IGC_New(StrongRef spec_ref, GCCallbacks *callbacks);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SRC_INCREMENTAL_GC_H_ */
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "index_delta.h"
+#include "forward_index.h"
+#include "byte_offsets.h"
+#include "commands.h"
+#include "config.h"
+#include "module.h"
+#include "notifications.h"
+#include "varint.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "rmalloc.h"
+
+#include <pthread.h>
+
+/* The layout of a delta, whose integers are varints unless noted otherwise:
+ *
+ *   version (u8) | flags (u8) | digest (u64)
+ *   number of terms, then for each: length | bytes | frequency | field mask | [offsets]
+ *   max frequency | total frequency
+ *   [number of fields, then for each: id | first token | last token, then the byte offsets]
+ *
+ * where the offsets are their count, then the length and the bytes of their delta encoding. The
+ * term offsets are there with DELTA_F_TERM_OFFSETS, and the byte offsets with
+ * DELTA_F_BYTE_OFFSETS, as the index stores them. */
+#define INDEX_DELTA_VERSION 1
+#define INDEX_DELTA_HEADER_LEN (2 + sizeof(uint64_t))
+
+#define DELTA_F_TERM_OFFSETS 0x01
+#define DELTA_F_BYTE_OFFSETS 0x02
+
+static pthread_t mainThread;
+
+void IndexDelta_Init(void) {
+  mainThread = pthread_self();
+}
+
+static uint8_t deltaFlags(const RSAddDocumentCtx *aCtx) {
+  uint8_t flags = 0;
+  if (aCtx->fwIdx->idxFlags & Index_StoreTermOffsets) {
+    flags |= DELTA_F_TERM_OFFSETS;
+  }
+  if (aCtx->byteOffsets) {
+    flags |= DELTA_F_BYTE_OFFSETS;
+  }
+  return flags;
+}
+
+static void writeOffsets(BufferWriter *w, const VarintVectorWriter *vw) {
+  size_t len = VVW_GetByteLength(vw);
+  WriteVarint(VVW_GetCount(vw), w);
+  WriteVarint(len, w);
+  if (len) {
+    Buffer_Write(w, VVW_GetByteData(vw), len);
+  }
+}
+
+void IndexDelta_Write(const RSAddDocumentCtx *aCtx, Buffer *out) {
+  BufferWriter w = NewBufferWriter(out);
+  const ForwardIndex *fw = aCtx->fwIdx;
+  const uint8_t flags = deltaFlags(aCtx);
+  Buffer_WriteU8(&w, INDEX_DELTA_VERSION);
+  Buffer_WriteU8(&w, flags);
+  Buffer_Write(&w, &aCtx->digest, sizeof(aCtx->digest));
+
+  WriteVarint(fw->hits->numItems, &w);
+  ForwardIndexIterator it = ForwardIndex_Iterate(aCtx->fwIdx);
+  for (ForwardIndexEntry *entry; (entry = ForwardIndexIterator_Next(&it));) {
+    WriteVarint(entry->len, &w);
+    if (entry->len) {
+      Buffer_Write(&w, entry->term, entry->len);
+    }
+    WriteVarint(entry->freq, &w);
+    WriteVarintFieldMask(entry->fieldMask, &w);
+    if (flags & DELTA_F_TERM_OFFSETS) {
+      writeOffsets(&w, entry->vw);
+    }
+  }
+  WriteVarint(fw->maxFreq, &w);
+  WriteVarint(fw->totalFreq, &w);
+
+  if (flags & DELTA_F_BYTE_OFFSETS) {
+    const RSByteOffsets *offsets = aCtx->byteOffsets;
+    WriteVarint(offsets->numFields, &w);
+    for (size_t i = 0; i < offsets->numFields; ++i) {
+      WriteVarint(offsets->fields[i].fieldId, &w);
+      WriteVarint(offsets->fields[i].firstTokPos, &w);
+      WriteVarint(offsets->fields[i].lastTokPos, &w);
+    }
+    writeOffsets(&w, aCtx->offsetsWriter.vw);
+  }
+}
+
+// Returns the next `len` bytes, or NULL if the delta is shorter
+static const char *readBytes(BufferReader *r, size_t len) {
+  if (len > BufferReader_Remaining(r)) {
+    return NULL;
+  }
+  const char *p = r->buf->data + r->pos;
+  r->pos += len;
+  return p;
+}
+
+// Reads offsets into `vw`, or only skips them if it is NULL
+static bool readOffsets(BufferReader *r, VarintVectorWriter *vw) {
+  uint32_t count = ReadVarint(r);
+  uint32_t len = ReadVarint(r);
+  const char *data = readBytes(r, len);
+  if (!data) {
+    return false;
+  }
+  if (!vw) {
+    return true;
+  }
+  Buffer buf = {.data = (char *)data, .cap = len, .offset = len};
+  BufferReader encoded = NewBufferReader(&buf);
+  // The deltas are summed up, as the writer encodes the offsets as deltas again
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    offset += ReadVarint(&encoded);
+    VVW_Write(vw, offset);
+  }
+  return BufferReader_Offset(&encoded) == len;
+}
+
+static size_t numTextFields(const RSAddDocumentCtx *aCtx) {
+  size_t n = 0;
+  for (size_t i = 0; i < aCtx->doc->numFields; ++i) {
+    if ((aCtx->doc->fields[i].indexAs & INDEXFLD_T_FULLTEXT) &&
+        FieldSpec_IsIndexable(aCtx->fspecs + i)) {
+      n++;
+    }
+  }
+  return n;
+}
+
+/* Reads the body of the delta, after its header. It is first read without `apply`, only checking
+ * that it is whole, so that a delta is either read into the document or not at all */
+static bool readBody(BufferReader *r, RSAddDocumentCtx *aCtx, uint8_t flags, bool apply) {
+  ForwardIndex *fw = aCtx->fwIdx;
+  uint32_t numTerms = ReadVarint(r);
+  for (uint32_t i = 0; i < numTerms; ++i) {
+    uint32_t len = ReadVarint(r);
+    const char *term = readBytes(r, len);
+    if (!term) {
+      return false;
+    }
+    uint32_t freq = ReadVarint(r);
+    t_fieldMask fieldMask = ReadVarintFieldMask(r);
+    ForwardIndexEntry *entry = apply ? ForwardIndex_Put(fw, term, len, freq, fieldMask) : NULL;
+    if ((flags & DELTA_F_TERM_OFFSETS) && !readOffsets(r, entry ? entry->vw : NULL)) {
+      return false;
+    }
+  }
+  uint32_t maxFreq = ReadVarint(r);
+  uint32_t totalFreq = ReadVarint(r);
+  if (apply) {
+    fw->maxFreq = maxFreq;
+    fw->totalFreq = totalFreq;
+  }
+
+  if (flags & DELTA_F_BYTE_OFFSETS) {
+    uint32_t numFields = ReadVarint(r);
+    // The byte offsets have room for the text fields of the document
+    if (numFields > numTextFields(aCtx)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < numFields; ++i) {
+      uint32_t fieldId = ReadVarint(r);
+      uint32_t firstTokPos = ReadVarint(r);
+      uint32_t lastTokPos = ReadVarint(r);
+      if (apply) {
+        RSByteOffsets_AddField(aCtx->byteOffsets, fieldId, firstTokPos)->lastTokPos = lastTokPos;
+      }
+    }
+    if (!readOffsets(r, apply ? aCtx->offsetsWriter.vw : NULL)) {
+      return false;
+    }
+  }
+  return BufferReader_Remaining(r) == 0;
+}
+
+bool IndexDelta_Read(RSAddDocumentCtx *aCtx, RedisModuleString *delta) {
+  size_t len;
+  const char *data = RedisModule_StringPtrLen(delta, &len);
+  if (len < INDEX_DELTA_HEADER_LEN || !aCtx->digest) {
+    return false;
+  }
+  Buffer buf = {.data = (char *)data, .cap = len, .offset = len};
+  BufferReader r = NewBufferReader(&buf);
+  uint8_t version = Buffer_ReadU8(&r);
+  uint8_t flags = Buffer_ReadU8(&r);
+  uint64_t digest;
+  Buffer_Read(&r, &digest, sizeof(digest));
+  // The document of the replica may differ from the one of the primary, or be indexed otherwise
+  if (version != INDEX_DELTA_VERSION || flags != deltaFlags(aCtx) || digest != aCtx->digest) {
+    return false;
+  }
+
+  const size_t bodyPos = BufferReader_Offset(&r);
+  if (!readBody(&r, aCtx, flags, false)) {
+    return false;
+  }
+  r.pos = bodyPos;
+  return readBody(&r, aCtx, flags, true);
+}
+
+void IndexDelta_Replicate(RedisModuleCtx *ctx, const RSAddDocumentCtx *aCtx) {
+  if (!RSGlobalConfig.indexDeltaReplication || !aCtx->digest || aCtx->failedField ||
+      (aCtx->stateFlags & ACTX_F_TEXTINDEXED)) {
+    // Without text fields, there is nothing for the replica to skip
+    return;
+  }
+  // The background scans index the documents which were written before, so were replicated as is
+  if (!pthread_equal(pthread_self(), mainThread)) {
+    return;
+  }
+  int ctxFlags = RedisModule_GetContextFlags(ctx);
+  if (!(ctxFlags & REDISMODULE_CTX_FLAGS_MASTER) || (ctxFlags & REDISMODULE_CTX_FLAGS_LOADING)) {
+    return;
+  }
+
+  Buffer buf = {0};
+  Buffer_Init(&buf, INDEX_DELTA_HEADER_LEN + 16 * aCtx->fwIdx->hits->numItems);
+  IndexDelta_Write(aCtx, &buf);
+  size_t nameLen;
+  const char *name = HiddenString_GetUnsafe(aCtx->spec->specName, &nameLen);
+  RedisModule_Replicate(ctx, RS_INDEX_DELTA_CMD, "bsb", name, nameLen, aCtx->doc->docKey,
+                        buf.data, buf.offset);
+  Buffer_Free(&buf);
+}
+
+/********************************************************
+ *        Deltas received for the pending writes        *
+ ********************************************************/
+
+static arrayof(RedisModuleString *) deltas = NULL;
+// The position in `deltas` of the delta of each index and key, keyed by both (see deltaKey())
+static dict *deltaKeys = NULL;
+
+static RedisModuleString *deltaKey(const char *index, size_t indexLen, RedisModuleString *key) {
+  size_t keyLen;
+  const char *k = RedisModule_StringPtrLen(key, &keyLen);
+  // The length of the name comes first, as both may hold any byte
+  uint32_t len = indexLen;
+  RedisModuleString *ret = RedisModule_CreateString(RSDummyContext, (const char *)&len, sizeof(len));
+  RedisModule_StringAppendBuffer(RSDummyContext, ret, index, indexLen);
+  RedisModule_StringAppendBuffer(RSDummyContext, ret, k, keyLen);
+  return ret;
+}
+
+RedisModuleString *IndexDelta_Find(const IndexSpec *spec, RedisModuleString *key) {
+  if (!deltaKeys) {
+    return NULL;
+  }
+  size_t nameLen;
+  const char *name = HiddenString_GetUnsafe(spec->specName, &nameLen);
+  RedisModuleString *dk = deltaKey(name, nameLen, key);
+  dictEntry *entry = dictFind(deltaKeys, dk);
+  RedisModule_FreeString(RSDummyContext, dk);
+  return entry ? deltas[entry->v.u64] : NULL;
+}
+
+void IndexDelta_Clear(void) {
+  if (!deltas) {
+    return;
+  }
+  for (size_t i = 0; i < array_len(deltas); ++i) {
+    RedisModule_FreeString(RSDummyContext, deltas[i]);
+  }
+  array_free(deltas);
+  deltas = NULL;
+  dictRelease(deltaKeys);
+  deltaKeys = NULL;
+}
+
+int IndexDeltaCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc != 4) {
+    return RedisModule_WrongArity(ctx);
+  }
+  // The replica indexes the terms of the delta instead of the document, so only the primary may send
+  // one, through the replication link or the AOF it wrote
+  int ctxFlags = RedisModule_GetContextFlags(ctx);
+  if (!(ctxFlags & (REDISMODULE_CTX_FLAGS_REPLICATED | REDISMODULE_CTX_FLAGS_LOADING))) {
+    return RedisModule_ReplyWithError(ctx, "ERR " RS_INDEX_DELTA_CMD " is sent by the primary only");
+  }
+  // Unless the write of the key is pending, its document is indexed already, or was not written
+  // along with the delta, which is then of no use
+  if (!KeyspaceEvents_IsPending(argv[2])) {
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+  }
+  if (!deltas) {
+    deltas = array_new(RedisModuleString *, 16);
+    deltaKeys = dictCreate(&dictTypeHeapRedisStrings, NULL);
+  }
+  size_t nameLen;
+  const char *name = RedisModule_StringPtrLen(argv[1], &nameLen);
+  RedisModuleString *dk = deltaKey(name, nameLen, argv[2]);
+  dictEntry *entry = dictFind(deltaKeys, dk);
+  RedisModuleString *delta = RedisModule_HoldString(RSDummyContext, argv[3]);
+  if (entry) {
+    // The key was written again since, so the last delta is the one of its content
+    RedisModule_FreeString(RSDummyContext, deltas[entry->v.u64]);
+    deltas[entry->v.u64] = delta;
+  } else {
+    array_append(deltas, delta);
+    entry = dictAddRaw(deltaKeys, dk, NULL);
+    entry->v.u64 = array_len(deltas) - 1;
+  }
+  RedisModule_FreeString(RSDummyContext, dk);
+  return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
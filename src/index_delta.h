@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "redismodule.h"
+#include "document.h"
+#include "spec.h"
+#include "buffer/buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Index deltas: with _INDEX_DELTA_REPLICATION, a primary replicates the forward index of each
+ * document it indexes on a write, i.e. the terms it found in the text fields of the document with
+ * their frequencies, fields and offsets, as a _FT._INDEXDELTA command following the write. The
+ * replica reads the write in the same MULTI/EXEC as the delta, so it defers indexing the document
+ * to the end of it (see KeyspaceEvents_IndexPending()), and then writes the terms of the delta to
+ * its inverted indexes rather than tokenizing the fields again.
+ *
+ * A delta only stands for the content it was built from, which the digest of the document (see
+ * AddDocumentCtx_Digest()) it carries identifies. A replica whose document differs, or which got
+ * no delta for it, tokenizes the document as usual. The other fields are always indexed by the
+ * replica itself. */
+
+// Record the thread the write events are handled by, i.e. the main thread
+void IndexDelta_Init(void);
+
+// Serialize the forward index of the preprocessed document
+void IndexDelta_Write(const RSAddDocumentCtx *aCtx, Buffer *out);
+
+/* Fill the empty forward index of the document, and its byte offsets, from the delta. Returns
+ * false, leaving them empty, if the delta is not the one of the content of the document */
+bool IndexDelta_Read(RSAddDocumentCtx *aCtx, RedisModuleString *delta);
+
+/* Replicate the delta of the document just preprocessed by a write on a primary, if it has text
+ * fields and _INDEX_DELTA_REPLICATION is set */
+void IndexDelta_Replicate(RedisModuleCtx *ctx, const RSAddDocumentCtx *aCtx);
+
+// The delta received for the pending write of `key` to the index, if any
+RedisModuleString *IndexDelta_Find(const IndexSpec *spec, RedisModuleString *key);
+
+// Drop the deltas received, once their pending writes are indexed
+void IndexDelta_Clear(void);
+
+/* _FT._INDEXDELTA <index> <key> <delta>
+ * Keep the delta until the write of the key pending in the current MULTI/EXEC is indexed */
+int IndexDeltaCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,6 +12,7 @@
 #include "types_rs.h"
 #include "rmalloc.h"
 #include <math.h>
+#include <pthread.h>
 #include <sys/param.h>
 #include "src/util/arr.h"
 #include "value.h"
@@ -88,6 +89,49 @@ int RSIndexResult_HasOffsets(const RSIndexResult *res) {
 }
 
 #define __absdelta(x, y) (x > y ? x - y : y - x)
+
+/* Offsets of a result read by the distance calculation. The offsets of term results are decoded
+ * in place from their encoded vector, skipping the pooled offset iterator. Other results are
+ * read with an offset iterator. The cursor points to itself, so it must not be moved once
+ * initialized. */
+typedef struct {
+  Buffer buf;
+  BufferReader br;
+  uint32_t lastValue;
+  bool isTerm;
+  RSOffsetIterator it;
+} offsetsCursor;
+
+static inline void offsetsCursor_Init(offsetsCursor *c, const RSIndexResult *r) {
+  c->isTerm = r->data.tag == RSResultData_Term;
+  if (c->isTerm) {
+    uint32_t len;
+    const char *data = RSOffsetVector_GetData(IndexResult_TermOffsetsRef(r), &len);
+    c->buf = (Buffer){.data = (char *)data, .offset = len, .cap = len};
+    c->br = NewBufferReader(&c->buf);
+    c->lastValue = 0;
+  } else {
+    c->it = RSIndexResult_IterateOffsets(r);
+  }
+}
+
+static inline uint32_t offsetsCursor_Next(offsetsCursor *c) {
+  if (!c->isTerm) {
+    return c->it.Next(c->it.ctx, NULL);
+  }
+  if (BufferReader_AtEnd(&c->br)) {
+    return RS_OFFSETVECTOR_EOF;
+  }
+  c->lastValue += ReadVarint(&c->br);
+  return c->lastValue;
+}
+
+static inline void offsetsCursor_Free(offsetsCursor *c) {
+  if (!c->isTerm) {
+    c->it.Free(c->it.ctx);
+  }
+}
+
 /**
 Find the minimal distance between members of the vectos.
 e.g. if V1 is {2,4,8} and V2 is {0,5,12}, the distance is 1 - abs(4-5)
@@ -106,7 +150,7 @@ int IndexResult_MinOffsetDelta(const RSIndexResult *r) {
     return 1;
   }
 
-  RSOffsetIterator v1, v2;
+  offsetsCursor v1, v2;
   int i = 0;
   while (i < num) {
     // if either
@@ -115,7 +159,7 @@ int IndexResult_MinOffsetDelta(const RSIndexResult *r) {
       continue;
     }
     if (i == num) break;
-    v1 = RSIndexResult_IterateOffsets(AggregateResult_GetUnchecked(agg, i));
+    const RSIndexResult *r1 = AggregateResult_GetUnchecked(agg, i);
     i++;
 
     while (i < num && !RSIndexResult_HasOffsets(AggregateResult_GetUnchecked(agg, i))) {
@@ -123,25 +167,25 @@ int IndexResult_MinOffsetDelta(const RSIndexResult *r) {
       continue;
     }
     if (i == num) {
-      v1.Free(v1.ctx);
       break;
     }
-    v2 = RSIndexResult_IterateOffsets(AggregateResult_GetUnchecked(agg, i));
+    offsetsCursor_Init(&v1, r1);
+    offsetsCursor_Init(&v2, AggregateResult_GetUnchecked(agg, i));
 
-    uint32_t p1 = v1.Next(v1.ctx, NULL);
-    uint32_t p2 = v2.Next(v2.ctx, NULL);
+    uint32_t p1 = offsetsCursor_Next(&v1);
+    uint32_t p2 = offsetsCursor_Next(&v2);
     int cd = __absdelta(p2, p1);
     while (cd > 1 && p1 != RS_OFFSETVECTOR_EOF && p2 != RS_OFFSETVECTOR_EOF) {
       cd = MIN(__absdelta(p2, p1), cd);
       if (p2 > p1) {
-        p1 = v1.Next(v1.ctx, NULL);
+        p1 = offsetsCursor_Next(&v1);
       } else {
-        p2 = v2.Next(v2.ctx, NULL);
+        p2 = offsetsCursor_Next(&v2);
       }
     }
 
-    v1.Free(v1.ctx);
-    v2.Free(v2.ctx);
+    offsetsCursor_Free(&v1);
+    offsetsCursor_Free(&v2);
 
     dist += cd * cd;
   }
@@ -189,7 +233,34 @@ size_t IndexResult_GetMatchedTerms(const RSIndexResult *r, RSQueryTerm **arr, si
   return arrlen;
 }
 
-int __indexResult_withinRangeInOrder(RSOffsetIterator *iters, uint32_t *positions, int num,
+/* The decoded offsets of a child of a result checked for range, and the position of the next one
+ * to read */
+typedef struct {
+  const uint32_t *data;
+  uint32_t len;
+  uint32_t pos;
+} decodedOffsets;
+
+static inline uint32_t decodedOffsets_Next(decodedOffsets *o) {
+  return o->pos < o->len ? o->data[o->pos++] : RS_OFFSETVECTOR_EOF;
+}
+
+/* Read the first offset which is not below `min`, by a binary search of the unread ones */
+static inline uint32_t decodedOffsets_SkipTo(decodedOffsets *o, uint32_t min) {
+  uint32_t lo = o->pos, hi = o->len;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (o->data[mid] < min) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  o->pos = lo;
+  return decodedOffsets_Next(o);
+}
+
+int __indexResult_withinRangeInOrder(decodedOffsets *offsets, uint32_t *positions, int num,
                                      int maxSlop) {
   while (1) {
 
@@ -198,12 +269,12 @@ int __indexResult_withinRangeInOrder(RSOffsetIterator *iters, uint32_t *position
     for (int i = 0; i < num; i++) {
       // take the current position and the position of the previous iterator.
       // For the first iterator we always advance once
-      uint32_t pos = i ? positions[i] : iters[i].Next(iters[i].ctx, NULL);
+      uint32_t pos = i ? positions[i] : decodedOffsets_Next(&offsets[i]);
       uint32_t lastPos = i ? positions[i - 1] : 0;
 
-      // read while we are not in order
-      while (pos != RS_OFFSETVECTOR_EOF && pos < lastPos) {
-        pos = iters[i].Next(iters[i].ctx, NULL);
+      // skip to the first position which is in order
+      if (pos < lastPos) {
+        pos = decodedOffsets_SkipTo(&offsets[i], lastPos);
       }
 
       // we've read through the entire list and it's not in order relative to the last pos
@@ -256,10 +327,10 @@ static inline uint32_t _arrayMax(uint32_t *arr, int len, uint32_t *pos) {
 
 /* Check the index result for maximal slop, in an unordered fashion.
  * The algorithm is simple - we find the first offsets min and max such that max-min<=maxSlop */
-int __indexResult_withinRangeUnordered(RSOffsetIterator *iters, uint32_t *positions, int num,
+int __indexResult_withinRangeUnordered(decodedOffsets *offsets, uint32_t *positions, int num,
                                        int maxSlop) {
   for (int i = 0; i < num; i++) {
-    positions[i] = iters[i].Next(iters[i].ctx, NULL);
+    positions[i] = decodedOffsets_Next(&offsets[i]);
   }
   uint32_t minPos, maxPos, min, max;
   // find the max member
@@ -279,7 +350,7 @@ int __indexResult_withinRangeUnordered(RSOffsetIterator *iters, uint32_t *positi
     }
 
     // if we are not meeting the conditions - advance the minimal iterator
-    positions[minPos] = iters[minPos].Next(iters[minPos].ctx, NULL);
+    positions[minPos] = decodedOffsets_Next(&offsets[minPos]);
     // If the minimal iterator is larger than the max iterator, the minimal iterator is the new
     // maximal iterator.
     if (positions[minPos] != RS_OFFSETVECTOR_EOF && positions[minPos] > max) {
@@ -295,6 +366,55 @@ int __indexResult_withinRangeUnordered(RSOffsetIterator *iters, uint32_t *positi
   return 0;
 }
 
+/* Whether the offsets are too far apart for any match, from the first and last offset of each
+ * child alone. A match takes an offset of each child, so it ends at or after the first offset of
+ * its last term, and starts at or before the last offset of its first one */
+static bool withinRange_CannotMatch(const decodedOffsets *offsets, int num, int maxSlop,
+                                    int inOrder) {
+  uint32_t maxFirst = 0, minLast = RS_OFFSETVECTOR_EOF;
+  for (int i = 0; i < num; i++) {
+    if (!offsets[i].len) {
+      // Left to the checks, which handle the empty vectors
+      return false;
+    }
+    maxFirst = MAX(maxFirst, offsets[i].data[0]);
+    minLast = MIN(minLast, offsets[i].data[offsets[i].len - 1]);
+  }
+  if (inOrder) {
+    maxFirst = offsets[num - 1].data[0];
+    minLast = offsets[0].data[offsets[0].len - 1];
+  }
+  return (int64_t)maxFirst - (int64_t)minLast - (num - 1) > maxSlop;
+}
+
+/* The buffer the offsets of the children are decoded to, per thread. It grows to the largest
+ * offsets the thread checked */
+typedef struct {
+  uint32_t *data;
+  size_t cap;
+} offsetsBuffer;
+
+static pthread_key_t offsetsBufferKey;
+
+static void offsetsBuffer_Free(void *p) {
+  offsetsBuffer *buf = p;
+  rm_free(buf->data);
+  rm_free(buf);
+}
+
+static void __attribute__((constructor)) initOffsetsBufferKey() {
+  pthread_key_create(&offsetsBufferKey, offsetsBuffer_Free);
+}
+
+static offsetsBuffer *getOffsetsBuffer() {
+  offsetsBuffer *buf = pthread_getspecific(offsetsBufferKey);
+  if (!buf) {
+    buf = rm_calloc(1, sizeof(*buf));
+    pthread_setspecific(offsetsBufferKey, buf);
+  }
+  return buf;
+}
+
 /** Test the result offset vectors to see if they fall within a max "slop" or distance between the
  * terms. That is the total number of non matched offsets between the terms is no bigger than
  * maxSlop.
@@ -311,35 +431,48 @@ int IndexResult_IsWithinRange(RSIndexResult *ir, int maxSlop, int inOrder) {
       return 1;
   }
 
-  // Fill a list of iterators and the last read positions
-  RSOffsetIterator iters[num];
+  // Decode the offsets of the children, and keep the last read positions
+  decodedOffsets offsets[num];
+  size_t starts[num];
   uint32_t positions[num];
+  offsetsBuffer *buf = getOffsetsBuffer();
+  size_t used = 0;
   int n = 0;
 
   AggregateRecordsSlice children = AggregateResult_GetRecordsSlice(agg);
   for (int i = 0; i < children.len; i++) {
     const RSIndexResult *child = children.ptr[i];
-    // collect only iterators for nodes that can have offsets
-    if (RSIndexResult_HasOffsets(child)) {
-      iters[n] = RSIndexResult_IterateOffsets(child);
-      positions[n] = 0;
-      n++;
+    // collect only the offsets of nodes that can have offsets
+    if (!RSIndexResult_HasOffsets(child)) {
+      continue;
+    }
+    size_t len = RSIndexResult_DecodeOffsets(child, buf->data + used, buf->cap - used);
+    if (used + len > buf->cap) {
+      buf->cap = MAX(buf->cap * 2, used + len);
+      buf->data = rm_realloc(buf->data, buf->cap * sizeof(*buf->data));
+      RSIndexResult_DecodeOffsets(child, buf->data + used, len);
     }
+    starts[n] = used;
+    offsets[n] = (decodedOffsets){.len = len, .pos = 0};
+    positions[n] = 0;
+    used += len;
+    n++;
   }
 
   // No applicable offset children - just return 1
   if (n == 0) {
     return 1;
   }
+  for (int i = 0; i < n; i++) {
+    offsets[i].data = buf->data + starts[i];
+  }
 
-  int rc;
+  if (withinRange_CannotMatch(offsets, n, maxSlop, inOrder)) {
+    return 0;
+  }
   // cal the relevant algorithm based on ordered/unordered condition
   if (inOrder)
-    rc = __indexResult_withinRangeInOrder(iters, positions, n, maxSlop);
+    return __indexResult_withinRangeInOrder(offsets, positions, n, maxSlop);
   else
-    rc = __indexResult_withinRangeUnordered(iters, positions, n, maxSlop);
-  for (int i = 0; i < n; i++) {
-    iters[i].Free(iters[i].ctx);
-  }
-  return rc;
+    return __indexResult_withinRangeUnordered(offsets, positions, n, maxSlop);
 }
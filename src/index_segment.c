@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "index_segment.h"
+#include "config.h"
+#include "module.h"
+#include "rdb.h"
+#include "rmalloc.h"
+#include "rmutil/rm_assert.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SEGMENT_MAGIC "RSSEG001"
+#define SEGMENT_END_MAGIC "RSSEGEND"
+// The blocks are aligned as the heap would align them, as some are read by words
+#define SEGMENT_ALIGN 8
+#define SEGMENT_NAME_LEN 64
+
+typedef struct {
+  char magic[8];
+  uint64_t id;
+} SegmentHeader;
+
+typedef struct {
+  char magic[8];
+  uint64_t id;
+  uint64_t size;  // The offset of the trailer, where the blocks end
+} SegmentTrailer;
+
+// The segment being read, mapped while the RDB which refers to it is loaded
+static struct {
+  const char *base;
+  size_t mapSize;
+  size_t size;  // The offset of its trailer, where the blocks end
+} reading;
+static size_t numMissing = 0;
+
+static struct {
+  FILE *fp;
+  char name[SEGMENT_NAME_LEN];
+  uint64_t id;
+  uint64_t pos;
+  bool failed;
+} writer;
+
+// Written by the main thread only, and inherited by the fork of a snapshot
+static struct {
+  bool armed;
+  uint64_t counter;
+  char pending[SEGMENT_NAME_LEN];  // The segment of the snapshot in progress
+  uint64_t pendingId;
+  char current[SEGMENT_NAME_LEN];  // The segment of the last RDB saved or loaded
+} snapshots;
+
+void IndexSegment_OnSnapshotStart(void) {
+  snapshots.pendingId = ((uint64_t)time(NULL) << 32) ^ ((uint64_t)getpid() << 16) ^
+                        ++snapshots.counter;
+  snprintf(snapshots.pending, sizeof(snapshots.pending), "redisearch-%016" PRIx64 ".seg",
+           snapshots.pendingId);
+  snapshots.armed = true;
+}
+
+void IndexSegment_OnSnapshotEnd(bool saved) {
+  if (!snapshots.armed) {
+    return;
+  }
+  snapshots.armed = false;
+  if (!saved) {
+    // The snapshot may have written some of its segment
+    unlink(snapshots.pending);
+    return;
+  }
+  // A mapped segment stays readable once deleted
+  if (*snapshots.current && strcmp(snapshots.current, snapshots.pending)) {
+    unlink(snapshots.current);
+  }
+  memcpy(snapshots.current, snapshots.pending, sizeof(snapshots.current));
+}
+
+static void writeBytes(const void *data, size_t len) {
+  if (len && fwrite(data, 1, len, writer.fp) != len) {
+    writer.failed = true;
+  }
+  writer.pos += len;
+}
+
+bool IndexSegment_BeginWrite(const char *name, uint64_t id) {
+  RS_ASSERT(!writer.fp);
+  writer.fp = fopen(name, "wb");
+  if (!writer.fp) {
+    RedisModule_Log(RSDummyContext, "warning", "Could not create the index segment %s: %s", name,
+                    strerror(errno));
+    return false;
+  }
+  snprintf(writer.name, sizeof(writer.name), "%s", name);
+  writer.id = id;
+  writer.pos = 0;
+  writer.failed = false;
+  SegmentHeader hdr = {.id = id};
+  memcpy(hdr.magic, SEGMENT_MAGIC, sizeof(hdr.magic));
+  writeBytes(&hdr, sizeof(hdr));
+  return true;
+}
+
+bool IndexSegment_Write(const void *data, size_t len, uint64_t *offset) {
+  if (!writer.fp) {
+    return false;
+  }
+  static const char padding[SEGMENT_ALIGN] = {0};
+  writeBytes(padding, (SEGMENT_ALIGN - writer.pos % SEGMENT_ALIGN) % SEGMENT_ALIGN);
+  *offset = writer.pos;
+  writeBytes(data, len);
+  return true;
+}
+
+bool IndexSegment_EndWrite(void) {
+  if (!writer.fp) {
+    return false;
+  }
+  // A segment is only read once its trailer is written
+  SegmentTrailer trailer = {.id = writer.id, .size = writer.pos};
+  memcpy(trailer.magic, SEGMENT_END_MAGIC, sizeof(trailer.magic));
+  writeBytes(&trailer, sizeof(trailer));
+  if (fflush(writer.fp) || fsync(fileno(writer.fp))) {
+    writer.failed = true;
+  }
+  fclose(writer.fp);
+  writer.fp = NULL;
+  if (writer.failed) {
+    // Its blocks are lost, and the indexes of the RDB are built again as it is loaded
+    RedisModule_Log(RSDummyContext, "warning", "Could not write the index segment %s", writer.name);
+    unlink(writer.name);
+    return false;
+  }
+  return true;
+}
+
+bool IndexSegment_BeginRead(const char *name, uint64_t id) {
+  IndexSegment_EndRead();
+  const int fd = open(name, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  void *base = MAP_FAILED;
+  if (!fstat(fd, &st) && st.st_size >= (off_t)(sizeof(SegmentHeader) + sizeof(SegmentTrailer))) {
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  // The mapping holds the file
+  close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+
+  SegmentHeader hdr;
+  SegmentTrailer trailer;
+  memcpy(&hdr, base, sizeof(hdr));
+  memcpy(&trailer, (const char *)base + st.st_size - sizeof(trailer), sizeof(trailer));
+  if (memcmp(hdr.magic, SEGMENT_MAGIC, sizeof(hdr.magic)) ||
+      memcmp(trailer.magic, SEGMENT_END_MAGIC, sizeof(trailer.magic)) || hdr.id != id ||
+      trailer.id != id || trailer.size != (uint64_t)st.st_size - sizeof(trailer)) {
+    munmap(base, st.st_size);
+    return false;
+  }
+
+  reading.base = base;
+  reading.mapSize = st.st_size;
+  reading.size = trailer.size;
+  // The blocks are copied from the mapping as they are loaded, and read sequentially
+  madvise(base, st.st_size, MADV_SEQUENTIAL);
+  return true;
+}
+
+const char *IndexSegment_Resolve(uint64_t offset, size_t len) {
+  if (!reading.base || offset < sizeof(SegmentHeader) || offset > reading.size ||
+      len > reading.size - offset) {
+    numMissing++;
+    return NULL;
+  }
+  return reading.base + offset;
+}
+
+void IndexSegment_EndRead(void) {
+  if (reading.base) {
+    munmap((void *)reading.base, reading.mapSize);
+    reading.base = NULL;
+  }
+}
+
+size_t IndexSegment_NumMissing(void) {
+  return numMissing;
+}
+
+void IndexSegment_RdbSaveBegin(RedisModuleIO *rdb) {
+  const bool write = snapshots.armed && RSGlobalConfig.indexSegments &&
+                     RSGlobalConfig.persistIndexes &&
+                     IndexSegment_BeginWrite(snapshots.pending, snapshots.pendingId);
+  const char *name = write ? snapshots.pending : "";
+  RedisModule_SaveStringBuffer(rdb, name, strlen(name));
+  RedisModule_SaveUnsigned(rdb, write ? snapshots.pendingId : 0);
+}
+
+void IndexSegment_RdbSaveEnd(void) {
+  if (writer.fp) {
+    IndexSegment_EndWrite();
+  }
+}
+
+int IndexSegment_RdbLoadBegin(RedisModuleIO *rdb) {
+  IndexSegment_EndRead();
+  size_t len;
+  char *buf = LoadStringBuffer_IOError(rdb, &len, return REDISMODULE_ERR);
+  const uint64_t id = LoadUnsigned_IOError(rdb, RedisModule_Free(buf); return REDISMODULE_ERR);
+  char name[SEGMENT_NAME_LEN];
+  // Only the segments next to the RDB are read
+  const bool valid = len < sizeof(name) && !memchr(buf, '/', len);
+  if (valid) {
+    memcpy(name, buf, len);
+    name[len] = '\0';
+  }
+  RedisModule_Free(buf);
+
+  if (!len) {
+    return REDISMODULE_OK;
+  }
+  if (valid && IndexSegment_BeginRead(name, id)) {
+    // Deleted by the next snapshot, as the RDB refers to it until then
+    memcpy(snapshots.current, name, sizeof(snapshots.current));
+  } else {
+    RedisModule_Log(RSDummyContext, "warning",
+                    "Could not map the index segment of the RDB, its indexes are built again");
+  }
+  return REDISMODULE_OK;
+}
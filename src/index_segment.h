@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "redismodule.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Immutable segments of the blocks of the inverted indexes persisted with the RDB (see
+ * _PERSIST_INDEXES), enabled by _INDEX_SEGMENTS.
+ *
+ * A snapshot writes the sealed blocks of the indexes to a segment file of its own, next to the RDB
+ * which refers to it, rather than to the RDB itself, which only holds their offsets. Loading the
+ * RDB maps the segment read-only while it is loaded, and the blocks are copied from the mapping, as
+ * the blocks of the Rust inverted index own their buffer: they are not parsed out of the RDB stream,
+ * and the RDB of a snapshot stays small. The last block of every index is always in the RDB.
+ *
+ * A segment file is named by the snapshot that writes it, and the one of the previous snapshot is
+ * deleted once the next one is saved. When the segment of an RDB can't be mapped, e.g. on a replica
+ * which loaded the RDB of its master, the contents of the indexes are dropped as they are loaded,
+ * and their documents are indexed again.
+ */
+
+/* Arm or disarm the snapshots, from the persistence events of the server. A snapshot only writes a
+ * segment when it was armed as it started */
+void IndexSegment_OnSnapshotStart(void);
+void IndexSegment_OnSnapshotEnd(bool saved);
+
+/* Create the segment `name`, to which the blocks saved from now on are written. Returns false if it
+ * could not be created */
+bool IndexSegment_BeginWrite(const char *name, uint64_t id);
+/* Write `len` bytes to the segment being written, returning their offset in `offset`. Returns false
+ * if no segment is being written */
+bool IndexSegment_Write(const void *data, size_t len, uint64_t *offset);
+/* Complete the segment being written. Returns false if it could not be written in full */
+bool IndexSegment_EndWrite(void);
+
+/* Map the segment `name`, from which the blocks loaded from now on are read until
+ * IndexSegment_EndRead() unmaps it. Returns false if it is missing, or is not the segment `id` */
+bool IndexSegment_BeginRead(const char *name, uint64_t id);
+/* The `len` bytes at `offset` of the segment being read, or NULL if no segment is being read or they
+ * are out of its bounds, which is counted by IndexSegment_NumMissing() */
+const char *IndexSegment_Resolve(uint64_t offset, size_t len);
+void IndexSegment_EndRead(void);
+/* The number of blocks which could not be resolved since the process started */
+size_t IndexSegment_NumMissing(void);
+
+/* Save the reference of the RDB to its segment, and start writing it if the snapshot was armed */
+void IndexSegment_RdbSaveBegin(RedisModuleIO *rdb);
+void IndexSegment_RdbSaveEnd(void);
+/* Load the reference of the RDB to its segment, and map it */
+int IndexSegment_RdbLoadBegin(RedisModuleIO *rdb);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,6 +14,9 @@
 #include "vector_index.h"
 #include "redis_index.h"
 #include "suffix.h"
+#include "prefix_cache.h"
+#include "term_index_cache.h"
+#include "impact_postings.h"
 #include "config.h"
 #include "rmutil/rm_assert.h"
 #include "phonetic_manager.h"
@@ -43,6 +46,8 @@ static void writeIndexEntry(IndexSpec *spec, InvertedIndex *idx, ForwardIndexEnt
     spec->stats.offsetVecsSize += VVW_GetByteLength(entry->vw);
     spec->stats.offsetVecRecords += VVW_GetCount(entry->vw);
   }
+
+  ImpactPostings_Write(spec, idx, entry);
 }
 
 // Number of terms for each block-allocator block
@@ -85,6 +90,37 @@ static size_t countMerged(mergedEntry *ent) {
   return n;
 }
 
+// Adds a term of fields with suffixes to the suffix trie or array of the spec
+static void addSuffixTerm(IndexSpec *spec, const char *term, size_t len, t_fieldMask fieldMask) {
+  if (spec->suffixMask & fieldMask
+      && term[0] != STEM_PREFIX
+      && term[0] != PHONETIC_PREFIX
+      && term[0] != SYNONYM_PREFIX_CHAR
+      && strlen(term) != 0) {
+    if (spec->suffixArray) {
+      SuffixArray_Add(spec->suffixArray, term, len);
+    } else {
+      addSuffixTrie(spec->suffix, term, len);
+    }
+  }
+}
+
+// Opens the inverted index of a term for writing, through the cache of the recently indexed terms
+static InvertedIndex *openTermIndex(RedisSearchCtx *ctx, const ForwardIndexEntry *entry,
+                                    bool *isNew) {
+  TermIndexCache *cache = ctx->spec->termIndexes;
+  InvertedIndex *invidx = TermIndexCache_Get(cache, entry->term, entry->len, entry->hash);
+  if (invidx) {
+    *isNew = false;
+    return invidx;
+  }
+  invidx = Redis_OpenInvertedIndex(ctx, entry->term, entry->len, 1, isNew);
+  if (invidx) {
+    TermIndexCache_Put(cache, entry->term, entry->len, entry->hash, invidx);
+  }
+  return invidx;
+}
+
 /**
  * Simple implementation, writes all the entries for a single document. This
  * function is used when there is only one item in the queue. In this case
@@ -98,14 +134,20 @@ static void writeCurEntries(RSAddDocumentCtx *aCtx, RedisSearchCtx *ctx) {
   ForwardIndexIterator it = ForwardIndex_Iterate(aCtx->fwIdx);
   ForwardIndexEntry *entry = ForwardIndexIterator_Next(&it);
 
+  // The terms of a disk index are written at once, in a single batch per document
+  DiskTermEntry *diskEntries = NULL;
+  size_t numDiskEntries = 0;
+  if (spec->diskSpec) {
+    diskEntries = rm_malloc(aCtx->fwIdx->hits->numItems * sizeof(*diskEntries));
+  }
+
   while (entry != NULL) {
-    bool isNew;
     if (spec->diskSpec) {
-      SearchDisk_IndexDocument(spec->diskSpec, entry->term, aCtx->doc->docId, entry->fieldMask);
-      // assume all terms are new, avoid the disk io to check
-      isNew = true;
+      diskEntries[numDiskEntries++] = (DiskTermEntry){
+        .term = entry->term, .len = entry->len, .fieldMask = entry->fieldMask, .freq = entry->freq};
     } else {
-      InvertedIndex *invidx = Redis_OpenInvertedIndex(ctx, entry->term, entry->len, 1, &isNew);
+      bool isNew;
+      InvertedIndex *invidx = openTermIndex(ctx, entry, &isNew);
       if (isNew && strlen(entry->term) != 0) {
         IndexSpec_AddTerm(spec, entry->term, entry->len);
       }
@@ -113,19 +155,99 @@ static void writeCurEntries(RSAddDocumentCtx *aCtx, RedisSearchCtx *ctx) {
         entry->docId = aCtx->doc->docId;
         RS_LOG_ASSERT(entry->docId, "docId should not be 0");
         writeIndexEntry(spec, invidx, entry);
+        PrefixCache_InvalidateTerm(spec->prefixCache, entry->term, entry->len);
       }
     }
 
-    if (spec->suffixMask & entry->fieldMask
-        && entry->term[0] != STEM_PREFIX
-        && entry->term[0] != PHONETIC_PREFIX
-        && entry->term[0] != SYNONYM_PREFIX_CHAR
-        && strlen(entry->term) != 0) {
-      addSuffixTrie(spec->suffix, entry->term, entry->len);
-    }
+    addSuffixTerm(spec, entry->term, entry->len, entry->fieldMask);
 
     entry = ForwardIndexIterator_Next(&it);
   }
+
+  if (diskEntries) {
+    SearchDisk_IndexDocuments(spec->diskSpec, aCtx->doc->docId, diskEntries, numDiskEntries);
+    rm_free(diskEntries);
+  }
+}
+
+/**
+ * Writes the entries of all the documents of the chain, term by term. The entries of each term are
+ * linked in the order of the documents, so that its inverted index is opened once for the whole
+ * chain, and receives its entries as a single run of increasing ids.
+ */
+static void writeMergedEntries(RSAddDocumentCtx *aCtx, RedisSearchCtx *ctx) {
+  IndexSpec *spec = ctx->spec;
+  static const KHTableProcs procs = {
+      .Compare = mergedCompare, .Hash = mergedHash, .Alloc = mergedAlloc};
+  BlkAlloc alloc;
+  BlkAlloc_Init(&alloc);
+  KHTable ht;
+  KHTable_Init(&ht, &procs, &alloc, aCtx->fwIdx ? aCtx->fwIdx->hits->numItems : 0);
+
+  for (RSAddDocumentCtx *cur = aCtx; cur; cur = cur->next) {
+    if (!cur->fwIdx || (cur->stateFlags & ACTX_F_ERRORED)) {
+      continue;
+    }
+    ForwardIndexIterator it = ForwardIndex_Iterate(cur->fwIdx);
+    for (ForwardIndexEntry *entry; (entry = ForwardIndexIterator_Next(&it));) {
+      entry->docId = cur->doc->docId;
+      RS_LOG_ASSERT(entry->docId, "docId should not be 0");
+      entry->next = NULL;
+      int isNew = 0;
+      mergedEntry *merged =
+          (mergedEntry *)KHTable_GetEntry(&ht, entry->term, entry->len, entry->hash, &isNew);
+      if (isNew) {
+        merged->head = merged->tail = entry;
+      } else {
+        merged->tail->next = entry;
+        merged->tail = entry;
+      }
+    }
+  }
+
+  KHTableIterator iter;
+  KHTableIter_Init(&ht, &iter);
+  for (KHTableEntry *kp; (kp = KHtableIter_Next(&iter));) {
+    ForwardIndexEntry *head = ((mergedEntry *)kp)->head;
+    bool isNew;
+    InvertedIndex *invidx = openTermIndex(ctx, head, &isNew);
+    if (isNew && strlen(head->term) != 0) {
+      IndexSpec_AddTerm(spec, head->term, head->len);
+    }
+    t_fieldMask fieldMask = 0;
+    for (ForwardIndexEntry *entry = head; entry; entry = entry->next) {
+      if (invidx) {
+        writeIndexEntry(spec, invidx, entry);
+      }
+      fieldMask |= entry->fieldMask;
+    }
+    if (invidx) {
+      PrefixCache_InvalidateTerm(spec->prefixCache, head->term, head->len);
+    }
+    addSuffixTerm(spec, head->term, head->len, fieldMask);
+  }
+
+  KHTable_Free(&ht);
+  BlkAlloc_FreeAll(&alloc, NULL, NULL, 0);
+}
+
+// Removes the vectors and shapes of a document, whose indexes are keyed by the document id
+static void removeInPlaceEntries(IndexSpec *spec, t_docId docId) {
+  if (spec->flags & Index_HasVecSim) {
+    for (int i = 0; i < spec->numFields; ++i) {
+      if (spec->fields[i].types == INDEXFLD_T_VECTOR) {
+        RedisModuleString *rmstr = IndexSpec_GetFormattedKey(spec, &spec->fields[i], INDEXFLD_T_VECTOR);
+        VecSimIndex *vecsim = openVectorIndex(spec, rmstr, DONT_CREATE_INDEX);
+        if(!vecsim)
+          continue;
+        VecSimIndex_DeleteVector(vecsim, docId);
+        // TODO: use VecSimReplace instead and if successful, do not insert and remove from doc
+      }
+    }
+  }
+  if (spec->flags & Index_HasGeometry) {
+    GeometryIndex_RemoveId(spec, docId);
+  }
 }
 
 /** Assigns a document ID to a single document. */
@@ -141,23 +263,9 @@ static RSDocumentMetadata *makeDocumentId(RedisModuleCtx *ctx, RSAddDocumentCtx
       DMD_Return(aCtx->oldMd);
       aCtx->oldMd = dmd;
       if (spec->gc) {
-        GCContext_OnDelete(spec->gc);
-      }
-      if (spec->flags & Index_HasVecSim) {
-        for (int i = 0; i < spec->numFields; ++i) {
-          if (spec->fields[i].types == INDEXFLD_T_VECTOR) {
-            RedisModuleString *rmstr = IndexSpec_GetFormattedKey(spec, &spec->fields[i], INDEXFLD_T_VECTOR);
-            VecSimIndex *vecsim = openVectorIndex(spec, rmstr, DONT_CREATE_INDEX);
-            if(!vecsim)
-              continue;
-            VecSimIndex_DeleteVector(vecsim, dmd->id);
-            // TODO: use VecSimReplace instead and if successful, do not insert and remove from doc
-          }
-        }
-      }
-      if (spec->flags & Index_HasGeometry) {
-        GeometryIndex_RemoveId(spec, dmd->id);
+        GCContext_OnDelete(spec->gc, dmd->id);
       }
+      removeInPlaceEntries(spec, dmd->id);
     }
   }
 
@@ -167,7 +275,10 @@ static RSDocumentMetadata *makeDocumentId(RedisModuleCtx *ctx, RSAddDocumentCtx
       DocTable_Put(table, s, n, doc->score, aCtx->docFlags, doc->payload, doc->payloadSize, doc->type);
   if (dmd) {
     doc->docId = dmd->id;
+    dmd->digest = aCtx->digest;
     ++spec->stats.numDocuments;
+    // The entries of the document are about to be written
+    ++spec->revision;
   }
 
   return dmd;
@@ -229,28 +340,44 @@ static void doAssignIds(RSAddDocumentCtx *cur, RedisSearchCtx *ctx) {
   }
 }
 
-static void indexBulkFields(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+static void bulkFieldFailed(RSAddDocumentCtx *cur, RedisSearchCtx *sctx, const FieldSpec *fs) {
+  const Document *doc = cur->doc;
+  IndexError_AddQueryError(&cur->spec->stats.indexError, &cur->status, doc->docKey);
+  FieldSpec_AddQueryError(&cur->spec->fields[fs->index], &cur->status, doc->docKey);
+  QueryError_ClearError(&cur->status);
+  cur->stateFlags |= ACTX_F_ERRORED;
+  // The document is indexed partly, so the same content is indexed again on its next update
+  if (!sctx->spec->diskSpec) {
+    RSDocumentMetadata *md = (RSDocumentMetadata *)DocTable_Borrow(&sctx->spec->docs, doc->docId);
+    if (md) {
+      md->digest = 0;
+      DMD_Return(md);
+    }
+  }
+}
+
+// The fields which are still being indexed by the scanner of the index are skipped, unless
+// `buildFields` is set, as the scanner writes them by ascending ids
+static void indexBulkFields(RSAddDocumentCtx *cur, RedisSearchCtx *sctx, bool buildFields) {
+  if (!cur->doc->docId || (cur->stateFlags & ACTX_F_ERRORED)) {
+    return;
+  }
+
   // Traverse all fields, seeing if there may be something which can be written!
-  for (RSAddDocumentCtx *cur = aCtx; cur && cur->doc->docId; cur = cur->next) {
-    if (cur->stateFlags & ACTX_F_ERRORED) {
+  const Document *doc = cur->doc;
+  for (size_t ii = 0; ii < doc->numFields; ++ii) {
+    const FieldSpec *fs = cur->fspecs + ii;
+    FieldIndexerData *fdata = cur->fdatas + ii;
+    if (fs->types == INDEXFLD_T_FULLTEXT || !FieldSpec_IsIndexable(fs) || fdata->isNull) {
       continue;
     }
-
-    const Document *doc = cur->doc;
-    for (size_t ii = 0; ii < doc->numFields; ++ii) {
-      const FieldSpec *fs = cur->fspecs + ii;
-      FieldIndexerData *fdata = cur->fdatas + ii;
-      if (fs->types == INDEXFLD_T_FULLTEXT || !FieldSpec_IsIndexable(fs) || fdata->isNull) {
-        continue;
-      }
-      if (IndexerBulkAdd(cur, sctx, doc->fields + ii, fs, fdata, &cur->status) != 0) {
-        IndexError_AddQueryError(&cur->spec->stats.indexError, &cur->status, doc->docKey);
-        FieldSpec_AddQueryError(&cur->spec->fields[fs->index], &cur->status, doc->docKey);
-        QueryError_ClearError(&cur->status);
-        cur->stateFlags |= ACTX_F_ERRORED;
-      }
-      cur->stateFlags |= ACTX_F_OTHERINDEXED;
+    if (!buildFields && IndexSpec_IsFieldBuilding(sctx->spec, fs->index)) {
+      continue;
     }
+    if (IndexerBulkAdd(cur, sctx, doc->fields + ii, fs, fdata, &cur->status) != 0) {
+      bulkFieldFailed(cur, sctx, fs);
+    }
+    cur->stateFlags |= ACTX_F_OTHERINDEXED;
   }
 }
 
@@ -336,6 +463,12 @@ static void writeExistingDocs(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
   aCtx->spec->stats.invertedSize += InvertedIndex_WriteEntryGeneric(sctx->spec->existingDocs, &rec);
 }
 
+static bool Indexer_NeedsProcessing(const RSAddDocumentCtx *aCtx) {
+  // A document which is complete or errored needs no further processing, unless it is empty
+  return !(ACTX_IS_INDEXED(aCtx) || aCtx->stateFlags & ACTX_F_ERRORED) ||
+         (aCtx->stateFlags & ACTX_F_EMPTY);
+}
+
 /**
  * Perform the processing chain on a single document entry, optionally merging
  * the tokens of further entries in the queue
@@ -344,11 +477,8 @@ static void Indexer_Process(RSAddDocumentCtx *aCtx) {
   RSAddDocumentCtx *firstZeroId = aCtx;
   RedisSearchCtx ctx = *aCtx->sctx;
 
-  if (ACTX_IS_INDEXED(aCtx) || aCtx->stateFlags & (ACTX_F_ERRORED)) {
-    // Document is complete or errored. No need for further processing.
-    if (!(aCtx->stateFlags & ACTX_F_EMPTY)) {
-      return;
-    }
+  if (!Indexer_NeedsProcessing(aCtx)) {
+    return;
   }
 
   if (!ctx.spec) {
@@ -390,7 +520,7 @@ static void Indexer_Process(RSAddDocumentCtx *aCtx) {
   }
 
   if (!(aCtx->stateFlags & ACTX_F_OTHERINDEXED)) {
-    indexBulkFields(aCtx, &ctx);
+    indexBulkFields(aCtx, &ctx, false);
   }
 }
 
@@ -400,6 +530,81 @@ int IndexDocument(RSAddDocumentCtx *aCtx) {
   return 0;
 }
 
+int IndexDocuments(RSAddDocumentCtx *aCtx) {
+  // The documents which need no processing are finished right away
+  RSAddDocumentCtx *chain = NULL, **tail = &chain;
+  for (RSAddDocumentCtx *cur = aCtx, *next; cur; cur = next) {
+    next = cur->next;
+    cur->next = NULL;
+    if (Indexer_NeedsProcessing(cur)) {
+      *tail = cur;
+      tail = &cur->next;
+    } else {
+      AddDocumentCtx_Finish(cur);
+    }
+  }
+  if (!chain) {
+    return 0;
+  }
+
+  RedisSearchCtx ctx = *chain->sctx;
+  doAssignIds(chain, &ctx);
+  for (RSAddDocumentCtx *cur = chain; cur; cur = cur->next) {
+    if (!(cur->stateFlags & ACTX_F_ERRORED)) {
+      writeExistingDocs(cur, &ctx);
+      writeMissingFieldDocs(cur, &ctx, cur->doc->fieldExpirations);
+    }
+  }
+
+  // Handle FULLTEXT indexes
+  if (ctx.spec->diskSpec) {
+    for (RSAddDocumentCtx *cur = chain; cur; cur = cur->next) {
+      if (cur->fwIdx && !(cur->stateFlags & ACTX_F_ERRORED)) {
+        writeCurEntries(cur, &ctx);
+      }
+    }
+  } else {
+    writeMergedEntries(chain, &ctx);
+  }
+
+  for (RSAddDocumentCtx *cur = chain, *next; cur; cur = next) {
+    next = cur->next;
+    // A key which is twice in the chain is replaced by its second document once the ids are
+    // assigned, and the vectors and shapes of the first one would not be removed anymore
+    if (!(cur->stateFlags & ACTX_F_OTHERINDEXED) &&
+        (ctx.spec->diskSpec || DocTable_Exists(&ctx.spec->docs, cur->doc->docId))) {
+      indexBulkFields(cur, &ctx, false);
+    }
+    AddDocumentCtx_Finish(cur);
+  }
+  return 0;
+}
+
+void IndexDocumentFields(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  RS_LOG_ASSERT(aCtx->doc->docId, "docId must be set");
+  if (!(aCtx->stateFlags & ACTX_F_OTHERINDEXED)) {
+    indexBulkFields(aCtx, sctx, true);
+  }
+}
+
+void IndexDocumentInPlace(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx) {
+  const Document *doc = aCtx->doc;
+  IndexSpec *spec = sctx->spec;
+  RS_LOG_ASSERT(doc->docId, "docId must be set");
+  removeInPlaceEntries(spec, doc->docId);
+  for (size_t ii = 0; ii < doc->numFields; ++ii) {
+    const FieldSpec *fs = aCtx->fspecs + ii;
+    FieldIndexerData *fdata = aCtx->fdatas + ii;
+    if (!(fs->types & DOCUMENT_IN_PLACE_TYPES) || !FieldSpec_IsIndexable(fs) || fdata->isNull) {
+      continue;
+    }
+    if (IndexerBulkAdd(aCtx, sctx, doc->fields + ii, fs, fdata, &aCtx->status) != 0) {
+      bulkFieldFailed(aCtx, sctx, fs);
+    }
+  }
+  aCtx->stateFlags |= ACTX_F_OTHERINDEXED;
+}
+
 bool g_isLoading = false;
 
 /**
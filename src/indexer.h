@@ -55,6 +55,27 @@ typedef struct FieldIndexerData {
  */
 int IndexDocument(RSAddDocumentCtx *aCtx);
 
+/**
+ * Index a chain of documents of the same spec, linked by the `next` of their contexts, and finish
+ * them. The entries of the terms of all the documents are merged, so that each inverted index
+ * receives the entries of the chain in a single run of increasing ids.
+ */
+int IndexDocuments(RSAddDocumentCtx *aCtx);
+
+/**
+ * Write the non-text fields of the document to their indexes, as `aCtx->doc->docId`, which is
+ * already in the index. The fields must have been preprocessed. Used to index the fields added to
+ * the schema for the existing documents
+ */
+void IndexDocumentFields(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx);
+
+/**
+ * Replace the values of the fields of DOCUMENT_IN_PLACE_TYPES of the document `aCtx->doc->docId`,
+ * which keeps its id. The other fields must be indexed with the same content already. The fields
+ * must have been preprocessed.
+ */
+void IndexDocumentInPlace(RSAddDocumentCtx *aCtx, RedisSearchCtx *sctx);
+
 /**
  * Function to preprocess field data. This should do as much stateless processing
  * as possible on the field - this means things like input validation and normalization.
@@ -195,6 +195,15 @@ VectorIndexStats IndexSpec_GetVectorIndexStats(IndexSpec *sp, const FieldSpec *f
   const VecSimIndexStatsInfo info = VecSimIndex_StatsInfo(vecsim);
   stats.memory += info.memory;
   stats.marked_deleted += info.numberOfMarkedDeleted;
+  const VectorQueryStats *queries = &fs->vectorOpts.queryStats;
+  stats.queries = (VectorQueryStats){
+      .queries = __atomic_load_n(&queries->queries, __ATOMIC_RELAXED),
+      .indexResults = __atomic_load_n(&queries->indexResults, __ATOMIC_RELAXED),
+      .distances = __atomic_load_n(&queries->distances, __ATOMIC_RELAXED),
+      .batches = __atomic_load_n(&queries->batches, __ATOMIC_RELAXED),
+      .adhocSwitches = __atomic_load_n(&queries->adhocSwitches, __ATOMIC_RELAXED),
+      .bytesRead = __atomic_load_n(&queries->bytesRead, __ATOMIC_RELAXED),
+  };
   return stats;
 }
 
@@ -205,8 +214,7 @@ VectorIndexStats IndexSpec_GetVectorIndexesStats(IndexSpec *sp) {
     const FieldSpec *fs = sp->fields + i;
     if (FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
       VectorIndexStats field_stats = IndexSpec_GetVectorIndexStats(sp, fs);
-      stats.memory += field_stats.memory;
-      stats.marked_deleted += field_stats.marked_deleted;
+      VectorIndexStats_Agg(&stats, &field_stats);
     }
   }
   return stats;
@@ -7,6 +7,7 @@
  * GNU Affero General Public License v3 (AGPLv3).
 */
 #include "global_stats.h"
+#include "latency_stats.h"
 #include "aggregate/aggregate.h"
 #include "util/units.h"
 #include "rs_wall_clock.h"
@@ -80,6 +81,11 @@ void TotalGlobalStats_CountQuery(uint32_t reqflags, rs_wall_clock_ns_t duration)
   // Implicit conversion from ns type to ms type, but it is the same type (uint64_t)
   INCR_BY(RSGlobalStats.totalStats.queries.total_query_execution_time, duration);
 
+  LatencyStats_CountQuery(reqflags & QEXEC_F_IS_HYBRID_TAIL ? LATENCY_QUERY_HYBRID :
+                          reqflags & QEXEC_F_IS_SEARCH      ? LATENCY_QUERY_SEARCH :
+                                                              LATENCY_QUERY_AGGREGATE,
+                          duration);
+
   if (!(QEXEC_F_IS_CURSOR & reqflags) || (QEXEC_F_IS_AGGREGATE & reqflags)) {
     // Count only unique queries, not iterations of a previous query (FT.CURSOR READ)
     INCR(RSGlobalStats.totalStats.queries.total_queries_processed);
@@ -94,6 +100,41 @@ QueriesGlobalStats TotalGlobalStats_GetQueryStats() {
   return stats;
 }
 
+void TotalGlobalStats_CountShardRequests(size_t sent) {
+  INCR_BY(RSGlobalStats.totalStats.coord.shard_requests, sent);
+}
+
+void TotalGlobalStats_CountHedgedRequest(void) {
+  INCR(RSGlobalStats.totalStats.coord.hedged_requests);
+}
+
+void TotalGlobalStats_CountHedgeWon(void) {
+  INCR(RSGlobalStats.totalStats.coord.hedged_requests_won);
+}
+
+void TotalGlobalStats_CountResultCacheLookup(bool hit) {
+  if (hit) {
+    INCR(RSGlobalStats.totalStats.coord.result_cache_hits);
+  } else {
+    INCR(RSGlobalStats.totalStats.coord.result_cache_misses);
+  }
+}
+
+void TotalGlobalStats_UpdateResultCacheBytes(ssize_t toAdd) {
+  INCR_BY(RSGlobalStats.totalStats.coord.result_cache_bytes, toAdd);
+}
+
+CoordGlobalStats TotalGlobalStats_GetCoordStats(void) {
+  CoordGlobalStats stats = {0};
+  stats.shard_requests = READ(RSGlobalStats.totalStats.coord.shard_requests);
+  stats.hedged_requests = READ(RSGlobalStats.totalStats.coord.hedged_requests);
+  stats.hedged_requests_won = READ(RSGlobalStats.totalStats.coord.hedged_requests_won);
+  stats.result_cache_hits = READ(RSGlobalStats.totalStats.coord.result_cache_hits);
+  stats.result_cache_misses = READ(RSGlobalStats.totalStats.coord.result_cache_misses);
+  stats.result_cache_bytes = READ(RSGlobalStats.totalStats.coord.result_cache_bytes);
+  return stats;
+}
+
 void IndexsGlobalStats_UpdateLogicallyDeleted(int64_t toAdd) {
     INCR_BY(RSGlobalStats.totalStats.logically_deleted, toAdd);
 }
@@ -45,8 +45,18 @@ typedef struct {
   rs_wall_clock_ns_t total_query_execution_time;   // Total time spent on queries, aggregated in ns and reported in ms
 } QueriesGlobalStats;
 
+typedef struct {
+  size_t shard_requests;          // Requests of the coordinator fanouts to the shards
+  size_t hedged_requests;         // Shard requests also sent to a replica of the shard, as they were slow
+  size_t hedged_requests_won;     // Hedged requests which the replica answered first
+  size_t result_cache_hits;       // FT.AGGREGATE queries which read the cached rows of the shards
+  size_t result_cache_misses;     // Cacheable FT.AGGREGATE queries which had to ask the shards
+  size_t result_cache_bytes;      // Memory of the rows in the result cache
+} CoordGlobalStats;
+
 typedef struct {
   QueriesGlobalStats queries;   // Queries statistics. values should be fetched by calling `TotalGlobalStats_GetQueryStats`, otherwise not safe.
+  CoordGlobalStats coord;       // Coordinator statistics, updated by the IO threads. Fetched by `TotalGlobalStats_GetCoordStats`
   uint_least8_t used_dialects;  // bitarray of dialects used by all indices
   size_t logically_deleted;     // Number of logically deleted documents in all indices
                                 // (i.e., marked with DELETED flag but their memory was not yet cleaned by the GC)
@@ -89,6 +99,25 @@ void TotalGlobalStats_CountQuery(uint32_t reqflags, rs_wall_clock_ns_t duration)
  */
 QueriesGlobalStats TotalGlobalStats_GetQueryStats();
 
+/**
+ * Count the requests a coordinator fanout sent to the shards, the ones of them which were hedged to
+ * a replica, and the hedged ones which the replica answered first.
+ */
+void TotalGlobalStats_CountShardRequests(size_t sent);
+void TotalGlobalStats_CountHedgedRequest(void);
+void TotalGlobalStats_CountHedgeWon(void);
+
+/**
+ * Count a lookup of the coordinator result cache, and the memory its entries take.
+ */
+void TotalGlobalStats_CountResultCacheLookup(bool hit);
+void TotalGlobalStats_UpdateResultCacheBytes(ssize_t toAdd);
+
+/**
+ * Safely reads and returns a copy of the global coordinator stats.
+ */
+CoordGlobalStats TotalGlobalStats_GetCoordStats(void);
+
 /**
  * Increase the number of logically deleted documents in all indices by `toAdd`.
  */
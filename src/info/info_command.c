@@ -10,9 +10,12 @@
 #include "inverted_index.h"
 #include "vector_index.h"
 #include "cursor.h"
+#include "search_cache.h"
+#include "snippet_cache.h"
 #include "resp3.h"
 #include "geometry/geometry_api.h"
 #include "geometry_index.h"
+#include "numeric_index.h"
 #include "redismodule.h"
 #include "module.h"
 #include "reply_macros.h"
@@ -101,6 +104,40 @@ static void renderIndexDefinitions(RedisModule_Reply *reply, const IndexSpec *sp
   RedisModule_Reply_MapEnd(reply); // index_definition
 }
 
+// The histograms of the numeric fields which hold values, as arrays of [lower, upper, count]
+// buckets. Nothing is replied if no numeric field holds values
+static void renderNumericHistograms(RedisModule_Reply *reply, IndexSpec *sp) {
+  bool opened = false;
+  for (int i = 0; i < sp->numFields; i++) {
+    const FieldSpec *fs = &sp->fields[i];
+    if (!FIELD_IS(fs, INDEXFLD_T_NUMERIC)) {
+      continue;
+    }
+    RedisModuleString *keyName = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_NUMERIC);
+    const NumericRangeTree *rt = openNumericKeysDict(sp, keyName, DONT_CREATE_INDEX);
+    if (!rt || !rt->histogram.numBuckets) {
+      continue;
+    }
+    if (!opened) {
+      REPLY_KVMAP("numeric_histograms"); // >numeric_histograms
+      opened = true;
+    }
+    const NumericHistogram *h = &rt->histogram;
+    REPLY_KVARRAY(HiddenString_GetUnsafe(fs->fieldName, NULL)); // >>field
+    for (uint32_t b = 0; b < h->numBuckets; b++) {
+      RedisModule_Reply_Array(reply);
+      RedisModule_Reply_Double(reply, h->bounds[b]);
+      RedisModule_Reply_Double(reply, h->bounds[b + 1]);
+      RedisModule_Reply_LongLong(reply, h->counts[b]);
+      RedisModule_Reply_ArrayEnd(reply);
+    }
+    REPLY_ARRAY_END; // >>field
+  }
+  if (opened) {
+    REPLY_MAP_END; // >numeric_histograms
+  }
+}
+
 void fillReplyWithIndexInfo(RedisSearchCtx* sctx, RedisModule_Reply *reply, bool obfuscate, bool withTimes) {
   const bool has_map = RedisModule_IsRESP3(reply);
 
@@ -225,6 +262,9 @@ void fillReplyWithIndexInfo(RedisSearchCtx* sctx, RedisModule_Reply *reply, bool
     if (FieldSpec_IsUnf(fs)) {
       RedisModule_Reply_SimpleString(reply, SPEC_UNF_STR);
     }
+    if (FieldSpec_IsStored(fs)) {
+      RedisModule_Reply_SimpleString(reply, SPEC_STORED_STR);
+    }
     if (FieldSpec_IsNoStem(fs)) {
       RedisModule_Reply_SimpleString(reply, SPEC_NOSTEM_STR);
     }
@@ -263,7 +303,7 @@ void fillReplyWithIndexInfo(RedisSearchCtx* sctx, RedisModule_Reply *reply, bool
   REPLY_KVNUM("doc_table_size_mb", sp->docs.memsize / (float)0x100000);
   REPLY_KVNUM("sortable_values_size_mb", sp->docs.sortablesSize / (float)0x100000);
 
-  size_t dt_tm_size = TrieMap_MemUsage(sp->docs.dim.tm);
+  size_t dt_tm_size = DocIdMap_MemUsage(&sp->docs.dim);
   REPLY_KVNUM("key_table_size_mb", dt_tm_size / (float)0x100000);
   size_t tags_overhead = IndexSpec_collect_tags_overhead(sp);
   REPLY_KVNUM("tag_overhead_sz_mb", tags_overhead / (float)0x100000);
@@ -284,11 +324,14 @@ void fillReplyWithIndexInfo(RedisSearchCtx* sctx, RedisModule_Reply *reply, bool
   // Legacy for not breaking changes
   REPLY_KVINT("hash_indexing_failures", sp->stats.indexError.error_count);
   REPLY_KVNUM("total_indexing_time", rs_wall_clock_convert_ns_to_ms_d(sp->stats.totalIndexTime));
-  REPLY_KVINT("indexing", !!global_spec_scanner || sp->scan_in_progress);
+  REPLY_KVINT("indexing", !!global_spec_scanner || sp->scan_in_progress ||
+                          sp->activation == IndexActivation_Queued);
 
   IndexesScanner *scanner = global_spec_scanner ? global_spec_scanner : sp->scanner;
   double percent_indexed = IndexesScanner_IndexedPercent(sctx->redisCtx, scanner, sp);
   REPLY_KVNUM("percent_indexed", percent_indexed);
+  // With _LAZY_INDEX_LOADING, not built yet as it was not used since it was loaded
+  REPLY_KVINT("cold", IndexSpec_IsCold(sp));
 
   REPLY_KVINT("number_of_uses", sp->counter);
 
@@ -300,8 +343,30 @@ void fillReplyWithIndexInfo(RedisSearchCtx* sctx, RedisModule_Reply *reply, bool
     RedisModule_Reply_MapEnd(reply);
   }
 
+  if (sp->flags & Index_HasVecSim) {
+    const VectorIndexingStats *vis = &sp->stats.vectorIndexing;
+    RedisModule_ReplyKV_Map(reply, "vector_indexing_stats");
+    REPLY_KVINT("pending_jobs", VectorIndexingStats_GetPending(vis));
+    REPLY_KVINT("completed_jobs", VectorIndexingStats_GetDone(vis));
+    REPLY_KVNUM("jobs_per_sec", VectorIndexingStats_GetThroughput(vis));
+    RedisModule_Reply_MapEnd(reply);
+  }
+
+  if (RSGlobalConfig.searchResultCacheBytes && sp->searchResults) {
+    SearchResultCache_ReplyStats(reply, sp->searchResults);
+  }
+
+  if (RSGlobalConfig.snippetCacheBytes && sp->snippets) {
+    SnippetCache_ReplyStats(reply, sp->snippets);
+  }
+
   Cursors_RenderStats(&g_CursorsList, &g_CursorsListCoord, sp, reply);
 
+  // The bounds of the buckets are values of the documents, which obfuscated replies hide
+  if (!obfuscate) {
+    renderNumericHistograms(reply, specForOpeningIndexes);
+  }
+
   // Unlock spec
   RedisSearchCtx_UnlockSpec(sctx);
 
@@ -28,6 +28,19 @@ static void FreeCursorNode(RedisModuleCtx* ctx, void *node) {
   rm_free(cursorNode);
 }
 
+// Stop the query of a client which disconnected, as no one is waiting for its reply
+static void CancelQueryOnDisconnect(RedisModuleCtx *ctx, RedisModuleBlockedClient *bc) {
+  BlockedQueryNode *queryNode = RedisModule_BlockClientGetPrivateData(bc);
+  if (queryNode) {
+    QueryCancelToken_Cancel(&queryNode->cancel);
+  }
+}
+
+const QueryCancelToken *BlockedQueryClient_CancelToken(RedisModuleBlockedClient *bc) {
+  BlockedQueryNode *queryNode = RedisModule_BlockClientGetPrivateData(bc);
+  return queryNode ? &queryNode->cancel : NULL;
+}
+
 RedisModuleBlockedClient *BlockQueryClient(RedisModuleCtx *ctx, StrongRef spec_ref, AREQ* req, int timeoutMS) {
   BlockedQueries *blockedQueries = MainThread_GetBlockedQueries();
   RS_LOG_ASSERT(blockedQueries, "MainThread_InitBlockedQueries was not called, or function not called from main thread");
@@ -39,6 +52,7 @@ RedisModuleBlockedClient *BlockQueryClient(RedisModuleCtx *ctx, StrongRef spec_r
   // found in buildRequest.
   RedisModuleBlockedClient *blockedClient = RedisModule_BlockClient(ctx, NULL, NULL, FreeQueryNode, 0);
   RedisModule_BlockClientSetPrivateData(blockedClient, node);
+  RedisModule_SetDisconnectCallback(blockedClient, CancelQueryOnDisconnect);
   // report block client start time
   RedisModule_BlockedClientMeasureTimeStart(blockedClient);
   return blockedClient;
@@ -9,6 +9,7 @@
 #pragma once
 #include "redismodule.h"
 #include "util/references.h"
+#include "util/timeout.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +20,9 @@ struct AREQ;
 struct Cursor;
 RedisModuleBlockedClient* BlockQueryClient(RedisModuleCtx *ctx, StrongRef spec, struct AREQ* req, int timeoutMS);
 RedisModuleBlockedClient* BlockCursorClient(RedisModuleCtx *ctx, Cursor* cursor, size_t count, int timeoutMS);
+// The token set when the client of a query blocked by `BlockQueryClient` disconnects. It lives until
+// the client is unblocked
+const QueryCancelToken *BlockedQueryClient_CancelToken(RedisModuleBlockedClient *bc);
 
 #ifdef __cplusplus
 }
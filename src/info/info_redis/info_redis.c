@@ -10,12 +10,20 @@
 #include "module.h"
 #include "version.h"
 #include "info/global_stats.h"
+#include "info/latency_stats.h"
+#include "info/profile_stats.h"
 #include "cursor.h"
+#include "stemmer.h"
 #include "info/indexes_info.h"
 #include "util/units.h"
 #include "info/info_redis/types/blocked_queries.h"
 #include "info/info_redis/threads/current_thread.h"
 #include "info/info_redis/threads/main_thread.h"
+#include "query_admission.h"
+#include "util/workers.h"
+#include "util/minmax.h"
+#include "util/cpu_dispatch.h"
+#include "coord/rmr/rmr.h"
 
 /* ========================== PROTOTYPES ============================ */
 // Fields statistics
@@ -30,6 +38,8 @@ static inline void AddToInfo_Queries(RedisModuleInfoCtx *ctx, TotalIndexesInfo *
 static inline void AddToInfo_ErrorsAndWarnings(RedisModuleInfoCtx *ctx, TotalIndexesInfo *total_info);
 static inline void AddToInfo_Dialects(RedisModuleInfoCtx *ctx);
 static inline void AddToInfo_RSConfig(RedisModuleInfoCtx *ctx);
+static inline void AddToInfo_WorkerThreads(RedisModuleInfoCtx *ctx);
+static inline void AddToInfo_CpuDispatch(RedisModuleInfoCtx *ctx);
 static inline void AddToInfo_BlockedQueries(RedisModuleInfoCtx *ctx);
 static inline void AddToInfo_CurrentThread(RedisModuleInfoCtx *ctx);
 /* ========================== MAIN FUNC ============================ */
@@ -71,6 +81,12 @@ void RS_moduleInfoFunc(RedisModuleInfoCtx *ctx, int for_crash_report) {
   // Query statistics
   AddToInfo_Queries(ctx, &total_info);
 
+  // Query latency distributions
+  LatencyStats_AddToInfo(ctx);
+
+  // Sampled profile of the queries
+  ProfileStats_AddToInfo(ctx);
+
   // Errors statistics
   AddToInfo_ErrorsAndWarnings(ctx, &total_info);
 
@@ -80,6 +96,15 @@ void RS_moduleInfoFunc(RedisModuleInfoCtx *ctx, int for_crash_report) {
   // Run time configuration
   AddToInfo_RSConfig(ctx);
 
+  // Worker threads
+  AddToInfo_WorkerThreads(ctx);
+
+  // Coordinator IO threads
+  MR_AddToInfo_IOThreads(ctx);
+
+  // SIMD kernels
+  AddToInfo_CpuDispatch(ctx);
+
   // Active operations
   if (for_crash_report) {
     AddToInfo_CurrentThread(ctx);
@@ -240,6 +265,32 @@ void AddToInfo_Queries(RedisModuleInfoCtx *ctx, TotalIndexesInfo *total_info) {
   RedisModule_InfoAddFieldULongLong(ctx, "total_query_commands", stats.total_query_commands);
   RedisModule_InfoAddFieldULongLong(ctx, "total_query_execution_time_ms", stats.total_query_execution_time);
   RedisModule_InfoAddFieldULongLong(ctx, "total_active_queries", total_info->total_active_queries);
+  StemmerCacheStats stemStats = StemmerCache_GetStats();
+  RedisModule_InfoAddFieldULongLong(ctx, "stemmer_cache_hits", stemStats.hits);
+  RedisModule_InfoAddFieldULongLong(ctx, "stemmer_cache_misses", stemStats.misses);
+  CoordGlobalStats coordStats = TotalGlobalStats_GetCoordStats();
+  RedisModule_InfoAddFieldULongLong(ctx, "coord_shard_requests", coordStats.shard_requests);
+  RedisModule_InfoAddFieldULongLong(ctx, "coord_hedged_shard_requests", coordStats.hedged_requests);
+  RedisModule_InfoAddFieldULongLong(ctx, "coord_hedged_shard_requests_won", coordStats.hedged_requests_won);
+  RedisModule_InfoAddFieldULongLong(ctx, "coord_result_cache_hits", coordStats.result_cache_hits);
+  RedisModule_InfoAddFieldULongLong(ctx, "coord_result_cache_misses", coordStats.result_cache_misses);
+  RedisModule_InfoAddFieldULongLong(ctx, "coord_result_cache_bytes", coordStats.result_cache_bytes);
+  // Admission of the queries running on the workers, per cost class
+  for (QueryCostClass cls = 0; cls < QUERY_CLASS__NUM; ++cls) {
+    QueryClassStats classStats = QueryAdmission_GetStats(cls);
+    const char *name = QueryAdmission_ClassName(cls);
+    char field[64];
+    snprintf(field, sizeof field, "%s_queries_admitted", name);
+    RedisModule_InfoAddFieldULongLong(ctx, field, classStats.admitted);
+    snprintf(field, sizeof field, "%s_queries_queued", name);
+    RedisModule_InfoAddFieldULongLong(ctx, field, classStats.queued);
+    snprintf(field, sizeof field, "%s_queries_rejected", name);
+    RedisModule_InfoAddFieldULongLong(ctx, field, classStats.rejected);
+    snprintf(field, sizeof field, "%s_queries_running", name);
+    RedisModule_InfoAddFieldULongLong(ctx, field, classStats.running);
+    snprintf(field, sizeof field, "%s_queries_waiting", name);
+    RedisModule_InfoAddFieldULongLong(ctx, field, classStats.waiting);
+  }
 }
 
 void AddToInfo_ErrorsAndWarnings(RedisModuleInfoCtx *ctx, TotalIndexesInfo *total_info) {
@@ -272,6 +323,15 @@ void AddToInfo_RSConfig(RedisModuleInfoCtx *ctx) {
   if (RSGlobalConfig.defaultScorer != NULL) {
     RedisModule_InfoAddFieldCString(ctx, "default_scorer", (char *)RSGlobalConfig.defaultScorer);
   }
+  if (RSGlobalConfig.workersCPUs != NULL && *RSGlobalConfig.workersCPUs) {
+    RedisModule_InfoAddFieldCString(ctx, "workers_cpus", (char *)RSGlobalConfig.workersCPUs);
+  }
+  if (RSGlobalConfig.ioThreadsCPUs != NULL && *RSGlobalConfig.ioThreadsCPUs) {
+    RedisModule_InfoAddFieldCString(ctx, "io_threads_cpus", (char *)RSGlobalConfig.ioThreadsCPUs);
+  }
+  if (RSGlobalConfig.forkGCCPUs != NULL && *RSGlobalConfig.forkGCCPUs) {
+    RedisModule_InfoAddFieldCString(ctx, "fork_gc_cpus", (char *)RSGlobalConfig.forkGCCPUs);
+  }
   RedisModule_InfoAddFieldCString(ctx, "enableGC",
                                   RSGlobalConfig.gcConfigParams.enableGC ? "ON" : "OFF");
   RedisModule_InfoAddFieldLongLong(ctx, "minimal_term_prefix",
@@ -300,6 +360,40 @@ void AddToInfo_RSConfig(RedisModuleInfoCtx *ctx) {
                                    RSGlobalConfig.requestConfigParams.BM25STD_TanhFactor);
 }
 
+void AddToInfo_WorkerThreads(RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoAddSection(ctx, "worker_threads");
+  uint64_t cpu_time_ns[MAX_WORKER_THREADS];
+  size_t n = workersThreadPool_GetThreadsCPUTime(cpu_time_ns, MAX_WORKER_THREADS);
+  n = MIN(n, MAX_WORKER_THREADS);
+  uint64_t total_ns = 0;
+  char field[64];
+  for (size_t i = 0; i < n; i++) {
+    snprintf(field, sizeof(field), "worker_%zu_cpu_time_ms", i);
+    RedisModule_InfoAddFieldULongLong(ctx, field, cpu_time_ns[i] / 1000000);
+    total_ns += cpu_time_ns[i];
+  }
+  RedisModule_InfoAddFieldULongLong(ctx, "workers_cpu_time_ms", total_ns / 1000000);
+}
+
+void AddToInfo_CpuDispatch(RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoAddSection(ctx, "simd");
+  char features[64] = "";
+  size_t len = 0;
+  const uint32_t selected = CpuDispatch_Features();
+  for (uint32_t f = 1; f & CPU_FEATURES_ALL; f <<= 1) {
+    if (selected & f) {
+      len += snprintf(features + len, sizeof(features) - len, "%s%s", len ? "," : "", CpuFeature_Name(f));
+    }
+  }
+  RedisModule_InfoAddFieldCString(ctx, "cpu_features", len ? features : "none");
+  char field[64];
+  for (size_t i = 0; i < CpuDispatch_NumKernels(); i++) {
+    const CpuDispatch_Kernel *kernel = CpuDispatch_GetKernel(i);
+    snprintf(field, sizeof(field), "kernel_%s", kernel->name);
+    RedisModule_InfoAddFieldCString(ctx, field, kernel->impl);
+  }
+}
+
 // IF the crashing thread worked on a spec, output the spec name
 void AddToInfo_CurrentThread(RedisModuleInfoCtx *ctx) {
   SpecInfo *specInfo = CurrentThread_TryGetSpecInfo();
@@ -12,6 +12,7 @@
 
 #include "util/dllist.h"
 #include "util/references.h"
+#include "util/timeout.h"
 #include "query.h"
 
 #ifdef __cplusplus
@@ -31,6 +32,7 @@ typedef struct {
   StrongRef spec;     // IndexSpec strong ref
   time_t start;       // Time node was added into list
   char *query;        // The query
+  QueryCancelToken cancel;  // Set when the client disconnects
 } BlockedQueryNode;
 
 typedef struct {
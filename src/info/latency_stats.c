@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "latency_stats.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+static LatencyHistogram queryHistograms[LATENCY_QUERY__NUM];
+static LatencyHistogram stageHistograms[LATENCY_STAGE__NUM];
+static LatencyHistogram waitHistograms[LATENCY_WAIT__NUM];
+static uint64_t waitTotalNs[LATENCY_WAIT__NUM];
+
+static const char *queryNames[LATENCY_QUERY__NUM] = {
+  [LATENCY_QUERY_SEARCH] = "search",
+  [LATENCY_QUERY_AGGREGATE] = "aggregate",
+  [LATENCY_QUERY_HYBRID] = "hybrid",
+};
+
+static const char *stageNames[LATENCY_STAGE__NUM] = {
+  [LATENCY_STAGE_PARSE] = "parse",
+  [LATENCY_STAGE_QUEUE] = "queue",
+  [LATENCY_STAGE_PLAN] = "plan",
+  [LATENCY_STAGE_ITERATORS] = "iterators",
+  [LATENCY_STAGE_LOAD] = "load",
+  [LATENCY_STAGE_SORT] = "sort",
+  [LATENCY_STAGE_REPLY] = "reply",
+  [LATENCY_STAGE_FANOUT] = "fanout",
+  [LATENCY_STAGE_SHARD_WAIT] = "shard_wait",
+};
+
+static const char *waitNames[LATENCY_WAIT__NUM] = {
+  [LATENCY_WAIT_SPEC_READ] = "spec_read_lock",
+  [LATENCY_WAIT_SPEC_WRITE] = "spec_write_lock",
+  [LATENCY_WAIT_GC] = "gc_lock",
+  [LATENCY_WAIT_DEPLETER_SYNC] = "depleter_sync",
+};
+
+static size_t bucketOf(uint64_t us) {
+  if (us < LATENCY_SUB_BUCKETS) {
+    return us;
+  }
+  const int msb = 63 - __builtin_clzll(us);
+  if (msb >= LATENCY_MAX_BIT) {
+    return LATENCY_NUM_BUCKETS - 1;
+  }
+  const int shift = msb - LATENCY_SUB_BITS;
+  return (shift + 1) * LATENCY_SUB_BUCKETS + ((us >> shift) - LATENCY_SUB_BUCKETS);
+}
+
+// The highest value counted in the bucket
+static uint64_t bucketTop(size_t bucket) {
+  if (bucket < LATENCY_SUB_BUCKETS) {
+    return bucket;
+  }
+  const int shift = bucket / LATENCY_SUB_BUCKETS - 1;
+  const uint64_t sub = bucket % LATENCY_SUB_BUCKETS;
+  return ((LATENCY_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram_Record(LatencyHistogram *h, uint64_t us) {
+  __atomic_add_fetch(&h->buckets[bucketOf(us)], 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&h->count, 1, __ATOMIC_RELAXED);
+  uint64_t max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+  while (us > max && !__atomic_compare_exchange_n(&h->max, &max, us, true, __ATOMIC_RELAXED,
+                                                  __ATOMIC_RELAXED)) {
+  }
+}
+
+uint64_t LatencyHistogram_Percentile(const LatencyHistogram *h, double fraction) {
+  uint64_t counts[LATENCY_NUM_BUCKETS];
+  uint64_t total = 0;
+  for (size_t i = 0; i < LATENCY_NUM_BUCKETS; i++) {
+    counts[i] = __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+    total += counts[i];
+  }
+  if (!total) {
+    return 0;
+  }
+  uint64_t rank = (uint64_t)ceil(fraction * total);
+  if (rank < 1) {
+    rank = 1;
+  }
+  const uint64_t max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < LATENCY_NUM_BUCKETS; i++) {
+    seen += counts[i];
+    // The last bucket has no top
+    if (seen >= rank && i < LATENCY_NUM_BUCKETS - 1) {
+      const uint64_t top = bucketTop(i);
+      return top < max ? top : max;
+    }
+  }
+  return max;
+}
+
+void LatencyStats_CountQuery(LatencyQueryType type, rs_wall_clock_ns_t ns) {
+  LatencyHistogram_Record(&queryHistograms[type], ns / 1000);
+}
+
+void LatencyStats_CountStage(LatencyStage stage, rs_wall_clock_ns_t ns) {
+  LatencyHistogram_Record(&stageHistograms[stage], ns / 1000);
+}
+
+void LatencyStats_CountWait(LatencyWait wait, rs_wall_clock_ns_t ns) {
+  LatencyHistogram_Record(&waitHistograms[wait], ns / 1000);
+  __atomic_add_fetch(&waitTotalNs[wait], ns, __ATOMIC_RELAXED);
+}
+
+// `totalNs` is the sum of the values, if it is kept
+static void addHistogramToInfo(RedisModuleInfoCtx *ctx, const char *prefix, const char *name,
+                               const LatencyHistogram *h, const uint64_t *totalNs) {
+  char field[64];
+  snprintf(field, sizeof field, "%s_%s", prefix, name);
+  RedisModule_InfoBeginDictField(ctx, field);
+  RedisModule_InfoAddFieldULongLong(ctx, "count", __atomic_load_n(&h->count, __ATOMIC_RELAXED));
+  RedisModule_InfoAddFieldULongLong(ctx, "p50", LatencyHistogram_Percentile(h, 0.5));
+  RedisModule_InfoAddFieldULongLong(ctx, "p99", LatencyHistogram_Percentile(h, 0.99));
+  RedisModule_InfoAddFieldULongLong(ctx, "p999", LatencyHistogram_Percentile(h, 0.999));
+  RedisModule_InfoAddFieldULongLong(ctx, "max", __atomic_load_n(&h->max, __ATOMIC_RELAXED));
+  if (totalNs) {
+    RedisModule_InfoAddFieldULongLong(ctx, "total", __atomic_load_n(totalNs, __ATOMIC_RELAXED) / 1000);
+  }
+  RedisModule_InfoEndDictField(ctx);
+}
+
+void LatencyStats_AddToInfo(RedisModuleInfoCtx *ctx) {
+  // All in microseconds
+  RedisModule_InfoAddSection(ctx, "latency");
+  for (LatencyQueryType type = 0; type < LATENCY_QUERY__NUM; ++type) {
+    addHistogramToInfo(ctx, "query", queryNames[type], &queryHistograms[type], NULL);
+  }
+  for (LatencyStage stage = 0; stage < LATENCY_STAGE__NUM; ++stage) {
+    addHistogramToInfo(ctx, "stage", stageNames[stage], &stageHistograms[stage], NULL);
+  }
+  for (LatencyWait wait = 0; wait < LATENCY_WAIT__NUM; ++wait) {
+    addHistogramToInfo(ctx, "wait", waitNames[wait], &waitHistograms[wait], &waitTotalNs[wait]);
+  }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stdint.h>
+#include "redismodule.h"
+#include "rs_wall_clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Latency distributions of the queries and of the stages they go through, reported by
+ * `INFO search` as a few percentiles of each.
+ *
+ * A histogram counts the values, in microseconds, in buckets of the same relative width: a value
+ * falls in the bucket of its highest set bit and of the LATENCY_SUB_BITS bits below it, so that a
+ * percentile is off by at most 1/2^LATENCY_SUB_BITS of its value. The counters are only ever
+ * incremented, with relaxed atomics, so the threads which record values never wait for each other
+ * or for the readers, and a percentile is read from a snapshot which may miss the latest values.
+ */
+
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+// The values from 2^LATENCY_MAX_BIT us (about 12 days) on are counted in the last bucket
+#define LATENCY_MAX_BIT 40
+#define LATENCY_NUM_BUCKETS ((LATENCY_MAX_BIT - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+typedef struct {
+  uint64_t buckets[LATENCY_NUM_BUCKETS];
+  uint64_t count;
+  uint64_t max;
+} LatencyHistogram;
+
+/* Count a value of `us` microseconds. Thread safe */
+void LatencyHistogram_Record(LatencyHistogram *h, uint64_t us);
+/* The value below which `fraction` (in [0, 1]) of the recorded values are, rounded up to the top of
+ * its bucket, or 0 if no value was recorded */
+uint64_t LatencyHistogram_Percentile(const LatencyHistogram *h, double fraction);
+
+typedef enum {
+  LATENCY_QUERY_SEARCH = 0,
+  LATENCY_QUERY_AGGREGATE,
+  LATENCY_QUERY_HYBRID,
+  LATENCY_QUERY__NUM,
+} LatencyQueryType;
+
+typedef enum {
+  LATENCY_STAGE_PARSE = 0,   // Parsing the request and its query
+  LATENCY_STAGE_QUEUE,       // Waiting for a worker thread
+  LATENCY_STAGE_PLAN,        // Building the iterators and the pipeline
+  LATENCY_STAGE_ITERATORS,   // Reading the iterators, and the steps of the pipeline not timed below
+  LATENCY_STAGE_LOAD,        // Loading the fields of the documents
+  LATENCY_STAGE_SORT,        // Keeping the top results of SORTBY and of the scores
+  LATENCY_STAGE_REPLY,       // Serializing the results into the reply
+  LATENCY_STAGE_FANOUT,      // Sending the request of the coordinator to the shards
+  LATENCY_STAGE_SHARD_WAIT,  // Waiting for a reply of a shard to a request of the coordinator
+  LATENCY_STAGE__NUM,
+} LatencyStage;
+
+/* The waits of the threads for each other, which limit how the queries scale with the workers */
+typedef enum {
+  LATENCY_WAIT_SPEC_READ = 0,  // A query, or another reader, for the read lock of an index
+  LATENCY_WAIT_SPEC_WRITE,     // A writer for the write lock of an index
+  LATENCY_WAIT_GC,             // The GC for either lock of an index
+  LATENCY_WAIT_DEPLETER_SYNC,  // The thread of a query for its depleters, to lock the index or to finish
+  LATENCY_WAIT__NUM,
+} LatencyWait;
+
+/* Count the latency of a query command (or of a chunk of its cursor) */
+void LatencyStats_CountQuery(LatencyQueryType type, rs_wall_clock_ns_t ns);
+/* Count the time a command spent in a stage */
+void LatencyStats_CountStage(LatencyStage stage, rs_wall_clock_ns_t ns);
+
+/* Count a wait of `ns` nanoseconds. Only the waits which blocked are counted, along with their total */
+void LatencyStats_CountWait(LatencyWait wait, rs_wall_clock_ns_t ns);
+
+/* Add the percentiles of the histograms to `INFO search` */
+void LatencyStats_AddToInfo(RedisModuleInfoCtx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
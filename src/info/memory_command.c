@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "memory_command.h"
+#include "spec.h"
+#include "inverted_index.h"
+#include "redis_index.h"
+#include "tag_index.h"
+#include "numeric_index.h"
+#include "geometry/geometry_api.h"
+#include "geometry_index.h"
+#include "suffix_array.h"
+#include "impact_postings.h"
+#include "spell_delete_index.h"
+#include "sortable.h"
+#include "field_spec_info.h"
+#include "reply.h"
+#include "reply_macros.h"
+#include "rmutil/args.h"
+#include "trie/trie_type.h"
+#include "trie/rune_util.h"
+#include "util/heap.h"
+#include "info/info_redis/threads/current_thread.h"
+
+// The inverted indexes of a structure, e.g. all the values of a TAG field
+typedef struct {
+  size_t numIndexes;
+  size_t bytes;
+  size_t numBlocks;
+  size_t numEntries;
+  size_t usedBytes;     // The bytes of the blocks holding entries
+  size_t allocatedBytes;
+  size_t denseBlocks;
+  size_t packedBlocks;
+  IndexFlags flags;
+} InvertedIndexesMemory;
+
+// Returns the memory of the index
+static size_t addInvertedIndex(InvertedIndexesMemory *mem, const InvertedIndex *idx) {
+  const size_t bytes = InvertedIndex_MemUsage(idx);
+  mem->numIndexes++;
+  mem->bytes += bytes;
+  mem->flags = InvertedIndex_Flags(idx);
+  const size_t numBlocks = InvertedIndex_NumBlocks(idx);
+  mem->numBlocks += numBlocks;
+  for (size_t i = 0; i < numBlocks; i++) {
+    const IndexBlock *blk = InvertedIndex_BlockRef(idx, i);
+    mem->numEntries += IndexBlock_NumEntries(blk);
+    mem->usedBytes += IndexBlock_Len(blk);
+    mem->allocatedBytes += IndexBlock_Cap(blk);
+    mem->denseBlocks += IndexBlock_IsDense(blk);
+    mem->packedBlocks += IndexBlock_IsPacked(blk);
+  }
+  return bytes;
+}
+
+// The encoding of the entries, by what they store
+static const char *encodingName(IndexFlags flags) {
+  switch (flags & INDEX_STORAGE_MASK & ~Index_WideSchema) {
+    case Index_DocIdsOnly:
+      return "doc-ids";
+    case Index_StoreNumeric:
+      return "numeric";
+    case Index_StoreFreqs | Index_StoreTermOffsets | Index_StoreFieldFlags:
+      return "freqs-fields-offsets";
+    case Index_StoreFreqs | Index_StoreFieldFlags:
+      return "freqs-fields";
+    case Index_StoreFreqs | Index_StoreTermOffsets:
+      return "freqs-offsets";
+    case Index_StoreFieldFlags | Index_StoreTermOffsets:
+      return "fields-offsets";
+    case Index_StoreFreqs:
+      return "freqs";
+    case Index_StoreFieldFlags:
+      return "fields";
+    case Index_StoreTermOffsets:
+      return "offsets";
+    default:
+      return "unknown";
+  }
+}
+
+static void replyInvertedIndexes(RedisModule_Reply *reply, const InvertedIndexesMemory *mem) {
+  REPLY_KVMAP("inverted_indexes");
+  REPLY_KVINT("count", mem->numIndexes);
+  REPLY_KVINT("bytes", mem->bytes);
+  if (mem->numIndexes) {
+    REPLY_KVSTR("encoding", encodingName(mem->flags));
+    REPLY_KVINT("wide_schema", !!(mem->flags & Index_WideSchema));
+  }
+  REPLY_KVINT("blocks", mem->numBlocks);
+  REPLY_KVINT("dense_blocks", mem->denseBlocks);
+  REPLY_KVINT("packed_blocks", mem->packedBlocks);
+  REPLY_KVINT("entries", mem->numEntries);
+  REPLY_KVNUM("entries_per_block_avg", mem->numBlocks ? (double)mem->numEntries / mem->numBlocks : 0);
+  // How much of the buffers of the blocks is used. The rest was allocated ahead of the entries
+  REPLY_KVNUM("block_utilization", mem->allocatedBytes ? (double)mem->usedBytes / mem->allocatedBytes : 0);
+  REPLY_MAP_END;
+}
+
+/***********************************************************************************************
+ * The largest inverted indexes of the terms
+ ***********************************************************************************************/
+
+typedef struct {
+  char *term;
+  size_t len;
+  size_t bytes;
+} TermMemory;
+
+// The heap keeps the smallest of the largest terms on its top
+static int cmpTermBytes(const void *e1, const void *e2, const void *udata) {
+  const TermMemory *t1 = e1, *t2 = e2;
+  if (t1->bytes < t2->bytes) return 1;
+  if (t1->bytes > t2->bytes) return -1;
+  return 0;
+}
+
+typedef struct {
+  heap_t *heap;
+  TermMemory *terms;
+  size_t numTerms;
+} TopTerms;
+
+static void TopTerms_Init(TopTerms *top, size_t n) {
+  top->numTerms = 0;
+  top->terms = n ? rm_malloc(n * sizeof(*top->terms)) : NULL;
+  top->heap = n ? rm_malloc(heap_sizeof(n)) : NULL;
+  if (n) {
+    heap_init(top->heap, cmpTermBytes, NULL, n);
+  }
+}
+
+// Takes the ownership of `term`
+static void TopTerms_Offer(TopTerms *top, char *term, size_t len, size_t bytes) {
+  if (!top->heap) {
+    rm_free(term);
+  } else if (heap_count(top->heap) < heap_size(top->heap)) {
+    TermMemory *tm = &top->terms[top->numTerms++];
+    *tm = (TermMemory){.term = term, .len = len, .bytes = bytes};
+    heap_offerx(top->heap, tm);
+  } else {
+    TermMemory *smallest = heap_peek(top->heap);
+    if (bytes <= smallest->bytes) {
+      rm_free(term);
+      return;
+    }
+    rm_free(smallest->term);
+    *smallest = (TermMemory){.term = term, .len = len, .bytes = bytes};
+    heap_replace(top->heap, smallest);
+  }
+}
+
+// Reply with the terms from the largest, and free them
+static void TopTerms_Reply(TopTerms *top, RedisModule_Reply *reply) {
+  const size_t n = top->numTerms;
+  TermMemory **sorted = rm_malloc(n * sizeof(*sorted));
+  for (size_t i = n; i > 0; i--) {
+    sorted[i - 1] = heap_poll(top->heap);
+  }
+  REPLY_KVARRAY("top_terms");
+  for (size_t i = 0; i < n; i++) {
+    RedisModule_Reply_Map(reply);
+    RedisModule_ReplyKV_StringBuffer(reply, "term", sorted[i]->term, sorted[i]->len);
+    REPLY_KVINT("bytes", sorted[i]->bytes);
+    RedisModule_Reply_MapEnd(reply);
+  }
+  REPLY_ARRAY_END;
+  for (size_t i = 0; i < n; i++) {
+    rm_free(sorted[i]->term);
+  }
+  rm_free(sorted);
+  rm_free(top->terms);
+  rm_free(top->heap);
+}
+
+/***********************************************************************************************
+ * The structures of the index
+ ***********************************************************************************************/
+
+// The inverted indexes of the terms are shared by all the TEXT fields, with the field mask of each
+// entry telling the fields it is in
+static void replyTerms(RedisModule_Reply *reply, RedisSearchCtx *sctx, size_t topN) {
+  IndexSpec *sp = sctx->spec;
+  InvertedIndexesMemory mem = {0};
+  size_t numCold = 0;
+  TopTerms top;
+  TopTerms_Init(&top, topN);
+
+  TrieIterator *iter = Trie_Iterate(sp->terms, "", 0, 0, 1);
+  rune *rstr = NULL;
+  t_len slen = 0;
+  float score = 0;
+  int dist = 0;
+  while (TrieIterator_Next(iter, &rstr, &slen, NULL, &score, &dist)) {
+    size_t len;
+    char *term = runesToStr(rstr, slen, &len);
+    bool isCold;
+    const InvertedIndex *idx = Redis_PeekInvertedIndex(sctx, term, len, &isCold);
+    if (!idx) {
+      rm_free(term);
+      continue;
+    }
+    numCold += isCold;
+    TopTerms_Offer(&top, term, len, addInvertedIndex(&mem, idx));
+  }
+  TrieIterator_Free(iter);
+
+  REPLY_KVMAP("text");
+  REPLY_KVINT("terms", sp->stats.numTerms);
+  // The blocks of the cold terms were moved to the disk database (see term_tiers.h)
+  REPLY_KVINT("cold_terms", numCold);
+  REPLY_KVINT("terms_trie_bytes", TrieType_MemUsage(sp->terms));
+  if (sp->suffix) {
+    REPLY_KVINT("suffix_bytes", TrieType_MemUsage(sp->suffix));
+  } else if (sp->suffixArray) {
+    REPLY_KVINT("suffix_bytes", SuffixArray_MemUsage(sp->suffixArray));
+  }
+  REPLY_KVINT("offset_vectors_bytes", sp->stats.offsetVecsSize);
+  REPLY_KVINT("impact_postings_bytes", ImpactPostings_MemUsage(sp->impactPostings));
+  REPLY_KVINT("spellcheck_deletes_bytes", SpellDeleteIndex_MemUsage(sp->spellDeletes));
+  replyInvertedIndexes(reply, &mem);
+  REPLY_MAP_END;
+
+  TopTerms_Reply(&top, reply);
+}
+
+static void replyTagField(RedisModule_Reply *reply, IndexSpec *sp, FieldSpec *fs) {
+  RedisModuleString *keyName = TagIndex_FormatName(sp, fs->fieldName);
+  const TagIndex *idx = TagIndex_Open(sp, keyName, DONT_CREATE_INDEX);
+  RedisModule_FreeString(RSDummyContext, keyName);
+  if (!idx) {
+    return;
+  }
+  InvertedIndexesMemory mem = {0};
+  TagValuesIterator *iter = TagIndex_IterateValues(idx, NULL, 0, TM_PREFIX_MODE);
+  char *value;
+  tm_len_t len;
+  InvertedIndex *iv;
+  while (TagValuesIterator_Next(iter, &value, &len, &iv)) {
+    addInvertedIndex(&mem, iv);
+  }
+  TagValuesIterator_Free(iter);
+
+  REPLY_KVINT("values", TagIndex_NumValues(idx));
+  // The values, the suffixes and the caches of the index
+  REPLY_KVINT("overhead_bytes", TagIndex_GetOverhead(sp, fs));
+  if (idx->suffix) {
+    REPLY_KVINT("suffix_bytes", TrieMap_MemUsage(idx->suffix));
+  }
+  replyInvertedIndexes(reply, &mem);
+}
+
+static size_t hllBytes(const struct HLL *hll) {
+  return hll->registers ? hll->size : 0;
+}
+
+static void replyNumericField(RedisModule_Reply *reply, IndexSpec *sp, FieldSpec *fs) {
+  RedisModuleString *keyName = IndexSpec_GetFormattedKey(sp, fs, fs->types);
+  NumericRangeTree *rt = openNumericKeysDict(sp, keyName, DONT_CREATE_INDEX);
+  if (!rt) {
+    return;
+  }
+  InvertedIndexesMemory mem = {0};
+  size_t numNodes = 0;
+  size_t treeBytes = sizeof(*rt);
+  size_t hll = hllBytes(&rt->distinct);
+  size_t exactValues = 0;
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(rt);
+  NumericRangeNode *node;
+  while ((node = NumericRangeTreeIterator_Next(iter))) {
+    numNodes++;
+    treeBytes += sizeof(*node);
+    const NumericRange *range = node->range;
+    if (range) {
+      treeBytes += sizeof(*range);
+      hll += hllBytes(&range->hll);
+      exactValues += range->numValues * sizeof(*range->values);
+      addInvertedIndex(&mem, range->entries);
+    }
+  }
+  NumericRangeTreeIterator_Free(iter);
+
+  REPLY_KVINT("nodes", numNodes);
+  REPLY_KVINT("ranges", rt->numRanges);
+  REPLY_KVINT("leaves", rt->numLeaves);
+  REPLY_KVINT("empty_leaves", rt->emptyLeaves);
+  REPLY_KVINT("tree_bytes", treeBytes);
+  // The cardinality estimates of the ranges, and of the whole tree
+  REPLY_KVINT("hll_bytes", hll);
+  // The distinct values of the ranges counted exactly (see _NUMERIC_EXACT_CARDINALITY)
+  REPLY_KVINT("exact_values_bytes", exactValues);
+  replyInvertedIndexes(reply, &mem);
+}
+
+static void replyField(RedisModule_Reply *reply, IndexSpec *sp, FieldSpec *fs) {
+  RedisModule_Reply_Map(reply);
+  char *path = FieldSpec_FormatPath(fs, false);
+  char *name = FieldSpec_FormatName(fs, false);
+  REPLY_KVSTR_SAFE("identifier", path);
+  REPLY_KVSTR_SAFE("attribute", name);
+  rm_free(path);
+  rm_free(name);
+  if (!(fs->options & FieldSpec_Dynamic)) {
+    REPLY_KVSTR("type", FieldSpec_GetTypeNames(INDEXTYPE_TO_POS(fs->types)));
+  }
+
+  if (FIELD_IS(fs, INDEXFLD_T_TAG)) {
+    replyTagField(reply, sp, fs);
+  }
+  if (FIELD_IS(fs, INDEXFLD_T_NUMERIC) || FIELD_IS(fs, INDEXFLD_T_GEO)) {
+    replyNumericField(reply, sp, fs);
+  }
+  if (FIELD_IS(fs, INDEXFLD_T_VECTOR)) {
+    REPLY_KVINT("vector_index_bytes", IndexSpec_GetVectorIndexStats(sp, fs).memory);
+  }
+  if (FIELD_IS(fs, INDEXFLD_T_GEOMETRY)) {
+    const GeometryIndex *idx = OpenGeometryIndex(sp, fs, DONT_CREATE_INDEX);
+    REPLY_KVINT("geometry_index_bytes", idx ? GeometryApi_Get(idx)->report(idx) : 0);
+  }
+  RedisModule_Reply_MapEnd(reply);
+}
+
+int IndexMemoryCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+  size_t topN = MEMORY_DEFAULT_TOP_TERMS;
+  ArgsCursor ac;
+  ArgsCursor_InitRString(&ac, argv + 2, argc - 2);
+  while (!AC_IsAtEnd(&ac)) {
+    if (AC_AdvanceIfMatch(&ac, "TOP")) {
+      if (AC_GetSize(&ac, &topN, 0) != AC_OK || topN > MEMORY_MAX_TOP_TERMS) {
+        return RedisModule_ReplyWithErrorFormat(ctx, "TOP must be between 0 and %d",
+                                                MEMORY_MAX_TOP_TERMS);
+      }
+    } else {
+      return RedisModule_ReplyWithError(ctx, "Unknown argument for FT.MEMORY");
+    }
+  }
+
+  StrongRef ref = IndexSpec_LoadUnsafe(RedisModule_StringPtrLen(argv[1], NULL));
+  IndexSpec *sp = StrongRef_Get(ref);
+  if (!sp) {
+    return RedisModule_ReplyWithError(ctx, "Unknown index name");
+  }
+  CurrentThread_SetIndexSpec(sp->own_ref);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+
+  const size_t vectorBytes = IndexSpec_VectorIndexesSize(sp);
+  RedisModule_Reply_Map(reply);
+  REPLY_KVINT("total_bytes", IndexSpec_TotalMemUsage(sp, 0, 0, 0, vectorBytes));
+  REPLY_KVINT("doc_table_bytes", sp->docs.memsize);
+  REPLY_KVINT("key_table_bytes", DocIdMap_MemUsage(&sp->docs.dim));
+  REPLY_KVINT("sortables_bytes",
+              sp->docs.sortablesSize + RSSortingColumns_MemUsage(&sp->docs.sortingColumns));
+  REPLY_KVINT("vector_indexes_bytes", vectorBytes);
+
+  replyTerms(reply, &sctx, topN);
+
+  REPLY_KVARRAY("fields");
+  for (size_t i = 0; i < sp->numFields; i++) {
+    replyField(reply, sp, &sp->fields[i]);
+  }
+  REPLY_ARRAY_END;
+  RedisModule_Reply_MapEnd(reply);
+
+  RedisModule_EndReply(reply);
+  CurrentThread_ClearIndexSpec();
+  return REDISMODULE_OK;
+}
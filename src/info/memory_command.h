@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "redismodule.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEMORY_DEFAULT_TOP_TERMS 10
+#define MEMORY_MAX_TOP_TERMS 1000
+
+/**
+ * FT.MEMORY <index> [TOP <n>]
+ *
+ * Break the memory of an index down by structure: the terms of its TEXT fields (which share their
+ * inverted indexes), the inverted indexes and tries of each TAG field, the range tree of each
+ * NUMERIC and GEO field, and the vector and geometry indexes. The inverted indexes are described by
+ * their encoding, their blocks and how full those are. The `n` terms with the largest inverted
+ * indexes are listed as well. It walks every inverted index of the index, on the main thread.
+ */
+int IndexMemoryCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
+
+#ifdef __cplusplus
+}
+#endif
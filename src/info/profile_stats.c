@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "profile_stats.h"
+#include "config.h"
+#include "result_processor.h"
+
+#include <ctype.h>
+#include <stdio.h>
+
+typedef struct {
+  uint64_t instances;  // The number of profiled iterators or processors of the type
+  uint64_t calls;
+  uint64_t ns;
+} ProfileStatsEntry;
+
+static uint64_t numQueries;
+static uint64_t sampleCounter;
+static ProfileStatsEntry iteratorStats[PROFILE_STATS_ITERATOR__NUM];
+static ProfileStatsEntry rpStats[RP_MAX];
+
+static const char *iteratorNames[PROFILE_STATS_ITERATOR__NUM] = {
+  [PROFILE_STATS_TEXT] = "TEXT",
+  [PROFILE_STATS_TAG] = "TAG",
+  [PROFILE_STATS_NUMERIC] = "NUMERIC",
+  [PROFILE_STATS_GEO] = "GEO",
+  [PROFILE_STATS_UNION] = "UNION",
+  [PROFILE_STATS_INTERSECT] = "INTERSECT",
+  [PROFILE_STATS_NOT] = "NOT",
+  [PROFILE_STATS_OPTIONAL] = "OPTIONAL",
+  [PROFILE_STATS_WILDCARD] = "WILDCARD",
+  [PROFILE_STATS_EMPTY] = "EMPTY",
+  [PROFILE_STATS_ID_LIST] = "ID-LIST",
+  [PROFILE_STATS_VECTOR] = "VECTOR",
+  [PROFILE_STATS_METRIC] = "METRIC",
+  [PROFILE_STATS_OPTIMIZER] = "OPTIMIZER",
+  [PROFILE_STATS_SAMPLE] = "SAMPLE",
+};
+
+const char *ProfileStats_IteratorName(ProfileStatsIterator type) {
+  return iteratorNames[type];
+}
+
+bool ProfileStats_ShouldSample(void) {
+  const unsigned int rate = RSGlobalConfig.profileSampleRate;
+  return rate && __atomic_fetch_add(&sampleCounter, 1, __ATOMIC_RELAXED) % rate == 0;
+}
+
+void ProfileStats_CountQuery(void) {
+  __atomic_add_fetch(&numQueries, 1, __ATOMIC_RELAXED);
+}
+
+static void countEntry(ProfileStatsEntry *e, uint64_t calls, rs_wall_clock_ns_t ns) {
+  __atomic_add_fetch(&e->instances, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&e->calls, calls, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&e->ns, ns, __ATOMIC_RELAXED);
+}
+
+void ProfileStats_CountIterator(ProfileStatsIterator type, uint64_t calls, rs_wall_clock_ns_t ns) {
+  countEntry(&iteratorStats[type], calls, ns);
+}
+
+void ProfileStats_CountRP(int type, uint64_t calls, rs_wall_clock_ns_t ns) {
+  if (type >= 0 && type < RP_MAX) {
+    countEntry(&rpStats[type], calls, ns);
+  }
+}
+
+static ProfileStatsEntry loadEntry(const ProfileStatsEntry *e) {
+  return (ProfileStatsEntry){
+    .instances = __atomic_load_n(&e->instances, __ATOMIC_RELAXED),
+    .calls = __atomic_load_n(&e->calls, __ATOMIC_RELAXED),
+    .ns = __atomic_load_n(&e->ns, __ATOMIC_RELAXED),
+  };
+}
+
+// The names of the processors hold spaces and capitals, e.g. "Score Max Normalizer"
+static void infoFieldName(char *buf, size_t len, const char *prefix, const char *name) {
+  size_t n = snprintf(buf, len, "%s_", prefix);
+  for (; *name && n + 1 < len; name++) {
+    buf[n++] = isalnum((unsigned char)*name) ? tolower((unsigned char)*name) : '_';
+  }
+  buf[n] = '\0';
+}
+
+static void addEntryToInfo(RedisModuleInfoCtx *ctx, const char *prefix, const char *name,
+                           const ProfileStatsEntry *entry) {
+  const ProfileStatsEntry e = loadEntry(entry);
+  if (!e.instances) {
+    return;
+  }
+  char field[64];
+  infoFieldName(field, sizeof(field), prefix, name);
+  RedisModule_InfoBeginDictField(ctx, field);
+  RedisModule_InfoAddFieldULongLong(ctx, "count", e.instances);
+  RedisModule_InfoAddFieldULongLong(ctx, "calls", e.calls);
+  RedisModule_InfoAddFieldDouble(ctx, "time_ms", rs_wall_clock_convert_ns_to_ms_d(e.ns));
+  RedisModule_InfoEndDictField(ctx);
+}
+
+void ProfileStats_AddToInfo(RedisModuleInfoCtx *ctx) {
+  RedisModule_InfoAddSection(ctx, "sampled_profile");
+  RedisModule_InfoAddFieldULongLong(ctx, "sampled_queries",
+                                    __atomic_load_n(&numQueries, __ATOMIC_RELAXED));
+  for (ProfileStatsIterator type = 0; type < PROFILE_STATS_ITERATOR__NUM; type++) {
+    addEntryToInfo(ctx, "iterator", iteratorNames[type], &iteratorStats[type]);
+  }
+  for (ResultProcessorType type = 0; type < RP_MAX; type++) {
+    addEntryToInfo(ctx, "rp", RPTypeToString(type), &rpStats[type]);
+  }
+}
+
+static void replyEntries(RedisModule_Reply *reply, const char *key, const ProfileStatsEntry *entries,
+                         size_t num, const char *(*nameOf)(int)) {
+  RedisModule_ReplyKV_Map(reply, key);
+  for (size_t i = 0; i < num; i++) {
+    const ProfileStatsEntry e = loadEntry(&entries[i]);
+    if (!e.instances) {
+      continue;
+    }
+    RedisModule_ReplyKV_Map(reply, nameOf(i));
+    RedisModule_ReplyKV_LongLong(reply, "Count", e.instances);
+    RedisModule_ReplyKV_LongLong(reply, "Calls", e.calls);
+    RedisModule_ReplyKV_Double(reply, "Time", rs_wall_clock_convert_ns_to_ms_d(e.ns));
+    RedisModule_Reply_MapEnd(reply);
+  }
+  RedisModule_Reply_MapEnd(reply);
+}
+
+static const char *iteratorNameOf(int type) {
+  return iteratorNames[type];
+}
+
+static const char *rpNameOf(int type) {
+  return RPTypeToString(type);
+}
+
+void ProfileStats_Reply(RedisModule_Reply *reply) {
+  RedisModule_Reply_Map(reply);
+  RedisModule_ReplyKV_LongLong(reply, "Sampled queries", __atomic_load_n(&numQueries, __ATOMIC_RELAXED));
+  replyEntries(reply, "Iterators", iteratorStats, PROFILE_STATS_ITERATOR__NUM, iteratorNameOf);
+  replyEntries(reply, "Result processors", rpStats, RP_MAX, rpNameOf);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+void ProfileStats_Reset(void) {
+  __atomic_store_n(&numQueries, 0, __ATOMIC_RELAXED);
+  for (size_t i = 0; i < PROFILE_STATS_ITERATOR__NUM; i++) {
+    iteratorStats[i] = (ProfileStatsEntry){0};
+  }
+  for (size_t i = 0; i < RP_MAX; i++) {
+    rpStats[i] = (ProfileStatsEntry){0};
+  }
+}
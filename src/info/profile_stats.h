@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "redismodule.h"
+#include "reply.h"
+#include "rs_wall_clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Sampled profiling: one in `search-_profile-sample-rate` queries is profiled as FT.PROFILE would
+ * profile it, without replying with its profile. The time each of its iterators and result
+ * processors spent, without the time of their children (or of their upstream processors), is added
+ * to the totals of their type, which `INFO search` and `FT.DEBUG PROFILE_STATS` report. Over many
+ * queries, the totals tell where the queries spend their time, for the cost of profiling a few.
+ *
+ * The totals are only ever added to, with relaxed atomics, and are only reset by
+ * `FT.DEBUG PROFILE_STATS RESET`.
+ */
+
+typedef enum {
+  PROFILE_STATS_TEXT = 0,
+  PROFILE_STATS_TAG,
+  PROFILE_STATS_NUMERIC,
+  PROFILE_STATS_GEO,
+  PROFILE_STATS_UNION,
+  PROFILE_STATS_INTERSECT,
+  PROFILE_STATS_NOT,
+  PROFILE_STATS_OPTIONAL,
+  PROFILE_STATS_WILDCARD,
+  PROFILE_STATS_EMPTY,
+  PROFILE_STATS_ID_LIST,
+  PROFILE_STATS_VECTOR,
+  PROFILE_STATS_METRIC,
+  PROFILE_STATS_OPTIMIZER,
+  PROFILE_STATS_SAMPLE,
+  PROFILE_STATS_ITERATOR__NUM,
+} ProfileStatsIterator;
+
+/* The name of the iterator type, as FT.PROFILE prints it */
+const char *ProfileStats_IteratorName(ProfileStatsIterator type);
+
+/* Whether the next query is sampled. Thread safe */
+bool ProfileStats_ShouldSample(void);
+
+/* Count a sampled query */
+void ProfileStats_CountQuery(void);
+/* Count an iterator of a sampled query, which was called `calls` times and spent `ns` in itself */
+void ProfileStats_CountIterator(ProfileStatsIterator type, uint64_t calls, rs_wall_clock_ns_t ns);
+/* Count a result processor (of type `ResultProcessorType`) of a sampled query */
+void ProfileStats_CountRP(int type, uint64_t calls, rs_wall_clock_ns_t ns);
+
+/* Add the totals to `INFO search` */
+void ProfileStats_AddToInfo(RedisModuleInfoCtx *ctx);
+/* Reply with the totals, as a map of the iterator types and a map of the processor types */
+void ProfileStats_Reply(RedisModule_Reply *reply);
+void ProfileStats_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,15 +9,42 @@
 
 #include "vector_index_stats.h"
 
+#define QUERY_STATS_METRIC(field)                                                 \
+    static size_t getQueries_##field(const VectorIndexStats *stats) {             \
+        return stats->queries.field;                                              \
+    }                                                                             \
+    static void setQueries_##field(VectorIndexStats *stats, size_t value) {       \
+        stats->queries.field = value;                                             \
+    }
+
+QUERY_STATS_METRIC(queries)
+QUERY_STATS_METRIC(indexResults)
+QUERY_STATS_METRIC(distances)
+QUERY_STATS_METRIC(batches)
+QUERY_STATS_METRIC(adhocSwitches)
+QUERY_STATS_METRIC(bytesRead)
+
 static VectorIndexStats_SetterMapping VectorIndexStats_SetterMappingsContainer[] = {
     {"memory", VectorIndexStats_SetMemory},
     {"marked_deleted", VectorIndexStats_SetMarkedDeleted},
+    {"queries", setQueries_queries},
+    {"index_results_read", setQueries_indexResults},
+    {"distance_computations", setQueries_distances},
+    {"batch_iterations", setQueries_batches},
+    {"adhoc_switches", setQueries_adhocSwitches},
+    {"vector_bytes_read", setQueries_bytesRead},
     {NULL, NULL} // Sentinel value to mark the end of the array
 };
 
 static VectorIndexStats_GetterMapping VectorIndexStats_GetterMappingContainer[] = {
     {"memory", VectorIndexStats_GetMemory},
     {"marked_deleted", VectorIndexStats_GetMarkedDeleted},
+    {"queries", getQueries_queries},
+    {"index_results_read", getQueries_indexResults},
+    {"distance_computations", getQueries_distances},
+    {"batch_iterations", getQueries_batches},
+    {"adhoc_switches", getQueries_adhocSwitches},
+    {"vector_bytes_read", getQueries_bytesRead},
     {NULL, NULL} // Sentinel value to mark the end of the array
 };
 
@@ -47,6 +74,21 @@ VectorIndexStats_Getter VectorIndexStats_GetGetter(const char* name){
 void VectorIndexStats_Agg(VectorIndexStats *first, const VectorIndexStats *second) {
     first->memory += second->memory;
     first->marked_deleted += second->marked_deleted;
+    first->queries.queries += second->queries.queries;
+    first->queries.indexResults += second->queries.indexResults;
+    first->queries.distances += second->queries.distances;
+    first->queries.batches += second->queries.batches;
+    first->queries.adhocSwitches += second->queries.adhocSwitches;
+    first->queries.bytesRead += second->queries.bytesRead;
+}
+
+void VectorQueryStats_Add(VectorQueryStats *total, const VectorQueryStats *query) {
+    __atomic_add_fetch(&total->queries, query->queries, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->indexResults, query->indexResults, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->distances, query->distances, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->batches, query->batches, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->adhocSwitches, query->adhocSwitches, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&total->bytesRead, query->bytesRead, __ATOMIC_RELAXED);
 }
 
 size_t VectorIndexStats_GetMemory(const VectorIndexStats *stats){
@@ -63,3 +105,31 @@ void VectorIndexStats_SetMemory(VectorIndexStats *stats, size_t memory) {
 void VectorIndexStats_SetMarkedDeleted(VectorIndexStats *stats, size_t marked_deleted) {
     stats->marked_deleted = marked_deleted;
 }
+
+void VectorIndexingStats_AddSubmitted(VectorIndexingStats *stats, size_t numJobs) {
+    __atomic_add_fetch(&stats->submittedJobs, numJobs, __ATOMIC_RELAXED);
+}
+
+void VectorIndexingStats_AddDone(VectorIndexingStats *stats, uint64_t runTimeNs) {
+    __atomic_add_fetch(&stats->runTimeNs, runTimeNs, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->doneJobs, 1, __ATOMIC_RELAXED);
+}
+
+size_t VectorIndexingStats_GetPending(const VectorIndexingStats *stats) {
+    // The jobs are counted as submitted once they were queued, so they may be done before
+    size_t done = __atomic_load_n(&stats->doneJobs, __ATOMIC_RELAXED);
+    size_t submitted = __atomic_load_n(&stats->submittedJobs, __ATOMIC_RELAXED);
+    return submitted > done ? submitted - done : 0;
+}
+
+size_t VectorIndexingStats_GetDone(const VectorIndexingStats *stats) {
+    return __atomic_load_n(&stats->doneJobs, __ATOMIC_RELAXED);
+}
+
+double VectorIndexingStats_GetThroughput(const VectorIndexingStats *stats) {
+    uint64_t runTimeNs = __atomic_load_n(&stats->runTimeNs, __ATOMIC_RELAXED);
+    if (!runTimeNs) {
+        return 0;
+    }
+    return VectorIndexingStats_GetDone(stats) * 1e9 / runTimeNs;
+}
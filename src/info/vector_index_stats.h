@@ -14,10 +14,26 @@
 #endif
 
 #include <string.h>
+#include <stdint.h>
+
+/* What the queries of a vector field did, other than taking time. Summed over the queries of the
+ * field, and kept in its spec */
+typedef struct VectorQueryStats {
+  size_t queries;
+  size_t indexResults;    // Read from the replies of the vector index
+  size_t distances;       // Computed by the queries themselves (ad-hoc brute force, reranking)
+  size_t batches;         // Read by the hybrid queries in batches mode
+  size_t adhocSwitches;   // Of the hybrid queries from batches to ad-hoc brute force
+  size_t bytesRead;       // Of the vectors of the results read and of the distances computed
+} VectorQueryStats;
+
+// Add the stats of a query to those of its field, atomically as the queries may run concurrently
+void VectorQueryStats_Add(VectorQueryStats *total, const VectorQueryStats *query);
 
 typedef struct VectorIndexStats {
   size_t memory;
   size_t marked_deleted;
+  VectorQueryStats queries;
 } VectorIndexStats;
 
 typedef void (*VectorIndexStats_Setter)(VectorIndexStats*, size_t);
@@ -45,10 +61,33 @@ size_t VectorIndexStats_GetMarkedDeleted(const VectorIndexStats *stats);
 void VectorIndexStats_SetMemory(VectorIndexStats *stats, size_t memory);
 void VectorIndexStats_SetMarkedDeleted(VectorIndexStats *stats, size_t marked_deleted);
 
+/* The jobs the tiered vector indexes of an index submitted to the workers: inserting the vectors
+ * of their flat buffer into their graph, and repairing the graph after deletions. The counters are
+ * updated atomically, by the main thread and the workers */
+typedef struct VectorIndexingStats {
+  size_t submittedJobs;
+  size_t doneJobs;
+  uint64_t runTimeNs;  // Spent running the done jobs, summed over the workers
+} VectorIndexingStats;
+
+void VectorIndexingStats_AddSubmitted(VectorIndexingStats *stats, size_t numJobs);
+void VectorIndexingStats_AddDone(VectorIndexingStats *stats, uint64_t runTimeNs);
+// The jobs not run yet, which is how far the graphs lag behind the written vectors
+size_t VectorIndexingStats_GetPending(const VectorIndexingStats *stats);
+size_t VectorIndexingStats_GetDone(const VectorIndexingStats *stats);
+// The jobs run per second by a worker, 0 if none ran
+double VectorIndexingStats_GetThroughput(const VectorIndexingStats *stats);
+
 // metrics display strings:
 static char* const VectorIndexStats_Metrics[] = {
     "memory",
     "marked_deleted",
+    "queries",
+    "index_results_read",
+    "distance_computations",
+    "batch_iterations",
+    "adhoc_switches",
+    "vector_bytes_read",
     NULL
 };
 
@@ -35,6 +35,7 @@ static QueryIterator eofIterator = {.Read = EOI_Read,
                                     .lastDocId = 0,
                                     .current = NULL,
                                     .Revalidate = Default_Revalidate,
+                                    .ReadBatch = Default_ReadBatch,
     };
 
 QueryIterator *NewEmptyIterator(void) {
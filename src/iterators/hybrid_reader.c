@@ -70,7 +70,9 @@ static IteratorStatus HR_ReadInBatch(HybridIterator *hr, RSIndexResult *out) {
 
 static void insertResultToHeap_Metric(HybridIterator *hr, RSIndexResult *child_res, RSIndexResult **vec_res, double *upper_bound) {
 
-  RSYieldableMetric_Concat(&(*vec_res)->metrics, child_res->metrics); // Pass child metrics, if there are any
+  if (child_res) {
+    RSYieldableMetric_Concat(&(*vec_res)->metrics, child_res->metrics); // Pass child metrics, if there are any
+  }
   ResultMetrics_Add(*vec_res, hr->ownKey, RSValue_NewNumber(IndexResult_NumValue(*vec_res)));
 
   if (hr->topResults->count < hr->query.k) {
@@ -109,8 +111,11 @@ static void insertResultToHeap_Aggregate(HybridIterator *hr, RSIndexResult *chil
   *upper_bound = IndexResult_NumValue(first);
 }
 
+// `child_res` is NULL when matching the ids of the child, which is only done when the results can
+// be trimmed
 static void insertResultToHeap(HybridIterator *hr, RSIndexResult *child_res,
                                RSIndexResult **vec_res, double *upper_bound) {
+  RS_ASSERT(child_res || hr->canTrimDeepResults);
   if (hr->canTrimDeepResults) {
     // If we ignore the document score, insert a single node of type DISTANCE.
     insertResultToHeap_Metric(hr, child_res, vec_res, upper_bound);
@@ -152,39 +157,163 @@ static void alternatingIterate(HybridIterator *hr, VecSimQueryReply_Iterator *ve
   IndexResult_Free(cur_vec_res);
 }
 
-static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
-  double upper_bound = INFINITY;
-  VecSimQueryReply_Code rc = VecSim_QueryReply_OK;
+// Go over the batch and the ids of the child, saving the mutual results in the heap
+static void matchFilterIds(HybridIterator *hr, double *upper_bound) {
   RSIndexResult *cur_vec_res = NewMetricResult();
-  void *qvector = hr->query.vector;
+  const t_docId *ids = hr->filterIds;
+  size_t pos = 0, n = array_len(ids);
+  while (pos < n && HR_ReadInBatch(hr, cur_vec_res) == ITERATOR_OK) {
+    // The batch is sorted by id, so the ids lower than this one are not in the rest of it either
+    t_docId id = cur_vec_res->docId;
+    size_t hi = n;
+    while (pos < hi) {
+      size_t mid = pos + (hi - pos) / 2;
+      if (ids[mid] < id) {
+        pos = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (pos < n && ids[pos] == id) {
+      if (hr->topResults->count < hr->query.k || IndexResult_NumValue(cur_vec_res) < *upper_bound) {
+        insertResultToHeap(hr, NULL, &cur_vec_res, upper_bound);
+      }
+      pos++;
+    }
+  }
+  IndexResult_Free(cur_vec_res);
+}
 
+// Read the ids of the child results into `filterIds`, for the batches to be matched against
+// without reading the child again. Gives up, leaving the child rewound, on a result yielding
+// metrics, which the vector results would have to carry
+static VecSimQueryReply_Code readFilterIds(HybridIterator *hr) {
+  arrayof(t_docId) ids = array_new(t_docId, 16);
+  IteratorStatus child_status;
+  while ((child_status = hr->child->Read(hr->child)) != ITERATOR_EOF) {
+    if (child_status == ITERATOR_TIMEOUT || TimedOut_WithCtx(&hr->timeoutCtx)) {
+      array_free(ids);
+      return VecSim_QueryReply_TimedOut;
+    }
+    if (hr->child->current->metrics) {
+      array_free(ids);
+      hr->child->Rewind(hr->child);
+      return VecSim_QueryReply_OK;
+    }
+    array_append(ids, hr->child->lastDocId);
+  }
+  hr->filterIds = ids;
+  return VecSim_QueryReply_OK;
+}
+
+// Read the next result of the child, from its ids if they were read. `child_res` is then NULL
+static IteratorStatus readFilter(HybridIterator *hr, size_t *pos, t_docId *docId,
+                                 RSIndexResult **child_res) {
+  if (hr->filterIds) {
+    if (*pos == array_len(hr->filterIds)) {
+      return ITERATOR_EOF;
+    }
+    *docId = hr->filterIds[(*pos)++];
+    *child_res = NULL;
+    return ITERATOR_OK;
+  }
+  IteratorStatus child_status = hr->child->Read(hr->child);
+  *docId = hr->child->lastDocId;
+  *child_res = hr->child->current;
+  return child_status;
+}
+
+// The query vector to compute the distances from the stored vectors with. To be freed if it's not
+// the one of the query
+static void *distanceQueryVector(HybridIterator *hr) {
+  void *qvector = hr->query.vector;
   if (hr->indexMetric == VecSimMetric_Cosine) {
     qvector = rm_malloc(hr->dimension * VecSimType_sizeof(hr->vecType));
     memcpy(qvector, hr->query.vector, hr->dimension * VecSimType_sizeof(hr->vecType));
     VecSim_Normalize(qvector, hr->dimension, hr->vecType);
   }
+  return qvector;
+}
+
+static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
+  double upper_bound = INFINITY;
+  VecSimQueryReply_Code rc = VecSim_QueryReply_OK;
+  RSIndexResult *cur_vec_res = NewMetricResult();
+  void *qvector = distanceQueryVector(hr);
 
   VecSimTieredIndex_AcquireSharedLocks(hr->index);
   IteratorStatus child_status;
-  while ((child_status = hr->child->Read(hr->child)) != ITERATOR_EOF) {
+  size_t pos = 0;
+  t_docId docId;
+  RSIndexResult *child_res;
+  while ((child_status = readFilter(hr, &pos, &docId, &child_res)) != ITERATOR_EOF) {
     if (child_status == ITERATOR_TIMEOUT || TimedOut_WithCtx(&hr->timeoutCtx)) {
       rc = VecSim_QueryReply_TimedOut;
       break;
     }
     RS_ASSERT(child_status == ITERATOR_OK);
-    double metric = VecSimIndex_GetDistanceFrom_Unsafe(hr->index, hr->child->lastDocId, qvector);
+    double metric = VecSimIndex_GetDistanceFrom_Unsafe(hr->index, docId, qvector);
+    hr->stats.distances++;
     // If this id is not in the vector index (since it was deleted), metric will return as NaN.
     if (isnan(metric)) {
       continue;
     }
     if (hr->topResults->count < hr->query.k || metric < upper_bound) {
       // Populate the vector result.
-      cur_vec_res->docId = hr->child->lastDocId;
+      cur_vec_res->docId = docId;
+      IndexResult_SetNumValue(cur_vec_res, metric);
+      insertResultToHeap(hr, child_res, &cur_vec_res, &upper_bound);
+    }
+  }
+  VecSimTieredIndex_ReleaseSharedLocks(hr->index);
+  if (qvector != hr->query.vector) {
+    rm_free(qvector);
+  }
+  IndexResult_Free(cur_vec_res);
+  return rc;
+}
+
+// Search for `rerankFactor` times K candidates, and keep the K closest of them by their distance
+// from the vectors stored in the index rather than the one the search computed, which may be that
+// of their compressed representation
+static VecSimQueryReply_Code rerankResults(HybridIterator *hr) {
+  double candidates = ceil(hr->query.rerankFactor * hr->query.k);
+  size_t num_candidates = candidates < MAX_KNN_K ? (size_t)candidates : MAX_KNN_K;
+  VecSimQueryReply *reply = VecSimIndex_TopKQuery(hr->index, hr->query.vector, num_candidates,
+                                                  &hr->runtimeParams, BY_ID);
+  VecSimQueryReply_Code rc = VecSimQueryReply_GetCode(reply);
+  if (rc == VecSim_QueryReply_TimedOut) {
+    VecSimQueryReply_Free(reply);
+    return rc;
+  }
+
+  hr->stats.indexResults += VecSimQueryReply_Len(reply);
+  double upper_bound = INFINITY;
+  RSIndexResult *cur_vec_res = NewMetricResult();
+  void *qvector = distanceQueryVector(hr);
+  VecSimQueryReply_Iterator *iter = VecSimQueryReply_GetIterator(reply);
+  VecSimTieredIndex_AcquireSharedLocks(hr->index);
+  while (VecSimQueryReply_IteratorHasNext(iter)) {
+    if (TimedOut_WithCtx(&hr->timeoutCtx)) {
+      rc = VecSim_QueryReply_TimedOut;
+      break;
+    }
+    t_docId id = VecSimQueryResult_GetId(VecSimQueryReply_IteratorNext(iter));
+    double metric = VecSimIndex_GetDistanceFrom_Unsafe(hr->index, id, qvector);
+    hr->stats.distances++;
+    // Deleted since the search
+    if (isnan(metric)) {
+      continue;
+    }
+    if (hr->topResults->count < hr->query.k || metric < upper_bound) {
+      cur_vec_res->docId = id;
       IndexResult_SetNumValue(cur_vec_res, metric);
-      insertResultToHeap(hr, hr->child->current, &cur_vec_res, &upper_bound);
+      insertResultToHeap_Metric(hr, NULL, &cur_vec_res, &upper_bound);
     }
   }
   VecSimTieredIndex_ReleaseSharedLocks(hr->index);
+  VecSimQueryReply_IteratorFree(iter);
+  VecSimQueryReply_Free(reply);
   if (qvector != hr->query.vector) {
     rm_free(qvector);
   }
@@ -192,6 +321,75 @@ static VecSimQueryReply_Code computeDistances(HybridIterator *hr) {
   return rc;
 }
 
+// Search for the K results, keeping them in the heap so that they can be cached. With a distance
+// bound, a range query only explores the graph around the results within it
+static VecSimQueryReply_Code searchResults(HybridIterator *hr) {
+  VecSimQueryReply *reply =
+      isinf(hr->distanceBound)
+          ? VecSimIndex_TopKQuery(hr->index, hr->query.vector, hr->query.k, &hr->runtimeParams, BY_ID)
+          : VecSimIndex_RangeQuery(hr->index, hr->query.vector, hr->distanceBound,
+                                   &hr->runtimeParams, BY_ID);
+  VecSimQueryReply_Code rc = VecSimQueryReply_GetCode(reply);
+  if (rc == VecSim_QueryReply_TimedOut) {
+    VecSimQueryReply_Free(reply);
+    return rc;
+  }
+
+  hr->stats.indexResults += VecSimQueryReply_Len(reply);
+  double upper_bound = INFINITY;
+  RSIndexResult *cur_vec_res = NewMetricResult();
+  VecSimQueryReply_Iterator *iter = VecSimQueryReply_GetIterator(reply);
+  while (VecSimQueryReply_IteratorHasNext(iter)) {
+    VecSimQueryResult *res = VecSimQueryReply_IteratorNext(iter);
+    double metric = VecSimQueryResult_GetScore(res);
+    // The range query may find more than K results
+    if (hr->topResults->count < hr->query.k || metric < upper_bound) {
+      cur_vec_res->docId = VecSimQueryResult_GetId(res);
+      IndexResult_SetNumValue(cur_vec_res, metric);
+      insertResultToHeap_Metric(hr, NULL, &cur_vec_res, &upper_bound);
+    }
+  }
+  VecSimQueryReply_IteratorFree(iter);
+  VecSimQueryReply_Free(reply);
+  IndexResult_Free(cur_vec_res);
+  return rc;
+}
+
+// Fill the heap with the results cached for the query. Returns false if there are none
+static bool readCachedResults(HybridIterator *hr) {
+  KNNCachedResult *results;
+  size_t num_results;
+  if (!KNNResultCache_Get(hr->resultCache, hr->sctx->spec->revision, hr->cacheKey, &results,
+                          &num_results)) {
+    return false;
+  }
+  double upper_bound = INFINITY;
+  RSIndexResult *cur_vec_res = NewMetricResult();
+  for (size_t i = 0; i < num_results; i++) {
+    cur_vec_res->docId = results[i].docId;
+    IndexResult_SetNumValue(cur_vec_res, results[i].distance);
+    insertResultToHeap_Metric(hr, NULL, &cur_vec_res, &upper_bound);
+  }
+  IndexResult_Free(cur_vec_res);
+  rm_free(results);
+  return true;
+}
+
+static void cacheResults(HybridIterator *hr) {
+  size_t num_results = hr->topResults->count;
+  if (!num_results || num_results > KNN_RESULT_CACHE_MAX_RESULTS) {
+    return;
+  }
+  KNNCachedResult *results = rm_malloc(num_results * sizeof(*results));
+  for (size_t i = 0; i < num_results; i++) {
+    const RSIndexResult *res = hr->topResults->data[i + 1];  // The heap is 1-based
+    results[i] = (KNNCachedResult){.docId = res->docId, .distance = IndexResult_NumValue(res)};
+  }
+  KNNResultCache_Put(hr->resultCache, hr->sctx->spec->revision, hr->cacheKey, results, num_results,
+                     hr->cacheCapacity);
+  rm_free(results);
+}
+
 // Review the estimated child results num, and returns true if hybrid policy should change.
 static bool reviewHybridSearchPolicy(HybridIterator *hr, size_t n_res_left, size_t child_upper_bound,
                                      size_t *child_num_estimated) {
@@ -220,8 +418,19 @@ static bool reviewHybridSearchPolicy(HybridIterator *hr, size_t n_res_left, size
 }
 
 static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
+  if (hr->searchMode == VECSIM_STANDARD_KNN && hr->topResults) {
+    if (hr->resultCache && readCachedResults(hr)) {
+      return VecSim_QueryReply_OK;
+    }
+    VecSimQueryReply_Code rc = hr->query.rerankFactor > 1 ? rerankResults(hr) : searchResults(hr);
+    if (rc == VecSim_QueryReply_OK && hr->resultCache) {
+      cacheResults(hr);
+    }
+    return rc;
+  }
   if (hr->searchMode == VECSIM_STANDARD_KNN) {
     hr->reply = VecSimIndex_TopKQuery(hr->index, hr->query.vector, hr->query.k, &(hr->runtimeParams), hr->query.order);
+    hr->stats.indexResults += VecSimQueryReply_Len(hr->reply);
     hr->iter = VecSimQueryReply_GetIterator(hr->reply);
     return VecSimQueryReply_GetCode(hr->reply);
   }
@@ -243,6 +452,15 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
     child_num_estimated = VecSimIndex_IndexSize(hr->index);
   }
   size_t child_upper_bound = child_num_estimated;
+  if (hr->canTrimDeepResults && hr->filterIdsMax &&
+      hr->child->NumEstimated(hr->child) <= hr->filterIdsMax) {
+    // Read the child once, rather than again for each batch
+    code = readFilterIds(hr);
+    if (VecSim_QueryReply_TimedOut == code) {
+      VecSimBatchIterator_Free(batch_it);
+      return code;
+    }
+  }
   while (VecSimBatchIterator_HasNext(batch_it)) {
     hr->numIterations++;
     size_t vec_index_size = VecSimIndex_IndexSize(hr->index);
@@ -262,11 +480,16 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
     if (VecSim_QueryReply_TimedOut == code) {
       break;
     }
+    hr->stats.indexResults += VecSimQueryReply_Len(hr->reply);
     hr->iter = VecSimQueryReply_GetIterator(hr->reply);
-    hr->child->Rewind(hr->child);
 
-    // Go over both iterators and save mutual results in the heap.
-    alternatingIterate(hr, hr->iter, &upper_bound);
+    if (hr->filterIds) {
+      matchFilterIds(hr, &upper_bound);
+    } else {
+      hr->child->Rewind(hr->child);
+      // Go over both iterators and save mutual results in the heap.
+      alternatingIterate(hr, hr->iter, &upper_bound);
+    }
     if (hr->topResults->count == hr->query.k) {
       break;
     }
@@ -277,7 +500,9 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
       hr->searchMode = VECSIM_HYBRID_BATCHES_TO_ADHOC_BF;
       // Clean the saved results, and restart the hybrid search in ad-hoc BF mode.
       mmh_clear(hr->topResults);
-      hr->child->Rewind(hr->child);
+      if (!hr->filterIds) {
+        hr->child->Rewind(hr->child);
+      }
       return computeDistances(hr);
     }
   }
@@ -285,6 +510,18 @@ static VecSimQueryReply_Code prepareResults(HybridIterator *hr) {
   return code;
 }
 
+// Done preparing the results, add the stats of the query to those of its field
+static void recordQueryStats(HybridIterator *hr) {
+  hr->stats.queries = 1;
+  hr->stats.batches = hr->numIterations;
+  hr->stats.adhocSwitches = hr->searchMode == VECSIM_HYBRID_BATCHES_TO_ADHOC_BF;
+  hr->stats.bytesRead = (hr->stats.indexResults + hr->stats.distances) * hr->dimension *
+                        VecSimType_sizeof(hr->vecType);
+  if (hr->fieldStats) {
+    VectorQueryStats_Add(hr->fieldStats, &hr->stats);
+  }
+}
+
 // In KNN mode, the results will return sorted by ascending order of the distance
 // (better score first), while in hybrid mode, the results will return in descending order.
 static IteratorStatus HR_ReadHybridUnsortedSingle(HybridIterator *hr) {
@@ -313,7 +550,9 @@ static IteratorStatus HR_ReadHybridUnsorted(QueryIterator *ctx) {
   HybridIterator *hr = (HybridIterator *)ctx;
   if (!hr->resultsPrepared) {
     hr->resultsPrepared = true;
-    if (prepareResults(hr) == VecSim_QueryReply_TimedOut) {
+    VecSimQueryReply_Code code = prepareResults(hr);
+    recordQueryStats(hr);
+    if (code == VecSim_QueryReply_TimedOut) {
       return ITERATOR_TIMEOUT;
     }
   }
@@ -352,7 +591,9 @@ static IteratorStatus HR_ReadKnnUnsorted(QueryIterator *ctx) {
   HybridIterator *hr = (HybridIterator *)ctx;
   if (!hr->resultsPrepared) {
     hr->resultsPrepared = true;
-    if (prepareResults(hr) == VecSim_QueryReply_TimedOut) {
+    VecSimQueryReply_Code code = prepareResults(hr);
+    recordQueryStats(hr);
+    if (code == VecSim_QueryReply_TimedOut) {
       return ITERATOR_TIMEOUT;
     }
     ctx->current = NewMetricResult(); // Initialize the current result.
@@ -379,6 +620,7 @@ static void HR_Rewind(QueryIterator *ctx) {
   HybridIterator *hr = (HybridIterator *)ctx;
   hr->resultsPrepared = false;
   hr->numIterations = 0;
+  hr->stats = (VectorQueryStats){0};
   VecSimQueryReply_Free(hr->reply);
   VecSimQueryReply_IteratorFree(hr->iter);
   hr->reply = NULL;
@@ -389,11 +631,16 @@ static void HR_Rewind(QueryIterator *ctx) {
     IndexResult_Free(hr->base.current);
     hr->base.current = NULL;
   }
+  array_free(hr->filterIds);
+  hr->filterIds = NULL;
 
   if (hr->searchMode == VECSIM_HYBRID_ADHOC_BF || hr->searchMode == VECSIM_HYBRID_BATCHES) {
     // Clean the saved and returned results (in case of HYBRID mode).
     mmh_clear(hr->topResults);
     hr->child->Rewind(hr->child);
+  } else if (hr->searchMode == VECSIM_STANDARD_KNN && hr->topResults) {
+    // The reranked or cached results
+    mmh_clear(hr->topResults);
   }
 }
 
@@ -408,7 +655,7 @@ void HybridIterator_Free(QueryIterator *self) {
     it->keyHandle->is_valid = false;
   }
 
-  if (it->topResults) {   // Iterator is in one of the hybrid modes.
+  if (it->topResults) {   // Iterator is in one of the hybrid modes, reranks or caches.
     mmh_free(it->topResults);
   }
   if (it->base.current) {
@@ -417,6 +664,8 @@ void HybridIterator_Free(QueryIterator *self) {
   }
   VecSimQueryReply_Free(it->reply);
   VecSimQueryReply_IteratorFree(it->iter);
+  array_free(it->filterIds);
+  sdsfree(it->cacheKey);
   if (it->child) {
     it->child->Free(it->child);
   }
@@ -452,6 +701,7 @@ QueryIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
   RS_ASSERT(hParams.qParams.searchMode >= 0 && hParams.qParams.searchMode < VECSIM_LAST_SEARCHMODE);
   QueryIterator* ri = HybridIteratorReducer(&hParams);
   if (ri) {
+    sdsfree(hParams.cacheKey);
     return ri;
   }
 
@@ -474,14 +724,39 @@ QueryIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
   hi->topResults = NULL;
   hi->numIterations = 0;
   hi->canTrimDeepResults = hParams.canTrimDeepResults;
-  hi->timeoutCtx = (TimeoutCtx){ .timeout = hParams.timeout, .counter = 0 };
+  hi->timeoutCtx = (TimeoutCtx){ .timeout = hParams.timeout, .counter = 0,
+                                 .cancel = hParams.sctx ? hParams.sctx->time.cancel : NULL };
   hi->runtimeParams.timeoutCtx = &hi->timeoutCtx;
   hi->sctx = hParams.sctx;
   hi->filterCtx = *hParams.filterCtx;
+  hi->filterIdsMax = hParams.filterIdsMax;
+  hi->filterIds = NULL;
+  hi->resultCache = NULL;
+  hi->cacheKey = NULL;
+  hi->cacheCapacity = 0;
+  hi->distanceBound = INFINITY;
+  hi->efRuntime = hParams.efRuntime;
+  hi->stats = (VectorQueryStats){0};
+  hi->fieldStats = hParams.fieldStats;
 
   if (hParams.childIt == NULL || hParams.query.k == 0) {
     // If there is no child iterator, or the query is going to return 0 results, we can use simple KNN.
     hi->searchMode = VECSIM_STANDARD_KNN;
+    if (hParams.childIt == NULL && hParams.query.k && hParams.query.k <= KNN_RESULT_CACHE_MAX_RESULTS &&
+        hParams.resultCache && hParams.sctx) {
+      hi->resultCache = hParams.resultCache;
+      hi->cacheKey = hParams.cacheKey;
+      hi->cacheCapacity = hParams.cacheCapacity;
+      hParams.cacheKey = NULL;
+    }
+    if (hParams.childIt == NULL && hParams.hasDistanceBound) {
+      hi->distanceBound = hParams.distanceBound;
+    }
+    if ((hParams.query.rerankFactor > 1 || hi->resultCache || !isinf(hi->distanceBound)) &&
+        hParams.query.k) {
+      // The reranked, cached or bounded results are kept in the heap, and read like the hybrid ones
+      hi->topResults = mmh_init_with_size(hParams.query.k, cmpVecSimResByScore, NULL, (mmh_free_func)IndexResult_Free);
+    }
   } else {
     // hi->searchMode is VECSIM_HYBRID_ADHOC_BF || VECSIM_HYBRID_BATCHES
     // Get the estimated number of results that pass the child "sub-query filter". Note that
@@ -503,6 +778,7 @@ QueryIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
     }
     hi->topResults = mmh_init_with_size(hParams.query.k, cmpVecSimResByScore, NULL, (mmh_free_func)IndexResult_Free);
   }
+  sdsfree(hParams.cacheKey);
 
   ri = &hi->base;
   ri->type = HYBRID_ITERATOR;
@@ -513,8 +789,9 @@ QueryIterator *NewHybridVectorIterator(HybridIteratorParams hParams, QueryError
   ri->Free = HybridIterator_Free;
   ri->Rewind = HR_Rewind;
   ri->Revalidate = HR_Revalidate;
+  ri->ReadBatch = Default_ReadBatch;
   ri->SkipTo = NULL; // As long as this iterator is always at the root, this is not needed.
-  if (hi->searchMode == VECSIM_STANDARD_KNN) {
+  if (hi->searchMode == VECSIM_STANDARD_KNN && !hi->topResults) {
     ri->Read = HR_ReadKnnUnsorted;
   } else {
     // Hybrid query - save the RSIndexResult subtree which is not the vector distance only if required.
@@ -12,6 +12,8 @@
 #include "vector_index.h"
 #include "util/minmax_heap.h"
 #include "util/timeout.h"
+#include "util/arr.h"
+#include "knn_cache.h"
 
 typedef struct {
   RedisSearchCtx *sctx;
@@ -26,6 +28,14 @@ typedef struct {
   QueryIterator *childIt;
   struct timespec timeout;
   const FieldFilterContext* filterCtx;
+  size_t filterIdsMax;     // Read a child of at most that many results once in batches mode, 0 to never
+  KNNResultCache *resultCache; // Caches the results of the query if it has no child, NULL to not cache
+  sds cacheKey;            // The key of the query in the cache. Owned by the iterator
+  size_t cacheCapacity;    // The most queries the cache keeps
+  bool hasDistanceBound;   // Whether a query without a child only looks for the results at most
+  double distanceBound;    // this far from its vector
+  size_t efRuntime;        // The EF of the HNSW search, 0 if the index is not HNSW
+  VectorQueryStats *fieldStats; // Of the field, which the query adds its stats to. May be NULL
 } HybridIteratorParams;
 
 typedef struct {
@@ -52,6 +62,15 @@ typedef struct {
   bool canTrimDeepResults;         // Ignore the document scores, only vector score matters. No need to deep copy the results from the child iterator.
   TimeoutCtx timeoutCtx;           // Timeout parameters
   FieldFilterContext filterCtx;
+  size_t filterIdsMax;
+  arrayof(t_docId) filterIds;      // The ids of the child results, when read once for all the batches
+  KNNResultCache *resultCache;     // NULL if the results are not cached
+  sds cacheKey;
+  size_t cacheCapacity;
+  double distanceBound;            // INFINITY if the results are not bounded
+  size_t efRuntime;
+  VectorQueryStats stats;          // Of the query, numIterations counting its batches
+  VectorQueryStats *fieldStats;
 } HybridIterator;
 
 #ifdef __cplusplus
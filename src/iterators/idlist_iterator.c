@@ -37,6 +37,22 @@ static IteratorStatus IL_Read(QueryIterator *base) {
   return ITERATOR_OK;
 }
 
+/* Copy the next ids of the list at once */
+static IteratorStatus IL_ReadBatch(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  IdListIterator *it = (IdListIterator *)base;
+  if (isEof(base) || it->offset >= it->size) {
+    setEof(base, true);
+    *numRead = 0;
+    return ITERATOR_EOF;
+  }
+  size_t n = MIN(cap, it->size - it->offset);
+  memcpy(out, it->docIds + it->offset, n * sizeof(*out));
+  it->offset += n;
+  base->lastDocId = base->current->docId = out[n - 1];
+  *numRead = n;
+  return ITERATOR_OK;
+}
+
 /* Skip to a docid, potentially reading the entry into hit, if the docId
 * matches */
 static IteratorStatus IL_SkipTo(QueryIterator *base, t_docId docId) {
@@ -112,6 +128,7 @@ QueryIterator *NewIdListIterator(t_docId *ids, t_offset num, double weight) {
   ret->SkipTo = IL_SkipTo;
   ret->Rewind = IL_Rewind;
   ret->Revalidate = Default_Revalidate;
+  ret->ReadBatch = IL_ReadBatch;
   return ret;
 }
 
@@ -167,6 +184,7 @@ QueryIterator *NewMetricIterator(t_docId *docIds, double *metric_list, size_t nu
   mi->metricList = metric_list;
   mi->ownKey = NULL;
   mi->keyHandle = NULL; // Will be set later if this iterator is used for metrics
+  mi->searchMode = NULL;
   it->docIds = docIds;
   it->size = num_results;
   it->offset = 0;
@@ -181,5 +199,6 @@ QueryIterator *NewMetricIterator(t_docId *docIds, double *metric_list, size_t nu
   ret->Free = MR_Free;
   ret->NumEstimated = IL_NumEstimated;
   ret->Revalidate = Default_Revalidate;
+  ret->ReadBatch = Default_ReadBatch; // Every read also yields a metric
   return ret;
 }
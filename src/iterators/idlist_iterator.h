@@ -34,6 +34,7 @@ typedef struct {
   // Consider placing in a union with an array of keys, if a field want to yield multiple metrics
   struct RLookupKey *ownKey;
   struct RLookupKeyHandle *keyHandle; // Back-reference to the handle that points to this iterator's ownKey
+  const char *searchMode; // How a filtered vector range query was run, printed by FT.PROFILE if set
 } MetricIterator;
 
 /**
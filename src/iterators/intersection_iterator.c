@@ -12,6 +12,59 @@
 #include "union_iterator.h"
 #include "index_result.h"
 #include "wildcard_iterator.h"
+#include "inverted_index_iterator.h"
+#include "util/sorted_ids.h"
+#include "util/minmax.h"
+
+/**************************** Adaptive Ordering ****************************/
+
+// Number of candidate ids checked between two reorderings of the children
+#define II_REORDER_INTERVAL 256
+// A child leads the intersection once it rejected this many times more candidates than the leader
+#define II_REORDER_MIN_RATIO 4
+// Minimal number of rejected candidates for the order to change, so a few rejects do not reorder
+// children of similar densities
+#define II_REORDER_MIN_REJECTS (II_REORDER_INTERVAL / 4)
+
+// (Re)build the order of the children, starting from the order of `its`. Children may be added
+// after construction, so this is called whenever their number changed
+static void II_ResetOrder(IntersectionIterator *it) {
+  it->order = rm_realloc(it->order, it->num_its * sizeof(*it->order));
+  it->rejects = rm_realloc(it->rejects, it->num_its * sizeof(*it->rejects));
+  for (uint32_t i = 0; i < it->num_its; i++) {
+    it->order[i] = i;
+    it->rejects[i] = 0;
+  }
+  it->num_ordered = it->num_its;
+  it->num_checks = 0;
+}
+
+// Re-pick the leading child if another child has been rejecting many more candidates than it.
+// The children are then advanced from the most to the least rejecting one, so a candidate is
+// dropped after as few skips as possible. Past observations are halved so the order can follow
+// changes in the density of the children along the ids
+static void II_Reorder(IntersectionIterator *it) {
+  uint32_t maxRejects = 0;
+  for (uint32_t i = 0; i < it->num_its; i++) {
+    maxRejects = MAX(maxRejects, it->rejects[i]);
+  }
+  if (maxRejects >= II_REORDER_MIN_REJECTS &&
+      maxRejects > (uint64_t)it->rejects[it->order[0]] * II_REORDER_MIN_RATIO) {
+    // Stable insertion sort by descending number of rejects. There are only a few children
+    for (uint32_t i = 1; i < it->num_its; i++) {
+      uint32_t cur = it->order[i];
+      uint32_t j = i;
+      for (; j > 0 && it->rejects[it->order[j - 1]] < it->rejects[cur]; j--) {
+        it->order[j] = it->order[j - 1];
+      }
+      it->order[j] = cur;
+    }
+  }
+  for (uint32_t i = 0; i < it->num_its; i++) {
+    it->rejects[i] /= 2;
+  }
+  it->num_checks = 0;
+}
 
 /**************************** Read + SkipTo Helpers ****************************/
 
@@ -20,9 +73,13 @@ static inline bool II_currentIsRelevant(IntersectionIterator *it) {
 }
 
 static inline IteratorStatus II_ReadFromFirstChild(IntersectionIterator *it, t_docId *out) {
-  // Read from the first child iterator, which is guaranteed to be non-NULL
-  RS_ASSERT(it->num_its > 0 && it->its[0] != NULL);
-  QueryIterator *child = it->its[0];
+  RS_ASSERT(it->num_its > 0);
+  if (it->num_ordered != it->num_its) {
+    II_ResetOrder(it);
+  }
+  // Read from the leading child, which is guaranteed to be non-NULL
+  QueryIterator *child = it->its[it->order[0]];
+  RS_ASSERT(child != NULL);
   IteratorStatus rc = child->Read(child);
   if (rc == ITERATOR_OK) {
     *out = child->lastDocId; // If we read successfully, we return the docId
@@ -43,7 +100,16 @@ static inline IteratorStatus II_ReadFromFirstChild(IntersectionIterator *it, t_d
 static IteratorStatus II_AgreeOnDocId(IntersectionIterator *it, t_docId *curTarget) {
   const t_docId docId = *curTarget;
 
-  for (uint32_t i = 0; i < it->num_its; i++) {
+  // The children are advanced in `order`, which only changes here and between candidates, when
+  // no child is past the target. All the children agree on a docId whenever the leader is read
+  if (it->num_ordered != it->num_its) {
+    II_ResetOrder(it);
+  } else if (++it->num_checks == II_REORDER_INTERVAL) {
+    II_Reorder(it);
+  }
+
+  for (uint32_t k = 0; k < it->num_its; k++) {
+    const uint32_t i = it->order[k];
     RS_ASSERT(it->its[i]->lastDocId <= docId);
     if (it->its[i]->lastDocId < docId) {
       // Advance the iterator to the requested docId
@@ -56,12 +122,14 @@ static IteratorStatus II_AgreeOnDocId(IntersectionIterator *it, t_docId *curTarg
           // The child iterator did not find the requested docId, so we need to advance the lastDocId
           // to the next possible value (the result that the child iterator yielded)
           *curTarget = it->its[i]->lastDocId;
+          it->rejects[i]++;
         }
         return rc;
       }
     }
   }
-  // All iterators agree on the docId, so we can set the current result
+  // All iterators agree on the docId, so we can set the current result. The children are added in
+  // the order of `its` rather than `order`, so the result does not depend on the reorderings
   IndexResult_ResetAggregate(it->base.current);
   for (uint32_t i = 0; i < it->num_its; i++) {
     RS_ASSERT(docId == it->its[i]->current->docId);
@@ -128,6 +196,18 @@ static IteratorStatus II_Read(QueryIterator *base) {
   return rc;
 }
 
+// Batched read of the fast path. The children are still advanced one consensus at a time, but
+// the loop calls `II_Read` directly rather than through the iterator's vtable
+static IteratorStatus II_ReadBatch(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  IteratorStatus rc = ITERATOR_OK;
+  size_t n = 0;
+  while (n < cap && (rc = II_Read(base)) == ITERATOR_OK) {
+    out[n++] = base->lastDocId;
+  }
+  *numRead = n;
+  return n ? ITERATOR_OK : rc;
+}
+
 static IteratorStatus II_SkipTo_CheckRelevancy(QueryIterator *base, t_docId docId) {
   RS_ASSERT(base->lastDocId < docId);
   IntersectionIterator *it = (IntersectionIterator *)base;
@@ -177,6 +257,127 @@ static IteratorStatus II_SkipTo(QueryIterator *base, t_docId docId) {
   return rc;
 }
 
+/*********************************** Block Reads ***********************************/
+
+// Number of ids to read ahead from the densest child
+#define II_PEEK_SIZE 256
+// Minimal number of ids to read ahead from any child
+#define II_PEEK_MIN_SIZE 16
+// Above this ratio between the estimations of the children, the dense children would read many ids
+// ahead for every id of the sparse ones, and plain skipping is cheaper
+#define II_PEEK_MAX_RATIO 16
+
+static inline void II_ResetCandidates(IntersectionIterator *it) {
+  it->num_candidates = 0;
+  it->candidate_pos = 0;
+}
+
+// Check if block reads can be used with the current children. Sets `maxEst` to the highest
+// estimation of the children
+static bool II_CanReadBlocks(const IntersectionIterator *it, size_t *maxEst) {
+  size_t minEst = SIZE_MAX;
+  *maxEst = 0;
+  for (uint32_t i = 0; i < it->num_its; i++) {
+    QueryIterator *child = it->its[i];
+    if (!InvIndIterator_CanPeek(child)) {
+      return false;
+    }
+    size_t est = child->NumEstimated(child);
+    minEst = MIN(minEst, est);
+    *maxEst = MAX(*maxEst, est);
+  }
+  return minEst > 0 && *maxEst / minEst <= II_PEEK_MAX_RATIO;
+}
+
+// Allocate the buffers of block reads, if they can be used with the current children
+static bool II_InitBlockReads(IntersectionIterator *it) {
+  size_t maxEst;
+  if (!II_CanReadBlocks(it, &maxEst)) {
+    return false;
+  }
+  // Read ahead from each child according to its density, so all of them cover a similar range of ids
+  it->peekSizes = rm_malloc(it->num_its * sizeof(*it->peekSizes));
+  for (uint32_t i = 0; i < it->num_its; i++) {
+    size_t est = it->its[i]->NumEstimated(it->its[i]);
+    it->peekSizes[i] = MAX(II_PEEK_MIN_SIZE, II_PEEK_SIZE * est / maxEst);
+  }
+  it->candidates = rm_malloc(II_PEEK_SIZE * sizeof(*it->candidates));
+  it->peeked = rm_malloc(II_PEEK_SIZE * sizeof(*it->peeked));
+  it->scratch = rm_malloc(II_PEEK_SIZE * sizeof(*it->scratch));
+  II_ResetCandidates(it);
+  return true;
+}
+
+// Refill the candidates with the ids the next ids of all the children have in common.
+// Sets `horizon` to the highest id all the children read ahead up to, meaning that there are no
+// other common ids up to it.
+static IteratorStatus II_FillCandidates(IntersectionIterator *it, t_docId *horizon) {
+  size_t n = 0;
+  t_docId maxId = DOCID_MAX;
+  for (uint32_t i = 0; i < it->num_its; i++) {
+    t_docId *ids = i == 0 ? it->candidates : it->peeked;
+    size_t m = InvIndIterator_PeekIds(it->its[i], ids, it->peekSizes[i]);
+    if (m == 0) {
+      // Some child has no more results, so the intersection is at EOF
+      it->base.atEOF = true;
+      return ITERATOR_EOF;
+    }
+    maxId = MIN(maxId, ids[m - 1]);
+    if (i == 0) {
+      n = m;
+      continue;
+    }
+    // Only the ids up to the horizon so far may be common to all the children
+    n = SortedIds_Intersect(it->candidates, SortedIds_CountUpTo(it->candidates, n, maxId),
+                            ids, SortedIds_CountUpTo(ids, m, maxId), it->scratch);
+    t_docId *tmp = it->candidates;
+    it->candidates = it->scratch;
+    it->scratch = tmp;
+  }
+  it->num_candidates = n;
+  it->candidate_pos = 0;
+  *horizon = maxId;
+  return ITERATOR_OK;
+}
+
+// Read implementation for intersections of term (or any inverted index) iterators of similar sizes.
+// Rather than agreeing on every id of the first child, we read ahead the next ids of all the
+// children, intersect them at once, and only advance the children to the common ids.
+static IteratorStatus II_Read_Blocks(QueryIterator *base) {
+  IntersectionIterator *it = (IntersectionIterator *)base;
+  if (base->atEOF) {
+    return ITERATOR_EOF;
+  }
+  if (!it->candidates && !II_InitBlockReads(it)) {
+    // Not applicable (children may have been added after construction). Fall back to the fast path
+    base->Read = II_Read;
+    base->SkipTo = II_SkipTo;
+    base->ReadBatch = II_ReadBatch;
+    return II_Read(base);
+  }
+  // Skip candidates the children have already passed
+  while (it->candidate_pos < it->num_candidates && it->candidates[it->candidate_pos] <= base->lastDocId) {
+    it->candidate_pos++;
+  }
+  if (it->candidate_pos == it->num_candidates) {
+    t_docId horizon;
+    IteratorStatus rc = II_FillCandidates(it, &horizon);
+    if (rc != ITERATOR_OK) {
+      return rc;
+    }
+    if (it->num_candidates == 0) {
+      // No common id up to the horizon. Advance the children past it
+      return II_Find_Consensus(it, horizon + 1);
+    }
+  }
+  return II_Find_Consensus(it, it->candidates[it->candidate_pos++]);
+}
+
+static IteratorStatus II_SkipTo_Blocks(QueryIterator *base, t_docId docId) {
+  II_ResetCandidates((IntersectionIterator *)base);
+  return II_SkipTo(base, docId);
+}
+
 static size_t II_NumEstimated(QueryIterator *base) {
   IntersectionIterator *it = (IntersectionIterator *)base;
   return it->num_expected;
@@ -188,6 +389,7 @@ static void II_Rewind(QueryIterator *base) {
   base->atEOF = false;
   base->lastDocId = 0;
   IndexResult_ResetAggregate(base->current);
+  II_ResetCandidates(ii);
 
   // rewind all child iterators
   for (uint32_t i = 0; i < ii->num_its; i++) {
@@ -204,6 +406,12 @@ static void II_Free(QueryIterator *base) {
   }
 
   rm_free(ii->its);
+  rm_free(ii->candidates);
+  rm_free(ii->peeked);
+  rm_free(ii->scratch);
+  rm_free(ii->peekSizes);
+  rm_free(ii->order);
+  rm_free(ii->rejects);
   IndexResult_Free(base->current);
   rm_free(base);
 }
@@ -228,7 +436,8 @@ static int cmpIter(QueryIterator **it1, QueryIterator **it2) {
   double factor2 = iteratorFactor(*it2);
   double est1 = (*it1)->NumEstimated(*it1) * factor1;
   double est2 = (*it2)->NumEstimated(*it2) * factor2;
-  return (int)(est1 - est2);
+  // A difference of the estimates may be below 1, or beyond the range of an int
+  return (est1 > est2) - (est1 < est2);
 }
 
 // Set estimation for number of results.
@@ -316,6 +525,9 @@ static ValidateStatus II_Revalidate(QueryIterator *base) {
   bool any_child_moved = false, movedToEOF = false;
   t_docId max_child_docId = 0;
 
+  // The children may have moved, or their indexes changed. Read ahead again
+  II_ResetCandidates(ii);
+
   // Step 1: Revalidate all children and track status
   for (uint32_t i = 0; i < ii->num_its; i++) {
     QueryIterator *child = ii->its[i];
@@ -374,6 +586,7 @@ QueryIterator *NewIntersectionIterator(QueryIterator **its, size_t num, int max_
   if (!in_order) {
     qsort(its, num, sizeof(*its), (CompareFunc)cmpIter);
   }
+  II_ResetOrder(it);
 
   // bind the iterator calls
   ret = &it->base;
@@ -382,14 +595,22 @@ QueryIterator *NewIntersectionIterator(QueryIterator **its, size_t num, int max_
   ret->lastDocId = 0;
   ret->current = NewIntersectResult(num, weight);
   ret->NumEstimated = II_NumEstimated;
-  if (max_slop < 0 && !in_order) {
+  size_t maxEst;
+  if (max_slop < 0 && !in_order && II_CanReadBlocks(it, &maxEst)) {
+    // Every result is relevant, and the children can read ahead. Intersect blocks of their ids
+    ret->Read = II_Read_Blocks;
+    ret->SkipTo = II_SkipTo_Blocks;
+    ret->ReadBatch = Default_ReadBatch;
+  } else if (max_slop < 0 && !in_order) {
     // No slop and no order means every result is relevant, so we can use the fast path
     ret->Read = II_Read;
     ret->SkipTo = II_SkipTo;
+    ret->ReadBatch = II_ReadBatch;
   } else {
     // Otherwise, we need to check relevancy
     ret->Read = II_Read_CheckRelevancy;
     ret->SkipTo = II_SkipTo_CheckRelevancy;
+    ret->ReadBatch = Default_ReadBatch;
   }
   ret->Free = II_Free;
   ret->Rewind = II_Rewind;
@@ -26,6 +26,23 @@ typedef struct IntersectionIterator {
   bool in_order;
 
   size_t num_expected;
+
+  // Block reads (see `II_Read_Blocks`). The ids every child yields next are read ahead and
+  // intersected at once, and only the common ids are then read from the children
+  t_docId *candidates;       // the common ids to read next. NULL if block reads are not used
+  t_docId *peeked;           // scratch buffers for reading ahead and intersecting ids
+  t_docId *scratch;
+  size_t *peekSizes;         // number of ids to read ahead from each child
+  size_t num_candidates;
+  size_t candidate_pos;      // index of the next candidate
+
+  // Adaptive ordering (see `II_AgreeOnDocId`). The children are advanced in the order of `order`,
+  // whose first child leads the intersection. It is re-picked from the number of candidate ids
+  // each child actually rejected, as the estimations the children were sorted by may be loose
+  uint32_t *order;           // indexes into `its`
+  uint32_t *rejects;         // number of candidates rejected by each child of `its`
+  uint32_t num_ordered;      // number of children `order` was built for
+  uint32_t num_checks;       // candidates checked since the last reordering
 } IntersectionIterator;
 
 /**
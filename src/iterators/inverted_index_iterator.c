@@ -9,6 +9,9 @@
 
 #include "inverted_index_iterator.h"
 #include "redis_index.h"
+#include "impact_postings.h"
+#include "spec.h"
+#include "util/minmax.h"
 
 void InvIndIterator_Free(QueryIterator *it) {
   if (!it) return;
@@ -31,6 +34,18 @@ size_t InvIndIterator_NumEstimated(QueryIterator *base) {
   return IndexReader_NumEstimated(it->reader);
 }
 
+// A range at the edge of the filter holds values which do not match it. The histogram of the tree
+// estimates how many of them do
+static size_t NumericInvIndIterator_NumEstimated(QueryIterator *base) {
+  NumericInvIndIterator *it = (NumericInvIndIterator *)base;
+  const NumericFilter *f = IndexReader_NumericFilter(it->base.reader);
+  size_t numDocs = IndexReader_NumEstimated(it->base.reader);
+  double min = MAX(f->min, it->base.profileCtx.numeric.rangeMin);
+  double max = MIN(f->max, it->base.profileCtx.numeric.rangeMax);
+  size_t estimate = NumericHistogram_Estimate(&it->rt->histogram, min, max);
+  return MIN(numDocs, estimate);
+}
+
 static ValidateStatus NumericCheckAbort(QueryIterator *base) {
   NumericInvIndIterator *nit = (NumericInvIndIterator *)base;
   InvIndIterator *it = (InvIndIterator *)base;
@@ -39,7 +54,7 @@ static ValidateStatus NumericCheckAbort(QueryIterator *base) {
     return VALIDATE_OK;
   }
 
-  if (nit->rt->revisionId != nit->revisionId) {
+  if (NumericRangeTree_RevisionId(nit->rt) != nit->revisionId) {
     // The numeric tree was either completely deleted or a node was split or removed.
     // The cursor is invalidated.
     return VALIDATE_ABORTED;
@@ -48,6 +63,22 @@ static ValidateStatus NumericCheckAbort(QueryIterator *base) {
   return VALIDATE_OK;
 }
 
+static ValidateStatus ImpactCheckAbort(QueryIterator *base) {
+  InvIndIterator *it = (InvIndIterator *)base;
+  if (!it->sctx) {
+    return VALIDATE_OK;
+  }
+  RSQueryTerm *term = IndexResult_QueryTermRef(base->current);
+  InvertedIndex *idx = Redis_OpenInvertedIndex(it->sctx, term->str, term->len, false, NULL);
+  const InvertedIndex *top =
+      idx ? ImpactPostings_Get(it->sctx->spec->impactPostings, term->str, term->len, idx) : NULL;
+  if (!top || !IndexReader_IsIndex(it->reader, top)) {
+    // The top documents of the term were selected again, or its postings were dropped
+    return VALIDATE_ABORTED;
+  }
+  return VALIDATE_OK;
+}
+
 static ValidateStatus TermCheckAbort(QueryIterator *base) {
   InvIndIterator *it = (InvIndIterator *)base;
   if (!it->sctx) {
@@ -274,6 +305,84 @@ IteratorStatus InvIndIterator_Read_SkipMulti_CheckExpiration(QueryIterator *base
   return ITERATOR_EOF;
 }
 
+/********************************** ReadBatch Implementations **********************************/
+
+// Returns true if the iterator should skip multi-values from the same document
+static inline bool ShouldSkipMulti(const InvIndIterator *it) {
+  return it->skipMulti &&                       // Skip multi-values is requested
+        IndexReader_HasMulti(it->reader); // The index holds multi-values (if not, no need to check)
+}
+
+// Batched read without expiration checks. The reader reads the whole batch in a loop specialized
+// for its encoding and filter, instead of being called for each entry
+static IteratorStatus InvIndIterator_ReadBatch_Ids(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  InvIndIterator *it = (InvIndIterator *)base;
+  size_t n = 0;
+  if (!base->atEOF) {
+    n = IndexReader_NextIds(it->reader, base->current, base->lastDocId, ShouldSkipMulti(it), out, cap);
+    base->atEOF = n < cap;
+  }
+  *numRead = n;
+  if (!n) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  base->lastDocId = out[n - 1];
+  return ITERATOR_OK;
+}
+
+// Batched reads checking the expiration, one per read implementation. Calling the read
+// implementation directly lets the compiler inline it into the loop, instead of paying for an
+// indirect call per entry.
+static inline IteratorStatus InvIndIterator_ReadBatch(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead,
+                                                      IteratorStatus (*read)(QueryIterator *)) {
+  IteratorStatus rc = ITERATOR_OK;
+  size_t n = 0;
+  while (n < cap && (rc = read(base)) == ITERATOR_OK) {
+    out[n++] = base->lastDocId;
+  }
+  *numRead = n;
+  return n ? ITERATOR_OK : rc;
+}
+
+static IteratorStatus InvIndIterator_ReadBatch_CheckExpiration(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  return InvIndIterator_ReadBatch(base, out, cap, numRead, InvIndIterator_Read_CheckExpiration);
+}
+
+static IteratorStatus InvIndIterator_ReadBatch_SkipMulti_CheckExpiration(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  return InvIndIterator_ReadBatch(base, out, cap, numRead, InvIndIterator_Read_SkipMulti_CheckExpiration);
+}
+
+bool InvIndIterator_CanPeek(const QueryIterator *it) {
+  // Any other read implementation filters some of the records out (multi-values, expired fields)
+  return it->type == INV_IDX_ITERATOR && it->Read == InvIndIterator_Read_Default;
+}
+
+size_t InvIndIterator_PeekIds(const QueryIterator *it, t_docId *out, size_t cap) {
+  RS_ASSERT(InvIndIterator_CanPeek(it));
+  if (it->atEOF) {
+    return 0;
+  }
+  RSIndexResult scratch = *it->current; // Decode into a copy, the current result must remain valid
+  return IndexReader_PeekIds(((const InvIndIterator *)it)->reader, &scratch, out, cap);
+}
+
+bool InvIndIterator_NumResults(const QueryIterator *it, size_t *numResults) {
+  if (it->type != INV_IDX_ITERATOR || it->lastDocId || it->atEOF) {
+    return false;
+  }
+  const InvIndIterator *iit = (const InvIndIterator *)it;
+  // The reads checking the expiration of the fields skip some of the documents, and the default
+  // read yields the multi-values of a document apart
+  bool unique = it->Read == InvIndIterator_Read_SkipMulti ||
+                (it->Read == InvIndIterator_Read_Default && !IndexReader_HasMulti(iit->reader));
+  if (iit->filtered || !unique) {
+    return false;
+  }
+  *numResults = IndexReader_NumEstimated(iit->reader);
+  return true;
+}
+
 /************************************ SkipTo Implementations ************************************/
 
 // 1. Default SkipTo implementation, without any additional filtering.
@@ -394,12 +503,6 @@ static inline bool HasExpiration(const InvIndIterator *it) {
          (it->filterCtx.field.isFieldMask || it->filterCtx.field.value.index != RS_INVALID_FIELD_INDEX);  // Context is a field mask or a valid index
 }
 
-// Returns true if the iterator should skip multi-values from the same document
-static inline bool ShouldSkipMulti(const InvIndIterator *it) {
-  return it->skipMulti &&                       // Skip multi-values is requested
-        IndexReader_HasMulti(it->reader); // The index holds multi-values (if not, no need to check)
-}
-
 static QueryIterator *InitInvIndIterator(InvIndIterator *it, const InvertedIndex *idx, RSIndexResult *res, const FieldFilterContext *filterCtx,
                                         bool skipMulti, const RedisSearchCtx *sctx, IndexDecoderCtx *decoderCtx, ValidateStatus (*checkAbortFn)(QueryIterator *)) {
   it->reader = NewIndexReader(idx, *decoderCtx);
@@ -407,6 +510,8 @@ static QueryIterator *InitInvIndIterator(InvIndIterator *it, const InvertedIndex
   it->sctx = sctx;
   it->filterCtx = *filterCtx;
   it->isWildcard = false;
+  it->filtered = decoderCtx->tag == IndexDecoderCtx_Numeric ||
+                 (decoderCtx->tag == IndexDecoderCtx_FieldMask && decoderCtx->field_mask != RS_FIELDMASK_ALL);
   it->CheckAbort = (ValidateStatus (*)(struct InvIndIterator *))checkAbortFn;
 
   QueryIterator *base = &it->base;
@@ -424,7 +529,7 @@ static QueryIterator *InitInvIndIterator(InvIndIterator *it, const InvertedIndex
   bool hasSeeker = IndexReader_HasSeeker(it->reader);
   bool hasExpiration = HasExpiration(it);
 
-  // Read function choice:
+  // Read (and ReadBatch) function choice:
   // skip multi     |  no                   |  yes
   // ------------------------------------------------------------------------
   // no expiration  |  Read_Default         |  Read_SkipMulti
@@ -432,12 +537,16 @@ static QueryIterator *InitInvIndIterator(InvIndIterator *it, const InvertedIndex
 
   if (skipMulti && hasExpiration) {
     base->Read = InvIndIterator_Read_SkipMulti_CheckExpiration;
+    base->ReadBatch = InvIndIterator_ReadBatch_SkipMulti_CheckExpiration;
   } else if (skipMulti) { // skipMulti && !hasExpiration
     base->Read = InvIndIterator_Read_SkipMulti;
+    base->ReadBatch = InvIndIterator_ReadBatch_Ids;
   } else if (hasExpiration) { // !skipMulti && hasExpiration
     base->Read = InvIndIterator_Read_CheckExpiration;
+    base->ReadBatch = InvIndIterator_ReadBatch_CheckExpiration;
   } else { // !skipMulti && !hasExpiration
     base->Read = InvIndIterator_Read_Default;
+    base->ReadBatch = InvIndIterator_ReadBatch_Ids;
   }
 
   // SkipTo function choice:
@@ -478,7 +587,7 @@ static QueryIterator *NewInvIndIterator_NumericRange(const InvertedIndex *idx, R
     RedisModuleString *numField = IndexSpec_GetFormattedKey(sctx->spec, fieldSpec, INDEXFLD_T_NUMERIC);
     NumericRangeTree *rt = openNumericKeysDict(sctx->spec, numField, DONT_CREATE_INDEX);
     RS_ASSERT(rt);
-    it->revisionId = rt->revisionId;
+    it->revisionId = NumericRangeTree_RevisionId(rt);
     it->rt = rt;
   }
 
@@ -532,6 +641,9 @@ QueryIterator *NewInvIndIterator_NumericQuery(const InvertedIndex *idx, const Re
   InvIndIterator *it = (InvIndIterator *)ret;
   it->profileCtx.numeric.rangeMin = rangeMin;
   it->profileCtx.numeric.rangeMax = rangeMax;
+  if (flt && NumericFilter_IsNumeric(flt) && ((NumericInvIndIterator *)it)->rt) {
+    ret->NumEstimated = NumericInvIndIterator_NumEstimated;
+  }
   return ret;
 }
 
@@ -545,16 +657,19 @@ static inline double CalculateIDF_BM25(size_t totalDocs, size_t termDocs) {
   return log(1.0F + (totalDocs - termDocs + 0.5F) / (termDocs + 0.5F));
 }
 
-QueryIterator *NewInvIndIterator_TermQuery(const InvertedIndex *idx, const RedisSearchCtx *sctx, FieldMaskOrIndex fieldMaskOrIndex,
-                                           RSQueryTerm *term, double weight) {
+// The IDF of the term is that of `statsIdx`, its full inverted index
+static QueryIterator *newTermQuery(const InvertedIndex *idx, const InvertedIndex *statsIdx,
+                                   const RedisSearchCtx *sctx, FieldMaskOrIndex fieldMaskOrIndex,
+                                   RSQueryTerm *term, double weight,
+                                   ValidateStatus (*checkAbortFn)(QueryIterator *)) {
   FieldFilterContext fieldCtx = {
     .field = fieldMaskOrIndex,
     .predicate = FIELD_EXPIRATION_DEFAULT,
   };
   if (term && sctx) {
     // compute IDF based on num of docs in the header
-    term->idf = CalculateIDF(sctx->spec->docs.size, InvertedIndex_NumDocs(idx)); // FIXME: docs.size starts at 1???
-    term->bm25_idf = CalculateIDF_BM25(sctx->spec->stats.numDocuments, InvertedIndex_NumDocs(idx));
+    term->idf = CalculateIDF(sctx->spec->docs.size, InvertedIndex_NumDocs(statsIdx)); // FIXME: docs.size starts at 1???
+    term->bm25_idf = CalculateIDF_BM25(sctx->spec->stats.numDocuments, InvertedIndex_NumDocs(statsIdx));
   }
 
   RSIndexResult *record = NewTokenRecord(term, weight);
@@ -568,7 +683,18 @@ QueryIterator *NewInvIndIterator_TermQuery(const InvertedIndex *idx, const Redis
     dctx.field_mask = RS_FIELDMASK_ALL; // Also covers the case of a non-wide schema
   }
 
-  return NewInvIndIterator(idx, record, &fieldCtx, true, sctx, &dctx, TermCheckAbort);
+  return NewInvIndIterator(idx, record, &fieldCtx, true, sctx, &dctx, checkAbortFn);
+}
+
+QueryIterator *NewInvIndIterator_TermQuery(const InvertedIndex *idx, const RedisSearchCtx *sctx, FieldMaskOrIndex fieldMaskOrIndex,
+                                           RSQueryTerm *term, double weight) {
+  return newTermQuery(idx, idx, sctx, fieldMaskOrIndex, term, weight, TermCheckAbort);
+}
+
+QueryIterator *NewInvIndIterator_ImpactQuery(const InvertedIndex *top, const InvertedIndex *idx,
+                                             const RedisSearchCtx *sctx, FieldMaskOrIndex fieldMaskOrIndex,
+                                             RSQueryTerm *term, double weight) {
+  return newTermQuery(top, idx, sctx, fieldMaskOrIndex, term, weight, ImpactCheckAbort);
 }
 
 QueryIterator *NewInvIndIterator_TagQuery(const InvertedIndex *idx, const TagIndex *tagIdx, const RedisSearchCtx *sctx, FieldMaskOrIndex fieldMaskOrIndex,
@@ -30,6 +30,9 @@ typedef struct InvIndIterator {
   // Whether this iterator is result of a wildcard query
   bool isWildcard;
 
+  // Whether the reader skips some of the records of the index, by their field mask or their value
+  bool filtered;
+
   union {
     struct {
       double rangeMin;
@@ -57,6 +60,19 @@ typedef struct {
   const TagIndex *tagIdx; // not const, may reopen on revalidation
 } TagInvIndIterator;
 
+// Check if the ids the iterator yields next can be read ahead with `InvIndIterator_PeekIds`, i.e. the
+// iterator yields every record its reader decodes, with no additional filtering
+bool InvIndIterator_CanPeek(const QueryIterator *it);
+
+// Read ahead the ids of up to `cap` next results of the iterator into `out`, without moving it.
+// Returns the number of ids written to `out`
+size_t InvIndIterator_PeekIds(const QueryIterator *it, t_docId *out, size_t cap);
+
+// Set `numResults` to the number of results the iterator yields, if it was not read yet and yields
+// every document of its index once, so that they are the number of documents of the index.
+// Returns false, leaving `numResults` as is, otherwise
+bool InvIndIterator_NumResults(const QueryIterator *it, size_t *numResults);
+
 // API for full index scan. Not suitable for queries
 QueryIterator *NewInvIndIterator_NumericFull(const InvertedIndex *idx);
 // API for full index scan. Not suitable for queries
@@ -70,6 +86,12 @@ QueryIterator *NewInvIndIterator_NumericQuery(const InvertedIndex *idx, const Re
 QueryIterator *NewInvIndIterator_TermQuery(const InvertedIndex *idx, const RedisSearchCtx *sctx, FieldMaskOrIndex fieldMaskOrIndex,
                                            RSQueryTerm *term, double weight);
 
+// Returns an iterator over `top`, the impact postings of a term whose full inverted index is `idx`
+// (see impact_postings.h), suitable for ranked queries
+QueryIterator *NewInvIndIterator_ImpactQuery(const InvertedIndex *top, const InvertedIndex *idx,
+                                             const RedisSearchCtx *sctx, FieldMaskOrIndex fieldMaskOrIndex,
+                                             RSQueryTerm *term, double weight);
+
 // Returns an iterator for a wildcard index (optimized for wildcard queries) - mainly to revalidate the index
 QueryIterator *NewInvIndIterator_WildcardQuery(const InvertedIndex *idx, const RedisSearchCtx *sctx, double weight);
 
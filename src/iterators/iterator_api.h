@@ -44,6 +44,7 @@ enum IteratorType {
   METRIC_ITERATOR,
   PROFILE_ITERATOR,
   OPTIMUS_ITERATOR,
+  SAMPLE_ITERATOR,
   MAX_ITERATOR,
 };
 
@@ -101,6 +102,16 @@ typedef struct QueryIterator {
 
   /* Rewind the iterator to the beginning and reset its state (including `atEOF` and `lastDocId`) */
   void (*Rewind)(struct QueryIterator *self);
+
+  /** Read up to `cap` next entries from the iterator, writing their ids to `out` (in increasing order)
+   *  and their number to `*numRead`. Equivalent to calling `Read` up to `cap` times, but amortizes the
+   *  call overhead over a whole batch of ids.
+   *  After the call, `lastDocId` and `current` refer to the last id written to `out`. The results of the
+   *  other ids of the batch are not retained, so this is only useful for callers that need the ids alone.
+   *  @returns ITERATOR_OK if at least one id was read (even if the iterator reached its end meanwhile),
+   *  or the status of the failing read otherwise (never `ITERATOR_NOTFOUND`)
+   */
+  IteratorStatus (*ReadBatch)(struct QueryIterator *self, t_docId *out, size_t cap, size_t *numRead);
 } QueryIterator;
 
 static inline ValidateStatus Default_Revalidate(struct QueryIterator *base) {
@@ -108,4 +119,15 @@ static inline ValidateStatus Default_Revalidate(struct QueryIterator *base) {
   return VALIDATE_OK;
 }
 
+// Generic batched read, in terms of the iterator's `Read`
+static inline IteratorStatus Default_ReadBatch(struct QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  IteratorStatus rc = ITERATOR_OK;
+  size_t n = 0;
+  while (n < cap && (rc = base->Read(base)) == ITERATOR_OK) {
+    out[n++] = base->lastDocId;
+  }
+  *numRead = n;
+  return n ? ITERATOR_OK : rc;
+}
+
 #endif
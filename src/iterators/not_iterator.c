@@ -11,6 +11,16 @@
 #include "wildcard_iterator.h"
 #include "empty_iterator.h"
 
+#include <string.h>
+
+// Children estimated to yield at least 1/NI_BITMAP_MIN_DENSITY of the ids are materialized into a
+// bitmap (see `NI_Materialize`), for ranges of at least NI_BITMAP_MIN_DOCS and at most
+// NI_BITMAP_MAX_DOCS ids (a bitmap of 16MB)
+#define NI_BITMAP_MIN_DENSITY 8
+#define NI_BITMAP_MIN_DOCS 4096
+#define NI_BITMAP_MAX_DOCS (1ULL << 27)
+#define NI_BITMAP_BATCH 1024
+
 static void NI_Rewind(QueryIterator *base) {
   NotIterator *ni = (NotIterator *)base;
   base->current->docId = 0;
@@ -29,6 +39,7 @@ static void NI_Free(QueryIterator *base) {
     ni->wcii->Free(ni->wcii);
   }
   IndexResult_Free(base->current);
+  rm_free(ni->excluded);
   rm_free(base);
 }
 
@@ -288,6 +299,203 @@ static ValidateStatus NI_Revalidate_Optimized(QueryIterator *base) {
   return wcii_status;
 }
 
+/********************************* Bitmap mode *********************************/
+
+// Read all the child's ids into the bitmap of excluded ids. Resumes where it stopped if a previous
+// call timed out
+static IteratorStatus NI_Materialize(NotIterator *ni) {
+  if (ni->materialized) {
+    return ITERATOR_OK;
+  }
+  if (!ni->excluded) {
+    ni->excluded = rm_calloc(ni->maxDocId / 64 + 1, sizeof(*ni->excluded));
+  }
+  t_docId ids[NI_BITMAP_BATCH];
+  size_t n;
+  IteratorStatus rc;
+  while ((rc = ni->child->ReadBatch(ni->child, ids, NI_BITMAP_BATCH, &n)) == ITERATOR_OK) {
+    for (size_t i = 0; i < n; i++) {
+      if (ids[i] <= ni->maxDocId) {
+        ni->excluded[ids[i] / 64] |= 1ULL << (ids[i] % 64);
+      }
+    }
+  }
+  if (rc != ITERATOR_EOF) {
+    return rc;
+  }
+  ni->materialized = true;
+  return ITERATOR_OK;
+}
+
+static inline bool NI_IsExcluded(const NotIterator *ni, t_docId docId) {
+  return docId <= ni->maxDocId && (ni->excluded[docId / 64] >> (docId % 64)) & 1;
+}
+
+// Find the first id from `docId` up to maxDocId which is not excluded, a whole word of the bitmap at
+// a time. Returns 0 if there is none
+static t_docId NI_NextIncluded(const NotIterator *ni, t_docId docId) {
+  if (docId > ni->maxDocId) {
+    return 0;
+  }
+  const size_t lastWord = ni->maxDocId / 64;
+  size_t w = docId / 64;
+  uint64_t word = ~ni->excluded[w] & (~0ULL << (docId % 64));
+  while (!word) {
+    if (++w > lastWord) {
+      return 0;
+    }
+    word = ~ni->excluded[w];
+  }
+  t_docId next = w * 64 + __builtin_ctzll(word);
+  return next <= ni->maxDocId ? next : 0;
+}
+
+/* Read from a NOT iterator - Non-Optimized bitmap version. Yields the ids up to max docId
+ * which are not set in the bitmap of the child */
+static IteratorStatus NI_Read_Bitmap(QueryIterator *base) {
+  NotIterator *ni = (NotIterator *)base;
+  if (base->atEOF || base->lastDocId >= ni->maxDocId) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  IteratorStatus rc = NI_Materialize(ni);
+  if (rc != ITERATOR_OK) return rc;
+
+  t_docId next = NI_NextIncluded(ni, base->lastDocId + 1);
+  if (!next) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  base->lastDocId = base->current->docId = next;
+  return ITERATOR_OK;
+}
+
+/* SkipTo for NOT iterator - Non-Optimized bitmap version */
+static IteratorStatus NI_SkipTo_Bitmap(QueryIterator *base, t_docId docId) {
+  NotIterator *ni = (NotIterator *)base;
+  RS_ASSERT(base->lastDocId < docId);
+  if (base->atEOF) {
+    return ITERATOR_EOF;
+  }
+  if (docId > ni->maxDocId) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  IteratorStatus rc = NI_Materialize(ni);
+  if (rc != ITERATOR_OK) return rc;
+
+  t_docId next = NI_NextIncluded(ni, docId);
+  if (!next) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  base->lastDocId = base->current->docId = next;
+  return next == docId ? ITERATOR_OK : ITERATOR_NOTFOUND;
+}
+
+/* Read from a NOT iterator - Optimized bitmap version. Yields the ids of the `existing docs`
+ * which are not set in the bitmap of the child */
+static IteratorStatus NI_Read_Bitmap_Optimized(QueryIterator *base) {
+  NotIterator *ni = (NotIterator *)base;
+  if (base->atEOF || base->lastDocId >= ni->maxDocId) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  IteratorStatus rc = NI_Materialize(ni);
+  if (rc != ITERATOR_OK) return rc;
+
+  while ((rc = ni->wcii->Read(ni->wcii)) == ITERATOR_OK) {
+    if (!NI_IsExcluded(ni, ni->wcii->lastDocId)) {
+      base->lastDocId = base->current->docId = ni->wcii->lastDocId;
+      return ITERATOR_OK;
+    }
+    if (TimedOut_WithCtx_Gran(&ni->timeoutCtx, 5000)) {
+      return ITERATOR_TIMEOUT;
+    }
+  }
+  if (rc == ITERATOR_EOF) {
+    base->atEOF = true;
+  }
+  return rc;
+}
+
+/* SkipTo for NOT iterator - Optimized bitmap version */
+static IteratorStatus NI_SkipTo_Bitmap_Optimized(QueryIterator *base, t_docId docId) {
+  NotIterator *ni = (NotIterator *)base;
+  RS_ASSERT(base->lastDocId < docId);
+  if (base->atEOF) {
+    return ITERATOR_EOF;
+  }
+  if (docId > ni->maxDocId) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  IteratorStatus rc = NI_Materialize(ni);
+  if (rc != ITERATOR_OK) return rc;
+
+  rc = ni->wcii->SkipTo(ni->wcii, docId);
+  if (rc == ITERATOR_TIMEOUT) return ITERATOR_TIMEOUT;
+  if (rc == ITERATOR_EOF) {
+    base->atEOF = true;
+    return rc;
+  }
+  if (!NI_IsExcluded(ni, ni->wcii->lastDocId)) {
+    // OK if the wildcard has docId, NOTFOUND if it is ahead
+    base->lastDocId = base->current->docId = ni->wcii->lastDocId;
+    return rc;
+  }
+  // The child has the wildcard's id - find the next valid result
+  base->lastDocId = ni->wcii->lastDocId;
+  rc = NI_Read_Bitmap_Optimized(base);
+  return rc == ITERATOR_OK ? ITERATOR_NOTFOUND : rc;
+}
+
+// Revalidate the child of a NOT iterator in bitmap mode. Once materialized, the bitmap is a snapshot
+// of the child, whose changes only affect deleted documents, so the child is no longer used
+static void NI_Revalidate_BitmapChild(NotIterator *ni) {
+  if (ni->materialized || ni->child->Revalidate(ni->child) != VALIDATE_ABORTED) {
+    return;
+  }
+  // When child is aborted, NOT iterator becomes "NOT nothing" = everything
+  ni->child->Free(ni->child);
+  ni->child = NewEmptyIterator();
+  if (ni->excluded) {
+    memset(ni->excluded, 0, (ni->maxDocId / 64 + 1) * sizeof(*ni->excluded));
+  }
+}
+
+// Revalidate for NOT iterator - Non-optimized bitmap version.
+static ValidateStatus NI_Revalidate_Bitmap(QueryIterator *base) {
+  NI_Revalidate_BitmapChild((NotIterator *)base);
+  return VALIDATE_OK;
+}
+
+// Revalidate for NOT iterator - Optimized bitmap version.
+static ValidateStatus NI_Revalidate_Bitmap_Optimized(QueryIterator *base) {
+  NotIterator *ni = (NotIterator *)base;
+  ValidateStatus wcii_status = ni->wcii->Revalidate(ni->wcii);
+  if (wcii_status == VALIDATE_ABORTED) {
+    return VALIDATE_ABORTED;
+  }
+  NI_Revalidate_BitmapChild(ni);
+  if (wcii_status == VALIDATE_MOVED) {
+    base->atEOF = ni->wcii->atEOF;
+    if (!base->atEOF) {
+      base->lastDocId = base->current->docId = ni->wcii->lastDocId;
+      if (NI_Materialize(ni) == ITERATOR_OK && NI_IsExcluded(ni, base->lastDocId)) {
+        NI_Read_Bitmap_Optimized(base);
+      }
+    }
+  }
+  return wcii_status;
+}
+
+// Dense children are excluded with a bitmap, sparse ones are skipped over
+static inline bool NI_UseBitmap(QueryIterator *child, t_docId maxDocId) {
+  return maxDocId >= NI_BITMAP_MIN_DOCS && maxDocId <= NI_BITMAP_MAX_DOCS &&
+         child->NumEstimated(child) * NI_BITMAP_MIN_DENSITY >= maxDocId;
+}
+
 /*
  * Reduce the not iterator by applying these rules:
  * 1. If the child is an empty iterator or NULL, return a wildcard iterator
@@ -325,7 +533,9 @@ QueryIterator *NewNotIterator(QueryIterator *it, t_docId maxDocId, double weight
   }
   ni->child = it;
   ni->maxDocId = maxDocId;          // Valid for the optimized case as well, since this is the maxDocId of the embedded wildcard iterator
-  ni->timeoutCtx = (TimeoutCtx){ .timeout = timeout, .counter = 0 };
+  ni->timeoutCtx = (TimeoutCtx){ .timeout = timeout, .counter = 0,
+                                 .cancel = q && q->sctx ? q->sctx->time.cancel : NULL };
+  const bool bitmap = NI_UseBitmap(it, maxDocId);
 
   ret->current = NewVirtualResult(weight, RS_FIELDMASK_ALL);
   ret->current->docId = 0;
@@ -334,10 +544,17 @@ QueryIterator *NewNotIterator(QueryIterator *it, t_docId maxDocId, double weight
   ret->lastDocId = 0;
   ret->NumEstimated = NI_NumEstimated;
   ret->Free = NI_Free;
-  ret->Read = optimized ? NI_Read_Optimized : NI_Read_NotOptimized;
-  ret->SkipTo = optimized ? NI_SkipTo_Optimized : NI_SkipTo_NotOptimized;
+  if (bitmap) {
+    ret->Read = optimized ? NI_Read_Bitmap_Optimized : NI_Read_Bitmap;
+    ret->SkipTo = optimized ? NI_SkipTo_Bitmap_Optimized : NI_SkipTo_Bitmap;
+    ret->Revalidate = optimized ? NI_Revalidate_Bitmap_Optimized : NI_Revalidate_Bitmap;
+  } else {
+    ret->Read = optimized ? NI_Read_Optimized : NI_Read_NotOptimized;
+    ret->SkipTo = optimized ? NI_SkipTo_Optimized : NI_SkipTo_NotOptimized;
+    ret->Revalidate = optimized ? NI_Revalidate_Optimized : NI_Revalidate_NotOptimized;
+  }
   ret->Rewind = NI_Rewind;
-  ret->Revalidate = optimized ? NI_Revalidate_Optimized : NI_Revalidate_NotOptimized;
+  ret->ReadBatch = Default_ReadBatch;
 
   return ret;
 }
@@ -358,10 +575,12 @@ QueryIterator *_New_NotIterator_With_WildCardIterator(QueryIterator *child, Quer
   ret->lastDocId = 0;
   ret->NumEstimated = NI_NumEstimated;
   ret->Free = NI_Free;
-  ret->Read = NI_Read_Optimized;
-  ret->SkipTo = NI_SkipTo_Optimized;
+  const bool bitmap = NI_UseBitmap(child, maxDocId);
+  ret->Read = bitmap ? NI_Read_Bitmap_Optimized : NI_Read_Optimized;
+  ret->SkipTo = bitmap ? NI_SkipTo_Bitmap_Optimized : NI_SkipTo_Optimized;
   ret->Rewind = NI_Rewind;
-  ret->Revalidate = NI_Revalidate_Optimized;
+  ret->Revalidate = bitmap ? NI_Revalidate_Bitmap_Optimized : NI_Revalidate_Optimized;
+  ret->ReadBatch = Default_ReadBatch;
 
   return ret;
 }
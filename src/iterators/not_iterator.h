@@ -23,6 +23,12 @@ typedef struct {
   QueryIterator *child;       // child index iterator
   t_docId maxDocId;
   TimeoutCtx timeoutCtx;
+
+  // Bitmap mode (see `NI_Materialize`), for dense children. The child's ids are read at once into
+  // a bitmap of the excluded ids, and the candidate ids are checked against it instead of
+  // advancing the child for every excluded id
+  uint64_t *excluded;         // bit `id` is set if the child has `id`. NULL until first used
+  bool materialized;          // all the child's ids are in `excluded`
 } NotIterator;
 
 /**
@@ -35,6 +35,9 @@ static inline double getSuccessRatio(const OptimizerIterator *optIt) {
 
 static size_t OPT_NumEstimated(QueryIterator *self) {
   OptimizerIterator *opt = (OptimizerIterator *)self;
+  if (!opt->numericIter) {
+    return MIN(opt->child->NumEstimated(opt->child), opt->optim->limit);
+  }
   return MIN(opt->child->NumEstimated(opt->child) ,
               opt->numericIter->NumEstimated(opt->numericIter));
 }
@@ -45,7 +48,7 @@ static ValidateStatus OPT_Validate(QueryIterator *self) {
   if (opt->child->Revalidate(opt->child) != VALIDATE_OK) {
     return VALIDATE_ABORTED;
   }
-  if (opt->numericIter->Revalidate(opt->numericIter) != VALIDATE_OK) {
+  if (opt->numericIter && opt->numericIter->Revalidate(opt->numericIter) != VALIDATE_OK) {
     return VALIDATE_ABORTED;
   }
   return VALIDATE_OK;
@@ -64,7 +67,7 @@ static void OPT_Rewind(QueryIterator *self) {
   // used to skip ranges when creating new numeric iterator
   QueryIterator *numeric = optIt->numericIter;
   NumericFilter *nf = qOpt->nf;
-  nf->offset += numeric->NumEstimated(numeric);
+  nf->offset += NumericFilter_RangesNumDocs(qOpt->sctx, nf);
   numeric->Free(numeric);
   optIt->numericIter = NULL;
 
@@ -103,6 +106,10 @@ void OptimizerIterator_Free(QueryIterator *self) {
     it->numericIter->Free(it->numericIter);
   }
 
+  if (it->rangesIter) {
+    NumericRangeTreeIterator_Free(it->rangesIter);
+  }
+
   // we always use the array as RSResultData_Numeric. no need for IndexResult_Free
   rm_free(it->resArr);
   heap_free(it->heap);
@@ -120,10 +127,44 @@ IteratorStatus OPT_ReadYield(QueryIterator *self) {
   return ITERATOR_EOF;
 }
 
+// Offer the numeric result of a matching document to the results heap
+static void OPT_Offer(OptimizerIterator *it, const RSIndexResult *numericRes) {
+  // copy the numeric result for the sorting heap
+  if (numericRes->data.tag == RSResultData_Numeric) {
+    *it->pooledResult = *numericRes;
+  } else {
+    const RSAggregateResult *agg = IndexResult_AggregateRef(numericRes);
+    const RSIndexResult *child = AggregateResult_Get(agg, 0);
+    RS_LOG_ASSERT(child->data.tag == RSResultData_Numeric, "???");
+    *it->pooledResult = *(child);
+  }
+
+  // handle expired results
+  const RSDocumentMetadata *dmd = DocTable_Borrow(&it->optim->sctx->spec->docs, numericRes->docId);
+  if (!dmd) {
+    return;
+  }
+  it->pooledResult->dmd = dmd;
+
+  // heap is not full. insert
+  if (heap_count(it->heap) < heap_size(it->heap)) {
+    heap_offer(&it->heap, it->pooledResult);
+    it->pooledResult++;
+
+  // heap is full. try to replace
+  } else {
+    RSIndexResult *tempRes = heap_peek(it->heap);
+    if (it->cmp(tempRes, it->pooledResult, NULL) > 0) {
+      heap_replace(it->heap, it->pooledResult);
+      it->pooledResult = tempRes;
+    }
+    DMD_Return(it->pooledResult->dmd);
+  }
+}
+
 IteratorStatus OPT_Read(QueryIterator *self) {
   IteratorStatus rc1, rc2;
   OptimizerIterator *it = (OptimizerIterator *)self;
-  QOptimizer *opt = it->optim;
 
   QueryIterator *child = it->child;
   QueryIterator *numeric = it->numericIter;
@@ -155,38 +196,7 @@ IteratorStatus OPT_Read(QueryIterator *self) {
       it->hitCounter++;
       if (childRes->docId == numericRes->docId) {
         self->lastDocId = childRes->docId;
-
-        // copy the numeric result for the sorting heap
-        if (numericRes->data.tag == RSResultData_Numeric) {
-          *it->pooledResult = *numericRes;
-        } else {
-          const RSAggregateResult *agg = IndexResult_AggregateRef(numericRes);
-          const RSIndexResult *child = AggregateResult_Get(agg, 0);
-          RS_LOG_ASSERT(child->data.tag == RSResultData_Numeric, "???");
-          *it->pooledResult = *(child);
-        }
-
-        // handle expired results
-        const RSDocumentMetadata *dmd = DocTable_Borrow(&opt->sctx->spec->docs, childRes->docId);
-        if (!dmd) {
-          continue;
-        }
-        it->pooledResult->dmd = dmd;
-
-        // heap is not full. insert
-        if (heap_count(it->heap) < heap_size(it->heap)) {
-          heap_offer(&it->heap, it->pooledResult);
-          it->pooledResult++;
-
-        // heap is full. try to replace
-        } else {
-          RSIndexResult *tempRes = heap_peek(it->heap);
-          if (it->cmp(tempRes, it->pooledResult, NULL) > 0) {
-            heap_replace(it->heap, it->pooledResult);
-            it->pooledResult = tempRes;
-          }
-          DMD_Return(it->pooledResult->dmd);
-        }
+        OPT_Offer(it, numericRes);
       }
     }
 
@@ -214,6 +224,68 @@ IteratorStatus OPT_Read(QueryIterator *self) {
   }
 }
 
+static NumericRangeTree *openSortbyTree(const QOptimizer *qOpt) {
+  IndexSpec *spec = qOpt->sctx->spec;
+  RedisModuleString *key = IndexSpec_GetFormattedKey(spec, qOpt->nf->fieldSpec, INDEXFLD_T_NUMERIC);
+  return key ? openNumericKeysDict(spec, key, DONT_CREATE_INDEX) : NULL;
+}
+
+// Read the leaves of the numeric tree one by one, in sort order. Once the heap is full, a leaf
+// whose values all come after the worst result in the heap ends the search, since so do the
+// leaves after it. Only the leaves up to the one completing the heap are read.
+static IteratorStatus OPT_ReadIndexOrder(QueryIterator *self) {
+  OptimizerIterator *it = (OptimizerIterator *)self;
+  QOptimizer *opt = it->optim;
+  const NumericFilter *nf = opt->nf;
+  FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index= it->numericFieldIndex}}, .predicate = FIELD_EXPIRATION_DEFAULT};
+
+  it->hitCounter = 0;
+  NumericRange *range;
+  while ((range = NumericRangeTreeIterator_NextLeaf(it->rangesIter, nf))) {
+    if (heap_count(it->heap) == heap_size(it->heap)) {
+      if (!heap_count(it->heap)) break;
+      double worst = IndexResult_NumValue((RSIndexResult *)heap_peek(it->heap));
+      if (nf->ascending ? range->minVal > worst : range->maxVal < worst) break;
+    }
+    QueryIterator *rangeIt = NewNumericRangeIterator(opt->sctx, range, nf, &filterCtx);
+    while (rangeIt->Read(rangeIt) == ITERATOR_OK) {
+      it->hitCounter++;
+      OPT_Offer(it, rangeIt->current);
+    }
+    rangeIt->Free(rangeIt);
+  }
+  // the tree is not accessed once the heap is filled
+  NumericRangeTreeIterator_Free(it->rangesIter);
+  it->rangesIter = NULL;
+
+  self->Read = OPT_ReadYield;
+  return OPT_ReadYield(self);
+}
+
+static void OPT_RewindIndexOrder(QueryIterator *self) {
+  OptimizerIterator *it = (OptimizerIterator *)self;
+  // return the documents of the results that were not yielded
+  while (heap_count(it->heap) > 0) {
+    RSIndexResult *res = heap_poll(it->heap);
+    DMD_Return(res->dmd);
+  }
+  it->pooledResult = it->resArr;
+
+  if (it->rangesIter) {
+    NumericRangeTreeIterator_Free(it->rangesIter);
+    it->rangesIter = NULL;
+  }
+  NumericRangeTree *t = openSortbyTree(it->optim);
+  if (t) {
+    it->rangesIter = NumericRangeTreeIterator_New(t);
+    self->Read = OPT_ReadIndexOrder;
+  } else {
+    self->Read = OPT_ReadYield;
+  }
+  self->atEOF = false;
+  self->lastDocId = 0;
+}
+
 QueryIterator *NewOptimizerIterator(QOptimizer *qOpt, QueryIterator *root, IteratorsConfig *config) {
   OptimizerIterator *oi = rm_calloc(1, sizeof(*oi));
   oi->child = root;
@@ -237,27 +309,40 @@ QueryIterator *NewOptimizerIterator(QOptimizer *qOpt, QueryIterator *root, Itera
   oi->lastLimitEstimate = qOpt->nf->limit =
     QOptimizer_EstimateLimit(oi->numDocs, oi->childEstimate, qOpt->limit);
 
-  FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index= field->index}}, .predicate = FIELD_EXPIRATION_DEFAULT};
   oi->numericFieldIndex = field->index;
-  oi->numericIter = NewNumericFilterIterator(qOpt->sctx, qOpt->nf, INDEXFLD_T_NUMERIC, config, &filterCtx);
-  if (!oi->numericIter) {
-    OptimizerIterator_Free(&oi->base);
-    return NewEmptyIterator();
-  }
-
-  oi->offset = oi->numericIter->NumEstimated(oi->numericIter);
   oi->config = config;
-
   QueryIterator *ri = &oi->base;
+
+  if (qOpt->type == Q_OPT_INDEX_ORDER) {
+    // the leaves are read one at a time, a numeric iterator over all of them is not needed
+    NumericRangeTree *t = openSortbyTree(qOpt);
+    if (!t) {
+      OptimizerIterator_Free(&oi->base);
+      return NewEmptyIterator();
+    }
+    oi->rangesIter = NumericRangeTreeIterator_New(t);
+    ri->Rewind = OPT_RewindIndexOrder;
+    ri->Read = OPT_ReadIndexOrder;
+  } else {
+    FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index= field->index}}, .predicate = FIELD_EXPIRATION_DEFAULT};
+    oi->numericIter = NewNumericFilterIterator(qOpt->sctx, qOpt->nf, INDEXFLD_T_NUMERIC, config, &filterCtx);
+    if (!oi->numericIter) {
+      OptimizerIterator_Free(&oi->base);
+      return NewEmptyIterator();
+    }
+    oi->offset = NumericFilter_RangesNumDocs(qOpt->sctx, qOpt->nf);
+    ri->Rewind = OPT_Rewind;
+    ri->Read = OPT_Read;
+  }
+
   ri->type = OPTIMUS_ITERATOR;
   ri->atEOF = false;
   ri->lastDocId = 0;
   ri->NumEstimated = OPT_NumEstimated;
   ri->Free = OptimizerIterator_Free;
-  ri->Rewind = OPT_Rewind;
   ri->Revalidate = OPT_Validate;
+  ri->ReadBatch = Default_ReadBatch;
   ri->SkipTo = NULL;            // The iterator is always on top and and Read() is called
-  ri->Read = OPT_Read;
   ri->current = NULL;
 
   return &oi->base;
@@ -11,6 +11,7 @@
 
 #include "query_optimizer.h"
 #include "iterators/iterator_api.h"
+#include "numeric_index.h"
 #include "redisearch.h"
 #include "util/heap.h"
 #include "util/timeout.h"
@@ -50,6 +51,8 @@ typedef struct {
 
   IteratorsConfig *config;       // Copy of current RSglobalconfig.IteratorsConfig
   t_fieldIndex numericFieldIndex; // field index for numeric filter
+
+  NumericRangeTreeIterator *rangesIter; // leaves of the numeric tree in sort order (Q_OPT_INDEX_ORDER)
 } OptimizerIterator;
 
 #ifdef __cplusplus
@@ -10,6 +10,14 @@
 #include "optional_iterator.h"
 #include "wildcard_iterator.h"
 #include "empty_iterator.h"
+#include "intersection_iterator.h"
+#include "inverted_index_iterator.h"
+#include "profile_iterator.h"
+#include "ext/default.h"
+#include "util/minmax.h"
+
+#include <limits.h>
+#include <string.h>
 
 static void OI_Free(QueryIterator *base) {
   OptionalIterator *oi = (OptionalIterator *)base;
@@ -20,6 +28,7 @@ static void OI_Free(QueryIterator *base) {
   }
   // Only free our virtual result, not the child's result
   IndexResult_Free(oi->virt);
+  rm_free(oi->required);
   rm_free(base);
 }
 
@@ -174,6 +183,48 @@ static IteratorStatus OI_Read_NotOptimized(QueryIterator *base) {
   return ITERATOR_OK;
 }
 
+// Whether a document of the intersection may enter the top-k results once the child contributes to
+// its score. The siblings are not all positioned on the document when the iterator leads the
+// intersection, in which case it can't tell
+static bool OI_MayCompete(const OptionalIterator *oi, t_docId docId) {
+  double bound = oi->maxContribution;
+  for (uint32_t i = 0; i < oi->numRequired; i++) {
+    const InvIndIterator *term = oi->required[i];
+    if (term->base.lastDocId != docId) {
+      return true;
+    }
+    const IndexBlock *blk = IndexReader_CurrentBlock(term->reader);
+    const RSQueryTerm *qt = IndexResult_QueryTermRef(term->base.current);
+    bound += BM25Std_TermUpperBound(qt->bm25_idf, term->base.current->weight, IndexBlock_MaxFreq(blk));
+  }
+  return bound * oi->intersectionWeight >= *oi->scoreThreshold;
+}
+
+// SkipTo for OPTIONAL iterator - Lazy version. The child is left behind on the documents that
+// can't compete, and advanced again on the next one that may
+static IteratorStatus OI_SkipTo_Lazy(QueryIterator *base, t_docId docId) {
+  OptionalIterator *oi = (OptionalIterator *)base;
+  if (!base->atEOF && docId <= oi->maxDocId && docId > oi->child->lastDocId &&
+      !oi->child->atEOF && !OI_MayCompete(oi, docId)) {
+    oi->virt->docId = docId;
+    base->current = oi->virt;
+    base->lastDocId = docId;
+    return ITERATOR_OK;
+  }
+  return OI_SkipTo_NotOptimized(base, docId);
+}
+
+// Read from an OPTIONAL iterator - Lazy version. The child may be behind, so the next document is
+// skipped to rather than read
+static IteratorStatus OI_Read_Lazy(QueryIterator *base) {
+  OptionalIterator *oi = (OptionalIterator *)base;
+  if (base->atEOF || base->lastDocId >= oi->maxDocId) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  return OI_SkipTo_Lazy(base, base->lastDocId + 1);
+}
+
 // Revalidate for OPTIONAL iterator - Non-optimized version.
 static ValidateStatus OI_Revalidate_NotOptimized(QueryIterator *base) {
   OptionalIterator *oi = (OptionalIterator *)base;
@@ -273,6 +324,100 @@ static QueryIterator* OptionalIteratorReducer(QueryIterator *it, QueryEvalCtx *q
   return ret;
 }
 
+static inline QueryIterator *OI_Unwrap(QueryIterator *it) {
+  return it->type == PROFILE_ITERATOR ? ((ProfileIterator *)it)->child : it;
+}
+
+// The term iterator of `it`, if the BM25STD score of its results can be bound
+static const InvIndIterator *OI_BoundedTerm(QueryIterator *it) {
+  it = OI_Unwrap(it);
+  if (it->type != INV_IDX_ITERATOR) {
+    return NULL;
+  }
+  const InvIndIterator *term = (const InvIndIterator *)it;
+  if (term->isWildcard || !(IndexReader_Flags(term->reader) & Index_StoreFreqs) ||
+      term->base.current->data.tag != RSResultData_Term || !IndexResult_QueryTermRef(term->base.current)) {
+    return NULL;
+  }
+  return term;
+}
+
+// The optional iterator of `it`, if it can be made lazy
+static OptionalIterator *OI_LazyCandidate(QueryIterator *it) {
+  it = OI_Unwrap(it);
+  if (it->type != OPTIONAL_ITERATOR || it->Read != OI_Read_NotOptimized) {
+    return NULL;
+  }
+  OptionalIterator *oi = (OptionalIterator *)it;
+  return OI_BoundedTerm(oi->child) ? oi : NULL;
+}
+
+bool OI_EnableLazy(QueryIterator *it, const double *threshold) {
+  if (it->type != INTERSECT_ITERATOR) {
+    return false;
+  }
+  IntersectionIterator *ii = (IntersectionIterator *)it;
+  // The relevancy check of a phrase reads the offsets of every child. A negative slop is kept as
+  // INT_MAX
+  if (ii->max_slop != INT_MAX || ii->in_order) {
+    return false;
+  }
+  OptionalIterator **optionals = rm_malloc(ii->num_its * sizeof(*optionals));
+  const InvIndIterator **required = rm_malloc(ii->num_its * sizeof(*required));
+  // The children, with the required terms first
+  QueryIterator **its = rm_malloc(ii->num_its * sizeof(*its));
+  uint32_t numOptional = 0, numRequired = 0;
+  bool bounded = true;
+  for (uint32_t i = 0; i < ii->num_its && bounded; i++) {
+    if ((required[numRequired] = OI_BoundedTerm(ii->its[i]))) {
+      its[numRequired++] = ii->its[i];
+    } else if ((optionals[numOptional] = OI_LazyCandidate(ii->its[i]))) {
+      numOptional++;
+    } else {
+      bounded = false;
+    }
+  }
+  if (!bounded || !numOptional || !numRequired) {
+    rm_free(optionals);
+    rm_free(required);
+    rm_free(its);
+    return false;
+  }
+  // An optional child estimates every document, so it may have been sorted first. It has to follow
+  // a required term, to be skipped to the documents the term leads to. Nothing was read yet, and the
+  // order of the intersection still follows `its`
+  for (uint32_t i = 0, j = numRequired; i < ii->num_its; i++) {
+    if (!OI_BoundedTerm(ii->its[i])) {
+      its[j++] = ii->its[i];
+    }
+  }
+  memcpy(ii->its, its, ii->num_its * sizeof(*its));
+  rm_free(its);
+
+  // Any of the other optional children may still contribute to a document left behind
+  double maxContribution = 0;
+  for (uint32_t i = 0; i < numOptional; i++) {
+    const InvIndIterator *term = OI_BoundedTerm(optionals[i]->child);
+    const RSQueryTerm *qt = IndexResult_QueryTermRef(term->base.current);
+    maxContribution += BM25Std_TermUpperBound(qt->bm25_idf, optionals[i]->weight,
+                                              IndexReader_MaxFreq(term->reader));
+  }
+  for (uint32_t i = 0; i < numOptional; i++) {
+    OptionalIterator *oi = optionals[i];
+    oi->required = rm_malloc(numRequired * sizeof(*oi->required));
+    memcpy(oi->required, required, numRequired * sizeof(*required));
+    oi->numRequired = numRequired;
+    oi->maxContribution = maxContribution;
+    oi->intersectionWeight = it->current->weight;
+    oi->scoreThreshold = threshold;
+    oi->base.Read = OI_Read_Lazy;
+    oi->base.SkipTo = OI_SkipTo_Lazy;
+  }
+  rm_free(optionals);
+  rm_free(required);
+  return true;
+}
+
 // Create a new OPTIONAL iterator - Non-Optimized version.
 QueryIterator *NewOptionalIterator(QueryIterator *it, QueryEvalCtx *q, double weight) {
   RS_ASSERT(q && q->sctx && q->sctx->spec && q->docTable);
@@ -300,6 +445,7 @@ QueryIterator *NewOptionalIterator(QueryIterator *it, QueryEvalCtx *q, double we
   ret->NumEstimated = OI_NumEstimated;
   ret->Free = OI_Free;
   ret->Rewind = OI_Rewind;
+  ret->ReadBatch = Default_ReadBatch;
   if (optimized) {
     ret->Read = OI_Read_Optimized;
     ret->SkipTo = OI_SkipTo_Optimized;
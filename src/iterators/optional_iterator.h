@@ -23,10 +23,29 @@ typedef struct {
   RSIndexResult *virt;
   t_docId maxDocId;
   double weight;
+
+  // Lazy mode (see `OI_EnableLazy`): the child is not advanced to the documents whose score upper
+  // bound, with the largest contribution the child may add, cannot enter the top-k results
+  const double *scoreThreshold;
+  const struct InvIndIterator **required;  // the term siblings of the iterator in the intersection
+  uint32_t numRequired;
+  double intersectionWeight;
+  double maxContribution;  // upper bound of the BM25STD score of all the lazy optional siblings
 } OptionalIterator;
 
 QueryIterator *NewOptionalIterator(QueryIterator *it, QueryEvalCtx *q, double weight);
 
+/**
+ * Make the optional term children of an intersection of terms lazy, for a search sorted by BM25STD
+ * score. `threshold` points at the minimal score a result must reach to enter the top-k heap.
+ * A child is then only advanced to the documents of the intersection whose required terms, bound
+ * by the maximal frequency of their current block, and the child itself, may reach it. The other
+ * documents get the virtual result of the child, which adds nothing to their score, so it only
+ * lowers the score of documents which are dropped anyway.
+ * @returns false if the intersection has no such children, or terms whose scores can't be bound
+ */
+bool OI_EnableLazy(QueryIterator *intersection, const double *threshold);
+
 #ifdef __cplusplus
 }
 #endif
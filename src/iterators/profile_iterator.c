@@ -53,6 +53,64 @@ static IteratorStatus PI_SkipTo(struct QueryIterator *self, t_docId docId) {
   return ret;
 }
 
+// Reading the counters is kept out of the time of the iterator
+static IteratorStatus HPI_Read(struct QueryIterator *self) {
+  ProfileIterator *pi = (ProfileIterator *)self;
+  PerfCounters begin, end;
+  const bool counted = PerfCounters_Read(&begin);
+  IteratorStatus ret = PI_Read(self);
+  if (counted && PerfCounters_Read(&end)) {
+    PerfCounters_AddDiff(&pi->counters.hw, &begin, &end);
+  }
+  return ret;
+}
+
+static IteratorStatus HPI_SkipTo(struct QueryIterator *self, t_docId docId) {
+  ProfileIterator *pi = (ProfileIterator *)self;
+  PerfCounters begin, end;
+  const bool counted = PerfCounters_Read(&begin);
+  IteratorStatus ret = PI_SkipTo(self, docId);
+  if (counted && PerfCounters_Read(&end)) {
+    PerfCounters_AddDiff(&pi->counters.hw, &begin, &end);
+  }
+  return ret;
+}
+
+static IteratorStatus CI_Read(struct QueryIterator *self) {
+  ProfileIterator *pi = (ProfileIterator *)self;
+  pi->counters.read++;
+  IteratorStatus ret = pi->child->Read(pi->child);
+  if (ret == ITERATOR_EOF) {
+    pi->counters.eof = 1;
+  }
+  SyncWithChild(pi);
+  return ret;
+}
+
+static IteratorStatus CI_SkipTo(struct QueryIterator *self, t_docId docId) {
+  ProfileIterator *pi = (ProfileIterator *)self;
+  pi->counters.skipTo++;
+  IteratorStatus ret = pi->child->SkipTo(pi->child, docId);
+  if (ret == ITERATOR_EOF) {
+    pi->counters.eof = 1;
+  }
+  SyncWithChild(pi);
+  return ret;
+}
+
+// Counted as the reads it stands for, and an EOF read if it reached the end, as if read one by one
+static IteratorStatus CI_ReadBatch(struct QueryIterator *self, t_docId *out, size_t cap, size_t *numRead) {
+  ProfileIterator *pi = (ProfileIterator *)self;
+  IteratorStatus ret = pi->child->ReadBatch(pi->child, out, cap, numRead);
+  pi->counters.read += *numRead;
+  if (ret == ITERATOR_EOF || pi->child->atEOF) {
+    pi->counters.read += !pi->counters.eof;
+    pi->counters.eof = 1;
+  }
+  SyncWithChild(pi);
+  return ret;
+}
+
 static void PI_Free(struct QueryIterator *self) {
   ProfileIterator *pi = (ProfileIterator *)self;
   pi->child->Free(pi->child);
@@ -97,6 +155,22 @@ QueryIterator *NewProfileIterator(QueryIterator *child) {
   ret->NumEstimated = PI_NumEstimated;
   ret->Rewind = PI_Rewind;
   ret->Revalidate = PI_Revalidate;
+  ret->ReadBatch = Default_ReadBatch;
+
+  return ret;
+}
+
+QueryIterator *NewHWProfileIterator(QueryIterator *child) {
+  QueryIterator *ret = NewProfileIterator(child);
+  ret->Read = HPI_Read;
+  ret->SkipTo = HPI_SkipTo;
+  return ret;
+}
 
+QueryIterator *NewCountingIterator(QueryIterator *child) {
+  QueryIterator *ret = NewProfileIterator(child);
+  ret->Read = CI_Read;
+  ret->SkipTo = CI_SkipTo;
+  ret->ReadBatch = CI_ReadBatch;
   return ret;
 }
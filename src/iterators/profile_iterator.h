@@ -10,11 +10,13 @@
 #pragma once
 
 #include "iterators/iterator_api.h"
+#include "util/perf_counters.h"
 
 typedef struct {
   size_t read;
   size_t skipTo;
   int eof;
+  PerfCounters hw;  // Only read by the iterators of NewHWProfileIterator
 } ProfileCounters;
 
 typedef struct {
@@ -34,3 +36,26 @@ typedef struct {
  * @return QueryIterator* The new profile iterator
  */
 QueryIterator *NewProfileIterator(QueryIterator *child);
+
+/**
+ * @brief Create a profile iterator that also reads the hardware counters of its child
+ *
+ * As `NewProfileIterator`, and the hardware counters of the thread are read before and after each
+ * call to its child (see perf_counters.h). The counts include those of the children of its child,
+ * as its time does. If the counters can not be read, it only profiles its child.
+ *
+ * @param child The iterator to wrap
+ * @return QueryIterator* The new profile iterator
+ */
+QueryIterator *NewHWProfileIterator(QueryIterator *child);
+
+/**
+ * @brief Create a profile iterator that only counts the reads of its child, without timing them
+ *
+ * Used to capture the plan of the queries logged by the slow log (see slowlog.h), at a fraction
+ * of the cost of profiling them. Its `wallTime` stays 0, and it reads its child in batches.
+ *
+ * @param child The iterator to wrap
+ * @return QueryIterator* The new counting iterator
+ */
+QueryIterator *NewCountingIterator(QueryIterator *child);
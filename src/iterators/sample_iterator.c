@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "sample_iterator.h"
+#include "rmalloc.h"
+#include "util/minmax.h"
+
+// The docIds are dense and increasing, so they are mixed (by the finalizer of splitmix64) for the
+// sampled ones to spread evenly across the index
+static inline uint64_t hashDocId(t_docId docId) {
+  uint64_t x = docId;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static inline uint64_t ratioThreshold(double ratio) {
+  // 2^64, above which the conversion would overflow
+  return ratio < 1 ? (uint64_t)(ratio * 18446744073709551616.0) : UINT64_MAX;
+}
+
+bool SampleIterator_Keeps(t_docId docId, double ratio) {
+  return hashDocId(docId) < ratioThreshold(ratio);
+}
+
+static inline void SI_SyncWithChild(QueryIterator *base, const QueryIterator *child) {
+  base->lastDocId = child->lastDocId;
+  base->current = child->current;
+  base->atEOF = child->atEOF;
+}
+
+static IteratorStatus SI_Read(QueryIterator *base) {
+  SampleIterator *si = (SampleIterator *)base;
+  QueryIterator *child = si->child;
+  IteratorStatus rc;
+  while ((rc = child->Read(child)) == ITERATOR_OK) {
+    if (hashDocId(child->lastDocId) < si->threshold) {
+      SI_SyncWithChild(base, child);
+      return ITERATOR_OK;
+    }
+  }
+  if (rc == ITERATOR_EOF) {
+    base->atEOF = true;
+  }
+  return rc;
+}
+
+static IteratorStatus SI_SkipTo(QueryIterator *base, t_docId docId) {
+  SampleIterator *si = (SampleIterator *)base;
+  QueryIterator *child = si->child;
+  IteratorStatus rc = child->SkipTo(child, docId);
+  if (rc == ITERATOR_OK || rc == ITERATOR_NOTFOUND) {
+    if (hashDocId(child->lastDocId) < si->threshold) {
+      SI_SyncWithChild(base, child);
+      return rc;
+    }
+    // The child landed on a result which is not sampled, so we look for the next one
+    rc = SI_Read(base);
+    return rc == ITERATOR_OK ? ITERATOR_NOTFOUND : rc;
+  }
+  if (rc == ITERATOR_EOF) {
+    base->atEOF = true;
+  }
+  return rc;
+}
+
+static ValidateStatus SI_Revalidate(QueryIterator *base) {
+  SampleIterator *si = (SampleIterator *)base;
+  QueryIterator *child = si->child;
+  ValidateStatus rc = child->Revalidate(child);
+  if (rc != VALIDATE_MOVED) {
+    return rc;
+  }
+  if (child->atEOF) {
+    base->atEOF = true;
+  } else if (hashDocId(child->lastDocId) < si->threshold) {
+    SI_SyncWithChild(base, child);
+  } else {
+    SI_Read(base);
+  }
+  return VALIDATE_MOVED;
+}
+
+static size_t SI_NumEstimated(QueryIterator *base) {
+  SampleIterator *si = (SampleIterator *)base;
+  size_t n = si->child->NumEstimated(si->child);
+  return MIN(n, (size_t)(n * si->ratio) + 1);
+}
+
+static void SI_Rewind(QueryIterator *base) {
+  SampleIterator *si = (SampleIterator *)base;
+  si->child->Rewind(si->child);
+  base->current = si->child->current;
+  base->atEOF = false;
+  base->lastDocId = 0;
+}
+
+static void SI_Free(QueryIterator *base) {
+  SampleIterator *si = (SampleIterator *)base;
+  si->child->Free(si->child);
+  rm_free(si);
+}
+
+QueryIterator *NewSampleIterator(QueryIterator *it, double ratio) {
+  SampleIterator *si = rm_calloc(1, sizeof(*si));
+  si->child = it;
+  si->ratio = ratio;
+  si->threshold = ratioThreshold(ratio);
+
+  QueryIterator *ret = &si->base;
+  ret->type = SAMPLE_ITERATOR;
+  ret->atEOF = false;
+  ret->lastDocId = 0;
+  ret->current = it->current;
+  ret->NumEstimated = SI_NumEstimated;
+  ret->Read = SI_Read;
+  ret->SkipTo = SI_SkipTo;
+  ret->Revalidate = SI_Revalidate;
+  ret->Free = SI_Free;
+  ret->Rewind = SI_Rewind;
+  ret->ReadBatch = Default_ReadBatch;
+  return ret;
+}
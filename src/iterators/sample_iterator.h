@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#pragma once
+
+#include "iterator_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  QueryIterator base;     // base index iterator
+  QueryIterator *child;   // child index iterator
+  double ratio;
+  uint64_t threshold;     // the results whose docId hashes below it are sampled
+} SampleIterator;
+
+/**
+ * Sample the results of `it` at `ratio` (in (0, 1)), for FT.AGGREGATE SAMPLE. A result is kept if
+ * the hash of its docId falls below `ratio` of the hash range, so the same documents are sampled by
+ * every query at the same ratio, and a sample at a lower ratio is a subset of one at a higher ratio
+ * @param it - The iterator to sample, owned by the returned iterator
+ * @param ratio - The expected ratio of the results of `it` to keep
+ */
+QueryIterator *NewSampleIterator(QueryIterator *it, double ratio);
+
+// Whether `docId` is sampled at `ratio`, as by the iterator
+bool SampleIterator_Keeps(t_docId docId, double ratio);
+
+#ifdef __cplusplus
+}
+#endif
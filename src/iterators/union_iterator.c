@@ -10,6 +10,10 @@
 #include "union_iterator.h"
 #include "wildcard_iterator.h"
 #include "empty_iterator.h"
+#include "inverted_index_iterator.h"
+#include "profile_iterator.h"
+#include "ext/default.h"
+#include "util/sorted_ids.h"
 
 static inline int cmpLastDocId(const void *e1, const void *e2, const void *udata) {
   const QueryIterator *it1 = e1, *it2 = e2;
@@ -20,6 +24,13 @@ static inline int cmpLastDocId(const void *e1, const void *e2, const void *udata
   return 0;
 }
 
+// Above this number of children, unions in full mode merge their children with a loser tree
+// rather than a heap: the tree only compares each advanced child with the losers on its path,
+// kept in flat arrays, rather than sifting the heap
+#define UI_LOSER_TREE_MIN_CHILDREN 64
+
+static void UI_LT_Build(UnionIterator *ui);
+
 static inline void resetMinIdHeap(UnionIterator *ui) {
   heap_t *hp = ui->heap_min_id;
   heap_clear(hp);
@@ -50,23 +61,46 @@ void UI_SyncIterList(UnionIterator *ui) {
   if (ui->heap_min_id) {
     resetMinIdHeap(ui);
   }
+  if (ui->lt_ids) {
+    UI_LT_Build(ui);
+  }
   for (size_t i = 0; i < ui->num; i++) {
     while (i < ui->num && ui->its[i]->atEOF) {
       UI_RemoveExhausted(ui, i);
     }
   }
-  if (ui->num == 0) {
+  if (ui->num == 0 && !ui->num_deferred) {
     // If no active iterators, set EOF
     ui->base.atEOF = true;
   }
 }
 
+// Open the deferred children that may yield an id up to `bound`, and offer them to the heap
+static void UI_OpenDeferredUpTo(UnionIterator *ui, t_docId bound) {
+  while (ui->num_deferred && ui->deferred[ui->num_deferred - 1].minId <= bound) {
+    UnionDeferredChild *d = &ui->deferred[--ui->num_deferred];
+    QueryIterator *child = ui->opener.open(ui->opener.ctx, d->source, d->arg, ui->deferredStale);
+    if (child) {
+      ui->its_orig[ui->num_orig++] = child;
+      ui->its[ui->num++] = child;
+      heap_offerx(ui->heap_min_id, child);
+    }
+  }
+}
+
+void UI_OpenDeferred(UnionIterator *ui) {
+  UI_OpenDeferredUpTo(ui, DOCID_MAX);
+}
+
 static size_t UI_NumEstimated(QueryIterator *base) {
   UnionIterator *ui = (UnionIterator *)base;
   size_t estimation = 0;
   for (size_t i = 0; i < ui->num_orig; ++i) {
     estimation += ui->its_orig[i]->NumEstimated(ui->its_orig[i]);
   }
+  for (size_t i = 0; i < ui->num_deferred; ++i) {
+    estimation += ui->deferred[i].numEstimated;
+  }
   return estimation;
 }
 
@@ -334,20 +368,26 @@ static inline IteratorStatus UI_Skip_Quick_Heap(QueryIterator *base, const t_doc
   // TODO: performance improvement?
   // before attempting to advance lagging iterators, we can perform a quick scan of the heap and check if
   // we already have a matching iterator, saving us from performing any `SkipTo` call, which may be expensive.
-  while ((cur = heap_peek(hp)) && cur->lastDocId < nextId) {
-    IteratorStatus rc = cur->SkipTo(cur, nextId);
-    if (rc == ITERATOR_OK) {
-      heap_replace(hp, cur); // replace current iterator with itself to update its position
-      UI_QuickSet(ui, cur);
-      return ITERATOR_OK;
-    } else if (rc == ITERATOR_NOTFOUND) {
-      heap_replace(hp, cur); // replace current iterator with itself to update its position
-    } else if (rc == ITERATOR_EOF) {
-      heap_poll(hp);
-    } else {
-      return rc;
+  // Deferred children are opened once they may yield `nextId`, or an id below the one found
+  t_docId bound = nextId;
+  do {
+    UI_OpenDeferredUpTo(ui, bound);
+    while ((cur = heap_peek(hp)) && cur->lastDocId < nextId) {
+      IteratorStatus rc = cur->SkipTo(cur, nextId);
+      if (rc == ITERATOR_OK) {
+        heap_replace(hp, cur); // replace current iterator with itself to update its position
+        UI_QuickSet(ui, cur);
+        return ITERATOR_OK;
+      } else if (rc == ITERATOR_NOTFOUND) {
+        heap_replace(hp, cur); // replace current iterator with itself to update its position
+      } else if (rc == ITERATOR_EOF) {
+        heap_poll(hp);
+      } else {
+        return rc;
+      }
     }
-  }
+    bound = cur ? cur->lastDocId - 1 : DOCID_MAX;
+  } while (ui->num_deferred && ui->deferred[ui->num_deferred - 1].minId <= bound);
 
   if (cur) {
     UI_QuickSet(ui, cur);
@@ -367,6 +407,202 @@ static inline IteratorStatus UI_Read_Quick_Heap(QueryIterator *base) {
   return rc == ITERATOR_NOTFOUND ? ITERATOR_OK : rc;
 }
 
+/********************************* Loser tree *********************************/
+
+// Play the matches of the subtree rooted at `node`, storing the loser of each internal node, and
+// return the winner of the subtree
+static uint32_t UI_LT_BuildNode(UnionIterator *ui, uint32_t node) {
+  if (node >= ui->lt_size) {
+    return node - ui->lt_size;
+  }
+  uint32_t left = UI_LT_BuildNode(ui, 2 * node);
+  uint32_t right = UI_LT_BuildNode(ui, 2 * node + 1);
+  bool rightWins = ui->lt_ids[right] < ui->lt_ids[left];
+  ui->lt_losers[node] = rightWins ? left : right;
+  return rightWins ? right : left;
+}
+
+// Rebuild the tree from the current state of the children
+static void UI_LT_Build(UnionIterator *ui) {
+  for (uint32_t i = 0; i < ui->lt_size; i++) {
+    const QueryIterator *child = i < ui->num_orig ? ui->its_orig[i] : NULL;
+    ui->lt_ids[i] = (!child || child->atEOF) ? DOCID_MAX : child->lastDocId;
+  }
+  ui->lt_winner = UI_LT_BuildNode(ui, 1);
+}
+
+// Update the id of the winning leaf after its child advanced, and replay its matches up to the
+// root. Only the winner may be updated, as the losers of its path are the leaves it played against
+static inline void UI_LT_ReplayWinner(UnionIterator *ui, const QueryIterator *child) {
+  const t_docId *ids = ui->lt_ids;
+  uint32_t winner = ui->lt_winner;
+  ui->lt_ids[winner] = child->atEOF ? DOCID_MAX : child->lastDocId;
+  for (uint32_t node = (winner + ui->lt_size) / 2; node > 0; node /= 2) {
+    uint32_t other = ui->lt_losers[node];
+    bool swap = ids[other] < ids[winner];
+    ui->lt_losers[node] = swap ? winner : other;
+    winner = swap ? other : winner;
+  }
+  ui->lt_winner = winner;
+}
+
+// Add the children of the subtree rooted at `node` whose id is `id` to the current result, where
+// `winner` is the winner of the subtree. The other matching leaves lost to a matching leaf, so
+// they are found below the losers of the winner's path that hold `id`
+static void UI_LT_Collect(UnionIterator *ui, uint32_t node, uint32_t winner, t_docId id) {
+  UI_AddChild(ui, ui->its_orig[winner]);
+  for (uint32_t pos = winner + ui->lt_size; pos > node; pos /= 2) {
+    uint32_t loser = ui->lt_losers[pos / 2];
+    if (ui->lt_ids[loser] == id) {
+      // The loser won the sibling subtree
+      UI_LT_Collect(ui, pos ^ 1, loser, id);
+    }
+  }
+}
+
+// Set the current result to the children at the minimal id, or EOF if all of them are depleted
+static inline IteratorStatus UI_LT_SetCurrent(UnionIterator *ui) {
+  const t_docId minId = ui->lt_ids[ui->lt_winner];
+  if (minId == DOCID_MAX) {
+    ui->base.atEOF = true;
+    return ITERATOR_EOF;
+  }
+  ui->base.lastDocId = minId;
+  UI_LT_Collect(ui, 1, ui->lt_winner, minId);
+  return ITERATOR_OK;
+}
+
+// Read implementation, for full (no quick exit) mode, using a loser tree (many children).
+// Like the heap, only the children that matched on the previous read/skip call are read
+static IteratorStatus UI_Read_Full_LoserTree(QueryIterator *base) {
+  UnionIterator *ui = (UnionIterator *)base;
+  if (base->atEOF) {
+    return ITERATOR_EOF;
+  }
+  IndexResult_ResetAggregate(ui->base.current);
+  while (ui->lt_ids[ui->lt_winner] == base->lastDocId) {
+    QueryIterator *cur = ui->its_orig[ui->lt_winner];
+    IteratorStatus rc = cur->Read(cur);
+    if (rc != ITERATOR_OK && rc != ITERATOR_EOF) {
+      return rc;
+    }
+    UI_LT_ReplayWinner(ui, cur);
+  }
+  return UI_LT_SetCurrent(ui);
+}
+
+// Skip implementation, for full (no quick exit) mode, using a loser tree (many children)
+static IteratorStatus UI_Skip_Full_LoserTree(QueryIterator *base, const t_docId nextId) {
+  RS_ASSERT(base->lastDocId < nextId);
+  UnionIterator *ui = (UnionIterator *)base;
+  if (base->atEOF) {
+    return ITERATOR_EOF;
+  }
+  IndexResult_ResetAggregate(ui->base.current);
+  while (ui->lt_ids[ui->lt_winner] < nextId) {
+    QueryIterator *cur = ui->its_orig[ui->lt_winner];
+    IteratorStatus rc = cur->SkipTo(cur, nextId);
+    if (rc != ITERATOR_OK && rc != ITERATOR_NOTFOUND && rc != ITERATOR_EOF) {
+      return rc;
+    }
+    UI_LT_ReplayWinner(ui, cur);
+  }
+  IteratorStatus rc = UI_LT_SetCurrent(ui);
+  if (rc == ITERATOR_OK && base->lastDocId != nextId) {
+    return ITERATOR_NOTFOUND;
+  }
+  return rc;
+}
+
+/********************************* Block-max pruning *********************************/
+
+// Get the term iterator behind a child, looking through a profile wrapper if needed
+static inline const InvIndIterator *UI_BlockMax_TermChild(const QueryIterator *child) {
+  if (child->type == PROFILE_ITERATOR) {
+    child = ((const ProfileIterator *)child)->child;
+  }
+  return child->type == INV_IDX_ITERATOR ? (const InvIndIterator *)child : NULL;
+}
+
+// Upper bound of the BM25STD contribution of a child, for any document of the block its reader is
+// currently positioned at. Sets `blockLastId` to the last id covered by the bound.
+static inline double UI_BlockMax_ChildBound(const QueryIterator *child, t_docId *blockLastId) {
+  const InvIndIterator *term = UI_BlockMax_TermChild(child);
+  const IndexBlock *blk = IndexReader_CurrentBlock(term->reader);
+  *blockLastId = IndexBlock_LastId(blk);
+  const RSQueryTerm *qt = IndexResult_QueryTermRef(term->base.current);
+  return BM25Std_TermUpperBound(qt->bm25_idf, term->base.current->weight, IndexBlock_MaxFreq(blk));
+}
+
+// Check whether the current candidate of the union may enter the top-k results.
+// If not, set `skipTo` to the first id that may be matched by a child other than the ones matching
+// the current candidate, or by any of them beyond its current block. Until that id, only the
+// currently matching children may contribute, and none of them can yield a better bound.
+static inline bool UI_BlockMax_Competitive(const UnionIterator *ui, t_docId *skipTo) {
+  const t_docId curId = ui->base.lastDocId;
+  t_docId next = DOCID_MAX;
+  double bound = 0;
+  for (uint32_t i = 0; i < ui->num; i++) {
+    const QueryIterator *cur = ui->its[i];
+    if (cur->lastDocId == curId) {
+      t_docId blockLastId;
+      bound += UI_BlockMax_ChildBound(cur, &blockLastId);
+      if (blockLastId < next) next = blockLastId + 1;
+    } else if (cur->lastDocId < next) {
+      next = cur->lastDocId;
+    }
+  }
+  // The documents scores are at most 1, so the union weight is the only remaining factor
+  if (bound * ui->base.current->weight >= *ui->scoreThreshold) {
+    return true;
+  }
+  *skipTo = next;
+  return false;
+}
+
+// Advance the union past candidates that cannot compete with the current top-k results.
+// `rc` is the status of the last positioning of the union. Once we move away from the position
+// we were asked for, an exact match is reported as ITERATOR_NOTFOUND.
+static inline IteratorStatus UI_BlockMax_Prune(UnionIterator *ui, IteratorStatus rc) {
+  QueryIterator *base = &ui->base;
+  t_docId skipTo;
+  while ((rc == ITERATOR_OK || rc == ITERATOR_NOTFOUND) && !UI_BlockMax_Competitive(ui, &skipTo)) {
+    rc = skipTo > base->lastDocId + 1 ? UI_Skip_Full_Flat(base, skipTo) : UI_Read_Full_Flat(base);
+    if (rc == ITERATOR_OK) rc = ITERATOR_NOTFOUND;
+  }
+  return rc;
+}
+
+static IteratorStatus UI_Read_BlockMax(QueryIterator *base) {
+  IteratorStatus rc = UI_BlockMax_Prune((UnionIterator *)base, UI_Read_Full_Flat(base));
+  return rc == ITERATOR_NOTFOUND ? ITERATOR_OK : rc;
+}
+
+static IteratorStatus UI_Skip_BlockMax(QueryIterator *base, const t_docId nextId) {
+  return UI_BlockMax_Prune((UnionIterator *)base, UI_Skip_Full_Flat(base, nextId));
+}
+
+bool UI_EnableBlockMax(QueryIterator *it, const double *threshold) {
+  if (it->type != UNION_ITERATOR || it->Read != UI_Read_Full_Flat) {
+    // Only the flat, full mode collects all the matching children we need for the bounds
+    return false;
+  }
+  UnionIterator *ui = (UnionIterator *)it;
+  for (uint32_t i = 0; i < ui->num_orig; i++) {
+    const InvIndIterator *term = UI_BlockMax_TermChild(ui->its_orig[i]);
+    if (!term || term->isWildcard || !(IndexReader_Flags(term->reader) & Index_StoreFreqs) ||
+        term->base.current->data.tag != RSResultData_Term || !IndexResult_QueryTermRef(term->base.current)) {
+      return false;
+    }
+  }
+  ui->scoreThreshold = threshold;
+  it->Read = UI_Read_BlockMax;
+  it->SkipTo = UI_Skip_BlockMax;
+  return true;
+}
+
+/*************************************************************************************/
+
 static void UI_Free(QueryIterator *base) {
   if (base == NULL) return;
 
@@ -378,8 +614,20 @@ static void UI_Free(QueryIterator *base) {
     }
   }
 
+  for (uint32_t i = 0; i < ui->num_deferred; i++) {
+    ui->opener.freeArg(ui->deferred[i].arg);
+  }
+  if (ui->opener.freeCtx) {
+    ui->opener.freeCtx(ui->opener.ctx);
+  }
+  rm_free(ui->deferred);
+
   IndexResult_Free(ui->base.current);
   if (ui->heap_min_id) heap_free(ui->heap_min_id);
+  rm_free(ui->lt_ids);
+  rm_free(ui->lt_losers);
+  rm_free(ui->merge);
+  rm_free(ui->merge_heap);
   rm_free(ui->its);
   rm_free(ui->its_orig);
   rm_free(ui);
@@ -435,6 +683,8 @@ static ValidateStatus UI_Revalidate(QueryIterator *base) {
   UnionIterator *ui = (UnionIterator *)base;
   t_docId original_lastDocId = base->lastDocId;
   bool all_child_ok = true;
+  // The lock was released, so the deferred children are reopened from scratch
+  ui->deferredStale = true;
 
   // Loop over the original iterators list and revalidate each child
   // Use read/write indexes to efficiently pack the array
@@ -460,7 +710,7 @@ static ValidateStatus UI_Revalidate(QueryIterator *base) {
     return VALIDATE_OK;
   }
   ui->num_orig = new_num_orig;
-  if (ui->num_orig == 0) {
+  if (ui->num_orig == 0 && !ui->num_deferred) {
     // All children were aborted, we should abort the union iterator
     return VALIDATE_ABORTED;
   }
@@ -468,6 +718,20 @@ static ValidateStatus UI_Revalidate(QueryIterator *base) {
   // Use UI_SyncIterList to update `its` array and heap - remove exhausted iterators
   UI_SyncIterList(ui);
 
+  if (ui->num_deferred && original_lastDocId) {
+    // The union moves to the minimal id of its children, which deferred children may precede
+    t_docId bound = DOCID_MAX;
+    for (uint32_t i = 0; i < ui->num; i++) {
+      if (ui->its[i]->lastDocId < bound) bound = ui->its[i]->lastDocId;
+    }
+    uint32_t opened = ui->num_orig;
+    UI_OpenDeferredUpTo(ui, bound);
+    for (uint32_t i = opened; i < ui->num_orig; i++) {
+      ui->its_orig[i]->SkipTo(ui->its_orig[i], original_lastDocId + 1);
+    }
+    UI_SyncIterList(ui);
+  }
+
   // Update current result - reset and rebuild if we have active children
   IndexResult_ResetAggregate(ui->base.current);
   // Find the minimum docId among active children to update current result
@@ -511,6 +775,7 @@ QueryIterator *NewUnionIterator(QueryIterator **its, int num, bool quickExit,
   ret->Free = UI_Free;
   ret->Rewind = UI_Rewind;
   ret->Revalidate = UI_Revalidate;
+  ret->ReadBatch = Default_ReadBatch;
 
   // Choose `Read` and `SkipTo` implementations.
   // We have 2 factors for the choice:
@@ -519,7 +784,14 @@ QueryIterator *NewUnionIterator(QueryIterator **its, int num, bool quickExit,
   // 2. minUnionIterHeap - choose whether to use a flat array or a heap for tracking the children, according to the number of children
   // Each implementation if fine-tuned for the best performance in its scenario, and relies on the current state
   // of the iterator and how it was left by previous API calls, so we can't change implementation mid-execution.
-  if (num > config->minUnionIterHeap) {
+  if (!quickExit && num > config->minUnionIterHeap && num >= UI_LOSER_TREE_MIN_CHILDREN) {
+    ret->Read = UI_Read_Full_LoserTree;
+    ret->SkipTo = UI_Skip_Full_LoserTree;
+    ui->lt_size = 1;
+    while (ui->lt_size < num) ui->lt_size *= 2;
+    ui->lt_ids = rm_malloc(ui->lt_size * sizeof(*ui->lt_ids));
+    ui->lt_losers = rm_malloc(ui->lt_size * sizeof(*ui->lt_losers));
+  } else if (num > config->minUnionIterHeap) {
     ret->Read = quickExit ? UI_Read_Quick_Heap : UI_Read_Full_Heap;
     ret->SkipTo = quickExit ? UI_Skip_Quick_Heap : UI_Skip_Full_Heap;
     ui->heap_min_id = rm_malloc(heap_sizeof(num));
@@ -532,3 +804,285 @@ QueryIterator *NewUnionIterator(QueryIterator **its, int num, bool quickExit,
   UI_SyncIterList(ui);
   return ret;
 }
+
+/********************************* Merging of batches *********************************/
+
+// The number of ids read from a child at once by a merging union
+#define UI_MERGE_BATCH 128
+
+// The batch of a child not yet yielded. Its last id is the current one of the child, as a cursor
+// reads the next batch once it is done with it
+typedef struct UnionMergeCursor {
+  t_docId ids[UI_MERGE_BATCH];
+  uint32_t pos;
+  uint32_t len;
+} UnionMergeCursor;
+
+static inline t_docId UI_Merge_Head(const UnionIterator *ui, uint32_t c) {
+  const UnionMergeCursor *cur = &ui->merge[c];
+  return cur->ids[cur->pos];
+}
+
+static void UI_Merge_SiftDown(UnionIterator *ui, uint32_t i) {
+  uint32_t *heap = ui->merge_heap;
+  const uint32_t n = ui->merge_heap_size;
+  while (true) {
+    uint32_t min = i, l = 2 * i + 1, r = l + 1;
+    if (l < n && UI_Merge_Head(ui, heap[l]) < UI_Merge_Head(ui, heap[min])) min = l;
+    if (r < n && UI_Merge_Head(ui, heap[r]) < UI_Merge_Head(ui, heap[min])) min = r;
+    if (min == i) return;
+    uint32_t tmp = heap[i];
+    heap[i] = heap[min];
+    heap[min] = tmp;
+    i = min;
+  }
+}
+
+// Build the heap of the cursors with ids left
+static void UI_Merge_Heapify(UnionIterator *ui) {
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < ui->merge_heap_size; i++) {
+    const UnionMergeCursor *cur = &ui->merge[ui->merge_heap[i]];
+    if (cur->pos < cur->len) {
+      ui->merge_heap[n++] = ui->merge_heap[i];
+    }
+  }
+  ui->merge_heap_size = n;
+  for (uint32_t i = n / 2; i-- > 0;) {
+    UI_Merge_SiftDown(ui, i);
+  }
+}
+
+// Read the next batch of the child to its cursor
+static IteratorStatus UI_Merge_Fill(UnionIterator *ui, uint32_t c) {
+  QueryIterator *child = ui->its_orig[c];
+  UnionMergeCursor *cur = &ui->merge[c];
+  size_t n = 0;
+  IteratorStatus rc = child->ReadBatch(child, cur->ids, UI_MERGE_BATCH, &n);
+  cur->pos = 0;
+  cur->len = rc == ITERATOR_OK ? n : 0;
+  return rc;
+}
+
+// Called once the cursor at the top of the heap was moved. Removes it if it has no ids left
+static inline void UI_Merge_FixTop(UnionIterator *ui) {
+  const UnionMergeCursor *cur = &ui->merge[ui->merge_heap[0]];
+  if (cur->pos == cur->len) {
+    ui->merge_heap[0] = ui->merge_heap[--ui->merge_heap_size];
+  }
+  UI_Merge_SiftDown(ui, 0);
+}
+
+static IteratorStatus UI_Merge_Start(UnionIterator *ui) {
+  ui->merge_started = true;
+  ui->merge_heap_size = 0;
+  for (uint32_t c = 0; c < ui->num_orig; c++) {
+    IteratorStatus rc = UI_Merge_Fill(ui, c);
+    if (rc == ITERATOR_TIMEOUT) {
+      return rc;
+    }
+    if (ui->merge[c].len) {
+      ui->merge_heap[ui->merge_heap_size++] = c;
+    }
+  }
+  UI_Merge_Heapify(ui);
+  return ITERATOR_OK;
+}
+
+// Yield the minimal id of the cursors, and move every cursor at it past it
+static IteratorStatus UI_Merge_Yield(UnionIterator *ui) {
+  const t_docId id = UI_Merge_Head(ui, ui->merge_heap[0]);
+  while (ui->merge_heap_size && UI_Merge_Head(ui, ui->merge_heap[0]) == id) {
+    uint32_t c = ui->merge_heap[0];
+    if (++ui->merge[c].pos == ui->merge[c].len && UI_Merge_Fill(ui, c) == ITERATOR_TIMEOUT) {
+      return ITERATOR_TIMEOUT;
+    }
+    UI_Merge_FixTop(ui);
+  }
+  ui->base.lastDocId = ui->base.current->docId = id;
+  return ITERATOR_OK;
+}
+
+static IteratorStatus UI_Read_Merge(QueryIterator *base) {
+  UnionIterator *ui = (UnionIterator *)base;
+  if (base->atEOF) {
+    return ITERATOR_EOF;
+  }
+  if (!ui->merge_started && UI_Merge_Start(ui) == ITERATOR_TIMEOUT) {
+    return ITERATOR_TIMEOUT;
+  }
+  if (!ui->merge_heap_size) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  return UI_Merge_Yield(ui);
+}
+
+static IteratorStatus UI_Skip_Merge(QueryIterator *base, const t_docId nextId) {
+  UnionIterator *ui = (UnionIterator *)base;
+  if (base->atEOF) {
+    return ITERATOR_EOF;
+  }
+  if (!ui->merge_started && UI_Merge_Start(ui) == ITERATOR_TIMEOUT) {
+    return ITERATOR_TIMEOUT;
+  }
+  while (ui->merge_heap_size && UI_Merge_Head(ui, ui->merge_heap[0]) < nextId) {
+    uint32_t c = ui->merge_heap[0];
+    UnionMergeCursor *cur = &ui->merge[c];
+    QueryIterator *child = ui->its_orig[c];
+    if (cur->ids[cur->len - 1] >= nextId) {
+      // Within the batch
+      cur->pos += SortedIds_CountUpTo(cur->ids + cur->pos, cur->len - cur->pos, nextId - 1);
+    } else if (child->atEOF) {
+      cur->pos = cur->len;
+    } else {
+      // Past the batch, which the child skips, and the cursor goes on from where it lands
+      IteratorStatus rc = child->SkipTo(child, nextId);
+      if (rc == ITERATOR_TIMEOUT) {
+        return rc;
+      }
+      cur->pos = 0;
+      cur->len = 0;
+      if (rc == ITERATOR_OK || rc == ITERATOR_NOTFOUND) {
+        cur->ids[cur->len++] = child->lastDocId;
+      }
+    }
+    UI_Merge_FixTop(ui);
+  }
+  if (!ui->merge_heap_size) {
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  const bool found = UI_Merge_Head(ui, ui->merge_heap[0]) == nextId;
+  IteratorStatus rc = UI_Merge_Yield(ui);
+  return rc == ITERATOR_OK && !found ? ITERATOR_NOTFOUND : rc;
+}
+
+static IteratorStatus UI_ReadBatch_Merge(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  size_t n = 0;
+  IteratorStatus rc = ITERATOR_OK;
+  while (n < cap && (rc = UI_Read_Merge(base)) == ITERATOR_OK) {
+    out[n++] = base->lastDocId;
+  }
+  *numRead = n;
+  return n ? ITERATOR_OK : rc;
+}
+
+static void UI_Rewind_Merge(QueryIterator *base) {
+  UnionIterator *ui = (UnionIterator *)base;
+  UI_Rewind(base);
+  ui->merge_started = false;
+  ui->merge_heap_size = 0;
+}
+
+// The children are all aborted together, as for the ranges of a numeric tree which was changed
+static ValidateStatus UI_Revalidate_Merge(QueryIterator *base) {
+  UnionIterator *ui = (UnionIterator *)base;
+  ValidateStatus ret = VALIDATE_OK;
+  bool needsHeapify = false;
+  for (uint32_t c = 0; c < ui->num_orig; c++) {
+    QueryIterator *child = ui->its_orig[c];
+    ValidateStatus rc = child->Revalidate(child);
+    if (rc == VALIDATE_ABORTED) {
+      ret = VALIDATE_ABORTED;
+    } else if (rc == VALIDATE_MOVED && ui->merge_started && ui->merge[c].len) {
+      // The last id of the batch is gone, and the child moved to the next one
+      UnionMergeCursor *cur = &ui->merge[c];
+      if (child->atEOF) {
+        cur->len--;
+      } else {
+        cur->ids[cur->len - 1] = child->lastDocId;
+      }
+      needsHeapify = true;
+    }
+  }
+  if (needsHeapify && ret != VALIDATE_ABORTED) {
+    UI_Merge_Heapify(ui);
+  }
+  return ret;
+}
+
+QueryIterator *NewMergeUnionIterator(QueryIterator **its, int num, double weight,
+                                     QueryNodeType type) {
+  QueryIterator *ret = UnionIteratorReducer(its, &num, true);
+  if (ret != NULL) {
+    return ret;
+  }
+  UnionIterator *ui = rm_calloc(1, sizeof(UnionIterator));
+  ui->its_orig = its;
+  ui->type = type;
+  ui->num_orig = num;
+  ui->its = rm_malloc(num * sizeof(*ui->its));
+  ui->merge = rm_malloc(num * sizeof(*ui->merge));
+  ui->merge_heap = rm_malloc(num * sizeof(*ui->merge_heap));
+
+  ret = &ui->base;
+  ret->type = UNION_ITERATOR;
+  ret->atEOF = false;
+  ret->lastDocId = 0;
+  ret->current = NewVirtualResult(weight, RS_FIELDMASK_ALL);
+  ret->NumEstimated = UI_NumEstimated;
+  ret->Free = UI_Free;
+  ret->Rewind = UI_Rewind_Merge;
+  ret->Revalidate = UI_Revalidate_Merge;
+  ret->Read = UI_Read_Merge;
+  ret->SkipTo = UI_Skip_Merge;
+  ret->ReadBatch = UI_ReadBatch_Merge;
+
+  UI_SyncIterList(ui);
+  return ret;
+}
+
+static int cmpDeferredDesc(const void *a, const void *b) {
+  const t_docId id1 = ((const UnionDeferredChild *)a)->minId;
+  const t_docId id2 = ((const UnionDeferredChild *)b)->minId;
+  return id1 < id2 ? 1 : (id1 > id2 ? -1 : 0);
+}
+
+QueryIterator *NewDeferredUnionIterator(UnionDeferredChild *deferred, int num,
+                                        const UnionChildOpener *opener, double weight,
+                                        QueryNodeType type, const char *q_str,
+                                        IteratorsConfig *config) {
+  if (num <= config->minUnionIterHeap) {
+    // Few enough children to be checked in a flat array, which the deferred children don't fit
+    QueryIterator **its = rm_malloc((num ? num : 1) * sizeof(*its));
+    int n = 0;
+    for (int i = 0; i < num; i++) {
+      QueryIterator *child = opener->open(opener->ctx, deferred[i].source, deferred[i].arg, false);
+      if (child) {
+        its[n++] = child;
+      }
+    }
+    if (opener->freeCtx) {
+      opener->freeCtx(opener->ctx);
+    }
+    rm_free(deferred);
+    return NewUnionIterator(its, n, true, weight, type, q_str, config);
+  }
+
+  qsort(deferred, num, sizeof(*deferred), cmpDeferredDesc);
+  UnionIterator *ui = rm_calloc(1, sizeof(UnionIterator));
+  ui->its_orig = rm_malloc(num * sizeof(*ui->its_orig));
+  ui->its = rm_malloc(num * sizeof(*ui->its));
+  ui->type = type;
+  ui->q_str = q_str;
+  ui->deferred = deferred;
+  ui->num_deferred = num;
+  ui->opener = *opener;
+
+  QueryIterator *ret = &ui->base;
+  ret->type = UNION_ITERATOR;
+  ret->atEOF = false;
+  ret->lastDocId = 0;
+  ret->current = NewUnionResult(num, weight);
+  ret->NumEstimated = UI_NumEstimated;
+  ret->Free = UI_Free;
+  ret->Rewind = UI_Rewind;
+  ret->Revalidate = UI_Revalidate;
+  ret->ReadBatch = Default_ReadBatch;
+  ret->Read = UI_Read_Quick_Heap;
+  ret->SkipTo = UI_Skip_Quick_Heap;
+  ui->heap_min_id = rm_malloc(heap_sizeof(num));
+  heap_init(ui->heap_min_id, cmpLastDocId, NULL, num);
+  return ret;
+}
@@ -18,6 +18,28 @@
 extern "C" {
 #endif
 
+/**
+ * A child of a union that is only opened once the union gets to `minId`, the lowest id it may
+ * yield, so that a union over thousands of expanded terms does not open all their readers before
+ * returning its first result (see `NewDeferredUnionIterator`)
+ */
+typedef struct {
+  t_docId minId;
+  size_t numEstimated;  // the estimation of the child, until it is opened
+  const void *source;   // what the child reads (e.g. an inverted index), passed to the opener
+  void *arg;            // passed to the opener, which takes its ownership
+} UnionDeferredChild;
+
+typedef struct {
+  // Returns the iterator of a deferred child, or NULL if it has no results. `stale` is set once the
+  // union was revalidated, after which the `source` of the child may be gone
+  QueryIterator *(*open)(void *ctx, const void *source, void *arg, bool stale);
+  // Frees the `arg` of a child that was never opened
+  void (*freeArg)(void *arg);
+  void (*freeCtx)(void *ctx);
+  void *ctx;
+} UnionChildOpener;
+
 typedef struct {
   QueryIterator base;
   heap_t *heap_min_id;
@@ -37,6 +59,30 @@ typedef struct {
   QueryNodeType type;
   // original string for fuzzy or prefix unions
   const char *q_str;
+
+  // Loser tree over `its_orig`, used instead of the heap in full mode for wide unions (see
+  // `UI_Read_Full_LoserTree`). NULL if not used
+  t_docId *lt_ids;      // the lastDocId of every leaf. DOCID_MAX for depleted children and padding
+  uint32_t *lt_losers;  // the loser of every internal node. The root is node 1
+  uint32_t lt_size;     // number of leaves, a power of 2
+  uint32_t lt_winner;   // the leaf with the minimal id
+
+  // Block-max pruning: when set, points at the minimal score a result must reach to enter the
+  // top-k heap, and candidates whose score upper bound is lower are skipped (see `UI_EnableBlockMax`)
+  const double *scoreThreshold;
+
+  // Children not opened yet, sorted by decreasing `minId`. Only used in quick mode with a heap
+  UnionDeferredChild *deferred;
+  uint32_t num_deferred;
+  UnionChildOpener opener;
+  bool deferredStale;  // set once revalidated
+
+  // Merging of the batches of the children (see `NewMergeUnionIterator`): a cursor over the last
+  // batch of every child of `its_orig`, and a min-heap of the cursors with ids left, by their next id
+  struct UnionMergeCursor *merge;
+  uint32_t *merge_heap;
+  uint32_t merge_heap_size;
+  bool merge_started;  // whether the first batches were read
 } UnionIterator;
 
 /**
@@ -50,9 +96,46 @@ typedef struct {
 QueryIterator *NewUnionIterator(QueryIterator **its, int num, bool quickExit, double weight,
                                 QueryNodeType type, const char *q_str, IteratorsConfig *config);
 
+/**
+ * Create a union of the ids of its children, which reads each of them in batches (see `ReadBatch`)
+ * and merges the batches, rather than advancing the children one result at a time. Every id is
+ * yielded once, with a virtual result, so it is only meant for children whose results are not
+ * needed, e.g. the ranges of a numeric filter.
+ * Parameters as in `NewUnionIterator`
+ */
+QueryIterator *NewMergeUnionIterator(QueryIterator **its, int num, double weight,
+                                     QueryNodeType type);
+
+/**
+ * Create a union in quick exit mode whose children are opened as the union gets to their first id.
+ * If there are too few children for a heap, they are all opened right away.
+ * @param deferred + num - the children to get the union of. The union takes the ownership of the
+ * array and of the `arg` of each child
+ * @param opener - opens the children. The union frees its context
+ * Other parameters as in `NewUnionIterator`
+ */
+QueryIterator *NewDeferredUnionIterator(UnionDeferredChild *deferred, int num,
+                                        const UnionChildOpener *opener, double weight,
+                                        QueryNodeType type, const char *q_str,
+                                        IteratorsConfig *config);
+
+// Open all the deferred children of a union (for profile iterator injection)
+void UI_OpenDeferred(UnionIterator *ui);
+
 // Sync state according to `its_orig` and `num_orig` (exposed for profile iterator injection)
 void UI_SyncIterList(UnionIterator *ui);
 
+/**
+ * Switch a union iterator to block-max (BMW) evaluation for BM25STD top-k queries.
+ * The union skips every candidate (and whole blocks of its children) whose BM25STD upper bound,
+ * computed from the per-block maximal term frequency, is below `*threshold`. The threshold is
+ * expected to be raised by the sorter as its heap fills up.
+ * Only applicable to a union in full mode whose children are all term iterators over
+ * indexes that store frequencies, and whose documents scores are at most 1.
+ * @returns true if the mode was enabled, false if the union is not eligible
+ */
+bool UI_EnableBlockMax(QueryIterator *it, const double *threshold);
+
 #ifdef __cplusplus
 }
 #endif
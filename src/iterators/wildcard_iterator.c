@@ -8,9 +8,15 @@
 */
 
 #include "wildcard_iterator.h"
+#include "doc_table.h"
 #include "inverted_index_iterator.h"
 #include "empty_iterator.h"
 #include "search_disk.h"
+#include "util/minmax.h"
+
+// The wildcard iterator skips the ids of the deleted documents once fewer than one in this many
+// ids belongs to a document
+#define WILDCARD_SPARSE_RATIO 2
 
 /* Free a wildcard iterator */
 static void WI_Free(QueryIterator *base) {
@@ -34,6 +40,23 @@ static IteratorStatus WI_Read(QueryIterator *base) {
   return ITERATOR_OK;
 }
 
+/* Read a run of consecutive ids at once */
+static IteratorStatus WI_ReadBatch(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  WildcardIterator *wi = (WildcardIterator *)base;
+  if (wi->currentId >= wi->topId) {
+    base->atEOF = true;
+    *numRead = 0;
+    return ITERATOR_EOF;
+  }
+  size_t n = MIN(cap, wi->topId - wi->currentId);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = ++wi->currentId;
+  }
+  base->lastDocId = base->current->docId = wi->currentId;
+  *numRead = n;
+  return ITERATOR_OK;
+}
+
 /* Skipto for wildcard iterator - always succeeds, but this should normally not happen as it has
  * no meaning */
 static IteratorStatus WI_SkipTo(QueryIterator *base, t_docId docId) {
@@ -49,6 +72,46 @@ static IteratorStatus WI_SkipTo(QueryIterator *base, t_docId docId) {
   return ITERATOR_OK;
 }
 
+/* Read the next id of a document in the doc table */
+static IteratorStatus WI_ReadLive(QueryIterator *base) {
+  WildcardIterator *wi = (WildcardIterator *)base;
+  t_docId next = wi->currentId < wi->topId ? DocTable_NextId(wi->docTable, wi->currentId + 1) : 0;
+  if (!next || next > wi->topId) {
+    wi->currentId = wi->topId;
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  base->lastDocId = base->current->docId = wi->currentId = next;
+  return ITERATOR_OK;
+}
+
+static IteratorStatus WI_ReadBatchLive(QueryIterator *base, t_docId *out, size_t cap, size_t *numRead) {
+  WildcardIterator *wi = (WildcardIterator *)base;
+  size_t n = 0;
+  while (n < cap && WI_ReadLive(base) == ITERATOR_OK) {
+    out[n++] = wi->currentId;
+  }
+  *numRead = n;
+  if (!n) {
+    return ITERATOR_EOF;
+  }
+  // The iterator is only at EOF once it has nothing more to read
+  base->atEOF = false;
+  return ITERATOR_OK;
+}
+
+static IteratorStatus WI_SkipToLive(QueryIterator *base, t_docId docId) {
+  WildcardIterator *wi = (WildcardIterator *)base;
+  t_docId next = docId <= wi->topId ? DocTable_NextId(wi->docTable, docId) : 0;
+  if (!next || next > wi->topId) {
+    wi->currentId = wi->topId;
+    base->atEOF = true;
+    return ITERATOR_EOF;
+  }
+  base->lastDocId = base->current->docId = wi->currentId = next;
+  return next == docId ? ITERATOR_OK : ITERATOR_NOTFOUND;
+}
+
 static void WI_Rewind(QueryIterator *base) {
   WildcardIterator *wi = (WildcardIterator *)base;
   wi->currentId = 0;
@@ -85,6 +148,7 @@ QueryIterator *NewWildcardIterator_NonOptimized(t_docId maxId, size_t numDocs, d
   ret->SkipTo = WI_SkipTo;
   ret->NumEstimated = WI_NumEstimated;
   ret->Revalidate = Default_Revalidate;
+  ret->ReadBatch = WI_ReadBatch;
   return ret;
 }
 
@@ -108,6 +172,16 @@ QueryIterator *NewWildcardIterator(const QueryEvalCtx *q, double weight) {
     return NewWildcardIterator_Optimized(q->sctx, weight);
   } else {
     // Non-optimized wildcard iterator, using a simple doc-id increment as its base.
-    return NewWildcardIterator_NonOptimized(q->docTable->maxDocId, q->docTable->size, weight);
+    QueryIterator *ret = NewWildcardIterator_NonOptimized(q->docTable->maxDocId, q->docTable->size, weight);
+    // Once most of the ids belong to deleted documents, skip them in the doc table rather than
+    // passing them on to be looked up and dropped one by one
+    if (q->docTable->size < q->docTable->maxDocId / WILDCARD_SPARSE_RATIO) {
+      WildcardIterator *wi = (WildcardIterator *)ret;
+      wi->docTable = q->docTable;
+      ret->Read = WI_ReadLive;
+      ret->ReadBatch = WI_ReadBatchLive;
+      ret->SkipTo = WI_SkipToLive;
+    }
+    return ret;
   }
 }
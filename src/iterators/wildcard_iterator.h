@@ -21,6 +21,7 @@ typedef struct {
   t_docId topId;
   t_docId currentId;
   t_docId numDocs;
+  const DocTable *docTable;  // When set, the ids of the deleted documents are skipped
 } WildcardIterator;
 
 /**
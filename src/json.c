@@ -59,6 +59,106 @@ JSONPath pathParse(const HiddenString* path, RedisModuleString **err_msg) {
   return japi->pathParse(HiddenString_GetUnsafe(path, NULL), RSDummyContext, err_msg);
 }
 
+static inline bool isMemberNameChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+size_t JSONPath_MemberParentLen(const char *path, size_t len) {
+  if (len < 2 || path[0] != '$') {
+    return 0;
+  }
+  size_t lastDot = 0;
+  size_t numMembers = 0;
+  for (size_t i = 1; i < len; i++) {
+    if (path[i] == '.') {
+      if (i + 1 == len || path[i + 1] == '.') {
+        // A trailing dot or a recursive descent
+        return 0;
+      }
+      lastDot = i;
+      numMembers++;
+    } else if (!isMemberNameChar(path[i]) || i == 1) {
+      return 0;
+    }
+  }
+  return numMembers >= 2 ? lastDot : 0;
+}
+
+size_t JSONPath_SharedParentLen(const char **paths, const size_t *parentLens, size_t n, size_t i) {
+  size_t len = parentLens[i];
+  if (!len || len >= JSON_READER_MAX_PATH) {
+    return 0;
+  }
+  for (size_t j = 0; j < n; j++) {
+    if (j != i && parentLens[j] == len && !memcmp(paths[i], paths[j], len)) {
+      return len;
+    }
+  }
+  return 0;
+}
+
+void JSONPath_GroupFields(FieldSpec *fields, size_t n) {
+  const char **paths = rm_malloc(n * sizeof(*paths));
+  size_t *parentLens = rm_malloc(n * sizeof(*parentLens));
+  for (size_t i = 0; i < n; i++) {
+    size_t len = 0;
+    paths[i] = fields[i].fieldPath ? HiddenString_GetUnsafe(fields[i].fieldPath, &len) : "";
+    parentLens[i] = JSONPath_MemberParentLen(paths[i], len);
+  }
+  for (size_t i = 0; i < n; i++) {
+    fields[i].jsonParentLen = JSONPath_SharedParentLen(paths, parentLens, n, i);
+  }
+  rm_free(paths);
+  rm_free(parentLens);
+}
+
+JSONResultsIterator JSONPathReader_Get(JSONPathReader *r, const char *path, size_t parentLen) {
+  size_t len = strlen(path);
+  // The relative path replaces the parent with the root symbol
+  if (!parentLen || parentLen >= JSON_READER_MAX_PATH || len - parentLen + 2 > JSON_READER_MAX_PATH) {
+    return japi->get(r->root, path);
+  }
+
+  JSONParentValue *parent = NULL;
+  for (size_t i = 0; i < r->numParents; i++) {
+    if (r->parents[i].len == parentLen && !memcmp(r->parents[i].path, path, parentLen)) {
+      parent = &r->parents[i];
+      break;
+    }
+  }
+  if (!parent) {
+    if (r->numParents == JSON_READER_MAX_PARENTS) {
+      return japi->get(r->root, path);
+    }
+    char parentPath[JSON_READER_MAX_PATH];
+    memcpy(parentPath, path, parentLen);
+    parentPath[parentLen] = '\0';
+    parent = &r->parents[r->numParents++];
+    parent->path = path;
+    parent->len = parentLen;
+    // A chain of member names has at most one value
+    parent->iter = japi->get(r->root, parentPath);
+    parent->value = parent->iter ? japi->next(parent->iter) : NULL;
+  }
+  if (!parent->value) {
+    return NULL;
+  }
+
+  char relPath[JSON_READER_MAX_PATH];
+  relPath[0] = '$';
+  memcpy(relPath + 1, path + parentLen, len - parentLen + 1);
+  return japi->get(parent->value, relPath);
+}
+
+void JSONPathReader_Free(JSONPathReader *r) {
+  for (size_t i = 0; i < r->numParents; i++) {
+    if (r->parents[i].iter) {
+      japi->freeIter(r->parents[i].iter);
+    }
+  }
+  r->numParents = 0;
+}
+
 int FieldSpec_CheckJsonType(FieldType fieldType, JSONType type, QueryError *status) {
   int rv = REDISMODULE_ERR;
   switch (type) {
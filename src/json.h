@@ -42,6 +42,47 @@ typedef struct {
   };
 } JSONIterable;
 
+// Reads the values of several JSONPaths of a document. A path which is a chain of member names,
+// like `$.user.name`, may be read relative to the value of its parent `$.user`, which is only
+// looked up once for all the paths which share it.
+#define JSON_READER_MAX_PARENTS 8
+#define JSON_READER_MAX_PATH 256
+
+typedef struct {
+  const char *path;  // The path of the first child, of which the parent is a prefix
+  size_t len;
+  JSONResultsIterator iter;
+  RedisJSON value;  // NULL if the parent has no value in the document
+} JSONParentValue;
+
+typedef struct {
+  RedisJSON root;
+  JSONParentValue parents[JSON_READER_MAX_PARENTS];
+  size_t numParents;
+} JSONPathReader;
+
+static inline void JSONPathReader_Init(JSONPathReader *r, RedisJSON root) {
+  r->root = root;
+  r->numParents = 0;
+}
+
+// Get the values of `path`, of which the first `parentLen` characters are a parent path that other
+// paths share, or 0 to look the path up from the root. The caller must free the returned iterator,
+// and keep `path` valid until the reader is freed
+JSONResultsIterator JSONPathReader_Get(JSONPathReader *r, const char *path, size_t parentLen);
+
+void JSONPathReader_Free(JSONPathReader *r);
+
+// Return the length of the parent of a JSONPath which is a chain of at least two member names,
+// like 6 for the parent `$.user` of `$.user.name`, or 0 for any other path
+size_t JSONPath_MemberParentLen(const char *path, size_t len);
+
+// Return the length of the parent that `paths[i]` shares with another of the paths, or 0
+size_t JSONPath_SharedParentLen(const char **paths, const size_t *parentLens, size_t n, size_t i);
+
+// Set the shared parents of the JSONPaths of the fields of a schema
+void JSONPath_GroupFields(FieldSpec *fields, size_t n);
+
 RedisJSON JSONIterable_Next(JSONIterable *iterable);
 void JSONIterable_Clean(JSONIterable *iterable); // Like free, but does not free the `iterable` pointer itself
 
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "knn_cache.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "rmalloc.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct {
+  uint64_t hash;  // Of the key, compared before the key itself
+  sds key;
+  KNNCachedResult *results;
+  size_t numResults;
+} KNNCacheEntry;
+
+struct KNNResultCache {
+  pthread_mutex_t lock;
+  arrayof(KNNCacheEntry) entries;
+  size_t next;        // The entry replaced next once the cache is full
+  uint64_t revision;  // The revision of the cached results
+};
+
+KNNResultCache *NewKNNResultCache(void) {
+  KNNResultCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  cache->entries = array_new(KNNCacheEntry, 0);
+  return cache;
+}
+
+static void KNNCacheEntry_Free(KNNCacheEntry *e) {
+  sdsfree(e->key);
+  rm_free(e->results);
+}
+
+static void KNNResultCache_Clear(KNNResultCache *cache) {
+  array_foreach(cache->entries, e, KNNCacheEntry_Free(&e));
+  array_clear(cache->entries);
+  cache->next = 0;
+}
+
+void KNNResultCache_Free(KNNResultCache *cache) {
+  if (!cache) return;
+  KNNResultCache_Clear(cache);
+  array_free(cache->entries);
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+static sds appendKeyBytes(sds key, const void *bytes, size_t len) {
+  key = sdscatlen(key, &len, sizeof(len));
+  return sdscatlen(key, bytes, len);
+}
+
+sds KNNResultCache_Key(t_fieldIndex field, const KNNVectorQuery *query,
+                       const VecSimRawParam *params, size_t numParams) {
+  sds key = sdsnewlen(&field, sizeof(field));
+  key = sdscatlen(key, &query->k, sizeof(query->k));
+  key = sdscatlen(key, &query->rerankFactor, sizeof(query->rerankFactor));
+  for (size_t i = 0; i < numParams; i++) {
+    key = appendKeyBytes(key, params[i].name, params[i].nameLen);
+    key = appendKeyBytes(key, params[i].value, params[i].valLen);
+  }
+  return appendKeyBytes(key, query->vector, query->vecLen);
+}
+
+// Drop the results of older revisions. The cache must be locked
+static void KNNResultCache_Sync(KNNResultCache *cache, uint64_t revision) {
+  if (revision > cache->revision) {
+    KNNResultCache_Clear(cache);
+    cache->revision = revision;
+  }
+}
+
+static KNNCacheEntry *KNNResultCache_Find(KNNResultCache *cache, const sds key, uint64_t hash) {
+  size_t len = sdslen(key);
+  for (size_t i = 0; i < array_len(cache->entries); i++) {
+    KNNCacheEntry *e = &cache->entries[i];
+    if (e->hash == hash && sdslen(e->key) == len && !memcmp(e->key, key, len)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+bool KNNResultCache_Get(KNNResultCache *cache, uint64_t revision, const sds key,
+                        KNNCachedResult **results, size_t *numResults) {
+  bool found = false;
+  uint64_t hash = RS_dictGenHashFunction(key, sdslen(key));
+  pthread_mutex_lock(&cache->lock);
+  KNNResultCache_Sync(cache, revision);
+  KNNCacheEntry *e = revision == cache->revision ? KNNResultCache_Find(cache, key, hash) : NULL;
+  if (e) {
+    *results = rm_malloc(e->numResults * sizeof(**results));
+    memcpy(*results, e->results, e->numResults * sizeof(**results));
+    *numResults = e->numResults;
+    found = true;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return found;
+}
+
+void KNNResultCache_Put(KNNResultCache *cache, uint64_t revision, const sds key,
+                        const KNNCachedResult *results, size_t numResults, size_t capacity) {
+  if (!capacity || !numResults || numResults > KNN_RESULT_CACHE_MAX_RESULTS) return;
+  uint64_t hash = RS_dictGenHashFunction(key, sdslen(key));
+  pthread_mutex_lock(&cache->lock);
+  KNNResultCache_Sync(cache, revision);
+  // Another query may have cached the same results meanwhile
+  if (revision == cache->revision && !KNNResultCache_Find(cache, key, hash)) {
+    KNNCacheEntry entry = {
+      .hash = hash,
+      .key = sdsdup(key),
+      .results = rm_malloc(numResults * sizeof(*results)),
+      .numResults = numResults,
+    };
+    memcpy(entry.results, results, numResults * sizeof(*results));
+    if (array_len(cache->entries) < capacity) {
+      array_append(cache->entries, entry);
+    } else {
+      // The capacity may have been lowered since the entries were added
+      cache->next %= capacity;
+      KNNCacheEntry_Free(&cache->entries[cache->next]);
+      cache->entries[cache->next++] = entry;
+    }
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
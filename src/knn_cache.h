@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "redisearch.h"
+#include "vector_index.h"
+#include "hiredis/sds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The queries returning more results than this, or none, are not cached
+#define KNN_RESULT_CACHE_MAX_RESULTS 1024
+
+typedef struct {
+  t_docId docId;
+  double distance;
+} KNNCachedResult;
+
+/**
+ * A cache of the results of the KNN queries without a filter run on the vector fields of an index,
+ * enabled by _KNN_RESULT_CACHE_ENTRIES, so that repeating a query (e.g. the same embedding sent by
+ * many clients) doesn't search the vector index again.
+ *
+ * The entries are keyed on the exact bytes of the query (see KNNResultCache_Key()) and stamped with
+ * the revision of the index, which is bumped whenever a document is added or deleted, and the whole
+ * cache is dropped once it is read at a newer revision. Once full, the oldest entry is replaced.
+ * Lookups may run concurrently, from the worker threads, and are serialized by the cache itself.
+ */
+typedef struct KNNResultCache KNNResultCache;
+
+KNNResultCache *NewKNNResultCache(void);
+void KNNResultCache_Free(KNNResultCache *cache);
+
+/* The key of the query on the field: its vector, K, the factor its candidates are reranked by,
+ * and its raw parameters (EF_RUNTIME, EPSILON...) */
+sds KNNResultCache_Key(t_fieldIndex field, const KNNVectorQuery *query,
+                       const VecSimRawParam *params, size_t numParams);
+
+/* Get a copy of the results of the query cached at `revision`, to be freed with rm_free().
+ * @returns false if they are not cached */
+bool KNNResultCache_Get(KNNResultCache *cache, uint64_t revision, const sds key,
+                        KNNCachedResult **results, size_t *numResults);
+
+/* Cache the results of the query at `revision`, keeping at most `capacity` entries */
+void KNNResultCache_Put(KNNResultCache *cache, uint64_t revision, const sds key,
+                        const KNNCachedResult *results, size_t numResults, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
@@ -33,6 +33,7 @@
 #include "profile.h"
 #include "info/info_redis/info_redis.h"
 #include "util/logging.h"
+#include "util/cpu_dispatch.h"
 
 #define DEPLETER_POOL_SIZE 4
 
@@ -131,6 +132,13 @@ int RediSearch_Init(RedisModuleCtx *ctx, int mode) {
 #endif
   RS_Initialized = 1;
 
+  // Select the SIMD kernels before anything may run them
+  CpuDispatch_Init(CpuDispatch_DetectFeatures());
+  for (size_t i = 0; i < CpuDispatch_NumKernels(); i++) {
+    const CpuDispatch_Kernel *kernel = CpuDispatch_GetKernel(i);
+    DO_LOG("verbose", "SIMD kernel %s: %s", kernel->name, kernel->impl);
+  }
+
   if (!RSDummyContext) {
     RSDummyContext = RedisModule_GetDetachedThreadSafeContext(ctx);
   }
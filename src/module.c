@@ -42,6 +42,7 @@
 #include "module.h"
 #include "rwlock.h"
 #include "info/info_command.h"
+#include "info/memory_command.h"
 #include "rejson_api.h"
 #include "geometry/geometry_api.h"
 #include "reply.h"
@@ -72,6 +73,8 @@
 #include "hybrid/hybrid_exec.h"
 #include "util/redis_mem_info.h"
 #include "notifications.h"
+#include "index_delta.h"
+#include "slowlog.h"
 
 #define VERIFY_ACL(ctx, idxR)                                                                     \
   do {                                                                                                      \
@@ -105,6 +108,10 @@ size_t NumShards = 0;
 RedisModuleString *config_ext_load = NULL;
 RedisModuleString *config_friso_ini = NULL;
 RedisModuleString *config_default_scorer = NULL;
+RedisModuleString *config_workers_cpus = NULL;
+RedisModuleString *config_io_threads_cpus = NULL;
+RedisModuleString *config_fork_gc_cpus = NULL;
+RedisModuleString *config_hot_indexes = NULL;
 
 /* ======================= DEBUG ONLY DECLARATIONS ======================= */
 static void DEBUG_DistSearchCommandHandler(void* pd);
@@ -378,7 +385,7 @@ end:
 }
 
 char *RS_GetExplainOutput(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
-                          QueryError *status);
+                          bool withCost, QueryError *status);
 
 static int queryExplainCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
                               int newlinesAsElements) {
@@ -387,8 +394,20 @@ static int queryExplainCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int
   }
   VERIFY_ACL(ctx, argv[1])
 
+  // FT.EXPLAIN {index_name} {query} COST ...
+  bool withCost = argc > 3 && !strcasecmp(RedisModule_StringPtrLen(argv[3], NULL), "COST");
+  RedisModuleString **args = argv;
+  if (withCost) {
+    args = rm_malloc(--argc * sizeof(*args));
+    memcpy(args, argv, 3 * sizeof(*args));
+    memcpy(args + 3, argv + 4, (argc - 3) * sizeof(*args));
+  }
+
   QueryError status = QueryError_Default();
-  char *explainRoot = RS_GetExplainOutput(ctx, argv, argc, &status);
+  char *explainRoot = RS_GetExplainOutput(ctx, args, argc, withCost, &status);
+  if (args != argv) {
+    rm_free(args);
+  }
   if (!explainRoot) {
     return QueryError_ReplyAndClear(ctx, &status);
   }
@@ -412,7 +431,7 @@ static int queryExplainCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int
   return REDISMODULE_OK;
 }
 
-/* FT.EXPLAIN {index_name} {query} */
+/* FT.EXPLAIN {index_name} {query} [COST] */
 int QueryExplainCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return queryExplainCommon(ctx, argv, argc, 0);
 }
@@ -421,6 +440,7 @@ int QueryExplainCLICommand(RedisModuleCtx *ctx, RedisModuleString **argv, int ar
 }
 
 int RSAggregateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
+int RSExportCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
 int RSSearchCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
 int RSCursorCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
 int RSProfileCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
@@ -467,16 +487,117 @@ int DeleteCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   return REDISMODULE_OK;
 }
 
-/* FT.TAGVALS {idx} {field}
+/* FT.TAGVALS {idx} {field} [WITHCOUNTS [QUERY {query}] [DIALECT {dialect}] [MAX {num}]]
  * Return all the values of a tag field.
- * There is no sorting or paging, so be careful with high-cradinality tag fields */
+ * There is no sorting or paging, so be careful with high-cradinality tag fields.
+ *
+ * With WITHCOUNTS, return the [value, count] pairs of the MAX values (all of them by default) with
+ * the most documents, by decreasing count. With QUERY, only the documents matching the query are
+ * counted, which are intersected with the documents of each value rather than loaded */
+
+// Replies with the top values of the field among the documents matching `query`, or among all the
+// documents if there is no query
+static void replyTagValueCounts(RedisModuleCtx *ctx, RedisSearchCtx *sctx, TagIndex *idx,
+                                const FieldSpec *fs, const char *query, size_t queryLen,
+                                unsigned int dialect, size_t max) {
+  QueryError status = QueryError_Default();
+  RSSearchOptions opts;
+  RSSearchOptions_Init(&opts);
+  QueryAST qast = {0};
+  uint64_t *docs = NULL;
+  size_t nwords = 0;
+
+  RedisSearchCtx_LockSpecRead(sctx);
+  if (query) {
+    if (QAST_Parse(&qast, sctx, &opts, query, queryLen, dialect, &status) != REDISMODULE_OK) {
+      RedisModule_ReplyWithError(ctx, QueryError_GetUserError(&status));
+      goto end;
+    }
+    iteratorsConfig_init(&qast.config);
+    if (QAST_Expand(&qast, NULL, &opts, sctx, &status) != REDISMODULE_OK) {
+      RedisModule_ReplyWithError(ctx, QueryError_GetUserError(&status));
+      goto end;
+    }
+  }
+
+  // A wildcard query counts all the documents, which the cached frequencies of the values serve
+  if (query && (!qast.root || qast.root->type != QN_WILDCARD)) {
+    nwords = sctx->spec->docs.maxDocId / 64 + 1;
+    docs = rm_calloc(nwords, sizeof(*docs));
+  }
+  if (docs && qast.root) {
+    SearchCtx_UpdateTime(sctx, RSGlobalConfig.requestConfigParams.queryTimeoutMS);
+    QueryIterator *it = QAST_Iterate(&qast, &opts, sctx, 0, &status);
+    t_docId batch[1024];
+    size_t n;
+    while (it->ReadBatch(it, batch, 1024, &n) == ITERATOR_OK) {
+      for (size_t i = 0; i < n; i++) {
+        if (batch[i] / 64 < nwords) {
+          docs[batch[i] / 64] |= 1ULL << (batch[i] % 64);
+        }
+      }
+    }
+    it->Free(it);
+  }
+
+  TagValueCount *counts = TagIndex_TopValues(idx, sctx, docs, nwords, max, fs->index);
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  RedisModule_Reply_Array(reply);
+  for (size_t i = 0; i < array_len(counts); i++) {
+    RedisModule_Reply_Array(reply);
+      RedisModule_Reply_StringBuffer(reply, counts[i].value, counts[i].len);
+      RedisModule_Reply_LongLong(reply, counts[i].count);
+    RedisModule_Reply_ArrayEnd(reply);
+  }
+  RedisModule_Reply_ArrayEnd(reply);
+  RedisModule_EndReply(reply);
+  TagValueCounts_Free(counts);
+
+end:
+  RedisSearchCtx_UnlockSpec(sctx);
+  rm_free(docs);
+  QAST_Destroy(&qast);
+  QueryError_ClearError(&status);
+}
 
 int TagValsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
-  // at least one field, and number of field/text args must be even
-  if (argc != 3) {
+  if (argc < 3) {
     return RedisModule_WrongArity(ctx);
   }
 
+  bool withCounts = false;
+  const char *query = NULL;
+  size_t queryLen = 0;
+  unsigned int dialect = RSGlobalConfig.requestConfigParams.dialectVersion;
+  size_t max = 0;
+  ArgsCursor ac;
+  ArgsCursor_InitRString(&ac, argv + 3, argc - 3);
+  while (!AC_IsAtEnd(&ac)) {
+    if (AC_AdvanceIfMatch(&ac, "WITHCOUNTS")) {
+      withCounts = true;
+    } else if (AC_AdvanceIfMatch(&ac, "QUERY")) {
+      if (AC_GetString(&ac, &query, &queryLen, 0) != AC_OK) {
+        return RedisModule_ReplyWithError(ctx, "Need an argument for QUERY");
+      }
+    } else if (AC_AdvanceIfMatch(&ac, "DIALECT")) {
+      QueryError status = QueryError_Default();
+      if (parseDialect(&dialect, &ac, &status) != REDISMODULE_OK) {
+        RedisModule_ReplyWithError(ctx, QueryError_GetUserError(&status));
+        QueryError_ClearError(&status);
+        return REDISMODULE_OK;
+      }
+    } else if (AC_AdvanceIfMatch(&ac, "MAX")) {
+      if (AC_GetSize(&ac, &max, AC_F_GE1) != AC_OK) {
+        return RedisModule_ReplyWithError(ctx, "MAX must be a positive integer");
+      }
+    } else {
+      return RedisModule_ReplyWithError(ctx, "Unknown argument for FT.TAGVALS");
+    }
+  }
+  if (!withCounts && (query || max)) {
+    return RedisModule_ReplyWithError(ctx, "QUERY and MAX require WITHCOUNTS");
+  }
+
   RedisSearchCtx *sctx = NewSearchCtx(ctx, argv[1], true);
   if (sctx == NULL) {
     return RedisModule_ReplyWithError(ctx, "Unknown Index name");
@@ -500,11 +621,19 @@ int TagValsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
   TagIndex *idx = TagIndex_Open(sctx->spec, rstr, DONT_CREATE_INDEX);
   RedisModule_FreeString(ctx, rstr);
   if (!idx) {
-    RedisModule_ReplyWithSet(ctx, 0);
+    if (withCounts) {
+      RedisModule_ReplyWithArray(ctx, 0);
+    } else {
+      RedisModule_ReplyWithSet(ctx, 0);
+    }
     goto cleanup;
   }
 
-  TagIndex_SerializeValues(idx, ctx);
+  if (withCounts) {
+    replyTagValueCounts(ctx, sctx, idx, fs, query, queryLen, dialect, max);
+  } else {
+    TagIndex_SerializeValues(idx, ctx);
+  }
 
 cleanup:
   CurrentThread_ClearIndexSpec();
@@ -732,7 +861,9 @@ int SynUpdateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
   SynonymMap_UpdateRedisStr(sp->smap, argv + offset, argc - offset, id);
 
-  if (initialScan) {
+  // The group is rebuilt from the inverted indexes of its terms, rather than by indexing all the
+  // documents again, unless they are not kept in memory
+  if (initialScan && !IndexSpec_RebuildSynonymGroup(&sctx, id)) {
     IndexSpec_ScanAndReindex(ctx, ref);
   }
 
@@ -1325,6 +1456,7 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx) {
     RedisModule_Log(ctx, "warning", "Failed to initialize thread local data, error: %d", error);
     return REDISMODULE_ERR;
   }
+  IndexDelta_Init();
 
   char ver[64];
   GetFormattedRedisVersion(ver, sizeof(ver));
@@ -1357,6 +1489,11 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx) {
       RedisModule_Log(ctx, "error", "Search Disk is enabled but could not be initialized");
       return REDISMODULE_ERR;
     }
+  } else if (RSGlobalConfig.termTieringIdleCycles && SearchDisk_HasAPI()) {
+    // The indexes stay in memory, and only the blocks of their cold terms are moved to the disk
+    if (!SearchDisk_Initialize(ctx) || !SearchDisk_HasPostings()) {
+      RedisModule_Log(ctx, "warning", "Search Disk does not store postings, terms stay in memory");
+    }
   }
 
   // register trie-dictionary type
@@ -1386,6 +1523,9 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx) {
   RM_TRY(RMCreateSearchCommand(ctx, RS_INDEX_LIST_CMD, IndexList, "readonly",
          0, 0, 0, "slow admin", false))
 
+  RM_TRY(RMCreateSearchCommand(ctx, RS_SLOWLOG_CMD, SlowLogCommand, "readonly",
+         0, 0, 0, "slow admin", false))
+
   RM_TRY(RMCreateSearchCommand(ctx, RS_ADD_CMD, RSAddDocumentCommand,
          "write deny-oom", INDEX_DOC_CMD_ARGS, "write", false))
 
@@ -1415,6 +1555,9 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx) {
   RM_TRY(RMCreateSearchCommand(ctx, RS_AGGREGATE_CMD, RSAggregateCommand,
          "readonly", INDEX_ONLY_CMD_ARGS, "read", true))
 
+  RM_TRY(RMCreateSearchCommand(ctx, RS_EXPORT_CMD, RSExportCommand,
+         "readonly", INDEX_ONLY_CMD_ARGS, "read", true))
+
   RM_TRY(RMCreateSearchCommand(ctx, RS_GET_CMD, GetSingleDocumentCommand,
          "readonly", INDEX_DOC_CMD_ARGS, "read", false))
 
@@ -1432,6 +1575,9 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx) {
          "write", INDEX_ONLY_CMD_ARGS, "", true))
   RM_TRY_F(RegisterRestoreIfNxCommands, RedisModule_GetCommand(ctx, RS_RESTORE_IF_NX))
 
+  RM_TRY(RMCreateSearchCommand(ctx, RS_INDEX_DELTA_CMD, IndexDeltaCommand,
+         "write", INDEX_DOC_CMD_ARGS, "", true))
+
   // Special cases: Register drop commands which write to arbitrary keys
   RM_TRY(RMCreateArbitraryWriteSearchCommand(ctx, RS_DROP_CMD, DropIndexCommand,
          "write", INDEX_ONLY_CMD_ARGS, "write slow dangerous", !IsEnterprise()))
@@ -1449,6 +1595,9 @@ int RediSearch_InitModuleInternal(RedisModuleCtx *ctx) {
   RM_TRY(RMCreateSearchCommand(ctx, RS_INFO_CMD, IndexInfoCommand,
          "readonly", INDEX_ONLY_CMD_ARGS, "", true))
 
+  RM_TRY(RMCreateSearchCommand(ctx, RS_MEMORY_CMD, IndexMemoryCommand,
+         "readonly", INDEX_ONLY_CMD_ARGS, "read slow", false))
+
   RM_TRY(RMCreateSearchCommand(ctx, RS_TAGVALS_CMD, TagValsCommand,
          "readonly", INDEX_ONLY_CMD_ARGS, "read slow dangerous", true))
 
@@ -1581,6 +1730,7 @@ void RediSearch_CleanupModule(void) {
   // GeometryApi_Free();
 
   Dictionary_Free();
+  SlowLog_Free();
   RediSearch_LockDestory();
 
   IndexError_GlobalCleanup();
@@ -1646,6 +1796,77 @@ cleanup:
   return REDISMODULE_OK;
 }
 
+// Sums the [value, count] pairs of FT.TAGVALS WITHCOUNTS replied by the shards, and replies with
+// the values with the most documents, as many as the privdata of the context (all of them if 0).
+// Each shard only replies with its own top values, so the counts of the values missing from the top
+// of some shards are partial
+int tagValueCountsReducer(struct MRCtx *mc, int count, MRReply **replies) {
+  RedisModuleCtx *ctx = MRCtx_GetRedisCtx(mc);
+  size_t max = (uintptr_t)MRCtx_GetPrivData(mc);
+
+  TrieMap *dict = NewTrieMap();
+  MRReply *err = NULL;
+  int nArrs = 0;
+  for (int i = 0; i < count; i++) {
+    if (!replies[i]) {
+      continue;
+    }
+    if (MRReply_Type(replies[i]) == MR_REPLY_ERROR) {
+      err = err ? err : replies[i];
+      continue;
+    }
+    nArrs++;
+    for (size_t j = 0; j < MRReply_Length(replies[i]); j++) {
+      MRReply *pair = MRReply_ArrayElement(replies[i], j);
+      size_t sl = 0;
+      const char *s = MRReply_String(MRReply_ArrayElement(pair, 0), &sl);
+      if (!s) {
+        continue;
+      }
+      size_t *sum = TrieMap_Find(dict, s, sl);
+      if (sum == TRIEMAP_NOTFOUND) {
+        sum = rm_calloc(1, sizeof(*sum));
+        TrieMap_Add(dict, s, sl, sum, NULL);
+      }
+      *sum += MRReply_Integer(MRReply_ArrayElement(pair, 1));
+    }
+  }
+
+  TagValueCount *counts = rm_malloc(MAX(TrieMap_NUniqueKeys(dict), 1) * sizeof(*counts));
+  size_t n = 0;
+  char *s;
+  tm_len_t sl;
+  void *p;
+  TrieMapIterator *it = TrieMap_Iterate(dict);
+  while (TrieMapIterator_Next(it, &s, &sl, &p)) {
+    counts[n++] = (TagValueCount){.value = rm_strndup(s, sl), .len = sl, .count = *(size_t *)p};
+  }
+  TrieMapIterator_Free(it);
+  TrieMap_Free(dict, NULL);
+  qsort(counts, n, sizeof(*counts), TagValueCount_Compare);
+
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  if (!nArrs && err) {
+    MR_ReplyWithMRReply(reply, err);
+  } else {
+    RedisModule_Reply_Array(reply);
+    for (size_t i = 0; i < n && (!max || i < max); i++) {
+      RedisModule_Reply_Array(reply);
+        RedisModule_Reply_StringBuffer(reply, counts[i].value, counts[i].len);
+        RedisModule_Reply_LongLong(reply, counts[i].count);
+      RedisModule_Reply_ArrayEnd(reply);
+    }
+    RedisModule_Reply_ArrayEnd(reply);
+  }
+  RedisModule_EndReply(reply);
+
+  for (size_t i = 0; i < n; i++) {
+    rm_free(counts[i].value);
+  }
+  rm_free(counts);
+  return REDISMODULE_OK;
+}
+
 // A reducer that just merges N arrays of the same length, selecting the first non NULL reply from
 // each
 
@@ -1797,11 +2018,15 @@ typedef struct{
   specialCaseCtx* reduceSpecialCaseCtxSortby;
 
   MRReply *warning;
+
+  int currentReply;     // The index of the shard reply being processed
+  uint32_t *shardHits;  // The KNN top results of each shard, when learning the shard window
 } searchReducerCtx;
 
 typedef struct {
   searchResult* result;
   double score;
+  int reply;  // The shard reply of the result
 } scoredSearchResultWrapper;
 
 specialCaseCtx* SpecialCaseCtx_New() {
@@ -1838,6 +2063,17 @@ static void searchRequestCtx_Free(searchRequestCtx *r) {
   if(r->requiredFields) {
     array_free(r->requiredFields);
   }
+  if (r->shardWindowK) {
+    WeakRef_Release(r->shardWindowSpec);
+  }
+  if (r->thresholdCmd) {
+    MRCommand_Free(r->thresholdCmd);
+    rm_free(r->thresholdCmd);
+  }
+  if (r->knnBoundCmd) {
+    MRCommand_Free(r->knnBoundCmd);
+    rm_free(r->knnBoundCmd);
+  }
   rm_free(r);
 }
 
@@ -2409,6 +2645,7 @@ static void ProcessKNNSearchResult(searchResult *res, searchReducerCtx *rCtx, do
       scoredSearchResultWrapper* resWrapper = rm_malloc(sizeof(scoredSearchResultWrapper));
       resWrapper->result = res;
       resWrapper->score = score;
+      resWrapper->reply = rCtx->currentReply;
       heap_offerx(knnCtx->pq, resWrapper);
     } else {
       // Check for upper bound
@@ -2421,6 +2658,7 @@ static void ProcessKNNSearchResult(searchResult *res, searchReducerCtx *rCtx, do
         scoredSearchResultWrapper* resWrapper = rm_malloc(sizeof(scoredSearchResultWrapper));
         resWrapper->result = res;
         resWrapper->score = score;
+        resWrapper->reply = rCtx->currentReply;
         // Current result is smaller then upper bound, replace them.
         largest = heap_poll(knnCtx->pq);
         heap_offerx(knnCtx->pq, resWrapper);
@@ -2635,6 +2873,9 @@ static void knnPostProcess(searchReducerCtx *rCtx) {
     for (size_t i = 0; i < numberOfResults; i++) {
       scoredSearchResultWrapper* wrappedResult = heap_poll(reducerSpecialCaseCtx->knn.pq);
       searchResult* res = wrappedResult->result;
+      if (rCtx->shardHits) {
+        rCtx->shardHits[wrappedResult->reply]++;
+      }
       rm_free(wrappedResult);
       if(heap_count(rCtx->pq) < heap_size(rCtx->pq)) {
         heap_offerx(rCtx->pq, res);
@@ -2894,6 +3135,248 @@ static int searchResultReducer_background(struct MRCtx *mc, int count, MRReply *
   return REDISMODULE_OK;
 }
 
+/* The score threshold of a distributed search sorted by score, enabled by
+ * _SCORE_THRESHOLD_MIN_RESULTS.
+ *
+ * The shards are first only asked for the scores of their top ceil(k / numShards) results, k being
+ * the offset plus the limit of the query. Once there are k of them or more, the k-th best score is
+ * a lower bound of the score of the k-th top result of the query, and the shards are then asked
+ * for their top k results with `_SCORE_THRESHOLD`, so that they don't sort, load nor send the
+ * results scoring below it. The top results of the query are the same. */
+
+static bool useScoreThreshold(const searchRequestCtx *req) {
+  return RSGlobalConfig.scoreThresholdMinResults && NumShards > 1 && req->limit > 0 &&
+         req->requestedResultsCount >= RSGlobalConfig.scoreThresholdMinResults &&
+         !req->withSortby && !req->specialCases && !req->profileArgs &&
+         !req->withExplainScores && !req->withPayload && !req->withSortingKeys;
+}
+
+// The command reading the scores of the top results of the shards, from the command of the query
+static MRCommand scoresCommand(const MRCommand *cmd, const searchRequestCtx *req) {
+  MRCommand scoresCmd = MRCommand_Copy(cmd);
+  // The last LIMIT is the one the shards use
+  char buf[32];
+  long long perShard = (req->requestedResultsCount + NumShards - 1) / NumShards;
+  int len = snprintf(buf, sizeof(buf), "%lld", perShard);
+  MRCommand_Append(&scoresCmd, "LIMIT", sizeof("LIMIT") - 1);
+  MRCommand_Append(&scoresCmd, "0", 1);
+  MRCommand_Append(&scoresCmd, buf, len);
+  MRCommand_Append(&scoresCmd, "NOCONTENT", sizeof("NOCONTENT") - 1);
+  return scoresCmd;
+}
+
+static void appendScore(arrayof(double) *scores, MRReply *score) {
+  double d;
+  if (score && MRReply_ToDouble(score, &d)) {
+    array_append(*scores, d);
+  }
+}
+
+static int cmpScoresDesc(const void *a, const void *b) {
+  double d1 = *(const double *)a, d2 = *(const double *)b;
+  return d1 < d2 ? 1 : (d1 > d2 ? -1 : 0);
+}
+
+// Returns whether the replies to the scores command hold at least `k` scores, and sets the k-th
+// best of them in `threshold`. The replies which failed are skipped
+static bool getScoreThreshold(MRReply **replies, int count, size_t k, double *threshold) {
+  arrayof(double) scores = array_new(double, 64);
+  for (int i = 0; i < count; i++) {
+    MRReply *rep = replies[i];
+    if (MRReply_Type(rep) == MR_REPLY_MAP) {
+      MRReply *results = MRReply_MapElement(rep, "results");
+      size_t len = results ? MRReply_Length(results) : 0;
+      for (size_t j = 0; j < len; j++) {
+        MRReply *result = MRReply_ArrayElement(results, j);
+        if (MRReply_Type(result) == MR_REPLY_MAP) {
+          appendScore(&scores, MRReply_MapElement(result, "score"));
+        }
+      }
+    } else if (MRReply_Type(rep) == MR_REPLY_ARRAY) {
+      // The total, then the id and the score of each result
+      size_t len = MRReply_Length(rep);
+      for (size_t j = 2; j < len; j += 2) {
+        appendScore(&scores, MRReply_ArrayElement(rep, j));
+      }
+    }
+  }
+
+  bool found = array_len(scores) >= k;
+  if (found) {
+    qsort(scores, array_len(scores), sizeof(*scores), cmpScoresDesc);
+    *threshold = scores[k - 1];
+  }
+  array_free(scores);
+  return found;
+}
+
+static void scoreThresholdReducer(void *mc_v) {
+  struct MRCtx *mc = mc_v;
+  searchRequestCtx *req = MRCtx_GetPrivData(mc);
+  MRCommand *cmd = req->thresholdCmd;
+  req->thresholdCmd = NULL;
+
+  double threshold;
+  if (getScoreThreshold(MRCtx_GetReplies(mc), MRCtx_GetNumReplied(mc), req->requestedResultsCount,
+                        &threshold)) {
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%.17g", threshold);
+    MRCommand_Append(cmd, "_SCORE_THRESHOLD", sizeof("_SCORE_THRESHOLD") - 1);
+    MRCommand_Append(cmd, buf, len);
+  }
+
+  // Ask for the results, which the shards reply to as they do without a threshold
+  struct MRCtx *resultsCtx = MR_CreateCtx(0, MRCtx_GetBlockedClient(mc), req, NumShards);
+  MRCtx_SetReduceFunction(resultsCtx, searchResultReducer_background);
+  MR_Fanout(resultsCtx, NULL, *cmd, false);
+  rm_free(cmd);
+
+  MRCtx_RequestCompleted(mc);
+  MRCtx_Free(mc);
+}
+
+static int scoreThresholdReducer_background(struct MRCtx *mc, int count, MRReply **replies) {
+  ConcurrentSearch_ThreadPoolRun(scoreThresholdReducer, mc, DIST_THREADPOOL);
+  return REDISMODULE_OK;
+}
+
+/* The second round of a distributed KNN query whose shards were asked for a window of its K
+ * results, enabled by _SHARD_WINDOW_SECOND_ROUND.
+ *
+ * A shard whose whole window made it to the top K results of the first round may have had more of
+ * them to give. The shards are then asked again for the full K with `_KNN_DISTANCE_BOUND`, set to
+ * the K-th distance of the first round, which no top result of the query is further than. Their
+ * graph search only explores around the results within the bound, so that the shards which have no
+ * more of them to give reply at once. The replies of the second round make the reply of the query,
+ * otherwise those of the first round do. */
+
+typedef struct {
+  double distance;
+  int reply;
+} knnReplyResult;
+
+static void appendKNNResult(arrayof(knnReplyResult) *results, MRReply *distance, int reply) {
+  double d;
+  if (distance && MRReply_ToDouble(distance, &d)) {
+    knnReplyResult r = {.distance = d, .reply = reply};
+    array_append(*results, r);
+  }
+}
+
+static int cmpKNNDistance(const void *a, const void *b) {
+  double d1 = ((const knnReplyResult *)a)->distance, d2 = ((const knnReplyResult *)b)->distance;
+  return d1 < d2 ? -1 : (d1 > d2 ? 1 : 0);
+}
+
+static const specialCaseCtx *getKNNCtx(const searchRequestCtx *req) {
+  for (size_t i = 0; i < array_len(req->specialCases); i++) {
+    if (req->specialCases[i]->specialCaseType == SPECIAL_CASE_KNN) {
+      return req->specialCases[i];
+    }
+  }
+  RS_ABORT("The query has no KNN");
+  return NULL;
+}
+
+// Returns whether a shard may have left out some of the top K results in the first round. Sets the
+// number of top results of each reply in `hits`, and in `bound` the distance no top result is
+// further than, INFINITY if there were less than K results. False if a reply failed
+static bool needsKNNSecondRound(const searchRequestCtx *req, MRReply **replies, int count,
+                                uint32_t *hits, double *bound) {
+  const specialCaseCtx *knnCtx = getKNNCtx(req);
+  searchReplyOffsets offsets;
+  getReplyOffsets(req, &offsets);
+
+  arrayof(knnReplyResult) results = array_new(knnReplyResult, 64);
+  bool failed = false;
+  for (int i = 0; i < count && !failed; i++) {
+    MRReply *rep = replies[i];
+    if (MRReply_Type(rep) == MR_REPLY_MAP) {
+      MRReply *repResults = MRReply_MapElement(rep, "results");
+      size_t len = repResults ? MRReply_Length(repResults) : 0;
+      for (size_t j = 0; j < len; j++) {
+        MRReply *fields = MRReply_MapElement(MRReply_ArrayElement(repResults, j), "required_fields");
+        appendKNNResult(&results, fields ? MRReply_MapElement(fields, knnCtx->knn.fieldName) : NULL, i);
+      }
+    } else if (MRReply_Type(rep) == MR_REPLY_ARRAY) {
+      // The total, then the fields of each result
+      size_t len = MRReply_Length(rep);
+      for (size_t j = 1; j + offsets.step <= len; j += offsets.step) {
+        appendKNNResult(&results, MRReply_ArrayElement(rep, j + knnCtx->knn.offset), i);
+      }
+    } else {
+      failed = true;
+    }
+  }
+
+  bool needed = false;
+  size_t k = knnCtx->knn.k;
+  if (!failed) {
+    qsort(results, array_len(results), sizeof(*results), cmpKNNDistance);
+    size_t top = array_len(results) < k ? array_len(results) : k;
+    for (size_t i = 0; i < top; i++) {
+      if (++hits[results[i].reply] >= req->knnWindow) {
+        needed = true;
+      }
+    }
+    *bound = top == k ? results[k - 1].distance : INFINITY;
+  }
+  array_free(results);
+  return needed;
+}
+
+static void knnBoundReducer(void *mc_v) {
+  struct MRCtx *mc = mc_v;
+  searchRequestCtx *req = MRCtx_GetPrivData(mc);
+  MRReply **replies = MRCtx_GetReplies(mc);
+  int count = MRCtx_GetNumReplied(mc);
+  MRCommand *cmd = req->knnBoundCmd;
+  req->knnBoundCmd = NULL;
+
+  uint32_t *hits = rm_calloc(count ? count : 1, sizeof(*hits));
+  double bound;
+  if (!needsKNNSecondRound(req, replies, count, hits, &bound)) {
+    rm_free(hits);
+    MRCommand_Free(cmd);
+    rm_free(cmd);
+    searchResultReducer(mc, count, replies);
+    return;
+  }
+
+  // What the first round missed is learned from, rather than the replies of the second one
+  if (req->shardWindowK) {
+    StrongRef strong_ref = IndexSpecRef_Promote(req->shardWindowSpec);
+    IndexSpec *sp = StrongRef_Get(strong_ref);
+    if (sp) {
+      ShardWindow_Learn(sp, getKNNCtx(req)->knn.k, req->shardWindowK, hits, count);
+      IndexSpecRef_Release(strong_ref);
+    }
+    WeakRef_Release(req->shardWindowSpec);
+    req->shardWindowK = 0;
+  }
+  rm_free(hits);
+
+  if (!isinf(bound)) {
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%.17g", bound);
+    MRCommand_Append(cmd, "_KNN_DISTANCE_BOUND", sizeof("_KNN_DISTANCE_BOUND") - 1);
+    MRCommand_Append(cmd, buf, len);
+  }
+  cmd->hedgeable = true;
+  struct MRCtx *resultsCtx = MR_CreateCtx(0, MRCtx_GetBlockedClient(mc), req, NumShards);
+  MRCtx_SetReduceFunction(resultsCtx, searchResultReducer_background);
+  MR_Fanout(resultsCtx, NULL, *cmd, false);
+  rm_free(cmd);
+
+  MRCtx_RequestCompleted(mc);
+  MRCtx_Free(mc);
+}
+
+static int knnBoundReducer_background(struct MRCtx *mc, int count, MRReply **replies) {
+  ConcurrentSearch_ThreadPoolRun(knnBoundReducer, mc, DIST_THREADPOOL);
+  return REDISMODULE_OK;
+}
+
 // TODO - get RequestConfig ptr as parameter instead of global config
 bool should_return_error(QueryErrorCode errCode) {
   // Check if this is a timeout error with non-fail policy
@@ -2975,6 +3458,9 @@ static int searchResultReducer(struct MRCtx *mc, int count, MRReply **replies) {
           knnCtx->knn.pq = rm_malloc(heap_sizeof(knnCtx->knn.k));
           heap_init(knnCtx->knn.pq, cmp_scored_results, NULL, knnCtx->knn.k);
           rCtx.processReply = (processReplyCB) ProcessKNNSearchReply;
+          if (req->shardWindowK) {
+            rCtx.shardHits = rm_calloc(count, sizeof(*rCtx.shardHits));
+          }
           break;
         }
       } else if (req->specialCases[i]->specialCaseType == SPECIAL_CASE_SORTBY) {
@@ -2985,6 +3471,7 @@ static int searchResultReducer(struct MRCtx *mc, int count, MRReply **replies) {
 
   if (!profile) {
     for (int i = 0; i < count; ++i) {
+      rCtx.currentReply = i;
       rCtx.processReply(replies[i], (struct searchReducerCtx *)&rCtx, ctx);
 
       // If we timed out on strict timeout policy, return a timeout error
@@ -3009,6 +3496,7 @@ static int searchResultReducer(struct MRCtx *mc, int count, MRReply **replies) {
       } else {
         mr_reply = MRReply_ArrayElement(replies[i], 0);
       }
+      rCtx.currentReply = i;
       rCtx.processReply(mr_reply, (struct searchReducerCtx *)&rCtx, ctx);
 
       // If we timed out on strict timeout policy, return a timeout error
@@ -3036,8 +3524,18 @@ static int searchResultReducer(struct MRCtx *mc, int count, MRReply **replies) {
   rs_wall_clock_ns_t duration = rs_wall_clock_elapsed_ns(&req->initClock);
   TotalGlobalStats_CountQuery(QEXEC_F_IS_SEARCH, duration);
 
+  if (rCtx.shardHits) {
+    StrongRef strong_ref = IndexSpecRef_Promote(req->shardWindowSpec);
+    IndexSpec *sp = StrongRef_Get(strong_ref);
+    if (sp) {
+      ShardWindow_Learn(sp, rCtx.reduceSpecialCaseCtxKnn->knn.k, req->shardWindowK, rCtx.shardHits, count);
+      IndexSpecRef_Release(strong_ref);
+    }
+  }
+
 cleanup:
   RedisModule_EndReply(reply);
+  rm_free(rCtx.shardHits);
 
   if (rCtx.pq) {
     heap_destroy(rCtx.pq);
@@ -3208,6 +3706,7 @@ static int FanoutCommandHandlerIndexless(RedisModuleCtx *ctx,
 void RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
                          struct ConcurrentCmdCtx *cmdCtx);
 int RSAggregateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
+int RSExportCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
 
 /** Debug */
 void DEBUG_RSExecDistAggregate(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
@@ -3256,6 +3755,9 @@ int DistAggregateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
 
   if (NumShards == 1) {
     // There is only one shard in the cluster. We can handle the command locally.
+    if (RMUtil_StringEqualsCaseC(argv[0], "FT.EXPORT")) {
+      return RSExportCommand(ctx, argv, argc);
+    }
     return RSAggregateCommand(ctx, argv, argc);
   } else if (cannotBlockCtx(ctx)) {
     return ReplyBlockDeny(ctx, argv[0]);
@@ -3354,6 +3856,18 @@ int TagValsCommandHandler(RedisModuleCtx *ctx, RedisModuleString **argv, int arg
   /* Replace our own FT command with _FT. command */
   MRCommand_SetPrefix(&cmd, "_FT");
 
+  // The counts of the values are summed, and the options are validated by the shards
+  if (RMUtil_ArgExists("WITHCOUNTS", argv, argc, 3)) {
+    long long max = 0;
+    int maxPos = RMUtil_ArgExists("MAX", argv, argc, 3);
+    if (maxPos && maxPos + 1 < argc) {
+      RedisModule_StringToLongLong(argv[maxPos + 1], &max);
+    }
+    void *privdata = (void *)(uintptr_t)(max > 0 ? max : 0);
+    MR_Fanout(MR_CreateCtx(ctx, 0, privdata, NumShards), tagValueCountsReducer, cmd, true);
+    return REDISMODULE_OK;
+  }
+
   MR_Fanout(MR_CreateCtx(ctx, 0, NULL, NumShards), uniqueStringsReducer, cmd, true);
   return REDISMODULE_OK;
 }
@@ -3446,32 +3960,49 @@ static void bailOut(RedisModuleBlockedClient *bc, QueryError *status) {
   RedisModule_FreeThreadSafeContext(clientCtx);
 }
 
-static int prepareCommand(MRCommand *cmd, searchRequestCtx *req, RedisModuleBlockedClient *bc, int protocol,
-  RedisModuleString **argv, int argc, WeakRef spec_ref, QueryError *status) {
-
-  cmd->protocol = protocol;
+// Handle KNN with shard ratio optimization for both multi-shard and standalone
+static void applyShardWindowRatio(MRCommand *cmd, searchRequestCtx *req, IndexSpec *sp, WeakRef spec_ref) {
+  if (!req->specialCases) {
+    return;
+  }
+  for (size_t i = 0; i < array_len(req->specialCases); ++i) {
+    if (req->specialCases[i]->specialCaseType == SPECIAL_CASE_KNN) {
+      specialCaseCtx* knnCtx = req->specialCases[i];
+      KNNVectorQuery *knn_query = &knnCtx->knn.queryNode->vn.vq->knn;
+      double ratio = knn_query->shardWindowRatio;
+
+      // Learn the ratio of the index unless the query sets its own. Only the sorted KNN replies
+      // tell which shard the top results come from
+      if (RSGlobalConfig.shardWindowTargetRecall && ratio == DEFAULT_SHARD_WINDOW_RATIO &&
+          knnCtx->knn.shouldSort && NumShards > 1) {
+        ratio = ShardWindow_GetRatio(sp);
+        req->shardWindowK = calculateEffectiveK(knn_query->k, ratio, NumShards);
+        req->shardWindowSpec = WeakRef_Clone(spec_ref);
+      }
 
-  // Handle KNN with shard ratio optimization for both multi-shard and standalone
-  if (req->specialCases) {
-    for (size_t i = 0; i < array_len(req->specialCases); ++i) {
-      if (req->specialCases[i]->specialCaseType == SPECIAL_CASE_KNN) {
-        specialCaseCtx* knnCtx = req->specialCases[i];
-        KNNVectorQuery *knn_query = &knnCtx->knn.queryNode->vn.vq->knn;
-        double ratio = knn_query->shardWindowRatio;
-
-        // Apply optimization only if ratio is valid and < 1.0 (ratio = 1.0 means no optimization)
-        if (ratio < MAX_SHARD_WINDOW_RATIO) {
-          // Calculate effective K based on deployment mode
-          size_t effectiveK = calculateEffectiveK(knn_query->k, ratio, NumShards);
-          // No modification needed if K values are the same
-          if (knn_query->k == effectiveK) break;
-          // Modify the command to replace KNN k (shards will ignore $SHARD_K_RATIO)
-          modifyKNNCommand(cmd, 2 + req->profileArgs, effectiveK, knnCtx->knn.queryNode->vn.vq);
+      // Apply optimization only if ratio is valid and < 1.0 (ratio = 1.0 means no optimization)
+      if (ratio < MAX_SHARD_WINDOW_RATIO) {
+        // Calculate effective K based on deployment mode
+        size_t effectiveK = calculateEffectiveK(knn_query->k, ratio, NumShards);
+        // No modification needed if K values are the same
+        if (knn_query->k == effectiveK) break;
+        if (RSGlobalConfig.shardWindowSecondRound && knnCtx->knn.shouldSort && !req->profileArgs) {
+          req->knnWindow = effectiveK;
+          req->knnBoundCmd = rm_malloc(sizeof(*req->knnBoundCmd));
+          *req->knnBoundCmd = MRCommand_Copy(cmd);
         }
-        break; // Only handle KNN context
+        // Modify the command to replace KNN k (shards will ignore $SHARD_K_RATIO)
+        modifyKNNCommand(cmd, 2 + req->profileArgs, effectiveK, knnCtx->knn.queryNode->vn.vq);
       }
+      break; // Only handle KNN context
     }
   }
+}
+
+static int prepareCommand(MRCommand *cmd, searchRequestCtx *req, RedisModuleBlockedClient *bc, int protocol,
+  RedisModuleString **argv, int argc, WeakRef spec_ref, QueryError *status) {
+
+  cmd->protocol = protocol;
 
   // replace the LIMIT {offset} {limit} with LIMIT 0 {limit}, because we need all top N to merge
   int limitIndex = RMUtil_ArgExists("LIMIT", argv, argc, 3);
@@ -3524,6 +4055,9 @@ static int prepareCommand(MRCommand *cmd, searchRequestCtx *req, RedisModuleBloc
     MRCommand_Insert(cmd, arg_pos++, prefix, len);
   }
 
+  // After the prefixes, so that the command asking for the full K has them too
+  applyShardWindowRatio(cmd, req, sp, spec_ref);
+
   // Return spec references, no longer needed
   IndexSpecRef_Release(strong_ref);
   WeakRef_Release(spec_ref);
@@ -3557,10 +4091,22 @@ int FlatSearchCommandHandler(RedisModuleBlockedClient *bc, int protocol,
   if (!(rc == REDISMODULE_OK)) {
     return REDISMODULE_OK;
   }
+  // The shard replies do not depend on the node which serves them
+  cmd.hedgeable = true;
   // Here we have an unsafe read of `NumShards`. This is fine because its just a hint.
   struct MRCtx *mrctx = MR_CreateCtx(0, bc, req, NumShards);
 
-  MRCtx_SetReduceFunction(mrctx, searchResultReducer_background);
+  if (useScoreThreshold(req)) {
+    // Read the scores first, the command of the query is sent once the threshold is known
+    req->thresholdCmd = rm_malloc(sizeof(*req->thresholdCmd));
+    *req->thresholdCmd = cmd;
+    cmd = scoresCommand(req->thresholdCmd, req);
+    MRCtx_SetReduceFunction(mrctx, scoreThresholdReducer_background);
+  } else if (req->knnBoundCmd) {
+    MRCtx_SetReduceFunction(mrctx, knnBoundReducer_background);
+  } else {
+    MRCtx_SetReduceFunction(mrctx, searchResultReducer_background);
+  }
   MR_Fanout(mrctx, NULL, cmd, false);
   return REDISMODULE_OK;
 }
@@ -3646,6 +4192,8 @@ int DistSearchCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     return RSSearchCommand(ctx, argv, argc);
   } else if (cannotBlockCtx(ctx)) {
     return ReplyBlockDeny(ctx, argv[0]);
+  } else if (AREQ_SearchBatchOffset(argv, argc)) {
+    return RedisModule_ReplyWithError(ctx, "BATCH is not supported on a cluster of several shards");
   }
 
   SearchCmdCtx* sCmdCtx = rm_malloc(sizeof(*sCmdCtx));
@@ -3921,6 +4469,14 @@ RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RM_TRY(RMCreateSearchCommand(ctx, "FT.AGGREGATE",
            SafeCmd(DistAggregateCommand), "readonly", 0, 0, -1, "read", false))
   }
+  // FT.EXPORT runs as FT.AGGREGATE, but replies with an Arrow IPC stream
+  if (clusterConfig.type == ClusterType_RedisLabs) {
+    RM_TRY(RMCreateSearchCommand(ctx, "FT.EXPORT",
+           SafeCmd(DistAggregateCommand), "readonly", 0, 1, -2, "read", false))
+  } else {
+    RM_TRY(RMCreateSearchCommand(ctx, "FT.EXPORT",
+           SafeCmd(DistAggregateCommand), "readonly", 0, 0, -1, "read", false))
+  }
   if (clusterConfig.type == ClusterType_RedisLabs) {
     RM_TRY(RMCreateSearchCommand(ctx, "FT.HYBRID",
            SafeCmd(DistHybridCommand), "readonly", 0, 1, -2, "read", false))
@@ -4004,6 +4560,17 @@ int RedisModule_OnUnload(RedisModuleCtx *ctx) {
     RedisModule_FreeString(ctx, config_default_scorer);
     config_default_scorer = NULL;
   }
+  RedisModuleString **cpuLists[] = {&config_workers_cpus, &config_io_threads_cpus, &config_fork_gc_cpus};
+  for (size_t i = 0; i < sizeof(cpuLists) / sizeof(*cpuLists); i++) {
+    if (*cpuLists[i]) {
+      RedisModule_FreeString(ctx, *cpuLists[i]);
+      *cpuLists[i] = NULL;
+    }
+  }
+  if (config_hot_indexes) {
+    RedisModule_FreeString(ctx, config_hot_indexes);
+    config_hot_indexes = NULL;
+  }
   if (RSGlobalConfig.extLoad) {
     rm_free((void *)RSGlobalConfig.extLoad);
     RSGlobalConfig.extLoad = NULL;
@@ -4016,6 +4583,12 @@ int RedisModule_OnUnload(RedisModuleCtx *ctx) {
     rm_free((void *)RSGlobalConfig.defaultScorer);
     RSGlobalConfig.defaultScorer = NULL;
   }
+  rm_free((void *)RSGlobalConfig.workersCPUs);
+  rm_free((void *)RSGlobalConfig.ioThreadsCPUs);
+  rm_free((void *)RSGlobalConfig.forkGCCPUs);
+  RSGlobalConfig.workersCPUs = RSGlobalConfig.ioThreadsCPUs = RSGlobalConfig.forkGCCPUs = NULL;
+  rm_free((void *)RSGlobalConfig.hotIndexes);
+  RSGlobalConfig.hotIndexes = NULL;
 
   SearchDisk_Close();
 
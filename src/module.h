@@ -12,12 +12,14 @@
 #include "redismodule.h"
 #include <query_node.h>
 #include <coord/rmr/reply.h>
+#include <coord/rmr/command.h>
 #include <util/heap.h>
 #include "rmutil/rm_assert.h"
 #include "shard_window_ratio.h"
 #include "coord/special_case_ctx.h"
 #include "rs_wall_clock.h"
 #include "thpool/thpool.h"
+#include "util/references.h"
 
 // Hack to support Alpine Linux 3 where __STRING is not defined
 #if !defined(__GLIBC__) && !defined(__STRING)
@@ -108,6 +110,17 @@ typedef struct {
   rs_wall_clock profileClock;
   void *reducer;
   bool queryOOM;
+  // The K asked from each shard when the shard window ratio of the index is learned, 0 otherwise
+  size_t shardWindowK;
+  WeakRef shardWindowSpec;
+  // The command asking the shards for the results once the score threshold of the query is
+  // known, while their scores are first read (see _SCORE_THRESHOLD_MIN_RESULTS)
+  MRCommand *thresholdCmd;
+  // The K asked from each shard when it is less than the K of the KNN query, and the command asking
+  // them for the full K, sent with a distance bound if a shard may have had more results to give
+  // (see _SHARD_WINDOW_SECOND_ROUND)
+  size_t knnWindow;
+  MRCommand *knnBoundCmd;
 } searchRequestCtx;
 
 bool debugCommandsEnabled(RedisModuleCtx *ctx);
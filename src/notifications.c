@@ -16,12 +16,18 @@
 #include "util/workers.h"
 #include "dictionary.h"
 #include "slot_ranges.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "index_delta.h"
+
+#include <pthread.h>
 
 #define JSON_LEN 5 // length of string "json."
 
 RedisModuleString *global_RenameFromKey = NULL;
 extern RedisModuleCtx *RSDummyContext;
 RedisModuleString **hashFields = NULL;
+size_t keyspaceEventsCount = 0;
 
 typedef enum {
   _null_cmd,
@@ -60,6 +66,162 @@ static void freeHashFields() {
   }
 }
 
+/********************************************************
+ *      Writes deferred to the end of a transaction     *
+ ********************************************************/
+
+// A key written inside MULTI/EXEC or a script, which is indexed once they are over
+typedef struct {
+  RedisModuleString *key;
+  // The fields written so far, NULL terminated, or NULL if any of them may have been written
+  RedisModuleString **fields;
+  size_t nfields;
+} PendingWrite;
+
+static arrayof(PendingWrite) pendingWrites = NULL;
+// The position of each of the keys in `pendingWrites`
+static dict *pendingKeys = NULL;
+// Whether the job indexing the pending writes at the end of the execution unit is registered
+static bool pendingJobAdded = false;
+// The thread which deferred the writes, i.e. the main thread
+static pthread_t pendingThread;
+
+static void PendingWrite_FreeFields(PendingWrite *w) {
+  for (size_t i = 0; i < w->nfields; ++i) {
+    RedisModule_FreeString(RSDummyContext, w->fields[i]);
+  }
+  rm_free(w->fields);
+  w->fields = NULL;
+  w->nfields = 0;
+}
+
+static void PendingWrite_AddFields(PendingWrite *w, RedisModuleString **fields) {
+  if (!fields) {
+    PendingWrite_FreeFields(w);
+    return;
+  }
+  size_t n = 0;
+  while (fields[n]) {
+    ++n;
+  }
+  w->fields = rm_realloc(w->fields, (w->nfields + n + 1) * sizeof(*w->fields));
+  for (size_t i = 0; i < n; ++i) {
+    w->fields[w->nfields++] = RedisModule_HoldString(RSDummyContext, fields[i]);
+  }
+  w->fields[w->nfields] = NULL;
+}
+
+void KeyspaceEvents_IndexPending(RedisModuleCtx *ctx) {
+  if (!pendingWrites) {
+    return;
+  }
+  if (!pthread_equal(pthread_self(), pendingThread)) {
+    // Only the execution unit which deferred the writes indexes them
+    return;
+  }
+  // Detached first, as indexing the writes may be asked again meanwhile
+  arrayof(PendingWrite) writes = pendingWrites;
+  pendingWrites = NULL;
+  dictRelease(pendingKeys);
+  pendingKeys = NULL;
+
+  size_t n = array_len(writes);
+  RedisModuleString **keys = rm_malloc(n * sizeof(*keys));
+  RedisModuleString ***fields = rm_malloc(n * sizeof(*fields));
+  for (size_t i = 0; i < n; ++i) {
+    keys[i] = writes[i].key;
+    fields[i] = writes[i].fields;
+  }
+  Indexes_UpdateMatchingBatch(ctx, keys, fields, n);
+  IndexDelta_Clear();
+
+  for (size_t i = 0; i < n; ++i) {
+    RedisModule_FreeString(RSDummyContext, writes[i].key);
+    PendingWrite_FreeFields(&writes[i]);
+  }
+  rm_free(fields);
+  rm_free(keys);
+  array_free(writes);
+}
+
+bool KeyspaceEvents_IsPending(RedisModuleString *key) {
+  return pendingKeys && pthread_equal(pthread_self(), pendingThread) && dictFind(pendingKeys, key);
+}
+
+static void indexPendingJob(RedisModuleCtx *ctx, void *pd) {
+  pendingJobAdded = false;
+  KeyspaceEvents_IndexPending(ctx);
+}
+
+/*
+ * Defer the write of a hash or of a JSON document inside MULTI/EXEC or a script to the end of the
+ * execution unit, once for all the writes of each key, so that the documents of each index are
+ * written together. The commands reading an index inside the unit index them first (see
+ * IndexSpec_LoadUnsafeEx()), as does another event of a pending key. Returns false if the write
+ * must be indexed right away.
+ */
+static bool deferWrite(RedisModuleCtx *ctx, RedisModuleString *key) {
+  int flags = RedisModule_GetContextFlags(ctx);
+  if (!(flags & (REDISMODULE_CTX_FLAGS_MULTI | REDISMODULE_CTX_FLAGS_LUA)) ||
+      (flags & REDISMODULE_CTX_FLAGS_LOADING) || RedisModule_GetSelectedDb(ctx) != 0) {
+    return false;
+  }
+  if (!pendingJobAdded) {
+    if (!RedisModule_AddPostNotificationJob ||
+        RedisModule_AddPostNotificationJob(ctx, indexPendingJob, NULL, NULL) != REDISMODULE_OK) {
+      return false;
+    }
+    pendingJobAdded = true;
+  }
+
+  if (!pendingWrites) {
+    pendingWrites = array_new(PendingWrite, 16);
+    pendingKeys = dictCreate(&dictTypeHeapRedisStrings, NULL);
+    pendingThread = pthread_self();
+  }
+  dictEntry *entry = dictFind(pendingKeys, key);
+  if (entry) {
+    PendingWrite *w = pendingWrites + entry->v.u64;
+    // A key any of whose fields may have been written stays so
+    if (w->fields) {
+      PendingWrite_AddFields(w, hashFields);
+    }
+    return true;
+  }
+  PendingWrite w = {.key = RedisModule_HoldString(RSDummyContext, key)};
+  PendingWrite_AddFields(&w, hashFields);
+  array_append(pendingWrites, w);
+  entry = dictAddRaw(pendingKeys, key, NULL);
+  entry->v.u64 = array_len(pendingWrites) - 1;
+  return true;
+}
+
+// Index the pending writes before another event of one of their keys, to keep them in order
+static void indexPendingBefore(RedisModuleCtx *ctx, RedisModuleString *key) {
+  if (pendingKeys && dictFind(pendingKeys, key)) {
+    KeyspaceEvents_IndexPending(ctx);
+  }
+}
+
+static bool isJsonWriteEvent(const char *event) {
+  if (strncmp(event, "json.", JSON_LEN)) {
+    return false;
+  }
+  event += JSON_LEN;
+  return !strcmp(event, "set") ||
+         !strcmp(event, "merge") ||
+         !strcmp(event, "mset") ||
+         !strcmp(event, "del") ||
+         !strcmp(event, "numincrby") ||
+         !strcmp(event, "nummultby") ||
+         !strcmp(event, "strappend") ||
+         !strcmp(event, "arrappend") ||
+         !strcmp(event, "arrinsert") ||
+         !strcmp(event, "arrpop") ||
+         !strcmp(event, "arrtrim") ||
+         !strcmp(event, "toggle");
+}
+
 int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
                              RedisModuleString *key) {
 
@@ -78,6 +240,8 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
   RedisModuleKey *kp;
   DocumentType kType;
 
+  ++keyspaceEventsCount;
+
   static const char *hset_event = 0, *hmset_event = 0, *hsetnx_event = 0, *hincrby_event = 0,
                     *hincrbyfloat_event = 0, *hdel_event = 0, *del_event = 0, *set_event = 0,
                     *rename_from_event = 0, *rename_to_event = 0, *trimmed_event = 0, *key_trimmed_event = 0,
@@ -143,12 +307,33 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
     else redisCommand = _null_cmd;
   }
 
+  bool deferrable = false;
+  switch (redisCommand) {
+    case hset_cmd:
+    case hmset_cmd:
+    case hsetnx_cmd:
+    case hincrby_cmd:
+    case hincrbyfloat_cmd:
+    case hdel_cmd:
+    case hexpired_cmd:
+      deferrable = true;
+      break;
+    case _null_cmd:
+      deferrable = isJsonWriteEvent(event);
+      break;
+  }
+  if (deferrable && deferWrite(ctx, key)) {
+    freeHashFields();
+    return REDISMODULE_OK;
+  }
+  indexPendingBefore(ctx, key);
+
   switch (redisCommand) {
     case loaded_cmd:
       // on loaded event the key is stack allocated so to use it to load the
       // document we must copy it
       key = RedisModule_CreateStringFromString(ctx, key);
-      Indexes_UpdateMatchingWithSchemaRules(ctx, key, getDocTypeFromString(key), hashFields); //TODO: avoid getDocTypeFromString ?
+      Indexes_UpdateLoadedWithSchemaRules(ctx, key, getDocTypeFromString(key), hashFields); //TODO: avoid getDocTypeFromString ?
       RedisModule_FreeString(ctx, key);
       break;
 
@@ -216,22 +401,9 @@ int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
 /********************************************************
  *              Handling RedisJSON commands             *
  ********************************************************/
-  if (!strncmp(event, "json.", JSON_LEN)) {
-    if (!strcmp(event + JSON_LEN, "set") ||
-        !strcmp(event + JSON_LEN, "merge") ||
-        !strcmp(event + JSON_LEN, "mset") ||
-        !strcmp(event + JSON_LEN, "del") ||
-        !strcmp(event + JSON_LEN, "numincrby") ||
-        !strcmp(event + JSON_LEN, "nummultby") ||
-        !strcmp(event + JSON_LEN, "strappend") ||
-        !strcmp(event + JSON_LEN, "arrappend") ||
-        !strcmp(event + JSON_LEN, "arrinsert") ||
-        !strcmp(event + JSON_LEN, "arrpop") ||
-        !strcmp(event + JSON_LEN, "arrtrim") ||
-        !strcmp(event + JSON_LEN, "toggle")) {
-      // update index
-      Indexes_UpdateMatchingWithSchemaRules(ctx, key, DocumentType_Json, hashFields);
-    }
+  if (isJsonWriteEvent(event)) {
+    // update index
+    Indexes_UpdateMatchingWithSchemaRules(ctx, key, DocumentType_Json, hashFields);
   }
 
   freeHashFields();
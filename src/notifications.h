@@ -1,29 +1,40 @@
-/*
- * Copyright (c) 2006-Present, Redis Ltd.
- * All rights reserved.
- *
- * Licensed under your choice of the Redis Source Available License 2.0
- * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
- * GNU Affero General Public License v3 (AGPLv3).
-*/
-#pragma once
-
-#include "redismodule.h"
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
-                             RedisModuleString *key);
-void Initialize_KeyspaceNotifications();
-void Initialize_ServerEventNotifications(RedisModuleCtx *ctx);
-void Initialize_CommandFilter(RedisModuleCtx *ctx);
-void Initialize_RdbNotifications(RedisModuleCtx *ctx);
-void Initialize_RoleChangeNotifications(RedisModuleCtx *ctx);
-void RDB_LoadingEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent, void *data);
-void LoadingProgressCallback(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent, void *data);
-
-#ifdef __cplusplus
-}
-#endif
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "redismodule.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The number of keyspace events handled so far. Only accessed with the GIL held
+extern size_t keyspaceEventsCount;
+
+// Index the writes deferred to the end of the current MULTI/EXEC or script, if called from it
+void KeyspaceEvents_IndexPending(RedisModuleCtx *ctx);
+
+// Whether the write of the key is deferred to the end of the current MULTI/EXEC or script
+bool KeyspaceEvents_IsPending(RedisModuleString *key);
+
+int HashNotificationCallback(RedisModuleCtx *ctx, int type, const char *event,
+                             RedisModuleString *key);
+void Initialize_KeyspaceNotifications();
+void Initialize_ServerEventNotifications(RedisModuleCtx *ctx);
+void Initialize_CommandFilter(RedisModuleCtx *ctx);
+void Initialize_RdbNotifications(RedisModuleCtx *ctx);
+void Initialize_RoleChangeNotifications(RedisModuleCtx *ctx);
+void RDB_LoadingEvent(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent, void *data);
+void LoadingProgressCallback(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent, void *data);
+
+#ifdef __cplusplus
+}
+#endif
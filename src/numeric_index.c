@@ -10,19 +10,27 @@
 #include "redis_index.h"
 #include "iterators/inverted_index_iterator.h"
 #include "iterators/union_iterator.h"
+#include "iterators/idlist_iterator.h"
 #include "sys/param.h"
 #include "rmutil/vector.h"
 #include "rmutil/util.h"
 #include "util/arr.h"
 #include <math.h>
+#include <string.h>
 #include "redismodule.h"
 #include "util/misc.h"
 #include "util/heap_doubles.h"
+#include "rdb.h"
 
 #define NR_MINRANGE_CARD 16
 #define NR_MAXRANGE_CARD 2500
 #define NR_MAXRANGE_SIZE 10000
 
+// A tree of at least NR_LOWCARD_MIN_ENTRIES entries with fewer than NR_LOWCARD_MAX_VALUES distinct
+// values splits its leaves down to a single value each
+#define NR_LOWCARD_MIN_ENTRIES 1024
+#define NR_LOWCARD_MAX_VALUES 32
+
 #define _SPLIT_CARD_BY_DEPTH(depth) (NR_MINRANGE_CARD << ((depth) * 2)) // *2 to get exponential growth of 4
 
 #define LAST_DEPTH_OF_NON_MAX_CARD 3 // Last depth to not have the max split cardinality
@@ -46,12 +54,47 @@ static inline bool NumericRange_Overlaps(NumericRange *n, double min, double max
   return !(min > n->maxVal || max < n->minVal);
 }
 
+void NumericRange_DropExactValues(NumericRange *r) {
+  rm_free(r->values);
+  r->values = NULL;
+}
+
+// Insert the value to the sorted distinct values of the range, if it is not there yet. The array
+// grows by powers of 2, and is dropped past NR_EXACT_CARD values
+static void addExactValue(NumericRange *n, double value) {
+  size_t lo = 0, hi = n->numValues;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (n->values[mid] < value) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < n->numValues && n->values[lo] == value) {
+    return;
+  }
+  if (n->numValues == NR_EXACT_CARD) {
+    NumericRange_DropExactValues(n);
+    return;
+  }
+  if (n->numValues >= 4 && !(n->numValues & (n->numValues - 1))) {
+    n->values = rm_realloc(n->values, 2 * n->numValues * sizeof(*n->values));
+  }
+  memmove(n->values + lo + 1, n->values + lo, (n->numValues - lo) * sizeof(*n->values));
+  n->values[lo] = value;
+  n->numValues++;
+}
+
 static inline void updateCardinality(NumericRange *n, double value) {
   hll_add(&n->hll, &value, sizeof(value));
+  if (n->values) {
+    addExactValue(n, value);
+  }
 }
 
 static inline size_t getCardinality(const NumericRange *n) {
-  return hll_count(&n->hll);
+  return n->values ? n->numValues : hll_count(&n->hll);
 }
 
 size_t NumericRange_GetCardinality(const NumericRange *n) {
@@ -59,18 +102,26 @@ size_t NumericRange_GetCardinality(const NumericRange *n) {
 }
 
 /*
- * Add a numeric entry to the range. Returns the additional memory used for the action.
+ * Add a numeric entry to the range. Returns the additional memory used for the action, which is
+ * negative if it sealed a block that got packed (see `_NUMERIC_COMPRESS`).
  * This function DOES NOT update the cardinality of the range.
  * It is the caller's responsibility to update the cardinality if needed, by calling `updateCardinality`
  */
-static size_t NumericRange_Add(NumericRange *n, t_docId docId, double value) {
+static int NumericRange_Add(NumericRange *n, t_docId docId, double value) {
 
   if (value < n->minVal) n->minVal = value;
   if (value > n->maxVal) n->maxVal = value;
 
+  const uint32_t numBlocks = InvertedIndex_NumBlocks(n->entries);
   size_t size = InvertedIndex_WriteNumericEntry(n->entries, docId, value);
+  size_t saved = 0;
+  if (RSGlobalConfig.numericCompress && numBlocks && InvertedIndex_NumBlocks(n->entries) > numBlocks) {
+    // The previous block won't be written to anymore
+    saved = InvertedIndex_PackNumericBlock(n->entries, numBlocks - 1);
+  }
   n->invertedIndexSize += size;
-  return size;
+  n->invertedIndexSize -= saved;
+  return (int)size - (int)saved;
 }
 
 /**
@@ -105,33 +156,38 @@ static double NumericRange_GetMedian(IndexReader *reader, RSIndexResult *res, si
   return median;
 }
 
-static inline NumericRange *NumericRange_New() {
+static inline NumericRange *NumericRange_New(const NumericRangeTree *t) {
   NumericRange *ret = rm_new(NumericRange);
   ret->entries = NewInvertedIndex(Index_StoreNumeric, &ret->invertedIndexSize);
   ret->minVal = INFINITY;
   ret->maxVal = -INFINITY;
-  hll_init(&ret->hll, NR_BIT_PRECISION);
+  hll_init(&ret->hll, t->hllBits);
+  ret->values = t->exactCard ? rm_malloc(4 * sizeof(*ret->values)) : NULL;
+  ret->numValues = 0;
   return ret;
 }
 
-static NumericRangeNode *NewLeafNode() {
+static NumericRangeNode *NewLeafNode(const NumericRangeTree *t) {
   NumericRangeNode *n = rm_new(NumericRangeNode);
   n->left = NULL;
   n->right = NULL;
   n->value = 0;
   n->maxDepth = 0;
-  n->range = NumericRange_New();
+  n->range = NumericRange_New(t);
   return n;
 }
 
-static void NumericRangeNode_Split(NumericRangeNode *n, NRN_AddRv *rv) {
+/* Split a leaf in two. The new leaves are filled from the range of the node, which is left intact,
+ * and are only attached to the node once they are complete, so that the node is either seen as the
+ * leaf it was or as the parent of complete leaves */
+static void NumericRangeNode_Split(const NumericRangeTree *t, NumericRangeNode *n, NRN_AddRv *rv) {
   NumericRange *r = n->range;
 
-  n->left  = NewLeafNode();
-  n->right = NewLeafNode();
+  NumericRangeNode *left = NewLeafNode(t);
+  NumericRangeNode *right = NewLeafNode(t);
 
-  NumericRange *lr = n->left->range;
-  NumericRange *rr = n->right->range;
+  NumericRange *lr = left->range;
+  NumericRange *rr = right->range;
 
   rv->sz += lr->invertedIndexSize + rr->invertedIndexSize;
 
@@ -155,6 +211,8 @@ static void NumericRangeNode_Split(NumericRangeNode *n, NRN_AddRv *rv) {
 
   n->maxDepth = 1;
   n->value = split;
+  __atomic_store_n(&n->right, right, __ATOMIC_RELEASE);
+  __atomic_store_n(&n->left, left, __ATOMIC_RELEASE);
   rv->changed = 1;
   rv->numRanges += 2;
   rv->numLeaves += 1; // We split a single leaf into two, we got a single additional leaf
@@ -174,6 +232,7 @@ static void removeRange(NumericRangeNode *n, NRN_AddRv *rv) {
   rv->numRecords -= InvertedIndex_NumEntries(temp->entries);
   InvertedIndex_Free(temp->entries);
   hll_destroy(&temp->hll);
+  rm_free(temp->values);
   rm_free(temp);
 
   rv->numRanges--;
@@ -201,12 +260,13 @@ static void NumericRangeNode_Balance(NumericRangeNode **n) {
   (*n)->maxDepth = MAX((*n)->left->maxDepth, (*n)->right->maxDepth) + 1;
 }
 
-static void NumericRangeNode_Add(NumericRangeNode **np, t_docId docId, double value, NRN_AddRv *rv, size_t depth) {
+static void NumericRangeNode_Add(const NumericRangeTree *t, NumericRangeNode **np, t_docId docId,
+                                 double value, NRN_AddRv *rv, size_t depth, bool splitValues) {
   NumericRangeNode *n = *np;
   if (!NumericRangeNode_IsLeaf(n)) {
     // recursively add to its left or right child.
     NumericRangeNode **childP = value < n->value ? &n->left : &n->right;
-    NumericRangeNode_Add(childP, docId, value, rv, depth + 1);
+    NumericRangeNode_Add(t, childP, docId, value, rv, depth + 1, splitValues);
 
     if (n->range) {
       // if this inner node retains a range, add the value to the range without
@@ -238,10 +298,10 @@ static void NumericRangeNode_Add(NumericRangeNode **np, t_docId docId, double va
 
     size_t card = getCardinality(n->range);
     if (card >= getSplitCardinality(depth) ||
-        (InvertedIndex_NumEntries(n->range->entries) > NR_MAXRANGE_SIZE && card > 1)) {
+        (card > 1 && (splitValues || InvertedIndex_NumEntries(n->range->entries) > NR_MAXRANGE_SIZE))) {
 
       // split this node but don't delete its range
-      NumericRangeNode_Split(n, rv);
+      NumericRangeNode_Split(t, n, rv);
 
       if (n->maxDepth > RSGlobalConfig.numericTreeMaxDepthRange) {
         removeRange(n, rv);
@@ -331,7 +391,9 @@ uint16_t numericTreesUniqueId = 0;
 NumericRangeTree *NewNumericRangeTree() {
   NumericRangeTree *ret = rm_malloc(sizeof(NumericRangeTree));
 
-  ret->root = NewLeafNode();
+  ret->hllBits = RSGlobalConfig.numericHllPrecision;
+  ret->exactCard = RSGlobalConfig.numericExactCardinality;
+  ret->root = NewLeafNode(ret);
   ret->invertedIndexesSize = ret->root->range->invertedIndexSize;
   ret->numEntries = 0;
   ret->numLeaves = 1;
@@ -340,9 +402,116 @@ NumericRangeTree *NewNumericRangeTree() {
   ret->lastDocId = 0;
   ret->emptyLeaves = 0;
   ret->uniqueId = numericTreesUniqueId++;
+  ret->histogram.numBuckets = 0;
+  ret->histogram.numEntries = 0;
+  ret->histogram.depth = 0;
+  hll_init(&ret->distinct, NR_BIT_PRECISION);
   return ret;
 }
 
+typedef struct {
+  NumericHistogram *h;
+  size_t depth;
+  size_t filled;  // The entries of the current bucket
+} HistogramBuilder;
+
+static size_t leavesNumEntries(const NumericRangeNode *n) {
+  if (!n) return 0;
+  if (NumericRangeNode_IsLeaf(n)) {
+    return n->range ? InvertedIndex_NumEntries(n->range->entries) : 0;
+  }
+  return leavesNumEntries(n->left) + leavesNumEntries(n->right);
+}
+
+// Add the leaves to the histogram in the order of their values, closing a bucket every `depth`
+// entries. A bucket closing in the middle of a leaf ends at the interpolated value
+static void histogramAddLeaves(HistogramBuilder *b, const NumericRangeNode *n) {
+  if (!n) return;
+  if (!NumericRangeNode_IsLeaf(n)) {
+    histogramAddLeaves(b, n->left);
+    histogramAddLeaves(b, n->right);
+    return;
+  }
+  const NumericRange *r = n->range;
+  size_t numEntries = r ? InvertedIndex_NumEntries(r->entries) : 0;
+  if (!numEntries) {
+    return;
+  }
+  NumericHistogram *h = b->h;
+  if (!h->numEntries) {
+    h->bounds[0] = r->minVal;
+  }
+  for (size_t done = 0; done < numEntries;) {
+    // The last bucket takes all the remaining entries
+    size_t room = h->numBuckets + 1 < NR_HISTOGRAM_BUCKETS ? b->depth - b->filled : SIZE_MAX;
+    size_t take = MIN(numEntries - done, room);
+    done += take;
+    b->filled += take;
+    h->counts[h->numBuckets] += take;
+    h->numEntries += take;
+    if (b->filled == b->depth && h->numBuckets + 1 < NR_HISTOGRAM_BUCKETS) {
+      h->bounds[++h->numBuckets] = r->minVal + (r->maxVal - r->minVal) * done / numEntries;
+      b->filled = 0;
+    }
+  }
+  h->bounds[h->numBuckets + (b->filled ? 1 : 0)] = r->maxVal;
+}
+
+void NumericRangeTree_RebuildHistogram(NumericRangeTree *t) {
+  NumericHistogram *h = &t->histogram;
+  memset(h, 0, sizeof(*h));
+  size_t total = leavesNumEntries(t->root);
+  if (!total) {
+    return;
+  }
+  HistogramBuilder b = {.h = h, .depth = (total + NR_HISTOGRAM_BUCKETS - 1) / NR_HISTOGRAM_BUCKETS};
+  histogramAddLeaves(&b, t->root);
+  if (b.filled) {
+    h->numBuckets++;  // The last bucket is not full
+  }
+  h->depth = b.depth;
+}
+
+// Count a new value in its bucket, or rebuild the histogram once its buckets are out of balance
+static void histogramAdd(NumericRangeTree *t, double value) {
+  NumericHistogram *h = &t->histogram;
+  if (!h->numBuckets || t->numEntries >= 2 * h->depth * h->numBuckets) {
+    NumericRangeTree_RebuildHistogram(t);
+    return;
+  }
+  // The first bucket whose upper bound is not below the value (the last one if there is none)
+  uint32_t lo = 0, hi = h->numBuckets - 1;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (h->bounds[mid + 1] < value) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (value < h->bounds[0]) h->bounds[0] = value;
+  if (value > h->bounds[h->numBuckets]) h->bounds[h->numBuckets] = value;
+  h->numEntries++;
+  if (++h->counts[lo] > 2 * h->depth) {
+    NumericRangeTree_RebuildHistogram(t);
+  }
+}
+
+size_t NumericHistogram_Estimate(const NumericHistogram *h, double min, double max) {
+  double estimate = 0;
+  for (uint32_t i = 0; i < h->numBuckets; i++) {
+    double lo = h->bounds[i], hi = h->bounds[i + 1];
+    if (max < lo || min > hi) {
+      continue;
+    }
+    double ratio = (MIN(max, hi) - MAX(min, lo)) / (hi - lo);
+    // A bucket of a single value is either contained or not. Some of the entries of a bucket may
+    // match, however narrow the overlap
+    estimate += h->counts[i] ? MAX(h->counts[i] * (isfinite(ratio) ? ratio : 1), 1) : 0;
+  }
+  return ceil(estimate);
+}
+
 NRN_AddRv NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value, int isMulti) {
 
   if (docId <= t->lastDocId && !isMulti) {
@@ -350,21 +519,27 @@ NRN_AddRv NumericRangeTree_Add(NumericRangeTree *t, t_docId docId, double value,
     // from it
     return (NRN_AddRv){0};
   }
-  t->lastDocId = docId;
+
+  hll_add(&t->distinct, &value, sizeof(value));
+  bool splitValues = t->numEntries >= NR_LOWCARD_MIN_ENTRIES &&
+                     hll_count(&t->distinct) < NR_LOWCARD_MAX_VALUES;
 
   NRN_AddRv rv;
-  NumericRangeNode_Add(&t->root, docId, value, &rv, 0);
+  NumericRangeNode_Add(t, &t->root, docId, value, &rv, 0, splitValues);
 
   // rv != 0 means the tree nodes have changed, and concurrent iteration is not allowed now
   // we increment the revision id of the tree, so currently running query iterators on it
   // will abort the next time they get execution context
   if (rv.changed) {
-    t->revisionId++;
+    __atomic_store_n(&t->revisionId, t->revisionId + 1, __ATOMIC_RELEASE);
   }
+  // Published once the entry is appended, so that a reader bounded by it sees all its entries
+  __atomic_store_n(&t->lastDocId, docId, __ATOMIC_RELEASE);
   t->numRanges += rv.numRanges;
   t->numLeaves += rv.numLeaves;
   t->numEntries++;
   t->invertedIndexesSize += rv.sz;
+  histogramAdd(t, value);
 
   return rv;
 }
@@ -424,7 +599,7 @@ NRN_AddRv NumericRangeTree_TrimEmptyLeaves(NumericRangeTree *t) {
   NumericRangeNode_RemoveChild(&t->root, &rv);
   if (rv.changed) {
     // Update the NumericTree
-    t->revisionId++;
+    __atomic_store_n(&t->revisionId, t->revisionId + 1, __ATOMIC_RELEASE);
     t->numRanges += rv.numRanges;
     t->emptyLeaves += rv.numLeaves;
     t->numLeaves += rv.numLeaves;
@@ -433,22 +608,252 @@ NRN_AddRv NumericRangeTree_TrimEmptyLeaves(NumericRangeTree *t) {
   return rv;
 }
 
+// A tree of at least NR_REBALANCE_MIN_LEAVES leaves is rebuilt once merging its small adjacent
+// leaves would remove a quarter of them, or once it is twice as deep as a balanced tree. Merged
+// leaves take up to half the cardinality and the size at which a leaf splits
+#define NR_REBALANCE_MIN_LEAVES 16
+#define NR_MERGE_MAX_CARD (NR_MAXRANGE_CARD / 2)
+#define NR_MERGE_MAX_SIZE (NR_MAXRANGE_SIZE / 2)
+
+typedef struct {
+  t_docId docId;
+  double value;
+} RangeEntry;
+
+static int cmpRangeEntries(const void *a, const void *b) {
+  t_docId x = ((const RangeEntry *)a)->docId, y = ((const RangeEntry *)b)->docId;
+  return x < y ? -1 : x > y;
+}
+
+/* The nodes of a tree in the order of their values: `bounds[i]` is the split value between
+ * `leaves[i]` and `leaves[i + 1]` */
+typedef struct {
+  arrayof(NumericRangeNode *) leaves;
+  arrayof(double) bounds;
+  arrayof(NumericRangeNode *) inner;
+} TreeLayout;
+
+static void collectLayout(NumericRangeNode *n, TreeLayout *l) {
+  if (NumericRangeNode_IsLeaf(n)) {
+    array_append(l->leaves, n);
+    return;
+  }
+  collectLayout(n->left, l);
+  array_append(l->bounds, n->value);
+  collectLayout(n->right, l);
+  array_append(l->inner, n);
+}
+
+/* Fill an empty range with the entries of the leaves, in the order of their document ids */
+static void fillRange(NumericRange *r, NumericRangeNode **leaves, size_t n, bool countValues,
+                      NRN_AddRv *rv) {
+  size_t total = 0;
+  for (size_t i = 0; i < n; ++i) {
+    total += InvertedIndex_NumEntries(leaves[i]->range->entries);
+  }
+  arrayof(RangeEntry) entries = array_new(RangeEntry, total);
+  IndexDecoderCtx decoderCtx = {.tag = IndexDecoderCtx_None};
+  RSIndexResult *res = NewNumericResult();
+  for (size_t i = 0; i < n; ++i) {
+    IndexReader *reader = NewIndexReader(leaves[i]->range->entries, decoderCtx);
+    while (IndexReader_Next(reader, res)) {
+      RangeEntry e = {.docId = res->docId, .value = IndexResult_NumValue(res)};
+      array_append(entries, e);
+    }
+    IndexReader_Free(reader);
+  }
+  IndexResult_Free(res);
+
+  // The documents of the leaves interleave, but the entries of a document may come in any order
+  qsort(entries, array_len(entries), sizeof(*entries), cmpRangeEntries);
+  rv->sz += r->invertedIndexSize;
+  for (size_t i = 0; i < array_len(entries); ++i) {
+    if (countValues) {
+      updateCardinality(r, entries[i].value);
+    }
+    rv->sz += NumericRange_Add(r, entries[i].docId, entries[i].value);
+    ++rv->numRecords;
+  }
+  rv->numRanges++;
+  array_free(entries);
+}
+
+/* Replace a run of adjacent leaves with a single one holding all their entries */
+static NumericRangeNode *mergeLeaves(const NumericRangeTree *t, NumericRangeNode **leaves, size_t n,
+                                     NRN_AddRv *rv) {
+  if (n == 1) {
+    return leaves[0];
+  }
+  NumericRangeNode *merged = NewLeafNode(t);
+  fillRange(merged->range, leaves, n, true, rv);
+  rv->numLeaves++;
+  for (size_t i = 0; i < n; ++i) {
+    NumericRangeNode_Free(leaves[i], rv);
+  }
+  return merged;
+}
+
+/* Build a balanced tree over the leaves. Its inner nodes retain ranges up to the same maximal
+ * depth as the ones built by splits */
+static NumericRangeNode *buildBalanced(const NumericRangeTree *t, NumericRangeNode **leaves,
+                                       const double *bounds, size_t n, NRN_AddRv *rv) {
+  if (n == 1) {
+    return leaves[0];
+  }
+  size_t mid = n / 2;
+  NumericRangeNode *node = rm_new(NumericRangeNode);
+  node->value = bounds[mid - 1];
+  node->left = buildBalanced(t, leaves, bounds, mid, rv);
+  node->right = buildBalanced(t, leaves + mid, bounds + mid, n - mid, rv);
+  node->maxDepth = MAX(node->left->maxDepth, node->right->maxDepth) + 1;
+  node->range = NULL;
+  if (node->maxDepth <= RSGlobalConfig.numericTreeMaxDepthRange) {
+    node->range = NumericRange_New(t);
+    fillRange(node->range, leaves, n, false, rv);
+  }
+  return node;
+}
+
+/* Replace the nodes of the tree with a balanced tree over its leaves, each run of them merged into
+ * a single one */
+static void rebuildTree(NumericRangeTree *t, const TreeLayout *l, const size_t *runs, size_t numRuns,
+                        NRN_AddRv *rv) {
+  size_t numLeaves = array_len(l->leaves);
+  NumericRangeNode **leaves = rm_malloc(numRuns * sizeof(*leaves));
+  double *bounds = rm_malloc(numRuns * sizeof(*bounds));
+  size_t emptyLeaves = 0;
+  for (size_t k = 0; k < numRuns; ++k) {
+    size_t end = k + 1 < numRuns ? runs[k + 1] : numLeaves;
+    leaves[k] = mergeLeaves(t, l->leaves + runs[k], end - runs[k], rv);
+    if (k) {
+      bounds[k - 1] = l->bounds[runs[k] - 1];
+    }
+    if (InvertedIndex_NumDocs(leaves[k]->range->entries) == 0) {
+      ++emptyLeaves;
+    }
+  }
+  for (size_t i = 0; i < array_len(l->inner); ++i) {
+    removeRange(l->inner[i], rv);
+    rm_free(l->inner[i]);
+  }
+  t->root = buildBalanced(t, leaves, bounds, numRuns, rv);
+  t->emptyLeaves = emptyLeaves;
+  rm_free(leaves);
+  rm_free(bounds);
+}
+
+NRN_AddRv NumericRangeTree_Rebalance(NumericRangeTree *t) {
+  NRN_AddRv rv = {0};
+  if (t->numLeaves < NR_REBALANCE_MIN_LEAVES) {
+    return rv;
+  }
+
+  TreeLayout l = {
+    .leaves = array_new(NumericRangeNode *, t->numLeaves),
+    .bounds = array_new(double, t->numLeaves),
+    .inner = array_new(NumericRangeNode *, t->numLeaves),
+  };
+  collectLayout(t->root, &l);
+  size_t numLeaves = array_len(l.leaves);
+
+  // The leaves of a low cardinality tree hold a single value each, and are not merged
+  bool merge = !(t->numEntries >= NR_LOWCARD_MIN_ENTRIES &&
+                 hll_count(&t->distinct) < NR_LOWCARD_MAX_VALUES);
+  // The first leaf of each run of leaves to merge. Adjacent leaves have disjoint values, so the
+  // cardinality of a run is the sum of theirs
+  arrayof(size_t) runs = array_new(size_t, numLeaves);
+  size_t runEntries = 0, runCard = 0;
+  for (size_t i = 0; i < numLeaves; ++i) {
+    NumericRange *r = l.leaves[i]->range;
+    size_t entries = InvertedIndex_NumEntries(r->entries);
+    size_t card = entries ? getCardinality(r) : 0;
+    if (!i || !merge || runEntries + entries > NR_MERGE_MAX_SIZE || runCard + card > NR_MERGE_MAX_CARD) {
+      array_append(runs, i);
+      runEntries = runCard = 0;
+    }
+    runEntries += entries;
+    runCard += card;
+  }
+  size_t numRuns = array_len(runs);
+  int balancedDepth = 0;
+  while (((size_t)1 << balancedDepth) < numLeaves) {
+    ++balancedDepth;
+  }
+
+  if (numLeaves - numRuns >= numLeaves / 4 || t->root->maxDepth > 2 * balancedDepth) {
+    rebuildTree(t, &l, runs, numRuns, &rv);
+    rv.changed = 1;
+    __atomic_store_n(&t->revisionId, t->revisionId + 1, __ATOMIC_RELEASE);
+    t->numRanges += rv.numRanges;
+    t->numLeaves += rv.numLeaves;
+    t->invertedIndexesSize += rv.sz;
+  }
+
+  array_free(runs);
+  array_free(l.leaves);
+  array_free(l.bounds);
+  array_free(l.inner);
+  return rv;
+}
+
 void NumericRangeTree_Free(NumericRangeTree *t) {
   NRN_AddRv rv = {0};
   NumericRangeNode_Free(t->root, &rv);
+  hll_destroy(&t->distinct);
   rm_free(t);
 }
 
-static QueryIterator *NewNumericRangeIterator(const RedisSearchCtx *sctx, NumericRange *nr,
-                                              const NumericFilter *f, const FieldFilterContext* filterCtx) {
+bool NumericRange_MatchesAll(const NumericRange *nr, const NumericFilter *f) {
+  return NumericFilter_IsNumeric(f) && NumericFilter_Match(f, nr->minVal) &&
+         NumericFilter_Match(f, nr->maxVal);
+}
+
+// The documents of a range partially overlapping [min, max], estimated by the histogram of the tree
+static size_t NumericRange_OverlapDocs(const NumericRange *nr, const NumericHistogram *h,
+                                       double min, double max) {
+  size_t numDocs = InvertedIndex_NumDocs(nr->entries);
+  size_t estimate = NumericHistogram_Estimate(h, MAX(min, nr->minVal), MIN(max, nr->maxVal));
+  return MIN(numDocs, estimate);
+}
+
+static size_t recursiveCardinality(const NumericRangeNode *n, const NumericHistogram *h,
+                                   const NumericFilter *f, bool *exact) {
+  if (!n) return 0;
+  if (n->range) {
+    if (NumericRange_MatchesAll(n->range, f)) {
+      // A document with several values may be in several ranges
+      if (InvertedIndex_Flags(n->range->entries) & Index_HasMultiValue) {
+        *exact = false;
+      }
+      return InvertedIndex_NumDocs(n->range->entries);
+    }
+    if (!NumericRange_Overlaps(n->range, f->min, f->max)) {
+      return 0;
+    }
+  }
+  if (!NumericRangeNode_IsLeaf(n)) {
+    return (f->min <= n->value ? recursiveCardinality(n->left, h, f, exact) : 0) +
+           (f->max >= n->value ? recursiveCardinality(n->right, h, f, exact) : 0);
+  }
+  *exact = false;
+  return NumericRange_OverlapDocs(n->range, h, f->min, f->max);
+}
+
+size_t NumericRangeTree_Cardinality(const NumericRangeTree *t, const NumericFilter *f, bool *exact) {
+  RS_ASSERT(NumericFilter_IsNumeric(f));
+  *exact = true;
+  return recursiveCardinality(t->root, &t->histogram, f, exact);
+}
+
+QueryIterator *NewNumericRangeIterator(const RedisSearchCtx *sctx, NumericRange *nr,
+                                       const NumericFilter *f, const FieldFilterContext* filterCtx) {
 
   const FieldSpec *fs = f->fieldSpec;
   // for numeric, if this range is at either end of the filter, we need
   // to check each record.
   // for geo, we always keep the filter to check the distance
-  if (NumericFilter_IsNumeric(f) &&
-      NumericFilter_Match(f, nr->minVal) && NumericFilter_Match(f, nr->maxVal)) {
-    // make the filter NULL so the reader will ignore it
+  if (NumericRange_MatchesAll(nr, f)) {
+    // make the filter NULL so the reader will ignore it, and read the range's ids alone
     f = NULL;
   }
 
@@ -498,6 +903,96 @@ QueryIterator *createNumericIterator(const RedisSearchCtx *sctx, NumericRangeTre
   return NewUnionIterator(its, n, true, 1.0, type, NULL, config);
 }
 
+#define NUMERIC_BITMAP_BATCH 1024
+
+/* Read the documents of all the ranges into a bitmap of the ids of the tree, and iterate its set
+ * bits. A document with several values in the ranges is set once, as the union yields it once */
+static QueryIterator *bitmapUnionRanges(const RedisSearchCtx *sctx, NumericRangeTree *t, Vector *v,
+                                        const NumericFilter *f, const FieldFilterContext* filterCtx) {
+  // Entries appended after the bitmap is sized are skipped
+  t_docId maxId = NumericRangeTree_LastDocId(t);
+  size_t nwords = maxId / 64 + 1;
+  uint64_t *bits = rm_calloc(nwords, sizeof(*bits));
+  size_t count = 0;
+  t_docId batch[NUMERIC_BITMAP_BATCH];
+  for (size_t i = 0; i < Vector_Size(v); i++) {
+    NumericRange *rng;
+    Vector_Get(v, i, &rng);
+    QueryIterator *it = NewNumericRangeIterator(sctx, rng, f, filterCtx);
+    size_t n;
+    while (it->ReadBatch(it, batch, NUMERIC_BITMAP_BATCH, &n) == ITERATOR_OK) {
+      for (size_t j = 0; j < n; j++) {
+        if (batch[j] > maxId) {
+          continue;
+        }
+        uint64_t bit = 1ULL << (batch[j] % 64);
+        uint64_t *word = &bits[batch[j] / 64];
+        count += !(*word & bit);
+        *word |= bit;
+      }
+    }
+    it->Free(it);
+  }
+
+  if (!count) {
+    rm_free(bits);
+    return NULL;
+  }
+  t_docId *ids = rm_malloc(count * sizeof(*ids));
+  size_t k = 0;
+  for (size_t w = 0; w < nwords; w++) {
+    for (uint64_t word = bits[w]; word; word &= word - 1) {
+      ids[k++] = w * 64 + __builtin_ctzll(word);
+    }
+  }
+  rm_free(bits);
+  return NewIdListIterator(ids, count, 1.0);
+}
+
+/* Merge the batches of the documents of all the ranges, decoded with the filter applied (or
+ * skipped, for the ranges it covers), rather than advancing their iterators one at a time */
+static QueryIterator *mergeUnionRanges(const RedisSearchCtx *sctx, Vector *v, const NumericFilter *f,
+                                       const FieldFilterContext* filterCtx) {
+  size_t n = Vector_Size(v);
+  QueryIterator **its = rm_calloc(n, sizeof(QueryIterator *));
+  for (size_t i = 0; i < n; i++) {
+    NumericRange *rng;
+    Vector_Get(v, i, &rng);
+    if (rng) {
+      its[i] = NewNumericRangeIterator(sctx, rng, f, filterCtx);
+    }
+  }
+  return NewMergeUnionIterator(its, n, 1.0, QN_NUMERIC);
+}
+
+/* Same as createNumericIterator, for the queries which only need the ids of the matching
+ * documents. When the filter selects many ranges, they are read in a single pass into a bitmap
+ * (see `_NUMERIC_BITMAP_UNION_RANGES`), or their batches are merged (see
+ * `_NUMERIC_MERGE_UNION_RANGES`), rather than merged by a union iterator */
+QueryIterator *createNumericIdsIterator(const RedisSearchCtx *sctx, NumericRangeTree *t,
+                                        const NumericFilter *f, IteratorsConfig *config,
+                                        const FieldFilterContext* filterCtx) {
+  size_t bitmapRanges = RSGlobalConfig.numericBitmapUnionRanges;
+  size_t mergeRanges = RSGlobalConfig.numericMergeUnionRanges;
+  if ((!bitmapRanges && !mergeRanges) || !NumericFilter_IsNumeric(f)) {
+    return createNumericIterator(sctx, t, f, config, filterCtx);
+  }
+
+  Vector *v = NumericRangeTree_Find(t, f);
+  size_t n = Vector_Size(v);
+  QueryIterator *it;
+  if (bitmapRanges && n >= bitmapRanges) {
+    it = bitmapUnionRanges(sctx, t, v, f, filterCtx);
+  } else if (mergeRanges && n >= mergeRanges && n > 1) {
+    it = mergeUnionRanges(sctx, v, f, filterCtx);
+  } else {
+    Vector_Free(v);
+    return createNumericIterator(sctx, t, f, config, filterCtx);
+  }
+  Vector_Free(v);
+  return it;
+}
+
 #define NUMERICINDEX_KEY_FMT "nm:%s/%s"
 
 RedisModuleString *fmtRedisNumericIndexKey(const RedisSearchCtx *ctx, const HiddenString *field) {
@@ -521,42 +1016,252 @@ NumericRangeTree *openNumericKeysDict(IndexSpec* spec, RedisModuleString *keyNam
   return kdv->p;
 }
 
+static NumericRangeTree *openFilterTree(const RedisSearchCtx *ctx, const NumericFilter *flt,
+                                        FieldType forType) {
+  RedisModuleString *s = IndexSpec_GetFormattedKey(ctx->spec, flt->fieldSpec, forType);
+  if (!s) {
+    return NULL;
+  }
+  return openNumericKeysDict(ctx->spec, s, DONT_CREATE_INDEX);
+}
+
 QueryIterator *NewNumericFilterIterator(const RedisSearchCtx *ctx, const NumericFilter *flt,
                                         FieldType forType, IteratorsConfig *config,
                                         const FieldFilterContext* filterCtx) {
-  const FieldSpec *fs = flt->fieldSpec;
-  RedisModuleString *s = IndexSpec_GetFormattedKey(ctx->spec, fs, forType);
-  if (!s) {
+  NumericRangeTree *t = openFilterTree(ctx, flt, forType);
+  if (!t) {
     return NULL;
   }
 
-  NumericRangeTree *t = openNumericKeysDict(ctx->spec, s, DONT_CREATE_INDEX);
+  return createNumericIterator(ctx, t, flt, config, filterCtx);
+}
+
+QueryIterator *NewNumericFilterIdsIterator(const RedisSearchCtx *ctx, const NumericFilter *flt,
+                                           IteratorsConfig *config,
+                                           const FieldFilterContext* filterCtx) {
+  NumericRangeTree *t = openFilterTree(ctx, flt, INDEXFLD_T_NUMERIC);
   if (!t) {
     return NULL;
   }
 
-  return createNumericIterator(ctx, t, flt, config, filterCtx);
+  return createNumericIdsIterator(ctx, t, flt, config, filterCtx);
+}
+
+size_t NumericFilter_Cardinality(const RedisSearchCtx *ctx, const NumericFilter *flt, bool *exact) {
+  NumericRangeTree *t = openFilterTree(ctx, flt, INDEXFLD_T_NUMERIC);
+  if (!t) {
+    *exact = true;
+    return 0;
+  }
+  return NumericRangeTree_Cardinality(t, flt, exact);
+}
+
+size_t NumericFilter_RangesNumDocs(const RedisSearchCtx *ctx, const NumericFilter *flt) {
+  NumericRangeTree *t = openFilterTree(ctx, flt, INDEXFLD_T_NUMERIC);
+  if (!t) {
+    return 0;
+  }
+  Vector *v = NumericRangeTree_Find(t, flt);
+  size_t total = 0;
+  for (size_t i = 0; i < Vector_Size(v); i++) {
+    NumericRange *rng;
+    Vector_Get(v, i, &rng);
+    total += InvertedIndex_NumDocs(rng->entries);
+  }
+  Vector_Free(v);
+  return total;
 }
 
 static inline size_t NumericRangeNode_sizeof() {
   return sizeof(NumericRangeNode);
 }
 
-static inline size_t NumericRange_sizeof() {
+static inline size_t NumericRange_sizeof(const NumericRangeTree *t) {
   size_t size = sizeof(NumericRange);
-  size += NR_REG_SIZE; // hll memory size
+  size += 1 << t->hllBits; // hll memory size
   return size;
 }
 
 unsigned long NumericIndexType_MemUsage(const NumericRangeTree *t) {
   unsigned long ret = sizeof(NumericRangeTree);
+  ret += NR_REG_SIZE; // distinct values hll memory size
   ret += t->invertedIndexesSize;
-  ret += t->numRanges * NumericRange_sizeof();
+  ret += t->numRanges * NumericRange_sizeof(t);
   // Our tree is a full binary tree, so `#nodes = 2 * #leaves - 1`
   ret += (2 * t->numLeaves - 1) * NumericRangeNode_sizeof();
   return ret;
 }
 
+static void saveHLL(RedisModuleIO *rdb, const struct HLL *hll) {
+  RedisModule_SaveStringBuffer(rdb, (const char *)hll->registers, hll->size);
+}
+
+// The HLL must be initialized
+static int loadHLL(RedisModuleIO *rdb, struct HLL *hll) {
+  size_t size;
+  char *registers = LoadStringBuffer_IOError(rdb, &size, return REDISMODULE_ERR);
+  int rc = hll_set_registers(hll, registers, size);
+  RedisModule_Free(registers);
+  return rc ? REDISMODULE_ERR : REDISMODULE_OK;
+}
+
+static void NumericRange_RdbSave(RedisModuleIO *rdb, const NumericRange *r) {
+  RedisModule_SaveDouble(rdb, r->minVal);
+  RedisModule_SaveDouble(rdb, r->maxVal);
+  saveHLL(rdb, &r->hll);
+  RedisModule_SaveUnsigned(rdb, r->values != NULL);
+  RedisModule_SaveUnsigned(rdb, r->numValues);
+  if (r->values) {
+    RedisModule_SaveStringBuffer(rdb, (const char *)r->values, r->numValues * sizeof(*r->values));
+  }
+  RedisModule_SaveUnsigned(rdb, r->invertedIndexSize);
+  InvertedIndex_RdbSave(rdb, r->entries);
+}
+
+static NumericRange *NumericRange_RdbLoad(RedisModuleIO *rdb, const NumericRangeTree *t) {
+  NumericRange *r = rm_calloc(1, sizeof(*r));
+  hll_init(&r->hll, t->hllBits);
+  r->minVal = LoadDouble_IOError(rdb, goto error);
+  r->maxVal = LoadDouble_IOError(rdb, goto error);
+  if (loadHLL(rdb, &r->hll) != REDISMODULE_OK) {
+    goto error;
+  }
+  const bool hasValues = LoadUnsigned_IOError(rdb, goto error);
+  r->numValues = LoadUnsigned_IOError(rdb, goto error);
+  if (hasValues) {
+    size_t len;
+    char *values = LoadStringBuffer_IOError(rdb, &len, goto error);
+    // Allocated as addExactValue() grows the values
+    size_t cap = 4;
+    while (cap < r->numValues) cap *= 2;
+    if (len == r->numValues * sizeof(*r->values)) {
+      r->values = rm_malloc(cap * sizeof(*r->values));
+      memcpy(r->values, values, len);
+    }
+    RedisModule_Free(values);
+    if (!r->values) {
+      goto error;
+    }
+  }
+  r->invertedIndexSize = LoadUnsigned_IOError(rdb, goto error);
+  size_t memsize;
+  r->entries = InvertedIndex_RdbLoad(rdb, &memsize);
+  if (!r->entries) {
+    goto error;
+  }
+  return r;
+
+error:
+  hll_destroy(&r->hll);
+  rm_free(r->values);
+  rm_free(r);
+  return NULL;
+}
+
+#define NODE_RDB_RANGE 0x01
+#define NODE_RDB_CHILDREN 0x02
+
+static void NumericRangeNode_RdbSave(RedisModuleIO *rdb, const NumericRangeNode *n) {
+  RedisModule_SaveDouble(rdb, n->value);
+  RedisModule_SaveUnsigned(rdb, n->maxDepth);
+  RedisModule_SaveUnsigned(rdb, (n->range ? NODE_RDB_RANGE : 0) |
+                                (NumericRangeNode_IsLeaf(n) ? 0 : NODE_RDB_CHILDREN));
+  if (n->range) {
+    NumericRange_RdbSave(rdb, n->range);
+  }
+  if (!NumericRangeNode_IsLeaf(n)) {
+    NumericRangeNode_RdbSave(rdb, n->left);
+    NumericRangeNode_RdbSave(rdb, n->right);
+  }
+}
+
+static NumericRangeNode *NumericRangeNode_RdbLoad(RedisModuleIO *rdb, const NumericRangeTree *t) {
+  NumericRangeNode *n = rm_calloc(1, sizeof(*n));
+  n->value = LoadDouble_IOError(rdb, goto error);
+  n->maxDepth = LoadUnsigned_IOError(rdb, goto error);
+  const uint64_t parts = LoadUnsigned_IOError(rdb, goto error);
+  if ((parts & NODE_RDB_RANGE) && !(n->range = NumericRange_RdbLoad(rdb, t))) {
+    goto error;
+  }
+  if ((parts & NODE_RDB_CHILDREN) && (!(n->left = NumericRangeNode_RdbLoad(rdb, t)) ||
+                                      !(n->right = NumericRangeNode_RdbLoad(rdb, t)))) {
+    goto error;
+  }
+  return n;
+
+error:;
+  NRN_AddRv rv = {0};
+  NumericRangeNode_Free(n, &rv);
+  return NULL;
+}
+
+void NumericRangeTree_RdbSave(RedisModuleIO *rdb, const NumericRangeTree *t) {
+  RedisModule_SaveUnsigned(rdb, t->hllBits);
+  RedisModule_SaveUnsigned(rdb, t->exactCard);
+  RedisModule_SaveUnsigned(rdb, t->numRanges);
+  RedisModule_SaveUnsigned(rdb, t->numLeaves);
+  RedisModule_SaveUnsigned(rdb, t->numEntries);
+  RedisModule_SaveUnsigned(rdb, t->invertedIndexesSize);
+  RedisModule_SaveUnsigned(rdb, t->lastDocId);
+  RedisModule_SaveUnsigned(rdb, t->revisionId);
+  RedisModule_SaveUnsigned(rdb, t->emptyLeaves);
+
+  const NumericHistogram *h = &t->histogram;
+  RedisModule_SaveUnsigned(rdb, h->numBuckets);
+  RedisModule_SaveUnsigned(rdb, h->numEntries);
+  RedisModule_SaveUnsigned(rdb, h->depth);
+  for (uint32_t i = 0; i < h->numBuckets; i++) {
+    RedisModule_SaveDouble(rdb, h->bounds[i]);
+    RedisModule_SaveUnsigned(rdb, h->counts[i]);
+  }
+  if (h->numBuckets) {
+    RedisModule_SaveDouble(rdb, h->bounds[h->numBuckets]);
+  }
+
+  saveHLL(rdb, &t->distinct);
+  NumericRangeNode_RdbSave(rdb, t->root);
+}
+
+NumericRangeTree *NumericRangeTree_RdbLoad(RedisModuleIO *rdb) {
+  NumericRangeTree *t = rm_calloc(1, sizeof(*t));
+  t->uniqueId = numericTreesUniqueId++;
+  hll_init(&t->distinct, NR_BIT_PRECISION);
+  t->hllBits = LoadUnsigned_IOError(rdb, goto error);
+  t->exactCard = LoadUnsigned_IOError(rdb, goto error);
+  t->numRanges = LoadUnsigned_IOError(rdb, goto error);
+  t->numLeaves = LoadUnsigned_IOError(rdb, goto error);
+  t->numEntries = LoadUnsigned_IOError(rdb, goto error);
+  t->invertedIndexesSize = LoadUnsigned_IOError(rdb, goto error);
+  t->lastDocId = LoadUnsigned_IOError(rdb, goto error);
+  t->revisionId = LoadUnsigned_IOError(rdb, goto error);
+  t->emptyLeaves = LoadUnsigned_IOError(rdb, goto error);
+
+  NumericHistogram *h = &t->histogram;
+  h->numBuckets = LoadUnsigned_IOError(rdb, goto error);
+  if (h->numBuckets > NR_HISTOGRAM_BUCKETS) {
+    goto error;
+  }
+  h->numEntries = LoadUnsigned_IOError(rdb, goto error);
+  h->depth = LoadUnsigned_IOError(rdb, goto error);
+  for (uint32_t i = 0; i < h->numBuckets; i++) {
+    h->bounds[i] = LoadDouble_IOError(rdb, goto error);
+    h->counts[i] = LoadUnsigned_IOError(rdb, goto error);
+  }
+  if (h->numBuckets) {
+    h->bounds[h->numBuckets] = LoadDouble_IOError(rdb, goto error);
+  }
+
+  if (loadHLL(rdb, &t->distinct) != REDISMODULE_OK ||
+      !(t->root = NumericRangeNode_RdbLoad(rdb, t))) {
+    goto error;
+  }
+  return t;
+
+error:
+  NumericRangeTree_Free(t);
+  return NULL;
+}
+
 NumericRangeTreeIterator *NumericRangeTreeIterator_New(NumericRangeTree *t) {
 #define NODE_STACK_INITIAL_SIZE 4
   NumericRangeTreeIterator *iter = rm_malloc(sizeof(NumericRangeTreeIterator));
@@ -578,6 +1283,29 @@ NumericRangeNode *NumericRangeTreeIterator_Next(NumericRangeTreeIterator *iter)
   return ret;
 }
 
+NumericRange *NumericRangeTreeIterator_NextLeaf(NumericRangeTreeIterator *iter, const NumericFilter *nf) {
+  while (array_len(iter->nodesStack)) {
+    NumericRangeNode *n = array_pop(iter->nodesStack);
+    if (NumericRangeNode_IsLeaf(n)) {
+      if (NumericRange_Overlaps(n->range, nf->min, nf->max)) {
+        return n->range;
+      }
+      continue;
+    }
+    // push the child to visit first last, skipping children out of the filter's range
+    NumericRangeNode *first = nf->ascending ? n->left : n->right;
+    NumericRangeNode *second = nf->ascending ? n->right : n->left;
+    bool visitLeft = nf->min <= n->value, visitRight = nf->max >= n->value;
+    if (nf->ascending ? visitRight : visitLeft) {
+      array_append(iter->nodesStack, second);
+    }
+    if (nf->ascending ? visitLeft : visitRight) {
+      array_append(iter->nodesStack, first);
+    }
+  }
+  return NULL;
+}
+
 void NumericRangeTreeIterator_Free(NumericRangeTreeIterator *iter) {
   array_free(iter->nodesStack);
   rm_free(iter);
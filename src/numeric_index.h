@@ -29,6 +29,9 @@ extern "C" {
 
 #define NR_BIT_PRECISION 6 // For error rate of `1.04 / sqrt(2^6)` = 13%
 #define NR_REG_SIZE (1 << NR_BIT_PRECISION)
+// With `_NUMERIC_EXACT_CARDINALITY`, the ranges of a tree count their distinct values exactly up
+// to this many, and estimate them with their HLL past it
+#define NR_EXACT_CARD 256
 
 /* A numeric range is a node in a numeric range tree, representing a range of
  * values bunched together.
@@ -42,6 +45,10 @@ typedef struct {
   double minVal;
   double maxVal;
   struct HLL hll;
+  // The sorted distinct values of the range while there are at most NR_EXACT_CARD of them, and
+  // NULL once there are more. The HLL is updated either way
+  double *values;
+  uint16_t numValues;
 
   size_t invertedIndexSize;
   InvertedIndex *entries;
@@ -70,6 +77,21 @@ typedef struct {
   NumericRangeNode **nodesStack;
 } NumericRangeTreeIterator;
 
+#define NR_HISTOGRAM_BUCKETS 32
+
+/* An equi-depth histogram of the values of a tree: the buckets hold about as many entries each, so
+ * the distribution is resolved more finely where the values are dense. It is rebuilt from the
+ * leaves of the tree (assuming the values of a leaf are spread evenly between its bounds) when the
+ * tree doubles, when a bucket gets twice as deep as the others, and by the fork GC. In between,
+ * the added values are counted in the bucket they fall in */
+typedef struct {
+  double bounds[NR_HISTOGRAM_BUCKETS + 1];  // Bucket `i` holds the values in [bounds[i], bounds[i+1]]
+  size_t counts[NR_HISTOGRAM_BUCKETS];
+  uint32_t numBuckets;  // 0 until the histogram is built
+  size_t numEntries;    // The total of the counts
+  size_t depth;         // The number of entries per bucket when it was last rebuilt
+} NumericHistogram;
+
 /* The root tree and its metadata */
 typedef struct {
   NumericRangeNode *root;
@@ -78,24 +100,89 @@ typedef struct {
   size_t numEntries;
   size_t invertedIndexesSize;
 
+  // Published with release semantics once an append or a split is complete, see
+  // NumericRangeTree_LastDocId() and NumericRangeTree_RevisionId()
   t_docId lastDocId;
 
   uint32_t revisionId;
 
+  uint8_t hllBits;  // The precision of the HLLs of the ranges
+  bool exactCard;   // Whether the ranges count their few distinct values exactly
+
   uint32_t uniqueId;
 
   size_t emptyLeaves;
 
+  NumericHistogram histogram;
+
+  // The distinct values added to the tree. While they are few, its leaves are split down to a
+  // single value each, so that a filter on a value reads a whole leaf without checking the values
+  struct HLL distinct;
+
 } NumericRangeTree;
 
 #define NumericRangeNode_IsLeaf(n) (n->left == NULL && n->right == NULL)
 
+/* The last document appended to the tree. Its entries, and the nodes leading to them, are
+ * visible to a thread which read it */
+static inline t_docId NumericRangeTree_LastDocId(const NumericRangeTree *t) {
+  return __atomic_load_n(&t->lastDocId, __ATOMIC_ACQUIRE);
+}
+
+/* The revision of the tree, incremented whenever its nodes change. The nodes of a revision are
+ * visible to a thread which read it */
+static inline uint32_t NumericRangeTree_RevisionId(const NumericRangeTree *t) {
+  return __atomic_load_n(&t->revisionId, __ATOMIC_ACQUIRE);
+}
+
 QueryIterator *NewNumericFilterIterator(const RedisSearchCtx *ctx, const NumericFilter *flt, FieldType forType,
                                         IteratorsConfig *config, const FieldFilterContext* filterCtx);
 
+/* Same as NewNumericFilterIterator over a numeric field, for the queries which only need the
+ * ids of the matching documents and not their values. When the filter selects at least
+ * `_NUMERIC_BITMAP_UNION_RANGES` ranges, their documents are read into a bitmap at once, and when
+ * it selects at least `_NUMERIC_MERGE_UNION_RANGES` ranges, the batches of their documents are
+ * merged, rather than their iterators merged by a union iterator */
+QueryIterator *NewNumericFilterIdsIterator(const RedisSearchCtx *ctx, const NumericFilter *flt,
+                                           IteratorsConfig *config, const FieldFilterContext* filterCtx);
+
+/* The number of documents matching a numeric filter. It is exact (and `*exact` is set) when every
+ * range the filter selects is fully contained in it and holds no multi-value documents. Otherwise
+ * the documents of the ranges at the edges of the filter are estimated by the tree's histogram */
+size_t NumericFilter_Cardinality(const RedisSearchCtx *ctx, const NumericFilter *flt, bool *exact);
+size_t NumericRangeTree_Cardinality(const NumericRangeTree *t, const NumericFilter *f, bool *exact);
+
+/* Rebuild the histogram of the tree from its leaves */
+void NumericRangeTree_RebuildHistogram(NumericRangeTree *t);
+
+/* The estimated number of entries of the histogram with a value in [min, max] */
+size_t NumericHistogram_Estimate(const NumericHistogram *h, double min, double max);
+
+/* The total number of documents of the ranges the filter selects (see NumericRangeTree_Find),
+ * including the ones at the edges of the filter which do not match it */
+size_t NumericFilter_RangesNumDocs(const RedisSearchCtx *ctx, const NumericFilter *flt);
+
+/* Forget the exact distinct values of the range, whose cardinality is then estimated by its HLL
+ * alone. Used when entries are removed from the range */
+void NumericRange_DropExactValues(NumericRange *r);
+
+/* Returns true if every value of the range matches the numeric filter, so the entries of the range
+ * are read without decoding or checking their values. Always false for a geo filter */
+bool NumericRange_MatchesAll(const NumericRange *nr, const NumericFilter *f);
+
+/* Create an iterator over the entries of a single range of the tree */
+QueryIterator *NewNumericRangeIterator(const RedisSearchCtx *sctx, NumericRange *nr,
+                                       const NumericFilter *f, const FieldFilterContext* filterCtx);
+
 /* Recursively trim empty nodes from tree  */
 NRN_AddRv NumericRangeTree_TrimEmptyLeaves(NumericRangeTree *t);
 
+/* Rebuild a skewed tree into a balanced one, merging the runs of small adjacent leaves (left
+ * behind by collected entries, e.g. of increasing values inserted in order) into evenly sized
+ * ones. A tree is skewed when this would remove a quarter of its leaves, or when it is twice as
+ * deep as a balanced tree. `changed` is set in the returned value if the tree was rebuilt */
+NRN_AddRv NumericRangeTree_Rebalance(NumericRangeTree *t);
+
 /* Create a new tree */
 NumericRangeTree *NewNumericRangeTree();
 
@@ -116,8 +203,19 @@ NumericRangeTree *openNumericKeysDict(IndexSpec* spec, RedisModuleString *keyNam
 
 unsigned long NumericIndexType_MemUsage(const NumericRangeTree *tree);
 
+/* Save the tree to the RDB as it is in memory: its nodes, the values and entries of its ranges,
+ * its histogram and its HLLs */
+void NumericRangeTree_RdbSave(RedisModuleIO *rdb, const NumericRangeTree *t);
+
+/* Load a tree saved by NumericRangeTree_RdbSave(), or return NULL on a short read */
+NumericRangeTree *NumericRangeTree_RdbLoad(RedisModuleIO *rdb);
+
 NumericRangeTreeIterator *NumericRangeTreeIterator_New(NumericRangeTree *t);
 NumericRangeNode *NumericRangeTreeIterator_Next(NumericRangeTreeIterator *iter);
+/* Return the next leaf range that overlaps the filter's range, in the filter's sort order.
+ * Leaves do not overlap each other, so every value of a returned range comes after the values of
+ * the ranges returned before it. The iterator must not be advanced with `_Next` as well */
+NumericRange *NumericRangeTreeIterator_NextLeaf(NumericRangeTreeIterator *iter, const NumericFilter *nf);
 void NumericRangeTreeIterator_Free(NumericRangeTreeIterator *iter);
 
 #ifdef __cplusplus
@@ -186,6 +186,43 @@ RSOffsetIterator RSIndexResult_IterateOffsets(const RSIndexResult *res) {
   }
 }
 
+size_t RSIndexResult_DecodeOffsets(const RSIndexResult *res, uint32_t *out, size_t cap) {
+  size_t n = 0;
+  if (res->data.tag == RSResultData_Term) {
+    // Decode the varints in place, as ReadVarint() would, rather than calling it per offset
+    uint32_t len;
+    const unsigned char *p =
+        (const unsigned char *)RSOffsetVector_GetData(IndexResult_TermOffsetsRef(res), &len);
+    const unsigned char *end = p + len;
+    uint32_t last = 0;
+    while (p < end) {
+      unsigned char c = *p++;
+      uint32_t delta = c & 0x7f;
+      while ((c & 0x80) && p < end) {
+        c = *p++;
+        delta = ((delta + 1) << 7) | (c & 0x7f);
+      }
+      last += delta;
+      if (n < cap) {
+        out[n] = last;
+      }
+      n++;
+    }
+    return n;
+  }
+
+  RSOffsetIterator it = RSIndexResult_IterateOffsets(res);
+  uint32_t pos;
+  while ((pos = it.Next(it.ctx, NULL)) != RS_OFFSETVECTOR_EOF) {
+    if (n < cap) {
+      out[n] = pos;
+    }
+    n++;
+  }
+  it.Free(it.ctx);
+  return n;
+}
+
 /* Rewind an offset vector iterator and start reading it from the beginning. */
 void _ovi_Rewind(void *ctx) {
   _RSOffsetVectorIterator *it = ctx;
@@ -58,6 +58,14 @@ typedef struct AggregationPipelineParams {
    *  Used by highlighting result processors to apply proper stemming,
    *  tokenization, and markup for the specified language. */
   RSLanguage language;
+
+  /** When set, the sorter by score drops the results scoring below it, which the coordinator
+   *  knows cannot make it into the top results of the distributed search. */
+  const double *scoreThreshold;
+
+  /** The ratio the results of the query were sampled at (see SAMPLE), by which the COUNT and SUM
+   *  reducers of the first GROUPBY scale up their outputs. 0 or 1 if the results are not sampled. */
+  double sampleRatio;
 } AggregationPipelineParams;
 
 
@@ -84,6 +92,11 @@ typedef struct QueryPipelineParams {
      *  search terms and filters. It produces the initial set of candidate documents. */
     const QueryIterator *rootiter;
 
+    /** Root iterators of the other doc-id ranges of the query, when its ranges are read in
+     *  parallel. Each is a clone of the tree of `rootiter`, which then reads the first range
+     *  (see RPQueryRanges). NULL when the query is read by a single root iterator. */
+    QueryIterator **rangeRoots;
+
     /** Slot ranges for the root iterator, used for cluster-aware query execution. */
     const SharedSlotRangeArray *slotRanges;
 
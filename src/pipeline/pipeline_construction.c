@@ -11,8 +11,38 @@
 extern "C" {
 #endif
 
+/**
+ * Whether results sorted by `sortedKeys` are sorted by the group keys as well, so that the results
+ * of each group are contiguous. The group keys must be schema fields, which are never split into
+ * several groups by multiple values
+ */
+static bool groupKeysSorted(const RLookupKey **keys, size_t nkeys, const RLookupKey **sortedKeys,
+                            size_t nsorted) {
+  if (!nkeys || nkeys > nsorted || nkeys > SORTASCMAP_MAXFIELDS) {
+    return false;
+  }
+  for (size_t ii = 0; ii < nkeys; ++ii) {
+    if (!(keys[ii]->flags & RLOOKUP_F_SCHEMASRC)) {
+      return false;
+    }
+    // The group keys are the leading sort keys, in any order
+    bool found = false;
+    for (size_t jj = 0; jj < nkeys && !found; ++jj) {
+      found = keys[ii] == sortedKeys[jj];
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// When `sampleRatio` is set, the reducers estimating totals scale up their outputs by it, and
+// write their standard errors to `<alias>_stderr` if `sampleErrors`
 static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup,
-                                     const RLookupKey ***loadKeys, QueryError *err) {
+                                     const RLookupKey ***loadKeys, const RLookupKey **sortedKeys,
+                                     size_t nsorted, double sampleRatio, bool sampleErrors,
+                                     QueryError *err) {
   arrayof(const char*) properties = PLNGroupStep_GetProperties(gstp);
   size_t nproperties = array_len(properties);
   const RLookupKey *srckeys[nproperties], *dstkeys[nproperties];
@@ -41,6 +71,9 @@ static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup,
   }
 
   Grouper *grp = Grouper_New(srckeys, dstkeys, nproperties);
+  if (groupKeysSorted(srckeys, nproperties, sortedKeys, nsorted)) {
+    Grouper_SetSortedInput(grp);
+  }
 
   size_t nreducers = array_len(gstp->reducers);
   for (size_t ii = 0; ii < nreducers; ++ii) {
@@ -70,6 +103,16 @@ static ResultProcessor *buildGroupRP(PLN_GroupStep *gstp, RLookup *srclookup,
       QueryError_SetWithUserDataFmt(err, QUERY_ERROR_CODE_DUP_FIELD, "Property", " `%s` specified more than once", pr->alias);
       return NULL;
     }
+
+    if (sampleRatio && rr->StdError) {
+      rr->sampleRatio = sampleRatio;
+      if (sampleErrors && !pr->isHidden) {
+        char *errname;
+        rm_asprintf(&errname, "%s_stderr", pr->alias);
+        rr->errkey = RLookup_GetKey_Write(&gstp->lookup, errname, RLOOKUP_F_NAMEALLOC);
+        rm_free(errname);
+      }
+    }
   }
 
   return Grouper_GetRP(grp);
@@ -89,11 +132,15 @@ static ResultProcessor *pushRP(QueryProcessingCtx *ctx, ResultProcessor *rp, Res
 }
 
 static ResultProcessor *getGroupRP(Pipeline *pipeline, const AggregationPipelineParams *params, PLN_GroupStep *gstp, ResultProcessor *rpUpstream,
+                                   const RLookupKey **sortedKeys, size_t nsorted, double sampleRatio,
                                    QueryError *status, bool forceLoad, uint32_t *outStateFlags) {
   RLookup *lookup = AGPLN_GetLookup(&pipeline->ap, &gstp->base, AGPLN_GETLOOKUP_PREV);
   RLookup *firstLk = AGPLN_GetLookup(&pipeline->ap, &gstp->base, AGPLN_GETLOOKUP_FIRST); // first lookup can load fields from redis
   const RLookupKey **loadKeys = NULL;
-  ResultProcessor *groupRP = buildGroupRP(gstp, lookup, (firstLk == lookup && firstLk->spcache) ? &loadKeys : NULL, status);
+  // The errors are only meaningful to the user, so the shards of a cluster don't send them
+  const bool sampleErrors = !(params->common.reqflags & QEXEC_F_INTERNAL);
+  ResultProcessor *groupRP = buildGroupRP(gstp, lookup, (firstLk == lookup && firstLk->spcache) ? &loadKeys : NULL,
+                                          sortedKeys, nsorted, sampleRatio, sampleErrors, status);
 
   if (!groupRP) {
     array_free(loadKeys);
@@ -201,6 +248,7 @@ static ResultProcessor *getArrangeRP(Pipeline *pipeline, const AggregationPipeli
         up = pushRP(&pipeline->qctx, rpLoader, up);
       }
       rp = RPSorter_NewByFields(maxResults, sortkeys, nkeys, astp->sortAscMap);
+      RPSorter_UseSortingColumns(rp, params->common.sctx);
       up = pushRP(&pipeline->qctx, rp, up);
     } else if (IsHybrid(&params->common) ||
                IsSearch(&params->common) && !IsOptimized(&params->common) ||
@@ -208,6 +256,11 @@ static ResultProcessor *getArrangeRP(Pipeline *pipeline, const AggregationPipeli
       // No sort? then it must be sort by score, which is the default.
       // In optimize mode, add sorter for queries with a scorer.
       rp = RPSorter_NewByScore(maxResults);
+      if (params->scoreThreshold) {
+        RPSorter_SetScoreThreshold(rp, *params->scoreThreshold);
+        // The scorers and the block-max pruning skip the results below the minimal score
+        pipeline->qctx.minScore = MAX(pipeline->qctx.minScore, *params->scoreThreshold);
+      }
       up = pushRP(&pipeline->qctx, rp, up);
     }
   }
@@ -306,9 +359,33 @@ static int processLoadStepArgs(PLN_LoadStep *loadStep, RLookup *lookup, uint32_t
   return REDISMODULE_OK;
 }
 
+// Returns the ARRANGE step directly following the LOAD step at `nn`, if the loaded fields it doesn't
+// sort by can be loaded after it. Rows that don't make the page then never load these fields.
+static const PLN_ArrangeStep *getLateLoadArrange(const AGGPlan *pln, const DLLIST_node *nn,
+                                                 const AggregationPipelineParams *params) {
+  const PLN_BaseStep *lstp = DLLIST_ITEM(nn, PLN_BaseStep, llnodePln);
+  if ((lstp->flags & PLN_F_LOAD_ALL) || IsHybrid(&params->common) || nn->next == &pln->steps) {
+    return NULL;
+  }
+  const PLN_BaseStep *next = DLLIST_ITEM(nn->next, PLN_BaseStep, llnodePln);
+  return next->type == PLN_T_ARRANGE ? (const PLN_ArrangeStep *)next : NULL;
+}
+
+static bool isSortKey(const PLN_ArrangeStep *astp, const RLookupKey *kk) {
+  for (size_t ii = 0; ii < array_len(astp->sortKeys); ++ii) {
+    const char *keystr = astp->sortKeys[ii];
+    if (strlen(keystr) == kk->name_len && !strncmp(keystr, kk->name, kk->name_len)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 ResultProcessor *processLoadStep(PLN_LoadStep *loadStep, RLookup *lookup,
                                 RedisSearchCtx *sctx, uint32_t reqflags, uint32_t loadFlags,
-                                bool forceLoad, uint32_t *outStateFlags, QueryError *status) {
+                                bool forceLoad, uint32_t *outStateFlags,
+                                const PLN_ArrangeStep *lateArrange, const RLookupKey ***lateKeys,
+                                QueryError *status) {
   if (!loadStep || !lookup || !sctx) {
     return NULL;
   }
@@ -318,20 +395,36 @@ ResultProcessor *processLoadStep(PLN_LoadStep *loadStep, RLookup *lookup,
     return NULL;
   }
 
+  const RLookupKey **keys = loadStep->keys;
+  size_t nkeys = loadStep->nkeys;
+  const RLookupKey **earlyKeys = NULL;
+  if (lateArrange) {
+    // Only load the sort keys now, and leave the rest to be loaded after the arrange step
+    for (size_t ii = 0; ii < loadStep->nkeys; ++ii) {
+      const RLookupKey *kk = loadStep->keys[ii];
+      if (isSortKey(lateArrange, kk)) {
+        *array_ensure_tail(&earlyKeys, const RLookupKey *) = kk;
+      } else {
+        *array_ensure_tail(lateKeys, const RLookupKey *) = kk;
+      }
+    }
+    keys = earlyKeys;
+    nkeys = array_len(earlyKeys);
+  }
+
+  ResultProcessor *rp = NULL;
   // Create RPLoader if we have keys to load or LOAD ALL flag is set
-  if (loadStep->nkeys || loadStep->base.flags & PLN_F_LOAD_ALL) {
-    ResultProcessor *rp = RPLoader_New(sctx, reqflags, lookup, loadStep->keys, loadStep->nkeys, forceLoad, outStateFlags);
+  if (nkeys || loadStep->base.flags & PLN_F_LOAD_ALL) {
+    rp = RPLoader_New(sctx, reqflags, lookup, keys, nkeys, forceLoad, outStateFlags);
 
     // Handle JSON spec case
     if (isSpecJson(sctx->spec)) {
       // On JSON, load all gets the serialized value of the doc, and doesn't make the fields available.
       lookup->options &= ~RLOOKUP_OPT_ALL_LOADED;
     }
-
-    return rp;
   }
-
-  return NULL;
+  array_free(earlyKeys);
+  return rp;
 }
 
 #define PUSH_RP()                                      \
@@ -350,7 +443,22 @@ void Pipeline_BuildQueryPart(Pipeline *pipeline, QueryPipelineParams *params) {
 
   RLookup_Init(first, cache);
 
-  ResultProcessor *rp = RPQueryIterator_New(params->rootiter, params->slotRanges, params->common.sctx);
+  ResultProcessor *rp;
+  if (params->rangeRoots) {
+    const size_t numRanges = array_len(params->rangeRoots) + 1;
+    // The ranges are only read in parallel when there are no slot ranges to filter by
+    RS_ASSERT(!params->slotRanges);
+    QueryIterator *roots[numRanges];
+    roots[0] = params->rootiter;
+    for (size_t i = 1; i < numRanges; i++) {
+      roots[i] = params->rangeRoots[i - 1];
+    }
+    array_free(params->rangeRoots);
+    params->rangeRoots = NULL;
+    rp = RPQueryRanges_New(roots, numRanges, params->common.sctx);
+  } else {
+    rp = RPQueryIterator_New(params->rootiter, params->slotRanges, params->common.sctx);
+  }
   params->rootiter = NULL; // Ownership of the root iterator is now with the pipeline.
   params->slotRanges = NULL; // Ownership of the slot ranges is now with the pipeline.
   ResultProcessor *rpUpstream = NULL;
@@ -469,7 +577,9 @@ int buildOutputPipeline(Pipeline *pipeline, const AggregationPipelineParams* par
       }
       ff->lookupKey = kk;
     }
-    rp = RPHighlighter_New(params->language, params->outFields, lookup);
+    IndexSpec *spec = params->common.sctx ? params->common.sctx->spec : NULL;
+    rp = RPHighlighter_New(params->language, params->outFields, lookup,
+                           spec ? spec->snippets : NULL);
     PUSH_RP();
   }
 
@@ -493,16 +603,33 @@ int Pipeline_BuildAggregationPart(Pipeline *pipeline, const AggregationPipelineP
   // Whether we've applied a SORTBY yet..
   int hasArrange = 0;
 
+  // Fields of a LOAD step to be loaded only after the ARRANGE step that follows it
+  const RLookupKey **lateLoadKeys = NULL;
+
+  // Function calls the APPLY and FILTER steps may share
+  ExprCSE cse = {0};
+
+  // The keys the results are currently sorted by. Only the values of a HASH index are known not to
+  // be changed or split into several groups, as long as no APPLY step wrote any of them
+  const RLookupKey **sortedKeys = NULL;
+  size_t nsorted = 0;
+  bool canSortGroups = sctx && sctx->spec && !isSpecJson(sctx->spec);
+
+  // Only the first GROUPBY groups the sampled results, the next ones group its groups
+  double sampleRatio = params->sampleRatio < 1 ? params->sampleRatio : 0;
+
   for (const DLLIST_node *nn = pln->steps.next; nn != &pln->steps; nn = nn->next) {
     const PLN_BaseStep *stp = DLLIST_ITEM(nn, PLN_BaseStep, llnodePln);
 
     switch (stp->type) {
       case PLN_T_GROUP: {
         // Adds group result processor and loader if needed.
-        rpUpstream = getGroupRP(pipeline, params, (PLN_GroupStep *)stp, rpUpstream, status, forceLoad, outStateFlags);
+        rpUpstream = getGroupRP(pipeline, params, (PLN_GroupStep *)stp, rpUpstream, sortedKeys, nsorted,
+                                sampleRatio, status, forceLoad, outStateFlags);
         if (!rpUpstream) {
           goto error;
         }
+        sampleRatio = 0;
         break;
       }
 
@@ -514,6 +641,17 @@ int Pipeline_BuildAggregationPart(Pipeline *pipeline, const AggregationPipelineP
         hasArrange = 1;
         rpUpstream = rp;
 
+        if (lateLoadKeys) {
+          RLookup *rootLookup = AGPLN_GetLookup(pln, NULL, AGPLN_GETLOOKUP_FIRST);
+          rp = RPLoader_New(sctx, requestFlags, rootLookup, lateLoadKeys, array_len(lateLoadKeys), forceLoad, outStateFlags);
+          array_free(lateLoadKeys);
+          lateLoadKeys = NULL;
+          PUSH_RP();
+        }
+
+        const PLN_ArrangeStep *astp = (const PLN_ArrangeStep *)stp;
+        sortedKeys = canSortGroups ? astp->sortkeysLK : NULL;
+        nsorted = sortedKeys ? array_len(astp->sortKeys) : 0;
         break;
       }
 
@@ -530,8 +668,10 @@ int Pipeline_BuildAggregationPart(Pipeline *pipeline, const AggregationPipelineP
         if (!ExprAST_GetLookupKeys(mstp->parsedExpr, curLookup, status)) {
           goto error;
         }
+        ExprCSE_Add(&cse, mstp->parsedExpr, curLookup);
 
         if (stp->type == PLN_T_APPLY) {
+          canSortGroups = false;
           uint32_t flags = mstp->noOverride ? RLOOKUP_F_NOFLAGS : RLOOKUP_F_OVERRIDE;
           RLookupKey *dstkey = RLookup_GetKey_Write(curLookup, stp->alias, flags);
           if (!dstkey) {
@@ -540,6 +680,8 @@ int Pipeline_BuildAggregationPart(Pipeline *pipeline, const AggregationPipelineP
             goto error;
           }
           rp = RPEvaluator_NewProjector(mstp->parsedExpr, curLookup, dstkey);
+          // Later calls reading the written property have another value
+          ExprCSE_Invalidate(&cse, stp->alias);
         } else {
           rp = RPEvaluator_NewFilter(mstp->parsedExpr, curLookup);
         }
@@ -557,11 +699,15 @@ int Pipeline_BuildAggregationPart(Pipeline *pipeline, const AggregationPipelineP
           goto error;
         }
 
+        // The loaded fields may replace the values calls read
+        ExprCSE_Invalidate(&cse, NULL);
+
         // Process the complete LOAD step
+        const PLN_ArrangeStep *lateArrange = getLateLoadArrange(pln, nn, params);
         rp = processLoadStep(lstp, curLookup, params->common.sctx, params->common.reqflags,
-                            loadFlags, forceLoad, outStateFlags, status);
+                            loadFlags, forceLoad, outStateFlags, lateArrange, &lateLoadKeys, status);
         if (QueryError_HasError(status)) {
-          return REDISMODULE_ERR;
+          goto error;
         }
         if (rp) {
           PUSH_RP();
@@ -609,6 +755,11 @@ int Pipeline_BuildAggregationPart(Pipeline *pipeline, const AggregationPipelineP
         RS_ABORT("Oops");
         break;
     }
+    // Only filtering keeps the results sorted by the same values
+    if (stp->type != PLN_T_ARRANGE && stp->type != PLN_T_FILTER && stp->type != PLN_T_ROOT) {
+      sortedKeys = NULL;
+      nsorted = 0;
+    }
   }
 
   // If no LIMIT or SORT has been applied, do it somewhere here so we don't
@@ -629,14 +780,17 @@ int Pipeline_BuildAggregationPart(Pipeline *pipeline, const AggregationPipelineP
     }
   }
 
-  // In profile mode, we need to add RP_Profile before each RP
-  if ((requestFlags & QEXEC_F_PROFILE) && pipeline->qctx.endProc) {
+  // In profile mode (or when the query is sampled), we need to add RP_Profile before each RP
+  if ((requestFlags & (QEXEC_F_PROFILE | QEXEC_F_PROFILE_SAMPLED)) && pipeline->qctx.endProc) {
     Profile_AddRPs(&pipeline->qctx);
   }
 
   //pipeline->stateflags |= outStateflags;
+  ExprCSE_Free(&cse);
   return REDISMODULE_OK;
 error:
+  ExprCSE_Free(&cse);
+  array_free(lateLoadKeys);
   return REDISMODULE_ERR;
 }
 
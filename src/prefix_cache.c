@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "prefix_cache.h"
+#include "rmalloc.h"
+#include "iterators/idlist_iterator.h"
+#include "iterators/empty_iterator.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct {
+  char *prefix;           // NULL for a free slot
+  size_t len;
+  t_fieldMask fieldMask;
+  t_docId *ids;
+  size_t numIds;
+  bool tooLarge;          // the expansion matches more than PREFIX_CACHE_MAX_IDS documents
+  uint64_t lastUsed;
+} PrefixCacheEntry;
+
+struct PrefixCache {
+  pthread_mutex_t lock;
+  PrefixCacheEntry entries[PREFIX_CACHE_CAPACITY];
+  size_t numEntries;
+  uint64_t clock;         // ticks on every access, for the LRU order
+};
+
+PrefixCache *NewPrefixCache(void) {
+  PrefixCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  return cache;
+}
+
+static void PrefixCacheEntry_Clear(PrefixCacheEntry *e) {
+  rm_free(e->prefix);
+  rm_free(e->ids);
+  memset(e, 0, sizeof(*e));
+}
+
+void PrefixCache_Free(PrefixCache *cache) {
+  if (!cache) return;
+  for (size_t i = 0; i < PREFIX_CACHE_CAPACITY; i++) {
+    PrefixCacheEntry_Clear(&cache->entries[i]);
+  }
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+// Find the entry of the key. The cache must be locked
+static PrefixCacheEntry *PrefixCache_Find(PrefixCache *cache, const char *prefix, size_t len,
+                                          t_fieldMask fieldMask) {
+  for (size_t i = 0; i < PREFIX_CACHE_CAPACITY; i++) {
+    PrefixCacheEntry *e = &cache->entries[i];
+    if (e->prefix && e->len == len && e->fieldMask == fieldMask && !memcmp(e->prefix, prefix, len)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+static QueryIterator *newCachedIterator(const PrefixCacheEntry *e, double weight) {
+  if (e->numIds == 0) {
+    return NewEmptyIterator();
+  }
+  // The iterator owns its ids, so it gets a copy
+  t_docId *ids = rm_malloc(e->numIds * sizeof(*ids));
+  memcpy(ids, e->ids, e->numIds * sizeof(*ids));
+  return NewIdListIterator(ids, e->numIds, weight);
+}
+
+QueryIterator *PrefixCache_Get(PrefixCache *cache, const char *prefix, size_t len, t_fieldMask fieldMask,
+                               double weight) {
+  QueryIterator *ret = NULL;
+  pthread_mutex_lock(&cache->lock);
+  PrefixCacheEntry *e = PrefixCache_Find(cache, prefix, len, fieldMask);
+  if (e && !e->tooLarge) {
+    e->lastUsed = ++cache->clock;
+    ret = newCachedIterator(e, weight);
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return ret;
+}
+
+// Store the entry of the key, replacing its previous entry or the least recently used one.
+// Takes ownership of `ids`. The cache must be locked
+static PrefixCacheEntry *PrefixCache_Put(PrefixCache *cache, const char *prefix, size_t len,
+                                         t_fieldMask fieldMask, t_docId *ids, size_t numIds, bool tooLarge) {
+  PrefixCacheEntry *e = PrefixCache_Find(cache, prefix, len, fieldMask);
+  if (!e) {
+    e = &cache->entries[0];
+    for (size_t i = 0; i < PREFIX_CACHE_CAPACITY && e->prefix; i++) {
+      PrefixCacheEntry *cur = &cache->entries[i];
+      if (!cur->prefix || cur->lastUsed < e->lastUsed) {
+        e = cur;
+      }
+    }
+  }
+  if (e->prefix) {
+    cache->numEntries--;
+  }
+  PrefixCacheEntry_Clear(e);
+  e->prefix = rm_strndup(prefix, len);
+  e->len = len;
+  e->fieldMask = fieldMask;
+  e->ids = ids;
+  e->numIds = numIds;
+  e->tooLarge = tooLarge;
+  e->lastUsed = ++cache->clock;
+  cache->numEntries++;
+  return e;
+}
+
+QueryIterator *PrefixCache_Materialize(PrefixCache *cache, const char *prefix, size_t len,
+                                       t_fieldMask fieldMask, QueryIterator *it, double weight) {
+  pthread_mutex_lock(&cache->lock);
+  PrefixCacheEntry *e = PrefixCache_Find(cache, prefix, len, fieldMask);
+  bool known = e && e->tooLarge;
+  pthread_mutex_unlock(&cache->lock);
+  if (known) {
+    return it;
+  }
+
+  // Drain the expansion outside the lock, as concurrent queries may do the same
+  size_t cap = 64, numIds = 0;
+  t_docId *ids = rm_malloc(cap * sizeof(*ids));
+  IteratorStatus rc;
+  while ((rc = it->Read(it)) == ITERATOR_OK && numIds < PREFIX_CACHE_MAX_IDS) {
+    if (numIds == cap) {
+      cap *= 2;
+      ids = rm_realloc(ids, cap * sizeof(*ids));
+    }
+    ids[numIds++] = it->lastDocId;
+  }
+  if (rc != ITERATOR_EOF && rc != ITERATOR_OK) {
+    // Timed out, the ids are partial
+    rm_free(ids);
+    it->Rewind(it);
+    return it;
+  }
+
+  bool tooLarge = rc == ITERATOR_OK;
+  if (tooLarge) {
+    rm_free(ids);
+    ids = NULL;
+    numIds = 0;
+  }
+  pthread_mutex_lock(&cache->lock);
+  e = PrefixCache_Put(cache, prefix, len, fieldMask, ids, numIds, tooLarge);
+  QueryIterator *ret = tooLarge ? NULL : newCachedIterator(e, weight);
+  pthread_mutex_unlock(&cache->lock);
+
+  if (!ret) {
+    it->Rewind(it);
+    return it;
+  }
+  it->Free(it);
+  return ret;
+}
+
+void PrefixCache_InvalidateTerm(PrefixCache *cache, const char *term, size_t len) {
+  if (!cache) return;
+  pthread_mutex_lock(&cache->lock);
+  for (size_t i = 0; i < PREFIX_CACHE_CAPACITY && cache->numEntries; i++) {
+    PrefixCacheEntry *e = &cache->entries[i];
+    if (e->prefix && e->len <= len && !memcmp(e->prefix, term, e->len)) {
+      PrefixCacheEntry_Clear(e);
+      cache->numEntries--;
+    }
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
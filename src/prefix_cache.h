@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include "redisearch.h"
+#include "iterators/iterator_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of prefix expansions each index keeps materialized
+#define PREFIX_CACHE_CAPACITY 16
+// Only expansions into at least this number of terms are worth materializing
+#define PREFIX_CACHE_MIN_EXPANSIONS 16
+// Expansions matching more documents than this are not materialized
+#define PREFIX_CACHE_MAX_IDS (1 << 16)
+
+/**
+ * A small LRU cache of the document ids matched by hot prefix queries (`term*`), so repeated
+ * queries iterate over a sorted id list instead of expanding the terms trie and merging hundreds
+ * of inverted indexes. Entries are keyed by the lower-cased prefix and the field mask, and are
+ * invalidated whenever a term starting with their prefix is written.
+ *
+ * The ids carry no term data (frequencies, offsets), so the caller may only use it for queries
+ * that don't need rich results. Lookups may run concurrently (under the spec read lock), and are
+ * serialized by the cache itself.
+ */
+typedef struct PrefixCache PrefixCache;
+
+PrefixCache *NewPrefixCache(void);
+void PrefixCache_Free(PrefixCache *cache);
+
+/**
+ * Get an iterator over the ids cached for the prefix, yielding results with the given weight.
+ * @returns NULL if the prefix is not cached (or is known to match too many documents)
+ */
+QueryIterator *PrefixCache_Get(PrefixCache *cache, const char *prefix, size_t len, t_fieldMask fieldMask,
+                               double weight);
+
+/**
+ * Materialize the ids of `it`, the expansion of the prefix, and cache them.
+ * Takes ownership of `it`, and returns the iterator to use in its place: an iterator over the
+ * cached ids, or `it` itself (rewound) if its ids could not be cached.
+ */
+QueryIterator *PrefixCache_Materialize(PrefixCache *cache, const char *prefix, size_t len,
+                                       t_fieldMask fieldMask, QueryIterator *it, double weight);
+
+/**
+ * Drop the entries whose prefix matches the term, after documents are written to its index
+ */
+void PrefixCache_InvalidateTerm(PrefixCache *cache, const char *term, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
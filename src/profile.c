@@ -7,6 +7,7 @@
  * GNU Affero General Public License v3 (AGPLv3).
 */
 #include "profile.h"
+#include "config.h"
 #include "iterators/profile_iterator.h"
 #include "iterators/inverted_index_iterator.h"
 #include "iterators/not_iterator.h"
@@ -16,8 +17,11 @@
 #include "iterators/idlist_iterator.h"
 #include "iterators/hybrid_reader.h"
 #include "iterators/optimizer_reader.h"
+#include "iterators/sample_iterator.h"
 #include "reply_macros.h"
 #include "util/units.h"
+#include "hiredis/sds.h"
+#include "info/profile_stats.h"
 
 typedef struct {
     IteratorsConfig *iteratorsConfig;
@@ -70,11 +74,28 @@ void printInvIdxIt(RedisModule_Reply *reply, QueryIterator *root, ProfileCounter
   RedisModule_Reply_MapEnd(reply);
 }
 
-static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *rp, int printProfileClock) {
+void Profile_PrintHWCounters(RedisModule_Reply *reply, const PerfCounters *hw) {
+  if (!hw->valid) {
+    return;
+  }
+  RedisModule_ReplyKV_Map(reply, "Hardware counters");
+  for (PerfCounter c = 0; c < PERF_COUNTER__NUM; c++) {
+    RedisModule_ReplyKV_LongLong(reply, PerfCounter_Name(c), hw->values[c]);
+  }
+  const uint64_t cycles = hw->values[PERF_COUNTER_CYCLES];
+  RedisModule_ReplyKV_Double(reply, "Instructions per cycle",
+                             cycles ? (double)hw->values[PERF_COUNTER_INSTRUCTIONS] / cycles : 0);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+// `upstreamHW` is set to the hardware counters of the profile processor above `rp`, which include
+// those of the processors above it, as its time does
+static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *rp, int printProfileClock,
+                                     PerfCounters *upstreamHW) {
   if (rp == NULL) {
     return 0;
   }
-  double upstreamTime = _recursiveProfilePrint(reply, rp->upstream, printProfileClock);
+  double upstreamTime = _recursiveProfilePrint(reply, rp->upstream, printProfileClock, upstreamHW);
 
   // Array is filled backward in pair of [common, profile] result processors
   if (rp->type != RP_PROFILE) {
@@ -90,12 +111,16 @@ static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *
       case RP_COUNTER:
       case RP_PAGER_LIMITER:
       case RP_HIGHLIGHTER:
-      case RP_GROUP:
       case RP_MAX_SCORE_NORMALIZER:
       case RP_NETWORK:
         printProfileType(RPTypeToString(rp->type));
         break;
 
+      case RP_GROUP:
+        printProfileType(RPTypeToString(rp->type));
+        Grouper_ReplyApproximated(reply, rp);
+        break;
+
       case RP_PROJECTOR:
       case RP_FILTER:
         RPEvaluator_Reply(reply, "Type", rp);
@@ -104,6 +129,7 @@ static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *
       case RP_SAFE_LOADER:
         printProfileType(RPTypeToString(rp->type));
         printProfileGILTime(rp->GILTime);
+        printProfileRPNumBatches(RPSafeLoader_GetNumBatches(rp));
         break;
 
       case RP_PROFILE:
@@ -120,12 +146,20 @@ static double _recursiveProfilePrint(RedisModule_Reply *reply, ResultProcessor *
     printProfileTime(totalRPTime - upstreamTime);
   }
   printProfileCounter(RPProfile_GetCount(rp) - 1);
+  const PerfCounters *totalHW = RPProfile_GetHWCounters(rp);
+  if (totalHW->valid) {
+    PerfCounters hw = {0};
+    PerfCounters_AddDiff(&hw, upstreamHW, totalHW);
+    Profile_PrintHWCounters(reply, &hw);
+  }
+  *upstreamHW = *totalHW;
   RedisModule_Reply_MapEnd(reply); // end of recursive map
   return totalRPTime;
 }
 
 static double printProfileRP(RedisModule_Reply *reply, ResultProcessor *rp, int printProfileClock) {
-  return _recursiveProfilePrint(reply, rp, printProfileClock);
+  PerfCounters upstreamHW = {0};
+  return _recursiveProfilePrint(reply, rp, printProfileClock, &upstreamHW);
 }
 
 void Profile_Print(RedisModule_Reply *reply, void *ctx) {
@@ -200,6 +234,11 @@ void Profile_Print(RedisModule_Reply *reply, void *ctx) {
       RedisModule_ReplyKV_Array(reply, "Result processors profile");
         printProfileRP(reply, rp, req->reqConfig.printProfileClock);
       RedisModule_Reply_ArrayEnd(reply);
+
+      // Print the memory taken from the request's arena, if it parsed a query
+      if (profile_verbose && req->arena.numObjects) {
+        RedisModule_ReplyKV_LongLong(reply, "Arena bytes", req->arena.bytes);
+      }
   RedisModule_Reply_MapEnd(reply);
 }
 
@@ -240,39 +279,53 @@ void Profile_PrintDefault(RedisModule_Reply *reply, void *ctx) {
 }
 
 /** Add Profile iterator before any iterator in the tree */
-void Profile_AddIters(QueryIterator **root) {
+// Wrap every iterator of the tree, with a timed profile iterator if `timed`, or else a counting one
+static void addProfileIters(QueryIterator **root, bool timed) {
   if (*root == NULL) return;
 
   // Add profile iterator before child iterators
   switch((*root)->type) {
     case NOT_ITERATOR: {
       QueryIterator *child = ((NotIterator *)(*root))->child;
-      Profile_AddIters(&child);
+      addProfileIters(&child, timed);
       ((NotIterator *)(*root))->child = child;
       break;
     }
     case OPTIONAL_ITERATOR: {
       QueryIterator *child = ((OptionalIterator *)(*root))->child;
-      Profile_AddIters(&child);
+      addProfileIters(&child, timed);
       ((OptionalIterator *)(*root))->child = child;
       break;
     }
     case HYBRID_ITERATOR: {
       QueryIterator *child = ((HybridIterator *)(*root))->child;
-      Profile_AddIters(&child);
+      addProfileIters(&child, timed);
       ((HybridIterator *)(*root))->child = child;
       break;
     }
     case OPTIMUS_ITERATOR: {
       QueryIterator *child = ((OptimizerIterator *)(*root))->child;
-      Profile_AddIters(&child);
+      addProfileIters(&child, timed);
       ((OptimizerIterator *)(*root))->child = child;
       break;
     }
+    case SAMPLE_ITERATOR: {
+      QueryIterator *child = ((SampleIterator *)(*root))->child;
+      addProfileIters(&child, timed);
+      ((SampleIterator *)(*root))->child = child;
+      break;
+    }
     case UNION_ITERATOR: {
       UnionIterator *ui = (UnionIterator *)(*root);
+      if (!timed && ui->num_deferred) {
+        // Opening the children up front would cost more than the counters save, so only the union
+        // is counted
+        break;
+      }
+      // Every child is profiled, so none can be opened later
+      UI_OpenDeferred(ui);
       for (int i = 0; i < ui->num_orig; i++) {
-        Profile_AddIters(&(ui->its_orig[i]));
+        addProfileIters(&(ui->its_orig[i]), timed);
       }
       UI_SyncIterList(ui);
       break;
@@ -280,7 +333,7 @@ void Profile_AddIters(QueryIterator **root) {
     case INTERSECT_ITERATOR: {
       IntersectionIterator *ii = (IntersectionIterator *)(*root);
       for (int i = 0; i < ii->num_its; i++) {
-        Profile_AddIters(&(ii->its[i]));
+        addProfileIters(&(ii->its[i]), timed);
       }
       break;
     }
@@ -299,7 +352,161 @@ void Profile_AddIters(QueryIterator **root) {
   }
 
   // Create a profile iterator and update outparam pointer
-  *root = NewProfileIterator(*root);
+  if (!timed) {
+    *root = NewCountingIterator(*root);
+  } else if (RSGlobalConfig.profileHWCounters) {
+    *root = NewHWProfileIterator(*root);
+  } else {
+    *root = NewProfileIterator(*root);
+  }
+}
+
+void Profile_AddIters(QueryIterator **root) {
+  addProfileIters(root, true);
+}
+
+void Profile_AddCounters(QueryIterator **root) {
+  addProfileIters(root, false);
+}
+
+// The type of an iterator, as printed by FT.PROFILE but without the terms it reads
+static ProfileStatsIterator iteratorKind(const QueryIterator *it) {
+  switch (it->type) {
+    case INV_IDX_ITERATOR: {
+      const IndexReader *reader = ((const InvIndIterator *)it)->reader;
+      if (IndexReader_Flags(reader) == Index_DocIdsOnly) {
+        return PROFILE_STATS_TAG;
+      } else if (IndexReader_Flags(reader) & Index_StoreNumeric) {
+        const NumericFilter *flt = IndexReader_NumericFilter(reader);
+        return flt && flt->geoFilter ? PROFILE_STATS_GEO : PROFILE_STATS_NUMERIC;
+      }
+      return PROFILE_STATS_TEXT;
+    }
+    case UNION_ITERATOR:      return PROFILE_STATS_UNION;
+    case INTERSECT_ITERATOR:  return PROFILE_STATS_INTERSECT;
+    case NOT_ITERATOR:        return PROFILE_STATS_NOT;
+    case OPTIONAL_ITERATOR:   return PROFILE_STATS_OPTIONAL;
+    case WILDCARD_ITERATOR:   return PROFILE_STATS_WILDCARD;
+    case EMPTY_ITERATOR:      return PROFILE_STATS_EMPTY;
+    case ID_LIST_ITERATOR:    return PROFILE_STATS_ID_LIST;
+    case HYBRID_ITERATOR:     return PROFILE_STATS_VECTOR;
+    case METRIC_ITERATOR:     return PROFILE_STATS_METRIC;
+    case OPTIMUS_ITERATOR:    return PROFILE_STATS_OPTIMIZER;
+    case SAMPLE_ITERATOR:     return PROFILE_STATS_SAMPLE;
+    // LCOV_EXCL_START
+    case PROFILE_ITERATOR:
+    case MAX_ITERATOR:
+      break;
+    // LCOV_EXCL_STOP
+  }
+  RS_ABORT("Unexpected iterator type");
+  return PROFILE_STATS_ITERATOR__NUM;
+}
+
+static size_t numChildren(const QueryIterator *it) {
+  switch (it->type) {
+    case UNION_ITERATOR:      return ((const UnionIterator *)it)->num_orig;
+    case INTERSECT_ITERATOR:  return ((const IntersectionIterator *)it)->num_its;
+    case NOT_ITERATOR:
+    case OPTIONAL_ITERATOR:
+    case HYBRID_ITERATOR:
+    case OPTIMUS_ITERATOR:
+    case SAMPLE_ITERATOR:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// The `i`th child of an iterator, which may be NULL (e.g. the filter of a vector query)
+static QueryIterator *childAt(const QueryIterator *it, size_t i) {
+  switch (it->type) {
+    case UNION_ITERATOR:      return ((const UnionIterator *)it)->its_orig[i];
+    case INTERSECT_ITERATOR:  return ((const IntersectionIterator *)it)->its[i];
+    case NOT_ITERATOR:        return ((const NotIterator *)it)->child;
+    case OPTIONAL_ITERATOR:   return ((const OptionalIterator *)it)->child;
+    case HYBRID_ITERATOR:     return ((const HybridIterator *)it)->child;
+    case OPTIMUS_ITERATOR:    return ((const OptimizerIterator *)it)->child;
+    case SAMPLE_ITERATOR:     return ((const SampleIterator *)it)->child;
+    default:                  return NULL;
+  }
+}
+
+static sds describeIterators(sds s, QueryIterator *root, const ProfileCounters *counters, int depth) {
+  if (root->type == PROFILE_ITERATOR) {
+    ProfileIterator *pi = (ProfileIterator *)root;
+    return describeIterators(s, pi->child, &pi->counters, depth);
+  }
+  s = sdscatprintf(s, "%*s%s estimated=%zu", depth * 2, "",
+                   ProfileStats_IteratorName(iteratorKind(root)), root->NumEstimated(root));
+  if (counters) {
+    s = sdscatprintf(s, " counter=%zu", counters->read + counters->skipTo - counters->eof);
+  }
+  s = sdscat(s, "\n");
+
+  for (size_t i = 0; i < numChildren(root); i++) {
+    QueryIterator *child = childAt(root, i);
+    if (child) {
+      s = describeIterators(s, child, NULL, depth + 1);
+    }
+  }
+  return s;
+}
+
+char *Profile_DescribeIterators(QueryIterator *root) {
+  if (!root) {
+    return NULL;
+  }
+  sds s = describeIterators(sdsempty(), root, NULL, 0);
+  char *ret = rm_strndup(s, sdslen(s));
+  sdsfree(s);
+  return ret;
+}
+
+// The time of a profile iterator includes the time of its children, which are profiled as well
+static void countSampledIterators(QueryIterator *root) {
+  if (root->type != PROFILE_ITERATOR) {
+    return;
+  }
+  const ProfileIterator *pi = (const ProfileIterator *)root;
+  rs_wall_clock_ns_t childrenTime = 0;
+  for (size_t i = 0; i < numChildren(pi->child); i++) {
+    QueryIterator *child = childAt(pi->child, i);
+    if (child && child->type == PROFILE_ITERATOR) {
+      childrenTime += ((const ProfileIterator *)child)->wallTime;
+      countSampledIterators(child);
+    }
+  }
+  const rs_wall_clock_ns_t selfTime = pi->wallTime > childrenTime ? pi->wallTime - childrenTime : 0;
+  ProfileStats_CountIterator(iteratorKind(pi->child), pi->counters.read + pi->counters.skipTo,
+                             selfTime);
+}
+
+// As in `_recursiveProfilePrint`, returns the time of the profile processor above `rp`
+static rs_wall_clock_ns_t countSampledRPs(ResultProcessor *rp) {
+  if (rp == NULL) {
+    return 0;
+  }
+  const rs_wall_clock_ns_t upstreamTime = countSampledRPs(rp->upstream);
+  if (rp->type != RP_PROFILE) {
+    return upstreamTime;
+  }
+  const rs_wall_clock_ns_t totalTime = RPProfile_GetClock(rp);
+  ProfileStats_CountRP(rp->upstream->type, RPProfile_GetCount(rp) - 1,
+                       totalTime > upstreamTime ? totalTime - upstreamTime : 0);
+  return totalTime;
+}
+
+void Profile_CountSampled(QueryProcessingCtx *qctx) {
+  if (!qctx->endProc) {
+    return;
+  }
+  ProfileStats_CountQuery();
+  QueryIterator *root = QITR_GetRootFilter(qctx);
+  if (root) {
+    countSampledIterators(root);
+  }
+  countSampledRPs(qctx->endProc);
 }
 
 #define PRINT_PROFILE_FUNC(name) static void name(RedisModule_Reply *reply,   \
@@ -408,9 +615,35 @@ PRINT_PROFILE_FUNC(printMetricIt) {
 
   printProfileCounters(counters);
 
+  if (it->searchMode) {
+    RedisModule_ReplyKV_SimpleString(reply, "Vector search mode", it->searchMode);
+  }
+
   RedisModule_Reply_MapEnd(reply);
 }
 
+static const char *vectorSearchModeName(VecSimSearchMode mode) {
+  switch (mode) {
+    case VECSIM_STANDARD_KNN:               return "STANDARD_KNN";
+    case VECSIM_HYBRID_ADHOC_BF:            return "HYBRID_ADHOC_BF";
+    case VECSIM_HYBRID_BATCHES:             return "HYBRID_BATCHES";
+    case VECSIM_HYBRID_BATCHES_TO_ADHOC_BF: return "HYBRID_BATCHES_TO_ADHOC_BF";
+    case VECSIM_RANGE_QUERY:                return "RANGE_QUERY";
+    default:                                return "EMPTY_MODE";
+  }
+}
+
+// What the vector query did, only in the verbose profile as it is not part of its stable format
+static void printHybridStats(RedisModule_Reply *reply, const HybridIterator *hi) {
+  RedisModule_ReplyKV_SimpleString(reply, "Vector search mode", vectorSearchModeName(hi->searchMode));
+  RedisModule_ReplyKV_LongLong(reply, "Vector index results", hi->stats.indexResults);
+  RedisModule_ReplyKV_LongLong(reply, "Distance computations", hi->stats.distances);
+  if (hi->efRuntime) {
+    RedisModule_ReplyKV_LongLong(reply, "EF runtime", hi->efRuntime);
+  }
+  RedisModule_ReplyKV_LongLong(reply, "Vector bytes read", hi->stats.bytesRead);
+}
+
 void PrintIteratorChildProfile(RedisModule_Reply *reply, QueryIterator *root, ProfileCounters *counters, double cpuTime,
                   int depth, int limited, PrintProfileConfig *config, QueryIterator *child, const char *text) {
   size_t nlen = 0;
@@ -427,6 +660,9 @@ void PrintIteratorChildProfile(RedisModule_Reply *reply, QueryIterator *root, Pr
           hi->searchMode == VECSIM_HYBRID_BATCHES_TO_ADHOC_BF) {
         printProfileNumBatches(hi);
       }
+      if (config->printProfileClock) {
+        printHybridStats(reply, hi);
+      }
     }
 
     if (root->type == OPTIMUS_ITERATOR) {
@@ -460,6 +696,7 @@ PRINT_PROFILE_SINGLE(printNotIt, NotIterator,           "NOT");
 PRINT_PROFILE_SINGLE(printOptionalIt, OptionalIterator, "OPTIONAL");
 PRINT_PROFILE_SINGLE(printHybridIt, HybridIterator,     "VECTOR");
 PRINT_PROFILE_SINGLE(printOptimusIt, OptimizerIterator, "OPTIMIZER");
+PRINT_PROFILE_SINGLE(printSampleIt, SampleIterator,     "SAMPLE");
 
 PRINT_PROFILE_FUNC(printProfileIt) {
   ProfileIterator *pi = (ProfileIterator *)root;
@@ -487,6 +724,7 @@ void printIteratorProfile(RedisModule_Reply *reply, QueryIterator *root, Profile
     case HYBRID_ITERATOR:     { printHybridIt(reply, root, counters, cpuTime, depth, limited, config);     break; }
     case METRIC_ITERATOR:     { printMetricIt(reply, root, counters, cpuTime, depth, limited, config);     break; }
     case OPTIMUS_ITERATOR:    { printOptimusIt(reply, root, counters, cpuTime, depth, limited, config);    break; }
+    case SAMPLE_ITERATOR:     { printSampleIt(reply, root, counters, cpuTime, depth, limited, config);     break; }
     case MAX_ITERATOR:        { RS_ABORT("nope");   break; } // LCOV_EXCL_LINE
   }
 }
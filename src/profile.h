@@ -18,11 +18,16 @@
 #define printProfileCounter(vcount) RedisModule_ReplyKV_LongLong(reply, "Counter", (vcount))
 // For now we only print the total counter in order to avoid breaking the response format of profile
 // If we get a chance to break it then consider splitting the count into separate fields
-#define printProfileCounters(counters) printProfileCounter(counters->read + counters->skipTo - counters->eof)
+#define printProfileCounters(counters)                                                      \
+  do {                                                                                      \
+    printProfileCounter(counters->read + counters->skipTo - counters->eof);                \
+    Profile_PrintHWCounters(reply, &counters->hw);                                          \
+  } while (0)
 
 #define printProfileGILTime(vtime) RedisModule_ReplyKV_Double(reply, "GIL-Time", (rs_timer_ms(&(vtime))))
 #define printProfileNumBatches(hybrid_reader) \
   RedisModule_ReplyKV_LongLong(reply, "Batches number", (hybrid_reader)->numIterations)
+#define printProfileRPNumBatches(vbatches) RedisModule_ReplyKV_LongLong(reply, "Batches number", (vbatches))
 #define printProfileOptimizationType(oi) \
   RedisModule_ReplyKV_SimpleString(reply, "Optimizer mode", QOptimizer_PrintType((oi)->optim))
 
@@ -35,6 +40,41 @@
  */
 void Profile_AddIters(QueryIterator **root);
 
+/**
+ * @brief Add counting iterators to the nodes of the iterator tree
+ *
+ * As `Profile_AddIters`, without timing the iterators, and without opening the deferred children of
+ * the unions, which are counted as a whole. Used by the slow log.
+ *
+ * @param root The root iterator
+ */
+void Profile_AddCounters(QueryIterator **root);
+
+// Print the hardware counters, if they were read (see _PROFILE_HW_COUNTERS)
+void Profile_PrintHWCounters(RedisModule_Reply *reply, const PerfCounters *hw);
+
+/**
+ * @brief Describe the shape of the iterator tree, one iterator per line
+ *
+ * Each line holds the type of an iterator, indented by its depth, its estimated number of results
+ * and, if it was profiled or counted, the number of results it read. The terms of the query are left
+ * out.
+ *
+ * @param root The root iterator, possibly NULL
+ * @return a string allocated with rm_malloc, or NULL if there is no iterator
+ */
+char *Profile_DescribeIterators(QueryIterator *root);
+
+/**
+ * @brief Add the profile of a sampled query to the totals of the sampled profile
+ *
+ * The query was built with QEXEC_F_PROFILE_SAMPLED, so its iterators and result processors are
+ * profiled. The time each of them spent without its children is added (see info/profile_stats.h).
+ *
+ * @param qctx The processing context of the query, once it was executed
+ */
+void Profile_CountSampled(QueryProcessingCtx *qctx);
+
 // Print the profile of a single shard
 void Profile_Print(RedisModule_Reply *reply, void *ctx);
 // Print the profile of a single shard, in full format
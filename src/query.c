@@ -30,11 +30,15 @@
 #include "numeric_filter.h"
 #include "util/strconv.h"
 #include "util/arr.h"
+#include "util/arena.h"
+#include "util/fnv.h"
 #include "rmutil/rm_assert.h"
 #include "module.h"
 #include "query_internal.h"
 #include "aggregate/aggregate.h"
 #include "suffix.h"
+#include "prefix_cache.h"
+#include "filter_cache.h"
 #include "wildcard.h"
 #include "geometry/geometry_api.h"
 #include "iterators/inverted_index_iterator.h"
@@ -47,7 +51,9 @@
 #include "iterators/empty_iterator.h"
 #include "iterators/hybrid_reader.h"
 #include "iterators/optimizer_reader.h"
+#include "iterators/sample_iterator.h"
 #include "search_disk.h"
+#include "obfuscation/obfuscation_api.h"
 
 #ifndef STRINGIFY
 #define __STRINGIFY(x) #x
@@ -56,8 +62,8 @@
 
 #define EFFECTIVE_FIELDMASK(q_, qn_) ((qn_)->opts.fieldMask & (q)->opts->fieldmask)
 
-static void QueryTokenNode_Free(QueryTokenNode *tn) {
-  if (tn->str) rm_free(tn->str);
+static void QueryTokenNode_Free(const QueryNode *n, QueryTokenNode *tn) {
+  if (tn->str && !n->tokenInArena) rm_free(tn->str);
 }
 
 static void QueryGeometryNode_Free(QueryGeometryNode *geom) {
@@ -103,13 +109,13 @@ void QueryNode_Free(QueryNode *n) {
 
   switch (n->type) {
     case QN_TOKEN:
-      QueryTokenNode_Free(&n->tn);
+      QueryTokenNode_Free(n, &n->tn);
       break;
     case QN_NUMERIC:
       NumericFilter_Free((void *)n->nn.nf);
       break;
     case QN_PREFIX:
-      QueryTokenNode_Free(&n->pfx.tok);
+      QueryTokenNode_Free(n, &n->pfx.tok);
       break;
     case QN_GEO:
       if (n->gn.gf) {
@@ -117,7 +123,7 @@ void QueryNode_Free(QueryNode *n) {
       }
       break;
     case QN_FUZZY:
-      QueryTokenNode_Free(&n->fz.tok);
+      QueryTokenNode_Free(n, &n->fz.tok);
       break;
     case QN_LEXRANGE:
       QueryLexRangeNode_Free(&n->lxrng);
@@ -126,7 +132,7 @@ void QueryNode_Free(QueryNode *n) {
       QueryVectorNode_Free(&n->vn);
       break;
     case QN_WILDCARD_QUERY:
-      QueryTokenNode_Free(&n->verb.tok);
+      QueryTokenNode_Free(n, &n->verb.tok);
       break;
     case QN_GEOMETRY:
       QueryGeometryNode_Free(&n->gmn);
@@ -142,7 +148,128 @@ void QueryNode_Free(QueryNode *n) {
     case QN_PHRASE:
       break;
   }
-  rm_free(n);
+  if (!n->inArena) {
+    rm_free(n);
+  }
+}
+
+static char *cloneTokenStr(const RSToken *tok) {
+  if (!tok->str) return NULL;
+  char *str = rm_malloc(tok->len + 1);
+  memcpy(str, tok->str, tok->len);
+  str[tok->len] = '\0';
+  return str;
+}
+
+// Point `*ptr`, if it points within `size` bytes from `from`, at the same offset from `to`
+static bool rebasePointer(void **ptr, const void *from, size_t size, void *to) {
+  const char *p = *ptr;
+  if (p < (const char *)from || p >= (const char *)from + size) {
+    return false;
+  }
+  *ptr = (char *)to + (p - (const char *)from);
+  return true;
+}
+
+// The parameters point at the values they set, within the node or its filter
+static bool rebaseParamTarget(void **ptr, const QueryNode *src, QueryNode *dst) {
+  if (!*ptr || rebasePointer(ptr, src, sizeof(*src), dst)) {
+    return true;
+  }
+  switch (src->type) {
+    case QN_NUMERIC:
+      return rebasePointer(ptr, src->nn.nf, sizeof(*src->nn.nf), dst->nn.nf);
+    case QN_GEO:
+      return rebasePointer(ptr, src->gn.gf, sizeof(*src->gn.gf), dst->gn.gf);
+    default:
+      return false;
+  }
+}
+
+static bool QueryNode_CanClone(const QueryNode *n) {
+  switch (n->type) {
+    case QN_NUMERIC:
+      return !n->nn.nf->geoFilter;
+    case QN_GEO:
+      return !n->gn.gf->numericFilters;
+    case QN_VECTOR:
+    case QN_GEOMETRY:
+    case QN_IDS:
+      return false;
+    default:
+      return true;
+  }
+}
+
+QueryNode *QueryNode_Clone(const QueryNode *src) {
+  if (!QueryNode_CanClone(src)) {
+    return NULL;
+  }
+  QueryNode *dst = NewQueryNode(src->type);
+  const bool inArena = dst->inArena;
+  *dst = *src;
+  dst->inArena = inArena;
+  dst->tokenInArena = false;
+  dst->children = NULL;
+  dst->params = NULL;
+  if (src->opts.distField) {
+    dst->opts.distField = rm_strdup(src->opts.distField);
+  }
+
+  switch (src->type) {
+    case QN_TOKEN:
+      dst->tn.str = cloneTokenStr(&src->tn);
+      break;
+    case QN_PREFIX:
+      dst->pfx.tok.str = cloneTokenStr(&src->pfx.tok);
+      break;
+    case QN_FUZZY:
+      dst->fz.tok.str = cloneTokenStr(&src->fz.tok);
+      break;
+    case QN_WILDCARD_QUERY:
+      dst->verb.tok.str = cloneTokenStr(&src->verb.tok);
+      break;
+    case QN_LEXRANGE:
+      dst->lxrng.begin = src->lxrng.begin ? rm_strdup(src->lxrng.begin) : NULL;
+      dst->lxrng.end = src->lxrng.end ? rm_strdup(src->lxrng.end) : NULL;
+      break;
+    case QN_NUMERIC:
+      dst->nn.nf = rm_malloc(sizeof(*dst->nn.nf));
+      *dst->nn.nf = *src->nn.nf;
+      break;
+    case QN_GEO:
+      dst->gn.gf = rm_malloc(sizeof(*dst->gn.gf));
+      *dst->gn.gf = *src->gn.gf;
+      break;
+    default:
+      break;
+  }
+
+  if (src->params) {
+    QueryNode_InitParams(dst, QueryNode_NumParams(src));
+    for (size_t ii = 0; ii < QueryNode_NumParams(src); ++ii) {
+      Param *param = &dst->params[ii];
+      *param = src->params[ii];
+      if (param->name) {
+        param->name = rm_strndup(param->name, param->len);
+      }
+      if (!rebaseParamTarget(&param->target, src, dst) ||
+          !rebaseParamTarget((void **)&param->target_len, src, dst)) {
+        QueryNode_Free(dst);
+        return NULL;
+      }
+    }
+  }
+
+  for (size_t ii = 0; ii < QueryNode_NumChildren(src); ++ii) {
+    QueryNode *child = QueryNode_Clone(src->children[ii]);
+    if (!child) {
+      QueryNode_Free(dst);
+      return NULL;
+    }
+    QueryNode_AddChild(dst, child);
+  }
+  return dst;
 }
 
 // Add a new metric request to the metricRequests array. Returns the index of the request
@@ -155,7 +282,9 @@ static int addMetricRequest(QueryEvalCtx *q, char *metric_name, bool isInternal)
 
 
 QueryNode *NewQueryNode(QueryNodeType type) {
-  QueryNode *s = rm_calloc(1, sizeof(QueryNode));
+  Arena *arena = Arena_Current();
+  QueryNode *s = arena ? Arena_Alloc(arena, sizeof(QueryNode)) : rm_calloc(1, sizeof(QueryNode));
+  s->inArena = arena != NULL;
   s->type = type;
   s->opts = (QueryNodeOptions){
     .fieldMask = RS_FIELDMASK_ALL,
@@ -175,6 +304,51 @@ QueryNode *NewQueryNodeChildren(QueryNodeType type, QueryNode **children, size_t
   return ret;
 }
 
+/* A copy of a token string of the query for the node. The tokens of the nodes in an arena are copied
+ * into it, rather than allocated one by one */
+static char *tokenStrndup(QueryNode *n, const char *s, size_t len) {
+  Arena *arena = n->inArena ? Arena_Current() : NULL;
+  if (!arena) {
+    char *ret = rm_malloc(len + 1);
+    memcpy(ret, s, len);
+    ret[len] = '\0';
+    return ret;
+  }
+  n->tokenInArena = true;
+  return Arena_Strndup(arena, s, len);
+}
+
+/* As rm_normalize(), for a token of the node. Sets `*len` to the length of the normalized token */
+static char *tokenNormalize(QueryNode *n, const char *s, size_t *len) {
+  char *ret = tokenStrndup(n, s, *len);
+  char *longer = normalize_inplace(ret, len);
+  if (longer) {
+    if (n->tokenInArena) {
+      ret = Arena_Strndup(Arena_Current(), longer, *len);
+      rm_free(longer);
+    } else {
+      rm_free(ret);
+      ret = longer;
+    }
+  }
+  return ret;
+}
+
+/* As rm_strndup_unescape(), for a token of the node */
+static char *tokenUnescape(QueryNode *n, const char *s, size_t *len) {
+  char *ret = tokenStrndup(n, s, *len);
+  char *dst = ret;
+  for (size_t left = *len; *s && left; ++s, --left) {
+    if (*s == '\\' && (ispunct(*(s + 1)) || isspace(*(s + 1)))) {
+      continue;
+    }
+    *dst++ = *s;
+  }
+  *dst = '\0';
+  *len = dst - ret;
+  return ret;
+}
+
 QueryNode *NewTokenNodeExpanded(QueryAST *q, const char *s, size_t len, RSTokenFlags flags) {
   QueryNode *ret = NewQueryNode(QN_TOKEN);
   q->numTokens++;
@@ -205,15 +379,8 @@ QueryNode *NewTokenNode_WithParams(QueryParseCtx *q, QueryToken *qt) {
 
   if (qt->type == QT_TERM || qt->type == QT_TERM_CASE || qt->type == QT_NUMERIC
       || qt->type == QT_SIZE) {
-    char *s;
-    size_t len;
-    if (qt->type == QT_TERM) {
-      s = rm_normalize(qt->s, qt->len);
-      len = strlen(s);
-    } else {
-      s = rm_strndup(qt->s, qt->len);
-      len = qt->len;
-    }
+    size_t len = qt->len;
+    char *s = qt->type == QT_TERM ? tokenNormalize(ret, qt->s, &len) : tokenStrndup(ret, qt->s, len);
     ret->tn = (QueryTokenNode){.str = s, .len = len, .expanded = 0, .flags = 0};
     // Do not expand numbers
     if(qt->type == QT_NUMERIC || qt->type == QT_SIZE) {
@@ -245,8 +412,9 @@ QueryNode *NewPrefixNode_WithParams(QueryParseCtx *q, QueryToken *qt, bool prefi
   ret->pfx.suffix = suffix;
   q->numTokens++;
   if (qt->type == QT_TERM) {
-    char *s = rm_strndup_unescape(qt->s, qt->len);
-    ret->pfx.tok = (RSToken){.str = s, .len = strlen(s), .expanded = 0, .flags = 0};
+    size_t len = qt->len;
+    char *s = tokenUnescape(ret, qt->s, &len);
+    ret->pfx.tok = (RSToken){.str = s, .len = len, .expanded = 0, .flags = 0};
   } else {
     assert (qt->type == QT_PARAM_TERM);
     QueryNode_InitParams(ret, 1);
@@ -259,10 +427,7 @@ QueryNode *NewWildcardNode_WithParams(QueryParseCtx *q, QueryToken *qt) {
   QueryNode *ret = NewQueryNode(QN_WILDCARD_QUERY);
   q->numTokens++;
   if (qt->type == QT_WILDCARD) {
-    // ensure str is NULL terminated
-    char *s = rm_malloc(qt->len + 1);
-    memcpy(s, qt->s, qt->len);
-    s[qt->len] = '\0';
+    char *s = tokenStrndup(ret, qt->s, qt->len);
     ret->verb.tok = (RSToken){.str = s, .len = qt->len, .expanded = 0, .flags = 0};
   } else {
     RS_ASSERT(qt->type == QT_PARAM_WILDCARD);
@@ -278,12 +443,13 @@ QueryNode *NewFuzzyNode_WithParams(QueryParseCtx *q, QueryToken *qt, int maxDist
   q->numTokens++;
 
   if (qt->type == QT_TERM || qt->type == QT_NUMERIC || qt->type == QT_SIZE) {
-    char *s = rm_normalize(qt->s, qt->len);
+    size_t len = qt->len;
+    char *s = tokenNormalize(ret, qt->s, &len);
     ret->fz = (QueryFuzzyNode){
       .tok =
           (RSToken){
             .str = (char *)s,
-            .len = strlen(s),
+            .len = len,
             .expanded = 0,
             .flags = 0,
             },
@@ -393,6 +559,7 @@ QueryNode *NewVectorNode_WithParams(struct QueryParseCtx *q, VectorQueryType typ
       QueryNode_SetParam(q, &ret->params[0], &vq->knn.vector, &vq->knn.vecLen, vec);
       QueryNode_SetParam(q, &ret->params[1], &vq->knn.k, NULL, value);
       vq->knn.shardWindowRatio = DEFAULT_SHARD_WINDOW_RATIO;
+      vq->knn.rerankFactor = DEFAULT_RERANK_FACTOR;
 
       // Save K position so it can be modified later in the shard command.
       // NOTE: If k is given as a *parameter*:
@@ -523,6 +690,10 @@ QueryIterator *Query_EvalTokenNode(QueryEvalCtx *q, QueryNode *qn) {
   if (q->sctx->spec->diskSpec) {
     RS_LOG_ASSERT(q->sctx->spec->diskSpec, "Disk spec should be open");
     return SearchDisk_NewTermIterator(q->sctx->spec->diskSpec, term->str, EFFECTIVE_FIELDMASK(q, qn), qn->opts.weight);
+  } else if ((q->reqFlags & QEXEC_F_IMPACT_POSTINGS) && !q->exhaustiveSubtree &&
+             !q->notSubtree && !q->positionalSubtree) {
+    // A term of a ranked query, alone or in a union, only needs its top documents
+    return Redis_OpenImpactReader(q->sctx, term, EFFECTIVE_FIELDMASK(q, qn), qn->opts.weight);
   } else {
     return Redis_OpenReader(q->sctx, term, q->docTable, EFFECTIVE_FIELDMASK(q, qn), qn->opts.weight);
   }
@@ -605,11 +776,65 @@ typedef struct {
   QueryIterator **its;
   size_t nits;
   size_t cap;
+  // The children of a union whose readers are deferred until it gets to their terms (see
+  // `initDeferredTerms`). NULL if the readers are opened right away
+  UnionDeferredChild *deferred;
+  size_t ndeferred;
+  size_t deferredCap;
   QueryEvalCtx *q;
   QueryNodeOptions *opts;
   double weight;
 } TrieCallbackCtx;
 
+typedef struct {
+  const RedisSearchCtx *sctx;
+  t_fieldMask fieldMask;
+} DeferredTermsCtx;
+
+static QueryIterator *openDeferredTerm(void *ctx, const void *source, void *arg, bool stale) {
+  DeferredTermsCtx *dctx = ctx;
+  RSQueryTerm *term = arg;
+  if (stale) {
+    return Redis_OpenReader(dctx->sctx, term, &dctx->sctx->spec->docs, dctx->fieldMask, 1);
+  }
+  FieldMaskOrIndex fieldMaskOrIndex = {.isFieldMask = true, .value.mask = dctx->fieldMask};
+  return NewInvIndIterator_TermQuery(source, dctx->sctx, fieldMaskOrIndex, term, 1);
+}
+
+/* Broad expansions may yield thousands of terms, and opening all their readers delays the first
+ * result of the union. Unless the index is on disk, the readers are only opened once the union gets
+ * to the first id of their term */
+static void initDeferredTerms(TrieCallbackCtx *ctx) {
+  if (!ctx->q->sctx->spec->diskSpec) {
+    ctx->deferredCap = 8;
+    ctx->deferred = rm_malloc(sizeof(*ctx->deferred) * ctx->deferredCap);
+  }
+}
+
+static size_t rangeItersNum(const TrieCallbackCtx *ctx) {
+  return ctx->nits + ctx->ndeferred;
+}
+
+static QueryIterator *rangeItersUnion(TrieCallbackCtx *ctx, double weight, QueryNodeType type,
+                                      const char *q_str) {
+  if (!ctx->deferred) {
+    return NewUnionIterator(ctx->its, ctx->nits, true, weight, type, q_str, ctx->q->config);
+  }
+  RS_ASSERT(!ctx->nits);
+  rm_free(ctx->its);
+  DeferredTermsCtx *dctx = rm_malloc(sizeof(*dctx));
+  dctx->sctx = ctx->q->sctx;
+  dctx->fieldMask = ctx->q->opts->fieldmask & ctx->opts->fieldMask;
+  UnionChildOpener opener = {
+    .open = openDeferredTerm,
+    .freeArg = (void (*)(void *))Term_Free,
+    .freeCtx = rm_free,
+    .ctx = dctx,
+  };
+  return NewDeferredUnionIterator(ctx->deferred, ctx->ndeferred, &opener, weight, type, q_str,
+                                  ctx->q->config);
+}
+
 static int runeIterCb(const rune *r, size_t n, void *p, void *payload);
 static int charIterCb(const char *s, size_t n, void *p, void *payload);
 
@@ -625,6 +850,17 @@ static const char *PrefixNode_GetTypeString(const QueryPrefixNode *pfx) {
 
 #define TRIE_STR_TOO_LONG_MSG "query string is too long. Maximum allowed length is " STRINGIFY(MAX_RUNESTR_LEN)
 
+/* Can the ids of a prefix node be served from the index's prefix cache? The cache holds plain ids,
+ * so only pure prefix queries whose results are not scored, highlighted or checked for term
+ * positions qualify, on indexes whose documents can't match differently as time passes */
+static bool Query_CanCachePrefix(const QueryEvalCtx *q, const QueryNode *qn) {
+  const IndexSpec *spec = q->sctx->spec;
+  return qn->pfx.prefix && !qn->pfx.suffix &&
+         (q->opts->flags & Search_CanSkipRichResults) && !q->positionalSubtree &&
+         spec->prefixCache && !spec->diskSpec &&
+         !(spec->docs.ttl && spec->monitorFieldExpiration);
+}
+
 /* Evaluate a prefix node by expanding all its possible matches and creating one big UNION on all
  * of them.
  * Used for Prefix, Contains and suffix nodes.
@@ -652,23 +888,39 @@ static QueryIterator *Query_EvalPrefixNode(QueryEvalCtx *q, QueryNode *qn) {
     return NULL;
   }
 
+  // Hot prefix expansions are served from the index's cache of materialized ids
+  char *cacheKey = NULL;
+  size_t cacheKeyLen = 0;
+  const t_fieldMask fieldMask = q->opts->fieldmask & qn->opts.fieldMask;
+  if (Query_CanCachePrefix(q, qn)) {
+    cacheKey = runesToStr(str, nstr, &cacheKeyLen);
+    QueryIterator *cached = PrefixCache_Get(spec->prefixCache, cacheKey, cacheKeyLen, fieldMask, qn->opts.weight);
+    if (cached) {
+      rm_free(cacheKey);
+      rm_free(str);
+      return cached;
+    }
+  }
+
   ctx.cap = 8;
   ctx.its = rm_malloc(sizeof(*ctx.its) * ctx.cap);
   ctx.nits = 0;
+  initDeferredTerms(&ctx);
 
   // spec support contains queries
-  if (spec->suffix && qn->pfx.suffix) {
+  if ((spec->suffix || spec->suffixArray) && qn->pfx.suffix) {
     // all modifier fields are supported
     if (qn->opts.fieldMask == RS_FIELDMASK_ALL ||
        (spec->suffixMask & qn->opts.fieldMask) == qn->opts.fieldMask) {
       SuffixCtx sufCtx = {
-        .root = spec->suffix->root,
+        .root = spec->suffix ? spec->suffix->root : NULL,
+        .array = spec->suffixArray,
         .rune = str,
         .runelen = nstr,
         .type = qn->pfx.prefix ? SUFFIX_TYPE_CONTAINS : SUFFIX_TYPE_SUFFIX,
         .callback = charIterCb,
         .cbCtx = &ctx,
-
+        .timeout = &q->sctx->time.timeout,
       };
       Suffix_IterateContains(&sufCtx);
     } else {
@@ -681,7 +933,15 @@ static QueryIterator *Query_EvalPrefixNode(QueryEvalCtx *q, QueryNode *qn) {
 
   rm_free(str);
 
-  return NewUnionIterator(ctx.its, ctx.nits, true, qn->opts.weight, QN_PREFIX, qn->pfx.tok.str, q->config);
+  size_t nits = rangeItersNum(&ctx);
+  QueryIterator *ret = rangeItersUnion(&ctx, qn->opts.weight, QN_PREFIX, qn->pfx.tok.str);
+  // Only complete expansions are cached: not truncated by the expansions limit or a timeout
+  if (cacheKey && ret && nits >= PREFIX_CACHE_MIN_EXPANSIONS && nits < q->config->maxPrefixExpansions &&
+      !TimedOut(&q->sctx->time.timeout)) {
+    ret = PrefixCache_Materialize(spec->prefixCache, cacheKey, cacheKeyLen, fieldMask, ret, qn->opts.weight);
+  }
+  rm_free(cacheKey);
+  return ret;
 }
 
 /* Evaluate a prefix node by expanding all its possible matches and creating one big UNION on all
@@ -711,15 +971,18 @@ static QueryIterator *Query_EvalWildcardQueryNode(QueryEvalCtx *q, QueryNode *qn
   ctx.cap = 8;
   ctx.its = rm_malloc(sizeof(*ctx.its) * ctx.cap);
   ctx.nits = 0;
+  initDeferredTerms(&ctx);
 
   bool fallbackBruteForce = false;
   // spec support using suffix trie
-  if (spec->suffix) {
+  const bool hasSuffixIndex = spec->suffix || spec->suffixArray;
+  if (hasSuffixIndex) {
     // all modifier fields are supported
     if (qn->opts.fieldMask == RS_FIELDMASK_ALL ||
        (spec->suffixMask & qn->opts.fieldMask) == qn->opts.fieldMask) {
       SuffixCtx sufCtx = {
-        .root = spec->suffix->root,
+        .root = spec->suffix ? spec->suffix->root : NULL,
+        .array = spec->suffixArray,
         .rune = str,
         .runelen = nstr,
         .cstr = token->str,
@@ -738,13 +1001,13 @@ static QueryIterator *Query_EvalWildcardQueryNode(QueryEvalCtx *q, QueryNode *qn
     }
   }
 
-  if (!spec->suffix || fallbackBruteForce) {
+  if (!hasSuffixIndex || fallbackBruteForce) {
     TrieNode_IterateWildcard(t->root, str, nstr, runeIterCb, &ctx, &q->sctx->time.timeout);
   }
 
   rm_free(str);
 
-  return NewUnionIterator(ctx.its, ctx.nits, true, qn->opts.weight, QN_WILDCARD_QUERY, qn->verb.tok.str, q->config);
+  return rangeItersUnion(&ctx, qn->opts.weight, QN_WILDCARD_QUERY, qn->verb.tok.str);
 }
 
 static void rangeItersAddIterator(TrieCallbackCtx *ctx, QueryIterator *it) {
@@ -772,27 +1035,50 @@ static void rangeIterCbStrs(const char *r, size_t n, void *p, void *invidx) {
   rangeItersAddIterator(ctx, ir);
 }
 
+// Add the reader of an expanded term, or defer it if the context is set to
+static void rangeItersAddTerm(TrieCallbackCtx *ctx, RSQueryTerm *term) {
+  QueryEvalCtx *q = ctx->q;
+  const t_fieldMask fieldMask = q->opts->fieldmask & ctx->opts->fieldMask;
+  QueryIterator *ir = NULL;
+  if (q->sctx->spec->diskSpec) {
+    ir = SearchDisk_NewTermIterator(q->sctx->spec->diskSpec, term->str, fieldMask, 1);
+  } else if (ctx->deferred) {
+    InvertedIndex *idx = Redis_OpenTermIndex(q->sctx, term->str, term->len, fieldMask);
+    if (!idx) {
+      Term_Free(term);
+      return;
+    }
+    ctx->deferred[ctx->ndeferred++] = (UnionDeferredChild){
+      .minId = IndexBlock_FirstId(InvertedIndex_BlockRef(idx, 0)),
+      .numEstimated = InvertedIndex_NumDocs(idx),
+      .source = idx,
+      .arg = term,
+    };
+    if (ctx->ndeferred == ctx->deferredCap) {
+      ctx->deferredCap *= 2;
+      ctx->deferred = rm_realloc(ctx->deferred, ctx->deferredCap * sizeof(*ctx->deferred));
+    }
+    return;
+  } else {
+    ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs, fieldMask, 1);
+  }
+  if (ir) {
+    rangeItersAddIterator(ctx, ir);
+  }
+}
+
 static int runeIterCb(const rune *r, size_t n, void *p, void *payload) {
   TrieCallbackCtx *ctx = p;
   QueryEvalCtx *q = ctx->q;
-  if (!RS_IsMock && ctx->nits >= q->config->maxPrefixExpansions) {
+  if (!RS_IsMock && rangeItersNum(ctx) >= q->config->maxPrefixExpansions) {
     QueryError_SetReachedMaxPrefixExpansionsWarning(q->status);
     return REDISEARCH_ERR;
   }
   RSToken tok = {0};
   tok.str = runesToStr(r, n, &tok.len);
-  QueryIterator *ir = NULL;
   RSQueryTerm *term = NewQueryTerm(&tok, ctx->q->tokenId++);
-  if (q->sctx->spec->diskSpec) {
-    ir = SearchDisk_NewTermIterator(q->sctx->spec->diskSpec, term->str, q->opts->fieldmask & ctx->opts->fieldMask, 1);
-  } else {
-    ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs,
-                                        q->opts->fieldmask & ctx->opts->fieldMask, 1);
-  }
+  rangeItersAddTerm(ctx, term);
   rm_free(tok.str);
-  if (ir) {
-    rangeItersAddIterator(ctx, ir);
-  }
 
   return REDISEARCH_OK;
 }
@@ -800,22 +1086,13 @@ static int runeIterCb(const rune *r, size_t n, void *p, void *payload) {
 static int charIterCb(const char *s, size_t n, void *p, void *payload) {
   TrieCallbackCtx *ctx = p;
   QueryEvalCtx *q = ctx->q;
-  if (ctx->nits >= q->config->maxPrefixExpansions) {
+  if (rangeItersNum(ctx) >= q->config->maxPrefixExpansions) {
     QueryError_SetReachedMaxPrefixExpansionsWarning(q->status);
     return REDISEARCH_ERR;
   }
   RSToken tok = {.str = (char *)s, .len = n};
   RSQueryTerm *term = NewQueryTerm(&tok, q->tokenId++);
-  QueryIterator *ir = NULL;
-  if (q->sctx->spec->diskSpec) {
-    ir = SearchDisk_NewTermIterator(q->sctx->spec->diskSpec, term->str, q->opts->fieldmask & ctx->opts->fieldMask, 1);
-  } else {
-    ir = Redis_OpenReader(q->sctx, term, &q->sctx->spec->docs,
-                                        q->opts->fieldmask & ctx->opts->fieldMask, 1);
-  }
-  if (ir) {
-    rangeItersAddIterator(ctx, ir);
-  }
+  rangeItersAddTerm(ctx, term);
 
   return REDISEARCH_OK;
 }
@@ -861,6 +1138,123 @@ static QueryIterator *Query_EvalFuzzyNode(QueryEvalCtx *q, QueryNode *qn) {
   return iterateExpandedTerms(q, terms, qn->pfx.tok.str, strlen(qn->pfx.tok.str), qn->fz.maxDist, 0, &qn->opts);
 }
 
+/* Can the filters intersected by the node be served from the index's filter cache? The cache holds
+ * plain ids, so only queries whose results are not scored, highlighted or checked for term
+ * positions qualify, on indexes whose documents can't match differently as time passes */
+static bool Query_CanCacheFilters(const QueryEvalCtx *q) {
+  const IndexSpec *spec = q->sctx->spec;
+  return RSGlobalConfig.filterCacheMinUses && (q->opts->flags & Search_CanSkipRichResults) &&
+         !q->positionalSubtree && spec->filterCache && !spec->diskSpec &&
+         !(spec->docs.ttl && spec->monitorFieldExpiration);
+}
+
+// A TAG node of plain values, or a NUMERIC or GEO node which doesn't yield its distances
+static bool isCacheableFilter(const QueryNode *qn) {
+  if (qn->opts.flags & QueryNode_YieldsDistance) {
+    return false;
+  }
+  switch (qn->type) {
+    case QN_NUMERIC:
+      return !qn->nn.nf->geoFilter;
+    case QN_GEO:
+      return true;
+    case QN_TAG:
+      for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+        if (qn->children[ii]->type != QN_TOKEN) {
+          return false;
+        }
+      }
+      return QueryNode_NumChildren(qn) > 0;
+    default:
+      return false;
+  }
+}
+
+// The key of a filter, exact on the values it matches (the explain dump rounds the numbers)
+static sds filterKey(const QueryNode *qn) {
+  sds key = sdsnewlen(&qn->type, sizeof(qn->type));
+  switch (qn->type) {
+    case QN_NUMERIC: {
+      const NumericFilter *nf = qn->nn.nf;
+      const uint8_t inclusive = (nf->minInclusive ? 1 : 0) | (nf->maxInclusive ? 2 : 0);
+      key = sdscatlen(key, &nf->fieldSpec->index, sizeof(nf->fieldSpec->index));
+      key = sdscatlen(key, &nf->min, sizeof(nf->min));
+      key = sdscatlen(key, &nf->max, sizeof(nf->max));
+      key = sdscatlen(key, &inclusive, sizeof(inclusive));
+    } break;
+    case QN_GEO: {
+      const GeoFilter *gf = qn->gn.gf;
+      key = sdscatlen(key, &gf->fieldSpec->index, sizeof(gf->fieldSpec->index));
+      key = sdscatlen(key, &gf->lon, sizeof(gf->lon));
+      key = sdscatlen(key, &gf->lat, sizeof(gf->lat));
+      key = sdscatlen(key, &gf->radius, sizeof(gf->radius));
+      key = sdscatlen(key, &gf->unitType, sizeof(gf->unitType));
+    } break;
+    default:
+      key = sdscatlen(key, &qn->tag.fs->index, sizeof(qn->tag.fs->index));
+      for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+        const QueryNode *child = qn->children[ii];
+        key = sdscatlen(key, &child->opts.flags, sizeof(child->opts.flags));
+        key = sdscatlen(key, &child->tn.len, sizeof(child->tn.len));
+        key = sdscatlen(key, child->tn.str, child->tn.len);
+      }
+      break;
+  }
+  return key;
+}
+
+static int cmpFilterKeys(const void *a, const void *b) {
+  const sds x = *(const sds *)a, y = *(const sds *)b;
+  int rc = memcmp(x, y, MIN(sdslen(x), sdslen(y)));
+  return rc ? rc : (sdslen(x) > sdslen(y)) - (sdslen(x) < sdslen(y));
+}
+
+/* Evaluate the filter children of the intersection node at once, as the ids the filter cache holds
+ * for them, or their intersection (materialized once they are used often enough). Marks the
+ * children it evaluated in `isFilter`.
+ * @returns NULL if less than two of the children are filters */
+static QueryIterator *Query_EvalCachedFilters(QueryEvalCtx *q, QueryNode *qn, bool *isFilter) {
+  const size_t n = QueryNode_NumChildren(qn);
+  size_t numFilters = 0;
+  for (size_t ii = 0; ii < n; ++ii) {
+    isFilter[ii] = isCacheableFilter(qn->children[ii]);
+    numFilters += isFilter[ii];
+  }
+  if (numFilters < 2) {
+    return NULL;
+  }
+
+  // The key does not depend on the order of the filters
+  sds keys[numFilters];
+  for (size_t ii = 0, jj = 0; ii < n; ++ii) {
+    if (isFilter[ii]) keys[jj++] = filterKey(qn->children[ii]);
+  }
+  qsort(keys, numFilters, sizeof(*keys), cmpFilterKeys);
+  sds key = sdsempty();
+  for (size_t jj = 0; jj < numFilters; ++jj) {
+    const size_t len = sdslen(keys[jj]);
+    key = sdscatlen(key, &len, sizeof(len));
+    key = sdscatsds(key, keys[jj]);
+    sdsfree(keys[jj]);
+  }
+
+  IndexSpec *spec = q->sctx->spec;
+  const uint64_t revision = __atomic_load_n(&spec->revision, __ATOMIC_RELAXED);
+  QueryIterator *ret = FilterCache_Get(spec->filterCache, revision, key, 1);
+  if (!ret) {
+    QueryIterator **iters = rm_calloc(numFilters, sizeof(*iters));
+    for (size_t ii = 0, jj = 0; ii < n; ++ii) {
+      if (!isFilter[ii]) continue;
+      qn->children[ii]->opts.fieldMask &= qn->opts.fieldMask;
+      iters[jj++] = Query_EvalNode(q, qn->children[ii]);
+    }
+    ret = NewIntersectionIterator(iters, numFilters, -1, false, 1);
+    ret = FilterCache_Materialize(spec->filterCache, revision, key, ret, RSGlobalConfig.filterCacheMinUses, 1);
+  }
+  sdsfree(key);
+  return ret;
+}
+
 static QueryIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
   QueryPhraseNode *node = &qn->pn;
   // an intersect stage with one child is the same as the child, so we just
@@ -870,27 +1264,74 @@ static QueryIterator *Query_EvalPhraseNode(QueryEvalCtx *q, QueryNode *qn) {
     return Query_EvalNode(q, qn->children[0]);
   }
 
+  int slop = 0;
+  bool inOrder = true;
+  if (!node->exact) {
+    // Let the query node override the slop/order parameters
+    slop = qn->opts.maxSlop;
+    if (slop == -1) slop = q->opts->slop;
+
+    // Let the query node override the inorder of the whole query
+    inOrder = (q->opts->flags & Search_InOrder) || qn->opts.inOrder;
+  }
+
   // recursively eval the children
-  QueryIterator **iters = rm_calloc(QueryNode_NumChildren(qn), sizeof(QueryIterator *));
+  bool currently_positionalSubtree = q->positionalSubtree;
+  bool currently_exhaustiveSubtree = q->exhaustiveSubtree;
+  q->positionalSubtree = currently_positionalSubtree || slop >= 0 || inOrder;
+  q->exhaustiveSubtree = true;
+  const size_t numIters = QueryNode_NumChildren(qn);
+  QueryIterator **iters = rm_calloc(numIters, sizeof(QueryIterator *));
+  // The hot filters of the node are read from the filter cache, in the slot of the first of them
+  bool isFilter[numIters];
+  QueryIterator *filters = Query_CanCacheFilters(q) ? Query_EvalCachedFilters(q, qn, isFilter) : NULL;
+  if (!filters) {
+    memset(isFilter, 0, numIters * sizeof(*isFilter));
+  }
+  // A vector range child is evaluated last, so that it may only scan the documents of its
+  // smallest sibling rather than search the whole vector index
+  size_t rangeChild = QueryNode_NumChildren(qn);
+  for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+    const QueryNode *child = qn->children[ii];
+    if (child->type == QN_VECTOR && child->vn.vq->type == VECSIM_QT_RANGE) {
+      rangeChild = ii;
+      break;
+    }
+  }
   for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+    if (ii == rangeChild) continue;
+    if (isFilter[ii]) {
+      iters[ii] = filters;
+      filters = NULL;
+      continue;
+    }
     qn->children[ii]->opts.fieldMask &= qn->opts.fieldMask;
     iters[ii] = Query_EvalNode(q, qn->children[ii]);
   }
-  QueryIterator *ret;
-
-  if (node->exact) {
-    ret = NewIntersectionIterator(iters, QueryNode_NumChildren(qn), 0, true, qn->opts.weight);
-  } else {
-    // Let the query node override the slop/order parameters
-    int slop = qn->opts.maxSlop;
-    if (slop == -1) slop = q->opts->slop;
-
-    // Let the query node override the inorder of the whole query
-    bool inOrder = (q->opts->flags & Search_InOrder) || qn->opts.inOrder;
+  if (rangeChild < QueryNode_NumChildren(qn)) {
+    QueryIterator *filter = NULL;
+    for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+      if (iters[ii] && (!filter || iters[ii]->NumEstimated(iters[ii]) < filter->NumEstimated(filter))) {
+        filter = iters[ii];
+      }
+    }
+    qn->children[rangeChild]->opts.fieldMask &= qn->opts.fieldMask;
+    q->rangeFilter = filter;
+    iters[rangeChild] = Query_EvalNode(q, qn->children[rangeChild]);
+    q->rangeFilter = NULL;
+  }
+  q->positionalSubtree = currently_positionalSubtree;
+  q->exhaustiveSubtree = currently_exhaustiveSubtree;
 
-    ret = NewIntersectionIterator(iters, QueryNode_NumChildren(qn), slop, inOrder, qn->opts.weight);
+  // Drop the slots of the other filters
+  size_t kept = 0;
+  bool seenFilter = false;
+  for (size_t ii = 0; ii < numIters; ++ii) {
+    if (isFilter[ii] && seenFilter) continue;
+    seenFilter |= isFilter[ii];
+    iters[kept++] = iters[ii];
   }
-  return ret;
+  return NewIntersectionIterator(iters, kept, slop, inOrder, qn->opts.weight);
 }
 
 static QueryIterator *Query_EvalWildcardNode(QueryEvalCtx *q, QueryNode *qn) {
@@ -922,8 +1363,15 @@ static QueryIterator *Query_EvalNumericNode(QueryEvalCtx *q, QueryNode *node) {
   RS_LOG_ASSERT(node->type == QN_NUMERIC, "query node type should be numeric")
 
   const FieldSpec *fs = node->nn.nf->fieldSpec;
+  IndexSpec *spec = q->sctx->spec;
+  if (spec->diskSpec && SearchDisk_HasNumeric()) {
+    const NumericFilter *nf = node->nn.nf;
+    return SearchDisk_NewNumericIterator(spec->diskSpec, fs->index, nf->min, nf->max, nf->minInclusive,
+                                         nf->maxInclusive, node->opts.weight);
+  }
   FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index= fs->index}}, .predicate = FIELD_EXPIRATION_DEFAULT};
-  return NewNumericFilterIterator(q->sctx, node->nn.nf, INDEXFLD_T_NUMERIC, q->config, &filterCtx);
+  // The values of the documents are only read by the query optimizer, which has its own iterator
+  return NewNumericFilterIdsIterator(q->sctx, node->nn.nf, q->config, &filterCtx);
 }
 
 static QueryIterator *Query_EvalGeofilterNode(QueryEvalCtx *q, QueryNode *node,
@@ -934,6 +1382,9 @@ static QueryIterator *Query_EvalGeofilterNode(QueryEvalCtx *q, QueryNode *node,
     return NULL;
   }
 
+  if (node->gn.nearest) {
+    return NewGeoNearestIterator(q->sctx, node->gn.gf, node->gn.nearest, q->config);
+  }
   return NewGeoRangeIterator(q->sctx, node->gn.gf, q->config);
 }
 
@@ -1140,22 +1591,35 @@ static void tag_strtolower(char **pstr, size_t *len, int caseSensitive) {
   *len = length;
 }
 
+/* Normalizes the token of a tag query node with tag_strtolower(), which is not idempotent, once for
+ * all the evaluations of the node. Returns false if the token was normalized already */
+static bool tagNode_Normalize(QueryNode *qn, RSToken *tok, int caseSensitive) {
+  if (qn->opts.flags & QueryNode_TagNormalized) {
+    return false;
+  }
+  tag_strtolower(&tok->str, &tok->len, caseSensitive);
+  qn->opts.flags |= QueryNode_TagNormalized;
+  return true;
+}
+
 static QueryIterator *Query_EvalTagLexRangeNode(QueryEvalCtx *q, TagIndex *idx, QueryNode *qn,
                                                 double weight, bool caseSensitive) {
-  TrieMap *t = idx->values;
   TrieCallbackCtx ctx = {.q = q, .opts = &qn->opts, .weight = weight};
 
-  if (!t) {
+  if (!idx->values) {
     return NULL;
   }
 
-  if(qn->lxrng.begin) {
-    size_t beginLen = strlen(qn->lxrng.begin);
-    tag_strtolower(&(qn->lxrng.begin), &beginLen, caseSensitive);
-  }
-  if(qn->lxrng.end) {
-    size_t endLen = strlen(qn->lxrng.end);
-    tag_strtolower(&(qn->lxrng.end), &endLen, caseSensitive);
+  if (!(qn->opts.flags & QueryNode_TagNormalized)) {
+    if(qn->lxrng.begin) {
+      size_t beginLen = strlen(qn->lxrng.begin);
+      tag_strtolower(&(qn->lxrng.begin), &beginLen, caseSensitive);
+    }
+    if(qn->lxrng.end) {
+      size_t endLen = strlen(qn->lxrng.end);
+      tag_strtolower(&(qn->lxrng.end), &endLen, caseSensitive);
+    }
+    qn->opts.flags |= QueryNode_TagNormalized;
   }
 
   ctx.cap = 8;
@@ -1165,8 +1629,8 @@ static QueryIterator *Query_EvalTagLexRangeNode(QueryEvalCtx *q, TagIndex *idx,
   const char *begin = qn->lxrng.begin, *end = qn->lxrng.end;
   int nbegin = begin ? strlen(begin) : -1, nend = end ? strlen(end) : -1;
 
-  TrieMap_IterateRange(t, begin, nbegin, qn->lxrng.includeBegin, end, nend, qn->lxrng.includeEnd,
-                       rangeIterCbStrs, &ctx);
+  TagIndex_IterateRange(idx, begin, nbegin, qn->lxrng.includeBegin, end, nend, qn->lxrng.includeEnd,
+                        rangeIterCbStrs, &ctx);
 
   return NewUnionIterator(ctx.its, ctx.nits, true, qn->opts.weight, QN_LEXRANGE, NULL, q->config);
 }
@@ -1180,7 +1644,7 @@ static QueryIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, Qu
   }
   RSToken *tok = &qn->pfx.tok;
 
-  tag_strtolower(&(tok->str), &tok->len, caseSensitive);
+  tagNode_Normalize(qn, tok, caseSensitive);
 
   // we allow a minimum of 2 letters in the prefix by default (configurable)
   if (tok->len < q->config->minTermPrefix) {
@@ -1200,22 +1664,18 @@ static QueryIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, Qu
         iter_mode = TM_SUFFIX_MODE;
       }
     }
-    TrieMapIterator *it = TrieMap_IterateWithFilter(idx->values, tok->str, tok->len, iter_mode);
-    if (!it) {
-      rm_free(its);
-      return NULL;
-    }
-    TrieMapIterator_SetTimeout(it, q->sctx->time.timeout);
+    TagValuesIterator *it = TagIndex_IterateValues(idx, tok->str, tok->len, iter_mode);
+    TagValuesIterator_SetTimeout(it, q->sctx->time.timeout);
 
 
     // an upper limit on the number of expansions is enforced to avoid stuff like "*"
     char *s;
     tm_len_t sl;
-    void *ptr;
+    InvertedIndex *ptr;
 
     // Find all completions of the prefix
     int hasNext;
-    while ((hasNext = TrieMapIterator_Next(it, &s, &sl, &ptr)) &&
+    while ((hasNext = TagValuesIterator_Next(it, &s, &sl, &ptr)) &&
            (itsSz < q->config->maxPrefixExpansions)) {
       QueryIterator *ret = TagIndex_OpenReader(idx, q->sctx, s, sl, 1, fieldIndex);
       if (!ret) continue;
@@ -1232,7 +1692,7 @@ static QueryIterator *Query_EvalTagPrefixNode(QueryEvalCtx *q, TagIndex *idx, Qu
       QueryError_SetReachedMaxPrefixExpansionsWarning(q->status);
     }
 
-    TrieMapIterator_Free(it);
+    TagValuesIterator_Free(it);
   } else {    // TAG field has suffix triemap
     arrayof(char**) arr = GetList_SuffixTrieMap(idx->suffix, tok->str, tok->len,
                                                 qn->pfx.prefix, q->sctx->time.timeout);
@@ -1274,9 +1734,9 @@ static QueryIterator *Query_EvalTagWildcardNode(QueryEvalCtx *q, TagIndex *idx,
 
   RSToken *tok = &qn->verb.tok;
 
-  tag_strtolower(&(tok->str), &tok->len, caseSensitive);
-
-  tok->len = Wildcard_RemoveEscape(tok->str, tok->len);
+  if (tagNode_Normalize(qn, tok, caseSensitive)) {
+    tok->len = Wildcard_RemoveEscape(tok->str, tok->len);
+  }
 
   size_t itsSz = 0, itsCap = 8;
   QueryIterator **its = rm_malloc(itsCap * sizeof(*its));
@@ -1315,16 +1775,16 @@ static QueryIterator *Query_EvalTagWildcardNode(QueryEvalCtx *q, TagIndex *idx,
 
   if (!idx->suffix || fallbackBruteForce) {
     // brute force wildcard query
-    TrieMapIterator *it = TrieMap_IterateWithFilter(idx->values, tok->str, tok->len, TM_WILDCARD_MODE);
-    TrieMapIterator_SetTimeout(it, q->sctx->time.timeout);
+    TagValuesIterator *it = TagIndex_IterateValues(idx, tok->str, tok->len, TM_WILDCARD_MODE);
+    TagValuesIterator_SetTimeout(it, q->sctx->time.timeout);
 
     char *s;
     tm_len_t sl;
-    void *ptr;
+    InvertedIndex *ptr;
 
     // Find all completions of the prefix
     int hasNext;
-    while ((hasNext = TrieMapIterator_Next(it, &s, &sl, &ptr)) &&
+    while ((hasNext = TagValuesIterator_Next(it, &s, &sl, &ptr)) &&
            (itsSz < q->config->maxPrefixExpansions)) {
       QueryIterator *ret = TagIndex_OpenReader(idx, q->sctx, s, sl, 1, fieldIndex);
       if (!ret) continue;
@@ -1341,12 +1801,66 @@ static QueryIterator *Query_EvalTagWildcardNode(QueryEvalCtx *q, TagIndex *idx,
       QueryError_SetReachedMaxPrefixExpansionsWarning(q->status);
     }
 
-    TrieMapIterator_Free(it);
+    TagValuesIterator_Free(it);
   }
 
   return NewUnionIterator(its, itsSz, true, weight, QN_WILDCARD_QUERY, qn->pfx.tok.str, q->config);
 }
 
+// A value never contains the separator of its field, so a value containing it, such as a list of
+// values passed in a parameter, is split into the values it lists. Returns false if `str` is a
+// single value
+static bool splitTagValues(const FieldSpec *fs, const char *str, size_t len, arrayof(char *) *values) {
+  char sep = fs->tagOpts.tagSep;
+  if (sep == TAG_FIELD_DEFAULT_JSON_SEP || !memchr(str, sep, len)) {
+    return false;
+  }
+  char *buf = rm_strndup(str, len), *p = buf;
+  char *tok;
+  size_t toklen = 0;
+  while ((tok = TagIndex_SepString(sep, &p, &toklen, FieldSpec_IndexesEmpty(fs)))) {
+    array_append(*values, rm_strndup(tok, *tok ? toklen : 0));
+  }
+  rm_free(buf);
+  return true;
+}
+
+// The TAG fields of the disk indexes are written to the disk database, when it supports them, and
+// only their exact values can be looked up
+static bool isDiskTagIndex(const QueryEvalCtx *q) {
+  return q->sctx->spec->diskSpec && SearchDisk_HasTags();
+}
+
+static QueryIterator *openTagReader(QueryEvalCtx *q, TagIndex *idx, const char *value, size_t len,
+                                    double weight, const FieldSpec *fs) {
+  if (isDiskTagIndex(q)) {
+    return SearchDisk_NewTagIterator(q->sctx->spec->diskSpec, fs->index, value, len, weight);
+  }
+  return TagIndex_OpenReader(idx, q->sctx, value, len, weight, fs->index);
+}
+
+// Evaluates the documents having any of the values. When the documents are not scored by the
+// values, and there are enough of them (see `_TAG_SET_MIN_VALUES`), they are read at once into a
+// list of ids. Frees the values
+static QueryIterator *Query_EvalTagValues(QueryEvalCtx *q, TagIndex *idx, arrayof(char *) values,
+                                          double readerWeight, double unionWeight, bool idsOnly,
+                                          const FieldSpec *fs) {
+  size_t n = array_len(values);
+  size_t minValues = RSGlobalConfig.tagSetMinValues;
+  QueryIterator *ret;
+  if (idsOnly && minValues && n >= minValues && !isDiskTagIndex(q)) {
+    ret = TagIndex_OpenSetReader(idx, q->sctx, values, n, unionWeight, fs->index);
+  } else {
+    QueryIterator **its = rm_malloc(n * sizeof(*its));
+    for (size_t i = 0; i < n; i++) {
+      its[i] = openTagReader(q, idx, values[i], strlen(values[i]), readerWeight, fs);
+    }
+    ret = NewUnionIterator(its, n, idsOnly, unionWeight, QN_TAG, NULL, q->config);
+  }
+  array_free_ex(values, rm_free(*(char **)ptr));
+  return ret;
+}
+
 static QueryIterator *query_EvalSingleTagNode(QueryEvalCtx *q, TagIndex *idx, QueryNode *n,
                                               double weight, const FieldSpec *fs) {
   QueryIterator *ret = NULL;
@@ -1358,10 +1872,22 @@ static QueryIterator *query_EvalSingleTagNode(QueryEvalCtx *q, TagIndex *idx, Qu
                   (q->reqFlags & QEXEC_F_IS_HYBRID_VECTOR_AGGREGATE_SUBQUERY);
   double effective_weight = is_hybrid ? 0.0 : weight;
 
+  if (isDiskTagIndex(q) && n->type != QN_TOKEN && n->type != QN_PHRASE) {
+    QueryError_SetError(q->status, QUERY_ERROR_CODE_UNSUPP_TYPE,
+                        "Disk indexes only support exact TAG values");
+    return NULL;
+  }
+
   switch (n->type) {
     case QN_TOKEN: {
-      tag_strtolower(&(n->tn.str), &n->tn.len, caseSensitive);
-      ret = TagIndex_OpenReader(idx, q->sctx, n->tn.str, n->tn.len, effective_weight, fs->index);
+      tagNode_Normalize(n, &n->tn, caseSensitive);
+      arrayof(char *) values = array_new(char *, 8);
+      if (splitTagValues(fs, n->tn.str, n->tn.len, &values)) {
+        return Query_EvalTagValues(q, idx, values, effective_weight, weight,
+                                   q->notSubtree || weight == 0, fs);
+      }
+      array_free(values);
+      ret = openTagReader(q, idx, n->tn.str, n->tn.len, effective_weight, fs);
       break;
     }
     case QN_PREFIX:
@@ -1379,7 +1905,7 @@ static QueryIterator *query_EvalSingleTagNode(QueryEvalCtx *q, TagIndex *idx, Qu
       char *terms[QueryNode_NumChildren(n)];
       for (size_t i = 0; i < QueryNode_NumChildren(n); ++i) {
         if (n->children[i]->type == QN_TOKEN) {
-          tag_strtolower(&(n->children[i]->tn.str), &n->children[i]->tn.len, caseSensitive);
+          tagNode_Normalize(n->children[i], &n->children[i]->tn, caseSensitive);
           terms[i] = n->children[i]->tn.str;
         } else {
           terms[i] = "";
@@ -1388,7 +1914,7 @@ static QueryIterator *query_EvalSingleTagNode(QueryEvalCtx *q, TagIndex *idx, Qu
 
       sds s = sdsjoin(terms, QueryNode_NumChildren(n), " ");
 
-      ret = TagIndex_OpenReader(idx, q->sctx, s, sdslen(s), effective_weight, fs->index);
+      ret = openTagReader(q, idx, s, sdslen(s), effective_weight, fs);
       sdsfree(s);
       break;
     }
@@ -1406,7 +1932,7 @@ static QueryIterator *Query_EvalTagNode(QueryEvalCtx *q, QueryNode *qn) {
   RedisModuleString *kstr = IndexSpec_GetFormattedKey(q->sctx->spec, node->fs, INDEXFLD_T_TAG);
   TagIndex *idx = TagIndex_Open(q->sctx->spec, kstr, DONT_CREATE_INDEX);
 
-  if (!idx) {
+  if (!idx && !isDiskTagIndex(q)) {
     // There are no documents to traverse.
     return NULL;
   }
@@ -1415,15 +1941,38 @@ static QueryIterator *Query_EvalTagNode(QueryEvalCtx *q, QueryNode *qn) {
     return query_EvalSingleTagNode(q, idx, qn->children[0], qn->opts.weight, node->fs);
   }
 
+  // We want to get results with all the matching children (`quickExit == false`), unless:
+  // 1. We are a `Not` sub-tree, so we only care about the set of IDs
+  // 2. The node's weight is 0, which means the sub-tree is not relevant for scoring.
+  bool quickExit = q->notSubtree || qn->opts.weight == 0;
+
+  // A list of plain values, such as `@perm:{a | b | c ...}`, is evaluated as a set of values
+  bool allTokens = true;
+  for (size_t i = 0; i < QueryNode_NumChildren(qn) && allTokens; i++) {
+    allTokens = qn->children[i]->type == QN_TOKEN;
+  }
+  if (allTokens) {
+    const FieldSpec *fs = node->fs;
+    bool caseSensitive = fs->tagOpts.tagFlags & TagField_CaseSensitive;
+    bool is_hybrid = (q->reqFlags & QEXEC_F_IS_HYBRID_SEARCH_SUBQUERY) ||
+                     (q->reqFlags & QEXEC_F_IS_HYBRID_VECTOR_AGGREGATE_SUBQUERY);
+    arrayof(char *) values = array_new(char *, QueryNode_NumChildren(qn));
+    for (size_t i = 0; i < QueryNode_NumChildren(qn); i++) {
+      QueryNode *child = qn->children[i];
+      tagNode_Normalize(child, &child->tn, caseSensitive);
+      if (!splitTagValues(fs, child->tn.str, child->tn.len, &values)) {
+        array_append(values, rm_strndup(child->tn.str, child->tn.len));
+      }
+    }
+    return Query_EvalTagValues(q, idx, values, is_hybrid ? 0.0 : qn->opts.weight, qn->opts.weight,
+                               quickExit, fs);
+  }
+
   // recursively eval the children
   QueryIterator **iters = rm_malloc(QueryNode_NumChildren(qn) * sizeof(QueryIterator *));
   for (size_t i = 0; i < QueryNode_NumChildren(qn); i++) {
     iters[i] = query_EvalSingleTagNode(q, idx, qn->children[i], qn->opts.weight, node->fs);
   }
-  // We want to get results with all the matching children (`quickExit == false`), unless:
-  // 1. We are a `Not` sub-tree, so we only care about the set of IDs
-  // 2. The node's weight is 0, which means the sub-tree is not relevant for scoring.
-  bool quickExit = q->notSubtree || qn->opts.weight == 0;
   return NewUnionIterator(iters, QueryNode_NumChildren(qn), quickExit, qn->opts.weight, QN_TAG, NULL, q->config);
 }
 
@@ -1548,6 +2097,8 @@ QueryIterator *QAST_Iterate(QueryAST *qast, const RSSearchOptions *opts, RedisSe
   if (!root) {
     // Return the dummy iterator
     root = NewEmptyIterator();
+  } else if (opts->sampleRatio > 0 && opts->sampleRatio < 1) {
+    root = NewSampleIterator(root, opts->sampleRatio);
   }
   return root;
 }
@@ -1572,6 +2123,7 @@ void QAST_Destroy(QueryAST *q) {
   rm_free(q->query);
   q->nquery = 0;
   q->query = NULL;
+  q->hash = 0;
 }
 
 int QAST_Expand(QueryAST *q, const char *expander, RSSearchOptions *opts, RedisSearchCtx *sctx,
@@ -1603,6 +2155,317 @@ int QAST_EvalParams(QueryAST *q, RSSearchOptions *opts, unsigned int dialectVers
   return REDISMODULE_OK;
 }
 
+/* Canonical form of the tree of a query.
+ *
+ * The hash of a node covers its type, its options and its values, and the hashes of its children.
+ * The children of a union, of a tag node, and of an intersection which is not positional, match the
+ * same documents in any order, so their hashes are sorted before being combined. */
+
+// An intersection which matches its children in any order and at any distance from each other
+static bool isUnorderedPhrase(const QueryNode *qn, bool ordered) {
+  return qn->type == QN_PHRASE && !qn->pn.exact && !ordered && qn->opts.maxSlop == -1 &&
+         !qn->opts.inOrder;
+}
+
+static bool isCommutative(const QueryNode *qn, bool ordered) {
+  return qn->type == QN_UNION || qn->type == QN_TAG || isUnorderedPhrase(qn, ordered);
+}
+
+static uint64_t hashString(const char *s, size_t len, uint64_t h) {
+  h = fnv_64a_buf(&len, sizeof(len), h);
+  return len ? fnv_64a_buf(s, len, h) : h;
+}
+
+static uint64_t hashField(const FieldSpec *fs, uint64_t h) {
+  const t_fieldIndex index = fs ? fs->index : RS_INVALID_FIELD_INDEX;
+  return fnv_64a_buf(&index, sizeof(index), h);
+}
+
+static uint64_t hashToken(const RSToken *tok, uint64_t h) {
+  const uint32_t flags = tok->flags, expanded = tok->expanded;
+  h = hashString(tok->str, tok->str ? tok->len : 0, h);
+  h = fnv_64a_buf(&flags, sizeof(flags), h);
+  return fnv_64a_buf(&expanded, sizeof(expanded), h);
+}
+
+static uint64_t hashNumericFilter(const NumericFilter *nf, uint64_t h) {
+  const uint8_t inclusive = (nf->minInclusive ? 1 : 0) | (nf->maxInclusive ? 2 : 0) |
+                            (nf->geoFilter ? 4 : 0);
+  h = hashField(nf->fieldSpec, h);
+  h = fnv_64a_buf(&nf->min, sizeof(nf->min), h);
+  h = fnv_64a_buf(&nf->max, sizeof(nf->max), h);
+  return fnv_64a_buf(&inclusive, sizeof(inclusive), h);
+}
+
+static uint64_t hashVectorQuery(const VectorQuery *vq, uint64_t h) {
+  h = hashField(vq->field, h);
+  h = fnv_64a_buf(&vq->type, sizeof(vq->type), h);
+  if (vq->type == VECSIM_QT_KNN) {
+    h = hashString(vq->knn.vector, vq->knn.vecLen, h);
+    h = fnv_64a_buf(&vq->knn.k, sizeof(vq->knn.k), h);
+    h = fnv_64a_buf(&vq->knn.shardWindowRatio, sizeof(vq->knn.shardWindowRatio), h);
+    h = fnv_64a_buf(&vq->knn.rerankFactor, sizeof(vq->knn.rerankFactor), h);
+  } else {
+    h = hashString(vq->range.vector, vq->range.vecLen, h);
+    h = fnv_64a_buf(&vq->range.radius, sizeof(vq->range.radius), h);
+  }
+  for (size_t ii = 0; ii < array_len(vq->params.params); ++ii) {
+    const VecSimRawParam *param = vq->params.params + ii;
+    h = hashString(param->name, param->nameLen, h);
+    h = hashString(param->value, param->valLen, h);
+  }
+  return vq->scoreField ? hashString(vq->scoreField, strlen(vq->scoreField), h) : h;
+}
+
+static uint64_t hashOptions(const QueryNodeOptions *opts, uint64_t h) {
+  // Whether the tag values were normalized already doesn't change what they match
+  const QueryNodeFlags flags = opts->flags & ~QueryNode_TagNormalized;
+  h = fnv_64a_buf(&flags, sizeof(flags), h);
+  h = fnv_64a_buf(&opts->fieldMask, sizeof(opts->fieldMask), h);
+  h = fnv_64a_buf(&opts->maxSlop, sizeof(opts->maxSlop), h);
+  h = fnv_64a_buf(&opts->inOrder, sizeof(opts->inOrder), h);
+  h = fnv_64a_buf(&opts->weight, sizeof(opts->weight), h);
+  h = fnv_64a_buf(&opts->phonetic, sizeof(opts->phonetic), h);
+  return opts->distField ? hashString(opts->distField, strlen(opts->distField), h) : h;
+}
+
+static int cmpHashes(const void *a, const void *b) {
+  const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static uint64_t hashNode(const QueryNode *qn, bool ordered) {
+  uint64_t h = fnv_64a_buf(&qn->type, sizeof(qn->type), 0);
+  h = hashOptions(&qn->opts, h);
+  switch (qn->type) {
+    case QN_PHRASE:
+      h = fnv_64a_buf(&qn->pn.exact, sizeof(qn->pn.exact), h);
+      break;
+    case QN_TOKEN:
+      h = hashToken(&qn->tn, h);
+      break;
+    case QN_PREFIX: {
+      const uint8_t ends = (qn->pfx.prefix ? 1 : 0) | (qn->pfx.suffix ? 2 : 0);
+      h = hashToken(&qn->pfx.tok, h);
+      h = fnv_64a_buf(&ends, sizeof(ends), h);
+    } break;
+    case QN_FUZZY:
+      h = hashToken(&qn->fz.tok, h);
+      h = fnv_64a_buf(&qn->fz.maxDist, sizeof(qn->fz.maxDist), h);
+      break;
+    case QN_WILDCARD_QUERY:
+      h = hashToken(&qn->verb.tok, h);
+      break;
+    case QN_TAG:
+      h = hashField(qn->tag.fs, h);
+      break;
+    case QN_NUMERIC:
+      h = hashNumericFilter(qn->nn.nf, h);
+      break;
+    case QN_GEO: {
+      const GeoFilter *gf = qn->gn.gf;
+      h = hashField(gf->fieldSpec, h);
+      h = fnv_64a_buf(&gf->lon, sizeof(gf->lon), h);
+      h = fnv_64a_buf(&gf->lat, sizeof(gf->lat), h);
+      h = fnv_64a_buf(&gf->radius, sizeof(gf->radius), h);
+      h = fnv_64a_buf(&gf->unitType, sizeof(gf->unitType), h);
+      h = fnv_64a_buf(&qn->gn.nearest, sizeof(qn->gn.nearest), h);
+    } break;
+    case QN_GEOMETRY: {
+      const GeometryQuery *geomq = qn->gmn.geomq;
+      h = hashField(geomq->fs, h);
+      h = fnv_64a_buf(&geomq->format, sizeof(geomq->format), h);
+      h = fnv_64a_buf(&geomq->query_type, sizeof(geomq->query_type), h);
+      h = hashString(geomq->str, geomq->str_len, h);
+    } break;
+    case QN_VECTOR:
+      h = hashVectorQuery(qn->vn.vq, h);
+      break;
+    case QN_IDS:
+      for (size_t ii = 0; ii < qn->fn.len; ++ii) {
+        h = hashString(qn->fn.keys[ii], sdslen(qn->fn.keys[ii]), h);
+      }
+      break;
+    case QN_LEXRANGE: {
+      const QueryLexRangeNode *lx = &qn->lxrng;
+      const uint8_t include = (lx->includeBegin ? 1 : 0) | (lx->includeEnd ? 2 : 0) |
+                              (lx->begin ? 4 : 0) | (lx->end ? 8 : 0);
+      h = fnv_64a_buf(&include, sizeof(include), h);
+      if (lx->begin) h = hashString(lx->begin, strlen(lx->begin), h);
+      if (lx->end) h = hashString(lx->end, strlen(lx->end), h);
+    } break;
+    case QN_MISSING:
+      h = hashField(qn->miss.field, h);
+      break;
+    case QN_UNION:
+    case QN_NOT:
+    case QN_OPTIONAL:
+    case QN_WILDCARD:
+    case QN_NULL:
+    case QN_MAX:
+      break;
+  }
+
+  const size_t n = QueryNode_NumChildren(qn);
+  if (!n) {
+    return h;
+  }
+  uint64_t *hashes = rm_malloc(n * sizeof(*hashes));
+  for (size_t ii = 0; ii < n; ++ii) {
+    hashes[ii] = hashNode(qn->children[ii], ordered);
+  }
+  if (isCommutative(qn, ordered)) {
+    qsort(hashes, n, sizeof(*hashes), cmpHashes);
+  }
+  h = fnv_64a_buf(&n, sizeof(n), h);
+  h = fnv_64a_buf(hashes, n * sizeof(*hashes), h);
+  rm_free(hashes);
+  return h;
+}
+
+// The whole query matches its intersections in order, or within a distance
+static bool isOrderedQuery(const RSSearchOptions *opts) {
+  return opts && (opts->slop != -1 || (opts->flags & Search_InOrder));
+}
+
+uint64_t QueryNode_Hash(const QueryNode *qn, const RSSearchOptions *opts) {
+  return qn ? hashNode(qn, isOrderedQuery(opts)) : 0;
+}
+
+// A node with none of the options a query may set on it, which is thus the same as its children
+// within a parent of its own type
+static bool hasDefaultOptions(const QueryNode *qn) {
+  const QueryNodeOptions *opts = &qn->opts;
+  return !opts->flags && opts->fieldMask == RS_FIELDMASK_ALL && opts->maxSlop == -1 &&
+         !opts->inOrder && opts->weight == 1 && opts->phonetic == PHONETIC_DEFAULT &&
+         !opts->distField && !QueryNode_NumParams(qn);
+}
+
+static bool isFoldable(const QueryNode *qn, bool ordered) {
+  return (qn->type == QN_UNION || isUnorderedPhrase(qn, ordered)) && hasDefaultOptions(qn);
+}
+
+static bool isSameTerm(const QueryNode *a, const QueryNode *b) {
+  const QueryNodeOptions *x = &a->opts, *y = &b->opts;
+  return a->type == QN_TOKEN && b->type == QN_TOKEN && a->tn.len == b->tn.len &&
+         a->tn.flags == b->tn.flags && a->tn.expanded == b->tn.expanded &&
+         !memcmp(a->tn.str, b->tn.str, a->tn.len) && x->flags == y->flags &&
+         x->fieldMask == y->fieldMask && x->weight == y->weight && x->phonetic == y->phonetic &&
+         !x->distField && !y->distField && !QueryNode_NumParams(a) && !QueryNode_NumParams(b);
+}
+
+// Move the children of the children of the same type as the node into it, in their place
+static void foldChildren(QueryNode *qn, bool ordered) {
+  const size_t n = QueryNode_NumChildren(qn);
+  size_t folded = 0;
+  for (size_t ii = 0; ii < n; ++ii) {
+    const QueryNode *child = qn->children[ii];
+    folded += child->type == qn->type && isFoldable(child, ordered);
+  }
+  if (!folded) {
+    return;
+  }
+  QueryNode **children = array_new(QueryNode *, n);
+  for (size_t ii = 0; ii < n; ++ii) {
+    QueryNode *child = qn->children[ii];
+    if (child->type == qn->type && isFoldable(child, ordered)) {
+      array_ensure_append_n(children, child->children, QueryNode_NumChildren(child));
+      QueryNode_ClearChildren(child, 0);
+      QueryNode_Free(child);
+    } else {
+      array_append(children, child);
+    }
+  }
+  array_free(qn->children);
+  qn->children = children;
+}
+
+typedef struct {
+  uint64_t hash;
+  size_t pos;
+} TermHash;
+
+static int cmpTermHashes(const void *a, const void *b) {
+  const TermHash *x = a, *y = b;
+  if (x->hash != y->hash) return (x->hash > y->hash) - (x->hash < y->hash);
+  return (x->pos > y->pos) - (x->pos < y->pos);
+}
+
+// Drop the repeated terms among the children of the node, keeping the first of each
+static void dedupTerms(QueryNode *qn) {
+  const size_t n = QueryNode_NumChildren(qn);
+  if (n < 2) {
+    return;
+  }
+  TermHash *terms = rm_malloc(n * sizeof(*terms));
+  size_t numTerms = 0;
+  for (size_t ii = 0; ii < n; ++ii) {
+    if (qn->children[ii]->type == QN_TOKEN) {
+      terms[numTerms++] = (TermHash){.hash = hashNode(qn->children[ii], false), .pos = ii};
+    }
+  }
+  qsort(terms, numTerms, sizeof(*terms), cmpTermHashes);
+  bool *repeated = rm_calloc(n, sizeof(*repeated));
+  size_t numRepeated = 0;
+  for (size_t jj = 1; jj < numTerms; ++jj) {
+    const QueryNode *term = qn->children[terms[jj].pos];
+    for (size_t kk = jj; kk-- > 0 && terms[kk].hash == terms[jj].hash;) {
+      if (!repeated[terms[kk].pos] && isSameTerm(qn->children[terms[kk].pos], term)) {
+        repeated[terms[jj].pos] = true;
+        numRepeated++;
+        break;
+      }
+    }
+  }
+  if (numRepeated) {
+    size_t kept = 0;
+    for (size_t ii = 0; ii < n; ++ii) {
+      if (repeated[ii]) {
+        QueryNode_Free(qn->children[ii]);
+      } else {
+        qn->children[kept++] = qn->children[ii];
+      }
+    }
+    qn->children = array_trimm_len(qn->children, numRepeated);
+  }
+  rm_free(repeated);
+  rm_free(terms);
+}
+
+// Returns the node in place of `qn`, which is released if it is redundant
+static QueryNode *canonicalizeNode(QueryNode *qn, bool ordered) {
+  // The children of a tag node are its values, which are matched as a whole
+  for (size_t ii = 0; qn->type != QN_TAG && ii < QueryNode_NumChildren(qn); ++ii) {
+    qn->children[ii] = canonicalizeNode(qn->children[ii], ordered);
+  }
+  if (qn->type == QN_UNION || isUnorderedPhrase(qn, ordered)) {
+    foldChildren(qn, ordered);
+  }
+  if (isCommutative(qn, ordered)) {
+    dedupTerms(qn);
+  }
+  if (QueryNode_NumChildren(qn) == 1 && isFoldable(qn, ordered)) {
+    QueryNode *child = qn->children[0];
+    QueryNode_ClearChildren(qn, 0);
+    QueryNode_Free(qn);
+    return child;
+  }
+  return qn;
+}
+
+void QAST_Canonicalize(QueryAST *q, const RSSearchOptions *opts) {
+  if (!q->root) {
+    return;
+  }
+  const bool ordered = isOrderedQuery(opts);
+  // Folding the nodes and dropping the repeated terms keeps the same documents, but not the same
+  // scores, nor the terms the highlighter would see
+  if (opts->flags & Search_CanSkipRichResults) {
+    q->root = canonicalizeNode(q->root, ordered);
+  }
+  q->hash = hashNode(q->root, ordered);
+}
+
 int QueryNode_EvalParams(dict *params, QueryNode *n, unsigned int dialectVersion, QueryError *status) {
   int withChildren = 1;
   int res = REDISMODULE_OK;
@@ -2079,6 +2942,32 @@ char *QAST_DumpExplain(const QueryAST *q, const IndexSpec *spec) {
   return ret;
 }
 
+static sds QueryNode_DumpObfuscated(sds s, QueryNode *qn) {
+  s = sdscat(s, Obfuscate_QueryNode(qn));
+  if (QueryNode_NumChildren(qn)) {
+    s = sdscat(s, "{");
+    for (size_t ii = 0; ii < QueryNode_NumChildren(qn); ++ii) {
+      if (ii) s = sdscat(s, " ");
+      s = QueryNode_DumpObfuscated(s, qn->children[ii]);
+    }
+    s = sdscat(s, "}");
+  }
+  return s;
+}
+
+/* Return the shape of the query parse tree on a single line, with the types of its nodes and none of
+ * their terms or values. The string should be freed by the caller */
+char *QAST_DumpObfuscated(const QueryAST *q) {
+  if (!q || !q->root) {
+    return rm_strdup("NULL");
+  }
+
+  sds s = QueryNode_DumpObfuscated(sdsempty(), q->root);
+  char *ret = rm_strndup(s, sdslen(s));
+  sdsfree(s);
+  return ret;
+}
+
 // Debugging function to print the query parse tree
 void QAST_Print(const QueryAST *ast, const IndexSpec *spec) {
   sds s = QueryNode_DumpSds(sdsnew(""), spec, ast->root, 0);
@@ -2128,6 +3017,23 @@ static int ValidateShardKRatio(const char *value, double *ratio, QueryError *sta
   return 1;
 }
 
+static int ValidateRerankFactor(const char *value, double *factor, QueryError *status) {
+  if (!ParseDouble(value, factor, 1)) {
+    QueryError_SetWithUserDataFmt(status, QUERY_ERROR_CODE_INVAL,
+      "Invalid rerank factor value", " '%s'", value);
+    return 0;
+  }
+
+  if (*factor < DEFAULT_RERANK_FACTOR || *factor > MAX_RERANK_FACTOR) {
+    QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_INVAL,
+      "Invalid rerank factor value: Rerank factor must be between %g and %g (got %g)",
+      DEFAULT_RERANK_FACTOR, MAX_RERANK_FACTOR, *factor);
+    return 0;
+  }
+
+  return 1;
+}
+
 // Convert the query attribute into a raw vector param to be resolved by the vector iterator
 // down the road. return 0 in case of an unrecognized parameter.
 static int QueryVectorNode_ApplyAttribute(VectorQuery *vq, QueryAttribute *attr, QueryError *status) {
@@ -2138,6 +3044,13 @@ static int QueryVectorNode_ApplyAttribute(VectorQuery *vq, QueryAttribute *attr,
     }
     vq->knn.shardWindowRatio = ratio;
     return 1;
+  } else if (STR_EQCASE(attr->name, attr->namelen, RERANK_FACTOR_ATTR)) {
+    double factor;
+    if (!ValidateRerankFactor(attr->value, &factor, status)) {
+      return 0;
+    }
+    vq->knn.rerankFactor = factor;
+    return 1;
   } else if (STR_EQCASE(attr->name, attr->namelen, VECSIM_EFRUNTIME) ||
              STR_EQCASE(attr->name, attr->namelen, VECSIM_EPSILON) ||
              STR_EQCASE(attr->name, attr->namelen, VECSIM_HYBRID_POLICY) ||
@@ -80,6 +80,9 @@ typedef struct QueryAST {
 
   // Flags indicating which syntax features are enabled for this query
   QAST_ValidationFlags validationFlags;
+
+  // The structural hash of the tree, set by QAST_Canonicalize()
+  uint64_t hash;
 } QueryAST;
 
 /**
@@ -150,9 +153,24 @@ int QAST_EvalParams(QueryAST *q, RSSearchOptions *opts, unsigned int dialectVers
 int QueryNode_EvalParams(dict *params, QueryNode *node, unsigned int dialectVersion, QueryError *status);
 
 int QAST_CheckIsValid(QueryAST *q, IndexSpec *spec, RSSearchOptions *opts, QueryError *status);
+
+/**
+ * Bring the tree into its canonical form, and set its structural hash. The hash is the same for the
+ * trees which differ only in the order of the children of their unions, tag nodes, and intersections
+ * which are not positional, so the caches may use it as the identity of the query.
+ * If the query doesn't need its scores nor its highlighted terms, the unions and intersections of
+ * default options are also folded into their parents of the same type, or replaced by their only
+ * child, and the repeated terms among the children of these nodes are dropped.
+ */
+void QAST_Canonicalize(QueryAST *q, const RSSearchOptions *opts);
+/* The structural hash of the subtree of a node, as QAST_Canonicalize() computes it */
+uint64_t QueryNode_Hash(const QueryNode *qn, const RSSearchOptions *opts);
 /* Return a string representation of the QueryParseCtx parse tree. The string should be freed by the
  * caller */
 char *QAST_DumpExplain(const QueryAST *q, const IndexSpec *spec);
+/* Return the shape of the parse tree on a single line, without its terms or values, e.g.
+ * `Phrase{Token Union{Tag Tag}}`. The string should be freed by the caller */
+char *QAST_DumpObfuscated(const QueryAST *q);
 
 /** Print a representation of the query to standard output */
 void QAST_Print(const QueryAST *ast, const IndexSpec *spec);
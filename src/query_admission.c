@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "query_admission.h"
+#include "config.h"
+#include "rmalloc.h"
+#include "util/workers.h"
+#include "iterators/intersection_iterator.h"
+#include <pthread.h>
+
+typedef struct WaitingQuery {
+  redisearch_thpool_proc resume;
+  void *arg;
+  struct WaitingQuery *next;
+} WaitingQuery;
+
+typedef struct {
+  QueryClassStats stats;
+  WaitingQuery *head;
+  WaitingQuery *tail;
+} QueryClass;
+
+static QueryClass classes_g[QUERY_CLASS__NUM];
+static pthread_mutex_t admissionLock_g = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *classNames_g[QUERY_CLASS__NUM] = {
+  [QUERY_CLASS_CHEAP] = "cheap",
+  [QUERY_CLASS_HEAVY] = "heavy",
+};
+
+static size_t iteratorCost(QueryIterator *it) {
+  if (it->type == INTERSECT_ITERATOR) {
+    IntersectionIterator *ii = (IntersectionIterator *)it;
+    size_t cost = 0;
+    for (uint32_t i = 0; i < ii->num_its; i++) {
+      cost += iteratorCost(ii->its[i]);
+    }
+    return cost;
+  }
+  return it->NumEstimated(it);
+}
+
+size_t QueryAdmission_Cost(QueryIterator *root, const AGGPlan *plan) {
+  size_t cost = root ? iteratorCost(root) : 0;
+  size_t passes = 1;
+  if (plan) {
+    const PLN_BaseStep *end = PLN_END_STEP(plan);
+    for (const PLN_BaseStep *step = PLN_NEXT_STEP(end); step != end; step = PLN_NEXT_STEP(step)) {
+      switch (step->type) {
+        case PLN_T_GROUP:
+        case PLN_T_APPLY:
+        case PLN_T_FILTER:
+          passes++;
+          break;
+        case PLN_T_ARRANGE:
+          passes += ((const PLN_ArrangeStep *)step)->sortKeys != NULL;
+          break;
+        case PLN_T_LOAD:
+          passes += !!(step->flags & PLN_F_LOAD_ALL);
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  return cost * passes;
+}
+
+QueryCostClass QueryAdmission_Classify(size_t cost) {
+  size_t threshold = RSGlobalConfig.heavyQueryCost;
+  return threshold && cost >= threshold ? QUERY_CLASS_HEAVY : QUERY_CLASS_CHEAP;
+}
+
+/* The number of queries of the class which may run at once, 0 for unlimited */
+static size_t maxRunning(QueryCostClass cls) {
+  return cls == QUERY_CLASS_HEAVY ? RSGlobalConfig.maxRunningHeavyQueries : 0;
+}
+
+QueryAdmission QueryAdmission_Enter(QueryCostClass cls, redisearch_thpool_proc resume, void *arg) {
+  QueryClass *qc = &classes_g[cls];
+  size_t max = maxRunning(cls);
+  QueryAdmission rc = QUERY_ADMIT_RUN;
+
+  pthread_mutex_lock(&admissionLock_g);
+  if (!max || qc->stats.running < max) {
+    qc->stats.running++;
+    qc->stats.admitted++;
+  } else if (qc->stats.waiting < RSGlobalConfig.maxWaitingHeavyQueries) {
+    WaitingQuery *wq = rm_new(WaitingQuery);
+    *wq = (WaitingQuery){.resume = resume, .arg = arg};
+    if (qc->tail) {
+      qc->tail->next = wq;
+    } else {
+      qc->head = wq;
+    }
+    qc->tail = wq;
+    qc->stats.waiting++;
+    qc->stats.queued++;
+    rc = QUERY_ADMIT_WAIT;
+  } else {
+    qc->stats.rejected++;
+    rc = QUERY_ADMIT_REJECT;
+  }
+  pthread_mutex_unlock(&admissionLock_g);
+  return rc;
+}
+
+void QueryAdmission_Exit(QueryCostClass cls) {
+  QueryClass *qc = &classes_g[cls];
+  size_t max = maxRunning(cls);
+  WaitingQuery *admitted = NULL, **last = &admitted;
+
+  pthread_mutex_lock(&admissionLock_g);
+  qc->stats.running--;
+  // The limit may have been raised since the queries were queued
+  while (qc->head && (!max || qc->stats.running < max)) {
+    WaitingQuery *wq = qc->head;
+    qc->head = wq->next;
+    if (!qc->head) {
+      qc->tail = NULL;
+    }
+    wq->next = NULL;
+    *last = wq;
+    last = &wq->next;
+    qc->stats.waiting--;
+    qc->stats.running++;
+  }
+  pthread_mutex_unlock(&admissionLock_g);
+
+  while (admitted) {
+    WaitingQuery *next = admitted->next;
+    workersThreadPool_AddWork(admitted->resume, admitted->arg);
+    rm_free(admitted);
+    admitted = next;
+  }
+}
+
+const char *QueryAdmission_ClassName(QueryCostClass cls) {
+  return classNames_g[cls];
+}
+
+QueryClassStats QueryAdmission_GetStats(QueryCostClass cls) {
+  pthread_mutex_lock(&admissionLock_g);
+  QueryClassStats stats = classes_g[cls].stats;
+  pthread_mutex_unlock(&admissionLock_g);
+  return stats;
+}
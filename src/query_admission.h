@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include "iterators/iterator_api.h"
+#include "aggregate/aggregate_plan.h"
+#include "thpool/thpool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Admission control of the queries running on the workers.
+ *
+ * Once the iterators of a query are built, its cost is estimated from them and from its plan, and
+ * the queries costing at least `_HEAVY_QUERY_COST` are heavy. At most `_MAX_RUNNING_HEAVY_QUERIES`
+ * heavy queries run at once, so that a burst of them leaves workers to the cheap ones. The others
+ * wait in a FIFO queue, without holding a worker or the spec lock, and are rejected once
+ * `_MAX_WAITING_HEAVY_QUERIES` are waiting. Cheap queries are always admitted */
+
+typedef enum {
+  QUERY_CLASS_CHEAP = 0,
+  QUERY_CLASS_HEAVY,
+  QUERY_CLASS__NUM,
+} QueryCostClass;
+
+typedef enum {
+  QUERY_ADMIT_RUN = 0,  // The query may run now
+  QUERY_ADMIT_WAIT,     // The query is queued, and will be resumed on the workers
+  QUERY_ADMIT_REJECT,   // The queue of the class is full
+} QueryAdmission;
+
+typedef struct {
+  size_t admitted;  // Queries which ran right away
+  size_t queued;    // Queries which waited for another of the class to finish
+  size_t rejected;
+  size_t running;   // Queries of the class running now
+  size_t waiting;   // Queries of the class waiting now
+} QueryClassStats;
+
+/* The estimated cost of a query: the number of documents its iterators read, times one plus the
+ * number of its steps which go over all the rows (GROUPBY, SORTBY, APPLY, FILTER, LOAD *).
+ * An intersection reads its children up to the id of the scarcest one, so they are summed */
+size_t QueryAdmission_Cost(QueryIterator *root, const AGGPlan *plan);
+
+/* The class of a query of the given cost, according to `_HEAVY_QUERY_COST` */
+QueryCostClass QueryAdmission_Classify(size_t cost);
+
+/* Ask to run a query of the class. On QUERY_ADMIT_WAIT, `resume(arg)` is added to the workers
+ * once the query is admitted. Every admitted query (whether it ran right away or was resumed) must
+ * call QueryAdmission_Exit() when done */
+QueryAdmission QueryAdmission_Enter(QueryCostClass cls, redisearch_thpool_proc resume, void *arg);
+
+/* An admitted query of the class is done. Its slot goes to the next waiting query, if any */
+void QueryAdmission_Exit(QueryCostClass cls);
+
+/* The name of the class, for the stats */
+const char *QueryAdmission_ClassName(QueryCostClass cls);
+
+QueryClassStats QueryAdmission_GetStats(QueryCostClass cls);
+
+#ifdef __cplusplus
+}
+#endif
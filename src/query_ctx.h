@@ -12,6 +12,7 @@
 #include "util/timeout.h"
 
 struct MetricRequest;
+struct QueryIterator;
 
 typedef struct QueryEvalCtx {
   RedisSearchCtx *sctx;
@@ -24,4 +25,9 @@ typedef struct QueryEvalCtx {
   uint32_t reqFlags;
   IteratorsConfig *config;
   bool notSubtree;
+  bool positionalSubtree;  // evaluating the children of a phrase whose term positions are checked
+  bool exhaustiveSubtree;  // evaluating the children of an intersection, which need all the
+                           // documents of their terms
+  struct QueryIterator *rangeFilter;  // the smallest sibling of the vector range query being
+                                     // evaluated, which its results are intersected with. Not owned
 } QueryEvalCtx;
@@ -88,6 +88,10 @@ void QueryNode_SetFieldMask(QueryNode *n, t_fieldMask mask);
 /* Free the query node and its children recursively */
 void QueryNode_Free(QueryNode *n);
 
+/* Copy the query node and its children recursively, along with their unresolved parameters.
+ * Returns NULL if a node cannot be copied (e.g. a vector or a geometry node) */
+QueryNode *QueryNode_Clone(const QueryNode *n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -120,6 +120,8 @@ typedef struct {
 
 typedef struct {
   struct GeoFilter *gf;
+  // If not 0, the query only returns this number of the documents closest to the center
+  size_t nearest;
 } QueryGeofilterNode;
 
 typedef struct {
@@ -159,6 +161,8 @@ typedef enum {
   // Marks this as the main vector node in a hybrid vector subquery
   QueryNode_HybridVectorSubqueryNode = 0x20,
   QueryNode_HideVectorDistanceField = 0x40,
+  // The tag value(s) of the node were unescaped and case-folded already, see tag_strtolower()
+  QueryNode_TagNormalized = 0x80,
 } QueryNodeFlags;
 
 /* Query attribute is a dynamic attribute that can be applied to any query node.
@@ -182,6 +186,7 @@ typedef struct {
 #define WEIGHT_ATTR "weight"
 #define PHONETIC_ATTR "phonetic"
 #define SHARD_K_RATIO_ATTR "shard_k_ratio"
+#define RERANK_FACTOR_ATTR "rerank_factor"
 
 
 /* Various modifiers and options that can apply to the entire query or any sub-query of it */
@@ -229,6 +234,11 @@ typedef struct RSQueryNode {
   Param *params;
 
   struct RSQueryNode **children;
+
+  /* The node was allocated from the arena of its request, and is released along with it */
+  bool inArena;
+  /* The string of the token of the node was copied into the arena as well */
+  bool tokenInArena;
 } QueryNode;
 
 int QueryNode_ApplyAttributes(QueryNode *qn, QueryAttribute *attr, size_t len, QueryError *status);
@@ -11,8 +11,11 @@
 #include "iterators/optimizer_reader.h"
 #include "numeric_index.h"
 #include "ext/default.h"
+#include "config.h"
 #include "iterators/union_iterator.h"
+#include "iterators/optional_iterator.h"
 #include "iterators/intersection_iterator.h"
+#include "iterators/empty_iterator.h"
 
 /********************* Horrific hacks moved from index.c *********************/
 
@@ -286,23 +289,72 @@ static void updateRootIter(AREQ *req, QueryIterator *root, QueryIterator *new) {
   }
 }
 
+// A search sorted by BM25STD score may skip the work of documents using upper bounds of their scores,
+// for a root union of terms or the optional terms of a root intersection. The bounds assume that
+// documents scores are at most 1, which holds unless a score field is set on the index.
+static bool canBoundScores(AREQ *req, QOptimizer *opt) {
+  const PLN_ArrangeStep *arng = AGPLN_GetArrangeStep(AREQ_AGGPlan(req));
+  const char *scorer = req->searchopts.scorerName;
+  return IsSearch(req) && opt->scorerReq && !(arng && arng->sortKeys) &&
+         !(AREQ_RequestFlags(req) & QEXEC_F_NOROWS) &&
+         (!scorer || !strcmp(scorer, BM25_STD_SCORER_NAME)) &&
+         !AREQ_SearchCtx(req)->spec->rule->score_field;
+}
+
+// A wildcard query sorted by a numeric field may read the numeric tree in sort order. A document
+// must have a single value in the tree for it to be collected once, which holds for hash documents.
+static bool canUseIndexOrder(AREQ *req, QOptimizer *opt) {
+  return req->ast.root->type == QN_WILDCARD && opt->field &&
+         AREQ_SearchCtx(req)->spec->rule->type == DocumentType_Hash;
+}
+
+bool QOptimizer_CanReadImpactPostings(AREQ *req, QOptimizer *opt) {
+  const PLN_ArrangeStep *arng = AGPLN_GetArrangeStep(AREQ_AGGPlan(req));
+  const char *scorer = req->searchopts.scorerName;
+  return RSGlobalConfig.impactPostingsMinDocs && IsSearch(req) && opt->type == Q_OPT_NONE &&
+         opt->scorerReq && !(arng && arng->sortKeys) &&
+         opt->limit <= RSGlobalConfig.impactPostingsSize &&
+         !(AREQ_RequestFlags(req) & QEXEC_F_NOROWS) &&
+         (!scorer || !strcmp(scorer, BM25_STD_SCORER_NAME)) &&
+         req->ast.root && req->ast.root->type != QN_VECTOR;
+}
+
 void QOptimizer_Iterators(AREQ *req, QOptimizer *opt) {
   IndexSpec *spec = AREQ_SearchCtx(req)->spec;
   QueryIterator *root = req->rootiter;
 
   switch (opt->type) {
     case Q_OPT_HYBRID:
+    case Q_OPT_BLOCK_MAX:
+    case Q_OPT_INDEX_ORDER:
+    case Q_OPT_LAZY_OPTIONAL:
       RS_ABORT("cannot be decided earlier");
 
+    case Q_OPT_NONE: {
+      if (!canBoundScores(req, opt)) {
+        return;
+      }
+      // The sorter raises `minScore` to the lowest score in its heap once it is full
+      const double *threshold = &AREQ_QueryProcessingCtx(req)->minScore;
+      if (root->type == UNION_ITERATOR && UI_EnableBlockMax(root, threshold)) {
+        opt->type = Q_OPT_BLOCK_MAX;
+      } else if (OI_EnableLazy(root, threshold)) {
+        opt->type = Q_OPT_LAZY_OPTIONAL;
+      }
+      return;
+    }
+
     // Nothing to do here
     case Q_OPT_NO_SORTER:
-    case Q_OPT_NONE:
     case Q_OPT_FILTER:
       return;
 
     // limit range to number of required LIMIT
     case Q_OPT_PARTIAL_RANGE: {
-      if (root->type == WILDCARD_ITERATOR) {
+      if (canUseIndexOrder(req, opt)) {
+        opt->type = Q_OPT_INDEX_ORDER;
+        req->rootiter = NewOptimizerIterator(opt, root, &req->ast.config);
+      } else if (root->type == WILDCARD_ITERATOR) {
         req->rootiter = NewOptimizerIterator(opt, root, &req->ast.config);
       } else if (req->ast.root->type == QN_NUMERIC) {
         // trim the union numeric iterator to have the minimal number of ranges
@@ -315,14 +367,27 @@ void QOptimizer_Iterators(AREQ *req, QOptimizer *opt) {
       return;
     }
     case Q_OPT_UNDECIDED: {
-      if (!opt->field) {
+      // When the numeric filter matches no more documents than required, or than the first hybrid
+      // iteration would read (see NewOptimizerIterator), they are all read anyway. Intersecting
+      // them with the root at once is cheaper than the hybrid iterations
+      bool fewMatches = false;
+      if (opt->field && opt->nf) {
+        bool exact = false;
+        size_t card = NumericFilter_Cardinality(AREQ_SearchCtx(req), opt->nf, &exact);
+        size_t firstLimit = QOptimizer_EstimateLimit(AREQ_SearchCtx(req)->spec->docs.size,
+                                                     root->NumEstimated(root), opt->limit);
+        fewMatches = (card <= opt->limit && exact) || card <= firstLimit;
+      }
+      if (!opt->field || fewMatches) {
+        // The filter of the sortby node was limited for the hybrid iterations
+        opt->sortbyNode->nn.nf->limit = 0;
         // TODO: For now set to NONE. Maybe add use of FILTER
         opt->type = Q_OPT_NONE;
         const FieldSpec *fs = opt->sortbyNode->nn.nf->fieldSpec;
         FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index= fs->index}}, .predicate = FIELD_EXPIRATION_DEFAULT};
         QueryIterator *numericIter = NewNumericFilterIterator(AREQ_SearchCtx(req), opt->sortbyNode->nn.nf, INDEXFLD_T_NUMERIC,
                                                               &req->ast.config, &filterCtx);
-        updateRootIter(req, root, numericIter);
+        updateRootIter(req, root, numericIter ? numericIter : NewEmptyIterator());
         return;
       }
       opt->type = Q_OPT_HYBRID;
@@ -358,6 +423,12 @@ const char *QOptimizer_PrintType(QOptimizer *opt) {
       return "Undecided";
     case Q_OPT_FILTER:
       return "Filter";
+    case Q_OPT_BLOCK_MAX:
+      return "Block-max pruning";
+    case Q_OPT_INDEX_ORDER:
+      return "Index order";
+    case Q_OPT_LAZY_OPTIONAL:
+      return "Lazy optional terms";
   }
   return NULL;
 }
@@ -49,6 +49,18 @@ typedef enum {
   // Use `FILTER` result processor instead of numeric range
   Q_OPT_FILTER = 4,
 
+  // Scored union query. Skip candidates that cannot enter the top results, using
+  // per-block upper bounds of the BM25STD score
+  Q_OPT_BLOCK_MAX = 5,
+
+  // Wildcard query sorted by a numeric field. Read the leaves of the numeric tree in sort order
+  // and stop once no further leaf can improve the results
+  Q_OPT_INDEX_ORDER = 6,
+
+  // Scored intersection query with optional terms. Only advance the optional terms to the
+  // documents that may still enter the top results with them
+  Q_OPT_LAZY_OPTIONAL = 7,
+
   // sortby other field. currently no optimization
   // Q_OPT_SORTBY_OTHER
 } Q_Optimize_Type;
@@ -94,6 +106,10 @@ void QOptimizer_Parse(AREQ *req);
  **/
 void QOptimizer_QueryNodes(QueryNode *root, QOptimizer *opt);
 
+/* whether the terms of a ranked query may be read from their impact postings, which only keep
+ * the top documents of the common terms. Decided before the iterators are built */
+bool QOptimizer_CanReadImpactPostings(AREQ *req, QOptimizer *opt);
+
 /* iterate over index iterator, check estimations and performs further optimizations */
 void QOptimizer_Iterators(AREQ *req, QOptimizer *opt);
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "query_plan_cache.h"
+#include "query_internal.h"
+#include "util/arena.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "rmalloc.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct {
+  uint64_t hash;  // Of the key, compared before the key itself
+  sds key;
+  QueryNode *root;
+  size_t numTokens;
+  size_t numParams;
+} QueryPlanCacheEntry;
+
+struct QueryPlanCache {
+  pthread_mutex_t lock;
+  arrayof(QueryPlanCacheEntry) entries;
+  size_t next;  // The entry replaced next once the cache is full
+};
+
+QueryPlanCache *NewQueryPlanCache(void) {
+  QueryPlanCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  cache->entries = array_new(QueryPlanCacheEntry, 0);
+  return cache;
+}
+
+static void QueryPlanCacheEntry_Free(QueryPlanCacheEntry *e) {
+  sdsfree(e->key);
+  QueryNode_Free(e->root);
+}
+
+void QueryPlanCache_Clear(QueryPlanCache *cache) {
+  pthread_mutex_lock(&cache->lock);
+  array_foreach(cache->entries, e, QueryPlanCacheEntry_Free(&e));
+  array_clear(cache->entries);
+  cache->next = 0;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+void QueryPlanCache_Free(QueryPlanCache *cache) {
+  if (!cache) return;
+  QueryPlanCache_Clear(cache);
+  array_free(cache->entries);
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+bool QueryPlanCache_IsCacheable(const char *query, size_t len) {
+  for (size_t i = 0; i + 1 < len; i++) {
+    if (query[i] == '=' && query[i + 1] == '>') {
+      return false;
+    }
+  }
+  return true;
+}
+
+sds QueryPlanCache_Key(const char *query, size_t len, unsigned int dialect, bool stopwords) {
+  sds key = sdsnewlen(&dialect, sizeof(dialect));
+  key = sdscatlen(key, &stopwords, sizeof(stopwords));
+  return sdscatlen(key, query, len);
+}
+
+static QueryPlanCacheEntry *QueryPlanCache_Find(QueryPlanCache *cache, const sds key, uint64_t hash) {
+  size_t len = sdslen(key);
+  for (size_t i = 0; i < array_len(cache->entries); i++) {
+    QueryPlanCacheEntry *e = &cache->entries[i];
+    if (e->hash == hash && sdslen(e->key) == len && !memcmp(e->key, key, len)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+bool QueryPlanCache_Get(QueryPlanCache *cache, const sds key, QueryAST *ast) {
+  uint64_t hash = RS_dictGenHashFunction(key, sdslen(key));
+  pthread_mutex_lock(&cache->lock);
+  QueryPlanCacheEntry *e = QueryPlanCache_Find(cache, key, hash);
+  if (e) {
+    // Only cloneable trees are cached
+    ast->root = QueryNode_Clone(e->root);
+    ast->numTokens = e->numTokens;
+    ast->numParams = e->numParams;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return e != NULL;
+}
+
+void QueryPlanCache_Put(QueryPlanCache *cache, const sds key, const QueryAST *ast, size_t capacity) {
+  if (!capacity || !ast->root) return;
+  // The cached tree outlives the request, so it is not allocated from its arena
+  Arena *prevArena = Arena_SetCurrent(NULL);
+  QueryNode *root = QueryNode_Clone(ast->root);
+  Arena_SetCurrent(prevArena);
+  if (!root) return;
+
+  uint64_t hash = RS_dictGenHashFunction(key, sdslen(key));
+  pthread_mutex_lock(&cache->lock);
+  // Another query may have cached the same tree meanwhile
+  if (QueryPlanCache_Find(cache, key, hash)) {
+    pthread_mutex_unlock(&cache->lock);
+    QueryNode_Free(root);
+    return;
+  }
+  QueryPlanCacheEntry entry = {
+    .hash = hash,
+    .key = sdsdup(key),
+    .root = root,
+    .numTokens = ast->numTokens,
+    .numParams = ast->numParams,
+  };
+  if (array_len(cache->entries) < capacity) {
+    array_append(cache->entries, entry);
+  } else {
+    // The capacity may have been lowered since the entries were added
+    cache->next %= capacity;
+    QueryPlanCacheEntry_Free(&cache->entries[cache->next]);
+    cache->entries[cache->next++] = entry;
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "query.h"
+#include "hiredis/sds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A cache of the query strings parsed on an index, enabled by _QUERY_PLAN_CACHE_ENTRIES, so that
+ * a query sent again and again with other PARAMS values is parsed once.
+ *
+ * The entries hold the tree of the query as the parser left it, before its parameters are
+ * resolved, and every request gets its own copy to bind its parameters to, expand and optimize.
+ * The trees point at the fields of the index, so the cache is cleared whenever fields are added.
+ * Once full, the oldest entry is replaced. Lookups may run concurrently, from the worker threads,
+ * and are serialized by the cache itself.
+ */
+typedef struct QueryPlanCache QueryPlanCache;
+
+QueryPlanCache *NewQueryPlanCache(void);
+void QueryPlanCache_Free(QueryPlanCache *cache);
+
+/* Drop all the entries. The spec must be locked for write */
+void QueryPlanCache_Clear(QueryPlanCache *cache);
+
+/* Whether the tree of the query can be cached. The parser reads the values of the parameters
+ * given to the attributes of a node (`=>{$weight: $w}`), so those queries are not */
+bool QueryPlanCache_IsCacheable(const char *query, size_t len);
+
+/* The key of a query string parsed in `dialect`, with or without the stop words of the index */
+sds QueryPlanCache_Key(const char *query, size_t len, unsigned int dialect, bool stopwords);
+
+/* Set the root of `ast` to a copy of the cached tree of the query, allocated from the arena of the
+ * calling thread, if any.
+ * @returns false if it is not cached */
+bool QueryPlanCache_Get(QueryPlanCache *cache, const sds key, QueryAST *ast);
+
+/* Cache a copy of the tree of the parsed query, keeping at most `capacity` entries. Trees holding
+ * nodes which cannot be copied are not cached */
+void QueryPlanCache_Put(QueryPlanCache *cache, const sds key, const QueryAST *ast, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,7 +16,11 @@
 #include "util/logging.h"
 #include "util/misc.h"
 #include "tag_index.h"
+#include "term_tiers.h"
+#include "impact_postings.h"
 #include "rmalloc.h"
+#include "rs_wall_clock.h"
+#include "info/latency_stats.h"
 #include <stdio.h>
 
 RedisModuleType *InvertedIndexType;
@@ -82,9 +86,24 @@ RedisModuleString *fmtRedisScoreIndexKey(const RedisSearchCtx *ctx, const char *
                                         (int)len, term);
 }
 
+// Set on the threads of the GC, to tell its waits for the locks apart from those of the queries and
+// of the writers
+static __thread bool gcThread = false;
+
+void RedisSearchCtx_MarkGCThread(void) {
+  gcThread = true;
+}
+
 void RedisSearchCtx_LockSpecRead(RedisSearchCtx *ctx) {
   RS_ASSERT(ctx->flags == RS_CTX_UNSET);
-  pthread_rwlock_rdlock(&ctx->spec->rwlock);
+  if (pthread_rwlock_tryrdlock(&ctx->spec->rwlock)) {
+    // Only the waits are timed, so that an uncontended lock costs what it did
+    rs_wall_clock start;
+    rs_wall_clock_init(&start);
+    pthread_rwlock_rdlock(&ctx->spec->rwlock);
+    LatencyStats_CountWait(gcThread ? LATENCY_WAIT_GC : LATENCY_WAIT_SPEC_READ,
+                           rs_wall_clock_elapsed_ns(&start));
+  }
   // pause rehashing while we're using the dict for reads only
   // Assert that the pause value before we pause is valid.
   RS_ASSERT_ALWAYS(dictPauseRehashing(ctx->spec->keysDict));
@@ -93,7 +112,15 @@ void RedisSearchCtx_LockSpecRead(RedisSearchCtx *ctx) {
 
 void RedisSearchCtx_LockSpecWrite(RedisSearchCtx *ctx) {
   RS_ASSERT(ctx->flags == RS_CTX_UNSET);
-  pthread_rwlock_wrlock(&ctx->spec->rwlock);
+  if (pthread_rwlock_trywrlock(&ctx->spec->rwlock)) {
+    rs_wall_clock start;
+    rs_wall_clock_init(&start);
+    __atomic_add_fetch(&ctx->spec->writersWaiting, 1, __ATOMIC_RELAXED);
+    pthread_rwlock_wrlock(&ctx->spec->rwlock);
+    __atomic_sub_fetch(&ctx->spec->writersWaiting, 1, __ATOMIC_RELAXED);
+    LatencyStats_CountWait(gcThread ? LATENCY_WAIT_GC : LATENCY_WAIT_SPEC_WRITE,
+                           rs_wall_clock_elapsed_ns(&start));
+  }
   ctx->flags = RS_CTX_READWRITE;
 }
 
@@ -105,6 +132,8 @@ RedisSearchCtx *NewSearchCtxC(RedisModuleCtx *ctx, const char *indexName, bool r
   if (!sp) {
     return NULL;
   }
+  // The index is built in the background from its first use, as a new index is
+  IndexSpec_Activate(sp);
 
   RedisSearchCtx *sctx = rm_new(RedisSearchCtx);
   *sctx = SEARCH_CTX_STATIC(ctx, sp);
@@ -147,12 +176,13 @@ void SearchCtx_Free(RedisSearchCtx *sctx) {
 }
 
 static InvertedIndex *openIndexKeysDict(const RedisSearchCtx *ctx, RedisModuleString *termKey,
-                                        int write, bool *outIsNew) {
+                                        const char *term, size_t len, int write, bool *outIsNew) {
   KeysDictValue *kdv = dictFetchValue(ctx->spec->keysDict, termKey);
   if (kdv) {
     if (outIsNew) {
       *outIsNew = false;
     }
+    TermTiers_Open(ctx->spec, kdv, term, len);
     return kdv->p;
   }
   if (!write) {
@@ -173,46 +203,73 @@ static InvertedIndex *openIndexKeysDict(const RedisSearchCtx *ctx, RedisModuleSt
 
 InvertedIndex *Redis_OpenInvertedIndex(const RedisSearchCtx *ctx, const char *term, size_t len, int write, bool *outIsNew) {
   RedisModuleString *termKey = fmtRedisTermKey(ctx, term, len);
-  InvertedIndex *idx = openIndexKeysDict(ctx, termKey, write, outIsNew);
+  InvertedIndex *idx = openIndexKeysDict(ctx, termKey, term, len, write, outIsNew);
   RedisModule_FreeString(ctx->redisCtx, termKey);
   return idx;
 }
 
-QueryIterator *Redis_OpenReader(const RedisSearchCtx *ctx, RSQueryTerm *term, DocTable *dt,
-                                t_fieldMask fieldMask, double weight) {
+InvertedIndex *Redis_PeekInvertedIndex(const RedisSearchCtx *ctx, const char *term, size_t len,
+                                       bool *isCold) {
+  RedisModuleString *termKey = fmtRedisTermKey(ctx, term, len);
+  KeysDictValue *kdv = dictFetchValue(ctx->spec->keysDict, termKey);
+  RedisModule_FreeString(ctx->redisCtx, termKey);
+  *isCold = kdv && __atomic_load_n(&kdv->cold, __ATOMIC_ACQUIRE);
+  return kdv ? kdv->p : NULL;
+}
 
-  RedisModuleString *termKey = fmtRedisTermKey(ctx, term->str, term->len);
-  InvertedIndex *idx = NULL;
-  RedisModuleKey *k = NULL;
+InvertedIndex *Redis_OpenTermIndex(const RedisSearchCtx *ctx, const char *term, size_t len,
+                                   t_fieldMask fieldMask) {
+  InvertedIndex *idx = Redis_OpenInvertedIndex(ctx, term, len, 0, NULL);
+  if (!idx || !InvertedIndex_NumDocs(idx) ||
+     (Index_StoreFieldMask(ctx->spec) && !(InvertedIndex_FieldMask(idx) & fieldMask))) {
+    // empty index! or index does not have results from requested field.
+    return NULL;
+  }
+  return idx;
+}
 
-  idx = openIndexKeysDict(ctx, termKey, 0, NULL);
-  if (!idx) {
-    goto err;
+void Redis_GetTermStats(const RedisSearchCtx *ctx, const char *term, size_t len, TermStats *stats) {
+  const IndexSpec *spec = ctx->spec;
+  if (spec->termStats && TermStatsCache_Get(spec->termStats, spec->revision, term, len, stats)) {
+    return;
   }
+  // The counters of a cold term are kept in memory
+  bool isCold;
+  InvertedIndex *idx = Redis_PeekInvertedIndex(ctx, term, len, &isCold);
+  stats->hasIndex = idx != NULL;
+  stats->numDocs = idx ? InvertedIndex_NumDocs(idx) : 0;
+  stats->fieldMask = idx ? InvertedIndex_FieldMask(idx) : 0;
+  if (spec->termStats) {
+    TermStatsCache_Put(spec->termStats, spec->revision, term, len, stats);
+  }
+}
 
-  if (!InvertedIndex_NumDocs(idx) ||
-     (Index_StoreFieldMask(ctx->spec) && !(InvertedIndex_FieldMask(idx) & fieldMask))) {
-    // empty index! or index does not have results from requested field.
-    // pass
-    goto err;
+QueryIterator *Redis_OpenReader(const RedisSearchCtx *ctx, RSQueryTerm *term, DocTable *dt,
+                                t_fieldMask fieldMask, double weight) {
+  InvertedIndex *idx = Redis_OpenTermIndex(ctx, term->str, term->len, fieldMask);
+  if (!idx) {
+    Term_Free(term);
+    return NULL;
   }
 
   FieldMaskOrIndex fieldMaskOrIndex = {.isFieldMask = true, .value.mask = fieldMask};
-  QueryIterator *it = NewInvIndIterator_TermQuery(idx, ctx, fieldMaskOrIndex, term, weight);
-  RedisModule_FreeString(ctx->redisCtx, termKey);
-  return it;
+  return NewInvIndIterator_TermQuery(idx, ctx, fieldMaskOrIndex, term, weight);
+}
 
-err:
-  if (k) {
-    RedisModule_CloseKey(k);
-  }
-  if (termKey) {
-    RedisModule_FreeString(ctx->redisCtx, termKey);
-  }
-  if (term) {
+QueryIterator *Redis_OpenImpactReader(const RedisSearchCtx *ctx, RSQueryTerm *term,
+                                      t_fieldMask fieldMask, double weight) {
+  InvertedIndex *idx = Redis_OpenTermIndex(ctx, term->str, term->len, fieldMask);
+  if (!idx) {
     Term_Free(term);
+    return NULL;
+  }
+
+  FieldMaskOrIndex fieldMaskOrIndex = {.isFieldMask = true, .value.mask = fieldMask};
+  InvertedIndex *top = ImpactPostings_Get(ctx->spec->impactPostings, term->str, term->len, idx);
+  if (top) {
+    return NewInvIndIterator_ImpactQuery(top, idx, ctx, fieldMaskOrIndex, term, weight);
   }
-  return NULL;
+  return NewInvIndIterator_TermQuery(idx, ctx, fieldMaskOrIndex, term, weight);
 }
 
 int Redis_DropScanHandler(RedisModuleCtx *ctx, RedisModuleString *kn, void *opaque) {
@@ -14,6 +14,7 @@
 #include "search_ctx.h"
 #include "concurrent_ctx.h"
 #include "spec.h"
+#include "term_stats.h"
 #include "iterators/iterator_api.h"
 
 /* Open an inverted index reader on a redis DMA string, for a specific term.
@@ -22,9 +23,27 @@
 QueryIterator *Redis_OpenReader(const RedisSearchCtx *ctx, RSQueryTerm *term, DocTable *dt,
                                  t_fieldMask fieldMask, double weight);
 
+/* Open a reader of a term for a ranked query, over the impact postings of the term if it has any
+ * (see impact_postings.h), or over its full inverted index */
+QueryIterator *Redis_OpenImpactReader(const RedisSearchCtx *ctx, RSQueryTerm *term,
+                                      t_fieldMask fieldMask, double weight);
+
 InvertedIndex *Redis_OpenInvertedIndex(const RedisSearchCtx *ctx, const char *term, size_t len,
                                          int write, bool *outIsNew);
 
+/* Returns the inverted index of a term without bringing its blocks back if it is cold (see
+ * term_tiers.h), setting `isCold` if it has none. Only its counters may be read then */
+InvertedIndex *Redis_PeekInvertedIndex(const RedisSearchCtx *ctx, const char *term, size_t len,
+                                       bool *isCold);
+
+/* Returns the inverted index of a term if it has documents in the fields of `fieldMask`, as
+ * checked by Redis_OpenReader(), or NULL */
+InvertedIndex *Redis_OpenTermIndex(const RedisSearchCtx *ctx, const char *term, size_t len,
+                                   t_fieldMask fieldMask);
+
+/* Get the statistics of a term through the term statistics cache of the spec */
+void Redis_GetTermStats(const RedisSearchCtx *ctx, const char *term, size_t len, TermStats *stats);
+
 /*
  * Select a random term from the index that matches the index prefix and inveted key format.
  * It tries RANDOMKEY 10 times and returns NULL if it can't find anything.
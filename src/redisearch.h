@@ -128,9 +128,6 @@ typedef struct {
 typedef struct RSDocumentMetadata_s {
   t_docId id;
 
-  /* The actual key of the document, not the internal incremental id */
-  char *keyPtr;
-
   /* The a-priory document score as given by the user on insertion */
   float score;
 
@@ -148,10 +145,20 @@ typedef struct RSDocumentMetadata_s {
 
   uint16_t ref_count;
 
+  /* Digest of the indexed content of the document, or 0 if unknown. A document whose content has
+   * the same digest is not indexed again */
+  uint64_t digest;
+
   struct RSSortingVector *sortVector;
+
+  /* The next document in the same bucket of the doc table */
+  struct RSDocumentMetadata_s *next;
+
+  /* The actual key of the document, not the internal incremental id */
+  char *keyPtr;
+
   /* Offsets of all terms in the document (in bytes). Used by highlighter */
   struct RSByteOffsets *byteOffsets;
-  DLLIST2_node llnode;
 
   /* Optional user payload */
   RSPayload *payload;
@@ -296,6 +303,10 @@ RSOffsetIterator RSOffsetVector_Iterate(const RSOffsetVector *v, RSQueryTerm *t)
 /* Iterate an offset vector. The iterator object is allocated on the heap and needs to be freed */
 RSOffsetIterator RSIndexResult_IterateOffsets(const RSIndexResult *res);
 
+/* Decode the offsets of a result, in order, to `out` which has room for `cap` of them. Returns the
+ * number of offsets of the result, which are all decoded only if it is not above `cap` */
+size_t RSIndexResult_DecodeOffsets(const RSIndexResult *res, uint32_t *out, size_t cap);
+
 int RSIndexResult_HasOffsets(const RSIndexResult *res);
 
 /* RS_SCORE_FILTEROUT is a special value (-inf) that should be returned by scoring functions in
@@ -337,6 +348,14 @@ typedef struct {
 typedef double (*RSScoringFunction)(const ScoringFunctionArgs *ctx, const RSIndexResult *res,
                                     const RSDocumentMetadata *dmd, double minScore);
 
+/* RSBatchScoringFunction is the optional batch version of a scoring function which scores a
+ * document by its metadata alone. It sets `scores[i]` to the score of the document `dmds[i]`, as
+ * the scoring function would return it. It is not given the index results, which the iterators
+ * reuse between the results of a batch */
+typedef void (*RSBatchScoringFunction)(const ScoringFunctionArgs *ctx,
+                                       const RSDocumentMetadata *const *dmds, size_t n,
+                                       double minScore, double *scores);
+
 /* The extension registration context, containing the callbacks available to the extension for
  * registering query expanders and scorers. */
 typedef struct RSExtensionCtx {
@@ -344,6 +363,9 @@ typedef struct RSExtensionCtx {
                                  void *privdata);
   int (*RegisterQueryExpander)(const char *alias, RSQueryTokenExpander exp, RSFreeFunction ff,
                                void *privdata);
+  /* Register the batch version of the scoring function already registered under `alias`. It is
+   * used instead of it for the results read in batches, unless their scores are explained */
+  int (*RegisterBatchScoringFunction)(const char *alias, RSBatchScoringFunction func);
 } RSExtensionCtx;
 
 /* An extension initialization function  */
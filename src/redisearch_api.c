@@ -181,10 +181,8 @@ RSFieldID RediSearch_CreateField(RefManager* rm, const char* name, unsigned type
     fs->options |= FieldSpec_WithSuffixTrie;
     if (fs->types == INDEXFLD_T_FULLTEXT) {
       sp->suffixMask |= FIELD_BIT(fs);
-      if (!sp->suffix) {
-        sp->suffix = NewTrie(suffixTrie_freeCallback, Trie_Sort_Lex);
-        sp->flags |= Index_HasSuffixTrie;
-      }
+      sp->flags |= Index_HasSuffixTrie;
+      IndexSpec_InitSuffixIndex(sp);
     }
   }
 
@@ -271,7 +269,7 @@ int RediSearch_DeleteDocument(RefManager* rm, const void* docKey, size_t len) {
       // Delete returns true/false, not RM_{OK,ERR}
       sp->stats.numDocuments--;
       if (sp->gc) {
-        GCContext_OnDelete(sp->gc);
+        GCContext_OnDelete(sp->gc, id);
       }
     } else {
       rc = REDISMODULE_ERR;
@@ -878,7 +876,7 @@ int RediSearch_IndexInfo(RSIndex* rm, RSIdxInfo *info) {
   info->maxDocId = sp->docs.maxDocId;
   info->docTableSize = sp->docs.memsize;
   info->sortablesSize = sp->docs.sortablesSize;
-  info->docTrieSize = TrieMap_MemUsage(sp->docs.dim.tm);
+  info->docTrieSize = DocIdMap_MemUsage(&sp->docs.dim);
   info->numTerms = sp->stats.numTerms;
   info->numRecords = sp->stats.numRecords;
   info->invertedSize = sp->stats.invertedSize;
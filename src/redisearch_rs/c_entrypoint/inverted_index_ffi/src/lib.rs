@@ -20,7 +20,7 @@ use std::{
 use ffi::{
     DocTable_Exists, IndexFlags, IndexFlags_Index_DocIdsOnly, IndexFlags_Index_StoreFieldFlags,
     IndexFlags_Index_StoreFreqs, IndexFlags_Index_StoreNumeric, IndexFlags_Index_StoreTermOffsets,
-    IndexFlags_Index_WideSchema, RedisSearchCtx, t_docId, t_fieldMask,
+    IndexFlags_Index_WideSchema, RSGlobalConfig, RedisSearchCtx, t_docId, t_fieldMask,
 };
 
 use fork_gc::{InvertedIndexGCCallback, InvertedIndexGCReader, InvertedIndexGCWriter};
@@ -121,6 +121,10 @@ macro_rules! ii_dispatch {
     };
 }
 
+// Use `ii_dispatch!`
+mod rdb;
+mod taken_blocks;
+
 /// The mask of flags that determine the index storage type. This includes all flags that affect
 /// the storage format of the index.
 const INDEX_STORAGE_MASK: IndexFlags = IndexFlags_Index_StoreFreqs
@@ -297,6 +301,29 @@ pub unsafe extern "C" fn InvertedIndex_WriteNumericEntry(
     ii_dispatch!(ii, add_record, &record).unwrap()
 }
 
+/// Pack the entries of a block of a numeric index into fixed-width columns, if that makes the
+/// block smaller. This is only meant for blocks which won't be written to anymore, so the last
+/// block of the index is never packed. The function returns the number of bytes the memory usage
+/// of the index shrank by, which is 0 if the block was left as is or the index isn't numeric.
+///
+/// # Safety
+/// The following invariant must be upheld when calling this function:
+/// - `ii` must be a valid pointer to an `InvertedIndex` instance and cannot be NULL.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn InvertedIndex_PackNumericBlock(
+    ii: *mut InvertedIndex,
+    block_idx: usize,
+) -> usize {
+    debug_assert!(!ii.is_null(), "ii must not be null");
+
+    // SAFETY: The caller must ensure that `ii` is a valid pointer to an `InvertedIndex`
+    let ii = unsafe { &mut *ii };
+    match ii {
+        InvertedIndex::Numeric(ii) => ii.pack_block(block_idx),
+        _ => 0,
+    }
+}
+
 /// Write a new entry to the inverted index. The function returns the number of bytes the memory
 /// usage of the index grew by.
 ///
@@ -777,6 +804,57 @@ pub unsafe extern "C" fn IndexBlock_NumEntries(ib: *const IndexBlock) -> u16 {
     ib.num_entries()
 }
 
+/// Get the highest term frequency of the entries in the index block. This is an upper bound on the
+/// frequency of any document of the block, for indexes storing frequencies.
+///
+/// # Safety
+///
+/// The following invariant must be upheld when calling this function:
+/// - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexBlock_MaxFreq(ib: *const IndexBlock) -> u32 {
+    debug_assert!(!ib.is_null(), "ib must not be null");
+
+    // SAFETY: The caller must ensure that `ib` is a valid pointer to an `IndexBlock`
+    let ib = unsafe { &*ib };
+
+    ib.max_freq()
+}
+
+/// Check if the entries of the index block were packed into fixed-width columns by
+/// [`InvertedIndex_PackNumericBlock`].
+///
+/// # Safety
+///
+/// The following invariant must be upheld when calling this function:
+/// - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexBlock_IsPacked(ib: *const IndexBlock) -> bool {
+    debug_assert!(!ib.is_null(), "ib must not be null");
+
+    // SAFETY: The caller must ensure that `ib` is a valid pointer to an `IndexBlock`
+    let ib = unsafe { &*ib };
+
+    ib.is_packed()
+}
+
+/// Check if the index block was sealed as a bitmap of its document IDs. Only the document IDs only
+/// encodings store dense blocks this way.
+///
+/// # Safety
+///
+/// The following invariant must be upheld when calling this function:
+/// - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexBlock_IsDense(ib: *const IndexBlock) -> bool {
+    debug_assert!(!ib.is_null(), "ib must not be null");
+
+    // SAFETY: The caller must ensure that `ib` is a valid pointer to an `IndexBlock`
+    let ib = unsafe { &*ib };
+
+    ib.is_dense()
+}
+
 /// Get a pointer to the raw data of the index block. This is used by some C tests.
 ///
 /// # Safety
@@ -793,6 +871,39 @@ pub unsafe extern "C" fn IndexBlock_Data(ib: *const IndexBlock) -> *const c_char
     ib.data().as_ptr() as *const _
 }
 
+/// Get the number of bytes of the encoded data of the index block.
+///
+/// # Safety
+///
+/// The following invariant must be upheld when calling this function:
+/// - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexBlock_Len(ib: *const IndexBlock) -> usize {
+    debug_assert!(!ib.is_null(), "ib must not be null");
+
+    // SAFETY: The caller must ensure that `ib` is a valid pointer to an `IndexBlock`
+    let ib = unsafe { &*ib };
+
+    ib.data().len()
+}
+
+/// Get the number of bytes allocated for the encoded data of the index block. The difference with
+/// [`IndexBlock_Len`] is memory the block reserved for its next entries.
+///
+/// # Safety
+///
+/// The following invariant must be upheld when calling this function:
+/// - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexBlock_Cap(ib: *const IndexBlock) -> usize {
+    debug_assert!(!ib.is_null(), "ib must not be null");
+
+    // SAFETY: The caller must ensure that `ib` is a valid pointer to an `IndexBlock`
+    let ib = unsafe { &*ib };
+
+    ib.capacity()
+}
+
 /// An opaque inverted index reader structure. The actual implementation is determined at runtime
 /// based on the index type and filter provided when creating the reader. This allows us to have a
 /// single interface for all index reader types while still being able to optimize the storage
@@ -903,7 +1014,7 @@ pub unsafe extern "C" fn NewIndexReader(
     // SAFETY: The caller must ensure that `ii` is a valid pointer to an `InvertedIndex`
     let ii = unsafe { &*ii };
 
-    let reader = match (ii, ctx) {
+    let mut reader = match (ii, ctx) {
         (InvertedIndex::Full(ii), ReadFilter::FieldMask(mask)) => {
             IndexReader::Full(ii.reader(mask))
         }
@@ -947,6 +1058,11 @@ pub unsafe extern "C" fn NewIndexReader(
         (index, filter) => panic!("Unsupported filter ({filter:?}) for inverted index ({index:?})"),
     };
 
+    // SAFETY: The global configuration is only changed from the main thread, while the readers
+    // are being created
+    let prefetch_distance = unsafe { RSGlobalConfig.indexReaderPrefetchDistance };
+    ir_dispatch!(&mut reader, set_prefetch_distance, prefetch_distance);
+
     let reader_boxed = Box::new(reader);
     Box::into_raw(reader_boxed)
 }
@@ -1137,6 +1253,120 @@ pub unsafe extern "C" fn IndexReader_Seek<'index_and_filter>(
     ir_dispatch!(ir, seek_record, doc_id, res).unwrap_or_default()
 }
 
+/// Get the block the index reader is currently positioned at. After a successful read or seek,
+/// this is the block holding the last entry returned. NULL is returned if the index is empty.
+///
+/// # Safety
+///
+/// The following invariant must be upheld when calling this function:
+/// - `ir` must be a valid, non NULL, pointer to an `IndexReader` instance.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexReader_CurrentBlock(ir: *const IndexReader) -> *const IndexBlock {
+    debug_assert!(!ir.is_null(), "ir must not be null");
+
+    // SAFETY: The caller must ensure that `ir` is a valid pointer to an `IndexReader`
+    let ir = unsafe { &*ir };
+
+    ir_dispatch!(ir, current_block).map_or(std::ptr::null(), |ib| ib as *const _)
+}
+
+/// Get the highest term frequency of the entries of the index read by the index reader. This is an
+/// upper bound on the frequency of any document of the index, for indexes storing frequencies.
+///
+/// # Safety
+///
+/// The following invariant must be upheld when calling this function:
+/// - `ir` must be a valid, non NULL, pointer to an `IndexReader` instance.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexReader_MaxFreq(ir: *const IndexReader) -> u32 {
+    debug_assert!(!ir.is_null(), "ir must not be null");
+
+    // SAFETY: The caller must ensure that `ir` is a valid pointer to an `IndexReader`
+    let ir = unsafe { &*ir };
+
+    ir_dispatch!(ir, index_max_freq)
+}
+
+/// Decode the document IDs of up to `cap` next entries of the index reader into `out`, without
+/// moving the reader. `scratch` is used to decode the entries, and should be a result of the type
+/// the reader yields. Returns the number of IDs written to `out`.
+///
+/// # Safety
+///
+/// The following invariants must be upheld when calling this function:
+/// - `ir` must be a valid, non NULL, pointer to an `IndexReader` instance.
+/// - `scratch` must be a valid pointer to an `RSIndexResult` instance.
+/// - `out` must be a valid pointer to an array of at least `cap` document IDs, unless `cap` is 0.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexReader_PeekIds<'index_and_filter>(
+    ir: *const IndexReader<'index_and_filter>,
+    scratch: *mut RSIndexResult<'index_and_filter>,
+    out: *mut t_docId,
+    cap: usize,
+) -> usize {
+    debug_assert!(!ir.is_null(), "ir must not be null");
+    debug_assert!(!scratch.is_null(), "scratch must not be null");
+
+    if cap == 0 {
+        return 0;
+    }
+    debug_assert!(!out.is_null(), "out must not be null");
+
+    // SAFETY: The caller must ensure that `ir` is a valid pointer to an `IndexReader`
+    let ir = unsafe { &*ir };
+
+    // SAFETY: The caller must ensure that `scratch` is a valid pointer to a `RSIndexResult`
+    let scratch = unsafe { &mut *scratch };
+
+    // SAFETY: The caller must ensure that `out` points to at least `cap` document IDs
+    let out = unsafe { std::slice::from_raw_parts_mut(out, cap) };
+
+    ir_dispatch!(ir, peek_ids, scratch, out)
+}
+
+/// Read the document IDs of up to `cap` next entries of the index reader into `out`. With
+/// `skip_multi`, the entries of the same document as the previous one (`prev_id` for the first) are
+/// skipped. `res` is set to the last entry read. Returns the number of IDs written to `out`, which
+/// is less than `cap` only at the end of the index.
+///
+/// The entries are read in a loop specialized for the encoding and the filter of the reader, and
+/// the unfiltered numeric reader skips over their values without decoding them.
+///
+/// # Safety
+///
+/// The following invariants must be upheld when calling this function:
+/// - `ir` must be a valid, non NULL, pointer to an `IndexReader` instance.
+/// - `res` must be a valid pointer to an `RSIndexResult` instance of the type the reader yields.
+/// - `out` must be a valid pointer to an array of at least `cap` document IDs, unless `cap` is 0.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn IndexReader_NextIds<'index_and_filter>(
+    ir: *mut IndexReader<'index_and_filter>,
+    res: *mut RSIndexResult<'index_and_filter>,
+    prev_id: t_docId,
+    skip_multi: bool,
+    out: *mut t_docId,
+    cap: usize,
+) -> usize {
+    debug_assert!(!ir.is_null(), "ir must not be null");
+    debug_assert!(!res.is_null(), "res must not be null");
+
+    if cap == 0 {
+        return 0;
+    }
+    debug_assert!(!out.is_null(), "out must not be null");
+
+    // SAFETY: The caller must ensure that `ir` is a valid pointer to an `IndexReader`
+    let ir = unsafe { &mut *ir };
+
+    // SAFETY: The caller must ensure that `res` is a valid pointer to a `RSIndexResult`
+    let res = unsafe { &mut *res };
+
+    // SAFETY: The caller must ensure that `out` points to at least `cap` document IDs
+    let out = unsafe { std::slice::from_raw_parts_mut(out, cap) };
+
+    ir_dispatch!(ir, next_ids, res, prev_id, skip_multi, out)
+}
+
 /// Check if the index reader can return multiple entries for the same document ID.
 ///
 /// # Safety
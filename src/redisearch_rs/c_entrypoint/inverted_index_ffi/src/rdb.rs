@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Saving an inverted index to the RDB as it is in memory, block by block, and loading it back.
+//!
+//! An index is saved as its flags, its last document ID, its number of unique documents, the
+//! field mask or number of entries it tracks, whether its document IDs are encoded raw, and its
+//! blocks. Every block is saved as its first and last document IDs, its number of entries, its
+//! highest frequency, its [`BLOCK_RDB_DENSE`] and [`BLOCK_RDB_PACKED`] flags, the capacity of its
+//! buffer and its encoded entries.
+//!
+//! While a snapshot writes an index segment (see `index_segment.h`), the entries of the sealed
+//! blocks are written to the segment instead, and the block is flagged [`BLOCK_RDB_SEGMENT`] and
+//! saved with their offset and length. They are copied from the mapped segment when loaded, as the
+//! blocks own their buffer. A block whose segment couldn't be mapped is loaded empty, and counted
+//! by `IndexSegment_NumMissing`, so that the owner of the index drops the contents it loaded.
+
+use std::ffi::c_char;
+
+use ffi::{
+    IndexFlags, IndexFlags_Index_StoreFieldFlags, IndexFlags_Index_StoreNumeric,
+    IndexSegment_Resolve, IndexSegment_Write, RedisModule_Free, RedisModule_IsIOError,
+    RedisModule_LoadStringBuffer, RedisModule_LoadUnsigned, RedisModule_SaveStringBuffer,
+    RedisModule_SaveUnsigned, RedisModuleIO, t_fieldMask,
+};
+use inverted_index::{
+    Encoder, IndexBlock, IndexReader as _, RSIndexResult, doc_ids_only::DocIdsOnly,
+    raw_doc_ids_only::RawDocIdsOnly,
+};
+
+use crate::{InvertedIndex, NewInvertedIndex_Ex};
+
+/// The block is a bitmap of its document IDs (see [`IndexBlock::is_dense`])
+pub(crate) const BLOCK_RDB_DENSE: u64 = 0x01;
+/// The entries of the block are packed into fixed-width columns (see [`IndexBlock::is_packed`])
+pub(crate) const BLOCK_RDB_PACKED: u64 = 0x02;
+/// The entries of the block are in the segment of the RDB
+const BLOCK_RDB_SEGMENT: u64 = 0x04;
+
+struct RdbWriter(*mut RedisModuleIO);
+
+impl RdbWriter {
+    fn unsigned(&mut self, value: u64) {
+        // SAFETY: The caller of `InvertedIndex_RdbSave` must ensure that `rdb` is valid
+        unsafe { RedisModule_SaveUnsigned.unwrap()(self.0, value) }
+    }
+
+    fn buffer(&mut self, buf: &[u8]) {
+        // SAFETY: The caller of `InvertedIndex_RdbSave` must ensure that `rdb` is valid, and
+        // `buf` is valid for `buf.len()` bytes
+        unsafe {
+            RedisModule_SaveStringBuffer.unwrap()(self.0, buf.as_ptr() as *const c_char, buf.len())
+        }
+    }
+}
+
+/// Reads from the RDB, returning `None` once it fails to.
+struct RdbReader(*mut RedisModuleIO);
+
+impl RdbReader {
+    fn io_error(&self) -> bool {
+        // SAFETY: The caller of `InvertedIndex_RdbLoad_Ex` must ensure that `rdb` is valid
+        unsafe { RedisModule_IsIOError.unwrap()(self.0) != 0 }
+    }
+
+    fn unsigned(&mut self) -> Option<u64> {
+        // SAFETY: The caller of `InvertedIndex_RdbLoad_Ex` must ensure that `rdb` is valid
+        let value = unsafe { RedisModule_LoadUnsigned.unwrap()(self.0) };
+        (!self.io_error()).then_some(value)
+    }
+
+    /// Read a buffer into a vector allocated with at least `capacity` bytes
+    fn buffer(&mut self, capacity: usize) -> Option<Vec<u8>> {
+        let mut len = 0;
+        // SAFETY: The caller of `InvertedIndex_RdbLoad_Ex` must ensure that `rdb` is valid
+        let data = unsafe { RedisModule_LoadStringBuffer.unwrap()(self.0, &mut len) };
+        if self.io_error() {
+            return None;
+        }
+
+        let mut buf = Vec::with_capacity(capacity.max(len));
+        if len > 0 {
+            // SAFETY: Redis returned a buffer of `len` bytes
+            buf.extend_from_slice(unsafe { std::slice::from_raw_parts(data as *const u8, len) });
+        }
+        if !data.is_null() {
+            // SAFETY: The buffer was allocated by Redis, and isn't used anymore
+            unsafe { RedisModule_Free.unwrap()(data as *mut _) };
+        }
+
+        Some(buf)
+    }
+}
+
+/// Save an inverted index to the RDB, block by block. It is loaded back by
+/// [`InvertedIndex_RdbLoad_Ex`].
+///
+/// # Safety
+///
+/// The following invariants must be upheld when calling this function:
+/// - `rdb` must be a valid pointer to a `RedisModuleIO` being saved to.
+/// - `ii` must be a valid, non NULL, pointer to an `InvertedIndex` instance.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn InvertedIndex_RdbSave(rdb: *mut RedisModuleIO, ii: *const InvertedIndex) {
+    debug_assert!(!rdb.is_null(), "rdb must not be null");
+    debug_assert!(!ii.is_null(), "ii must not be null");
+
+    // SAFETY: The caller must ensure that `ii` is a valid pointer to an `InvertedIndex`
+    let ii = unsafe { &*ii };
+    let mut w = RdbWriter(rdb);
+
+    w.unsigned(ii_dispatch!(ii, flags) as u64);
+    w.unsigned(ii_dispatch!(ii, last_doc_id).unwrap_or(0));
+    w.unsigned(ii_dispatch!(ii, unique_docs) as u64);
+    if let Some(field_mask) = field_mask(ii) {
+        w.buffer(&field_mask.to_ne_bytes());
+    } else if let InvertedIndex::Numeric(ii) = ii {
+        w.unsigned(ii.number_of_entries() as u64);
+    }
+    // The deltas of the document IDs only blocks are either raw or varints
+    w.unsigned(matches!(ii, InvertedIndex::RawDocumentIdOnly(_)) as u64);
+
+    let num_blocks = ii_dispatch!(ii, number_of_blocks);
+    w.unsigned(num_blocks as u64);
+    for i in 0..num_blocks {
+        let block = ii_dispatch!(ii, block_ref, i).expect("block index is in range");
+        w.unsigned(block.first_block_id());
+        w.unsigned(block.last_block_id());
+        w.unsigned(block.num_entries() as u64);
+        w.unsigned(block.max_freq() as u64);
+        let dense = if block.is_dense() { BLOCK_RDB_DENSE } else { 0 };
+        let packed = if block.is_packed() {
+            BLOCK_RDB_PACKED
+        } else {
+            0
+        };
+        // The last block is the one written to once the index is loaded, so it is always in the RDB
+        let data = block.data();
+        let mut offset = 0;
+        let in_segment = i + 1 < num_blocks
+            && !data.is_empty()
+            // SAFETY: `data` is valid for `data.len()` bytes
+            && unsafe { IndexSegment_Write(data.as_ptr().cast(), data.len(), &mut offset) };
+        let segment = if in_segment { BLOCK_RDB_SEGMENT } else { 0 };
+        w.unsigned(dense | packed | segment);
+        // The capacity is kept, as the sizes accounted for by the owners of the index include it
+        w.unsigned(block.capacity() as u64);
+        if in_segment {
+            w.unsigned(offset);
+            w.unsigned(data.len() as u64);
+        } else {
+            w.buffer(data);
+        }
+    }
+}
+
+/// Load an inverted index saved by [`InvertedIndex_RdbSave`]. A document IDs only index saved with
+/// another `raw_doc_id_encoding` is encoded again. The memory of the index is returned in
+/// `mem_size`.
+///
+/// Returns NULL if the RDB couldn't be read, or doesn't hold a valid index.
+///
+/// # Safety
+///
+/// The following invariant must be upheld when calling this function:
+/// - `rdb` must be a valid pointer to a `RedisModuleIO` being loaded from.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn InvertedIndex_RdbLoad_Ex(
+    rdb: *mut RedisModuleIO,
+    raw_doc_id_encoding: bool,
+    compress_floats: bool,
+    mem_size: &mut usize,
+) -> *mut InvertedIndex {
+    debug_assert!(!rdb.is_null(), "rdb must not be null");
+
+    let Some(ii) = load(&mut RdbReader(rdb), raw_doc_id_encoding, compress_floats) else {
+        return std::ptr::null_mut();
+    };
+
+    *mem_size = ii_dispatch!(&ii, memory_usage);
+    Box::into_raw(Box::new(ii))
+}
+
+/// Copy the `len` entries at `offset` of the segment being read into a vector allocated with at
+/// least `capacity` bytes, or `None` if they can't be resolved
+fn segment_buffer(offset: u64, len: usize, capacity: usize) -> Option<Vec<u8>> {
+    // SAFETY: `IndexSegment_Resolve` only reads the state of the segment being read
+    let data = unsafe { IndexSegment_Resolve(offset, len) };
+    if data.is_null() {
+        return None;
+    }
+
+    let mut buf = Vec::with_capacity(capacity.max(len));
+    // SAFETY: A resolved segment is valid for `len` bytes at `data`, until it is done being read
+    buf.extend_from_slice(unsafe { std::slice::from_raw_parts(data as *const u8, len) });
+    Some(buf)
+}
+
+/// The field mask tracked by the index, if it tracks one
+fn field_mask(ii: &InvertedIndex) -> Option<t_fieldMask> {
+    match ii {
+        InvertedIndex::Full(ii) => Some(ii.field_mask()),
+        InvertedIndex::FullWide(ii) => Some(ii.field_mask()),
+        InvertedIndex::FreqsFields(ii) => Some(ii.field_mask()),
+        InvertedIndex::FreqsFieldsWide(ii) => Some(ii.field_mask()),
+        InvertedIndex::FieldsOnly(ii) => Some(ii.field_mask()),
+        InvertedIndex::FieldsOnlyWide(ii) => Some(ii.field_mask()),
+        InvertedIndex::FieldsOffsets(ii) => Some(ii.field_mask()),
+        InvertedIndex::FieldsOffsetsWide(ii) => Some(ii.field_mask()),
+        InvertedIndex::FreqsOnly(_)
+        | InvertedIndex::OffsetsOnly(_)
+        | InvertedIndex::FreqsOffsets(_)
+        | InvertedIndex::DocumentIdOnly(_)
+        | InvertedIndex::RawDocumentIdOnly(_)
+        | InvertedIndex::Numeric(_) => None,
+    }
+}
+
+fn load(
+    r: &mut RdbReader,
+    raw_doc_id_encoding: bool,
+    compress_floats: bool,
+) -> Option<InvertedIndex> {
+    let flags = r.unsigned()? as IndexFlags;
+    // The last document ID is the one of the last block
+    let _last_doc_id = r.unsigned()?;
+    let n_unique_docs = r.unsigned()? as u32;
+
+    let mut field_mask = 0;
+    let mut number_of_entries = 0;
+    if flags & IndexFlags_Index_StoreFieldFlags != 0 {
+        let saved = r.buffer(0)?;
+        // Saved by a build with another width of field masks
+        field_mask = t_fieldMask::from_ne_bytes(saved.as_slice().try_into().ok()?);
+    } else if flags & IndexFlags_Index_StoreNumeric != 0 {
+        number_of_entries = r.unsigned()? as usize;
+    }
+    let saved_raw_doc_ids = r.unsigned()? != 0;
+
+    // The blocks are restored into an index with the encoding they were saved with
+    let mut mem_size = 0;
+    let ii = NewInvertedIndex_Ex(flags, saved_raw_doc_ids, compress_floats, &mut mem_size);
+    // SAFETY: `NewInvertedIndex_Ex` returns a valid pointer to a boxed index
+    let mut ii = *unsafe { Box::from_raw(ii) };
+
+    let num_blocks = r.unsigned()? as usize;
+    let mut blocks: Vec<IndexBlock> = Vec::with_capacity(num_blocks);
+    for _ in 0..num_blocks {
+        let first_doc_id = r.unsigned()?;
+        let last_doc_id = r.unsigned()?;
+        let mut num_entries = u16::try_from(r.unsigned()?).ok()?;
+        let max_freq = u32::try_from(r.unsigned()?).ok()?;
+        let block_flags = r.unsigned()?;
+        let capacity = r.unsigned()? as usize;
+        let buffer = if block_flags & BLOCK_RDB_SEGMENT != 0 {
+            let offset = r.unsigned()?;
+            let len = r.unsigned()? as usize;
+            segment_buffer(offset, len, capacity)
+        } else {
+            Some(r.buffer(capacity)?)
+        };
+
+        let mut dense = block_flags & BLOCK_RDB_DENSE != 0;
+        let mut packed = block_flags & BLOCK_RDB_PACKED != 0;
+        let valid_flags = block_flags & !(BLOCK_RDB_DENSE | BLOCK_RDB_PACKED | BLOCK_RDB_SEGMENT)
+            == 0
+            && (!dense
+                || matches!(
+                    ii,
+                    InvertedIndex::DocumentIdOnly(_) | InvertedIndex::RawDocumentIdOnly(_)
+                ))
+            && (!packed || matches!(ii, InvertedIndex::Numeric(_)));
+        let ordered = first_doc_id <= last_doc_id
+            && blocks
+                .last()
+                .is_none_or(|prev| prev.last_block_id() <= first_doc_id);
+        if !valid_flags || !ordered {
+            return None;
+        }
+        let buffer = buffer.unwrap_or_else(|| {
+            // The owner of the index drops the contents it loaded along with the block
+            num_entries = 0;
+            dense = false;
+            packed = false;
+            Vec::new()
+        });
+
+        blocks.push(IndexBlock::restore(
+            first_doc_id,
+            last_doc_id,
+            num_entries,
+            max_freq,
+            packed,
+            dense,
+            buffer,
+        ));
+    }
+
+    match &mut ii {
+        InvertedIndex::Full(ii) => ii.restore_blocks(blocks, n_unique_docs, field_mask),
+        InvertedIndex::FullWide(ii) => ii.restore_blocks(blocks, n_unique_docs, field_mask),
+        InvertedIndex::FreqsFields(ii) => ii.restore_blocks(blocks, n_unique_docs, field_mask),
+        InvertedIndex::FreqsFieldsWide(ii) => ii.restore_blocks(blocks, n_unique_docs, field_mask),
+        InvertedIndex::FieldsOnly(ii) => ii.restore_blocks(blocks, n_unique_docs, field_mask),
+        InvertedIndex::FieldsOnlyWide(ii) => ii.restore_blocks(blocks, n_unique_docs, field_mask),
+        InvertedIndex::FieldsOffsets(ii) => ii.restore_blocks(blocks, n_unique_docs, field_mask),
+        InvertedIndex::FieldsOffsetsWide(ii) => {
+            ii.restore_blocks(blocks, n_unique_docs, field_mask)
+        }
+        InvertedIndex::FreqsOnly(ii) => ii.restore_blocks(blocks, n_unique_docs),
+        InvertedIndex::OffsetsOnly(ii) => ii.restore_blocks(blocks, n_unique_docs),
+        InvertedIndex::FreqsOffsets(ii) => ii.restore_blocks(blocks, n_unique_docs),
+        InvertedIndex::DocumentIdOnly(ii) => ii.restore_blocks(blocks, n_unique_docs),
+        InvertedIndex::RawDocumentIdOnly(ii) => ii.restore_blocks(blocks, n_unique_docs),
+        InvertedIndex::Numeric(ii) => ii.restore_blocks(blocks, n_unique_docs, number_of_entries),
+    }
+
+    Some(match ii {
+        InvertedIndex::DocumentIdOnly(saved) if raw_doc_id_encoding => {
+            InvertedIndex::RawDocumentIdOnly(reencode_doc_ids(&saved, RawDocIdsOnly)?)
+        }
+        InvertedIndex::RawDocumentIdOnly(saved) if !raw_doc_id_encoding => {
+            InvertedIndex::DocumentIdOnly(reencode_doc_ids(&saved, DocIdsOnly)?)
+        }
+        ii => ii,
+    })
+}
+
+/// Write the document IDs of an index saved with the other document IDs only encoding again
+fn reencode_doc_ids<S, E>(
+    saved: &inverted_index::InvertedIndex<S>,
+    encoder: E,
+) -> Option<inverted_index::InvertedIndex<E>>
+where
+    S: Encoder + inverted_index::DecodedBy,
+    E: Encoder,
+{
+    let mut ii = inverted_index::InvertedIndex::new(saved.flags(), encoder);
+    let mut reader = saved.reader();
+    let mut result = RSIndexResult::term();
+    while reader.next_record(&mut result).ok()? {
+        ii.add_record(&result).ok()?;
+    }
+
+    Some(ii)
+}
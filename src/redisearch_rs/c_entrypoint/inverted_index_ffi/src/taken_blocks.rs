@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Moving the blocks of an inverted index out of it, e.g. for the cold terms of an index, and
+//! back.
+//!
+//! Every block is written as a header of its first and last document IDs (8 bytes each), the
+//! length of its encoded entries (4 bytes), its number of entries (2 bytes), its highest frequency
+//! (4 bytes) and its flags (1 byte), all little endian, followed by its encoded entries.
+
+use std::{ffi::c_char, io::Write};
+
+use buffer::{Buffer, BufferWriter};
+use inverted_index::IndexBlock;
+
+use crate::{
+    InvertedIndex,
+    rdb::{BLOCK_RDB_DENSE, BLOCK_RDB_PACKED},
+};
+
+const HEADER_SIZE: usize = 8 + 8 + 4 + 2 + 4 + 1;
+
+/// Move the blocks of the index to the end of `out`, leaving the index without any block, as the
+/// cold terms of an index are. Its counters are kept. Returns the number of bytes freed.
+///
+/// # Safety
+///
+/// The following invariants must be upheld when calling this function:
+/// - `ii` must be a valid, non NULL, pointer to an `InvertedIndex` instance.
+/// - `out` must be a valid, non NULL, pointer to an initialized `Buffer`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn InvertedIndex_TakeBlocks(
+    ii: *mut InvertedIndex,
+    out: *mut ffi::Buffer,
+) -> usize {
+    debug_assert!(!ii.is_null(), "ii must not be null");
+    debug_assert!(!out.is_null(), "out must not be null");
+
+    // SAFETY: The caller must ensure that `ii` is a valid pointer to an `InvertedIndex`
+    let ii = unsafe { &mut *ii };
+    // SAFETY: The caller must ensure that `out` is a valid pointer to a `Buffer`. `Buffer` is a
+    // transparent wrapper around `ffi::Buffer`.
+    let out = unsafe { &mut *(out as *mut Buffer) };
+
+    let mem_before = ii_dispatch!(&*ii, memory_usage);
+    let blocks = ii_dispatch!(&mut *ii, take_blocks);
+
+    let mut writer = BufferWriter::new(out);
+    for block in &blocks {
+        let dense = if block.is_dense() { BLOCK_RDB_DENSE } else { 0 };
+        let packed = if block.is_packed() {
+            BLOCK_RDB_PACKED
+        } else {
+            0
+        };
+        let data = block.data();
+
+        let mut header = [0u8; HEADER_SIZE];
+        header[0..8].copy_from_slice(&block.first_block_id().to_le_bytes());
+        header[8..16].copy_from_slice(&block.last_block_id().to_le_bytes());
+        header[16..20].copy_from_slice(&(data.len() as u32).to_le_bytes());
+        header[20..22].copy_from_slice(&block.num_entries().to_le_bytes());
+        header[22..26].copy_from_slice(&block.max_freq().to_le_bytes());
+        header[26] = (dense | packed) as u8;
+
+        writer
+            .write_all(&header)
+            .and_then(|_| writer.write_all(data))
+            .expect("writing to a buffer doesn't fail");
+    }
+    drop(blocks);
+
+    mem_before - ii_dispatch!(&*ii, memory_usage)
+}
+
+/// Give an index emptied by [`InvertedIndex_TakeBlocks`] its blocks back, from the `len` bytes it
+/// wrote at `data`. Returns the number of bytes allocated, or 0 if they hold no complete block, in
+/// which case the index is left as is.
+///
+/// # Safety
+///
+/// The following invariants must be upheld when calling this function:
+/// - `ii` must be a valid, non NULL, pointer to an `InvertedIndex` instance without any block.
+/// - `data` must be valid for reads of `len` bytes.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn InvertedIndex_RestoreBlocks(
+    ii: *mut InvertedIndex,
+    data: *const c_char,
+    len: usize,
+) -> usize {
+    debug_assert!(!ii.is_null(), "ii must not be null");
+
+    // SAFETY: The caller must ensure that `ii` is a valid pointer to an `InvertedIndex`
+    let ii = unsafe { &mut *ii };
+    if data.is_null() || len == 0 {
+        return 0;
+    }
+    // SAFETY: The caller must ensure that `data` is valid for reads of `len` bytes
+    let data = unsafe { std::slice::from_raw_parts(data as *const u8, len) };
+
+    let Some(blocks) = read_blocks(data) else {
+        return 0;
+    };
+
+    let mem_before = ii_dispatch!(&*ii, memory_usage);
+    ii_dispatch!(&mut *ii, put_blocks, blocks);
+
+    ii_dispatch!(&*ii, memory_usage) - mem_before
+}
+
+/// Read the blocks written by [`InvertedIndex_TakeBlocks`], or `None` if `data` is truncated or
+/// holds none.
+fn read_blocks(mut data: &[u8]) -> Option<Vec<IndexBlock>> {
+    let mut blocks = Vec::new();
+    while !data.is_empty() {
+        let (header, rest) = data.split_at_checked(HEADER_SIZE)?;
+        let int = |at: usize, n: usize| {
+            let mut bytes = [0u8; 8];
+            bytes[..n].copy_from_slice(&header[at..at + n]);
+            u64::from_le_bytes(bytes)
+        };
+        let len = int(16, 4) as usize;
+        let (buffer, rest) = rest.split_at_checked(len)?;
+        let flags = header[26] as u64;
+
+        blocks.push(IndexBlock::restore(
+            int(0, 8),
+            int(8, 8),
+            int(20, 2) as u16,
+            int(22, 4) as u32,
+            flags & BLOCK_RDB_PACKED != 0,
+            flags & BLOCK_RDB_DENSE != 0,
+            buffer.to_vec(),
+        ));
+        data = rest;
+    }
+
+    (!blocks.is_empty()).then_some(blocks)
+}
@@ -46,6 +46,16 @@ unsafe extern "C" fn RPProfile_IncrementCount(_r: *mut ffi::ResultProcessor) {
     unreachable!()
 }
 
+/// Stub implementation of `RPQueryIterator_Count` for the linker to not complain when running these tests.
+/// This should not be called during these tests.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn RPQueryIterator_Count(
+    _rp: *mut ffi::ResultProcessor,
+    _count: *mut usize,
+) -> std::ffi::c_int {
+    unreachable!()
+}
+
 #[test]
 fn rp_counter_new_returns_valid_pointer() {
     let counter = unsafe { RPCounter_New() };
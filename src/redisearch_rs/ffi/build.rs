@@ -68,6 +68,7 @@ fn main() {
         root.join("src").join("score_explain.h"),
         root.join("src").join("rlookup.h"),
         root.join("src").join("util").join("arr").join("arr.h"),
+        root.join("src").join("index_segment.h"),
     ];
 
     let mut bindings = bindgen::Builder::default();
@@ -6,6 +6,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include "buffer.h"
 #include "config.h"
 #include "search_ctx.h"
 #include "spec.h"
@@ -189,6 +190,18 @@ uintptr_t InvertedIndex_MemUsage(const struct InvertedIndex *ii);
  */
 uintptr_t InvertedIndex_WriteNumericEntry(struct InvertedIndex *ii, t_docId doc_id, double value);
 
+/**
+ * Pack the entries of a block of a numeric index into fixed-width columns, if that makes the
+ * block smaller. This is only meant for blocks which won't be written to anymore, so the last
+ * block of the index is never packed. The function returns the number of bytes the memory usage
+ * of the index shrank by, which is 0 if the block was left as is or the index isn't numeric.
+ *
+ * # Safety
+ * The following invariant must be upheld when calling this function:
+ * - `ii` must be a valid pointer to an `InvertedIndex` instance and cannot be NULL.
+ */
+uintptr_t InvertedIndex_PackNumericBlock(struct InvertedIndex *ii, uintptr_t block_idx);
+
 /**
  * Write a new entry to the inverted index. The function returns the number of bytes the memory
  * usage of the index grew by.
@@ -424,6 +437,39 @@ t_docId IndexBlock_LastId(const struct IndexBlock *ib);
  */
 uint16_t IndexBlock_NumEntries(const struct IndexBlock *ib);
 
+/**
+ * Get the highest term frequency of the entries in the index block. This is an upper bound on the
+ * frequency of any document of the block, for indexes storing frequencies.
+ *
+ * # Safety
+ *
+ * The following invariant must be upheld when calling this function:
+ * - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+ */
+uint32_t IndexBlock_MaxFreq(const struct IndexBlock *ib);
+
+/**
+ * Check if the entries of the index block were packed into fixed-width columns by
+ * [`InvertedIndex_PackNumericBlock`].
+ *
+ * # Safety
+ *
+ * The following invariant must be upheld when calling this function:
+ * - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+ */
+bool IndexBlock_IsPacked(const struct IndexBlock *ib);
+
+/**
+ * Check if the index block was sealed as a bitmap of its document IDs. Only the document IDs only
+ * encodings store dense blocks this way.
+ *
+ * # Safety
+ *
+ * The following invariant must be upheld when calling this function:
+ * - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+ */
+bool IndexBlock_IsDense(const struct IndexBlock *ib);
+
 /**
  * Get a pointer to the raw data of the index block. This is used by some C tests.
  *
@@ -434,6 +480,27 @@ uint16_t IndexBlock_NumEntries(const struct IndexBlock *ib);
  */
 const char *IndexBlock_Data(const struct IndexBlock *ib);
 
+/**
+ * Get the number of bytes of the encoded data of the index block.
+ *
+ * # Safety
+ *
+ * The following invariant must be upheld when calling this function:
+ * - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+ */
+uintptr_t IndexBlock_Len(const struct IndexBlock *ib);
+
+/**
+ * Get the number of bytes allocated for the encoded data of the index block. The difference with
+ * [`IndexBlock_Len`] is memory the block reserved for its next entries.
+ *
+ * # Safety
+ *
+ * The following invariant must be upheld when calling this function:
+ * - `ib` must be a valid pointer to an `IndexBlock` instance and cannot be NULL.
+ */
+uintptr_t IndexBlock_Cap(const struct IndexBlock *ib);
+
 /**
  * Create a new inverted index reader for the given inverted index and filter. The returned pointer
  * must be freed using [`IndexReader_Free`] when no longer needed.
@@ -542,6 +609,68 @@ bool IndexReader_Seek(struct IndexReader *ir,
                       t_docId doc_id,
                       RSIndexResult *res);
 
+/**
+ * Get the block the index reader is currently positioned at. After a successful read or seek,
+ * this is the block holding the last entry returned. NULL is returned if the index is empty.
+ *
+ * # Safety
+ *
+ * The following invariant must be upheld when calling this function:
+ * - `ir` must be a valid, non NULL, pointer to an `IndexReader` instance.
+ */
+const struct IndexBlock *IndexReader_CurrentBlock(const struct IndexReader *ir);
+
+/**
+ * Get the highest term frequency of the entries of the index read by the index reader. This is an
+ * upper bound on the frequency of any document of the index, for indexes storing frequencies.
+ *
+ * # Safety
+ *
+ * The following invariant must be upheld when calling this function:
+ * - `ir` must be a valid, non NULL, pointer to an `IndexReader` instance.
+ */
+uint32_t IndexReader_MaxFreq(const struct IndexReader *ir);
+
+/**
+ * Decode the document IDs of up to `cap` next entries of the index reader into `out`, without
+ * moving the reader. `scratch` is used to decode the entries, and should be a result of the type
+ * the reader yields. Returns the number of IDs written to `out`.
+ *
+ * # Safety
+ *
+ * The following invariants must be upheld when calling this function:
+ * - `ir` must be a valid, non NULL, pointer to an `IndexReader` instance.
+ * - `scratch` must be a valid pointer to an `RSIndexResult` instance.
+ * - `out` must be a valid pointer to an array of at least `cap` document IDs, unless `cap` is 0.
+ */
+uintptr_t IndexReader_PeekIds(const struct IndexReader *ir,
+                              RSIndexResult *scratch,
+                              t_docId *out,
+                              uintptr_t cap);
+
+/**
+ * Read the document IDs of up to `cap` next entries of the index reader into `out`. With
+ * `skip_multi`, the entries of the same document as the previous one (`prev_id` for the first) are
+ * skipped. `res` is set to the last entry read. Returns the number of IDs written to `out`, which
+ * is less than `cap` only at the end of the index.
+ *
+ * The entries are read in a loop specialized for the encoding and the filter of the reader, and
+ * the unfiltered numeric reader skips over their values without decoding them.
+ *
+ * # Safety
+ *
+ * The following invariants must be upheld when calling this function:
+ * - `ir` must be a valid, non NULL, pointer to an `IndexReader` instance.
+ * - `res` must be a valid pointer to an `RSIndexResult` instance of the type the reader yields.
+ * - `out` must be a valid pointer to an array of at least `cap` document IDs, unless `cap` is 0.
+ */
+uintptr_t IndexReader_NextIds(struct IndexReader *ir,
+                              RSIndexResult *res,
+                              t_docId prev_id,
+                              bool skip_multi,
+                              t_docId *out,
+                              uintptr_t cap);
+
 /**
  * Check if the index reader can return multiple entries for the same document ID.
  *
@@ -597,6 +726,60 @@ void IndexReader_SwapIndex(struct IndexReader *ir, const struct InvertedIndex *i
  */
 bool IndexReader_Revalidate(const struct IndexReader *ir);
 
+/**
+ * Save an inverted index to the RDB, block by block. It is loaded back by
+ * [`InvertedIndex_RdbLoad_Ex`].
+ *
+ * # Safety
+ *
+ * The following invariants must be upheld when calling this function:
+ * - `rdb` must be a valid pointer to a `RedisModuleIO` being saved to.
+ * - `ii` must be a valid, non NULL, pointer to an `InvertedIndex` instance.
+ */
+void InvertedIndex_RdbSave(RedisModuleIO *rdb, const struct InvertedIndex *ii);
+
+/**
+ * Load an inverted index saved by [`InvertedIndex_RdbSave`]. A document IDs only index saved with
+ * another `raw_doc_id_encoding` is encoded again. The memory of the index is returned in
+ * `mem_size`.
+ *
+ * Returns NULL if the RDB couldn't be read, or doesn't hold a valid index.
+ *
+ * # Safety
+ *
+ * The following invariant must be upheld when calling this function:
+ * - `rdb` must be a valid pointer to a `RedisModuleIO` being loaded from.
+ */
+struct InvertedIndex *InvertedIndex_RdbLoad_Ex(RedisModuleIO *rdb,
+                                               bool raw_doc_id_encoding,
+                                               bool compress_floats,
+                                               uintptr_t *mem_size);
+
+/**
+ * Move the blocks of the index to the end of `out`, leaving the index without any block, as the
+ * cold terms of an index are. Its counters are kept. Returns the number of bytes freed.
+ *
+ * # Safety
+ *
+ * The following invariants must be upheld when calling this function:
+ * - `ii` must be a valid, non NULL, pointer to an `InvertedIndex` instance.
+ * - `out` must be a valid, non NULL, pointer to an initialized `Buffer`.
+ */
+uintptr_t InvertedIndex_TakeBlocks(struct InvertedIndex *ii, Buffer *out);
+
+/**
+ * Give an index emptied by [`InvertedIndex_TakeBlocks`] its blocks back, from the `len` bytes it
+ * wrote at `data`. Returns the number of bytes allocated, or 0 if they hold no complete block, in
+ * which case the index is left as is.
+ *
+ * # Safety
+ *
+ * The following invariants must be upheld when calling this function:
+ * - `ii` must be a valid, non NULL, pointer to an `InvertedIndex` instance without any block.
+ * - `data` must be valid for reads of `len` bytes.
+ */
+uintptr_t InvertedIndex_RestoreBlocks(struct InvertedIndex *ii, const char *data, uintptr_t len);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -609,3 +792,9 @@ bool IndexReader_Revalidate(const struct IndexReader *ir);
 inline static InvertedIndex *NewInvertedIndex(IndexFlags flags, size_t *memsize) {
   return NewInvertedIndex_Ex(flags, RSGlobalConfig.invertedIndexRawDocidEncoding, RSGlobalConfig.numericCompress, memsize);
 }
+
+// Load an inverted index saved by `InvertedIndex_RdbSave`, with the encodings of the running
+// configuration. Returns NULL on a short read.
+inline static InvertedIndex *InvertedIndex_RdbLoad(RedisModuleIO *rdb, size_t *memsize) {
+  return InvertedIndex_RdbLoad_Ex(rdb, RSGlobalConfig.invertedIndexRawDocidEncoding, RSGlobalConfig.numericCompress, memsize);
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Dense blocks of the document IDs only encoders.
+//!
+//! A sealed block holding at least one of every [`DENSE_BLOCK_MAX_GAP`] consecutive document IDs
+//! is stored as a bitmap of its IDs instead, when that isn't larger than its encoded entries. The
+//! bitmap is made of 64-bit little endian words, the first one starting at the word aligned ID
+//! at or before the first document ID of the block.
+//!
+//! The reader position is the offset of the word holding the next ID. When it is the offset of a
+//! word, the next ID is the first one of the word. One past the offset of a word means there are
+//! IDs left in the word after the last one read, which is the base the decoders get.
+
+use std::io::Cursor;
+
+use ffi::t_docId;
+
+use crate::{Decoder, IndexBlock, RSIndexResult};
+
+/// A block is dense if it holds at least one of every `DENSE_BLOCK_MAX_GAP` consecutive IDs
+pub const DENSE_BLOCK_MAX_GAP: u64 = 8;
+
+const WORD_BITS: u64 = 64;
+const WORD_BYTES: usize = std::mem::size_of::<u64>();
+
+/// The document ID of the first bit of the bitmap of `block`
+const fn first_word_base(block: &IndexBlock) -> t_docId {
+    block.first_doc_id & !(WORD_BITS - 1)
+}
+
+/// Check if `block` qualifies to be stored as a bitmap. Returns the size of the bitmap if so.
+fn dense_size(block: &IndexBlock) -> Option<usize> {
+    let span = block.last_doc_id - block.first_doc_id;
+    if block.num_entries == 0 || span >= block.num_entries as u64 * DENSE_BLOCK_MAX_GAP {
+        return None;
+    }
+
+    let size = ((block.last_doc_id - first_word_base(block)) / WORD_BITS + 1) as usize * WORD_BYTES;
+    (size <= block.buffer.len()).then_some(size)
+}
+
+/// Store the entries of a sealed `block` as a bitmap of their IDs, if it is dense enough. The
+/// bitmap is written in place, so the capacity accounted for by the writers of the block stays the
+/// same until the GC repairs the block. Returns `false` if the block was left as is.
+pub fn densify<D: Decoder>(decoder: &D, block: &mut IndexBlock) -> bool {
+    if block.dense || block.packed {
+        return false;
+    }
+    let Some(size) = dense_size(block) else {
+        return false;
+    };
+
+    let base = first_word_base(block);
+    let mut words = vec![0u64; size / WORD_BYTES];
+    {
+        let mut cursor = Cursor::new(block.buffer.as_slice());
+        let mut result = D::base_result();
+        let mut last_doc_id = block.first_doc_id;
+        while (cursor.position() as usize) < block.buffer.len() {
+            let delta_base = D::base_id(block, last_doc_id);
+            if decoder
+                .decode(&mut cursor, delta_base, &mut result)
+                .is_err()
+            {
+                return false;
+            }
+            last_doc_id = result.doc_id;
+
+            let bit = result.doc_id - base;
+            words[(bit / WORD_BITS) as usize] |= 1 << (bit % WORD_BITS);
+        }
+    }
+
+    block.buffer.clear();
+    for word in words {
+        block.buffer.extend_from_slice(&word.to_le_bytes());
+    }
+    block.dense = true;
+
+    true
+}
+
+#[inline(always)]
+fn load_word(buffer: &[u8], w: usize) -> std::io::Result<u64> {
+    let Some(bytes) = buffer.get(w * WORD_BYTES..(w + 1) * WORD_BYTES) else {
+        return Err(std::io::Error::new(
+            std::io::ErrorKind::UnexpectedEof,
+            "failed to fill whole buffer",
+        ));
+    };
+
+    Ok(u64::from_le_bytes(bytes.try_into().unwrap()))
+}
+
+/// Decode the next document ID of a dense `block`. `base` is the last document ID read.
+#[inline(always)]
+pub fn decode(
+    block: &IndexBlock,
+    cursor: &mut Cursor<&[u8]>,
+    base: t_docId,
+    result: &mut RSIndexResult,
+) -> std::io::Result<()> {
+    let buffer = *cursor.get_ref();
+    let pos = cursor.position() as usize;
+    let first_word_base = first_word_base(block);
+
+    let mut w = pos / WORD_BYTES;
+    let mut word = load_word(buffer, w)?;
+    if !pos.is_multiple_of(WORD_BYTES) {
+        // Only the IDs after the last one read are left in this word
+        let bit = base + 1 - (first_word_base + w as u64 * WORD_BITS);
+        word = if bit < WORD_BITS {
+            word & (u64::MAX << bit)
+        } else {
+            0
+        };
+    }
+    while word == 0 {
+        w += 1;
+        word = load_word(buffer, w)?;
+    }
+
+    result.doc_id = first_word_base + w as u64 * WORD_BITS + word.trailing_zeros() as u64;
+
+    word &= word - 1;
+    let next = if word != 0 {
+        w * WORD_BYTES + 1
+    } else {
+        (w + 1) * WORD_BYTES
+    };
+    cursor.set_position(next as u64);
+
+    Ok(())
+}
+
+/// Like [`decode`], but skip to the first ID equal or greater than `target`, jumping straight to
+/// the word holding it. Returns `false` if the block has no such ID.
+#[inline(always)]
+pub fn seek(
+    block: &IndexBlock,
+    cursor: &mut Cursor<&[u8]>,
+    base: t_docId,
+    target: t_docId,
+    result: &mut RSIndexResult,
+) -> std::io::Result<bool> {
+    let pos = cursor.position() as usize;
+    let first_word_base = first_word_base(block);
+
+    // The next ID the reader would look at
+    let next = if pos.is_multiple_of(WORD_BYTES) {
+        first_word_base + (pos / WORD_BYTES) as u64 * WORD_BITS
+    } else {
+        base + 1
+    };
+
+    let mut base = base;
+    if target > next {
+        let w = ((target - first_word_base) / WORD_BITS) as usize;
+        cursor.set_position((w * WORD_BYTES + 1) as u64);
+        base = target - 1;
+    }
+
+    match decode(block, cursor, base, result) {
+        Ok(()) => Ok(true),
+        Err(err) if err.kind() == std::io::ErrorKind::UnexpectedEof => {
+            // Like the other decoders, a failed seek consumes the block
+            cursor.set_position(cursor.get_ref().len() as u64);
+            Ok(false)
+        }
+        Err(err) => Err(err),
+    }
+}
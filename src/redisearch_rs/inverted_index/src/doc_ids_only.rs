@@ -12,7 +12,7 @@ use std::io::{Cursor, Seek, Write};
 use ffi::t_docId;
 use varint::VarintEncode;
 
-use crate::{DecodedBy, Decoder, Encoder, RSIndexResult, TermDecoder};
+use crate::{DecodedBy, Decoder, Encoder, IndexBlock, RSIndexResult, TermDecoder, dense};
 
 /// Encode and decode only the delta document ID of a record, without any other data.
 /// The delta is encoded using [varint encoding](varint).
@@ -32,6 +32,10 @@ impl Encoder for DocIdsOnly {
         let bytes_written = delta.write_as_varint(&mut writer)?;
         Ok(bytes_written)
     }
+
+    fn seal(&self, block: &mut IndexBlock) -> bool {
+        dense::densify(self, block)
+    }
 }
 
 impl DecodedBy for DocIdsOnly {
@@ -59,6 +63,36 @@ impl Decoder for DocIdsOnly {
     fn base_result<'index>() -> RSIndexResult<'index> {
         RSIndexResult::term()
     }
+    #[inline(always)]
+    fn decode_in_block<'index>(
+        &self,
+        block: &IndexBlock,
+        cursor: &mut Cursor<&'index [u8]>,
+        base: t_docId,
+        result: &mut RSIndexResult<'index>,
+    ) -> std::io::Result<()> {
+        if block.dense {
+            dense::decode(block, cursor, base, result)
+        } else {
+            self.decode(cursor, base, result)
+        }
+    }
+
+    #[inline(always)]
+    fn seek_in_block<'index>(
+        &self,
+        block: &IndexBlock,
+        cursor: &mut Cursor<&'index [u8]>,
+        base: t_docId,
+        target: t_docId,
+        result: &mut RSIndexResult<'index>,
+    ) -> std::io::Result<bool> {
+        if block.dense {
+            dense::seek(block, cursor, base, target, result)
+        } else {
+            self.seek(cursor, base, target, result)
+        }
+    }
 }
 
 impl TermDecoder for DocIdsOnly {}
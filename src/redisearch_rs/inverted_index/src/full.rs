@@ -26,6 +26,12 @@ use crate::{
 ///
 /// The offsets themselves are then written directly.
 ///
+/// The offsets are not decoded with the record: the decoded term borrows them from the block, and
+/// seeking past a record skips them by its offsets length. Only the readers of the offsets, such as
+/// the slop check and the highlighter, decode them. They are kept inline rather than in a stream of
+/// their own, as a block is read from a single cursor position: a record would need to hold the
+/// start of its offsets in the other stream, growing the stream it was moved out of.
+///
 /// This encoder only supports delta values that fit in a `u32`.
 #[derive(Clone, Copy, Default)]
 pub struct Full;
@@ -199,7 +205,7 @@ impl Decoder for Full {
 /// The delta, frequency, and offsets lengths are encoded using [qint encoding](qint).
 /// The field mask is then encoded using [varint encoding](varint).
 ///
-/// The offsets themselves are then written directly.
+/// The offsets themselves are then written directly, and decoded lazily as for [`Full`].
 ///
 /// This encoder only supports delta values that fit in a `u32`.
 #[derive(Clone, Copy, Default)]
@@ -1095,9 +1095,12 @@ impl<'index> RSIndexResult<'index> {
                 self.freq += child.freq;
                 self.field_mask |= child.field_mask;
 
-                // SAFETY: we know both arguments are valid `RSIndexResult` types
-                unsafe {
-                    RSYieldableMetric_Concat(&mut self.metrics, child.metrics);
+                // Most children have no metrics, which spares the aggregating iterators a C call
+                if !child.metrics.is_null() {
+                    // SAFETY: we know both arguments are valid `RSIndexResult` types
+                    unsafe {
+                        RSYieldableMetric_Concat(&mut self.metrics, child.metrics);
+                    }
                 }
             }
             RSResultData::Term(_)
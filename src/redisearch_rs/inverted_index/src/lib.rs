@@ -29,6 +29,7 @@ use smallvec::SmallVec;
 
 pub mod controlled_cursor;
 pub mod debug;
+mod dense;
 pub mod doc_ids_only;
 pub mod fields_offsets;
 pub mod fields_only;
@@ -143,6 +144,15 @@ impl NumericFilter {
     }
 }
 
+/// The number of blocks an index writes with the same entries budget. Every time an index grows by
+/// this many blocks, the budget of its new blocks grows by another
+/// [`Encoder::RECOMMENDED_BLOCK_ENTRIES`], up to [`Encoder::MAX_BLOCK_SCALE`] times.
+const BLOCK_GROWTH_BLOCKS: usize = 16;
+
+/// Once a block holds [`Encoder::RECOMMENDED_BLOCK_ENTRIES`] entries, it is also full when its
+/// buffer reaches this size in bytes. This keeps the blocks of wide encodings cheap to decode.
+const MAX_BLOCK_BYTES: usize = 16 * 1024;
+
 /// Encoder to write a record into an index
 pub trait Encoder: Clone {
     /// Document ids are represented as `u64`s and stored using delta-encoding.
@@ -163,6 +173,11 @@ pub trait Encoder: Clone {
     /// The suggested number of entries that can be written in a single block. Defaults to 100.
     const RECOMMENDED_BLOCK_ENTRIES: u16 = 100;
 
+    /// The maximal number of times [`Encoder::RECOMMENDED_BLOCK_ENTRIES`] is scaled up for the
+    /// blocks of an index holding many blocks. `1` keeps all blocks at the recommended size.
+    /// Defaults to 8.
+    const MAX_BLOCK_SCALE: u16 = 8;
+
     /// Write the record to the writer and return the number of bytes written. The delta is the
     /// pre-computed difference between the current document ID and the last document ID written.
     fn encode<W: Write + Seek>(
@@ -176,6 +191,26 @@ pub trait Encoder: Clone {
     fn delta_base(block: &IndexBlock) -> t_docId {
         block.last_doc_id
     }
+
+    /// Re-encode the entries of a block which won't be written to anymore in a more compact
+    /// layout, which only the decoder of this encoder reads (see [`IndexBlock::is_packed`]). A block
+    /// repaired from a packed block gets that block as `packed_from`, to be packed the same way.
+    ///
+    /// Returns `false` when the block is left as is, which is always the case for encoders without
+    /// such a layout.
+    fn pack(&self, _block: &mut IndexBlock, _packed_from: Option<&IndexBlock>) -> bool {
+        false
+    }
+
+    /// Called once a write filled `block`, which won't be written to anymore. Encoders can store
+    /// the entries of the block in a layout only their decoder reads, such as a bitmap of its
+    /// document IDs (see [`IndexBlock::is_dense`]), as long as the capacity of the block buffer
+    /// stays the same.
+    ///
+    /// Returns `false` when the block is left as is, which is the default.
+    fn seal(&self, _block: &mut IndexBlock) -> bool {
+        false
+    }
 }
 
 /// Trait to model that an encoder can be decoded by a decoder.
@@ -247,6 +282,35 @@ pub trait Decoder {
     fn base_id(_block: &IndexBlock, last_doc_id: t_docId) -> t_docId {
         last_doc_id
     }
+
+    /// Like [`Decoder::decode`], for a cursor over the buffer of `block`. Decoders reading blocks
+    /// sealed or packed by their encoder (see [`Encoder::seal`] and [`Encoder::pack`]) override
+    /// this to decode those.
+    #[inline(always)]
+    fn decode_in_block<'index>(
+        &self,
+        _block: &IndexBlock,
+        cursor: &mut Cursor<&'index [u8]>,
+        base: t_docId,
+        result: &mut RSIndexResult<'index>,
+    ) -> std::io::Result<()> {
+        self.decode(cursor, base, result)
+    }
+
+    /// Like [`Decoder::seek`], for a cursor over the buffer of `block`. Decoders reading blocks
+    /// sealed or packed by their encoder (see [`Encoder::seal`] and [`Encoder::pack`]) override
+    /// this to seek in those.
+    #[inline(always)]
+    fn seek_in_block<'index>(
+        &self,
+        _block: &IndexBlock,
+        cursor: &mut Cursor<&'index [u8]>,
+        base: t_docId,
+        target: t_docId,
+        result: &mut RSIndexResult<'index>,
+    ) -> std::io::Result<bool> {
+        self.seek(cursor, base, target, result)
+    }
 }
 
 /// Marker trait for decoders producing numeric results.
@@ -297,6 +361,19 @@ pub struct IndexBlock {
     /// The total number of non-unique entries in this block
     num_entries: u16,
 
+    /// The highest frequency of the entries in this block. This is an upper bound on the term
+    /// frequency of any document of the block, used for block-max pruning of top-k queries. It is
+    /// only meaningful for indexes storing frequencies.
+    max_freq: u32,
+
+    /// Whether the entries of this block were re-encoded by [`Encoder::pack`] once the block was
+    /// sealed. A packed block isn't written to, nor merged with other blocks, anymore.
+    packed: bool,
+
+    /// Whether this block is a bitmap of its document IDs, stored by [`Encoder::seal`]. Like a
+    /// packed block, a dense block isn't written to, nor merged with other blocks, anymore.
+    dense: bool,
+
     /// The encoded entries in this block
     buffer: Vec<u8>,
 }
@@ -314,6 +391,9 @@ impl<'de> Deserialize<'de> for IndexBlock {
             first_doc_id: t_docId,
             last_doc_id: t_docId,
             num_entries: u16,
+            max_freq: u32,
+            packed: bool,
+            dense: bool,
             buffer: Vec<u8>,
         }
 
@@ -328,6 +408,9 @@ impl<'de> Deserialize<'de> for IndexBlock {
             first_doc_id: ib.first_doc_id,
             last_doc_id: ib.last_doc_id,
             num_entries: ib.num_entries,
+            max_freq: ib.max_freq,
+            packed: ib.packed,
+            dense: ib.dense,
             buffer: ib.buffer,
         })
     }
@@ -364,6 +447,9 @@ impl IndexBlock {
             first_doc_id: doc_id,
             last_doc_id: doc_id,
             num_entries: 0,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             buffer: Vec::new(),
         };
         let buf_cap = this.buffer.capacity();
@@ -388,11 +474,58 @@ impl IndexBlock {
         self.num_entries
     }
 
+    /// Get the highest frequency of the entries in this block.
+    pub const fn max_freq(&self) -> u32 {
+        self.max_freq
+    }
+
+    /// Check if the entries of this block were packed by the encoder of its index (see
+    /// [`Encoder::pack`]).
+    pub const fn is_packed(&self) -> bool {
+        self.packed
+    }
+
+    /// Check if this block is stored as a bitmap of its document IDs (see [`Encoder::seal`]).
+    pub const fn is_dense(&self) -> bool {
+        self.dense
+    }
+
+    /// Restore a block saved with its encoded entries, e.g. to an RDB. The entries are expected to
+    /// be encoded by the encoder of the index the block is restored into.
+    pub fn restore(
+        first_doc_id: t_docId,
+        last_doc_id: t_docId,
+        num_entries: u16,
+        max_freq: u32,
+        packed: bool,
+        dense: bool,
+        buffer: Vec<u8>,
+    ) -> Self {
+        // Counter balances the decrement in the `Drop` implementation
+        TOTAL_BLOCKS.fetch_add(1, atomic::Ordering::Relaxed);
+
+        Self {
+            first_doc_id,
+            last_doc_id,
+            num_entries,
+            max_freq,
+            packed,
+            dense,
+            buffer,
+        }
+    }
+
     /// Get a reference to the encoded data in this block. This is only needed for some C tests.
     pub fn data(&self) -> &[u8] {
         &self.buffer
     }
 
+    /// Get the number of bytes allocated for the encoded data of this block, which is at least
+    /// the length of [`IndexBlock::data`].
+    pub fn capacity(&self) -> usize {
+        self.buffer.capacity()
+    }
+
     const fn writer(&mut self) -> ControlledCursor<'_> {
         ControlledCursor::new(&mut self.buffer)
     }
@@ -424,7 +557,7 @@ impl IndexBlock {
 
         while self.buffer.len() as u64 > cursor.position() {
             let base = D::base_id(self, last_read_doc_id.unwrap_or(self.first_doc_id));
-            decoder.decode(&mut cursor, base, &mut result)?;
+            decoder.decode_in_block(self, &mut cursor, base, &mut result)?;
 
             if doc_exist(result.doc_id) {
                 if let Some(repair) = repair.as_mut() {
@@ -452,6 +585,18 @@ impl IndexBlock {
                 n_unique_docs_removed: unique_read,
             }))
         } else if block_changed {
+            if self.packed || self.dense {
+                // Store the remaining entries the same way again, which a repair shouldn't grow
+                let encoder = &tmp_inverted_index.encoder;
+                for block in &mut tmp_inverted_index.blocks {
+                    if self.packed {
+                        encoder.pack(block, Some(self));
+                    } else if encoder.seal(block) {
+                        block.buffer.shrink_to_fit();
+                    }
+                }
+            }
+
             Ok(Some(RepairType::Replace {
                 blocks: tmp_inverted_index.blocks.into(),
                 n_unique_docs_removed: unique_read - unique_write,
@@ -576,6 +721,7 @@ impl<E: Encoder> InvertedIndex<E> {
         debug_assert!(block.num_entries.saturating_add(1) < u16::MAX);
         block.num_entries += 1;
         block.last_doc_id = doc_id;
+        block.max_freq = block.max_freq.max(record.freq);
 
         // We took ownership of the block so put it back
         self.add_block(block);
@@ -600,14 +746,23 @@ impl<E: Encoder> InvertedIndex<E> {
             || (
                 // If the block is full
                 !same_doc
-                    && self
-                        .blocks
-                        .last()
-                        .expect("we just confirmed there are blocks")
-                        .num_entries
-                        >= E::RECOMMENDED_BLOCK_ENTRIES
+                    && self.block_is_full(
+                        self.blocks
+                            .last()
+                            .expect("we just confirmed there are blocks"),
+                    )
             )
+            // A packed or dense block can't be written to. The GC might have deleted the blocks
+            // after it.
+            || self.blocks.last().is_some_and(|b| b.packed || b.dense)
         {
+            if let Some(last) = self.blocks.last_mut()
+                && self.encoder.seal(last)
+            {
+                // Readers positioned in this block need to find their position again
+                self.gc_marker.fetch_add(1, atomic::Ordering::Relaxed);
+            }
+
             IndexBlock::new(doc_id)
         } else {
             (
@@ -619,6 +774,45 @@ impl<E: Encoder> InvertedIndex<E> {
         }
     }
 
+    /// The number of entries the blocks of this index can hold. Small indexes use the recommended
+    /// number of entries of the encoder, while larger ones grow their blocks with the number of
+    /// blocks they hold so that reads and seeks have fewer block boundaries to cross.
+    fn block_capacity(&self) -> usize {
+        let scale = (self.blocks.len() / BLOCK_GROWTH_BLOCKS + 1).min(E::MAX_BLOCK_SCALE as usize);
+
+        E::RECOMMENDED_BLOCK_ENTRIES as usize * scale.max(1)
+    }
+
+    /// Pack the entries of a block which isn't written to anymore into a more compact layout, if
+    /// the encoder has one (see [`Encoder::pack`]). The block being written to, which is the last
+    /// one, is never packed. Returns by how much memory shrank, which is 0 if the block was left as
+    /// is.
+    pub fn pack_block(&mut self, index: usize) -> usize {
+        if index + 1 >= self.blocks.len() {
+            return 0;
+        }
+
+        let block = &mut self.blocks[index];
+        let buf_cap = block.buffer.capacity();
+        if !self.encoder.pack(block, None) {
+            return 0;
+        }
+
+        // Readers positioned in this block need to find their position again
+        self.gc_marker.fetch_add(1, atomic::Ordering::Relaxed);
+
+        buf_cap - block.buffer.capacity()
+    }
+
+    /// Check if no more entries should be written to `block`. A block always takes the recommended
+    /// number of entries of the encoder. Past that, it takes entries until the capacity of the index
+    /// is reached or its buffer reaches [`MAX_BLOCK_BYTES`].
+    fn block_is_full(&self, block: &IndexBlock) -> bool {
+        block.num_entries >= E::RECOMMENDED_BLOCK_ENTRIES
+            && (block.num_entries as usize >= self.block_capacity()
+                || block.buffer.len() >= MAX_BLOCK_BYTES)
+    }
+
     /// Add a block back to the index. This allows us to control the growth strategy used by the
     /// `blocks` vector.
     fn add_block(&mut self, block: IndexBlock) {
@@ -674,6 +868,43 @@ impl<E: Encoder> InvertedIndex<E> {
         self.blocks.get(index)
     }
 
+    /// Replace the blocks of this index with blocks restored from another index holding
+    /// `n_unique_docs` documents (see [`IndexBlock::restore`]). The blocks are expected to be
+    /// ordered by document ID and not overlap.
+    pub fn restore_blocks(&mut self, blocks: Vec<IndexBlock>, n_unique_docs: u32) {
+        debug_assert!(
+            blocks.is_sorted_by(|a, b| a.last_doc_id <= b.first_doc_id),
+            "blocks must be sorted and not overlap"
+        );
+
+        self.blocks = blocks;
+        self.n_unique_docs = n_unique_docs;
+        self.gc_marker.fetch_add(1, atomic::Ordering::Relaxed);
+    }
+
+    /// Move the blocks out of this index, e.g. to store them elsewhere while the index isn't
+    /// read. The counters of the index are kept, and the blocks are given back by
+    /// [`InvertedIndex::put_blocks`].
+    pub fn take_blocks(&mut self) -> Vec<IndexBlock> {
+        // Readers paused on this index need to find their position again once the blocks are back
+        self.gc_marker.fetch_add(1, atomic::Ordering::Relaxed);
+        std::mem::take(&mut self.blocks)
+    }
+
+    /// Give back the blocks taken by [`InvertedIndex::take_blocks`] to this index, which has no
+    /// blocks meanwhile.
+    pub fn put_blocks(&mut self, blocks: Vec<IndexBlock>) {
+        debug_assert!(self.blocks.is_empty(), "the index must not have any block");
+
+        self.blocks = blocks;
+        self.gc_marker.fetch_add(1, atomic::Ordering::Relaxed);
+    }
+
+    /// Get the highest frequency of the entries in this index. See [`IndexBlock::max_freq`].
+    pub fn max_freq(&self) -> u32 {
+        self.blocks.iter().map(|b| b.max_freq).max().unwrap_or(0)
+    }
+
     /// Get the current GC marker of this index. This is only used by the some C tests.
     pub fn gc_marker(&self) -> u32 {
         self.gc_marker.load(atomic::Ordering::Relaxed)
@@ -867,11 +1098,126 @@ impl<E: Encoder + DecodedBy> InvertedIndex<E> {
             }
         }
 
+        self.merge_blocks(&mut info);
+
         self.blocks.shrink_to_fit();
         self.gc_marker_inc();
 
         info
     }
+
+    /// Merge adjacent blocks left under-filled by a garbage collection, as long as the merged blocks
+    /// stay within the capacity of the index. Indexes with no more than [`BLOCK_GROWTH_BLOCKS`]
+    /// blocks keep the blocks they have. The last block is never merged since it is still being
+    /// written to.
+    fn merge_blocks(&mut self, info: &mut GcApplyInfo) {
+        if self.blocks.len() <= BLOCK_GROWTH_BLOCKS {
+            return;
+        }
+
+        let capacity = self.block_capacity();
+        let last_block = self
+            .blocks
+            .pop()
+            .expect("we just confirmed there are blocks");
+
+        let mut tmp_blocks = Vec::with_capacity(self.blocks.len() + 1);
+        std::mem::swap(&mut self.blocks, &mut tmp_blocks);
+
+        for block in tmp_blocks {
+            let merge_into = match self.blocks.last_mut() {
+                Some(prev) if Self::can_merge(prev, &block, capacity) => prev,
+                _ => {
+                    self.blocks.push(block);
+                    continue;
+                }
+            };
+
+            let prev_cap = merge_into.buffer.capacity();
+            match Self::append_block(&self.encoder, merge_into, &block) {
+                Ok(()) => {
+                    info.bytes_freed += IndexBlock::SIZE + block.buffer.capacity() + prev_cap;
+                    info.bytes_allocated += merge_into.buffer.capacity();
+                }
+                Err(_) => {
+                    // Keep the block as it is. It will be read, and reported, as any other block.
+                    self.blocks.push(block);
+                }
+            }
+        }
+
+        self.blocks.push(last_block);
+    }
+
+    /// Check if the entries of `block` can be appended to `prev` without going over `capacity`,
+    /// [`MAX_BLOCK_BYTES`], or the largest delta the encoder can hold.
+    fn can_merge(prev: &IndexBlock, block: &IndexBlock, capacity: usize) -> bool {
+        !prev.packed
+            && !prev.dense
+            && !block.packed
+            && !block.dense
+            && prev.num_entries as usize + block.num_entries as usize <= capacity
+            && prev.buffer.len() + block.buffer.len() <= MAX_BLOCK_BYTES
+            // No entry of `block` is further from the base of `prev` than its last one
+            && E::Delta::from_u64(block.last_doc_id - E::delta_base(prev)).is_some()
+    }
+
+    /// Append the entries of `block` to `prev` by re-encoding them relative to the entries of
+    /// `prev`. On error, `prev` is left as it was.
+    fn append_block(encoder: &E, prev: &mut IndexBlock, block: &IndexBlock) -> std::io::Result<()> {
+        let (last_doc_id, num_entries) = (prev.last_doc_id, prev.num_entries);
+
+        match Self::encode_appended(encoder, prev, block) {
+            Ok(appended) => {
+                prev.buffer.extend_from_slice(&appended);
+                prev.buffer.shrink_to_fit();
+                prev.max_freq = prev.max_freq.max(block.max_freq);
+
+                Ok(())
+            }
+            Err(err) => {
+                prev.last_doc_id = last_doc_id;
+                prev.num_entries = num_entries;
+
+                Err(err)
+            }
+        }
+    }
+
+    /// Encode the entries of `block` as if they were written to `prev` and return the bytes to
+    /// append to its buffer. The last document ID and number of entries of `prev` are updated as
+    /// the entries are encoded.
+    fn encode_appended(
+        encoder: &E,
+        prev: &mut IndexBlock,
+        block: &IndexBlock,
+    ) -> std::io::Result<Vec<u8>> {
+        let mut cursor: Cursor<&[u8]> = Cursor::new(&block.buffer);
+        let mut writer = Cursor::new(Vec::with_capacity(block.buffer.len()));
+        let mut last_read_doc_id = None;
+        let decoder = E::decoder();
+        let mut result = E::Decoder::base_result();
+
+        while block.buffer.len() as u64 > cursor.position() {
+            let base = E::Decoder::base_id(block, last_read_doc_id.unwrap_or(block.first_doc_id));
+            decoder.decode_in_block(block, &mut cursor, base, &mut result)?;
+            last_read_doc_id = Some(result.doc_id);
+
+            let delta =
+                E::Delta::from_u64(result.doc_id - E::delta_base(prev)).ok_or_else(|| {
+                    std::io::Error::new(
+                        std::io::ErrorKind::InvalidData,
+                        "delta is too large for the merged block",
+                    )
+                })?;
+            encoder.encode(&mut writer, delta, &result)?;
+
+            prev.num_entries += 1;
+            prev.last_doc_id = result.doc_id;
+        }
+
+        Ok(writer.into_inner())
+    }
 }
 
 /// A wrapper around the inverted index to track the total number of entries in the index.
@@ -911,12 +1257,30 @@ impl<E: Encoder> EntriesTrackingIndex<E> {
         self.index.memory_usage() + std::mem::size_of::<usize>()
     }
 
+    /// Pack the entries of a block which isn't written to anymore into a more compact layout, if
+    /// the encoder has one. Returns by how much memory shrank.
+    pub fn pack_block(&mut self, index: usize) -> usize {
+        self.index.pack_block(index)
+    }
+
     /// The total number of entries in the index. This is not the number of unique documents, but
     /// rather the total number of entries added to the index.
     pub const fn number_of_entries(&self) -> usize {
         self.number_of_entries
     }
 
+    /// Replace the blocks of this index with blocks restored from another index, along with the
+    /// number of entries it tracked. See [`InvertedIndex::restore_blocks`].
+    pub fn restore_blocks(
+        &mut self,
+        blocks: Vec<IndexBlock>,
+        n_unique_docs: u32,
+        number_of_entries: usize,
+    ) {
+        self.index.restore_blocks(blocks, n_unique_docs);
+        self.number_of_entries = number_of_entries;
+    }
+
     /// Returns the last document ID in the index, if any.
     pub fn last_doc_id(&self) -> Option<t_docId> {
         self.index.last_doc_id()
@@ -972,6 +1336,16 @@ impl<E: Encoder> EntriesTrackingIndex<E> {
         self.index.gc_marker_inc();
     }
 
+    /// Move the blocks out of this index. See [`InvertedIndex::take_blocks`].
+    pub fn take_blocks(&mut self) -> Vec<IndexBlock> {
+        self.index.take_blocks()
+    }
+
+    /// Give back the blocks taken out of this index. See [`InvertedIndex::put_blocks`].
+    pub fn put_blocks(&mut self, blocks: Vec<IndexBlock>) {
+        self.index.put_blocks(blocks)
+    }
+
     /// Get a reference to the inner inverted index.
     pub const fn inner(&self) -> &InvertedIndex<E> {
         &self.index
@@ -1071,6 +1445,18 @@ impl<E: Encoder> FieldMaskTrackingIndex<E> {
         self.field_mask
     }
 
+    /// Replace the blocks of this index with blocks restored from another index, along with the
+    /// field mask it tracked. See [`InvertedIndex::restore_blocks`].
+    pub fn restore_blocks(
+        &mut self,
+        blocks: Vec<IndexBlock>,
+        n_unique_docs: u32,
+        field_mask: t_fieldMask,
+    ) {
+        self.index.restore_blocks(blocks, n_unique_docs);
+        self.field_mask = field_mask;
+    }
+
     /// Return the debug summary for this inverted index.
     pub fn summary(&self) -> Summary {
         self.index.summary()
@@ -1101,6 +1487,16 @@ impl<E: Encoder> FieldMaskTrackingIndex<E> {
         self.index.gc_marker_inc();
     }
 
+    /// Move the blocks out of this index. See [`InvertedIndex::take_blocks`].
+    pub fn take_blocks(&mut self) -> Vec<IndexBlock> {
+        self.index.take_blocks()
+    }
+
+    /// Give back the blocks taken out of this index. See [`InvertedIndex::put_blocks`].
+    pub fn put_blocks(&mut self, blocks: Vec<IndexBlock>) {
+        self.index.put_blocks(blocks)
+    }
+
     /// Get a reference to the inner inverted index.
     pub const fn inner(&self) -> &InvertedIndex<E> {
         &self.index
@@ -1140,6 +1536,7 @@ impl<E: Encoder + DecodedBy> FieldMaskTrackingIndex<E> {
 }
 
 /// Reader that is able to read the records from an [`InvertedIndex`]
+#[derive(Clone)]
 pub struct IndexReaderCore<'index, E, D> {
     /// The block of the inverted index that is being read from. This might be used to determine the
     /// base document ID for delta calculations.
@@ -1164,6 +1561,37 @@ pub struct IndexReaderCore<'index, E, D> {
     /// detect if the index has been modified since the last read, in which case the reader
     /// should be reset.
     gc_marker: u32,
+
+    /// The number of records before the end of the current block at which the next block is
+    /// prefetched. 0 disables prefetching.
+    prefetch_distance: u32,
+
+    /// The position in the current buffer from which the next block is prefetched. This is
+    /// `u64::MAX` once the next block was prefetched, or when there is nothing to prefetch.
+    prefetch_pos: u64,
+}
+
+/// The most bytes of a block buffer prefetched ahead of reading the block.
+const PREFETCH_MAX_BYTES: usize = 256;
+
+/// Hint the CPU to start loading the beginning of the block's buffer into its cache, so it is
+/// there once the reader gets to the block.
+#[inline(always)]
+fn prefetch_block(block: &IndexBlock) {
+    #[cfg(target_arch = "x86_64")]
+    {
+        use std::arch::x86_64::{_MM_HINT_T0, _mm_prefetch};
+
+        let len = block.buffer.len().min(PREFETCH_MAX_BYTES);
+        for line in block.buffer[..len].chunks(64) {
+            // SAFETY: prefetching is only a hint which never faults, and the address is in the
+            // block's buffer anyway.
+            unsafe { _mm_prefetch::<_MM_HINT_T0>(line.as_ptr().cast()) };
+        }
+    }
+
+    #[cfg(not(target_arch = "x86_64"))]
+    let _ = block;
 }
 
 /// A reader is something which knows how to read / decode the records from an `[InvertedIndex]`.
@@ -1200,6 +1628,58 @@ pub trait IndexReader<'index> {
     /// Check if the underlying index has been modified since the last time this reader read from it.
     /// If it has, then the reader should be reset before reading from it again.
     fn needs_revalidation(&self) -> bool;
+
+    /// Decode the document IDs of up to `out.len()` next records into `out`, without moving the
+    /// reader. `scratch` is used to decode the records. Returns the number of IDs written to `out`,
+    /// which is less than `out.len()` only at the end of the index.
+    fn peek_ids(&self, scratch: &mut RSIndexResult<'index>, out: &mut [t_docId]) -> usize
+    where
+        Self: Clone,
+    {
+        // Read from a copy of the reader's position
+        let mut peek = self.clone();
+        let mut n = 0;
+
+        while n < out.len() && matches!(peek.next_record(scratch), Ok(true)) {
+            out[n] = scratch.doc_id;
+            n += 1;
+        }
+
+        n
+    }
+
+    /// Read the document IDs of up to `out.len()` next records into `out`. With `skip_multi`, the
+    /// records of the same document as the previous one (`prev_id` for the first) are skipped.
+    /// `result` is set to the last record read.
+    ///
+    /// This is monomorphized for every reader, so that its decoder and filter are inlined into the
+    /// loop, which spares the caller a call per record. The unfiltered numeric reader has a faster
+    /// inherent version, which skips over the values instead of decoding them.
+    ///
+    /// Returns the number of IDs written to `out`, which is less than `out.len()` only at the end
+    /// of the index.
+    #[inline]
+    fn next_ids(
+        &mut self,
+        result: &mut RSIndexResult<'index>,
+        mut prev_id: t_docId,
+        skip_multi: bool,
+        out: &mut [t_docId],
+    ) -> usize {
+        let mut n = 0;
+
+        while n < out.len() && matches!(self.next_record(result), Ok(true)) {
+            if skip_multi && result.doc_id == prev_id {
+                continue;
+            }
+
+            out[n] = result.doc_id;
+            prev_id = result.doc_id;
+            n += 1;
+        }
+
+        n
+    }
 }
 
 /// Marker trait for readers producing numeric values.
@@ -1235,9 +1715,17 @@ impl<'index, E: DecodedBy<Decoder = D>, D: Decoder> IndexReader<'index>
             self.set_current_block(self.current_block_idx + 1);
         }
 
-        let base = D::base_id(&self.ii.blocks[self.current_block_idx], self.last_doc_id);
+        if self.current_buffer.position() >= self.prefetch_pos {
+            self.prefetch_pos = u64::MAX;
+            if let Some(next_block) = self.ii.blocks.get(self.current_block_idx + 1) {
+                prefetch_block(next_block);
+            }
+        }
+
+        let block = &self.ii.blocks[self.current_block_idx];
+        let base = D::base_id(block, self.last_doc_id);
         self.decoder
-            .decode(&mut self.current_buffer, base, result)?;
+            .decode_in_block(block, &mut self.current_buffer, base, result)?;
 
         self.last_doc_id = result.doc_id;
 
@@ -1254,10 +1742,11 @@ impl<'index, E: DecodedBy<Decoder = D>, D: Decoder> IndexReader<'index>
             return Ok(false);
         }
 
-        let base = D::base_id(&self.ii.blocks[self.current_block_idx], self.last_doc_id);
-        let success = self
-            .decoder
-            .seek(&mut self.current_buffer, base, doc_id, result)?;
+        let block = &self.ii.blocks[self.current_block_idx];
+        let base = D::base_id(block, self.last_doc_id);
+        let success =
+            self.decoder
+                .seek_in_block(block, &mut self.current_buffer, base, doc_id, result)?;
 
         if success {
             self.last_doc_id = result.doc_id;
@@ -1293,12 +1782,25 @@ impl<'index, E: DecodedBy<Decoder = D>, D: Decoder> IndexReader<'index>
             return true;
         }
 
-        // Binary search to find the correct block index
-        let relative_idx = self.ii.blocks[search_start..]
-            .binary_search_by_key(&doc_id, |b| b.last_doc_id)
-            .unwrap_or_else(|insertion_point| insertion_point);
+        // Gallop from the next block, since skips usually land in one of the following blocks, then
+        // binary search the range the correct block was found in. All the blocks before `bottom`
+        // end before the document ID, and the last block doesn't.
+        let blocks = &self.ii.blocks;
+        let mut bottom = search_start + 1;
+        let mut step = 1;
+        while bottom + step < blocks.len() && blocks[bottom + step - 1].last_doc_id < doc_id {
+            bottom += step;
+            step <<= 1;
+        }
+
+        let top = (bottom + step).min(blocks.len());
+        let relative_idx = blocks[bottom..top].partition_point(|b| b.last_doc_id < doc_id);
 
-        self.set_current_block(search_start + relative_idx);
+        self.set_current_block(bottom + relative_idx);
+        if self.prefetch_distance > 0 {
+            // A far skip lands on a block which is likely not cached yet
+            prefetch_block(&self.ii.blocks[self.current_block_idx]);
+        }
 
         true
     }
@@ -1353,9 +1855,19 @@ impl<'index, E: DecodedBy<Decoder = D>, D: Decoder> IndexReaderCore<'index, E, D
             current_block_idx: 0,
             last_doc_id,
             gc_marker: ii.gc_marker.load(atomic::Ordering::Relaxed),
+            prefetch_distance: 0,
+            prefetch_pos: u64::MAX,
         }
     }
 
+    /// Prefetch the next block once the reader is `distance` records before the end of the
+    /// current block, so it is cached again by the time the reader gets to it. 0 disables
+    /// prefetching.
+    pub fn set_prefetch_distance(&mut self, distance: u32) {
+        self.prefetch_distance = distance;
+        self.prefetch_pos = self.block_prefetch_pos();
+    }
+
     /// Check if this reader is reading from the given index
     pub fn is_index(&self, index: &InvertedIndex<E>) -> bool {
         std::ptr::eq(self.ii, index)
@@ -1372,6 +1884,17 @@ impl<'index, E: DecodedBy<Decoder = D>, D: Decoder> IndexReaderCore<'index, E, D
         self.ii
     }
 
+    /// Get the block the reader is currently positioned at. After a successful read or seek, this
+    /// is the block holding the last record returned. `None` is returned if the index is empty.
+    pub fn current_block(&self) -> Option<&'index IndexBlock> {
+        self.ii.blocks.get(self.current_block_idx)
+    }
+
+    /// Get the highest frequency of the entries of the underlying index.
+    pub fn index_max_freq(&self) -> u32 {
+        self.ii.max_freq()
+    }
+
     /// Set the current active block to the given index
     fn set_current_block(&mut self, index: usize) {
         debug_assert!(
@@ -1383,6 +1906,25 @@ impl<'index, E: DecodedBy<Decoder = D>, D: Decoder> IndexReaderCore<'index, E, D
         let current_block = &self.ii.blocks[self.current_block_idx];
         self.last_doc_id = current_block.first_doc_id;
         self.current_buffer = Cursor::new(&current_block.buffer);
+        self.prefetch_pos = self.block_prefetch_pos();
+    }
+
+    /// Get the position in the current block from which the next block is prefetched. Records
+    /// have no fixed size, so the position is estimated from the block's average record size.
+    fn block_prefetch_pos(&self) -> u64 {
+        let distance = self.prefetch_distance as u64;
+        if distance == 0 || self.current_block_idx + 1 >= self.ii.blocks.len() {
+            return u64::MAX;
+        }
+
+        let block = &self.ii.blocks[self.current_block_idx];
+        let num_entries = block.num_entries as u64;
+        if num_entries <= distance {
+            return 0;
+        }
+
+        let len = block.buffer.len() as u64;
+        len - len * distance / num_entries
     }
 }
 
@@ -1405,6 +1947,7 @@ pub enum ReadFilter<'numeric_filter> {
 /// A reader that filters out records that do not match a given field mask. It is used to
 /// filter records in an index based on their field mask, allowing only those that match the
 /// specified mask to be returned.
+#[derive(Clone)]
 pub struct FilterMaskReader<IR> {
     /// Mask which a record needs to match to be valid
     mask: t_fieldMask,
@@ -1504,6 +2047,23 @@ impl<'index, E: DecodedBy<Decoder = D>, D: Decoder>
     pub const fn internal_index(&self) -> &InvertedIndex<E> {
         self.inner.internal_index()
     }
+
+    /// Get the block the reader is currently positioned at. After a successful read or seek, this
+    /// is the block holding the last record returned. `None` is returned if the index is empty.
+    pub fn current_block(&self) -> Option<&'index IndexBlock> {
+        self.inner.current_block()
+    }
+
+    /// Get the highest frequency of the entries of the underlying index.
+    pub fn index_max_freq(&self) -> u32 {
+        self.inner.index_max_freq()
+    }
+
+    /// Prefetch the next block once the reader is `distance` records before the end of the
+    /// current block. 0 disables prefetching.
+    pub fn set_prefetch_distance(&mut self, distance: u32) {
+        self.inner.set_prefetch_distance(distance);
+    }
 }
 
 /// Automatically implemented if the IndexReaderCore uses a TermDecoder.
@@ -1517,6 +2077,7 @@ impl<'index, E: DecodedBy<Decoder = D>, D: Decoder + TermDecoder> TermReader<'in
 /// specified filter to be returned.
 ///
 /// This should only be wrapped around readers that return numeric records.
+#[derive(Clone)]
 pub struct FilterNumericReader<'filter, IR> {
     /// The numeric filter that is used to filter the records.
     filter: &'filter NumericFilter,
@@ -1641,6 +2202,23 @@ impl<'filter, 'index, E: DecodedBy<Decoder = D>, D: Decoder>
     pub const fn internal_index(&self) -> &InvertedIndex<E> {
         self.inner.internal_index()
     }
+
+    /// Get the block the reader is currently positioned at. After a successful read or seek, this
+    /// is the block holding the last record returned. `None` is returned if the index is empty.
+    pub fn current_block(&self) -> Option<&'index IndexBlock> {
+        self.inner.current_block()
+    }
+
+    /// Get the highest frequency of the entries of the underlying index.
+    pub fn index_max_freq(&self) -> u32 {
+        self.inner.index_max_freq()
+    }
+
+    /// Prefetch the next block once the reader is `distance` records before the end of the
+    /// current block. 0 disables prefetching.
+    pub fn set_prefetch_distance(&mut self, distance: u32) {
+        self.inner.set_prefetch_distance(distance);
+    }
 }
 
 /// A [`FilterNumericReader`] wrapping a [`NumericReader'] is also a [`NumericReader`].
@@ -1651,6 +2229,7 @@ impl<'index, IR: NumericReader<'index>> NumericReader<'index> for FilterNumericR
 /// specified geo filter to be returned.
 ///
 /// This should only be wrapped around readers that return numeric records.
+#[derive(Clone)]
 pub struct FilterGeoReader<'filter, IR> {
     /// Numeric filter with a geo filter set to which a record needs to match to be valid.
     /// This is only needed because the reader needs to be able to return the original numeric
@@ -1803,6 +2382,23 @@ impl<'filter, 'index, E: DecodedBy<Decoder = D>, D: Decoder>
     pub const fn internal_index(&self) -> &InvertedIndex<E> {
         self.inner.internal_index()
     }
+
+    /// Get the block the reader is currently positioned at. After a successful read or seek, this
+    /// is the block holding the last record returned. `None` is returned if the index is empty.
+    pub fn current_block(&self) -> Option<&'index IndexBlock> {
+        self.inner.current_block()
+    }
+
+    /// Get the highest frequency of the entries of the underlying index.
+    pub fn index_max_freq(&self) -> u32 {
+        self.inner.index_max_freq()
+    }
+
+    /// Prefetch the next block once the reader is `distance` records before the end of the
+    /// current block. 0 disables prefetching.
+    pub fn set_prefetch_distance(&mut self, distance: u32) {
+        self.inner.set_prefetch_distance(distance);
+    }
 }
 
 /// A [`FilterGeoReader`] wrapping a [`NumericReader'] is also a [`NumericReader`].
@@ -139,12 +139,38 @@
 //!      │  │   └─ Delta bytes: 1                  (256 = 0x0100)
 //!      │  └─ Type: INT_POS (10)
 //!      └─ Value bytes: 1 (001) (ie 2 bytes are used for the value)
+//! ```
+//!
+//! # Packed Blocks
+//!
+//! Once a block is sealed, [`Encoder::pack`] can re-encode all its entries into two columns of
+//! fixed-width numbers, following a header:
+//!
+//! ```text
+//! ┌─────────────┬──────────────────────────┬──────────────────────────┐
+//! │ Header      │ Value residuals          │ ID offsets               │
+//! │ (19 bytes)  │ (0-8 bytes per entry)    │ (1-8 bytes per entry)    │
+//! └─────────────┴──────────────────────────┴──────────────────────────┘
+//! ```
+//!
+//! The ID offsets are taken from the first document ID of the block. The values are turned into
+//! integers scaled by the smallest power of 10 (up to 10^4) restoring all of them exactly, and the
+//! value of an entry is `(base + slope * id_offset + residual) / 10^scale`. This is a frame of
+//! reference when `slope` is 0, or a line through the block values, e.g. for timestamps growing
+//! with the document IDs. All the arithmetic wraps around, so the integers are always restored
+//! exactly.
+//!
+//! Each column uses the narrowest width of 0, 1, 2, 4 or 8 bytes fitting all its numbers, so every
+//! entry can be found from the reader position alone: it is the position in the ID offsets column.
 
 use std::io::{Cursor, IoSlice, Read, Write};
 
 use ffi::t_docId;
 
-use crate::{DecodedBy, Decoder, Encoder, IdDelta, NumericDecoder, RSIndexResult};
+use crate::{
+    DecodedBy, Decoder, Encoder, IdDelta, IndexBlock, IndexReaderCore, NumericDecoder,
+    RSIndexResult,
+};
 
 /// Trait to convert various types to byte representations for numeric encoding
 trait ToBytes<const N: usize> {
@@ -391,6 +417,50 @@ impl Encoder for Numeric {
 
         Ok(bytes_written)
     }
+
+    /// Pack the block into [fixed-width columns](self#packed-blocks) if that makes it smaller. The
+    /// values need to be restored exactly, so blocks holding values with more than 4 decimals, or
+    /// beyond 2^53, are left as they are.
+    fn pack(&self, block: &mut IndexBlock, packed_from: Option<&IndexBlock>) -> bool {
+        if block.packed || block.num_entries == 0 {
+            return false;
+        }
+
+        let n = block.num_entries as usize;
+        let mut offsets = Vec::with_capacity(n);
+        let mut values = Vec::with_capacity(n);
+        {
+            let mut cursor = Cursor::new(block.buffer.as_slice());
+            let mut result = Self::base_result();
+            let mut base = block.first_doc_id;
+            while (cursor.position() as usize) < block.buffer.len() {
+                if self.decode(&mut cursor, base, &mut result).is_err() {
+                    return false;
+                }
+                base = result.doc_id;
+                offsets.push(result.doc_id - block.first_doc_id);
+                values.push(result.as_numeric().unwrap_or_default());
+            }
+        }
+
+        let Some((scale, xs)) = packed_integers(&values) else {
+            return false;
+        };
+
+        // The line of the block this one was repaired from fits the remaining entries as well
+        let slope_hint = packed_from
+            .filter(|b| b.packed)
+            .map_or(0, |b| PackedHeader::read(&b.buffer).slope);
+        let packed = pack_entries(&offsets, &xs, scale, slope_hint);
+        if packed.len() >= block.buffer.len() {
+            return false;
+        }
+
+        block.buffer = packed;
+        block.packed = true;
+
+        true
+    }
 }
 
 impl DecodedBy for Numeric {
@@ -490,6 +560,368 @@ impl Decoder for Numeric {
     fn base_result<'index>() -> RSIndexResult<'index> {
         RSIndexResult::numeric(0.0)
     }
+
+    #[inline(always)]
+    fn decode_in_block<'index>(
+        &self,
+        block: &IndexBlock,
+        cursor: &mut Cursor<&'index [u8]>,
+        base: t_docId,
+        result: &mut RSIndexResult<'index>,
+    ) -> std::io::Result<()> {
+        if !block.packed {
+            return self.decode(cursor, base, result);
+        }
+
+        let header = PackedHeader::read(cursor.get_ref());
+        let (i, offset) = header.next_offset(cursor, block.num_entries as usize)?;
+
+        result.doc_id = block.first_doc_id + offset;
+        // SAFETY: Caller must ensure `result` is numeric
+        unsafe {
+            *result.as_numeric_unchecked_mut() = header.value(cursor.get_ref(), i, offset);
+        }
+
+        Ok(())
+    }
+
+    fn seek_in_block<'index>(
+        &self,
+        block: &IndexBlock,
+        cursor: &mut Cursor<&'index [u8]>,
+        base: t_docId,
+        target: t_docId,
+        result: &mut RSIndexResult<'index>,
+    ) -> std::io::Result<bool> {
+        if !block.packed {
+            return self.seek(cursor, base, target, result);
+        }
+
+        loop {
+            match self.decode_in_block(block, cursor, base, result) {
+                Ok(_) if result.doc_id >= target => return Ok(true),
+                Ok(_) => continue,
+                Err(err) if err.kind() == std::io::ErrorKind::UnexpectedEof => return Ok(false),
+                Err(err) => return Err(err),
+            }
+        }
+    }
+}
+
+impl Numeric {
+    /// Move the cursor past the next record without decoding its value, and return its document
+    /// ID. `base` is the same base document ID [`Decoder::decode`] would use.
+    #[inline(always)]
+    pub fn skip(&self, cursor: &mut Cursor<&[u8]>, base: t_docId) -> std::io::Result<t_docId> {
+        let mut header = [0; 1];
+        cursor.read_exact(&mut header)?;
+
+        let header = header[0];
+        let delta_bytes = (header & 0b111) as usize;
+        let type_bits = (header >> 3) & 0b11;
+        let upper_bits = header >> 5;
+
+        let delta = read_only_u64(cursor, delta_bytes)?;
+
+        let value_bytes = match type_bits {
+            Self::TINY_TYPE => 0,
+            Self::INT_POS_TYPE | Self::INT_NEG_TYPE => upper_bits as u64 + 1,
+            Self::FLOAT_TYPE => match upper_bits {
+                FLOAT32_POSITIVE | FLOAT32_NEGATIVE => 4,
+                FLOAT64_POSITIVE | FLOAT64_NEGATIVE => 8,
+                _ => 0,
+            },
+            _ => unreachable!("All four possible combinations are covered"),
+        };
+
+        let end = cursor.position() + value_bytes;
+        if end > cursor.get_ref().len() as u64 {
+            return Err(std::io::Error::new(
+                std::io::ErrorKind::UnexpectedEof,
+                "failed to fill whole buffer",
+            ));
+        }
+        cursor.set_position(end);
+
+        Ok(base + delta)
+    }
+
+    /// Like [`Numeric::skip`], for a cursor over the buffer of `block`, which might be packed.
+    #[inline(always)]
+    pub fn skip_in_block(
+        &self,
+        block: &IndexBlock,
+        cursor: &mut Cursor<&[u8]>,
+        base: t_docId,
+    ) -> std::io::Result<t_docId> {
+        if !block.packed {
+            return self.skip(cursor, base);
+        }
+
+        let header = PackedHeader::read(cursor.get_ref());
+        let (_, offset) = header.next_offset(cursor, block.num_entries as usize)?;
+
+        Ok(block.first_doc_id + offset)
+    }
+}
+
+impl<'index> IndexReaderCore<'index, Numeric, Numeric> {
+    /// Read the document IDs of up to `out.len()` next records into `out`, skipping over their
+    /// values. With `skip_multi`, the records of the same document as the previous one (`prev_id`
+    /// for the first) are skipped. `result` is set to the last record read.
+    ///
+    /// Returns the number of IDs written to `out`, which is less than `out.len()` only at the end
+    /// of the index.
+    pub fn next_ids(
+        &mut self,
+        result: &mut RSIndexResult<'index>,
+        mut prev_id: t_docId,
+        skip_multi: bool,
+        out: &mut [t_docId],
+    ) -> usize {
+        // The position of the last record written to `out`, to decode its value once done
+        let mut last = None;
+        let mut n = 0;
+
+        while n < out.len() {
+            if self.current_buffer.get_ref().len() as u64 <= self.current_buffer.position() {
+                if self.current_block_idx + 1 >= self.ii.blocks.len() {
+                    break;
+                }
+
+                self.set_current_block(self.current_block_idx + 1);
+            }
+
+            let block = &self.ii.blocks[self.current_block_idx];
+            let base = Numeric::base_id(block, self.last_doc_id);
+            let before = self.current_buffer.clone();
+            let Ok(doc_id) = self
+                .decoder
+                .skip_in_block(block, &mut self.current_buffer, base)
+            else {
+                break;
+            };
+            self.last_doc_id = doc_id;
+
+            if skip_multi && doc_id == prev_id {
+                continue;
+            }
+
+            out[n] = doc_id;
+            prev_id = doc_id;
+            n += 1;
+            last = Some((block, before, base));
+        }
+
+        // Decode from a copy, the reader stays after the last record
+        if let Some((block, mut cursor, base)) = last {
+            self.decoder
+                .decode_in_block(block, &mut cursor, base, result)
+                .expect("the record was just skipped over, so it is complete");
+        }
+
+        n
+    }
+}
+
+/// Values are scaled by up to `10^4` to be packed, e.g. prices with cents
+const PACKED_SCALES: [f64; 5] = [1.0, 10.0, 100.0, 1000.0, 10000.0];
+
+/// Integers up to 2^53 are exactly represented by a `f64`
+const PACKED_MAX_INT: f64 = (1u64 << 53) as f64;
+
+/// The header of a [packed block](self#packed-blocks).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+struct PackedHeader {
+    /// The width of each ID offset: 1, 2, 4 or 8 bytes
+    id_bytes: u8,
+
+    /// The width of each value residual: 0, 1, 2, 4 or 8 bytes
+    value_bytes: u8,
+
+    /// The decimal exponent turning the block values to integers
+    scale: u8,
+
+    /// The integer value of the line at the first document ID of the block
+    base: i64,
+
+    /// The integer value growth of the line for each document ID
+    slope: i64,
+}
+
+impl PackedHeader {
+    const SIZE: usize = 19;
+
+    /// Read the header at the start of a packed block buffer
+    #[inline(always)]
+    fn read(buffer: &[u8]) -> Self {
+        let int = |at: usize| i64::from_le_bytes(buffer[at..at + 8].try_into().unwrap());
+
+        Self {
+            id_bytes: buffer[0],
+            value_bytes: buffer[1],
+            scale: buffer[2],
+            base: int(3),
+            slope: int(11),
+        }
+    }
+
+    fn write(&self, buffer: &mut Vec<u8>) {
+        buffer.extend_from_slice(&[self.id_bytes, self.value_bytes, self.scale]);
+        buffer.extend_from_slice(&self.base.to_le_bytes());
+        buffer.extend_from_slice(&self.slope.to_le_bytes());
+    }
+
+    /// The position of the ID offsets column in a block of `num_entries` entries
+    #[inline(always)]
+    const fn ids_offset(&self, num_entries: usize) -> usize {
+        Self::SIZE + num_entries * self.value_bytes as usize
+    }
+
+    /// Move the cursor past the next ID offset and return the index of its entry with the offset.
+    /// The first read moves the cursor from the start of the block to the ID offsets column.
+    #[inline(always)]
+    fn next_offset(
+        &self,
+        cursor: &mut Cursor<&[u8]>,
+        num_entries: usize,
+    ) -> std::io::Result<(usize, u64)> {
+        let ids_offset = self.ids_offset(num_entries);
+        let pos = (cursor.position() as usize).max(ids_offset);
+        let width = self.id_bytes as usize;
+
+        let Some(bytes) = cursor.get_ref().get(pos..pos + width) else {
+            return Err(std::io::Error::new(
+                std::io::ErrorKind::UnexpectedEof,
+                "failed to fill whole buffer",
+            ));
+        };
+        let offset = packed_load(bytes);
+        cursor.set_position((pos + width) as u64);
+
+        Ok(((pos - ids_offset) / width, offset))
+    }
+
+    /// The value of the `i`-th entry of the block, given its ID offset
+    #[inline(always)]
+    fn value(&self, buffer: &[u8], i: usize, offset: u64) -> f64 {
+        let width = self.value_bytes as usize;
+        let at = Self::SIZE + i * width;
+        let residual = packed_load(&buffer[at..at + width]);
+        let x = self
+            .base
+            .wrapping_add(self.slope.wrapping_mul(offset as i64))
+            .wrapping_add(residual as i64);
+
+        x as f64 / PACKED_SCALES[self.scale as usize]
+    }
+}
+
+/// The number of bytes (0, 1, 2, 4 or 8) needed to store any number up to `max`
+const fn packed_width(max: u64) -> u8 {
+    match max {
+        0 => 0,
+        1..=0xFF => 1,
+        0x100..=0xFFFF => 2,
+        0x1_0000..=0xFFFF_FFFF => 4,
+        _ => 8,
+    }
+}
+
+/// Load a little endian number of `bytes.len()` bytes
+#[inline(always)]
+fn packed_load(bytes: &[u8]) -> u64 {
+    let mut buffer = [0; 8];
+    buffer[..bytes.len()].copy_from_slice(bytes);
+    u64::from_le_bytes(buffer)
+}
+
+/// Turn the values into integers, scaled by the lowest power of 10 that restores all of them
+/// exactly. Returns the scale with the integers, or `None` if some value can't be packed.
+fn packed_integers(values: &[f64]) -> Option<(u8, Vec<i64>)> {
+    'scales: for (scale, factor) in PACKED_SCALES.iter().enumerate() {
+        let mut xs = Vec::with_capacity(values.len());
+        for &value in values {
+            let scaled = value * factor;
+            if !scaled.is_finite() || scaled.abs() > PACKED_MAX_INT {
+                continue 'scales;
+            }
+
+            let x = scaled.round() as i64;
+            let restored = x as f64 / factor;
+            // -0.0 would be restored as 0
+            if restored != value || restored.is_sign_negative() != value.is_sign_negative() {
+                continue 'scales;
+            }
+            xs.push(x);
+        }
+
+        return Some((scale as u8, xs));
+    }
+
+    None
+}
+
+/// The residuals of the integers off the line of `slope`: returns the width of their range with
+/// their minimum
+fn packed_frame(offsets: &[u64], xs: &[i64], slope: i64) -> (u8, i64) {
+    let residuals = offsets
+        .iter()
+        .zip(xs)
+        .map(|(&offset, &x)| x.wrapping_sub(slope.wrapping_mul(offset as i64)));
+    let (min, max) = residuals.fold((i64::MAX, i64::MIN), |(min, max), r| {
+        (min.min(r), max.max(r))
+    });
+
+    (packed_width(max.wrapping_sub(min) as u64), min)
+}
+
+/// Write a packed block of the entries with the given ID offsets and integer values. The values
+/// are stored off the line with the narrowest residuals among a frame of reference, the line
+/// through the first and last entries, and the line of `slope_hint`.
+fn pack_entries(offsets: &[u64], xs: &[i64], scale: u8, slope_hint: i64) -> Vec<u8> {
+    let n = offsets.len();
+    let id_range = offsets[n - 1];
+    let slopes = [
+        0,
+        if id_range > 0 {
+            xs[n - 1].wrapping_sub(xs[0]) / id_range as i64
+        } else {
+            0
+        },
+        slope_hint,
+    ];
+
+    let mut header = PackedHeader {
+        id_bytes: packed_width(id_range).max(1),
+        value_bytes: u8::MAX,
+        scale,
+        base: 0,
+        slope: 0,
+    };
+    for slope in slopes {
+        let (width, base) = packed_frame(offsets, xs, slope);
+        if width < header.value_bytes {
+            header.value_bytes = width;
+            header.base = base;
+            header.slope = slope;
+        }
+    }
+
+    let size = header.ids_offset(n) + n * header.id_bytes as usize;
+    let mut buffer = Vec::with_capacity(size);
+    header.write(&mut buffer);
+    for (&offset, &x) in offsets.iter().zip(xs) {
+        let residual = x
+            .wrapping_sub(header.slope.wrapping_mul(offset as i64))
+            .wrapping_sub(header.base) as u64;
+        buffer.extend_from_slice(&residual.to_le_bytes()[..header.value_bytes as usize]);
+    }
+    for &offset in offsets {
+        buffer.extend_from_slice(&offset.to_le_bytes()[..header.id_bytes as usize]);
+    }
+
+    buffer
 }
 
 #[inline(always)]
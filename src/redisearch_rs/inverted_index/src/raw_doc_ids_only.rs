@@ -11,7 +11,7 @@ use std::io::{Cursor, Seek, Write};
 
 use ffi::t_docId;
 
-use crate::{DecodedBy, Decoder, Encoder, IndexBlock, RSIndexResult, TermDecoder};
+use crate::{DecodedBy, Decoder, Encoder, IndexBlock, RSIndexResult, TermDecoder, dense};
 
 /// Encode and decode only the raw document ID delta without any compression.
 ///
@@ -38,6 +38,10 @@ impl Encoder for RawDocIdsOnly {
     fn delta_base(block: &IndexBlock) -> t_docId {
         block.first_doc_id
     }
+
+    fn seal(&self, block: &mut IndexBlock) -> bool {
+        dense::densify(self, block)
+    }
 }
 
 impl DecodedBy for RawDocIdsOnly {
@@ -64,8 +68,13 @@ impl Decoder for RawDocIdsOnly {
         Ok(())
     }
 
-    fn base_id(block: &IndexBlock, _last_doc_id: t_docId) -> t_docId {
-        block.first_doc_id
+    fn base_id(block: &IndexBlock, last_doc_id: t_docId) -> t_docId {
+        // The bitmap of a dense block is read from the last ID read instead
+        if block.dense {
+            last_doc_id
+        } else {
+            block.first_doc_id
+        }
     }
 
     fn seek<'index>(
@@ -124,6 +133,36 @@ impl Decoder for RawDocIdsOnly {
     fn base_result<'index>() -> RSIndexResult<'index> {
         RSIndexResult::term()
     }
+    #[inline(always)]
+    fn decode_in_block<'index>(
+        &self,
+        block: &IndexBlock,
+        cursor: &mut Cursor<&'index [u8]>,
+        base: t_docId,
+        result: &mut RSIndexResult<'index>,
+    ) -> std::io::Result<()> {
+        if block.dense {
+            dense::decode(block, cursor, base, result)
+        } else {
+            self.decode(cursor, base, result)
+        }
+    }
+
+    #[inline(always)]
+    fn seek_in_block<'index>(
+        &self,
+        block: &IndexBlock,
+        cursor: &mut Cursor<&'index [u8]>,
+        base: t_docId,
+        target: t_docId,
+        result: &mut RSIndexResult<'index>,
+    ) -> std::io::Result<bool> {
+        if block.dense {
+            dense::seek(block, cursor, base, target, result)
+        } else {
+            self.seek(cursor, base, target, result)
+        }
+    }
 }
 
 impl TermDecoder for RawDocIdsOnly {}
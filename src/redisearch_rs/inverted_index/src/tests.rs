@@ -20,11 +20,15 @@ use crate::{
     IndexBlock, IndexReader, InvertedIndex, NumericFilter, NumericReader, RSAggregateResult,
     RSIndexResult, RSResultData, RSResultKind, RSTermRecord, RepairType,
     debug::{BlockSummary, Summary},
+    doc_ids_only::DocIdsOnly,
+    numeric::Numeric,
+    raw_doc_ids_only::RawDocIdsOnly,
 };
 use ffi::{GeoDistance_GEO_DISTANCE_M, GeoFilter, t_docId};
 use ffi::{
     IndexFlags_Index_DocIdsOnly, IndexFlags_Index_HasMultiValue, IndexFlags_Index_StoreFieldFlags,
-    IndexFlags_Index_StoreNumeric, IndexFlags_Index_StoreTermOffsets, IndexFlags_Index_WideSchema,
+    IndexFlags_Index_StoreFreqs, IndexFlags_Index_StoreNumeric, IndexFlags_Index_StoreTermOffsets,
+    IndexFlags_Index_WideSchema,
 };
 use pretty_assertions::assert_eq;
 use smallvec::smallvec;
@@ -403,6 +407,84 @@ fn adding_ii_blocks_growth_strategy() {
     );
 }
 
+#[test]
+fn adding_grows_blocks_with_index_size() {
+    /// Dummy encoder which keeps all blocks at the recommended size
+    #[derive(Clone)]
+    struct FixedBlocksDummy;
+
+    impl Encoder for FixedBlocksDummy {
+        type Delta = u32;
+
+        const MAX_BLOCK_SCALE: u16 = 1;
+
+        fn encode<W: std::io::Write + std::io::Seek>(
+            &self,
+            writer: W,
+            delta: Self::Delta,
+            record: &RSIndexResult,
+        ) -> std::io::Result<usize> {
+            Dummy.encode(writer, delta, record)
+        }
+    }
+
+    /// Dummy encoder whose recommended blocks are already bigger than the block bytes limit
+    #[derive(Clone)]
+    struct WideDummy;
+
+    impl Encoder for WideDummy {
+        type Delta = u32;
+
+        fn encode<W: std::io::Write + std::io::Seek>(
+            &self,
+            mut writer: W,
+            _delta: Self::Delta,
+            _record: &RSIndexResult,
+        ) -> std::io::Result<usize> {
+            writer.write_all(&[0; 256])?;
+
+            Ok(256)
+        }
+    }
+
+    fn block_entries<E: Encoder>(ii: &InvertedIndex<E>) -> Vec<u16> {
+        ii.blocks_summary()
+            .iter()
+            .map(|b| b.number_of_entries)
+            .collect()
+    }
+
+    let mut ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, Dummy);
+    let mut fixed_ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, FixedBlocksDummy);
+    let mut wide_ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, WideDummy);
+
+    for doc_id in 1..=2_400 {
+        let record = RSIndexResult::default().doc_id(doc_id);
+        ii.add_record(&record).unwrap();
+        fixed_ii.add_record(&record).unwrap();
+        wide_ii.add_record(&record).unwrap();
+    }
+
+    // The first 15 blocks have the recommended size. The blocks written while the index holds 16
+    // blocks or more take twice that, and the last one is still being written to
+    let mut expected = vec![100; 15];
+    expected.extend([200; 4]);
+    expected.push(100);
+    assert_eq!(block_entries(&ii), expected);
+
+    assert_eq!(block_entries(&fixed_ii), vec![100; 24]);
+    assert_eq!(block_entries(&wide_ii), vec![100; 24]);
+
+    // The blocks stop growing at the maximal scale
+    for doc_id in 2_401..=100_000 {
+        ii.add_record(&RSIndexResult::default().doc_id(doc_id))
+            .unwrap();
+    }
+    let entries = block_entries(&ii);
+    assert_eq!(entries.iter().map(|&n| n as usize).sum::<usize>(), 100_000);
+    assert_eq!(entries.iter().max(), Some(&800));
+}
+
 #[test]
 fn adding_tracks_entries() {
     let mut ii = EntriesTrackingIndex::new(IndexFlags_Index_DocIdsOnly, Dummy);
@@ -422,6 +504,29 @@ fn adding_tracks_entries() {
     assert_eq!(ii.number_of_entries(), 2);
 }
 
+#[test]
+fn adding_tracks_block_max_freq() {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_StoreFreqs, crate::freqs_only::FreqsOnly);
+
+    for (doc_id, freq) in [(1, 3), (2, 7), (3, 2)] {
+        ii.add_record(&RSIndexResult::virt().doc_id(doc_id).frequency(freq))
+            .unwrap();
+    }
+    assert_eq!(ii.blocks[0].max_freq(), 7);
+    assert_eq!(ii.max_freq(), 7);
+
+    // Removing the most frequent entry lowers the bound of the repaired block
+    let gc_result = ii
+        .scan_gc(
+            |doc_id| doc_id != 2,
+            None::<fn(&RSIndexResult, &IndexBlock)>,
+        )
+        .unwrap()
+        .unwrap();
+    ii.apply_gc(gc_result);
+    assert_eq!(ii.blocks[0].max_freq(), 3);
+}
+
 #[test]
 fn adding_track_field_mask() {
     let mut ii = FieldMaskTrackingIndex::new(IndexFlags_Index_StoreFieldFlags, Dummy);
@@ -495,12 +600,18 @@ fn reading_records() {
         IndexBlock {
             buffer: vec![0, 0, 0, 0, 0, 0, 0, 1],
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 11,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0],
             num_entries: 0,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 100,
             last_doc_id: 100,
         },
@@ -541,12 +652,18 @@ fn reading_over_empty_blocks() {
         IndexBlock {
             buffer: vec![0, 0, 0, 0],
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 10,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0],
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 30,
             last_doc_id: 30,
         },
@@ -573,6 +690,137 @@ fn reading_over_empty_blocks() {
     assert!(!found, "should not return any more records");
 }
 
+#[test]
+fn peeking_ids_keeps_the_reader_position() {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, Dummy);
+    for doc_id in 1..=250 {
+        ii.add_record(&RSIndexResult::default().doc_id(doc_id))
+            .unwrap();
+    }
+
+    let mut ir = ii.reader();
+    let mut result = RSIndexResult::default();
+    assert!(ir.next_record(&mut result).unwrap());
+    assert_eq!(result.doc_id, 1);
+
+    // Peeking crosses the block boundaries
+    let mut scratch = RSIndexResult::default();
+    let mut ids = [0; 150];
+    assert_eq!(ir.peek_ids(&mut scratch, &mut ids), 150);
+    assert_eq!(ids.to_vec(), (2..=151).collect::<Vec<_>>());
+
+    // The reader reads on from where it was
+    assert!(ir.next_record(&mut result).unwrap());
+    assert_eq!(result.doc_id, 2);
+
+    // Peeking stops at the end of the index
+    let mut ids = [0; 300];
+    assert_eq!(ir.peek_ids(&mut scratch, &mut ids), 248);
+    assert_eq!(ids[247], 250);
+}
+
+#[test]
+fn prefetching_the_next_block() {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, Dummy);
+    for doc_id in 1..=250 {
+        ii.add_record(&RSIndexResult::default().doc_id(doc_id))
+            .unwrap();
+    }
+    assert_eq!(ii.blocks.len(), 3);
+
+    let mut ir = ii.reader();
+    assert_eq!(
+        ir.prefetch_pos,
+        u64::MAX,
+        "prefetching is disabled by default"
+    );
+
+    // The next block is prefetched 10 out of 100 records before the end of the block
+    ir.set_prefetch_distance(10);
+    let first_len = ii.blocks[0].buffer.len() as u64;
+    assert_eq!(ir.prefetch_pos, first_len - first_len / 10);
+
+    let mut result = RSIndexResult::default();
+    for _ in 0..91 {
+        assert!(ir.next_record(&mut result).unwrap());
+    }
+    assert_eq!(
+        ir.prefetch_pos,
+        u64::MAX,
+        "the next block is only prefetched once"
+    );
+
+    // Moving to the next block sets its own prefetch position
+    assert!(ir.skip_to(101));
+    let second_len = ii.blocks[1].buffer.len() as u64;
+    assert_eq!(ir.prefetch_pos, second_len - second_len / 10);
+
+    // Blocks with fewer records than the distance prefetch right away
+    ir.set_prefetch_distance(100);
+    assert_eq!(ir.prefetch_pos, 0);
+
+    // There is nothing to prefetch after the last block
+    assert!(ir.skip_to(250));
+    assert_eq!(ir.prefetch_pos, u64::MAX);
+
+    ir.reset();
+    ir.set_prefetch_distance(0);
+    assert_eq!(ir.prefetch_pos, u64::MAX);
+
+    // Prefetching doesn't change what is read
+    ir.set_prefetch_distance(16);
+    let mut count = 0;
+    while ir.next_record(&mut result).unwrap() {
+        count += 1;
+        assert_eq!(result.doc_id, count);
+    }
+    assert_eq!(count, 250);
+}
+
+#[test]
+fn reading_numeric_ids() {
+    let mut ii = InvertedIndex::new(
+        IndexFlags_Index_StoreNumeric,
+        crate::numeric::Numeric::new(),
+    );
+    for doc_id in 1..=250 {
+        ii.add_record(&RSIndexResult::numeric(doc_id as f64 * 1.5).doc_id(doc_id))
+            .unwrap();
+        if doc_id % 10 == 0 {
+            // A multi-value document
+            ii.add_record(&RSIndexResult::numeric(-1e100).doc_id(doc_id))
+                .unwrap();
+        }
+    }
+
+    let mut ir = ii.reader();
+    let mut result = RSIndexResult::numeric(0.0);
+    assert!(ir.next_record(&mut result).unwrap());
+    assert_eq!(result.doc_id, 1);
+
+    // The ids are read across the blocks, skipping the other values of multi-value documents
+    let mut ids = [0; 150];
+    assert_eq!(ir.next_ids(&mut result, 1, true, &mut ids), 150);
+    assert_eq!(ids.to_vec(), (2..=151).collect::<Vec<_>>());
+    assert_eq!(result.doc_id, 151);
+    assert_eq!(result.as_numeric(), Some(151.0 * 1.5));
+
+    // Without skipping the multi-values, every entry is read, up to the end of the index
+    let mut expected = Vec::new();
+    let mut check = ir.clone();
+    let mut scratch = RSIndexResult::numeric(0.0);
+    while check.next_record(&mut scratch).unwrap() {
+        expected.push(scratch.doc_id);
+    }
+
+    let mut ids = [0; 300];
+    let n = ir.next_ids(&mut result, 151, false, &mut ids);
+    assert_eq!(ids[..n].to_vec(), expected);
+    assert_eq!(result.doc_id, 250);
+    assert_eq!(result.as_numeric(), Some(-1e100));
+    assert_eq!(ir.next_ids(&mut result, 250, false, &mut ids), 0);
+}
+
 #[test]
 fn read_using_the_first_block_id_as_the_base() {
     #[derive(Clone)]
@@ -630,6 +878,9 @@ fn read_using_the_first_block_id_as_the_base() {
     let blocks = vec![IndexBlock {
         buffer: vec![0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 2],
         num_entries: 3,
+        max_freq: 0,
+        packed: false,
+        dense: false,
         first_doc_id: 10,
         last_doc_id: 12,
     }];
@@ -663,12 +914,18 @@ fn seeking_records() {
         IndexBlock {
             buffer: vec![0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1],
             num_entries: 3,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 12,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 5],
             num_entries: 4,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 100,
             last_doc_id: 108,
         },
@@ -702,6 +959,41 @@ fn seeking_records() {
     assert!(!found);
 }
 
+#[test]
+fn skipping_to_far_blocks() {
+    // Runs of 100 documents, with a gap between every run
+    let mut ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, Dummy);
+    for block in 0..300 {
+        for doc_id in block * 1_000..block * 1_000 + 100 {
+            ii.add_record(&RSIndexResult::default().doc_id(doc_id))
+                .unwrap();
+        }
+    }
+    let blocks = ii.blocks_summary();
+
+    for from in [0, 1, 7, blocks.len() / 2, blocks.len() - 2] {
+        for target in [150, 1_050, 1_500, 3_099, 64_000, 123_456, 298_050, 299_099] {
+            let mut ir = ii.reader();
+            ir.set_current_block(from);
+            if blocks[from].last_doc_id >= target {
+                continue;
+            }
+
+            assert!(ir.skip_to(target));
+
+            // The reader is on the first block ending at or after the target
+            let expected = blocks.iter().position(|b| b.last_doc_id >= target).unwrap();
+            assert_eq!(
+                ir.current_block_idx, expected,
+                "skipping from block {from} to {target}"
+            );
+        }
+    }
+
+    let mut ir = ii.reader();
+    assert!(!ir.skip_to(299_100));
+}
+
 #[test]
 fn index_reader_construction_with_no_blocks() {
     let ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, Dummy);
@@ -719,36 +1011,54 @@ fn index_reader_skip_to() {
         IndexBlock {
             buffer: vec![0, 0, 0, 0, 0, 0, 0, 5],
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 15,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0, 0, 0, 0, 1],
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 16,
             last_doc_id: 17,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0, 0, 0, 0, 4],
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 20,
             last_doc_id: 24,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0],
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 30,
             last_doc_id: 30,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0],
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 40,
             last_doc_id: 40,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0],
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 50,
             last_doc_id: 50,
         },
@@ -802,12 +1112,18 @@ fn reader_reset() {
         IndexBlock {
             buffer: vec![0, 0, 0, 0, 0, 0, 0, 1],
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 11,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0],
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 100,
             last_doc_id: 100,
         },
@@ -861,12 +1177,18 @@ fn reader_unique_docs() {
         IndexBlock {
             buffer: vec![0, 0, 0, 0, 0, 0, 0, 1],
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 11,
         },
         IndexBlock {
             buffer: vec![0, 0, 0, 0],
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 100,
             last_doc_id: 100,
         },
@@ -1038,6 +1360,42 @@ fn reading_filter_based_on_field_mask() {
     );
 }
 
+#[test]
+fn reading_ids_filtered_based_on_field_mask() {
+    // Doc 11 does not match the mask, and doc 12 has two entries
+    let records = || {
+        vec![
+            RSIndexResult::default().doc_id(10).field_mask(0b0001),
+            RSIndexResult::default().doc_id(11).field_mask(0b0010),
+            RSIndexResult::default().doc_id(12).field_mask(0b0100),
+            RSIndexResult::default().doc_id(12).field_mask(0b0001),
+            RSIndexResult::default().doc_id(13).field_mask(0b0101),
+        ]
+        .into_iter()
+    };
+
+    let mut reader = FilterMaskReader::new(0b0101 as _, records());
+    let mut result = RSIndexResult::default();
+    let mut ids = [0; 2];
+    assert_eq!(reader.next_ids(&mut result, 0, true, &mut ids), 2);
+    assert_eq!(ids, [10, 12]);
+    assert_eq!(
+        result,
+        RSIndexResult::default().doc_id(12).field_mask(0b0100)
+    );
+
+    // The batch ends early at the end of the records
+    let mut ids = [0; 4];
+    assert_eq!(reader.next_ids(&mut result, 12, true, &mut ids), 1);
+    assert_eq!(ids[0], 13);
+    assert_eq!(reader.next_ids(&mut result, 13, true, &mut ids), 0);
+
+    // Without skipping the multi-values, every matching entry is read
+    let mut reader = FilterMaskReader::new(0b0101 as _, records());
+    assert_eq!(reader.next_ids(&mut result, 0, false, &mut ids), 4);
+    assert_eq!(ids, [10, 12, 12, 13]);
+}
+
 #[test]
 fn reading_filter_based_on_numeric_filter() {
     // Make an iterator with three records having different numeric values. The second record will be
@@ -1377,6 +1735,9 @@ fn index_block_repair_delete() {
     let block = IndexBlock {
         buffer: encode_ids!(encoder, 10, 11, 11),
         num_entries: 3,
+        max_freq: 0,
+        packed: false,
+        dense: false,
         first_doc_id: 10,
         last_doc_id: 11,
     };
@@ -1404,6 +1765,9 @@ fn index_block_repair_unchanged() {
     let block = IndexBlock {
         buffer: encode_ids!(encoder, 10, 11),
         num_entries: 2,
+        max_freq: 0,
+        packed: false,
+        dense: false,
         first_doc_id: 10,
         last_doc_id: 11,
     };
@@ -1426,6 +1790,9 @@ fn index_block_repair_some_deletions() {
     let block = IndexBlock {
         buffer: encode_ids!(encoder, 10, 11, 12),
         num_entries: 3,
+        max_freq: 0,
+        packed: false,
+        dense: false,
         first_doc_id: 10,
         last_doc_id: 12,
     };
@@ -1445,6 +1812,9 @@ fn index_block_repair_some_deletions() {
                 first_doc_id: 11,
                 last_doc_id: 11,
                 num_entries: 1,
+                max_freq: 0,
+                packed: false,
+                dense: false,
                 buffer: encode_ids!(Dummy, 11),
             }],
             n_unique_docs_removed: 2
@@ -1545,6 +1915,9 @@ fn index_block_repair_delta_too_big() {
     let block = IndexBlock {
         buffer: writer.into_inner(),
         num_entries: 3,
+        max_freq: 0,
+        packed: false,
+        dense: false,
         first_doc_id: 10,
         last_doc_id: 42,
     };
@@ -1576,6 +1949,9 @@ fn index_block_repair_delta_too_big() {
                         writer.into_inner()
                     },
                     num_entries: 1,
+                    max_freq: 0,
+                    packed: false,
+                    dense: false,
                     first_doc_id: 10,
                     last_doc_id: 10,
                 },
@@ -1594,6 +1970,9 @@ fn index_block_repair_delta_too_big() {
                         writer.into_inner()
                     },
                     num_entries: 1,
+                    max_freq: 0,
+                    packed: false,
+                    dense: false,
                     first_doc_id: 42,
                     last_doc_id: 42,
                 }
@@ -1615,24 +1994,36 @@ fn ii_scan_gc() {
         IndexBlock {
             buffer: encode_ids!(encoder, 10, 11),
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 11,
         },
         IndexBlock {
             buffer: encode_ids!(encoder, 20, 21, 22),
             num_entries: 3,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 20,
             last_doc_id: 22,
         },
         IndexBlock {
             buffer: encode_ids!(encoder, 30),
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 30,
             last_doc_id: 30,
         },
         IndexBlock {
             buffer: encode_ids!(encoder, 40),
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 40,
             last_doc_id: 40,
         },
@@ -1667,6 +2058,9 @@ fn ii_scan_gc() {
                         blocks: smallvec![IndexBlock {
                             buffer: encode_ids!(Dummy, 21, 22),
                             num_entries: 2,
+                            max_freq: 0,
+                            packed: false,
+                            dense: false,
                             first_doc_id: 21,
                             last_doc_id: 22,
                         }],
@@ -1686,12 +2080,18 @@ fn ii_scan_gc_no_change() {
         IndexBlock {
             buffer: encode_ids!(encoder, 10, 11),
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 11,
         },
         IndexBlock {
             buffer: encode_ids!(encoder, 30),
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 30,
             last_doc_id: 30,
         },
@@ -1722,24 +2122,36 @@ fn ii_apply_gc() {
         IndexBlock {
             buffer: encode_ids!(encoder, 10, 11),
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 11,
         },
         IndexBlock {
             buffer: encode_ids!(encoder, 20, 21, 22),
             num_entries: 3,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 20,
             last_doc_id: 22,
         },
         IndexBlock {
             buffer: encode_ids!(encoder, 30),
             num_entries: 1,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 30,
             last_doc_id: 30,
         },
         IndexBlock {
             buffer: encode_ids!(encoder, 40, 71, 72),
             num_entries: 3,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 40,
             last_doc_id: 72,
         },
@@ -1767,6 +2179,9 @@ fn ii_apply_gc() {
                 blocks: smallvec![IndexBlock {
                     buffer: encode_ids!(Dummy, 21),
                     num_entries: 1,
+                    max_freq: 0,
+                    packed: false,
+                    dense: false,
                     first_doc_id: 21,
                     last_doc_id: 21,
                 }],
@@ -1780,12 +2195,18 @@ fn ii_apply_gc() {
                     IndexBlock {
                         buffer: encode_ids!(Dummy, 40),
                         num_entries: 1,
+                        max_freq: 0,
+                        packed: false,
+                        dense: false,
                         first_doc_id: 40,
                         last_doc_id: 40,
                     },
                     IndexBlock {
                         buffer: encode_ids!(Dummy, 72),
                         num_entries: 1,
+                        max_freq: 0,
+                        packed: false,
+                        dense: false,
                         first_doc_id: 72,
                         last_doc_id: 72,
                     },
@@ -1822,24 +2243,36 @@ fn ii_apply_gc() {
             IndexBlock {
                 buffer: encode_ids!(Dummy, 21),
                 num_entries: 1,
+                max_freq: 0,
+                packed: false,
+                dense: false,
                 first_doc_id: 21,
                 last_doc_id: 21,
             },
             IndexBlock {
                 buffer: encode_ids!(Dummy, 30),
                 num_entries: 1,
+                max_freq: 0,
+                packed: false,
+                dense: false,
                 first_doc_id: 30,
                 last_doc_id: 30,
             },
             IndexBlock {
                 buffer: encode_ids!(Dummy, 40),
                 num_entries: 1,
+                max_freq: 0,
+                packed: false,
+                dense: false,
                 first_doc_id: 40,
                 last_doc_id: 40,
             },
             IndexBlock {
                 buffer: encode_ids!(Dummy, 72),
                 num_entries: 1,
+                max_freq: 0,
+                packed: false,
+                dense: false,
                 first_doc_id: 72,
                 last_doc_id: 72,
             },
@@ -1866,12 +2299,18 @@ fn ii_apply_gc_last_block_updated() {
         IndexBlock {
             buffer: encode_ids!(encoder, 10, 11),
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 10,
             last_doc_id: 11,
         },
         IndexBlock {
             buffer: encode_ids!(encoder, 20, 21, 22),
             num_entries: 3,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 20,
             last_doc_id: 22,
         },
@@ -1898,6 +2337,9 @@ fn ii_apply_gc_last_block_updated() {
                 blocks: smallvec![IndexBlock {
                     buffer: encode_ids!(Dummy, 21),
                     num_entries: 1,
+                    max_freq: 0,
+                    packed: false,
+                    dense: false,
                     first_doc_id: 21,
                     last_doc_id: 21,
                 }],
@@ -1931,6 +2373,9 @@ fn ii_apply_gc_last_block_updated() {
         vec![IndexBlock {
             buffer: encode_ids!(Dummy, 20, 21, 22),
             num_entries: 3,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 20,
             last_doc_id: 22,
         },]
@@ -2021,6 +2466,9 @@ fn ii_apply_gc_entries_tracking_index() {
                 blocks: smallvec![IndexBlock {
                     buffer: encode_ids!(AllowDupsDummy, 15, 15),
                     num_entries: 2,
+                    max_freq: 0,
+                    packed: false,
+                    dense: false,
                     first_doc_id: 15,
                     last_doc_id: 15,
                 }],
@@ -2053,6 +2501,9 @@ fn ii_apply_gc_entries_tracking_index() {
         vec![IndexBlock {
             buffer: encode_ids!(AllowDupsDummy, 15, 15),
             num_entries: 2,
+            max_freq: 0,
+            packed: false,
+            dense: false,
             first_doc_id: 15,
             last_doc_id: 15,
         },]
@@ -2067,3 +2518,415 @@ fn ii_apply_gc_entries_tracking_index() {
         }
     );
 }
+
+#[test]
+fn ii_apply_gc_merges_blocks() {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, Dummy);
+
+    for doc_id in 1..=2_000 {
+        ii.add_record(&RSIndexResult::default().doc_id(doc_id))
+            .unwrap();
+    }
+
+    // 15 blocks with the recommended 100 entries, 2 with 200 entries and the last one with 100
+    assert_eq!(ii.blocks.len(), 18);
+
+    let gc_result = ii
+        .scan_gc(
+            |doc_id| doc_id % 10 == 0,
+            None::<fn(&RSIndexResult, &IndexBlock)>,
+        )
+        .unwrap()
+        .unwrap();
+    let memory_before = ii.memory_usage();
+    let info = ii.apply_gc(gc_result);
+
+    assert_eq!(info.entries_removed, 1_800);
+    assert_eq!(
+        ii.memory_usage(),
+        memory_before + info.bytes_allocated - info.bytes_freed
+    );
+
+    // All the blocks but the last one fit in the capacity of the index
+    assert_eq!(
+        ii.blocks_summary(),
+        vec![
+            BlockSummary {
+                first_doc_id: 10,
+                last_doc_id: 1_900,
+                number_of_entries: 190,
+            },
+            BlockSummary {
+                first_doc_id: 1_910,
+                last_doc_id: 2_000,
+                number_of_entries: 10,
+            },
+        ]
+    );
+    assert_eq!(ii.unique_docs(), 200);
+
+    let mut ir = ii.reader();
+    let mut result = RSIndexResult::default();
+    for doc_id in (10..=2_000).step_by(10) {
+        assert!(ir.next_record(&mut result).unwrap());
+        assert_eq!(result.doc_id, doc_id);
+    }
+    assert!(!ir.next_record(&mut result).unwrap());
+}
+
+#[test]
+fn ii_apply_gc_keeps_small_index_blocks() {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, Dummy);
+
+    for doc_id in 1..=1_000 {
+        ii.add_record(&RSIndexResult::default().doc_id(doc_id))
+            .unwrap();
+    }
+
+    let gc_result = ii
+        .scan_gc(
+            |doc_id| doc_id % 10 == 0,
+            None::<fn(&RSIndexResult, &IndexBlock)>,
+        )
+        .unwrap()
+        .unwrap();
+    ii.apply_gc(gc_result);
+
+    // Indexes with few blocks are not merged
+    assert_eq!(ii.blocks.len(), 10);
+    assert!(
+        ii.blocks_summary()
+            .iter()
+            .all(|b| b.number_of_entries == 10)
+    );
+}
+
+/// Write `num_docs` documents `step` apart to a document IDs only index.
+fn dense_doc_ids_index<E: Encoder + DecodedBy + Clone>(
+    encoder: E,
+    num_docs: t_docId,
+    step: t_docId,
+) -> InvertedIndex<E> {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_DocIdsOnly, encoder);
+    for i in 1..=num_docs {
+        ii.add_record(&RSIndexResult::term().doc_id(i * step))
+            .unwrap();
+    }
+    ii
+}
+
+fn check_dense_doc_ids_blocks<E: Encoder + DecodedBy + Clone>(encoder: E) {
+    let num_docs = E::RECOMMENDED_BLOCK_ENTRIES as t_docId * 3 + 1;
+    for (step, expect_dense) in [(1, true), (3, true), (7, true), (9, false)] {
+        let ii = dense_doc_ids_index(encoder.clone(), num_docs, step);
+        assert_eq!(ii.blocks.len(), 4);
+
+        // The sealed blocks are stored as bitmaps when they are dense enough, never the last one
+        let sealed = &ii.blocks[..3];
+        assert!(
+            sealed.iter().all(|b| b.is_dense() == expect_dense),
+            "{step}"
+        );
+        assert!(!ii.blocks.last().unwrap().is_dense());
+        if expect_dense {
+            let span = sealed[0].last_doc_id - (sealed[0].first_doc_id & !63);
+            assert_eq!(sealed[0].buffer.len(), (span / 64 + 1) as usize * 8);
+        }
+
+        let mut ir = ii.reader();
+        let mut result = RSIndexResult::term();
+        for i in 1..=num_docs {
+            assert!(ir.next_record(&mut result).unwrap(), "{step} {i}");
+            assert_eq!(result.doc_id, i * step);
+        }
+        assert!(!ir.next_record(&mut result).unwrap());
+
+        // Seeking lands on the next existing document, from inside or outside a block
+        ir.reset();
+        for target in (1..=num_docs * step).step_by(97) {
+            assert!(
+                ir.seek_record(target, &mut result).unwrap(),
+                "{step} {target}"
+            );
+            assert_eq!(result.doc_id, target.div_ceil(step) * step);
+        }
+        ir.reset();
+        for target in [step * 5, step * 5 + 1, step * 64, step * 2_500] {
+            assert!(ir.skip_to(target), "{step} {target}");
+            assert!(ir.seek_record(target, &mut result).unwrap());
+            assert_eq!(result.doc_id, target.div_ceil(step) * step);
+        }
+        assert!(!ir.seek_record(num_docs * step + 1, &mut result).unwrap());
+    }
+}
+
+#[test]
+fn dense_doc_ids_only_blocks() {
+    check_dense_doc_ids_blocks(DocIdsOnly);
+    check_dense_doc_ids_blocks(RawDocIdsOnly);
+}
+
+#[test]
+fn dense_blocks_keep_their_capacity_and_are_not_merged() {
+    let mut ii = dense_doc_ids_index(DocIdsOnly, 2_001, 1);
+    assert!(ii.blocks[0].is_dense());
+    // The bitmap is written in place, in the buffer of the block
+    assert!(ii.blocks[0].buffer.capacity() >= 1_000);
+
+    // The GC would merge the remaining blocks if they weren't dense
+    let gc_result = ii
+        .scan_gc(
+            |doc_id| doc_id % 4 == 0 && doc_id <= 1_800,
+            None::<fn(&RSIndexResult, &IndexBlock)>,
+        )
+        .unwrap()
+        .unwrap();
+    ii.apply_gc(gc_result);
+    assert_eq!(ii.blocks.len(), 2);
+    // The remaining documents are still dense enough, and stored as bitmaps again
+    assert!(ii.blocks.iter().all(|b| b.is_dense()));
+    assert_eq!(ii.blocks[0].num_entries, 250);
+    assert_eq!(ii.blocks[0].buffer.capacity(), ii.blocks[0].buffer.len());
+
+    // Writing after a dense block starts a new block
+    ii.add_record(&RSIndexResult::term().doc_id(1_801)).unwrap();
+    assert_eq!(ii.blocks.len(), 3);
+    assert!(!ii.blocks.last().unwrap().is_dense());
+
+    let mut ir = ii.reader();
+    let mut result = RSIndexResult::term();
+    let mut read = Vec::new();
+    while ir.next_record(&mut result).unwrap() {
+        read.push(result.doc_id);
+    }
+    let mut expected = (4..=1_800).step_by(4).collect::<Vec<_>>();
+    expected.push(1_801);
+    assert_eq!(read, expected);
+}
+
+/// Write the values to consecutive documents `step` apart, and pack all the sealed blocks.
+/// Returns the index with the number of bytes saved.
+fn packed_numeric_index(values: &[f64], step: t_docId) -> (InvertedIndex<Numeric>, usize) {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_StoreNumeric, Numeric::new());
+    for (i, &value) in values.iter().enumerate() {
+        ii.add_record(&RSIndexResult::numeric(value).doc_id((i as t_docId + 1) * step))
+            .unwrap();
+    }
+
+    let memory_before = ii.memory_usage();
+    let gc_marker = ii.gc_marker();
+    let saved: usize = (0..ii.blocks.len()).map(|i| ii.pack_block(i)).sum();
+    assert_eq!(ii.memory_usage(), memory_before - saved);
+    assert_eq!(saved > 0, ii.gc_marker() != gc_marker);
+
+    // The block being written to is never packed
+    assert!(!ii.blocks.last().unwrap().is_packed());
+
+    (ii, saved)
+}
+
+#[test]
+fn packing_numeric_blocks() {
+    let values: [(&str, Vec<f64>, bool); 4] = [
+        (
+            "timestamps",
+            (0..1_005)
+                .map(|i| 1_700_000_000_000.0 + i as f64 * 1_000.0 + (i % 7) as f64)
+                .collect(),
+            true,
+        ),
+        (
+            "prices",
+            (0..1_005)
+                .map(|i| (i * 7_919 % 100_000) as f64 / 100.0)
+                .collect(),
+            true,
+        ),
+        (
+            "quarters",
+            (0..1_005).map(|i| (i % 50) as f64 / 4.0 - 5.0).collect(),
+            true,
+        ),
+        (
+            "fractions",
+            (0..1_005).map(|i| i as f64 / 3.0).collect(),
+            false,
+        ),
+    ];
+
+    for (name, values, expect_packed) in &values {
+        for step in [1, 7] {
+            let (ii, saved) = packed_numeric_index(values, step);
+            assert_eq!(saved > 0, *expect_packed, "{name}");
+            let sealed = &ii.blocks[..ii.blocks.len() - 1];
+            assert!(
+                sealed.iter().all(|b| b.is_packed() == *expect_packed),
+                "{name}"
+            );
+
+            // Packing is lossless
+            let mut ir = ii.reader();
+            let mut result = RSIndexResult::numeric(0.0);
+            for (i, &value) in values.iter().enumerate() {
+                assert!(ir.next_record(&mut result).unwrap(), "{name} {i}");
+                assert_eq!(result.doc_id, (i as t_docId + 1) * step);
+                assert_eq!(result.as_numeric(), Some(value), "{name} {i}");
+            }
+            assert!(!ir.next_record(&mut result).unwrap());
+
+            // Seeking finds the next entry in packed blocks
+            ir.reset();
+            for i in (0..values.len()).step_by(37) {
+                let target = i as t_docId * step + 1;
+                assert!(ir.seek_record(target, &mut result).unwrap(), "{name} {i}");
+                assert_eq!(result.doc_id, (i as t_docId + 1) * step);
+                assert_eq!(result.as_numeric(), Some(values[i]));
+            }
+
+            // The ids are read ahead from packed blocks as well
+            ir.reset();
+            let mut ids = vec![0; values.len()];
+            assert_eq!(ir.next_ids(&mut result, 0, true, &mut ids), values.len());
+            assert!(
+                ids.iter()
+                    .enumerate()
+                    .all(|(i, &id)| id == (i as t_docId + 1) * step)
+            );
+            assert_eq!(result.as_numeric(), values.last().copied());
+        }
+    }
+}
+
+#[test]
+fn packed_numeric_block_layout() {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_StoreNumeric, Numeric::new());
+    // Prices with cents, growing by 0.5 with every document, and a second block to seal the first
+    for doc_id in 1..=101 {
+        ii.add_record(&RSIndexResult::numeric(10.0 + doc_id as f64 / 2.0).doc_id(doc_id * 3))
+            .unwrap();
+    }
+    assert!(ii.pack_block(0) > 0);
+
+    let block = &ii.blocks[0];
+    assert!(block.is_packed());
+    // Scaled by 10, the values grow by 5 every 3 ids: the residuals off the line through the
+    // first and last entries fit 1 byte, and the id offsets up to 297 take 2 bytes
+    assert_eq!(block.buffer[..3], [2, 1, 1]);
+    assert_eq!(block.buffer.len(), 19 + 100 + 100 * 2);
+}
+
+#[test]
+fn packed_numeric_blocks_are_not_written_to_or_merged() {
+    let mut ii = InvertedIndex::new(IndexFlags_Index_StoreNumeric, Numeric::new());
+    for doc_id in 1..=2_000 {
+        ii.add_record(&RSIndexResult::numeric(doc_id as f64).doc_id(doc_id))
+            .unwrap();
+    }
+    let num_blocks = ii.blocks.len();
+    for i in 0..num_blocks {
+        ii.pack_block(i);
+    }
+    assert_eq!(ii.pack_block(0), 0, "packed blocks are packed once");
+
+    // The GC removes the last block, and would merge all the remaining ones if they weren't packed
+    let gc_result = ii
+        .scan_gc(
+            |doc_id| doc_id % 2 == 0 && doc_id <= 1_800,
+            None::<fn(&RSIndexResult, &IndexBlock)>,
+        )
+        .unwrap()
+        .unwrap();
+    ii.apply_gc(gc_result);
+    assert!(ii.blocks.len() > 2);
+    assert!(ii.blocks.iter().all(|b| b.is_packed()));
+
+    // Writing after a packed block starts a new block, even for the same document
+    let last_doc_id = ii.last_doc_id().unwrap();
+    ii.add_record(&RSIndexResult::numeric(-1.0).doc_id(last_doc_id))
+        .unwrap();
+    assert!(!ii.blocks.last().unwrap().is_packed());
+    assert_eq!(ii.blocks.last().unwrap().first_doc_id, last_doc_id);
+
+    let mut ir = ii.reader();
+    let mut result = RSIndexResult::numeric(0.0);
+    let mut read = Vec::new();
+    while ir.next_record(&mut result).unwrap() {
+        read.push((result.doc_id, result.as_numeric().unwrap()));
+    }
+    let mut expected = (2..=1_800)
+        .step_by(2)
+        .map(|id| (id, id as f64))
+        .collect::<Vec<_>>();
+    expected.push((1_800, -1.0));
+    assert_eq!(read, expected);
+}
+
+#[test]
+fn repairing_packed_numeric_blocks() {
+    let timestamps = (0..201)
+        .map(|i| 1_700_000_000_000.0 + i as f64 * 1_000.0 + (i % 7) as f64)
+        .collect::<Vec<_>>();
+    let (mut ii, _) = packed_numeric_index(&timestamps, 1);
+    assert!(ii.blocks[0].is_packed());
+    let len_before = ii.blocks[0].buffer.len();
+
+    // Delete every third document of the first block, starting from the first one
+    let mut repaired = Vec::new();
+    let gc_result = ii
+        .scan_gc(
+            |doc_id| doc_id > 100 || (doc_id - 1) % 3 != 0,
+            Some(|res: &RSIndexResult, _: &IndexBlock| {
+                repaired.push((res.doc_id, res.as_numeric().unwrap()))
+            }),
+        )
+        .unwrap()
+        .unwrap();
+    let info = ii.apply_gc(gc_result);
+    assert_eq!(info.entries_removed, 34);
+
+    // The remaining entries are packed again, and every entry was passed to the repair callback
+    let block = &ii.blocks[0];
+    assert!(block.is_packed());
+    assert!(block.buffer.len() < len_before);
+    assert_eq!(block.first_doc_id, 2);
+    assert_eq!(block.num_entries, 66);
+    assert_eq!(repaired.len(), 201 - 34);
+
+    let mut ir = ii.reader();
+    let mut result = RSIndexResult::numeric(0.0);
+    for i in (1..201).filter(|i| *i >= 100 || i % 3 != 0) {
+        assert!(ir.next_record(&mut result).unwrap());
+        assert_eq!(result.doc_id, i as t_docId + 1);
+        assert_eq!(result.as_numeric(), Some(timestamps[i]));
+    }
+    assert!(!ir.next_record(&mut result).unwrap());
+}
+
+#[test]
+fn take_and_put_blocks() {
+    let mut ii = dense_doc_ids_index(DocIdsOnly, 2_500, 1);
+    let num_blocks = ii.blocks.len();
+    let gc_marker = ii.gc_marker();
+
+    let blocks = ii.take_blocks();
+    assert_eq!(blocks.len(), num_blocks);
+    assert_eq!(ii.number_of_blocks(), 0);
+    assert_ne!(ii.gc_marker(), gc_marker);
+    // The counters are kept while the blocks are out
+    assert_eq!(ii.unique_docs(), 2_500);
+    assert!(!ii.reader().next_record(&mut RSIndexResult::term()).unwrap());
+
+    let gc_marker = ii.gc_marker();
+    ii.put_blocks(blocks);
+    assert_eq!(ii.number_of_blocks(), num_blocks);
+    assert_ne!(ii.gc_marker(), gc_marker);
+
+    ii.add_record(&RSIndexResult::term().doc_id(2_501)).unwrap();
+    let mut ir = ii.reader();
+    let mut result = RSIndexResult::term();
+    for i in 1..=2_501 {
+        assert!(ir.next_record(&mut result).unwrap());
+        assert_eq!(result.doc_id, i);
+    }
+    assert!(!ir.next_record(&mut result).unwrap());
+}
@@ -289,6 +289,28 @@ fn test_offsets_too_short() {
     assert_eq!(kind, std::io::ErrorKind::UnexpectedEof);
 }
 
+#[test]
+fn test_decode_full_borrows_offsets() {
+    // The offsets are not decoded, but borrowed from the block
+    let buf = vec![0, 0, 1, 10, 3, 1, 2, 3];
+    let range = buf.as_ptr_range();
+
+    let mut cursor = Cursor::new(buf.as_ref());
+    let record = Full::default().decode_new(&mut cursor, 100).unwrap();
+    let offsets = record.as_term().unwrap().offsets();
+    assert_eq!(offsets, &[1, 2, 3]);
+    assert!(range.contains(&offsets.as_ptr()));
+
+    let buf = vec![0, 0, 1, 3, 10, 1, 2, 3];
+    let range = buf.as_ptr_range();
+
+    let mut cursor = Cursor::new(buf.as_ref());
+    let record = FullWide::default().decode_new(&mut cursor, 100).unwrap();
+    let offsets = record.as_term().unwrap().offsets();
+    assert_eq!(offsets, &[1, 2, 3]);
+    assert!(range.contains(&offsets.as_ptr()));
+}
+
 #[test]
 fn test_seek_full() {
     let buf = vec![
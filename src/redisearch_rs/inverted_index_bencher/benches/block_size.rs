@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Compare reading and seeking large indexes with blocks growing with the size of the index
+//! against indexes whose blocks are kept at the recommended size of their encoder.
+
+use std::{
+    hint::black_box,
+    io::{Seek, Write},
+    time::Duration,
+};
+
+use criterion::{
+    BenchmarkGroup, BenchmarkId, Criterion, criterion_group, criterion_main, measurement::WallTime,
+};
+use ffi::{IndexFlags_Index_DocIdsOnly, IndexFlags_Index_StoreNumeric};
+use inverted_index::{
+    DecodedBy, Decoder, Encoder, IndexBlock, IndexReader, InvertedIndex, RSIndexResult,
+    doc_ids_only::DocIdsOnly, numeric::Numeric,
+};
+
+#[allow(unused_imports)] // We need this symbol for C binding
+use inverted_index_bencher::ResultMetrics_Free;
+
+/// Wrapper around an encoder which keeps all the blocks at the recommended size of the encoder
+#[derive(Clone)]
+struct FixedBlocks<E>(E);
+
+impl<E: Encoder> Encoder for FixedBlocks<E> {
+    type Delta = E::Delta;
+
+    const ALLOW_DUPLICATES: bool = E::ALLOW_DUPLICATES;
+    const RECOMMENDED_BLOCK_ENTRIES: u16 = E::RECOMMENDED_BLOCK_ENTRIES;
+    const MAX_BLOCK_SCALE: u16 = 1;
+
+    fn encode<W: Write + Seek>(
+        &self,
+        writer: W,
+        delta: Self::Delta,
+        record: &RSIndexResult,
+    ) -> std::io::Result<usize> {
+        self.0.encode(writer, delta, record)
+    }
+
+    fn delta_base(block: &IndexBlock) -> ffi::t_docId {
+        E::delta_base(block)
+    }
+}
+
+impl<E: DecodedBy> DecodedBy for FixedBlocks<E> {
+    type Decoder = E::Decoder;
+
+    fn decoder() -> Self::Decoder {
+        E::decoder()
+    }
+}
+
+const TOTAL_RECORDS: u64 = 1_000_000;
+
+fn benchmark_block_size(c: &mut Criterion) {
+    let mut group = c.benchmark_group("Block size");
+    group.measurement_time(Duration::from_millis(500));
+    group.warm_up_time(Duration::from_millis(200));
+
+    let numeric = |doc_id: u64| RSIndexResult::numeric(doc_id as f64 / 10.0).doc_id(doc_id);
+    benchmark_encoder(
+        &mut group,
+        "Numeric/Adaptive",
+        IndexFlags_Index_StoreNumeric,
+        Numeric::new(),
+        numeric,
+    );
+    benchmark_encoder(
+        &mut group,
+        "Numeric/Fixed",
+        IndexFlags_Index_StoreNumeric,
+        FixedBlocks(Numeric::new()),
+        numeric,
+    );
+
+    let doc_id_only = |doc_id: u64| RSIndexResult::term().doc_id(doc_id);
+    benchmark_encoder(
+        &mut group,
+        "DocIdsOnly/Adaptive",
+        IndexFlags_Index_DocIdsOnly,
+        DocIdsOnly,
+        doc_id_only,
+    );
+    benchmark_encoder(
+        &mut group,
+        "DocIdsOnly/Fixed",
+        IndexFlags_Index_DocIdsOnly,
+        FixedBlocks(DocIdsOnly),
+        doc_id_only,
+    );
+
+    group.finish();
+}
+
+fn benchmark_encoder<E: Encoder + DecodedBy>(
+    group: &mut BenchmarkGroup<'_, WallTime>,
+    name: &str,
+    flags: ffi::IndexFlags,
+    encoder: E,
+    record: impl Fn(u64) -> RSIndexResult<'static>,
+) {
+    let mut ii = InvertedIndex::new(flags, encoder);
+    // Leave gaps between the documents so seeks have IDs to skip over
+    for doc_id in (1..=TOTAL_RECORDS).map(|i| i * 3) {
+        ii.add_record(&record(doc_id)).unwrap();
+    }
+
+    let blocks = ii.blocks_summary();
+    let max_entries = blocks
+        .iter()
+        .map(|b| b.number_of_entries)
+        .max()
+        .unwrap_or(0);
+    println!(
+        "{name}: {} blocks, at most {max_entries} entries per block, {:.2} bytes per entry",
+        blocks.len(),
+        ii.memory_usage() as f64 / TOTAL_RECORDS as f64,
+    );
+
+    group.bench_function(BenchmarkId::new("Read", name), |b| {
+        b.iter(|| {
+            let mut reader = ii.reader();
+            let mut result = E::Decoder::base_result();
+            while reader.next_record(&mut result).unwrap() {
+                black_box(&result);
+            }
+        })
+    });
+
+    group.bench_function(BenchmarkId::new("Seek", name), |b| {
+        b.iter(|| {
+            let mut reader = ii.reader();
+            let mut result = E::Decoder::base_result();
+            // Seek to a document missing from the index every 1000 documents
+            for target in (1..TOTAL_RECORDS * 3).step_by(3_000) {
+                if !reader.seek_record(target, &mut result).unwrap() {
+                    break;
+                }
+                black_box(&result);
+            }
+        })
+    });
+}
+
+criterion_group!(benches, benchmark_block_size);
+criterion_main!(benches);
@@ -27,6 +27,13 @@ impl ResultProcessor for Counter {
             .upstream()
             .expect("There is no processor upstream of this counter.");
 
+        if upstream.ty() == ffi::ResultProcessorType_RP_INDEX {
+            // The root of the query counts its results itself, without building them when it can.
+            // Safety: The upstream processor is of type RP_INDEX, i.e. the root of the query.
+            self.count += unsafe { upstream.count_root() }?;
+            return Ok(None);
+        }
+
         while upstream.next(res)?.is_some() {
             self.count += 1;
 
@@ -89,6 +96,31 @@ pub(crate) mod test {
 
     static PROFILE_COUNTER: AtomicUsize = AtomicUsize::new(0);
 
+    /// Mock implementation of `RPQueryIterator_Count` for tests, counting the results of its
+    /// upstream instead of those of a query.
+    #[unsafe(no_mangle)]
+    unsafe extern "C" fn RPQueryIterator_Count(
+        rp: *mut ffi::ResultProcessor,
+        count: *mut usize,
+    ) -> libc::c_int {
+        // Safety: The tests only call this on the `MockRPIndex` processors of their chains.
+        let upstream = unsafe { (*rp).upstream };
+        let next = unsafe { (*upstream).Next.unwrap() };
+        let mut res = default_search_result();
+        let mut n = 0;
+        let rc = loop {
+            // Safety: `upstream` is a valid result processor of the chain.
+            let rc = unsafe { next(upstream, &mut res) };
+            if rc != ffi::RPStatus_RS_RESULT_OK as libc::c_int {
+                break rc;
+            }
+            n += 1;
+        };
+        // Safety: The caller passes a valid pointer.
+        unsafe { *count = n };
+        rc
+    }
+
     /// Mock implementation of `RPProfile_IncrementCount` for tests
     ///
     // FIXME: replace with `Profile::increment_count` once the profile result processor is ported.
@@ -110,6 +142,22 @@ pub(crate) mod test {
         assert_eq!(rp.count, 3);
     }
 
+    /// Tests that the results of the root of the query are counted by `RPQueryIterator_Count`.
+    #[test]
+    fn counts_root() {
+        type MockRPIndex = MockResultProcessor<{ ffi::ResultProcessorType_RP_INDEX }>;
+
+        let mut chain = Chain::new();
+        chain.append(from_iter(iter::repeat_n(default_search_result(), 5)));
+        chain.append(MockRPIndex::new());
+        chain.append(Counter::new());
+
+        let (cx, rp) = chain.last_as_context_and_inner::<Counter>();
+
+        assert!(rp.next(cx, &mut default_search_result()).unwrap().is_none());
+        assert_eq!(rp.count, 5);
+    }
+
     /// Tests that RPProfile_IncrementCount is incremented one when the pipeline runs.
     #[test]
     fn test_profile_count() {
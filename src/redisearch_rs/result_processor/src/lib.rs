@@ -167,17 +167,42 @@ impl Upstream<'_> {
         // the QueryIterator and other result processors are implemented correctly, this should be safe.
         let ret_code = unsafe { next(self.ptr.as_ptr(), res) };
 
-        match ret_code as ffi::RPStatus {
-            ffi::RPStatus_RS_RESULT_OK => Ok(Some(())),
-            ffi::RPStatus_RS_RESULT_EOF => Ok(None),
-            ffi::RPStatus_RS_RESULT_PAUSED => {
-                unimplemented!("result processor returned unsupported error code PAUSED")
-            }
-            ffi::RPStatus_RS_RESULT_TIMEDOUT => Err(Error::TimedOut),
-            ffi::RPStatus_RS_RESULT_ERROR => Err(Error::Error),
-            code => {
-                unimplemented!("result processor returned unknown error code {code}")
-            }
+        status_to_result(ret_code)
+    }
+
+    /// Count the remaining results of this result processor, the root of the query, without pulling
+    /// them one at a time (see `RPQueryIterator_Count`).
+    ///
+    /// # Errors
+    ///
+    /// Returns `Err(_)` for exceptional error cases, as [`Upstream::next`] does.
+    ///
+    /// # Safety
+    ///
+    /// This result processor must be the `RPQueryIterator` at the root of the query, i.e. of type
+    /// [`ffi::ResultProcessorType_RP_INDEX`].
+    pub unsafe fn count_root(&mut self) -> Result<usize, Error> {
+        let mut count = 0;
+        // Safety: The caller ensures this result processor is an `RPQueryIterator`, and `Header`
+        // has the layout of `ffi::ResultProcessor`.
+        let ret_code = unsafe { ffi::RPQueryIterator_Count(self.ptr.as_ptr().cast(), &mut count) };
+
+        status_to_result(ret_code).map(|_| count)
+    }
+}
+
+/// Translate the status returned by a C result processor.
+fn status_to_result(ret_code: c_int) -> Result<Option<()>, Error> {
+    match ret_code as ffi::RPStatus {
+        ffi::RPStatus_RS_RESULT_OK => Ok(Some(())),
+        ffi::RPStatus_RS_RESULT_EOF => Ok(None),
+        ffi::RPStatus_RS_RESULT_PAUSED => {
+            unimplemented!("result processor returned unsupported error code PAUSED")
+        }
+        ffi::RPStatus_RS_RESULT_TIMEDOUT => Err(Error::TimedOut),
+        ffi::RPStatus_RS_RESULT_ERROR => Err(Error::Error),
+        code => {
+            unimplemented!("result processor returned unknown error code {code}")
         }
     }
 }
@@ -238,6 +263,17 @@ struct Header {
     next: Option<unsafe extern "C" fn(self_: *mut Header, res: *mut ffi::SearchResult) -> c_int>,
     /// "VTable" function. Frees the processor and any internal data related to it.
     free: Option<unsafe extern "C" fn(self_: *mut Header)>,
+    /// Optional "VTable" function. Pulls a batch of [`ffi::SearchResult`]s out of this result processor.
+    ///
+    /// Rust result processors do not implement it, so C consumers read them one result at a time.
+    next_batch: Option<
+        unsafe extern "C" fn(
+            self_: *mut Header,
+            res: *mut ffi::SearchResult,
+            cap: usize,
+            len: *mut usize,
+        ) -> c_int,
+    >,
 
     // the following fields are Rust-specific and do not map to the C (ffi::ResultProcessor) type
     /// The TypeId of the inner ResultProcessor implementation, for debugging purposes
@@ -281,6 +317,7 @@ where
                 },
                 next: Some(Self::result_processor_next),
                 free: Some(Self::result_processor_free),
+                next_batch: None,
                 #[cfg(debug_assertions)]
                 inner_ty_id: TypeId::of::<P>(),
                 #[cfg(debug_assertions)]
@@ -463,6 +500,10 @@ pub(crate) mod test {
             ::std::mem::offset_of!(Header, free)
                 == ::std::mem::offset_of!(ffi::ResultProcessor, Free)
         );
+        assert!(
+            ::std::mem::offset_of!(Header, next_batch)
+                == ::std::mem::offset_of!(ffi::ResultProcessor, NextBatch)
+        );
     };
 
     /// Assert that Rust error types translate to the correct C ret code
@@ -543,6 +584,7 @@ pub(crate) mod test {
                     },
                     next: Some(result_processor_next),
                     free: Some(result_processor_free),
+                    next_batch: None,
 
                     #[cfg(debug_assertions)]
                     inner_ty_id: TypeId::of::<()>(),
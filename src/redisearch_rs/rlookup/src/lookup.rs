@@ -70,6 +70,9 @@ pub enum RLookupKeyFlag {
 
     /// This key type is numeric
     Numeric = 0x1000,
+
+    /// This key type is a tag
+    Tag = 0x2000,
 }
 
 /// Helper type to represent a set of [`RLookupKeyFlag`]s.
@@ -334,6 +337,9 @@ impl<'a> RLookupKey<'a> {
         if fs_types.contains(FieldSpecType::Numeric) {
             self.flags |= RLookupKeyFlag::Numeric;
         }
+        if fs_types.contains(FieldSpecType::Tag) {
+            self.flags |= RLookupKeyFlag::Tag;
+        }
     }
 
     /// Construct an `RLookupKey` from its main parts. Prefer Self::new if you are unsure which to use.
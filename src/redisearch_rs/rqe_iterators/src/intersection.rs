@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Intersection iterator implementation
+
+use std::ptr;
+
+use ffi::t_docId;
+use inverted_index::RSIndexResult;
+
+use crate::{RQEIterator, RQEIteratorError, RQEValidateStatus, SkipToOutcome, reset_aggregate};
+
+/// An iterator that yields the documents all of its children have, with an intersection result
+/// aggregating the results of the children.
+///
+/// The children are all of the same type, so that the common shapes of the queries, e.g. an
+/// intersection of terms, compile to loops calling the readers of the children directly.
+/// Children of different types can still be intersected as `Box<dyn RQEIterator>`.
+///
+/// Unlike the C iterator, the slop and the order of the terms are not checked.
+pub struct Intersection<'index, I> {
+    /// The children, sorted by their estimated number of results, so that the sparsest leads.
+    children: Vec<I>,
+    /// The current result of every child, inside the child. The children live in the heap buffer
+    /// of `children`, so the results don't move with the iterator.
+    currents: Vec<*mut RSIndexResult<'index>>,
+    last_doc_id: t_docId,
+    at_eof: bool,
+    /// A reusable result object to avoid allocations on each `read` call.
+    result: RSIndexResult<'index>,
+}
+
+impl<'index, I> Intersection<'index, I>
+where
+    I: RQEIterator<'index>,
+{
+    /// Creates a new intersection iterator, whose results have the given `weight`. An
+    /// intersection without children yields no results.
+    pub fn new(mut children: Vec<I>, weight: f64) -> Self {
+        children.sort_by_key(|child| child.num_estimated());
+        let num = children.len();
+        Self {
+            children,
+            currents: vec![ptr::null_mut(); num],
+            last_doc_id: 0,
+            at_eof: num == 0,
+            result: RSIndexResult::intersect(num).weight(weight),
+        }
+    }
+
+    /// Advance the children until they are all on the same document, the first of at least
+    /// `target` they all have, and make it the current result. Returns `false` once a child has no
+    /// more results.
+    fn agree(&mut self, mut target: t_docId) -> Result<bool, RQEIteratorError> {
+        let num = self.children.len();
+        // The number of consecutive children found on `target`
+        let mut agreeing = 0;
+        let mut i = 0;
+        while agreeing < num {
+            let child = &mut self.children[i];
+            let doc_id = if child.last_doc_id() < target {
+                match child.skip_to(target)? {
+                    Some(SkipToOutcome::Found(result) | SkipToOutcome::NotFound(result)) => {
+                        self.currents[i] = result;
+                        result.doc_id
+                    }
+                    None => {
+                        self.at_eof = true;
+                        return Ok(false);
+                    }
+                }
+            } else {
+                child.last_doc_id()
+            };
+
+            if doc_id > target {
+                target = doc_id;
+                agreeing = 1;
+            } else {
+                agreeing += 1;
+            }
+            i = if i + 1 == num { 0 } else { i + 1 };
+        }
+
+        self.set_result(target);
+        Ok(true)
+    }
+
+    /// Aggregate the results of the children, which are all on `doc_id`.
+    fn set_result(&mut self, doc_id: t_docId) {
+        reset_aggregate(&mut self.result);
+        for &current in &self.currents {
+            // SAFETY: Every child is on `doc_id`, so it set its current result, which lives as
+            // long as the child and therefore as long as this result. The result is aggregated
+            // again before it is read once the children moved.
+            self.result.push_borrowed(unsafe { &*current });
+        }
+        self.result.doc_id = doc_id;
+        self.last_doc_id = doc_id;
+    }
+}
+
+impl<'index, I> RQEIterator<'index> for Intersection<'index, I>
+where
+    I: RQEIterator<'index>,
+{
+    fn read(&mut self) -> Result<Option<&mut RSIndexResult<'index>>, RQEIteratorError> {
+        if self.at_eof {
+            return Ok(None);
+        }
+
+        // The sparsest child leads, the others only skip to its documents
+        let lead = &mut self.children[0];
+        let target = if lead.last_doc_id() > self.last_doc_id {
+            // Left ahead of the other children by the last agreement
+            lead.last_doc_id()
+        } else {
+            match lead.read()? {
+                Some(result) => {
+                    self.currents[0] = result;
+                    result.doc_id
+                }
+                None => {
+                    self.at_eof = true;
+                    return Ok(None);
+                }
+            }
+        };
+
+        if self.agree(target)? {
+            Ok(Some(&mut self.result))
+        } else {
+            Ok(None)
+        }
+    }
+
+    fn skip_to(
+        &mut self,
+        doc_id: t_docId,
+    ) -> Result<Option<SkipToOutcome<'_, 'index>>, RQEIteratorError> {
+        debug_assert!(self.last_doc_id < doc_id);
+        if self.at_eof || !self.agree(doc_id)? {
+            return Ok(None);
+        }
+
+        if self.result.doc_id == doc_id {
+            Ok(Some(SkipToOutcome::Found(&mut self.result)))
+        } else {
+            Ok(Some(SkipToOutcome::NotFound(&mut self.result)))
+        }
+    }
+
+    fn revalidate(&mut self) -> Result<RQEValidateStatus<'_, 'index>, RQEIteratorError> {
+        let mut moved = false;
+        for (child, current) in self.children.iter_mut().zip(&mut self.currents) {
+            match child.revalidate()? {
+                RQEValidateStatus::Ok => {}
+                RQEValidateStatus::Moved {
+                    current: Some(result),
+                } => {
+                    *current = result;
+                    moved = true;
+                }
+                RQEValidateStatus::Moved { current: None } => {
+                    self.at_eof = true;
+                    return Ok(RQEValidateStatus::Moved { current: None });
+                }
+                RQEValidateStatus::Aborted => return Ok(RQEValidateStatus::Aborted),
+            }
+        }
+        if !moved || self.at_eof {
+            return Ok(RQEValidateStatus::Ok);
+        }
+
+        // The children only move forward, to the first document they have from the current one
+        let target = self
+            .children
+            .iter()
+            .map(|child| child.last_doc_id())
+            .max()
+            .unwrap_or(0);
+        if target == self.last_doc_id {
+            // Every child is still on the current document, but their results may have changed
+            self.set_result(target);
+            return Ok(RQEValidateStatus::Ok);
+        }
+
+        if self.agree(target)? {
+            Ok(RQEValidateStatus::Moved {
+                current: Some(&mut self.result),
+            })
+        } else {
+            Ok(RQEValidateStatus::Moved { current: None })
+        }
+    }
+
+    fn rewind(&mut self) {
+        for child in &mut self.children {
+            child.rewind();
+        }
+        self.last_doc_id = 0;
+        self.at_eof = self.children.is_empty();
+        self.result.doc_id = 0;
+    }
+
+    fn num_estimated(&self) -> usize {
+        // The children are sorted by their estimation
+        self.children
+            .first()
+            .map_or(0, |child| child.num_estimated())
+    }
+
+    fn last_doc_id(&self) -> t_docId {
+        self.last_doc_id
+    }
+
+    fn at_eof(&self) -> bool {
+        self.at_eof
+    }
+}
@@ -10,12 +10,16 @@
 use ffi::t_docId;
 use thiserror::Error;
 
-use ::inverted_index::RSIndexResult;
+use ::inverted_index::{RSIndexResult, ResultMetrics_Reset_func};
 
 pub mod empty;
 pub mod id_list;
+pub mod intersection;
 pub mod inverted_index;
 pub mod metric;
+pub mod not;
+pub mod optional;
+pub mod union;
 pub mod wildcard;
 
 #[derive(Debug, PartialEq)]
@@ -97,3 +101,61 @@ pub trait RQEIterator<'index> {
     /// The iterator implementation must ensure that `at_eof` returns `false` when it is sure that the [`RQEIterator::read`] returns `Ok(None)`.
     fn at_eof(&self) -> bool;
 }
+
+/// Boxed iterators, e.g. the children of different types of a composite iterator, are iterators,
+/// at the cost of a dynamic dispatch on every call.
+impl<'index, I> RQEIterator<'index> for Box<I>
+where
+    I: RQEIterator<'index> + ?Sized,
+{
+    #[inline(always)]
+    fn read(&mut self) -> Result<Option<&mut RSIndexResult<'index>>, RQEIteratorError> {
+        (**self).read()
+    }
+
+    #[inline(always)]
+    fn skip_to(
+        &mut self,
+        doc_id: t_docId,
+    ) -> Result<Option<SkipToOutcome<'_, 'index>>, RQEIteratorError> {
+        (**self).skip_to(doc_id)
+    }
+
+    fn revalidate(&mut self) -> Result<RQEValidateStatus<'_, 'index>, RQEIteratorError> {
+        (**self).revalidate()
+    }
+
+    fn rewind(&mut self) {
+        (**self).rewind()
+    }
+
+    fn num_estimated(&self) -> usize {
+        (**self).num_estimated()
+    }
+
+    #[inline(always)]
+    fn last_doc_id(&self) -> t_docId {
+        (**self).last_doc_id()
+    }
+
+    #[inline(always)]
+    fn at_eof(&self) -> bool {
+        (**self).at_eof()
+    }
+}
+
+/// Clear an aggregate result of a composite iterator, before the results of its children are
+/// added to it again.
+fn reset_aggregate(result: &mut RSIndexResult) {
+    if let Some(agg) = result.as_aggregate_mut() {
+        agg.reset();
+    }
+    result.freq = 0;
+    result.field_mask = 0;
+    if !result.metrics.is_null() {
+        // SAFETY: The metrics of the result were concatenated from those of the children
+        unsafe {
+            ResultMetrics_Reset_func(result);
+        }
+    }
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Not iterator implementation
+
+use ffi::{RS_FIELDMASK_ALL, t_docId};
+use inverted_index::RSIndexResult;
+
+use crate::{RQEIterator, RQEIteratorError, RQEValidateStatus, SkipToOutcome};
+
+/// The id of a child which has no more results.
+const DEPLETED: t_docId = t_docId::MAX;
+
+/// An iterator that yields the ids from 1 to a maximal id (inclusive) its child doesn't have.
+///
+/// This is a port of the non-optimized variant of the C iterator, which walks over every id
+/// rather than over the existing documents of the index.
+pub struct Not<'index, I> {
+    child: I,
+    /// The document the child is on, 0 before it is read, or [`DEPLETED`].
+    child_id: t_docId,
+    max_doc_id: t_docId,
+    last_doc_id: t_docId,
+    at_eof: bool,
+    /// A reusable result object to avoid allocations on each `read` call.
+    result: RSIndexResult<'index>,
+}
+
+impl<'index, I> Not<'index, I>
+where
+    I: RQEIterator<'index>,
+{
+    /// Creates a new not iterator, whose results have the given `weight`.
+    pub const fn new(child: I, max_doc_id: t_docId, weight: f64) -> Self {
+        Self {
+            child,
+            child_id: 0,
+            max_doc_id,
+            last_doc_id: 0,
+            at_eof: max_doc_id == 0,
+            result: RSIndexResult::virt()
+                .weight(weight)
+                .field_mask(RS_FIELDMASK_ALL),
+        }
+    }
+
+    /// Move the child to its first document of at least `doc_id`.
+    fn advance_child(&mut self, doc_id: t_docId) -> Result<(), RQEIteratorError> {
+        if self.child_id >= doc_id {
+            return Ok(());
+        }
+        // Reading is cheaper than skipping for the ids right after those of the child
+        let next = if self.child_id + 1 == doc_id {
+            self.child.read()?.map(|result| result.doc_id)
+        } else {
+            match self.child.skip_to(doc_id)? {
+                Some(SkipToOutcome::Found(result) | SkipToOutcome::NotFound(result)) => {
+                    Some(result.doc_id)
+                }
+                None => None,
+            }
+        };
+        self.child_id = next.unwrap_or(DEPLETED);
+        Ok(())
+    }
+
+    /// Yield the first id of at least `doc_id` the child doesn't have.
+    fn next_from(
+        &mut self,
+        mut doc_id: t_docId,
+    ) -> Result<Option<&mut RSIndexResult<'index>>, RQEIteratorError> {
+        loop {
+            if doc_id > self.max_doc_id {
+                self.at_eof = true;
+                return Ok(None);
+            }
+            self.advance_child(doc_id)?;
+            if self.child_id != doc_id {
+                break;
+            }
+            doc_id += 1;
+        }
+
+        self.last_doc_id = doc_id;
+        self.result.doc_id = doc_id;
+        Ok(Some(&mut self.result))
+    }
+}
+
+impl<'index, I> RQEIterator<'index> for Not<'index, I>
+where
+    I: RQEIterator<'index>,
+{
+    fn read(&mut self) -> Result<Option<&mut RSIndexResult<'index>>, RQEIteratorError> {
+        if self.at_eof {
+            return Ok(None);
+        }
+        self.next_from(self.last_doc_id + 1)
+    }
+
+    fn skip_to(
+        &mut self,
+        doc_id: t_docId,
+    ) -> Result<Option<SkipToOutcome<'_, 'index>>, RQEIteratorError> {
+        debug_assert!(self.last_doc_id < doc_id);
+        if self.at_eof {
+            return Ok(None);
+        }
+
+        let found = doc_id <= self.max_doc_id && {
+            self.advance_child(doc_id)?;
+            self.child_id != doc_id
+        };
+        let Some(result) = self.next_from(doc_id)? else {
+            return Ok(None);
+        };
+        if found {
+            Ok(Some(SkipToOutcome::Found(result)))
+        } else {
+            Ok(Some(SkipToOutcome::NotFound(result)))
+        }
+    }
+
+    fn revalidate(&mut self) -> Result<RQEValidateStatus<'_, 'index>, RQEIteratorError> {
+        if self.child_id == DEPLETED {
+            return Ok(RQEValidateStatus::Ok);
+        }
+        self.child_id = match self.child.revalidate()? {
+            RQEValidateStatus::Ok => return Ok(RQEValidateStatus::Ok),
+            RQEValidateStatus::Moved {
+                current: Some(result),
+            } => result.doc_id,
+            // Nothing is excluded once the child is gone
+            RQEValidateStatus::Moved { current: None } | RQEValidateStatus::Aborted => DEPLETED,
+        };
+
+        if self.at_eof || self.last_doc_id == 0 || self.child_id != self.last_doc_id {
+            return Ok(RQEValidateStatus::Ok);
+        }
+        // The child moved to the current document, which is now excluded
+        let current = self.next_from(self.last_doc_id + 1)?;
+        Ok(RQEValidateStatus::Moved { current })
+    }
+
+    fn rewind(&mut self) {
+        self.child.rewind();
+        self.child_id = 0;
+        self.last_doc_id = 0;
+        self.at_eof = self.max_doc_id == 0;
+        self.result.doc_id = 0;
+    }
+
+    fn num_estimated(&self) -> usize {
+        self.max_doc_id as usize
+    }
+
+    fn last_doc_id(&self) -> t_docId {
+        self.last_doc_id
+    }
+
+    fn at_eof(&self) -> bool {
+        self.at_eof || self.last_doc_id >= self.max_doc_id
+    }
+}
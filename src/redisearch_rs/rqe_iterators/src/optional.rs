@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Optional iterator implementation
+
+use std::ptr;
+
+use ffi::{RS_FIELDMASK_ALL, t_docId};
+use inverted_index::RSIndexResult;
+
+use crate::{RQEIterator, RQEIteratorError, RQEValidateStatus, SkipToOutcome};
+
+/// The id of a child which has no more results.
+const DEPLETED: t_docId = t_docId::MAX;
+
+/// An iterator that yields every id from 1 to a maximal id (inclusive), with the result of its
+/// child for the ids the child has, and a virtual result of no weight for the others.
+///
+/// This is a port of the non-optimized variant of the C iterator, which walks over every id
+/// rather than over the existing documents of the index.
+pub struct Optional<'index, I> {
+    /// Boxed, so that the current result of the child doesn't move with the iterator.
+    child: Box<I>,
+    /// The document the child is on, 0 before it is read, or [`DEPLETED`].
+    child_id: t_docId,
+    /// The current result of the child, inside the child.
+    child_current: *mut RSIndexResult<'index>,
+    max_doc_id: t_docId,
+    /// The weight given to the results of the child.
+    weight: f64,
+    last_doc_id: t_docId,
+    at_eof: bool,
+    /// The result of the ids the child doesn't have.
+    virt: RSIndexResult<'index>,
+}
+
+impl<'index, I> Optional<'index, I>
+where
+    I: RQEIterator<'index>,
+{
+    /// Creates a new optional iterator, giving the results of the child the given `weight`.
+    pub fn new(child: I, max_doc_id: t_docId, weight: f64) -> Self {
+        Self {
+            child: Box::new(child),
+            child_id: 0,
+            child_current: ptr::null_mut(),
+            max_doc_id,
+            weight,
+            last_doc_id: 0,
+            at_eof: max_doc_id == 0,
+            virt: RSIndexResult::virt()
+                .frequency(1)
+                .field_mask(RS_FIELDMASK_ALL),
+        }
+    }
+
+    /// Make `doc_id` the current document, once the child is on it or past it.
+    fn set_current(&mut self, doc_id: t_docId) -> &mut RSIndexResult<'index> {
+        self.last_doc_id = doc_id;
+        if self.child_id == doc_id {
+            // SAFETY: The child is on `doc_id`, so it set its current result, which lives in the
+            // box of the child as long as this iterator.
+            let result = unsafe { &mut *self.child_current };
+            result.weight = self.weight;
+            result
+        } else {
+            self.virt.doc_id = doc_id;
+            &mut self.virt
+        }
+    }
+}
+
+impl<'index, I> RQEIterator<'index> for Optional<'index, I>
+where
+    I: RQEIterator<'index>,
+{
+    fn read(&mut self) -> Result<Option<&mut RSIndexResult<'index>>, RQEIteratorError> {
+        if self.at_eof || self.last_doc_id >= self.max_doc_id {
+            self.at_eof = true;
+            return Ok(None);
+        }
+
+        let doc_id = self.last_doc_id + 1;
+        // The child is never behind the current document, so it is on it when it is behind `doc_id`
+        if self.child_id < doc_id {
+            match self.child.read()? {
+                Some(result) => {
+                    self.child_id = result.doc_id;
+                    self.child_current = result;
+                }
+                None => self.child_id = DEPLETED,
+            }
+        }
+        Ok(Some(self.set_current(doc_id)))
+    }
+
+    fn skip_to(
+        &mut self,
+        doc_id: t_docId,
+    ) -> Result<Option<SkipToOutcome<'_, 'index>>, RQEIteratorError> {
+        debug_assert!(self.last_doc_id < doc_id);
+        if self.at_eof || doc_id > self.max_doc_id {
+            self.at_eof = true;
+            return Ok(None);
+        }
+
+        if self.child_id < doc_id {
+            match self.child.skip_to(doc_id)? {
+                Some(SkipToOutcome::Found(result) | SkipToOutcome::NotFound(result)) => {
+                    self.child_id = result.doc_id;
+                    self.child_current = result;
+                }
+                None => self.child_id = DEPLETED,
+            }
+        }
+        // Every id is found, virtually when the child doesn't have it
+        Ok(Some(SkipToOutcome::Found(self.set_current(doc_id))))
+    }
+
+    fn revalidate(&mut self) -> Result<RQEValidateStatus<'_, 'index>, RQEIteratorError> {
+        if self.child_id == DEPLETED {
+            return Ok(RQEValidateStatus::Ok);
+        }
+        let was_current = self.child_id == self.last_doc_id;
+        match self.child.revalidate()? {
+            RQEValidateStatus::Ok => return Ok(RQEValidateStatus::Ok),
+            RQEValidateStatus::Moved {
+                current: Some(result),
+            } => {
+                self.child_id = result.doc_id;
+                self.child_current = result;
+            }
+            // The ids are still yielded once the child is gone, with virtual results
+            RQEValidateStatus::Moved { current: None } | RQEValidateStatus::Aborted => {
+                self.child_id = DEPLETED;
+            }
+        }
+
+        if !was_current || self.last_doc_id == 0 {
+            return Ok(RQEValidateStatus::Ok);
+        }
+        // The current document lost the result of the child, and is now virtual
+        let doc_id = self.last_doc_id;
+        Ok(RQEValidateStatus::Moved {
+            current: Some(self.set_current(doc_id)),
+        })
+    }
+
+    fn rewind(&mut self) {
+        self.child.rewind();
+        self.child_id = 0;
+        self.last_doc_id = 0;
+        self.at_eof = self.max_doc_id == 0;
+        self.virt.doc_id = 0;
+    }
+
+    fn num_estimated(&self) -> usize {
+        self.max_doc_id as usize
+    }
+
+    fn last_doc_id(&self) -> t_docId {
+        self.last_doc_id
+    }
+
+    fn at_eof(&self) -> bool {
+        self.at_eof || self.last_doc_id >= self.max_doc_id
+    }
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Union iterator implementation
+
+use std::ptr;
+
+use ffi::t_docId;
+use inverted_index::RSIndexResult;
+
+use crate::{RQEIterator, RQEIteratorError, RQEValidateStatus, SkipToOutcome, reset_aggregate};
+
+/// The id of a child which has no more results.
+const DEPLETED: t_docId = t_docId::MAX;
+
+/// An iterator that yields the documents any of its children has, with a union result
+/// aggregating the results of the children on the document.
+///
+/// The children are all of the same type, so that the common shapes of the queries, e.g. the
+/// union of the terms a prefix expands to, compile to loops calling the readers of the children
+/// directly. Children of different types can still be united as `Box<dyn RQEIterator>`.
+///
+/// This is a port of the flat variant of the C iterator, which scans the children for the next
+/// document rather than keeping them in a heap.
+pub struct Union<'index, I> {
+    children: Vec<I>,
+    /// The document every child is on, 0 before it is read, or [`DEPLETED`].
+    ids: Vec<t_docId>,
+    /// The current result of every child, inside the child. The children live in the heap buffer
+    /// of `children`, so the results don't move with the iterator.
+    currents: Vec<*mut RSIndexResult<'index>>,
+    /// Whether to only aggregate the first child on a document, when only the documents matter.
+    quick_exit: bool,
+    last_doc_id: t_docId,
+    at_eof: bool,
+    /// A reusable result object to avoid allocations on each `read` call.
+    result: RSIndexResult<'index>,
+}
+
+impl<'index, I> Union<'index, I>
+where
+    I: RQEIterator<'index>,
+{
+    /// Creates a new union iterator, whose results have the given `weight`. With `quick_exit`,
+    /// a result only aggregates one of the children on its document.
+    pub fn new(children: Vec<I>, quick_exit: bool, weight: f64) -> Self {
+        let num = children.len();
+        Self {
+            children,
+            ids: vec![0; num],
+            currents: vec![ptr::null_mut(); num],
+            quick_exit,
+            last_doc_id: 0,
+            at_eof: num == 0,
+            result: RSIndexResult::union(num).weight(weight),
+        }
+    }
+
+    /// Make the smallest document the children are on the current result, or return `false` if
+    /// they have no more results.
+    fn set_result(&mut self) -> bool {
+        let doc_id = self.ids.iter().copied().min().unwrap_or(DEPLETED);
+        if doc_id == DEPLETED {
+            self.at_eof = true;
+            return false;
+        }
+
+        reset_aggregate(&mut self.result);
+        for (&id, &current) in self.ids.iter().zip(&self.currents) {
+            if id == doc_id {
+                // SAFETY: The child is on `doc_id`, so it set its current result, which lives as
+                // long as the child and therefore as long as this result. The result is
+                // aggregated again before it is read once the children moved.
+                self.result.push_borrowed(unsafe { &*current });
+                if self.quick_exit {
+                    break;
+                }
+            }
+        }
+        self.result.doc_id = doc_id;
+        self.last_doc_id = doc_id;
+        true
+    }
+}
+
+impl<'index, I> RQEIterator<'index> for Union<'index, I>
+where
+    I: RQEIterator<'index>,
+{
+    fn read(&mut self) -> Result<Option<&mut RSIndexResult<'index>>, RQEIteratorError> {
+        if self.at_eof {
+            return Ok(None);
+        }
+
+        // Move the children which were on the current document, or not read yet
+        for ((child, id), current) in self
+            .children
+            .iter_mut()
+            .zip(&mut self.ids)
+            .zip(&mut self.currents)
+        {
+            if *id <= self.last_doc_id {
+                match child.read()? {
+                    Some(result) => {
+                        *id = result.doc_id;
+                        *current = result;
+                    }
+                    None => *id = DEPLETED,
+                }
+            }
+        }
+
+        if self.set_result() {
+            Ok(Some(&mut self.result))
+        } else {
+            Ok(None)
+        }
+    }
+
+    fn skip_to(
+        &mut self,
+        doc_id: t_docId,
+    ) -> Result<Option<SkipToOutcome<'_, 'index>>, RQEIteratorError> {
+        debug_assert!(self.last_doc_id < doc_id);
+        if self.at_eof {
+            return Ok(None);
+        }
+
+        for ((child, id), current) in self
+            .children
+            .iter_mut()
+            .zip(&mut self.ids)
+            .zip(&mut self.currents)
+        {
+            if *id < doc_id {
+                match child.skip_to(doc_id)? {
+                    Some(SkipToOutcome::Found(result) | SkipToOutcome::NotFound(result)) => {
+                        *id = result.doc_id;
+                        *current = result;
+                    }
+                    None => *id = DEPLETED,
+                }
+            }
+        }
+
+        if !self.set_result() {
+            Ok(None)
+        } else if self.result.doc_id == doc_id {
+            Ok(Some(SkipToOutcome::Found(&mut self.result)))
+        } else {
+            Ok(Some(SkipToOutcome::NotFound(&mut self.result)))
+        }
+    }
+
+    fn revalidate(&mut self) -> Result<RQEValidateStatus<'_, 'index>, RQEIteratorError> {
+        let mut moved = false;
+        for ((child, id), current) in self
+            .children
+            .iter_mut()
+            .zip(&mut self.ids)
+            .zip(&mut self.currents)
+        {
+            if *id == DEPLETED {
+                continue;
+            }
+            match child.revalidate()? {
+                RQEValidateStatus::Ok => {}
+                RQEValidateStatus::Moved {
+                    current: Some(result),
+                } => {
+                    *id = result.doc_id;
+                    *current = result;
+                    moved = true;
+                }
+                // An aborted child no longer takes part in the union
+                RQEValidateStatus::Moved { current: None } | RQEValidateStatus::Aborted => {
+                    *id = DEPLETED;
+                    moved = true;
+                }
+            }
+        }
+        if !moved || self.at_eof || self.last_doc_id == 0 {
+            return Ok(RQEValidateStatus::Ok);
+        }
+
+        // The children only move forward, so the union is still on its document if any child is
+        let last_doc_id = self.last_doc_id;
+        if !self.set_result() {
+            Ok(RQEValidateStatus::Moved { current: None })
+        } else if self.last_doc_id == last_doc_id {
+            Ok(RQEValidateStatus::Ok)
+        } else {
+            Ok(RQEValidateStatus::Moved {
+                current: Some(&mut self.result),
+            })
+        }
+    }
+
+    fn rewind(&mut self) {
+        for child in &mut self.children {
+            child.rewind();
+        }
+        self.ids.fill(0);
+        self.last_doc_id = 0;
+        self.at_eof = self.children.is_empty();
+        self.result.doc_id = 0;
+    }
+
+    fn num_estimated(&self) -> usize {
+        self.children
+            .iter()
+            .map(|child| child.num_estimated())
+            .sum()
+    }
+
+    fn last_doc_id(&self) -> t_docId {
+        self.last_doc_id
+    }
+
+    fn at_eof(&self) -> bool {
+        // Every child either has no more results, or yielded them all up to the current document
+        self.at_eof
+            || self
+                .children
+                .iter()
+                .zip(&self.ids)
+                .all(|(child, &id)| id == DEPLETED || (id <= self.last_doc_id && child.at_eof()))
+    }
+}
@@ -69,6 +69,14 @@ pub extern "C" fn IndexResult_ConcatMetrics(
     // Do nothing since the code will call this
 }
 
+#[unsafe(no_mangle)]
+pub extern "C" fn RSYieldableMetric_Concat(
+    _parent: *mut *mut ffi::RSYieldableMetric,
+    _child: *const ffi::RSYieldableMetric,
+) {
+    // Do nothing since the code will call this
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn Term_Offset_Data_Free(_tr: *mut RSTermRecord) {
     panic!("Nothing should have copied the term record to require this call");
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+use rqe_iterators::{
+    RQEIterator, RQEValidateStatus, SkipToOutcome, empty::Empty, id_list::IdList,
+    intersection::Intersection, wildcard::Wildcard,
+};
+
+mod c_mocks;
+
+static CASES: &[&[&[u64]]] = &[
+    &[&[1, 2, 3, 4, 5]],
+    &[&[1, 3, 5, 7, 9], &[1, 2, 3, 4, 5, 6, 7, 8, 9, 10]],
+    &[&[2, 4, 6, 8, 10], &[1, 3, 5, 7, 9]],
+    &[
+        &[1, 2, 3, 5, 6, 20, 98, 500, 1000],
+        &[3, 6, 20, 21, 500],
+        &[6, 20, 500, 1001],
+    ],
+    &[&[10, 20, 30, 40, 50], &[50], &[1, 50, 100]],
+];
+
+fn expected(case: &[&[u64]]) -> Vec<u64> {
+    case[0]
+        .iter()
+        .copied()
+        .filter(|id| case.iter().all(|ids| ids.contains(id)))
+        .collect()
+}
+
+fn intersection(case: &[&[u64]]) -> Intersection<'static, IdList<'static>> {
+    let children = case.iter().map(|ids| IdList::new(ids.to_vec())).collect();
+    Intersection::new(children, 2.0)
+}
+
+#[test]
+fn read() {
+    for (ci, &case) in CASES.iter().enumerate() {
+        let mut it = intersection(case);
+        let min = case.iter().map(|ids| ids.len()).min().unwrap();
+        assert_eq!(it.num_estimated(), min, "Case {ci}");
+
+        for expected_id in expected(case) {
+            let res = it.read().unwrap().expect("expected a result");
+            assert_eq!(res.doc_id, expected_id, "Case {ci}");
+            assert_eq!(res.weight, 2.0, "Case {ci}");
+            // One child result per child, all on the document
+            let agg = res.as_aggregate().unwrap();
+            assert_eq!(agg.len(), case.len(), "Case {ci}");
+            for i in 0..agg.len() {
+                assert_eq!(agg.get(i).unwrap().doc_id, expected_id, "Case {ci}");
+            }
+            assert_eq!(it.last_doc_id(), expected_id, "Case {ci}");
+        }
+
+        assert!(matches!(it.read(), Ok(None)), "Case {ci}");
+        assert!(it.at_eof(), "Case {ci}");
+        assert!(matches!(it.read(), Ok(None)), "Case {ci}");
+    }
+}
+
+#[test]
+fn skip_to() {
+    for (ci, &case) in CASES.iter().enumerate() {
+        let expected = expected(case);
+        let top = *case.iter().flat_map(|ids| ids.iter()).max().unwrap();
+        let mut it = intersection(case);
+
+        for probe in 1..=top + 1 {
+            it.rewind();
+            match expected.iter().find(|&&id| id >= probe) {
+                Some(&id) if id == probe => {
+                    let Ok(Some(SkipToOutcome::Found(res))) = it.skip_to(probe) else {
+                        panic!("Case {ci} probe {probe}: expected to find it");
+                    };
+                    assert_eq!(res.doc_id, id, "Case {ci} probe {probe}");
+                }
+                Some(&id) => {
+                    let Ok(Some(SkipToOutcome::NotFound(res))) = it.skip_to(probe) else {
+                        panic!("Case {ci} probe {probe}: expected to land on {id}");
+                    };
+                    assert_eq!(res.doc_id, id, "Case {ci} probe {probe}");
+                }
+                None => {
+                    assert!(
+                        matches!(it.skip_to(probe), Ok(None)),
+                        "Case {ci} probe {probe}"
+                    );
+                    assert!(it.at_eof(), "Case {ci} probe {probe}");
+                }
+            }
+        }
+    }
+}
+
+#[test]
+fn read_after_skip_to() {
+    let mut it = intersection(&[&[1, 2, 3, 4, 5, 6], &[2, 3, 5, 6], &[1, 3, 4, 6]]);
+    let Ok(Some(SkipToOutcome::NotFound(res))) = it.skip_to(2) else {
+        panic!("expected to land on 3");
+    };
+    assert_eq!(res.doc_id, 3);
+    assert_eq!(it.read().unwrap().unwrap().doc_id, 6);
+    assert!(matches!(it.read(), Ok(None)));
+
+    it.rewind();
+    assert!(!it.at_eof());
+    assert_eq!(it.last_doc_id(), 0);
+    assert_eq!(it.read().unwrap().unwrap().doc_id, 3);
+}
+
+#[test]
+fn no_children() {
+    let mut it = Intersection::<IdList>::new(vec![], 1.0);
+    assert!(it.at_eof());
+    assert_eq!(it.num_estimated(), 0);
+    assert!(matches!(it.read(), Ok(None)));
+    assert!(matches!(it.skip_to(1), Ok(None)));
+}
+
+#[test]
+fn boxed_children() {
+    // Children of different types
+    let mut it = Intersection::new(
+        vec![
+            Box::new(IdList::new(vec![2, 4, 6, 8])) as Box<dyn RQEIterator>,
+            Box::new(Wildcard::new(7)),
+        ],
+        1.0,
+    );
+    for expected_id in [2, 4, 6] {
+        assert_eq!(it.read().unwrap().unwrap().doc_id, expected_id);
+    }
+    assert!(matches!(it.read(), Ok(None)));
+
+    let mut it = Intersection::new(
+        vec![
+            Box::new(IdList::new(vec![1, 2])) as Box<dyn RQEIterator>,
+            Box::new(Empty),
+        ],
+        1.0,
+    );
+    assert!(matches!(it.read(), Ok(None)));
+    assert!(it.at_eof());
+}
+
+#[test]
+fn nested() {
+    let inner = vec![
+        Intersection::new(
+            vec![IdList::new(vec![1, 2, 3, 4]), IdList::new(vec![2, 3, 4])],
+            1.0,
+        ),
+        Intersection::new(
+            vec![IdList::new(vec![3, 4, 5]), IdList::new(vec![1, 4, 5])],
+            1.0,
+        ),
+    ];
+    let mut it = Intersection::new(inner, 1.0);
+    let res = it.read().unwrap().unwrap();
+    assert_eq!(res.doc_id, 4);
+    let child = res.get(0).unwrap();
+    assert_eq!(child.doc_id, 4);
+    assert_eq!(child.as_aggregate().unwrap().len(), 2);
+    assert!(matches!(it.read(), Ok(None)));
+}
+
+#[test]
+fn revalidate() {
+    let mut it = intersection(&[&[1, 2, 3], &[2, 3]]);
+    assert_eq!(it.read().unwrap().unwrap().doc_id, 2);
+    assert_eq!(it.revalidate().unwrap(), RQEValidateStatus::Ok);
+    assert_eq!(it.read().unwrap().unwrap().doc_id, 3);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+use rqe_iterators::{RQEIterator, SkipToOutcome, empty::Empty, id_list::IdList, not::Not};
+
+mod c_mocks;
+
+static CASES: &[(&[u64], u64)] = &[
+    (&[1, 3, 5, 7, 9], 10),
+    (&[2, 4, 6, 8, 10], 10),
+    (&[1, 2, 3, 4, 5], 5),
+    (&[1, 2, 3, 5, 6, 20, 98], 100),
+    (&[42], 40),
+    (&[50], 100),
+];
+
+fn expected(ids: &[u64], max_doc_id: u64) -> Vec<u64> {
+    (1..=max_doc_id).filter(|id| !ids.contains(id)).collect()
+}
+
+#[test]
+fn read() {
+    for (ci, &(ids, max_doc_id)) in CASES.iter().enumerate() {
+        let mut it = Not::new(IdList::new(ids.to_vec()), max_doc_id, 3.0);
+        assert_eq!(it.num_estimated(), max_doc_id as usize, "Case {ci}");
+
+        for expected_id in expected(ids, max_doc_id) {
+            let res = it.read().unwrap().expect("expected a result");
+            assert_eq!(res.doc_id, expected_id, "Case {ci}");
+            assert_eq!(res.weight, 3.0, "Case {ci}");
+            assert_eq!(it.last_doc_id(), expected_id, "Case {ci}");
+        }
+
+        assert!(matches!(it.read(), Ok(None)), "Case {ci}");
+        assert!(it.at_eof(), "Case {ci}");
+    }
+}
+
+#[test]
+fn skip_to() {
+    for (ci, &(ids, max_doc_id)) in CASES.iter().enumerate() {
+        let expected = expected(ids, max_doc_id);
+        let mut it = Not::new(IdList::new(ids.to_vec()), max_doc_id, 1.0);
+
+        for probe in 1..=max_doc_id + 1 {
+            it.rewind();
+            match expected.iter().find(|&&id| id >= probe) {
+                Some(&id) if id == probe => {
+                    let Ok(Some(SkipToOutcome::Found(res))) = it.skip_to(probe) else {
+                        panic!("Case {ci} probe {probe}: expected to find it");
+                    };
+                    assert_eq!(res.doc_id, id, "Case {ci} probe {probe}");
+                }
+                Some(&id) => {
+                    let Ok(Some(SkipToOutcome::NotFound(res))) = it.skip_to(probe) else {
+                        panic!("Case {ci} probe {probe}: expected to land on {id}");
+                    };
+                    assert_eq!(res.doc_id, id, "Case {ci} probe {probe}");
+                }
+                None => {
+                    assert!(
+                        matches!(it.skip_to(probe), Ok(None)),
+                        "Case {ci} probe {probe}"
+                    );
+                    assert!(it.at_eof(), "Case {ci} probe {probe}");
+                }
+            }
+        }
+    }
+}
+
+#[test]
+fn empty_child() {
+    let mut it = Not::new(Empty, 3, 1.0);
+    for expected_id in 1..=3 {
+        assert_eq!(it.read().unwrap().unwrap().doc_id, expected_id);
+    }
+    assert!(matches!(it.read(), Ok(None)));
+
+    let mut it = Not::new(Empty, 0, 1.0);
+    assert!(it.at_eof());
+    assert!(matches!(it.read(), Ok(None)));
+}
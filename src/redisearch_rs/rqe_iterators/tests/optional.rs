@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+use inverted_index::RSResultKind;
+use rqe_iterators::{
+    RQEIterator, SkipToOutcome, id_list::IdList, intersection::Intersection, optional::Optional,
+};
+
+mod c_mocks;
+
+static CASES: &[(&[u64], u64)] = &[
+    (&[1, 3, 5, 7, 9], 10),
+    (&[2, 4, 6, 8, 10], 10),
+    (&[1, 2, 3, 4, 5], 5),
+    (&[1, 2, 3, 5, 6, 20, 98], 100),
+    (&[42], 40),
+];
+
+fn child(ids: &[u64]) -> IdList<'static> {
+    // A non-virtual result, to tell the results of the child apart
+    IdList::with_result(ids.to_vec(), inverted_index::RSIndexResult::numeric(1.0))
+}
+
+#[test]
+fn read() {
+    for (ci, &(ids, max_doc_id)) in CASES.iter().enumerate() {
+        let mut it = Optional::new(child(ids), max_doc_id, 4.0);
+        assert_eq!(it.num_estimated(), max_doc_id as usize, "Case {ci}");
+
+        for expected_id in 1..=max_doc_id {
+            let res = it.read().unwrap().expect("expected a result");
+            assert_eq!(res.doc_id, expected_id, "Case {ci}");
+            if ids.contains(&expected_id) {
+                assert_eq!(
+                    res.kind(),
+                    RSResultKind::Numeric,
+                    "Case {ci} id {expected_id}"
+                );
+                assert_eq!(res.weight, 4.0, "Case {ci}");
+            } else {
+                assert_eq!(
+                    res.kind(),
+                    RSResultKind::Virtual,
+                    "Case {ci} id {expected_id}"
+                );
+                assert_eq!(res.weight, 0.0, "Case {ci}");
+            }
+        }
+
+        assert!(it.at_eof(), "Case {ci}");
+        assert!(matches!(it.read(), Ok(None)), "Case {ci}");
+    }
+}
+
+#[test]
+fn skip_to() {
+    for (ci, &(ids, max_doc_id)) in CASES.iter().enumerate() {
+        let mut it = Optional::new(child(ids), max_doc_id, 1.0);
+        for probe in 1..=max_doc_id {
+            it.rewind();
+            let Ok(Some(SkipToOutcome::Found(res))) = it.skip_to(probe) else {
+                panic!("Case {ci} probe {probe}: expected to find it");
+            };
+            assert_eq!(res.doc_id, probe, "Case {ci} probe {probe}");
+            let kind = if ids.contains(&probe) {
+                RSResultKind::Numeric
+            } else {
+                RSResultKind::Virtual
+            };
+            assert_eq!(res.kind(), kind, "Case {ci} probe {probe}");
+        }
+        it.rewind();
+        assert!(matches!(it.skip_to(max_doc_id + 1), Ok(None)), "Case {ci}");
+        assert!(it.at_eof(), "Case {ci}");
+    }
+}
+
+#[test]
+fn read_after_skip_to() {
+    let mut it = Optional::new(child(&[2, 5]), 6, 1.0);
+    assert!(matches!(it.skip_to(3), Ok(Some(SkipToOutcome::Found(_)))));
+    let kinds: Vec<_> =
+        std::iter::from_fn(|| it.read().unwrap().map(|res| (res.doc_id, res.kind()))).collect();
+    assert_eq!(
+        kinds,
+        [
+            (4, RSResultKind::Virtual),
+            (5, RSResultKind::Numeric),
+            (6, RSResultKind::Virtual)
+        ]
+    );
+}
+
+#[test]
+fn in_intersection() {
+    // The optional child doesn't restrict the documents of the intersection
+    let mut it = Intersection::new(
+        vec![
+            Box::new(IdList::new(vec![2, 4, 6])) as Box<dyn RQEIterator>,
+            Box::new(Optional::new(child(&[4, 5]), 10, 1.0)),
+        ],
+        1.0,
+    );
+    for (expected_id, kind) in [
+        (2, RSResultKind::Virtual),
+        (4, RSResultKind::Numeric),
+        (6, RSResultKind::Virtual),
+    ] {
+        let res = it.read().unwrap().unwrap();
+        assert_eq!(res.doc_id, expected_id);
+        assert_eq!(res.get(1).unwrap().kind(), kind);
+    }
+    assert!(matches!(it.read(), Ok(None)));
+}
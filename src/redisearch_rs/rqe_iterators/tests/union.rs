@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+use rqe_iterators::{
+    RQEIterator, RQEValidateStatus, SkipToOutcome, empty::Empty, id_list::IdList, union::Union,
+    wildcard::Wildcard,
+};
+
+mod c_mocks;
+
+static CASES: &[&[&[u64]]] = &[
+    &[&[1, 2, 3, 4, 5]],
+    &[&[1, 3, 5, 7, 9], &[2, 4, 6, 8, 10]],
+    &[&[1, 3, 5, 7, 9], &[1, 2, 3, 4, 5, 6, 7, 8, 9, 10]],
+    &[
+        &[1, 2, 3, 5, 6, 20, 98, 500, 1000],
+        &[3, 6, 20, 21, 500],
+        &[6, 20, 500, 1001],
+    ],
+    &[&[10, 20, 30, 40, 50], &[50], &[1, 50, 100]],
+];
+
+fn expected(case: &[&[u64]]) -> Vec<u64> {
+    let mut ids: Vec<u64> = case.iter().flat_map(|ids| ids.iter().copied()).collect();
+    ids.sort();
+    ids.dedup();
+    ids
+}
+
+fn union(case: &[&[u64]], quick_exit: bool) -> Union<'static, IdList<'static>> {
+    let children = case.iter().map(|ids| IdList::new(ids.to_vec())).collect();
+    Union::new(children, quick_exit, 2.0)
+}
+
+#[test]
+fn read() {
+    for quick_exit in [false, true] {
+        for (ci, &case) in CASES.iter().enumerate() {
+            let mut it = union(case, quick_exit);
+            let sum = case.iter().map(|ids| ids.len()).sum::<usize>();
+            assert_eq!(it.num_estimated(), sum, "Case {ci}");
+            assert!(!it.at_eof(), "Case {ci}");
+
+            for expected_id in expected(case) {
+                assert!(!it.at_eof(), "Case {ci}");
+                let res = it.read().unwrap().expect("expected a result");
+                assert_eq!(res.doc_id, expected_id, "Case {ci}");
+                assert_eq!(res.weight, 2.0, "Case {ci}");
+                // One child result per child on the document, or only the first of them
+                let having = case.iter().filter(|ids| ids.contains(&expected_id)).count();
+                let agg = res.as_aggregate().unwrap();
+                assert_eq!(agg.len(), if quick_exit { 1 } else { having }, "Case {ci}");
+                for i in 0..agg.len() {
+                    assert_eq!(agg.get(i).unwrap().doc_id, expected_id, "Case {ci}");
+                }
+                assert_eq!(it.last_doc_id(), expected_id, "Case {ci}");
+            }
+
+            assert!(it.at_eof(), "Case {ci}");
+            assert!(matches!(it.read(), Ok(None)), "Case {ci}");
+            assert!(it.at_eof(), "Case {ci}");
+        }
+    }
+}
+
+#[test]
+fn skip_to() {
+    for (ci, &case) in CASES.iter().enumerate() {
+        let expected = expected(case);
+        let mut it = union(case, false);
+
+        for probe in 1..=expected.last().unwrap() + 1 {
+            it.rewind();
+            match expected.iter().find(|&&id| id >= probe) {
+                Some(&id) if id == probe => {
+                    let Ok(Some(SkipToOutcome::Found(res))) = it.skip_to(probe) else {
+                        panic!("Case {ci} probe {probe}: expected to find it");
+                    };
+                    assert_eq!(res.doc_id, id, "Case {ci} probe {probe}");
+                }
+                Some(&id) => {
+                    let Ok(Some(SkipToOutcome::NotFound(res))) = it.skip_to(probe) else {
+                        panic!("Case {ci} probe {probe}: expected to land on {id}");
+                    };
+                    assert_eq!(res.doc_id, id, "Case {ci} probe {probe}");
+                }
+                None => {
+                    assert!(
+                        matches!(it.skip_to(probe), Ok(None)),
+                        "Case {ci} probe {probe}"
+                    );
+                    assert!(it.at_eof(), "Case {ci} probe {probe}");
+                }
+            }
+        }
+    }
+}
+
+#[test]
+fn read_after_skip_to() {
+    let mut it = union(&[&[1, 5, 9], &[2, 6], &[7]], false);
+    let Ok(Some(SkipToOutcome::NotFound(res))) = it.skip_to(3) else {
+        panic!("expected to land on 5");
+    };
+    assert_eq!(res.doc_id, 5);
+    for expected_id in [6, 7, 9] {
+        assert_eq!(it.read().unwrap().unwrap().doc_id, expected_id);
+    }
+    assert!(matches!(it.read(), Ok(None)));
+
+    it.rewind();
+    assert!(!it.at_eof());
+    assert_eq!(it.read().unwrap().unwrap().doc_id, 1);
+}
+
+#[test]
+fn no_children() {
+    let mut it = Union::<IdList>::new(vec![], false, 1.0);
+    assert!(it.at_eof());
+    assert_eq!(it.num_estimated(), 0);
+    assert!(matches!(it.read(), Ok(None)));
+    assert!(matches!(it.skip_to(1), Ok(None)));
+}
+
+#[test]
+fn boxed_children() {
+    let mut it = Union::new(
+        vec![
+            Box::new(IdList::new(vec![5, 8])) as Box<dyn RQEIterator>,
+            Box::new(Wildcard::new(3)),
+            Box::new(Empty),
+        ],
+        false,
+        1.0,
+    );
+    for expected_id in [1, 2, 3, 5, 8] {
+        assert_eq!(it.read().unwrap().unwrap().doc_id, expected_id);
+    }
+    assert!(matches!(it.read(), Ok(None)));
+}
+
+#[test]
+fn revalidate() {
+    let mut it = union(&[&[1, 3], &[2, 3]], false);
+    assert_eq!(it.read().unwrap().unwrap().doc_id, 1);
+    assert_eq!(it.revalidate().unwrap(), RQEValidateStatus::Ok);
+    assert_eq!(it.read().unwrap().unwrap().doc_id, 2);
+}
@@ -41,6 +41,16 @@ fn benchmark_wildcard(c: &mut Criterion) {
     bencher.bench(c);
 }
 
+fn benchmark_intersection(c: &mut Criterion) {
+    let bencher = benchers::composite::IntersectionBencher::default();
+    bencher.bench(c);
+}
+
+fn benchmark_union(c: &mut Criterion) {
+    let bencher = benchers::composite::UnionBencher::default();
+    bencher.bench(c);
+}
+
 fn benchmark_inverted_index_numeric_full(c: &mut Criterion) {
     let bencher = benchers::inverted_index::NumericFullBencher::default();
     bencher.bench(c);
@@ -130,6 +140,8 @@ criterion_group!(
     benchmark_wildcard,
     benchmark_inverted_index_numeric_full,
     benchmark_inverted_index_term_full,
+    benchmark_intersection,
+    benchmark_union,
 );
 
 criterion_main!(benches);
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+//! Benchmark the composite iterators over term iterators.
+//!
+//! The children are either all of the same type, which the composite iterators are monomorphized
+//! for, or boxed as `dyn RQEIterator`, which dispatches every call through a vtable as the C
+//! iterators do through their function pointers.
+
+use std::time::Duration;
+
+use ::ffi::RSQueryTerm;
+use criterion::{
+    BenchmarkGroup, Criterion,
+    measurement::{Measurement, WallTime},
+};
+use inverted_index::{InvertedIndex, RSIndexResult, full::Full};
+use rqe_iterators::{
+    RQEIterator, intersection::Intersection, inverted_index::TermFull, union::Union,
+};
+
+const MEASUREMENT_TIME: Duration = Duration::from_millis(500);
+const WARMUP_TIME: Duration = Duration::from_millis(200);
+/// The highest document ID of the indexes.
+const INDEX_SIZE: u64 = 1_000_000;
+/// Every child index has the multiples of its step.
+const STEPS: [u64; 3] = [2, 3, 5];
+/// The increment when skipping to a document ID.
+const SKIP_TO_STEP: u64 = 100;
+
+fn benchmark_group<'a>(
+    c: &'a mut Criterion,
+    it_name: &str,
+    test: &str,
+) -> BenchmarkGroup<'a, WallTime> {
+    let label = format!("Iterator - {it_name} - {test}");
+    let mut group = c.benchmark_group(label);
+    group.measurement_time(MEASUREMENT_TIME);
+    group.warm_up_time(WARMUP_TIME);
+    group
+}
+
+/// The term indexes the children read.
+struct Indexes {
+    indexes: Vec<InvertedIndex<Full>>,
+    /// The term used in records, needs to be kept alive for the duration of the benchmark
+    term: *mut RSQueryTerm,
+}
+
+impl Indexes {
+    fn new() -> Self {
+        const TEST_STR: &str = "term";
+        let term = Box::into_raw(Box::new(RSQueryTerm {
+            str_: TEST_STR.as_ptr() as *mut _,
+            len: TEST_STR.len(),
+            idf: 5.0,
+            id: 1,
+            flags: 0,
+            bm25_idf: 10.0,
+        }));
+
+        let indexes = STEPS
+            .iter()
+            .map(|&step| {
+                let mut ii = InvertedIndex::new(
+                    ::ffi::IndexFlags_Index_StoreFreqs
+                        | ::ffi::IndexFlags_Index_StoreTermOffsets
+                        | ::ffi::IndexFlags_Index_StoreFieldFlags
+                        | ::ffi::IndexFlags_Index_StoreByteOffsets,
+                    Full::default(),
+                );
+                for doc_id in (step..INDEX_SIZE).step_by(step as usize) {
+                    let record = RSIndexResult::term_with_term_ptr(
+                        term,
+                        inverted_index::RSOffsetVector::with_data(std::ptr::null_mut(), 0),
+                        doc_id,
+                        1,
+                        1,
+                    );
+                    ii.add_record(&record).expect("failed to add record");
+                }
+                ii
+            })
+            .collect();
+        Self { indexes, term }
+    }
+
+    fn children(&self) -> Vec<impl RQEIterator<'_>> {
+        self.indexes
+            .iter()
+            .map(|ii| TermFull::new(ii.reader()))
+            .collect()
+    }
+
+    fn boxed_children(&self) -> Vec<Box<dyn RQEIterator<'_> + '_>> {
+        self.indexes
+            .iter()
+            .map(|ii| Box::new(TermFull::new(ii.reader())) as Box<dyn RQEIterator>)
+            .collect()
+    }
+}
+
+impl Drop for Indexes {
+    fn drop(&mut self) {
+        unsafe {
+            let _ = Box::from_raw(self.term);
+        }
+    }
+}
+
+/// Read the iterator to the end, or skip through it by [`SKIP_TO_STEP`] if `skip`.
+fn iterate<'index>(it: &mut impl RQEIterator<'index>, skip: bool) {
+    loop {
+        let next = if skip {
+            it.skip_to(it.last_doc_id() + SKIP_TO_STEP)
+                .map(|outcome| outcome.is_some())
+        } else {
+            it.read().map(|current| current.is_some())
+        };
+        if !criterion::black_box(next.unwrap_or(false)) {
+            break;
+        }
+    }
+}
+
+#[derive(Default)]
+pub struct IntersectionBencher;
+
+impl IntersectionBencher {
+    pub fn bench(&self, c: &mut Criterion) {
+        let indexes = Indexes::new();
+
+        for (test, skip) in [("Read", false), ("SkipTo", true)] {
+            let mut group = benchmark_group(c, "Intersection", test);
+            Self::run(&mut group, &indexes, skip);
+            group.finish();
+        }
+    }
+
+    fn run<M: Measurement>(group: &mut BenchmarkGroup<'_, M>, indexes: &Indexes, skip: bool) {
+        group.bench_function("Rust", |b| {
+            b.iter(|| {
+                let mut it = Intersection::new(indexes.children(), 1.0);
+                iterate(&mut it, skip);
+            });
+        });
+        group.bench_function("Rust dyn", |b| {
+            b.iter(|| {
+                let mut it = Intersection::new(indexes.boxed_children(), 1.0);
+                iterate(&mut it, skip);
+            });
+        });
+    }
+}
+
+#[derive(Default)]
+pub struct UnionBencher;
+
+impl UnionBencher {
+    pub fn bench(&self, c: &mut Criterion) {
+        let indexes = Indexes::new();
+
+        for (test, skip) in [("Read", false), ("SkipTo", true)] {
+            let mut group = benchmark_group(c, "Union", test);
+            Self::run(&mut group, &indexes, skip);
+            group.finish();
+        }
+    }
+
+    fn run<M: Measurement>(group: &mut BenchmarkGroup<'_, M>, indexes: &Indexes, skip: bool) {
+        group.bench_function("Rust", |b| {
+            b.iter(|| {
+                let mut it = Union::new(indexes.children(), false, 1.0);
+                iterate(&mut it, skip);
+            });
+        });
+        group.bench_function("Rust dyn", |b| {
+            b.iter(|| {
+                let mut it = Union::new(indexes.boxed_children(), false, 1.0);
+                iterate(&mut it, skip);
+            });
+        });
+    }
+}
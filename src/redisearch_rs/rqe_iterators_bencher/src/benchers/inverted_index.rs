@@ -34,6 +34,12 @@ const INDEX_SIZE: u64 = 1_000_000;
 const SPARSE_DELTA: u64 = 1000;
 /// The increment when skipping to a document ID.
 const SKIP_TO_STEP: u64 = 100;
+/// The increment when skipping far ahead in the dense index, across many blocks.
+const SKIP_TO_FAR_STEP: u64 = 10_000;
+/// The number of indexes read in turn, as the children of an intersection are.
+const INTERLEAVED_INDEXES: u64 = 8;
+/// The prefetch distance of the C readers compared to no prefetching, the default configuration.
+const PREFETCH_DISTANCE: u32 = 16;
 
 fn benchmark_group<'a>(
     c: &'a mut Criterion,
@@ -56,6 +62,8 @@ impl NumericFullBencher {
         self.read_sparse(c);
         self.skip_to_dense(c);
         self.skip_to_sparse(c);
+        self.skip_to_far(c);
+        self.read_interleaved(c);
     }
 
     fn read_dense(&self, c: &mut Criterion) {
@@ -86,6 +94,20 @@ impl NumericFullBencher {
         group.finish();
     }
 
+    fn skip_to_far(&self, c: &mut Criterion) {
+        let mut group = benchmark_group(c, "NumericFull", "SkipTo Far");
+        self.c_skip_to_far(&mut group);
+        self.rust_skip_to_far(&mut group);
+        group.finish();
+    }
+
+    fn read_interleaved(&self, c: &mut Criterion) {
+        let mut group = benchmark_group(c, "NumericFull", "Read Interleaved");
+        self.c_read_interleaved(&mut group, "C", 0);
+        self.c_read_interleaved(&mut group, "C Prefetch", PREFETCH_DISTANCE);
+        group.finish();
+    }
+
     fn c_index(delta: u64) -> ffi::InvertedIndex {
         let ii = ffi::InvertedIndex::new(ffi::IndexFlags_Index_StoreNumeric);
         for doc_id in 1..INDEX_SIZE {
@@ -119,6 +141,50 @@ impl NumericFullBencher {
         });
     }
 
+    /// Read several dense indexes one entry at a time each, so that every reader moves to a
+    /// block that is cold in the cache.
+    fn c_read_interleaved<M: Measurement>(
+        &self,
+        group: &mut BenchmarkGroup<'_, M>,
+        name: &str,
+        prefetch_distance: u32,
+    ) {
+        group.bench_function(name, |b| {
+            b.iter_batched_ref(
+                || {
+                    crate::set_index_reader_prefetch_distance(prefetch_distance);
+                    (0..INTERLEAVED_INDEXES)
+                        .map(|_| {
+                            let ii = ffi::InvertedIndex::new(ffi::IndexFlags_Index_StoreNumeric);
+                            for doc_id in 1..INDEX_SIZE / INTERLEAVED_INDEXES {
+                                ii.write_numeric_entry(doc_id, doc_id as f64);
+                            }
+                            ii
+                        })
+                        .collect::<Vec<_>>()
+                },
+                |indexes| {
+                    let its: Vec<_> = indexes
+                        .iter()
+                        .map(|ii| ii.iterator_numeric_full())
+                        .collect();
+                    // All the indexes have the same entries, so they all end together.
+                    'read: loop {
+                        for it in &its {
+                            if it.read() != ::ffi::IteratorStatus_ITERATOR_OK {
+                                break 'read;
+                            }
+                            criterion::black_box(it.current());
+                        }
+                    }
+                    its.iter().for_each(ffi::QueryIterator::free);
+                },
+                criterion::BatchSize::SmallInput,
+            );
+        });
+        crate::set_index_reader_prefetch_distance(0);
+    }
+
     fn c_read_sparse<M: Measurement>(&self, group: &mut BenchmarkGroup<'_, M>) {
         group.bench_function("C", |b| {
             b.iter_batched_ref(
@@ -238,6 +304,43 @@ impl NumericFullBencher {
             );
         });
     }
+
+    fn c_skip_to_far<M: Measurement>(&self, group: &mut BenchmarkGroup<'_, M>) {
+        group.bench_function("C", |b| {
+            b.iter_batched_ref(
+                || Self::c_index(1),
+                |ii| {
+                    let it = ii.iterator_numeric_full();
+                    while it.skip_to(it.last_doc_id() + SKIP_TO_FAR_STEP)
+                        != ::ffi::IteratorStatus_ITERATOR_EOF
+                    {
+                        criterion::black_box(it.current());
+                    }
+                    it.free();
+                },
+                criterion::BatchSize::SmallInput,
+            );
+        });
+    }
+
+    fn rust_skip_to_far<M: Measurement>(&self, group: &mut BenchmarkGroup<'_, M>) {
+        group.bench_function("Rust", |b| {
+            b.iter_batched_ref(
+                || Self::rust_index(1),
+                |ii| {
+                    let mut it = NumericFull::new(ii.reader());
+                    while let Ok(Some(outcome)) = it.skip_to(it.last_doc_id() + SKIP_TO_FAR_STEP) {
+                        match outcome {
+                            SkipToOutcome::Found(current) | SkipToOutcome::NotFound(current) => {
+                                criterion::black_box(current);
+                            }
+                        }
+                    }
+                },
+                criterion::BatchSize::SmallInput,
+            );
+        });
+    }
 }
 
 pub struct TermFullBencher<E> {
@@ -294,6 +397,7 @@ where
         self.read_sparse(c);
         self.skip_to_dense(c);
         self.skip_to_sparse(c);
+        self.skip_to_far(c);
     }
 
     fn read_dense(&self, c: &mut Criterion) {
@@ -324,6 +428,13 @@ where
         group.finish();
     }
 
+    fn skip_to_far(&self, c: &mut Criterion) {
+        let mut group = benchmark_group(c, &self.group_name, "SkipTo Far");
+        self.c_skip_to_far(&mut group);
+        self.rust_skip_to_far(&mut group);
+        group.finish();
+    }
+
     fn c_index(&self, sparse: bool) -> ffi::InvertedIndex {
         let ii = ffi::InvertedIndex::new(self.ii_flags);
 
@@ -491,4 +602,41 @@ where
             );
         });
     }
+
+    fn c_skip_to_far<M: Measurement>(&self, group: &mut BenchmarkGroup<'_, M>) {
+        group.bench_function("C", |b| {
+            b.iter_batched_ref(
+                || self.c_index(false),
+                |ii| {
+                    let it = ii.iterator_term_full();
+                    while it.skip_to(it.last_doc_id() + SKIP_TO_FAR_STEP)
+                        != ::ffi::IteratorStatus_ITERATOR_EOF
+                    {
+                        criterion::black_box(it.current());
+                    }
+                    it.free();
+                },
+                criterion::BatchSize::SmallInput,
+            );
+        });
+    }
+
+    fn rust_skip_to_far<M: Measurement>(&self, group: &mut BenchmarkGroup<'_, M>) {
+        group.bench_function("Rust", |b| {
+            b.iter_batched_ref(
+                || self.rust_index(false),
+                |ii| {
+                    let mut it = TermFull::new(ii.reader());
+                    while let Ok(Some(outcome)) = it.skip_to(it.last_doc_id() + SKIP_TO_FAR_STEP) {
+                        match outcome {
+                            SkipToOutcome::Found(current) | SkipToOutcome::NotFound(current) => {
+                                criterion::black_box(current);
+                            }
+                        }
+                    }
+                },
+                criterion::BatchSize::SmallInput,
+            );
+        });
+    }
 }
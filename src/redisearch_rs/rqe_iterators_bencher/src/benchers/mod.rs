@@ -7,6 +7,7 @@
  * GNU Affero General Public License v3 (AGPLv3).
 */
 
+pub mod composite;
 pub mod empty;
 pub mod id_list;
 pub mod inverted_index;
@@ -34,7 +34,17 @@ redis_mock::bind_redis_alloc_symbols_to_mock_impl!();
 // symbols required by the C code we need to redefine
 #[unsafe(no_mangle)]
 #[allow(non_upper_case_globals)]
-pub static mut RSGlobalConfig: *const c_void = std::ptr::null();
+// SAFETY: The C configuration is a plain struct of numbers, flags and pointers, all valid when zeroed.
+pub static mut RSGlobalConfig: ::ffi::RSConfig = unsafe { std::mem::zeroed() };
+
+/// Set the number of entries before the end of an index block at which the C index readers
+/// created from now on prefetch the next block. 0 disables prefetching.
+pub fn set_index_reader_prefetch_distance(distance: u32) {
+    // SAFETY: The benchmarks are single threaded, nothing reads the configuration concurrently.
+    unsafe {
+        RSGlobalConfig.indexReaderPrefetchDistance = distance;
+    }
+}
 
 #[unsafe(no_mangle)]
 #[allow(non_upper_case_globals)]
@@ -516,18 +516,17 @@ int RedisModule_Reply_RSValue(RedisModule_Reply *reply, const RSValue *v, SendRe
 
     case RSValueType_Number: {
       if (!(flags & SENDREPLY_FLAG_EXPAND)) {
+        if ((flags & SENDREPLY_FLAG_TYPED) && reply->resp3) {
+          return RedisModule_Reply_Double(reply, RSValue_Number_Get(v));
+        }
         char buf[128];
         size_t len = RSValue_NumToString(v, buf);
 
         if (flags & SENDREPLY_FLAG_TYPED) {
-          if (reply->resp3) {
-            return RedisModule_Reply_Double(reply, RSValue_Number_Get(v));
-          } else {
-             // In RESP2, RM_ReplyWithDouble() does not tag the response as
-             // double, it's just a plain string. So we send it as simple string
-             // that is converted to double by MRReply_ToValue().
-            return RedisModule_Reply_Error(reply, buf);
-          }
+          // In RESP2, RM_ReplyWithDouble() does not tag the response as
+          // double, it's just a plain string. So we send it as simple string
+          // that is converted to double by MRReply_ToValue().
+          return RedisModule_Reply_Error(reply, buf);
         } else {
           return RedisModule_Reply_StringBuffer(reply, buf, len);
         }
@@ -16,11 +16,15 @@
 #include "util/timeout.h"
 #include "util/arr.h"
 #include "iterators/empty_iterator.h"
+#include "iterators/wildcard_iterator.h"
+#include "iterators/inverted_index_iterator.h"
+#include "ttl_table.h"
 #include "rs_wall_clock.h"
 #include <stdatomic.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <time.h>
+#include <math.h>
 #include "util/references.h"
 #include "hybrid/hybrid_scoring.h"
 #include "hybrid/hybrid_search_result.h"
@@ -29,6 +33,9 @@
 #include "search_disk.h"
 #include "debug_commands.h"
 #include "search_result.h"
+#include "value_intern.h"
+#include "info/latency_stats.h"
+#include "aggregate/binary_rows.h"
 
 /*******************************************************************************************************************
  *  Base Result Processor - this processor is the topmost processor of every processing chain.
@@ -41,14 +48,65 @@ static int UnlockSpec_and_ReturnRPResult(RedisSearchCtx *sctx, int result_status
   RedisSearchCtx_UnlockSpec(sctx);
   return result_status;
 }
+
+#define RP_QUERY_IT_BATCH_SIZE 128
+// The minimal number of ids the root reads under the spec read lock before it yields it to a writer
+#define RP_QUERY_IT_YIELD_INTERVAL 1024
+
 typedef struct {
   ResultProcessor base;
   QueryIterator *iterator;
   size_t timeoutLimiter;    // counter to limit number of calls to TimedOut_WithCounter()
   RedisSearchCtx *sctx;
   const SharedSlotRangeArray *slotRanges; // Owned slot ranges info, may be used for filtering
+
+  // When the root iterator yields nothing but ids, they are read ahead in batches (see `rpQueryItCanBatch`)
+  bool batched;
+  size_t batchPos;          // index of the next id of `batch` to yield
+  size_t batchLen;          // number of ids in `batch`
+  t_docId batch[RP_QUERY_IT_BATCH_SIZE];
+
+  // When reading a single range of the query (see `RPQueryRanges`), only the ids in
+  // [rangeStart, rangeEnd) are yielded, and the spec is locked and unlocked by the ranges processor
+  bool ranged;
+  t_docId rangeStart;       // the id to skip to before the first read. 0 once skipped
+  t_docId rangeEnd;
+
+  // When set, the results borrow their document metadata from the doc table instead of taking a
+  // reference to it, and the spec is left locked once the root is done. Set by a sorter directly
+  // downstream, which pins the results it keeps and unlocks the spec (see `rpsortBorrowDmds`)
+  bool borrowDmds;
+
+  // When set, the results are counted into the total results of the query rather than yielded, if
+  // the root can tell them apart without their metadata (see `RPQueryIterator_Count`)
+  bool countOnly;
+
+  // The ids read since the spec was locked, see `rpQueryItShouldYield`
+  size_t readsSinceLock;
+  // The iterators replaced by an empty one when they failed to revalidate. The results yielded
+  // before may still point to their current result, so they are freed with the processor
+  arrayof(QueryIterator *) retired;
 } RPQueryIterator;
 
+/* The spec is unlocked once the root is done, unless the processor reads a range of the query or
+ * its results borrow their metadata */
+static inline int rpQueryItReturn(RPQueryIterator *self, int result_status) {
+  if (self->ranged || self->borrowDmds) {
+    return result_status;
+  }
+  return UnlockSpec_and_ReturnRPResult(self->sctx, result_status);
+}
+
+
+/* A long query yields the spec read lock between its results when a writer waits for it, rather
+ * than holding off the indexing and the GC until it is done. The spec is locked again (after the
+ * writer, since the lock prefers writers) and the iterators revalidated as for a cursor read.
+ * Not when the results borrow their metadata, or when the ranges processor owns the lock */
+static inline bool rpQueryItShouldYield(const RPQueryIterator *self) {
+  return self->sctx->flags == RS_CTX_READONLY && !self->ranged && !self->borrowDmds &&
+         self->readsSinceLock >= RP_QUERY_IT_YIELD_INTERVAL &&
+         __atomic_load_n(&self->sctx->spec->writersWaiting, __ATOMIC_RELAXED);
+}
 
 /****
  * getDocumentMetadata - get the document metadata for the current document from the iterator.
@@ -59,12 +117,15 @@ typedef struct {
  * @param docs The document table
  * @param sctx The search context
  * @param it The query iterator
+ * @param docId The id of the document, either the last id read from `it` or an id it read ahead
  * @param dmd The document metadata pointer to set
+ * @param borrowed Set to whether *dmd is borrowed, if `borrow` is set and the metadata is taken from the doc table
  * @return true if the document is not deleted or expired, false otherwise.
  */
-static bool getDocumentMetadata(IndexSpec* spec, DocTable* docs, RedisSearchCtx *sctx, const QueryIterator *it, const RSDocumentMetadata **dmd) {
+static bool getDocumentMetadata(IndexSpec* spec, DocTable* docs, RedisSearchCtx *sctx, const QueryIterator *it, t_docId docId, const RSDocumentMetadata **dmd, bool borrow, bool *borrowed) {
+  *borrowed = false;
   if (spec->diskSpec) {
-    RSDocumentMetadata* diskDmd = (RSDocumentMetadata *)rm_calloc(1, sizeof(RSDocumentMetadata));
+    RSDocumentMetadata* diskDmd = DMD_Alloc();
     diskDmd->ref_count = 1;
     // Start from checking the deleted-ids (in memory), then perform IO
     const bool foundDocument = !SearchDisk_DocIdDeleted(spec->diskSpec, it->current->docId) && SearchDisk_GetDocumentMetadata(spec->diskSpec, it->current->docId, diskDmd);
@@ -76,17 +137,118 @@ static bool getDocumentMetadata(IndexSpec* spec, DocTable* docs, RedisSearchCtx
   } else {
     if (it->current->dmd) {
       *dmd = it->current->dmd;
+    } else if (borrow) {
+      *dmd = DocTable_Lookup(docs, docId);
+      *borrowed = true;
     } else {
-      *dmd = DocTable_Borrow(docs, it->lastDocId);
+      *dmd = DocTable_Borrow(docs, docId);
     }
     if (!*dmd || (*dmd)->flags & Document_Deleted || DocTable_IsDocExpired(docs, *dmd, &sctx->time.current)) {
-      DMD_Return(*dmd);
+      if (!*borrowed) {
+        DMD_Return(*dmd);
+      }
       return false;;
     }
   }
   return true;
 }
 
+/* Read the next id from the root iterator, either directly or from the read-ahead batch */
+static inline IteratorStatus rpQueryItReadNext(RPQueryIterator *self, t_docId *docId) {
+  QueryIterator *it = self->iterator;
+  if (!self->batched) {
+    IteratorStatus rc = it->Read(it);
+    *docId = it->lastDocId;
+    return rc;
+  }
+  if (self->batchPos == self->batchLen) {
+    IteratorStatus rc = it->ReadBatch(it, self->batch, RP_QUERY_IT_BATCH_SIZE, &self->batchLen);
+    self->batchPos = 0;
+    if (rc != ITERATOR_OK) {
+      return rc;
+    }
+  }
+  *docId = self->batch[self->batchPos++];
+  // The results of the root differ only by their id, so we can yield its current result for any of them
+  it->current->docId = *docId;
+  return ITERATOR_OK;
+}
+
+/* Read the next id, starting the range of the processor at its first id and ending it at its last */
+static inline IteratorStatus rpQueryItRead(RPQueryIterator *self, t_docId *docId) {
+  if (!self->ranged) {
+    return rpQueryItReadNext(self, docId);
+  }
+  IteratorStatus rc;
+  if (self->rangeStart) {
+    QueryIterator *it = self->iterator;
+    rc = it->SkipTo(it, self->rangeStart);
+    self->rangeStart = 0;
+    if (rc == ITERATOR_NOTFOUND) {
+      rc = ITERATOR_OK;
+    }
+    *docId = it->lastDocId;
+  } else {
+    rc = rpQueryItReadNext(self, docId);
+  }
+  // The ids past the range are read by the next range
+  if (rc == ITERATOR_OK && *docId >= self->rangeEnd) {
+    return ITERATOR_EOF;
+  }
+  return rc;
+}
+
+static int rpQueryItEOF(ResultProcessor *base, SearchResult *res) {
+  return RS_RESULT_EOF;
+}
+
+/* Can the results be counted without their metadata? Only if every id the iterators read is that of a
+ * document of the table, which neither expires nor is filtered out by its slot: no document was ever
+ * removed from the table (so the inverted indexes hold no id for the GC to collect), and none of them
+ * has an expiration */
+static bool rpQueryItCanCount(const RPQueryIterator *self) {
+  const IndexSpec *spec = self->sctx->spec;
+  const DocTable *docs = &spec->docs;
+  return !self->ranged && !spec->diskSpec && !isTrimming && !should_filter_slots &&
+         docs->size == docs->maxDocId + 1 && (!docs->ttl || TimeToLiveTable_IsEmpty(docs->ttl));
+}
+
+/* Count the remaining results into the total results of the query, reading the ids of the root in
+ * batches. The results of an inverted index which was not read yet are the documents it holds */
+static int rpQueryItCount(RPQueryIterator *self) {
+  QueryIterator *it = self->iterator;
+  RedisSearchCtx *sctx = self->sctx;
+  uint32_t *total = &self->base.parent->totalResults;
+  // The ids read ahead were not yielded yet
+  *total += self->batchLen - self->batchPos;
+  self->batchPos = self->batchLen;
+
+  size_t numResults;
+  if (InvIndIterator_NumResults(it, &numResults)) {
+    *total += numResults;
+    self->base.Next = rpQueryItEOF;
+    return RS_RESULT_EOF;
+  }
+
+  IteratorStatus rc = ITERATOR_OK;
+  while (rc == ITERATOR_OK) {
+    if (TimedOut_WithCounter(&sctx->time.timeout, &self->timeoutLimiter) == TIMED_OUT ||
+        QueryCancelToken_IsCancelled(sctx->time.cancel)) {
+      return RS_RESULT_TIMEDOUT;
+    }
+    size_t len;
+    rc = it->ReadBatch(it, self->batch, RP_QUERY_IT_BATCH_SIZE, &len);
+    if (rc == ITERATOR_OK) {
+      *total += len;
+    }
+  }
+  if (rc == ITERATOR_TIMEOUT) {
+    return RS_RESULT_TIMEDOUT;
+  }
+  self->base.Next = rpQueryItEOF;
+  return RS_RESULT_EOF;
+}
+
 /* Next implementation */
 static int rpQueryItNext(ResultProcessor *base, SearchResult *res) {
   RPQueryIterator *self = (RPQueryIterator *)base;
@@ -94,42 +256,69 @@ static int rpQueryItNext(ResultProcessor *base, SearchResult *res) {
   RedisSearchCtx *sctx = self->sctx;
   DocTable* docs = &self->sctx->spec->docs;
   const RSDocumentMetadata *dmd;
+  bool borrowed;
+  t_docId docId;
+  if (rpQueryItShouldYield(self)) {
+    RedisSearchCtx_UnlockSpec(sctx);
+  }
   if (sctx->flags == RS_CTX_UNSET) {
     // If we need to read the iterators and we didn't lock the spec yet, lock it now
     // and reopen the keys in the concurrent search context (iterators' validation)
+    rs_wall_clock lockClock;
+    rs_wall_clock_init(&lockClock);
     RedisSearchCtx_LockSpecRead(sctx);
+    base->parent->lockWaitTime += rs_wall_clock_elapsed_ns(&lockClock);
+    self->readsSinceLock = 0;
     ValidateStatus rc = it->Revalidate(it);
     if (rc == VALIDATE_ABORTED) {
       // The iterator is no longer valid, we should not use it.
-      self->iterator->Free(self->iterator);
+      array_ensure_append_1(self->retired, self->iterator);
       it = self->iterator = NewEmptyIterator(); // Replace with a new empty iterator
+      self->batched = false;
+      self->batchPos = self->batchLen = 0;
     } else if (rc == VALIDATE_MOVED && !it->atEOF) {
       // The iterator is still valid, but the current result has changed, or we are at EOF.
       // If we are at EOF, we can enter the loop and let it handle it. (reading again should be safe)
-      goto validate_current;
+      if (self->batchPos == self->batchLen) {
+        docId = it->lastDocId;
+        goto validate_current;
+      }
+      // The iterator moved past the ids we read ahead. Yield its new position right after them
+      // (we already yielded at least one id of the batch, so there is room for another one)
+      RS_ASSERT(self->batchLen - self->batchPos < RP_QUERY_IT_BATCH_SIZE);
+      memmove(self->batch, self->batch + self->batchPos, (self->batchLen - self->batchPos) * sizeof(*self->batch));
+      self->batchLen -= self->batchPos;
+      self->batchPos = 0;
+      self->batch[self->batchLen++] = it->lastDocId;
     }
   }
 
+  if (self->countOnly && rpQueryItCanCount(self)) {
+    return rpQueryItReturn(self, rpQueryItCount(self));
+  }
+
   // Read from the root filter until we have a valid result
   while (1) {
     // check for timeout in case we are encountering a lot of deleted documents
-    if (TimedOut_WithCounter(&sctx->time.timeout, &self->timeoutLimiter) == TIMED_OUT) {
-      return UnlockSpec_and_ReturnRPResult(sctx, RS_RESULT_TIMEDOUT);
+    if (TimedOut_WithCounter(&sctx->time.timeout, &self->timeoutLimiter) == TIMED_OUT ||
+        QueryCancelToken_IsCancelled(sctx->time.cancel)) {
+      return rpQueryItReturn(self, RS_RESULT_TIMEDOUT);
     }
-    IteratorStatus rc = it->Read(it);
+    IteratorStatus rc = rpQueryItRead(self, &docId);
+    self->readsSinceLock++;
     switch (rc) {
     case ITERATOR_EOF:
       // This means we are done!
-      return UnlockSpec_and_ReturnRPResult(sctx, RS_RESULT_EOF);
+      return rpQueryItReturn(self, RS_RESULT_EOF);
     case ITERATOR_TIMEOUT:
-      return UnlockSpec_and_ReturnRPResult(sctx, RS_RESULT_TIMEDOUT);
+      return rpQueryItReturn(self, RS_RESULT_TIMEDOUT);
     default:
       RS_ASSERT(rc == ITERATOR_OK);
     }
 
 validate_current:
     IndexSpec* spec = self->sctx->spec;
-    if (!getDocumentMetadata(spec, docs, sctx, it, &dmd)) {
+    if (!getDocumentMetadata(spec, docs, sctx, it, docId, &dmd, self->borrowDmds, &borrowed)) {
       continue;
     }
 
@@ -140,7 +329,9 @@ validate_current:
       int firstSlot, lastSlot;
       RedisModule_ShardingGetSlotRange(&firstSlot, &lastSlot);
       if (firstSlot > slot || lastSlot < slot) {
-        DMD_Return(dmd);
+        if (!borrowed) {
+          DMD_Return(dmd);
+        }
         continue;
       }
     }
@@ -148,7 +339,9 @@ validate_current:
       RS_ASSERT(self->slotRanges != NULL);
       int slot = RedisModule_ClusterKeySlotC(dmd->keyPtr, sdslen(dmd->keyPtr));
       if (!Slots_CanAccessKeysInSlot(self->slotRanges, slot)) {
-        DMD_Return(dmd);
+        if (!borrowed) {
+          DMD_Return(dmd);
+        }
         continue;
       }
     }
@@ -159,10 +352,13 @@ validate_current:
   }
 
   // set the result data
-  SearchResult_SetDocId(res, it->lastDocId);
+  SearchResult_SetDocId(res, docId);
   SearchResult_SetIndexResult(res, it->current);
   SearchResult_SetScore(res, 0);
   SearchResult_SetDocumentMetadata(res, dmd);
+  if (borrowed) {
+    SearchResult_SetFlags(res, SearchResult_GetFlags(res) | Result_BorrowedDmd);
+  }
   RLookupRow_SetSortingVector(SearchResult_GetRowDataMut(res), dmd->sortVector);
   return RS_RESULT_OK;
 }
@@ -170,14 +366,28 @@ validate_current:
 static void rpQueryItFree(ResultProcessor *iter) {
   RPQueryIterator *self = (RPQueryIterator *)iter;
   self->iterator->Free(self->iterator);
+  if (self->retired) {
+    array_foreach(self->retired, retired, retired->Free(retired));
+    array_free(self->retired);
+  }
   Slots_FreeLocalSlots(self->slotRanges);
   rm_free(iter);
 }
 
+/* Can we read the ids of the root iterator ahead? Only if its results carry no data but their id (so
+ * yielding its current result for any of them is valid), and it is not provided by the disk API */
+static bool rpQueryItCanBatch(const QueryIterator *root, const RedisSearchCtx *sctx) {
+  if (sctx->spec && sctx->spec->diskSpec) {
+    return false;
+  }
+  return IsWildcardIterator((QueryIterator *)root) || root->type == ID_LIST_ITERATOR;
+}
+
 ResultProcessor *RPQueryIterator_New(QueryIterator *root, const SharedSlotRangeArray *slotRanges, RedisSearchCtx *sctx) {
   RS_ASSERT(root != NULL);
   RPQueryIterator *ret = rm_calloc(1, sizeof(*ret));
   ret->iterator = root;
+  ret->batched = rpQueryItCanBatch(root, sctx);
   ret->slotRanges = slotRanges;
   ret->base.Next = rpQueryItNext;
   ret->base.Free = rpQueryItFree;
@@ -186,6 +396,21 @@ ResultProcessor *RPQueryIterator_New(QueryIterator *root, const SharedSlotRangeA
   return &ret->base;
 }
 
+int RPQueryIterator_Count(ResultProcessor *rp, size_t *count) {
+  RS_ASSERT(rp->type == RP_INDEX);
+  RPQueryIterator *self = (RPQueryIterator *)rp;
+  self->countOnly = true;
+  const uint32_t before = rp->parent->totalResults;
+  SearchResult r = {0};
+  int rc;
+  while ((rc = rp->Next(rp, &r)) == RS_RESULT_OK) {
+    SearchResult_Clear(&r);
+  }
+  SearchResult_Destroy(&r);
+  *count = rp->parent->totalResults - before;
+  return rc;
+}
+
 QueryIterator *QITR_GetRootFilter(QueryProcessingCtx *it) {
   /* On coordinator, the root result processor will be a network result processor and we should ignore it */
   if (it->rootProc->type == RP_INDEX) {
@@ -214,6 +439,44 @@ void QITR_FreeChain(QueryProcessingCtx *qitr) {
   }
 }
 
+int RP_NextBatch(ResultProcessor *rp, SearchResult *res, size_t cap, size_t *len) {
+  if (rp->NextBatch) {
+    return rp->NextBatch(rp, res, cap, len);
+  }
+  int rc = RS_RESULT_OK;
+  size_t n = 0;
+  while (n < cap && (rc = rp->Next(rp, &res[n])) == RS_RESULT_OK) {
+    n++;
+  }
+  *len = n;
+  return rc;
+}
+
+SearchResult *RP_NewBatch(void) {
+  return rm_calloc(RP_BATCH_SIZE, sizeof(SearchResult));
+}
+
+void RP_FreeBatch(SearchResult *batch) {
+  if (!batch) return;
+  for (size_t i = 0; i < RP_BATCH_SIZE; i++) {
+    SearchResult_Destroy(&batch[i]);
+  }
+  rm_free(batch);
+}
+
+// Swaps the contents of two results, so that each of them keeps owning its own allocations
+static inline void rpBatchSwapInto(SearchResult *a, SearchResult *b) {
+  SearchResult tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
+
+void RP_BatchSwap(SearchResult *res, size_t i, size_t j) {
+  if (i != j) {
+    rpBatchSwapInto(&res[i], &res[j]);
+  }
+}
+
 /*******************************************************************************************************************
  *  Scoring Processor
  *
@@ -225,11 +488,44 @@ void QITR_FreeChain(QueryProcessingCtx *qitr) {
 typedef struct {
   ResultProcessor base;
   RSScoringFunction scorer;
+  RSBatchScoringFunction batchScorer;
   RSFreeFunction scorerFree;
   ScoringFunctionArgs scorerCtx;
   const RLookupKey *scoreKey;
+  // The arguments and the scores of the batch scorer, of RP_BATCH_SIZE entries each
+  const RSDocumentMetadata **batchDmds;
+  double *batchScores;
 } RPScorer;
 
+// Sets the score of `res`. Returns false if the result was filtered out by the
+// scorer, in which case it is cleared.
+static bool rpscoreSet(RPScorer *self, SearchResult *res, double score) {
+  ResultProcessor *base = &self->base;
+  SearchResult_SetScore(res, score);
+  if (self->scorerCtx.scrExp) {
+    SearchResult_SetScoreExplain(res, (RSScoreExplain *)self->scorerCtx.scrExp);
+    self->scorerCtx.scrExp = rm_calloc(1, sizeof(RSScoreExplain));
+  }
+  // If we got the special score RS_SCORE_FILTEROUT - disregard the result and decrease the total
+  // number of results (it's been increased by the upstream processor)
+  if (SearchResult_GetScore(res) == RS_SCORE_FILTEROUT) {
+    base->parent->totalResults--;
+    SearchResult_Clear(res);
+    return false;
+  }
+  if (self->scoreKey) {
+    RLookup_WriteOwnKey(self->scoreKey, SearchResult_GetRowDataMut(res), RSValue_NewNumber(SearchResult_GetScore(res)));
+  }
+  return true;
+}
+
+// Applies the scoring function to `res`, see rpscoreSet()
+static bool rpscoreApply(RPScorer *self, SearchResult *res) {
+  return rpscoreSet(self, res, self->scorer(&self->scorerCtx, SearchResult_GetIndexResult(res),
+                                            SearchResult_GetDocumentMetadata(res),
+                                            self->base.parent->minScore));
+}
+
 static int rpscoreNext(ResultProcessor *base, SearchResult *res) {
   int rc;
   RPScorer *self = (RPScorer *)base;
@@ -239,29 +535,51 @@ static int rpscoreNext(ResultProcessor *base, SearchResult *res) {
     if (rc != RS_RESULT_OK) {
       return rc;
     }
+    // continue and loop to the next result if this one is excluded by the scorer
+  } while (!rpscoreApply(self, res));
+
+  return rc;
+}
+
+static int rpscoreNextBatch(ResultProcessor *base, SearchResult *res, size_t cap, size_t *len) {
+  int rc = RS_RESULT_OK;
+  size_t n, kept = 0;
+  RPScorer *self = (RPScorer *)base;
 
-    // Apply the scoring function
-    SearchResult_SetScore(res, self->scorer(&self->scorerCtx, SearchResult_GetIndexResult(res), SearchResult_GetDocumentMetadata(res), base->parent->minScore));
-    if (self->scorerCtx.scrExp) {
-      SearchResult_SetScoreExplain(res, (RSScoreExplain *)self->scorerCtx.scrExp);
-      self->scorerCtx.scrExp = rm_calloc(1, sizeof(RSScoreExplain));
+  if (!self->batchScorer || self->scorerCtx.scrExp) {
+    // The index result of a result read from the index is its iterator's current one, which the
+    // next read overwrites, so each result is scored as soon as it is read
+    while (kept < cap && (rc = base->upstream->Next(base->upstream, &res[kept])) == RS_RESULT_OK) {
+      if (rpscoreApply(self, &res[kept])) {
+        kept++;
+      }
     }
-    // If we got the special score RS_SCORE_FILTEROUT - disregard the result and decrease the total
-    // number of results (it's been increased by the upstream processor)
-    if (SearchResult_GetScore(res) == RS_SCORE_FILTEROUT) {
-      base->parent->totalResults--;
-      SearchResult_Clear(res);
-      // continue and loop to the next result, since this is excluded by the
-      // scorer.
-      continue;
+    *len = kept;
+    return rc;
+  }
+
+  if (!self->batchDmds) {
+    self->batchDmds = rm_malloc(RP_BATCH_SIZE * sizeof(*self->batchDmds));
+    self->batchScores = rm_malloc(RP_BATCH_SIZE * sizeof(*self->batchScores));
+  }
+  cap = MIN(cap, RP_BATCH_SIZE);
+  do {
+    rc = RP_NextBatch(base->upstream, res, cap, &n);
+    for (size_t i = 0; i < n; i++) {
+      self->batchDmds[i] = SearchResult_GetDocumentMetadata(&res[i]);
     }
-    if (self->scoreKey) {
-      RLookup_WriteOwnKey(self->scoreKey, SearchResult_GetRowDataMut(res), RSValue_NewNumber(SearchResult_GetScore(res)));
+    self->batchScorer(&self->scorerCtx, self->batchDmds, n, base->parent->minScore,
+                      self->batchScores);
+    // Set the scores in place, moving the filtered out results to the end of the batch
+    kept = 0;
+    for (size_t i = 0; i < n; i++) {
+      if (rpscoreSet(self, &res[i], self->batchScores[i])) {
+        RP_BatchSwap(res, kept++, i);
+      }
     }
+  } while (kept == 0 && rc == RS_RESULT_OK);
 
-    break;
-  } while (1);
-
+  *len = kept;
   return rc;
 }
 
@@ -273,6 +591,8 @@ static void rpscoreFree(ResultProcessor *rp) {
   }
   rm_free(self->scorerCtx.scrExp);
   self->scorerCtx.scrExp = NULL;
+  rm_free(self->batchDmds);
+  rm_free(self->batchScores);
   rm_free(self);
 }
 
@@ -283,10 +603,12 @@ ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
                               const RLookupKey *rlk) {
   RPScorer *ret = rm_calloc(1, sizeof(*ret));
   ret->scorer = funcs->sf;
+  ret->batchScorer = funcs->bsf;
   ret->scorerFree = funcs->ff;
   ret->scorerCtx = *fnargs;
   ret->scoreKey = rlk;
   ret->base.Next = rpscoreNext;
+  ret->base.NextBatch = rpscoreNextBatch;
   ret->base.Free = rpscoreFree;
   ret->base.type = RP_SCORER;
   return &ret->base;
@@ -356,6 +678,15 @@ ResultProcessor *RPMetricsLoader_New() {
 
 typedef int (*RPSorterCompareFunc)(const void *e1, const void *e2, const void *udata);
 
+// A result accumulated by the numeric top-k selection. The sort value and the doc id are
+// encoded so that a larger entry always sorts first, whatever the sort direction is.
+typedef struct {
+  double key;
+  t_docId tie;
+  bool hasValue;
+  SearchResult *res;
+} RPSortNumEntry;
+
 typedef struct {
   ResultProcessor base;
 
@@ -377,8 +708,37 @@ typedef struct {
     uint64_t ascendMap;
   } fieldcmp;
 
+  // Results read from upstream in batches, if it supports it (allocated lazily)
+  SearchResult *batch;
+
+  // Top-k selection used instead of the heap when sorting by a single numeric key.
+  // Up to twice the heap size of results are kept, and whenever the buffer fills up it is
+  // trimmed back to the best ones, whose worst entry is then used to reject new results.
+  struct {
+    bool active;
+    bool ascending;
+    bool hasThreshold;
+    RPSortNumEntry threshold;
+    RPSortNumEntry *entries; // array_*
+    size_t yieldIdx;
+    // When set, the sort values are read from the sorting columns of the index while it is locked
+    const RedisSearchCtx *sctx;
+  } num;
+
   // Whether a timeout warning needs to be propagated down the downstream
   bool timedOut;
+
+  // When set, the root directly upstream yields results which borrow their metadata, and leaves
+  // this context locked for the sorter to unlock once it is done accumulating
+  RedisSearchCtx *borrowSctx;
+
+  // When set, the upstream yields runs of results which are already sorted, and this drops the
+  // rest of the current run
+  void (*skipRun)(ResultProcessor *upstream);
+
+  // When set, the results scoring below the threshold are dropped
+  bool hasScoreThreshold;
+  double scoreThreshold;
 } RPSorter;
 
 /* Yield - pops the current top result from the heap */
@@ -387,8 +747,7 @@ static int rpsortNext_Yield(ResultProcessor *rp, SearchResult *r) {
   SearchResult *cur_best = mmh_pop_max(self->pq);
 
   if (cur_best) {
-    SearchResult_Override(r, cur_best);
-    rm_free(cur_best);
+    SearchResult_MoveFree(r, cur_best);
     return RS_RESULT_OK;
   }
   int ret = self->timedOut ? RS_RESULT_TIMEDOUT : RS_RESULT_EOF;
@@ -396,11 +755,19 @@ static int rpsortNext_Yield(ResultProcessor *rp, SearchResult *r) {
   return ret;
 }
 
+static void srDtor(void *p);
+
 static void rpsortFree(ResultProcessor *rp) {
   RPSorter *self = (RPSorter *)rp;
 
-  SearchResult_Destroy(self->pooledResult);
-  rm_free(self->pooledResult);
+  SearchResult_Free(self->pooledResult);
+  RP_FreeBatch(self->batch);
+
+  // free the results accumulated by the numeric selection that were not yielded
+  for (size_t i = self->num.yieldIdx; i < array_len(self->num.entries); i++) {
+    srDtor(self->num.entries[i].res);
+  }
+  array_free(self->num.entries);
 
   // calling mmh_free will free all the remaining results in the heap, if any
   mmh_free(self->pq);
@@ -409,23 +776,234 @@ static void rpsortFree(ResultProcessor *rp) {
 
 #define RESULT_QUEUED RS_RESULT_MAX + 1
 
-static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
+/************************* Numeric top-k selection *************************/
+
+static inline bool numEntryBetter(const RPSortNumEntry *a, const RPSortNumEntry *b) {
+  if (a->hasValue != b->hasValue) {
+    // Results without a sort value come last in either direction
+    return a->hasValue;
+  }
+  if (a->key != b->key) {
+    return a->key > b->key;
+  }
+  return a->tie > b->tie;
+}
+
+static int numEntryCmp(const void *e1, const void *e2) {
+  const RPSortNumEntry *a = e1, *b = e2;
+  return numEntryBetter(a, b) ? -1 : (numEntryBetter(b, a) ? 1 : 0);
+}
+
+// Reads the sort value of a result from the sorting columns of the index. Returns false if the
+// value has to be read from the row.
+static inline bool rpsortNumColumnValue(const RPSorter *self, const RLookupRow *row, t_docId docId,
+                                        double *d) {
+  const RedisSearchCtx *sctx = self->num.sctx;
+  // The columns may change once the spec is unlocked, e.g. when the results were loaded upstream
+  if (!sctx || sctx->flags == RS_CTX_UNSET) {
+    return false;
+  }
+  const RLookupKey *key = self->fieldcmp.keys[0];
+  if (row->dyn && array_len(row->dyn) > key->dstidx && row->dyn[key->dstidx]) {
+    // The row has its own value for the key
+    return false;
+  }
+  *d = DocTable_GetSortingNumber(&sctx->spec->docs, key->svidx, docId);
+  return !isnan(*d);
+}
+
+// Fills the entry of `res`. Returns false if its sort value is not a plain number, in which
+// case the generic comparison must be used.
+static bool rpsortNumEntry(const RPSorter *self, const SearchResult *res, RPSortNumEntry *e) {
+  t_docId docId = SearchResult_GetDocId(res);
+  // Matching `cmpByFields`: ascending sorts the smaller value and doc id first
+  e->tie = self->num.ascending ? ~docId : docId;
+  double d;
+  if (rpsortNumColumnValue(self, SearchResult_GetRowData(res), docId, &d)) {
+    e->hasValue = true;
+    e->key = self->num.ascending ? -d : d;
+    return true;
+  }
+  const RSValue *v = RLookup_GetItem(self->fieldcmp.keys[0], SearchResult_GetRowData(res));
+  if (!v) {
+    e->hasValue = false;
+    e->key = 0;
+    return true;
+  }
+  v = RSValue_Dereference(v);
+  if (!RSValue_IsNumber(v)) {
+    return false;
+  }
+  d = RSValue_Number_Get(v);
+  if (isnan(d)) {
+    return false;
+  }
+  e->hasValue = true;
+  e->key = self->num.ascending ? -d : d;
+  return true;
+}
+
+static inline void numEntrySwap(RPSortNumEntry *entries, size_t i, size_t j) {
+  RPSortNumEntry tmp = entries[i];
+  entries[i] = entries[j];
+  entries[j] = tmp;
+}
+
+// Reorders `entries` so that its first `k` entries are the best ones, the k-th best last
+static void numEntriesSelect(RPSortNumEntry *entries, size_t n, size_t k) {
+  size_t lo = 0, hi = n - 1, target = k - 1;
+  while (lo < hi) {
+    // Use the median of three as the pivot, moving it to `hi`
+    size_t mid = lo + (hi - lo) / 2;
+    if (numEntryBetter(&entries[mid], &entries[lo])) numEntrySwap(entries, mid, lo);
+    if (numEntryBetter(&entries[hi], &entries[lo])) numEntrySwap(entries, hi, lo);
+    if (numEntryBetter(&entries[mid], &entries[hi])) numEntrySwap(entries, mid, hi);
+    const RPSortNumEntry pivot = entries[hi];
+
+    size_t store = lo;
+    for (size_t i = lo; i < hi; i++) {
+      if (numEntryBetter(&entries[i], &pivot)) {
+        numEntrySwap(entries, i, store++);
+      }
+    }
+    numEntrySwap(entries, store, hi);
+
+    if (store == target) {
+      return;
+    } else if (store < target) {
+      lo = store + 1;
+    } else {
+      hi = store - 1;
+    }
+  }
+}
+
+// Trims the accumulated entries to the best `pq->size` ones
+static void rpsortNumTrim(RPSorter *self) {
+  size_t k = self->pq->size;
+  size_t n = array_len(self->num.entries);
+  if (n <= k) {
+    return;
+  }
+  numEntriesSelect(self->num.entries, n, k);
+  for (size_t i = k; i < n; i++) {
+    srDtor(self->num.entries[i].res);
+  }
+  self->num.entries = array_trimm_len(self->num.entries, n - k);
+
+  // The worst of the kept entries is the bar new results have to pass
+  self->num.threshold = self->num.entries[k - 1];
+  self->num.hasThreshold = true;
+}
+
+static bool rpsortQueueHeap(RPSorter *self);
+
+// Moves the accumulated entries into the heap, and keeps using it from now on
+static void rpsortNumFallback(RPSorter *self) {
+  SearchResult *pooled = self->pooledResult;
+  for (size_t i = 0; i < array_len(self->num.entries); i++) {
+    self->pooledResult = self->num.entries[i].res;
+    rpsortQueueHeap(self);
+    // Whether the result was queued or dropped, we are left with an unneeded empty result
+    srDtor(self->pooledResult);
+  }
+  self->pooledResult = pooled;
+  array_free(self->num.entries);
+  self->num.entries = NULL;
+  self->num.active = false;
+}
+
+static bool rpsortQueueNumeric(RPSorter *self) {
+  RPSortNumEntry e;
+  if (!rpsortNumEntry(self, self->pooledResult, &e)) {
+    rpsortNumFallback(self);
+    return rpsortQueueHeap(self);
+  }
+
+  // Most results are rejected here, once we know how good a result has to be
+  if (self->num.hasThreshold && !numEntryBetter(&e, &self->num.threshold)) {
+    SearchResult_Clear(self->pooledResult);
+    return false;
+  }
+
+  SearchResult_SetIndexResult(self->pooledResult, NULL);
+  SearchResult_PinDocumentMetadata(self->pooledResult);
+  e.res = self->pooledResult;
+  array_ensure_append_1(self->num.entries, e);
+  self->pooledResult = SearchResult_New();
+
+  if (array_len(self->num.entries) >= 2 * self->pq->size) {
+    rpsortNumTrim(self);
+  }
+  return true;
+}
+
+static int rpsortNext_YieldNumeric(ResultProcessor *rp, SearchResult *r) {
   RPSorter *self = (RPSorter *)rp;
+  if (self->num.yieldIdx < array_len(self->num.entries)) {
+    SearchResult *cur_best = self->num.entries[self->num.yieldIdx++].res;
+    SearchResult_MoveFree(r, cur_best);
+    return RS_RESULT_OK;
+  }
+  int ret = self->timedOut ? RS_RESULT_TIMEDOUT : RS_RESULT_EOF;
+  self->timedOut = false;
+  return ret;
+}
 
-  // get the next result from upstream. `self->pooledResult` is expected to be empty and allocated.
-  int rc = rp->upstream->Next(rp->upstream, self->pooledResult);
+/*********************************************************************************/
+
+// Moves the sorter to yielding its accumulated results
+static int rpsortNext_StartYield(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+  if (self->num.active) {
+    // Select the best results and only sort them
+    rpsortNumTrim(self);
+    if (self->num.entries) {
+      qsort(self->num.entries, array_len(self->num.entries), sizeof(*self->num.entries), numEntryCmp);
+    }
+    rp->Next = rpsortNext_YieldNumeric;
+  } else {
+    rp->Next = rpsortNext_Yield;
+  }
+  return rp->Next(rp, r);
+}
+
+// Handles the return code that stopped the accumulation of upstream results
+static int rpsortNext_Done(ResultProcessor *rp, SearchResult *r, int rc) {
+  RPSorter *self = (RPSorter *)rp;
+
+  // All the kept results are pinned by now
+  if (self->borrowSctx) {
+    RedisSearchCtx_UnlockSpec(self->borrowSctx);
+  }
 
   // if our upstream has finished - just change the state to not accumulating, and yield
   if (rc == RS_RESULT_EOF) {
-    rp->Next = rpsortNext_Yield;
-    return rpsortNext_Yield(rp, r);
+    return rpsortNext_StartYield(rp, r);
   } else if (rc == RS_RESULT_TIMEDOUT && (rp->parent->timeoutPolicy == TimeoutPolicy_Return)) {
     self->timedOut = true;
-    rp->Next = rpsortNext_Yield;
-    return rpsortNext_Yield(rp, r);
-  } else if (rc != RS_RESULT_OK) {
-    // whoops!
-    return rc;
+    return rpsortNext_StartYield(rp, r);
+  }
+  // whoops!
+  return rc;
+}
+
+// Queues `self->pooledResult` if it makes it into the top results, and returns whether it did.
+// `self->pooledResult` is left empty and allocated for the next result.
+static inline bool rpsortQueue(RPSorter *self) {
+  if (self->num.active) {
+    return rpsortQueueNumeric(self);
+  } else {
+    return rpsortQueueHeap(self);
+  }
+}
+
+static bool rpsortQueueHeap(RPSorter *self) {
+  ResultProcessor *rp = &self->base;
+
+  if (self->hasScoreThreshold && SearchResult_GetScore(self->pooledResult) < self->scoreThreshold) {
+    SearchResult_Clear(self->pooledResult);
+    return false;
   }
 
   // If the queue is not full - we just push the result into it
@@ -433,12 +1011,14 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
 
     // copy the index result to make it thread safe - but only if it is pushed to the heap
     SearchResult_SetIndexResult(self->pooledResult, NULL);
+    SearchResult_PinDocumentMetadata(self->pooledResult);
     mmh_insert(self->pq, self->pooledResult);
     if (SearchResult_GetScore(self->pooledResult) < rp->parent->minScore) {
       rp->parent->minScore = SearchResult_GetScore(self->pooledResult);
     }
     // we need to allocate a new result for the next iteration
-    self->pooledResult = rm_calloc(1, sizeof(*self->pooledResult));
+    self->pooledResult = SearchResult_New();
+    return true;
   } else {
     // find the min result
     SearchResult *minh = mmh_peek_min(self->pq);
@@ -449,21 +1029,96 @@ static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
     }
 
     // if needed - pop it and insert a new result
-    if (self->cmp(self->pooledResult, minh, self->cmpCtx) > 0) {
+    bool queued = self->cmp(self->pooledResult, minh, self->cmpCtx) > 0;
+    if (queued) {
       SearchResult_SetIndexResult(self->pooledResult, NULL);
+      SearchResult_PinDocumentMetadata(self->pooledResult);
       self->pooledResult = mmh_exchange_min(self->pq, self->pooledResult);
     }
     // clear the result in preparation for the next iteration
     SearchResult_Clear(self->pooledResult);
+    return queued;
+  }
+}
+
+static int rpsortNext_innerLoop(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+
+  // get the next result from upstream. `self->pooledResult` is expected to be empty and allocated.
+  int rc = rp->upstream->Next(rp->upstream, self->pooledResult);
+  if (rc != RS_RESULT_OK) {
+    return rpsortNext_Done(rp, r, rc);
+  }
+  rs_wall_clock sortClock;
+  rs_wall_clock_init(&sortClock);
+  const bool queued = rpsortQueue(self);
+  rp->parent->sortTime += rs_wall_clock_elapsed_ns(&sortClock);
+  if (!queued && self->skipRun) {
+    // The bar only gets higher, and the rest of the run sorts after this result
+    self->skipRun(rp->upstream);
   }
   return RESULT_QUEUED;
 }
 
+static int rpsortNext_innerLoopBatch(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+  size_t len;
+
+  int rc = rp->upstream->NextBatch(rp->upstream, self->batch, RP_BATCH_SIZE, &len);
+  rs_wall_clock sortClock;
+  rs_wall_clock_init(&sortClock);
+  for (size_t i = 0; i < len; i++) {
+    // Move the result into the pooled one, leaving the empty pooled result in the batch
+    rpBatchSwapInto(self->pooledResult, &self->batch[i]);
+    rpsortQueue(self);
+  }
+  rp->parent->sortTime += rs_wall_clock_elapsed_ns(&sortClock);
+  if (rc != RS_RESULT_OK) {
+    return rpsortNext_Done(rp, r, rc);
+  }
+  return RESULT_QUEUED;
+}
+
+// Lets the results of the root borrow their metadata, if it is only separated from the sorter by
+// processors which handle each result while the spec is locked. Most of the results are dropped
+// by the sorter, which then never touches the ref count of their metadata, and the kept ones are
+// pinned before the sorter unlocks the spec.
+static void rpsortBorrowDmds(RPSorter *self) {
+  ResultProcessor *up = self->base.upstream;
+  while (up && (up->type == RP_SCORER || up->type == RP_METRICS || up->type == RP_PROFILE)) {
+    up = up->upstream;
+  }
+  if (!up || up->type != RP_INDEX) {
+    return;
+  }
+  RPQueryIterator *root = (RPQueryIterator *)up;
+  if (root->ranged || (root->sctx->spec && root->sctx->spec->diskSpec)) {
+    return;
+  }
+  root->borrowDmds = true;
+  self->borrowSctx = root->sctx;
+}
+
 static int rpsortNext_Accum(ResultProcessor *rp, SearchResult *r) {
+  RPSorter *self = (RPSorter *)rp;
+  if (!self->borrowSctx) {
+    rpsortBorrowDmds(self);
+  }
   uint32_t chunkLimit = rp->parent->resultLimit;
   rp->parent->resultLimit = UINT32_MAX; // we want to accumulate all results
+
+  // Read whole batches when the upstream can produce them. A batch may span runs, so they are not
+  // used when skipping runs.
+  int (*innerLoop)(ResultProcessor *, SearchResult *) = rpsortNext_innerLoop;
+  if (rp->upstream->NextBatch && !self->skipRun) {
+    if (!self->batch) {
+      self->batch = RP_NewBatch();
+    }
+    innerLoop = rpsortNext_innerLoopBatch;
+  }
+
   int rc;
-  while ((rc = rpsortNext_innerLoop(rp, r)) == RESULT_QUEUED) {
+  while ((rc = innerLoop(rp, r)) == RESULT_QUEUED) {
     // Do nothing.
   }
   rp->parent->resultLimit = chunkLimit; // restore the limit
@@ -519,10 +1174,7 @@ static int cmpByFields(const void *e1, const void *e2, const void *udata) {
 }
 
 static void srDtor(void *p) {
-  if (p) {
-    SearchResult_Destroy(p);
-    rm_free(p);
-  }
+  SearchResult_Free(p);
 }
 
 ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys, size_t nkeys, uint64_t ascmap) {
@@ -535,7 +1187,12 @@ ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys
   ret->fieldcmp.nkeys = nkeys;
 
   ret->pq = mmh_init_with_size(maxresults, ret->cmp, ret->cmpCtx, srDtor);
-  ret->pooledResult = rm_calloc(1, sizeof(*ret->pooledResult));
+  ret->pooledResult = SearchResult_New();
+  // Sorting by a single numeric field is common enough to skip the generic comparison
+  if (nkeys == 1 && (keys[0]->flags & RLOOKUP_T_NUMERIC)) {
+    ret->num.active = true;
+    ret->num.ascending = SORTASCMAP_GETASC(ascmap, 0);
+  }
   ret->base.Next = rpsortNext_Accum;
   ret->base.Free = rpsortFree;
   ret->base.type = RP_SORTER;
@@ -546,6 +1203,28 @@ ResultProcessor *RPSorter_NewByScore(size_t maxresults) {
   return RPSorter_NewByFields(maxresults, NULL, 0, 0);
 }
 
+void RPSorter_UseSortingColumns(ResultProcessor *rp, const RedisSearchCtx *sctx) {
+  RPSorter *self = (RPSorter *)rp;
+  if (self->num.active && (self->fieldcmp.keys[0]->flags & RLOOKUP_F_SVSRC) && sctx && sctx->spec) {
+    self->num.sctx = sctx;
+  }
+}
+
+void RPSorter_SetSortedRuns(ResultProcessor *rp, void (*skipRun)(ResultProcessor *upstream)) {
+  RPSorter *self = (RPSorter *)rp;
+  if (self->fieldcmp.nkeys) {
+    self->skipRun = skipRun;
+  }
+}
+
+void RPSorter_SetScoreThreshold(ResultProcessor *rp, double threshold) {
+  RPSorter *self = (RPSorter *)rp;
+  if (!self->fieldcmp.nkeys) {
+    self->hasScoreThreshold = true;
+    self->scoreThreshold = threshold;
+  }
+}
+
 /*******************************************************************************************************************
  *  Paging Processor
  *
@@ -623,6 +1302,211 @@ ResultProcessor *RPPager_New(size_t offset, size_t limit) {
   return &ret->base;
 }
 
+/*******************************************************************************************************************
+ *  Spilled Rows Result Processor
+ *
+ * Holds the rows of a processor which was drained into the binary rows encoding, and yields them
+ * in the same order. The encoding is only decoded once the rows are read, so that until then it
+ * costs nothing but its bytes
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  Buffer rows;
+  BinaryRowsReader reader;
+  RLookup *lk;
+  arrayof(uint32_t) expired;  // The rows which were flagged as expired, in order
+  uint32_t nextExpired;
+} RPSpilledRows;
+
+static int rpspilledNext_Read(ResultProcessor *base, SearchResult *r) {
+  RPSpilledRows *self = (RPSpilledRows *)base;
+  if (BinaryRowsReader_AtEnd(&self->reader)) {
+    return RS_RESULT_EOF;
+  }
+  uint32_t row = self->reader.curRow;
+  BinaryRowsReader_Next(&self->reader, SearchResult_GetRowDataMut(r));
+  if (self->nextExpired < array_len(self->expired) && self->expired[self->nextExpired] == row) {
+    SearchResult_SetFlags(r, SearchResult_GetFlags(r) | Result_ExpiredDoc);
+    self->nextExpired++;
+  }
+  return RS_RESULT_OK;
+}
+
+static int rpspilledNext_Init(ResultProcessor *base, SearchResult *r) {
+  RPSpilledRows *self = (RPSpilledRows *)base;
+  BinaryRowsReader_Init(&self->reader, self->rows.data, self->rows.offset, self->lk);
+  base->Next = rpspilledNext_Read;
+  return base->Next(base, r);
+}
+
+static void rpspilledFree(ResultProcessor *base) {
+  RPSpilledRows *self = (RPSpilledRows *)base;
+  BinaryRowsReader_Free(&self->reader);
+  Buffer_Free(&self->rows);
+  array_free(self->expired);
+  rm_free(self);
+}
+
+bool RP_HoldsAllResults(const ResultProcessor *rp) {
+  switch (rp->type) {
+    case RP_SORTER: {
+      // A sorter which timed out holds the results it accumulated until then
+      const RPSorter *self = (const RPSorter *)rp;
+      return (rp->Next == rpsortNext_Yield || rp->Next == rpsortNext_YieldNumeric) && !self->timedOut;
+    }
+    case RP_GROUP:
+      return Grouper_HoldsAllResults(rp);
+    default:
+      return false;
+  }
+}
+
+ResultProcessor *RPSpilledRows_New(ResultProcessor *src, RLookup *lk) {
+  RS_ASSERT(RP_HoldsAllResults(src));
+  RPSpilledRows *ret = rm_calloc(1, sizeof(*ret));
+  ret->lk = lk;
+
+  BinaryRowsWriter w;
+  BinaryRowsWriter_Init(&w, true);
+  SearchResult r = {0};
+  while (src->Next(src, &r) == RS_RESULT_OK) {
+    if (SearchResult_GetFlags(&r) & Result_ExpiredDoc) {
+      uint32_t row = BinaryRowsWriter_NumRows(&w);
+      array_ensure_append_1(ret->expired, row);
+    } else {
+      uint32_t pos = 0;
+      for (const RLookupKey *kk = lk->head; kk; kk = kk->next) {
+        if (!kk->name) {
+          continue;  // Overridden key
+        }
+        const RSValue *v = RLookup_GetItem(kk, SearchResult_GetRowData(&r));
+        if (v) {
+          BinaryRowsWriter_AddValue(&w, pos, kk, v);
+        }
+        pos++;
+      }
+    }
+    BinaryRowsWriter_EndRow(&w);
+    SearchResult_Clear(&r);
+  }
+  SearchResult_Destroy(&r);
+  BinaryRowsWriter_Finish(&w, &ret->rows);
+  BinaryRowsWriter_Free(&w);
+
+  ret->base.type = RP_SPILLED_ROWS;
+  ret->base.Next = rpspilledNext_Init;
+  ret->base.Free = rpspilledFree;
+  return &ret->base;
+}
+
+/*******************************************************************************************************************
+ *  Read Ahead Result Processor
+ *
+ * The last processor of a chain whose next results were read ahead, before the next chunk asked
+ * for them. It yields them first, and then whatever stopped the read ahead, before reading on
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  arrayof(SearchResult *) results;
+  uint32_t pos;
+  int rc;          // What stopped the read ahead, RS_RESULT_OK if it was stopped by the caller
+  QueryError err;  // The error of the read ahead, passed downstream with `rc`
+  // The warnings of the read ahead, passed downstream with the first result
+  bool oomWarning;
+  bool maxPrefixExpansionsWarning;
+} RPReadAhead;
+
+static int rpReadAheadNext(ResultProcessor *base, SearchResult *r) {
+  RPReadAhead *self = (RPReadAhead *)base;
+  if (self->oomWarning) {
+    QueryError_SetQueryOOMWarning(base->parent->err);
+    self->oomWarning = false;
+  }
+  if (self->maxPrefixExpansionsWarning) {
+    QueryError_SetReachedMaxPrefixExpansionsWarning(base->parent->err);
+    self->maxPrefixExpansionsWarning = false;
+  }
+  if (self->pos < array_len(self->results)) {
+    SearchResult_MoveFree(r, self->results[self->pos++]);
+    return RS_RESULT_OK;
+  }
+  array_clear(self->results);
+  self->pos = 0;
+  if (self->rc != RS_RESULT_OK) {
+    int rc = self->rc;
+    self->rc = RS_RESULT_OK;
+    if (QueryError_HasError(&self->err)) {
+      QueryError_CloneFrom(&self->err, base->parent->err);
+    }
+    QueryError_ClearError(&self->err);
+    return rc;
+  }
+  return base->upstream->Next(base->upstream, r);
+}
+
+static void rpReadAheadFree(ResultProcessor *base) {
+  RPReadAhead *self = (RPReadAhead *)base;
+  for (uint32_t i = self->pos; i < array_len(self->results); i++) {
+    SearchResult_Free(self->results[i]);
+  }
+  array_free(self->results);
+  QueryError_ClearError(&self->err);
+  rm_free(self);
+}
+
+// The memory a result read ahead takes
+static size_t readAheadResultBytes(const SearchResult *r) {
+  const RLookupRow *row = SearchResult_GetRowData(r);
+  size_t bytes = sizeof(*r);
+  for (uint32_t i = 0; i < array_len(row->dyn); i++) {
+    if (row->dyn[i]) {
+      bytes += sizeof(row->dyn[i]) + RSValue_MemoryUsage(row->dyn[i]);
+    }
+  }
+  return bytes;
+}
+
+size_t RPReadAhead_Fill(QueryProcessingCtx *qctx, size_t count, size_t maxBytes) {
+  RPReadAhead *self;
+  if (qctx->endProc && qctx->endProc->type == RP_READ_AHEAD) {
+    self = (RPReadAhead *)qctx->endProc;
+  } else {
+    self = rm_calloc(1, sizeof(*self));
+    self->err = QueryError_Default();
+    self->base.type = RP_READ_AHEAD;
+    self->base.Next = rpReadAheadNext;
+    self->base.Free = rpReadAheadFree;
+    QITR_PushRP(qctx, &self->base);
+  }
+
+  ResultProcessor *upstream = self->base.upstream;
+  qctx->resultLimit = count;
+  size_t bytes = 0;
+  while (self->rc == RS_RESULT_OK && array_len(self->results) - self->pos < count && bytes < maxBytes) {
+    SearchResult *r = SearchResult_New();
+    int rc = upstream->Next(upstream, r);
+    if (rc != RS_RESULT_OK) {
+      SearchResult_Free(r);
+      self->rc = rc;
+      break;
+    }
+    // The iterators moved on
+    SearchResult_SetIndexResult(r, NULL);
+    bytes += readAheadResultBytes(r);
+    array_ensure_append_1(self->results, r);
+  }
+
+  if (QueryError_HasError(qctx->err)) {
+    QueryError_CloneFrom(qctx->err, &self->err);
+  }
+  self->oomWarning |= QueryError_HasQueryOOMWarning(qctx->err);
+  self->maxPrefixExpansionsWarning |= QueryError_HasReachedMaxPrefixExpansionsWarning(qctx->err);
+  QueryError_ClearError(qctx->err);
+  return array_len(self->results) - self->pos;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 /// Value Loader                                                             ///
@@ -685,14 +1569,30 @@ static int rploaderNext(ResultProcessor *base, SearchResult *r) {
     return rc;
   }
 
+  rs_wall_clock loadClock;
+  rs_wall_clock_init(&loadClock);
   rpLoader_loadDocument(lc, r);
+  base->parent->loadTime += rs_wall_clock_elapsed_ns(&loadClock);
   return RS_RESULT_OK;
 }
 
+static int rploaderNextBatch(ResultProcessor *base, SearchResult *res, size_t cap, size_t *len) {
+  RPLoader *lc = (RPLoader *)base;
+  int rc = RP_NextBatch(base->upstream, res, cap, len);
+  rs_wall_clock loadClock;
+  rs_wall_clock_init(&loadClock);
+  for (size_t i = 0; i < *len; i++) {
+    rpLoader_loadDocument(lc, &res[i]);
+  }
+  base->parent->loadTime += rs_wall_clock_elapsed_ns(&loadClock);
+  return rc;
+}
+
 static void rploaderFreeInternal(ResultProcessor *base) {
   RPLoader *lc = (RPLoader *)base;
   QueryError_ClearError(&lc->status);
   rm_free(lc->loadopts.keys);
+  RSValueInterner_Free(lc->loadopts.interner);
 }
 
 static void rploaderFree(ResultProcessor *base) {
@@ -709,6 +1609,7 @@ static void rploaderNew_setLoadOpts(RPLoader *self, RedisSearchCtx *sctx, RLooku
   self->loadopts.keys = rm_malloc(sizeof(*keys) * nkeys);
   memcpy(self->loadopts.keys, keys, sizeof(*keys) * nkeys);
   self->loadopts.nkeys = nkeys;
+  self->loadopts.interner = RSValueInterner_New();
   if (nkeys) {
     self->loadopts.mode = RLOOKUP_LOAD_KEYLIST;
   } else {
@@ -725,6 +1626,7 @@ static ResultProcessor *RPPlainLoader_New(RedisSearchCtx *sctx, RLookup *lk, con
   rploaderNew_setLoadOpts(self, sctx, lk, keys, nkeys, forceLoad);
 
   self->base.Next = rploaderNext;
+  self->base.NextBatch = rploaderNextBatch;
   self->base.Free = rploaderFree;
   self->base.type = RP_LOADER;
   return &self->base;
@@ -764,6 +1666,12 @@ typedef struct RPSafeLoader {
   // Used when changing the MT mode through a cursor execution session (e.g. FT.CURSOR READ)
   bool becomePlainLoader;
 
+  // Key names of the buffered results, created before locking Redis (array_*)
+  RedisModuleString **keyNames;
+
+  // Number of buffers loaded, each under a single acquisition of the GIL
+  size_t numBatches;
+
   // Search context
   RedisSearchCtx *sctx;
 } RPSafeLoader;
@@ -855,19 +1763,55 @@ static int rpSafeLoader_ResetAndReturnLastCode(RPSafeLoader *self, SearchResult
 
 /*********************************************************************************/
 
+// Creates the key names of all the buffered documents. Called before locking Redis, so the
+// loading phase only has to open the keys and read their fields.
+static void rpSafeLoader_PrepareKeyNames(RPSafeLoader *self) {
+  array_clear(self->keyNames);
+  SearchResult *curr_res;
+  while ((curr_res = GetNextResult(self))) {
+    const RSDocumentMetadata *dmd = SearchResult_GetDocumentMetadata(curr_res);
+    RedisModuleString *keyName = dmd ? RedisModule_CreateString(NULL, dmd->keyPtr, sdslen(dmd->keyPtr)) : NULL;
+    array_ensure_append_1(self->keyNames, keyName);
+  }
+
+  // Reset the iterator
+  self->curr_result_index = 0;
+}
+
+// Frees the key names once Redis is unlocked. Keys opened by the loader are closed by
+// then, so we hold the only reference to each name.
+static void rpSafeLoader_FreeKeyNames(RPSafeLoader *self) {
+  array_foreach(self->keyNames, keyName, if (keyName) RedisModule_FreeString(NULL, keyName));
+  array_clear(self->keyNames);
+}
+
 static void rpSafeLoader_Load(RPSafeLoader *self) {
   SearchResult *curr_res;
+  RLookupLoadOptions *loadopts = &self->base_loader.loadopts;
 
   // iterate the buffer.
   // TODO: implement `GetNextResult` that gets the current block to save calculation time.
   while ((curr_res = GetNextResult(self))) {
+    loadopts->keyName = self->keyNames[self->curr_result_index - 1];
     rpLoader_loadDocument(&self->base_loader, curr_res);
   }
+  loadopts->keyName = NULL;
 
   // Reset the iterator
   self->curr_result_index = 0;
 }
 
+// Accumulates the GIL time of a single buffer into the processor's own GIL time
+static void rpSafeLoader_AddGILTime(RPSafeLoader *self, rs_wall_clock_ns_t ns) {
+  struct timespec *GILTime = &self->base_loader.base.GILTime;
+  GILTime->tv_sec += ns / NANOSEC_PER_SECOND;
+  GILTime->tv_nsec += ns % NANOSEC_PER_SECOND;
+  if (GILTime->tv_nsec >= NANOSEC_PER_SECOND) {
+    GILTime->tv_sec++;
+    GILTime->tv_nsec -= NANOSEC_PER_SECOND;
+  }
+}
+
 static int rpSafeLoaderNext_Yield(ResultProcessor *rp, SearchResult *result_output) {
   RPSafeLoader *self = (RPSafeLoader *)rp;
   SearchResult *curr_res = GetNextResult(self);
@@ -919,11 +1863,20 @@ static int rpSafeLoaderNext_Accumulate(ResultProcessor *rp, SearchResult *res) {
   // First, we verify that we unlocked the spec before we lock Redis.
   RedisSearchCtx_UnlockSpec(sctx);
 
+  // The wait for the lock is part of the load time
+  rs_wall_clock loadClock;
+  rs_wall_clock_init(&loadClock);
+  // Create the key names of the whole buffer before we lock Redis
+  rpSafeLoader_PrepareKeyNames(self);
+
   bool isQueryProfile = rp->parent->isProfile;
   rs_wall_clock rpStartTime;
   if (isQueryProfile) rs_wall_clock_init(&rpStartTime);
   // Then, lock Redis to guarantee safe access to Redis keyspace
+  rs_wall_clock lockClock;
+  rs_wall_clock_init(&lockClock);
   RedisModule_ThreadSafeContextLock(sctx->redisCtx);
+  rp->parent->lockWaitTime += rs_wall_clock_elapsed_ns(&lockClock);
 
   rpSafeLoader_Load(self);
 
@@ -932,8 +1885,14 @@ static int rpSafeLoaderNext_Accumulate(ResultProcessor *rp, SearchResult *res) {
 
   if (isQueryProfile) {
     // GIL time is time passed since rpStartTime combined with the time we already accumulated in the rp->GILTime
-    rp->parent->GILTime += rs_wall_clock_elapsed_ns(&rpStartTime);
+    rs_wall_clock_ns_t batchGILTime = rs_wall_clock_elapsed_ns(&rpStartTime);
+    rp->parent->GILTime += batchGILTime;
+    rpSafeLoader_AddGILTime(self, batchGILTime);
   }
+  rp->parent->loadTime += rs_wall_clock_elapsed_ns(&loadClock);
+  self->numBatches++;
+
+  rpSafeLoader_FreeKeyNames(self);
 
   // Move to the yielding phase
   rp->Next = rpSafeLoaderNext_Yield;
@@ -952,6 +1911,7 @@ static void rpSafeLoaderFree(ResultProcessor *base) {
   // Free buffer memory blocks
   array_foreach(sl->BufferBlocks, SearchResultsBlock, array_free(SearchResultsBlock));
   array_free(sl->BufferBlocks);
+  array_free(sl->keyNames);
 
   rploaderFreeInternal(base);
 
@@ -1041,15 +2001,24 @@ static ResultProcessor *RPSafeLoader_New_FromPlainLoader(RPLoader *loader) {
   sl->BufferBlocks = NULL;
   sl->buffer_results_count = 0;
   sl->curr_result_index = 0;
+  sl->keyNames = NULL;
+  sl->numBatches = 0;
 
   sl->last_buffered_rc = RS_RESULT_OK;
 
+  // The safe loader buffers its results under the GIL, so it is read one result at a time
   sl->base_loader.base.Next = rpSafeLoaderNext_Accumulate;
+  sl->base_loader.base.NextBatch = NULL;
   sl->base_loader.base.Free = rpSafeLoaderFree;
   sl->base_loader.base.type = RP_SAFE_LOADER;
   return &sl->base_loader.base;
 }
 
+size_t RPSafeLoader_GetNumBatches(const ResultProcessor *rp) {
+  RS_ASSERT(rp->type == RP_SAFE_LOADER);
+  return ((const RPSafeLoader *)rp)->numBatches;
+}
+
 void SetLoadersForBG(QueryProcessingCtx *qctx) {
   ResultProcessor *cur = qctx->endProc;
   ResultProcessor dummyHead = { .upstream = cur };
@@ -1097,7 +2066,8 @@ static char *RPTypeLookup[RP_MAX] = {"Index",   "Loader",    "Threadsafe-Loader"
                                      "Sorter",  "Counter",   "Pager/Limiter",     "Highlighter",
                                      "Grouper", "Projector", "Filter",            "Profile",
                                      "Network", "Metrics Applier", "Key Name Loader", "Score Max Normalizer",
-                                     "Vector Normalizer", "Hybrid Merger", "Depleter"};
+                                     "Vector Normalizer", "Hybrid Merger", "Depleter", "Index Ranges", "Result Cache",
+                                     "Spilled Rows", "Read Ahead"};
 
 const char *RPTypeToString(ResultProcessorType type) {
   RS_LOG_ASSERT(type >= 0 && type < RP_MAX, "enum is out of range");
@@ -1123,6 +2093,7 @@ typedef struct {
   ResultProcessor base;
   rs_wall_clock_ns_t profileTime;
   uint64_t profileCount;
+  PerfCounters hw;
 } RPProfile;
 
 static int rpprofileNext(ResultProcessor *base, SearchResult *r) {
@@ -1136,6 +2107,18 @@ static int rpprofileNext(ResultProcessor *base, SearchResult *r) {
   return rc;
 }
 
+// Reading the counters is kept out of the time of the processor
+static int rpprofileNext_HW(ResultProcessor *base, SearchResult *r) {
+  RPProfile *self = (RPProfile *)base;
+  PerfCounters begin, end;
+  const bool counted = PerfCounters_Read(&begin);
+  int rc = rpprofileNext(base, r);
+  if (counted && PerfCounters_Read(&end)) {
+    PerfCounters_AddDiff(&self->hw, &begin, &end);
+  }
+  return rc;
+}
+
 static void rpProfileFree(ResultProcessor *base) {
   RPProfile *rp = (RPProfile *)base;
   rm_free(rp);
@@ -1147,7 +2130,7 @@ ResultProcessor *RPProfile_New(ResultProcessor *rp, QueryProcessingCtx *qctx) {
   rpp->profileCount = 0;
   rpp->base.upstream = rp;
   rpp->base.parent = qctx;
-  rpp->base.Next = rpprofileNext;
+  rpp->base.Next = RSGlobalConfig.profileHWCounters ? rpprofileNext_HW : rpprofileNext;
   rpp->base.Free = rpProfileFree;
   rpp->base.type = RP_PROFILE;
 
@@ -1164,6 +2147,11 @@ uint64_t RPProfile_GetCount(ResultProcessor *rp) {
   return self->profileCount;
 }
 
+const PerfCounters *RPProfile_GetHWCounters(ResultProcessor *rp) {
+  RPProfile *self = (RPProfile *)rp;
+  return &self->hw;
+}
+
 void RPProfile_IncrementCount(ResultProcessor *rp) {
   RPProfile *self = (RPProfile *)rp;
   self->profileCount++;
@@ -1219,8 +2207,7 @@ void Profile_AddRPs(QueryProcessingCtx *qctx) {
     return ret;
    }
   SearchResult *poppedResult = array_pop(self->pool);
-  SearchResult_Override(r, poppedResult);
-  rm_free(poppedResult);
+  SearchResult_MoveFree(r, poppedResult);
   double oldScore = SearchResult_GetScore(r);
   if (self->maxValue != 0) {
     SearchResult_SetScore(r, SearchResult_GetScore(r) / self->maxValue);
@@ -1256,7 +2243,7 @@ static int RPMaxScoreNormalizerNext_innerLoop(ResultProcessor *rp, SearchResult
   array_ensure_append_1(self->pool, self->pooledResult);
 
   // we need to allocate a new result for the next iteration
-  self->pooledResult = rm_calloc(1, sizeof(*self->pooledResult));
+  self->pooledResult = SearchResult_New();
   return RESULT_QUEUED;
 }
 
@@ -1431,17 +2418,20 @@ static void RPDepleter_Deplete(void *arg) {
   if (sync->take_index_lock) {
     // Lock the index for read
     RedisSearchCtx_LockSpecRead(self->depletingThreadCtx);
-    // Increment the counter
+    // Increment the counter, and wake up the pipeline thread waiting for all the depleters to lock
+    pthread_mutex_lock(&sync->mutex);
     atomic_fetch_add(&sync->num_locked, 1);
+    pthread_cond_broadcast(&sync->cond);
+    pthread_mutex_unlock(&sync->mutex);
   }
 
   // Deplete the pipeline into the `self->results` array.
-  SearchResult *r = rm_calloc(1, sizeof(*r));
+  SearchResult *r = SearchResult_New();
   while ((rc = self->base.upstream->Next(self->base.upstream, r)) == RS_RESULT_OK) {
     array_append(self->results, r);
-    r = rm_calloc(1, sizeof(*r));
+    r = SearchResult_New();
   }
-  rm_free(r);
+  SearchResult_Free(r);
   // Save the last return code from the upstream.
   self->last_rc = rc;
 
@@ -1473,8 +2463,7 @@ static int RPDepleter_Next_Yield(ResultProcessor *base, SearchResult *r) {
   }
   // Return the next result in the array.
   SearchResult *current = self->results[self->cur_idx];
-  SearchResult_Override(r, current);    // Copy result data to output
-  rm_free(current);
+  SearchResult_MoveFree(r, current);    // Move result data to output
   self->results[self->cur_idx] = NULL;
   self->cur_idx++;
   return RS_RESULT_OK;
@@ -1485,6 +2474,33 @@ static inline void RPDepleter_StartDepletionThread(RPDepleter *self) {
     redisearch_thpool_add_work(depleterPool, RPDepleter_Deplete, self, THPOOL_PRIORITY_HIGH);
 }
 
+void RPDepleter_StartAll(ResultProcessor **rps, size_t n) {
+  arrayof(redisearch_thpool_work_t) jobs = array_new(redisearch_thpool_work_t, n);
+  for (size_t i = 0; i < n; i++) {
+    RPDepleter *depleter = (RPDepleter *)rps[i];
+    if (rps[i]->type != RP_DEPLETER || !depleter->first_call) {
+      continue;
+    }
+    depleter->first_call = false;
+    redisearch_thpool_work_t job = {.function_p = RPDepleter_Deplete, .arg_p = depleter};
+    array_append(jobs, job);
+  }
+  redisearch_thpool_add_n_work(depleterPool, jobs, array_len(jobs), THPOOL_PRIORITY_HIGH);
+  array_free(jobs);
+}
+
+// Sleep until a depleter locked the index (or is done), rather than polling for all of them to lock it
+static inline void RPDepleter_WaitForLock(DepleterSync *sync) {
+  pthread_mutex_lock(&sync->mutex);
+  if (atomic_load(&sync->num_locked) < sync->num_depleters) {
+    rs_wall_clock start;
+    rs_wall_clock_init(&start);
+    pthread_cond_wait(&sync->cond, &sync->mutex);
+    LatencyStats_CountWait(LATENCY_WAIT_DEPLETER_SYNC, rs_wall_clock_elapsed_ns(&start));
+  }
+  pthread_mutex_unlock(&sync->mutex);
+}
+
 // Can only succeed once, if called after RE_RESULT_OK was returned an error will be returned
 // Waits for all the depletion threads to take a read lock
 // After all of them took a lock it will release its own read lock which was previously obtained in the main query thread
@@ -1519,7 +2535,10 @@ static inline int RPDepleter_WaitForDepletionToComplete(RPDepleter *self, Deplet
   }
 
   // Wait on condition variable for any depleter to signal completion
+  rs_wall_clock start;
+  rs_wall_clock_init(&start);
   pthread_cond_wait(&sync->cond, &sync->mutex);
+  LatencyStats_CountWait(LATENCY_WAIT_DEPLETER_SYNC, rs_wall_clock_elapsed_ns(&start));
 
   // Check if our specific thread is done after being woken up
   if (self->done_depleting == true) {
@@ -1556,6 +2575,7 @@ static int RPDepleter_Next_Dispatch(ResultProcessor *base, SearchResult *r) {
 
   DepleterSync *sync = (DepleterSync *)StrongRef_Get(self->sync_ref);
   if (RPDepleter_WaitForDepletionToStart(sync, self->nextThreadCtx) == RS_RESULT_DEPLETING) {
+    RPDepleter_WaitForLock(sync);
     return RS_RESULT_DEPLETING;
   }
 
@@ -1631,15 +2651,11 @@ int RPDepleter_DepleteAll(arrayof(ResultProcessor*) depleters) {
 
   const size_t count = array_len(depleters);
   // Start all depleting threads
-  for (size_t i = 0; i < count; i++) {
-    RPDepleter* depleter = (RPDepleter*)depleters[i];
-    depleter->first_call = false;
-    RPDepleter_StartDepletionThread(depleter);
-  }
+  RPDepleter_StartAll(depleters, count);
 
-  // Wait for depleting to start with configurable interval and timeout
+  // Wait for depleting to start
   while (RPDepleter_WaitForDepletionToStart(sync, searchCtx) == RS_RESULT_DEPLETING) {
-    usleep(1000);
+    RPDepleter_WaitForLock(sync);
   }
 
   for (size_t numDone = 0; numDone < count; ) {
@@ -1665,18 +2681,128 @@ int RPDepleter_DepleteAll(arrayof(ResultProcessor*) depleters) {
   return RS_RESULT_OK;;
 }
 
+/*******************************************************************************************************************
+ *  Query Ranges Processor
+ *
+ *  Reads the root iterators of a query in parallel. Every root is a clone of the same iterator tree,
+ *  read by its own RPQueryIterator over a distinct range of document ids, and depleted by an RPDepleter
+ *  on the depleters thread-pool. The depleters do not take the index lock: the pipeline thread holds
+ *  it for read while they run. The results are then yielded range after range, so they come in the
+ *  order of their ids, as if a single RPQueryIterator read them.
+ *******************************************************************************************************************/
+typedef struct {
+  ResultProcessor base;
+  RedisSearchCtx *sctx;
+  arrayof(ResultProcessor *) depleters;  // the depleter of each range, in the order of the ranges
+  QueryProcessingCtx *rangeCtxs;         // the parents of the range processors, counting their results
+  size_t curRange;                       // index of the range to yield results from
+  bool depleted;
+} RPQueryRanges;
+
+static void rpQueryRangesFree(ResultProcessor *base) {
+  RPQueryRanges *self = (RPQueryRanges *)base;
+  for (size_t i = 0; i < array_len(self->depleters); i++) {
+    ResultProcessor *depleter = self->depleters[i];
+    depleter->upstream->Free(depleter->upstream);
+    depleter->Free(depleter);
+  }
+  array_free(self->depleters);
+  rm_free(self->rangeCtxs);
+  rm_free(self);
+}
+
+static int rpQueryRangesDeplete(RPQueryRanges *self) {
+  RedisSearchCtx *sctx = self->sctx;
+  if (sctx->flags == RS_CTX_UNSET) {
+    // Lock the spec for all the ranges, and validate their iterators (none of them was read yet)
+    RedisSearchCtx_LockSpecRead(sctx);
+    for (size_t i = 0; i < array_len(self->depleters); i++) {
+      RPQueryIterator *range = (RPQueryIterator *)self->depleters[i]->upstream;
+      if (range->iterator->Revalidate(range->iterator) == VALIDATE_ABORTED) {
+        range->iterator->Free(range->iterator);
+        range->iterator = NewEmptyIterator();
+        range->batched = false;
+      }
+    }
+  }
+  int rc = RPDepleter_DepleteAll(self->depleters);
+  self->depleted = true;
+  for (size_t i = 0; i < array_len(self->depleters); i++) {
+    self->base.parent->totalResults += self->rangeCtxs[i].totalResults;
+  }
+  return rc;
+}
+
+static int rpQueryRangesNext(ResultProcessor *base, SearchResult *res) {
+  RPQueryRanges *self = (RPQueryRanges *)base;
+  if (!self->depleted) {
+    int rc = rpQueryRangesDeplete(self);
+    if (rc != RS_RESULT_OK) {
+      return UnlockSpec_and_ReturnRPResult(self->sctx, rc);
+    }
+  }
+  while (self->curRange < array_len(self->depleters)) {
+    ResultProcessor *depleter = self->depleters[self->curRange];
+    int rc = depleter->Next(depleter, res);
+    if (rc == RS_RESULT_OK) {
+      // The index result of the root has moved on since the result was read
+      SearchResult_SetIndexResult(res, NULL);
+      return RS_RESULT_OK;
+    }
+    if (rc != RS_RESULT_EOF) {
+      // The range timed out, so the next ranges are incomplete
+      self->curRange = array_len(self->depleters);
+      return UnlockSpec_and_ReturnRPResult(self->sctx, rc);
+    }
+    self->curRange++;
+  }
+  return UnlockSpec_and_ReturnRPResult(self->sctx, RS_RESULT_EOF);
+}
+
+ResultProcessor *RPQueryRanges_New(QueryIterator **roots, size_t numRanges, RedisSearchCtx *sctx) {
+  RS_ASSERT(numRanges > 1);
+  RPQueryRanges *ret = rm_calloc(1, sizeof(*ret));
+  ret->sctx = sctx;
+  ret->depleters = array_new(ResultProcessor *, numRanges);
+  ret->rangeCtxs = rm_calloc(numRanges, sizeof(*ret->rangeCtxs));
+
+  // Split the ids assigned so far into ranges of equal width. The last range is unbounded
+  const t_docId width = sctx->spec->docs.maxDocId / numRanges + 1;
+  StrongRef sync_ref = DepleterSync_New(numRanges, false);
+  for (size_t i = 0; i < numRanges; i++) {
+    RPQueryIterator *range = (RPQueryIterator *)RPQueryIterator_New(roots[i], NULL, sctx);
+    range->ranged = true;
+    range->rangeStart = i ? 1 + i * width : 0;
+    range->rangeEnd = i + 1 < numRanges ? 1 + (i + 1) * width : DOCID_MAX;
+    range->base.parent = &ret->rangeCtxs[i];
+
+    ResultProcessor *depleter = RPDepleter_New(StrongRef_Clone(sync_ref), sctx, sctx);
+    depleter->parent = &ret->rangeCtxs[i];
+    depleter->upstream = &range->base;
+    array_append(ret->depleters, depleter);
+  }
+  StrongRef_Release(sync_ref);
+
+  ret->base.Next = rpQueryRangesNext;
+  ret->base.Free = rpQueryRangesFree;
+  ret->base.type = RP_INDEX_RANGES;
+  return &ret->base;
+}
+
 // Wrapper for HybridSearchResult destructor to match dictionary value destructor signature
 static void hybridSearchResultValueDestructor(void *privdata, void *obj) {
   HybridSearchResult_Free((HybridSearchResult*)obj);
 }
 
-// Dictionary type for keyPtr -> HybridSearchResult mapping
+// Dictionary type for keyPtr -> HybridSearchResult mapping. The keys are not copied, as they point
+// into the first result stored for their document, which stays in the dictionary until the keys
+// are no longer looked up (once the results are accumulated)
 dictType dictTypeHybridSearchResult = {
   .hashFunction = stringsHashFunction,
-  .keyDup = stringsKeyDup,
+  .keyDup = NULL,
   .valDup = NULL,
   .keyCompare = stringsKeyCompare,
-  .keyDestructor = stringsKeyDestructor,
+  .keyDestructor = NULL,
   .valDestructor = hybridSearchResultValueDestructor,
 };
 
@@ -1766,7 +2892,7 @@ static inline bool RPHybridMerger_Error(const RPHybridMerger *self) {
  static int hybridMergerConsumeFromUpstream(RPHybridMerger *self, size_t maxResults, size_t upstreamIndex) {
    size_t consumed = 0;
    int rc = RS_RESULT_OK;
-   SearchResult *r = rm_calloc(1, sizeof(*r));
+   SearchResult *r = SearchResult_New();
    ResultProcessor *upstream = self->upstreams[upstreamIndex];
    while (consumed < maxResults && (rc = upstream->Next(upstream, r)) == RS_RESULT_OK) {
        double score = SearchResult_GetScore(r);
@@ -1775,13 +2901,13 @@ static inline bool RPHybridMerger_Error(const RPHybridMerger *self) {
          score = consumed;
        }
        if (hybridMergerStoreUpstreamResult(self, r, upstreamIndex, score)) {
-         r = rm_calloc(1, sizeof(*r));
+         r = SearchResult_New();
        } else {
          SearchResult_Clear(r);
          --consumed; // avoid wrong rank in RRF
        }
    }
-   rm_free(r);
+   SearchResult_Free(r);
    return rc;
  }
 
@@ -1809,8 +2935,7 @@ static int RPHybridMerger_Yield(ResultProcessor *rp, SearchResult *r) {
   }
 
   // Override the output result with merged data
-  SearchResult_Override(r, mergedResult);
-  rm_free(mergedResult);
+  SearchResult_MoveFree(r, mergedResult);
 
   // Add score as field if scoreKey is provided
   if (self->scoreKey) {
@@ -1831,6 +2956,9 @@ static int RPHybridMerger_Yield(ResultProcessor *rp, SearchResult *r) {
     window = self->hybridScoringCtx->linearCtx.window;
   }
 
+  // Run the subqueries at the same time, rather than each when it is first read
+  RPDepleter_StartAll(self->upstreams, self->numUpstreams);
+
   bool *consumed = rm_calloc(self->numUpstreams, sizeof(bool));
   size_t numConsumed = 0;
   // Continuously try to consume from upstreams until all are consumed
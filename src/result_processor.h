@@ -21,6 +21,7 @@
 #include "score_explain.h"
 #include "rs_wall_clock.h"
 #include "util/references.h"
+#include "util/perf_counters.h"
 #include "hybrid/hybrid_scoring.h"
 #include "hybrid/hybrid_lookup_context.h"
 #include "vector_normalization.h"
@@ -71,6 +72,10 @@ typedef enum {
   RP_VECTOR_NORMALIZER,
   RP_HYBRID_MERGER,
   RP_DEPLETER,
+  RP_INDEX_RANGES,
+  RP_RESULT_CACHE,
+  RP_SPILLED_ROWS,
+  RP_READ_AHEAD,
   RP_MAX, // Marks the last non-debug RP type
   // Debug only result processors
   RP_TIMEOUT,
@@ -93,6 +98,17 @@ typedef struct QueryProcessingCtx {
   rs_wall_clock initTime; //used with clock_gettime(CLOCK_MONOTONIC, ...)
   rs_wall_clock_ns_t GILTime;  //Time accumulated in nanoseconds
 
+  // The start of the current chunk
+  rs_wall_clock chunkClock;
+  // Time accumulated in nanoseconds by the loaders, the sorter and the reply, since the start of the
+  // current chunk (see `LatencyStats_CountStage`)
+  rs_wall_clock_ns_t loadTime;
+  rs_wall_clock_ns_t sortTime;
+  rs_wall_clock_ns_t replyTime;
+  // Time accumulated in nanoseconds waiting for the lock of the spec or for the GIL, since the end of
+  // the previous chunk. Reported by the slow log
+  rs_wall_clock_ns_t lockWaitTime;
+
   // the minimal score applicable for a result. It can be used to optimize the
   // scorers
   double minScore;
@@ -116,6 +132,10 @@ typedef struct QueryProcessingCtx {
 
   bool isProfile;
   RSTimeoutPolicy timeoutPolicy;
+
+  // Stops the query early when set, e.g. when its client disconnected. It is also set in the
+  // `SearchTime` of the query, through which the iterators check it with their timeout
+  const QueryCancelToken *cancel;
 } QueryProcessingCtx;
 
 QueryIterator *QITR_GetRootFilter(QueryProcessingCtx *it);
@@ -174,10 +194,53 @@ typedef struct ResultProcessor {
 
   /** Frees the processor and any internal data related to it. */
   void (*Free)(struct ResultProcessor *self);
+
+  /**
+   * Optional. Populates up to `cap` results of the array `res`, setting `*len`
+   * to the number of populated results. As with Next(), the existing data of
+   * the results is not read, and the populated ones must eventually be freed.
+   *
+   * Returns RS_RESULT_OK if more results may follow, otherwise the code that
+   * ended the stream - in which case the first `*len` results are still valid
+   * and must be consumed before handling it.
+   *
+   * Processors that don't implement it are read through RP_NextBatch(), one
+   * result at a time.
+   */
+  int (*NextBatch)(struct ResultProcessor *self, SearchResult *res, size_t cap, size_t *len);
 } ResultProcessor;
 
+// The number of results exchanged at once by processors that read in batches
+#define RP_BATCH_SIZE 256
+
+/**
+ * Reads a batch of up to `cap` results from `rp` into `res`, see
+ * ResultProcessor::NextBatch. Processors without a NextBatch implementation
+ * are read by calling their Next() until the batch is full or it fails.
+ */
+int RP_NextBatch(ResultProcessor *rp, SearchResult *res, size_t cap, size_t *len);
+
+/** Allocates an empty batch of RP_BATCH_SIZE results, freed with RP_FreeBatch() */
+SearchResult *RP_NewBatch(void);
+void RP_FreeBatch(SearchResult *batch);
+
+/**
+ * Swaps two results of a batch, so that each slot keeps owning its own
+ * allocations. Used to compact the kept results of a batch to its front.
+ */
+void RP_BatchSwap(SearchResult *res, size_t i, size_t j);
+
 ResultProcessor *RPQueryIterator_New(QueryIterator *itr, const SharedSlotRangeArray *slotRanges, RedisSearchCtx *sctx);
 
+/**
+ * Reads all the remaining results of the root processor `rp` (of type RP_INDEX), for a processor
+ * directly downstream which only needs their number. They are counted into the total results of
+ * the query as if they were yielded, without borrowing their metadata when the doc table has
+ * neither removed documents nor expirations, and straight from the number of documents of a single
+ * inverted index. Sets `count` to the number of results, and returns the status of the last read.
+ */
+int RPQueryIterator_Count(ResultProcessor *rp, size_t *count);
+
 ResultProcessor *RPScorer_New(const ExtScoringFunctionCtx *funcs,
                               const ScoringFunctionArgs *fnargs,
                               const RLookupKey *rlk);
@@ -201,8 +264,64 @@ ResultProcessor *RPSorter_NewByFields(size_t maxresults, const RLookupKey **keys
 
 ResultProcessor *RPSorter_NewByScore(size_t maxresults);
 
+/**
+ * Lets a sorter by a single sortable numeric key read the sort values from the sorting columns of
+ * the index of `sctx` while it is locked, instead of from the sorting vectors of the results.
+ */
+void RPSorter_UseSortingColumns(ResultProcessor *rp, const RedisSearchCtx *sctx);
+
+/**
+ * Tells a sorter by fields that its upstream yields runs of results which are already sorted by
+ * the same keys, such as the rows of the replies of the shards. Once the sorter is full and a
+ * result of a run does not make it into the top results, neither does the rest of the run, which
+ * `skipRun(upstream)` is called to drop.
+ */
+void RPSorter_SetSortedRuns(ResultProcessor *rp, void (*skipRun)(ResultProcessor *upstream));
+
+/**
+ * Tells a sorter by score that the results scoring below `threshold` can't make it into the top
+ * results, so that it drops them instead of queueing them until its heap is full.
+ */
+void RPSorter_SetScoreThreshold(ResultProcessor *rp, double threshold);
+
 ResultProcessor *RPPager_New(size_t offset, size_t limit);
 
+/*******************************************************************************************************************
+ *  Spilled Rows Processor
+ *
+ * Takes the place of a processor which holds all of its remaining results, keeping only their
+ * fields in the compact encoding of binary_rows.h. A paused cursor uses it to release the
+ * processors and the iterators below, which are done anyway.
+ *******************************************************************************************************************/
+
+/**
+ * Whether the processor has read all of its upstream, and only yields the results it holds: a
+ * sorter or a group-by which started yielding
+ */
+bool RP_HoldsAllResults(const ResultProcessor *rp);
+
+/**
+ * Drains `src`, for which RP_HoldsAllResults() holds, into a new processor which yields the same
+ * rows. The named keys of `lk` are kept, and written back to the keys of the same names. The
+ * caller still owns `src`, which yields nothing anymore
+ */
+ResultProcessor *RPSpilledRows_New(ResultProcessor *src, RLookup *lk);
+
+/*******************************************************************************************************************
+ *  Read Ahead Processor
+ *
+ * The last processor of a chain whose next results were read before the next chunk asks for them,
+ * e.g. by a worker between two reads of a cursor. It yields them before reading on.
+ *******************************************************************************************************************/
+
+/**
+ * Read up to `count` results of the chain ahead, until they take `maxBytes`, into the read ahead
+ * processor at its end, which is pushed there first if needed. The error and the warnings of the
+ * read are moved from `qctx->err` to the processor, which passes them downstream with the results.
+ * Returns the number of results the processor holds
+ */
+size_t RPReadAhead_Fill(QueryProcessingCtx *qctx, size_t count, size_t maxBytes);
+
 /*******************************************************************************************************************
  *  Loading Processor
  *
@@ -223,9 +342,16 @@ ResultProcessor *RPLoader_New(RedisSearchCtx *sctx, uint32_t reqflags, RLookup *
 void SetLoadersForBG(QueryProcessingCtx *qctx);
 void SetLoadersForMainThread(QueryProcessingCtx *qctx);
 
-/** Creates a new Highlight processor */
+/** Returns the number of buffers a safe loader has loaded, each under a single lock of Redis */
+size_t RPSafeLoader_GetNumBatches(const ResultProcessor *rp);
+
+struct SnippetCache;
+/**
+ * Creates a new Highlight processor. The fields it highlights and summarizes are cached in
+ * `snippets` when _SNIPPET_CACHE_BYTES is set, if it is not NULL
+ */
 ResultProcessor *RPHighlighter_New(RSLanguage language, const FieldList *fields,
-                                   const RLookup *lookup);
+                                   const RLookup *lookup, struct SnippetCache *snippets);
 
 /*******************************************************************************************************************
  *  Profiling Processor
@@ -237,6 +363,8 @@ ResultProcessor *RPProfile_New(ResultProcessor *rp, QueryProcessingCtx *qctx);
 
 rs_wall_clock_ns_t RPProfile_GetClock(ResultProcessor *rp);
 uint64_t RPProfile_GetCount(ResultProcessor *rp);
+// The hardware counters of the processors up to `rp`, if _PROFILE_HW_COUNTERS was set
+const PerfCounters *RPProfile_GetHWCounters(ResultProcessor *rp);
 void RPProfile_IncrementCount(ResultProcessor *rp);
 
 void Profile_AddRPs(QueryProcessingCtx *qctx);
@@ -288,6 +416,15 @@ ResultProcessor *RPDepleter_New(StrongRef sync_ref, RedisSearchCtx *depletingThr
 */
 int RPDepleter_DepleteAll(arrayof(ResultProcessor*) depleters);
 
+/**
+* Queues the depletion jobs of all the depleters among the processors at once, so that their
+* pipelines are run at the same time by the threads of the pool. Processors which are not
+* depleters, or whose depletion already started, are skipped.
+* @param rps Array of processors
+* @param n Number of processors in the array
+*/
+void RPDepleter_StartAll(ResultProcessor **rps, size_t n);
+
 /**
 * Creates a new shared synchronization object for coordinating multiple RPDepleter processors.
 * This is used during pipeline construction to create sync objects that allow multiple
@@ -297,6 +434,24 @@ int RPDepleter_DepleteAll(arrayof(ResultProcessor*) depleters);
 */
 StrongRef DepleterSync_New(unsigned int num_depleters, bool take_index_lock);
 
+/*******************************************************************************
+* Query Ranges Result Processor
+*
+*  Reads the root iterators of a query in parallel, each over a distinct range of
+*  document ids, and yields their results in the order of the ids. The roots must be
+*  clones of the same iterator tree, and their results carry no index result (so no
+*  scoring or highlighting may follow). The spec is locked for read by the pipeline
+*  thread for the whole depletion of the ranges.
+*/
+
+/**
+* Constructs a new query ranges processor, taking ownership of the roots.
+* @param roots The root iterator of every range, in the order of the ranges
+* @param numRanges Number of ranges, at least 2
+* @param sctx Search context of the pipeline
+*/
+ResultProcessor *RPQueryRanges_New(QueryIterator **roots, size_t numRanges, RedisSearchCtx *sctx);
+
 /*******************************************************************************************************************
  *  Hybrid Merger Result Processor
  *
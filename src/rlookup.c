@@ -13,7 +13,46 @@
 #include <util/arr.h>
 #include "doc_types.h"
 #include "value.h"
+#include "value_intern.h"
 #include "util/arr.h"
+#include "util/fnv.h"
+
+#define RLOOKUP_INDEX_MIN_KEYS 16
+
+// The slot of the key named `name` in the index of the lookup, or the empty slot where it belongs
+static uint32_t RLookup_IndexSlot(const RLookup *lookup, const char *name, size_t name_len) {
+  const uint32_t mask = lookup->indexCap - 1;
+  uint32_t slot = rs_fnv_32a_buf(name, name_len, 0) & mask;
+  for (;; slot = (slot + 1) & mask) {
+    const RLookupKey *kk = lookup->index[slot];
+    if (!kk || (kk->name_len == name_len && !strncmp(kk->name, name, name_len))) {
+      return slot;
+    }
+  }
+}
+
+// Index a key, unless it is hidden or one with the same name comes first in the list
+static void RLookup_IndexKey(RLookup *lookup, RLookupKey *key) {
+  if (!key->name) {
+    return;
+  }
+  uint32_t slot = RLookup_IndexSlot(lookup, key->name, key->name_len);
+  if (!lookup->index[slot]) {
+    lookup->index[slot] = key;
+    lookup->indexLen++;
+  }
+}
+
+// (Re)build the index of the lookup, keeping it at most half full
+static void RLookup_BuildIndex(RLookup *lookup, uint32_t cap) {
+  rm_free(lookup->index);
+  lookup->index = rm_calloc(cap, sizeof(*lookup->index));
+  lookup->indexCap = cap;
+  lookup->indexLen = 0;
+  for (RLookupKey *kk = lookup->head; kk; kk = kk->next) {
+    RLookup_IndexKey(lookup, kk);
+  }
+}
 
 // Allocate a new RLookupKey and add it to the RLookup table.
 static RLookupKey *createNewKey(RLookup *lookup, const char *name, size_t name_len, uint32_t flags) {
@@ -36,6 +75,12 @@ static RLookupKey *createNewKey(RLookup *lookup, const char *name, size_t name_l
   // Increase the RLookup table row length. (all rows have the same length).
   ++(lookup->rowlen);
 
+  if (lookup->index && (lookup->indexLen + 1) * 2 <= lookup->indexCap) {
+    RLookup_IndexKey(lookup, ret);
+  } else if (lookup->index || lookup->rowlen >= RLOOKUP_INDEX_MIN_KEYS) {
+    RLookup_BuildIndex(lookup, lookup->index ? lookup->indexCap * 2 : RLOOKUP_INDEX_MIN_KEYS * 4);
+  }
+
   return ret;
 }
 
@@ -55,6 +100,9 @@ static RLookupKey *overrideKey(RLookup *lk, RLookupKey *old, uint32_t flags) {
   new->flags |= old->flags & RLOOKUP_F_NAMEALLOC;
 
   /* Make the old key inaccessible for new lookups */
+  if (lk->index) {
+    lk->index[RLookup_IndexSlot(lk, old->name, old->name_len)] = new;
+  }
   if (old->path == old->name) {
     // If the old key allocated the name and not the path, we take ownership of the allocation
     old->flags &= ~RLOOKUP_F_NAMEALLOC;
@@ -111,6 +159,9 @@ static void setKeyByFieldSpec(RLookupKey *key, const FieldSpec *fs) {
   if (FIELD_IS(fs, INDEXFLD_T_NUMERIC)) {
     key->flags |= RLOOKUP_T_NUMERIC;
   }
+  if (FIELD_IS(fs, INDEXFLD_T_TAG)) {
+    key->flags |= RLOOKUP_T_TAG;
+  }
 }
 
 // Gets a key from the schema if the field is sortable (so its data is available), unless an RP upstream
@@ -129,6 +180,9 @@ static RLookupKey *genKeyFromSpec(RLookup *lookup, const char *name, size_t name
 }
 
 static RLookupKey *RLookup_FindKey(RLookup *lookup, const char *name, size_t name_len) {
+  if (lookup->index) {
+    return lookup->index[RLookup_IndexSlot(lookup, name, name_len)];
+  }
   for (RLookupKey *kk = lookup->head; kk; kk = kk->next) {
     // match `name` to the name of the key
     if (kk->name_len == name_len && !strncmp(kk->name, name, name_len)) {
@@ -319,13 +373,16 @@ void RLookup_WriteKey(const RLookupKey *key, RLookupRow *row, RSValue *v) {
   RLookup_WriteOwnKey(key, row, RSValue_IncrRef(v));
 }
 
-void RLookup_WriteKeyByName(RLookup *lookup, const char *name, size_t len, RLookupRow *dst, RSValue *v) {
-  // Get the key first
+RLookupKey *RLookup_GetKeyByName(RLookup *lookup, const char *name, size_t len) {
   RLookupKey *k = RLookup_FindKey(lookup, name, len);
   if (!k) {
     k = RLookup_GetKey_WriteEx(lookup, name, len, RLOOKUP_F_NAMEALLOC);
   }
-  RLookup_WriteKey(k, dst, v);
+  return k;
+}
+
+void RLookup_WriteKeyByName(RLookup *lookup, const char *name, size_t len, RLookupRow *dst, RSValue *v) {
+  RLookup_WriteKey(RLookup_GetKeyByName(lookup, name, len), dst, v);
 }
 
 void RLookup_WriteOwnKeyByName(RLookup *lookup, const char *name, size_t len, RLookupRow *row, RSValue *value) {
@@ -384,6 +441,7 @@ void RLookup_Cleanup(RLookup *lk) {
     cur = next;
   }
   IndexSpecCache_Decref(lk->spcache);
+  rm_free(lk->index);
 
   lk->head = lk->tail = NULL;
   memset(lk, 0xff, sizeof(*lk));
@@ -405,7 +463,6 @@ RSValue *hvalToValue(const RedisModuleString *src, RLookupCoerceType type) {
 
 static RSValue *jsonValToValue(RedisModuleCtx *ctx, RedisJSON json) {
   size_t len;
-  char *str;
   const char *constStr;
   RedisModuleString *rstr;
   long long ll;
@@ -416,8 +473,7 @@ static RSValue *jsonValToValue(RedisModuleCtx *ctx, RedisJSON json) {
   switch (japi->getType(json)) {
     case JSONType_String:
       japi->getString(json, &constStr, &len);
-      str = rm_strndup(constStr, len);
-      return RSValue_NewString(str, len);
+      return RSValue_NewCopiedString(constStr, len);
     case JSONType_Int:
       japi->getInt(json, &ll);
       return RSValue_NewNumberFromInt64(ll);
@@ -615,6 +671,35 @@ RSValue *replyElemToValue(RedisModuleCallReply *rep, RLookupCoerceType otype) {
   }
 }
 
+// Returns the name of the document's key, unless the caller created it in advance.
+// Release it with releaseDocKeyName()
+static RedisModuleString *getDocKeyName(RedisModuleCtx *ctx, const RLookupLoadOptions *options,
+                                        const char *keyPtr, size_t len) {
+  return options->keyName ? options->keyName : RedisModule_CreateString(ctx, keyPtr, len);
+}
+
+static void releaseDocKeyName(RedisModuleCtx *ctx, const RLookupLoadOptions *options,
+                              RedisModuleString *keyName) {
+  if (keyName != options->keyName) {
+    RedisModule_FreeString(ctx, keyName);
+  }
+}
+
+// The value of the hash field of the key. The strings of TAG fields repeat across the documents,
+// so they are interned when the options have an interner
+static RSValue *hvalToKeyValue(const RLookupKey *kk, const RedisModuleString *src,
+                               RLookupCoerceType type, const RLookupLoadOptions *options) {
+  if (type == RLOOKUP_C_STR && options->interner && (kk->flags & RLOOKUP_T_TAG)) {
+    size_t len;
+    const char *str = RedisModule_StringPtrLen(src, &len);
+    RSValue *v = RSValueInterner_Get(options->interner, str, len);
+    if (v) {
+      return v;
+    }
+  }
+  return hvalToValue(src, type);
+}
+
 // returns true if the value of the key is already available
 // avoids the need to call to redis api to get the value
 // i.e we can use the sorting vector as a cache
@@ -637,10 +722,9 @@ static int getKeyCommonHash(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOp
   // In this case, the flag must be obtained via HGET
   if (!*keyobj) {
     RedisModuleCtx *ctx = options->sctx->redisCtx;
-    RedisModuleString *keyName =
-        RedisModule_CreateString(ctx, keyPtr, strlen(keyPtr));
+    RedisModuleString *keyName = getDocKeyName(ctx, options, keyPtr, strlen(keyPtr));
     *keyobj = RedisModule_OpenKey(ctx, keyName, DOCUMENT_OPEN_KEY_QUERY_FLAGS);
-    RedisModule_FreeString(ctx, keyName);
+    releaseDocKeyName(ctx, options, keyName);
     if (!*keyobj) {
       QueryError_SetCode(options->status, QUERY_ERROR_CODE_NO_DOC);
       return REDISMODULE_ERR;
@@ -661,7 +745,7 @@ static int getKeyCommonHash(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOp
     // `val` was created by `RedisModule_HashGet` and is owned by us.
     // This function might retain it, but it's thread-safe to free it afterwards without any locks
     // as it will hold the only reference to it after the next line.
-    rsv = hvalToValue(val, (kk->flags & RLOOKUP_T_NUMERIC) ? RLOOKUP_C_DBL : RLOOKUP_C_STR);
+    rsv = hvalToKeyValue(kk, val, (kk->flags & RLOOKUP_T_NUMERIC) ? RLOOKUP_C_DBL : RLOOKUP_C_STR, options);
     RedisModule_FreeString(RSDummyContext, val);
   } else if (!strcmp(kk->path, UNDERSCORE_KEY)) {
     const RedisModuleString *keyName = RedisModule_GetKeyNameFromModuleKey(*keyobj);
@@ -676,8 +760,15 @@ static int getKeyCommonHash(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOp
 }
 
 
+// The JSON document of the keys loaded for a row
+typedef struct {
+  RedisJSON root;
+  JSONPathReader reader;
+  size_t parentLen;  // The shared parent of the path of the key being loaded, see JSONPathReader
+} jsonDocKeys;
+
 static int getKeyCommonJSON(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOptions *options,
-                        RedisJSON *keyobj) {
+                        jsonDocKeys *doc) {
   if (!japi) {
     QueryError_SetCode(options->status, QUERY_ERROR_CODE_UNSUPP_TYPE);
     RedisModule_Log(RSDummyContext, "warning", "cannot operate on a JSON index as RedisJSON is not loaded");
@@ -692,23 +783,25 @@ static int getKeyCommonJSON(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOp
   RedisModuleCtx *ctx = options->sctx->redisCtx;
   const bool keyPtrFromDMD = options->dmd != NULL;
   char *keyPtr = keyPtrFromDMD ? options->dmd->keyPtr : (char *)options->keyPtr;
-  if (!*keyobj) {
+  if (!doc->root) {
 
-    RedisModuleString* keyName = RedisModule_CreateString(ctx, keyPtr, keyPtrFromDMD ? sdslen(keyPtr) : strlen(keyPtr));
-    *keyobj = japi->openKeyWithFlags(ctx, keyName, DOCUMENT_OPEN_KEY_QUERY_FLAGS);
-    RedisModule_FreeString(ctx, keyName);
+    RedisModuleString* keyName = getDocKeyName(ctx, options, keyPtr, keyPtrFromDMD ? sdslen(keyPtr) : strlen(keyPtr));
+    doc->root = japi->openKeyWithFlags(ctx, keyName, DOCUMENT_OPEN_KEY_QUERY_FLAGS);
+    releaseDocKeyName(ctx, options, keyName);
 
-    if (!*keyobj) {
+    if (!doc->root) {
       QueryError_SetCode(options->status, QUERY_ERROR_CODE_NO_DOC);
       return REDISMODULE_ERR;
     }
+    JSONPathReader_Init(&doc->reader, doc->root);
   }
 
   // Get the actual json value
   RedisModuleString *val = NULL;
   RSValue *rsv = NULL;
 
-  JSONResultsIterator jsonIter = (*kk->path == '$') ? japi->get(*keyobj, kk->path) : NULL;
+  JSONResultsIterator jsonIter =
+      (*kk->path == '$') ? JSONPathReader_Get(&doc->reader, kk->path, doc->parentLen) : NULL;
 
   if (!jsonIter) {
     // The field does not exist and and it isn't `__key`
@@ -730,25 +823,51 @@ static int getKeyCommonJSON(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOp
   return REDISMODULE_OK;
 }
 
+// `keyobj` is the RedisModuleKey ** of a hash, or the jsonDocKeys * of a JSON document
 typedef int (*GetKeyFunc)(const RLookupKey *kk, RLookupRow *dst, RLookupLoadOptions *options,
-                          void **keyobj);
-
+                          void *keyobj);
+
+// Up to this number of keys, the keys whose JSONPaths share a parent are loaded through it
+#define JSON_LOAD_MAX_GROUPED_KEYS 64
+
+// Set the parents that the paths of the keys to load share, in `parentLens`
+static void groupJsonKeys(RLookupLoadOptions *options, size_t *parentLens) {
+  const char *paths[JSON_LOAD_MAX_GROUPED_KEYS];
+  size_t memberParentLens[JSON_LOAD_MAX_GROUPED_KEYS];
+  size_t n = options->nkeys;
+  for (size_t ii = 0; ii < n; ++ii) {
+    paths[ii] = options->keys[ii]->path;
+    memberParentLens[ii] = JSONPath_MemberParentLen(paths[ii], strlen(paths[ii]));
+  }
+  for (size_t ii = 0; ii < n; ++ii) {
+    parentLens[ii] = JSONPath_SharedParentLen(paths, memberParentLens, n, ii);
+  }
+}
 
 int loadIndividualKeys(RLookup *it, RLookupRow *dst, RLookupLoadOptions *options) {
   // Load the document from the schema. This should be simple enough...
-  void *key = NULL;  // This is populated by getKeyCommon; we free it at the end
+  RedisModuleKey *hashKey = NULL;  // This is populated by getKeyCommon; we free it at the end
+  jsonDocKeys jsonDoc = {0};
   DocumentType type = options->dmd ? options->dmd->type : options->type;
   GetKeyFunc getKey = (type == DocumentType_Hash) ? (GetKeyFunc)getKeyCommonHash :
                                                     (GetKeyFunc)getKeyCommonJSON;
+  void *key = (type == DocumentType_Hash) ? (void *)&hashKey : (void *)&jsonDoc;
   int rc = REDISMODULE_ERR;
   // On error we silently skip the rest
   // On success we continue
   // (success could also be when no value is found and nothing is loaded into `dst`,
   //  for example, with a JSONPath with no matches)
   if (options->nkeys) {
+    size_t parentLens[JSON_LOAD_MAX_GROUPED_KEYS];
+    bool grouped = type == DocumentType_Json && options->nkeys > 1 &&
+                   options->nkeys <= JSON_LOAD_MAX_GROUPED_KEYS;
+    if (grouped) {
+      groupJsonKeys(options, parentLens);
+    }
     for (size_t ii = 0; ii < options->nkeys; ++ii) {
       const RLookupKey *kk = options->keys[ii];
-      if (getKey(kk, dst, options, &key) != REDISMODULE_OK) {
+      jsonDoc.parentLen = grouped ? parentLens[ii] : 0;
+      if (getKey(kk, dst, options, key) != REDISMODULE_OK) {
         goto done;
       }
     }
@@ -764,7 +883,7 @@ int loadIndividualKeys(RLookup *it, RLookupRow *dst, RLookupLoadOptions *options
           continue;
         }
       }
-      if (getKey(kk, dst, options, &key) != REDISMODULE_OK) {
+      if (getKey(kk, dst, options, key) != REDISMODULE_OK) {
         goto done;
       }
     }
@@ -772,12 +891,11 @@ int loadIndividualKeys(RLookup *it, RLookupRow *dst, RLookupLoadOptions *options
   rc = REDISMODULE_OK;
 
 done:
-  if (key) {
-    switch (type) {
-    case DocumentType_Hash: RedisModule_CloseKey(key); break;
-    case DocumentType_Json: break;
-    case DocumentType_Unsupported: RS_LOG_ASSERT(1, "placeholder");
-    }
+  if (hashKey) {
+    RedisModule_CloseKey(hashKey);
+  }
+  if (jsonDoc.root) {
+    JSONPathReader_Free(&jsonDoc.reader);
   }
   return rc;
 }
@@ -810,7 +928,7 @@ static void RLookup_HGETALL_scan_callback(RedisModuleKey *key, RedisModuleString
   // the value was created just before calling this callback and will be freed right after
   // the callback returns, so this is a thread-local operation that will take ownership of
   // the string value.
-  RSValue *vptr = hvalToValue(value, ctype);
+  RSValue *vptr = hvalToKeyValue(rlk, value, ctype, pd->options);
   RLookup_WriteOwnKey(rlk, pd->dst, vptr);
 }
 
@@ -818,8 +936,7 @@ static int RLookup_HGETALL(RLookup *it, RLookupRow *dst, RLookupLoadOptions *opt
   int rc = REDISMODULE_ERR;
   RedisModuleCallReply *rep = NULL;
   RedisModuleCtx *ctx = options->sctx->redisCtx;
-  RedisModuleString *krstr =
-      RedisModule_CreateString(ctx, options->dmd->keyPtr, sdslen(options->dmd->keyPtr));
+  RedisModuleString *krstr = getDocKeyName(ctx, options, options->dmd->keyPtr, sdslen(options->dmd->keyPtr));
   // We can only use the scan API from Redis version 6.0.6 and above
   // and when the deployment is not enterprise-crdt
   if(!isFeatureSupported(RM_SCAN_KEY_API_FIX) || isCrdt){
@@ -879,7 +996,7 @@ static int RLookup_HGETALL(RLookup *it, RLookupRow *dst, RLookupLoadOptions *opt
 
 done:
   if (krstr) {
-    RedisModule_FreeString(ctx, krstr);
+    releaseDocKeyName(ctx, options, krstr);
   }
   if (rep) {
     RedisModule_FreeCallReply(rep);
@@ -896,9 +1013,9 @@ int RLookup_JSON_GetAll(RLookup *it, RLookupRow *dst, RLookupLoadOptions *option
   JSONResultsIterator jsonIter = NULL;
   RedisModuleCtx *ctx = options->sctx->redisCtx;
 
-  RedisModuleString* keyName = RedisModule_CreateString(ctx, options->dmd->keyPtr, sdslen(options->dmd->keyPtr));
+  RedisModuleString* keyName = getDocKeyName(ctx, options, options->dmd->keyPtr, sdslen(options->dmd->keyPtr));
   RedisJSON jsonRoot = japi->openKeyWithFlags(ctx, keyName, DOCUMENT_OPEN_KEY_QUERY_FLAGS);
-  RedisModule_FreeString(ctx, keyName);
+  releaseDocKeyName(ctx, options, keyName);
   if (!jsonRoot) {
     goto done;
   }
@@ -96,6 +96,12 @@ typedef struct RLookup {
   // If present, then GetKey will consult this list if the value is not found in
   // the existing list of keys.
   IndexSpecCache *spcache;
+
+  // The keys by name, in an open addressing table whose capacity is a power of 2, once the
+  // lookup has RLOOKUP_INDEX_MIN_KEYS keys. Below that, scanning the list is as fast
+  RLookupKey **index;
+  uint32_t indexCap;
+  uint32_t indexLen;
 } RLookup;
 
 // If the key cannot be found, do not mark it as an error, but create it and
@@ -202,6 +208,11 @@ typedef enum {
  */
 #define RLOOKUP_T_NUMERIC 0x1000
 
+/**
+ * This key type is a tag
+ */
+#define RLOOKUP_T_TAG 0x2000
+
 // Flags that are allowed to be passed to GetKey
 #define RLOOKUP_GET_KEY_FLAGS (RLOOKUP_F_NAMEALLOC | RLOOKUP_F_OVERRIDE | RLOOKUP_F_HIDDEN | RLOOKUP_F_EXPLICITRETURN | \
                                RLOOKUP_F_FORCE_LOAD)
@@ -275,6 +286,12 @@ void RLookup_WriteOwnKey(const RLookupKey *key, RLookupRow *row, RSValue *value)
  */
 void RLookupRow_Move(const RLookup *lk, RLookupRow *src, RLookupRow *dst);
 
+/**
+ * Get the key of the given name, creating it if missing, as RLookup_WriteKeyByName() does. Used to
+ * resolve the key once for many rows
+ */
+RLookupKey *RLookup_GetKeyByName(RLookup *lookup, const char *name, size_t len);
+
 /**
  * Write a value by-name to the lookup table. This is useful for 'dynamic' keys
  * for which it is not necessary to use the boilerplate of getting an explicit
@@ -353,6 +370,13 @@ typedef struct {
   const char *keyPtr;
   DocumentType type;
 
+  /**
+   * Optional. The name of the document's key, created ahead of time by the caller
+   * so it doesn't have to be created while the keyspace is locked. Still owned
+   * by the caller.
+   */
+  RedisModuleString *keyName;
+
   /** Keys to load. If present, then loadNonCached and loadAllFields is ignored */
   const RLookupKey **keys;
   /** Number of keys in keys array */
@@ -375,6 +399,11 @@ typedef struct {
    */
   bool forceString;
 
+  /**
+   * Optional. The strings loaded for TAG keys of hashes are interned in it, see RSValueInterner
+   */
+  struct RSValueInterner *interner;
+
   struct QueryError *status;
 } RLookupLoadOptions;
 
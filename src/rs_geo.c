@@ -9,6 +9,9 @@
 #include "rs_geo.h"
 #include "fast_float/fast_float_strtod.h"
 
+#include <math.h>
+#include <stdlib.h>
+
 int encodeGeo(double lon, double lat, double *bits) {
   GeoHashBits hash;
   int rv = geohashEncodeWGS84(lon, lat, GEO_STEP_MAX, &hash);
@@ -99,6 +102,115 @@ void calcRanges(double longitude, double latitude, double radius_meters, GeoHash
   calcAllNeighbors(&georadius, longitude, latitude, radius_meters, ranges);
 }
 
+static double clampDouble(double v, double min, double max) {
+  return v < min ? min : v > max ? max : v;
+}
+
+/* The distance from the point to the closest point of the area */
+static double distanceToArea(double lon, double lat, const GeoHashArea *area) {
+  const GeoHashRange *lons = &area->longitude, *lats = &area->latitude;
+  if (lon >= lons->min && lon <= lons->max && lat >= lats->min && lat <= lats->max) {
+    return 0;
+  }
+  double dist = INFINITY;
+  // The closest point of a parallel has the longitude of the point, or is one of its ends
+  const double parallelLons[] = {clampDouble(lon, lons->min, lons->max), lons->min, lons->max};
+  for (size_t i = 0; i < sizeof(parallelLons) / sizeof(*parallelLons); i++) {
+    dist = fmin(dist, geohashGetDistance(lon, lat, parallelLons[i], lats->min));
+    dist = fmin(dist, geohashGetDistance(lon, lat, parallelLons[i], lats->max));
+  }
+  // The distance along a meridian less than 90 degrees away is smallest at the latitude where
+  // its derivative is 0, or at the closest end
+  const double meridians[] = {lons->min, lons->max};
+  for (size_t i = 0; i < sizeof(meridians) / sizeof(*meridians); i++) {
+    double dlon = (meridians[i] - lon) * M_PI / 180;
+    if (cos(dlon) > 0) {
+      double closest = atan(tan(lat * M_PI / 180) / cos(dlon)) * 180 / M_PI;
+      dist = fmin(dist, geohashGetDistance(lon, lat, meridians[i],
+                                           clampDouble(closest, lats->min, lats->max)));
+    }
+  }
+  return dist;
+}
+
+/* The distance from the point to the farthest point of the area, which is one of its corners */
+static double maxDistanceToArea(double lon, double lat, const GeoHashArea *area) {
+  const GeoHashRange *lons = &area->longitude, *lats = &area->latitude;
+  return fmax(fmax(geohashGetDistance(lon, lat, lons->min, lats->min),
+                   geohashGetDistance(lon, lat, lons->min, lats->max)),
+              fmax(geohashGetDistance(lon, lat, lons->max, lats->min),
+                   geohashGetDistance(lon, lat, lons->max, lats->max)));
+}
+
+static int cmpCoverRanges(const void *a, const void *b) {
+  double x = ((const GeoCoverRange *)a)->range.min, y = ((const GeoCoverRange *)b)->range.min;
+  return x < y ? -1 : x > y;
+}
+
+// The relative error allowed on the distances to the cells, far above the rounding errors
+#define GEO_COVER_DISTANCE_EPSILON 1e-9
+
+size_t calcCovering(double longitude, double latitude, double radius_meters,
+                    GeoCoverRange *ranges) {
+  GeoHashRadius georadius = geohashGetAreasByRadiusWGS84(longitude, latitude, radius_meters);
+  const GeoHashBits cells[GEO_RANGE_COUNT] = {
+      georadius.hash,
+      georadius.neighbors.north,
+      georadius.neighbors.south,
+      georadius.neighbors.east,
+      georadius.neighbors.west,
+      georadius.neighbors.north_east,
+      georadius.neighbors.north_west,
+      georadius.neighbors.south_east,
+      georadius.neighbors.south_west,
+  };
+
+  size_t n = 0;
+  for (size_t i = 0; i < GEO_RANGE_COUNT; i++) {
+    if (HASHISZERO(cells[i])) {
+      continue;
+    }
+    uint8_t extra = GEO_STEP_MAX - cells[i].step;
+    if (extra > GEO_COVER_EXTRA_STEPS) {
+      extra = GEO_COVER_EXTRA_STEPS;
+    }
+    for (uint64_t k = 0; k < (1ULL << (2 * extra)); k++) {
+      GeoHashBits cell = {.bits = (cells[i].bits << (2 * extra)) | k, .step = cells[i].step + extra};
+      GeoHashArea area;
+      geohashDecodeWGS84(cell, &area);
+      if (distanceToArea(longitude, latitude, &area) > radius_meters * (1 + GEO_COVER_DISTANCE_EPSILON)) {
+        continue;
+      }
+      GeoHashFix52Bits min, max;
+      scoresOfGeoHashBox(cell, &min, &max);
+      ranges[n++] = (GeoCoverRange){
+          .range = {.min = min, .max = max},
+          .inner = maxDistanceToArea(longitude, latitude, &area) <
+                   radius_meters * (1 - GEO_COVER_DISTANCE_EPSILON),
+      };
+    }
+  }
+  if (!n) {
+    return 0;
+  }
+
+  // The neighbors may be the same cell for large radiuses, as in calcAllNeighbors
+  qsort(ranges, n, sizeof(*ranges), cmpCoverRanges);
+  size_t merged = 0;
+  for (size_t i = 1; i < n; i++) {
+    GeoCoverRange *last = &ranges[merged];
+    if (ranges[i].range.min < last->range.max) {
+      continue;
+    }
+    if (ranges[i].range.min == last->range.max && ranges[i].inner == last->inner) {
+      last->range.max = ranges[i].range.max;
+      continue;
+    }
+    ranges[++merged] = ranges[i];
+  }
+  return merged + 1;
+}
+
 bool isWithinRadiusLonLat(double lon1, double lat1, double lon2, double lat2, double radius,
                           double *distance) {
   double dist = geohashGetDistance(lon1, lat1, lon2, lat2);
@@ -33,6 +33,24 @@ int  decodeGeo(double bits, double *xy);
 void calcRanges(double longitude, double latitude, double radius_meters,
                 GeoHashRange *ranges);
 
+/* The cells of a covering are the cells of calcRanges split GEO_COVER_EXTRA_STEPS steps further,
+ * each into 4^GEO_COVER_EXTRA_STEPS cells */
+#define GEO_COVER_EXTRA_STEPS 2
+#define GEO_COVER_MAX_RANGES (GEO_RANGE_COUNT << (2 * GEO_COVER_EXTRA_STEPS))
+
+typedef struct {
+  GeoHashRange range;  // Of the geohash scores of its cells, the max is excluded
+  bool inner;          // Whether the circle contains the cells, or only touches them
+} GeoCoverRange;
+
+/*
+ * Cover the circle with the finer cells of the squares of `calcRanges`, dropping those out of it.
+ * The adjacent cells either inside the circle or on its boundary are merged into a range.
+ * Returns the number of ranges written, sorted by score.
+ */
+size_t calcCovering(double longitude, double latitude, double radius_meters,
+                    GeoCoverRange *ranges);
+
 /*
  * Return true is distance is smaller than radius. radius must be in meters.
  * If `distance' is not NULL, the distance value is returned.
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "search_cache.h"
+#include "search_result.h"
+#include "config.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "util/dict.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct {
+  t_docId docId;
+  double score;
+  RSValue **values;  // Indexed by column, NULL when the row has no value for it
+  uint32_t numValues;
+} SearchCachedRow;
+
+typedef struct {
+  char *name;
+  size_t len;
+} SearchCachedColumn;
+
+typedef struct SearchCachedResult {
+  sds key;
+  arrayof(SearchCachedColumn) columns;
+  arrayof(SearchCachedRow) rows;
+  uint32_t totalResults;
+  size_t bytes;
+  uint32_t refcount;  // One is held by the cache while the entry is in it
+  struct SearchCachedResult *prev, *next;  // From the least to the most recently used
+} SearchCachedResult;
+
+struct SearchResultCache {
+  pthread_mutex_t lock;
+  dict *entries;  // Key -> SearchCachedResult
+  SearchCachedResult *head, *tail;
+  uint64_t revision;  // The revision of the cached results
+  size_t bytes;
+  size_t hits;
+  size_t misses;
+};
+
+static uint64_t sdsHashFunction(const void *key) {
+  return RS_dictGenHashFunction(key, sdslen((sds)key));
+}
+
+static int sdsKeyCompare(void *privdata, const void *key1, const void *key2) {
+  size_t l1 = sdslen((sds)key1), l2 = sdslen((sds)key2);
+  return l1 == l2 && !memcmp(key1, key2, l1);
+}
+
+// The entries own their keys
+static dictType entriesDictType = {
+  .hashFunction = sdsHashFunction,
+  .keyCompare = sdsKeyCompare,
+};
+
+SearchResultCache *NewSearchResultCache(void) {
+  SearchResultCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  cache->entries = dictCreate(&entriesDictType, NULL);
+  return cache;
+}
+
+static void freeRows(arrayof(SearchCachedRow) rows) {
+  for (size_t i = 0; i < array_len(rows); i++) {
+    for (uint32_t j = 0; j < rows[i].numValues; j++) {
+      if (rows[i].values[j]) {
+        RSValue_DecrRef(rows[i].values[j]);
+      }
+    }
+    rm_free(rows[i].values);
+  }
+  array_free(rows);
+}
+
+static void SearchCachedResult_Release(SearchCachedResult *e) {
+  if (__atomic_sub_fetch(&e->refcount, 1, __ATOMIC_ACQ_REL)) {
+    return;
+  }
+  freeRows(e->rows);
+  for (size_t i = 0; i < array_len(e->columns); i++) {
+    rm_free(e->columns[i].name);
+  }
+  array_free(e->columns);
+  sdsfree(e->key);
+  rm_free(e);
+}
+
+// The cache must be locked
+static void unlinkEntry(SearchResultCache *cache, SearchCachedResult *e) {
+  if (e->prev) {
+    e->prev->next = e->next;
+  } else {
+    cache->head = e->next;
+  }
+  if (e->next) {
+    e->next->prev = e->prev;
+  } else {
+    cache->tail = e->prev;
+  }
+  e->prev = e->next = NULL;
+}
+
+// The cache must be locked
+static void linkEntry(SearchResultCache *cache, SearchCachedResult *e) {
+  e->prev = cache->tail;
+  if (cache->tail) {
+    cache->tail->next = e;
+  } else {
+    cache->head = e;
+  }
+  cache->tail = e;
+}
+
+// The cache must be locked
+static void removeEntry(SearchResultCache *cache, SearchCachedResult *e) {
+  dictDelete(cache->entries, e->key);
+  unlinkEntry(cache, e);
+  cache->bytes -= e->bytes;
+  SearchCachedResult_Release(e);
+}
+
+// Evict the least recently used entries until the cache takes at most `bytes`. It must be locked
+static void evict(SearchResultCache *cache, size_t bytes) {
+  while (cache->head && cache->bytes > bytes) {
+    removeEntry(cache, cache->head);
+  }
+}
+
+// Drop the results of older revisions. The cache must be locked
+static void syncRevision(SearchResultCache *cache, uint64_t revision) {
+  if (revision > cache->revision) {
+    evict(cache, 0);
+    cache->revision = revision;
+  }
+}
+
+void SearchResultCache_Free(SearchResultCache *cache) {
+  if (!cache) return;
+  evict(cache, 0);
+  dictRelease(cache->entries);
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+sds SearchResultCache_Key(int protocol, sds *args, size_t nargs) {
+  sds key = sdscatlen(sdsempty(), &protocol, sizeof(protocol));
+  for (size_t i = 0; i < nargs; i++) {
+    size_t len = sdslen(args[i]);
+    key = sdscatlen(key, &len, sizeof(len));
+    key = sdscatlen(key, args[i], len);
+  }
+  return key;
+}
+
+// Get the entry of the key at the revision, counting a hit or a miss
+static SearchCachedResult *SearchResultCache_Get(SearchResultCache *cache, uint64_t revision,
+                                                 const sds key) {
+  pthread_mutex_lock(&cache->lock);
+  syncRevision(cache, revision);
+  // The budget may have been lowered since the entries were added
+  evict(cache, RSGlobalConfig.searchResultCacheBytes);
+  SearchCachedResult *e = revision == cache->revision ? dictFetchValue(cache->entries, key) : NULL;
+  if (e) {
+    unlinkEntry(cache, e);
+    linkEntry(cache, e);
+    __atomic_add_fetch(&e->refcount, 1, __ATOMIC_RELAXED);
+    cache->hits++;
+  } else {
+    cache->misses++;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return e;
+}
+
+// Cache the entry read at the revision, or free it if the index changed since
+static void SearchResultCache_Put(SearchResultCache *cache, uint64_t revision, SearchCachedResult *e) {
+  pthread_mutex_lock(&cache->lock);
+  syncRevision(cache, revision);
+  const size_t budget = RSGlobalConfig.searchResultCacheBytes;
+  if (revision != cache->revision || e->bytes > budget) {
+    pthread_mutex_unlock(&cache->lock);
+    SearchCachedResult_Release(e);
+    return;
+  }
+  // Another query may have cached the same results meanwhile
+  SearchCachedResult *old = dictFetchValue(cache->entries, e->key);
+  if (old) {
+    removeEntry(cache, old);
+  }
+  evict(cache, budget - e->bytes);
+  dictAdd(cache->entries, e->key, e);
+  linkEntry(cache, e);
+  cache->bytes += e->bytes;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+void SearchResultCache_ReplyStats(RedisModule_Reply *reply, SearchResultCache *cache) {
+  pthread_mutex_lock(&cache->lock);
+  const size_t hits = cache->hits, misses = cache->misses;
+  const size_t entries = dictSize(cache->entries), bytes = cache->bytes;
+  pthread_mutex_unlock(&cache->lock);
+
+  RedisModule_ReplyKV_Map(reply, "search_result_cache_stats");
+  RedisModule_ReplyKV_LongLong(reply, "hits", hits);
+  RedisModule_ReplyKV_LongLong(reply, "misses", misses);
+  RedisModule_ReplyKV_LongLong(reply, "entries", entries);
+  RedisModule_ReplyKV_LongLong(reply, "bytes", bytes);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+/*******************************************************************************************************************
+ *  Result Cache Processor
+ *
+ * Replays the rows of a cached query, or records the rows of its pipeline into the cache
+ *******************************************************************************************************************/
+
+typedef struct {
+  ResultProcessor base;
+  SearchResultCache *cache;
+  uint64_t revision;
+  const DocTable *docs;
+  RLookup *lookup;
+
+  // Replaying
+  SearchCachedResult *cached;
+  arrayof(RLookupKey *) cachedKeys;  // The key of each column of the entry
+  size_t curIdx;
+
+  // Recording
+  sds key;
+  arrayof(const RLookupKey *) keys;  // The key of each recorded column
+  arrayof(SearchCachedRow) rows;
+  size_t bytes;
+  bool recording;  // Until the rows took too much memory, or were cached
+} RPSearchResultCache;
+
+static int rpSearchCacheNext_Replay(ResultProcessor *base, SearchResult *r) {
+  RPSearchResultCache *self = (RPSearchResultCache *)base;
+  const SearchCachedResult *e = self->cached;
+  if (!self->curIdx) {
+    base->parent->totalResults = e->totalResults;
+  }
+  while (self->curIdx < array_len(e->rows)) {
+    const SearchCachedRow *row = &e->rows[self->curIdx++];
+    // The documents are there as long as the revision of the index is the one of the rows
+    const RSDocumentMetadata *dmd = DocTable_Borrow(self->docs, row->docId);
+    if (!dmd) {
+      continue;
+    }
+    SearchResult_SetDocId(r, row->docId);
+    SearchResult_SetScore(r, row->score);
+    SearchResult_SetDocumentMetadata(r, dmd);
+    RLookupRow *dst = SearchResult_GetRowDataMut(r);
+    RLookupRow_SetSortingVector(dst, dmd->sortVector);
+    for (uint32_t i = 0; i < row->numValues; i++) {
+      if (row->values[i]) {
+        RLookup_WriteKey(self->cachedKeys[i], dst, row->values[i]);
+      }
+    }
+    return RS_RESULT_OK;
+  }
+  return RS_RESULT_EOF;
+}
+
+static uint32_t columnOf(RPSearchResultCache *self, const RLookupKey *key) {
+  for (uint32_t i = 0; i < array_len(self->keys); i++) {
+    if (self->keys[i] == key) {
+      return i;
+    }
+  }
+  array_append(self->keys, key);
+  return array_len(self->keys) - 1;
+}
+
+// Returns false once the rows take too much memory to be cached
+static bool recordRow(RPSearchResultCache *self, const SearchResult *r) {
+  SearchCachedRow cr = {.docId = SearchResult_GetDocId(r), .score = SearchResult_GetScore(r)};
+  size_t bytes = sizeof(cr);
+  const RLookupRow *row = SearchResult_GetRowData(r);
+  // The values of the sorting vector are read from the document when the row is replayed
+  for (const RLookupKey *k = self->lookup->head; k && row->dyn; k = k->next) {
+    RSValue *v = array_len(row->dyn) > k->dstidx ? row->dyn[k->dstidx] : NULL;
+    if (!v) {
+      continue;
+    }
+    uint32_t col = columnOf(self, k);
+    if (col >= cr.numValues) {
+      cr.values = rm_realloc(cr.values, array_len(self->keys) * sizeof(*cr.values));
+      memset(cr.values + cr.numValues, 0, (array_len(self->keys) - cr.numValues) * sizeof(*cr.values));
+      cr.numValues = array_len(self->keys);
+    }
+    cr.values[col] = RSValue_IncrRef(v);
+    bytes += sizeof(v) + RSValue_MemoryUsage(v);
+  }
+  array_append(self->rows, cr);
+  self->bytes += bytes;
+  return self->bytes <= RSGlobalConfig.searchResultCacheBytes / SEARCH_RESULT_CACHE_ENTRY_SHARE;
+}
+
+static void storeRows(RPSearchResultCache *self) {
+  SearchCachedResult *e = rm_calloc(1, sizeof(*e));
+  e->key = self->key;
+  e->rows = self->rows;
+  e->totalResults = self->base.parent->totalResults;
+  e->columns = array_new(SearchCachedColumn, array_len(self->keys));
+  size_t bytes = sizeof(*e) + sdslen(e->key);
+  for (size_t i = 0; i < array_len(self->keys); i++) {
+    const RLookupKey *k = self->keys[i];
+    SearchCachedColumn col = {.name = rm_strndup(k->name, k->name_len), .len = k->name_len};
+    array_append(e->columns, col);
+    bytes += sizeof(col) + col.len;
+  }
+  e->bytes = self->bytes + bytes;
+  e->refcount = 1;
+  self->key = NULL;
+  self->rows = NULL;
+  SearchResultCache_Put(self->cache, self->revision, e);
+}
+
+static int rpSearchCacheNext_Record(ResultProcessor *base, SearchResult *r) {
+  RPSearchResultCache *self = (RPSearchResultCache *)base;
+  int rc = base->upstream->Next(base->upstream, r);
+  if (!self->recording) {
+    return rc;
+  }
+  if (rc == RS_RESULT_OK) {
+    self->recording = recordRow(self, r);
+  } else {
+    // Partial results, or ones with a warning, are not cached
+    QueryError *err = base->parent->err;
+    if (rc == RS_RESULT_EOF && QueryError_IsOk(err) &&
+        !QueryError_HasReachedMaxPrefixExpansionsWarning(err) && !QueryError_HasQueryOOMWarning(err)) {
+      storeRows(self);
+    }
+    self->recording = false;
+  }
+  return rc;
+}
+
+static void rpSearchCacheFree(ResultProcessor *base) {
+  RPSearchResultCache *self = (RPSearchResultCache *)base;
+  if (self->cached) {
+    SearchCachedResult_Release(self->cached);
+    array_free(self->cachedKeys);
+  }
+  if (self->rows) {
+    freeRows(self->rows);
+  }
+  array_free(self->keys);
+  sdsfree(self->key);
+  rm_free(self);
+}
+
+ResultProcessor *RPSearchResultCache_New(SearchResultCache *cache, uint64_t revision, sds key,
+                                         const DocTable *docs, RLookup *lookup) {
+  RPSearchResultCache *self = rm_calloc(1, sizeof(*self));
+  self->cache = cache;
+  self->revision = revision;
+  self->docs = docs;
+  self->lookup = lookup;
+  self->base.type = RP_RESULT_CACHE;
+  self->base.Free = rpSearchCacheFree;
+
+  self->cached = SearchResultCache_Get(cache, revision, key);
+  if (self->cached) {
+    sdsfree(key);
+    const SearchCachedResult *e = self->cached;
+    self->cachedKeys = array_new(RLookupKey *, array_len(e->columns));
+    for (size_t i = 0; i < array_len(e->columns); i++) {
+      array_append(self->cachedKeys, RLookup_GetKeyByName(lookup, e->columns[i].name, e->columns[i].len));
+    }
+    self->base.Next = rpSearchCacheNext_Replay;
+  } else {
+    self->key = key;
+    self->keys = array_new(const RLookupKey *, 8);
+    self->rows = array_new(SearchCachedRow, 16);
+    self->recording = true;
+    self->base.Next = rpSearchCacheNext_Record;
+  }
+  return &self->base;
+}
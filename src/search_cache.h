@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "result_processor.h"
+#include "rlookup.h"
+#include "doc_table.h"
+#include "reply.h"
+#include "hiredis/sds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The queries whose rows take more than this share of the memory of the cache are not cached
+#define SEARCH_RESULT_CACHE_ENTRY_SHARE 16
+
+/**
+ * A cache of the results of the FT.SEARCH queries of an index, enabled by
+ * _SEARCH_RESULT_CACHE_BYTES (the memory the cache of each index may take), so that repeating a
+ * hot query on a read-mostly index replies with the same rows without running it again.
+ *
+ * The entries are keyed on the arguments of the query (see SearchResultCache_Key()), and hold the
+ * rows it replied with: the id and score of their documents, and the values of the row that the
+ * reply reads. They are stamped with the revision of the index, which is bumped whenever a
+ * document is added or deleted, and the whole cache is dropped once it is read at a newer
+ * revision. The least recently used entries are evicted once the cache takes more than its
+ * memory. Lookups may run concurrently, from the worker threads, and are serialized by the cache
+ * itself.
+ */
+typedef struct SearchResultCache SearchResultCache;
+
+SearchResultCache *NewSearchResultCache(void);
+void SearchResultCache_Free(SearchResultCache *cache);
+
+/* The key of a query: the protocol of its reply and its arguments after the index name, which
+ * hold its query string, parameters, LIMIT, SORTBY and whatever else shapes the reply */
+sds SearchResultCache_Key(int protocol, sds *args, size_t nargs);
+
+/**
+ * A processor to push at the end of the pipeline of the query, once it is built.
+ *
+ * If the rows of the query are cached at `revision`, it replays them (and the total number of
+ * results) without reading its upstream processors. Otherwise it passes the results of its
+ * upstream through, and caches them once they are all read without an error or a warning.
+ * Takes ownership of `key`. The documents of the rows are read from `docs`, and their values
+ * written to the keys of `lookup`.
+ */
+ResultProcessor *RPSearchResultCache_New(SearchResultCache *cache, uint64_t revision, sds key,
+                                         const DocTable *docs, RLookup *lookup);
+
+/* Reply with the statistics of the cache, for FT.INFO */
+void SearchResultCache_ReplyStats(RedisModule_Reply *reply, SearchResultCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,6 +16,7 @@
 #include "concurrent_ctx.h"
 #include "trie/trie_type.h"
 #include <time.h>
+#include "util/timeout.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +39,8 @@ typedef struct {
   struct timespec current;
   // when the query should timeout - monotonic raw clock, unrelated to real clock
   struct timespec timeout;
+  // stops the query early when set, as if it timed out (optional, see `QueryProcessingCtx.cancel`)
+  const QueryCancelToken *cancel;
 } SearchTime;
 
 /** Context passed to all redis related search handling functions. */
@@ -81,6 +84,9 @@ void RedisSearchCtx_LockSpecWrite(RedisSearchCtx *sctx);
 
 void RedisSearchCtx_UnlockSpec(RedisSearchCtx *sctx);
 
+/* Count the waits of the calling thread for the locks of the indexes as waits of the GC */
+void RedisSearchCtx_MarkGCThread(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -65,6 +65,61 @@ QueryIterator* SearchDisk_NewWildcardIterator(RedisSearchDiskIndexSpec *index, d
     return disk->index.newWildcardIterator(index, weight);
 }
 
+bool SearchDisk_IndexDocuments(RedisSearchDiskIndexSpec *index, t_docId docId, const DiskTermEntry *entries, size_t numEntries) {
+    RS_ASSERT(disk && index);
+    if (disk->index.indexDocuments) {
+        return disk->index.indexDocuments(index, docId, entries, numEntries);
+    }
+    bool ok = true;
+    for (size_t i = 0; i < numEntries; i++) {
+        ok &= disk->index.indexDocument(index, entries[i].term, docId, entries[i].fieldMask);
+    }
+    return ok;
+}
+
+bool SearchDisk_HasNumeric() {
+    return disk && disk->index.indexNumeric && disk->index.newNumericIterator;
+}
+
+bool SearchDisk_IndexNumeric(RedisSearchDiskIndexSpec *index, t_fieldIndex field, t_docId docId, const double *values, size_t numValues) {
+    RS_ASSERT(SearchDisk_HasNumeric() && index);
+    return disk->index.indexNumeric(index, field, docId, values, numValues);
+}
+
+QueryIterator* SearchDisk_NewNumericIterator(RedisSearchDiskIndexSpec *index, t_fieldIndex field, double min, double max,
+                                             bool minInclusive, bool maxInclusive, double weight) {
+    RS_ASSERT(SearchDisk_HasNumeric() && index);
+    return disk->index.newNumericIterator(index, field, min, max, minInclusive, maxInclusive, weight);
+}
+
+bool SearchDisk_HasTags() {
+    return disk && disk->index.indexTags && disk->index.newTagIterator;
+}
+
+bool SearchDisk_IndexTags(RedisSearchDiskIndexSpec *index, t_fieldIndex field, t_docId docId, const char **tags, size_t numTags) {
+    RS_ASSERT(SearchDisk_HasTags() && index);
+    return disk->index.indexTags(index, field, docId, tags, numTags);
+}
+
+QueryIterator* SearchDisk_NewTagIterator(RedisSearchDiskIndexSpec *index, t_fieldIndex field, const char *tag, size_t len, double weight) {
+    RS_ASSERT(SearchDisk_HasTags() && index && tag);
+    return disk->index.newTagIterator(index, field, tag, len, weight);
+}
+
+bool SearchDisk_HasPostings() {
+    return disk && disk->index.putPostings && disk->index.takePostings;
+}
+
+bool SearchDisk_PutPostings(RedisSearchDiskIndexSpec *index, const char *term, size_t len, const char *data, size_t dataLen) {
+    RS_ASSERT(SearchDisk_HasPostings() && index);
+    return disk->index.putPostings(index, term, len, data, dataLen);
+}
+
+char *SearchDisk_TakePostings(RedisSearchDiskIndexSpec *index, const char *term, size_t len, size_t *dataLen) {
+    RS_ASSERT(SearchDisk_HasPostings() && index);
+    return disk->index.takePostings(index, term, len, &sdsnewlen, dataLen);
+}
+
 t_docId SearchDisk_PutDocument(RedisSearchDiskIndexSpec *handle, const char *key, double score, uint32_t flags, uint32_t maxFreq) {
     RS_ASSERT(disk && handle);
     return disk->docTable.putDocument(handle, key, score, flags, maxFreq);
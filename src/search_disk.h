@@ -83,6 +83,110 @@ QueryIterator* SearchDisk_NewTermIterator(RedisSearchDiskIndexSpec *index, const
  */
 QueryIterator* SearchDisk_NewWildcardIterator(RedisSearchDiskIndexSpec *index, double weight);
 
+/**
+ * @brief Index all the terms of a document at once
+ *
+ * Falls back to indexing the terms one at a time when the disk library does not support it.
+ *
+ * @param index Pointer to the index
+ * @param docId Document ID to index
+ * @param entries The terms of the document
+ * @param numEntries Number of entries
+ * @return true if successful, false otherwise
+ */
+bool SearchDisk_IndexDocuments(RedisSearchDiskIndexSpec *index, t_docId docId, const DiskTermEntry *entries, size_t numEntries);
+
+/**
+ * @brief Check if the NUMERIC fields of the disk indexes are written to the disk database
+ *
+ * When they are not, they are indexed in memory, as for the other indexes.
+ */
+bool SearchDisk_HasNumeric();
+
+/**
+ * @brief Index the values of a NUMERIC field of a document
+ *
+ * @param index Pointer to the index
+ * @param field Index of the field in the schema
+ * @param docId Document ID to index
+ * @param values The values of the field
+ * @param numValues Number of values
+ * @return true if successful, false otherwise
+ */
+bool SearchDisk_IndexNumeric(RedisSearchDiskIndexSpec *index, t_fieldIndex field, t_docId docId, const double *values, size_t numValues);
+
+/**
+ * @brief Create an IndexIterator for the documents having a value of a NUMERIC field in a range
+ *
+ * @param index Pointer to the index
+ * @param field Index of the field in the schema
+ * @param min, max Bounds of the range
+ * @param minInclusive, maxInclusive Whether the bounds are part of the range
+ * @param weight Weight for the iterator (used in scoring)
+ * @return Pointer to the IndexIterator, or NULL on error
+ */
+QueryIterator* SearchDisk_NewNumericIterator(RedisSearchDiskIndexSpec *index, t_fieldIndex field, double min, double max,
+                                             bool minInclusive, bool maxInclusive, double weight);
+
+/**
+ * @brief Check if the TAG fields of the disk indexes are written to the disk database
+ *
+ * When they are not, they are indexed in memory, as for the other indexes.
+ */
+bool SearchDisk_HasTags();
+
+/**
+ * @brief Index the values of a TAG field of a document
+ *
+ * @param index Pointer to the index
+ * @param field Index of the field in the schema
+ * @param docId Document ID to index
+ * @param tags The values of the field
+ * @param numTags Number of values
+ * @return true if successful, false otherwise
+ */
+bool SearchDisk_IndexTags(RedisSearchDiskIndexSpec *index, t_fieldIndex field, t_docId docId, const char **tags, size_t numTags);
+
+/**
+ * @brief Create an IndexIterator for the documents having a value of a TAG field
+ *
+ * @param index Pointer to the index
+ * @param field Index of the field in the schema
+ * @param tag The value to look up
+ * @param len Length of the value
+ * @param weight Weight for the iterator (used in scoring)
+ * @return Pointer to the IndexIterator, or NULL on error
+ */
+QueryIterator* SearchDisk_NewTagIterator(RedisSearchDiskIndexSpec *index, t_fieldIndex field, const char *tag, size_t len, double weight);
+
+/**
+ * @brief Check if the postings of the terms of the indexes in memory can be stored on disk
+ */
+bool SearchDisk_HasPostings();
+
+/**
+ * @brief Store the postings of a term
+ *
+ * @param index Pointer to the index
+ * @param term Term the postings belong to
+ * @param len Length of the term
+ * @param data The postings
+ * @param dataLen Length of the postings
+ * @return true if successful, false otherwise
+ */
+bool SearchDisk_PutPostings(RedisSearchDiskIndexSpec *index, const char *term, size_t len, const char *data, size_t dataLen);
+
+/**
+ * @brief Read the postings of a term stored by SearchDisk_PutPostings, and delete them
+ *
+ * @param index Pointer to the index
+ * @param term Term the postings belong to
+ * @param len Length of the term
+ * @param dataLen Set to the length of the postings
+ * @return The postings, to free with sdsfree, or NULL if they are not stored
+ */
+char *SearchDisk_TakePostings(RedisSearchDiskIndexSpec *index, const char *term, size_t len, size_t *dataLen);
+
 // DocTable API wrappers
 
 /**
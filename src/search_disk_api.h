@@ -22,6 +22,14 @@ typedef const void* RedisSearchDiskIndexSpec;
 typedef const void* RedisSearchDiskInvertedIndex;
 typedef const void* RedisSearchDiskIterator;
 
+// A term of the forward index of a document, for the batched writes
+typedef struct DiskTermEntry {
+  const char *term;
+  size_t len;
+  t_fieldMask fieldMask;
+  uint32_t freq;
+} DiskTermEntry;
+
 // Callback function to allocate memory for the key in the scope of the search module memory
 typedef char* (*AllocateKeyCallback)(const void*, size_t len);
 
@@ -64,6 +72,100 @@ typedef struct IndexDiskAPI {
    * @return Number of documents in the index
    */
   QueryIterator* (*newWildcardIterator)(RedisSearchDiskIndexSpec *index, double weight);
+
+  /*
+   * The entries below were added in version 2 of the API, and may be NULL, in which case the terms
+   * are written one at a time and the NUMERIC and TAG fields are kept in memory.
+   */
+
+  /**
+   * @brief Indexes all the terms of a document at once
+   *
+   * @param index Pointer to the index
+   * @param docId Document ID to index
+   * @param entries The terms of the document, in no particular order
+   * @param numEntries Number of entries
+   * @return true if the write was successful, false otherwise
+   */
+  bool (*indexDocuments)(RedisSearchDiskIndexSpec *index, t_docId docId, const DiskTermEntry *entries, size_t numEntries);
+
+  /**
+   * @brief Indexes the values of a NUMERIC field of a document
+   *
+   * @param index Pointer to the index
+   * @param field Index of the field in the schema
+   * @param docId Document ID to index
+   * @param values The values of the field (several for multi-value JSON fields)
+   * @param numValues Number of values
+   * @return true if the write was successful, false otherwise
+   */
+  bool (*indexNumeric)(RedisSearchDiskIndexSpec *index, t_fieldIndex field, t_docId docId, const double *values, size_t numValues);
+
+  /**
+   * @brief Creates a new iterator over the documents having a value of a NUMERIC field in a range
+   *
+   * @param index Pointer to the index
+   * @param field Index of the field in the schema
+   * @param min, max Bounds of the range
+   * @param minInclusive, maxInclusive Whether the bounds are part of the range
+   * @param weight Weight for the iterator (used in scoring)
+   * @return Pointer to the created iterator, or NULL if creation failed
+   */
+  QueryIterator *(*newNumericIterator)(RedisSearchDiskIndexSpec *index, t_fieldIndex field, double min, double max,
+                                       bool minInclusive, bool maxInclusive, double weight);
+
+  /**
+   * @brief Indexes the values of a TAG field of a document
+   *
+   * @param index Pointer to the index
+   * @param field Index of the field in the schema
+   * @param docId Document ID to index
+   * @param tags The values of the field, already split and normalized
+   * @param numTags Number of values
+   * @return true if the write was successful, false otherwise
+   */
+  bool (*indexTags)(RedisSearchDiskIndexSpec *index, t_fieldIndex field, t_docId docId, const char **tags, size_t numTags);
+
+  /**
+   * @brief Creates a new iterator over the documents having a value of a TAG field
+   *
+   * @param index Pointer to the index
+   * @param field Index of the field in the schema
+   * @param tag The value, normalized as it was indexed
+   * @param len Length of the value
+   * @param weight Weight for the iterator (used in scoring)
+   * @return Pointer to the created iterator, or NULL if creation failed
+   */
+  QueryIterator *(*newTagIterator)(RedisSearchDiskIndexSpec *index, t_fieldIndex field, const char *tag, size_t len, double weight);
+
+  /*
+   * The entries below were added in version 3 of the API, and may be NULL, in which case the terms
+   * of the indexes in memory are never moved to the disk database (see term_tiers.h).
+   */
+
+  /**
+   * @brief Stores the postings of a term of an index in memory, as an opaque buffer
+   *
+   * @param index Pointer to the index
+   * @param term Term the postings belong to
+   * @param len Length of the term
+   * @param data The postings
+   * @param dataLen Length of the postings
+   * @return true if the write was successful, false otherwise
+   */
+  bool (*putPostings)(RedisSearchDiskIndexSpec *index, const char *term, size_t len, const char *data, size_t dataLen);
+
+  /**
+   * @brief Reads the postings of a term stored by putPostings, and deletes them
+   *
+   * @param index Pointer to the index
+   * @param term Term the postings belong to
+   * @param len Length of the term
+   * @param allocate Callback allocating the returned buffer in the memory of the search module
+   * @param dataLen Set to the length of the postings
+   * @return The postings, allocated by `allocate`, or NULL if they are not stored
+   */
+  char *(*takePostings)(RedisSearchDiskIndexSpec *index, const char *term, size_t len, AllocateKeyCallback allocate, size_t *dataLen);
 } IndexDiskAPI;
 
 typedef struct DocTableDiskAPI {
@@ -100,7 +202,7 @@ typedef struct RedisSearchDiskAPI {
   DocTableDiskAPI docTable;
 } RedisSearchDiskAPI;
 
-#define RedisSearchDiskAPI_LATEST_API_VER 1
+#define RedisSearchDiskAPI_LATEST_API_VER 3
 #ifdef __cplusplus
 }
 #endif
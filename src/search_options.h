@@ -102,6 +102,16 @@ typedef struct {
   const StopWordList *stopwords;
   dict *params;
 
+  // Sent by the coordinator with `_KNN_DISTANCE_BOUND`: the KNN queries without a filter only
+  // look for the results at most this far from their vector
+  double knnDistanceBound;
+  bool hasKnnDistanceBound;
+
+  // FT.AGGREGATE SAMPLE: the ratio of the results the query samples (0 or 1 if it doesn't), or
+  // the number of documents of the index to sample, from which the ratio is then computed
+  double sampleRatio;
+  size_t sampleCount;
+
   /** Legacy options */
   struct {
     LegacyNumericFilter **filters;
@@ -12,12 +12,60 @@
 #include "redisearch_rs/headers/types_rs.h"
 #include "rlookup.h"
 #include "score_explain.h"
+#include "util/mempool.h"
+#include <pthread.h>
+
+// The results freed by a thread, kept with their row arrays for the next ones it allocates
+static pthread_key_t resultsPoolKey_g;
+
+static void *resultAlloc() {
+  return rm_calloc(1, sizeof(SearchResult));
+}
+
+static void resultFree(void *p) {
+  SearchResult_Destroy(p);
+  rm_free(p);
+}
+
+static void __attribute__((constructor)) initResultsPoolKey() {
+  pthread_key_create(&resultsPoolKey_g, (void (*)(void *))mempool_destroy);
+}
+
+static inline mempool_t *getResultsPool() {
+  mempool_t *pool = pthread_getspecific(resultsPoolKey_g);
+  if (pool == NULL) {
+    const mempool_options opts = {
+        .initialCap = 0, .maxCap = 1000, .alloc = resultAlloc, .free = resultFree};
+    pool = mempool_new(&opts);
+    pthread_setspecific(resultsPoolKey_g, pool);
+  }
+  return pool;
+}
+
+SearchResult *SearchResult_New(void) {
+  return mempool_get(getResultsPool());
+}
+
+void SearchResult_Free(SearchResult *r) {
+  if (!r) return;
+  SearchResult_Clear(r);
+  // Keep the (wiped) row array, so that the next result of the thread writes its fields in place
+  RLookupRow row = r->rowdata;
+  *r = (SearchResult){.rowdata = row};
+  mempool_release(getResultsPool(), r);
+}
+
+void SearchResult_MoveFree(SearchResult *dst, SearchResult *src) {
+  SearchResult_Override(dst, src);
+  *src = (SearchResult){0};
+  mempool_release(getResultsPool(), src);
+}
 
 // Allocates a new SearchResult, and populates it with `r`'s data (takes
 // ownership as well)
 SearchResult *SearchResult_AllocateMove(SearchResult *r) {
-  SearchResult *ret = rm_malloc(sizeof(*ret));
-  *ret = *r;
+  SearchResult *ret = SearchResult_New();
+  SearchResult_Override(ret, r);
   return ret;
 }
 
@@ -37,12 +85,15 @@ void SearchResult_Clear(SearchResult *r) {
     SearchResult_SetIndexResult(r, NULL);
   }
 
+  const bool borrowed = SearchResult_GetFlags(r) & Result_BorrowedDmd;
   SearchResult_SetFlags(r, 0);
   RLookupRow_Wipe(SearchResult_GetRowDataMut(r));
 
   const RSDocumentMetadata* dmd = SearchResult_GetDocumentMetadata(r);
   if (dmd) {
-    DMD_Return(dmd);
+    if (!borrowed) {
+      DMD_Return(dmd);
+    }
     SearchResult_SetDocumentMetadata(r, NULL);
   }
 }
@@ -52,6 +103,13 @@ void SearchResult_Destroy(SearchResult *r) {
   RLookupRow_Reset(SearchResult_GetRowDataMut(r));
 }
 
+void SearchResult_PinDocumentMetadata(SearchResult *res) {
+  if (SearchResult_GetFlags(res) & Result_BorrowedDmd) {
+    DMD_Incref(res->dmd);
+    SearchResult_SetFlags(res, SearchResult_GetFlags(res) & ~Result_BorrowedDmd);
+  }
+}
+
 void SearchResult_Override(SearchResult *dst, SearchResult *src) {
   if (!src) return;
   RLookupRow oldrow = dst->rowdata;
@@ -46,6 +46,29 @@ typedef struct {
 
 /* SearchResult flags */
 static const uint8_t Result_ExpiredDoc = 1 << 0;
+// The result holds no reference to its document metadata, which is only valid while the spec is
+// locked. See `SearchResult_PinDocumentMetadata`
+static const uint8_t Result_BorrowedDmd = 1 << 1;
+
+/**
+ * Allocates an empty SearchResult. Results are pooled per thread: the ones a thread frees are
+ * kept (up to a bound) for the next ones it allocates, along with the arrays of their rows, so
+ * that the results of a query are not allocated one by one while the workers contend on the
+ * allocator. Free it with `SearchResult_Free`.
+ */
+SearchResult* SearchResult_New(void);
+
+/**
+ * Destroys the contents of a result allocated by `SearchResult_New` (or
+ * `SearchResult_AllocateMove`), and returns it to the pool of the calling thread.
+ */
+void SearchResult_Free(SearchResult* r);
+
+/**
+ * Moves the contents of the allocated `src` into `dst` (see `SearchResult_Override`), and returns
+ * `src` to the pool of the calling thread.
+ */
+void SearchResult_MoveFree(SearchResult* dst, SearchResult* src);
 
 /**
  * Moves the contents of `r` into a newly heap-allocated SearchResult.
@@ -72,6 +95,12 @@ void SearchResult_Destroy(SearchResult* r);
  */
 void SearchResult_Override(SearchResult* dst, SearchResult* src);
 
+/**
+ * Takes a reference to the document metadata of `res` if it was borrowed from the spec, so that
+ * the result can be kept once the spec is unlocked. Must be called while the spec is locked.
+ */
+void SearchResult_PinDocumentMetadata(SearchResult* res);
+
 /**
  * Returns the document ID of `res`.
 */
@@ -194,7 +223,8 @@ static inline void SearchResult_SetFlags(SearchResult* res, uint8_t flags) {
  */
 static inline void SearchResult_MergeFlags(SearchResult* res, const SearchResult* other) {
   RS_ASSERT(res && other);
-  res->flags |= other->flags;
+  // A borrowed metadata is a property of the result which holds it
+  res->flags |= other->flags & ~Result_BorrowedDmd;
 }
 
 #ifdef __cplusplus
@@ -14,6 +14,15 @@
 #include <string.h>
 #include <strings.h>
 #include "vector_index.h"
+#include "spec.h"
+#include <pthread.h>
+
+// The weight of a query in the moving average of the queries which may have missed results
+#define SHARD_WINDOW_MISS_WEIGHT 0.05
+#define SHARD_WINDOW_GROW_FACTOR 2.0
+#define SHARD_WINDOW_SHRINK_FACTOR 0.9
+
+static pthread_mutex_t shardWindowLock_g = PTHREAD_MUTEX_INITIALIZER;
 
 void modifyKNNCommand(MRCommand *cmd, size_t query_arg_index, size_t effectiveK, VectorQuery *vq) {
     // Get original K value from the VectorQuery
@@ -33,3 +42,43 @@ void modifyKNNCommand(MRCommand *cmd, size_t query_arg_index, size_t effectiveK,
     // Replace just the K value substring at the exact position
     MRCommand_ReplaceArgSubstring(cmd, query_arg_index, k_pos, k_len, effectiveK_str, newK_len);
 }
+
+double ShardWindow_GetRatio(IndexSpec *sp) {
+  pthread_mutex_lock(&shardWindowLock_g);
+  double ratio = sp->shardWindowRatio;
+  pthread_mutex_unlock(&shardWindowLock_g);
+  return ratio > MIN_SHARD_WINDOW_RATIO ? ratio : MAX_SHARD_WINDOW_RATIO;
+}
+
+void ShardWindow_Learn(IndexSpec *sp, size_t k, size_t window, const uint32_t *hits,
+                       size_t numShards) {
+  if (!k || numShards < 2) {
+    return;
+  }
+  size_t maxHits = 0;
+  for (size_t i = 0; i < numShards; i++) {
+    if (hits[i] > maxHits) {
+      maxHits = hits[i];
+    }
+  }
+  // A shard asked for the full K has nothing more to give
+  bool missed = window < k && maxHits >= window;
+  double allowed = 1.0 - RSGlobalConfig.shardWindowTargetRecall / 100.0;
+  double minRatio = 1.0 / numShards;
+
+  pthread_mutex_lock(&shardWindowLock_g);
+  double ratio = sp->shardWindowRatio > MIN_SHARD_WINDOW_RATIO ? sp->shardWindowRatio
+                                                               : MAX_SHARD_WINDOW_RATIO;
+  sp->shardWindowMissRate += SHARD_WINDOW_MISS_WEIGHT * ((missed ? 1.0 : 0.0) - sp->shardWindowMissRate);
+  if (missed) {
+    if (sp->shardWindowMissRate > allowed) {
+      ratio = fmin(ratio * SHARD_WINDOW_GROW_FACTOR, MAX_SHARD_WINDOW_RATIO);
+    }
+  } else if (sp->shardWindowMissRate <= allowed) {
+    // Keep room for one more result than the busiest shard gave, which tells a miss apart
+    double needed = (double)(maxHits + 1) / k;
+    ratio = fmax(ratio * SHARD_WINDOW_SHRINK_FACTOR, fmin(needed, ratio));
+  }
+  sp->shardWindowRatio = fmax(ratio, minRatio);
+  pthread_mutex_unlock(&shardWindowLock_g);
+}
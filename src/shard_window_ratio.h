@@ -75,6 +75,27 @@ static inline size_t calculateEffectiveK(size_t originalK, double ratio, size_t
  */
 void modifyKNNCommand(MRCommand *cmd, size_t query_arg_index, size_t effectiveK, VectorQuery *vq);
 
+struct IndexSpec;
+
+/**
+ * The shard window ratio learned for the index from its previous KNN queries, when
+ * _SHARD_WINDOW_TARGET_RECALL is set. Starts at MAX_SHARD_WINDOW_RATIO, so that the first queries
+ * ask every shard for the full K.
+ */
+double ShardWindow_GetRatio(struct IndexSpec *sp);
+
+/**
+ * Learn from the top results of a KNN query of the index, which asked each of the `numShards`
+ * shards for `window` of its `k` results. `hits` holds the number of results of each shard which
+ * made it to the top results.
+ *
+ * A shard all of whose results made it may have had more of them to give, so the query may have
+ * missed some. The ratio grows as soon as these queries are more frequent than the target recall
+ * allows, and otherwise shrinks slowly toward what the shards actually contributed.
+ */
+void ShardWindow_Learn(struct IndexSpec *sp, size_t k, size_t window, const uint32_t *hits,
+                       size_t numShards);
+
 #ifdef __cplusplus
 }
 #endif
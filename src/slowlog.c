@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "slowlog.h"
+#include "aggregate/aggregate.h"
+#include "profile.h"
+#include "query.h"
+#include "reply.h"
+#include "rmalloc.h"
+#include "rmutil/strings.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define SLOWLOG_DEFAULT_GET_COUNT 10
+
+typedef struct {
+  long long id;
+  long long timestamp;  // Unix time, in seconds
+  rs_wall_clock_ns_t duration;
+  const char *command;
+  char *index;  // Obfuscated
+  char *query;  // Obfuscated
+  char *plan;   // One iterator per line, or NULL if the query read no iterators
+  uint32_t totalResults;
+  rs_wall_clock_ns_t iteratorsTime;
+  rs_wall_clock_ns_t loadTime;
+  rs_wall_clock_ns_t sortTime;
+  rs_wall_clock_ns_t replyTime;
+  rs_wall_clock_ns_t lockWaitTime;
+} SlowLogEntry;
+
+// The entries are in `ring[(head + i) % cap]`, from the oldest to the newest
+static struct {
+  pthread_mutex_t lock;
+  SlowLogEntry *ring;
+  size_t cap;
+  size_t head;
+  size_t len;
+  long long nextId;
+} slowlog = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static void freeEntry(SlowLogEntry *e) {
+  rm_free(e->index);
+  rm_free(e->query);
+  rm_free(e->plan);
+}
+
+static SlowLogEntry *entryAt(size_t i) {
+  return &slowlog.ring[(slowlog.head + i) % slowlog.cap];
+}
+
+// Keep the newest `cap` entries, in a ring of `cap` entries. Called with the lock held
+static void resizeRing(size_t cap) {
+  while (slowlog.len > cap) {
+    freeEntry(entryAt(0));
+    slowlog.head = (slowlog.head + 1) % slowlog.cap;
+    slowlog.len--;
+  }
+  SlowLogEntry *ring = rm_malloc(cap * sizeof(*ring));
+  for (size_t i = 0; i < slowlog.len; i++) {
+    ring[i] = *entryAt(i);
+  }
+  rm_free(slowlog.ring);
+  slowlog.ring = ring;
+  slowlog.cap = cap;
+  slowlog.head = 0;
+}
+
+// Called with the lock held
+static void clearRing(void) {
+  for (size_t i = 0; i < slowlog.len; i++) {
+    freeEntry(entryAt(i));
+  }
+  slowlog.head = slowlog.len = 0;
+}
+
+void SlowLog_CountQuery(AREQ *req, rs_wall_clock_ns_t duration) {
+  const unsigned int thresholdMS = RSGlobalConfig.slowlogThresholdMS;
+  const QEFlags flags = AREQ_RequestFlags(req);
+  if (!thresholdMS || duration < (rs_wall_clock_ns_t)thresholdMS * 1000000 ||
+      (flags & (QEXEC_F_IS_HYBRID_TAIL | QEXEC_F_IS_HYBRID_SEARCH_SUBQUERY |
+                QEXEC_F_IS_HYBRID_VECTOR_AGGREGATE_SUBQUERY))) {
+    return;
+  }
+
+  // Everything but the lock is prepared here, as the request is owned by the calling thread
+  QueryProcessingCtx *qctx = AREQ_QueryProcessingCtx(req);
+  const IndexSpec *spec = AREQ_SearchCtx(req)->spec;
+  const rs_wall_clock_ns_t chunkTime = rs_wall_clock_elapsed_ns(&qctx->chunkClock);
+  const rs_wall_clock_ns_t timed = qctx->loadTime + qctx->sortTime + qctx->replyTime;
+  SlowLogEntry e = {
+    .timestamp = time(NULL),
+    .duration = duration,
+    .command = flags & QEXEC_F_IS_SEARCH ? "FT.SEARCH" : "FT.AGGREGATE",
+    .index = rm_strdup(spec && spec->obfuscatedName ? spec->obfuscatedName : ""),
+    .query = QAST_DumpObfuscated(&req->ast),
+    .plan = Profile_DescribeIterators(QITR_GetRootFilter(qctx)),
+    .totalResults = qctx->totalResults,
+    .iteratorsTime = chunkTime > timed ? chunkTime - timed : 0,
+    .loadTime = qctx->loadTime,
+    .sortTime = qctx->sortTime,
+    .replyTime = qctx->replyTime,
+    .lockWaitTime = qctx->lockWaitTime,
+  };
+
+  pthread_mutex_lock(&slowlog.lock);
+  const size_t maxLen = RSGlobalConfig.slowlogMaxLen;
+  if (slowlog.cap != maxLen) {
+    resizeRing(maxLen);
+  }
+  SlowLogEntry *slot;
+  if (slowlog.len < slowlog.cap) {
+    slot = entryAt(slowlog.len++);
+  } else {
+    // Overwrite the oldest entry
+    slot = entryAt(0);
+    freeEntry(slot);
+    slowlog.head = (slowlog.head + 1) % slowlog.cap;
+  }
+  e.id = slowlog.nextId++;
+  *slot = e;
+  pthread_mutex_unlock(&slowlog.lock);
+}
+
+static void replyPlan(RedisModule_Reply *reply, const char *plan) {
+  RedisModule_ReplyKV_Array(reply, "plan");
+  for (const char *line = plan; line && *line;) {
+    const char *end = strchr(line, '\n');
+    const size_t len = end ? (size_t)(end - line) : strlen(line);
+    RedisModule_Reply_StringBuffer(reply, line, len);
+    line += len + (end != NULL);
+  }
+  RedisModule_Reply_ArrayEnd(reply);
+}
+
+static void replyEntry(RedisModule_Reply *reply, const SlowLogEntry *e) {
+  RedisModule_Reply_Map(reply);
+  RedisModule_ReplyKV_LongLong(reply, "id", e->id);
+  RedisModule_ReplyKV_LongLong(reply, "timestamp", e->timestamp);
+  RedisModule_ReplyKV_Double(reply, "duration_ms", rs_wall_clock_convert_ns_to_ms_d(e->duration));
+  RedisModule_ReplyKV_SimpleString(reply, "command", e->command);
+  RedisModule_ReplyKV_SimpleString(reply, "index", e->index);
+  RedisModule_ReplyKV_SimpleString(reply, "query", e->query);
+  RedisModule_ReplyKV_LongLong(reply, "total_results", e->totalResults);
+  replyPlan(reply, e->plan);
+  RedisModule_ReplyKV_Map(reply, "times_ms");
+  RedisModule_ReplyKV_Double(reply, "iterators", rs_wall_clock_convert_ns_to_ms_d(e->iteratorsTime));
+  RedisModule_ReplyKV_Double(reply, "load", rs_wall_clock_convert_ns_to_ms_d(e->loadTime));
+  RedisModule_ReplyKV_Double(reply, "sort", rs_wall_clock_convert_ns_to_ms_d(e->sortTime));
+  RedisModule_ReplyKV_Double(reply, "reply", rs_wall_clock_convert_ns_to_ms_d(e->replyTime));
+  RedisModule_ReplyKV_Double(reply, "lock_wait", rs_wall_clock_convert_ns_to_ms_d(e->lockWaitTime));
+  RedisModule_Reply_MapEnd(reply);
+  RedisModule_Reply_MapEnd(reply);
+}
+
+int SlowLogCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+  if (argc < 2) {
+    return RedisModule_WrongArity(ctx);
+  }
+
+  if (RMUtil_StringEqualsCaseC(argv[1], "LEN")) {
+    if (argc != 2) {
+      return RedisModule_WrongArity(ctx);
+    }
+    pthread_mutex_lock(&slowlog.lock);
+    const size_t len = slowlog.len;
+    pthread_mutex_unlock(&slowlog.lock);
+    return RedisModule_ReplyWithLongLong(ctx, len);
+  }
+
+  if (RMUtil_StringEqualsCaseC(argv[1], "RESET")) {
+    if (argc != 2) {
+      return RedisModule_WrongArity(ctx);
+    }
+    pthread_mutex_lock(&slowlog.lock);
+    clearRing();
+    pthread_mutex_unlock(&slowlog.lock);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+  }
+
+  if (!RMUtil_StringEqualsCaseC(argv[1], "GET")) {
+    return RedisModule_ReplyWithError(ctx, "Unknown FT.SLOWLOG subcommand");
+  }
+  if (argc > 3) {
+    return RedisModule_WrongArity(ctx);
+  }
+  long long count = SLOWLOG_DEFAULT_GET_COUNT;
+  if (argc == 3 && (RedisModule_StringToLongLong(argv[2], &count) != REDISMODULE_OK || count < -1)) {
+    return RedisModule_ReplyWithError(ctx, "Count must be a non-negative integer, or -1 for all");
+  }
+
+  RedisModule_Reply _reply = RedisModule_NewReply(ctx), *reply = &_reply;
+  pthread_mutex_lock(&slowlog.lock);
+  const size_t n = count == -1 || (size_t)count > slowlog.len ? slowlog.len : (size_t)count;
+  RedisModule_Reply_Array(reply);
+  // The newest first
+  for (size_t i = 0; i < n; i++) {
+    replyEntry(reply, entryAt(slowlog.len - 1 - i));
+  }
+  RedisModule_Reply_ArrayEnd(reply);
+  pthread_mutex_unlock(&slowlog.lock);
+  RedisModule_EndReply(reply);
+  return REDISMODULE_OK;
+}
+
+void SlowLog_Free(void) {
+  pthread_mutex_lock(&slowlog.lock);
+  clearRing();
+  rm_free(slowlog.ring);
+  slowlog.ring = NULL;
+  slowlog.cap = 0;
+  pthread_mutex_unlock(&slowlog.lock);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stdbool.h>
+#include "redismodule.h"
+#include "rs_wall_clock.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The slow log keeps the queries which ran for at least `search-_slowlog-threshold-ms`, with what is
+ * needed to tell why: the shape of their query and of their iterators, how many results each
+ * iterator read out of how many it estimated, and the time spent in the stages of the pipeline and
+ * waiting for locks. The terms of the query and the name of the index are obfuscated, so that the
+ * log may be shared.
+ *
+ * The last `search-_slowlog-max-len` entries are kept in a ring, behind a mutex which is only taken
+ * when a query is slow enough to be logged, or by FT.SLOWLOG.
+ */
+
+struct AREQ;
+
+/* Whether the queries are timed for the slow log. Their iterators count their reads while it is */
+static inline bool SlowLog_Enabled(void) {
+  return RSGlobalConfig.slowlogThresholdMS > 0;
+}
+
+/* Log the request if its command took `duration` ns, and at least the threshold. Thread safe. Called
+ * once its chunk is sent, before its counters are reset */
+void SlowLog_CountQuery(struct AREQ *req, rs_wall_clock_ns_t duration);
+
+/* FT.SLOWLOG GET [count] | LEN | RESET */
+int SlowLogCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
+
+/* Drop the entries of the log */
+void SlowLog_Free(void);
+
+#ifdef __cplusplus
+}
+#endif
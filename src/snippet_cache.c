@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "snippet_cache.h"
+#include "config.h"
+#include "rmalloc.h"
+#include "util/dict.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct SnippetCacheEntry {
+  sds key;
+  char *text;   // NULL when the field was left as is
+  size_t len;
+  size_t bytes;
+  struct SnippetCacheEntry *prev, *next;  // From the least to the most recently used
+} SnippetCacheEntry;
+
+struct SnippetCache {
+  pthread_mutex_t lock;
+  dict *entries;  // Key -> SnippetCacheEntry
+  SnippetCacheEntry *head, *tail;
+  size_t bytes;
+  size_t hits;
+  size_t misses;
+};
+
+static uint64_t sdsHashFunction(const void *key) {
+  return RS_dictGenHashFunction(key, sdslen((sds)key));
+}
+
+static int sdsKeyCompare(void *privdata, const void *key1, const void *key2) {
+  size_t l1 = sdslen((sds)key1), l2 = sdslen((sds)key2);
+  return l1 == l2 && !memcmp(key1, key2, l1);
+}
+
+// The entries own their keys
+static dictType entriesDictType = {
+  .hashFunction = sdsHashFunction,
+  .keyCompare = sdsKeyCompare,
+};
+
+SnippetCache *NewSnippetCache(void) {
+  SnippetCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  cache->entries = dictCreate(&entriesDictType, NULL);
+  return cache;
+}
+
+// The cache must be locked
+static void unlinkEntry(SnippetCache *cache, SnippetCacheEntry *e) {
+  if (e->prev) {
+    e->prev->next = e->next;
+  } else {
+    cache->head = e->next;
+  }
+  if (e->next) {
+    e->next->prev = e->prev;
+  } else {
+    cache->tail = e->prev;
+  }
+  e->prev = e->next = NULL;
+}
+
+// The cache must be locked
+static void linkEntry(SnippetCache *cache, SnippetCacheEntry *e) {
+  e->prev = cache->tail;
+  if (cache->tail) {
+    cache->tail->next = e;
+  } else {
+    cache->head = e;
+  }
+  cache->tail = e;
+}
+
+// The cache must be locked
+static void removeEntry(SnippetCache *cache, SnippetCacheEntry *e) {
+  dictDelete(cache->entries, e->key);
+  unlinkEntry(cache, e);
+  cache->bytes -= e->bytes;
+  sdsfree(e->key);
+  rm_free(e->text);
+  rm_free(e);
+}
+
+// Evict the least recently used entries until the cache takes at most `bytes`. It must be locked
+static void evict(SnippetCache *cache, size_t bytes) {
+  while (cache->head && cache->bytes > bytes) {
+    removeEntry(cache, cache->head);
+  }
+}
+
+void SnippetCache_Free(SnippetCache *cache) {
+  if (!cache) return;
+  evict(cache, 0);
+  dictRelease(cache->entries);
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+bool SnippetCache_Get(SnippetCache *cache, const sds key, RSValue **value) {
+  pthread_mutex_lock(&cache->lock);
+  // The budget may have been lowered since the entries were added
+  evict(cache, RSGlobalConfig.snippetCacheBytes);
+  SnippetCacheEntry *e = dictFetchValue(cache->entries, key);
+  if (e) {
+    unlinkEntry(cache, e);
+    linkEntry(cache, e);
+    // Copied under the lock, as the entry may be evicted as soon as it is released
+    *value = e->text ? RSValue_NewCopiedString(e->text, e->len) : NULL;
+    cache->hits++;
+  } else {
+    cache->misses++;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return e != NULL;
+}
+
+void SnippetCache_Put(SnippetCache *cache, sds key, const RSValue *value) {
+  SnippetCacheEntry *e = rm_calloc(1, sizeof(*e));
+  e->key = key;
+  if (value) {
+    const char *text = RSValue_StringPtrLen(value, &e->len);
+    e->text = rm_malloc(e->len + 1);
+    memcpy(e->text, text, e->len);
+  }
+  e->bytes = sizeof(*e) + sdslen(key) + e->len;
+
+  pthread_mutex_lock(&cache->lock);
+  const size_t budget = RSGlobalConfig.snippetCacheBytes;
+  if (e->bytes > budget / SNIPPET_CACHE_ENTRY_SHARE ||
+      // Another query may have cached the same snippet meanwhile
+      dictFetchValue(cache->entries, key)) {
+    pthread_mutex_unlock(&cache->lock);
+    sdsfree(e->key);
+    rm_free(e->text);
+    rm_free(e);
+    return;
+  }
+  evict(cache, budget - e->bytes);
+  dictAdd(cache->entries, e->key, e);
+  linkEntry(cache, e);
+  cache->bytes += e->bytes;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+void SnippetCache_ReplyStats(RedisModule_Reply *reply, SnippetCache *cache) {
+  pthread_mutex_lock(&cache->lock);
+  const size_t hits = cache->hits, misses = cache->misses;
+  const size_t entries = dictSize(cache->entries), bytes = cache->bytes;
+  pthread_mutex_unlock(&cache->lock);
+
+  RedisModule_ReplyKV_Map(reply, "snippet_cache_stats");
+  RedisModule_ReplyKV_LongLong(reply, "hits", hits);
+  RedisModule_ReplyKV_LongLong(reply, "misses", misses);
+  RedisModule_ReplyKV_LongLong(reply, "entries", entries);
+  RedisModule_ReplyKV_LongLong(reply, "bytes", bytes);
+  RedisModule_Reply_MapEnd(reply);
+}
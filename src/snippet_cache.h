@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "value.h"
+#include "reply.h"
+#include "hiredis/sds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The snippets taking more than this share of the memory of the cache are not cached
+#define SNIPPET_CACHE_ENTRY_SHARE 16
+
+/**
+ * A cache of the fields highlighted and summarized by the queries of an index, enabled by
+ * _SNIPPET_CACHE_BYTES (the memory the cache of each index may take), so that a popular document
+ * returned again under the same query terms is not fragmented again.
+ *
+ * The entries are keyed on the id of the document, the field, the terms the document matched and
+ * the HIGHLIGHT and SUMMARIZE options (see the highlighter). A document gets a new id whenever it
+ * is updated, so the snippets of its older versions are never read again, and are evicted along
+ * with the least recently used ones once the cache takes more than its memory. Lookups may run
+ * concurrently, from the worker threads, and are serialized by the cache itself.
+ */
+typedef struct SnippetCache SnippetCache;
+
+SnippetCache *NewSnippetCache(void);
+void SnippetCache_Free(SnippetCache *cache);
+
+/**
+ * Look the key up, counting a hit or a miss.
+ * @returns true if it is cached, setting `value` to a new value holding its snippet, or to NULL if
+ * the field was left as is
+ */
+bool SnippetCache_Get(SnippetCache *cache, const sds key, RSValue **value);
+
+/* Cache the snippet of the key, or NULL if the field was left as is. Takes ownership of `key` */
+void SnippetCache_Put(SnippetCache *cache, sds key, const RSValue *value);
+
+/* Reply with the statistics of the cache, for FT.INFO */
+void SnippetCache_ReplyStats(RedisModule_Reply *reply, SnippetCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,15 +13,34 @@
 #include "rmutil/util.h"
 #include "rmutil/strings.h"
 #include "rmalloc.h"
+#include "util/slab.h"
 #include "sortable.h"
 #include "buffer.h"
 
+#define SORTING_VECTOR_SIZE(len) (sizeof(RSSortingVector) + (len) * sizeof(RSValue *))
+
+// The vectors of up to SORTING_VECTOR_SLABS values are allocated from a slab of their length, as
+// each document of an index with sortable fields has one
+#define SORTING_VECTOR_SLABS 16
+#define SORTING_VECTOR_SLAB(len) SLAB_INITIALIZER(SORTING_VECTOR_SIZE(len))
+
+static Slab sortingVectorSlabs[SORTING_VECTOR_SLABS] = {
+    SORTING_VECTOR_SLAB(1),  SORTING_VECTOR_SLAB(2),  SORTING_VECTOR_SLAB(3),
+    SORTING_VECTOR_SLAB(4),  SORTING_VECTOR_SLAB(5),  SORTING_VECTOR_SLAB(6),
+    SORTING_VECTOR_SLAB(7),  SORTING_VECTOR_SLAB(8),  SORTING_VECTOR_SLAB(9),
+    SORTING_VECTOR_SLAB(10), SORTING_VECTOR_SLAB(11), SORTING_VECTOR_SLAB(12),
+    SORTING_VECTOR_SLAB(13), SORTING_VECTOR_SLAB(14), SORTING_VECTOR_SLAB(15),
+    SORTING_VECTOR_SLAB(16),
+};
+
 /* Create a sorting vector of a given length for a document */
 RSSortingVector *NewSortingVector(size_t len) {
   if (len > RS_SORTABLES_MAX) {
     return NULL;
   }
-  RSSortingVector *ret = rm_malloc(sizeof(RSSortingVector) + (len * sizeof(RSValue*)));
+  RSSortingVector *ret = len && len <= SORTING_VECTOR_SLABS
+                             ? Slab_Alloc(&sortingVectorSlabs[len - 1])
+                             : rm_malloc(SORTING_VECTOR_SIZE(len));
   ret->len = len;
   // set all values to NIL
   for (int i = 0; i < len; i++) {
@@ -89,7 +108,31 @@ void SortingVector_Free(RSSortingVector *v) {
   for (size_t i = 0; i < v->len; i++) {
     RSValue_DecrRef(v->values[i]);
   }
-  rm_free(v);
+  if (v->len && v->len <= SORTING_VECTOR_SLABS) {
+    Slab_Free(&sortingVectorSlabs[v->len - 1], v);
+  } else {
+    rm_free(v);
+  }
+}
+
+/* Save a sorting vector to RDB, as SortingVector_RdbLoad() reads it */
+void SortingVector_RdbSave(RedisModuleIO *rdb, const RSSortingVector *v) {
+  RedisModule_SaveUnsigned(rdb, v->len);
+  for (size_t i = 0; i < v->len; i++) {
+    const RSValue *val = RSValue_Dereference(v->values[i]);
+    if (RSValue_IsNumber(val)) {
+      RedisModule_SaveUnsigned(rdb, RS_SORTABLE_NUM);
+      RedisModule_SaveDouble(rdb, RSValue_Number_Get(val));
+    } else if (RSValue_IsAnyString(val)) {
+      size_t len;
+      const char *str = RSValue_StringPtrLen(val, &len);
+      RedisModule_SaveUnsigned(rdb, RSValueType_String);
+      // With the terminating NUL, which the load expects
+      RedisModule_SaveStringBuffer(rdb, str, len + 1);
+    } else {
+      RedisModule_SaveUnsigned(rdb, RS_SORTABLE_NIL);
+    }
+  }
 }
 
 /* Load a sorting vector from RDB */
@@ -144,3 +187,83 @@ size_t RSSortingVector_GetMemorySize(RSSortingVector *v) {
   }
   return sum;
 }
+
+#define SORTING_COLUMNS_MIN_CAP 1024
+
+static void sortingColumnFill(double *col, size_t from, size_t to) {
+  for (size_t i = from; i < to; i++) {
+    col[i] = NAN;
+  }
+}
+
+// Makes room for `docId` in all the columns
+static void sortingColumnsGrow(RSSortingColumns *c, t_docId docId, size_t maxIds) {
+  size_t cap = MAX(c->cap * 2, SORTING_COLUMNS_MIN_CAP);
+  cap = MIN(MAX(cap, docId + 1), maxIds);
+  for (size_t i = 0; i < c->ncols; i++) {
+    if (c->cols[i]) {
+      c->cols[i] = rm_realloc(c->cols[i], cap * sizeof(double));
+      sortingColumnFill(c->cols[i], c->cap, cap);
+    }
+  }
+  c->cap = cap;
+}
+
+void RSSortingColumns_Set(RSSortingColumns *c, t_docId docId, const RSSortingVector *sv,
+                          size_t maxIds) {
+  if (docId >= maxIds) {
+    return;
+  }
+  for (size_t i = 0; i < sv->len; i++) {
+    const RSValue *v = sv->values[i] ? RSValue_Dereference(sv->values[i]) : NULL;
+    if (!v || !RSValue_IsNumber(v)) {
+      // A document which is updated in place may have had a number in the field
+      if (i < c->ncols && c->cols[i] && docId < c->cap) {
+        c->cols[i][docId] = NAN;
+      }
+      continue;
+    }
+    if (docId >= c->cap) {
+      sortingColumnsGrow(c, docId, maxIds);
+    }
+    if (i >= c->ncols) {
+      c->cols = rm_realloc(c->cols, sv->len * sizeof(*c->cols));
+      memset(c->cols + c->ncols, 0, (sv->len - c->ncols) * sizeof(*c->cols));
+      c->ncols = sv->len;
+    }
+    if (!c->cols[i]) {
+      c->cols[i] = rm_malloc(c->cap * sizeof(double));
+      sortingColumnFill(c->cols[i], 0, c->cap);
+    }
+    c->cols[i][docId] = RSValue_Number_Get(v);
+  }
+}
+
+void RSSortingColumns_Clear(RSSortingColumns *c, t_docId docId) {
+  if (docId >= c->cap) {
+    return;
+  }
+  for (size_t i = 0; i < c->ncols; i++) {
+    if (c->cols[i]) {
+      c->cols[i][docId] = NAN;
+    }
+  }
+}
+
+size_t RSSortingColumns_MemUsage(const RSSortingColumns *c) {
+  size_t sum = c->ncols * sizeof(*c->cols);
+  for (size_t i = 0; i < c->ncols; i++) {
+    if (c->cols[i]) {
+      sum += c->cap * sizeof(double);
+    }
+  }
+  return sum;
+}
+
+void RSSortingColumns_Free(RSSortingColumns *c) {
+  for (size_t i = 0; i < c->ncols; i++) {
+    rm_free(c->cols[i]);
+  }
+  rm_free(c->cols);
+  *c = (RSSortingColumns){0};
+}
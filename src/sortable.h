@@ -10,6 +10,8 @@
 
 #include "value.h"
 
+#include <math.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -64,9 +66,43 @@ RSSortingVector *NewSortingVector(size_t len);
 /* Free a sorting vector */
 void SortingVector_Free(RSSortingVector *v);
 
-/* Load a sorting vector from RDB. Used by legacy RDB load only */
+/* Save a sorting vector to RDB. Its numbers and strings are saved, and its other values as NIL */
+void SortingVector_RdbSave(RedisModuleIO *rdb, const RSSortingVector *v);
+
+/* Load a sorting vector from RDB. Used by legacy RDB load, and to load the persisted contents of
+ * an index */
 RSSortingVector *SortingVector_RdbLoad(RedisModuleIO *rdb);
 
+/* The numeric sortable values of the documents of a table, stored by column: one dense array of
+ * doubles per sortable index, indexed by doc id. Reading one field of many documents from its
+ * column does not touch their sorting vectors. A document without a number in the field (no value,
+ * a string or a NaN) has a NaN in the column, and its value is read from its sorting vector */
+typedef struct {
+  double **cols;    // Per sortable index, NULL until a number is set in it
+  size_t cap;       // The number of ids held by each column
+  uint16_t ncols;
+} RSSortingColumns;
+
+/* Sets the numbers of the sorting vector of a document in the columns. Ids from `maxIds` on are
+ * not stored, so that the columns do not grow past the size of the table */
+void RSSortingColumns_Set(RSSortingColumns *c, t_docId docId, const RSSortingVector *sv,
+                          size_t maxIds);
+
+/* Removes the numbers of a document from the columns */
+void RSSortingColumns_Clear(RSSortingColumns *c, t_docId docId);
+
+/* Returns the number of the document at a sortable index, or NaN if it is not in the columns */
+static inline double RSSortingColumns_GetNum(const RSSortingColumns *c, size_t idx, t_docId docId) {
+  if (idx < c->ncols && c->cols[idx] && docId < c->cap) {
+    return c->cols[idx][docId];
+  }
+  return NAN;
+}
+
+size_t RSSortingColumns_MemUsage(const RSSortingColumns *c);
+
+void RSSortingColumns_Free(RSSortingColumns *c);
+
 /* Normalize sorting string for storage. This folds everything to unicode equivalent strings. The
  * allocated return string needs to be freed later */
 char *normalizeStr(const char *str);
@@ -10,6 +10,7 @@
 
 #include <math.h>
 #include <ctype.h>
+#include <stdatomic.h>
 
 #include "triemap.h"
 #include "util/logging.h"
@@ -22,9 +23,22 @@
 #include "config.h"
 #include "cursor.h"
 #include "tag_index.h"
+#include "numeric_index.h"
 #include "redis_index.h"
 #include "indexer.h"
 #include "suffix.h"
+#include "stemmer.h"
+#include "phonetic_manager.h"
+#include "prefix_cache.h"
+#include "term_stats.h"
+#include "knn_cache.h"
+#include "search_cache.h"
+#include "query_plan_cache.h"
+#include "filter_cache.h"
+#include "snippet_cache.h"
+#include "term_index_cache.h"
+#include "impact_postings.h"
+#include "spell_delete_index.h"
 #include "alias.h"
 #include "module.h"
 #include "aggregate/expr/expression.h"
@@ -42,10 +56,14 @@
 #include "util/hash/hash.h"
 #include "reply_macros.h"
 #include "notifications.h"
+#include "index_delta.h"
 #include "info/field_spec_info.h"
 #include "rs_wall_clock.h"
 #include "util/redis_mem_info.h"
 #include "search_disk.h"
+#include "index_segment.h"
+#include "varint.h"
+#include "iterators/inverted_index_iterator.h"
 
 #define INITIAL_DOC_TABLE_SIZE 1000
 
@@ -423,8 +441,13 @@ void Indexes_SetTempSpecsTimers(TimerOp op) {
 //---------------------------------------------------------------------------------------------
 
 double IndexesScanner_IndexedPercent(RedisModuleCtx *ctx, IndexesScanner *scanner, const IndexSpec *sp) {
-  if (scanner || sp->scan_in_progress) {
-    if (scanner) {
+  if (IndexSpec_IsCold(sp)) {
+    return 0;
+  } else if (scanner || sp->scan_in_progress) {
+    if (scanner && scanner->fieldsOnly) {
+      t_docId maxDocId = sp->docs.maxDocId;
+      return maxDocId > 0 ? MIN(1.0, (double)(scanner->nextDocId - 1) / maxDocId) : 0;
+    } else if (scanner) {
       size_t totalKeys = RedisModule_DbSize(ctx);
       return totalKeys > 0 ? (double)scanner->scannedKeys / totalKeys : 0;
     } else {
@@ -475,6 +498,8 @@ size_t IndexSpec_collect_text_overhead(const IndexSpec *sp) {
   if (sp->suffix) {
     // TODO: Count the values' memory as well
     overhead += TrieType_MemUsage(sp->suffix);
+  } else if (sp->suffixArray) {
+    overhead += SuffixArray_MemUsage(sp->suffixArray);
   }
   return overhead;
 }
@@ -484,7 +509,8 @@ size_t IndexSpec_TotalMemUsage(IndexSpec *sp, size_t doctable_tm_size, size_t ta
   size_t res = 0;
   res += sp->docs.memsize;
   res += sp->docs.sortablesSize;
-  res += doctable_tm_size ? doctable_tm_size : TrieMap_MemUsage(sp->docs.dim.tm);
+  res += RSSortingColumns_MemUsage(&sp->docs.sortingColumns);
+  res += doctable_tm_size ? doctable_tm_size : DocIdMap_MemUsage(&sp->docs.dim);
   res += text_overhead ? text_overhead :  IndexSpec_collect_text_overhead(sp);
   res += tags_overhead ? tags_overhead : IndexSpec_collect_tags_overhead(sp);
   res += IndexSpec_collect_numeric_overhead(sp);
@@ -1298,6 +1324,16 @@ static int parseFieldSpec(ArgsCursor *ac, IndexSpec *sp, StrongRef sp_ref, Field
         fs->options |= FieldSpec_UNF;
       }
       continue;
+    } else if (AC_AdvanceIfMatch(ac, SPEC_STORED_STR)) {
+      if (!FIELD_IS(fs, INDEXFLD_T_FULLTEXT | INDEXFLD_T_TAG | INDEXFLD_T_NUMERIC)) {
+        QueryError_SetWithUserDataFmt(status, QUERY_ERROR_CODE_PARSE_ARGS, "`STORED` is only supported for TEXT, TAG and NUMERIC fields", ", field `%s`", HiddenString_GetUnsafe(fs->fieldName, NULL));
+        goto error;
+      }
+      // The value is kept as is in the sorting vector of the documents, so that it is loaded from
+      // there rather than from their keys. It can be sorted by as well
+      FieldSpec_SetSortable(fs);
+      fs->options |= FieldSpec_Stored | FieldSpec_UNF;
+      continue;
     } else if (AC_AdvanceIfMatch(ac, SPEC_NOINDEX_STR)) {
       fs->options |= FieldSpec_NotIndexable;
       continue;
@@ -1396,6 +1432,10 @@ static int IndexSpec_AddFieldsInternal(IndexSpec *sp, StrongRef spec_ref, ArgsCu
         QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_INVAL, "Disk index does not support NOINDEX fields");
         goto reset;
       }
+      if (fs->options & FieldSpec_Stored) {
+        QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_INVAL, "Disk index does not support STORED fields");
+        goto reset;
+      }
       if (fs->options & FieldSpec_Sortable) {
         QueryError_SetWithoutUserDataFmt(status, QUERY_ERROR_CODE_INVAL, "Disk index does not support SORTABLE fields");
         goto reset;
@@ -1485,14 +1525,13 @@ static int IndexSpec_AddFieldsInternal(IndexSpec *sp, StrongRef spec_ref, ArgsCu
     }
     if (FIELD_IS(fs, INDEXFLD_T_FULLTEXT) && FieldSpec_HasSuffixTrie(fs)) {
       sp->suffixMask |= FIELD_BIT(fs);
-      if (!sp->suffix) {
-        sp->flags |= Index_HasSuffixTrie;
-        sp->suffix = NewTrie(suffixTrie_freeCallback, Trie_Sort_Lex);
-      }
+      sp->flags |= Index_HasSuffixTrie;
+      IndexSpec_InitSuffixIndex(sp);
     }
   }
 
   // If we successfully modified the schema, we need to update the spec cache
+  JSONPath_GroupFields(sp->fields, sp->numFields);
   IndexSpecCache_Decref(sp->spcache);
   sp->spcache = IndexSpec_BuildSpecCache(sp);
 
@@ -1515,14 +1554,25 @@ reset:
   return 0;
 }
 
+static bool IndexSpec_CanIndexFields(const IndexSpec *sp, t_fieldIndex firstField);
+static void IndexSpec_IndexFieldsAsync(StrongRef spec_ref, t_fieldIndex firstField);
+
 // Assumes the spec is locked for write
 int IndexSpec_AddFields(StrongRef spec_ref, IndexSpec *sp, RedisModuleCtx *ctx, ArgsCursor *ac, bool initialScan,
                         QueryError *status) {
   setMemoryInfo(ctx);
 
+  t_fieldIndex firstField = sp->numFields;
   int rc = IndexSpec_AddFieldsInternal(sp, spec_ref, ac, status, 0);
+  // The cached query trees point at the fields, which may have been moved
+  QueryPlanCache_Clear(sp->queryPlans);
   if (rc && initialScan) {
-    IndexSpec_ScanAndReindex(ctx, spec_ref);
+    if (IndexSpec_CanIndexFields(sp, firstField)) {
+      // Only the new fields are indexed, for the documents which are already in the index
+      IndexSpec_IndexFieldsAsync(spec_ref, firstField);
+    } else {
+      IndexSpec_ScanAndReindex(ctx, spec_ref);
+    }
   }
 
   return rc;
@@ -1664,6 +1714,20 @@ void IndexSpec_AddTerm(IndexSpec *sp, const char *term, size_t len) {
   if (isNew) {
     sp->stats.numTerms++;
     sp->stats.termsSize += len;
+    if (sp->spellDeletes) {
+      SpellDeleteIndex_Add(sp->spellDeletes, term, len);
+    }
+  }
+}
+
+void IndexSpec_InitSuffixIndex(IndexSpec *sp) {
+  if (sp->suffix || sp->suffixArray) {
+    return;
+  }
+  if (RSGlobalConfig.suffixArray) {
+    sp->suffixArray = NewSuffixArray();
+  } else {
+    sp->suffix = NewTrie(suffixTrie_freeCallback, Trie_Sort_Lex);
   }
 }
 
@@ -1765,6 +1829,20 @@ static void IndexSpec_FreeUnlinkedData(IndexSpec *spec) {
   if (spec->terms) {
     TrieType_Free(spec->terms);
   }
+  PrefixCache_Free(spec->prefixCache);
+  spec->prefixCache = NULL;
+  TermStatsCache_Free(spec->termStats);
+  spec->termStats = NULL;
+  TermIndexCache_Free(spec->termIndexes);
+  spec->termIndexes = NULL;
+  ImpactPostings_Free(spec->impactPostings);
+  spec->impactPostings = NULL;
+  KNNResultCache_Free(spec->knnResults);
+  SearchResultCache_Free(spec->searchResults);
+  QueryPlanCache_Free(spec->queryPlans);
+  FilterCache_Free(spec->filterCache);
+  SnippetCache_Free(spec->snippets);
+  spec->knnResults = NULL;
   // Free TEXT TAG NUMERIC VECTOR and GEOSHAPE fields trie and inverted indexes
   if (spec->keysDict) {
     dictRelease(spec->keysDict);
@@ -1819,11 +1897,16 @@ static void IndexSpec_FreeUnlinkedData(IndexSpec *spec) {
   if (spec->suffix) {
     TrieType_Free(spec->suffix);
   }
+  if (spec->suffixArray) {
+    SuffixArray_Free(spec->suffixArray);
+  }
+  SpellDeleteIndex_Free(spec->spellDeletes);
 
   // Destroy the spec's lock
   pthread_rwlock_destroy(&spec->rwlock);
 
   if (spec->diskSpec) SearchDisk_CloseIndex(spec->diskSpec);
+  if (spec->coldTerms) SearchDisk_CloseIndex(spec->coldTerms);
 
   // Free spec struct
   rm_free(spec);
@@ -1973,6 +2056,9 @@ StrongRef IndexSpec_LoadUnsafe(const char *name) {
 }
 
 StrongRef IndexSpec_LoadUnsafeEx(IndexLoadOptions *options) {
+  // The commands reading an index inside MULTI/EXEC or a script see the writes made before them
+  KeyspaceEvents_IndexPending(RSDummyContext);
+
   const char *ixname = NULL;
   if (options->flags & INDEXSPEC_LOAD_KEY_RSTRING) {
     ixname = RedisModule_StringPtrLen(options->nameR, NULL);
@@ -2063,6 +2149,144 @@ void IndexSpec_InitializeSynonym(IndexSpec *sp) {
   }
 }
 
+static int cmpOffsets(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Subtract the entries of an inverted index of a term from the statistics of the spec, before it
+// is freed
+static void IndexSpec_RemoveTermIndexStats(IndexSpec *sp, InvertedIndex *idx) {
+  sp->stats.invertedSize -= InvertedIndex_MemUsage(idx);
+  sp->stats.numRecords -= InvertedIndex_NumEntries(idx);
+  if (!(sp->flags & Index_StoreTermOffsets)) {
+    return;
+  }
+  FieldMaskOrIndex allFields = {.isFieldMask = true, .value.mask = RS_FIELDMASK_ALL};
+  QueryIterator *it = NewInvIndIterator_TermQuery(idx, NULL, allFields, NULL, 1);
+  while (it->Read(it) == ITERATOR_OK) {
+    uint32_t len;
+    RSOffsetVector_GetData(IndexResult_TermOffsetsRef(it->current), &len);
+    sp->stats.offsetVecsSize -= len;
+    sp->stats.offsetVecRecords -= RSIndexResult_DecodeOffsets(it->current, NULL, 0);
+  }
+  it->Free(it);
+}
+
+// Assuming the spec is locked for writing before calling this function.
+bool IndexSpec_RebuildSynonymGroup(RedisSearchCtx *sctx, const char *groupId) {
+  IndexSpec *sp = sctx->spec;
+  if (sp->diskSpec || !sp->keysDict || !sp->smap) {
+    return false;
+  }
+
+  // Open an iterator over each of the terms of the group which has entries
+  size_t numTerms;
+  const char **terms = SynonymMap_GetGroupTerms(sp->smap, groupId, &numTerms);
+  FieldMaskOrIndex allFields = {.isFieldMask = true, .value.mask = RS_FIELDMASK_ALL};
+  QueryIterator **its = array_new(QueryIterator *, numTerms);
+  for (size_t i = 0; i < numTerms; i++) {
+    InvertedIndex *idx = Redis_OpenInvertedIndex(sctx, terms[i], strlen(terms[i]), 0, NULL);
+    if (!idx) {
+      continue;
+    }
+    QueryIterator *it = NewInvIndIterator_TermQuery(idx, NULL, allFields, NULL, 1);
+    if (it->Read(it) == ITERATOR_OK) {
+      array_append(its, it);
+    } else {
+      it->Free(it);
+    }
+  }
+  rm_free(terms);
+
+  // Merge them by document, as the forward index of each document would have had the group id at
+  // the positions of all the terms of the group
+  bool storeOffsets = sp->flags & Index_StoreTermOffsets;
+  size_t memsize;
+  InvertedIndex *merged = NewInvertedIndex(sp->flags, &memsize);
+  size_t numRecords = 0, offsetVecsSize = 0, offsetVecRecords = 0;
+  VarintVectorWriter *vw = NewVarintVectorWriter(64);
+  uint32_t *offsets = array_new(uint32_t, 16);
+  while (array_len(its)) {
+    t_docId docId = its[0]->lastDocId;
+    for (uint32_t i = 1; i < array_len(its); i++) {
+      docId = MIN(docId, its[i]->lastDocId);
+    }
+
+    RSIndexResult rec = {.data.term_tag = RSResultData_Term, .docId = docId};
+    size_t matched = 0;
+    array_clear(offsets);
+    for (uint32_t i = 0; i < array_len(its);) {
+      QueryIterator *it = its[i];
+      if (it->lastDocId != docId) {
+        i++;
+        continue;
+      }
+      // The result is overwritten by the next read
+      rec.freq += it->current->freq;
+      rec.fieldMask |= it->current->fieldMask;
+      if (storeOffsets) {
+        size_t n = RSIndexResult_DecodeOffsets(it->current, NULL, 0);
+        size_t at = array_len(offsets);
+        offsets = array_grow(offsets, n);
+        RSIndexResult_DecodeOffsets(it->current, offsets + at, n);
+      }
+      matched++;
+      if (it->Read(it) == ITERATOR_OK) {
+        i++;
+      } else {
+        it->Free(it);
+        its = array_del_fast(its, i);
+      }
+    }
+
+    if (storeOffsets) {
+      if (matched > 1) {
+        qsort(offsets, array_len(offsets), sizeof(*offsets), cmpOffsets);
+      }
+      VVW_Reset(vw);
+      for (uint32_t i = 0; i < array_len(offsets); i++) {
+        VVW_Write(vw, offsets[i]);
+      }
+      RSOffsetVector_SetData(IndexResult_TermOffsetsRefMut(&rec), (char *)VVW_GetByteData(vw),
+                             VVW_GetByteLength(vw));
+      offsetVecsSize += VVW_GetByteLength(vw);
+      offsetVecRecords += VVW_GetCount(vw);
+    }
+    memsize += InvertedIndex_WriteEntryGeneric(merged, &rec);
+    numRecords++;
+  }
+  array_free(offsets);
+  VVW_Free(vw);
+  array_free(its);
+
+  // Replace the inverted index of the group id with the merged one. The iterators of the paused
+  // queries over the previous one abort, as they do when the GC frees an inverted index
+  char *groupTerm;
+  size_t len = rm_asprintf(&groupTerm, "%c%s", SYNONYM_PREFIX_CHAR, groupId);
+  bool isNew;
+  Redis_OpenInvertedIndex(sctx, groupTerm, len, 1, &isNew);
+  if (isNew) {
+    IndexSpec_AddTerm(sp, groupTerm, len);
+  }
+  RedisModuleString *termKey = fmtRedisTermKey(sctx, groupTerm, len);
+  KeysDictValue *kdv = dictFetchValue(sp->keysDict, termKey);
+  RedisModule_FreeString(sctx->redisCtx, termKey);
+  IndexSpec_RemoveTermIndexStats(sp, kdv->p);
+  InvertedIndex_Free(kdv->p);
+  kdv->p = merged;
+  sp->stats.invertedSize += memsize;
+  sp->stats.numRecords += numRecords;
+  sp->stats.offsetVecsSize += offsetVecsSize;
+  sp->stats.offsetVecRecords += offsetVecRecords;
+
+  TermIndexCache_Remove(sp->termIndexes, groupTerm, len);
+  PrefixCache_InvalidateTerm(sp->prefixCache, groupTerm, len);
+  sp->revision++;
+  rm_free(groupTerm);
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 static void IndexSpec_InitLock(IndexSpec *sp) {
@@ -2096,6 +2320,7 @@ static void initializeIndexSpec(IndexSpec *sp, const HiddenString *name, IndexFl
   sp->obfuscatedName = IndexSpec_FormatObfuscatedName(name);
   sp->docs = DocTable_New(INITIAL_DOC_TABLE_SIZE);
   sp->suffix = NULL;
+  sp->suffixArray = NULL;
   sp->suffixMask = (t_fieldMask)0;
   sp->keysDict = NULL;
   sp->getValue = NULL;
@@ -2117,6 +2342,15 @@ static void initializeIndexSpec(IndexSpec *sp, const HiddenString *name, IndexFl
   sp->terms = NewTrie(NULL, Trie_Sort_Lex);
 
   IndexSpec_InitLock(sp);
+  sp->prefixCache = NewPrefixCache();
+  sp->termStats = NewTermStatsCache();
+  sp->termIndexes = NewTermIndexCache();
+  sp->impactPostings = NewImpactPostings();
+  sp->knnResults = NewKNNResultCache();
+  sp->searchResults = NewSearchResultCache();
+  sp->queryPlans = NewQueryPlanCache();
+  sp->filterCache = NewFilterCache();
+  sp->snippets = NewSnippetCache();
   // First, initialise fields IndexError for every field
   // In the RDB flow if some fields are not loaded correctly, we will free the spec and attempt to cleanup all the fields.
   for (t_fieldIndex i = 0; i < sp->numFields; i++) {
@@ -2469,7 +2703,10 @@ static IndexesScanner *IndexesScanner_New(StrongRef global_ref) {
   return scanner;
 }
 
+static void IndexesScanner_DropPending(IndexesScanner *scanner);
+
 void IndexesScanner_Free(IndexesScanner *scanner) {
+  IndexesScanner_DropPending(scanner);
   rm_free(scanner->spec_name_for_logs);
   if (global_spec_scanner == scanner) {
     global_spec_scanner = NULL;
@@ -2510,6 +2747,266 @@ static void IndexSpec_DoneIndexingCallabck(struct RSAddDocumentCtx *docCtx, Redi
 //---------------------------------------------------------------------------------------------
 
 int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type);
+static int IndexSpec_LoadDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key,
+                             DocumentType type, t_fieldIndex from, Document *doc);
+
+// The minimal number of documents loaded by a scan step before they are indexed together, for
+// each of the threads preprocessing them
+#define SCAN_BATCH_DOCS 64
+
+// Loads a document for the current scan step. Its fields are preprocessed without the GIL, once
+// the step is over (see `IndexesScanner_PreprocessPending`)
+static void IndexesScanner_LoadDoc(IndexesScanner *scanner, StrongRef spec_ref, RedisModuleCtx *ctx,
+                                   RedisModuleString *key, DocumentType type) {
+  IndexSpec *spec = StrongRef_Get(spec_ref);
+  Document *doc = rm_calloc(1, sizeof(*doc));
+  if (IndexSpec_LoadDoc(spec, ctx, key, type, 0, doc) != REDISMODULE_OK) {
+    rm_free(doc);
+    return;
+  }
+  unsigned int numOps = doc->numFields != 0 ? doc->numFields: 1;
+  IndexerYieldWhileLoading(ctx, numOps, REDISMODULE_YIELD_FLAG_CLIENTS);
+
+  QueryError status = QueryError_Default();
+  RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, doc, &status);
+  QueryError_ClearError(&status);
+  if (!aCtx) {
+    Document_Free(doc);
+    rm_free(doc);
+    return;
+  }
+  aCtx->stateFlags |= ACTX_F_NOFREEDOC;
+  // The strings of the document are copied while we hold the GIL
+  Document_MakeStringsOwner(doc);
+
+  if (!scanner->pending) {
+    scanner->pending = array_new(RSAddDocumentCtx *, 8);
+    scanner->pendingRef = StrongRef_Clone(spec_ref);
+    scanner->pendingEvents = keyspaceEventsCount;
+  }
+  array_append(scanner->pending, aCtx);
+}
+
+// The threads preprocessing the documents of a scan step: the scanner, and the workers if any
+static size_t scanPreprocessThreads(void) {
+  return RSGlobalConfig.numWorkerThreads ? workersThreadPool_NumThreads() + 1 : 1;
+}
+
+static void preprocessDocs(RSAddDocumentCtx **docs, size_t n, RedisSearchCtx *sctx) {
+  for (size_t i = 0; i < n; i++) {
+    AddDocumentCtx_Preprocess(docs[i], sctx);
+  }
+}
+
+typedef enum {
+  PREPROCESS_JOB_PENDING,
+  PREPROCESS_JOB_RUNNING,
+  PREPROCESS_JOB_DONE,
+} PreprocessJobState;
+
+// A share of the documents of a scan step, preprocessed by a worker unless the scanner claims it
+// first. Referenced by the scanner and by the queue of the workers
+typedef struct {
+  RSAddDocumentCtx **docs;
+  size_t n;
+  RedisSearchCtx *sctx;
+  atomic_int state;
+  atomic_int refcount;
+} PreprocessJob;
+
+static pthread_mutex_t preprocessLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t preprocessDone = PTHREAD_COND_INITIALIZER;
+
+static void PreprocessJob_Release(PreprocessJob *job) {
+  if (atomic_fetch_sub(&job->refcount, 1) == 1) {
+    rm_free(job);
+  }
+}
+
+static bool PreprocessJob_Claim(PreprocessJob *job) {
+  int expected = PREPROCESS_JOB_PENDING;
+  return atomic_compare_exchange_strong(&job->state, &expected, PREPROCESS_JOB_RUNNING);
+}
+
+static void PreprocessJob_Run(void *arg) {
+  PreprocessJob *job = arg;
+  if (PreprocessJob_Claim(job)) {
+    preprocessDocs(job->docs, job->n, job->sctx);
+    pthread_mutex_lock(&preprocessLock);
+    atomic_store(&job->state, PREPROCESS_JOB_DONE);
+    pthread_cond_broadcast(&preprocessDone);
+    pthread_mutex_unlock(&preprocessLock);
+  }
+  PreprocessJob_Release(job);
+}
+
+// Preprocesses the documents split into a share for each of `nparts` threads. The scanner takes
+// the first one, and the shares the workers did not start yet once it is done with it, so that a
+// busy or paused pool does not stall the scan
+static void preprocessDocsParallel(RSAddDocumentCtx **docs, size_t n, size_t nparts,
+                                   RedisSearchCtx *sctx) {
+  size_t perPart = (n + nparts - 1) / nparts;
+  PreprocessJob *jobs[nparts];
+  size_t njobs = 0;
+  for (size_t p = 1; p < nparts && p * perPart < n; p++) {
+    PreprocessJob *job = rm_malloc(sizeof(*job));
+    job->docs = docs + p * perPart;
+    job->n = MIN(perPart, n - p * perPart);
+    job->sctx = sctx;
+    atomic_init(&job->state, PREPROCESS_JOB_PENDING);
+    atomic_init(&job->refcount, 2);
+    if (workersThreadPool_AddWork(PreprocessJob_Run, job) != 0) {
+      // Not queued, so run below
+      atomic_store(&job->refcount, 1);
+    }
+    jobs[njobs++] = job;
+  }
+
+  preprocessDocs(docs, perPart, sctx);
+  for (size_t i = 0; i < njobs; i++) {
+    if (PreprocessJob_Claim(jobs[i])) {
+      preprocessDocs(jobs[i]->docs, jobs[i]->n, sctx);
+      atomic_store(&jobs[i]->state, PREPROCESS_JOB_DONE);
+    }
+  }
+
+  pthread_mutex_lock(&preprocessLock);
+  for (size_t i = 0; i < njobs; i++) {
+    while (atomic_load(&jobs[i]->state) != PREPROCESS_JOB_DONE) {
+      pthread_cond_wait(&preprocessDone, &preprocessLock);
+    }
+  }
+  pthread_mutex_unlock(&preprocessLock);
+  for (size_t i = 0; i < njobs; i++) {
+    PreprocessJob_Release(jobs[i]);
+  }
+}
+
+// Preprocesses the pending documents, sharing them with the workers. Called without the GIL
+static void IndexesScanner_PreprocessPending(IndexesScanner *scanner) {
+  if (!scanner->pending) {
+    return;
+  }
+  IndexSpec *spec = StrongRef_Get(scanner->pendingRef);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, spec);
+  rs_wall_clock start;
+  rs_wall_clock_init(&start);
+  // The workers read the spec under the lock held here until they are done
+  RedisSearchCtx_LockSpecRead(&sctx);
+  const size_t n = array_len(scanner->pending);
+  const size_t nparts = MIN(scanPreprocessThreads(), n / SCAN_BATCH_DOCS);
+  if (nparts > 1) {
+    preprocessDocsParallel(scanner->pending, n, nparts, &sctx);
+  } else {
+    preprocessDocs(scanner->pending, n, &sctx);
+  }
+  spec->stats.totalIndexTime += rs_wall_clock_elapsed_ns(&start);
+  RedisSearchCtx_UnlockSpec(&sctx);
+}
+
+static void IndexesScanner_DropPending(IndexesScanner *scanner) {
+  if (!scanner->pending) {
+    return;
+  }
+  for (size_t i = 0; i < array_len(scanner->pending); i++) {
+    Document *doc = scanner->pending[i]->doc;
+    AddDocumentCtx_Free(scanner->pending[i]);
+    Document_Free(doc);
+    rm_free(doc);
+  }
+  array_free(scanner->pending);
+  scanner->pending = NULL;
+  StrongRef_Release(scanner->pendingRef);
+}
+
+// Writes the preprocessed pending documents to their index. Called with the GIL held.
+static void IndexesScanner_ApplyPending(IndexesScanner *scanner, RedisModuleCtx *ctx) {
+  if (!scanner->pending) {
+    return;
+  }
+  IndexSpec *spec = StrongRef_Get(scanner->pendingRef);
+  if (scanner->cancelled) {
+    IndexesScanner_DropPending(scanner);
+    return;
+  }
+  if (scanner->pendingEvents != keyspaceEventsCount) {
+    // Some keys may have changed while the GIL was released, and may already be indexed with
+    // their new content, so the documents are loaded again
+    size_t n = array_len(scanner->pending);
+    RedisModuleString **keys = rm_malloc(n * sizeof(*keys));
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = RedisModule_HoldString(RSDummyContext, scanner->pending[i]->doc->docKey);
+    }
+    StrongRef spec_ref = StrongRef_Clone(scanner->pendingRef);
+    IndexesScanner_DropPending(scanner);
+    for (size_t i = 0; i < n; i++) {
+      DocumentType type = getDocTypeFromString(keys[i]);
+      if (type != DocumentType_Unsupported && SchemaRule_ShouldIndex(spec, keys[i], type)) {
+        IndexSpec_UpdateDoc(spec, ctx, keys[i], type);
+      }
+      RedisModule_FreeString(RSDummyContext, keys[i]);
+    }
+    rm_free(keys);
+    StrongRef_Release(spec_ref);
+    return;
+  }
+
+  rs_wall_clock start;
+  rs_wall_clock_init(&start);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  IndexSpec_IncrActiveWrites(spec);
+  // The documents are written together, so that the entries of each term are appended as one run
+  size_t n = array_len(scanner->pending);
+  Document **docs = rm_malloc(n * sizeof(*docs));
+  for (size_t i = 0; i < n; i++) {
+    docs[i] = scanner->pending[i]->doc;
+  }
+  AddDocumentCtx_SubmitBatch(scanner->pending, n, &sctx, DOCUMENT_ADD_REPLACE);
+  for (size_t i = 0; i < n; i++) {
+    Document_Free(docs[i]);
+    rm_free(docs[i]);
+  }
+  rm_free(docs);
+  spec->stats.totalIndexTime += rs_wall_clock_elapsed_ns(&start);
+  IndexSpec_DecrActiveWrites(spec);
+  RedisSearchCtx_UnlockSpec(&sctx);
+
+  array_free(scanner->pending);
+  scanner->pending = NULL;
+  StrongRef_Release(scanner->pendingRef);
+}
+
+static void IndexSpec_RepackGeometry(IndexSpec *spec, RedisModuleCtx *ctx) {
+  if (!(spec->flags & Index_HasGeometry)) {
+    return;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  GeometryIndex_Repack(spec, true);
+  RedisSearchCtx_UnlockSpec(&sctx);
+}
+
+// Packs the R-trees the scan inserted the geometries into one by one. Called with the GIL held.
+static void IndexesScanner_RepackGeometry(IndexesScanner *scanner, RedisModuleCtx *ctx) {
+  if (!scanner->global) {
+    StrongRef spec_ref = WeakRef_Promote(scanner->spec_ref);
+    IndexSpec *spec = StrongRef_Get(spec_ref);
+    if (spec) {
+      IndexSpec_RepackGeometry(spec, ctx);
+      StrongRef_Release(spec_ref);
+    }
+    return;
+  }
+  dictIterator *iter = dictGetIterator(specDict_g);
+  dictEntry *entry = NULL;
+  while ((entry = dictNext(iter))) {
+    StrongRef spec_ref = dictGetRef(entry);
+    IndexSpec_RepackGeometry(StrongRef_Get(spec_ref), ctx);
+  }
+  dictReleaseIterator(iter);
+}
+
 static void Indexes_ScanProc(RedisModuleCtx *ctx, RedisModuleString *keyname, RedisModuleKey *key,
                              IndexesScanner *scanner) {
 
@@ -2553,8 +3050,13 @@ static void Indexes_ScanProc(RedisModuleCtx *ctx, RedisModuleString *keyname, Re
     if (sp) {
       // This check is performed without locking the spec, but it's ok since we locked the GIL
       // So the main thread is not running and the GC is not touching the relevant data
-      if (SchemaRule_ShouldIndex(sp, keyname, type)) {
+      if (!SchemaRule_ShouldIndex(sp, keyname, type)) {
+        // Not indexed
+      } else if (scanner->isDebug) {
+        // The debug scanner checks the indexed documents at given points of the scan
         IndexSpec_UpdateDoc(sp, ctx, keyname, type);
+      } else {
+        IndexesScanner_LoadDoc(scanner, curr_run_ref, ctx, keyname, type);
       }
       IndexSpecRef_Release(curr_run_ref);
     } else {
@@ -2592,6 +3094,8 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
   }
 
   size_t counter = 0;
+  // Large enough to give each of the threads a share of every step
+  const size_t batchDocs = SCAN_BATCH_DOCS * scanPreprocessThreads();
   RedisModuleScanCB scanner_func = (RedisModuleScanCB)Indexes_ScanProc;
   if (globalDebugCtx.debugMode) {
     // If we are in debug mode, we need to use the debug scanner function
@@ -2607,7 +3111,13 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
   }
 
   while (RedisModule_Scan(ctx, cursor, scanner_func, scanner)) {
+    if (scanner->pending && array_len(scanner->pending) < batchDocs &&
+        !scanner->cancelled && !scanner->scanFailedOnOOM) {
+      // Scan on until the batch of documents is large enough to share the runs of its terms
+      continue;
+    }
     RedisModule_ThreadSafeContextUnlock(ctx);
+    IndexesScanner_PreprocessPending(scanner);
     counter++;
     if (counter % RSGlobalConfig.numBGIndexingIterationsBeforeSleep == 0) {
       // Sleep for one microsecond to allow redis server to acquire the GIL while we release it.
@@ -2620,6 +3130,7 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
       sched_yield();
     }
     RedisModule_ThreadSafeContextLock(ctx);
+    IndexesScanner_ApplyPending(scanner, ctx);
 
     // Check if we need to handle OOM but must check if the scanner was cancelled for other reasons (i.e. FT. ALTER)
     if (scanner->scanFailedOnOOM && !scanner->cancelled) {
@@ -2657,6 +3168,15 @@ static void Indexes_ScanAndReindexTask(IndexesScanner *scanner) {
     }
   }
 
+  // The last step of the scan may have loaded documents as well
+  if (scanner->pending) {
+    RedisModule_ThreadSafeContextUnlock(ctx);
+    IndexesScanner_PreprocessPending(scanner);
+    RedisModule_ThreadSafeContextLock(ctx);
+    IndexesScanner_ApplyPending(scanner, ctx);
+  }
+  IndexesScanner_RepackGeometry(scanner, ctx);
+
   if (scanner->isDebug) {
     DebugIndexesScanner* dScanner = (DebugIndexesScanner*)scanner;
     dScanner->status = DEBUG_INDEX_SCANNER_CODE_DONE;
@@ -2682,17 +3202,147 @@ end:
   RedisModule_FreeThreadSafeContext(ctx);
 }
 
-//---------------------------------------------------------------------------------------------
+// The number of documents whose new fields are indexed in each step of a fields-only scan
+#define FIELDS_SCAN_STEP_DOCS 100
 
-static void IndexSpec_ScanAndReindexAsync(StrongRef spec_ref) {
+// Indexes the new fields of the next documents of the index, by ascending ids. Called with the GIL
+// held. Returns false once there are no more documents to visit, or the scan must stop.
+static bool IndexesScanner_IndexFieldsStep(IndexesScanner *scanner, RedisModuleCtx *ctx) {
+  StrongRef spec_ref = IndexSpecRef_Promote(scanner->spec_ref);
+  IndexSpec *sp = StrongRef_Get(spec_ref);
+  if (!sp) {
+    // spec was deleted, cancel scan
+    scanner->cancelled = true;
+    return false;
+  }
+
+  // The fields are loaded before the spec is locked, as a document which fails to load is deleted
+  // from the index
+  Document docs[FIELDS_SCAN_STEP_DOCS];
+  t_docId ids[FIELDS_SCAN_STEP_DOCS];
+  size_t n = 0;
+  bool more = true;
+  while (n < FIELDS_SCAN_STEP_DOCS) {
+    t_docId docId = DocTable_NextId(&sp->docs, scanner->nextDocId);
+    if (!docId) {
+      more = false;
+      break;
+    }
+    const RSDocumentMetadata *dmd = DocTable_Lookup(&sp->docs, docId);
+    RedisModuleString *key = DMD_CreateKeyString(dmd, ctx);
+    if (isBgIndexingMemoryOverLimit(ctx)) {
+      scanner->scanFailedOnOOM = true;
+      scanner->OOMkey = key;
+      more = false;
+      break;
+    }
+    scanner->nextDocId = docId + 1;
+    ++scanner->scannedKeys;
+    docs[n] = (Document){0};
+    if (IndexSpec_LoadDoc(sp, ctx, key, sp->rule->type, scanner->firstField, &docs[n]) == REDISMODULE_OK) {
+      ids[n++] = docId;
+    }
+    RedisModule_FreeString(ctx, key);
+  }
+
+  rs_wall_clock start;
+  rs_wall_clock_init(&start);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, sp);
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  IndexSpec_IncrActiveWrites(sp);
+  for (size_t i = 0; i < n; i++) {
+    QueryError status = QueryError_Default();
+    // The document may have been deleted while the next ones were loaded
+    RSAddDocumentCtx *aCtx =
+        DocTable_Lookup(&sp->docs, ids[i]) ? NewAddDocumentCtx(sp, &docs[i], &status) : NULL;
+    QueryError_ClearError(&status);
+    if (aCtx) {
+      aCtx->stateFlags |= ACTX_F_NOFREEDOC;
+      Document_AddFieldsToIndexes(aCtx, &sctx, ids[i]);
+    } else {
+      array_free(docs[i].fieldExpirations);
+    }
+    Document_Free(&docs[i]);
+  }
+  sp->stats.totalIndexTime += rs_wall_clock_elapsed_ns(&start);
+  IndexSpec_DecrActiveWrites(sp);
+  RedisSearchCtx_UnlockSpec(&sctx);
+  IndexSpecRef_Release(spec_ref);
+  return more;
+}
+
+static void Indexes_IndexFieldsTask(IndexesScanner *scanner) {
+  RedisModuleCtx *ctx = RedisModule_GetDetachedThreadSafeContext(RSDummyContext);
+  RedisModule_ThreadSafeContextLock(ctx);
+  RedisModule_Log(ctx, "notice", "Indexing new fields of index %s in background",
+                  scanner->spec_name_for_logs);
+
+  size_t counter = 0;
+  while (!scanner->cancelled && IndexesScanner_IndexFieldsStep(scanner, ctx)) {
+    RedisModule_ThreadSafeContextUnlock(ctx);
+    // See `Indexes_ScanAndReindexTask`
+    if (++counter % RSGlobalConfig.numBGIndexingIterationsBeforeSleep == 0) {
+      usleep(1);
+    } else {
+      sched_yield();
+    }
+    RedisModule_ThreadSafeContextLock(ctx);
+  }
+
+  if (scanner->scanFailedOnOOM && !scanner->cancelled) {
+    scanStopAfterOOM(ctx, scanner);
+  } else if (scanner->cancelled) {
+    RedisModule_Log(ctx, "notice", "Indexing new fields of index %s in background: cancelled (scanned=%ld)",
+                    scanner->spec_name_for_logs, scanner->scannedKeys);
+  } else {
+    RedisModule_Log(ctx, "notice", "Indexing new fields of index %s in background: done (scanned=%ld)",
+                    scanner->spec_name_for_logs, scanner->scannedKeys);
+  }
+  IndexesScanner_Free(scanner);
+
+  RedisModule_ThreadSafeContextUnlock(ctx);
+  RedisModule_FreeThreadSafeContext(ctx);
+}
+
+// Whether the fields from `firstField` on can be indexed for the documents of the index without
+// re-indexing them. They are written by ascending ids, which the indexes of text fields cannot
+// take while other documents are indexed, and the sortable and missing values are written with the
+// whole document.
+static bool IndexSpec_CanIndexFields(const IndexSpec *sp, t_fieldIndex firstField) {
+  // A scan which is in progress still has to index the documents with all their fields
+  if (sp->scan_in_progress || global_spec_scanner || sp->scan_failed_OOM || isSpecOnDisk(sp) ||
+      globalDebugCtx.debugMode) {
+    return false;
+  }
+  const FieldType supported =
+      INDEXFLD_T_NUMERIC | INDEXFLD_T_TAG | INDEXFLD_T_GEO | INDEXFLD_T_VECTOR | INDEXFLD_T_GEOMETRY;
+  for (t_fieldIndex i = firstField; i < sp->numFields; i++) {
+    const FieldSpec *fs = sp->fields + i;
+    if ((fs->types & ~supported) || FieldSpec_IsSortable(fs) || FieldSpec_IndexesMissing(fs)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void ReindexPool_Init() {
   if (!reindexPool) {
     reindexPool = redisearch_thpool_create(1, DEFAULT_HIGH_PRIORITY_BIAS_THRESHOLD, LogCallback, "reindex");
   }
-#ifdef _DEBUG
-  IndexSpec* spec = (IndexSpec*)StrongRef_Get(spec_ref);
-  const char* indexName = IndexSpec_FormatName(spec, RSGlobalConfig.hideUserDataFromLog);
-  RedisModule_Log(RSDummyContext, "notice", "Register index %s for async scan", indexName);
-#endif
+}
+
+static void IndexSpec_IndexFieldsAsync(StrongRef spec_ref, t_fieldIndex firstField) {
+  ReindexPool_Init();
+  IndexesScanner *scanner = IndexesScanner_New(spec_ref);
+  scanner->fieldsOnly = true;
+  scanner->firstField = firstField;
+  scanner->nextDocId = 1;
+  redisearch_thpool_add_work(reindexPool, (redisearch_thpool_proc)Indexes_IndexFieldsTask, scanner, THPOOL_PRIORITY_HIGH);
+}
+
+//---------------------------------------------------------------------------------------------
+
+static IndexesScanner *IndexesScanner_NewForReindex(StrongRef spec_ref) {
   IndexesScanner *scanner;
   if (globalDebugCtx.debugMode) {
     // If we are in debug mode, we need to allocate a debug scanner
@@ -2704,6 +3354,17 @@ static void IndexSpec_ScanAndReindexAsync(StrongRef spec_ref) {
   } else {
     scanner = IndexesScanner_New(spec_ref);
   }
+  return scanner;
+}
+
+static void IndexSpec_ScanAndReindexAsync(StrongRef spec_ref) {
+  ReindexPool_Init();
+#ifdef _DEBUG
+  IndexSpec* spec = (IndexSpec*)StrongRef_Get(spec_ref);
+  const char* indexName = IndexSpec_FormatName(spec, RSGlobalConfig.hideUserDataFromLog);
+  RedisModule_Log(RSDummyContext, "notice", "Register index %s for async scan", indexName);
+#endif
+  IndexesScanner *scanner = IndexesScanner_NewForReindex(spec_ref);
 
   redisearch_thpool_add_work(reindexPool, (redisearch_thpool_proc)Indexes_ScanAndReindexTask, scanner, THPOOL_PRIORITY_HIGH);
 }
@@ -2797,6 +3458,8 @@ void IndexSpec_AddToInfo(RedisModuleInfoCtx *ctx, IndexSpec *sp) {
     }
     if (FieldSpec_IsSortable(fs))
       RedisModule_InfoAddFieldCString(ctx, SPEC_SORTABLE_STR, "ON");
+    if (FieldSpec_IsStored(fs))
+      RedisModule_InfoAddFieldCString(ctx, SPEC_STORED_STR, "ON");
     if (FieldSpec_IsNoStem(fs))
       RedisModule_InfoAddFieldCString(ctx, SPEC_NOSTEM_STR, "ON");
     if (!FieldSpec_IsIndexable(fs))
@@ -2820,7 +3483,7 @@ void IndexSpec_AddToInfo(RedisModuleInfoCtx *ctx, IndexSpec *sp) {
   RedisModule_InfoAddFieldDouble(ctx, "offset_vectors_size", sp->stats.offsetVecsSize / (float)0x100000);
   RedisModule_InfoAddFieldDouble(ctx, "doc_table_size", sp->docs.memsize / (float)0x100000);
   RedisModule_InfoAddFieldDouble(ctx, "sortable_values_size", sp->docs.sortablesSize / (float)0x100000);
-  RedisModule_InfoAddFieldDouble(ctx, "key_table_size", TrieMap_MemUsage(sp->docs.dim.tm) / (float)0x100000);
+  RedisModule_InfoAddFieldDouble(ctx, "key_table_size", DocIdMap_MemUsage(&sp->docs.dim) / (float)0x100000);
   RedisModule_InfoAddFieldDouble("tag_overhead_size_mb", IndexSpec_collect_tags_overhead(sp) / (float)0x100000);
   RedisModule_InfoAddFieldDouble("text_overhead_size_mb", IndexSpec_collect_text_overhead(sp) / (float)0x100000);
   RedisModule_InfoAddFieldDouble("total_index_memory_sz_mb", IndexSpec_TotalMemUsage(sp) / (float)0x100000);
@@ -2837,10 +3500,12 @@ void IndexSpec_AddToInfo(RedisModuleInfoCtx *ctx, IndexSpec *sp) {
 
   RedisModule_InfoBeginDictField(ctx, "index_failures");
   RedisModule_InfoAddFieldLongLong(ctx, "hash_indexing_failures", sp->stats.indexingFailures);
-  RedisModule_InfoAddFieldLongLong(ctx, "indexing", !!global_spec_scanner || sp->scan_in_progress);
+  RedisModule_InfoAddFieldLongLong(ctx, "indexing", !!global_spec_scanner || sp->scan_in_progress ||
+                                                    sp->activation == IndexActivation_Queued);
   IndexesScanner *scanner = global_spec_scanner ? global_spec_scanner : sp->scanner;
   double percent_indexed = IndexesScanner_IndexedPercent(ctx, scanner, sp);
   RedisModule_InfoAddFieldDouble(ctx, "percent_indexed", percent_indexed);
+  RedisModule_InfoAddFieldLongLong(ctx, "cold", IndexSpec_IsCold(sp));
   RedisModule_InfoEndDictField(ctx);
 
   // Garbage collector
@@ -2864,6 +3529,65 @@ void IndexSpec_ScanAndReindex(RedisModuleCtx *ctx, StrongRef spec_ref) {
   }
 }
 
+// Builds a cold index, on the thread of the reindex pool so that the indexes are built one at a time
+static void IndexSpec_ActivateTask(void *arg) {
+  WeakRef spec_ref = {arg};
+  RedisModuleCtx *ctx = RedisModule_GetDetachedThreadSafeContext(RSDummyContext);
+  RedisModule_ThreadSafeContextLock(ctx);
+  StrongRef strong = WeakRef_Promote(spec_ref);
+  IndexSpec *sp = StrongRef_Get(strong);
+  IndexesScanner *scanner = NULL;
+  if (sp) {
+    // The scanner is set before the index is active, so that it never looks done before it is
+    if (RedisModule_DbSize(ctx) > 0) {
+      scanner = IndexesScanner_NewForReindex(strong);
+    }
+    __atomic_store_n(&sp->activation, IndexActivation_Active, __ATOMIC_RELEASE);
+  }
+  StrongRef_Release(strong);
+  RedisModule_ThreadSafeContextUnlock(ctx);
+  RedisModule_FreeThreadSafeContext(ctx);
+  WeakRef_Release(spec_ref);
+
+  if (scanner) {
+    Indexes_ScanAndReindexTask(scanner);
+  }
+}
+
+static void IndexSpec_QueueActivation(IndexSpec *sp, thpool_priority priority) {
+  uint8_t cold = IndexActivation_Cold;
+  if (__atomic_compare_exchange_n(&sp->activation, &cold, IndexActivation_Queued, false,
+                                  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    WeakRef spec_ref = StrongRef_Demote(sp->own_ref);
+    redisearch_thpool_add_work(reindexPool, IndexSpec_ActivateTask, spec_ref.rm, priority);
+  }
+}
+
+void IndexSpec_Activate(IndexSpec *sp) {
+  if (__atomic_load_n(&sp->activation, __ATOMIC_ACQUIRE) == IndexActivation_Cold) {
+    IndexSpec_QueueActivation(sp, THPOOL_PRIORITY_HIGH);
+  }
+}
+
+// Queue the building of the cold indexes of _HOT_INDEXES, in their order. Called on the main thread
+static void Indexes_ActivateHotIndexes() {
+  if (!RSGlobalConfig.hotIndexes) {
+    return;
+  }
+  char *list = rm_strdup(RSGlobalConfig.hotIndexes);
+  char *saveptr = NULL;
+  for (char *name = strtok_r(list, ", ", &saveptr); name; name = strtok_r(NULL, ", ", &saveptr)) {
+    IndexLoadOptions loadOpts = {
+        .nameC = name,
+        .flags = INDEXSPEC_LOAD_NOCOUNTERINC | INDEXSPEC_LOAD_NOTIMERUPDATE};
+    IndexSpec *sp = StrongRef_Get(IndexSpec_LoadUnsafeEx(&loadOpts));
+    if (sp) {
+      IndexSpec_QueueActivation(sp, THPOOL_PRIORITY_LOW);
+    }
+  }
+  rm_free(list);
+}
+
 // only used on "RDB load finished" event (before the server is ready to accept commands)
 // so it threadsafe
 void IndexSpec_DropLegacyIndexFromKeySpace(IndexSpec *sp) {
@@ -3009,12 +3733,11 @@ IndexSpec *IndexSpec_RdbLoad(RedisModuleIO *rdb, int encver, QueryError *status)
     if (FieldSpec_HasSuffixTrie(fs) && FIELD_IS(fs, INDEXFLD_T_FULLTEXT)) {
       sp->flags |= Index_HasSuffixTrie;
       sp->suffixMask |= FIELD_BIT(fs);
-      if (!sp->suffix) {
-        sp->suffix = NewTrie(suffixTrie_freeCallback, Trie_Sort_Lex);
-      }
+      IndexSpec_InitSuffixIndex(sp);
     }
   }
   // After loading all the fields, we can build the spec cache
+  JSONPath_GroupFields(sp->fields, sp->numFields);
   sp->spcache = IndexSpec_BuildSpecCache(sp);
 
   if (SchemaRule_RdbLoad(spec_ref, rdb, encver, status) != REDISMODULE_OK) {
@@ -3067,6 +3790,283 @@ cleanup_no_index:
   return NULL;
 }
 
+// The contents of an index are only saved when they are all it holds: its documents are hashes,
+// indexed in RAM by fields whose indexes can be saved as they are, and none of them is pending
+static bool IndexSpec_CanPersistContents(const IndexSpec *sp) {
+  if (!RSGlobalConfig.persistIndexes || !sp->rule || sp->rule->type != DocumentType_Hash ||
+      sp->diskSpec || sp->coldTerms || sp->scan_in_progress || sp->docs.ttl) {
+    return false;
+  }
+  // The suffixes of the terms are added again by the fields of their inverted indexes
+  if (sp->suffixMask && !(sp->flags & Index_StoreFieldFlags)) {
+    return false;
+  }
+  for (int i = 0; i < sp->numFields; i++) {
+    if (FIELD_IS(sp->fields + i, INDEXFLD_T_VECTOR | INDEXFLD_T_GEOMETRY)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void IndexStats_RdbSave(RedisModuleIO *rdb, const IndexStats *stats) {
+  RedisModule_SaveUnsigned(rdb, stats->numDocuments);
+  RedisModule_SaveUnsigned(rdb, stats->numTerms);
+  RedisModule_SaveUnsigned(rdb, stats->numRecords);
+  RedisModule_SaveUnsigned(rdb, stats->invertedSize);
+  RedisModule_SaveUnsigned(rdb, stats->offsetVecsSize);
+  RedisModule_SaveUnsigned(rdb, stats->offsetVecRecords);
+  RedisModule_SaveUnsigned(rdb, stats->termsSize);
+  RedisModule_SaveUnsigned(rdb, stats->totalDocsLen);
+}
+
+static int IndexStats_RdbLoad(RedisModuleIO *rdb, IndexStats *stats) {
+  stats->numDocuments = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  stats->numTerms = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  stats->numRecords = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  stats->invertedSize = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  stats->offsetVecsSize = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  stats->offsetVecRecords = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  stats->termsSize = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  stats->totalDocsLen = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  return REDISMODULE_OK;
+}
+
+// An inverted index that may be missing, behind a flag
+static void saveOptionalIndex(RedisModuleIO *rdb, const InvertedIndex *idx) {
+  RedisModule_SaveUnsigned(rdb, idx != NULL);
+  if (idx) {
+    InvertedIndex_RdbSave(rdb, idx);
+  }
+}
+
+static int loadOptionalIndex(RedisModuleIO *rdb, InvertedIndex **idx) {
+  *idx = NULL;
+  if (!LoadUnsigned_IOError(rdb, return REDISMODULE_ERR)) {
+    return REDISMODULE_OK;
+  }
+  // The memory of the indexes is restored with the statistics of the spec
+  size_t memsize;
+  *idx = InvertedIndex_RdbLoad(rdb, &memsize);
+  return *idx ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
+static void addKeysDictValue(IndexSpec *sp, RedisModuleString *key, void *p,
+                             void (*dtor)(void *)) {
+  KeysDictValue *kdv = rm_calloc(1, sizeof(*kdv));
+  kdv->dtor = dtor;
+  kdv->p = p;
+  dictAdd(sp->keysDict, key, kdv);
+}
+
+static void saveTermIndex(RedisModuleIO *rdb, IndexSpec *sp, const char *term, size_t len) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(RSDummyContext, sp);
+  saveOptionalIndex(rdb, Redis_OpenInvertedIndex(&sctx, term, len, DONT_CREATE_INDEX, NULL));
+}
+
+static int loadTermIndex(RedisModuleIO *rdb, IndexSpec *sp, const char *term, size_t len) {
+  InvertedIndex *idx;
+  if (loadOptionalIndex(rdb, &idx) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  if (!idx) {
+    return REDISMODULE_OK;
+  }
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(RSDummyContext, sp);
+  RedisModuleString *termKey = fmtRedisTermKey(&sctx, term, len);
+  addKeysDictValue(sp, termKey, idx, (void (*)(void *))InvertedIndex_Free);
+  RedisModule_FreeString(RSDummyContext, termKey);
+
+  // As the indexer adds them, for the terms of the fields with suffixes
+  if ((sp->suffixMask & InvertedIndex_FieldMask(idx)) && len && term[0] != STEM_PREFIX &&
+      term[0] != PHONETIC_PREFIX && term[0] != SYNONYM_PREFIX_CHAR) {
+    if (sp->suffixArray) {
+      SuffixArray_Add(sp->suffixArray, term, len);
+    } else {
+      addSuffixTrie(sp->suffix, term, len);
+    }
+  }
+  return REDISMODULE_OK;
+}
+
+// The terms of the trie, with their scores and inverted indexes
+static void saveTerms(RedisModuleIO *rdb, IndexSpec *sp) {
+  rune *rstr;
+  t_len slen;
+  float score;
+  int dist;
+  size_t numTerms = 0;
+  TrieIterator *it = Trie_Iterate(sp->terms, "", 0, 0, 1);
+  while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+    numTerms++;
+  }
+  TrieIterator_Free(it);
+
+  RedisModule_SaveUnsigned(rdb, numTerms);
+  it = Trie_Iterate(sp->terms, "", 0, 0, 1);
+  while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+    size_t termLen;
+    char *term = runesToStr(rstr, slen, &termLen);
+    RedisModule_SaveStringBuffer(rdb, term, termLen);
+    RedisModule_SaveFloat(rdb, score);
+    saveTermIndex(rdb, sp, term, termLen);
+    rm_free(term);
+  }
+  TrieIterator_Free(it);
+  // The empty term is indexed, but not added to the trie
+  saveTermIndex(rdb, sp, "", 0);
+}
+
+static int loadTerms(RedisModuleIO *rdb, IndexSpec *sp) {
+  const size_t numTerms = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  for (size_t i = 0; i < numTerms; i++) {
+    size_t len;
+    char *term = LoadStringBuffer_IOError(rdb, &len, return REDISMODULE_ERR);
+    const float score = RedisModule_LoadFloat(rdb);
+    Trie_InsertStringBuffer(sp->terms, term, len, score, 0, NULL);
+    int rc = loadTermIndex(rdb, sp, term, len);
+    RedisModule_Free(term);
+    if (rc != REDISMODULE_OK) {
+      return REDISMODULE_ERR;
+    }
+  }
+  return loadTermIndex(rdb, sp, "", 0);
+}
+
+static void saveNumericTree(RedisModuleIO *rdb, IndexSpec *sp, const FieldSpec *fs, FieldType type) {
+  RedisModuleString *key = IndexSpec_GetFormattedKey(sp, fs, type);
+  NumericRangeTree *t = key ? openNumericKeysDict(sp, key, DONT_CREATE_INDEX) : NULL;
+  RedisModule_SaveUnsigned(rdb, t != NULL);
+  if (t) {
+    NumericRangeTree_RdbSave(rdb, t);
+  }
+}
+
+static int loadNumericTree(RedisModuleIO *rdb, IndexSpec *sp, const FieldSpec *fs, FieldType type) {
+  if (!LoadUnsigned_IOError(rdb, return REDISMODULE_ERR)) {
+    return REDISMODULE_OK;
+  }
+  NumericRangeTree *t = NumericRangeTree_RdbLoad(rdb);
+  if (!t) {
+    return REDISMODULE_ERR;
+  }
+  RedisModuleString *key = IndexSpec_GetFormattedKey(sp, fs, type);
+  addKeysDictValue(sp, key, t, (void (*)(void *))NumericRangeTree_Free);
+  return REDISMODULE_OK;
+}
+
+static void saveTagIndex(RedisModuleIO *rdb, IndexSpec *sp, const FieldSpec *fs) {
+  RedisModuleString *key = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_TAG);
+  TagIndex *idx = key ? TagIndex_Open(sp, key, DONT_CREATE_INDEX) : NULL;
+  RedisModule_SaveUnsigned(rdb, idx != NULL);
+  if (idx) {
+    TagIndex_RdbSave(rdb, idx);
+  }
+}
+
+static int loadTagIndex(RedisModuleIO *rdb, IndexSpec *sp, const FieldSpec *fs) {
+  if (!LoadUnsigned_IOError(rdb, return REDISMODULE_ERR)) {
+    return REDISMODULE_OK;
+  }
+  RedisModuleString *key = IndexSpec_GetFormattedKey(sp, fs, INDEXFLD_T_TAG);
+  TagIndex *idx = TagIndex_Open(sp, key, CREATE_INDEX);
+  if (FieldSpec_HasSuffixTrie(fs) && !idx->suffix) {
+    idx->suffix = NewTrieMap();
+  }
+  size_t memsize;
+  return TagIndex_RdbLoad(rdb, idx, &memsize);
+}
+
+// Save what the index holds after its definition, so that loading it does not index its
+// documents again
+static void IndexSpec_RdbSaveContents(RedisModuleIO *rdb, IndexSpec *sp) {
+  IndexStats_RdbSave(rdb, &sp->stats);
+  DocTable_RdbSave(&sp->docs, rdb);
+  saveTerms(rdb, sp);
+  for (int i = 0; i < sp->numFields; i++) {
+    const FieldSpec *fs = sp->fields + i;
+    if (FIELD_IS(fs, INDEXFLD_T_NUMERIC)) {
+      saveNumericTree(rdb, sp, fs, INDEXFLD_T_NUMERIC);
+    }
+    if (FIELD_IS(fs, INDEXFLD_T_GEO)) {
+      saveNumericTree(rdb, sp, fs, INDEXFLD_T_GEO);
+    }
+    if (FIELD_IS(fs, INDEXFLD_T_TAG)) {
+      saveTagIndex(rdb, sp, fs);
+    }
+    saveOptionalIndex(rdb, dictFetchValue(sp->missingFieldDict, fs->fieldName));
+  }
+  saveOptionalIndex(rdb, sp->existingDocs);
+}
+
+// Drop the contents loaded along with the index, which is left as its definition creates it, so that
+// its documents are indexed again as their keys are loaded
+static void IndexSpec_DropLoadedContents(IndexSpec *sp) {
+  IndexStats *stats = &sp->stats;
+  stats->numDocuments = stats->numTerms = stats->numRecords = stats->invertedSize = 0;
+  stats->offsetVecsSize = stats->offsetVecRecords = stats->termsSize = stats->totalDocsLen = 0;
+  DocTable_Free(&sp->docs);
+  sp->docs = DocTable_New(INITIAL_DOC_TABLE_SIZE);
+  TrieType_Free(sp->terms);
+  sp->terms = NewTrie(NULL, Trie_Sort_Lex);
+  SpellDeleteIndex_Free(sp->spellDeletes);
+  sp->spellDeletes = NULL;
+  if (sp->suffix) {
+    TrieType_Free(sp->suffix);
+    sp->suffix = NewTrie(suffixTrie_freeCallback, Trie_Sort_Lex);
+  }
+  if (sp->suffixArray) {
+    SuffixArray_Free(sp->suffixArray);
+    sp->suffixArray = NewSuffixArray();
+  }
+  dictEmpty(sp->keysDict, NULL);
+  dictEmpty(sp->missingFieldDict, NULL);
+  if (sp->existingDocs) {
+    InvertedIndex_Free(sp->existingDocs);
+    sp->existingDocs = NULL;
+  }
+}
+
+static int IndexSpec_RdbLoadContents(RedisModuleIO *rdb, IndexSpec *sp) {
+  const size_t missing = IndexSegment_NumMissing();
+  if (IndexStats_RdbLoad(rdb, &sp->stats) != REDISMODULE_OK ||
+      DocTable_RdbLoad(&sp->docs, rdb) != REDISMODULE_OK ||
+      loadTerms(rdb, sp) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  for (int i = 0; i < sp->numFields; i++) {
+    const FieldSpec *fs = sp->fields + i;
+    if (FIELD_IS(fs, INDEXFLD_T_NUMERIC) &&
+        loadNumericTree(rdb, sp, fs, INDEXFLD_T_NUMERIC) != REDISMODULE_OK) {
+      return REDISMODULE_ERR;
+    }
+    if (FIELD_IS(fs, INDEXFLD_T_GEO) &&
+        loadNumericTree(rdb, sp, fs, INDEXFLD_T_GEO) != REDISMODULE_OK) {
+      return REDISMODULE_ERR;
+    }
+    if (FIELD_IS(fs, INDEXFLD_T_TAG) && loadTagIndex(rdb, sp, fs) != REDISMODULE_OK) {
+      return REDISMODULE_ERR;
+    }
+    InvertedIndex *missing;
+    if (loadOptionalIndex(rdb, &missing) != REDISMODULE_OK) {
+      return REDISMODULE_ERR;
+    }
+    if (missing) {
+      dictAdd(sp->missingFieldDict, (void *)fs->fieldName, missing);
+    }
+  }
+  if (loadOptionalIndex(rdb, &sp->existingDocs) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+  if (IndexSegment_NumMissing() != missing) {
+    // Some of its blocks are in a segment which could not be mapped
+    IndexSpec_DropLoadedContents(sp);
+    return REDISMODULE_OK;
+  }
+  sp->contentsLoaded = true;
+  return REDISMODULE_OK;
+}
+
 static int IndexSpec_StoreAfterRdbLoad(IndexSpec *sp) {
 
   if (!sp) {
@@ -3108,7 +4108,24 @@ static int IndexSpec_StoreAfterRdbLoad(IndexSpec *sp) {
 static int IndexSpec_CreateFromRdb(RedisModuleIO *rdb, int encver, QueryError *status) {
   // Load the index spec using the new function
   IndexSpec *sp = IndexSpec_RdbLoad(rdb, encver, status);
+  if (sp && encver >= INDEX_CONTENTS_VERSION) {
+    // Loaded even into a duplicate, as they must be consumed
+    const uint64_t hasContents = LoadUnsigned_IOError(rdb, goto contents_error);
+    if (hasContents && IndexSpec_RdbLoadContents(rdb, sp) != REDISMODULE_OK) {
+      goto contents_error;
+    }
+  }
+  if (sp && RSGlobalConfig.lazyIndexLoading && !sp->contentsLoaded) {
+    // Its documents are indexed by a scan once it is used, rather than as their keys are loaded
+    sp->activation = IndexActivation_Cold;
+    ReindexPool_Init();
+  }
   return IndexSpec_StoreAfterRdbLoad(sp);
+
+contents_error:
+  QueryError_SetError(status, QUERY_ERROR_CODE_PARSE_ARGS, "while reading the contents of an index");
+  StrongRef_Release(sp->own_ref);
+  return REDISMODULE_ERR;
 }
 
 void *IndexSpec_LegacyRdbLoad(RedisModuleIO *rdb, int encver) {
@@ -3120,6 +4137,15 @@ void *IndexSpec_LegacyRdbLoad(RedisModuleIO *rdb, int encver) {
   RedisModuleCtx *ctx = RedisModule_GetContextFromIO(rdb);
   IndexSpec *sp = rm_calloc(1, sizeof(IndexSpec));
   IndexSpec_InitLock(sp);
+  sp->prefixCache = NewPrefixCache();
+  sp->termStats = NewTermStatsCache();
+  sp->termIndexes = NewTermIndexCache();
+  sp->impactPostings = NewImpactPostings();
+  sp->knnResults = NewKNNResultCache();
+  sp->searchResults = NewSearchResultCache();
+  sp->queryPlans = NewQueryPlanCache();
+  sp->filterCache = NewFilterCache();
+  sp->snippets = NewSnippetCache();
   StrongRef spec_ref = StrongRef_New(sp, (RefManager_Free)IndexSpec_Free);
   sp->own_ref = spec_ref;
 
@@ -3148,6 +4174,7 @@ void *IndexSpec_LegacyRdbLoad(RedisModuleIO *rdb, int encver) {
     }
   }
   // After loading all the fields, we can build the spec cache
+  JSONPath_GroupFields(sp->fields, sp->numFields);
   sp->spcache = IndexSpec_BuildSpecCache(sp);
 
   IndexStats_RdbLoad(rdb, &sp->stats);
@@ -3242,14 +4269,19 @@ int Indexes_RdbLoad(RedisModuleIO *rdb, int encver, int when) {
   }
 
   size_t nIndexes = LoadUnsigned_IOError(rdb, goto cleanup);
+  if (encver >= INDEX_SEGMENTS_VERSION && IndexSegment_RdbLoadBegin(rdb) != REDISMODULE_OK) {
+    goto cleanup;
+  }
   QueryError status = QueryError_Default();
   for (size_t i = 0; i < nIndexes; ++i) {
     if (IndexSpec_CreateFromRdb(rdb, encver, &status) != REDISMODULE_OK) {
       RedisModule_LogIOError(rdb, "warning", "RDB Load: %s", QueryError_GetDisplayableError(&status, RSGlobalConfig.hideUserDataFromLog));
       QueryError_ClearError(&status);
+      IndexSegment_EndRead();
       return REDISMODULE_ERR;
     }
   }
+  IndexSegment_EndRead();
 
   // If we have indexes in the auxiliary data, we need to subscribe to the
   // keyspace notifications
@@ -3264,6 +4296,7 @@ cleanup:
 void Indexes_RdbSave(RedisModuleIO *rdb, int when) {
 
   RedisModule_SaveUnsigned(rdb, dictSize(specDict_g));
+  IndexSegment_RdbSaveBegin(rdb);
 
   dictIterator *iter = dictGetIterator(specDict_g);
   dictEntry *entry = NULL;
@@ -3271,9 +4304,22 @@ void Indexes_RdbSave(RedisModuleIO *rdb, int when) {
     StrongRef spec_ref = dictGetRef(entry);
     IndexSpec *sp = StrongRef_Get(spec_ref);
     IndexSpec_RdbSave(rdb, sp);
+
+    // The GC may be writing to the index from its thread, or may have been when BGSAVE forked, in
+    // which case the index is indexed again on load instead
+    const bool saveContents =
+        IndexSpec_CanPersistContents(sp) && !pthread_rwlock_tryrdlock(&sp->rwlock);
+    RedisModule_SaveUnsigned(rdb, saveContents);
+    if (saveContents) {
+      dictPauseRehashing(sp->keysDict);
+      IndexSpec_RdbSaveContents(rdb, sp);
+      dictResumeRehashing(sp->keysDict);
+      pthread_rwlock_unlock(&sp->rwlock);
+    }
   }
 
   dictReleaseIterator(iter);
+  IndexSegment_RdbSaveEnd();
 }
 
 void Indexes_RdbSave2(RedisModuleIO *rdb, int when) {
@@ -3387,14 +4433,11 @@ int IndexSpec_RegisterType(RedisModuleCtx *ctx) {
   return REDISMODULE_OK;
 }
 
-int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type) {
+// Loads the fields of `key` indexed by `spec`, from the field at index `from` on, into `doc`. If
+// the document cannot be loaded, the error is recorded and the document is deleted from the index.
+static int IndexSpec_LoadDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key,
+                             DocumentType type, t_fieldIndex from, Document *doc) {
   RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
-
-  if (!spec->rule) {
-    RedisModule_Log(ctx, "warning", "Index spec '%s': no rule found", IndexSpec_FormatName(spec, RSGlobalConfig.hideUserDataFromLog));
-    return REDISMODULE_ERR;
-  }
-
   QueryError status = QueryError_Default();
 
   if(spec->scan_failed_OOM) {
@@ -3404,46 +4447,77 @@ int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString
     return REDISMODULE_ERR;
   }
 
-  rs_wall_clock startDocTime;
-  rs_wall_clock_init(&startDocTime);
-
-  Document doc = {0};
-  Document_Init(&doc, key, DEFAULT_SCORE, DEFAULT_LANGUAGE, type);
+  Document_Init(doc, key, DEFAULT_SCORE, DEFAULT_LANGUAGE, type);
   // if a key does not exit, is not a hash or has no fields in index schema
 
-  int rv = REDISMODULE_ERR;
-  switch (type) {
-  case DocumentType_Hash:
-    rv = Document_LoadSchemaFieldHash(&doc, &sctx, &status);
-    break;
-  case DocumentType_Json:
-    rv = Document_LoadSchemaFieldJson(&doc, &sctx, &status);
-    break;
-  case DocumentType_Unsupported:
-    RS_ABORT("Should receive valid type");
-    break;
-  }
+  int rv = Document_LoadSchemaFieldsFrom(doc, &sctx, from, &status);
 
   if (rv != REDISMODULE_OK) {
     // we already unlocked the spec but we can increase this value atomically
-    IndexError_AddQueryError(&spec->stats.indexError, &status, doc.docKey);
+    IndexError_AddQueryError(&spec->stats.indexError, &status, doc->docKey);
 
     // if a document did not load properly, it is deleted
     // to prevent mismatch of index and hash
     IndexSpec_DeleteDoc(spec, ctx, key);
     QueryError_ClearError(&status);
-    Document_Free(&doc);
+    Document_Free(doc);
+    return REDISMODULE_ERR;
+  }
+  return REDISMODULE_OK;
+}
+
+int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+
+  if (!spec->rule) {
+    RedisModule_Log(ctx, "warning", "Index spec '%s': no rule found", IndexSpec_FormatName(spec, RSGlobalConfig.hideUserDataFromLog));
     return REDISMODULE_ERR;
   }
 
+  rs_wall_clock startDocTime;
+  rs_wall_clock_init(&startDocTime);
+
+  Document doc = {0};
+  if (IndexSpec_LoadDoc(spec, ctx, key, type, 0, &doc) != REDISMODULE_OK) {
+    return REDISMODULE_ERR;
+  }
+
+  QueryError status = QueryError_Default();
   unsigned int numOps = doc.numFields != 0 ? doc.numFields: 1;
   IndexerYieldWhileLoading(ctx, numOps, REDISMODULE_YIELD_FLAG_CLIENTS);
-  RedisSearchCtx_LockSpecWrite(&sctx);
-  IndexSpec_IncrActiveWrites(spec);
 
+  // The fields are tokenized and parsed under the read lock, so that the queries running in the
+  // background are only held back by the writes of the document
+  RedisSearchCtx_LockSpecRead(&sctx);
   RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, &doc, &status);
   aCtx->stateFlags |= ACTX_F_NOFREEDOC;
-  AddDocumentCtx_Submit(aCtx, &sctx, DOCUMENT_ADD_REPLACE);
+  aCtx->indexDelta = IndexDelta_Find(spec, key);
+  // An unchanged document is only skipped with _SKIP_UNCHANGED_DOCS, as indexing it again counts
+  // its terms again, which the scores of its matches reflect
+  bool inPlace = AddDocumentCtx_IsUnchanged(aCtx, &sctx) &&
+                 (aCtx->hasInPlaceFields || RSGlobalConfig.skipUnchangedDocs);
+  if (inPlace && !aCtx->hasInPlaceFields) {
+    // A retried write, or a write to fields which are not indexed: the document keeps its id
+    RedisSearchCtx_UnlockSpec(&sctx);
+    AddDocumentCtx_Free(aCtx);
+    Document_Free(&doc);
+    return REDISMODULE_OK;
+  }
+  AddDocumentCtx_Preprocess(aCtx, &sctx);
+  RedisSearchCtx_UnlockSpec(&sctx);
+  if (!inPlace) {
+    IndexDelta_Replicate(ctx, aCtx);
+  }
+
+  RedisSearchCtx_LockSpecWrite(&sctx);
+  IndexSpec_IncrActiveWrites(spec);
+  if (inPlace) {
+    // Only the vectors and shapes of the document may have changed, and their indexes are keyed
+    // by id, so the document keeps its id. The GIL was held since the check.
+    AddDocumentCtx_UpdateInPlace(aCtx, &sctx);
+  } else {
+    AddDocumentCtx_Submit(aCtx, &sctx, DOCUMENT_ADD_REPLACE);
+  }
 
   Document_Free(&doc);
 
@@ -3453,14 +4527,86 @@ int IndexSpec_UpdateDoc(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString
   return REDISMODULE_OK;
 }
 
+// Updates the documents of `n` keys of the index type, as IndexSpec_UpdateDoc() does for each of
+// them, writing their terms to the inverted indexes together (see AddDocumentCtx_SubmitBatch)
+static void IndexSpec_UpdateDocs(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString **keys,
+                                 size_t n) {
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+  rs_wall_clock start;
+  rs_wall_clock_init(&start);
+
+  Document *docs = rm_calloc(n, sizeof(*docs));
+  bool *loaded = rm_calloc(n, sizeof(*loaded));
+  for (size_t i = 0; i < n; i++) {
+    loaded[i] = IndexSpec_LoadDoc(spec, ctx, keys[i], spec->rule->type, 0, &docs[i]) == REDISMODULE_OK;
+  }
+
+  RSAddDocumentCtx **batch = rm_malloc(n * sizeof(*batch));
+  RSAddDocumentCtx **inPlace = rm_malloc(n * sizeof(*inPlace));
+  size_t nbatch = 0, ninPlace = 0;
+  RedisSearchCtx_LockSpecRead(&sctx);
+  for (size_t i = 0; i < n; i++) {
+    if (!loaded[i]) {
+      continue;
+    }
+    QueryError status = QueryError_Default();
+    RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, &docs[i], &status);
+    QueryError_ClearError(&status);
+    if (!aCtx) {
+      continue;
+    }
+    aCtx->stateFlags |= ACTX_F_NOFREEDOC;
+    aCtx->indexDelta = IndexDelta_Find(spec, keys[i]);
+    if (AddDocumentCtx_IsUnchanged(aCtx, &sctx) &&
+        (aCtx->hasInPlaceFields || RSGlobalConfig.skipUnchangedDocs)) {
+      if (!aCtx->hasInPlaceFields) {
+        AddDocumentCtx_Free(aCtx);
+        continue;
+      }
+      inPlace[ninPlace++] = aCtx;
+    } else {
+      batch[nbatch++] = aCtx;
+    }
+    AddDocumentCtx_Preprocess(aCtx, &sctx);
+  }
+  RedisSearchCtx_UnlockSpec(&sctx);
+  for (size_t i = 0; i < nbatch; i++) {
+    IndexDelta_Replicate(ctx, batch[i]);
+  }
+
+  if (nbatch || ninPlace) {
+    RedisSearchCtx_LockSpecWrite(&sctx);
+    IndexSpec_IncrActiveWrites(spec);
+    // The keys are distinct, so the documents updated in place keep their ids whatever the order
+    for (size_t i = 0; i < ninPlace; i++) {
+      AddDocumentCtx_UpdateInPlace(inPlace[i], &sctx);
+    }
+    AddDocumentCtx_SubmitBatch(batch, nbatch, &sctx, DOCUMENT_ADD_REPLACE);
+    spec->stats.totalIndexTime += rs_wall_clock_elapsed_ns(&start);
+    IndexSpec_DecrActiveWrites(spec);
+    RedisSearchCtx_UnlockSpec(&sctx);
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    if (loaded[i]) {
+      Document_Free(&docs[i]);
+    }
+  }
+  rm_free(inPlace);
+  rm_free(batch);
+  rm_free(loaded);
+  rm_free(docs);
+}
+
 void IndexSpec_DeleteDoc_Unsafe(IndexSpec *spec, RedisModuleCtx *ctx, RedisModuleString *key, t_docId id) {
 
   if (DocTable_DeleteR(&spec->docs, key)) {
     spec->stats.numDocuments--;
+    ++spec->revision;
 
     // Increment the index's garbage collector's scanning frequency after document deletions
     if (spec->gc) {
-      GCContext_OnDelete(spec->gc);
+      GCContext_OnDelete(spec->gc, id);
     }
   }
 
@@ -3516,9 +4662,26 @@ static void onFlush(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent
   RSGlobalStats.totalStats.used_dialects = 0;
 }
 
+// Only the snapshots of the RDB write index segments
+static void onPersistence(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent, void *data) {
+  switch (subevent) {
+    case REDISMODULE_SUBEVENT_PERSISTENCE_RDB_START:
+    case REDISMODULE_SUBEVENT_PERSISTENCE_SYNC_RDB_START:
+      IndexSegment_OnSnapshotStart();
+      break;
+    case REDISMODULE_SUBEVENT_PERSISTENCE_ENDED:
+      IndexSegment_OnSnapshotEnd(true);
+      break;
+    case REDISMODULE_SUBEVENT_PERSISTENCE_FAILED:
+      IndexSegment_OnSnapshotEnd(false);
+      break;
+  }
+}
+
 void Indexes_Init(RedisModuleCtx *ctx) {
   specDict_g = dictCreate(&dictTypeHeapHiddenStrings, NULL);
   RedisModule_SubscribeToServerEvent(ctx, RedisModuleEvent_FlushDB, onFlush);
+  RedisModule_SubscribeToServerEvent(ctx, RedisModuleEvent_Persistence, onPersistence);
   SchemaPrefixes_Create();
 }
 
@@ -3637,8 +4800,9 @@ void Indexes_SpecOpsIndexingCtxFree(SpecOpIndexingCtx *specs) {
   rm_free(specs);
 }
 
-void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type,
-                                           RedisModuleString **hashFields) {
+static void updateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
+                                          DocumentType type, RedisModuleString **hashFields,
+                                          bool loaded) {
   if (type == DocumentType_Unsupported) {
     // COPY could overwrite a hash/json with other types so we must try and remove old doc
     Indexes_DeleteMatchingWithSchemaRules(ctx, key, hashFields);
@@ -3655,6 +4819,17 @@ void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStrin
       continue;
     }
 
+    if (loaded && specOp->spec->contentsLoaded) {
+      // Its document was loaded along with the index
+      if (DocTable_GetIdR(&specOp->spec->docs, key)) {
+        specOp->spec->contentsLoadedDocs++;
+      }
+      continue;
+    }
+    if (loaded && IndexSpec_IsCold(specOp->spec)) {
+      continue;
+    }
+
     if (hashFieldChanged(specOp->spec, hashFields)) {
       if (specOp->op == SpecOp_Add) {
         IndexSpec_UpdateDoc(specOp->spec, ctx, key, type);
@@ -3667,6 +4842,72 @@ void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleStrin
   Indexes_SpecOpsIndexingCtxFree(specs);
 }
 
+void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type,
+                                           RedisModuleString **hashFields) {
+  updateMatchingWithSchemaRules(ctx, key, type, hashFields, false);
+}
+
+void Indexes_UpdateLoadedWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type,
+                                         RedisModuleString **hashFields) {
+  updateMatchingWithSchemaRules(ctx, key, type, hashFields, true);
+}
+
+// The keys of a batch to update in one of the indexes
+typedef struct {
+  IndexSpec *spec;
+  arrayof(RedisModuleString *) keys;
+} SpecKeysBatch;
+
+void Indexes_UpdateMatchingBatch(RedisModuleCtx *ctx, RedisModuleString **keys,
+                                 RedisModuleString ***hashFields, size_t n) {
+  arrayof(SpecKeysBatch) batches = array_new(SpecKeysBatch, 4);
+  // The position of the batch of each index in `batches`
+  dict *specs = dictCreate(&dictTypeHeapHiddenStrings, NULL);
+
+  for (size_t i = 0; i < n; i++) {
+    DocumentType type = getDocTypeFromString(keys[i]);
+    if (type == DocumentType_Unsupported) {
+      // The key was deleted or overwritten by another type since it was written
+      Indexes_DeleteMatchingWithSchemaRules(ctx, keys[i], hashFields[i]);
+      continue;
+    }
+
+    SpecOpIndexingCtx *matching = Indexes_FindMatchingSchemaRules(ctx, keys[i], true, NULL);
+    for (size_t j = 0; j < array_len(matching->specsOps); ++j) {
+      SpecOpCtx *specOp = matching->specsOps + j;
+      IndexSpec *spec = specOp->spec;
+      if (type != spec->rule->type || !hashFieldChanged(spec, hashFields[i])) {
+        continue;
+      }
+      if (specOp->op == SpecOp_Del) {
+        IndexSpec_DeleteDoc(spec, ctx, keys[i]);
+        continue;
+      }
+      dictEntry *entry = dictFind(specs, spec->specName);
+      if (!entry) {
+        SpecKeysBatch batch = {.spec = spec, .keys = array_new(RedisModuleString *, 8)};
+        array_append(batches, batch);
+        entry = dictAddRaw(specs, (void *)spec->specName, NULL);
+        entry->v.u64 = array_len(batches) - 1;
+      }
+      array_append(batches[entry->v.u64].keys, keys[i]);
+    }
+    Indexes_SpecOpsIndexingCtxFree(matching);
+  }
+
+  for (size_t i = 0; i < array_len(batches); i++) {
+    SpecKeysBatch *batch = batches + i;
+    if (array_len(batch->keys) == 1) {
+      IndexSpec_UpdateDoc(batch->spec, ctx, batch->keys[0], batch->spec->rule->type);
+    } else {
+      IndexSpec_UpdateDocs(batch->spec, ctx, batch->keys, array_len(batch->keys));
+    }
+    array_free(batch->keys);
+  }
+  dictRelease(specs);
+  array_free(batches);
+}
+
 void Indexes_DeleteMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
                                            RedisModuleString **hashFields) {
   SpecOpIndexingCtx *specs = Indexes_FindMatchingSchemaRules(ctx, key, false, NULL);
@@ -3852,7 +5093,41 @@ void Indexes_StartRDBLoadingEvent() {
   g_isLoading = true;
 }
 
+// The keys of the contents of the index that were not loaded expired before they were saved or
+// loaded, so their documents are deleted
+static void IndexSpec_DeleteUnloadedDocs(RedisModuleCtx *ctx, IndexSpec *sp) {
+  if (sp->contentsLoadedDocs + 1 >= sp->docs.size) {
+    return;
+  }
+  arrayof(RedisModuleString *) unloaded = array_new(RedisModuleString *, 8);
+  DOCTABLE_FOREACH((&sp->docs), {
+    RedisModuleString *key = RedisModule_CreateString(ctx, dmd->keyPtr, sdslen(dmd->keyPtr));
+    RedisModuleKey *k = RedisModule_OpenKey(ctx, key, REDISMODULE_READ);
+    if (!k || RedisModule_KeyType(k) == REDISMODULE_KEYTYPE_EMPTY) {
+      array_append(unloaded, key);
+    } else {
+      RedisModule_FreeString(ctx, key);
+    }
+    if (k) RedisModule_CloseKey(k);
+  });
+  for (size_t i = 0; i < array_len(unloaded); i++) {
+    IndexSpec_DeleteDoc(sp, ctx, unloaded[i]);
+    RedisModule_FreeString(ctx, unloaded[i]);
+  }
+  array_free(unloaded);
+}
+
 void Indexes_EndRDBLoadingEvent(RedisModuleCtx *ctx) {
+  dictIterator *iter = dictGetIterator(specDict_g);
+  dictEntry *entry;
+  while ((entry = dictNext(iter))) {
+    IndexSpec *sp = StrongRef_Get(dictGetRef(entry));
+    if (sp->contentsLoaded) {
+      IndexSpec_DeleteUnloadedDocs(ctx, sp);
+    }
+  }
+  dictReleaseIterator(iter);
+
   int hasLegacyIndexes = dictSize(legacySpecDict);
   Indexes_UpgradeLegacyIndexes();
 
@@ -3865,8 +5140,18 @@ void Indexes_EndRDBLoadingEvent(RedisModuleCtx *ctx) {
   if (hasLegacyIndexes) {
     Indexes_ScanAndReindex();
   }
+  Indexes_ActivateHotIndexes();
 }
 
 void Indexes_EndLoading() {
   g_isLoading = false;
+  // Whatever is loaded from now on is indexed
+  dictIterator *iter = dictGetIterator(specDict_g);
+  dictEntry *entry;
+  while ((entry = dictNext(iter))) {
+    IndexSpec *sp = StrongRef_Get(dictGetRef(entry));
+    sp->contentsLoaded = false;
+    sp->contentsLoadedDocs = 0;
+  }
+  dictReleaseIterator(iter);
 }
@@ -27,6 +27,7 @@
 #include "rules.h"
 #include <pthread.h>
 #include "info/index_error.h"
+#include "info/vector_index_stats.h"
 #include "obfuscation/hidden.h"
 #include "rs_wall_clock.h"
 
@@ -61,6 +62,7 @@ struct IndexesScanner;
 #define SPEC_PHONETIC_STR "PHONETIC"
 #define SPEC_SORTABLE_STR "SORTABLE"
 #define SPEC_UNF_STR "UNF"
+#define SPEC_STORED_STR "STORED"
 #define SPEC_STOPWORDS_STR "STOPWORDS"
 #define SPEC_NOINDEX_STR "NOINDEX"
 #define SPEC_TAG_SEPARATOR_STR "SEPARATOR"
@@ -159,8 +161,16 @@ typedef struct {
   size_t totalDocsLen;
   uint32_t activeQueries;
   uint32_t activeWrites;
+  VectorIndexingStats vectorIndexing;
 } IndexStats;
 
+// The state of an index loaded from the RDB while _LAZY_INDEX_LOADING is on
+typedef enum {
+  IndexActivation_Active = 0,  // Its documents are indexed
+  IndexActivation_Cold,        // Its documents were not indexed as their keys were loaded
+  IndexActivation_Queued,      // The scan of its documents is about to start
+} IndexActivation;
+
 typedef enum {
   Index_StoreTermOffsets = 0x01,
   Index_StoreFieldFlags = 0x02,
@@ -221,7 +231,9 @@ typedef uint16_t FieldSpecDedupeArray[SPEC_MAX_FIELDS];
   (Index_StoreFreqs | Index_StoreFieldFlags | Index_StoreTermOffsets | Index_StoreNumeric | \
    Index_WideSchema)
 
-#define INDEX_CURRENT_VERSION 25
+#define INDEX_CURRENT_VERSION 27
+#define INDEX_SEGMENTS_VERSION 27
+#define INDEX_CONTENTS_VERSION 26
 #define INDEX_VECSIM_SVS_VAMANA_VERSION 25
 #define INDEX_INDEXALL_VERSION 24
 #define INDEX_GEOMETRY_VERSION 23
@@ -300,6 +312,18 @@ typedef struct IndexSpec {
 
   Trie *terms;                    // Trie of all TEXT terms. Used for GC and fuzzy queries
   Trie *suffix;                   // Trie of TEXT suffix tokens of terms. Used for contains queries
+  struct SuffixArray *suffixArray; // Replaces the suffix trie when _SUFFIX_ARRAY was set on creation
+  struct SpellDeleteIndex *spellDeletes; // Deletions of the terms for FT.SPELLCHECK, built when first used
+  struct PrefixCache *prefixCache; // Materialized expansions of hot prefix queries
+  struct FilterCache *filterCache; // Materialized hot filters, when enabled
+  struct SnippetCache *snippets;  // Highlighted and summarized fields, when enabled
+  struct TermStatsCache *termStats; // Statistics of the TEXT terms, read by spellcheck scoring
+  struct TermIndexCache *termIndexes; // Inverted indexes of the TEXT terms indexed recently
+  struct ImpactPostings *impactPostings; // Top documents of the common TEXT terms, when enabled
+  struct KNNResultCache *knnResults; // Results of the unfiltered KNN queries, when enabled
+  struct SearchResultCache *searchResults; // Results of the FT.SEARCH queries, when enabled
+  struct QueryPlanCache *queryPlans; // Parsed query strings, when enabled
+  uint64_t revision;              // Bumped whenever a document is added or deleted (so whenever the inverted indexes of the TEXT terms change)
   t_fieldMask suffixMask;         // Mask of all fields that support contains query
   dict *keysDict;                 // Global dictionary. Contains inverted indexes of all TEXT TAG NUMERIC VECTOR and GEOSHAPE terms
 
@@ -321,6 +345,11 @@ typedef struct IndexSpec {
   bool monitorDocumentExpiration;
   bool monitorFieldExpiration;
   bool isDuplicate;               // Marks that this index is a duplicate of an existing one
+  // The contents of the index were loaded from the RDB along with it (see _PERSIST_INDEXES), so its
+  // documents are not indexed again as their keys are loaded. Until loading ends
+  bool contentsLoaded;
+  size_t contentsLoadedDocs;      // The documents of the contents whose keys were loaded since
+  uint8_t activation;             // An IndexActivation, read by the queries from any thread
 
   // cached strings, corresponding to number of fields
   IndexSpecFmtStrings *indexStrs;
@@ -340,8 +369,16 @@ typedef struct IndexSpec {
   // Count the number of times the index was used
   long long counter;
 
+  // The shard window ratio of the coordinator KNN queries, learned when _SHARD_WINDOW_TARGET_RECALL
+  // is set. 0 until the first query. Guarded by the lock of shard_window_ratio.c
+  double shardWindowRatio;
+  // Moving average of the queries whose top results may have missed results of a shard
+  double shardWindowMissRate;
+
   // read write lock
   pthread_rwlock_t rwlock;
+  // The threads waiting to lock the spec for write. Long queries yield their read lock to them
+  uint32_t writersWaiting;
 
   // Cursors counters
   size_t activeCursors;
@@ -359,6 +396,9 @@ typedef struct IndexSpec {
 
   // Disk index handle
   RedisSearchDiskIndexSpec *diskSpec;
+  // The disk database holding the blocks of the cold terms of an index in memory, opened once the
+  // first of them is moved there (see term_tiers.h)
+  RedisSearchDiskIndexSpec *coldTerms;
 } IndexSpec;
 
 typedef enum SpecOp { SpecOp_Add, SpecOp_Del } SpecOp;
@@ -377,6 +417,10 @@ typedef struct SpecOpIndexingCtx {
 typedef struct {
   void (*dtor)(void *p);
   void *p;
+  // The GC cycles since the inverted index of a term was last opened, and whether its blocks were
+  // moved to the disk database since. Only used by the terms (see term_tiers.h)
+  uint16_t idleCycles;
+  bool cold;
 } KeysDictValue;
 
 extern RedisModuleType *IndexSpecType;
@@ -556,6 +600,16 @@ void IndexesScanner_Cancel(struct IndexesScanner *scanner);
 void IndexesScanner_ResetProgression(struct IndexesScanner *scanner);
 
 void IndexSpec_ScanAndReindex(RedisModuleCtx *ctx, StrongRef ref);
+
+/* Whether the documents of the index were not indexed yet, as it was loaded while
+ * _LAZY_INDEX_LOADING is on. A cold index is built by a background scan, as a new index is, once it
+ * is first used or when it is one of _HOT_INDEXES */
+#define IndexSpec_IsCold(sp) (__atomic_load_n(&(sp)->activation, __ATOMIC_ACQUIRE) != IndexActivation_Active)
+
+/* Queue the scan of the documents of a cold index ahead of the hot indexes, if it was not queued
+ * already. May be called from any thread */
+void IndexSpec_Activate(IndexSpec *sp);
+
 #ifdef FTINFO_FOR_INFO_MODULES
 /**
  * Exposing all the fields of the index to INFO command.
@@ -637,6 +691,9 @@ void IndexSpec_Free(IndexSpec *spec);
 
 void IndexSpec_AddTerm(IndexSpec *sp, const char *term, size_t len);
 
+/* Creates the suffix index shared by the TEXT fields WITHSUFFIXTRIE, if the spec has none yet */
+void IndexSpec_InitSuffixIndex(IndexSpec *sp);
+
 /** Returns a string suitable for indexes. This saves on string creation/destruction */
 RedisModuleString *IndexSpec_GetFormattedKey(IndexSpec *sp, const FieldSpec *fs, FieldType forType);
 RedisModuleString *IndexSpec_GetFormattedKeyByName(IndexSpec *sp, const char *s, FieldType forType);
@@ -651,6 +708,14 @@ int IndexSpec_RegisterType(RedisModuleCtx *ctx);
 void IndexSpec_ClearAliases(StrongRef ref);
 
 void IndexSpec_InitializeSynonym(IndexSpec *sp);
+
+/**
+ * Rebuild the inverted index of a synonym group from the inverted indexes of the terms of the group,
+ * as indexing all the documents again with the current synonyms would, once a group has changed.
+ * Returns false if the inverted indexes of the spec are not kept in memory, in which case the
+ * documents have to be indexed again
+ */
+bool IndexSpec_RebuildSynonymGroup(struct RedisSearchCtx *sctx, const char *groupId);
 void Indexes_SetTempSpecsTimers(TimerOp op);
 
 //---------------------------------------------------------------------------------------------
@@ -664,8 +729,27 @@ typedef struct IndexesScanner {
   char *spec_name_for_logs;
   size_t scannedKeys;
   RedisModuleString *OOMkey; // The key that caused the OOM
+  // The documents loaded by the current scan step. They are preprocessed while the GIL is
+  // released between the steps, and written once it is taken back
+  arrayof(struct RSAddDocumentCtx *) pending;
+  StrongRef pendingRef;      // The spec of the pending documents
+  size_t pendingEvents;      // `keyspaceEventsCount` when the pending documents were loaded
+  // Set when the scanner only indexes the fields from `firstField` on, which were added to the
+  // schema, for the documents of the index. The documents are visited by ascending ids from
+  // `nextDocId` on, instead of scanning the keyspace (see `IndexSpec_AddFields`)
+  bool fieldsOnly;
+  t_fieldIndex firstField;
+  t_docId nextDocId;
 } IndexesScanner;
 
+/* Whether the field is still being indexed for the existing documents by the scanner of the
+ * index. Until then the documents which are indexed meanwhile leave it to the scanner, as its
+ * indexes only accept increasing ids */
+static inline bool IndexSpec_IsFieldBuilding(const IndexSpec *sp, t_fieldIndex index) {
+  return sp->scanner && sp->scanner->fieldsOnly && !sp->scanner->cancelled &&
+         index >= sp->scanner->firstField;
+}
+
 typedef struct DebugIndexesScanner {
   IndexesScanner base;
   int maxDocsTBscanned;
@@ -726,6 +810,14 @@ size_t Indexes_Count();
 void Indexes_Propagate(RedisModuleCtx *ctx);
 void Indexes_UpdateMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type,
                                            RedisModuleString **hashFields);
+// Index a key loaded from the RDB, except in the indexes whose contents were loaded along with them
+void Indexes_UpdateLoadedWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key, DocumentType type,
+                                         RedisModuleString **hashFields);
+// Update `n` distinct keys in the indexes matching them, as Indexes_UpdateMatchingWithSchemaRules()
+// does with the type they have now, writing the documents of each index together. `hashFields`
+// holds the NULL terminated fields written to each of the keys, or NULL if any may have been
+void Indexes_UpdateMatchingBatch(RedisModuleCtx *ctx, RedisModuleString **keys,
+                                 RedisModuleString ***hashFields, size_t n);
 void Indexes_DeleteMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *key,
                                            RedisModuleString **hashFields);
 void Indexes_ReplaceMatchingWithSchemaRules(RedisModuleCtx *ctx, RedisModuleString *from_key,
@@ -756,6 +848,7 @@ void IndexSpecRef_Release(StrongRef ref);
 void Indexes_StartRDBLoadingEvent();
 
 // This function is called in case the server ends RDB loading.
+// The documents of the loaded contents whose keys were not loaded (as they expired) are deleted.
 void Indexes_EndRDBLoadingEvent(RedisModuleCtx *ctx);
 
 // This function is to be called when loading finishes (failed or not)
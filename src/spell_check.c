@@ -9,8 +9,11 @@
 #include "spell_check.h"
 #include "util/arr.h"
 #include "dictionary.h"
+#include "redis_index.h"
 #include "reply.h"
 #include "iterators/inverted_index_iterator.h"
+#include "spell_delete_index.h"
+#include "config.h"
 #include <stdbool.h>
 
 /** Forward declaration **/
@@ -87,6 +90,24 @@ void RS_SuggestionsFree(RS_Suggestions *s) {
  */
 static double SpellCheck_GetScore(SpellCheckCtx *scCtx, char *suggestion, size_t len,
                                   t_fieldMask fieldMask) {
+  const IndexSpec *spec = scCtx->sctx->spec;
+  TermStats stats;
+  Redis_GetTermStats(scCtx->sctx, suggestion, len, &stats);
+  if (!stats.hasIndex) {
+    // can not find inverted index key, score is 0.
+    return 0;
+  }
+  // Unless fields may expire, the statistics tell whether the fields have documents with the
+  // suggestion, when they have either all or none of its documents
+  if (!(spec->docs.ttl && spec->monitorFieldExpiration)) {
+    if (!stats.numDocs || (Index_StoreFieldMask(spec) && !(stats.fieldMask & fieldMask))) {
+      return -1;
+    }
+    if (!Index_StoreFieldMask(spec) || !(stats.fieldMask & ~fieldMask)) {
+      return stats.numDocs;
+    }
+  }
+
   InvertedIndex *invidx = Redis_OpenInvertedIndex(scCtx->sctx, suggestion, len, 0, NULL);
   double retVal = 0;
   if (!invidx) {
@@ -153,6 +174,47 @@ static void SpellCheck_FindSuggestions(SpellCheckCtx *scCtx, Trie *t, const char
   TrieIterator_Free(it);
 }
 
+typedef struct {
+  SpellCheckCtx *scCtx;
+  t_fieldMask fieldMask;
+  RS_Suggestions *s;
+} deleteIndexSuggestions;
+
+static void addDeleteIndexSuggestion(const char *term, size_t len, void *arg) {
+  deleteIndexSuggestions *ctx = arg;
+  double score;
+  if ((score = SpellCheck_GetScore(ctx->scCtx, (char *)term, len, ctx->fieldMask)) != -1) {
+    RS_SuggestionsAdd(ctx->s, (char *)term, len, score, 1);
+  }
+}
+
+/* Find the suggestions among the terms of the index, in their deletion index if it is enabled and
+ * can tell them */
+static void SpellCheck_FindTermSuggestions(SpellCheckCtx *scCtx, const char *term, size_t len,
+                                           t_fieldMask fieldMask, RS_Suggestions *s) {
+  IndexSpec *spec = scCtx->sctx->spec;
+  if (!RSGlobalConfig.spellCheckDeleteIndex) {
+    if (spec->spellDeletes) {
+      RedisSearchCtx_LockSpecWrite(scCtx->sctx);
+      SpellDeleteIndex_Free(spec->spellDeletes);
+      spec->spellDeletes = NULL;
+      RedisSearchCtx_UnlockSpec(scCtx->sctx);
+    }
+  } else if (scCtx->distance <= SPELL_DELETE_INDEX_MAX_DIST) {
+    if (!spec->spellDeletes) {
+      RedisSearchCtx_LockSpecWrite(scCtx->sctx);
+      spec->spellDeletes = NewSpellDeleteIndex(spec->terms);
+      RedisSearchCtx_UnlockSpec(scCtx->sctx);
+    }
+    deleteIndexSuggestions ctx = {.scCtx = scCtx, .fieldMask = fieldMask, .s = s};
+    if (SpellDeleteIndex_Find(spec->spellDeletes, term, len, scCtx->distance,
+                              addDeleteIndexSuggestion, &ctx)) {
+      return;
+    }
+  }
+  SpellCheck_FindSuggestions(scCtx, spec->terms, term, len, fieldMask, s, 1);
+}
+
 RS_Suggestion **spellCheck_GetSuggestions(RS_Suggestions *s) {
   TrieIterator *iter = Trie_Iterate(s->suggestionsTrie, "", 0, 0, 1);
   RS_Suggestion **ret = array_new(RS_Suggestion *, s->suggestionsTrie->size);
@@ -266,7 +328,7 @@ static bool SpellCheck_ReplyTermSuggestions(SpellCheckCtx *scCtx, char *term, si
 
   RS_Suggestions *s = RS_SuggestionsCreate();
 
-  SpellCheck_FindSuggestions(scCtx, scCtx->sctx->spec->terms, term, len, fieldMask, s, 1);
+  SpellCheck_FindTermSuggestions(scCtx, term, len, fieldMask, s);
 
   // sorting results by score
 
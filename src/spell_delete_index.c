@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "spell_delete_index.h"
+#include "trie/rune_util.h"
+#include "util/arr.h"
+#include "util/dict.h"
+#include "rmalloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// A term of the index, with its lowered runes, by which the trie matches it
+typedef struct {
+  const char *term;
+  size_t len;
+  size_t rlen;
+  rune runes[];
+} indexedTerm;
+
+struct SpellDeleteIndex {
+  // Deletion -> array of the terms it is obtained from. The deletions are arrays of runes led by
+  // their length. A term is owned by the key of its own runes, with no deletion
+  dict *deletes;
+  size_t memsize;
+};
+
+// A deletion on the stack, led by its length
+typedef rune deletionBuf[SPELL_DELETE_INDEX_MAX_TERM_LEN + 1];
+
+static inline size_t deletionSize(const rune *key) {
+  return (key[0] + 1) * sizeof(rune);
+}
+
+static uint64_t deletionHash(const void *key) {
+  return dictGenHashFunction(key, deletionSize(key));
+}
+
+static int deletionCompare(void *privdata, const void *a, const void *b) {
+  const rune *x = a, *y = b;
+  return x[0] == y[0] && !memcmp(x + 1, y + 1, x[0] * sizeof(rune));
+}
+
+static void deletionDestructor(void *privdata, void *key) {
+  rm_free(key);
+}
+
+static void bucketDestructor(void *privdata, void *val) {
+  array_free(val);
+}
+
+static dictType deletesType = {
+  .hashFunction = deletionHash,
+  .keyCompare = deletionCompare,
+  .keyDestructor = deletionDestructor,
+  .valDestructor = bucketDestructor,
+};
+
+typedef void (*deletionFn)(SpellDeleteIndex *idx, const rune *key, void *arg);
+
+// Call `fn` with `key`, and with every string obtained by deleting up to `depth` of its runes from
+// position `from` on. A string obtained by several sets of deletions is passed once for each
+static void forEachDeletion(SpellDeleteIndex *idx, const rune *key, size_t from, int depth,
+                            deletionFn fn, void *arg) {
+  fn(idx, key, arg);
+  if (!depth) {
+    return;
+  }
+  size_t n = key[0];
+  deletionBuf del;
+  for (size_t i = from; i < n; i++) {
+    del[0] = n - 1;
+    memcpy(del + 1, key + 1, i * sizeof(rune));
+    memcpy(del + 1 + i, key + 2 + i, (n - 1 - i) * sizeof(rune));
+    forEachDeletion(idx, del, i, depth - 1, fn, arg);
+  }
+}
+
+// The lowered runes of `str` to `key`. Returns false if it has too many of them to be indexed
+static bool toDeletion(const char *str, size_t len, deletionBuf key) {
+  size_t rlen;
+  rune *runes = strToLowerRunes(str, len, &rlen);
+  if (!runes || rlen > SPELL_DELETE_INDEX_MAX_TERM_LEN) {
+    rm_free(runes);
+    return false;
+  }
+  key[0] = rlen;
+  memcpy(key + 1, runes, rlen * sizeof(rune));
+  rm_free(runes);
+  return true;
+}
+
+static indexedTerm *findTerm(SpellDeleteIndex *idx, const rune *key, const char *term, size_t len) {
+  indexedTerm **bucket = dictFetchValue(idx->deletes, key);
+  for (uint32_t i = 0; bucket && i < array_len(bucket); i++) {
+    if (bucket[i]->len == len && !memcmp(bucket[i]->term, term, len)) {
+      return bucket[i];
+    }
+  }
+  return NULL;
+}
+
+static void addDeletion(SpellDeleteIndex *idx, const rune *key, void *arg) {
+  indexedTerm *t = arg;
+  dictEntry *e = dictFind(idx->deletes, key);
+  if (!e) {
+    rune *k = rm_malloc(deletionSize(key));
+    memcpy(k, key, deletionSize(key));
+    indexedTerm **bucket = array_new(indexedTerm *, 1);
+    array_append(bucket, t);
+    dictAdd(idx->deletes, k, bucket);
+    idx->memsize += deletionSize(key) + sizeof(dictEntry) + sizeof(t);
+    return;
+  }
+  indexedTerm **bucket = dictGetVal(e);
+  // The deletions of a term are all added before those of another one
+  if (array_tail(bucket) == t) {
+    return;
+  }
+  array_append(bucket, t);
+  dictSetVal(idx->deletes, e, bucket);
+  idx->memsize += sizeof(t);
+}
+
+static void removeDeletion(SpellDeleteIndex *idx, const rune *key, void *arg) {
+  indexedTerm *t = arg;
+  indexedTerm **bucket = dictFetchValue(idx->deletes, key);
+  if (!bucket) {
+    return;
+  }
+  for (uint32_t i = 0; i < array_len(bucket); i++) {
+    if (bucket[i] == t) {
+      array_del_fast(bucket, i);
+      idx->memsize -= sizeof(t);
+      break;
+    }
+  }
+  if (!array_len(bucket)) {
+    idx->memsize -= deletionSize(key) + sizeof(dictEntry);
+    dictDelete(idx->deletes, key);
+  }
+}
+
+SpellDeleteIndex *NewSpellDeleteIndex(Trie *terms) {
+  SpellDeleteIndex *idx = rm_calloc(1, sizeof(*idx));
+  idx->deletes = dictCreate(&deletesType, NULL);
+
+  TrieIterator *it = Trie_Iterate(terms, "", 0, 0, 1);
+  rune *rstr;
+  t_len slen;
+  float score;
+  int dist;
+  while (TrieIterator_Next(it, &rstr, &slen, NULL, &score, &dist)) {
+    size_t len;
+    char *term = runesToStr(rstr, slen, &len);
+    SpellDeleteIndex_Add(idx, term, len);
+    rm_free(term);
+  }
+  TrieIterator_Free(it);
+  return idx;
+}
+
+void SpellDeleteIndex_Free(SpellDeleteIndex *idx) {
+  if (!idx) return;
+  // The terms are freed once no bucket refers to them
+  indexedTerm **terms = array_new(indexedTerm *, 64);
+  dictIterator *iter = dictGetIterator(idx->deletes);
+  dictEntry *e;
+  while ((e = dictNext(iter))) {
+    const rune *key = dictGetKey(e);
+    indexedTerm **bucket = dictGetVal(e);
+    for (uint32_t i = 0; i < array_len(bucket); i++) {
+      if (bucket[i]->rlen == key[0]) {
+        array_append(terms, bucket[i]);
+      }
+    }
+  }
+  dictReleaseIterator(iter);
+  dictRelease(idx->deletes);
+  array_free_ex(terms, rm_free(*(indexedTerm **)ptr));
+  rm_free(idx);
+}
+
+void SpellDeleteIndex_Add(SpellDeleteIndex *idx, const char *term, size_t len) {
+  deletionBuf key;
+  if (!toDeletion(term, len, key) || findTerm(idx, key, term, len)) {
+    return;
+  }
+  size_t runesSize = key[0] * sizeof(rune);
+  indexedTerm *t = rm_malloc(sizeof(*t) + runesSize + len + 1);
+  char *str = (char *)t->runes + runesSize;
+  memcpy(str, term, len);
+  str[len] = '\0';
+  t->term = str;
+  t->len = len;
+  t->rlen = key[0];
+  memcpy(t->runes, key + 1, runesSize);
+  idx->memsize += sizeof(*t) + runesSize + len + 1;
+  forEachDeletion(idx, key, 0, SPELL_DELETE_INDEX_MAX_DIST, addDeletion, t);
+}
+
+void SpellDeleteIndex_Remove(SpellDeleteIndex *idx, const char *term, size_t len) {
+  deletionBuf key;
+  indexedTerm *t;
+  if (!toDeletion(term, len, key) || !(t = findTerm(idx, key, term, len))) {
+    return;
+  }
+  forEachDeletion(idx, key, 0, SPELL_DELETE_INDEX_MAX_DIST, removeDeletion, t);
+  idx->memsize -= sizeof(*t) + t->rlen * sizeof(rune) + len + 1;
+  rm_free(t);
+}
+
+// The Levenshtein distance of `a` and `b`, or `maxDist + 1` if it is larger than `maxDist`
+static int editDistance(const rune *a, size_t n, const rune *b, size_t m, int maxDist) {
+  if ((n > m ? n - m : m - n) > (size_t)maxDist) {
+    return maxDist + 1;
+  }
+  int rows[2][SPELL_DELETE_INDEX_MAX_TERM_LEN + 1];
+  int *prev = rows[0], *cur = rows[1];
+  for (size_t j = 0; j <= m; j++) {
+    prev[j] = j;
+  }
+  for (size_t i = 1; i <= n; i++) {
+    cur[0] = i;
+    int rowMin = cur[0];
+    for (size_t j = 1; j <= m; j++) {
+      int d = prev[j - 1] + (a[i - 1] != b[j - 1]);
+      if (prev[j] + 1 < d) d = prev[j] + 1;
+      if (cur[j - 1] + 1 < d) d = cur[j - 1] + 1;
+      cur[j] = d;
+      if (d < rowMin) rowMin = d;
+    }
+    if (rowMin > maxDist) {
+      return maxDist + 1;
+    }
+    int *tmp = prev;
+    prev = cur;
+    cur = tmp;
+  }
+  return prev[m];
+}
+
+static void collectDeletion(SpellDeleteIndex *idx, const rune *key, void *arg) {
+  indexedTerm ***candidates = arg;
+  indexedTerm **bucket = dictFetchValue(idx->deletes, key);
+  for (uint32_t i = 0; bucket && i < array_len(bucket); i++) {
+    array_append(*candidates, bucket[i]);
+  }
+}
+
+static int cmpPtrs(const void *a, const void *b) {
+  uintptr_t x = (uintptr_t)*(void *const *)a, y = (uintptr_t)*(void *const *)b;
+  return x < y ? -1 : x > y;
+}
+
+bool SpellDeleteIndex_Find(SpellDeleteIndex *idx, const char *term, size_t len, int maxDist,
+                           SpellDeleteIndex_Callback cb, void *ctx) {
+  deletionBuf key;
+  // The terms within the distance may be longer than the indexed ones
+  if (maxDist > SPELL_DELETE_INDEX_MAX_DIST || !toDeletion(term, len, key) ||
+      key[0] + maxDist > SPELL_DELETE_INDEX_MAX_TERM_LEN) {
+    return false;
+  }
+
+  // A term within the distance has a deletion in common with the term, of up to `maxDist` runes
+  // deleted from each
+  indexedTerm **candidates = array_new(indexedTerm *, 16);
+  forEachDeletion(idx, key, 0, maxDist, collectDeletion, &candidates);
+  qsort(candidates, array_len(candidates), sizeof(*candidates), cmpPtrs);
+  for (uint32_t i = 0; i < array_len(candidates); i++) {
+    indexedTerm *t = candidates[i];
+    if ((i && t == candidates[i - 1]) ||
+        editDistance(key + 1, key[0], t->runes, t->rlen, maxDist) > maxDist) {
+      continue;
+    }
+    cb(t->term, t->len, ctx);
+  }
+  array_free(candidates);
+  return true;
+}
+
+size_t SpellDeleteIndex_MemUsage(const SpellDeleteIndex *idx) {
+  return idx ? idx->memsize + sizeof(*idx) : 0;
+}
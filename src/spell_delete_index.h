@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "trie/trie_type.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The largest distance the index answers. FT.SPELLCHECK walks the trie for larger ones
+#define SPELL_DELETE_INDEX_MAX_DIST 2
+
+/**
+ * A symmetric-delete index of the terms of a spec, for the suggestions of FT.SPELLCHECK. Every
+ * string obtained by deleting up to SPELL_DELETE_INDEX_MAX_DIST characters of a term maps to the
+ * terms it was obtained from, so the terms within a distance of a misspelled one are found by
+ * looking up its own deletions, and checking the distance of the few terms they map to.
+ *
+ * Terms longer than SPELL_DELETE_INDEX_MAX_TERM_LEN characters are not indexed, so terms whose
+ * suggestions could be that long are not looked up in it. The index is changed along with the
+ * trie of the terms.
+ */
+typedef struct SpellDeleteIndex SpellDeleteIndex;
+
+#define SPELL_DELETE_INDEX_MAX_TERM_LEN 32
+
+/* Create the index of all the terms of the trie */
+SpellDeleteIndex *NewSpellDeleteIndex(Trie *terms);
+void SpellDeleteIndex_Free(SpellDeleteIndex *idx);
+
+void SpellDeleteIndex_Add(SpellDeleteIndex *idx, const char *term, size_t len);
+void SpellDeleteIndex_Remove(SpellDeleteIndex *idx, const char *term, size_t len);
+
+typedef void (*SpellDeleteIndex_Callback)(const char *term, size_t len, void *ctx);
+
+/* Call `cb` with each term of the index within `maxDist` edits of `term`.
+ * @returns false, without calling it, if the index can not tell all of them */
+bool SpellDeleteIndex_Find(SpellDeleteIndex *idx, const char *term, size_t len, int maxDist,
+                           SpellDeleteIndex_Callback cb, void *ctx);
+
+size_t SpellDeleteIndex_MemUsage(const SpellDeleteIndex *idx);
+
+#ifdef __cplusplus
+}
+#endif
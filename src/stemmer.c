@@ -10,25 +10,132 @@
 #include <string.h>
 #include <stdio.h>
 #include <sys/param.h>
+#include <pthread.h>
 #include "snowball/include/libstemmer.h"
 #include "rmalloc.h"
 #include "rmutil/rm_assert.h"
+#include "util/fnv.h"
+
+// Each thread caches the stems of the last words it stemmed in every language, in a direct mapped
+// table of STEM_CACHE_SLOTS entries. Words or stems longer than STEM_CACHE_MAX_LEN are not cached.
+#define STEM_CACHE_SLOTS 1024
+#define STEM_CACHE_MAX_LEN 30
+// The hits and misses of a thread are added to the global counters by batches
+#define STEM_CACHE_STATS_BATCH 256
+
+typedef struct {
+  uint64_t hash;
+  uint8_t wordLen;  // 0 for an empty slot
+  uint8_t stemLen;
+  char word[STEM_CACHE_MAX_LEN];
+  char stem[STEM_CACHE_MAX_LEN + 1];
+} stemCacheEntry;
+
+typedef struct {
+  stemCacheEntry *langs[RS_LANG_UNSUPPORTED];
+  size_t hits;
+  size_t misses;
+} stemCache;
+
+static pthread_key_t stemCacheKey_g;
+static size_t stemCacheHits_g = 0;
+static size_t stemCacheMisses_g = 0;
+
+static void stemCacheFlushStats(stemCache *c) {
+  __atomic_add_fetch(&stemCacheHits_g, c->hits, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&stemCacheMisses_g, c->misses, __ATOMIC_RELAXED);
+  c->hits = c->misses = 0;
+}
+
+static void stemCacheFree(stemCache *c) {
+  stemCacheFlushStats(c);
+  for (size_t i = 0; i < RS_LANG_UNSUPPORTED; i++) {
+    rm_free(c->langs[i]);
+  }
+  rm_free(c);
+}
+
+static void __attribute__((constructor)) initStemCacheKey() {
+  pthread_key_create(&stemCacheKey_g, (void (*)(void *))stemCacheFree);
+}
+
+static inline stemCache *getStemCache() {
+  stemCache *c = pthread_getspecific(stemCacheKey_g);
+  if (c == NULL) {
+    c = rm_calloc(1, sizeof(*c));
+    pthread_setspecific(stemCacheKey_g, c);
+  }
+  return c;
+}
+
+static inline void stemCacheCount(stemCache *c, bool hit) {
+  hit ? c->hits++ : c->misses++;
+  if (c->hits + c->misses >= STEM_CACHE_STATS_BATCH) {
+    stemCacheFlushStats(c);
+  }
+}
+
+const char *SnowballStemmer_Stem(struct sb_stemmer *sb, RSLanguage language, const char *word,
+                                 size_t len, size_t *outlen) {
+  if (len == 0 || len > STEM_CACHE_MAX_LEN || language >= RS_LANG_UNSUPPORTED) {
+    const sb_symbol *stemmed = sb_stemmer_stem(sb, (const sb_symbol *)word, (int)len);
+    *outlen = stemmed ? sb_stemmer_length(sb) : 0;
+    return (const char *)stemmed;
+  }
+
+  stemCache *c = getStemCache();
+  if (!c->langs[language]) {
+    c->langs[language] = rm_calloc(STEM_CACHE_SLOTS, sizeof(stemCacheEntry));
+  }
+  uint64_t hash = fnv_64a_buf(word, len, 0);
+  stemCacheEntry *e = &c->langs[language][hash & (STEM_CACHE_SLOTS - 1)];
+  if (e->hash == hash && e->wordLen == len && !memcmp(e->word, word, len)) {
+    stemCacheCount(c, true);
+    *outlen = e->stemLen;
+    return e->stem;
+  }
+  stemCacheCount(c, false);
+
+  const sb_symbol *stemmed = sb_stemmer_stem(sb, (const sb_symbol *)word, (int)len);
+  if (!stemmed) {
+    *outlen = 0;
+    return NULL;
+  }
+  *outlen = sb_stemmer_length(sb);
+  if (*outlen <= STEM_CACHE_MAX_LEN) {
+    e->hash = hash;
+    e->wordLen = len;
+    e->stemLen = *outlen;
+    memcpy(e->word, word, len);
+    memcpy(e->stem, stemmed, *outlen);
+    e->stem[*outlen] = '\0';
+  }
+  return (const char *)stemmed;
+}
+
+StemmerCacheStats StemmerCache_GetStats() {
+  stemCache *c = pthread_getspecific(stemCacheKey_g);
+  if (c) {
+    stemCacheFlushStats(c);
+  }
+  return (StemmerCacheStats){
+      .hits = __atomic_load_n(&stemCacheHits_g, __ATOMIC_RELAXED),
+      .misses = __atomic_load_n(&stemCacheMisses_g, __ATOMIC_RELAXED),
+  };
+}
 
 struct sbStemmerCtx {
   struct sb_stemmer *sb;
+  RSLanguage language;
   char *buf;
   size_t cap;
 };
 
 const char *__sbstemmer_Stem(void *ctx, const char *word, size_t len, size_t *outlen) {
-  const sb_symbol *b = (const sb_symbol *)word;
   struct sbStemmerCtx *stctx = ctx;
-  struct sb_stemmer *sb = stctx->sb;
 
-  const sb_symbol *stemmed = sb_stemmer_stem(sb, b, (int)len);
+  const char *stemmed = SnowballStemmer_Stem(stctx->sb, stctx->language, word, len, outlen);
   if (stemmed) {
-    *outlen = sb_stemmer_length(sb);
-
     // if the stem and its origin are the same - don't do anything
     if (*outlen == len && strncasecmp(word, (const char *)stemmed, len) == 0) {
       return NULL;
@@ -42,7 +149,8 @@ const char *__sbstemmer_Stem(void *ctx, const char *word, size_t len, size_t *ou
       stctx->buf = rm_realloc(stctx->buf, stctx->cap);
     }
     // the first location is saved for the + prefix
-    memcpy(stctx->buf + 1, stemmed, *outlen + 1);
+    memcpy(stctx->buf + 1, stemmed, *outlen - 1);
+    stctx->buf[*outlen] = '\0';
     return (const char *)stctx->buf;
   }
   return NULL;
@@ -73,6 +181,7 @@ Stemmer *__newSnowballStemmer(RSLanguage language) {
 
   struct sbStemmerCtx *ctx = rm_malloc(sizeof(*ctx));
   ctx->sb = sb;
+  ctx->language = language;
   ctx->cap = 24;
   ctx->buf = rm_malloc(ctx->cap);
   ctx->buf[0] = STEM_PREFIX;
@@ -9,6 +9,8 @@
 #ifndef __RS_STEMMER_H__
 #define __RS_STEMMER_H__
 #include "language.h"
+#include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +43,24 @@ int ResetStemmer(Stemmer *stemmer, StemmerType type, RSLanguage language);
 /* Get a stemmer expander instance for registering it */
 void RegisterStemmerExpander();
 
+struct sb_stemmer;
+
+/* Stem `word` with the snowball stemmer `sb` of `language`. The stems of the last words stemmed by
+ * the calling thread are cached per language, so that the indexer and the query expander skip
+ * snowball for repeated words. Returns the stem and sets its length in `outlen`, or returns NULL
+ * if the word cannot be stemmed. The stem is only valid until the next call in the same thread */
+const char *SnowballStemmer_Stem(struct sb_stemmer *sb, RSLanguage language, const char *word,
+                                 size_t len, size_t *outlen);
+
+typedef struct {
+  size_t hits;
+  size_t misses;
+} StemmerCacheStats;
+
+/* Get the hits and misses of the stem caches of all the threads. The counts of the other threads
+ * are published by batches, so they may lag behind by a few hundred lookups */
+StemmerCacheStats StemmerCache_GetStats();
+
 /* Snoball Stemmer wrapper implementation */
 const char *__sbstemmer_Stem(void *ctx, const char *word, size_t len, size_t *outlen);
 void __sbstemmer_Free(Stemmer *s);
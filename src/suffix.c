@@ -166,7 +166,13 @@ static int recursiveAdd(TrieNode *node, SuffixCtx *sufCtx) {
 }
 
 void Suffix_IterateContains(SuffixCtx *sufCtx) {
-  if (sufCtx->type == SUFFIX_TYPE_CONTAINS) {
+  if (sufCtx->array) {
+    size_t len;
+    char *str = runesToStr(sufCtx->rune, sufCtx->runelen, &len);
+    SuffixArray_IterateContains(sufCtx->array, str, len, sufCtx->type == SUFFIX_TYPE_SUFFIX,
+                                sufCtx->callback, sufCtx->cbCtx, sufCtx->timeout);
+    rm_free(str);
+  } else if (sufCtx->type == SUFFIX_TYPE_CONTAINS) {
     // get string from node and children
     TrieNode *node = TrieNode_Get(sufCtx->root, sufCtx->rune, sufCtx->runelen, 0, NULL);
     if (!node) {
@@ -313,8 +319,7 @@ int Suffix_CB_Wildcard(const rune *rune, size_t len, void *p, void *payload) {
   suffixData *data = (suffixData *)pl->data;
   arrayof(char *) array = data->array;
   for (int i = 0; i < array_len(array); ++i) {
-    if (Wildcard_MatchChar(sufCtx->cstr, sufCtx->cstrlen, array[i], strlen(array[i]))
-            == FULL_MATCH) {
+    if (WildcardMatcher_Match(sufCtx->matcher, array[i], strlen(array[i]))) {
       if (sufCtx->callback(array[i], strlen(array[i]), sufCtx->cbCtx, NULL) != REDISMODULE_OK) {
         return REDISEARCH_ERR;
       }
@@ -323,7 +328,49 @@ int Suffix_CB_Wildcard(const rune *rune, size_t len, void *p, void *payload) {
   return REDISMODULE_OK;
 }
 
+static int Suffix_CB_ArrayWildcard(const char *term, size_t len, void *p, void *payload) {
+  SuffixCtx *sufCtx = p;
+  if (!WildcardMatcher_Match(sufCtx->matcher, term, len)) {
+    return REDISMODULE_OK;
+  }
+  return sufCtx->callback(term, len, sufCtx->cbCtx, NULL);
+}
+
+/* The suffix array only finds exact strings, so the terms matching the pattern are searched by the
+ * longest run of the pattern without `*` or `?`, which they all contain */
+static int Suffix_IterateArrayWildcard(SuffixCtx *sufCtx) {
+  size_t best = 0, bestLen = 0;
+  for (size_t i = 0; i < sufCtx->runelen;) {
+    size_t j = i;
+    while (j < sufCtx->runelen && sufCtx->rune[j] != (rune)'*' && sufCtx->rune[j] != (rune)'?') {
+      ++j;
+    }
+    if (j - i > bestLen) {
+      best = i;
+      bestLen = j - i;
+    }
+    i = j + 1;
+  }
+  if (bestLen < MIN_SUFFIX) {
+    return 0;
+  }
+
+  size_t len;
+  char *str = runesToStr(sufCtx->rune + best, bestLen, &len);
+  SuffixArray_IterateContains(sufCtx->array, str, len, false, Suffix_CB_ArrayWildcard, sufCtx,
+                              sufCtx->timeout);
+  rm_free(str);
+  return 1;
+}
+
 int Suffix_IterateWildcard(SuffixCtx *sufCtx) {
+  WildcardMatcher matcher;
+  WildcardMatcher_Init(&matcher, sufCtx->cstr, sufCtx->cstrlen);
+  sufCtx->matcher = &matcher;
+  if (sufCtx->array) {
+    return Suffix_IterateArrayWildcard(sufCtx);
+  }
+
   size_t idx[sufCtx->cstrlen];
   size_t lens[sufCtx->cstrlen];
   int useIdx = Suffix_ChooseToken_rune(sufCtx->rune, sufCtx->runelen, idx, lens);
@@ -454,15 +501,17 @@ arrayof(char**) GetList_SuffixTrieMap(TrieMap *trie, const char *str, uint32_t l
 static arrayof(char*) _getWildcardArray(TrieMapIterator *it, const char *pattern, uint32_t plen, long long maxPrefixExpansions) {
   char *s;
   tm_len_t sl;
-  suffixData *nodeData;;
+  suffixData *nodeData;
   arrayof(char*) resArray = NULL;
+  WildcardMatcher matcher;
+  WildcardMatcher_Init(&matcher, pattern, plen);
 
   while (TrieMapIterator_Next(it, &s, &sl, (void **)&nodeData)) {
     for (int i = 0; i < array_len(nodeData->array); ++i) {
       if (array_len(resArray) > maxPrefixExpansions) {
         goto end;
       }
-      if (Wildcard_MatchChar(pattern, plen, nodeData->array[i], strlen(nodeData->array[i])) == FULL_MATCH) {
+      if (WildcardMatcher_Match(&matcher, nodeData->array[i], strlen(nodeData->array[i]))) {
         resArray = array_ensure_append_1(resArray, nodeData->array[i]);
       }
     }
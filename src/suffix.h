@@ -14,6 +14,8 @@ extern "C" {
 
 #include "trie/trie_type.h"
 #include "triemap.h"
+#include "suffix_array.h"
+#include "wildcard.h"
 #include "util/arr.h"
 
 #define MIN_SUFFIX 2
@@ -29,10 +31,12 @@ typedef enum {
 /***********************************************************/
 typedef struct SuffixCtx {
     TrieNode *root;
+    SuffixArray *array;  // Searched instead of the trie if set
     rune *rune;
     size_t runelen;
     const char *cstr;
     size_t cstrlen;
+    const WildcardMatcher *matcher;  // Of `cstr`, set while iterating wildcard matches
     SuffixType type;
     TrieSuffixCallback *callback;
     void *cbCtx;
@@ -52,10 +56,10 @@ void deleteSuffixTrie(Trie *trie, const char *str, uint32_t len);
 
 void suffixTrie_freeCallback(void *data);
 
-/* Iterate on suffix trie and add use callback function on results */
+/* Iterate on suffix trie, or suffix array, and add use callback function on results */
 void Suffix_IterateContains(SuffixCtx *sufCtx);
 
-/* Iterate on suffix trie and add use callback function on results
+/* Iterate on suffix trie, or suffix array, and add use callback function on results
  * If wildcard pattern does not support suffix trie, return 0, else return 1. */
 int Suffix_IterateWildcard(SuffixCtx *sufCtx);
 
@@ -0,0 +1,374 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "suffix_array.h"
+#include "triemap.h"
+#include "rmalloc.h"
+#include "util/arr.h"
+#include "util/timeout.h"
+#include "rmutil/rm_assert.h"
+
+#include <string.h>
+
+typedef struct {
+  char *text;          // The terms in increasing order, each one followed by a '\0'
+  uint32_t *terms;     // The offset of each term in the text
+  uint32_t *suffixes;  // The offsets of the suffixes of all the terms in the text, in suffix order
+  uint64_t *deleted;   // A bit per deleted term
+  uint32_t textLen;
+  uint32_t numTerms;
+  uint32_t numSuffixes;
+  uint32_t numDeleted;
+} SuffixSegment;
+
+struct SuffixArray {
+  arrayof(SuffixSegment *) segments;  // From the oldest and largest
+  TrieMap *pending;                   // The terms added since the last segment, to a copy of them
+  size_t numTerms;
+};
+
+// Compares the term at `s` in the text of a segment with a term which is not NUL-terminated
+static int compareTerm(const char *s, const char *term, size_t len) {
+  int rc = strncmp(s, term, len);
+  return rc ? rc : (unsigned char)s[len];
+}
+
+static int comparePtrs(const void *a, const void *b) {
+  return strcmp(*(const char **)a, *(const char **)b);
+}
+
+static inline size_t segment_TermLen(const SuffixSegment *seg, uint32_t i) {
+  uint32_t end = i + 1 < seg->numTerms ? seg->terms[i + 1] : seg->textLen;
+  return end - seg->terms[i] - 1;
+}
+
+static inline bool segment_IsDeleted(const SuffixSegment *seg, uint32_t i) {
+  return seg->deleted[i / 64] & (1ULL << (i % 64));
+}
+
+static inline size_t segment_NumLive(const SuffixSegment *seg) {
+  return seg->numTerms - seg->numDeleted;
+}
+
+/* Builds a segment of `n` terms, which are in increasing order. Only the suffixes starting at the
+ * first byte of a UTF-8 sequence are indexed, since the query strings are whole runes */
+static SuffixSegment *newSegment(const char **terms, const size_t *lens, size_t n) {
+  size_t textLen = 0, numSuffixes = 0;
+  for (size_t i = 0; i < n; i++) {
+    textLen += lens[i] + 1;
+    for (size_t j = 0; j < lens[i]; j++) {
+      numSuffixes += (terms[i][j] & 0xc0) != 0x80;
+    }
+  }
+  RS_LOG_ASSERT(textLen <= UINT32_MAX, "suffix array segment is too large");
+
+  SuffixSegment *seg = rm_calloc(1, sizeof(*seg));
+  seg->text = rm_malloc(textLen);
+  seg->terms = rm_malloc(n * sizeof(*seg->terms));
+  seg->suffixes = rm_malloc(numSuffixes * sizeof(*seg->suffixes));
+  seg->deleted = rm_calloc((n + 63) / 64, sizeof(*seg->deleted));
+  seg->textLen = textLen;
+  seg->numTerms = n;
+  seg->numSuffixes = numSuffixes;
+
+  const char **ptrs = rm_malloc(numSuffixes * sizeof(*ptrs));
+  size_t offset = 0, k = 0;
+  for (size_t i = 0; i < n; i++) {
+    seg->terms[i] = offset;
+    memcpy(seg->text + offset, terms[i], lens[i]);
+    seg->text[offset + lens[i]] = '\0';
+    for (size_t j = 0; j < lens[i]; j++) {
+      if ((terms[i][j] & 0xc0) != 0x80) {
+        ptrs[k++] = seg->text + offset + j;
+      }
+    }
+    offset += lens[i] + 1;
+  }
+  qsort(ptrs, numSuffixes, sizeof(*ptrs), comparePtrs);
+  for (size_t i = 0; i < numSuffixes; i++) {
+    seg->suffixes[i] = ptrs[i] - seg->text;
+  }
+  rm_free(ptrs);
+  return seg;
+}
+
+static void segment_Free(SuffixSegment *seg) {
+  rm_free(seg->text);
+  rm_free(seg->terms);
+  rm_free(seg->suffixes);
+  rm_free(seg->deleted);
+  rm_free(seg);
+}
+
+// Returns the index of a term in the segment, or -1
+static int64_t segment_Find(const SuffixSegment *seg, const char *term, size_t len) {
+  size_t lo = 0, hi = seg->numTerms;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int rc = compareTerm(seg->text + seg->terms[mid], term, len);
+    if (rc == 0) {
+      return mid;
+    } else if (rc < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return -1;
+}
+
+// Returns the index of the term holding the suffix at `offset`
+static uint32_t segment_TermOf(const SuffixSegment *seg, uint32_t offset) {
+  size_t lo = 0, hi = seg->numTerms;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (seg->terms[mid] <= offset) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// Appends the live terms of the segments, in increasing order
+static void segment_CollectLive(const SuffixSegment *a, const SuffixSegment *b,
+                                arrayof(const char *) *terms, arrayof(size_t) *lens) {
+  uint32_t i = 0, j = 0;
+  uint32_t na = a->numTerms, nb = b ? b->numTerms : 0;
+  while (i < na || j < nb) {
+    const SuffixSegment *seg;
+    uint32_t idx;
+    if (j == nb || (i < na && strcmp(a->text + a->terms[i], b->text + b->terms[j]) < 0)) {
+      seg = a;
+      idx = i++;
+    } else {
+      seg = b;
+      idx = j++;
+    }
+    if (!segment_IsDeleted(seg, idx)) {
+      array_append(*terms, seg->text + seg->terms[idx]);
+      array_append(*lens, segment_TermLen(seg, idx));
+    }
+  }
+}
+
+// Replaces `a`, and `b` if not NULL, by a segment of their live terms, or NULL if there are none
+static SuffixSegment *segment_Merge(SuffixSegment *a, SuffixSegment *b) {
+  size_t cap = segment_NumLive(a) + (b ? segment_NumLive(b) : 0);
+  arrayof(const char *) terms = array_new(const char *, cap);
+  arrayof(size_t) lens = array_new(size_t, cap);
+  segment_CollectLive(a, b, &terms, &lens);
+  SuffixSegment *seg = array_len(terms) ? newSegment(terms, lens, array_len(terms)) : NULL;
+  array_free(terms);
+  array_free(lens);
+  segment_Free(a);
+  if (b) {
+    segment_Free(b);
+  }
+  return seg;
+}
+
+SuffixArray *NewSuffixArray(void) {
+  SuffixArray *sa = rm_calloc(1, sizeof(*sa));
+  sa->segments = array_new(SuffixSegment *, 4);
+  sa->pending = NewTrieMap();
+  return sa;
+}
+
+void SuffixArray_Free(SuffixArray *sa) {
+  array_free_ex(sa->segments, segment_Free(*(SuffixSegment **)ptr));
+  TrieMap_Free(sa->pending, rm_free);
+  rm_free(sa);
+}
+
+// Moves the pending terms into a new segment, and merges it with the previous segments as long as
+// they are not more than twice as large
+static void flushPending(SuffixArray *sa) {
+  size_t n = TrieMap_NUniqueKeys(sa->pending);
+  const char **terms = rm_malloc(n * sizeof(*terms));
+  size_t *lens = rm_malloc(n * sizeof(*lens));
+  TrieMapIterator *it = TrieMap_Iterate(sa->pending);
+  char *key;
+  tm_len_t len;
+  void *copy;
+  size_t i = 0;
+  while (TrieMapIterator_Next(it, &key, &len, &copy)) {
+    terms[i++] = copy;
+  }
+  TrieMapIterator_Free(it);
+  RS_LOG_ASSERT(i == n, "pending terms must all be iterated");
+
+  // The copies are NUL-terminated
+  qsort(terms, n, sizeof(*terms), comparePtrs);
+  for (i = 0; i < n; i++) {
+    lens[i] = strlen(terms[i]);
+  }
+  array_append(sa->segments, newSegment(terms, lens, n));
+  rm_free(terms);
+  rm_free(lens);
+  TrieMap_Free(sa->pending, rm_free);
+  sa->pending = NewTrieMap();
+
+  uint32_t numSegments;
+  while ((numSegments = array_len(sa->segments)) > 1 &&
+         2 * segment_NumLive(sa->segments[numSegments - 1]) >=
+             segment_NumLive(sa->segments[numSegments - 2])) {
+    SuffixSegment *last = array_pop(sa->segments);
+    SuffixSegment *merged = segment_Merge(sa->segments[numSegments - 2], last);
+    if (merged) {
+      sa->segments[numSegments - 2] = merged;
+    } else {
+      array_pop(sa->segments);
+    }
+  }
+}
+
+void SuffixArray_Add(SuffixArray *sa, const char *term, size_t len) {
+  // Like the suffix trie, the terms are limited to the length of the keys of a trie
+  if (len == 0 || len > UINT16_MAX || TrieMap_Find(sa->pending, term, len) != TRIEMAP_NOTFOUND) {
+    return;
+  }
+  for (uint32_t i = 0; i < array_len(sa->segments); i++) {
+    SuffixSegment *seg = sa->segments[i];
+    int64_t idx = segment_Find(seg, term, len);
+    if (idx >= 0) {
+      if (segment_IsDeleted(seg, idx)) {
+        seg->deleted[idx / 64] &= ~(1ULL << (idx % 64));
+        seg->numDeleted--;
+        sa->numTerms++;
+      }
+      return;
+    }
+  }
+
+  TrieMap_Add(sa->pending, term, len, rm_strndup(term, len), NULL);
+  sa->numTerms++;
+  if (TrieMap_NUniqueKeys(sa->pending) >= SUFFIX_ARRAY_PENDING_TERMS) {
+    flushPending(sa);
+  }
+}
+
+void SuffixArray_Delete(SuffixArray *sa, const char *term, size_t len) {
+  if (len == 0 || len > UINT16_MAX) {
+    return;
+  }
+  if (TrieMap_Find(sa->pending, term, len) != TRIEMAP_NOTFOUND) {
+    TrieMap_Delete(sa->pending, term, len, rm_free);
+    sa->numTerms--;
+    return;
+  }
+  for (uint32_t i = 0; i < array_len(sa->segments); i++) {
+    SuffixSegment *seg = sa->segments[i];
+    int64_t idx = segment_Find(seg, term, len);
+    if (idx < 0) {
+      continue;
+    }
+    if (!segment_IsDeleted(seg, idx)) {
+      seg->deleted[idx / 64] |= 1ULL << (idx % 64);
+      seg->numDeleted++;
+      sa->numTerms--;
+      // Rebuild the segment once half its terms are deleted
+      if (2 * seg->numDeleted > seg->numTerms) {
+        SuffixSegment *rebuilt = segment_Merge(seg, NULL);
+        if (rebuilt) {
+          sa->segments[i] = rebuilt;
+        } else {
+          sa->segments = array_del(sa->segments, i);
+        }
+      }
+    }
+    return;
+  }
+}
+
+static int cmpU32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Returns REDISEARCH_OK if the iteration should go on
+static int segment_IterateContains(const SuffixSegment *seg, const char *str, size_t len,
+                                   bool suffixOnly, TrieSuffixCallback *cb, void *ctx) {
+  // The suffixes starting with `str` are contiguous
+  size_t lo = 0, hi = seg->numSuffixes;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (strncmp(seg->text + seg->suffixes[mid], str, len) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // A term can contain the string more than once, so its index is collected once per occurrence
+  arrayof(uint32_t) matches = array_new(uint32_t, 16);
+  for (size_t i = lo; i < seg->numSuffixes && !strncmp(seg->text + seg->suffixes[i], str, len); i++) {
+    uint32_t offset = seg->suffixes[i];
+    if (suffixOnly && seg->text[offset + len] != '\0') {
+      continue;
+    }
+    uint32_t idx = segment_TermOf(seg, offset);
+    if (!segment_IsDeleted(seg, idx)) {
+      array_append(matches, idx);
+    }
+  }
+  qsort(matches, array_len(matches), sizeof(*matches), cmpU32);
+
+  int rc = REDISEARCH_OK;
+  for (uint32_t i = 0; i < array_len(matches) && rc == REDISEARCH_OK; i++) {
+    if (i && matches[i] == matches[i - 1]) {
+      continue;
+    }
+    rc = cb(seg->text + seg->terms[matches[i]], segment_TermLen(seg, matches[i]), ctx, NULL);
+  }
+  array_free(matches);
+  return rc;
+}
+
+void SuffixArray_IterateContains(const SuffixArray *sa, const char *str, size_t len, bool suffixOnly,
+                                 TrieSuffixCallback *cb, void *ctx, const struct timespec *timeout) {
+  size_t counter = 0;
+  for (uint32_t i = 0; i < array_len(sa->segments); i++) {
+    if (segment_IterateContains(sa->segments[i], str, len, suffixOnly, cb, ctx) != REDISEARCH_OK ||
+        (timeout && TimedOut_WithCounter(timeout, &counter))) {
+      return;
+    }
+  }
+
+  // The pending terms are few enough to be scanned
+  TrieMapIterator *it = TrieMap_Iterate(sa->pending);
+  char *key;
+  tm_len_t keyLen;
+  void *copy;
+  while (TrieMapIterator_Next(it, &key, &keyLen, &copy)) {
+    bool match = suffixOnly ? keyLen >= len && !memcmp(key + keyLen - len, str, len)
+                            : memmem(key, keyLen, str, len) != NULL;
+    if ((match && cb(copy, keyLen, ctx, NULL) != REDISEARCH_OK) ||
+        (timeout && TimedOut_WithCounter(timeout, &counter))) {
+      break;
+    }
+  }
+  TrieMapIterator_Free(it);
+}
+
+size_t SuffixArray_NumTerms(const SuffixArray *sa) {
+  return sa->numTerms;
+}
+
+size_t SuffixArray_MemUsage(const SuffixArray *sa) {
+  size_t mem = sizeof(*sa) + TrieMap_MemUsage(sa->pending) +
+               array_len(sa->segments) * sizeof(*sa->segments);
+  for (uint32_t i = 0; i < array_len(sa->segments); i++) {
+    const SuffixSegment *seg = sa->segments[i];
+    mem += sizeof(*seg) + seg->textLen + seg->numTerms * sizeof(*seg->terms) +
+           seg->numSuffixes * sizeof(*seg->suffixes) + (seg->numTerms + 63) / 64 * sizeof(*seg->deleted);
+  }
+  return mem;
+}
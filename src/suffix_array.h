@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "trie/trie.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The number of terms added to a suffix array since its last segment from which they are moved
+// into a new segment
+#define SUFFIX_ARRAY_PENDING_TERMS 1024
+
+/**
+ * A suffix index of a set of terms, which answers the contains and suffix queries of the TEXT
+ * fields WITHSUFFIXTRIE as the suffix trie does, in a fraction of its memory.
+ *
+ * The terms are kept in immutable segments. Each one holds the text of its terms and the sorted
+ * offsets of all their suffixes, so that the terms containing a string are found with a binary
+ * search. The terms added since the last segment are kept aside until there are
+ * SUFFIX_ARRAY_PENDING_TERMS of them, and then the segments are merged, as in a log-structured
+ * merge tree, so that each one holds more than twice as many terms as the next. Deleted terms are
+ * only marked as such, until half the terms of their segment are deleted.
+ */
+typedef struct SuffixArray SuffixArray;
+
+SuffixArray *NewSuffixArray(void);
+
+void SuffixArray_Free(SuffixArray *sa);
+
+/* Adds a term, unless it is already in the array */
+void SuffixArray_Add(SuffixArray *sa, const char *term, size_t len);
+
+/* Deletes a term, if it is in the array */
+void SuffixArray_Delete(SuffixArray *sa, const char *term, size_t len);
+
+/* Calls `cb` once for each term containing `str`, or only ending with it if `suffixOnly`, until it
+ * returns something other than REDISEARCH_OK or the timeout is reached. The terms are passed
+ * without a payload, and stay valid until the array is modified */
+void SuffixArray_IterateContains(const SuffixArray *sa, const char *str, size_t len, bool suffixOnly,
+                                 TrieSuffixCallback *cb, void *ctx, const struct timespec *timeout);
+
+size_t SuffixArray_NumTerms(const SuffixArray *sa);
+
+size_t SuffixArray_MemUsage(const SuffixArray *sa);
+
+#ifdef __cplusplus
+}
+#endif
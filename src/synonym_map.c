@@ -195,6 +195,22 @@ TermData** SynonymMap_DumpAllTerms(SynonymMap* smap, size_t* size) {
   return dump;
 }
 
+const char** SynonymMap_GetGroupTerms(SynonymMap* smap, const char* groupId, size_t* size) {
+  const char** terms = rm_malloc(sizeof(char*) * dictSize(smap->h_table));
+  size_t j = 0;
+  dictIterator* iter = dictGetIterator(smap->h_table);
+  dictEntry* entry = NULL;
+  while ((entry = dictNext(iter))) {
+    TermData* val = dictGetVal(entry);
+    if (TermData_IdExists(val, groupId)) {
+      terms[j++] = val->term;
+    }
+  }
+  dictReleaseIterator(iter);
+  *size = j;
+  return terms;
+}
+
 static void SynonymMap_CopyEntry(SynonymMap* smap, const char* key, TermData* t_data) {
   dictAdd(smap->h_table, (char*)key, TermData_Copy(t_data));
 }
@@ -91,6 +91,15 @@ TermData* SynonymMap_GetIdsBySynonym(SynonymMap* smap, const char* synonym, size
  */
 TermData** SynonymMap_DumpAllTerms(SynonymMap* smap, size_t* size);
 
+/**
+ * Return the terms of a synonym group, which are owned by the map. The array should be freed with
+ * rm_free
+ * smap - the synonym map
+ * groupId - the id of the group, without the `~` prefix
+ * size - a pointer to size_t to retrieve the result size
+ */
+const char** SynonymMap_GetGroupTerms(SynonymMap* smap, const char* groupId, size_t* size);
+
 /**
  * Return an str representation of the given id
  * id - the id
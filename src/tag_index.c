@@ -19,6 +19,12 @@
 #include "rmutil/rm_assert.h"
 #include "resp3.h"
 #include "iterators/inverted_index_iterator.h"
+#include "iterators/idlist_iterator.h"
+#include "util/fnv.h"
+#include "util/heap.h"
+#include "util/timeout.h"
+#include "wildcard.h"
+#include "rdb.h"
 
 extern RedisModuleCtx *RSDummyContext;
 
@@ -30,8 +36,16 @@ static uint32_t tagUniqueId = 0;
 TagIndex *NewTagIndex() {
   TagIndex *idx = rm_new(TagIndex);
   idx->values = NewTrieMap();
+  idx->frozen = NULL;
+  idx->numFrozen = 0;
   idx->uniqueId = tagUniqueId++;
   idx->suffix = NULL;
+  idx->revision = 0;
+  memset(&idx->setCache, 0, sizeof(idx->setCache));
+  pthread_mutex_init(&idx->setCache.lock, NULL);
+  idx->freqs = NULL;
+  idx->numFreqs = 0;
+  idx->freqsRevision = 0;
   return idx;
 }
 
@@ -188,9 +202,20 @@ struct InvertedIndex *TagIndex_OpenIndex(const TagIndex *idx, const char *value,
                                           size_t len, int create_if_missing, size_t *sz) {
   *sz = 0;
   InvertedIndex *iv = TrieMap_Find(idx->values, value, len);
-  if (iv == TRIEMAP_NOTFOUND) {
-    if (create_if_missing) {
-      iv = NewInvertedIndex(Index_DocIdsOnly, sz);
+  if (iv != TRIEMAP_NOTFOUND) {
+    return iv;
+  }
+  // A value is either in the trie or in the compacted values, where it stays once deleted
+  void **slot = idx->frozen ? FrontCodedDict_Find(idx->frozen, value, len) : NULL;
+  if (slot && *slot) {
+    return *slot;
+  }
+  if (create_if_missing) {
+    iv = NewInvertedIndex(Index_DocIdsOnly, sz);
+    if (slot) {
+      *slot = iv;
+      ((TagIndex *)idx)->numFrozen++;
+    } else {
       TrieMap_Add(idx->values, value, len, iv, NULL);
     }
   }
@@ -204,6 +229,7 @@ static inline size_t tagIndex_Put(TagIndex *idx, const char *value, size_t len,
   size_t sz;
   RSIndexResult rec = {.data.tag = RSResultData_Virtual, .docId = docId, .freq = 0};
   InvertedIndex *iv = TagIndex_OpenIndex(idx, value, len, CREATE_INDEX, &sz);
+  idx->revision++;
   return InvertedIndex_WriteEntryGeneric(iv, &rec) + sz;
 }
 
@@ -237,13 +263,317 @@ static QueryIterator *TagIndex_GetReader(const TagIndex *idx, const RedisSearchC
 QueryIterator *TagIndex_OpenReader(TagIndex *idx, const RedisSearchCtx *sctx, const char *value, size_t len,
                                    double weight, t_fieldIndex fieldIndex) {
 
-  InvertedIndex *iv = TrieMap_Find(idx->values, (char *)value, len);
+  size_t sz;
+  InvertedIndex *iv = TagIndex_OpenIndex(idx, value, len, DONT_CREATE_INDEX, &sz);
   if (iv == TRIEMAP_NOTFOUND || !iv || InvertedIndex_NumDocs(iv) == 0) {
     return NULL;
   }
   return TagIndex_GetReader(idx, sctx, iv, value, len, weight, fieldIndex);
 }
 
+#define TAG_SET_BATCH 1024
+
+static int cmpSetValues(const void *a, const void *b) {
+  return strcmp(*(const char **)a, *(const char **)b);
+}
+
+static int cmpDocIds(const void *a, const void *b) {
+  t_docId x = *(const t_docId *)a, y = *(const t_docId *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Reads the documents of the values into a sorted list of distinct ids, in a bitmap when the ids
+// are dense enough, and otherwise in an array which is sorted afterwards
+static t_docId *readSetIds(TagIndex *idx, const RedisSearchCtx *sctx, char **values, size_t n,
+                           t_fieldIndex fieldIndex, size_t *count) {
+  t_docId maxId = 0;
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    size_t sz;
+    InvertedIndex *iv = TagIndex_OpenIndex(idx, values[i], strlen(values[i]), DONT_CREATE_INDEX, &sz);
+    if (iv && iv != TRIEMAP_NOTFOUND) {
+      total += InvertedIndex_NumDocs(iv);
+      t_docId lastId = InvertedIndex_LastId(iv);
+      maxId = lastId > maxId ? lastId : maxId;
+    }
+  }
+  *count = 0;
+  if (!total) {
+    return NULL;
+  }
+
+  size_t nwords = maxId / 64 + 1;
+  bool dense = nwords <= total;
+  uint64_t *bits = dense ? rm_calloc(nwords, sizeof(*bits)) : NULL;
+  t_docId *ids = dense ? NULL : rm_malloc(total * sizeof(*ids));
+  size_t k = 0;
+  t_docId batch[TAG_SET_BATCH];
+  for (size_t i = 0; i < n; i++) {
+    QueryIterator *it = TagIndex_OpenReader(idx, sctx, values[i], strlen(values[i]), 1, fieldIndex);
+    if (!it) {
+      continue;
+    }
+    size_t nread;
+    while (it->ReadBatch(it, batch, TAG_SET_BATCH, &nread) == ITERATOR_OK) {
+      for (size_t j = 0; j < nread; j++) {
+        if (dense) {
+          uint64_t bit = 1ULL << (batch[j] % 64);
+          uint64_t *word = &bits[batch[j] / 64];
+          k += !(*word & bit);
+          *word |= bit;
+        } else {
+          if (k == total) {
+            total *= 2;
+            ids = rm_realloc(ids, total * sizeof(*ids));
+          }
+          ids[k++] = batch[j];
+        }
+      }
+    }
+    it->Free(it);
+  }
+
+  if (dense) {
+    ids = k ? rm_malloc(k * sizeof(*ids)) : NULL;
+    size_t j = 0;
+    for (size_t w = 0; w < nwords; w++) {
+      for (uint64_t word = bits[w]; word; word &= word - 1) {
+        ids[j++] = w * 64 + __builtin_ctzll(word);
+      }
+    }
+    rm_free(bits);
+  } else if (k) {
+    qsort(ids, k, sizeof(*ids), cmpDocIds);
+    size_t j = 1;
+    for (size_t i = 1; i < k; i++) {
+      if (ids[i] != ids[j - 1]) {
+        ids[j++] = ids[i];
+      }
+    }
+    k = j;
+  }
+  if (!k) {
+    rm_free(ids);
+    return NULL;
+  }
+  *count = k;
+  return ids;
+}
+
+static TagSetCacheEntry *findCachedSet(TagIndex *idx, uint64_t hash, const char *key, size_t keyLen) {
+  for (size_t i = 0; i < TAG_SET_CACHE_SIZE; i++) {
+    TagSetCacheEntry *e = &idx->setCache.entries[i];
+    if (e->key && e->hash == hash && e->revision == idx->revision && e->keyLen == keyLen &&
+        !memcmp(e->key, key, keyLen)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+QueryIterator *TagIndex_OpenSetReader(TagIndex *idx, const RedisSearchCtx *sctx, char **values,
+                                      size_t n, double weight, t_fieldIndex fieldIndex) {
+  // The key of the set is its sorted distinct values, so that it does not depend on their order
+  qsort(values, n, sizeof(*values), cmpSetValues);
+  size_t keyLen = 0;
+  for (size_t i = 0; i < n; i++) {
+    keyLen += strlen(values[i]) + 1;
+  }
+  char *key = rm_malloc(keyLen);
+  size_t numValues = 0;
+  keyLen = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (numValues && !strcmp(values[i], values[numValues - 1])) {
+      continue;
+    }
+    values[numValues++] = values[i];
+    size_t len = strlen(values[i]) + 1;
+    memcpy(key + keyLen, values[i], len);
+    keyLen += len;
+  }
+
+  // The documents of an expiring field depend on the time of the query
+  bool cacheable = !sctx || !(sctx->spec->docs.ttl && sctx->spec->monitorFieldExpiration);
+  uint64_t hash = fnv_64a_buf(key, keyLen, 0);
+  TagSetCache *cache = &idx->setCache;
+  t_docId *ids = NULL;
+  size_t count = 0;
+  if (cacheable) {
+    pthread_mutex_lock(&cache->lock);
+    TagSetCacheEntry *e = findCachedSet(idx, hash, key, keyLen);
+    if (e && e->numIds) {
+      count = e->numIds;
+      ids = rm_malloc(count * sizeof(*ids));
+      memcpy(ids, e->ids, count * sizeof(*ids));
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (e) {
+      rm_free(key);
+      return count ? NewIdListIterator(ids, count, weight) : NULL;
+    }
+  }
+
+  ids = readSetIds(idx, sctx, values, numValues, fieldIndex, &count);
+  if (!cacheable || count > TAG_SET_CACHE_MAX_IDS) {
+    rm_free(key);
+  } else {
+    pthread_mutex_lock(&cache->lock);
+    if (findCachedSet(idx, hash, key, keyLen)) {
+      // Another query cached the same set meanwhile
+      rm_free(key);
+    } else {
+      TagSetCacheEntry *e = &cache->entries[cache->next];
+      cache->next = (cache->next + 1) % TAG_SET_CACHE_SIZE;
+      rm_free(e->key);
+      rm_free(e->ids);
+      *e = (TagSetCacheEntry){.hash = hash, .revision = idx->revision, .key = key, .keyLen = keyLen,
+                              .numIds = count};
+      if (count) {
+        e->ids = rm_malloc(count * sizeof(*ids));
+        memcpy(e->ids, ids, count * sizeof(*ids));
+      }
+    }
+    pthread_mutex_unlock(&cache->lock);
+  }
+  return count ? NewIdListIterator(ids, count, weight) : NULL;
+}
+
+int TagValueCount_Compare(const void *a, const void *b) {
+  const TagValueCount *x = a, *y = b;
+  if (x->count != y->count) {
+    return x->count > y->count ? -1 : 1;
+  }
+  int rc = memcmp(x->value, y->value, MIN(x->len, y->len));
+  return rc ? rc : (x->len > y->len) - (x->len < y->len);
+}
+
+// The heap keeps the worst of the top values at its root
+static int cmpHeapValueCounts(const void *a, const void *b, const void *udata) {
+  return TagValueCount_Compare(a, b);
+}
+
+static void freeValueCounts(TagValueCount *counts, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    rm_free(counts[i].value);
+  }
+  rm_free(counts);
+}
+
+// Returns the table of the values by decreasing number of documents, building it if the index
+// changed since it was last built. The table stays valid under the read lock of the spec
+static const TagValueCount *frequencyTable(TagIndex *idx, size_t *n) {
+  TagSetCache *cache = &idx->setCache;
+  pthread_mutex_lock(&cache->lock);
+  bool fresh = idx->freqs && idx->freqsRevision == idx->revision;
+  pthread_mutex_unlock(&cache->lock);
+  if (!fresh) {
+    size_t cap = TagIndex_NumValues(idx), count = 0;
+    TagValueCount *freqs = rm_malloc(MAX(cap, 1) * sizeof(*freqs));
+    TagValuesIterator *it = TagIndex_IterateValues(idx, NULL, 0, TM_PREFIX_MODE);
+    char *str;
+    tm_len_t len;
+    InvertedIndex *iv;
+    while (TagValuesIterator_Next(it, &str, &len, &iv)) {
+      if (count == cap) {
+        cap = cap * 2 + 1;
+        freqs = rm_realloc(freqs, cap * sizeof(*freqs));
+      }
+      freqs[count++] = (TagValueCount){.value = rm_strndup(str, len), .len = len,
+                                       .count = InvertedIndex_NumDocs(iv)};
+    }
+    TagValuesIterator_Free(it);
+    qsort(freqs, count, sizeof(*freqs), TagValueCount_Compare);
+
+    pthread_mutex_lock(&cache->lock);
+    if (idx->freqs && idx->freqsRevision == idx->revision) {
+      // Another query built the same table meanwhile
+      freeValueCounts(freqs, count);
+    } else {
+      freeValueCounts(idx->freqs, idx->numFreqs);
+      idx->freqs = freqs;
+      idx->numFreqs = count;
+      idx->freqsRevision = idx->revision;
+    }
+    pthread_mutex_unlock(&cache->lock);
+  }
+  *n = idx->numFreqs;
+  return idx->freqs;
+}
+
+static size_t countSetDocs(TagIndex *idx, const RedisSearchCtx *sctx, const TagValueCount *v,
+                           const uint64_t *docs, size_t nwords, t_fieldIndex fieldIndex) {
+  QueryIterator *it = TagIndex_OpenReader(idx, sctx, v->value, v->len, 1, fieldIndex);
+  if (!it) {
+    return 0;
+  }
+  size_t count = 0, n;
+  t_docId batch[TAG_SET_BATCH];
+  while (it->ReadBatch(it, batch, TAG_SET_BATCH, &n) == ITERATOR_OK) {
+    for (size_t j = 0; j < n; j++) {
+      t_docId id = batch[j];
+      count += id / 64 < nwords && (docs[id / 64] >> (id % 64)) & 1;
+    }
+  }
+  it->Free(it);
+  return count;
+}
+
+arrayof(TagValueCount) TagIndex_TopValues(TagIndex *idx, const RedisSearchCtx *sctx,
+                                          const uint64_t *docs, size_t nwords, size_t max,
+                                          t_fieldIndex fieldIndex) {
+  size_t numFreqs;
+  const TagValueCount *freqs = frequencyTable(idx, &numFreqs);
+  if (!max || max > numFreqs) {
+    max = numFreqs;
+  }
+  arrayof(TagValueCount) top = array_new(TagValueCount, max);
+  if (!docs) {
+    for (size_t i = 0; i < max; i++) {
+      TagValueCount v = freqs[i];
+      v.value = rm_strndup(v.value, v.len);
+      array_append(top, v);
+    }
+    return top;
+  }
+
+  heap_t *heap = rm_malloc(heap_sizeof(max));
+  heap_init(heap, cmpHeapValueCounts, NULL, max);
+  TagValueCount *counts = rm_malloc(MAX(max, 1) * sizeof(*counts));
+  size_t numCounts = 0;
+  for (size_t i = 0; i < numFreqs && max; i++) {
+    const TagValueCount *worst = heap_count(heap) == max ? heap_peek(heap) : NULL;
+    // A value has at most as many documents in the set as in the index
+    if (worst && freqs[i].count < worst->count) {
+      break;
+    }
+    TagValueCount v = freqs[i];
+    v.count = countSetDocs(idx, sctx, &freqs[i], docs, nwords, fieldIndex);
+    if (!v.count || (worst && TagValueCount_Compare(&v, worst) >= 0)) {
+      continue;
+    }
+    // The slot of the evicted value is reused for the new one
+    TagValueCount *slot = worst ? (TagValueCount *)worst : &counts[numCounts++];
+    if (worst) {
+      heap_poll(heap);
+    }
+    *slot = v;
+    heap_offerx(heap, slot);
+  }
+  heap_free(heap);
+
+  qsort(counts, numCounts, sizeof(*counts), TagValueCount_Compare);
+  for (size_t i = 0; i < numCounts; i++) {
+    counts[i].value = rm_strndup(counts[i].value, counts[i].len);
+    array_append(top, counts[i]);
+  }
+  rm_free(counts);
+  return top;
+}
+
+void TagValueCounts_Free(arrayof(TagValueCount) counts) {
+  array_free_ex(counts, rm_free(((TagValueCount *)ptr)->value));
+}
+
 /* Format the key name for a tag index */
 RedisModuleString *TagIndex_FormatName(const IndexSpec *spec, const HiddenString* field) {
   return RedisModule_CreateStringPrintf(RSDummyContext, TAG_INDEX_KEY_FMT, HiddenString_GetUnsafe(spec->specName, NULL), HiddenString_GetUnsafe(field, NULL));
@@ -265,32 +595,317 @@ TagIndex *TagIndex_Open(const IndexSpec *spec, RedisModuleString *key, bool crea
   return kdv->p;
 }
 
+void TagIndex_DeleteValue(TagIndex *idx, const char *value, size_t len) {
+  if (TrieMap_Delete(idx->values, value, len, (void (*)(void *))InvertedIndex_Free)) {
+    idx->revision++;
+    return;
+  }
+  void **slot = idx->frozen ? FrontCodedDict_Find(idx->frozen, value, len) : NULL;
+  if (slot && *slot) {
+    InvertedIndex_Free(*slot);
+    *slot = NULL;
+    idx->numFrozen--;
+  }
+  idx->revision++;
+}
+
+size_t TagIndex_NumValues(const TagIndex *idx) {
+  return TrieMap_NUniqueKeys(idx->values) + idx->numFrozen;
+}
+
+// The values are moved to the front-coded dictionary, so the trie must not free them
+static void keepValue(void *p) {
+}
+
+void TagIndex_Compact(TagIndex *idx) {
+  FrontCodedDict *frozen = NewFrontCodedDict();
+  TagValuesIterator *it = TagIndex_IterateValues(idx, NULL, 0, TM_PREFIX_MODE);
+  char *str;
+  tm_len_t len;
+  InvertedIndex *iv;
+  while (TagValuesIterator_Next(it, &str, &len, &iv)) {
+    FrontCodedDict_Append(frozen, str, len, iv);
+  }
+  TagValuesIterator_Free(it);
+  FrontCodedDict_Finish(frozen);
+
+  if (idx->frozen) {
+    FrontCodedDict_Free(idx->frozen);
+  }
+  TrieMap_Free(idx->values, keepValue);
+  idx->values = NewTrieMap();
+  idx->frozen = frozen;
+  idx->numFrozen = FrontCodedDict_NumKeys(frozen);
+}
+
+struct TagValuesIterator {
+  TrieMapIterator *delta;
+  char *deltaStr;
+  tm_len_t deltaLen;
+  void *deltaValue;
+  bool deltaValid;  // Whether the delta* fields hold the next value of the trie
+
+  FrontCodedDictIterator frozen;
+  bool hasFrozen;   // Whether `frozen` was initialized
+  bool frozenOpen;  // Whether there may be more compacted values to iterate
+  char *frozenStr;
+  size_t frozenLen;
+  void *frozenValue;
+  bool frozenValid;
+
+  const char *pattern;
+  size_t patternLen;
+  size_t literalLen;  // Length of the prefix of the pattern that all the matching values start with
+  WildcardMatcher matcher;  // In TM_WILDCARD_MODE
+  tm_iter_mode mode;
+  TimeoutCtx timeout;
+  bool hasTimeout;
+
+  bool started;
+  bool lastFromDelta;
+};
+
+TagValuesIterator *TagIndex_IterateValues(const TagIndex *idx, const char *pattern, size_t len,
+                                          tm_iter_mode mode) {
+  TagValuesIterator *it = rm_calloc(1, sizeof(*it));
+  it->pattern = pattern;
+  it->patternLen = pattern ? len : 0;
+  it->mode = mode;
+  if (pattern) {
+    it->delta = TrieMap_IterateWithFilter(idx->values, pattern, len, mode);
+  } else {
+    it->delta = TrieMap_Iterate(idx->values);
+  }
+
+  if (mode == TM_PREFIX_MODE) {
+    it->literalLen = it->patternLen;
+  } else if (mode == TM_WILDCARD_MODE) {
+    WildcardMatcher_Init(&it->matcher, pattern, it->patternLen);
+    it->literalLen = it->matcher.prefixLen;
+  }
+
+  if (idx->frozen && idx->numFrozen) {
+    FrontCodedDictIterator_Init(&it->frozen, idx->frozen);
+    it->hasFrozen = true;
+    it->frozenOpen = true;
+    if (it->literalLen) {
+      FrontCodedDictIterator_Seek(&it->frozen, pattern, it->literalLen);
+    }
+  }
+  return it;
+}
+
+void TagValuesIterator_SetTimeout(TagValuesIterator *it, struct timespec timeout) {
+  if (it->delta) {
+    TrieMapIterator_SetTimeout(it->delta, timeout);
+  }
+  it->timeout.timeout = timeout;
+  it->hasTimeout = timeout.tv_sec || timeout.tv_nsec;
+}
+
+static bool matchesPattern(const TagValuesIterator *it, const char *str, size_t len) {
+  switch (it->mode) {
+    case TM_PREFIX_MODE:
+      return true;
+    case TM_WILDCARD_MODE:
+      return WildcardMatcher_Match(&it->matcher, str, len);
+    case TM_SUFFIX_MODE:
+      return len >= it->patternLen &&
+             !memcmp(str + len - it->patternLen, it->pattern, it->patternLen);
+    case TM_CONTAINS_MODE:
+      return !it->patternLen || memmem(str, len, it->pattern, it->patternLen);
+  }
+  return false;
+}
+
+static void advanceDelta(TagValuesIterator *it) {
+  it->deltaValid = it->delta &&
+                   TrieMapIterator_Next(it->delta, &it->deltaStr, &it->deltaLen, &it->deltaValue);
+}
+
+static void advanceFrozen(TagValuesIterator *it) {
+  it->frozenValid = false;
+  while (it->frozenOpen &&
+         FrontCodedDictIterator_Next(&it->frozen, &it->frozenStr, &it->frozenLen, &it->frozenValue)) {
+    if (it->hasTimeout && TimedOut_WithCtx(&it->timeout)) {
+      break;
+    }
+    // The values are sorted, so none of the next ones matches either
+    if (it->frozenLen < it->literalLen || memcmp(it->frozenStr, it->pattern, it->literalLen)) {
+      break;
+    }
+    if (it->frozenValue && matchesPattern(it, it->frozenStr, it->frozenLen)) {
+      it->frozenValid = true;
+      return;
+    }
+  }
+  it->frozenOpen = false;
+}
+
+int TagValuesIterator_Next(TagValuesIterator *it, char **str, tm_len_t *len, InvertedIndex **iv) {
+  // Advance the side of the last value only once it was consumed, since its key may be reused
+  if (!it->started) {
+    it->started = true;
+    advanceDelta(it);
+    advanceFrozen(it);
+  } else if (it->lastFromDelta) {
+    advanceDelta(it);
+  } else {
+    advanceFrozen(it);
+  }
+
+  if (!it->deltaValid && !it->frozenValid) {
+    return 0;
+  }
+  it->lastFromDelta = it->deltaValid;
+  if (it->deltaValid && it->frozenValid) {
+    size_t minLen = MIN(it->deltaLen, it->frozenLen);
+    int rc = minLen ? memcmp(it->deltaStr, it->frozenStr, minLen) : 0;
+    it->lastFromDelta = rc < 0 || (rc == 0 && it->deltaLen < it->frozenLen);
+  }
+
+  if (it->lastFromDelta) {
+    *str = it->deltaStr;
+    *len = it->deltaLen;
+    *iv = it->deltaValue;
+  } else {
+    *str = it->frozenStr;
+    *len = it->frozenLen;
+    *iv = it->frozenValue;
+  }
+  return 1;
+}
+
+void TagValuesIterator_Free(TagValuesIterator *it) {
+  if (it->delta) {
+    TrieMapIterator_Free(it->delta);
+  }
+  if (it->hasFrozen) {
+    FrontCodedDictIterator_Free(&it->frozen);
+  }
+  rm_free(it);
+}
+
+void TagIndex_IterateRange(const TagIndex *idx, const char *min, int minlen, bool includeMin,
+                           const char *max, int maxlen, bool includeMax,
+                           TrieMapRangeCallback callback, void *ctx) {
+  TrieMap_IterateRange(idx->values, min, minlen, includeMin, max, maxlen, includeMax, callback, ctx);
+  if (!idx->frozen || !idx->numFrozen) {
+    return;
+  }
+
+  FrontCodedDictIterator it;
+  FrontCodedDictIterator_Init(&it, idx->frozen);
+  if (minlen >= 0) {
+    FrontCodedDictIterator_Seek(&it, min, minlen);
+  }
+  char *str;
+  size_t len;
+  void *value;
+  while (FrontCodedDictIterator_Next(&it, &str, &len, &value)) {
+    if (maxlen >= 0) {
+      size_t n = MIN(len, (size_t)maxlen);
+      int rc = n ? memcmp(str, max, n) : 0;
+      if (rc > 0 || (rc == 0 && (len > (size_t)maxlen || (len == (size_t)maxlen && !includeMax)))) {
+        break;
+      }
+    }
+    if (!value || (!includeMin && minlen >= 0 && len == (size_t)minlen && (!len || !memcmp(str, min, len)))) {
+      continue;
+    }
+    callback(str, len, ctx, value);
+  }
+  FrontCodedDictIterator_Free(&it);
+}
+
 /* Serialize all the tags in the index to the redis client */
 void TagIndex_SerializeValues(TagIndex *idx, RedisModuleCtx *ctx) {
-  TrieMapIterator *it = TrieMap_Iterate(idx->values);
+  TagValuesIterator *it = TagIndex_IterateValues(idx, NULL, 0, TM_PREFIX_MODE);
 
   char *str;
   tm_len_t slen;
-  void *ptr;
+  InvertedIndex *iv;
   RedisModule_ReplyWithSet(ctx, REDISMODULE_POSTPONED_LEN);
   long long count = 0;
-  while (TrieMapIterator_Next(it, &str, &slen, &ptr)) {
+  while (TagValuesIterator_Next(it, &str, &slen, &iv)) {
     ++count;
     RedisModule_ReplyWithStringBuffer(ctx, str, slen);
   }
 
   RedisModule_ReplySetSetLength(ctx, count);
 
-  TrieMapIterator_Free(it);
+  TagValuesIterator_Free(it);
 }
 
 void TagIndex_Free(void *p) {
   TagIndex *idx = p;
   TrieMap_Free(idx->values, (void (*)(void *))InvertedIndex_Free);
+  if (idx->frozen) {
+    FrontCodedDictIterator it;
+    FrontCodedDictIterator_Init(&it, idx->frozen);
+    char *str;
+    size_t len;
+    void *iv;
+    while (FrontCodedDictIterator_Next(&it, &str, &len, &iv)) {
+      if (iv) {
+        InvertedIndex_Free(iv);
+      }
+    }
+    FrontCodedDictIterator_Free(&it);
+    FrontCodedDict_Free(idx->frozen);
+  }
   TrieMap_Free(idx->suffix, suffixTrieMap_freeCallback);
+  for (size_t i = 0; i < TAG_SET_CACHE_SIZE; i++) {
+    rm_free(idx->setCache.entries[i].key);
+    rm_free(idx->setCache.entries[i].ids);
+  }
+  pthread_mutex_destroy(&idx->setCache.lock);
+  freeValueCounts(idx->freqs, idx->numFreqs);
   rm_free(idx);
 }
 
+void TagIndex_RdbSave(RedisModuleIO *rdb, const TagIndex *idx) {
+  size_t numValues = 0;
+  char *str;
+  tm_len_t len;
+  InvertedIndex *iv;
+  TagValuesIterator *it = TagIndex_IterateValues(idx, NULL, 0, TM_PREFIX_MODE);
+  while (TagValuesIterator_Next(it, &str, &len, &iv)) {
+    numValues++;
+  }
+  TagValuesIterator_Free(it);
+
+  RedisModule_SaveUnsigned(rdb, numValues);
+  it = TagIndex_IterateValues(idx, NULL, 0, TM_PREFIX_MODE);
+  while (TagValuesIterator_Next(it, &str, &len, &iv)) {
+    RedisModule_SaveStringBuffer(rdb, str, len);
+    InvertedIndex_RdbSave(rdb, iv);
+  }
+  TagValuesIterator_Free(it);
+}
+
+int TagIndex_RdbLoad(RedisModuleIO *rdb, TagIndex *idx, size_t *memsize) {
+  *memsize = 0;
+  const size_t numValues = LoadUnsigned_IOError(rdb, return REDISMODULE_ERR);
+  for (size_t i = 0; i < numValues; i++) {
+    size_t len;
+    char *value = LoadStringBuffer_IOError(rdb, &len, return REDISMODULE_ERR);
+    size_t sz;
+    InvertedIndex *iv = InvertedIndex_RdbLoad(rdb, &sz);
+    if (!iv) {
+      RedisModule_Free(value);
+      return REDISMODULE_ERR;
+    }
+    *memsize += sz;
+    TrieMap_Add(idx->values, value, len, iv, NULL);
+    if (idx->suffix && len) {
+      addSuffixTrieMap(idx->suffix, value, len);
+    }
+    RedisModule_Free(value);
+  }
+  return REDISMODULE_OK;
+}
+
 size_t TagIndex_GetOverhead(const IndexSpec *sp, FieldSpec *fs) {
   size_t overhead = 0;
   TagIndex *idx = NULL;
@@ -299,9 +914,19 @@ size_t TagIndex_GetOverhead(const IndexSpec *sp, FieldSpec *fs) {
   RedisModule_FreeString(RSDummyContext, keyName);
   if (idx) {
     overhead = TrieMap_MemUsage(idx->values);     // Values' size are counted in stats.invertedSize
+    if (idx->frozen) {
+      overhead += FrontCodedDict_MemUsage(idx->frozen);
+    }
     if (idx->suffix) {
       overhead += TrieMap_MemUsage(idx->suffix);
     }
+    for (size_t i = 0; i < TAG_SET_CACHE_SIZE; i++) {
+      overhead += idx->setCache.entries[i].keyLen +
+                  idx->setCache.entries[i].numIds * sizeof(t_docId);
+    }
+    for (size_t i = 0; i < idx->numFreqs; i++) {
+      overhead += sizeof(*idx->freqs) + idx->freqs[i].len;
+    }
   }
   return overhead;
 }
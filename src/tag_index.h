@@ -16,6 +16,10 @@
 #include "geo_index.h"
 #include "vector_index.h"
 #include "indexer.h"
+#include "triemap.h"
+#include "util/front_coded.h"
+
+#include <pthread.h>
 
 struct InvertedIndex;
 
@@ -102,10 +106,53 @@ extern "C" {
  *
  *
  */
+
+// Number of sets of values whose documents are cached by a tag index, see TagIndex_OpenSetReader()
+#define TAG_SET_CACHE_SIZE 8
+// Sets matching more documents than this are not cached
+#define TAG_SET_CACHE_MAX_IDS (1 << 20)
+
+typedef struct {
+  uint64_t hash;
+  uint64_t revision;  // The revision of the index the ids were read at
+  char *key;          // The sorted values of the set, each followed by a NUL
+  size_t keyLen;
+  t_docId *ids;
+  size_t numIds;
+} TagSetCacheEntry;
+
+typedef struct {
+  // Queries run concurrently under the read lock of the spec, and all fill the cache
+  pthread_mutex_t lock;
+  TagSetCacheEntry entries[TAG_SET_CACHE_SIZE];
+  size_t next;  // The entry replaced next
+} TagSetCache;
+
+/* A tag value and its number of documents, see TagIndex_TopValues() */
+typedef struct {
+  char *value;
+  size_t len;
+  size_t count;
+} TagValueCount;
+
 typedef struct {
   uint32_t uniqueId;
+  // The values added since the last compaction of the index
   TrieMap *values;
+  // The values of the index at its last compaction, see TagIndex_Compact(). NULL if it was never
+  // compacted. The values deleted since are left in place with a NULL inverted index
+  FrontCodedDict *frozen;
+  size_t numFrozen;  // Number of values of `frozen` which were not deleted
   TrieMap *suffix;
+  // Incremented whenever a document is added to or removed from a value, which invalidates the
+  // cached sets
+  uint64_t revision;
+  TagSetCache setCache;
+  // All the values by decreasing number of documents, as of `freqsRevision`. Guarded by the lock of
+  // the set cache
+  TagValueCount *freqs;
+  size_t numFreqs;
+  uint64_t freqsRevision;
 } TagIndex;
 
 #define TAG_INDEX_KEY_FMT "tag:%s/%s"
@@ -137,6 +184,30 @@ size_t TagIndex_Index(TagIndex *idx, const char **values, size_t n, t_docId docI
 QueryIterator *TagIndex_OpenReader(TagIndex *idx, const RedisSearchCtx *sctx, const char *value, size_t len,
                                    double weight, t_fieldIndex fieldIndex);
 
+/* Open an iterator over the documents having any of the `n` values, which are read at once into
+ * a list of ids rather than merged by a union iterator. The ids are cached by the set of values
+ * until the index changes, unless `sctx` has fields expiring, so that the same set (permissions...)
+ * is only read once. The iterated results have no term, so the iterator is only meant for the
+ * queries which do not score the documents by their values.
+ * `values` are sorted in place. Returns NULL if no document has any of the values */
+QueryIterator *TagIndex_OpenSetReader(TagIndex *idx, const RedisSearchCtx *sctx, char **values,
+                                      size_t n, double weight, t_fieldIndex fieldIndex);
+
+/* Returns the `max` values with the most documents (all of them if `max` is 0), by decreasing
+ * number of documents and then by value, in an array to free with TagValueCounts_Free().
+ * Without `docs`, the numbers of documents of the values are taken from a table which is cached
+ * until the index changes. Otherwise only the documents set in the `nwords` words of the `docs`
+ * bitmap are counted, visiting the values by decreasing number of documents until none of the
+ * remaining values can make it to the top. Must be called under the read lock of the spec */
+arrayof(TagValueCount) TagIndex_TopValues(TagIndex *idx, const RedisSearchCtx *sctx,
+                                          const uint64_t *docs, size_t nwords, size_t max,
+                                          t_fieldIndex fieldIndex);
+
+void TagValueCounts_Free(arrayof(TagValueCount) counts);
+
+/* Orders the values by decreasing number of documents, and then by value */
+int TagValueCount_Compare(const void *a, const void *b);
+
 /* Open the tag index key in redis */
 TagIndex *TagIndex_Open(const IndexSpec *spec, RedisModuleString *formattedKey, bool create_if_missing);
 
@@ -148,6 +219,48 @@ TagIndex *TagIndex_Open(const IndexSpec *spec, RedisModuleString *formattedKey,
 struct InvertedIndex *TagIndex_OpenIndex(const TagIndex *idx, const char *value,
                                          size_t len, int create_if_missing, size_t *sz);
 
+/* Delete a tag value and free its inverted index */
+void TagIndex_DeleteValue(TagIndex *idx, const char *value, size_t len);
+
+/* The number of distinct values in the index */
+size_t TagIndex_NumValues(const TagIndex *idx);
+
+/* Move all the values of the index into a new front-coded dictionary, which takes much less memory
+ * than the trie for large numbers of values, and leave an empty trie for the values added next.
+ * The inverted indexes are moved as they are, so the readers on them remain valid */
+void TagIndex_Compact(TagIndex *idx);
+
+/* Save the values of the index to the RDB, with their inverted indexes as they are in memory */
+void TagIndex_RdbSave(RedisModuleIO *rdb, const TagIndex *idx);
+
+/* Load the values saved by TagIndex_RdbSave() into an empty index, adding them to its suffix trie
+ * if it has one. The memory of their inverted indexes is returned in `memsize`. Returns
+ * REDISMODULE_ERR on a short read, leaving the values loaded so far in the index */
+int TagIndex_RdbLoad(RedisModuleIO *rdb, TagIndex *idx, size_t *memsize);
+
+/* Iterates the values of the index, with their inverted index, in lexicographic order */
+typedef struct TagValuesIterator TagValuesIterator;
+
+/* Iterate the values matching `pattern` according to `mode`, as TrieMap_IterateWithFilter() does,
+ * or all the values if `pattern` is NULL. The prefix of the pattern is binary-searched in the
+ * compacted values for the prefix and the wildcard modes. `pattern` must outlive the iterator */
+TagValuesIterator *TagIndex_IterateValues(const TagIndex *idx, const char *pattern, size_t len,
+                                          tm_iter_mode mode);
+
+/* Stop the iteration once `timeout` is reached. A zeroed timeout is unlimited */
+void TagValuesIterator_SetTimeout(TagValuesIterator *it, struct timespec timeout);
+
+/* Returns 0 once there are no more values. The value is valid until the next call */
+int TagValuesIterator_Next(TagValuesIterator *it, char **str, tm_len_t *len,
+                           struct InvertedIndex **iv);
+
+void TagValuesIterator_Free(TagValuesIterator *it);
+
+/* Calls `callback` with the values in the given range, as TrieMap_IterateRange() does */
+void TagIndex_IterateRange(const TagIndex *idx, const char *min, int minlen, bool includeMin,
+                           const char *max, int maxlen, bool includeMax,
+                           TrieMapRangeCallback callback, void *ctx);
+
 /* Serialize all the tags in the index to the redis client */
 void TagIndex_SerializeValues(TagIndex *idx, RedisModuleCtx *ctx);
 
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "term_index_cache.h"
+#include "util/fnv.h"
+#include "rmalloc.h"
+
+#include <string.h>
+
+typedef struct {
+  char *term;  // NULL for an empty slot
+  uint32_t len;
+  uint32_t hash;
+  InvertedIndex *idx;
+} termIndexSlot;
+
+struct TermIndexCache {
+  termIndexSlot *slots;  // Allocated on the first put
+};
+
+TermIndexCache *NewTermIndexCache(void) {
+  return rm_calloc(1, sizeof(TermIndexCache));
+}
+
+void TermIndexCache_Free(TermIndexCache *cache) {
+  if (!cache) return;
+  if (cache->slots) {
+    for (size_t i = 0; i < TERM_INDEX_CACHE_SLOTS; i++) {
+      rm_free(cache->slots[i].term);
+    }
+    rm_free(cache->slots);
+  }
+  rm_free(cache);
+}
+
+static inline termIndexSlot *findSlot(TermIndexCache *cache, const char *term, size_t len,
+                                      uint32_t hash) {
+  termIndexSlot *slot = &cache->slots[hash % TERM_INDEX_CACHE_SLOTS];
+  if (slot->term && slot->hash == hash && slot->len == len && !memcmp(slot->term, term, len)) {
+    return slot;
+  }
+  return NULL;
+}
+
+InvertedIndex *TermIndexCache_Get(TermIndexCache *cache, const char *term, size_t len,
+                                  uint32_t hash) {
+  if (!cache || !cache->slots) return NULL;
+  termIndexSlot *slot = findSlot(cache, term, len, hash);
+  return slot ? slot->idx : NULL;
+}
+
+void TermIndexCache_Put(TermIndexCache *cache, const char *term, size_t len, uint32_t hash,
+                        InvertedIndex *idx) {
+  if (!cache || len > UINT32_MAX) return;
+  if (!cache->slots) {
+    cache->slots = rm_calloc(TERM_INDEX_CACHE_SLOTS, sizeof(*cache->slots));
+  }
+  termIndexSlot *slot = &cache->slots[hash % TERM_INDEX_CACHE_SLOTS];
+  if (!slot->term || slot->len < len) {
+    rm_free(slot->term);
+    slot->term = rm_malloc(len + 1);
+  }
+  memcpy(slot->term, term, len);
+  slot->term[len] = '\0';
+  slot->len = len;
+  slot->hash = hash;
+  slot->idx = idx;
+}
+
+void TermIndexCache_Remove(TermIndexCache *cache, const char *term, size_t len) {
+  if (!cache || !cache->slots) return;
+  // The same hash as the entries of the forward index
+  termIndexSlot *slot = findSlot(cache, term, len, rs_fnv_32a_buf(term, len, 0));
+  if (slot) {
+    rm_free(slot->term);
+    *slot = (termIndexSlot){0};
+  }
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "inverted_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of slots of the cache of each index
+#define TERM_INDEX_CACHE_SLOTS 1024
+
+/**
+ * A cache of the inverted indexes of the TEXT terms an index wrote to recently, so that indexing
+ * documents one by one (pipelined HSETs) does not format the key of every term and look it up in
+ * the keys dictionary for every document containing it.
+ *
+ * The slots are mapped by the hash of the forward index entries, and a colliding term replaces the
+ * previous one. The cache is only used with the spec locked for write, and the inverted index of a
+ * term must be removed from it before it is freed.
+ */
+typedef struct TermIndexCache TermIndexCache;
+
+TermIndexCache *NewTermIndexCache(void);
+void TermIndexCache_Free(TermIndexCache *cache);
+
+/* Get the inverted index of the term, whose forward index hash is `hash`.
+ * @returns NULL if it is not cached */
+InvertedIndex *TermIndexCache_Get(TermIndexCache *cache, const char *term, size_t len,
+                                  uint32_t hash);
+
+/* Cache the inverted index of the term */
+void TermIndexCache_Put(TermIndexCache *cache, const char *term, size_t len, uint32_t hash,
+                        InvertedIndex *idx);
+
+/* Remove the term from the cache, before its inverted index is freed */
+void TermIndexCache_Remove(TermIndexCache *cache, const char *term, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
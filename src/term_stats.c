@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "term_stats.h"
+#include "triemap.h"
+#include "rmalloc.h"
+
+#include <pthread.h>
+
+struct TermStatsCache {
+  pthread_mutex_t lock;
+  TrieMap *stats;     // term -> TermStats
+  uint64_t revision;  // the revision of the cached statistics
+};
+
+TermStatsCache *NewTermStatsCache(void) {
+  TermStatsCache *cache = rm_calloc(1, sizeof(*cache));
+  pthread_mutex_init(&cache->lock, NULL);
+  cache->stats = NewTrieMap();
+  return cache;
+}
+
+void TermStatsCache_Free(TermStatsCache *cache) {
+  if (!cache) return;
+  TrieMap_Free(cache->stats, rm_free);
+  pthread_mutex_destroy(&cache->lock);
+  rm_free(cache);
+}
+
+// Drop the statistics of older revisions. The cache must be locked
+static void TermStatsCache_Sync(TermStatsCache *cache, uint64_t revision) {
+  if (revision > cache->revision) {
+    TrieMap_Free(cache->stats, rm_free);
+    cache->stats = NewTrieMap();
+    cache->revision = revision;
+  }
+}
+
+bool TermStatsCache_Get(TermStatsCache *cache, uint64_t revision, const char *term, size_t len,
+                        TermStats *stats) {
+  bool found = false;
+  if (len > UINT16_MAX) return false;  // Too long for the keys of the map
+  pthread_mutex_lock(&cache->lock);
+  TermStatsCache_Sync(cache, revision);
+  if (revision == cache->revision) {
+    TermStats *cached = TrieMap_Find(cache->stats, term, len);
+    if (cached != TRIEMAP_NOTFOUND) {
+      *stats = *cached;
+      found = true;
+    }
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return found;
+}
+
+void TermStatsCache_Put(TermStatsCache *cache, uint64_t revision, const char *term, size_t len,
+                        const TermStats *stats) {
+  if (len > UINT16_MAX) return;
+  pthread_mutex_lock(&cache->lock);
+  TermStatsCache_Sync(cache, revision);
+  if (revision == cache->revision && TrieMap_NUniqueKeys(cache->stats) < TERM_STATS_CACHE_CAPACITY) {
+    TermStats *cached = rm_malloc(sizeof(*cached));
+    *cached = *stats;
+    TrieMap_Add(cache->stats, term, len, cached, NULL);
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "redisearch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of terms whose statistics each index keeps, at most
+#define TERM_STATS_CACHE_CAPACITY 4096
+
+typedef struct {
+  bool hasIndex;          // whether the term has an inverted index
+  uint32_t numDocs;       // the document frequency of the term
+  t_fieldMask fieldMask;  // the fields the documents of the term have it in
+} TermStats;
+
+/**
+ * A cache of the statistics of the TEXT terms of an index, so that repeated lookups (spellcheck
+ * scoring every suggestion of every query term) don't go through the keys dictionary each time.
+ *
+ * The statistics are stamped with the revision of the index they were read at, which the index
+ * bumps whenever its inverted indexes change, and the whole cache is dropped once it is read at a
+ * newer revision. Lookups may run concurrently (under the spec read lock), and are serialized by
+ * the cache itself.
+ */
+typedef struct TermStatsCache TermStatsCache;
+
+TermStatsCache *NewTermStatsCache(void);
+void TermStatsCache_Free(TermStatsCache *cache);
+
+/* Get the statistics of the term cached at `revision`.
+ * @returns false if they are not cached */
+bool TermStatsCache_Get(TermStatsCache *cache, uint64_t revision, const char *term, size_t len,
+                        TermStats *stats);
+
+/* Cache the statistics of the term, read at `revision` */
+void TermStatsCache_Put(TermStatsCache *cache, uint64_t revision, const char *term, size_t len,
+                        const TermStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
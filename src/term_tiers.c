@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "term_tiers.h"
+#include "config.h"
+#include "redis_index.h"
+#include "search_ctx.h"
+#include "search_disk.h"
+#include "term_index_cache.h"
+#include "inverted_index.h"
+#include "trie/trie_type.h"
+#include "trie/rune_util.h"
+#include "util/arr.h"
+#include "module.h"
+#include "rmalloc.h"
+#include "hiredis/sds.h"
+
+#include <pthread.h>
+#include <string.h>
+
+// Serializes bringing the blocks of cold terms back, which may run under the read lock
+static pthread_mutex_t warmLock = PTHREAD_MUTEX_INITIALIZER;
+
+void TermTiers_Open(IndexSpec *sp, KeysDictValue *kdv, const char *term, size_t len) {
+  if (__atomic_load_n(&kdv->idleCycles, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&kdv->idleCycles, 0, __ATOMIC_RELAXED);
+  }
+  if (!__atomic_load_n(&kdv->cold, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+
+  pthread_mutex_lock(&warmLock);
+  // Another reader of the term may have brought it back meanwhile
+  if (kdv->cold) {
+    InvertedIndex *idx = kdv->p;
+    size_t dataLen = 0;
+    char *data = SearchDisk_TakePostings(sp->coldTerms, term, len, &dataLen);
+    size_t allocated = data ? InvertedIndex_RestoreBlocks(idx, data, dataLen) : 0;
+    if (data) {
+      sdsfree(data);
+    }
+    if (!allocated) {
+      // The index is left without blocks, which its readers see as an empty term
+      RedisModule_Log(RSDummyContext, "warning",
+                      "Index %s: could not read the blocks of a cold term from disk",
+                      sp->obfuscatedName);
+    }
+    sp->stats.invertedSize += allocated;
+    __atomic_store_n(&kdv->cold, false, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&warmLock);
+}
+
+static KeysDictValue *fetchTerm(RedisSearchCtx *sctx, const char *term, size_t len) {
+  RedisModuleString *termKey = fmtRedisTermKey(sctx, term, len);
+  KeysDictValue *kdv = dictFetchValue(sctx->spec->keysDict, termKey);
+  RedisModule_FreeString(sctx->redisCtx, termKey);
+  return kdv;
+}
+
+// Age the terms of the index, returning those which were idle for `idleCycles` cycles and are
+// worth moving. The spec must be locked for read
+static arrayof(char *) ageTerms(RedisSearchCtx *sctx, uint32_t idleCycles) {
+  arrayof(char *) idle = array_new(char *, 16);
+  TrieIterator *iter = Trie_Iterate(sctx->spec->terms, "", 0, 0, 1);
+  rune *rstr = NULL;
+  t_len slen = 0;
+  float score = 0;
+  int dist = 0;
+  while (TrieIterator_Next(iter, &rstr, &slen, NULL, &score, &dist)) {
+    size_t len;
+    char *term = runesToStr(rstr, slen, &len);
+    KeysDictValue *kdv = fetchTerm(sctx, term, len);
+    if (kdv && !kdv->cold) {
+      // The readers reset the counter concurrently, so a term read meanwhile may seldom be moved
+      uint16_t cycles = __atomic_load_n(&kdv->idleCycles, __ATOMIC_RELAXED);
+      if (cycles < UINT16_MAX) {
+        cycles = __atomic_add_fetch(&kdv->idleCycles, 1, __ATOMIC_RELAXED);
+      }
+      if (cycles >= idleCycles && array_len(idle) < TERM_TIERING_MAX_MOVES &&
+          InvertedIndex_MemUsage(kdv->p) >= TERM_TIERING_MIN_BYTES) {
+        array_append(idle, term);
+        continue;
+      }
+    }
+    rm_free(term);
+  }
+  TrieIterator_Free(iter);
+  return idle;
+}
+
+// Move the blocks of the idle terms to the disk database. The spec must be locked for write
+static void moveTerms(RedisSearchCtx *sctx, arrayof(char *) idle, uint32_t idleCycles) {
+  IndexSpec *sp = sctx->spec;
+  if (!sp->coldTerms) {
+    sp->coldTerms = SearchDisk_OpenIndex(HiddenString_GetUnsafe(sp->specName, NULL), sp->rule->type);
+    if (!sp->coldTerms) {
+      return;
+    }
+  }
+
+  Buffer buf;
+  Buffer_Init(&buf, TERM_TIERING_MIN_BYTES);
+  for (uint32_t i = 0; i < array_len(idle); i++) {
+    const char *term = idle[i];
+    size_t len = strlen(term);
+    KeysDictValue *kdv = fetchTerm(sctx, term, len);
+    // The term may have been read, or collected, since it was aged
+    if (!kdv || kdv->cold || kdv->idleCycles < idleCycles) {
+      continue;
+    }
+    InvertedIndex *idx = kdv->p;
+    buf.offset = 0;
+    size_t freed = InvertedIndex_TakeBlocks(idx, &buf);
+    if (!SearchDisk_PutPostings(sp->coldTerms, term, len, buf.data, buf.offset)) {
+      InvertedIndex_RestoreBlocks(idx, buf.data, buf.offset);
+      continue;
+    }
+    // The writers cache the indexes they wrote to, and must open a cold one again
+    TermIndexCache_Remove(sp->termIndexes, term, len);
+    sp->stats.invertedSize -= freed;
+    kdv->cold = true;
+  }
+  Buffer_Free(&buf);
+}
+
+int TermTiers_RunCycle(WeakRef spRef) {
+  StrongRef strong = WeakRef_Promote(spRef);
+  IndexSpec *sp = StrongRef_Get(strong);
+  if (!sp) {
+    // Index was deleted
+    return 0;
+  }
+  const uint32_t idleCycles = RSGlobalConfig.termTieringIdleCycles;
+  if (!idleCycles || sp->diskSpec || !disk_db || !SearchDisk_HasPostings()) {
+    StrongRef_Release(strong);
+    return 1;
+  }
+
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(NULL, sp);
+  // The terms are aged under the read lock, so that only moving them blocks the queries
+  RedisSearchCtx_LockSpecRead(&sctx);
+  arrayof(char *) idle = ageTerms(&sctx, idleCycles);
+  RedisSearchCtx_UnlockSpec(&sctx);
+
+  if (array_len(idle)) {
+    RedisSearchCtx_LockSpecWrite(&sctx);
+    moveTerms(&sctx, idle, idleCycles);
+    RedisSearchCtx_UnlockSpec(&sctx);
+  }
+  array_free_ex(idle, rm_free(*(char **)ptr));
+  StrongRef_Release(strong);
+  return 1;
+}
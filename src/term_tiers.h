@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include "spec.h"
+#include "util/references.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The terms whose blocks take less memory than this stay in memory however long they are idle
+#define TERM_TIERING_MIN_BYTES 1024
+// The most terms a GC cycle of an index moves to the disk database, as it holds the write lock
+#define TERM_TIERING_MAX_MOVES 1024
+
+/**
+ * Tiering of the inverted indexes of the TEXT terms of the indexes in memory, enabled by
+ * _TERM_TIERING_IDLE_CYCLES when the disk database stores postings (see SearchDisk_HasPostings())
+ * so that the long tail of a vocabulary does not take memory.
+ *
+ * Every GC cycle of an index ages its terms, and moves the blocks of those that were not opened
+ * during the last _TERM_TIERING_IDLE_CYCLES cycles to the disk database. The inverted index of such
+ * a cold term stays in the keys dictionary without its blocks, so that its statistics are still read
+ * from memory, and they are brought back the first time it is opened to be read or written again.
+ * As this may happen under the read lock of the index, from several threads at once, it is
+ * serialized by a lock of its own.
+ */
+
+/* Mark the term as used, and bring its blocks back from the disk database if it is cold */
+void TermTiers_Open(IndexSpec *sp, KeysDictValue *kdv, const char *term, size_t len);
+
+/* Age the terms of the index, and move the blocks of those which are idle to the disk database.
+ * Run by the GC of the index. Returns 0 if the index was freed */
+int TermTiers_RunCycle(WeakRef spRef);
+
+#ifdef __cplusplus
+}
+#endif
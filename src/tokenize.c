@@ -15,8 +15,183 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <strings.h>
+#include <stdbool.h>
 #include "phonetic_manager.h"
 
+#if defined(__SSE2__)
+#define TOKENIZE_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define TOKENIZE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(TOKENIZE_SSE2) || defined(TOKENIZE_NEON)
+#define TOKENIZE_SIMD
+
+// The text is classified by chunks of 16 bytes. The mask of a chunk has a bit set per flagged
+// byte. With NEON, each byte has 4 bits of the mask, of which only the highest one is kept.
+#define TOKENIZE_CHUNK 16
+
+#if defined(TOKENIZE_SSE2)
+#define CHUNK_MASK_SHIFT 0
+typedef __m128i ChunkVec;
+
+static inline ChunkVec chunkLoad(const char *p) {
+  return _mm_loadu_si128((const __m128i *)p);
+}
+static inline void chunkStore(char *p, ChunkVec v) {
+  _mm_storeu_si128((__m128i *)p, v);
+}
+static inline uint64_t chunkMask(ChunkVec v) {
+  return (uint32_t)_mm_movemask_epi8(v);
+}
+static inline ChunkVec chunkOr(ChunkVec a, ChunkVec b) {
+  return _mm_or_si128(a, b);
+}
+static inline ChunkVec chunkAnd(ChunkVec v, uint8_t c) {
+  return _mm_and_si128(v, _mm_set1_epi8((char)c));
+}
+static inline ChunkVec chunkAdd(ChunkVec a, ChunkVec b) {
+  return _mm_add_epi8(a, b);
+}
+static inline ChunkVec chunkEq(ChunkVec v, uint8_t c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8((char)c));
+}
+// Signed comparison, so that the bytes with their high bit set are below any ASCII byte
+static inline ChunkVec chunkLess(ChunkVec v, int8_t c) {
+  return _mm_cmplt_epi8(v, _mm_set1_epi8(c));
+}
+static inline ChunkVec chunkInRange(ChunkVec v, uint8_t lo, uint8_t hi) {
+  ChunkVec t = _mm_sub_epi8(v, _mm_set1_epi8((char)lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8((char)(hi - lo))), t);
+}
+#else
+#define CHUNK_MASK_SHIFT 2
+typedef uint8x16_t ChunkVec;
+
+static inline ChunkVec chunkLoad(const char *p) {
+  return vld1q_u8((const uint8_t *)p);
+}
+static inline void chunkStore(char *p, ChunkVec v) {
+  vst1q_u8((uint8_t *)p, v);
+}
+static inline uint64_t chunkMask(ChunkVec v) {
+  uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+  return nibbles & 0x8888888888888888ULL;
+}
+static inline ChunkVec chunkOr(ChunkVec a, ChunkVec b) {
+  return vorrq_u8(a, b);
+}
+static inline ChunkVec chunkAnd(ChunkVec v, uint8_t c) {
+  return vandq_u8(v, vdupq_n_u8(c));
+}
+static inline ChunkVec chunkAdd(ChunkVec a, ChunkVec b) {
+  return vaddq_u8(a, b);
+}
+static inline ChunkVec chunkEq(ChunkVec v, uint8_t c) {
+  return vceqq_u8(v, vdupq_n_u8(c));
+}
+// Signed comparison, so that the bytes with their high bit set are below any ASCII byte
+static inline ChunkVec chunkLess(ChunkVec v, int8_t c) {
+  return vcltq_s8(vreinterpretq_s8_u8(v), vdupq_n_s8(c));
+}
+static inline ChunkVec chunkInRange(ChunkVec v, uint8_t lo, uint8_t hi) {
+  return vcleq_u8(vsubq_u8(v, vdupq_n_u8(lo)), vdupq_n_u8(hi - lo));
+}
+#endif
+
+static inline size_t chunkMaskFirst(uint64_t mask) {
+  return __builtin_ctzll(mask) >> CHUNK_MASK_SHIFT;
+}
+
+// Flags the bytes of the chunk at `p` which may end a token or escape the next byte: all the
+// separators of ToksepMap_g, the backslash and the NUL. The other control characters below 0x10
+// and '_' are flagged too, and simply skipped by the scalar loop.
+static inline uint64_t chunkSeparators(const char *p) {
+  ChunkVec x = chunkLoad(p);
+  // (x & 0xDF) is below 0x10 for the bytes 0x00-0x0F and 0x20-0x2F
+  ChunkVec flags = chunkInRange(chunkAnd(x, 0xDF), 0x00, 0x0F);
+  flags = chunkOr(flags, chunkInRange(x, ':', '@'));
+  flags = chunkOr(flags, chunkInRange(x, '[', '`'));
+  flags = chunkOr(flags, chunkInRange(x, '{', '~'));
+  return chunkMask(flags);
+}
+
+// Lowers a token of plain ASCII in place, by chunks which may extend past the token up to `end`.
+// Returns false as soon as a chunk has a byte which the scalar normalization handles: a control
+// character or a blank, a backslash, or a byte of a multibyte character. The chunks before it
+// are lowered already, which the scalar normalization then leaves as they are.
+static bool lowerPlainToken(char *s, size_t len, const char *end) {
+  for (size_t i = 0; i < len; i += TOKENIZE_CHUNK) {
+    if (s + i + TOKENIZE_CHUNK > end) {
+      return false;
+    }
+    ChunkVec x = chunkLoad(s + i);
+    ChunkVec special = chunkOr(chunkLess(x, 0x21), chunkOr(chunkEq(x, '\\'), chunkEq(x, 0x7F)));
+    uint64_t mask = chunkMask(special);
+    size_t n = len - i < TOKENIZE_CHUNK ? len - i : TOKENIZE_CHUNK;
+    if (n < TOKENIZE_CHUNK) {
+      // Only the first bytes of the last chunk belong to the token
+      mask &= (1ULL << (n << CHUNK_MASK_SHIFT)) - 1;
+    }
+    if (mask) {
+      return false;
+    }
+    ChunkVec lowered = chunkAdd(x, chunkAnd(chunkInRange(x, 'A', 'Z'), 'a' - 'A'));
+    if (n == TOKENIZE_CHUNK) {
+      chunkStore(s + i, lowered);
+    } else {
+      char buf[TOKENIZE_CHUNK];
+      chunkStore(buf, lowered);
+      memcpy(s + i, buf, n);
+    }
+  }
+  return true;
+}
+#endif  // TOKENIZE_SIMD
+
+/**
+ * Same as toksep(), for a text which ends at `end`. The runs of bytes which neither end the token
+ * nor escape are skipped by chunks.
+ */
+static inline char *nextToken(char **s, const char *end, size_t *tokLen) {
+  uint8_t *pos = (uint8_t *)*s;
+  char *orig = *s;
+  int escaped = 0;
+  for (;; ++pos) {
+#ifdef TOKENIZE_SIMD
+    if (!escaped) {
+      while ((const char *)pos + TOKENIZE_CHUNK <= end) {
+        uint64_t mask = chunkSeparators((const char *)pos);
+        if (mask) {
+          pos += chunkMaskFirst(mask);
+          break;
+        }
+        pos += TOKENIZE_CHUNK;
+      }
+    }
+#endif
+    if (!*pos) {
+      break;
+    }
+    if (ToksepMap_g[*pos] && !escaped) {
+      *s = (char *)++pos;
+      *tokLen = ((char *)pos - orig) - 1;
+      if (!*pos) {
+        *s = NULL;
+      }
+      return orig;
+    }
+    escaped = !escaped && *pos == '\\';
+  }
+
+  // Didn't find a terminating token. Use a simpler length calculation
+  *s = NULL;
+  *tokLen = (char *)pos - orig;
+  return orig;
+}
+
 typedef struct {
   RSTokenizer base;
   char *pos;
@@ -43,9 +218,17 @@ static void simpleTokenizer_Start(RSTokenizer *base, char *text, size_t len, uin
  * - len on input contains the length of the raw token, on output contains the
  *   length of the normalized token
  * - allocated is set to 1 if the function allocated new memory, 0 otherwise
+ * - end is the end of the text of the token, up to which it may be read by chunks
  */
-static char *DefaultNormalize(char *s, char *dst, size_t *len, int *allocated) {
+static char *DefaultNormalize(char *s, char *dst, size_t *len, int *allocated, const char *end) {
   size_t origLen = *len;
+#ifdef TOKENIZE_SIMD
+  // Most tokens are plain ASCII, which is lowered without any copy
+  if (dst == s && lowerPlainToken(s, origLen, end)) {
+    *allocated = 0;
+    return dst;
+  }
+#endif
   char *realDest = s;
   size_t dstLen = 0;
 
@@ -88,7 +271,7 @@ uint32_t simpleTokenizer_Next(RSTokenizer *base, Token *t) {
   while (self->pos != NULL) {
     // get the next token
     size_t origLen;
-    char *tok = toksep(&self->pos, &origLen);
+    char *tok = nextToken(&self->pos, ctx->text + ctx->len, &origLen);
     // normalize the token
     size_t normLen = origLen;
     char normalized_s[MAX_NORMALIZE_SIZE];
@@ -105,7 +288,7 @@ uint32_t simpleTokenizer_Next(RSTokenizer *base, Token *t) {
     }
 
     int allocated = 0;
-    char *normalized = DefaultNormalize(tok, normBuf, &normLen, &allocated);
+    char *normalized = DefaultNormalize(tok, normBuf, &normLen, &allocated, ctx->text + ctx->len);
 
     // ignore tokens that turn into nothing, unless the whole string is empty.
     if ((normalized == NULL || normLen == 0) && !ctx->empty_input) {
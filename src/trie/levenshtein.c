@@ -13,6 +13,8 @@
 #include "levenshtein.h"
 #include "rune_util.h"
 #include "rmalloc.h"
+#include "util/arr.h"
+#include "util/fnv.h"
 
 // NewSparseAutomaton creates a new automaton for the string s, with a given max
 // edit distance check
@@ -31,10 +33,10 @@ sparseVector *SparseAutomaton_Start(SparseAutomaton *a) {
   return newSparseVector(vals, a->max + 1);
 }
 
-// Step returns the next state of the automaton given a previous state and a
-// character to check
-sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, rune c) {
-  sparseVector *newVec = newSparseVectorCap(state->len);
+// Steps from `state` into `*out`, which is reused rather than allocated
+static void automatonStep(SparseAutomaton *a, const sparseVector *state, rune c, sparseVector **out) {
+  sparseVector *newVec = *out;
+  newVec->len = 0;
 
   if (state->len) {
     sparseVectorEntry e = state->entries[0];
@@ -44,7 +46,7 @@ sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, rune
   }
 
   for (int j = 0; j < state->len; j++) {
-    sparseVectorEntry *entry = &state->entries[j];
+    const sparseVectorEntry *entry = &state->entries[j];
 
     if (entry->idx == a->len) {
       break;
@@ -66,6 +68,14 @@ sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, rune
       sparseVector_append(&newVec, entry->idx + 1, val);
     }
   }
+  *out = newVec;
+}
+
+// Step returns the next state of the automaton given a previous state and a
+// character to check
+sparseVector *SparseAutomaton_Step(SparseAutomaton *a, sparseVector *state, rune c) {
+  sparseVector *newVec = newSparseVectorCap(state->len);
+  automatonStep(a, state, c, &newVec);
   return newVec;
 }
 
@@ -144,51 +154,99 @@ void __dfn_addEdge(dfaNode *n, rune r, dfaNode *child) {
   n->edges[n->numEdges++] = (dfaEdge){.r = r, .n = child};
 }
 
-void dfa_build(dfaNode *parent, SparseAutomaton *a, Vector *cache) {
+/* Builds the states of the DFA. The states are found by their vector in an open addressing hash
+ * table rather than by scanning the cache, which is quadratic in the number of states of long
+ * terms at distance 2 */
+typedef struct {
+  SparseAutomaton *a;
+  Vector *cache;
+  dfaNode **table;
+  size_t tableCap;  // A power of 2, at least twice the number of states
+  size_t numStates;
+  sparseVector *scratch;  // The next state, until we know whether it is a new one
+} dfaBuilder;
+
+static dfaNode **dfaBuilder_slot(dfaBuilder *b, sparseVector *v) {
+  size_t mask = b->tableCap - 1;
+  size_t i = fnv_64a_buf(v->entries, v->len * sizeof(*v->entries), 0) & mask;
+  while (b->table[i] && !__sv_equals(v, b->table[i]->v)) {
+    i = (i + 1) & mask;
+  }
+  return &b->table[i];
+}
+
+static void dfaBuilder_index(dfaBuilder *b, dfaNode *dfn) {
+  if (2 * (b->numStates + 1) > b->tableCap) {
+    dfaNode **old = b->table;
+    size_t oldCap = b->tableCap;
+    b->tableCap = oldCap ? oldCap * 2 : 64;
+    b->table = rm_calloc(b->tableCap, sizeof(*b->table));
+    for (size_t i = 0; i < oldCap; i++) {
+      if (old[i]) {
+        *dfaBuilder_slot(b, old[i]->v) = old[i];
+      }
+    }
+    rm_free(old);
+  }
+  *dfaBuilder_slot(b, dfn->v) = dfn;
+  b->numStates++;
+}
+
+static void dfaBuilder_build(dfaBuilder *b, dfaNode *parent);
+
+// Returns the state reached from `v` with `c`, which is built if it is a new one, or NULL if the
+// automaton can no longer match
+static dfaNode *dfaBuilder_step(dfaBuilder *b, sparseVector *v, rune c) {
+  automatonStep(b->a, v, c, &b->scratch);
+  if (b->scratch->len == 0) {
+    return NULL;
+  }
+  dfaNode *dfn = *dfaBuilder_slot(b, b->scratch);
+  if (dfn) {
+    return dfn;
+  }
+
+  sparseVector *nv = newSparseVectorCap(b->scratch->len);
+  nv->len = b->scratch->len;
+  memcpy(nv->entries, b->scratch->entries, nv->len * sizeof(*nv->entries));
+  dfn = __newDfaNode(nv->entries[nv->len - 1].val, nv);
+  dfaBuilder_index(b, dfn);
+  __dfn_putCache(b->cache, dfn);
+  dfaBuilder_build(b, dfn);
+  return dfn;
+}
+
+static void dfaBuilder_build(dfaBuilder *b, dfaNode *parent) {
+  SparseAutomaton *a = b->a;
   parent->match = SparseAutomaton_IsMatch(a, parent->v);
 
   for (int i = 0; i < parent->v->len; i++) {
     if (parent->v->entries[i].idx < a->len) {
       rune c = a->string[parent->v->entries[i].idx];
-      dfaNode *edge = __dfn_getEdge(parent, c);
-      if (edge == NULL) {
-        sparseVector *nv = SparseAutomaton_Step(a, parent->v, c);
-
-        if (nv->len > 0) {
-          dfaNode *dfn = __dfn_getCache(cache, nv);
-          if (dfn == NULL) {
-            int dist = nv->entries[nv->len - 1].val;
-            edge = __newDfaNode(dist, nv);
-            __dfn_addEdge(parent, c, edge);
-            __dfn_putCache(cache, edge);
-            dfa_build(edge, a, cache);
-            continue;
-          } else {
-            __dfn_addEdge(parent, c, dfn);
-          }
+      if (__dfn_getEdge(parent, c) == NULL) {
+        dfaNode *edge = dfaBuilder_step(b, parent->v, c);
+        if (edge) {
+          __dfn_addEdge(parent, c, edge);
         }
-        sparseVector_free(nv);
       }
     }
   }
 
-  // if (parent->distance < a->max) {
-  sparseVector *nv = SparseAutomaton_Step(a, parent->v, 1);
-  if (nv->len > 0) {
-    dfaNode *dfn = __dfn_getCache(cache, nv);
-    if (dfn) {
-      parent->fallback = dfn;
-    } else {
-      int dist = nv->entries[nv->len - 1].val;
-      parent->fallback = __newDfaNode(dist, nv);
-      __dfn_putCache(cache, parent->fallback);
-      dfa_build(parent->fallback, a, cache);
-      return;
-    }
-  }
-  sparseVector_free(nv);
+  // any other rune
+  parent->fallback = dfaBuilder_step(b, parent->v, 1);
+}
 
-  //}
+void dfa_build(dfaNode *parent, SparseAutomaton *a, Vector *cache) {
+  dfaBuilder b = {.a = a, .cache = cache, .scratch = newSparseVectorCap(a->max * 2 + 2)};
+  size_t n = Vector_Size(cache);
+  for (size_t i = 0; i < n; i++) {
+    dfaNode *dfn;
+    Vector_Get(cache, i, &dfn);
+    dfaBuilder_index(&b, dfn);
+  }
+  dfaBuilder_build(&b, parent);
+  rm_free(b.table);
+  sparseVector_free(b.scratch);
 }
 
 DFAFilter *NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode) {
@@ -203,12 +261,10 @@ DFAFilter *NewDFAFilter(rune *str, size_t len, int maxDist, int prefixMode) {
 
   DFAFilter *ret = rm_malloc(sizeof(*ret));
   ret->cache = cache;
-  ret->stack = NewVector(dfaNode *, 8);
-  ret->distStack = NewVector(int, 8);
+  ret->stack = array_new(dfaFrame, 8);
   ret->a = a;
   ret->prefixMode = prefixMode;
-  Vector_Push(ret->stack, dr);
-  Vector_Push(ret->distStack, (maxDist + 1));
+  array_append(ret->stack, ((dfaFrame){dr, maxDist + 1}));
 
   return ret;
 }
@@ -222,23 +278,18 @@ void DFAFilter_Free(DFAFilter *fc) {
   }
 
   Vector_Free(fc->cache);
-  Vector_Free(fc->stack);
-  Vector_Free(fc->distStack);
+  array_free(fc->stack);
 }
 
 FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx, runeTransform rTransform) {
   DFAFilter *fc = ctx;
-  dfaNode *dn;
-  int minDist;
-
-  Vector_Get(fc->stack, Vector_Size(fc->stack) - 1, &dn);
-  Vector_Get(fc->distStack, Vector_Size(fc->distStack) - 1, &minDist);
+  dfaNode *dn = array_tail(fc->stack).n;
+  int minDist = array_tail(fc->stack).minDist;
 
   // a null node means we're in prefix mode, and we're done matching our prefix
   if (dn == NULL) {
     *matched = 1;
-    Vector_Push(fc->stack, NULL);
-    Vector_Push(fc->distStack, minDist);
+    array_append(fc->stack, ((dfaFrame){NULL, minDist}));
     return F_CONTINUE;
   }
 
@@ -267,12 +318,10 @@ FilterCode FilterFunc(rune b, void *ctx, int *matched, void *matchCtx, runeTrans
       }
       //    if (fc->prefixMode) next = NULL;
     }
-    Vector_Push(fc->stack, next);
-    Vector_Push(fc->distStack, MIN(next->distance, minDist));
+    array_append(fc->stack, ((dfaFrame){next, MIN(next->distance, minDist)}));
     return F_CONTINUE;
   } else if (fc->prefixMode && *matched) {
-    Vector_Push(fc->stack, NULL);
-    Vector_Push(fc->distStack, minDist);
+    array_append(fc->stack, ((dfaFrame){NULL, minDist}));
     return F_CONTINUE;
   }
 
@@ -292,8 +341,5 @@ FilterCode LoweringFilterFunc(rune b, void *ctx, int *matched, void *matchCtx) {
 void StackPop(void *ctx, int numLevels) {
   DFAFilter *fc = ctx;
 
-  for (int i = 0; i < numLevels; i++) {
-    Vector_Pop(fc->stack, NULL);
-    Vector_Pop(fc->distStack, NULL);
-  }
+  fc->stack = array_trimm_len(fc->stack, numLevels);
 }
@@ -73,14 +73,19 @@ int SparseAutomaton_IsMatch(SparseAutomaton *a, sparseVector *v);
 /* Can the current state lead to a possible match, or is this a dead end? */
 int SparseAutomaton_CanMatch(SparseAutomaton *a, sparseVector *v);
 
+/* A state of the DFA filter's stack, and the minimal distance leading up to it, used for prefix
+ * matching */
+typedef struct {
+    dfaNode *n;
+    int minDist;
+} dfaFrame;
+
 /* DFAFilter is a constructed DFA used to filter the traversal on the trie */
 typedef struct {
     // a cache of the DFA states, allowing us to reuse the same state whenever we need it
     Vector *cache;
-    // A stack of the states leading up to the current state
-    Vector *stack;
-    // A stack of the minimal distance for each state, used for prefix matching
-    Vector *distStack;
+    // A stack (arr.h) of the states leading up to the current state
+    dfaFrame *stack;
     // whether the filter works in prefix mode or not
     int prefixMode;
 
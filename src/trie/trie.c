@@ -18,6 +18,14 @@
 #include "wildcard.h"
 #include "trie/levenshtein.h"
 
+#if !defined(TRIE_32BIT_RUNES) && defined(__SSE2__)
+#define TRIE_CHILD_LOOKUP_SSE2
+#include <emmintrin.h>
+#elif !defined(TRIE_32BIT_RUNES) && defined(__aarch64__) && defined(__ARM_NEON)
+#define TRIE_CHILD_LOOKUP_NEON
+#include <arm_neon.h>
+#endif
+
 typedef struct {
   rune * buf;
   TrieRangeCallback *callback;
@@ -106,6 +114,40 @@ TrieNode *__trieNode_resizeChildren(TrieNode *n, int offset) {
   return n;
 }
 
+/* Returns the index of the child whose key is `r`, or -1. The keys of the children are distinct,
+ * but only lex-sorted in Trie_Sort_Lex mode, so the keys are compared 8 at a time rather than
+ * binary-searched */
+static int __trieNode_findChild(TrieNode *n, rune r) {
+  const rune *keys = __trieNode_childKey(n, 0);
+  t_len i = 0;
+#if defined(TRIE_CHILD_LOOKUP_SSE2)
+  const __m128i needle = _mm_set1_epi16((short)r);
+  for (; i + 8 <= n->numChildren; i += 8) {
+    __m128i eq = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(keys + i)), needle);
+    int mask = _mm_movemask_epi8(eq);
+    if (mask) {
+      return i + __builtin_ctz(mask) / 2;
+    }
+  }
+#elif defined(TRIE_CHILD_LOOKUP_NEON)
+  const uint16x8_t needle = vdupq_n_u16(r);
+  for (; i + 8 <= n->numChildren; i += 8) {
+    uint16x8_t eq = vceqq_u16(vld1q_u16(keys + i), needle);
+    // Narrow each 16 bit lane to 4 bits of a 64 bit mask
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(eq, 4)), 0);
+    if (mask) {
+      return i + __builtin_ctzll(mask) / 4;
+    }
+  }
+#endif
+  for (; i < n->numChildren; i++) {
+    if (keys[i] == r) {
+      return i;
+    }
+  }
+  return -1;
+}
+
 TrieNode *__trie_AddChildIdx(TrieNode *n, const rune *str, t_len offset, t_len len, RSPayload *payload,
                              float score, int idx) {
   n = __trieNode_resizeChildren(n, 1);
@@ -245,6 +287,7 @@ int TrieNode_Add(TrieNode **np, const rune *str, t_len len, RSPayload *payload,
       // in increment mode, just add the score to the node's score
       case ADD_INCR:
         n->score += score;
+        updateScore(n, n->score);
         break;
 
       // by default we just replace the score
@@ -267,25 +310,30 @@ int TrieNode_Add(TrieNode **np, const rune *str, t_len len, RSPayload *payload,
     return (term && !deleted) ? 0 : 1;
   }
 
-  // proceed to the next child or add a new child for the current rune
-  int idx = 0;
-  int scoreIdx = REDISEARCH_UNINITIALIZED;
-  for (; idx < n->numChildren; idx++) {
-    const rune *childKey = __trieNode_childKey(n, idx);
+  // proceed to the next child
+  int idx = __trieNode_findChild(n, str[offset]);
+  if (idx >= 0) {
     TrieNode *child = __trieNode_children(n)[idx];
-    if (str[offset] == *childKey) {
-      int rc = TrieNode_Add(&child, str + offset, len - offset, payload, score, op, freecb);
-      *__trieNode_childKey(n, idx) = str[offset];
-      __trieNode_children(n)[idx] = child;
-      // In score mode, check if the order was kept and fix as necessary
-      if (n->sortMode == Trie_Sort_Score && n->numChildren > 1) {
-        if ((idx > 0 && child->maxChildScore > __trieNode_children(n)[idx - 1]->maxChildScore) ||
-            (idx < n->numChildren - 2 && child->maxChildScore < __trieNode_children(n)[idx + 1]->maxChildScore)) {
-          __trieNode_sortChildren(n);
-        }
+    int rc = TrieNode_Add(&child, str + offset, len - offset, payload, score, op, freecb);
+    // In increment mode the score of the term is only known once added
+    updateScore(n, child->maxChildScore);
+    *__trieNode_childKey(n, idx) = str[offset];
+    __trieNode_children(n)[idx] = child;
+    // In score mode, check if the order was kept and fix as necessary
+    if (n->sortMode == Trie_Sort_Score && n->numChildren > 1) {
+      if ((idx > 0 && child->maxChildScore > __trieNode_children(n)[idx - 1]->maxChildScore) ||
+          (idx < n->numChildren - 2 && child->maxChildScore < __trieNode_children(n)[idx + 1]->maxChildScore)) {
+        __trieNode_sortChildren(n);
       }
-      return rc;
     }
+    return rc;
+  }
+
+  // or add a new child for the current rune
+  int scoreIdx = REDISEARCH_UNINITIALIZED;
+  for (idx = 0; idx < n->numChildren; idx++) {
+    const rune *childKey = __trieNode_childKey(n, idx);
+    TrieNode *child = __trieNode_children(n)[idx];
     // break if new node has lex value higher than current child
     if (n->sortMode == Trie_Sort_Lex && str[offset] < *childKey) {
       break;
@@ -327,21 +375,10 @@ TrieNode *TrieNode_Get(TrieNode *n, const rune *str, t_len len, bool exact, int
     } else if (localOffset == n->len) {
       // we've reached the end of the node's string but not the search string
       // let's find a child to continue to
-      t_len i = 0;
-      TrieNode *nextChild = NULL;
-      rune *childKeys = __trieNode_childKey(n, 0);
-      for (; i < n->numChildren; i++) {
-        if (str[offset] == childKeys[i]) {
-          nextChild = __trieNode_children(n)[i];
-          break;
-        }
-        if (n->sortMode == Trie_Sort_Lex && str[offset] < childKeys[i]) {
-          break;
-        }
-      }
+      int i = __trieNode_findChild(n, str[offset]);
 
-      // we couldn't find a matching child
-      n = nextChild;
+      // NULL if we couldn't find a matching child
+      n = i >= 0 ? __trieNode_children(n)[i] : NULL;
 
     } else {
       return NULL;
@@ -446,18 +483,10 @@ int TrieNode_Delete(TrieNode *n, const rune *str, t_len len, TrieFreeCallback fr
     } else if (localOffset == n->len) {
       // we've reached the end of the node's string but not the search string
       // let's find a child to continue to
-      t_len i = 0;
-      TrieNode *nextChild = NULL;
-      for (; i < n->numChildren; i++) {
-        rune ckey = *__trieNode_childKey(n, i);
-        if (str[offset] == ckey) {
-          nextChild = __trieNode_children(n)[i];;
-          break;
-        }
-      }
+      int i = __trieNode_findChild(n, str[offset]);
 
-      // we couldn't find a matching child
-      n = nextChild;
+      // NULL if we couldn't find a matching child
+      n = i >= 0 ? __trieNode_children(n)[i] : NULL;
 
     } else {
       goto end;
@@ -1133,6 +1162,34 @@ static void wildcardIterate(TrieNode *n, RangeCtx *r) {
   array_trimm_len(r->buf, n->len);
 }
 
+/* Descends from the root along the literal prefix of the pattern, since only the subtree under it
+ * can match. Returns the node to iterate from, with the path above it in the buffer, or NULL if no
+ * term starts with the prefix */
+static TrieNode *wildcardSeekPrefix(TrieNode *n, RangeCtx *r) {
+  size_t prefixLen = Wildcard_LiteralPrefixRune(r->origStr, r->lenOrigStr);
+  size_t offset = 0;
+  while (offset < prefixLen) {
+    int idx = __trieNode_findChild(n, r->origStr[offset]);
+    if (idx < 0) {
+      return NULL;
+    }
+    TrieNode *child = __trieNode_children(n)[idx];
+    size_t cmpLen = MIN(child->len, prefixLen - offset);
+    if (memcmp(child->str, r->origStr + offset, cmpLen * sizeof(rune))) {
+      return NULL;
+    }
+    if (child->len > cmpLen) {
+      // The prefix ends inside this node
+      return child;
+    }
+    r->buf = array_ensure_append(r->buf, child->str, child->len, rune);
+    offset += child->len;
+    n = child;
+  }
+  array_trimm_len(r->buf, n->len);
+  return n;
+}
+
 void TrieNode_IterateWildcard(TrieNode *n, const rune *str, int nstr,
                               TrieRangeCallback callback, void *ctx, struct timespec *timeout) {
   RangeCtx r = {
@@ -1148,7 +1205,13 @@ void TrieNode_IterateWildcard(TrieNode *n, const rune *str, int nstr,
       .containsStars = !!runenchr(str, nstr, '*'),
   };
 
-  wildcardIterate(n, &r);
+  // Only the root has no string of its own
+  if (n->len == 0) {
+    n = wildcardSeekPrefix(n, &r);
+  }
+  if (n) {
+    wildcardIterate(n, &r);
+  }
 
   array_free(r.buf);
 }
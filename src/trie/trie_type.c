@@ -16,6 +16,7 @@
 #include "trie_type.h"
 #include "rmalloc.h"
 #include "rdb.h"
+#include "triemap.h"
 
 #include <math.h>
 #include <sys/param.h>
@@ -23,6 +24,194 @@
 #include <string.h>
 #include <limits.h>
 
+/* The score of a term found for a query, as the suggestions are ranked */
+static float suggestionScore(float score, const rune *rstr, t_len slen, const rune *runes,
+                             size_t rlen, size_t len, int maxDist, int dist, int prefixMode) {
+  score = slen > 0 && slen == rlen && memcmp(runes, rstr, slen) == 0 ? (float)INT_MAX : score;
+
+  if (maxDist > 0) {
+    // factor the distance into the score
+    score *= exp((double)-(2 * dist));
+  }
+  // in prefix mode we also factor in the total length of the suffix
+  if (prefixMode) {
+    score /= sqrt(1 + (slen >= len ? slen - len : len - slen));
+  }
+  return score;
+}
+
+/***************************************************************
+ *
+ *                    Suggestion cache
+ *
+ * Each cached prefix holds the TRIE_SUGGEST_CACHE_SIZE terms with the highest scores for its
+ * query, sorted by decreasing score. An inserted term can only enter the list, and a term of the
+ * list can only move up, so the lists are updated in place; otherwise, when a term of a list is
+ * deleted or its score decreases, the next term may be anywhere in the subtree and the prefix is
+ * dropped from the cache, to be searched again.
+ ***************************************************************/
+
+typedef struct {
+  char *str;
+  size_t len;
+  float score;
+  char *payload;
+  size_t plen;
+} suggestCacheItem;
+
+typedef struct {
+  size_t queryLen;  // Byte length of the query, which the scores depend on
+  suggestCacheItem items[TRIE_SUGGEST_CACHE_SIZE];
+} suggestCacheEntry;
+
+static void suggestCacheItem_Set(suggestCacheItem *item, float score, const char *payload,
+                                 size_t plen) {
+  rm_free(item->payload);
+  item->score = score;
+  item->payload = plen ? rm_malloc(plen) : NULL;
+  item->plen = plen;
+  if (plen) {
+    memcpy(item->payload, payload, plen);
+  }
+}
+
+static void suggestCacheEntry_Free(void *p) {
+  suggestCacheEntry *e = p;
+  for (size_t i = 0; i < TRIE_SUGGEST_CACHE_SIZE; ++i) {
+    rm_free(e->items[i].str);
+    rm_free(e->items[i].payload);
+  }
+  rm_free(e);
+}
+
+/* Moves up the item at `i` to keep the items sorted */
+static void suggestCacheEntry_Raise(suggestCacheEntry *e, size_t i) {
+  while (i > 0 && e->items[i].score > e->items[i - 1].score) {
+    suggestCacheItem tmp = e->items[i];
+    e->items[i] = e->items[i - 1];
+    e->items[--i] = tmp;
+  }
+}
+
+/* Updates an entry with the new score of a term under its prefix. Returns false if the entry can no
+ * longer be trusted */
+static bool suggestCacheEntry_Update(suggestCacheEntry *e, const rune *prefix, size_t prefixLen,
+                                     const rune *runes, size_t len, const char *str, size_t slen,
+                                     const TrieNode *node) {
+  float score = suggestionScore(node->score, runes, len, prefix, prefixLen, e->queryLen, 0, 0, 1);
+  const char *payload = node->payload ? node->payload->data : NULL;
+  size_t plen = node->payload ? node->payload->len : 0;
+
+  for (size_t i = 0; i < TRIE_SUGGEST_CACHE_SIZE; ++i) {
+    suggestCacheItem *item = &e->items[i];
+    if (item->len == slen && !memcmp(item->str, str, slen)) {
+      if (score < item->score) {
+        return false;
+      }
+      suggestCacheItem_Set(item, score, payload, plen);
+      suggestCacheEntry_Raise(e, i);
+      return true;
+    }
+  }
+
+  suggestCacheItem *last = &e->items[TRIE_SUGGEST_CACHE_SIZE - 1];
+  if (score > last->score) {
+    rm_free(last->str);
+    last->str = rm_strndup(str, slen);
+    last->len = slen;
+    suggestCacheItem_Set(last, score, payload, plen);
+    suggestCacheEntry_Raise(e, TRIE_SUGGEST_CACHE_SIZE - 1);
+  }
+  return true;
+}
+
+/* Updates or drops the cached prefixes of a term after its insertion (with `node`) or its
+ * deletion (with no node) */
+static void suggestCache_UpdateTerm(Trie *t, const rune *runes, size_t len, const TrieNode *node) {
+  if (!t->suggestCache) {
+    return;
+  }
+  rune prefix[TRIE_SUGGEST_CACHE_PREFIX];
+  char *str = NULL;
+  size_t slen = 0;
+  for (size_t i = 0; i < TRIE_SUGGEST_CACHE_PREFIX && i < len; ++i) {
+    prefix[i] = runeFold(runes[i]);
+    const char *key = (const char *)prefix;
+    tm_len_t keyLen = (i + 1) * sizeof(rune);
+    suggestCacheEntry *e = TrieMap_Find(t->suggestCache, key, keyLen);
+    if (e == TRIEMAP_NOTFOUND) {
+      continue;
+    }
+    if (!str) {
+      str = runesToStr(runes, len, &slen);
+    }
+
+    bool keep;
+    if (node) {
+      keep = suggestCacheEntry_Update(e, prefix, i + 1, runes, len, str, slen, node);
+    } else {
+      keep = true;
+      for (size_t j = 0; j < TRIE_SUGGEST_CACHE_SIZE && keep; ++j) {
+        keep = e->items[j].len != slen || memcmp(e->items[j].str, str, slen);
+      }
+    }
+    if (!keep) {
+      TrieMap_Delete(t->suggestCache, key, keyLen, suggestCacheEntry_Free);
+    }
+  }
+  rm_free(str);
+}
+
+/* Returns the cached suggestions of a prefix, or NULL if it is not cached */
+static Vector *suggestCache_Get(Trie *t, const rune *prefix, size_t prefixLen, size_t queryLen,
+                                size_t num) {
+  if (!t->suggestCache) {
+    return NULL;
+  }
+  suggestCacheEntry *e = TrieMap_Find(t->suggestCache, (const char *)prefix,
+                                      prefixLen * sizeof(rune));
+  if (e == TRIEMAP_NOTFOUND || e->queryLen != queryLen) {
+    return NULL;
+  }
+
+  Vector *ret = NewVector(TrieSearchResult *, num);
+  for (size_t i = 0; i < num; ++i) {
+    const suggestCacheItem *item = &e->items[i];
+    TrieSearchResult *res = rm_malloc(sizeof(*res));
+    res->str = rm_strndup(item->str, item->len);
+    res->len = item->len;
+    res->score = item->score;
+    res->payload = item->payload;
+    res->plen = item->plen;
+    Vector_Put(ret, i, res);
+  }
+  return ret;
+}
+
+/* Caches the top suggestions of a prefix, as returned by the search */
+static void suggestCache_Put(Trie *t, const rune *prefix, size_t prefixLen, size_t queryLen,
+                             Vector *res) {
+  if (Vector_Size(res) < TRIE_SUGGEST_CACHE_SIZE) {
+    return;
+  }
+  if (!t->suggestCache) {
+    t->suggestCache = NewTrieMap();
+  }
+
+  suggestCacheEntry *e = rm_calloc(1, sizeof(*e));
+  e->queryLen = queryLen;
+  for (size_t i = 0; i < TRIE_SUGGEST_CACHE_SIZE; ++i) {
+    TrieSearchResult *h;
+    Vector_Get(res, i, &h);
+    e->items[i].str = rm_strndup(h->str, h->len);
+    e->items[i].len = h->len;
+    suggestCacheItem_Set(&e->items[i], h->score, h->payload, h->plen);
+  }
+  TrieMap_Delete(t->suggestCache, (const char *)prefix, prefixLen * sizeof(rune),
+                 suggestCacheEntry_Free);
+  TrieMap_Add(t->suggestCache, (const char *)prefix, prefixLen * sizeof(rune), e, NULL);
+}
+
 Trie *NewTrie(TrieFreeCallback freecb, TrieSortMode sortMode) {
   Trie *tree = rm_malloc(sizeof(Trie));
   rune *rs = strToRunes("", 0);
@@ -30,6 +219,7 @@ Trie *NewTrie(TrieFreeCallback freecb, TrieSortMode sortMode) {
   tree->size = 0;
   tree->freecb = freecb;
   tree->sortMode = sortMode;
+  tree->suggestCache = NULL;
   rm_free(rs);
   return tree;
 }
@@ -59,6 +249,12 @@ int Trie_InsertRune(Trie *t, const rune *runes, size_t len, double score, int in
   if (runes && len && len < TRIE_INITIAL_STRING_LEN) {
     rc = TrieNode_Add(&t->root, runes, len, payload, (float)score, incr ? ADD_INCR : ADD_REPLACE, t->freecb);
     t->size += rc;
+    if (t->suggestCache) {
+      TrieNode *node = TrieNode_Get(t->root, runes, len, true, NULL);
+      if (node) {
+        suggestCache_UpdateTerm(t, runes, len, node);
+      }
+    }
   }
   return rc;
 }
@@ -92,6 +288,9 @@ int Trie_Delete(Trie *t, const char *s, size_t len) {
 int Trie_DeleteRunes(Trie *t, const rune *runes, size_t len) {
   int rc = TrieNode_Delete(t->root, runes, len, t->freecb);
   t->size -= rc;
+  if (rc) {
+    suggestCache_UpdateTerm(t, runes, len, NULL);
+  }
   return rc;
 }
 
@@ -133,20 +332,10 @@ TrieIterator *Trie_Iterate(Trie *t, const char *prefix, size_t len, int maxDist,
   return it;
 }
 
-Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDist, int prefixMode,
-                    int trim, int optimize) {
-
-  if (len > TRIE_MAX_PREFIX * sizeof(rune)) {
-    return NULL;
-  }
-  size_t rlen;
-  rune *runes = strToSingleCodepointFoldedRunes(s, &rlen);
-  // make sure query length does not overflow
-  if (!runes || rlen >= TRIE_MAX_PREFIX) {
-    rm_free(runes);
-    return NULL;
-  }
-
+/* Returns the `num` terms with the highest scores for the folded query runes, sorted by decreasing
+ * score, and the number of terms the search went through in `numCandidates` */
+static Vector *trieSearch(Trie *tree, const rune *runes, size_t rlen, size_t len, size_t num,
+                          int maxDist, int prefixMode, size_t *numCandidates) {
   heap_t *pq = rm_malloc(heap_sizeof(num));
   heap_init(pq, cmpEntries, NULL, num);
 
@@ -161,7 +350,9 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
 
   TrieSearchResult *pooledEntry = NULL;
   int dist = maxDist + 1;
+  *numCandidates = 0;
   while (TrieIterator_Next(it, &rstr, &slen, &payload, &score, &dist)) {
+    ++*numCandidates;
     if (pooledEntry == NULL) {
       pooledEntry = rm_malloc(sizeof(TrieSearchResult));
       pooledEntry->str = NULL;
@@ -170,16 +361,7 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
     }
     TrieSearchResult *ent = pooledEntry;
 
-    ent->score = slen > 0 && slen == rlen && memcmp(runes, rstr, slen) == 0 ? (float)INT_MAX : score;
-
-    if (maxDist > 0) {
-      // factor the distance into the score
-      ent->score *= exp((double)-(2 * dist));
-    }
-    // in prefix mode we also factor in the total length of the suffix
-    if (prefixMode) {
-      ent->score /= sqrt(1 + (slen >= len ? slen - len : len - slen));
-    }
+    ent->score = suggestionScore(score, rstr, slen, runes, rlen, len, maxDist, dist, prefixMode);
 
     if (heap_count(pq) < heap_size(pq)) {
       ent->str = runesToStr(rstr, slen, &ent->len);
@@ -229,6 +411,47 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
     Vector_Put(ret, n - i - 1, h);
   }
 
+  TrieIterator_Free(it);
+  heap_free(pq);
+  return ret;
+}
+
+Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDist, int prefixMode,
+                    int trim, int optimize) {
+
+  if (len > TRIE_MAX_PREFIX * sizeof(rune)) {
+    return NULL;
+  }
+  size_t rlen;
+  rune *runes = strToSingleCodepointFoldedRunes(s, &rlen);
+  // make sure query length does not overflow
+  if (!runes || rlen >= TRIE_MAX_PREFIX) {
+    rm_free(runes);
+    return NULL;
+  }
+
+  // The short prefixes match the most terms, so their top suggestions are cached
+  bool cacheable = maxDist == 0 && prefixMode && rlen > 0 && rlen <= TRIE_SUGGEST_CACHE_PREFIX &&
+                   num <= TRIE_SUGGEST_CACHE_SIZE;
+  Vector *ret = cacheable ? suggestCache_Get(tree, runes, rlen, len, num) : NULL;
+  if (!ret) {
+    size_t numCandidates;
+    ret = trieSearch(tree, runes, rlen, len, cacheable ? TRIE_SUGGEST_CACHE_SIZE : num, maxDist,
+                     prefixMode, &numCandidates);
+    if (cacheable) {
+      if (numCandidates >= TRIE_SUGGEST_CACHE_MIN_TERMS) {
+        suggestCache_Put(tree, runes, rlen, len, ret);
+      }
+      for (size_t i = num; i < Vector_Size(ret); ++i) {
+        TrieSearchResult *h;
+        Vector_Get(ret, i, &h);
+        TrieSearchResult_Free(h);
+      }
+      ret->top = MIN(num, Vector_Size(ret));
+    }
+  }
+  size_t n = Vector_Size(ret);
+
   // trim the results to remove irrelevant results
   if (trim) {
     float maxScore = 0;
@@ -253,9 +476,6 @@ Vector *Trie_Search(Trie *tree, const char *s, size_t len, size_t num, int maxDi
   }
 
   rm_free(runes);
-  TrieIterator_Free(it);
-  heap_free(pq);
-
   return ret;
 }
 
@@ -379,6 +599,9 @@ void TrieType_Free(void *value) {
   if (tree->root) {
     TrieNode_Free(tree->root, tree->freecb);
   }
+  if (tree->suggestCache) {
+    TrieMap_Free(tree->suggestCache, suggestCacheEntry_Free);
+  }
 
   rm_free(tree);
 }
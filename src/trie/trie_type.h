@@ -23,11 +23,21 @@ extern RedisModuleType *TrieType;
 #define TRIE_ENCVER_CURRENT 1
 #define TRIE_ENCVER_NOPAYLOADS 0
 
+// Prefixes up to this number of runes have their top suggestions cached by Trie_Search
+#define TRIE_SUGGEST_CACHE_PREFIX 3
+// The number of suggestions cached per prefix, which is the largest MAX served from the cache
+#define TRIE_SUGGEST_CACHE_SIZE 16
+// A prefix is only cached once its search went through at least this number of terms
+#define TRIE_SUGGEST_CACHE_MIN_TERMS 256
+
 typedef struct {
   TrieNode *root;
   size_t size;
   TrieFreeCallback freecb;
   TrieSortMode sortMode;
+  // The top suggestions of the short prefixes searched on large subtrees, by folded prefix. Kept up
+  // to date by the insertions and the deletions, or dropped when they cannot be
+  struct TrieMap *suggestCache;
 } Trie;
 
 typedef struct {
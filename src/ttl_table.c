@@ -13,11 +13,34 @@
 #include "util/misc.h"
 #include "rmutil/rm_assert.h"
 
+#include <string.h>
+
 typedef struct {
   t_expirationTimePoint documentExpirationPoint;
   FieldExpiration* fieldExpirations;
 } TimeToLiveEntry;
 
+// The expiration times are counted in wheel slots of 2^TTL_WHEEL_SLOT_SHIFT seconds
+#define TTL_WHEEL_SLOT_SHIFT 6
+#define TTL_WHEEL_SLOTS 1024
+
+struct TimeToLiveTable {
+  dict *entries;  // doc id -> TimeToLiveEntry
+
+  // The expiration times of the entries, counted by slot. The wheel covers the slots from `base`
+  // on, and the times before and after it are only counted. Once the wheel is empty, it is rebuilt
+  // from the earliest time in the table.
+  struct {
+    int64_t base;
+    uint32_t first;     // The first slot with a time in the wheel, TTL_WHEEL_SLOTS if none
+    size_t early;       // Times before the wheel
+    size_t late;        // Times after the wheel
+    int64_t lateMin;    // A lower bound of the slots of the late times
+    int64_t nextDue;    // No time in the table is in an earlier slot
+    uint32_t counts[TTL_WHEEL_SLOTS];
+  } wheel;
+};
+
 static uint64_t hashFunction_DocId(const void *key) {
   return (t_docId)key;
 }
@@ -36,15 +59,124 @@ static dictType dictTimeToLive = {
   .valDestructor = destructor_TimeToLiveEntry,
 };
 
+static inline bool hasTime(const t_expirationTimePoint *point) {
+  return point->tv_sec || point->tv_nsec;
+}
+
+static void wheelReset(TimeToLiveTable *table, int64_t base) {
+  memset(&table->wheel, 0, sizeof(table->wheel));
+  table->wheel.base = base;
+  table->wheel.first = TTL_WHEEL_SLOTS;
+  table->wheel.lateMin = INT64_MAX;
+  table->wheel.nextDue = INT64_MAX;
+}
+
+static void wheelAddTime(TimeToLiveTable *table, const t_expirationTimePoint *point) {
+  if (!hasTime(point)) {
+    return;
+  }
+  int64_t slot = point->tv_sec >> TTL_WHEEL_SLOT_SHIFT;
+  if (slot < table->wheel.base) {
+    table->wheel.early++;
+  } else if (slot - table->wheel.base >= TTL_WHEEL_SLOTS) {
+    table->wheel.late++;
+    table->wheel.lateMin = MIN(table->wheel.lateMin, slot);
+  } else {
+    uint32_t i = slot - table->wheel.base;
+    table->wheel.counts[i]++;
+    table->wheel.first = MIN(table->wheel.first, i);
+  }
+}
+
+static void wheelRemoveTime(TimeToLiveTable *table, const t_expirationTimePoint *point) {
+  if (!hasTime(point)) {
+    return;
+  }
+  int64_t slot = point->tv_sec >> TTL_WHEEL_SLOT_SHIFT;
+  if (slot < table->wheel.base) {
+    table->wheel.early--;
+  } else if (slot - table->wheel.base >= TTL_WHEEL_SLOTS) {
+    if (!--table->wheel.late) {
+      table->wheel.lateMin = INT64_MAX;
+    }
+  } else {
+    table->wheel.counts[slot - table->wheel.base]--;
+    while (table->wheel.first < TTL_WHEEL_SLOTS && !table->wheel.counts[table->wheel.first]) {
+      table->wheel.first++;
+    }
+  }
+}
+
+static void wheelAddEntry(TimeToLiveTable *table, const TimeToLiveEntry *entry) {
+  wheelAddTime(table, &entry->documentExpirationPoint);
+  for (size_t i = 0; i < array_len(entry->fieldExpirations); i++) {
+    wheelAddTime(table, &entry->fieldExpirations[i].point);
+  }
+}
+
+static void wheelRemoveEntry(TimeToLiveTable *table, const TimeToLiveEntry *entry) {
+  wheelRemoveTime(table, &entry->documentExpirationPoint);
+  for (size_t i = 0; i < array_len(entry->fieldExpirations); i++) {
+    wheelRemoveTime(table, &entry->fieldExpirations[i].point);
+  }
+}
+
+static int64_t entryMinSlot(const TimeToLiveEntry *entry) {
+  int64_t slot = INT64_MAX;
+  if (hasTime(&entry->documentExpirationPoint)) {
+    slot = entry->documentExpirationPoint.tv_sec >> TTL_WHEEL_SLOT_SHIFT;
+  }
+  for (size_t i = 0; i < array_len(entry->fieldExpirations); i++) {
+    if (hasTime(&entry->fieldExpirations[i].point)) {
+      slot = MIN(slot, entry->fieldExpirations[i].point.tv_sec >> TTL_WHEEL_SLOT_SHIFT);
+    }
+  }
+  return slot;
+}
+
+// Restarts the wheel from the earliest time in the table, once all its times are after the wheel
+static void wheelRebuild(TimeToLiveTable *table) {
+  int64_t base = INT64_MAX;
+  dictIterator *iter = dictGetIterator(table->entries);
+  dictEntry *de;
+  while ((de = dictNext(iter))) {
+    base = MIN(base, entryMinSlot(dictGetVal(de)));
+  }
+  wheelReset(table, base);
+  dictReleaseIterator(iter);
+  iter = dictGetIterator(table->entries);
+  while ((de = dictNext(iter))) {
+    wheelAddEntry(table, dictGetVal(de));
+  }
+  dictReleaseIterator(iter);
+}
+
+// Updates `nextDue` after times were added or removed
+static void wheelUpdate(TimeToLiveTable *table) {
+  if (!table->wheel.early && table->wheel.first == TTL_WHEEL_SLOTS && table->wheel.late) {
+    wheelRebuild(table);
+  }
+  if (table->wheel.early) {
+    table->wheel.nextDue = INT64_MIN;
+  } else if (table->wheel.first < TTL_WHEEL_SLOTS) {
+    table->wheel.nextDue = MIN(table->wheel.base + table->wheel.first, table->wheel.lateMin);
+  } else {
+    table->wheel.nextDue = table->wheel.lateMin;
+  }
+}
+
 void TimeToLiveTable_VerifyInit(TimeToLiveTable **table) {
     if (!*table) {
-      *table = dictCreate(&dictTimeToLive, NULL);
+      *table = rm_malloc(sizeof(**table));
+      (*table)->entries = dictCreate(&dictTimeToLive, NULL);
+      wheelReset(*table, 0);
     }
 }
 
 void TimeToLiveTable_Destroy(TimeToLiveTable **table) {
     if (*table) {
-      dictRelease(*table);
+      dictRelease((*table)->entries);
+      rm_free(*table);
       *table = NULL;
     }
 }
@@ -54,16 +186,62 @@ void TimeToLiveTable_Add(TimeToLiveTable *table, t_docId docId, t_expirationTime
   entry->documentExpirationPoint = docExpirationTime;
   entry->fieldExpirations = sortedById;
   // we don't want the operation to fail so we use dictReplace
-  const bool added = dictAdd(table, (void*)docId, entry) == DICT_OK;
+  const bool added = dictAdd(table->entries, (void*)docId, entry) == DICT_OK;
   RS_LOG_ASSERT(added, "Failed to add document to ttl table");
+  if (!table->wheel.early && !table->wheel.late && table->wheel.first == TTL_WHEEL_SLOTS) {
+    // The wheel is empty, so it starts at the times of this entry
+    table->wheel.base = entryMinSlot(entry);
+  }
+  wheelAddEntry(table, entry);
+  wheelUpdate(table);
+}
+
+void TimeToLiveTable_AddFields(TimeToLiveTable *table, t_docId docId, arrayof(FieldExpiration) sortedById) {
+  dictEntry *de = dictFind(table->entries, (void*)docId);
+  if (!de) {
+    t_expirationTimePoint none = {0};
+    TimeToLiveTable_Add(table, docId, none, sortedById);
+    return;
+  }
+  TimeToLiveEntry *entry = dictGetVal(de);
+  wheelRemoveEntry(table, entry);
+  FieldExpiration *old = entry->fieldExpirations;
+  const size_t nold = array_len(old), nnew = array_len(sortedById);
+  FieldExpiration *merged = array_new(FieldExpiration, nold + nnew);
+  size_t i = 0, j = 0;
+  while (i < nold || j < nnew) {
+    if (j == nnew || (i < nold && old[i].index < sortedById[j].index)) {
+      array_append(merged, old[i++]);
+    } else {
+      array_append(merged, sortedById[j++]);
+    }
+  }
+  array_free(old);
+  array_free(sortedById);
+  entry->fieldExpirations = merged;
+  if (!table->wheel.early && !table->wheel.late && table->wheel.first == TTL_WHEEL_SLOTS) {
+    table->wheel.base = entryMinSlot(entry);
+  }
+  wheelAddEntry(table, entry);
+  wheelUpdate(table);
 }
 
 void TimeToLiveTable_Remove(TimeToLiveTable *table, t_docId docId) {
-  dictDelete(table, (void*)docId);
+  dictEntry *de = dictFind(table->entries, (void*)docId);
+  if (!de) {
+    return;
+  }
+  wheelRemoveEntry(table, dictGetVal(de));
+  dictDelete(table->entries, (void*)docId);
+  wheelUpdate(table);
 }
 
 bool TimeToLiveTable_IsEmpty(TimeToLiveTable *table) {
-  return dictSize(table) == 0;
+  return dictSize(table->entries) == 0;
+}
+
+bool TimeToLiveTable_AnyExpired(const TimeToLiveTable *table, const struct timespec* now) {
+  return (now->tv_sec >> TTL_WHEEL_SLOT_SHIFT) >= table->wheel.nextDue;
 }
 
 static inline bool DidExpire(const t_expirationTimePoint* field, const t_expirationTimePoint* now) {
@@ -75,7 +253,10 @@ static inline bool DidExpire(const t_expirationTimePoint* field, const t_expirat
 }
 
 bool TimeToLiveTable_HasDocExpired(TimeToLiveTable *table, t_docId docId, const struct timespec* expirationPoint) {
-  dictEntry *entry = dictFind(table, (void*)docId);
+  if (!TimeToLiveTable_AnyExpired(table, expirationPoint)) {
+    return false;
+  }
+  dictEntry *entry = dictFind(table->entries, (void*)docId);
   if (!entry) {
     return false;
   }
@@ -85,7 +266,11 @@ bool TimeToLiveTable_HasDocExpired(TimeToLiveTable *table, t_docId docId, const
 }
 
 bool TimeToLiveTable_VerifyDocAndField(TimeToLiveTable *table, t_docId docId, t_fieldIndex field, enum FieldExpirationPredicate predicate, const struct timespec* expirationPoint) {
-  dictEntry *entry = dictFind(table, (void*)docId);
+  if (predicate == FIELD_EXPIRATION_DEFAULT && !TimeToLiveTable_AnyExpired(table, expirationPoint)) {
+    // no field has expired yet
+    return true;
+  }
+  dictEntry *entry = dictFind(table->entries, (void*)docId);
   if (!entry) {
     // the document did not have a ttl for itself or its fields
     // if predicate is default then we know at least one field is valid
@@ -120,7 +305,11 @@ bool TimeToLiveTable_VerifyDocAndField(TimeToLiveTable *table, t_docId docId, t_
 }
 
 bool TimeToLiveTable_VerifyDocAndFieldMask(TimeToLiveTable *table, t_docId docId, uint32_t fieldMask, enum FieldExpirationPredicate predicate, const struct timespec* expirationPoint, const t_fieldIndex* ftIdToFieldIndex) {
-  dictEntry *entry = dictFind(table, (void*)docId);
+  if (predicate == FIELD_EXPIRATION_DEFAULT && fieldMask && !TimeToLiveTable_AnyExpired(table, expirationPoint)) {
+    // no field has expired yet
+    return true;
+  }
+  dictEntry *entry = dictFind(table->entries, (void*)docId);
   if (!entry) {
     // the document did not have a ttl for itself or its fields
     // if predicate is default then we know at least one field is valid
@@ -183,7 +372,11 @@ bool TimeToLiveTable_VerifyDocAndFieldMask(TimeToLiveTable *table, t_docId docId
 
 // TODO: Rust - unify with the implementation above using generic field mask
 bool TimeToLiveTable_VerifyDocAndWideFieldMask(TimeToLiveTable *table, t_docId docId, t_fieldMask fieldMask, enum FieldExpirationPredicate predicate, const struct timespec* expirationPoint, const t_fieldIndex* ftIdToFieldIndex) {
-  dictEntry *entry = dictFind(table, (void*)docId);
+  if (predicate == FIELD_EXPIRATION_DEFAULT && fieldMask && !TimeToLiveTable_AnyExpired(table, expirationPoint)) {
+    // no field has expired yet
+    return true;
+  }
+  dictEntry *entry = dictFind(table->entries, (void*)docId);
   if (!entry) {
     // the document did not have a ttl for itself or its fields
     // if predicate is default then we know at least one field is valid
@@ -23,14 +23,24 @@ typedef struct {
   t_expirationTimePoint point;
 } FieldExpiration;
 
-typedef dict TimeToLiveTable;
+/* The expiration times of the documents of a table, and of their fields, by doc id. The pending
+ * expirations are also counted in a timer wheel, so that as long as none of them is due the checks
+ * return without looking up the document */
+typedef struct TimeToLiveTable TimeToLiveTable;
 
 void TimeToLiveTable_VerifyInit(TimeToLiveTable **table);
 void TimeToLiveTable_Destroy(TimeToLiveTable **table);
 void TimeToLiveTable_Add(TimeToLiveTable *table, t_docId docId, t_expirationTimePoint docExpiration, arrayof(FieldExpiration) sortedById);
+/* Adds the expiration times of fields to the entry of a document, which is created if needed. The
+ * fields must not be in the entry already */
+void TimeToLiveTable_AddFields(TimeToLiveTable *table, t_docId docId, arrayof(FieldExpiration) sortedById);
 void TimeToLiveTable_Remove(TimeToLiveTable *table, t_docId docId);
 bool TimeToLiveTable_IsEmpty(TimeToLiveTable *table);
 
+/* Returns false if none of the expiration times in the table has passed at `now`, in which case
+ * every document and field in the table is still valid */
+bool TimeToLiveTable_AnyExpired(const TimeToLiveTable *table, const struct timespec* now);
+
 bool TimeToLiveTable_HasDocExpired(TimeToLiveTable *table, t_docId docId, const struct timespec* expirationPoint);
 
 bool TimeToLiveTable_VerifyDocAndField(TimeToLiveTable *table, t_docId docId, t_fieldIndex fieldIndex, enum FieldExpirationPredicate predicate, const struct timespec* expirationPoint);
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "arena.h"
+#include <pthread.h>
+#include <string.h>
+#include <sys/param.h>
+
+static pthread_key_t currentArenaKey_g;
+
+static void __attribute__((constructor)) initCurrentArenaKey() {
+  pthread_key_create(&currentArenaKey_g, NULL);
+}
+
+void *Arena_Alloc(Arena *a, size_t size) {
+  size = (size + 15) & ~(size_t)15;
+  void *p = BlkAlloc_Alloc(&a->blocks, size, MAX(size, ARENA_BLOCK_SIZE));
+  memset(p, 0, size);
+  a->bytes += size;
+  a->numObjects++;
+  return p;
+}
+
+char *Arena_Strndup(Arena *a, const char *s, size_t len) {
+  char *p = Arena_Alloc(a, len + 1);
+  memcpy(p, s, len);
+  return p;
+}
+
+void Arena_Free(Arena *a) {
+  BlkAlloc_FreeAll(&a->blocks, NULL, NULL, 0);
+  *a = (Arena){0};
+}
+
+Arena *Arena_SetCurrent(Arena *a) {
+  Arena *prev = pthread_getspecific(currentArenaKey_g);
+  pthread_setspecific(currentArenaKey_g, a);
+  return prev;
+}
+
+Arena *Arena_Current(void) {
+  return pthread_getspecific(currentArenaKey_g);
+}
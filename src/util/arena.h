@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include "block_alloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the blocks the objects of an arena are carved from
+#define ARENA_BLOCK_SIZE 4096
+
+/**
+ * A bump allocator for the objects which live as long as a request. The objects are packed in
+ * blocks, are not freed on their own, and are all released at once by Arena_Free. A zeroed arena
+ * is an empty one.
+ *
+ * Code which allocates objects without a handle on the request (e.g. the query parser) opts in with
+ * Arena_Current, which returns the arena the calling thread is working for, if any. The objects
+ * must remember where they were allocated, so that they are not freed on their own.
+ */
+typedef struct {
+  BlkAlloc blocks;
+  size_t bytes;       // The bytes of the objects allocated from the arena
+  size_t numObjects;
+} Arena;
+
+/* Allocate a zeroed object, aligned on 16 bytes */
+void *Arena_Alloc(Arena *a, size_t size);
+
+/* Copy the first `len` bytes of a string into the arena, NUL terminated */
+char *Arena_Strndup(Arena *a, const char *s, size_t len);
+
+/* Release all the objects of the arena, leaving it empty */
+void Arena_Free(Arena *a);
+
+/* Set the arena the calling thread allocates its request objects from (NULL for none), returning
+ * the previous one, which should be set back once done */
+Arena *Arena_SetCurrent(Arena *a);
+
+/* The arena the calling thread allocates its request objects from, or NULL */
+Arena *Arena_Current(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -88,8 +88,8 @@ void *BlkAlloc_Alloc(BlkAlloc *blocks, size_t elemSize, size_t blockSize) {
   if (!blocks->root) {
     blocks->root = blocks->last = getNewBlock(blocks, blockSize);
 
-  } else if (blocks->last->numUsed + elemSize > blockSize) {
-    // Allocate a new element
+  } else if (blocks->last->numUsed + elemSize > blocks->last->capacity) {
+    // Allocate a new block. A recycled block may be larger than blockSize, and is filled up first
     BlkAllocBlock *newBlock = getNewBlock(blocks, blockSize);
     blocks->last->next = newBlock;
     blocks->last = newBlock;
@@ -43,7 +43,8 @@ static inline void BlkAlloc_Init(BlkAlloc *alloc) {
  * (if the current block has no more room for elemSize). blockSize should be
  * greater than elemSize, and should likely be a multiple thereof.
  *
- * The returned pointer remains valid until FreeAll is called.
+ * The returned pointer remains valid until FreeAll is called. The elements are packed up to the
+ * capacity of the current block, which may exceed blockSize when it was recycled by Clear.
  */
 void *BlkAlloc_Alloc(BlkAlloc *alloc, size_t elemSize, size_t blockSize);
 
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#if defined(__linux__)
+// For the CPU_* macros and sched_setaffinity
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include "cpu_affinity.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+// The highest CPU a list may name
+#if defined(__linux__)
+#define CPU_LIST_MAX CPU_SETSIZE
+#else
+#define CPU_LIST_MAX 1024
+#endif
+
+typedef void (*CPUList_Callback)(unsigned long cpu, void *ctx);
+
+static bool parseCPU(const char **p, unsigned long *cpu) {
+  if (!isdigit((unsigned char)**p)) {
+    return false;
+  }
+  char *end;
+  *cpu = strtoul(*p, &end, 10);
+  *p = end;
+  return *cpu < CPU_LIST_MAX;
+}
+
+/* Call `cb` with every CPU of the list. Returns false if it is malformed (in which case `cb` may
+ * have been called with some of its CPUs) */
+static bool CPUList_ForEach(const char *list, CPUList_Callback cb, void *ctx) {
+  const char *p = list;
+  while (*p) {
+    unsigned long first, last;
+    if (!parseCPU(&p, &first)) {
+      return false;
+    }
+    last = first;
+    if (*p == '-') {
+      p++;
+      if (!parseCPU(&p, &last) || last < first) {
+        return false;
+      }
+    }
+    if (cb) {
+      for (unsigned long cpu = first; cpu <= last; cpu++) {
+        cb(cpu, ctx);
+      }
+    }
+    if (*p == ',') {
+      p++;
+      if (!*p) {
+        return false;
+      }
+    } else if (*p) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CPUList_IsValid(const char *list) {
+  return !list || CPUList_ForEach(list, NULL, NULL);
+}
+
+#if defined(__linux__)
+static void addCPU(unsigned long cpu, void *ctx) {
+  CPU_SET(cpu, (cpu_set_t *)ctx);
+}
+#endif
+
+bool CPUList_PinCurrentThread(const char *list) {
+  if (!list || !*list) {
+    return true;
+  }
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (!CPUList_ForEach(list, addCPU, &set)) {
+    return false;
+  }
+  // With a pid of 0 the calling thread is pinned, not the whole process
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Placement of the threads of the module on CPU sets, e.g. to keep the workers on the NUMA node
+ * of the memory they read. A CPU list is a comma separated list of CPUs and of inclusive ranges of
+ * CPUs, e.g. "0-7,16-23". An empty (or NULL) list leaves the threads unpinned */
+
+// Whether the CPU list is well formed
+bool CPUList_IsValid(const char *list);
+
+/* Pin the calling thread to the CPUs of the list. The memory it then allocates is placed on the
+ * NUMA node of these CPUs by the kernel's first-touch policy. Returns false if the list is not
+ * empty and the thread could not be pinned (or pinning is not supported on this system) */
+bool CPUList_PinCurrentThread(const char *list);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "cpu_dispatch.h"
+#include "numeric_kernels.h"
+#include "sorted_ids.h"
+#include "hll/hll.h"
+
+typedef struct {
+  CpuDispatch_Kernel kernel;
+  // Point the kernel at the best implementation `features` allow, and return its name
+  const char *(*select)(uint32_t features);
+} dispatchedKernel;
+
+static dispatchedKernel kernels[] = {
+  {{"numeric_reducers", "scalar"}, NumericKernels_Select},
+  {{"docid_intersect", "scalar"}, SortedIds_Select},
+  {{"hll", "scalar"}, hll_select_kernels},
+};
+
+static uint32_t selectedFeatures = 0;
+
+uint32_t CpuDispatch_DetectFeatures(void) {
+  uint32_t features = 0;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  // The features whose registers the OS does not save are not reported as supported
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2")) features |= CPU_FEATURE_SSE4_2;
+  if (__builtin_cpu_supports("avx2")) features |= CPU_FEATURE_AVX2;
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")) {
+    features |= CPU_FEATURE_AVX512;
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  // NEON is part of the AArch64 baseline
+  features |= CPU_FEATURE_NEON;
+#endif
+  return features;
+}
+
+void CpuDispatch_Init(uint32_t features) {
+  selectedFeatures = features;
+  for (size_t i = 0; i < sizeof(kernels) / sizeof(*kernels); i++) {
+    kernels[i].kernel.impl = kernels[i].select(features);
+  }
+}
+
+uint32_t CpuDispatch_Features(void) {
+  return selectedFeatures;
+}
+
+const char *CpuFeature_Name(CpuFeature feature) {
+  switch (feature) {
+    case CPU_FEATURE_SSE4_2:
+      return "sse4.2";
+    case CPU_FEATURE_AVX2:
+      return "avx2";
+    case CPU_FEATURE_AVX512:
+      return "avx512";
+    case CPU_FEATURE_NEON:
+      return "neon";
+  }
+  return "unknown";
+}
+
+size_t CpuDispatch_NumKernels(void) {
+  return sizeof(kernels) / sizeof(*kernels);
+}
+
+const CpuDispatch_Kernel *CpuDispatch_GetKernel(size_t i) {
+  return i < CpuDispatch_NumKernels() ? &kernels[i].kernel : NULL;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Runtime selection of the SIMD kernels. The module is built for the baseline of its architecture,
+ * and the kernels which have faster implementations for newer instruction sets pick one of them
+ * through a function pointer once, when the module is loaded, rather than on every call. Before
+ * that (e.g. in unit tests which do not load the module), every kernel runs its scalar version.
+ */
+typedef enum {
+  CPU_FEATURE_SSE4_2 = 1 << 0,
+  CPU_FEATURE_AVX2 = 1 << 1,
+  CPU_FEATURE_AVX512 = 1 << 2,  // AVX-512 F, BW, DQ and VL
+  CPU_FEATURE_NEON = 1 << 3,
+} CpuFeature;
+
+#define CPU_FEATURES_ALL (CPU_FEATURE_SSE4_2 | CPU_FEATURE_AVX2 | CPU_FEATURE_AVX512 | CPU_FEATURE_NEON)
+
+/* The features of the CPU the module runs on, with the support of the OS */
+uint32_t CpuDispatch_DetectFeatures(void);
+
+/* Select the implementation of every kernel among those `features` allow. Called when the module is
+ * loaded with the detected features, and by tests with fewer of them, but never while the kernels
+ * may run */
+void CpuDispatch_Init(uint32_t features);
+
+/* The features the kernels were selected with */
+uint32_t CpuDispatch_Features(void);
+
+const char *CpuFeature_Name(CpuFeature feature);
+
+typedef struct {
+  const char *name;
+  const char *impl;  // The name of the selected implementation
+} CpuDispatch_Kernel;
+
+size_t CpuDispatch_NumKernels(void);
+const CpuDispatch_Kernel *CpuDispatch_GetKernel(size_t i);
+
+#ifdef __cplusplus
+}
+#endif
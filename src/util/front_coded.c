@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "front_coded.h"
+#include "rmalloc.h"
+#include "rmutil/rm_assert.h"
+
+#include <string.h>
+
+/*
+ * Each key is encoded as <varint shared><varint suffix length><suffix>, where `shared` is the length
+ * of the prefix it shares with the previous key, and is always 0 for the first key of a block.
+ */
+struct FrontCodedDict {
+  char *data;
+  size_t dataLen;
+  size_t dataCap;
+  size_t *blocks;  // Offset of the first key of each block
+  void **values;   // The values, in key order
+  size_t numKeys;
+  size_t keysCap;
+  size_t maxKeyLen;
+  char *lastKey;   // The last appended key, until the dictionary is finished
+  size_t lastLen;
+};
+
+static void writeVarint(FrontCodedDict *d, size_t n) {
+  do {
+    unsigned char c = n & 0x7f;
+    n >>= 7;
+    d->data[d->dataLen++] = (char)(c | (n ? 0x80 : 0));
+  } while (n);
+}
+
+static size_t readVarint(const char *data, size_t *offset) {
+  size_t n = 0;
+  unsigned shift = 0;
+  unsigned char c;
+  do {
+    c = (unsigned char)data[(*offset)++];
+    n |= (size_t)(c & 0x7f) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  return n;
+}
+
+static int compareKeys(const char *a, size_t alen, const char *b, size_t blen) {
+  size_t n = alen < blen ? alen : blen;
+  int rc = n ? memcmp(a, b, n) : 0;
+  if (rc) {
+    return rc;
+  }
+  return alen < blen ? -1 : alen > blen;
+}
+
+FrontCodedDict *NewFrontCodedDict(void) {
+  return rm_calloc(1, sizeof(FrontCodedDict));
+}
+
+void FrontCodedDict_Free(FrontCodedDict *d) {
+  rm_free(d->data);
+  rm_free(d->blocks);
+  rm_free(d->values);
+  rm_free(d->lastKey);
+  rm_free(d);
+}
+
+void FrontCodedDict_Append(FrontCodedDict *d, const char *key, size_t len, void *value) {
+  RS_ASSERT(!d->numKeys || compareKeys(d->lastKey, d->lastLen, key, len) < 0);
+
+  if (d->numKeys == d->keysCap) {
+    d->keysCap = d->keysCap ? d->keysCap * 2 : FRONT_CODED_BLOCK_SIZE;
+    d->values = rm_realloc(d->values, d->keysCap * sizeof(*d->values));
+    d->blocks = rm_realloc(d->blocks, (d->keysCap / FRONT_CODED_BLOCK_SIZE) * sizeof(*d->blocks));
+  }
+
+  size_t shared = 0;
+  if (d->numKeys % FRONT_CODED_BLOCK_SIZE == 0) {
+    d->blocks[d->numKeys / FRONT_CODED_BLOCK_SIZE] = d->dataLen;
+  } else {
+    size_t maxShared = d->lastLen < len ? d->lastLen : len;
+    while (shared < maxShared && d->lastKey[shared] == key[shared]) {
+      shared++;
+    }
+  }
+
+  // Two varints take at most 20 bytes
+  size_t needed = d->dataLen + 20 + len - shared;
+  if (needed > d->dataCap) {
+    d->dataCap = d->dataCap * 2 > needed ? d->dataCap * 2 : needed;
+    d->data = rm_realloc(d->data, d->dataCap);
+  }
+  writeVarint(d, shared);
+  writeVarint(d, len - shared);
+  if (len > d->maxKeyLen) {
+    d->maxKeyLen = len;
+    d->lastKey = rm_realloc(d->lastKey, len);
+  }
+  if (len > shared) {
+    memcpy(d->data + d->dataLen, key + shared, len - shared);
+    memcpy(d->lastKey + shared, key + shared, len - shared);
+    d->dataLen += len - shared;
+  }
+  d->lastLen = len;
+  d->values[d->numKeys++] = value;
+}
+
+void FrontCodedDict_Finish(FrontCodedDict *d) {
+  rm_free(d->lastKey);
+  d->lastKey = NULL;
+  if (!d->numKeys) {
+    return;
+  }
+  size_t numBlocks = (d->numKeys + FRONT_CODED_BLOCK_SIZE - 1) / FRONT_CODED_BLOCK_SIZE;
+  d->data = rm_realloc(d->data, d->dataLen);
+  d->dataCap = d->dataLen;
+  d->values = rm_realloc(d->values, d->numKeys * sizeof(*d->values));
+  d->blocks = rm_realloc(d->blocks, numBlocks * sizeof(*d->blocks));
+  d->keysCap = d->numKeys;
+}
+
+size_t FrontCodedDict_NumKeys(const FrontCodedDict *d) {
+  return d->numKeys;
+}
+
+size_t FrontCodedDict_MemUsage(const FrontCodedDict *d) {
+  size_t numBlocks = (d->keysCap + FRONT_CODED_BLOCK_SIZE - 1) / FRONT_CODED_BLOCK_SIZE;
+  return sizeof(*d) + d->dataCap + d->keysCap * sizeof(*d->values) +
+         numBlocks * sizeof(*d->blocks);
+}
+
+void FrontCodedDictIterator_Init(FrontCodedDictIterator *it, const FrontCodedDict *d) {
+  it->dict = d;
+  it->pos = 0;
+  it->offset = 0;
+  it->keyLen = 0;
+  it->pending = false;
+  it->key = d->maxKeyLen <= FRONT_CODED_INLINE_KEY_LEN ? it->inlineKey : rm_malloc(d->maxKeyLen);
+}
+
+void FrontCodedDictIterator_Free(FrontCodedDictIterator *it) {
+  if (it->key != it->inlineKey) {
+    rm_free(it->key);
+  }
+}
+
+// Decodes the key at the position of the iterator, on top of the previous key
+static void decodeNext(FrontCodedDictIterator *it) {
+  const char *data = it->dict->data;
+  size_t shared = readVarint(data, &it->offset);
+  size_t suffixLen = readVarint(data, &it->offset);
+  if (suffixLen) {
+    memcpy(it->key + shared, data + it->offset, suffixLen);
+  }
+  it->offset += suffixLen;
+  it->keyLen = shared + suffixLen;
+  it->pos++;
+}
+
+void FrontCodedDictIterator_Seek(FrontCodedDictIterator *it, const char *key, size_t len) {
+  const FrontCodedDict *d = it->dict;
+  it->pending = false;
+  if (!d->numKeys) {
+    return;
+  }
+
+  // Find the last block whose first key is less than or equal to the key
+  size_t lo = 0, hi = (d->numKeys + FRONT_CODED_BLOCK_SIZE - 1) / FRONT_CODED_BLOCK_SIZE;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    size_t offset = d->blocks[mid];
+    readVarint(d->data, &offset);  // Always 0
+    size_t headLen = readVarint(d->data, &offset);
+    if (compareKeys(d->data + offset, headLen, key, len) <= 0) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+
+  it->pos = lo * FRONT_CODED_BLOCK_SIZE;
+  it->offset = d->blocks[lo];
+  while (it->pos < d->numKeys) {
+    decodeNext(it);
+    if (compareKeys(it->key, it->keyLen, key, len) >= 0) {
+      it->pending = true;
+      return;
+    }
+  }
+}
+
+bool FrontCodedDictIterator_Next(FrontCodedDictIterator *it, char **key, size_t *len, void **value) {
+  if (it->pending) {
+    it->pending = false;
+  } else if (it->pos < it->dict->numKeys) {
+    decodeNext(it);
+  } else {
+    return false;
+  }
+  *key = it->key;
+  *len = it->keyLen;
+  *value = it->dict->values[it->pos - 1];
+  return true;
+}
+
+void **FrontCodedDict_Find(const FrontCodedDict *d, const char *key, size_t len) {
+  FrontCodedDictIterator it;
+  FrontCodedDictIterator_Init(&it, d);
+  FrontCodedDictIterator_Seek(&it, key, len);
+  void **slot = NULL;
+  if (it.pending && !compareKeys(it.key, it.keyLen, key, len)) {
+    slot = &d->values[it.pos - 1];
+  }
+  FrontCodedDictIterator_Free(&it);
+  return slot;
+}
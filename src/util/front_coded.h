@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of keys in a block. The first key of a block is stored whole, so that the blocks can be
+// binary-searched, and every other key only stores its suffix after the prefix it shares with the
+// previous key.
+#define FRONT_CODED_BLOCK_SIZE 16
+
+// Keys up to this length are decoded in the iterator itself rather than in an allocated buffer
+#define FRONT_CODED_INLINE_KEY_LEN 128
+
+/**
+ * An immutable sorted dictionary of binary keys, each mapped to a pointer. The keys are
+ * front-coded in blocks, which takes a fraction of the memory of a trie for large sets of keys
+ * sharing their prefixes (ids, SKUs...).
+ *
+ * The dictionary is built by appending the keys in strictly increasing (memcmp) order, and is
+ * searched once FrontCodedDict_Finish() is called. The values can be replaced in place through the
+ * slot returned by FrontCodedDict_Find().
+ */
+typedef struct FrontCodedDict FrontCodedDict;
+
+FrontCodedDict *NewFrontCodedDict(void);
+
+/* Frees the dictionary. The values are not freed */
+void FrontCodedDict_Free(FrontCodedDict *d);
+
+/* Appends a key, which must be greater than the previously appended key */
+void FrontCodedDict_Append(FrontCodedDict *d, const char *key, size_t len, void *value);
+
+/* Ends the building of the dictionary, and releases the spare capacity of its buffers */
+void FrontCodedDict_Finish(FrontCodedDict *d);
+
+/* Returns the slot of the value of `key`, or NULL if the key is not in the dictionary */
+void **FrontCodedDict_Find(const FrontCodedDict *d, const char *key, size_t len);
+
+size_t FrontCodedDict_NumKeys(const FrontCodedDict *d);
+
+size_t FrontCodedDict_MemUsage(const FrontCodedDict *d);
+
+/* Iterates the keys of a dictionary in increasing order. The iterator lives on the stack, and
+ * must not be copied once initialized */
+typedef struct {
+  const FrontCodedDict *dict;
+  size_t pos;     // Ordinal of the next key to decode
+  size_t offset;  // Offset of the next key to decode
+  char *key;      // The last decoded key
+  size_t keyLen;
+  bool pending;   // Whether the last decoded key was not returned yet, after a seek
+  char inlineKey[FRONT_CODED_INLINE_KEY_LEN];
+} FrontCodedDictIterator;
+
+/* Positions the iterator on the first key of the dictionary */
+void FrontCodedDictIterator_Init(FrontCodedDictIterator *it, const FrontCodedDict *d);
+
+/* Positions the iterator on the first key greater than or equal to `key`, using a binary search
+ * over the first keys of the blocks */
+void FrontCodedDictIterator_Seek(FrontCodedDictIterator *it, const char *key, size_t len);
+
+/* Returns the next key and its value, or false at the end of the dictionary. The key is valid
+ * until the next call */
+bool FrontCodedDictIterator_Next(FrontCodedDictIterator *it, char **key, size_t *len, void **value);
+
+void FrontCodedDictIterator_Free(FrontCodedDictIterator *it);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "key_id_map.h"
+#include "dict.h"
+#include "rmalloc.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#define KEY_ID_MAP_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define KEY_ID_MAP_NEON
+#include <arm_neon.h>
+#endif
+
+// A control byte is either one of these, or the low 7 bits of the hash of the key of a full slot
+#define CTRL_EMPTY ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+
+struct KeyIdMapEntry {
+  sds key;
+  uint64_t id;
+};
+typedef struct KeyIdMapEntry KeyIdMapEntry;
+
+// A mask of the slots of a group, with one bit set per matching slot. With NEON, each slot has
+// 4 bits of the mask, of which only the highest one is kept.
+typedef uint64_t GroupMask;
+
+#ifdef KEY_ID_MAP_NEON
+#define GROUP_MASK_SHIFT 2
+#else
+#define GROUP_MASK_SHIFT 0
+#endif
+
+static inline GroupMask groupMatch(const uint8_t *ctrl, uint8_t c) {
+#if defined(KEY_ID_MAP_SSE2)
+  __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#elif defined(KEY_ID_MAP_NEON)
+  uint8x16_t eq = vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(c));
+  uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+  return nibbles & 0x8888888888888888ULL;
+#else
+  GroupMask mask = 0;
+  for (int i = 0; i < KEY_ID_MAP_GROUP_WIDTH; i++) {
+    mask |= (GroupMask)(ctrl[i] == c) << i;
+  }
+  return mask;
+#endif
+}
+
+// Matches the empty and the deleted slots, which are the only ones with their high bit set
+static inline GroupMask groupMatchFree(const uint8_t *ctrl) {
+#if defined(KEY_ID_MAP_SSE2)
+  return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#elif defined(KEY_ID_MAP_NEON)
+  uint8x16_t high = vcltzq_s8(vreinterpretq_s8_u8(vld1q_u8(ctrl)));
+  uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(high), 4)), 0);
+  return nibbles & 0x8888888888888888ULL;
+#else
+  GroupMask mask = 0;
+  for (int i = 0; i < KEY_ID_MAP_GROUP_WIDTH; i++) {
+    mask |= (GroupMask)(ctrl[i] >> 7) << i;
+  }
+  return mask;
+#endif
+}
+
+static inline size_t groupMaskFirst(GroupMask mask) {
+  return __builtin_ctzll(mask) >> GROUP_MASK_SHIFT;
+}
+
+static inline uint64_t hashKey(const char *key, size_t len) {
+  return RS_dictGenHashFunction(key, (int)len);
+}
+
+// The maximal number of full and deleted slots, for a load factor of 7/8
+static inline size_t maxLoad(size_t capacity) {
+  return capacity - capacity / 8;
+}
+
+static size_t capacityFor(size_t size) {
+  if (size <= 1) {
+    return 1;
+  } else if (size <= KEY_ID_MAP_SMALL_CAPACITY) {
+    return KEY_ID_MAP_SMALL_CAPACITY;
+  }
+  size_t capacity = KEY_ID_MAP_GROUP_WIDTH;
+  while (maxLoad(capacity) < size) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+/* A swiss table is made of its control bytes followed by its entries. A small map is made of its
+ * entries followed by the hashes of their keys, of which the first `size` ones are full */
+static inline bool isSmall(size_t capacity) {
+  return capacity < KEY_ID_MAP_GROUP_WIDTH;
+}
+
+static size_t tableSize(size_t capacity) {
+  if (!capacity) {
+    return 0;
+  } else if (isSmall(capacity)) {
+    return capacity * (sizeof(KeyIdMapEntry) + sizeof(uint64_t));
+  }
+  return capacity + KEY_ID_MAP_GROUP_WIDTH + capacity * sizeof(KeyIdMapEntry);
+}
+
+static inline uint8_t *ctrlOf(const KeyIdMap *m) {
+  return m->table;
+}
+
+static inline KeyIdMapEntry *entriesOf(const KeyIdMap *m) {
+  if (isSmall(m->capacity)) {
+    return m->table;
+  }
+  return (KeyIdMapEntry *)(ctrlOf(m) + m->capacity + KEY_ID_MAP_GROUP_WIDTH);
+}
+
+static inline uint64_t *smallHashesOf(const KeyIdMap *m) {
+  return (uint64_t *)((KeyIdMapEntry *)m->table + m->capacity);
+}
+
+// Sets the control byte of a slot, and its mirror after the end of the slots if it is one of the
+// first ones, so that a whole group can be read from any slot without wrapping around
+static inline void setCtrl(KeyIdMap *m, size_t i, uint8_t c) {
+  uint8_t *ctrl = ctrlOf(m);
+  ctrl[i] = c;
+  ctrl[((i - KEY_ID_MAP_GROUP_WIDTH) & (m->capacity - 1)) + KEY_ID_MAP_GROUP_WIDTH] = c;
+}
+
+/* The groups of a key are probed one after the other from the slot of its hash. A key is always
+ * stored in the first group with a free slot at the time it was added, and the slots of the
+ * deleted keys are not emptied, so a lookup stops at the first group with an empty slot */
+static KeyIdMapEntry *findEntry(const KeyIdMap *m, const char *key, size_t len, uint64_t hash) {
+  KeyIdMapEntry *entries = entriesOf(m);
+  if (isSmall(m->capacity)) {
+    const uint64_t *hashes = smallHashesOf(m);
+    for (size_t i = 0; i < m->size; i++) {
+      if (hashes[i] == hash && sdslen(entries[i].key) == len && !memcmp(entries[i].key, key, len)) {
+        return &entries[i];
+      }
+    }
+    return NULL;
+  }
+
+  size_t mask = m->capacity - 1;
+  size_t pos = (hash >> 7) & mask;
+  uint8_t tag = hash & 0x7f;
+  for (size_t probed = 0; probed < m->capacity; probed += KEY_ID_MAP_GROUP_WIDTH) {
+    const uint8_t *group = ctrlOf(m) + pos;
+    for (GroupMask match = groupMatch(group, tag); match; match &= match - 1) {
+      KeyIdMapEntry *e = &entries[(pos + groupMaskFirst(match)) & mask];
+      if (sdslen(e->key) == len && !memcmp(e->key, key, len)) {
+        return e;
+      }
+    }
+    if (groupMatch(group, CTRL_EMPTY)) {
+      return NULL;
+    }
+    pos = (pos + KEY_ID_MAP_GROUP_WIDTH) & mask;
+  }
+  return NULL;
+}
+
+static size_t findFreeSlot(const KeyIdMap *m, uint64_t hash) {
+  size_t mask = m->capacity - 1;
+  size_t pos = (hash >> 7) & mask;
+  GroupMask free;
+  while (!(free = groupMatchFree(ctrlOf(m) + pos))) {
+    pos = (pos + KEY_ID_MAP_GROUP_WIDTH) & mask;
+  }
+  return (pos + groupMaskFirst(free)) & mask;
+}
+
+// Adds an entry which is not in the map to a slot which is known to be free
+static void insertNew(KeyIdMap *m, KeyIdMapEntry e, uint64_t hash) {
+  if (isSmall(m->capacity)) {
+    entriesOf(m)[m->size] = e;
+    smallHashesOf(m)[m->size] = hash;
+  } else {
+    size_t slot = findFreeSlot(m, hash);
+    if (ctrlOf(m)[slot] == CTRL_EMPTY) {
+      m->growthLeft--;
+    }
+    setCtrl(m, slot, hash & 0x7f);
+    entriesOf(m)[slot] = e;
+  }
+  m->size++;
+}
+
+static void rehash(KeyIdMap *m, size_t capacity) {
+  KeyIdMap old = *m;
+  m->capacity = capacity;
+  m->table = rm_malloc(tableSize(capacity));
+  m->size = 0;
+  m->growthLeft = 0;
+  if (!isSmall(capacity)) {
+    memset(ctrlOf(m), CTRL_EMPTY, capacity + KEY_ID_MAP_GROUP_WIDTH);
+    m->growthLeft = maxLoad(capacity);
+  }
+
+  const KeyIdMapEntry *entries = entriesOf(&old);
+  if (isSmall(old.capacity)) {
+    for (size_t i = 0; i < old.size; i++) {
+      insertNew(m, entries[i], smallHashesOf(&old)[i]);
+    }
+  } else {
+    for (size_t i = 0; i < old.capacity; i++) {
+      if (!(ctrlOf(&old)[i] & 0x80)) {
+        insertNew(m, entries[i], hashKey(entries[i].key, sdslen(entries[i].key)));
+      }
+    }
+  }
+  rm_free(old.table);
+}
+
+void KeyIdMap_Init(KeyIdMap *m) {
+  *m = (KeyIdMap){0};
+}
+
+void KeyIdMap_Destroy(KeyIdMap *m) {
+  rm_free(m->table);
+  KeyIdMap_Init(m);
+}
+
+uint64_t KeyIdMap_Get(const KeyIdMap *m, const char *key, size_t len) {
+  if (!m->size) {
+    return 0;
+  }
+  const KeyIdMapEntry *e = findEntry(m, key, len, hashKey(key, len));
+  return e ? e->id : 0;
+}
+
+void KeyIdMap_Put(KeyIdMap *m, sds key, uint64_t id) {
+  size_t len = sdslen(key);
+  uint64_t hash = hashKey(key, len);
+  KeyIdMapEntry *e = m->size ? findEntry(m, key, len, hash) : NULL;
+  if (e) {
+    e->key = key;
+    e->id = id;
+    return;
+  }
+
+  if (isSmall(m->capacity)) {
+    if (m->size == m->capacity) {
+      rehash(m, capacityFor(m->size + 1));
+    }
+  } else if (!m->growthLeft && ctrlOf(m)[findFreeSlot(m, hash)] == CTRL_EMPTY) {
+    // Only the deleted slots are reclaimed if enough of them would be emptied
+    rehash(m, m->size * 32 <= (size_t)m->capacity * 25 ? m->capacity : (size_t)m->capacity * 2);
+  }
+  insertNew(m, (KeyIdMapEntry){.key = key, .id = id}, hash);
+}
+
+bool KeyIdMap_Delete(KeyIdMap *m, const char *key, size_t len) {
+  KeyIdMapEntry *e = m->size ? findEntry(m, key, len, hashKey(key, len)) : NULL;
+  if (!e) {
+    return false;
+  }
+  KeyIdMapEntry *entries = entriesOf(m);
+  size_t i = e - entries;
+  if (isSmall(m->capacity)) {
+    // The full slots of a small map are kept first
+    entries[i] = entries[m->size - 1];
+    smallHashesOf(m)[i] = smallHashesOf(m)[m->size - 1];
+  } else {
+    setCtrl(m, i, CTRL_DELETED);
+  }
+  if (!--m->size) {
+    KeyIdMap_Destroy(m);
+  } else if (isSmall(m->capacity) ? capacityFor(m->size) < m->capacity
+                                    : m->size < m->capacity / 8) {
+    rehash(m, capacityFor(isSmall(m->capacity) ? m->size : m->size * 2));
+  }
+  return true;
+}
+
+size_t KeyIdMap_MemUsage(const KeyIdMap *m) {
+  return sizeof(*m) + tableSize(m->capacity);
+}
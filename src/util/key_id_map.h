@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hiredis/sds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of slots whose control bytes are matched at once
+#define KEY_ID_MAP_GROUP_WIDTH 16
+// The most keys of a map which is not a swiss table
+#define KEY_ID_MAP_SMALL_CAPACITY 4
+
+struct KeyIdMapEntry;
+
+/**
+ * An open-addressing hash map from binary keys to non-zero 64-bit ids, laid out as a swiss table:
+ * each slot has a control byte holding 7 bits of the hash of its key, and a probe matches the
+ * control bytes of a group of slots at once (with SSE2 or NEON when available), so that keys are
+ * only compared when their tags match.
+ *
+ * A map of up to KEY_ID_MAP_SMALL_CAPACITY keys is a plain array of its entries and of the hashes
+ * of their keys instead, which is scanned, so that the map of a small index is not much larger
+ * than its keys. The slots are only allocated by the first key.
+ *
+ * The map does not copy its keys. It stores the sds strings it is given, which must stay valid
+ * until their entry is deleted or replaced, so that keys owned elsewhere are not stored twice.
+ */
+typedef struct {
+  void *table;          // The slots, or NULL if the map was never added to or was emptied
+  size_t size;
+  // 0, 1, KEY_ID_MAP_SMALL_CAPACITY or a power of 2 of at least KEY_ID_MAP_GROUP_WIDTH
+  uint32_t capacity;
+  uint32_t growthLeft;  // Number of empty slots which can still be filled before the map is rehashed
+} KeyIdMap;
+
+void KeyIdMap_Init(KeyIdMap *m);
+
+/* Frees the map. The keys are not freed */
+void KeyIdMap_Destroy(KeyIdMap *m);
+
+/* Returns the id of a key, or 0 if the key is not in the map */
+uint64_t KeyIdMap_Get(const KeyIdMap *m, const char *key, size_t len);
+
+/* Maps `key` to `id`. If the key is already in the map, both its id and its stored key are
+ * replaced */
+void KeyIdMap_Put(KeyIdMap *m, sds key, uint64_t id);
+
+/* Removes a key from the map. Returns whether the key was in the map */
+bool KeyIdMap_Delete(KeyIdMap *m, const char *key, size_t len);
+
+static inline size_t KeyIdMap_Size(const KeyIdMap *m) {
+  return m->size;
+}
+
+/* The memory used by the map, excluding the keys */
+size_t KeyIdMap_MemUsage(const KeyIdMap *m);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "numeric_kernels.h"
+#include "cpu_dispatch.h"
+#include <math.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NUMERIC_KERNELS_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define NUMERIC_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+// The scalar kernels keep 4 independent accumulators, so that the additions are not serialized
+static double sumScalar(const double *vals, size_t n) {
+  double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    s0 += vals[i];
+    s1 += vals[i + 1];
+    s2 += vals[i + 2];
+    s3 += vals[i + 3];
+  }
+  for (; i < n; i++) {
+    s0 += vals[i];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+// A comparison with a NaN is false, so NaNs never replace the minimum or the maximum
+static double minScalar(const double *vals, size_t n, double m) {
+  for (size_t i = 0; i < n; i++) {
+    m = vals[i] < m ? vals[i] : m;
+  }
+  return m;
+}
+
+static double maxScalar(const double *vals, size_t n, double m) {
+  for (size_t i = 0; i < n; i++) {
+    m = vals[i] > m ? vals[i] : m;
+  }
+  return m;
+}
+
+static double minScalarAll(const double *vals, size_t n) {
+  return minScalar(vals, n, INFINITY);
+}
+
+static double maxScalarAll(const double *vals, size_t n) {
+  return maxScalar(vals, n, -INFINITY);
+}
+
+static double sumSquaredDeviationsScalar(const double *vals, size_t n, double mean) {
+  double s0 = 0, s1 = 0;
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    double d0 = vals[i] - mean, d1 = vals[i + 1] - mean;
+    s0 += d0 * d0;
+    s1 += d1 * d1;
+  }
+  for (; i < n; i++) {
+    double d = vals[i] - mean;
+    s0 += d * d;
+  }
+  return s0 + s1;
+}
+
+#ifdef NUMERIC_KERNELS_AVX2
+__attribute__((target("avx2")))
+static double hsumAVX2(__m256d v) {
+  __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+__attribute__((target("avx2")))
+static double sumAVX2(const double *vals, size_t n) {
+  __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    s0 = _mm256_add_pd(s0, _mm256_loadu_pd(vals + i));
+    s1 = _mm256_add_pd(s1, _mm256_loadu_pd(vals + i + 4));
+  }
+  return hsumAVX2(_mm256_add_pd(s0, s1)) + sumScalar(vals + i, n - i);
+}
+
+// MINPD and MAXPD return their second operand when either is a NaN, which the accumulator never is
+__attribute__((target("avx2")))
+static double minAVX2(const double *vals, size_t n) {
+  __m256d m = _mm256_set1_pd(INFINITY);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    m = _mm256_min_pd(_mm256_loadu_pd(vals + i), m);
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, m);
+  return minScalar(vals + i, n - i, minScalar(lanes, 4, INFINITY));
+}
+
+__attribute__((target("avx2")))
+static double maxAVX2(const double *vals, size_t n) {
+  __m256d m = _mm256_set1_pd(-INFINITY);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    m = _mm256_max_pd(_mm256_loadu_pd(vals + i), m);
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, m);
+  return maxScalar(vals + i, n - i, maxScalar(lanes, 4, -INFINITY));
+}
+
+__attribute__((target("avx2")))
+static double sumSquaredDeviationsAVX2(const double *vals, size_t n, double mean) {
+  const __m256d vmean = _mm256_set1_pd(mean);
+  __m256d s = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d d = _mm256_sub_pd(_mm256_loadu_pd(vals + i), vmean);
+    s = _mm256_add_pd(s, _mm256_mul_pd(d, d));
+  }
+  return hsumAVX2(s) + sumSquaredDeviationsScalar(vals + i, n - i, mean);
+}
+#endif
+
+#ifdef NUMERIC_KERNELS_NEON
+static double sumNEON(const double *vals, size_t n) {
+  float64x2_t s0 = vdupq_n_f64(0), s1 = vdupq_n_f64(0);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    s0 = vaddq_f64(s0, vld1q_f64(vals + i));
+    s1 = vaddq_f64(s1, vld1q_f64(vals + i + 2));
+  }
+  return vaddvq_f64(vaddq_f64(s0, s1)) + sumScalar(vals + i, n - i);
+}
+
+// FMINNM and FMAXNM return the number when one of their operands is a NaN
+static double minNEON(const double *vals, size_t n) {
+  float64x2_t m = vdupq_n_f64(INFINITY);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    m = vminnmq_f64(vld1q_f64(vals + i), m);
+  }
+  return minScalar(vals + i, n - i, vminnmvq_f64(m));
+}
+
+static double maxNEON(const double *vals, size_t n) {
+  float64x2_t m = vdupq_n_f64(-INFINITY);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    m = vmaxnmq_f64(vld1q_f64(vals + i), m);
+  }
+  return maxScalar(vals + i, n - i, vmaxnmvq_f64(m));
+}
+
+static double sumSquaredDeviationsNEON(const double *vals, size_t n, double mean) {
+  const float64x2_t vmean = vdupq_n_f64(mean);
+  float64x2_t s = vdupq_n_f64(0);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    float64x2_t d = vsubq_f64(vld1q_f64(vals + i), vmean);
+    s = vaddq_f64(s, vmulq_f64(d, d));
+  }
+  return vaddvq_f64(s) + sumSquaredDeviationsScalar(vals + i, n - i, mean);
+}
+#endif
+
+#ifdef NUMERIC_KERNELS_AVX2
+__attribute__((target("avx512f")))
+static double sumAVX512(const double *vals, size_t n) {
+  __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    s0 = _mm512_add_pd(s0, _mm512_loadu_pd(vals + i));
+    s1 = _mm512_add_pd(s1, _mm512_loadu_pd(vals + i + 8));
+  }
+  return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1)) + sumScalar(vals + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static double minAVX512(const double *vals, size_t n) {
+  __m512d m = _mm512_set1_pd(INFINITY);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    m = _mm512_min_pd(_mm512_loadu_pd(vals + i), m);
+  }
+  return minScalar(vals + i, n - i, _mm512_reduce_min_pd(m));
+}
+
+__attribute__((target("avx512f")))
+static double maxAVX512(const double *vals, size_t n) {
+  __m512d m = _mm512_set1_pd(-INFINITY);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    m = _mm512_max_pd(_mm512_loadu_pd(vals + i), m);
+  }
+  return maxScalar(vals + i, n - i, _mm512_reduce_max_pd(m));
+}
+
+__attribute__((target("avx512f")))
+static double sumSquaredDeviationsAVX512(const double *vals, size_t n, double mean) {
+  const __m512d vmean = _mm512_set1_pd(mean);
+  __m512d s = _mm512_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512d d = _mm512_sub_pd(_mm512_loadu_pd(vals + i), vmean);
+    s = _mm512_fmadd_pd(d, d, s);
+  }
+  return _mm512_reduce_add_pd(s) + sumSquaredDeviationsScalar(vals + i, n - i, mean);
+}
+#endif
+
+// Selected by `NumericKernels_Select`
+static double (*sumImpl)(const double *, size_t) = sumScalar;
+static double (*minImpl)(const double *, size_t) = minScalarAll;
+static double (*maxImpl)(const double *, size_t) = maxScalarAll;
+static double (*sumSquaredDeviationsImpl)(const double *, size_t, double) = sumSquaredDeviationsScalar;
+
+const char *NumericKernels_Select(uint32_t features) {
+#if defined(NUMERIC_KERNELS_AVX2)
+  if (features & CPU_FEATURE_AVX512) {
+    sumImpl = sumAVX512;
+    minImpl = minAVX512;
+    maxImpl = maxAVX512;
+    sumSquaredDeviationsImpl = sumSquaredDeviationsAVX512;
+    return "avx512";
+  }
+  if (features & CPU_FEATURE_AVX2) {
+    sumImpl = sumAVX2;
+    minImpl = minAVX2;
+    maxImpl = maxAVX2;
+    sumSquaredDeviationsImpl = sumSquaredDeviationsAVX2;
+    return "avx2";
+  }
+#elif defined(NUMERIC_KERNELS_NEON)
+  if (features & CPU_FEATURE_NEON) {
+    sumImpl = sumNEON;
+    minImpl = minNEON;
+    maxImpl = maxNEON;
+    sumSquaredDeviationsImpl = sumSquaredDeviationsNEON;
+    return "neon";
+  }
+#endif
+  sumImpl = sumScalar;
+  minImpl = minScalarAll;
+  maxImpl = maxScalarAll;
+  sumSquaredDeviationsImpl = sumSquaredDeviationsScalar;
+  return "scalar";
+}
+
+double NumericKernel_Sum(const double *vals, size_t n) {
+  return sumImpl(vals, n);
+}
+
+double NumericKernel_Min(const double *vals, size_t n) {
+  return minImpl(vals, n);
+}
+
+double NumericKernel_Max(const double *vals, size_t n) {
+  return maxImpl(vals, n);
+}
+
+double NumericKernel_SumSquaredDeviations(const double *vals, size_t n, double mean) {
+  return sumSquaredDeviationsImpl(vals, n, mean);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Kernels over contiguous arrays of numbers, for the reducers which receive the numbers of many
+ * results at once. Use AVX-512 or AVX2 (when the CPU supports them) or NEON to process several
+ * numbers at a time. The sums are accumulated in several lanes, so they may differ from a sequential sum in
+ * the last bits.
+ */
+
+// The sum of the numbers. NaNs propagate to the sum
+double NumericKernel_Sum(const double *vals, size_t n);
+
+// The smallest of the numbers, ignoring NaNs, or +INFINITY if there is none
+double NumericKernel_Min(const double *vals, size_t n);
+
+// The largest of the numbers, ignoring NaNs, or -INFINITY if there is none
+double NumericKernel_Max(const double *vals, size_t n);
+
+// The sum of the squared differences between the numbers and `mean`
+double NumericKernel_SumSquaredDeviations(const double *vals, size_t n, double mean);
+
+/* Select the implementation of the kernels for the CPU features (see cpu_dispatch.h).
+ * @returns the name of the implementation */
+const char *NumericKernels_Select(uint32_t features);
+
+#ifdef __cplusplus
+}
+#endif
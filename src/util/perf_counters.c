@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "perf_counters.h"
+
+static const char *counterNames[PERF_COUNTER__NUM] = {
+  [PERF_COUNTER_CYCLES] = "Cycles",
+  [PERF_COUNTER_INSTRUCTIONS] = "Instructions",
+  [PERF_COUNTER_LLC_MISSES] = "LLC misses",
+  [PERF_COUNTER_BRANCH_MISSES] = "Branch misses",
+};
+
+const char *PerfCounter_Name(PerfCounter counter) {
+  return counterNames[counter];
+}
+
+#if defined(__linux__)
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const uint64_t counterConfigs[PERF_COUNTER__NUM] = {
+  [PERF_COUNTER_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+  [PERF_COUNTER_INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS,
+  [PERF_COUNTER_LLC_MISSES] = PERF_COUNT_HW_CACHE_MISSES,
+  [PERF_COUNTER_BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+typedef enum {
+  GROUP_UNOPENED = 0,
+  GROUP_OPEN,
+  GROUP_UNAVAILABLE,
+} GroupState;
+
+// The counters of a thread are opened as a group, so that they are read at once and scheduled
+// together. They are closed as the thread exits
+static __thread GroupState state;
+static __thread int fds[PERF_COUNTER__NUM];
+
+static pthread_key_t closeKey;
+static pthread_once_t closeKeyOnce = PTHREAD_ONCE_INIT;
+
+static void closeGroup(void *unused) {
+  (void)unused;
+  for (int i = 0; i < PERF_COUNTER__NUM; i++) {
+    close(fds[i]);
+  }
+  state = GROUP_UNAVAILABLE;
+}
+
+static void createCloseKey(void) {
+  pthread_key_create(&closeKey, closeGroup);
+}
+
+static bool openGroup(void) {
+  for (int i = 0; i < PERF_COUNTER__NUM; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = counterConfigs[i];
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    const int leader = i ? fds[0] : -1;
+    fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+    if (fds[i] < 0) {
+      while (i--) {
+        close(fds[i]);
+      }
+      return false;
+    }
+  }
+  pthread_once(&closeKeyOnce, createCloseKey);
+  // Any non NULL value, for the destructor to be called
+  pthread_setspecific(closeKey, fds);
+  return true;
+}
+
+bool PerfCounters_Read(PerfCounters *out) {
+  if (state == GROUP_UNOPENED) {
+    state = openGroup() ? GROUP_OPEN : GROUP_UNAVAILABLE;
+  }
+  if (state != GROUP_OPEN) {
+    return false;
+  }
+  // With PERF_FORMAT_GROUP, the number of counters followed by their values
+  uint64_t buf[1 + PERF_COUNTER__NUM];
+  if (read(fds[0], buf, sizeof(buf)) != sizeof(buf) || buf[0] != PERF_COUNTER__NUM) {
+    return false;
+  }
+  memcpy(out->values, buf + 1, sizeof(out->values));
+  out->valid = true;
+  return true;
+}
+
+#else
+
+bool PerfCounters_Read(PerfCounters *out) {
+  (void)out;
+  return false;
+}
+
+#endif
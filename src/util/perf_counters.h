@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hardware counters of the calling thread, read through perf_event_open(2) on Linux. They tell
+ * whether a piece of code is bound by its instructions (a high instructions per cycle ratio) or by
+ * its memory accesses (many cache misses for few instructions). Only the user space of the thread
+ * is counted */
+
+typedef enum {
+  PERF_COUNTER_CYCLES = 0,
+  PERF_COUNTER_INSTRUCTIONS,
+  PERF_COUNTER_LLC_MISSES,
+  PERF_COUNTER_BRANCH_MISSES,
+  PERF_COUNTER__NUM,
+} PerfCounter;
+
+typedef struct {
+  uint64_t values[PERF_COUNTER__NUM];
+  bool valid;  // Whether any values were added
+} PerfCounters;
+
+/* Read the counters of the calling thread, opened on its first call. Returns false if they can not
+ * be read, e.g. on another system, or when perf_event_paranoid does not allow it */
+bool PerfCounters_Read(PerfCounters *out);
+
+/* Add the counts between two reads to `acc` */
+static inline void PerfCounters_AddDiff(PerfCounters *acc, const PerfCounters *begin,
+                                        const PerfCounters *end) {
+  for (int i = 0; i < PERF_COUNTER__NUM; i++) {
+    acc->values[i] += end->values[i] - begin->values[i];
+  }
+  acc->valid = true;
+}
+
+/* The name of a counter, as reported by FT.PROFILE */
+const char *PerfCounter_Name(PerfCounter counter);
+
+#ifdef __cplusplus
+}
+#endif
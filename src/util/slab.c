@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "slab.h"
+#include "rmalloc.h"
+#include "rmutil/rm_assert.h"
+
+#include <string.h>
+
+typedef struct SlabChunk {
+  struct SlabChunk *prev, *next;  // Siblings in the list of partial chunks
+  void *freeList;                 // The freed objects, each one pointing to the next
+  uint32_t numUsed;
+  uint32_t numCarved;             // The objects after these were never allocated yet
+  uint32_t capacity;
+  char data[] __attribute__((aligned(8)));
+} SlabChunk;
+
+static inline void partialPush(Slab *s, SlabChunk *c) {
+  c->prev = NULL;
+  c->next = s->partial;
+  if (s->partial) {
+    s->partial->prev = c;
+  }
+  s->partial = c;
+}
+
+static inline void partialRemove(Slab *s, SlabChunk *c) {
+  if (c->prev) {
+    c->prev->next = c->next;
+  } else {
+    s->partial = c->next;
+  }
+  if (c->next) {
+    c->next->prev = c->prev;
+  }
+  c->prev = c->next = NULL;
+}
+
+// Returns the number of chunks starting at or before `ptr`
+static size_t chunksBefore(const Slab *s, const void *ptr) {
+  size_t lo = 0, hi = s->numChunks;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if ((const char *)s->chunks[mid] <= (const char *)ptr) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static SlabChunk *newChunk(Slab *s) {
+  SlabChunk *c = rm_malloc(SLAB_CHUNK_SIZE);
+  c->prev = c->next = NULL;
+  c->freeList = NULL;
+  c->numUsed = c->numCarved = 0;
+  c->capacity = (SLAB_CHUNK_SIZE - sizeof(SlabChunk)) / s->objSize;
+  RS_ASSERT(c->capacity > 0);
+
+  if (s->numChunks == s->chunksCap) {
+    s->chunksCap = s->chunksCap ? s->chunksCap * 2 : 8;
+    s->chunks = rm_realloc(s->chunks, s->chunksCap * sizeof(*s->chunks));
+  }
+  size_t pos = chunksBefore(s, c);
+  memmove(s->chunks + pos + 1, s->chunks + pos, (s->numChunks - pos) * sizeof(*s->chunks));
+  s->chunks[pos] = c;
+  s->numChunks++;
+  partialPush(s, c);
+  return c;
+}
+
+static void freeChunk(Slab *s, SlabChunk *c, size_t pos) {
+  partialRemove(s, c);
+  memmove(s->chunks + pos, s->chunks + pos + 1, (s->numChunks - pos - 1) * sizeof(*s->chunks));
+  s->numChunks--;
+  rm_free(c);
+  if (!s->numChunks) {
+    rm_free(s->chunks);
+    s->chunks = NULL;
+    s->chunksCap = 0;
+  }
+}
+
+void *Slab_Alloc(Slab *s) {
+  pthread_mutex_lock(&s->lock);
+  SlabChunk *c = s->partial ? s->partial : newChunk(s);
+  void *ptr;
+  if (c->freeList) {
+    ptr = c->freeList;
+    c->freeList = *(void **)ptr;
+  } else {
+    ptr = c->data + (size_t)c->numCarved++ * s->objSize;
+  }
+  if (++c->numUsed == c->capacity) {
+    partialRemove(s, c);
+  }
+  s->numObjects++;
+  pthread_mutex_unlock(&s->lock);
+
+  memset(ptr, 0, s->objSize);
+  return ptr;
+}
+
+void Slab_Free(Slab *s, void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  pthread_mutex_lock(&s->lock);
+  size_t pos = chunksBefore(s, ptr) - 1;
+  SlabChunk *c = s->chunks[pos];
+  RS_ASSERT((char *)ptr >= c->data && (char *)ptr < c->data + (size_t)c->capacity * s->objSize);
+
+  if (c->numUsed-- == c->capacity) {
+    partialPush(s, c);
+  }
+  s->numObjects--;
+  // An empty chunk is kept while it is the only one with free objects, so that a slab which is
+  // full does not allocate and release a chunk over and over
+  if (!c->numUsed && (!s->numObjects || s->partial != c || c->next)) {
+    freeChunk(s, c, pos);
+  } else {
+    *(void **)ptr = c->freeList;
+    c->freeList = ptr;
+  }
+  pthread_mutex_unlock(&s->lock);
+}
+
+size_t Slab_MemUsage(Slab *s) {
+  pthread_mutex_lock(&s->lock);
+  size_t mem = s->numChunks * SLAB_CHUNK_SIZE + s->chunksCap * sizeof(*s->chunks);
+  pthread_mutex_unlock(&s->lock);
+  return mem;
+}
+
+size_t Slab_NumObjects(Slab *s) {
+  pthread_mutex_lock(&s->lock);
+  size_t n = s->numObjects;
+  pthread_mutex_unlock(&s->lock);
+  return n;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the chunks from which the objects of a slab are allocated
+#define SLAB_CHUNK_SIZE (64 * 1024)
+
+struct SlabChunk;
+
+/**
+ * A slab allocator of objects of a single size. The objects are carved out of chunks of
+ * SLAB_CHUNK_SIZE bytes, and a freed object is reused by the next allocation from its chunk, so
+ * that long-lived objects which are allocated and freed over time do not fragment the heap. New
+ * objects are taken from the chunks which already have free ones before a chunk is added, and a
+ * chunk is released as soon as all its objects are freed.
+ *
+ * The objects are allocated and freed under the lock of the slab, so a slab can be shared by all
+ * threads. Slabs are usually static, and initialized with SLAB_INITIALIZER.
+ */
+typedef struct {
+  size_t objSize;
+  pthread_mutex_t lock;
+  struct SlabChunk **chunks;  // All the chunks, sorted by address
+  size_t numChunks;
+  size_t chunksCap;
+  struct SlabChunk *partial;  // The chunks with free objects
+  size_t numObjects;
+} Slab;
+
+// The object size is rounded to a multiple of 8 bytes, so that all the objects are aligned
+#define SLAB_INITIALIZER(size) \
+  { .objSize = ((size) + 7) & ~(size_t)7, .lock = PTHREAD_MUTEX_INITIALIZER }
+
+/* Allocates a zeroed object */
+void *Slab_Alloc(Slab *s);
+
+/* Frees an object allocated from the slab */
+void Slab_Free(Slab *s, void *ptr);
+
+/* The number of bytes of an object of the slab */
+static inline size_t Slab_ObjectSize(const Slab *s) {
+  return s->objSize;
+}
+
+/* The memory held by the chunks of the slab */
+size_t Slab_MemUsage(Slab *s);
+
+/* The number of allocated objects */
+size_t Slab_NumObjects(Slab *s);
+
+#ifdef __cplusplus
+}
+#endif
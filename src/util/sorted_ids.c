@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "sorted_ids.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SORTED_IDS_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define SORTED_IDS_NEON
+#include <arm_neon.h>
+#endif
+
+size_t SortedIds_CountUpTo(const t_docId *ids, size_t n, t_docId maxId) {
+  size_t bottom = 0, top = n;
+  while (bottom < top) {
+    size_t mid = bottom + (top - bottom) / 2;
+    if (ids[mid] <= maxId) {
+      bottom = mid + 1;
+    } else {
+      top = mid;
+    }
+  }
+  return bottom;
+}
+
+static size_t intersectScalar(const t_docId *a, size_t na, const t_docId *b, size_t nb, t_docId *out) {
+  size_t i = 0, j = 0, n = 0;
+  while (i < na && j < nb) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (b[j] < a[i]) {
+      j++;
+    } else {
+      out[n++] = a[i];
+      i++;
+      j++;
+    }
+  }
+  return n;
+}
+
+// Search every id of the short array `a` in the long array `b`, by exponential search from the
+// position of the previous id followed by a binary search
+static size_t intersectGallop(const t_docId *a, size_t na, const t_docId *b, size_t nb, t_docId *out) {
+  size_t j = 0, n = 0;
+  for (size_t i = 0; i < na && j < nb; i++) {
+    const t_docId id = a[i];
+    if (b[j] < id) {
+      size_t step = 1;
+      while (j + step < nb && b[j + step] < id) {
+        j += step;
+        step <<= 1;
+      }
+      // b[j] < id <= b[j + step] (if in range)
+      size_t bottom = j + 1, top = j + step < nb ? j + step : nb;
+      while (bottom < top) {
+        size_t mid = bottom + (top - bottom) / 2;
+        if (b[mid] < id) {
+          bottom = mid + 1;
+        } else {
+          top = mid;
+        }
+      }
+      j = bottom;
+    }
+    if (j < nb && b[j] == id) {
+      out[n++] = id;
+      j++;
+    }
+  }
+  return n;
+}
+
+#ifdef SORTED_IDS_AVX2
+// Compare blocks of 4 ids of each array against each other (all the rotations of the block of `b`),
+// and advance the block(s) with the lowest last id
+__attribute__((target("avx2")))
+static size_t intersectAVX2(const t_docId *a, size_t na, const t_docId *b, size_t nb, t_docId *out) {
+  size_t i = 0, j = 0, n = 0;
+  while (i + 4 <= na && j + 4 <= nb) {
+    const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+    const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+    __m256i eq = _mm256_cmpeq_epi64(va, vb);
+    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+    while (mask) {
+      out[n++] = a[i + __builtin_ctz(mask)];
+      mask &= mask - 1;
+    }
+    const t_docId lastA = a[i + 3], lastB = b[j + 3];
+    if (lastA <= lastB) i += 4;
+    if (lastB <= lastA) j += 4;
+  }
+  return n + intersectScalar(a + i, na - i, b + j, nb - j, out + n);
+}
+#endif
+
+#ifdef SORTED_IDS_NEON
+// Same as the AVX2 variant, with blocks of 2 ids
+static size_t intersectNEON(const t_docId *a, size_t na, const t_docId *b, size_t nb, t_docId *out) {
+  size_t i = 0, j = 0, n = 0;
+  while (i + 2 <= na && j + 2 <= nb) {
+    const uint64x2_t va = vld1q_u64((const uint64_t *)(a + i));
+    const uint64x2_t vb = vld1q_u64((const uint64_t *)(b + j));
+    const uint64x2_t eq = vorrq_u64(vceqq_u64(va, vb), vceqq_u64(va, vextq_u64(vb, vb, 1)));
+    if (vgetq_lane_u64(eq, 0)) out[n++] = a[i];
+    if (vgetq_lane_u64(eq, 1)) out[n++] = a[i + 1];
+    const t_docId lastA = a[i + 1], lastB = b[j + 1];
+    if (lastA <= lastB) i += 2;
+    if (lastB <= lastA) j += 2;
+  }
+  return n + intersectScalar(a + i, na - i, b + j, nb - j, out + n);
+}
+#endif
+
+// Selected by `SortedIds_Select`
+static size_t (*intersectImpl)(const t_docId *, size_t, const t_docId *, size_t, t_docId *) = intersectScalar;
+
+const char *SortedIds_Select(uint32_t features) {
+#if defined(SORTED_IDS_AVX2)
+  // Blocks of 4 ids already fill an AVX2 register, so AVX-512 runs the AVX2 variant
+  if (features & (CPU_FEATURE_AVX2 | CPU_FEATURE_AVX512)) {
+    intersectImpl = intersectAVX2;
+    return "avx2";
+  }
+#elif defined(SORTED_IDS_NEON)
+  if (features & CPU_FEATURE_NEON) {
+    intersectImpl = intersectNEON;
+    return "neon";
+  }
+#endif
+  intersectImpl = intersectScalar;
+  return "scalar";
+}
+
+size_t SortedIds_Intersect(const t_docId *a, size_t na, const t_docId *b, size_t nb, t_docId *out) {
+  if (na > nb) {
+    // Make `a` the shorter array
+    const t_docId *tmp = a;
+    a = b;
+    b = tmp;
+    size_t ntmp = na;
+    na = nb;
+    nb = ntmp;
+  }
+  if (na == 0) {
+    return 0;
+  }
+  if (nb / na >= SORTED_IDS_GALLOP_RATIO) {
+    return intersectGallop(a, na, b, nb, out);
+  }
+  return intersectImpl(a, na, b, nb, out);
+}
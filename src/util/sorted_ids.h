@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "redisearch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Above this ratio between the lengths of the arrays, the shorter array is searched (galloping)
+// in the longer one rather than merged with it
+#define SORTED_IDS_GALLOP_RATIO 32
+
+/**
+ * Intersect two sorted arrays of unique document ids.
+ * Uses AVX2 (when the CPU supports it, see cpu_dispatch.h) or NEON to compare blocks of ids, and galloping search when
+ * the lengths of the arrays are very different.
+ * @param out - output array, which can hold at least MIN(na, nb) ids. May not overlap the inputs.
+ * @returns the number of ids written to `out`, in increasing order
+ */
+size_t SortedIds_Intersect(const t_docId *a, size_t na, const t_docId *b, size_t nb, t_docId *out);
+
+/**
+ * Find the number of leading ids of a sorted array which are less than or equal to `maxId`
+ */
+size_t SortedIds_CountUpTo(const t_docId *ids, size_t n, t_docId maxId);
+
+/* Select the implementation of the intersection for the CPU features (see cpu_dispatch.h).
+ * @returns the name of the implementation */
+const char *SortedIds_Select(uint32_t features);
+
+#ifdef __cplusplus
+}
+#endif
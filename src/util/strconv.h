@@ -125,6 +125,20 @@ static char* unicode_tolower(char *encoded, size_t *inout_len) {
 
   size_t in_len = *inout_len;
 
+  // ASCII strings, the bulk of the tags and terms, are lowered in place without decoding them
+  size_t ascii_len = 0;
+  while (ascii_len < in_len && encoded[ascii_len] && !(encoded[ascii_len] & 0x80)) {
+    ++ascii_len;
+  }
+  if (ascii_len == in_len) {
+    for (size_t j = 0; j < in_len; j++) {
+      if (encoded[j] >= 'A' && encoded[j] <= 'Z') {
+        encoded[j] += 'a' - 'A';
+      }
+    }
+    return NULL;
+  }
+
   uint32_t u_stack_buffer[SSO_MAX_LENGTH];
   uint32_t *u_buffer = u_stack_buffer;
   char *longer_dst = NULL;
@@ -195,16 +209,16 @@ static char* unicode_tolower(char *encoded, size_t *inout_len) {
   return longer_dst;
 }
 
-// strndup + unescape + tolower
-static char *rm_normalize(const char *s, size_t len) {
-  char *ret = rm_strndup(s, len);
-  char *dst = ret;
-  char *src = ret;
+// unescape + tolower of a NUL terminated string of `*len` bytes, in place. Returns NULL, or the
+// string in a new buffer if it got longer in lower case. `*len` is set to its new length
+static char *normalize_inplace(char *s, size_t *len) {
+  char *dst = s;
+  char *src = s;
   while (*src) {
     // unescape
     if (*src == '\\' && (ispunct(*(src+1)) || isspace(*(src+1)))) {
       ++src;
-      --len;
+      --*len;
       continue;
     }
     *dst = *src;
@@ -214,15 +228,22 @@ static char *rm_normalize(const char *s, size_t len) {
   *dst = '\0';
 
   // convert to lower case
-  char *longerDst = unicode_tolower(ret, &len);
-  if (longerDst) {
-      rm_free(ret);
-      ret = longerDst;
-  } else {
+  char *longerDst = unicode_tolower(s, len);
+  if (!longerDst) {
     // No memory allocation, just ensure null termination
-    ret[len] = '\0';
+    s[*len] = '\0';
   }
+  return longerDst;
+}
 
+// strndup + unescape + tolower
+static char *rm_normalize(const char *s, size_t len) {
+  char *ret = rm_strndup(s, len);
+  char *longerDst = normalize_inplace(ret, &len);
+  if (longerDst) {
+    rm_free(ret);
+    ret = longerDst;
+  }
   return ret;
 }
 
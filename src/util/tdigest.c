@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "tdigest.h"
+#include "rmalloc.h"
+#include "rmutil/rm_assert.h"
+
+typedef struct {
+  double mean;
+  double weight;
+} TDCentroid;
+
+struct TDigest {
+  double compression;
+
+  // The merged centroids sorted by mean, followed by the buffered ones
+  TDCentroid *centroids;
+  size_t merged;
+  size_t len;
+  size_t allocated;
+  size_t cap;  // The buffer is merged once the array holds that many centroids
+  bool reverse;  // Whether the next merge goes from the largest centroid to the smallest
+
+  double mergedWeight;
+  double unmergedWeight;
+  double min;
+  double max;
+};
+
+// The number of centroids the buffer can hold, for every centroid a merge can produce
+#define TDIGEST_BUFFER_FACTOR 5
+#define TDIGEST_INITIAL_SIZE 16
+// The quantiles the scale function is evaluated at are kept away from 0 and 1, where it is infinite
+#define TDIGEST_MIN_Q 1e-15
+
+// The serialized form of a digest, followed by its centroids
+typedef struct __attribute__((packed)) {
+  uint64_t n;
+  double min;
+  double max;
+} TDHeader;
+
+TDigest *NewTDigest(double compression) {
+  TDigest *td = rm_calloc(1, sizeof(*td));
+  td->compression = compression < 1 ? 1 : compression;
+  // Every two consecutive merged centroids span at least one unit of the scale function, so a
+  // merge produces no more than about `compression` centroids, and the values are merged in
+  // batches of several times that
+  td->cap = ((size_t)ceil(td->compression) + 2) * TDIGEST_BUFFER_FACTOR;
+  td->min = INFINITY;
+  td->max = -INFINITY;
+  return td;
+}
+
+void TD_Free(TDigest *td) {
+  rm_free(td->centroids);
+  rm_free(td);
+}
+
+double TD_GetCount(const TDigest *td) {
+  return td->mergedWeight + td->unmergedWeight;
+}
+
+// The logistic scale function, mapping a quantile to its position in units of centroids. The
+// centroids get smaller in proportion to q * (1 - q), so the tails are resolved much more finely
+// than the median. The normalizer keeps the number of centroids around `compression` as the
+// number of values grows
+static inline double scaleNormalizer(double compression, double n) {
+  return n > compression ? 4 * log(n / compression) + 24 : 24;
+}
+
+static inline double scaleK(double q, double compression, double n) {
+  q = q < TDIGEST_MIN_Q ? TDIGEST_MIN_Q : (q > 1 - TDIGEST_MIN_Q ? 1 - TDIGEST_MIN_Q : q);
+  return log(q / (1 - q)) * compression / scaleNormalizer(compression, n);
+}
+
+static inline double scaleQ(double k, double compression, double n) {
+  double w = exp(k * scaleNormalizer(compression, n) / compression);
+  return isinf(w) ? 1 : w / (1 + w);
+}
+
+static int centroidCmp(const void *a, const void *b) {
+  double ma = ((const TDCentroid *)a)->mean, mb = ((const TDCentroid *)b)->mean;
+  return ma < mb ? -1 : ma > mb ? 1 : 0;
+}
+
+static int centroidCmpReverse(const void *a, const void *b) {
+  return centroidCmp(b, a);
+}
+
+// Merge the buffered centroids into the sorted ones.
+// The merges alternate between both ends, since the centroids a merge starts from are filled up
+// the most, which would otherwise bias the quantiles towards the same end every time. The scale
+// function is symmetric, so a reverse merge is the same merge over the reversed centroids
+static void TD_Compress(TDigest *td) {
+  if (td->len == td->merged) {
+    return;
+  }
+  TDCentroid *c = td->centroids;
+  qsort(c, td->len, sizeof(*c), td->reverse ? centroidCmpReverse : centroidCmp);
+
+  double total = td->mergedWeight + td->unmergedWeight;
+  double weightSoFar = 0;
+  double compression = td->compression;
+  double weightLimit = total * scaleQ(scaleK(0, compression, total) + 1, compression, total);
+  size_t n = 0;
+  // The centroids are merged in place, since every merged centroid is written before the ones it
+  // is made of are read
+  for (size_t ii = 1; ii < td->len; ++ii) {
+    double weight = c[n].weight + c[ii].weight;
+    if (weightSoFar + weight <= weightLimit) {
+      c[n].mean += (c[ii].mean - c[n].mean) * c[ii].weight / weight;
+      c[n].weight = weight;
+    } else {
+      weightSoFar += c[n].weight;
+      double k = scaleK(weightSoFar / total, compression, total);
+      weightLimit = total * scaleQ(k + 1, compression, total);
+      c[++n] = c[ii];
+    }
+  }
+
+  td->merged = td->len = n + 1;
+  if (td->reverse) {
+    for (size_t ii = 0; ii < td->merged / 2; ++ii) {
+      TDCentroid tmp = c[ii];
+      c[ii] = c[td->merged - 1 - ii];
+      c[td->merged - 1 - ii] = tmp;
+    }
+  }
+  td->reverse = !td->reverse;
+  td->mergedWeight = total;
+  td->unmergedWeight = 0;
+}
+
+void TD_Add(TDigest *td, double val, double weight) {
+  if (isnan(val) || !(weight > 0)) {
+    return;
+  }
+  if (td->len == td->cap) {
+    TD_Compress(td);
+    RS_ASSERT(td->len < td->cap);
+  }
+  if (td->len == td->allocated) {
+    size_t allocated = td->allocated ? td->allocated * 2 : TDIGEST_INITIAL_SIZE;
+    td->allocated = allocated < td->cap ? allocated : td->cap;
+    td->centroids = rm_realloc(td->centroids, td->allocated * sizeof(*td->centroids));
+  }
+  td->centroids[td->len++] = (TDCentroid){.mean = val, .weight = weight};
+  td->unmergedWeight += weight;
+  if (val < td->min) td->min = val;
+  if (val > td->max) td->max = val;
+}
+
+void TD_Merge(TDigest *dst, const TDigest *src) {
+  for (size_t ii = 0; ii < src->len; ++ii) {
+    TD_Add(dst, src->centroids[ii].mean, src->centroids[ii].weight);
+  }
+  if (src->min < dst->min) dst->min = src->min;
+  if (src->max > dst->max) dst->max = src->max;
+}
+
+// The average of x1 and x2, which is never out of their range however it is rounded
+static double weightedAverage(double x1, double w1, double x2, double w2) {
+  if (x1 > x2) {
+    return weightedAverage(x2, w2, x1, w1);
+  }
+  double x = (x1 * w1 + x2 * w2) / (w1 + w2);
+  return x < x1 ? x1 : (x > x2 ? x2 : x);
+}
+
+double TD_Quantile(TDigest *td, double q) {
+  TD_Compress(td);
+  if (td->merged == 0) {
+    return NAN;
+  }
+  const TDCentroid *c = td->centroids;
+  size_t n = td->merged;
+  double total = td->mergedWeight;
+  double index = q * total;
+
+  // Each centroid stands for values spread around its mean, so the quantiles between the extremes
+  // and the middle of the first and last centroids are interpolated from the extremes
+  if (index < 1) {
+    return td->min;
+  }
+  if (c[0].weight > 2 && index < c[0].weight / 2) {
+    return td->min + (index - 1) / (c[0].weight / 2 - 1) * (c[0].mean - td->min);
+  }
+  if (index > total - 1) {
+    return td->max;
+  }
+  if (c[n - 1].weight > 2 && total - index <= c[n - 1].weight / 2) {
+    return td->max - (total - index - 1) / (c[n - 1].weight / 2 - 1) * (td->max - c[n - 1].mean);
+  }
+
+  double weightSoFar = c[0].weight / 2;
+  for (size_t ii = 0; ii + 1 < n; ++ii) {
+    double dw = (c[ii].weight + c[ii + 1].weight) / 2;
+    if (weightSoFar + dw > index) {
+      // A centroid of a single value is that exact value, rather than a spread around it
+      double leftUnit = 0;
+      if (c[ii].weight == 1) {
+        if (index - weightSoFar < 0.5) {
+          return c[ii].mean;
+        }
+        leftUnit = 0.5;
+      }
+      double rightUnit = 0;
+      if (c[ii + 1].weight == 1) {
+        if (weightSoFar + dw - index <= 0.5) {
+          return c[ii + 1].mean;
+        }
+        rightUnit = 0.5;
+      }
+      double z1 = index - weightSoFar - leftUnit;
+      double z2 = weightSoFar + dw - index - rightUnit;
+      return weightedAverage(c[ii].mean, z2, c[ii + 1].mean, z1);
+    }
+    weightSoFar += dw;
+  }
+
+  // Between the middle of the last centroid and the maximum
+  return weightedAverage(c[n - 1].mean, total - index, td->max, index - weightSoFar);
+}
+
+size_t TD_Serialize(TDigest *td, char **buf) {
+  TD_Compress(td);
+  TDHeader hdr = {.n = td->merged, .min = td->min, .max = td->max};
+  size_t len = sizeof(hdr) + td->merged * sizeof(*td->centroids);
+  *buf = rm_malloc(len);
+  memcpy(*buf, &hdr, sizeof(hdr));
+  if (td->merged) {
+    memcpy(*buf + sizeof(hdr), td->centroids, td->merged * sizeof(*td->centroids));
+  }
+  return len;
+}
+
+int TD_MergeSerialized(TDigest *td, const char *buf, size_t len) {
+  TDHeader hdr;
+  if (len < sizeof(hdr)) {
+    return 0;
+  }
+  memcpy(&hdr, buf, sizeof(hdr));
+  if ((len - sizeof(hdr)) / sizeof(TDCentroid) != hdr.n ||
+      (len - sizeof(hdr)) % sizeof(TDCentroid) != 0) {
+    return 0;
+  }
+  const char *p = buf + sizeof(hdr);
+  for (uint64_t ii = 0; ii < hdr.n; ++ii, p += sizeof(TDCentroid)) {
+    TDCentroid centroid;
+    memcpy(&centroid, p, sizeof(centroid));
+    TD_Add(td, centroid.mean, centroid.weight);
+  }
+  if (hdr.n) {
+    if (hdr.min < td->min) td->min = hdr.min;
+    if (hdr.max > td->max) td->max = hdr.max;
+  }
+  return 1;
+}
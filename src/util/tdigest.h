@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#ifndef TDIGEST_H
+#define TDIGEST_H
+
+#include <stdlib.h>
+
+#define TDIGEST_DEFAULT_COMPRESSION 100
+
+/**
+ * A merging t-digest (Dunning & Ertl, "Computing Extremely Accurate Quantiles Using t-Digests").
+ *
+ * Values are buffered, and the buffer is periodically merged into a list of centroids sorted by
+ * their mean. The size of the centroids is bounded by a logistic scale function, so that the
+ * centroids near the tails hold few values, which keeps p99 and p999 accurate. The digest never
+ * holds more than a few times `compression` centroids, whatever the number of values
+ */
+typedef struct TDigest TDigest;
+
+TDigest *NewTDigest(double compression);
+void TD_Add(TDigest *td, double val, double weight);
+// Add all the values of `src` to `dst`
+void TD_Merge(TDigest *dst, const TDigest *src);
+double TD_Quantile(TDigest *td, double q);
+double TD_GetCount(const TDigest *td);
+void TD_Free(TDigest *td);
+
+/**
+ * Serialize the centroids of the digest into a newly allocated buffer, returning its length.
+ * The buffer can be added to another digest with TD_MergeSerialized
+ */
+size_t TD_Serialize(TDigest *td, char **buf);
+// Returns 0 if the buffer is not a serialized digest
+int TD_MergeSerialized(TDigest *td, const char *buf, size_t len);
+
+#endif
@@ -19,7 +19,10 @@ static void ThreadPoolAPI_Execute(void *ctx) {
   IndexSpec *spec = StrongRef_Get(spec_ref);
   if (spec) {
     IndexSpec_IncrActiveWrites(spec); // Currently assuming all jobs are writes
+    rs_wall_clock start;
+    rs_wall_clock_init(&start);
     job->cb(job->arg);
+    VectorIndexingStats_AddDone(&spec->stats.vectorIndexing, rs_wall_clock_elapsed_ns(&start));
     IndexSpec_DecrActiveWrites(spec);
     IndexSpecRef_Release(spec_ref);
   }
@@ -56,5 +59,11 @@ int ThreadPoolAPI_SubmitIndexJobs(void *pool, void *spec_ctx, void **ext_jobs,
     }
     return REDISMODULE_ERR;
   }
+  StrongRef strong_ref = IndexSpecRef_Promote(spec_ref);
+  IndexSpec *spec = StrongRef_Get(strong_ref);
+  if (spec) {
+    VectorIndexingStats_AddSubmitted(&spec->stats.vectorIndexing, n_jobs);
+    IndexSpecRef_Release(strong_ref);
+  }
   return REDISMODULE_OK;
 }
@@ -60,9 +60,25 @@ static inline double rs_timer_ms(struct timespec *a){
 
 #define TIMEOUT_COUNTER_LIMIT 100
 
+/* Set from another thread to stop a query early, e.g. when its client disconnects or its cursor is
+ * deleted while it is read. It is checked along with the timeout, so a cancelled query stops as if
+ * it timed out. The token must outlive the threads running the query */
+typedef struct QueryCancelToken {
+  bool cancelled;
+} QueryCancelToken;
+
+static inline void QueryCancelToken_Cancel(QueryCancelToken *token) {
+  __atomic_store_n(&token->cancelled, true, __ATOMIC_RELAXED);
+}
+
+static inline bool QueryCancelToken_IsCancelled(const QueryCancelToken *token) {
+  return token && __atomic_load_n(&token->cancelled, __ATOMIC_RELAXED);
+}
+
 typedef struct TimeoutCtx {
   size_t counter;
   struct timespec timeout;
+  const QueryCancelToken *cancel;  // Optional
 } TimeoutCtx;
 
 typedef int(*TimeoutCb)(TimeoutCtx *);
@@ -98,14 +114,20 @@ static inline int TimedOut_WithCounter_Gran(const struct timespec *timeout, size
   return NOT_TIMED_OUT;
 }
 
-// Check if time has been reached (run once every 100 calls)
-static inline int TimedOut_WithCtx(TimeoutCtx *ctx) {
-  return TimedOut_WithCounter(&ctx->timeout, &ctx->counter);
+// Check if time has been reached or the query was cancelled (run once every `gran` calls)
+static inline int TimedOut_WithCtx_Gran(TimeoutCtx *ctx, uint32_t gran) {
+  if (RS_IsMock) return 0;
+
+  if (ctx->counter != REDISEARCH_UNINITIALIZED && ++ctx->counter == gran) {
+    ctx->counter = 0;
+    return QueryCancelToken_IsCancelled(ctx->cancel) ? TIMED_OUT : TimedOut(&ctx->timeout);
+  }
+  return NOT_TIMED_OUT;
 }
 
-// Check if time has been reached (run once every `gran` calls)
-static inline int TimedOut_WithCtx_Gran(TimeoutCtx *ctx, uint32_t gran) {
-  return TimedOut_WithCounter_Gran(&ctx->timeout, &ctx->counter, gran);
+// Check if time has been reached or the query was cancelled (run once every 100 calls)
+static inline int TimedOut_WithCtx(TimeoutCtx *ctx) {
+  return TimedOut_WithCtx_Gran(ctx, TIMEOUT_COUNTER_LIMIT);
 }
 
 // Check if time has been reached
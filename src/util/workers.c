@@ -14,6 +14,7 @@
 #include "logging.h"
 #include "rmutil/rm_assert.h"
 #include "VecSim/vec_sim.h"
+#include "cpu_affinity.h"
 
 #include <pthread.h>
 
@@ -35,6 +36,14 @@ static void yieldCallback(void *yieldCtx) {
   RedisModule_Yield(ctx, REDISMODULE_YIELD_FLAG_CLIENTS, NULL);
 }
 
+// Pin the worker to the CPUs of `_WORKERS_CPUS`, if set
+static void pinWorkerThread(void) {
+  if (!CPUList_PinCurrentThread(RSGlobalConfig.workersCPUs)) {
+    RedisModule_Log(RSDummyContext, "warning", "Could not pin a worker thread to the CPUs %s",
+                    RSGlobalConfig.workersCPUs);
+  }
+}
+
 /* Configure here anything that needs to know it can use the thread pool */
 static void workersThreadPool_OnActivation(size_t new_num) {
   // Log that we've enabled the thread pool.
@@ -55,6 +64,7 @@ int workersThreadPool_CreatePool(size_t worker_count) {
 
   _workers_thpool = redisearch_thpool_create(worker_count, RSGlobalConfig.highPriorityBiasNum, LogCallback, "workers");
   if (_workers_thpool == NULL) return REDISMODULE_ERR;
+  redisearch_thpool_set_on_thread_start(_workers_thpool, pinWorkerThread);
   if (worker_count > 0) {
     workersThreadPool_OnActivation(worker_count);
   } else {
@@ -198,6 +208,13 @@ thpool_stats workersThreadPool_getStats() {
   return redisearch_thpool_get_stats(_workers_thpool);
 }
 
+size_t workersThreadPool_GetThreadsCPUTime(uint64_t *cpu_time_ns, size_t max) {
+  if (!_workers_thpool) {
+    return 0;
+  }
+  return redisearch_thpool_get_threads_cpu_time(_workers_thpool, cpu_time_ns, max);
+}
+
 void workersThreadPool_wait() {
   if (!_workers_thpool || workerThreadPool_isPaused()) {
     return;
@@ -29,6 +29,9 @@ size_t workersThreadPool_WorkingThreadCount(void);
 // return n_threads value.
 size_t workersThreadPool_NumThreads(void);
 
+// Fill `cpu_time_ns` with the CPU time of up to `max` of the workers, and return the number of workers
+size_t workersThreadPool_GetThreadsCPUTime(uint64_t *cpu_time_ns, size_t max);
+
 // adds a task
 int workersThreadPool_AddWork(redisearch_thpool_proc, void *arg_p);
 
@@ -7,6 +7,7 @@
  * GNU Affero General Public License v3 (AGPLv3).
 */
 #include <pthread.h>
+#include <math.h>
 
 #include "value.h"
 #include "rmalloc.h"
@@ -27,21 +28,41 @@ static void *_valueAlloc() {
   return rm_malloc(sizeof(RSValue));
 }
 
+// The values of the short copied strings, which are stored after them
+pthread_key_t inlineStrMempoolKey_g;
+
+static void *_inlineStrValueAlloc() {
+  return rm_malloc(sizeof(RSValue) + RSVALUE_INLINE_STR_MAX + 1);
+}
+
 static void __attribute__((constructor)) initKey() {
   pthread_key_create(&mempoolKey_g, (void (*)(void *))mempool_destroy);
+  pthread_key_create(&inlineStrMempoolKey_g, (void (*)(void *))mempool_destroy);
 }
 
-static inline mempool_t *getPool() {
-  mempool_t *tp = pthread_getspecific(mempoolKey_g);
+static inline mempool_t *getPoolEx(pthread_key_t key, mempool_alloc_fn alloc) {
+  mempool_t *tp = pthread_getspecific(key);
   if (tp == NULL) {
     const mempool_options opts = {
-        .initialCap = 0, .maxCap = 1000, .alloc = _valueAlloc, .free = rm_free};
+        .initialCap = 0, .maxCap = 1000, .alloc = alloc, .free = rm_free};
     tp = mempool_new(&opts);
-    pthread_setspecific(mempoolKey_g, tp);
+    pthread_setspecific(key, tp);
   }
   return tp;
 }
 
+static inline mempool_t *getPool() {
+  return getPoolEx(mempoolKey_g, _valueAlloc);
+}
+
+static inline mempool_t *getInlineStrPool() {
+  return getPoolEx(inlineStrMempoolKey_g, _inlineStrValueAlloc);
+}
+
+static inline bool isInlineStr(const RSValue *v) {
+  return v->_t == RSValueType_String && v->_strval.stype == RSStringType_Inline;
+}
+
 ///////////////////////////////////////////////////////////////
 // Helper functions used throughout (no RSValue dependencies)
 ///////////////////////////////////////////////////////////////
@@ -205,6 +226,20 @@ RSValue *RSValue_NullStatic() {
 }
 
 RSValue *RSValue_NewCopiedString(const char *s, size_t n) {
+  if (n <= RSVALUE_INLINE_STR_MAX) {
+    // Most loaded strings are short, so save them their own allocation
+    RSValue *v = mempool_get(getInlineStrPool());
+    char *cp = (char *)(v + 1);
+    memcpy(cp, s, n);
+    cp[n] = 0;
+    v->_t = RSValueType_String;
+    v->_refcount = 1;
+    v->_allocated = 1;
+    v->_strval.str = cp;
+    v->_strval.len = n;
+    v->_strval.stype = RSStringType_Inline;
+    return v;
+  }
   RSValue *v = RSValue_NewWithType(RSValueType_String);
   char *cp = rm_malloc(n + 1);
   cp[n] = 0;
@@ -213,6 +248,24 @@ RSValue *RSValue_NewCopiedString(const char *s, size_t n) {
   return v;
 }
 
+RSValue *RSValue_NewInternedString(const char *s, size_t len, uint64_t hash) {
+  RSInternedString *is = rm_malloc(sizeof(*is) + len + 1);
+  char *cp = (char *)(is + 1);
+  memcpy(cp, s, len);
+  cp[len] = 0;
+  is->hash = hash;
+
+  RSValue *v = &is->value;
+  v->_t = RSValueType_String;
+  v->_refcount = 1;
+  // Not from the pools, see RSValue_Free()
+  v->_allocated = 0;
+  v->_strval.str = cp;
+  v->_strval.len = len;
+  v->_strval.stype = RSStringType_Interned;
+  return v;
+}
+
 RSValue *RSValue_NewParsedNumber(const char *p, size_t l) {
 
   char *e;
@@ -396,6 +449,99 @@ const char *RSValue_StringPtrLen(const RSValue *value, size_t *lenp) {
   }
 }
 
+size_t RSValue_FormatDouble(double d, char *buf) {
+  // 10^-3 .. 10^14
+  static const double powers[] = {1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5,
+                                  1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14};
+#define POW10(e) powers[(e) + 3]
+  const double a = fabs(d);
+  if (!(a >= 1e-3 && a < 1e11)) {
+    // Exponents, NaN and infinities
+    return sprintf(buf, "%.12g", d);
+  }
+  // 10^exp <= a < 10^(exp+1). The powers below 1 are rounded up as doubles, so that comparing
+  // against them is exact
+  int exp = -3;
+  while (exp < 10 && a >= POW10(exp + 1)) {
+    exp++;
+  }
+  // The 12 digits of the value. The product is off by less than 10^-3, so it is rounded as the
+  // exact value unless its fraction is that close to a half
+  const double scaled = a * POW10(11 - exp);
+  if (fabs(scaled - floor(scaled) - 0.5) < 1e-3) {
+    return sprintf(buf, "%.12g", d);
+  }
+#undef POW10
+  uint64_t n = llround(scaled);
+  if (n == 1000000000000ULL) {
+    // Rounded up to the next power of 10
+    n /= 10;
+    exp++;
+  }
+  char digits[12];
+  for (int i = 11; i >= 0; i--) {
+    digits[i] = '0' + n % 10;
+    n /= 10;
+  }
+  int ndigits = 12;
+  while (ndigits > 1 && digits[ndigits - 1] == '0') {
+    ndigits--;
+  }
+
+  size_t len = 0;
+  if (d < 0) {
+    buf[len++] = '-';
+  }
+  if (exp >= 0) {
+    memcpy(buf + len, digits, exp + 1);
+    len += exp + 1;
+    if (ndigits > exp + 1) {
+      buf[len++] = '.';
+      memcpy(buf + len, digits + exp + 1, ndigits - exp - 1);
+      len += ndigits - exp - 1;
+    }
+  } else {
+    buf[len++] = '0';
+    buf[len++] = '.';
+    memset(buf + len, '0', -exp - 1);
+    len += -exp - 1;
+    memcpy(buf + len, digits, ndigits);
+    len += ndigits;
+  }
+  buf[len] = '\0';
+  return len;
+}
+
+size_t RSValue_MemoryUsage(const RSValue *v) {
+  v = RSValue_Dereference(v);
+  size_t bytes = sizeof(RSValue);
+  switch (RSValue_Type(v)) {
+    case RSValueType_String:
+    case RSValueType_RedisString:
+    case RSValueType_OwnRstring: {
+      size_t len;
+      RSValue_StringPtrLen(v, &len);
+      bytes += len;
+      break;
+    }
+    case RSValueType_Array:
+      for (uint32_t i = 0; i < RSValue_ArrayLen(v); i++) {
+        bytes += sizeof(RSValue *) + RSValue_MemoryUsage(RSValue_ArrayItem(v, i));
+      }
+      break;
+    case RSValueType_Map:
+      for (uint32_t i = 0; i < RSValue_Map_Len(v); i++) {
+        RSValue *key, *val;
+        RSValue_Map_GetEntry(v, i, &key, &val);
+        bytes += RSValue_MemoryUsage(key) + RSValue_MemoryUsage(val);
+      }
+      break;
+    default:
+      break;
+  }
+  return bytes;
+}
+
 // Map getters/setters
 uint32_t RSValue_Map_Len(const RSValue *v) {
   RS_ASSERT(v && v->_t == RSValueType_Map);
@@ -425,6 +571,8 @@ void RSValue_Clear(RSValue *v) {
           rm_free(v->_strval.str);
           break;
         case RSStringType_Const:
+        case RSStringType_Inline:
+        case RSStringType_Interned:
           break;
       }
       break;
@@ -500,9 +648,16 @@ uint16_t RSValue_Refcount(const RSValue *v) {
 /* Free a value's internal value. It only does anything in the case of a string, and doesn't free
  * the actual value object */
 void RSValue_Free(RSValue *v) {
+  if (v->_t == RSValueType_String && v->_strval.stype == RSStringType_Interned) {
+    rm_free(v);
+    return;
+  }
+  // A value which held an inline string and was then set to another type is released to the
+  // pool of the plain values, which only takes its first bytes
+  mempool_t *pool = isInlineStr(v) ? getInlineStrPool() : getPool();
   RSValue_Clear(v);
   if (v->_allocated) {
-    mempool_release(getPool(), v);
+    mempool_release(pool, v);
   }
 }
 
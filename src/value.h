@@ -56,8 +56,15 @@ typedef enum {
 typedef enum {
   RSStringType_Const = 0x00,
   RSStringType_RMAlloc = 0x02,
+  // The string is stored right after the value, in the same allocation (see RSVALUE_INLINE_STR_MAX)
+  RSStringType_Inline = 0x04,
+  // The value is an RSInternedString, shared by the rows which loaded the same string
+  RSStringType_Interned = 0x06,
 } RSStringType;
 
+// The longest string RSValue_NewCopiedString stores in the allocation of its value
+#define RSVALUE_INLINE_STR_MAX 15
+
 /**
  * Represents a key-value pair entry in an RSValueMap.
  * Both key and value are RSValue pointers that are owned by the map.
@@ -129,6 +136,13 @@ typedef struct RSValue {
 } RSValue;
 #pragma pack()
 
+/* A string value created by RSValueInterner_Get(), allocated with its string (which follows this
+ * struct). The hash of the string is computed once, for RSValue_Hash() with no seed */
+typedef struct {
+  RSValue value;
+  uint64_t hash;
+} RSInternedString;
+
 ///////////////////////////////////////////////////////////////
 // Constructors
 ///////////////////////////////////////////////////////////////
@@ -258,6 +272,15 @@ RSValue *RSValue_NullStatic();
  */
 RSValue *RSValue_NewCopiedString(const char *s, size_t dst);
 
+/**
+ * Creates an interned string value with a copy of the string, see RSInternedString.
+ * @param s The string to copy
+ * @param len The length of the string
+ * @param hash The hash of the string, as RSValue_Hash(v, 0) computes it
+ * @return A pointer to a heap-allocated RSValue, with a reference count of 1
+ */
+RSValue *RSValue_NewInternedString(const char *s, size_t len, uint64_t hash);
+
 /**
  * Creates a heap-allocated RSValue by parsing a string as a number.
  * Returns NULL if the string cannot be parsed as a valid number.
@@ -486,6 +509,12 @@ static inline uint32_t RSValue_ArrayLen(const RSValue *arr) {
 /** Accesses the array length as an lvalue */
 #define RSVALUE_ARRLEN(vv) ((vv)->_arrval.len)
 
+/**
+ * The memory held by the value, counting its strings and the values of its arrays and maps.
+ * References count the value they point to.
+ */
+size_t RSValue_MemoryUsage(const RSValue *v);
+
 // Map getters/setters
 /**
  * Get the number of key-value pairs in a map RSValue.
@@ -624,7 +653,9 @@ static inline uint64_t RSValue_Hash(const RSValue *v, uint64_t hval) {
     case RSValueType_Reference:
       return RSValue_Hash(v->_ref, hval);
     case RSValueType_String:
-
+      if (!hval && v->_strval.stype == RSStringType_Interned) {
+        return ((const RSInternedString *)v)->hash;
+      }
       return fnv_64a_buf(v->_strval.str, v->_strval.len, hval);
     case RSValueType_Number:
       return fnv_64a_buf(&v->_numval, sizeof(double), hval);
@@ -708,14 +739,42 @@ static inline int RSValue_BoolTest(const RSValue *v) {
  * Formats the passed numeric RSValue as a string.
  * The passed RSValue must be of type RSValueType_Number.
  */
+/**
+ * Formats an integer as sprintf("%lld") does, without parsing a format. Most of the numbers of the
+ * rows of a reply are integers
+ */
+static inline size_t RSValue_FormatInteger(long long ll, char *buf) {
+  char digits[20];
+  size_t n = 0, len = 0;
+  unsigned long long u = ll < 0 ? -(unsigned long long)ll : (unsigned long long)ll;
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u);
+  if (ll < 0) {
+    buf[len++] = '-';
+  }
+  while (n) {
+    buf[len++] = digits[--n];
+  }
+  buf[len] = '\0';
+  return len;
+}
+
+/**
+ * Formats a double as sprintf("%.12g") does. The values with a fixed notation, between 0.001 and
+ * 10^11, are rounded to 12 digits without printf, unless they are too close to a tie to tell
+ */
+size_t RSValue_FormatDouble(double d, char *buf);
+
 static size_t RSValue_NumToString(const RSValue *v, char *buf) {
   RS_ASSERT(v->_t == RSValueType_Number);
   double dd = v->_numval;
   long long ll = dd;
   if (ll == dd) {
-    return sprintf(buf, "%lld", ll);
+    return RSValue_FormatInteger(ll, buf);
   } else {
-    return sprintf(buf, "%.12g", dd);
+    return RSValue_FormatDouble(dd, buf);
   }
 }
 
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#include "value_intern.h"
+#include "rmalloc.h"
+
+#define INTERNER_MIN_CAP 64
+
+RSValueInterner *RSValueInterner_New(void) {
+  return rm_calloc(1, sizeof(RSValueInterner));
+}
+
+void RSValueInterner_Free(RSValueInterner *in) {
+  if (!in) {
+    return;
+  }
+  for (uint32_t i = 0; i < in->cap; i++) {
+    if (in->slots[i]) {
+      RSValue_DecrRef(&in->slots[i]->value);
+    }
+  }
+  rm_free(in->slots);
+  rm_free(in);
+}
+
+static uint32_t probe(const RSValueInterner *in, uint64_t hash, const char *s, size_t len) {
+  uint32_t mask = in->cap - 1;
+  uint32_t i = (uint32_t)(hash ^ hash >> 32) & mask;
+  for (RSInternedString *is; (is = in->slots[i]); i = (i + 1) & mask) {
+    if (is->hash == hash && is->value._strval.len == len && !memcmp(is->value._strval.str, s, len)) {
+      break;
+    }
+  }
+  return i;
+}
+
+static void grow(RSValueInterner *in) {
+  RSValueInterner old = *in;
+  in->cap = old.cap ? old.cap * 2 : INTERNER_MIN_CAP;
+  in->slots = rm_calloc(in->cap, sizeof(*in->slots));
+  for (uint32_t i = 0; i < old.cap; i++) {
+    RSInternedString *is = old.slots[i];
+    if (is) {
+      in->slots[probe(in, is->hash, is->value._strval.str, is->value._strval.len)] = is;
+    }
+  }
+  rm_free(old.slots);
+}
+
+RSValue *RSValueInterner_Get(RSValueInterner *in, const char *s, size_t len) {
+  if (len > RSVALUE_INTERN_MAX_LEN) {
+    return NULL;
+  }
+  uint64_t hash = fnv_64a_buf((void *)s, len, 0);
+  if (!in->cap) {
+    grow(in);
+  }
+  uint32_t i = probe(in, hash, s, len);
+  RSInternedString *is = in->slots[i];
+  if (is) {
+    // Rows of other threads may hold the value too
+    if (__atomic_load_n(&is->value._refcount, __ATOMIC_RELAXED) < RSVALUE_INTERN_MAX_REFS) {
+      return RSValue_IncrRef(&is->value);
+    }
+    RSValue_DecrRef(&is->value);
+  } else {
+    if (in->size >= RSVALUE_INTERN_MAX_ENTRIES) {
+      return NULL;
+    }
+    // Keep the table at most half full
+    if (++in->size * 2 > in->cap) {
+      grow(in);
+      i = probe(in, hash, s, len);
+    }
+  }
+  is = (RSInternedString *)RSValue_NewInternedString(s, len, hash);
+  in->slots[i] = is;
+  return RSValue_IncrRef(&is->value);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+#pragma once
+
+#include "value.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The longest string which is interned
+#define RSVALUE_INTERN_MAX_LEN 64
+// The most distinct strings a table interns. The others are loaded as plain values
+#define RSVALUE_INTERN_MAX_ENTRIES 4096
+// A value is replaced by a fresh one once it has this many references, far from the 16 bits of the
+// reference count, which the rows holding it may still increment
+#define RSVALUE_INTERN_MAX_REFS (1 << 14)
+
+/* The strings loaded by a query which repeat across its rows, such as the values of TAG fields.
+ * The rows of a string share its value, whose hash is computed once, so the grouper and the
+ * COUNT_DISTINCT reducer compare them by pointer and do not hash them again.
+ *
+ * The values are reference counted as any other, so they may outlive the table */
+typedef struct RSValueInterner {
+  RSInternedString **slots;  // Open addressing, by the hash of the strings
+  uint32_t cap;
+  uint32_t size;
+} RSValueInterner;
+
+RSValueInterner *RSValueInterner_New(void);
+
+/* Release the references of the table to its values */
+void RSValueInterner_Free(RSValueInterner *in);
+
+/* A new reference to the interned value of the string, created if it is not yet in the table.
+ * Returns NULL if the string is too long, or the table is full */
+RSValue *RSValueInterner_Get(RSValueInterner *in, const char *s, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,12 +9,15 @@
 #include "vector_index.h"
 #include "iterators/hybrid_reader.h"
 #include "iterators/idlist_iterator.h"
+#include "iterators/wildcard_iterator.h"
+#include "knn_cache.h"
 #include "query_param.h"
 #include "rdb.h"
 #include "util/workers_pool.h"
 #include "util/threadpool_api.h"
 #include "redis_index.h"
 
+#include <math.h>
 
 #if defined(__x86_64__) && defined(__GLIBC__)
 #include <cpuid.h>
@@ -105,6 +108,97 @@ QueryIterator *createMetricIteratorFromVectorQueryResults(VecSimQueryReply *repl
   }
 }
 
+// Whether computing the distance of each document of the filter a range query is intersected with
+// is expected to be faster than searching the vector index. As a range query has no K, all the
+// documents of the filter are taken as candidate results, the way a hybrid KNN query of that K would
+static bool preferRangeFilterScan(VecSimIndex *index, QueryIterator *filter) {
+  size_t subset_size = filter->NumEstimated(filter);
+  // Since NumEstimated(filter) is an upper bound, it can be higher than index size.
+  if (subset_size > VecSimIndex_IndexSize(index)) {
+    subset_size = VecSimIndex_IndexSize(index);
+  }
+  return subset_size == 0 || VecSimIndex_PreferAdHocSearch(index, subset_size, subset_size, true);
+}
+
+// The EF an HNSW query of K results searches with, 0 if the field is not indexed with HNSW
+static size_t hnswEfRuntime(const FieldSpec *fs, const VecSimQueryParams *qParams, size_t k) {
+  const VecSimParams *params = &fs->vectorOpts.vecSimParams;
+  if (params->algo != VecSimAlgo_TIERED ||
+      params->algoParams.tieredParams.primaryIndexParams->algo != VecSimAlgo_HNSWLIB) {
+    return 0;
+  }
+  size_t ef = qParams->hnswRuntimeParams.efRuntime;
+  if (!ef) {
+    ef = params->algoParams.tieredParams.primaryIndexParams->algoParams.hnswParams.efRuntime;
+  }
+  return ef > k ? ef : k;
+}
+
+// Read the documents of the filter, keeping those within the radius of the query vector, and rewind
+// the filter for the intersection to read it again
+static QueryIterator *scanRangeFilter(QueryEvalCtx *q, VecSimIndex *index, VectorQuery *vq,
+                                      VecSimMetric metric, size_t dim, VecSimType type,
+                                      TimeoutCtx *timeoutCtx, bool yields_metric) {
+  QueryIterator *filter = q->rangeFilter;
+  void *qvector = vq->range.vector;
+  if (metric == VecSimMetric_Cosine) {
+    qvector = rm_malloc(dim * VecSimType_sizeof(type));
+    memcpy(qvector, vq->range.vector, dim * VecSimType_sizeof(type));
+    VecSim_Normalize(qvector, dim, type);
+  }
+
+  size_t cap = filter->NumEstimated(filter);
+  if (cap > VecSimIndex_IndexSize(index)) {
+    cap = VecSimIndex_IndexSize(index);
+  }
+  cap++;
+  size_t res_num = 0;
+  t_docId *docIdsList = rm_malloc(sizeof(*docIdsList) * cap);
+  double *metricList = rm_malloc(sizeof(*metricList) * cap);
+  bool timed_out = false;
+  IteratorStatus rc;
+  VecSimTieredIndex_AcquireSharedLocks(index);
+  while ((rc = filter->Read(filter)) != ITERATOR_EOF) {
+    if (rc == ITERATOR_TIMEOUT || TimedOut_WithCtx(timeoutCtx)) {
+      timed_out = true;
+      break;
+    }
+    if (rc != ITERATOR_OK) continue;
+    double distance = VecSimIndex_GetDistanceFrom_Unsafe(index, filter->lastDocId, qvector);
+    // NaN if the document has no vector in the index
+    if (isnan(distance) || distance > vq->range.radius) continue;
+    if (res_num == cap) {
+      cap *= 2;
+      docIdsList = rm_realloc(docIdsList, sizeof(*docIdsList) * cap);
+      metricList = rm_realloc(metricList, sizeof(*metricList) * cap);
+    }
+    docIdsList[res_num] = filter->lastDocId;
+    metricList[res_num++] = distance;
+  }
+  VecSimTieredIndex_ReleaseSharedLocks(index);
+  filter->Rewind(filter);
+  if (qvector != vq->range.vector) {
+    rm_free(qvector);
+  }
+
+  if (timed_out || res_num == 0) {
+    rm_free(docIdsList);
+    rm_free(metricList);
+    if (timed_out) {
+      QueryError_SetError(q->status, QUERY_ERROR_CODE_TIMED_OUT, NULL);
+    }
+    return NULL;
+  }
+  // The documents are read in the order of their ids
+  if (!yields_metric) {
+    rm_free(metricList);
+    return NewIdListIterator(docIdsList, res_num, 1.0);
+  }
+  MetricIterator *it = (MetricIterator *)NewMetricIterator(docIdsList, metricList, res_num, VECTOR_DISTANCE);
+  it->searchMode = "ADHOC_BF";
+  return &it->base.base;
+}
+
 QueryIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, QueryIterator *child_it) {
   RedisSearchCtx *ctx = q->sctx;
   RedisModuleString *key = IndexSpec_GetFormattedKey(ctx->spec, vq->field, INDEXFLD_T_VECTOR);
@@ -139,6 +233,11 @@ QueryIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, QueryIterator
                                                "Error parsing vector similarity query: query " VECSIM_KNN_K_TOO_LARGE_ERR_MSG ", must not exceed %zu", MAX_KNN_K);
         return NULL;
       }
+      // Only the queries without a filter are cached, as they can't be told apart otherwise. Those
+      // with a distance bound only find some of their results
+      size_t cacheCapacity = RSGlobalConfig.knnResultCacheEntries;
+      bool cached = cacheCapacity && ctx->spec->knnResults && !q->opts->hasKnnDistanceBound &&
+                    (child_it == NULL || IsWildcardIterator(child_it));
       HybridIteratorParams hParams = {.index = vecsim,
                                       .dim = dim,
                                       .elementType = type,
@@ -151,6 +250,18 @@ QueryIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, QueryIterator
                                       .timeout = q->sctx->time.timeout,
                                       .sctx = q->sctx,
                                       .filterCtx = &filterCtx,
+                                      .filterIdsMax = RSGlobalConfig.hybridFilterIdsMax,
+                                      .resultCache = cached ? ctx->spec->knnResults : NULL,
+                                      .cacheKey = cached ? KNNResultCache_Key(vq->field->index, &vq->knn,
+                                                                              vq->params.params,
+                                                                              array_len(vq->params.params))
+                                                         : NULL,
+                                      .cacheCapacity = cacheCapacity,
+                                      .hasDistanceBound = q->opts->hasKnnDistanceBound,
+                                      .distanceBound = q->opts->knnDistanceBound,
+                                      .efRuntime = hnswEfRuntime(vq->field, &qParams, vq->knn.k),
+                                      // The counters of the field are updated atomically
+                                      .fieldStats = (VectorQueryStats *)&vq->field->vectorOpts.queryStats,
       };
       return NewHybridVectorIterator(hParams, q->status);
     }
@@ -173,7 +284,13 @@ QueryIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, QueryIterator
                                     &qParams, QUERY_TYPE_RANGE, q->status) != VecSim_OK)  {
         return NULL;
       }
-      qParams.timeoutCtx = &(TimeoutCtx){ .timeout = q->sctx->time.timeout, .counter = 0 };
+      TimeoutCtx timeoutCtx = { .timeout = q->sctx->time.timeout, .counter = 0,
+                                .cancel = q->sctx->time.cancel };
+      bool yields_metric = vq->scoreField != NULL;
+      if (q->rangeFilter && preferRangeFilterScan(vecsim, q->rangeFilter)) {
+        return scanRangeFilter(q, vecsim, vq, metric, dim, type, &timeoutCtx, yields_metric);
+      }
+      qParams.timeoutCtx = &timeoutCtx;
       VecSimQueryReply *results =
           VecSimIndex_RangeQuery(vecsim, vq->range.vector, vq->range.radius,
                                  &qParams, vq->range.order);
@@ -182,8 +299,11 @@ QueryIterator *NewVectorIterator(QueryEvalCtx *q, VectorQuery *vq, QueryIterator
         QueryError_SetError(q->status, QUERY_ERROR_CODE_TIMED_OUT, NULL);
         return NULL;
       }
-      bool yields_metric = vq->scoreField != NULL;
-      return createMetricIteratorFromVectorQueryResults(results, yields_metric);
+      QueryIterator *it = createMetricIteratorFromVectorQueryResults(results, yields_metric);
+      if (q->rangeFilter && it && it->type == METRIC_ITERATOR) {
+        ((MetricIterator *)it)->searchMode = "RANGE_QUERY";
+      }
+      return it;
     }
   }
   return NULL;
@@ -95,6 +95,8 @@ typedef struct {
   size_t k;                      // number of vectors to return
   VecSimQueryReply_Order order;  // specify the result order.
   double shardWindowRatio;       // shard window ratio for distributed queries
+  double rerankFactor;           // The candidates searched for, per result, which are then reranked
+                                 // by their distance from the stored vectors. 1 for no reranking
 
   // Position tracking for K value modification (shard ratio optimization)
   // For literal K (e.g., "KNN 10"): stores position and length of numeric value
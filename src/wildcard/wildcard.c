@@ -7,6 +7,7 @@
  * GNU Affero General Public License v3 (AGPLv3).
 */
 #include <stdio.h>
+#include <string.h>
 #include <rmutil/rm_assert.h>
 #include "wildcard.h"
 
@@ -111,6 +112,77 @@ match_t Wildcard_MatchRune(const rune *pattern, size_t p_len, const rune *str, s
   return FULL_MATCH;
 }
 
+static inline bool isWildcard(char c) {
+  return c == '*' || c == '?';
+}
+
+void WildcardMatcher_Init(WildcardMatcher *m, const char *pattern, size_t p_len) {
+  *m = (WildcardMatcher){.pattern = pattern, .len = p_len};
+  for (size_t i = 0; i < p_len; ++i) {
+    if (pattern[i] == '*') {
+      m->hasStar = true;
+    } else {
+      m->minLen++;
+    }
+  }
+
+  while (m->prefixLen < p_len && !isWildcard(pattern[m->prefixLen])) {
+    m->prefixLen++;
+  }
+  if (m->prefixLen == p_len) {
+    // No wildcards at all
+    return;
+  }
+  while (!isWildcard(pattern[p_len - m->suffixLen - 1])) {
+    m->suffixLen++;
+  }
+
+  // The runs between the first and the last wildcards
+  for (size_t i = m->prefixLen; i < p_len - m->suffixLen;) {
+    while (i < p_len - m->suffixLen && isWildcard(pattern[i])) {
+      ++i;
+    }
+    size_t start = i;
+    while (i < p_len - m->suffixLen && !isWildcard(pattern[i])) {
+      ++i;
+    }
+    if (i - start > m->chunkLen) {
+      m->chunk = pattern + start;
+      m->chunkLen = i - start;
+    }
+  }
+}
+
+bool WildcardMatcher_Match(const WildcardMatcher *m, const char *str, size_t str_len) {
+  if (str_len < m->minLen || (!m->hasStar && str_len != m->minLen)) {
+    return false;
+  }
+  if (m->prefixLen && memcmp(str, m->pattern, m->prefixLen)) {
+    return false;
+  }
+  if (m->prefixLen == m->len) {
+    return true;
+  }
+  if (m->suffixLen &&
+      memcmp(str + str_len - m->suffixLen, m->pattern + m->len - m->suffixLen, m->suffixLen)) {
+    return false;
+  }
+  // The chunk can only match between the prefix and the suffix
+  if (m->chunkLen && !memmem(str + m->prefixLen, str_len - m->prefixLen - m->suffixLen, m->chunk,
+                             m->chunkLen)) {
+    return false;
+  }
+  return Wildcard_MatchChar(m->pattern, m->len, str, str_len) == FULL_MATCH;
+}
+
+size_t Wildcard_LiteralPrefixRune(const rune *pattern, size_t p_len) {
+  size_t i = 0;
+  while (i < p_len && pattern[i] != (rune)'*' && pattern[i] != (rune)'?') {
+    ++i;
+  }
+  return i;
+}
+
 size_t Wildcard_TrimPattern(char *pattern, size_t p_len) {
   size_t i = 0;
   size_t runner = 0;
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <string.h>
+#include <stdbool.h>
 
 #include "trie/rune_util.h"
 
@@ -44,6 +45,30 @@ typedef enum {
 match_t Wildcard_MatchChar(const char *pattern, size_t p_len, const char *str, size_t str_len);
 match_t Wildcard_MatchRune(const rune *pattern, size_t p_len, const rune *str, size_t str_len);
 
+/* A pattern prepared once to be matched against many strings, as Wildcard_MatchChar() does for a
+ * full match. The literal prefix and suffix of the pattern, and its longest literal run between
+ * wildcards, are compared or searched with memcmp/memmem first, so that most of the strings that
+ * do not match are rejected without running the backtracking matcher.
+ * The pattern is not copied, and must outlive the matcher */
+typedef struct {
+  const char *pattern;
+  size_t len;
+  size_t minLen;       // Number of characters other than '*', the length of the shortest match
+  bool hasStar;        // Otherwise the matching strings are exactly `minLen` long
+  size_t prefixLen;    // Length of the run of literal characters the pattern starts with
+  size_t suffixLen;    // Length of the run of literal characters the pattern ends with
+  const char *chunk;   // Longest literal run in between
+  size_t chunkLen;
+} WildcardMatcher;
+
+void WildcardMatcher_Init(WildcardMatcher *m, const char *pattern, size_t p_len);
+
+/* Returns true if the whole string matches the pattern */
+bool WildcardMatcher_Match(const WildcardMatcher *m, const char *str, size_t str_len);
+
+/* Returns the number of runes the pattern starts with before its first '*' or '?' */
+size_t Wildcard_LiteralPrefixRune(const rune *pattern, size_t p_len);
+
 /* Moves '?' before '*' and removes multiple '*'.
  * The patterns are equivalent as '**'=='*' (0 or more chars) and
  * '?*'=='*?' (1 or more chars) */
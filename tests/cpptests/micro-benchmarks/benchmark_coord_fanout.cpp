@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "benchmark/benchmark.h"
+#include "redismock/util.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <strings.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/result_processor.h"
+#include "src/search_ctx.h"
+#include "src/rlookup.h"
+#include "src/aggregate/aggregate.h"
+#include "coord/config.h"
+#include "coord/rpnet.h"
+#include "coord/hybrid/dist_utils.h"
+#include "coord/rmr/rmr.h"
+#include "coord/rmr/cluster_topology.h"
+
+extern "C" RedisModuleCtx *RSDummyContext;
+
+// The pages of the cursor of a shard, read one `_FT.CURSOR READ` after the other
+constexpr static size_t numPages = 4;
+
+static int64_t cpuNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1'000'000'000LL + ts.tv_nsec;
+}
+
+// The bytes in use by the allocator, of all the threads
+static size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// The replies of a shard and how long it takes to send each of them
+struct ShardConfig {
+    size_t numShards;
+    size_t rowsPerReply;
+    size_t payloadBytes;
+    int64_t latencyUs;  // Of every reply
+    int64_t jitterUs;   // The mean of an exponentially distributed delay added to the latency
+};
+
+// A shard that serves canned replies to the commands the coordinator sends to it, on a thread of
+// its own. The rows of every page are sorted by `n`, and the rows of the shards interleave, as the
+// replies of a query sorted by `n` would
+class MockShard {
+public:
+    int port = 0;
+
+    MockShard(size_t shard, const ShardConfig &conf) : conf(conf), rng(shard) {
+        for (size_t page = 0; page < numPages; page++) {
+            pages.emplace_back(renderPage(shard, page));
+        }
+
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {0};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listenFd, (struct sockaddr *)&addr, len) || listen(listenFd, 16) ||
+            getsockname(listenFd, (struct sockaddr *)&addr, &len) || pipe(stopPipe)) {
+            abort();
+        }
+        port = ntohs(addr.sin_port);
+        thread = std::thread(&MockShard::run, this);
+    }
+
+    ~MockShard() {
+        char c = 0;
+        (void)!write(stopPipe[1], &c, 1);
+        thread.join();
+        for (auto &client : clients) {
+            close(client.fd);
+        }
+        close(listenFd);
+        close(stopPipe[0]);
+        close(stopPipe[1]);
+    }
+
+    // The CPU time the thread of the shard used so far
+    int64_t cpuTime() const {
+        return cpu.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Client {
+        int fd;
+        std::string buf;
+    };
+
+    ShardConfig conf;
+    std::mt19937 rng;
+    std::vector<std::string> pages;
+    int listenFd;
+    int stopPipe[2];
+    std::vector<Client> clients;
+    std::thread thread;
+    std::atomic<int64_t> cpu{0};
+
+    // An `_FT.AGGREGATE` or `_FT.CURSOR READ` reply in RESP2: [[total, [n, <n>, payload, <payload>],
+    // ...], cursor]. The cursor id is the index of the next page, or 0 after the last one
+    std::string renderPage(size_t shard, size_t page) {
+        std::string payload(conf.payloadBytes, 'x');
+        std::string out = "*2\r\n*" + std::to_string(conf.rowsPerReply + 1) + "\r\n:" +
+                          std::to_string(conf.rowsPerReply) + "\r\n";
+        for (size_t i = 0; i < conf.rowsPerReply; i++) {
+            char n[32];
+            size_t value = (page * conf.rowsPerReply + i) * conf.numShards + shard;
+            // Padded, so that the string values compare as the numbers do
+            snprintf(n, sizeof(n), "%020zu", value);
+            out += "*4\r\n$1\r\nn\r\n$20\r\n";
+            out += n;
+            out += "\r\n$7\r\npayload\r\n$" + std::to_string(payload.size()) + "\r\n" + payload + "\r\n";
+        }
+        size_t cursor = page + 1 < numPages ? page + 1 : 0;
+        out += ":" + std::to_string(cursor) + "\r\n";
+        return out;
+    }
+
+    // Parse the first command of the buffer, an array of bulk strings as hiredis sends it. Returns
+    // the length of the command, or 0 if it was not received in full yet
+    static size_t parseCommand(const std::string &buf, std::vector<std::string> &argv) {
+        size_t pos = 0;
+        auto readLength = [&](char type, long &n) {
+            if (pos >= buf.size() || buf[pos] != type) return false;
+            size_t end = buf.find("\r\n", pos);
+            if (end == std::string::npos) return false;
+            n = strtol(buf.c_str() + pos + 1, NULL, 10);
+            pos = end + 2;
+            return true;
+        };
+        argv.clear();
+        long argc;
+        if (!readLength('*', argc)) return 0;
+        for (long i = 0; i < argc; i++) {
+            long len;
+            if (!readLength('$', len) || pos + len + 2 > buf.size()) return 0;
+            argv.emplace_back(buf, pos, len);
+            pos += len + 2;
+        }
+        return pos;
+    }
+
+    static bool is(const std::string &arg, const char *name) {
+        return !strcasecmp(arg.c_str(), name);
+    }
+
+    // Sleep the latency of a reply of rows
+    void delay() {
+        int64_t us = conf.latencyUs;
+        if (conf.jitterUs) {
+            std::exponential_distribution<> jitter(1.0 / conf.jitterUs);
+            us += jitter(rng);
+        }
+        if (us) {
+            std::this_thread::sleep_for(std::chrono::microseconds(us));
+        }
+    }
+
+    const std::string &reply(const std::vector<std::string> &argv) {
+        static const std::string ok = "+OK\r\n";
+        static const std::string noCursor = "-Cursor not found\r\n";
+        static const std::string unknown = "-ERR unknown command\r\n";
+        if (argv.empty()) {
+            return unknown;
+        }
+        if (is(argv[0], "_FT.AGGREGATE")) {
+            delay();
+            return pages[0];
+        }
+        if (is(argv[0], "_FT.CURSOR") && argv.size() == 4) {
+            if (!is(argv[1], "READ")) {
+                return ok;  // DEL
+            }
+            size_t page = strtoul(argv[3].c_str(), NULL, 10);
+            if (page == 0 || page >= pages.size()) {
+                return noCursor;
+            }
+            delay();
+            return pages[page];
+        }
+        if (is(argv[0], "AUTH") || is(argv[0], "HELLO") || is(argv[0], "READONLY")) {
+            return ok;
+        }
+        return unknown;
+    }
+
+    // Returns false once the client is disconnected
+    bool serve(Client &client) {
+        char buf[16 * 1024];
+        ssize_t n = read(client.fd, buf, sizeof(buf));
+        if (n <= 0) {
+            return false;
+        }
+        client.buf.append(buf, n);
+        std::vector<std::string> argv;
+        size_t len;
+        while ((len = parseCommand(client.buf, argv))) {
+            client.buf.erase(0, len);
+            const std::string &out = reply(argv);
+            for (size_t sent = 0; sent < out.size();) {
+                ssize_t rc = write(client.fd, out.data() + sent, out.size() - sent);
+                if (rc <= 0) {
+                    return false;
+                }
+                sent += rc;
+            }
+        }
+        return true;
+    }
+
+    void run() {
+        while (true) {
+            std::vector<struct pollfd> fds = {{stopPipe[0], POLLIN, 0}, {listenFd, POLLIN, 0}};
+            for (auto &client : clients) {
+                fds.push_back({client.fd, POLLIN, 0});
+            }
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                continue;
+            }
+            if (fds[0].revents) {
+                return;
+            }
+            for (size_t i = 0; i < clients.size();) {
+                if (fds[i + 2].revents && !serve(clients[i])) {
+                    close(clients[i].fd);
+                    clients.erase(clients.begin() + i);
+                    fds.erase(fds.begin() + i + 2);
+                } else {
+                    i++;
+                }
+            }
+            if (fds[1].revents) {
+                int fd = accept(listenFd, NULL, NULL);
+                if (fd >= 0) {
+                    clients.push_back({fd, ""});
+                }
+            }
+            cpu.store(cpuNs(CLOCK_THREAD_CPUTIME_ID), std::memory_order_relaxed);
+        }
+    }
+};
+
+// The coordinator of an aggregate query over a cluster of mock shards: the network processor reads
+// the replies of the shards through the I/O thread, optionally under a sorter by `n` which skips
+// the rest of the rows of a shard once they can't make it into its top results
+class BM_CoordFanout : public benchmark::Fixture {
+public:
+    constexpr static size_t topResults = 10;
+    std::vector<std::unique_ptr<MockShard>> shards;
+    size_t expectedRows;
+    RLookup lookup;
+    const RLookupKey *sortKey;
+    AREQ *areq;
+    QueryError err;
+    static bool initialized;
+
+    void SetUp(::benchmark::State &state) {
+        if (!initialized) {
+            RMCK::init();
+            RSDummyContext = RedisModule_GetThreadSafeContext(NULL);
+            // The shards may close the connections of the coordinator while it writes to them
+            signal(SIGPIPE, SIG_IGN);
+            clusterConfig.cursorReadAhead = DEFAULT_CURSOR_READ_AHEAD;
+            clusterConfig.cursorReplyThreshold = DEFAULT_CURSOR_REPLY_THRESHOLD;
+            clusterConfig.topologyValidationTimeoutMS = DEFAULT_TOPOLOGY_VALIDATION_TIMEOUT;
+            MR_Init(1, 1, 0);
+            initialized = true;
+        }
+
+        ShardConfig conf = {
+            .numShards = (size_t)state.range(0),
+            .rowsPerReply = (size_t)state.range(1),
+            .payloadBytes = (size_t)state.range(2),
+            .latencyUs = state.range(3),
+            .jitterUs = state.range(4),
+        };
+        MRClusterTopology *topo = MR_NewTopology(conf.numShards);
+        for (size_t i = 0; i < conf.numShards; i++) {
+            shards.emplace_back(new MockShard(i, conf));
+            // The ports tell the nodes of the shards of every benchmark apart
+            std::string id = "shard" + std::to_string(shards.back()->port);
+            MRClusterNode node = {
+                .endpoint = {.host = rm_strdup("127.0.0.1"), .port = shards.back()->port},
+                .id = rm_strdup(id.c_str()),
+            };
+            MRClusterShard shard = MR_NewClusterShard(&node);
+            MRClusterTopology_AddShard(topo, &shard);
+        }
+        MR_UpdateTopology(topo);
+        expectedRows = conf.numShards * conf.rowsPerReply * numPages;
+
+        RLookup_Init(&lookup, NULL);
+        sortKey = RLookup_GetKey_Write(&lookup, "n", RLOOKUP_F_NOFLAGS);
+        err = QueryError_Default();
+        areq = AREQ_New();
+        areq->sctx = rm_new(RedisSearchCtx);
+        *areq->sctx = SEARCH_CTX_STATIC(RSDummyContext, NULL);
+        areq->sctx->time.timeout = {LONG_MAX, 999999999};
+        AREQ_QueryProcessingCtx(areq)->err = &err;
+
+        // The requests wait for the new nodes to connect, while they may still be sent to the
+        // nodes of the previous benchmark until their connections are found to be closed
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (runQuery(false, NULL) != expectedRows) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                state.SkipWithError("The coordinator did not read all the rows of the shards");
+                break;
+            }
+            QueryError_ClearError(&err);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    void TearDown(::benchmark::State &state) {
+        AREQ_QueryProcessingCtx(areq)->err = NULL;
+        AREQ_Free(areq);
+        QueryError_ClearError(&err);
+        RLookup_Cleanup(&lookup);
+        shards.clear();
+    }
+
+    int64_t shardsCpuTime() const {
+        int64_t total = 0;
+        for (auto &shard : shards) {
+            total += shard->cpuTime();
+        }
+        return total;
+    }
+
+    // Run the query on the shards and read all of its results. The peak of the heap while the
+    // results are read is written to `peak`, if given, which is sampled after every result
+    size_t runQuery(bool sorted, size_t *peak) {
+        MRCommand cmd = MR_NewCommand(4, "_FT.AGGREGATE", "idx", "*", "WITHCURSOR");
+        cmd.rootCommand = C_AGG;
+        cmd.protocol = 2;
+        RPNet *nc = RPNet_New(&cmd, rpnetNext);
+        nc->lookup = &lookup;
+        nc->areq = areq;
+        nc->it = MR_Iterate(&nc->cmd, netCursorCallback);
+        if (!nc->it) {
+            rpnetFree(&nc->base);
+            return 0;
+        }
+
+        QueryProcessingCtx qctx = {0};
+        qctx.resultLimit = UINT32_MAX;
+        qctx.err = &err;
+        QITR_PushRP(&qctx, &nc->base);
+        if (sorted) {
+            ResultProcessor *sorter = RPSorter_NewByFields(topResults, &sortKey, 1, SORTASCMAP_INIT);
+            RPSorter_SetSortedRuns(sorter, RPNet_SkipShard);
+            QITR_PushRP(&qctx, sorter);
+            QITR_PushRP(&qctx, RPPager_New(0, topResults));
+        }
+
+        size_t base = peak ? heapInUse() : 0;
+        size_t n = 0;
+        SearchResult r = {0};
+        ResultProcessor *end = qctx.endProc;
+        while (end->Next(end, &r) == RS_RESULT_OK) {
+            n++;
+            if (peak) {
+                size_t used = heapInUse();
+                *peak = std::max(*peak, used > base ? used - base : 0);
+            }
+            SearchResult_Clear(&r);
+        }
+        SearchResult_Destroy(&r);
+        QITR_FreeChain(&qctx);
+        return n;
+    }
+};
+bool BM_CoordFanout::initialized = false;
+
+// Each iteration is a whole query. The CPU time of the coordinator is that of the process but the
+// shards: its I/O thread, which parses the replies, and the thread reading them, which merges
+// them. The peak of the heap is of a query after the timed ones, as sampling it is not free
+BENCHMARK_DEFINE_F(BM_CoordFanout, Query)(benchmark::State &state) {
+    if (state.skipped()) {
+        return;
+    }
+    bool sorted = state.range(5);
+    int64_t coordCpu = 0, mergeCpu = 0;
+    size_t results = 0;
+    for (auto _ : state) {
+        int64_t shardsStart = shardsCpuTime();
+        int64_t processStart = cpuNs(CLOCK_PROCESS_CPUTIME_ID);
+        int64_t threadStart = cpuNs(CLOCK_THREAD_CPUTIME_ID);
+        results += runQuery(sorted, NULL);
+        mergeCpu += cpuNs(CLOCK_THREAD_CPUTIME_ID) - threadStart;
+        coordCpu += cpuNs(CLOCK_PROCESS_CPUTIME_ID) - processStart - (shardsCpuTime() - shardsStart);
+    }
+    state.SetItemsProcessed(results);
+    state.counters["coord_cpu_us"] = benchmark::Counter(coordCpu / 1e3, benchmark::Counter::kAvgIterations);
+    state.counters["merge_cpu_us"] = benchmark::Counter(mergeCpu / 1e3, benchmark::Counter::kAvgIterations);
+
+    size_t peak = 0;
+    runQuery(sorted, &peak);
+    state.counters["peak_heap_bytes"] = peak;
+}
+
+#define FANOUT_SCENARIOS()                                                        \
+    ArgNames({"shards", "rows", "payload", "latency_us", "jitter_us", "sorted"}) \
+    ->ArgsProduct({                                                               \
+        {1, 4, 16, 64},     /* shards */                                          \
+        {100, 1000},        /* rows per reply */                                  \
+        {16, 1024},         /* payload bytes per row */                           \
+        {0},                /* latency_us */                                      \
+        {0},                /* jitter_us */                                       \
+        {false, true}       /* sorted */                                          \
+    })
+
+// The replies of the shards arrive apart, and the slowest shard holds the merge back
+#define LATENCY_SCENARIOS()                                                       \
+    ArgNames({"shards", "rows", "payload", "latency_us", "jitter_us", "sorted"}) \
+    ->ArgsProduct({                                                               \
+        {4, 16},            /* shards */                                          \
+        {100},              /* rows per reply */                                  \
+        {64},               /* payload bytes per row */                           \
+        {100, 1000},        /* latency_us */                                      \
+        {0, 1000},          /* jitter_us */                                       \
+        {false, true}       /* sorted */                                          \
+    })
+
+BENCHMARK_REGISTER_F(BM_CoordFanout, Query)->FANOUT_SCENARIOS()->UseRealTime();
+BENCHMARK_REGISTER_F(BM_CoordFanout, Query)->LATENCY_SCENARIOS()->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "benchmark/benchmark.h"
+#include "common.h"
+#include "index_utils.h"
+#include "redismock/util.h"
+#include "redismock/internal.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/module.h"
+#include "src/version.h"
+#include "src/config.h"
+#include "src/fork_gc.h"
+#include "src/redisearch_api.h"
+
+extern "C" {
+static int my_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (RedisModule_Init(ctx, REDISEARCH_MODULE_NAME, REDISEARCH_MODULE_VERSION,
+                         REDISMODULE_APIVER_1) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+    RSGlobalConfig.defaultScorer = rm_strdup(DEFAULT_SCORER_NAME);
+    return RediSearch_InitModuleInternal(ctx);
+}
+}
+
+// How the churn leaves garbage for the GC
+enum ChurnMode {
+    CHURN_DELETE = 0,  // The documents are deleted, and added back after the cycle
+    CHURN_UPDATE = 1,  // The documents are replaced, which deletes their previous version
+};
+
+// An index of TEXT, NUMERIC and TAG fields, of which each iteration churns a percentage of the
+// documents, and runs a whole cycle of the fork GC over them: fork, scan in the child, and apply
+// in the parent. The churn is not timed
+class BM_ForkGC : public benchmark::Fixture {
+public:
+    constexpr static size_t numDocs = 100'000;
+    RedisModuleCtx *ctx;
+    RefManager *ism;
+    ForkGC *fgc;
+    std::vector<size_t> ids;
+    std::mt19937 rng{46};
+    size_t version = 0;
+    static bool initialized;
+
+    void SetUp(::benchmark::State &state) {
+        if (!initialized) {
+            const char *arguments[] = {"NOGC"};
+            RMCK_Bootstrap(my_OnLoad, arguments, 1);
+            RSGlobalConfig.freeResourcesThread = false;
+            initialized = true;
+        }
+        ctx = RedisModule_GetThreadSafeContext(NULL);
+        RSGlobalConfig.gcConfigParams.forkGc.forkGcCleanThreshold = 0;
+        RSGlobalConfig.gcConfigParams.forkGc.forkGcApplyThreads = state.range(2);
+        RSGlobalConfig.gcConfigParams.forkGc.forkGcCycleBudgetMs = state.range(3);
+
+        ism = createSpec(ctx);
+        RediSearch_CreateTextField(ism, "t");
+        RediSearch_CreateNumericField(ism, "n");
+        RediSearch_CreateTagField(ism, "g");
+        fgc = reinterpret_cast<ForkGC *>(get_spec(ism)->gc->gcCtx);
+        ids.resize(numDocs);
+        std::iota(ids.begin(), ids.end(), 0);
+        for (size_t id : ids) {
+            addDoc(id);
+        }
+        version++;
+    }
+
+    void TearDown(::benchmark::State &state) {
+        freeSpec(ism);
+        RedisModule_FreeThreadSafeContext(ctx);
+    }
+
+    // The terms and the tag of a document change with its version, so that an update leaves the
+    // entries of its previous version behind in other inverted indexes
+    void addDoc(size_t id) {
+        size_t v = id + version;
+        std::string text = "w" + std::to_string(v % 1000) + " w" + std::to_string(v * 7 % 1000);
+        std::string tag = "tag" + std::to_string(v % 100);
+        RS::addDocument(ctx, ism, numToDocStr(id).c_str(), "t", text.c_str(),
+                        "n", std::to_string(v).c_str(), "g", tag.c_str());
+    }
+
+    // Churn a random sample of the documents. Returns the sample, for the deleted ones to be added
+    // back after the cycle
+    std::vector<size_t> churn(ChurnMode mode, size_t percent) {
+        std::shuffle(ids.begin(), ids.end(), rng);
+        std::vector<size_t> sample(ids.begin(), ids.begin() + numDocs * percent / 100);
+        for (size_t id : sample) {
+            if (mode == CHURN_UPDATE) {
+                addDoc(id);
+            } else {
+                std::string key = numToDocStr(id);
+                RediSearch_DeleteDocument(ism, key.c_str(), key.size());
+            }
+        }
+        return sample;
+    }
+};
+bool BM_ForkGC::initialized = false;
+
+#define GC_SCENARIOS()                                                      \
+    ArgNames({"percent", "update", "apply_threads", "budget_ms"})           \
+    ->ArgsProduct({                                                         \
+        {1, 10, 50},              /* percent */                             \
+        {CHURN_DELETE, CHURN_UPDATE}, /* update */                          \
+        {0, 4},                   /* apply_threads */                       \
+        {0, 5}                    /* budget_ms */                           \
+    })                                                                      \
+    ->Iterations(20)->Unit(benchmark::kMillisecond)->UseRealTime()
+
+// Each iteration is a cycle. The counters are the averages of the cycles: the fork itself, the
+// parent receiving and applying the results, the time it held the write lock of the spec, the
+// results received from the child and their throughput, the pages the child copied on write, and
+// the bytes the cycle reclaimed from the inverted indexes
+BENCHMARK_DEFINE_F(BM_ForkGC, Cycle)(benchmark::State &state) {
+    auto mode = static_cast<ChurnMode>(state.range(1));
+    size_t percent = state.range(0);
+    GCContext *gc = get_spec(ism)->gc;
+    double forkUs = 0, applyUs = 0, writeLockUs = 0, bytes = 0, cowBytes = 0, reclaimed = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<size_t> sample = churn(mode, percent);
+        ssize_t collected = fgc->stats.totalCollected;
+        state.ResumeTiming();
+
+        gc->callbacks.periodicCallback(fgc);
+
+        state.PauseTiming();
+        forkUs += fgc->stats.lastForkUs;
+        applyUs += fgc->stats.lastApplyUs;
+        writeLockUs += fgc->stats.lastWriteLockUs;
+        bytes += fgc->stats.lastBytesReceived;
+        cowBytes += fgc->stats.lastCowBytes;
+        reclaimed += fgc->stats.totalCollected - collected;
+        if (mode == CHURN_DELETE) {
+            for (size_t id : sample) {
+                addDoc(id);
+            }
+        }
+        version++;
+        state.ResumeTiming();
+    }
+    state.counters["fork_us"] = benchmark::Counter(forkUs, benchmark::Counter::kAvgIterations);
+    state.counters["apply_us"] = benchmark::Counter(applyUs, benchmark::Counter::kAvgIterations);
+    state.counters["write_lock_us"] = benchmark::Counter(writeLockUs, benchmark::Counter::kAvgIterations);
+    state.counters["pipe_bytes"] = benchmark::Counter(bytes, benchmark::Counter::kAvgIterations);
+    // Bytes per microsecond are MB/s
+    state.counters["pipe_MBps"] = applyUs ? bytes / applyUs : 0;
+    state.counters["cow_bytes"] = benchmark::Counter(cowBytes, benchmark::Counter::kAvgIterations);
+    state.counters["reclaimed_bytes"] = benchmark::Counter(reclaimed, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_REGISTER_F(BM_ForkGC, Cycle)->GC_SCENARIOS();
+
+BENCHMARK_MAIN();
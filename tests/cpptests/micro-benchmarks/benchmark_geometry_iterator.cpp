@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "benchmark/benchmark.h"
+#include "redismock/util.h"
+
+#include <random>
+#include <string>
+
+#include "src/iterators/iterator_api.h"
+#include "src/geometry/geometry_api.h"
+#include "src/doc_table.h"
+
+// Queries a geometry index of random small squares, as it is built by inserting them one by one
+// (Packed = 0) or once it is repacked (Packed = 1)
+class BM_GeometryIterator : public benchmark::Fixture {
+public:
+  static bool initialized;
+  GeometryIndex *index;
+  const GeometryApi *api;
+  std::string query;
+
+  void SetUp(::benchmark::State &state) {
+    if (!initialized) {
+      RMCK::init();
+      initialized = true;
+    }
+
+    index = GeometryIndexFactory(GEOMETRY_COORDS_Cartesian);
+    api = GeometryApi_Get(index);
+
+    auto numDocuments = 200000;
+    std::mt19937 rng(46);
+    std::uniform_real_distribution<double> dist(0, 10000);
+    for (t_docId id = 1; id <= numDocuments; ++id) {
+      auto x = dist(rng), y = dist(rng);
+      auto wkt = square(x, y, 5);
+      api->addGeomStr(index, GEOMETRY_FORMAT_WKT, wkt.c_str(), wkt.size(), id, NULL);
+    }
+    if (state.range(0)) {
+      api->repack(index, true);
+    }
+    query = square(5000, 5000, 100);
+  }
+
+  void TearDown(::benchmark::State &state) {
+    api->freeIndex(index);
+  }
+
+  static std::string square(double x, double y, double size) {
+    auto p = [](double x, double y) { return std::to_string(x) + " " + std::to_string(y); };
+    return "POLYGON((" + p(x, y) + ", " + p(x, y + size) + ", " + p(x + size, y + size) + ", " +
+           p(x + size, y) + ", " + p(x, y) + "))";
+  }
+};
+bool BM_GeometryIterator::initialized = false;
+
+BENCHMARK_DEFINE_F(BM_GeometryIterator, Intersects)(benchmark::State &state) {
+  FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}},
+                                  .predicate = FIELD_EXPIRATION_DEFAULT};
+  for (auto _ : state) {
+    QueryIterator *it = api->query(NULL, &filterCtx, index, QueryType::INTERSECTS, GEOMETRY_FORMAT_WKT,
+                                   query.c_str(), query.size(), NULL);
+    benchmark::DoNotOptimize(it->NumEstimated(it));
+    it->Free(it);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_GeometryIterator, Intersects)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
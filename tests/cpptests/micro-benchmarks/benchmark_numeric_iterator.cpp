@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "benchmark/benchmark.h"
+#include "redismock/util.h"
+
+#include <random>
+
+#include "src/iterators/iterator_api.h"
+#include "src/numeric_index.h"
+#include "src/numeric_filter.h"
+#include "src/config.h"
+
+extern "C" {
+// Internal functions of numeric_index.c, which open the iterator of a filter over a tree
+QueryIterator *createNumericIterator(const RedisSearchCtx *sctx, NumericRangeTree *t,
+                                     const NumericFilter *f, IteratorsConfig *config,
+                                     const FieldFilterContext* filterCtx);
+QueryIterator *createNumericIdsIterator(const RedisSearchCtx *sctx, NumericRangeTree *t,
+                                        const NumericFilter *f, IteratorsConfig *config,
+                                        const FieldFilterContext* filterCtx);
+}
+
+// A numeric filter over a range tree, which matches the given percentage of the documents. The
+// iterator is a union of the ranges of the tree the filter overlaps, of which the ranges at its
+// edges are filtered by value
+class BM_NumericIterator : public benchmark::Fixture {
+public:
+    constexpr static size_t numDocs = 200'000;
+    constexpr static double maxValue = 100'000;
+    NumericRangeTree *tree;
+    NumericFilter *filter;
+    IteratorsConfig config;
+    FieldFilterContext filterCtx;
+    QueryIterator *iterator;
+    static bool initialized;
+
+    void SetUp(::benchmark::State &state) {
+        if (!initialized) {
+            RMCK::init();
+            initialized = true;
+        }
+
+        bool isMulti = state.range(1);
+        std::mt19937 rng(46);
+        std::uniform_real_distribution<> dist(0, maxValue);
+        tree = NewNumericRangeTree();
+        for (t_docId id = 1; id <= numDocs; id++) {
+            NumericRangeTree_Add(tree, id, dist(rng), isMulti);
+            if (isMulti) {
+                NumericRangeTree_Add(tree, id, dist(rng), isMulti);
+            }
+        }
+
+        double percent = state.range(0);
+        filter = NewNumericFilter(0, maxValue * percent / 100, 1, 1, true, NULL);
+        iteratorsConfig_init(&config);
+        filterCtx = {.field = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}},
+                     .predicate = FIELD_EXPIRATION_DEFAULT};
+        iterator = createNumericIterator(NULL, tree, filter, &config, &filterCtx);
+    }
+
+    void TearDown(::benchmark::State &state) {
+        iterator->Free(iterator);
+        NumericFilter_Free(filter);
+        NumericRangeTree_Free(tree);
+    }
+
+    // Open an iterator of the filter and read all of it, as a query does
+    size_t readAll(QueryIterator *it) {
+        size_t n = 0;
+        while (it->Read(it) == ITERATOR_OK) {
+            n++;
+        }
+        it->Free(it);
+        return n;
+    }
+};
+bool BM_NumericIterator::initialized = false;
+
+#define NUMERIC_SCENARIOS()                                                 \
+    ArgNames({"percent", "multi"})                                          \
+    ->ArgsProduct({                                                         \
+        {1, 5, 10, 25, 50, 100},    /* percent */                           \
+        {false, true}               /* multi */                             \
+    })
+
+BENCHMARK_DEFINE_F(BM_NumericIterator, Read)(benchmark::State &state) {
+    for (auto _ : state) {
+        IteratorStatus rc = iterator->Read(iterator);
+        if (rc == ITERATOR_EOF) {
+            iterator->Rewind(iterator);
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(BM_NumericIterator, SkipTo)(benchmark::State &state) {
+    t_offset step = 10;
+    for (auto _ : state) {
+        IteratorStatus rc = iterator->SkipTo(iterator, iterator->lastDocId + step);
+        if (rc == ITERATOR_EOF) {
+            iterator->Rewind(iterator);
+        }
+    }
+}
+
+// The ids only iterator collects the ids of the ranges in a bitmap when it is opened, so the whole
+// query is measured, against the union it replaces
+BENCHMARK_DEFINE_F(BM_NumericIterator, ReadAll)(benchmark::State &state) {
+    size_t n = 0;
+    for (auto _ : state) {
+        n += readAll(createNumericIterator(NULL, tree, filter, &config, &filterCtx));
+    }
+    state.SetItemsProcessed(n);
+}
+
+BENCHMARK_DEFINE_F(BM_NumericIterator, ReadAll_IdsOnly)(benchmark::State &state) {
+    size_t n = 0;
+    for (auto _ : state) {
+        n += readAll(createNumericIdsIterator(NULL, tree, filter, &config, &filterCtx));
+    }
+    state.SetItemsProcessed(n);
+}
+
+BENCHMARK_REGISTER_F(BM_NumericIterator, Read)->NUMERIC_SCENARIOS();
+BENCHMARK_REGISTER_F(BM_NumericIterator, SkipTo)->NUMERIC_SCENARIOS();
+BENCHMARK_REGISTER_F(BM_NumericIterator, ReadAll)->NUMERIC_SCENARIOS();
+BENCHMARK_REGISTER_F(BM_NumericIterator, ReadAll_IdsOnly)->NUMERIC_SCENARIOS();
+
+BENCHMARK_MAIN();
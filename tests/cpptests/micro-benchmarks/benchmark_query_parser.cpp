@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "benchmark/benchmark.h"
+#include "query_test_utils.h"
+#include "redismock/util.h"
+#include "redismock/internal.h"
+
+#include <cstring>
+
+#include "src/module.h"
+#include "src/version.h"
+#include "src/config.h"
+#include "src/spec.h"
+#include "src/util/arena.h"
+
+extern "C" {
+static int my_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (RedisModule_Init(ctx, REDISEARCH_MODULE_NAME, REDISEARCH_MODULE_VERSION,
+                         REDISMODULE_APIVER_1) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+    RSGlobalConfig.defaultScorer = rm_strdup(DEFAULT_SCORER_NAME);
+    return RediSearch_InitModuleInternal(ctx);
+}
+}
+
+// A log of the queries of a product search, by the number of times each appears in it. Most of them
+// are a few words, some with filters
+static const struct {
+    const char *query;
+    int weight;
+} queryLog[] = {
+    {"wireless headphones", 20},
+    {"usb c charger 65w", 12},
+    {"@title:(running shoes) @price:[50 120]", 10},
+    {"@brand:{Sony|Bose} noise cancelling", 8},
+    {"lapt* @category:{electronics}", 6},
+    {"\"stainless steel\" water bottle -plastic", 5},
+    {"%speker% bluetooth", 4},
+    {"@title:kitchen* @rating:[4 +inf] @in_stock:{true}", 4},
+    {"(gaming | office) chair ergonomic", 3},
+    {"@description:(organic cotton) ~@title:kids", 2},
+    {"w'*phone*case*' @price:[-inf 30]", 1},
+    {"@sku:{AB\\-1234\\-XY}", 1},
+};
+
+// Each iteration parses the whole log, weighted, as the shards would, in the arena of a request
+class BM_QueryParser : public benchmark::Fixture {
+public:
+    static bool initialized;
+    StrongRef ref;
+    RedisSearchCtx sctx;
+
+    void SetUp(::benchmark::State &state) {
+        if (!initialized) {
+            const char *arguments[] = {"NOGC"};
+            RMCK_Bootstrap(my_OnLoad, arguments, 1);
+            initialized = true;
+        }
+        static const char *args[] = {
+            "SCHEMA", "title", "TEXT", "description", "TEXT", "brand", "TAG", "category", "TAG",
+            "in_stock", "TAG", "sku", "TAG", "price", "NUMERIC", "rating", "NUMERIC"};
+        QueryError err = QueryError_Default();
+        ref = IndexSpec_ParseC("idx", args, sizeof(args) / sizeof(*args), &err);
+        sctx = SEARCH_CTX_STATIC(NULL, (IndexSpec *)StrongRef_Get(ref));
+    }
+
+    void TearDown(::benchmark::State &state) {
+        IndexSpec_RemoveFromGlobals(ref, false);
+    }
+};
+bool BM_QueryParser::initialized = false;
+
+BENCHMARK_DEFINE_F(BM_QueryParser, ParseLog)(benchmark::State &state) {
+    bool useArena = state.range(0);
+    size_t queries = 0, bytes = 0;
+    for (auto _ : state) {
+        for (const auto &entry : queryLog) {
+            for (int i = 0; i < entry.weight; i++) {
+                Arena arena = {0};
+                if (useArena) {
+                    Arena_SetCurrent(&arena);
+                }
+                {
+                    QASTCXX ast(sctx);
+                    if (!ast.parse(entry.query, 2)) {
+                        state.SkipWithError(ast.getError());
+                        return;
+                    }
+                }
+                Arena_SetCurrent(NULL);
+                Arena_Free(&arena);
+                queries++;
+                bytes += strlen(entry.query);
+            }
+        }
+    }
+    state.SetItemsProcessed(queries);
+    state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK_REGISTER_F(BM_QueryParser, ParseLog)->ArgName("arena")->Arg(false)->Arg(true);
+
+BENCHMARK_MAIN();
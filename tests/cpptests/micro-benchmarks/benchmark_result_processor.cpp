@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "benchmark/benchmark.h"
+#include "iterator_util.h"
+#include "redismock/util.h"
+
+#include <random>
+#include <vector>
+
+#include "src/iterators/iterator_api.h"
+#include "src/result_processor.h"
+#include "src/search_result.h"
+#include "src/extension.h"
+
+// The stages of the chain, each on top of the previous ones
+enum ChainDepth {
+    CHAIN_SOURCE = 0,  // The results of the iterator
+    CHAIN_SCORER = 1,  // Scored results
+    CHAIN_SORTER = 2,  // The top results by score
+    CHAIN_PAGER = 3,   // A page of the top results
+};
+
+// Yields the ids of an iterator. It stands for the index processor, which needs the metadata of
+// the documents in the doc table of an index. It is not typed as one, so that the sorter doesn't
+// borrow the metadata from it
+struct RPIteratorSource : public ResultProcessor {
+    QueryIterator *it;
+
+    RPIteratorSource(QueryIterator *it) : it(it) {
+        memset(static_cast<ResultProcessor *>(this), 0, sizeof(ResultProcessor));
+        type = RP_MAX;
+        Next = sourceNext;
+        Free = sourceFree;
+    }
+
+    static int sourceNext(ResultProcessor *rp, SearchResult *res) {
+        QueryIterator *it = static_cast<RPIteratorSource *>(rp)->it;
+        if (it->Read(it) != ITERATOR_OK) {
+            return RS_RESULT_EOF;
+        }
+        SearchResult_SetDocId(res, it->lastDocId);
+        SearchResult_SetIndexResult(res, it->current);
+        rp->parent->totalResults++;
+        return RS_RESULT_OK;
+    }
+
+    static void sourceFree(ResultProcessor *rp) {
+        delete static_cast<RPIteratorSource *>(rp);
+    }
+};
+
+// Scatters the scores, so that the sorter keeps replacing its top results
+static double hashScorer(const ScoringFunctionArgs *ctx, const RSIndexResult *res,
+                         const RSDocumentMetadata *dmd, double minScore) {
+    return (res->docId * 2654435761u) % 100'000;
+}
+
+class BM_ResultProcessor : public benchmark::Fixture {
+public:
+    constexpr static t_docId maxDocId = 1'000'000;
+    constexpr static size_t topResults = 10;
+    std::vector<t_docId> ids;
+    QueryIterator *iterator;
+    static bool initialized;
+
+    void SetUp(::benchmark::State &state) {
+        if (!initialized) {
+            RMCK::init();
+            initialized = true;
+        }
+
+        // The chance of each id to match the query
+        double density = state.range(1) / 100.0;
+        std::mt19937 rng(46);
+        std::uniform_real_distribution<> dist;
+        ids.clear();
+        for (t_docId id = 1; id <= maxDocId; id++) {
+            if (dist(rng) < density) {
+                ids.emplace_back(id);
+            }
+        }
+        iterator = (QueryIterator *)new MockIterator(ids);
+    }
+
+    void TearDown(::benchmark::State &state) {
+        iterator->Free(iterator);
+    }
+
+    // Build the chain of the given depth over the iterator, and read all of its results
+    static size_t runChain(QueryIterator *it, ChainDepth depth) {
+        QueryProcessingCtx qctx = {0};
+        qctx.resultLimit = UINT32_MAX;
+        QITR_PushRP(&qctx, new RPIteratorSource(it));
+
+        ExtScoringFunctionCtx scoring = {.sf = hashScorer};
+        ScoringFunctionArgs scargs = {0};
+        if (depth >= CHAIN_SCORER) {
+            QITR_PushRP(&qctx, RPScorer_New(&scoring, &scargs, NULL));
+        }
+        if (depth >= CHAIN_SORTER) {
+            QITR_PushRP(&qctx, RPSorter_NewByScore(topResults));
+        }
+        if (depth >= CHAIN_PAGER) {
+            QITR_PushRP(&qctx, RPPager_New(0, topResults));
+        }
+
+        size_t n = 0;
+        SearchResult r = {0};
+        ResultProcessor *end = qctx.endProc;
+        while (end->Next(end, &r) == RS_RESULT_OK) {
+            n++;
+            SearchResult_Clear(&r);
+        }
+        SearchResult_Destroy(&r);
+        QITR_FreeChain(&qctx);
+        return n;
+    }
+};
+bool BM_ResultProcessor::initialized = false;
+
+#define CHAIN_SCENARIOS()                                                   \
+    ArgNames({"depth", "percent"})                                          \
+    ->ArgsProduct({                                                         \
+        {CHAIN_SOURCE, CHAIN_SCORER, CHAIN_SORTER, CHAIN_PAGER}, /* depth */ \
+        {1, 10, 50}                                             /* percent */ \
+    })
+
+// Each iteration is a whole query: the chain reads all the results of the iterator
+BENCHMARK_DEFINE_F(BM_ResultProcessor, Chain)(benchmark::State &state) {
+    auto depth = static_cast<ChainDepth>(state.range(0));
+    size_t results = 0;
+    for (auto _ : state) {
+        iterator->Rewind(iterator);
+        benchmark::DoNotOptimize(runChain(iterator, depth));
+        results += ids.size();
+    }
+    state.SetItemsProcessed(results);
+}
+
+BENCHMARK_REGISTER_F(BM_ResultProcessor, Chain)->CHAIN_SCENARIOS();
+
+BENCHMARK_MAIN();
@@ -11,11 +11,13 @@
 #include "iterator_util.h"
 #include "redismock/util.h"
 
+#include <climits>
 #include <random>
 #include <vector>
 
 #include "src/iterators/iterator_api.h"
 #include "src/iterators/union_iterator.h"
+#include "src/config.h"
 
 template <bool quickExit>
 class BM_UnionIterator : public benchmark::Fixture {
@@ -34,9 +36,11 @@ public:
         std::mt19937 rng(46);
         std::uniform_int_distribution<t_docId> dist(1, 2'000'000);
 
+        // Keep the total size of wide unions (loser tree) in check
+        const size_t numIds = numChildren > 100 ? 10'000 : 100'000;
         childrenIds.resize(numChildren);
         for (int i = 0; i < numChildren; ++i) {
-            childrenIds[i].resize(100'000);
+            childrenIds[i].resize(numIds);
             for (auto &id : childrenIds[i]) {
                 id = dist(rng);
             }
@@ -61,9 +65,9 @@ public:
 };
 template <bool quickExit>
 bool BM_UnionIterator<quickExit>::initialized = false;
-// Translation - exponential range from 2 to 20 (double each time), then 25, 50, 75, and 100.
-// This is the number of child iterators in each scenario
-#define UNION_SCENARIOS() RangeMultiplier(2)->Range(2, 20)->DenseRange(25, 100, 25)
+// Translation - exponential range from 2 to 20 (double each time), then 25, 50, 75, and 100, then
+// 128, 256 and 512. This is the number of child iterators in each scenario
+#define UNION_SCENARIOS() RangeMultiplier(2)->Range(2, 20)->DenseRange(25, 100, 25)->Arg(128)->Arg(256)->Arg(512)
 
 BENCHMARK_TEMPLATE1_DEFINE_F(BM_UnionIterator, ReadFull, false)(benchmark::State &state) {
     for (auto _ : state) {
@@ -108,4 +112,94 @@ BENCHMARK_REGISTER_F(BM_UnionIterator, ReadQuick)->UNION_SCENARIOS();
 BENCHMARK_REGISTER_F(BM_UnionIterator, SkipToFull)->UNION_SCENARIOS();
 BENCHMARK_REGISTER_F(BM_UnionIterator, SkipToQuick)->UNION_SCENARIOS();
 
+// The same union over children of a given density, tracked by a flat array or by a heap. The
+// children are few enough for a full union not to use the loser tree
+template <bool quickExit>
+class BM_UnionIteratorMode : public benchmark::Fixture {
+public:
+    constexpr static t_docId maxDocId = 200'000;
+    std::vector<std::vector<t_docId>> childrenIds;
+    IteratorsConfig config;
+    QueryIterator *ui_base;
+    static bool initialized;
+
+    void SetUp(::benchmark::State &state) {
+        if (!initialized) {
+            RMCK::init();
+            initialized = true;
+        }
+
+        auto numChildren = state.range(0);
+        bool heap = state.range(1);
+        // The chance of each id to be in each child
+        double density = state.range(2) / 100.0;
+
+        std::mt19937 rng(46);
+        std::uniform_real_distribution<> dist;
+        childrenIds.clear();
+        childrenIds.resize(numChildren);
+        for (auto &child : childrenIds) {
+            for (t_docId id = 1; id <= maxDocId; id++) {
+                if (dist(rng) < density) {
+                    child.emplace_back(id);
+                }
+            }
+        }
+
+        iteratorsConfig_init(&config);
+        config.minUnionIterHeap = heap ? 1 : LLONG_MAX;
+        QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * numChildren);
+        for (size_t i = 0; i < childrenIds.size(); i++) {
+            children[i] = (QueryIterator *)new MockIterator(childrenIds[i]);
+        }
+        ui_base = NewUnionIterator(children, numChildren, quickExit, 1.0, QN_UNION, NULL, &config);
+    }
+
+    void TearDown(::benchmark::State &state) {
+        ui_base->Free(ui_base);
+    }
+};
+template <bool quickExit>
+bool BM_UnionIteratorMode<quickExit>::initialized = false;
+
+#define UNION_MODE_SCENARIOS()                                              \
+    ArgNames({"numChildren", "heap", "percent"})                            \
+    ->ArgsProduct({                                                         \
+        {2, 4, 8, 16, 32},      /* numChildren */                           \
+        {false, true},          /* heap */                                  \
+        {1, 10, 50}             /* percent */                               \
+    })
+
+BENCHMARK_TEMPLATE1_DEFINE_F(BM_UnionIteratorMode, ReadFull, false)(benchmark::State &state) {
+    for (auto _ : state) {
+        IteratorStatus rc = ui_base->Read(ui_base);
+        if (rc == ITERATOR_EOF) {
+            ui_base->Rewind(ui_base);
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE1_DEFINE_F(BM_UnionIteratorMode, ReadQuick, true)(benchmark::State &state) {
+    for (auto _ : state) {
+        IteratorStatus rc = ui_base->Read(ui_base);
+        if (rc == ITERATOR_EOF) {
+            ui_base->Rewind(ui_base);
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE1_DEFINE_F(BM_UnionIteratorMode, SkipToFull, false)(benchmark::State &state) {
+    t_offset step = 10;
+    for (auto _ : state) {
+        IteratorStatus rc = ui_base->SkipTo(ui_base, ui_base->lastDocId + step);
+        if (rc == ITERATOR_EOF) {
+            ui_base->Rewind(ui_base);
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(BM_UnionIteratorMode, ReadFull)->UNION_MODE_SCENARIOS();
+BENCHMARK_REGISTER_F(BM_UnionIteratorMode, ReadQuick)->UNION_MODE_SCENARIOS();
+BENCHMARK_REGISTER_F(BM_UnionIteratorMode, SkipToFull)->UNION_MODE_SCENARIOS();
+
 BENCHMARK_MAIN();
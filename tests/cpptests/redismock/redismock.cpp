@@ -1099,6 +1099,14 @@ static RedisModuleCallReply *RMCK_CallHgetall(RedisModuleCtx *ctx, const char *c
   return r;
 }
 
+// No configuration of the server is set, so that every `CONFIG GET` replies with an empty array
+static RedisModuleCallReply *RMCK_CallConfig(RedisModuleCtx *ctx, const char *cmd, const char *fmt,
+                                             va_list ap) {
+  RedisModuleCallReply *r = new RedisModuleCallReply(ctx);
+  r->type = REDISMODULE_REPLY_ARRAY;
+  return r;
+}
+
 static RedisModuleCallReply *RMCK_CallHashFieldExpireTime(RedisModuleCtx *ctx, const char *cmd, const char *fmt,
                                               va_list ap) {
   // return an empty array of expire times
@@ -1129,6 +1137,8 @@ RedisModuleCallReply *RMCK_Call(RedisModuleCtx *ctx, const char *cmd, const char
     reply = RMCK_CallDel(ctx, cmd, fmt, ap);
   } else if (strcasecmp(cmd, "HPEXPIRETIME") == 0) {
     reply = RMCK_CallHashFieldExpireTime(ctx, cmd, fmt, ap);
+  } else if (strcasecmp(cmd, "CONFIG") == 0) {
+    reply = RMCK_CallConfig(ctx, cmd, fmt, ap);
   } else {
     errno = ENOTSUP;
   }
@@ -1350,6 +1360,13 @@ static unsigned long long RMCK_ServerInfoGetFieldUnsigned(RedisModuleServerInfoD
   return 0;
 }
 
+// The secret the connections of the coordinator authenticate with
+static const char *RMCK_GetInternalSecret(RedisModuleCtx *, size_t *len) {
+  static const char secret[] = "redismock-internal-secret";
+  *len = sizeof(secret) - 1;
+  return secret;
+}
+
 static unsigned long long RMCK_DbSize(RedisModuleCtx *ctx) {
   return ctx->db->size();
 }
@@ -1455,6 +1472,7 @@ static void registerApis() {
   REGISTER_API(GetSharedAPI);
 
   REGISTER_API(DbSize);
+  REGISTER_API(GetInternalSecret);
   REGISTER_API(GetServerInfo);
   REGISTER_API(FreeServerInfo);
   REGISTER_API(ServerInfoGetFieldUnsigned);
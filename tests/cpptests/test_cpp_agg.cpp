@@ -21,8 +21,11 @@
 
 #include <vector>
 #include <array>
+#include <set>
+#include <string>
 #include <iostream>
 #include <cstdarg>
+#include <algorithm>
 
 class AggTest : public ::testing::Test {};
 using RS::addDocument;
@@ -255,6 +258,128 @@ TEST_F(AggTest, testGroupSplit) {
   RLookup_Cleanup(&lk_out);
 }
 
+class KeyGenerator : public ResultProcessor {
+ public:
+  RLookupKey *kvalue = NULL;
+  bool strings = false;
+  size_t counter = 0;
+
+  KeyGenerator() {
+    memset(static_cast<ResultProcessor *>(this), 0, sizeof(ResultProcessor));
+  }
+};
+
+#define NUM_GROUPS 5000
+#define RESULTS_PER_GROUP 3
+
+TEST_F(AggTest, testGroupByManyGroups) {
+  for (bool strings : {false, true}) {
+    QueryProcessingCtx qitr = {0};
+    KeyGenerator gen;
+    gen.strings = strings;
+    RLookup lk_in = {0};
+    RLookup lk_out = {0};
+    gen.kvalue = RLookup_GetKey_Write(&lk_in, "value", RLOOKUP_F_NOFLAGS);
+    RLookupKey *val_out = RLookup_GetKey_Write(&lk_out, "value", RLOOKUP_F_NOFLAGS);
+    RLookupKey *count_out = RLookup_GetKey_Write(&lk_out, "COUNT", RLOOKUP_F_NOFLAGS);
+    Grouper *gr = Grouper_New((const RLookupKey **)&gen.kvalue, (const RLookupKey **)&val_out, 1);
+    ArgsCursor args = {0};
+    ReducerOptions opt = {0};
+    opt.args = &args;
+    Grouper_AddReducer(gr, RDCRCount_New(&opt), count_out);
+
+    gen.Next = [](ResultProcessor *rp, SearchResult *res) -> int {
+      KeyGenerator *p = static_cast<KeyGenerator *>(rp);
+      if (p->counter >= NUM_GROUPS * RESULTS_PER_GROUP) return RS_RESULT_EOF;
+      size_t key = p->counter++ % NUM_GROUPS;
+      SearchResult_SetDocId(res, p->counter);
+      RSValue *v;
+      if (p->strings) {
+        std::string s = "key" + std::to_string(key);
+        v = RSValue_NewCopiedString(s.c_str(), s.size());
+      } else {
+        v = RSValue_NewNumber(key);
+      }
+      RLookup_WriteOwnKey(p->kvalue, SearchResult_GetRowDataMut(res), v);
+      return RS_RESULT_OK;
+    };
+    QITR_PushRP(&qitr, &gen);
+    ResultProcessor *gp = Grouper_GetRP(gr);
+    QITR_PushRP(&qitr, gp);
+
+    // Every key is yielded once, with all of its results
+    std::set<std::string> seen;
+    SearchResult res = {0};
+    while (gp->Next(gp, &res) == RS_RESULT_OK) {
+      RSValue *rv = RLookup_GetItem(val_out, SearchResult_GetRowData(&res));
+      ASSERT_TRUE(rv != NULL);
+      size_t len;
+      const char *s = strings ? RSValue_StringPtrLen(rv, &len) : NULL;
+      std::string key = strings ? std::string(s, len) : std::to_string(RSValue_Number_Get(rv));
+      ASSERT_TRUE(seen.insert(key).second) << key;
+      RSValue *count = RLookup_GetItem(count_out, SearchResult_GetRowData(&res));
+      ASSERT_EQ(RSValue_Number_Get(count), RESULTS_PER_GROUP) << key;
+      SearchResult_Clear(&res);
+    }
+    ASSERT_EQ(seen.size(), NUM_GROUPS);
+    ASSERT_EQ(qitr.totalResults, NUM_GROUPS);
+    SearchResult_Destroy(&res);
+    gp->Free(gp);
+    RLookup_Cleanup(&lk_in);
+    RLookup_Cleanup(&lk_out);
+  }
+}
+
+TEST_F(AggTest, testGroupBySortedInput) {
+  QueryProcessingCtx qitr = {0};
+  KeyGenerator gen;
+  RLookup lk_in = {0};
+  RLookup lk_out = {0};
+  gen.kvalue = RLookup_GetKey_Write(&lk_in, "value", RLOOKUP_F_NOFLAGS);
+  RLookupKey *val_out = RLookup_GetKey_Write(&lk_out, "value", RLOOKUP_F_NOFLAGS);
+  RLookupKey *count_out = RLookup_GetKey_Write(&lk_out, "COUNT", RLOOKUP_F_NOFLAGS);
+  Grouper *gr = Grouper_New((const RLookupKey **)&gen.kvalue, (const RLookupKey **)&val_out, 1);
+  ArgsCursor args = {0};
+  ReducerOptions opt = {0};
+  opt.args = &args;
+  Grouper_AddReducer(gr, RDCRCount_New(&opt), count_out);
+  Grouper_SetSortedInput(gr);
+
+  // The results of each key are contiguous
+  gen.Next = [](ResultProcessor *rp, SearchResult *res) -> int {
+    KeyGenerator *p = static_cast<KeyGenerator *>(rp);
+    if (p->counter >= NUM_GROUPS * RESULTS_PER_GROUP) return RS_RESULT_EOF;
+    size_t key = p->counter++ / RESULTS_PER_GROUP;
+    SearchResult_SetDocId(res, p->counter);
+    RLookup_WriteOwnKey(p->kvalue, SearchResult_GetRowDataMut(res), RSValue_NewNumber(key));
+    return RS_RESULT_OK;
+  };
+  QITR_PushRP(&qitr, &gen);
+  ResultProcessor *gp = Grouper_GetRP(gr);
+  QITR_PushRP(&qitr, gp);
+
+  // Each key is yielded in order, once the first result of the next key is read
+  SearchResult res = {0};
+  size_t expected = 0;
+  while (gp->Next(gp, &res) == RS_RESULT_OK) {
+    RSValue *rv = RLookup_GetItem(val_out, SearchResult_GetRowData(&res));
+    ASSERT_TRUE(rv != NULL);
+    ASSERT_EQ(RSValue_Number_Get(rv), expected);
+    RSValue *count = RLookup_GetItem(count_out, SearchResult_GetRowData(&res));
+    ASSERT_EQ(RSValue_Number_Get(count), RESULTS_PER_GROUP);
+    ASSERT_EQ(gen.counter, std::min<size_t>(NUM_GROUPS * RESULTS_PER_GROUP, (expected + 1) * RESULTS_PER_GROUP + 1));
+    expected++;
+    SearchResult_Clear(&res);
+  }
+  ASSERT_EQ(expected, NUM_GROUPS);
+  ASSERT_EQ(qitr.totalResults, NUM_GROUPS);
+  ASSERT_EQ(gp->Next(gp, &res), RS_RESULT_EOF);
+  SearchResult_Destroy(&res);
+  gp->Free(gp);
+  RLookup_Cleanup(&lk_in);
+  RLookup_Cleanup(&lk_out);
+}
+
 #if 0
 int testAggregatePlan() {
   CmdString *argv = CmdParser_NewArgListV(
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "rmutil/alloc.h"
+#include "gtest/gtest.h"
+
+#include "src/util/arena.h"
+#include "src/query.h"
+#include "src/query_internal.h"
+#include "src/spec.h"
+#include "query_test_utils.h"
+
+#include <cstring>
+#include <thread>
+
+class ArenaTest : public ::testing::Test {};
+
+TEST_F(ArenaTest, AllocAndFree) {
+  Arena arena = {0};
+  char *prev = NULL;
+  for (size_t i = 1; i <= 1000; i++) {
+    char *p = (char *)Arena_Alloc(&arena, i % 40 + 1);
+    ASSERT_EQ(0, (uintptr_t)p % 16);
+    for (size_t j = 0; j < i % 40 + 1; j++) {
+      ASSERT_EQ(0, p[j]);
+    }
+    memset(p, 0xff, i % 40 + 1);
+    ASSERT_NE(p, prev);
+    prev = p;
+  }
+  ASSERT_EQ(1000, arena.numObjects);
+  ASSERT_GE(arena.bytes, 1000 * 16);
+
+  // An object larger than a block gets a block of its own
+  char *big = (char *)Arena_Alloc(&arena, 3 * ARENA_BLOCK_SIZE);
+  big[3 * ARENA_BLOCK_SIZE - 1] = 1;
+  ASSERT_EQ(1001, arena.numObjects);
+
+  Arena_Free(&arena);
+  ASSERT_EQ(0, arena.numObjects);
+  ASSERT_EQ(0, arena.bytes);
+  // A freed arena may be used again
+  ASSERT_TRUE(Arena_Alloc(&arena, 8) != NULL);
+  Arena_Free(&arena);
+}
+
+TEST_F(ArenaTest, CurrentArena) {
+  Arena arena = {0};
+  ASSERT_EQ(NULL, Arena_Current());
+  ASSERT_EQ(NULL, Arena_SetCurrent(&arena));
+  ASSERT_EQ(&arena, Arena_Current());
+
+  // The current arena is per thread
+  std::thread([] { ASSERT_EQ(NULL, Arena_Current()); }).join();
+
+  // The query nodes opt into the current arena
+  QueryNode *child = NewQueryNode(QN_WILDCARD);
+  ASSERT_TRUE(child->inArena);
+  ASSERT_EQ(1, arena.numObjects);
+
+  // A tree may mix both kinds of nodes
+  ASSERT_EQ(&arena, Arena_SetCurrent(NULL));
+  QueryNode *n = NewNotNode(child);
+  ASSERT_FALSE(n->inArena);
+  ASSERT_EQ(1, arena.numObjects);
+  QueryNode_Free(n);
+  Arena_Free(&arena);
+}
+
+TEST_F(ArenaTest, TokensInArena) {
+  static const char *args[] = {"SCHEMA", "title", "text"};
+  QueryError err = QueryError_Default();
+  StrongRef ref = IndexSpec_ParseC("idx", args, sizeof(args) / sizeof(*args), &err);
+  RedisSearchCtx ctx = SEARCH_CTX_STATIC(NULL, (IndexSpec *)StrongRef_Get(ref));
+
+  Arena arena = {0};
+  Arena_SetCurrent(&arena);
+  {
+    QASTCXX ast(ctx);
+    ASSERT_TRUE(ast.parse("HeLLo\\,x wor* %FuZZy% w'Wi*Ld'", 2)) << ast.getError();
+    QueryNode *root = ast.root;
+    ASSERT_EQ(QN_PHRASE, root->type);
+    ASSERT_EQ(4, QueryNode_NumChildren(root));
+    // The tokens are unescaped and lower cased into the arena, as the nodes are
+    for (size_t i = 0; i < 4; i++) {
+      ASSERT_TRUE(root->children[i]->tokenInArena);
+    }
+    ASSERT_STREQ("hello,x", root->children[0]->tn.str);
+    ASSERT_EQ(7, root->children[0]->tn.len);
+    ASSERT_STREQ("wor", root->children[1]->pfx.tok.str);
+    ASSERT_STREQ("fuzzy", root->children[2]->fz.tok.str);
+    ASSERT_EQ(5, root->children[2]->fz.tok.len);
+    ASSERT_STREQ("Wi*Ld", root->children[3]->verb.tok.str);
+
+    // A clone of a node owns its token
+    QueryNode *clone = QueryNode_Clone(root->children[0]);
+    ASSERT_FALSE(clone->tokenInArena);
+    ASSERT_STREQ("hello,x", clone->tn.str);
+    QueryNode_Free(clone);
+  }
+  Arena_SetCurrent(NULL);
+  Arena_Free(&arena);
+
+  // Without an arena, the tokens are allocated on their own
+  QASTCXX ast(ctx);
+  ASSERT_TRUE(ast.parse("wor*", 2));
+  ASSERT_FALSE(ast.root->tokenInArena);
+  ASSERT_STREQ("wor", ast.root->pfx.tok.str);
+  IndexSpec_RemoveFromGlobals(ref, false);
+}
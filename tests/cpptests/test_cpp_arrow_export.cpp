@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "aggregate/arrow_export.h"
+#include "value.h"
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+class ArrowExportTest : public ::testing::Test {};
+
+template <typename T>
+static T load(const uint8_t *p) {
+  T v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// A table of the FlatBuffers metadata of a message
+struct FbTable {
+  const uint8_t *pos;
+
+  const uint8_t *field(int id) const {
+    const uint8_t *vtable = pos - load<int32_t>(pos);
+    if (4 + 2 * id >= load<uint16_t>(vtable)) return nullptr;
+    uint16_t off = load<uint16_t>(vtable + 4 + 2 * id);
+    return off ? pos + off : nullptr;
+  }
+  template <typename T>
+  T scalar(int id) const {
+    const uint8_t *p = field(id);
+    EXPECT_EQ(0, (uintptr_t)p % sizeof(T)) << "Unaligned field " << id;
+    return p ? load<T>(p) : 0;
+  }
+  const uint8_t *ref(int id) const {
+    const uint8_t *p = field(id);
+    return p + load<uint32_t>(p);
+  }
+  FbTable table(int id) const {
+    return {ref(id)};
+  }
+  std::vector<FbTable> tables(int id) const {
+    const uint8_t *v = ref(id);
+    std::vector<FbTable> ret;
+    for (uint32_t i = 0; i < load<uint32_t>(v); i++) {
+      const uint8_t *slot = v + 4 + 4 * i;
+      ret.push_back({slot + load<uint32_t>(slot)});
+    }
+    return ret;
+  }
+  // A vector of structs of two int64
+  std::vector<std::pair<int64_t, int64_t>> pairs(int id) const {
+    const uint8_t *v = ref(id);
+    std::vector<std::pair<int64_t, int64_t>> ret;
+    for (uint32_t i = 0; i < load<uint32_t>(v); i++) {
+      ret.emplace_back(load<int64_t>(v + 4 + 16 * i), load<int64_t>(v + 12 + 16 * i));
+    }
+    return ret;
+  }
+  std::string string(int id) const {
+    const uint8_t *s = ref(id);
+    return std::string((const char *)s + 4, load<uint32_t>(s));
+  }
+};
+
+typedef std::vector<std::optional<std::string>> Column;
+
+// Read the stream, with the values of each column formatted as strings
+struct StreamReader {
+  std::vector<std::string> names;
+  std::vector<uint8_t> types;  // The members of the Type union
+  std::vector<Column> columns;
+  std::vector<int64_t> batchRows;
+  bool ended = false;
+
+  void read(const std::string &data) {
+    const uint8_t *p = (const uint8_t *)data.data(), *end = p + data.size();
+    while (p < end) {
+      ASSERT_EQ(0, (p - (const uint8_t *)data.data()) % 8);
+      ASSERT_EQ(0xFFFFFFFF, load<uint32_t>(p));
+      uint32_t len = load<uint32_t>(p + 4);
+      p += 8;
+      if (!len) {
+        ended = true;
+        ASSERT_EQ(p, end);
+        return;
+      }
+      ASSERT_EQ(0, len % 8);
+      FbTable message = {p + load<uint32_t>(p)};
+      ASSERT_EQ(4, message.scalar<int16_t>(0));  // V5
+      const uint8_t kind = message.scalar<uint8_t>(1);
+      const int64_t bodyLen = message.scalar<int64_t>(3);
+      const uint8_t *body = p + len;
+      FbTable header = message.table(2);
+      if (kind == 1) {
+        readSchema(header);
+      } else {
+        ASSERT_EQ(3, kind);
+        readBatch(header, body, bodyLen);
+      }
+      p = body + bodyLen;
+    }
+  }
+
+  void readSchema(const FbTable &schema) {
+    ASSERT_TRUE(names.empty());
+    for (const FbTable &field : schema.tables(1)) {
+      names.push_back(field.string(0));
+      types.push_back(field.scalar<uint8_t>(2));
+      if (types.back() == 3) {
+        ASSERT_EQ(2, field.table(3).scalar<int16_t>(0));  // DOUBLE
+      }
+      ASSERT_EQ(0, load<uint32_t>(field.ref(5)));  // No children
+    }
+    columns.resize(names.size());
+  }
+
+  void readBatch(const FbTable &batch, const uint8_t *body, int64_t bodyLen) {
+    const int64_t n = batch.scalar<int64_t>(0);
+    batchRows.push_back(n);
+    auto nodes = batch.pairs(1);
+    auto buffers = batch.pairs(2);
+    ASSERT_EQ(nodes.size(), names.size());
+    size_t b = 0;
+    for (size_t c = 0; c < names.size(); c++) {
+      ASSERT_EQ(n, nodes[c].first);
+      auto validity = buffers[b++];
+      int64_t nulls = 0;
+      for (int64_t i = 0; i < n; i++) {
+        bool valid = !validity.second || (body[validity.first + i / 8] >> (i % 8) & 1);
+        nulls += !valid;
+        if (!valid) {
+          columns[c].push_back(std::nullopt);
+        } else if (types[c] == 3) {
+          ASSERT_EQ(0, buffers[b].first % 8);
+          columns[c].push_back(std::to_string(load<double>(body + buffers[b].first + 8 * i)));
+        } else {
+          const uint8_t *offsets = body + buffers[b].first;
+          int32_t start = load<int32_t>(offsets + 4 * i), stop = load<int32_t>(offsets + 4 * i + 4);
+          columns[c].push_back(std::string((const char *)body + buffers[b + 1].first + start,
+                                           stop - start));
+        }
+      }
+      ASSERT_EQ(nulls, nodes[c].second);
+      b += types[c] == 3 ? 1 : 2;
+    }
+    ASSERT_EQ(b, buffers.size());
+    for (auto &[offset, len] : buffers) {
+      ASSERT_LE(offset + len, bodyLen);
+    }
+  }
+};
+
+static std::string finish(ArrowExportWriter *w, bool eos) {
+  Buffer buf = {0};
+  Buffer_Init(&buf, 16);
+  ArrowExportWriter_Finish(w, eos, &buf);
+  std::string ret(buf.data, buf.offset);
+  Buffer_Free(&buf);
+  return ret;
+}
+
+TEST_F(ArrowExportTest, testStream) {
+  ArrowExportWriter *w = ArrowExportWriter_New();
+  for (int i = 0; i < 5; i++) {
+    RSValue *n = RSValue_NewNumber(i * 1.5);
+    RSValue *s = RSValue_NewCopiedString(i % 2 ? "odd" : "even", i % 2 ? 3 : 4);
+    if (i != 2) {
+      ArrowExportWriter_AddValue(w, 0, n);
+    }
+    ArrowExportWriter_AddValue(w, 1, s);
+    ArrowExportWriter_AddValue(w, 2, i % 2 ? n : s);
+    // Not exported
+    ArrowExportWriter_AddValue(w, 3, s);
+    ArrowExportWriter_EndRow(w);
+    RSValue_DecrRef(n);
+    RSValue_DecrRef(s);
+  }
+  ArrowExportWriter_AddColumn(w, 0, "num", 3);
+  ArrowExportWriter_AddColumn(w, 1, "tag", 3);
+  ArrowExportWriter_AddColumn(w, 2, "mixed", 5);
+  std::string stream = finish(w, false);
+  ASSERT_TRUE(ArrowExportWriter_HasSchema(w));
+
+  // The types are kept by the later chunks
+  for (int i = 0; i < 3; i++) {
+    RSValue *n = RSValue_NewNumber(100 + i);
+    RSValue *s = RSValue_NewCopiedString("x", 1);
+    ArrowExportWriter_AddValue(w, 0, i == 1 ? s : n);
+    ArrowExportWriter_AddValue(w, 1, n);
+    ArrowExportWriter_AddValue(w, 5, n);
+    ArrowExportWriter_EndRow(w);
+    RSValue_DecrRef(n);
+    RSValue_DecrRef(s);
+  }
+  stream += finish(w, false);
+  // A chunk without rows adds nothing, until the end of the stream
+  ASSERT_EQ("", finish(w, false));
+  stream += finish(w, true);
+  ArrowExportWriter_Free(w);
+
+  StreamReader r;
+  ASSERT_NO_FATAL_FAILURE(r.read(stream));
+  ASSERT_TRUE(r.ended);
+  ASSERT_EQ(r.names, std::vector<std::string>({"num", "tag", "mixed"}));
+  ASSERT_EQ(r.types, std::vector<uint8_t>({3, 5, 5}));
+  ASSERT_EQ(r.batchRows, std::vector<int64_t>({5, 3}));
+  auto d = [](double v) { return std::optional<std::string>(std::to_string(v)); };
+  ASSERT_EQ(r.columns[0], Column({d(0), d(1.5), std::nullopt, d(4.5), d(6), d(100), std::nullopt, d(102)}));
+  ASSERT_EQ(r.columns[1], Column({"even", "odd", "even", "odd", "even", "100", "101", "102"}));
+  ASSERT_EQ(r.columns[2], Column({"even", "1.5", "even", "4.5", "even", std::nullopt, std::nullopt, std::nullopt}));
+}
+
+TEST_F(ArrowExportTest, testEmpty) {
+  ArrowExportWriter *w = ArrowExportWriter_New();
+  ArrowExportWriter_AddColumn(w, 1, "f", 1);
+  StreamReader r;
+  ASSERT_NO_FATAL_FAILURE(r.read(finish(w, true)));
+  ArrowExportWriter_Free(w);
+  ASSERT_TRUE(r.ended);
+  // A column without values is a Utf8 one
+  ASSERT_EQ(r.names, std::vector<std::string>({"f"}));
+  ASSERT_EQ(r.types, std::vector<uint8_t>({5}));
+  ASSERT_TRUE(r.batchRows.empty());
+}
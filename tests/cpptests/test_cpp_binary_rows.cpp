@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "aggregate/binary_rows.h"
+#include "rlookup.h"
+#include "value.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+class BinaryRowsTest : public ::testing::Test {};
+
+static std::string str(const RSValue *v) {
+  size_t len;
+  const char *s = RSValue_StringPtrLen(v, &len);
+  return s ? std::string(s, len) : std::string();
+}
+
+TEST_F(BinaryRowsTest, testRoundTrip) {
+  RLookup src = {0};
+  RLookup_Init(&src, NULL);
+  RLookupKey *num = RLookup_GetKey_Write(&src, "num", RLOOKUP_F_NOFLAGS);
+  RLookupKey *tag = RLookup_GetKey_Write(&src, "tag", RLOOKUP_F_NOFLAGS);
+  RLookupKey *mixed = RLookup_GetKey_Write(&src, "mixed", RLOOKUP_F_NOFLAGS);
+  std::string longStr(BINARY_ROWS_DICT_MAX_LEN + 1, 'x');
+
+  BinaryRowsWriter w;
+  BinaryRowsWriter_Init(&w, true);
+  const size_t numRows = 3;
+  for (size_t i = 0; i < numRows; i++) {
+    RSValue *n = RSValue_NewNumber(i + 0.5);
+    RSValue *t = RSValue_NewCopiedString(i % 2 ? "odd" : "even", i % 2 ? 3 : 4);
+    BinaryRowsWriter_AddValue(&w, 0, num, n);
+    BinaryRowsWriter_AddValue(&w, 1, tag, t);
+    RSValue_DecrRef(n);
+    RSValue_DecrRef(t);
+    if (i == 1) {
+      RSValue *s = RSValue_NewCopiedString(longStr.c_str(), longStr.size());
+      BinaryRowsWriter_AddValue(&w, 2, mixed, s);
+      RSValue_DecrRef(s);
+    } else if (i == 2) {
+      RSValue **arr = RSValue_AllocateArray(2);
+      arr[0] = RSValue_NewNumber(7);
+      arr[1] = RSValue_NullStatic();
+      RSValue *a = RSValue_NewArray(arr, 2);
+      BinaryRowsWriter_AddValue(&w, 2, mixed, a);
+      RSValue_DecrRef(a);
+    }
+    BinaryRowsWriter_EndRow(&w);
+  }
+  ASSERT_EQ(numRows, BinaryRowsWriter_NumRows(&w));
+  // Both tags are in the dictionary
+  ASSERT_EQ(2, array_len(w.dict));
+
+  Buffer buf = {0};
+  BinaryRowsWriter_Finish(&w, &buf);
+  BinaryRowsWriter_Free(&w);
+
+  RLookup dst = {0};
+  RLookup_Init(&dst, NULL);
+  // An existing key is reused
+  RLookupKey *dstTag = RLookup_GetKey_Write(&dst, "tag", RLOOKUP_F_NOFLAGS);
+  BinaryRowsReader r = {0};
+  BinaryRowsReader_Init(&r, buf.data, buf.offset, &dst);
+  ASSERT_EQ(numRows, r.numRows);
+  RLookupKey *dstNum = RLookup_GetKeyByName(&dst, "num", 3);
+  RLookupKey *dstMixed = RLookup_GetKeyByName(&dst, "mixed", 5);
+
+  RLookupRow rows[numRows] = {};
+  for (size_t i = 0; i < numRows; i++) {
+    ASSERT_FALSE(BinaryRowsReader_AtEnd(&r));
+    BinaryRowsReader_Next(&r, &rows[i]);
+  }
+  ASSERT_TRUE(BinaryRowsReader_AtEnd(&r));
+  BinaryRowsReader_Free(&r);
+  Buffer_Free(&buf);
+
+  for (size_t i = 0; i < numRows; i++) {
+    const RSValue *n = RLookup_GetItem(dstNum, &rows[i]);
+    ASSERT_TRUE(n && RSValue_IsNumber(n));
+    ASSERT_EQ(i + 0.5, RSValue_Number_Get(n));
+    ASSERT_EQ(i % 2 ? "odd" : "even", str(RLookup_GetItem(dstTag, &rows[i])));
+  }
+  // The rows share the values of the dictionary
+  ASSERT_EQ(RLookup_GetItem(dstTag, &rows[0]), RLookup_GetItem(dstTag, &rows[2]));
+
+  ASSERT_EQ(NULL, RLookup_GetItem(dstMixed, &rows[0]));
+  ASSERT_EQ(longStr, str(RLookup_GetItem(dstMixed, &rows[1])));
+  const RSValue *a = RLookup_GetItem(dstMixed, &rows[2]);
+  ASSERT_EQ(RSValueType_Array, RSValue_Type(a));
+  ASSERT_EQ(2, RSValue_ArrayLen(a));
+  ASSERT_EQ(7, RSValue_Number_Get(RSValue_ArrayItem(a, 0)));
+  ASSERT_TRUE(RSValue_IsNull(RSValue_ArrayItem(a, 1)));
+
+  for (size_t i = 0; i < numRows; i++) {
+    RLookupRow_Reset(&rows[i]);
+  }
+  RLookup_Cleanup(&dst);
+  RLookup_Cleanup(&src);
+}
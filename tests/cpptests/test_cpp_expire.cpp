@@ -90,3 +90,38 @@ TEST_F(ExpireTest, testSkipTo) {
   args.clear();
   RedisModule_FreeThreadSafeContext(ctx);
 }
+
+TEST_F(ExpireTest, testTimeToLiveTableAnyExpired) {
+  TimeToLiveTable *table = NULL;
+  TimeToLiveTable_VerifyInit(&table);
+  const time_t now = 1700000000;
+  struct timespec ts = {now, 0};
+  ASSERT_FALSE(TimeToLiveTable_AnyExpired(table, &ts));
+
+  // A document expiring soon, and fields expiring in a month
+  TimeToLiveTable_Add(table, 1, {now + 1000, 0}, NULL);
+  for (t_docId docId = 2; docId < 10; ++docId) {
+    arrayof(FieldExpiration) fe = array_new(FieldExpiration, 1);
+    FieldExpiration fe_entry = {0, {now + 30 * 86400 + (time_t)docId, 0}};
+    array_append(fe, fe_entry);
+    TimeToLiveTable_Add(table, docId, {0, 0}, fe);
+  }
+  ASSERT_FALSE(TimeToLiveTable_AnyExpired(table, &ts));
+  ts.tv_sec = now + 86400;
+  ASSERT_TRUE(TimeToLiveTable_AnyExpired(table, &ts));
+  ASSERT_TRUE(TimeToLiveTable_HasDocExpired(table, 1, &ts));
+  ASSERT_TRUE(TimeToLiveTable_VerifyDocAndField(table, 2, 0, FIELD_EXPIRATION_DEFAULT, &ts));
+
+  // Once the expired document is removed, nothing is due until the fields expire
+  TimeToLiveTable_Remove(table, 1);
+  ASSERT_FALSE(TimeToLiveTable_AnyExpired(table, &ts));
+  ASSERT_TRUE(TimeToLiveTable_VerifyDocAndField(table, 2, 0, FIELD_EXPIRATION_DEFAULT, &ts));
+  ASSERT_FALSE(TimeToLiveTable_VerifyDocAndField(table, 2, 0, FIELD_EXPIRATION_MISSING, &ts));
+  ts.tv_sec = now + 30 * 86400 + 2;
+  ASSERT_TRUE(TimeToLiveTable_AnyExpired(table, &ts));
+  ASSERT_FALSE(TimeToLiveTable_VerifyDocAndField(table, 2, 0, FIELD_EXPIRATION_DEFAULT, &ts));
+  ASSERT_TRUE(TimeToLiveTable_VerifyDocAndField(table, 2, 0, FIELD_EXPIRATION_MISSING, &ts));
+
+  TimeToLiveTable_Destroy(&table);
+  ASSERT_EQ(table, nullptr);
+}
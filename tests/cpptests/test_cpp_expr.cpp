@@ -10,9 +10,13 @@
 #include "gtest/gtest.h"
 #include "aggregate/expr/expression.h"
 #include "aggregate/expr/exprast.h"
+#include "aggregate/expr/bytecode.h"
 #include "aggregate/functions/function.h"
 #include "util/arr.h"
 #include "value.h"
+#include "search_result.h"
+
+#include <cmath>
 
 class ExprTest : public ::testing::Test {
  public:
@@ -663,3 +667,74 @@ TEST_F(ExprTest, testEvalFuncCaseWithDifferentTypeComparison) {
 }
 
 #undef ASSERT_EXPR_EVAL_NUMBER
+
+TEST_F(ExprTest, testProgramMatchesEval) {
+  RLookup lk = {0};
+  RLookup_Init(&lk, NULL);
+  RLookupKey *kfoo = RLookup_GetKey_Write(&lk, "foo", RLOOKUP_F_NOFLAGS);
+  RLookupKey *kbar = RLookup_GetKey_Write(&lk, "bar", RLOOKUP_F_NOFLAGS);
+
+  // The last rows are left to the AST evaluator: a string, a missing value and a NaN compare
+  const size_t n = 6;
+  SearchResult res[n] = {};
+  double foos[] = {1, -3.5, 7, 0, 2, NAN};
+  double bars[] = {2, 2, 0, 3, 0, 1};
+  for (size_t i = 0; i < n; i++) {
+    RLookupRow *row = SearchResult_GetRowDataMut(&res[i]);
+    RLookup_WriteOwnKey(kfoo, row, i == 4 ? RSValue_NewCString(rm_strdup("abc")) : RSValue_NewNumber(foos[i]));
+    if (i != 3) {
+      RLookup_WriteOwnKey(kbar, row, RSValue_NewNumber(bars[i]));
+    }
+  }
+
+  const char *exprs[] = {
+    "@foo * 2 + @bar",
+    "@foo % (@bar + 1) - @foo ^ 2",
+    "@foo <= @bar",
+    "@foo * 2 > @bar && !(@bar == 2)",
+    "@foo == 1 || @bar != 0",
+    "(1 < 2) + @foo / 3",
+    "!(@bar - 2)",
+  };
+  for (const char *e : exprs) {
+    TEvalCtx ctx(e);
+    ASSERT_TRUE(ctx) << ctx.error();
+    ctx.lookup = &lk;
+    ASSERT_EQ(EXPR_EVAL_OK, ctx.bindLookupKeys()) << e;
+
+    ExprProgram *prog = ExprProgram_Compile(ctx.root);
+    ASSERT_NE(prog, nullptr) << e;
+    ExprProgram_Run(prog, res, n);
+    for (size_t i = 0; i < n; i++) {
+      double num;
+      if (!ExprProgram_Result(prog, i, &num)) {
+        ASSERT_TRUE(i == 3 || i == 4) << e << " row " << i;
+        continue;
+      }
+      ctx.srcrow = SearchResult_GetRowData(&res[i]);
+      ASSERT_EQ(EXPR_EVAL_OK, ctx.eval()) << e << " row " << i;
+      double expected = RSValue_Number_Get(RSValue_Dereference(&ctx.result()));
+      if (std::isnan(expected)) {
+        ASSERT_TRUE(std::isnan(num)) << e << " row " << i;
+      } else {
+        ASSERT_EQ(expected, num) << e << " row " << i;
+      }
+    }
+    ExprProgram_Free(prog);
+  }
+
+  // Only numeric expressions are compiled
+  const char *notCompiled[] = {"@foo", "3", "sqrt(@foo) + 1", "@foo == 'abc'", "@bar != NULL"};
+  for (const char *e : notCompiled) {
+    TEvalCtx ctx(e);
+    ASSERT_TRUE(ctx) << ctx.error();
+    ctx.lookup = &lk;
+    ASSERT_EQ(EXPR_EVAL_OK, ctx.bindLookupKeys()) << e;
+    ASSERT_EQ(ExprProgram_Compile(ctx.root), nullptr) << e;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    SearchResult_Destroy(&res[i]);
+  }
+  RLookup_Cleanup(&lk);
+}
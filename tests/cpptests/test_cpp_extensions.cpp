@@ -48,6 +48,13 @@ static double myScorer(const ScoringFunctionArgs *ctx, const RSIndexResult *h,
   return 3.141;
 }
 
+static void myBatchScorer(const ScoringFunctionArgs *ctx, const RSDocumentMetadata *const *dmds,
+                          size_t n, double minScore, double *scores) {
+  for (size_t i = 0; i < n; i++) {
+    scores[i] = 3.141;
+  }
+}
+
 static int myExpander(RSQueryExpanderCtx *ctx, RSToken *token) {
   ctx->ExpandToken(ctx, strdup("foo"), 3, 0x00ff);
   return REDISMODULE_OK;
@@ -69,6 +76,14 @@ int myRegisterFunc(RSExtensionCtx *ctx) {
   if (ctx->RegisterScoringFunction(SCORER_NAME, myScorer, myFreeFunc, NULL) == REDISEARCH_ERR) {
     return REDISEARCH_ERR;
   }
+  if (ctx->RegisterBatchScoringFunction(SCORER_NAME, myBatchScorer) == REDISEARCH_ERR) {
+    return REDISEARCH_ERR;
+  }
+  // A batch version is only registered for a known scorer, and only once
+  if (ctx->RegisterBatchScoringFunction("no_such_scorer", myBatchScorer) == REDISEARCH_OK ||
+      ctx->RegisterBatchScoringFunction(SCORER_NAME, myBatchScorer) == REDISEARCH_OK) {
+    return REDISEARCH_ERR;
+  }
 
   /* Snowball Stemmer is the default expander */
   if (ctx->RegisterQueryExpander(EXPANDER_NAME, myExpander, myFreeFunc, NULL) == REDISEARCH_ERR) {
@@ -101,6 +116,7 @@ TEST_F(ExtTest, testRegistration) {
   ASSERT_EQ(sx->privdata, scxp.extdata);
   ASSERT_TRUE(sx->ff == myFreeFunc);
   ASSERT_TRUE(sx->sf == myScorer);
+  ASSERT_TRUE(sx->bsf == myBatchScorer);
   sx->ff(sx->privdata);
   ASSERT_EQ(2, numFreed);
   std::string ucScorer(SCORER_NAME);
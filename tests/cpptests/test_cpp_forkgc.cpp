@@ -199,6 +199,56 @@ TEST_F(FGCTestNumeric, testNumeric) {
   ASSERT_EQ(collected_bytes, fgc->stats.totalCollected);
 }
 
+/**
+ * Increasing values are added to the rightmost leaf, so that the leaves of the older values only
+ * lose entries. Once most of them are collected, the tree is rebuilt over fewer leaves.
+ */
+TEST_F(FGCTestNumeric, testRebalanceSkewedTree) {
+  size_t num_docs = 40000;
+  for (size_t i = 0; i < num_docs; i++) {
+    this->addDocumentWrapper(numToDocStr(i).c_str(), numeric_field_name, std::to_string(i).c_str());
+  }
+  NumericRangeTree *rt = getNumericTree(get_spec(ism), numeric_field_name);
+  size_t num_leaves = rt->numLeaves;
+  ASSERT_GE(num_leaves, 16);
+
+  // Keep every 10th of the oldest documents
+  FGC_WaitBeforeFork(fgc);
+  size_t expired = num_docs * 9 / 10;
+  size_t remaining = num_docs;
+  for (size_t i = 0; i < expired; i++) {
+    if (i % 10) {
+      ASSERT_TRUE(RS::deleteDocument(ctx, ism, numToDocStr(i).c_str()));
+      remaining--;
+    }
+  }
+  FGC_ForkAndWaitBeforeApply(fgc);
+  FGC_Apply(fgc);
+
+  ASSERT_LT(rt->numLeaves, num_leaves / 2);
+  ASSERT_EQ(rt->numEntries, remaining);
+  int balanced_depth = 0;
+  while ((1UL << balanced_depth) < rt->numLeaves) balanced_depth++;
+  ASSERT_EQ(rt->root->maxDepth, balanced_depth);
+
+  // The leaves are in the order of their values, and hold all the remaining entries
+  size_t total_entries = 0;
+  double prev_max = -INFINITY;
+  NumericFilter *flt = NewNumericFilter(-INFINITY, INFINITY, 1, 1, true, NULL);
+  Vector *v = NumericRangeTree_Find(rt, flt);
+  ASSERT_EQ(Vector_Size(v), rt->numLeaves);
+  for (size_t i = 0; i < Vector_Size(v); i++) {
+    NumericRange *r;
+    Vector_Get(v, i, &r);
+    ASSERT_GT(r->minVal, prev_max);
+    prev_max = r->maxVal;
+    total_entries += InvertedIndex_NumEntries(r->entries);
+  }
+  ASSERT_EQ(total_entries, remaining);
+  Vector_Free(v);
+  NumericFilter_Free(flt);
+}
+
 /** Mark one of the entries in the last block as deleted while the child is running.
  * This means the number of original entries recorded by the child and the current number of
  * entries are equal, and we conclude there weren't any changes in the parent to the block buffer.
@@ -281,6 +331,68 @@ TEST_F(FGCTestTag, testRemoveLastBlockWhileUpdate) {
   ASSERT_EQ(1, TotalIIBlocks() - startValue);
 }
 
+/**
+ * The entries left by a cycle in a block that changed since its fork are looked for again by the
+ * next cycle, even though no document was deleted in between.
+ * */
+TEST_F(FGCTestTag, testRetryDeletedIdsOfIncompleteCycle) {
+  ASSERT_TRUE(RS::addDocument(ctx, ism, "doc1", "f1", "hello"));
+  FGC_WaitBeforeFork(fgc);
+  ASSERT_TRUE(RS::deleteDocument(ctx, ism, "doc1"));
+  FGC_ForkAndWaitBeforeApply(fgc);
+  ASSERT_TRUE(RS::addDocument(ctx, ism, "doc2", "f1", "hello"));
+  FGC_Apply(fgc);
+
+  // The changes to the last block were discarded, so the id of doc1 is kept
+  ASSERT_EQ(1, fgc->stats.gcBlocksDenied);
+  ASSERT_EQ(1, array_len(fgc->deletedIds));
+  ASSERT_EQ(2, (get_spec(ism))->stats.numRecords);
+
+  FGC_WaitBeforeFork(fgc);
+  FGC_ForkAndWaitBeforeApply(fgc);
+  FGC_Apply(fgc);
+
+  ASSERT_EQ(1, fgc->stats.gcBlocksDenied);
+  ASSERT_EQ(0, array_len(fgc->deletedIds));
+  ASSERT_EQ(1, (get_spec(ism))->stats.numRecords);
+}
+
+/**
+ * Apply the values of a tag field on the apply threads, in several batches. The value of each
+ * deleted document is removed, and the others are left intact.
+ */
+TEST_F(FGCTestTag, testApplyOnThreads) {
+  RSGlobalConfig.gcConfigParams.forkGc.forkGcApplyThreads = 4;
+  size_t num_docs = 300;
+  for (size_t i = 0; i < num_docs; i++) {
+    std::string val = "v" + std::to_string(i);
+    ASSERT_TRUE(RS::addDocument(ctx, ism, numToDocStr(i).c_str(), "f1", val.c_str()));
+  }
+  FGC_WaitBeforeFork(fgc);
+  for (size_t i = 1; i < num_docs; i += 2) {
+    ASSERT_TRUE(RS::deleteDocument(ctx, ism, numToDocStr(i).c_str()));
+  }
+  FGC_ForkAndWaitBeforeApply(fgc);
+  FGC_Apply(fgc);
+  RSGlobalConfig.gcConfigParams.forkGc.forkGcApplyThreads = DEFAULT_FORK_GC_APPLY_THREADS;
+
+  ASSERT_EQ(num_docs / 2, (get_spec(ism))->stats.numRecords);
+  RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, get_spec(ism));
+  RedisModuleString *keyName = IndexSpec_GetFormattedKeyByName(sctx.spec, "f1", INDEXFLD_T_TAG);
+  TagIndex *tagIdx = TagIndex_Open(sctx.spec, keyName, DONT_CREATE_INDEX);
+  for (size_t i = 0; i < num_docs; i++) {
+    std::string val = "v" + std::to_string(i);
+    size_t sz;
+    InvertedIndex *iv = TagIndex_OpenIndex(tagIdx, val.c_str(), val.size(), DONT_CREATE_INDEX, &sz);
+    if (i % 2) {
+      ASSERT_TRUE(iv == TRIEMAP_NOTFOUND || iv == NULL) << "value " << val;
+    } else {
+      ASSERT_TRUE(iv != TRIEMAP_NOTFOUND && iv != NULL) << "value " << val;
+      ASSERT_EQ(1, InvertedIndex_NumDocs(iv));
+    }
+  }
+}
+
 /**
  * Modify the last block, but don't delete it entirely. While the fork is running,
  * fill up the last block and add more blocks.
@@ -81,7 +81,7 @@ struct MockUpstream : public ResultProcessor {
       for (size_t i = 0; i < docIds.size(); i++) {
         size_t entryIndex = depletionCount + i;
 
-        documentMetadata[entryIndex] = static_cast<RSDocumentMetadata*>(rm_calloc(1, sizeof(RSDocumentMetadata)));
+        documentMetadata[entryIndex] = DMD_Alloc();
         DMD_Incref(documentMetadata[entryIndex]);
 
         std::string str = "doc" + std::to_string(docIds[i]);
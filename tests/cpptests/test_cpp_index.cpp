@@ -47,6 +47,7 @@ extern "C" {
 #include <random>
 #include <chrono>
 #include <iostream>
+#include <string>
 
 class IndexTest : public ::testing::Test {};
 
@@ -147,6 +148,50 @@ TEST_F(IndexTest, testDistance) {
   } while (rc != RS_OFFSETVECTOR_EOF);
   it.Free(it.ctx);
 
+  // Offsets of aggregate children are read through their offset iterator
+  RSIndexResult *un = NewUnionResult(2, 1);
+  AggregateResult_AddChild(un, tr2);
+  AggregateResult_AddChild(un, tr3);
+  RSIndexResult *nested = NewIntersectResult(2, 1);
+  AggregateResult_AddChild(nested, tr1);
+  AggregateResult_AddChild(nested, un);
+  ASSERT_EQ(2, IndexResult_MinOffsetDelta(nested));
+  // tr1 {1, 9, 13, 16, 22} against the merged {4, 7, 20, 25, 32}
+  ASSERT_EQ(0, IndexResult_IsWithinRange(nested, 0, 0));
+  ASSERT_EQ(1, IndexResult_IsWithinRange(nested, 1, 0));
+  ASSERT_EQ(0, IndexResult_IsWithinRange(nested, 1, 1));
+  ASSERT_EQ(1, IndexResult_IsWithinRange(nested, 2, 1));
+
+  // The offsets are decoded in order, and only partly if they don't fit
+  uint32_t decoded[10];
+  ASSERT_EQ(10, RSIndexResult_DecodeOffsets(res, decoded, 10));
+  for (int j = 0; j < 10; j++) {
+    ASSERT_EQ(expected[j], decoded[j]);
+  }
+  ASSERT_EQ(5, RSIndexResult_DecodeOffsets(tr1, decoded, 2));
+  ASSERT_EQ(1, decoded[0]);
+  ASSERT_EQ(9, decoded[1]);
+
+  // Offsets too far apart for the slop, with multi-byte varints
+  VarintVectorWriter *vw4 = NewVarintVectorWriter(8);
+  VVW_Write(vw4, 20000);
+  VVW_Truncate(vw4);
+  RSIndexResult *tr4 = NewTokenRecord(NULL, 1);
+  tr4->docId = 1;
+  *IndexResult_TermOffsetsRefMut(tr4) = offsetsFromVVW(vw4);
+  RSIndexResult *far = NewIntersectResult(2, 1);
+  AggregateResult_AddChild(far, tr1);
+  AggregateResult_AddChild(far, tr4);
+  ASSERT_EQ(0, IndexResult_IsWithinRange(far, 100, 0));
+  ASSERT_EQ(0, IndexResult_IsWithinRange(far, 100, 1));
+  ASSERT_EQ(1, IndexResult_IsWithinRange(far, 20000 - 22 - 1, 1));
+  ASSERT_EQ(0, IndexResult_IsWithinRange(far, 20000 - 22 - 2, 0));
+  IndexResult_Free(far);
+  IndexResult_Free(tr4);
+  VVW_Free(vw4);
+
+  IndexResult_Free(nested);
+  IndexResult_Free(un);
   IndexResult_Free(tr1);
   IndexResult_Free(tr2);
   IndexResult_Free(tr3);
@@ -1287,7 +1332,7 @@ TEST_F(IndexTest, testDocTable) {
   ASSERT_EQ(N + 1, dt.size);
   ASSERT_EQ(N, dt.maxDocId);
 #ifdef __x86_64__
-  ASSERT_EQ(10180 + doc_table_size, (int)dt.memsize);
+  ASSERT_EQ(9380 + doc_table_size, (int)dt.memsize);
 #endif
   for (int i = 0; i < N; i++) {
     snprintf(buf, sizeof(buf), "doc_%d", i);
@@ -1340,6 +1385,84 @@ TEST_F(IndexTest, testDocTable) {
   DocTable_Free(&dt);
 }
 
+TEST_F(IndexTest, testDocTableChains) {
+  char buf[16];
+  // With a max size of 4, ids 1, 5 and 9 share the same bucket
+  DocTable dt = NewDocTable(4, 4);
+  int N = 12;
+  for (int i = 0; i < N; i++) {
+    size_t nkey = snprintf(buf, sizeof(buf), "doc_%d", i);
+    DMD_Return(DocTable_Put(&dt, buf, nkey, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash));
+  }
+  ASSERT_EQ(4, dt.cap);
+
+  // Delete the documents from the middle, the head and the tail of a chain
+  for (int i : {4, 8, 0}) {
+    size_t nkey = snprintf(buf, sizeof(buf), "doc_%d", i);
+    ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+  }
+  for (int i = 0; i < N; i++) {
+    t_docId id = i + 1;
+    bool deleted = i == 0 || i == 4 || i == 8;
+    ASSERT_EQ(!deleted, DocTable_Exists(&dt, id)) << id;
+    const RSDocumentMetadata *dmd = DocTable_Borrow(&dt, id);
+    if (deleted) {
+      ASSERT_FALSE(dmd);
+      continue;
+    }
+    ASSERT_TRUE(dmd);
+    ASSERT_EQ(id, dmd->id);
+    DMD_Return(dmd);
+  }
+
+  size_t count = 0;
+  DOCTABLE_FOREACH((&dt), count++);
+  ASSERT_EQ(N - 3, count);
+  DocTable_Free(&dt);
+}
+
+TEST_F(IndexTest, testDocTableSortingColumns) {
+  char buf[16];
+  DocTable dt = NewDocTable(10, 2000);
+  int N = 1500;
+  for (int i = 0; i < N; i++) {
+    size_t nkey = snprintf(buf, sizeof(buf), "doc_%d", i);
+    RSDocumentMetadata *dmd = DocTable_Put(&dt, buf, nkey, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash);
+    // A number, a string, and a number only in the even documents
+    RSSortingVector *sv = NewSortingVector(3);
+    RSSortingVector_PutNum(sv, 0, i);
+    RSSortingVector_PutStr(sv, 1, rm_strdup("str"));
+    if (i % 2 == 0) {
+      RSSortingVector_PutNum(sv, 2, -i);
+    }
+    DocTable_SetSortingVector(&dt, dmd, sv);
+    DMD_Return(dmd);
+  }
+  ASSERT_GT(RSSortingColumns_MemUsage(&dt.sortingColumns), 2 * N * sizeof(double));
+
+  for (int i = 0; i < N; i++) {
+    t_docId id = i + 1;
+    ASSERT_EQ(i, DocTable_GetSortingNumber(&dt, 0, id)) << id;
+    ASSERT_TRUE(isnan(DocTable_GetSortingNumber(&dt, 1, id))) << id;
+    if (i % 2 == 0) {
+      ASSERT_EQ(-i, DocTable_GetSortingNumber(&dt, 2, id)) << id;
+    } else {
+      ASSERT_TRUE(isnan(DocTable_GetSortingNumber(&dt, 2, id))) << id;
+    }
+  }
+  ASSERT_TRUE(isnan(DocTable_GetSortingNumber(&dt, 3, 1)));
+  ASSERT_TRUE(isnan(DocTable_GetSortingNumber(&dt, 0, N + 1)));
+
+  // The numbers of a deleted document are removed
+  size_t nkey = snprintf(buf, sizeof(buf), "doc_%d", 0);
+  ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+  ASSERT_TRUE(isnan(DocTable_GetSortingNumber(&dt, 0, 1)));
+  ASSERT_TRUE(isnan(DocTable_GetSortingNumber(&dt, 2, 1)));
+  ASSERT_EQ(1, DocTable_GetSortingNumber(&dt, 0, 2));
+
+  DocTable_Free(&dt);
+}
+
 TEST_F(IndexTest, testVarintFieldMask) {
   t_fieldMask x = 127;
   size_t expected[] = {0, 2, 1, 1, 2, 0, 2, 0, 2, 3, 0, 0, 3, 0, 0, 4};
@@ -1448,7 +1571,275 @@ TEST_F(IndexTest, testRawDocId) {
   RSGlobalConfig.invertedIndexRawDocidEncoding = previousConfig;
 }
 
+// The number of entries of the first blocks of a document ids only index
+#define DOCIDS_BLOCK_SIZE 1000
+// A sealed block is stored as a bitmap if it has at least one of every this many consecutive ids
+#define DENSE_BLOCK_MAX_GAP 8
+
+static void checkDenseBlocks(t_docId step, bool expectDense) {
+  size_t index_memsize = 0;
+  InvertedIndex *idx = NewInvertedIndex(Index_DocIdsOnly, &index_memsize);
+  const t_docId maxId = 3 * DOCIDS_BLOCK_SIZE * step;
+  for (t_docId id = step; id <= maxId; id += step) {
+    RSIndexResult rec = {.docId = id, .data = {.tag = RSResultData_Virtual}};
+    InvertedIndex_WriteEntryGeneric(idx, &rec);
+  }
+  RSIndexResult rec = {.docId = maxId + 1, .data = {.tag = RSResultData_Virtual}};
+  InvertedIndex_WriteEntryGeneric(idx, &rec);
+
+  // All the full blocks are sealed, the last one is still being written to
+  ASSERT_EQ(4, InvertedIndex_NumBlocks(idx));
+  for (size_t i = 0; i < 3; i++) {
+    const IndexBlock *blk = InvertedIndex_BlockRef(idx, i);
+    ASSERT_EQ(expectDense, IndexBlock_IsDense(blk)) << "block " << i;
+    // The bitmap is written in place, the block keeps the memory it was allocated
+    ASSERT_LE(IndexBlock_Len(blk), IndexBlock_Cap(blk)) << "block " << i;
+    if (expectDense) {
+      ASSERT_EQ((IndexBlock_LastId(blk) - IndexBlock_FirstId(blk) / 64 * 64) / 64 * 8 + 8,
+                IndexBlock_Len(blk)) << "block " << i;
+    }
+  }
+  ASSERT_FALSE(IndexBlock_IsDense(InvertedIndex_BlockRef(idx, 3)));
+
+  FieldMaskOrIndex f = {.isFieldMask = true, .value = {.mask = RS_FIELDMASK_ALL}};
+  QueryIterator *ir = NewInvIndIterator_TermQuery(idx, nullptr, f, nullptr, 1);
+  for (t_docId id = step; id <= maxId; id += step) {
+    ASSERT_EQ(ITERATOR_OK, ir->Read(ir));
+    ASSERT_EQ(id, ir->lastDocId);
+  }
+  ASSERT_EQ(ITERATOR_OK, ir->Read(ir));
+  ASSERT_EQ(maxId + 1, ir->lastDocId);
+  ASSERT_EQ(ITERATOR_EOF, ir->Read(ir));
+
+  // Skip to every id, from the start and from the previous one
+  ir->Rewind(ir);
+  for (t_docId id = 1; id <= maxId; id++) {
+    IteratorStatus rc = ir->SkipTo(ir, id);
+    t_docId expected = (id + step - 1) / step * step;
+    ASSERT_EQ(id == expected ? ITERATOR_OK : ITERATOR_NOTFOUND, rc) << "id " << id;
+    ASSERT_EQ(expected, ir->lastDocId);
+    id = expected;
+  }
+  for (t_docId id = 1; id <= maxId; id += 7 * step + 3) {
+    ir->Rewind(ir);
+    ir->SkipTo(ir, id);
+    ASSERT_EQ((id + step - 1) / step * step, ir->lastDocId);
+  }
+
+  ir->Free(ir);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testDenseBlocks) {
+  const int previousConfig = RSGlobalConfig.invertedIndexRawDocidEncoding;
+  for (int raw = 0; raw <= 1; raw++) {
+    RSGlobalConfig.invertedIndexRawDocidEncoding = raw;
+    checkDenseBlocks(1, true);
+    checkDenseBlocks(3, true);
+    checkDenseBlocks(DENSE_BLOCK_MAX_GAP - 1, true);
+    checkDenseBlocks(DENSE_BLOCK_MAX_GAP + 1, false);
+  }
+  RSGlobalConfig.invertedIndexRawDocidEncoding = previousConfig;
+}
+
+// The number of entries of the first blocks of a numeric index
+#define NUMERIC_BLOCK_SIZE 100
+
+// Write the values to consecutive ids, `step` apart, and pack all the sealed blocks
+static InvertedIndex *writePackedNumeric(const std::vector<double> &values, t_docId step, size_t *saved) {
+  size_t index_memsize = 0;
+  InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, &index_memsize);
+  for (size_t i = 0; i < values.size(); i++) {
+    InvertedIndex_WriteNumericEntry(idx, (i + 1) * step, values[i]);
+  }
+  const unsigned long memUsage = InvertedIndex_MemUsage(idx);
+  const uint32_t numBlocks = InvertedIndex_NumBlocks(idx);
+  *saved = 0;
+  for (uint32_t b = 0; b + 1 < numBlocks; b++) {
+    *saved += InvertedIndex_PackNumericBlock(idx, b);
+  }
+  EXPECT_EQ(memUsage - *saved, InvertedIndex_MemUsage(idx));
+  // The block being written to is never packed
+  EXPECT_FALSE(IndexBlock_IsPacked(InvertedIndex_BlockRef(idx, numBlocks - 1)));
+  return idx;
+}
+
+static void checkPackedNumeric(const std::vector<double> &values, t_docId step, bool expectPacked) {
+  size_t saved;
+  InvertedIndex *idx = writePackedNumeric(values, step, &saved);
+  ASSERT_EQ(expectPacked, saved > 0);
+  for (uint32_t b = 0; b + 1 < InvertedIndex_NumBlocks(idx); b++) {
+    ASSERT_EQ(expectPacked, IndexBlock_IsPacked(InvertedIndex_BlockRef(idx, b))) << "block " << b;
+  }
+
+  FieldMaskOrIndex fieldMaskOrIndex = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}};
+  FieldFilterContext fieldCtx = {.field = fieldMaskOrIndex, .predicate = FIELD_EXPIRATION_DEFAULT};
+  QueryIterator *it = NewInvIndIterator_NumericQuery(idx, nullptr, &fieldCtx, nullptr, nullptr, -INFINITY, INFINITY);
+  for (size_t i = 0; i < values.size(); i++) {
+    ASSERT_EQ(ITERATOR_OK, it->Read(it)) << "i=" << i;
+    ASSERT_EQ((i + 1) * step, it->lastDocId);
+    // Packing is lossless
+    ASSERT_EQ(values[i], IndexResult_NumValue(it->current)) << "i=" << i;
+  }
+  ASSERT_EQ(ITERATOR_EOF, it->Read(it));
+
+  if (step > 1) {
+    it->Rewind(it);
+    for (size_t i = 0; i < values.size(); i += 37) {
+      ASSERT_EQ(ITERATOR_NOTFOUND, it->SkipTo(it, i * step + 1)) << "i=" << i;
+      ASSERT_EQ((i + 1) * step, it->lastDocId);
+      ASSERT_EQ(values[i], IndexResult_NumValue(it->current));
+    }
+  }
+
+  it->Free(it);
+  InvertedIndex_Free(idx);
+}
+
+TEST_F(IndexTest, testPackedNumericBlocks) {
+  const size_t n = 10 * NUMERIC_BLOCK_SIZE + 5;
+  std::vector<double> timestamps, prices, quarters, fractions;
+  for (size_t i = 0; i < n; i++) {
+    timestamps.push_back(1700000000000.0 + i * 1000 + i % 7);
+    prices.push_back((i * 7919 % 100000) / 100.0);
+    quarters.push_back((i % 50) / 4.0 - 5);
+    fractions.push_back(i / 3.0);
+  }
+  for (t_docId step : {1, 7}) {
+    checkPackedNumeric(timestamps, step, true);
+    checkPackedNumeric(prices, step, true);
+    checkPackedNumeric(quarters, step, true);
+    checkPackedNumeric(fractions, step, false);
+  }
+}
+
+static void writeGcDelta(void *ctx, const void *buf, c_size_t len) {
+  static_cast<std::string *>(ctx)->append(static_cast<const char *>(buf), len);
+}
+
+static int readGcDelta(void *ctx, void *buf, c_size_t len) {
+  auto *delta = static_cast<std::pair<std::string, size_t> *>(ctx);
+  if (delta->second + len > delta->first.size()) {
+    return 1;
+  }
+  memcpy(buf, delta->first.data() + delta->second, len);
+  delta->second += len;
+  return 0;
+}
+
+static void noGcHeader(void *) {}
+
+TEST_F(IndexTest, testPackedNumericRepair) {
+  const size_t n = 2 * NUMERIC_BLOCK_SIZE + 1;
+  std::vector<double> timestamps;
+  DocTable dt = NewDocTable(10, n);
+  char buf[16];
+  for (size_t i = 0; i < n; i++) {
+    timestamps.push_back(1700000000000.0 + i * 1000 + i % 7);
+    size_t nkey = snprintf(buf, sizeof(buf), "doc_%zu", i);
+    DMD_Return(DocTable_Put(&dt, buf, nkey, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash));
+  }
+  // Delete every third document of the first block, starting from the first one
+  for (size_t i = 0; i < NUMERIC_BLOCK_SIZE; i += 3) {
+    size_t nkey = snprintf(buf, sizeof(buf), "doc_%zu", i);
+    ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+  }
+
+  size_t saved;
+  InvertedIndex *idx = writePackedNumeric(timestamps, 1, &saved);
+  ASSERT_TRUE(IndexBlock_IsPacked(InvertedIndex_BlockRef(idx, 0)));
+  const size_t memUsage = InvertedIndex_MemUsage(idx);
+
+  // Scan and apply the GC delta in-process, through a buffer instead of the fork GC pipe
+  IndexSpec spec = {};
+  spec.docs = dt;
+  RedisSearchCtx sctx = {};
+  sctx.spec = &spec;
+  std::pair<std::string, size_t> delta;
+  II_GCWriter wr = {.ctx = &delta.first, .write = writeGcDelta};
+  II_GCCallback cb = {.ctx = nullptr, .call = noGcHeader};
+  ASSERT_TRUE(InvertedIndex_GcDelta_Scan(&wr, &sctx, idx, &cb, nullptr));
+  II_GCReader rd = {.ctx = &delta, .read = readGcDelta};
+  InvertedIndexGcDelta *deltas = InvertedIndex_GcDelta_Read(&rd);
+  ASSERT_NE(nullptr, deltas);
+  II_GCScanStats stats = {0};
+  InvertedIndex_ApplyGcDelta(idx, deltas, &stats);
+
+  // The remaining entries are packed again, which never grows the block
+  const size_t deleted = (NUMERIC_BLOCK_SIZE + 2) / 3;
+  const IndexBlock *blk = InvertedIndex_BlockRef(idx, 0);
+  ASSERT_TRUE(IndexBlock_IsPacked(blk));
+  ASSERT_GT(stats.bytes_freed, stats.bytes_allocated);
+  ASSERT_EQ(memUsage - stats.bytes_freed + stats.bytes_allocated, InvertedIndex_MemUsage(idx));
+  ASSERT_EQ(deleted, stats.entries_removed);
+  ASSERT_EQ(2, IndexBlock_FirstId(blk));
+  ASSERT_EQ(NUMERIC_BLOCK_SIZE - deleted, IndexBlock_NumEntries(blk));
+
+  IndexDecoderCtx decoderCtx = {.tag = IndexDecoderCtx_None};
+  IndexReader *reader = NewIndexReader(idx, decoderCtx);
+  RSIndexResult *res = NewNumericResult();
+  for (size_t i = 1; i < NUMERIC_BLOCK_SIZE; i++) {
+    if (i % 3 == 0) {
+      continue;
+    }
+    ASSERT_TRUE(IndexReader_Next(reader, res));
+    ASSERT_EQ(i + 1, res->docId);
+    ASSERT_EQ(timestamps[i], IndexResult_NumValue(res));
+  }
+  // Then the second block
+  ASSERT_TRUE(IndexReader_Next(reader, res));
+  ASSERT_EQ(NUMERIC_BLOCK_SIZE + 1, res->docId);
+
+  IndexResult_Free(res);
+  IndexReader_Free(reader);
+  InvertedIndex_Free(idx);
+  DocTable_Free(&dt);
+}
+
 // Test HybridIteratorReducer optimization with NULL child iterator
+TEST_F(IndexTest, testTakeRestoreBlocks) {
+  size_t index_memsize = 0;
+  InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, &index_memsize);
+  for (size_t i = 1; i <= 1000; i++) {
+    InvertedIndex_WriteNumericEntry(idx, i * 3, (double)i / 7);
+  }
+  const uint32_t numBlocks = InvertedIndex_NumBlocks(idx);
+  const uint32_t gcMarker = InvertedIndex_GcMarker(idx);
+  ASSERT_GT(numBlocks, 1);
+
+  Buffer buf;
+  Buffer_Init(&buf, 16);
+  size_t freed = InvertedIndex_TakeBlocks(idx, &buf);
+  ASSERT_GT(freed, buf.offset);
+  ASSERT_EQ(0, InvertedIndex_NumBlocks(idx));
+  // The paused readers must seek their position again
+  ASSERT_NE(gcMarker, InvertedIndex_GcMarker(idx));
+  // The counters stay
+  ASSERT_EQ(1000, InvertedIndex_NumDocs(idx));
+
+  // A truncated buffer holds no complete block
+  ASSERT_EQ(0, InvertedIndex_RestoreBlocks(idx, buf.data, 8));
+  ASSERT_GT(InvertedIndex_RestoreBlocks(idx, buf.data, buf.offset), 0);
+  ASSERT_EQ(numBlocks, InvertedIndex_NumBlocks(idx));
+  Buffer_Free(&buf);
+
+  FieldMaskOrIndex fieldMaskOrIndex = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}};
+  FieldFilterContext fieldCtx = {.field = fieldMaskOrIndex, .predicate = FIELD_EXPIRATION_DEFAULT};
+  QueryIterator *it = NewInvIndIterator_NumericQuery(idx, nullptr, &fieldCtx, nullptr, nullptr, -INFINITY, INFINITY);
+  for (size_t i = 1; i <= 1000; i++) {
+    ASSERT_EQ(ITERATOR_OK, it->Read(it)) << "i=" << i;
+    ASSERT_EQ(i * 3, it->lastDocId);
+    ASSERT_EQ((double)i / 7, IndexResult_NumValue(it->current));
+  }
+  ASSERT_EQ(ITERATOR_EOF, it->Read(it));
+  it->Free(it);
+
+  // The restored index is written to as before
+  InvertedIndex_WriteNumericEntry(idx, 3003, 1);
+  ASSERT_EQ(1001, InvertedIndex_NumDocs(idx));
+  InvertedIndex_Free(idx);
+}
+
 TEST_F(IndexTest, testHybridIteratorReducerWithEmptyChild) {
   // Create hybrid params with NULL child iterator
   size_t n = 100;
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "gtest/gtest.h"
+#include "redismock/redismock.h"
+#include "redismock/util.h"
+#include "common.h"
+#include "index_delta.h"
+#include "forward_index.h"
+#include "spec.h"
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// The forward index of a preprocessed document, and its byte offsets
+struct ForwardIndexContent {
+  std::map<std::string, std::tuple<uint32_t, t_fieldMask, std::string>> terms;
+  uint32_t maxFreq = 0, totalFreq = 0;
+  std::vector<std::tuple<uint16_t, uint32_t, uint32_t>> fields;
+  std::string byteOffsets;
+
+  explicit ForwardIndexContent(const RSAddDocumentCtx *aCtx) {
+    ForwardIndexIterator it = ForwardIndex_Iterate(aCtx->fwIdx);
+    for (ForwardIndexEntry *entry; (entry = ForwardIndexIterator_Next(&it));) {
+      terms[std::string(entry->term, entry->len)] = {
+          entry->freq, entry->fieldMask,
+          std::string((const char *)VVW_GetByteData(entry->vw), VVW_GetByteLength(entry->vw))};
+    }
+    maxFreq = aCtx->fwIdx->maxFreq;
+    totalFreq = aCtx->fwIdx->totalFreq;
+    for (size_t i = 0; aCtx->byteOffsets && i < aCtx->byteOffsets->numFields; i++) {
+      const RSByteOffsetField &f = aCtx->byteOffsets->fields[i];
+      fields.emplace_back(f.fieldId, f.firstTokPos, f.lastTokPos);
+    }
+    const VarintVectorWriter *vw = aCtx->offsetsWriter.vw;
+    byteOffsets = std::string((const char *)VVW_GetByteData(vw), VVW_GetByteLength(vw));
+  }
+
+  bool operator==(const ForwardIndexContent &other) const {
+    return std::tie(terms, maxFreq, totalFreq, fields, byteOffsets) ==
+           std::tie(other.terms, other.maxFreq, other.totalFreq, other.fields, other.byteOffsets);
+  }
+};
+
+class IndexDeltaTest : public ::testing::Test {
+ protected:
+  RedisModuleCtx *ctx;
+  IndexSpec *spec;
+  std::vector<RedisModuleString *> strings;
+
+  void SetUp() override {
+    ctx = RedisModule_GetThreadSafeContext(NULL);
+    spec = RS::createIndex(ctx, "idx", "ON", "HASH", "SCHEMA", "title", "TEXT", "WEIGHT", "2",
+                           "body", "TEXT", "n", "NUMERIC", "SORTABLE");
+  }
+
+  void TearDown() override {
+    for (RedisModuleString *s : strings) {
+      RedisModule_FreeString(ctx, s);
+    }
+    IndexSpec_RemoveFromGlobals(spec->own_ref, false);
+    RedisModule_FreeThreadSafeContext(ctx);
+  }
+
+  RedisModuleString *str(const std::string &s) {
+    strings.push_back(RedisModule_CreateString(ctx, s.data(), s.size()));
+    return strings.back();
+  }
+
+  // Preprocesses a document of the given title and body, with the delta given if any
+  RSAddDocumentCtx *preprocess(Document *doc, const char *title, const char *body,
+                               RedisModuleString *delta = nullptr) {
+    Document_Init(doc, str("doc1"), 1, DEFAULT_LANGUAGE, DocumentType_Hash);
+    Document_AddField(doc, "title", str(title), 0);
+    Document_AddField(doc, "body", str(body), 0);
+    Document_AddField(doc, "n", str("42"), 0);
+    QueryError status = QueryError_Default();
+    RSAddDocumentCtx *aCtx = NewAddDocumentCtx(spec, doc, &status);
+    EXPECT_NE(aCtx, nullptr) << QueryError_GetUserError(&status);
+    aCtx->stateFlags |= ACTX_F_NOFREEDOC;
+    aCtx->indexDelta = delta;
+    RedisSearchCtx sctx = SEARCH_CTX_STATIC(ctx, spec);
+    AddDocumentCtx_Preprocess(aCtx, &sctx);
+    EXPECT_EQ(aCtx->failedField, nullptr);
+    return aCtx;
+  }
+
+  RedisModuleString *writeDelta(const RSAddDocumentCtx *aCtx) {
+    Buffer buf = {0};
+    Buffer_Init(&buf, 16);
+    IndexDelta_Write(aCtx, &buf);
+    RedisModuleString *ret = str(std::string(buf.data, buf.offset));
+    Buffer_Free(&buf);
+    return ret;
+  }
+};
+
+TEST_F(IndexDeltaTest, testRoundTrip) {
+  const char *title = "Hello World", *body = "the running foxes, and the running dogs";
+  Document doc = {0};
+  RSAddDocumentCtx *aCtx = preprocess(&doc, title, body);
+  ASSERT_FALSE(aCtx->fromDelta);
+  const ForwardIndexContent expected(aCtx);
+  ASSERT_GT(expected.terms.size(), 4);
+  ASSERT_EQ(expected.fields.size(), 2);
+  RedisModuleString *delta = writeDelta(aCtx);
+  AddDocumentCtx_Free(aCtx);
+  Document_Free(&doc);
+
+  aCtx = preprocess(&doc, title, body, delta);
+  ASSERT_TRUE(aCtx->fromDelta);
+  ASSERT_TRUE(ForwardIndexContent(aCtx) == expected);
+  // The sortables are still filled from the document
+  ASSERT_NE(aCtx->sv, nullptr);
+  AddDocumentCtx_Free(aCtx);
+  Document_Free(&doc);
+}
+
+TEST_F(IndexDeltaTest, testOtherContent) {
+  Document doc = {0};
+  RSAddDocumentCtx *aCtx = preprocess(&doc, "hello world", "first body");
+  RedisModuleString *delta = writeDelta(aCtx);
+  AddDocumentCtx_Free(aCtx);
+  Document_Free(&doc);
+
+  // The delta of another content is not used, and the document is tokenized instead
+  aCtx = preprocess(&doc, "hello world", "second body");
+  const ForwardIndexContent expected(aCtx);
+  AddDocumentCtx_Free(aCtx);
+  Document_Free(&doc);
+  aCtx = preprocess(&doc, "hello world", "second body", delta);
+  ASSERT_FALSE(aCtx->fromDelta);
+  ASSERT_TRUE(ForwardIndexContent(aCtx) == expected);
+  AddDocumentCtx_Free(aCtx);
+  Document_Free(&doc);
+
+  // As is a truncated delta
+  size_t len;
+  const char *data = RedisModule_StringPtrLen(delta, &len);
+  aCtx = preprocess(&doc, "hello world", "first body", str(std::string(data, len - 1)));
+  ASSERT_FALSE(aCtx->fromDelta);
+  ASSERT_FALSE(ForwardIndexContent(aCtx).terms.empty());
+  AddDocumentCtx_Free(aCtx);
+  Document_Free(&doc);
+}
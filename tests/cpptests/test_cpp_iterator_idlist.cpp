@@ -63,6 +63,25 @@ TEST_P(IDListIteratorCommonTest, Read) {
   ASSERT_EQ(i, docIds.size()) << "Expected to read " << docIds.size() << " documents";
 }
 
+TEST_P(IDListIteratorCommonTest, ReadBatch) {
+  t_docId ids[7];
+  size_t n, i = 0;
+  IteratorStatus rc;
+  while ((rc = iterator_base->ReadBatch(iterator_base, ids, 7, &n)) == ITERATOR_OK) {
+    ASSERT_GT(n, 0);
+    ASSERT_LE(n, 7);
+    for (size_t j = 0; j < n; j++) {
+      ASSERT_EQ(ids[j], docIds[i++]);
+    }
+    ASSERT_EQ(iterator_base->lastDocId, ids[n - 1]);
+    ASSERT_EQ(iterator_base->current->docId, ids[n - 1]);
+  }
+  ASSERT_EQ(rc, ITERATOR_EOF);
+  ASSERT_EQ(n, 0);
+  ASSERT_TRUE(iterator_base->atEOF);
+  ASSERT_EQ(i, docIds.size()) << "Expected to read " << docIds.size() << " documents";
+}
+
 TEST_P(IDListIteratorCommonTest, SkipTo) {
   IdListIterator *iterator = (IdListIterator *)iterator_base;
   IteratorStatus rc;
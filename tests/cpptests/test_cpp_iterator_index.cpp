@@ -148,6 +148,24 @@ TEST_P(IndexIteratorTest, Read) {
     ASSERT_EQ(it_base->NumEstimated(it_base), InvertedIndex_NumDocs(idx));
 }
 
+TEST_P(IndexIteratorTest, ReadBatch) {
+    IteratorStatus rc;
+    t_docId ids[100];
+    size_t n, i = 0;
+    while ((rc = it_base->ReadBatch(it_base, ids, 100, &n)) == ITERATOR_OK) {
+        ASSERT_GT(n, 0);
+        for (size_t j = 0; j < n; j++) {
+            ASSERT_EQ(ids[j], resultSet[i++]);
+        }
+        ASSERT_EQ(it_base->lastDocId, ids[n - 1]);
+        ASSERT_EQ(it_base->current->docId, ids[n - 1]);
+    }
+    ASSERT_EQ(rc, ITERATOR_EOF);
+    ASSERT_EQ(n, 0);
+    ASSERT_TRUE(it_base->atEOF);
+    ASSERT_EQ(i, resultSet.size()) << "Expected to read " << resultSet.size() << " documents";
+}
+
 TEST_P(IndexIteratorTest, SkipTo) {
     InvIndIterator *it = (InvIndIterator *)it_base;
     IteratorStatus rc;
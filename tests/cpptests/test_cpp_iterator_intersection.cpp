@@ -87,6 +87,23 @@ TEST_P(IntersectionIteratorCommonTest, Read) {
   ASSERT_EQ(ii_base->NumEstimated(ii_base), expected);
 }
 
+TEST_P(IntersectionIteratorCommonTest, ReadBatch) {
+  IteratorStatus rc;
+  t_docId ids[4];
+  size_t n, i = 0;
+  while ((rc = ii_base->ReadBatch(ii_base, ids, 4, &n)) == ITERATOR_OK) {
+    ASSERT_GT(n, 0);
+    for (size_t j = 0; j < n; j++) {
+      ASSERT_EQ(ids[j], resultSet[i++]);
+    }
+    ASSERT_EQ(ii_base->lastDocId, ids[n - 1]);
+  }
+  ASSERT_EQ(rc, ITERATOR_EOF);
+  ASSERT_EQ(n, 0);
+  ASSERT_TRUE(ii_base->atEOF);
+  ASSERT_EQ(i, resultSet.size()) << "Expected to read " << resultSet.size() << " documents";
+}
+
 TEST_P(IntersectionIteratorCommonTest, SkipTo) {
   IntersectionIterator *ii = (IntersectionIterator *)ii_base;
   IteratorStatus rc;
@@ -363,6 +380,42 @@ TEST_F(IntersectionIteratorTest, SlopAndOrder) {
 }
 
 
+TEST_F(IntersectionIteratorTest, AdaptiveOrder) {
+  // The dense child is estimated to be the smallest one, as all its ids are at the beginning of
+  // the range. There, the sparse child rejects almost all of its ids, and should lead instead
+  std::vector<t_docId> dense, sparse;
+  for (t_docId id = 1; id <= 5000; id++) {
+    dense.push_back(id);
+  }
+  for (t_docId id = 100; id <= 1000000; id += 100) {
+    sparse.push_back(id);
+  }
+  auto denseChild = new MockIterator(dense);
+  auto sparseChild = new MockIterator(sparse);
+  auto children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * 2);
+  children[0] = reinterpret_cast<QueryIterator *>(sparseChild);
+  children[1] = reinterpret_cast<QueryIterator *>(denseChild);
+  QueryIterator *ii_base = NewIntersectionIterator(children, 2, -1, false, 1.0);
+  IntersectionIterator *ii = (IntersectionIterator *)ii_base;
+  ASSERT_EQ(ii->its[0], reinterpret_cast<QueryIterator *>(denseChild));
+
+  t_docId expected = 100;
+  while (ii_base->Read(ii_base) == ITERATOR_OK) {
+    ASSERT_EQ(ii_base->lastDocId, expected);
+    // The result children keep the order of the estimations
+    const RSAggregateResult *agg = IndexResult_AggregateRef(ii_base->current);
+    ASSERT_EQ(AggregateResult_GetUnchecked(agg, 0), denseChild->base.current);
+    expected += 100;
+  }
+  ASSERT_EQ(expected, 5000 + 100);
+  ASSERT_TRUE(ii_base->atEOF);
+
+  // The sparse child took the lead early on, so most of the dense ids were skipped over
+  ASSERT_EQ(ii->its[ii->order[0]], reinterpret_cast<QueryIterator *>(sparseChild));
+  ASSERT_LT(denseChild->readCount, 1000);
+  ii_base->Free(ii_base);
+}
+
 class IntersectionIteratorReducerTest : public ::testing::Test {};
 
 TEST_F(IntersectionIteratorReducerTest, TestIntersectionWithEmptyChild) {
@@ -660,3 +713,99 @@ TEST_F(IntersectionIteratorRevalidateTest, RevalidateSomeChildrenMovedToEOF) {
   ASSERT_EQ(ii_base->Read(ii_base), ITERATOR_EOF);
   ASSERT_EQ(ii_base->SkipTo(ii_base, 100), ITERATOR_EOF);
 }
+
+class IntersectionIteratorBlocksTest : public ::testing::Test {
+protected:
+  std::vector<InvertedIndex *> indexes;
+
+  InvertedIndex *createIndex(t_docId step, t_docId maxId) {
+    size_t memsize;
+    InvertedIndex *idx = NewInvertedIndex(static_cast<IndexFlags>(INDEX_DEFAULT_FLAGS), &memsize);
+    for (t_docId i = step; i <= maxId; i += step) {
+      auto res = (RSIndexResult) {
+        .docId = i,
+        .fieldMask = 1,
+        .freq = 1,
+        .data = {.term_tag = RSResultData_Tag::RSResultData_Term},
+      };
+      InvertedIndex_WriteEntryGeneric(idx, &res);
+    }
+    indexes.push_back(idx);
+    return idx;
+  }
+
+  // Intersection of term iterators over indexes holding the multiples of each step
+  QueryIterator *createIntersection(std::vector<t_docId> steps, t_docId maxId) {
+    QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * steps.size());
+    for (size_t i = 0; i < steps.size(); i++) {
+      children[i] = NewInvIndIterator_TermQuery(createIndex(steps[i], maxId), nullptr,
+                                                {.isFieldMask = true, .value = {.mask = RS_FIELDMASK_ALL}}, nullptr, 1.0);
+    }
+    return NewIntersectionIterator(children, steps.size(), -1, false, 1.0);
+  }
+
+  void TearDown() override {
+    for (auto idx : indexes) {
+      InvertedIndex_Free(idx);
+    }
+  }
+};
+
+TEST_F(IntersectionIteratorBlocksTest, Read) {
+  // Steps with a ratio small enough for block reads, and co-prime so there are few common ids
+  QueryIterator *ii_base = createIntersection({2, 3, 5}, 30000);
+  t_docId expected = 30;
+  while (ii_base->Read(ii_base) == ITERATOR_OK) {
+    ASSERT_EQ(ii_base->lastDocId, expected);
+    ASSERT_EQ(ii_base->current->docId, expected);
+    expected += 30;
+  }
+  ASSERT_EQ(expected, 30000 + 30);
+  ASSERT_TRUE(ii_base->atEOF);
+  ASSERT_EQ(ii_base->Read(ii_base), ITERATOR_EOF);
+
+  // Mix skips and reads after a rewind
+  ii_base->Rewind(ii_base);
+  ASSERT_EQ(ii_base->Read(ii_base), ITERATOR_OK);
+  ASSERT_EQ(ii_base->lastDocId, 30);
+  ASSERT_EQ(ii_base->SkipTo(ii_base, 1000), ITERATOR_NOTFOUND);
+  ASSERT_EQ(ii_base->lastDocId, 1020);
+  ASSERT_EQ(ii_base->Read(ii_base), ITERATOR_OK);
+  ASSERT_EQ(ii_base->lastDocId, 1050);
+  ASSERT_EQ(ii_base->SkipTo(ii_base, 9000), ITERATOR_OK);
+  ASSERT_EQ(ii_base->Read(ii_base), ITERATOR_OK);
+  ASSERT_EQ(ii_base->lastDocId, 9030);
+  ii_base->Free(ii_base);
+}
+
+TEST_F(IntersectionIteratorBlocksTest, NoCommonIds) {
+  // The children never agree, and the whole range is covered by read ahead ids only
+  QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * 2);
+  InvertedIndex *evens = createIndex(2, 10000);
+  size_t memsize;
+  InvertedIndex *odds = NewInvertedIndex(static_cast<IndexFlags>(INDEX_DEFAULT_FLAGS), &memsize);
+  indexes.push_back(odds);
+  for (t_docId i = 1; i <= 10000; i += 2) {
+    auto res = (RSIndexResult) {.docId = i, .fieldMask = 1, .freq = 1, .data = {.term_tag = RSResultData_Tag::RSResultData_Term}};
+    InvertedIndex_WriteEntryGeneric(odds, &res);
+  }
+  FieldMaskOrIndex mask = {.isFieldMask = true, .value = {.mask = RS_FIELDMASK_ALL}};
+  children[0] = NewInvIndIterator_TermQuery(evens, nullptr, mask, nullptr, 1.0);
+  children[1] = NewInvIndIterator_TermQuery(odds, nullptr, mask, nullptr, 1.0);
+  QueryIterator *ii_base = NewIntersectionIterator(children, 2, -1, false, 1.0);
+  ASSERT_EQ(ii_base->Read(ii_base), ITERATOR_EOF);
+  ASSERT_TRUE(ii_base->atEOF);
+  ii_base->Free(ii_base);
+}
+
+TEST_F(IntersectionIteratorBlocksTest, DifferentSizes) {
+  // Too different for block reads. Results are the same either way
+  QueryIterator *ii_base = createIntersection({1, 100}, 10000);
+  t_docId expected = 100;
+  while (ii_base->Read(ii_base) == ITERATOR_OK) {
+    ASSERT_EQ(ii_base->lastDocId, expected);
+    expected += 100;
+  }
+  ASSERT_EQ(expected, 10000 + 100);
+  ii_base->Free(ii_base);
+}
@@ -12,6 +12,7 @@
 #include "gtest/gtest.h"
 #include "iterator_util.h"
 
+#include <algorithm>
 #include <random>
 #include <vector>
 
@@ -1071,3 +1072,99 @@ TEST_F(NotIteratorOptimizedRevalidateTest, RevalidateWildcardMovesToSameIdAsChil
   // Should be able to continue reading
   ASSERT_EQ(ni_base->Read(ni_base), ITERATOR_OK);
 }
+
+// Dense children are materialized into a bitmap of the excluded ids, for both versions
+class NotIteratorBitmapTest : public ::testing::TestWithParam<bool> {
+protected:
+  const t_docId maxDocId = 50000;
+  std::vector<t_docId> childDocIds;
+  std::vector<t_docId> wcDocIds;
+  std::vector<t_docId> resultSet;
+  MockIterator *mockChild;
+  QueryIterator *ni_base;
+  std::unique_ptr<MockQueryEvalCtx> mockQctx;
+
+  void SetUp() override {
+    const bool optimized = GetParam();
+    for (t_docId id = 1; id <= maxDocId; id++) {
+      if (id % 3 == 0 || id % 7 == 0) childDocIds.push_back(id);
+      if (!optimized || id % 2 == 0) wcDocIds.push_back(id);
+    }
+    for (t_docId id : wcDocIds) {
+      if (id % 3 != 0 && id % 7 != 0) resultSet.push_back(id);
+    }
+    mockChild = new MockIterator(childDocIds);
+    struct timespec timeout = {LONG_MAX, 999999999}; // "infinite" timeout
+    if (optimized) {
+      ni_base = _New_NotIterator_With_WildCardIterator((QueryIterator *)mockChild,
+                                                       (QueryIterator *)new MockIterator(wcDocIds),
+                                                       maxDocId, 1.0, timeout);
+    } else {
+      mockQctx = std::make_unique<MockQueryEvalCtx>(maxDocId, maxDocId);
+      ni_base = NewNotIterator((QueryIterator *)mockChild, maxDocId, 1.0, timeout, &mockQctx->qctx);
+    }
+  }
+  void TearDown() override {
+    ni_base->Free(ni_base);
+  }
+};
+
+TEST_P(NotIteratorBitmapTest, Read) {
+  NotIterator *ni = (NotIterator *)ni_base;
+  for (int round = 0; round < 2; round++) {
+    for (t_docId id : resultSet) {
+      ASSERT_EQ(ni_base->Read(ni_base), ITERATOR_OK);
+      ASSERT_EQ(ni_base->lastDocId, id);
+      ASSERT_EQ(ni_base->current->docId, id);
+    }
+    ASSERT_EQ(ni_base->Read(ni_base), ITERATOR_EOF);
+    ASSERT_TRUE(ni_base->atEOF);
+    ASSERT_TRUE(ni->materialized);
+    if (round == 1) {
+      // The child was read once, and never again after the rewind
+      ASSERT_EQ(mockChild->readCount, 0);
+    }
+    ni_base->Rewind(ni_base);
+  }
+}
+
+TEST_P(NotIteratorBitmapTest, SkipTo) {
+  for (t_docId target = 1; target <= maxDocId; target += 97) {
+    auto it = std::lower_bound(resultSet.begin(), resultSet.end(), target);
+    ni_base->Rewind(ni_base);
+    IteratorStatus rc = ni_base->SkipTo(ni_base, target);
+    if (it == resultSet.end()) {
+      ASSERT_EQ(rc, ITERATOR_EOF);
+      continue;
+    }
+    ASSERT_EQ(rc, *it == target ? ITERATOR_OK : ITERATOR_NOTFOUND) << "target " << target;
+    ASSERT_EQ(ni_base->lastDocId, *it);
+    // Reading continues from the skipped-to id
+    if (it + 1 != resultSet.end()) {
+      ASSERT_EQ(ni_base->Read(ni_base), ITERATOR_OK);
+      ASSERT_EQ(ni_base->lastDocId, *(it + 1));
+    }
+  }
+  ASSERT_EQ(ni_base->SkipTo(ni_base, maxDocId + 1), ITERATOR_EOF);
+}
+
+TEST_P(NotIteratorBitmapTest, TimeoutWhileMaterializing) {
+  NotIterator *ni = (NotIterator *)ni_base;
+  // Time out after half of the child's ids, then resume
+  std::vector<t_docId> rest(childDocIds.begin() + childDocIds.size() / 2, childDocIds.end());
+  mockChild->docIds.resize(childDocIds.size() / 2);
+  mockChild->whenDone = ITERATOR_TIMEOUT;
+  ASSERT_EQ(ni_base->Read(ni_base), ITERATOR_TIMEOUT);
+  ASSERT_FALSE(ni->materialized);
+
+  mockChild->docIds.insert(mockChild->docIds.end(), rest.begin(), rest.end());
+  mockChild->whenDone = ITERATOR_EOF;
+  mockChild->base.atEOF = false;
+  for (t_docId id : resultSet) {
+    ASSERT_EQ(ni_base->Read(ni_base), ITERATOR_OK);
+    ASSERT_EQ(ni_base->lastDocId, id);
+  }
+  ASSERT_EQ(ni_base->Read(ni_base), ITERATOR_EOF);
+}
+
+INSTANTIATE_TEST_SUITE_P(NotIteratorBitmapP, NotIteratorBitmapTest, ::testing::Bool());
@@ -19,6 +19,8 @@
 #include "index_utils.h"
 #include "src/iterators/wildcard_iterator.h"
 #include "src/iterators/inverted_index_iterator.h"
+#include "src/iterators/intersection_iterator.h"
+#include "ext/default.h"
 #include "inverted_index.h"
 
 
@@ -1024,3 +1026,110 @@ TEST_F(OptionalIteratorOptimizedRevalidateTest, RevalidateWildcardMovedToChildId
   ASSERT_EQ(oi_base->lastDocId, 15); // Should have moved forward
   ASSERT_EQ(oi_base->current, oi->child->current); // Should now be a real result from child
 }
+
+class OptionalIteratorLazyTest : public ::testing::Test {
+protected:
+  InvertedIndex *idxA, *idxB;
+  QueryIterator *ii_base, *optional;
+  double threshold = 0;
+
+  static InvertedIndex *createIndex(t_docId step, t_docId highFreqDoc) {
+    size_t memsize;
+    InvertedIndex *idx = NewInvertedIndex(static_cast<IndexFlags>(INDEX_DEFAULT_FLAGS), &memsize);
+    for (t_docId i = step; i <= 1000; i += step) {
+      auto res = (RSIndexResult) {
+        .docId = i,
+        .fieldMask = 1,
+        .freq = i == highFreqDoc ? 50U : 1U,
+        .data = {.term_tag = RSResultData_Tag::RSResultData_Term},
+      };
+      InvertedIndex_WriteEntryGeneric(idx, &res);
+    }
+    return idx;
+  }
+
+  static QueryIterator *createTermIterator(InvertedIndex *idx, const char *str) {
+    RSToken tok = {.str = const_cast<char *>(str), .len = strlen(str), .flags = 0};
+    RSQueryTerm *term = NewQueryTerm(&tok, 1);
+    term->bm25_idf = 1.0;
+    return NewInvIndIterator_TermQuery(idx, nullptr, {.isFieldMask = true, .value = {.mask = RS_FIELDMASK_ALL}}, term, 1.0);
+  }
+
+  void SetUp() override {
+    // "a ~b": "a" appears in every doc, with a high frequency in doc 450 only. "b" appears in even
+    // docs only
+    idxA = createIndex(1, 450);
+    idxB = createIndex(2, 0);
+    MockQueryEvalCtx ctx(1000, 1000);
+    optional = NewOptionalIterator(createTermIterator(idxB, "b"), &ctx.qctx, 1.0);
+    QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * 2);
+    children[0] = createTermIterator(idxA, "a");
+    children[1] = optional;
+    ii_base = NewIntersectionIterator(children, 2, -1, false, 1.0);
+    ASSERT_TRUE(OI_EnableLazy(ii_base, &threshold));
+  }
+  void TearDown() override {
+    ii_base->Free(ii_base);
+    InvertedIndex_Free(idxA);
+    InvertedIndex_Free(idxB);
+  }
+
+  // The docs of the intersection on which the optional child was consulted and matched
+  std::vector<t_docId> readRealHits() {
+    std::vector<t_docId> hits;
+    size_t count = 0;
+    while (ii_base->Read(ii_base) == ITERATOR_OK) {
+      EXPECT_EQ(ii_base->lastDocId, ++count);
+      if (optional->current != ((OptionalIterator *)optional)->virt) {
+        hits.push_back(ii_base->lastDocId);
+      }
+    }
+    EXPECT_EQ(count, 1000);
+    return hits;
+  }
+};
+
+TEST_F(OptionalIteratorLazyTest, NoThreshold) {
+  // With a threshold of 0, the child is consulted on every doc
+  std::vector<t_docId> expected;
+  for (t_docId i = 2; i <= 1000; i += 2) expected.push_back(i);
+  ASSERT_EQ(readRealHits(), expected);
+}
+
+TEST_F(OptionalIteratorLazyTest, SkipNonCompetitive) {
+  // Only docs in the block of "a" holding doc 450 (401-500) may reach the threshold with a match of
+  // "b". All the docs are still returned, but the child is only consulted on those
+  double singleBound = BM25Std_TermUpperBound(1.0, 1.0, 1);
+  double highBound = BM25Std_TermUpperBound(1.0, 1.0, 50);
+  threshold = (2 * singleBound + highBound + singleBound) / 2;
+  ASSERT_GT(threshold, 2 * singleBound);
+
+  std::vector<t_docId> expected;
+  for (t_docId i = 402; i <= 500; i += 2) expected.push_back(i);
+  ASSERT_EQ(readRealHits(), expected);
+
+  // A threshold that no doc can reach leaves the child where it is
+  ii_base->Rewind(ii_base);
+  threshold = highBound + singleBound + 1;
+  ASSERT_TRUE(readRealHits().empty());
+  ASSERT_EQ(((OptionalIterator *)optional)->child->lastDocId, 0);
+}
+
+TEST_F(OptionalIteratorLazyTest, NotEligible) {
+  // Children other than term iterators have no bounds
+  MockQueryEvalCtx ctx(1000, 1000);
+  QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * 2);
+  children[0] = reinterpret_cast<QueryIterator *>(new MockIterator({1UL, 2UL, 3UL}));
+  children[1] = NewOptionalIterator(createTermIterator(idxB, "b"), &ctx.qctx, 1.0);
+  QueryIterator *mixed = NewIntersectionIterator(children, 2, -1, false, 1.0);
+  ASSERT_FALSE(OI_EnableLazy(mixed, &threshold));
+  mixed->Free(mixed);
+
+  // Phrases check the offsets of all their children
+  children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * 2);
+  children[0] = createTermIterator(idxA, "a");
+  children[1] = NewOptionalIterator(createTermIterator(idxB, "b"), &ctx.qctx, 1.0);
+  QueryIterator *phrase = NewIntersectionIterator(children, 2, 0, true, 1.0);
+  ASSERT_FALSE(OI_EnableLazy(phrase, &threshold));
+  phrase->Free(phrase);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "rmutil/alloc.h"
+
+#include "gtest/gtest.h"
+#include "iterator_util.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "src/iterators/sample_iterator.h"
+
+class SampleIteratorTest : public ::testing::Test {
+protected:
+  std::vector<t_docId> childDocIds;
+
+  void SetUp() override {
+    for (t_docId id = 1; id <= 1000; id++) {
+      childDocIds.push_back(id * 3);
+    }
+  }
+
+  QueryIterator *newIterator(double ratio, IteratorStatus whenDone = ITERATOR_EOF) {
+    MockIterator *child = new MockIterator();
+    child->docIds = childDocIds;
+    child->whenDone = whenDone;
+    return NewSampleIterator((QueryIterator *)child, ratio);
+  }
+
+  std::vector<t_docId> sampled(double ratio) {
+    std::vector<t_docId> ids;
+    std::copy_if(childDocIds.begin(), childDocIds.end(), std::back_inserter(ids),
+                 [ratio](t_docId id) { return SampleIterator_Keeps(id, ratio); });
+    return ids;
+  }
+};
+
+TEST_F(SampleIteratorTest, Read) {
+  const std::vector<t_docId> expected = sampled(0.3);
+  // The hash spreads the sampled ids evenly
+  ASSERT_GT(expected.size(), 250);
+  ASSERT_LT(expected.size(), 350);
+
+  QueryIterator *it = newIterator(0.3);
+  ASSERT_EQ(it->NumEstimated(it), (size_t)(childDocIds.size() * 0.3) + 1);
+  for (int round = 0; round < 2; round++) {
+    for (t_docId id : expected) {
+      ASSERT_EQ(it->Read(it), ITERATOR_OK);
+      ASSERT_EQ(it->lastDocId, id);
+      ASSERT_EQ(it->current->docId, id);
+    }
+    ASSERT_EQ(it->Read(it), ITERATOR_EOF);
+    ASSERT_TRUE(it->atEOF);
+    it->Rewind(it);
+    ASSERT_EQ(it->lastDocId, 0);
+    ASSERT_FALSE(it->atEOF);
+  }
+  it->Free(it);
+}
+
+TEST_F(SampleIteratorTest, SkipTo) {
+  const std::vector<t_docId> expected = sampled(0.3);
+  for (t_docId target = 1; target <= childDocIds.back() + 1; target += 7) {
+    QueryIterator *it = newIterator(0.3);
+    auto next = std::lower_bound(expected.begin(), expected.end(), target);
+    IteratorStatus rc = it->SkipTo(it, target);
+    if (next == expected.end()) {
+      ASSERT_EQ(rc, ITERATOR_EOF);
+      ASSERT_TRUE(it->atEOF);
+    } else {
+      ASSERT_EQ(rc, *next == target ? ITERATOR_OK : ITERATOR_NOTFOUND) << target;
+      ASSERT_EQ(it->lastDocId, *next);
+      if (++next != expected.end()) {
+        ASSERT_EQ(it->Read(it), ITERATOR_OK);
+        ASSERT_EQ(it->lastDocId, *next);
+      }
+    }
+    it->Free(it);
+  }
+}
+
+TEST_F(SampleIteratorTest, NestedSamples) {
+  // A sample at a lower ratio is a subset of one at a higher ratio
+  const std::vector<t_docId> small = sampled(0.1), large = sampled(0.5);
+  ASSERT_LT(small.size(), large.size());
+  ASSERT_TRUE(std::includes(large.begin(), large.end(), small.begin(), small.end()));
+}
+
+TEST_F(SampleIteratorTest, Timeout) {
+  QueryIterator *it = newIterator(0.3, ITERATOR_TIMEOUT);
+  IteratorStatus rc;
+  size_t n = 0;
+  while ((rc = it->Read(it)) == ITERATOR_OK) {
+    n++;
+  }
+  ASSERT_EQ(rc, ITERATOR_TIMEOUT);
+  ASSERT_EQ(n, sampled(0.3).size());
+  it->Free(it);
+}
@@ -6,6 +6,9 @@
 
 #include "rmutil/alloc.h"
 
+#include <algorithm>
+#include <set>
+
 #include "gtest/gtest.h"
 #include "iterator_util.h"
 
@@ -14,6 +17,7 @@
 #include "src/iterators/wildcard_iterator.h"
 #include "src/iterators/inverted_index_iterator.h"
 #include "inverted_index.h"
+#include "ext/default.h"
 
 class UnionIteratorCommonTest : public ::testing::TestWithParam<std::tuple<unsigned, bool, std::vector<t_docId>>> {
 protected:
@@ -139,11 +143,11 @@ TEST_P(UnionIteratorCommonTest, Rewind) {
 }
 
 // Parameters for the tests above. We run all the combinations of:
-// 1. number of child iterators in {2, 5, 25}
+// 1. number of child iterators in {2, 5, 25, 100} (flat, heap and loser tree alternatives)
 // 2. quick mode (true/false)
 // 3. expected result set, one of the 3 given lists below
 INSTANTIATE_TEST_SUITE_P(UnionIteratorP, UnionIteratorCommonTest, ::testing::Combine(
-  ::testing::Values(2, 5, 25),
+  ::testing::Values(2, 5, 25, 100),
   ::testing::Bool(),
   ::testing::Values(
     std::vector<t_docId>{1, 2, 3, 40, 50},
@@ -233,11 +237,11 @@ TEST_P(UnionIteratorEdgesTest, TimeoutLastChild) {
 }
 
 // Parameters for the tests above. We run all the combinations of:
-// 1. number of child iterators in {2, 5, 25}
+// 1. number of child iterators in {2, 5, 25, 100} (flat, heap and loser tree alternatives)
 // 2. quick mode (true/false)
 // 3. sparse/dense result set (we may get different behavior if we have sequential ids to return)
 INSTANTIATE_TEST_SUITE_P(UnionIteratorEdgesP, UnionIteratorEdgesTest, ::testing::Combine(
-    ::testing::Values(2, 5, 25),
+    ::testing::Values(2, 5, 25, 100),
     ::testing::Bool(),
     ::testing::Bool()
 ));
@@ -281,6 +285,205 @@ TEST_F(UnionIteratorSingleTest, ReuseResults) {
   ui_base->Free(ui_base);
 }
 
+// A wide union in full mode merges its children with a loser tree. Every child that agrees on the
+// current id must be collected, however far apart the children are in the tree
+TEST_F(UnionIteratorSingleTest, WideUnionCollectsAllMatches) {
+  const unsigned numChildren = 130;
+  const t_docId maxId = 1000;
+  QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * numChildren);
+  for (unsigned i = 0; i < numChildren; i++) {
+    // Child i yields the multiples of i + 1
+    std::vector<t_docId> ids;
+    for (t_docId id = i + 1; id <= maxId; id += i + 1) {
+      ids.push_back(id);
+    }
+    children[i] = (QueryIterator *)new MockIterator(ids);
+  }
+  QueryIterator *ui_base = NewUnionIterator(children, numChildren, false, 1.0, QN_UNION, NULL,
+                                            &RSGlobalConfig.iteratorsConfigParams);
+  auto numDivisors = [&](t_docId id) {
+    size_t count = 0;
+    for (unsigned i = 0; i < numChildren; i++) {
+      count += id % (i + 1) == 0;
+    }
+    return count;
+  };
+
+  for (t_docId id = 1; id <= maxId; id++) {
+    ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_OK);
+    ASSERT_EQ(ui_base->lastDocId, id);
+    ASSERT_EQ(AggregateResult_NumChildren(IndexResult_AggregateRef(ui_base->current)), numDivisors(id)) << "id " << id;
+  }
+  ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_EOF);
+
+  ui_base->Rewind(ui_base);
+  for (t_docId id = 7; id <= maxId; id += 97) {
+    ASSERT_EQ(ui_base->SkipTo(ui_base, id), ITERATOR_OK);
+    ASSERT_EQ(ui_base->lastDocId, id);
+    ASSERT_EQ(AggregateResult_NumChildren(IndexResult_AggregateRef(ui_base->current)), numDivisors(id)) << "id " << id;
+    ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_OK);
+    ASSERT_EQ(ui_base->lastDocId, id + 1);
+  }
+  ASSERT_EQ(ui_base->SkipTo(ui_base, maxId + 1), ITERATOR_EOF);
+  ASSERT_TRUE(ui_base->atEOF);
+
+  ui_base->Free(ui_base);
+}
+
+// A merging union reads its children in batches, of fewer ids than the children have, and yields
+// every id of them once
+TEST_F(UnionIteratorSingleTest, MergeUnionYieldsEveryIdOnce) {
+  const unsigned numChildren = 20;
+  const t_docId maxId = 5000;
+  QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * numChildren);
+  std::set<t_docId> expected;
+  for (unsigned i = 0; i < numChildren; i++) {
+    // Child i yields the multiples of i + 7
+    std::vector<t_docId> ids;
+    for (t_docId id = i + 7; id <= maxId; id += i + 7) {
+      ids.push_back(id);
+      expected.insert(id);
+    }
+    children[i] = (QueryIterator *)new MockIterator(ids);
+  }
+  QueryIterator *ui_base = NewMergeUnionIterator(children, numChildren, 1.0, QN_NUMERIC);
+
+  for (t_docId id : expected) {
+    ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_OK);
+    ASSERT_EQ(ui_base->lastDocId, id);
+    ASSERT_EQ(ui_base->current->docId, id);
+  }
+  ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_EOF);
+  ASSERT_TRUE(ui_base->atEOF);
+
+  // Skips within the batches of the children and past them
+  ui_base->Rewind(ui_base);
+  for (t_docId id = 5; id <= maxId; id += 13 * (id % 7 + 1)) {
+    auto next = expected.lower_bound(id);
+    ASSERT_NE(next, expected.end());
+    ASSERT_EQ(ui_base->SkipTo(ui_base, id), *next == id ? ITERATOR_OK : ITERATOR_NOTFOUND);
+    ASSERT_EQ(ui_base->lastDocId, *next);
+    if (++next != expected.end()) {
+      ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_OK);
+      ASSERT_EQ(ui_base->lastDocId, *next);
+      id = *next;
+    }
+  }
+  ASSERT_EQ(ui_base->SkipTo(ui_base, maxId + 1), ITERATOR_EOF);
+  ASSERT_TRUE(ui_base->atEOF);
+
+  ui_base->Rewind(ui_base);
+  std::vector<t_docId> batch(100), ids;
+  size_t n;
+  while (ui_base->ReadBatch(ui_base, batch.data(), batch.size(), &n) == ITERATOR_OK) {
+    ids.insert(ids.end(), batch.begin(), batch.begin() + n);
+  }
+  ASSERT_EQ(ids, std::vector<t_docId>(expected.begin(), expected.end()));
+
+  ui_base->Free(ui_base);
+}
+
+
+class UnionIteratorDeferredTest : public ::testing::Test {
+protected:
+  std::vector<std::vector<t_docId>> docIds;
+  size_t numOpened = 0;
+
+  static QueryIterator *openChild(void *ctx, const void *source, void *arg, bool stale) {
+    ++*static_cast<size_t *>(ctx);
+    return (QueryIterator *)new MockIterator(*static_cast<const std::vector<t_docId> *>(source));
+  }
+  static void freeArg(void *arg) {}
+
+  // Child i yields every (i + 2)th id from 10 * i + 1
+  QueryIterator *newUnion(unsigned numChildren, t_docId maxId) {
+    docIds.resize(numChildren);
+    UnionDeferredChild *children = (UnionDeferredChild *)rm_malloc(sizeof(*children) * numChildren);
+    for (unsigned i = 0; i < numChildren; i++) {
+      for (t_docId id = 10 * i + 1; id <= maxId; id += i + 2) {
+        docIds[i].push_back(id);
+      }
+      children[i] = {.minId = docIds[i][0], .numEstimated = docIds[i].size(),
+                     .source = &docIds[i], .arg = nullptr};
+    }
+    UnionChildOpener opener = {.open = openChild, .freeArg = freeArg, .freeCtx = nullptr, .ctx = &numOpened};
+    return NewDeferredUnionIterator(children, numChildren, &opener, 1.0, QN_PREFIX, NULL,
+                                    &RSGlobalConfig.iteratorsConfigParams);
+  }
+
+  std::vector<t_docId> expected() {
+    std::set<t_docId> ids;
+    for (auto &child : docIds) {
+      ids.insert(child.begin(), child.end());
+    }
+    return std::vector<t_docId>(ids.begin(), ids.end());
+  }
+};
+
+TEST_F(UnionIteratorDeferredTest, OpensChildrenOnTheirFirstId) {
+  const unsigned numChildren = 100;
+  QueryIterator *ui_base = newUnion(numChildren, 2000);
+  std::vector<t_docId> ids = expected();
+  size_t estimation = 0;
+  for (auto &child : docIds) {
+    estimation += child.size();
+  }
+  ASSERT_EQ(ui_base->NumEstimated(ui_base), estimation);
+  ASSERT_EQ(numOpened, 0);
+
+  ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_OK);
+  ASSERT_EQ(ui_base->lastDocId, 1);
+  ASSERT_EQ(numOpened, 1);
+  ASSERT_EQ(ui_base->SkipTo(ui_base, 45), ITERATOR_OK);
+  ASSERT_EQ(numOpened, 5);
+  ASSERT_EQ(ui_base->NumEstimated(ui_base), estimation);
+
+  for (auto it = std::upper_bound(ids.begin(), ids.end(), 45); it != ids.end(); ++it) {
+    ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_OK);
+    ASSERT_EQ(ui_base->lastDocId, *it);
+    ASSERT_EQ(ui_base->current->docId, *it);
+  }
+  ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_EOF);
+  ASSERT_EQ(numOpened, numChildren);
+  ui_base->Free(ui_base);
+}
+
+TEST_F(UnionIteratorDeferredTest, SkipTo) {
+  QueryIterator *ui_base = newUnion(100, 2000);
+  std::vector<t_docId> ids = expected();
+  for (int pass = 0; pass < 2; pass++) {
+    // Skipping past the first ids of the children, until EOF
+    for (t_docId id = 2; id <= ids.back(); id += 37) {
+      IteratorStatus rc = ui_base->SkipTo(ui_base, id);
+      auto next = std::lower_bound(ids.begin(), ids.end(), id);
+      ASSERT_EQ(rc, *next == id ? ITERATOR_OK : ITERATOR_NOTFOUND) << "id " << id;
+      ASSERT_EQ(ui_base->lastDocId, *next);
+    }
+    ASSERT_EQ(ui_base->SkipTo(ui_base, ids.back() + 1), ITERATOR_EOF);
+    ASSERT_EQ(numOpened, 100);
+    ui_base->Rewind(ui_base);
+  }
+  ui_base->Free(ui_base);
+}
+
+TEST_F(UnionIteratorDeferredTest, FewChildren) {
+  // Too few children for a heap: they are all opened right away
+  QueryIterator *ui_base = newUnion(5, 100);
+  ASSERT_EQ(numOpened, 5);
+  for (t_docId id : expected()) {
+    ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_OK);
+    ASSERT_EQ(ui_base->lastDocId, id);
+  }
+  ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_EOF);
+  ui_base->Free(ui_base);
+}
+
+TEST_F(UnionIteratorDeferredTest, NeverOpened) {
+  QueryIterator *ui_base = newUnion(50, 1000);
+  ASSERT_EQ(ui_base->SkipTo(ui_base, 5), ITERATOR_OK);
+  ASSERT_EQ(numOpened, 1);
+  ui_base->Free(ui_base);
+}
 
 class UnionIteratorReducerTest : public ::testing::Test {};
 
@@ -583,3 +786,103 @@ TEST_F(UnionIteratorRevalidateTest, RevalidateAllChildrenAtEOFAfterValidation) {
   ASSERT_EQ(ui_base->Read(ui_base), ITERATOR_EOF);
   ASSERT_EQ(ui_base->SkipTo(ui_base, lastValidDocId + 1), ITERATOR_EOF);
 }
+
+class UnionIteratorBlockMaxTest : public ::testing::Test {
+protected:
+  InvertedIndex *idxA, *idxB;
+  QueryIterator *ui_base;
+  double threshold = 0;
+
+  static InvertedIndex *createIndex(t_docId step, t_docId highFreqDoc) {
+    size_t memsize;
+    InvertedIndex *idx = NewInvertedIndex(static_cast<IndexFlags>(INDEX_DEFAULT_FLAGS), &memsize);
+    for (t_docId i = step; i <= 1000; i += step) {
+      auto res = (RSIndexResult) {
+        .docId = i,
+        .fieldMask = 1,
+        .freq = i == highFreqDoc ? 50U : 1U,
+        .data = {.term_tag = RSResultData_Tag::RSResultData_Term},
+      };
+      InvertedIndex_WriteEntryGeneric(idx, &res);
+    }
+    return idx;
+  }
+
+  static QueryIterator *createTermIterator(InvertedIndex *idx, const char *str) {
+    RSToken tok = {.str = const_cast<char *>(str), .len = strlen(str), .flags = 0};
+    RSQueryTerm *term = NewQueryTerm(&tok, 1);
+    term->bm25_idf = 1.0;
+    return NewInvIndIterator_TermQuery(idx, nullptr, {.isFieldMask = true, .value = {.mask = RS_FIELDMASK_ALL}}, term, 1.0);
+  }
+
+  void SetUp() override {
+    // "a" appears in every doc, with a high frequency in doc 450 only. "b" appears in even docs only.
+    idxA = createIndex(1, 450);
+    idxB = createIndex(2, 0);
+    QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * 2);
+    children[0] = createTermIterator(idxA, "a");
+    children[1] = createTermIterator(idxB, "b");
+    ui_base = NewUnionIterator(children, 2, false, 1.0, QN_UNION, NULL, &RSGlobalConfig.iteratorsConfigParams);
+    ASSERT_TRUE(UI_EnableBlockMax(ui_base, &threshold));
+  }
+  void TearDown() override {
+    ui_base->Free(ui_base);
+    InvertedIndex_Free(idxA);
+    InvertedIndex_Free(idxB);
+  }
+};
+
+TEST_F(UnionIteratorBlockMaxTest, NoThreshold) {
+  // With a threshold of 0, nothing is pruned
+  size_t count = 0;
+  while (ui_base->Read(ui_base) == ITERATOR_OK) {
+    ASSERT_EQ(ui_base->lastDocId, ++count);
+  }
+  ASSERT_EQ(count, 1000);
+}
+
+TEST_F(UnionIteratorBlockMaxTest, PruneBlocks) {
+  // A single low frequency match, or two of them, can't reach the threshold.
+  // Only docs in the block of "a" holding doc 450 (401-500) that also match "b" can.
+  double singleBound = BM25Std_TermUpperBound(1.0, 1.0, 1);
+  double highBound = BM25Std_TermUpperBound(1.0, 1.0, 50);
+  threshold = (2 * singleBound + highBound + singleBound) / 2;
+  ASSERT_GT(threshold, 2 * singleBound);
+  ASSERT_GT(threshold, highBound);
+
+  std::vector<t_docId> expected;
+  for (t_docId i = 402; i <= 500; i += 2) expected.push_back(i);
+  std::vector<t_docId> actual;
+  while (ui_base->Read(ui_base) == ITERATOR_OK) {
+    actual.push_back(ui_base->lastDocId);
+  }
+  ASSERT_EQ(actual, expected);
+
+  // Skipping into a pruned range lands on the next competitive candidate
+  ui_base->Rewind(ui_base);
+  ASSERT_EQ(ui_base->SkipTo(ui_base, 10), ITERATOR_NOTFOUND);
+  ASSERT_EQ(ui_base->lastDocId, 402);
+  ASSERT_EQ(ui_base->SkipTo(ui_base, 404), ITERATOR_OK);
+  ASSERT_EQ(ui_base->lastDocId, 404);
+  ASSERT_EQ(ui_base->SkipTo(ui_base, 499), ITERATOR_NOTFOUND);
+  ASSERT_EQ(ui_base->lastDocId, 500);
+  ASSERT_EQ(ui_base->SkipTo(ui_base, 501), ITERATOR_EOF);
+}
+
+TEST_F(UnionIteratorBlockMaxTest, NotEligible) {
+  // Quick exit unions don't collect all the matching children, so bounds can't be computed
+  QueryIterator **children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * 2);
+  children[0] = createTermIterator(idxA, "a");
+  children[1] = createTermIterator(idxB, "b");
+  QueryIterator *quick = NewUnionIterator(children, 2, true, 1.0, QN_UNION, NULL, &RSGlobalConfig.iteratorsConfigParams);
+  ASSERT_FALSE(UI_EnableBlockMax(quick, &threshold));
+  quick->Free(quick);
+
+  // Children other than term iterators have no bounds
+  children = (QueryIterator **)rm_malloc(sizeof(QueryIterator *) * 2);
+  children[0] = createTermIterator(idxA, "a");
+  children[1] = reinterpret_cast<QueryIterator *>(new MockIterator({1UL, 2UL, 3UL}));
+  QueryIterator *mixed = NewUnionIterator(children, 2, false, 1.0, QN_UNION, NULL, &RSGlobalConfig.iteratorsConfigParams);
+  ASSERT_FALSE(UI_EnableBlockMax(mixed, &threshold));
+  mixed->Free(mixed);
+}
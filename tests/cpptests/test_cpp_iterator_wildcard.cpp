@@ -8,9 +8,13 @@
 */
 
 #include <algorithm>
+#include <vector>
 #include "rmutil/alloc.h"
 #include "gtest/gtest.h"
 #include "src/iterators/wildcard_iterator.h"
+#include "src/doc_table.h"
+#include "src/query_ctx.h"
+#include "src/spec.h"
 
 class WildcardIteratorTest : public ::testing::Test {
 protected:
@@ -65,6 +69,36 @@ TEST_F(WildcardIteratorTest, Read) {
   ASSERT_EQ(iterator_base->Read(iterator_base), ITERATOR_EOF);
 }
 
+TEST_F(WildcardIteratorTest, ReadBatch) {
+  t_docId ids[32];
+  size_t n;
+  t_docId expected = 1;
+  // Read the ids in batches, the last one being partial
+  while (iterator_base->ReadBatch(iterator_base, ids, 32, &n) == ITERATOR_OK) {
+    ASSERT_GT(n, 0);
+    ASSERT_LE(n, 32);
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_EQ(ids[i], expected++);
+    }
+    ASSERT_EQ(iterator_base->lastDocId, ids[n - 1]);
+    ASSERT_EQ(iterator_base->current->docId, ids[n - 1]);
+  }
+  ASSERT_EQ(n, 0);
+  ASSERT_EQ(expected, maxDocId + 1);
+  ASSERT_TRUE(iterator_base->atEOF);
+  ASSERT_EQ(iterator_base->Read(iterator_base), ITERATOR_EOF);
+
+  // Batched and single reads can be mixed
+  iterator_base->Rewind(iterator_base);
+  ASSERT_EQ(iterator_base->Read(iterator_base), ITERATOR_OK);
+  ASSERT_EQ(iterator_base->ReadBatch(iterator_base, ids, 3, &n), ITERATOR_OK);
+  ASSERT_EQ(n, 3);
+  ASSERT_EQ(ids[0], 2);
+  ASSERT_EQ(ids[2], 4);
+  ASSERT_EQ(iterator_base->Read(iterator_base), ITERATOR_OK);
+  ASSERT_EQ(iterator_base->lastDocId, 5);
+}
+
 TEST_F(WildcardIteratorTest, SkipTo) {
   // Test skipping to specific docIds
   t_docId skipTargets[] = {5, 10, 20, 50, 75, 100};
@@ -146,3 +180,53 @@ TEST_F(WildcardIteratorTest, ZeroDocuments) {
 
   emptyIterator->Free(emptyIterator);
 }
+
+TEST_F(WildcardIteratorTest, SkipDeletedDocuments) {
+  char buf[16];
+  DocTable dt = NewDocTable(16, 1000);
+  for (int i = 1; i <= 100; i++) {
+    size_t nkey = snprintf(buf, sizeof(buf), "doc_%d", i);
+    DMD_Return(DocTable_Put(&dt, buf, nkey, 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash));
+  }
+  const std::vector<t_docId> live = {10, 50, 51, 90};
+  for (int i = 1; i <= 100; i++) {
+    if (std::find(live.begin(), live.end(), i) == live.end()) {
+      size_t nkey = snprintf(buf, sizeof(buf), "doc_%d", i);
+      ASSERT_EQ(1, DocTable_Delete(&dt, buf, nkey));
+    }
+  }
+  ASSERT_EQ(10, DocTable_NextId(&dt, 0));
+  ASSERT_EQ(50, DocTable_NextId(&dt, 11));
+  ASSERT_EQ(0, DocTable_NextId(&dt, 91));
+
+  IndexSpec spec = {};
+  RedisSearchCtx sctx = {};
+  sctx.spec = &spec;
+  QueryEvalCtx q = {};
+  q.sctx = &sctx;
+  q.docTable = &dt;
+  QueryIterator *it = NewWildcardIterator(&q, weight);
+
+  // Only the ids of the documents in the table are read
+  for (t_docId id : live) {
+    ASSERT_EQ(ITERATOR_OK, it->Read(it));
+    ASSERT_EQ(id, it->lastDocId);
+  }
+  ASSERT_EQ(ITERATOR_EOF, it->Read(it));
+
+  it->Rewind(it);
+  t_docId ids[8];
+  size_t n;
+  ASSERT_EQ(ITERATOR_OK, it->ReadBatch(it, ids, 8, &n));
+  ASSERT_EQ(std::vector<t_docId>(ids, ids + n), live);
+  ASSERT_EQ(ITERATOR_EOF, it->ReadBatch(it, ids, 8, &n));
+
+  it->Rewind(it);
+  ASSERT_EQ(ITERATOR_OK, it->SkipTo(it, 50));
+  ASSERT_EQ(ITERATOR_NOTFOUND, it->SkipTo(it, 60));
+  ASSERT_EQ(90, it->lastDocId);
+  ASSERT_EQ(ITERATOR_EOF, it->SkipTo(it, 91));
+
+  it->Free(it);
+  DocTable_Free(&dt);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "rmutil/alloc.h"
+#include "gtest/gtest.h"
+
+#include "src/util/key_id_map.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class KeyIdMapTest : public ::testing::Test {
+protected:
+  KeyIdMap map;
+  // The map does not own its keys
+  std::unordered_map<std::string, sds> keys;
+
+  void SetUp() override {
+    KeyIdMap_Init(&map);
+  }
+  void TearDown() override {
+    KeyIdMap_Destroy(&map);
+    for (auto &kv : keys) {
+      sdsfree(kv.second);
+    }
+  }
+
+  void put(const std::string &key, uint64_t id) {
+    sds s = sdsnewlen(key.data(), key.size());
+    KeyIdMap_Put(&map, s, id);
+    auto it = keys.find(key);
+    if (it != keys.end()) {
+      sdsfree(it->second);
+    }
+    keys[key] = s;
+  }
+  uint64_t get(const std::string &key) {
+    return KeyIdMap_Get(&map, key.data(), key.size());
+  }
+  bool del(const std::string &key) {
+    return KeyIdMap_Delete(&map, key.data(), key.size());
+  }
+};
+
+TEST_F(KeyIdMapTest, PutGetDelete) {
+  ASSERT_EQ(0, get("doc1"));
+  ASSERT_FALSE(del("doc1"));
+  ASSERT_EQ(sizeof(KeyIdMap), KeyIdMap_MemUsage(&map));
+
+  put("doc1", 1);
+  put("doc2", 2);
+  put(std::string("doc\0" "3", 5), 3);
+  ASSERT_EQ(3, KeyIdMap_Size(&map));
+  ASSERT_EQ(1, get("doc1"));
+  ASSERT_EQ(2, get("doc2"));
+  ASSERT_EQ(3, get(std::string("doc\0" "3", 5)));
+  ASSERT_EQ(0, get("doc"));
+
+  // Putting a key again replaces its id
+  put("doc1", 4);
+  ASSERT_EQ(3, KeyIdMap_Size(&map));
+  ASSERT_EQ(4, get("doc1"));
+
+  ASSERT_TRUE(del("doc1"));
+  ASSERT_FALSE(del("doc1"));
+  ASSERT_EQ(0, get("doc1"));
+  ASSERT_EQ(2, get("doc2"));
+
+  // The memory is released with the last key
+  ASSERT_TRUE(del("doc2"));
+  ASSERT_TRUE(del(std::string("doc\0" "3", 5)));
+  ASSERT_EQ(0, KeyIdMap_Size(&map));
+  ASSERT_EQ(sizeof(KeyIdMap), KeyIdMap_MemUsage(&map));
+}
+
+TEST_F(KeyIdMapTest, GrowAndShrink) {
+  const size_t n = 100000;
+  for (size_t i = 0; i < n; i++) {
+    put("key:" + std::to_string(i), i + 1);
+  }
+  ASSERT_EQ(n, KeyIdMap_Size(&map));
+  size_t fullMem = KeyIdMap_MemUsage(&map);
+
+  // Deleting and adding keys keeps the map at the same size, as the deleted slots are reclaimed
+  for (size_t i = 0; i < n; i += 2) {
+    ASSERT_TRUE(del("key:" + std::to_string(i)));
+    put("new:" + std::to_string(i), n + i + 1);
+  }
+  ASSERT_EQ(fullMem, KeyIdMap_MemUsage(&map));
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(i % 2 ? i + 1 : 0, get("key:" + std::to_string(i))) << i;
+    ASSERT_EQ(i % 2 ? 0 : n + i + 1, get("new:" + std::to_string(i))) << i;
+  }
+
+  // The map shrinks when most of its keys are deleted
+  for (size_t i = 0; i < n; i++) {
+    del("new:" + std::to_string(i));
+    if (i % 100 != 1) {
+      del("key:" + std::to_string(i));
+    }
+  }
+  ASSERT_EQ(n / 100, KeyIdMap_Size(&map));
+  ASSERT_LT(KeyIdMap_MemUsage(&map), fullMem / 16);
+  for (size_t i = 1; i < n; i += 100) {
+    ASSERT_EQ(i + 1, get("key:" + std::to_string(i))) << i;
+  }
+}
+
+TEST_F(KeyIdMapTest, SmallMaps) {
+  // The map of a few keys is scanned rather than probed, and grows into a swiss table
+  std::vector<size_t> mem = {KeyIdMap_MemUsage(&map)};
+  for (int i = 1; i <= KEY_ID_MAP_SMALL_CAPACITY + 1; i++) {
+    put("doc" + std::to_string(i), i);
+    mem.push_back(KeyIdMap_MemUsage(&map));
+    for (int j = 1; j <= i; j++) {
+      ASSERT_EQ(j, get("doc" + std::to_string(j))) << i;
+    }
+    ASSERT_EQ(0, get("doc0"));
+  }
+  ASSERT_LT(mem[0], mem[1]);
+  ASSERT_LT(mem[1], mem[2]);
+  ASSERT_EQ(mem[2], mem[KEY_ID_MAP_SMALL_CAPACITY]);
+  ASSERT_LT(mem[KEY_ID_MAP_SMALL_CAPACITY], mem[KEY_ID_MAP_SMALL_CAPACITY + 1]);
+
+  // A small map of two keys shrinks back to the size of one
+  ASSERT_TRUE(del("doc2"));
+  ASSERT_EQ(1, get("doc1"));
+  put("doc2", 2);
+  ASSERT_EQ(2, get("doc2"));
+
+  // It shrinks back as its keys are deleted, and keeps the remaining ones
+  for (int i = KEY_ID_MAP_SMALL_CAPACITY + 1; i > 1; i--) {
+    ASSERT_TRUE(del("doc" + std::to_string(i)));
+    ASSERT_EQ(0, get("doc" + std::to_string(i)));
+    ASSERT_EQ(1, get("doc1"));
+  }
+  ASSERT_LE(KeyIdMap_MemUsage(&map), mem[2]);
+  ASSERT_TRUE(del("doc1"));
+  ASSERT_EQ(mem[0], KeyIdMap_MemUsage(&map));
+}
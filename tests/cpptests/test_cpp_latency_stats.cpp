@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "gtest/gtest.h"
+
+#include "src/info/latency_stats.h"
+
+#include <memory>
+
+class LatencyHistogramTest : public ::testing::Test {
+protected:
+  std::unique_ptr<LatencyHistogram> h{new LatencyHistogram()};
+};
+
+TEST_F(LatencyHistogramTest, Empty) {
+  ASSERT_EQ(0, h->count);
+  ASSERT_EQ(0, LatencyHistogram_Percentile(h.get(), 0.5));
+  ASSERT_EQ(0, LatencyHistogram_Percentile(h.get(), 1));
+}
+
+TEST_F(LatencyHistogramTest, SmallValuesAreExact) {
+  for (uint64_t us = 0; us < LATENCY_SUB_BUCKETS; us++) {
+    LatencyHistogram_Record(h.get(), us);
+  }
+  ASSERT_EQ(LATENCY_SUB_BUCKETS, h->count);
+  ASSERT_EQ(LATENCY_SUB_BUCKETS - 1, h->max);
+  ASSERT_EQ(0, LatencyHistogram_Percentile(h.get(), 0));
+  ASSERT_EQ(3, LatencyHistogram_Percentile(h.get(), 0.5));
+  ASSERT_EQ(LATENCY_SUB_BUCKETS - 1, LatencyHistogram_Percentile(h.get(), 1));
+}
+
+TEST_F(LatencyHistogramTest, RelativeError) {
+  for (uint64_t us = 1; us < 1000000; us = us * 3 / 2 + 1) {
+    LatencyHistogram single = {};
+    LatencyHistogram_Record(&single, us);
+    // Capped by the largest value
+    ASSERT_EQ(us, LatencyHistogram_Percentile(&single, 0.5));
+  }
+  // Half of the values are below 1000, and the percentile is at most an eighth above its value
+  h.reset(new LatencyHistogram());
+  for (int i = 0; i < 50; i++) {
+    LatencyHistogram_Record(h.get(), 1000);
+    LatencyHistogram_Record(h.get(), 5000);
+  }
+  const uint64_t p50 = LatencyHistogram_Percentile(h.get(), 0.5);
+  ASSERT_GE(p50, 1000);
+  ASSERT_LE(p50, 1000 + 1000 / LATENCY_SUB_BUCKETS);
+  ASSERT_EQ(5000, LatencyHistogram_Percentile(h.get(), 0.99));
+  ASSERT_EQ(5000, h->max);
+}
+
+TEST_F(LatencyHistogramTest, HugeValues) {
+  LatencyHistogram_Record(h.get(), UINT64_MAX);
+  ASSERT_EQ(1, h->count);
+  ASSERT_EQ(UINT64_MAX, h->max);
+  ASSERT_EQ(UINT64_MAX, LatencyHistogram_Percentile(h.get(), 0.5));
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "rmutil/alloc.h"
+#include "gtest/gtest.h"
+#include "iterator_util.h"
+
+#include "src/prefix_cache.h"
+
+#include <string>
+#include <vector>
+
+class PrefixCacheTest : public ::testing::Test {
+protected:
+  PrefixCache *cache;
+
+  void SetUp() override {
+    cache = NewPrefixCache();
+  }
+  void TearDown() override {
+    PrefixCache_Free(cache);
+  }
+
+  QueryIterator *materialize(const std::string &prefix, t_fieldMask mask, QueryIterator *it) {
+    return PrefixCache_Materialize(cache, prefix.c_str(), prefix.size(), mask, it, 1.0);
+  }
+  QueryIterator *get(const std::string &prefix, t_fieldMask mask = RS_FIELDMASK_ALL) {
+    return PrefixCache_Get(cache, prefix.c_str(), prefix.size(), mask, 1.0);
+  }
+  void invalidate(const std::string &term) {
+    PrefixCache_InvalidateTerm(cache, term.c_str(), term.size());
+  }
+
+  static void expectIds(QueryIterator *it, const std::vector<t_docId> &expected) {
+    ASSERT_NE(it, nullptr);
+    for (t_docId id : expected) {
+      ASSERT_EQ(it->Read(it), ITERATOR_OK);
+      ASSERT_EQ(it->lastDocId, id);
+    }
+    ASSERT_EQ(it->Read(it), ITERATOR_EOF);
+    it->Free(it);
+  }
+};
+
+TEST_F(PrefixCacheTest, MaterializeAndGet) {
+  std::vector<t_docId> ids = {1, 5, 7, 100, 1000};
+  ASSERT_EQ(get("hel"), nullptr);
+  expectIds(materialize("hel", RS_FIELDMASK_ALL, (QueryIterator *)new MockIterator(ids)), ids);
+
+  expectIds(get("hel"), ids);
+  expectIds(get("hel"), ids);
+  // The key is the exact prefix and field mask
+  ASSERT_EQ(get("he"), nullptr);
+  ASSERT_EQ(get("hell"), nullptr);
+  ASSERT_EQ(get("hel", 0x2), nullptr);
+
+  // An expansion without documents is cached too
+  QueryIterator *it = materialize("xyz", RS_FIELDMASK_ALL, (QueryIterator *)new MockIterator());
+  ASSERT_EQ(it->type, EMPTY_ITERATOR);
+  it->Free(it);
+  expectIds(get("xyz"), {});
+}
+
+TEST_F(PrefixCacheTest, InvalidateTerm) {
+  std::vector<t_docId> ids = {2, 4, 6};
+  expectIds(materialize("hel", RS_FIELDMASK_ALL, (QueryIterator *)new MockIterator(ids)), ids);
+  expectIds(materialize("hel", 0x2, (QueryIterator *)new MockIterator(ids)), ids);
+  expectIds(materialize("wor", RS_FIELDMASK_ALL, (QueryIterator *)new MockIterator(ids)), ids);
+
+  // Terms that don't start with the prefix leave it cached
+  invalidate("he");
+  invalidate("help");
+  invalidate("world");
+  ASSERT_EQ(get("wor"), nullptr);
+  expectIds(get("hel"), ids);
+
+  // All the field masks of the prefix are dropped
+  invalidate("hello");
+  ASSERT_EQ(get("hel"), nullptr);
+  ASSERT_EQ(get("hel", 0x2), nullptr);
+}
+
+TEST_F(PrefixCacheTest, TooManyIds) {
+  std::vector<t_docId> ids;
+  for (t_docId id = 1; id <= PREFIX_CACHE_MAX_IDS + 1; id++) {
+    ids.push_back(id);
+  }
+  QueryIterator *child = (QueryIterator *)new MockIterator(ids);
+  // The expansion is returned as is, rewound
+  QueryIterator *it = materialize("hel", RS_FIELDMASK_ALL, child);
+  ASSERT_EQ(it, child);
+  ASSERT_EQ(it->lastDocId, 0);
+  ASSERT_EQ(get("hel"), nullptr);
+
+  // It is known to be too large, and not read again
+  auto *mock = (MockIterator *)it;
+  size_t readCount = mock->readCount;
+  ASSERT_EQ(materialize("hel", RS_FIELDMASK_ALL, it), child);
+  ASSERT_EQ(mock->readCount, readCount);
+  expectIds(it, ids);
+}
+
+TEST_F(PrefixCacheTest, Timeout) {
+  MockIterator *mock = new MockIterator(1UL, 2UL, 3UL);
+  mock->whenDone = ITERATOR_TIMEOUT;
+  QueryIterator *it = materialize("hel", RS_FIELDMASK_ALL, (QueryIterator *)mock);
+  ASSERT_EQ(it, (QueryIterator *)mock);
+  ASSERT_EQ(get("hel"), nullptr);
+  it->Free(it);
+}
+
+TEST_F(PrefixCacheTest, EvictLeastRecentlyUsed) {
+  std::vector<t_docId> ids = {3};
+  for (int i = 0; i < PREFIX_CACHE_CAPACITY; i++) {
+    std::string prefix = "p" + std::to_string(i);
+    expectIds(materialize(prefix, RS_FIELDMASK_ALL, (QueryIterator *)new MockIterator(ids)), ids);
+  }
+  // Use the oldest entry, so the second one is the least recently used
+  expectIds(get("p0"), ids);
+  expectIds(materialize("new", RS_FIELDMASK_ALL, (QueryIterator *)new MockIterator(ids)), ids);
+
+  ASSERT_EQ(get("p1"), nullptr);
+  expectIds(get("p0"), ids);
+  expectIds(get("new"), ids);
+  for (int i = 2; i < PREFIX_CACHE_CAPACITY; i++) {
+    expectIds(get("p" + std::to_string(i)), ids);
+  }
+}
@@ -10,6 +10,7 @@
 
 #include "src/query_parser/tokenizer.h"
 #include "src/util/references.h"
+#include "src/query_internal.h"
 #include "query_test_utils.h"
 
 #include "gtest/gtest.h"
@@ -937,3 +938,147 @@ TEST_F(QueryTest, testWildcard) {
 
   IndexSpec_RemoveFromGlobals(ref, false);
 }
+
+TEST_F(QueryTest, testCloneWithParams) {
+  static const char *args[] = {"SCHEMA", "title", "text", "num", "numeric", "loc", "geo"};
+  QueryError err = QueryError_Default();
+  StrongRef ref = IndexSpec_ParseC("idx", args, sizeof(args) / sizeof(const char *), &err);
+  RedisSearchCtx ctx = SEARCH_CTX_STATIC(NULL, (IndexSpec *)StrongRef_Get(ref));
+
+  const char *qt = "@title:$term @num:[$min $max] @loc:[$lon $lat $radius km]";
+  QASTCXX ast(ctx);
+  ASSERT_TRUE(ast.parse(qt, 2)) << ast.getError();
+  ASSERT_EQ(ast.root->type, QN_PHRASE);
+  ASSERT_EQ(QueryNode_NumChildren(ast.root), 3);
+
+  dict *params = Param_DictCreate();
+  const char *values[][2] = {{"term", "Hello"}, {"min", "1"}, {"max", "5"},
+                             {"lon", "31.52"}, {"lat", "32.1342"}, {"radius", "10"}};
+  for (auto &kv : values) {
+    ASSERT_EQ(REDISMODULE_OK, Param_DictAdd(params, kv[0], kv[1], strlen(kv[1]), &err));
+  }
+
+  // Every copy binds the parameters to its own nodes
+  for (int i = 0; i < 2; i++) {
+    QueryNode *n = QueryNode_Clone(ast.root);
+    ASSERT_TRUE(n != NULL);
+    ASSERT_EQ(REDISMODULE_OK, QueryNode_EvalParams(params, n, 2, &err)) << QueryError_GetUserError(&err);
+    ASSERT_EQ(n->children[0]->type, QN_TOKEN);
+    ASSERT_STREQ("hello", n->children[0]->tn.str);
+    ASSERT_EQ(5, n->children[0]->tn.len);
+    ASSERT_EQ(n->children[1]->type, QN_NUMERIC);
+    ASSERT_EQ(1, n->children[1]->nn.nf->min);
+    ASSERT_EQ(5, n->children[1]->nn.nf->max);
+    ASSERT_EQ(n->children[2]->type, QN_GEO);
+    ASSERT_EQ(31.52, n->children[2]->gn.gf->lon);
+    ASSERT_EQ(32.1342, n->children[2]->gn.gf->lat);
+    ASSERT_EQ(10, n->children[2]->gn.gf->radius);
+    ASSERT_EQ(GEO_DISTANCE_KM, n->children[2]->gn.gf->unitType);
+    QueryNode_Free(n);
+  }
+
+  // While the source tree is left unresolved
+  ASSERT_TRUE(ast.root->children[0]->tn.str == NULL);
+  ASSERT_EQ(0, ast.root->children[1]->nn.nf->min);
+  ASSERT_EQ(0, ast.root->children[2]->gn.gf->lon);
+
+  Param_DictFree(params);
+  IndexSpec_RemoveFromGlobals(ref, false);
+}
+
+TEST_F(QueryTest, testCanonicalize) {
+  static const char *args[] = {"SCHEMA", "title", "text", "body", "text", "tags", "tag"};
+  QueryError err = QueryError_Default();
+  StrongRef ref = IndexSpec_ParseC("idx", args, sizeof(args) / sizeof(const char *), &err);
+  RedisSearchCtx ctx = SEARCH_CTX_STATIC(NULL, (IndexSpec *)StrongRef_Get(ref));
+
+  RSSearchOptions scored, unscored;
+  RSSearchOptions_Init(&scored);
+  RSSearchOptions_Init(&unscored);
+  unscored.flags |= Search_CanSkipRichResults;
+  auto hashOf = [&](const char *qt, const RSSearchOptions *opts) {
+    QASTCXX ast(ctx);
+    EXPECT_TRUE(ast.parse(qt, 2)) << ast.getError();
+    QAST_Canonicalize(&ast, opts);
+    EXPECT_EQ(ast.hash, QueryNode_Hash(ast.root, opts));
+    return ast.hash;
+  };
+
+  // The order of the children of commutative nodes doesn't change the hash
+  ASSERT_EQ(hashOf("hello world foo", &scored), hashOf("foo hello world", &scored));
+  ASSERT_EQ(hashOf("hello | world", &scored), hashOf("world | hello", &scored));
+  ASSERT_EQ(hashOf("@tags:{foo | bar}", &scored), hashOf("@tags:{bar | foo}", &scored));
+  // But it does for the positional ones, and the values and the options of the nodes do
+  ASSERT_NE(hashOf("\"hello world\"", &scored), hashOf("\"world hello\"", &scored));
+  ASSERT_NE(hashOf("hello world", &scored), hashOf("hello worlds", &scored));
+  ASSERT_NE(hashOf("@title:hello", &scored), hashOf("@body:hello", &scored));
+  ASSERT_NE(hashOf("hello world", &scored), hashOf("hello | world", &scored));
+  ASSERT_NE(hashOf("(hello world) => {$inorder: true}", &scored),
+            hashOf("(world hello) => {$inorder: true}", &scored));
+  RSSearchOptions inOrder = scored;
+  inOrder.flags |= Search_InOrder;
+  ASSERT_NE(hashOf("hello world", &inOrder), hashOf("world hello", &inOrder));
+
+  // Nested nodes of the same type are folded, once the scores are not needed
+  {
+    QASTCXX ast(ctx);
+    ASSERT_TRUE(ast.parse("(hello world) (foo bar)", 2)) << ast.getError();
+    ASSERT_EQ(QueryNode_NumChildren(ast.root), 3);
+    QAST_Canonicalize(&ast, &scored);
+    ASSERT_EQ(QueryNode_NumChildren(ast.root), 3);
+    QAST_Canonicalize(&ast, &unscored);
+    ASSERT_EQ(ast.root->type, QN_PHRASE);
+    ASSERT_EQ(QueryNode_NumChildren(ast.root), 4);
+    for (size_t ii = 0; ii < 4; ++ii) {
+      ASSERT_EQ(ast.root->children[ii]->type, QN_TOKEN);
+    }
+    ASSERT_EQ(ast.hash, hashOf("bar foo world hello", &unscored));
+  }
+  {
+    QASTCXX ast(ctx);
+    ASSERT_TRUE(ast.parse("(hello | world) | (foo | bar)", 2)) << ast.getError();
+    ASSERT_EQ(QueryNode_NumChildren(ast.root), 3);
+    QAST_Canonicalize(&ast, &unscored);
+    ASSERT_EQ(ast.root->type, QN_UNION);
+    ASSERT_EQ(QueryNode_NumChildren(ast.root), 4);
+  }
+  {
+    // But not a node with options of its own
+    QASTCXX ast(ctx);
+    ASSERT_TRUE(ast.parse("hello | @title:(world | foo)", 2)) << ast.getError();
+    QAST_Canonicalize(&ast, &unscored);
+    ASSERT_EQ(ast.root->type, QN_UNION);
+    ASSERT_EQ(QueryNode_NumChildren(ast.root), 2);
+    ASSERT_EQ(ast.root->children[1]->type, QN_UNION);
+  }
+
+  // Repeated terms are dropped, and a node left with a single child is replaced by it
+  {
+    QASTCXX ast(ctx);
+    ASSERT_TRUE(ast.parse("hello | world | hello", 2)) << ast.getError();
+    QAST_Canonicalize(&ast, &unscored);
+    ASSERT_EQ(ast.root->type, QN_UNION);
+    ASSERT_EQ(QueryNode_NumChildren(ast.root), 2);
+    ASSERT_STREQ("hello", ast.root->children[0]->tn.str);
+    ASSERT_STREQ("world", ast.root->children[1]->tn.str);
+  }
+  {
+    QASTCXX ast(ctx);
+    ASSERT_TRUE(ast.parse("hello hello", 2)) << ast.getError();
+    QAST_Canonicalize(&ast, &unscored);
+    ASSERT_EQ(ast.root->type, QN_TOKEN);
+    ASSERT_STREQ("hello", ast.root->tn.str);
+  }
+  {
+    QASTCXX ast(ctx);
+    ASSERT_TRUE(ast.parse("@tags:{foo | bar | foo} \"hello hello\"", 2)) << ast.getError();
+    QAST_Canonicalize(&ast, &unscored);
+    ASSERT_EQ(ast.root->type, QN_PHRASE);
+    ASSERT_EQ(ast.root->children[0]->type, QN_TAG);
+    ASSERT_EQ(QueryNode_NumChildren(ast.root->children[0]), 2);
+    ASSERT_EQ(ast.root->children[1]->type, QN_PHRASE);
+    ASSERT_EQ(QueryNode_NumChildren(ast.root->children[1]), 2);
+  }
+
+  IndexSpec_RemoveFromGlobals(ref, false);
+}
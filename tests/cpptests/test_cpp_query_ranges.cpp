@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "result_processor.h"
+#include "gtest/gtest.h"
+#include "spec.h"
+#include "search_ctx.h"
+#include "rmalloc.h"
+#include "common.h"
+#include "redismock/redismock.h"
+#include "search_result.h"
+#include "iterator_util.h"
+
+#include <string>
+#include <vector>
+
+#define NUM_DOCS 1000
+
+class RPQueryRangesTest : public ::testing::Test {
+protected:
+  RedisModuleCtx *ctx;
+  IndexSpec *spec;
+  RedisSearchCtx sctx;
+
+  void SetUp() override {
+    ctx = RedisModule_GetThreadSafeContext(NULL);
+    const ::testing::TestInfo* const test_info =
+      ::testing::UnitTest::GetInstance()->current_test_info();
+    std::string index_name = std::string("test_index_") + test_info->name();
+
+    QueryError err = QueryError_Default();
+    RMCK::ArgvList argv(ctx, "FT.CREATE", index_name.c_str(), "SKIPINITIALSCAN", "SCHEMA", "field1", "TEXT");
+    spec = IndexSpec_CreateNew(ctx, argv, argv.size(), &err);
+    ASSERT_NE(spec, nullptr) << QueryError_GetUserError(&err);
+    for (size_t i = 1; i <= NUM_DOCS; i++) {
+      std::string key = "doc" + std::to_string(i);
+      DMD_Return(DocTable_Put(&spec->docs, key.c_str(), key.size(), 1.0, Document_DefaultFlags, NULL, 0, DocumentType_Hash));
+    }
+    ASSERT_EQ(spec->docs.maxDocId, NUM_DOCS);
+    sctx = SEARCH_CTX_STATIC(ctx, spec);
+  }
+
+  void TearDown() override {
+    IndexSpec_RemoveFromGlobals(spec->own_ref, true);
+    RedisModule_FreeThreadSafeContext(ctx);
+  }
+
+  // Read all the results of the processor, returning the last return code
+  static int readAll(ResultProcessor *rp, std::vector<t_docId> &ids) {
+    SearchResult res = {0};
+    int rc;
+    while ((rc = rp->Next(rp, &res)) == RS_RESULT_OK) {
+      EXPECT_EQ(SearchResult_GetIndexResult(&res), nullptr);
+      ids.push_back(SearchResult_GetDocId(&res));
+      SearchResult_Clear(&res);
+    }
+    SearchResult_Destroy(&res);
+    return rc;
+  }
+};
+
+TEST_F(RPQueryRangesTest, ReadInOrder) {
+  std::vector<t_docId> expected;
+  for (t_docId id = 1; id <= NUM_DOCS; id++) {
+    if (id % 3) expected.push_back(id);
+  }
+  // Every range reads a clone of the same tree
+  const size_t numRanges = 3;
+  QueryIterator *roots[numRanges];
+  for (size_t i = 0; i < numRanges; i++) {
+    roots[i] = (QueryIterator *)new MockIterator(expected);
+  }
+
+  QueryProcessingCtx qitr = {0};
+  ResultProcessor *rp = RPQueryRanges_New(roots, numRanges, &sctx);
+  QITR_PushRP(&qitr, rp);
+
+  std::vector<t_docId> ids;
+  ASSERT_EQ(readAll(rp, ids), RS_RESULT_EOF);
+  ASSERT_EQ(ids, expected);
+  ASSERT_EQ(qitr.totalResults, expected.size());
+  // The spec is unlocked once all the ranges are read
+  ASSERT_EQ(sctx.flags, RS_CTX_UNSET);
+  rp->Free(rp);
+}
+
+TEST_F(RPQueryRangesTest, Timeout) {
+  std::vector<t_docId> all, partial;
+  for (t_docId id = 1; id <= NUM_DOCS; id++) {
+    all.push_back(id);
+    if (id <= 700) partial.push_back(id);
+  }
+  // The second range, from id 501, times out after reading id 700
+  QueryIterator *roots[2];
+  roots[0] = (QueryIterator *)new MockIterator(all);
+  MockIterator *timingOut = new MockIterator(partial);
+  timingOut->whenDone = ITERATOR_TIMEOUT;
+  roots[1] = (QueryIterator *)timingOut;
+
+  QueryProcessingCtx qitr = {0};
+  ResultProcessor *rp = RPQueryRanges_New(roots, 2, &sctx);
+  QITR_PushRP(&qitr, rp);
+
+  std::vector<t_docId> ids;
+  ASSERT_EQ(readAll(rp, ids), RS_RESULT_TIMEDOUT);
+  ASSERT_EQ(ids, partial);
+  ASSERT_EQ(sctx.flags, RS_CTX_UNSET);
+  rp->Free(rp);
+}
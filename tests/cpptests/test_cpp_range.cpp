@@ -17,14 +17,20 @@
 #include "common.h"
 
 #include <stdio.h>
+#include <cmath>
 #include <random>
 #include <unordered_set>
+#include <algorithm>
+#include <vector>
 
 extern "C" {
 // declaration for an internal function implemented in numeric_index.c
 QueryIterator *createNumericIterator(const RedisSearchCtx *sctx, NumericRangeTree *t,
                                      const NumericFilter *f, IteratorsConfig *config,
                                      const FieldFilterContext* filterCtx);
+QueryIterator *createNumericIdsIterator(const RedisSearchCtx *sctx, NumericRangeTree *t,
+                                        const NumericFilter *f, IteratorsConfig *config,
+                                        const FieldFilterContext* filterCtx);
 }
 
 // Helper so we get the same pseudo-random numbers
@@ -43,8 +49,12 @@ TEST_F(RangeTest, testRangeTree) {
   ASSERT_TRUE(t != NULL);
 
   for (size_t i = 0; i < 50000; i++) {
-
+    uint32_t revision = NumericRangeTree_RevisionId(t);
+    size_t numLeaves = t->numLeaves;
     NumericRangeTree_Add(t, i + 1, (double)(1 + prng() % 5000), false);
+    ASSERT_EQ(NumericRangeTree_LastDocId(t), i + 1);
+    // The revision changes exactly when a leaf is split
+    ASSERT_EQ(NumericRangeTree_RevisionId(t) != revision, t->numLeaves != numLeaves);
   }
   ASSERT_EQ(t->numRanges, 8);
   ASSERT_EQ(t->numEntries, 50000);
@@ -225,6 +235,288 @@ TEST_F(RangeTest, testRangeIteratorMulti) {
   testRangeIteratorHelper(true);
 }
 
+TEST_F(RangeTest, testNumericBitmapUnion) {
+  // Documents with several values, which may fall in several of the ranges
+  NumericRangeTree *t = NewNumericRangeTree();
+  for (size_t i = 0; i < 50000; i++) {
+    for (size_t mult = 0; mult < 2; mult++) {
+      NumericRangeTree_Add(t, i + 1, (double)(1 + prng() % 5000), true);
+    }
+  }
+
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}}, .predicate = FIELD_EXPIRATION_DEFAULT};
+  auto readIds = [](QueryIterator *it) {
+    std::vector<t_docId> ids;
+    if (it) {
+      while (it->Read(it) == ITERATOR_OK) {
+        ids.push_back(it->lastDocId);
+      }
+      it->Free(it);
+    }
+    return ids;
+  };
+
+  RSGlobalConfig.numericBitmapUnionRanges = 2;
+  double ranges[][2] = {{0, 100}, {10, 1000}, {2500, 3500}, {0, 5000}, {4999, 4999}, {6000, 7000}};
+  for (auto &range : ranges) {
+    NumericFilter *flt = NewNumericFilter(range[0], range[1], 1, 1, true, NULL);
+    Vector *v = NumericRangeTree_Find(t, flt);
+    size_t numRanges = Vector_Size(v);
+    Vector_Free(v);
+
+    QueryIterator *it = createNumericIdsIterator(NULL, t, flt, &config, &filterCtx);
+    if (numRanges >= 2) {
+      ASSERT_EQ(it->type, ID_LIST_ITERATOR);
+    }
+    // The bitmap yields each document once, and the ids are compared as sets otherwise
+    std::vector<t_docId> ids = readIds(it);
+    std::vector<t_docId> expected = readIds(createNumericIterator(NULL, t, flt, &config, &filterCtx));
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+    if (numRanges < 2) {
+      ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+    ASSERT_EQ(ids, expected);
+    NumericFilter_Free(flt);
+  }
+  RSGlobalConfig.numericBitmapUnionRanges = 0;
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testNumericMergeUnion) {
+  // Documents with several values, which may fall in several of the ranges
+  NumericRangeTree *t = NewNumericRangeTree();
+  for (size_t i = 0; i < 50000; i++) {
+    for (size_t mult = 0; mult < 2; mult++) {
+      NumericRangeTree_Add(t, i + 1, (double)(1 + prng() % 5000), true);
+    }
+  }
+
+  IteratorsConfig config{};
+  iteratorsConfig_init(&config);
+  FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}}, .predicate = FIELD_EXPIRATION_DEFAULT};
+  auto readIds = [](QueryIterator *it) {
+    std::vector<t_docId> ids;
+    if (it) {
+      while (it->Read(it) == ITERATOR_OK) {
+        ids.push_back(it->lastDocId);
+      }
+      it->Free(it);
+    }
+    return ids;
+  };
+
+  RSGlobalConfig.numericMergeUnionRanges = 2;
+  double ranges[][2] = {{0, 100}, {10, 1000}, {2500, 3500}, {0, 5000}, {4999, 4999}, {6000, 7000}};
+  for (auto &range : ranges) {
+    NumericFilter *flt = NewNumericFilter(range[0], range[1], 1, 1, true, NULL);
+    Vector *v = NumericRangeTree_Find(t, flt);
+    size_t numRanges = Vector_Size(v);
+    Vector_Free(v);
+
+    std::vector<t_docId> expected = readIds(createNumericIterator(NULL, t, flt, &config, &filterCtx));
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+    QueryIterator *it = createNumericIdsIterator(NULL, t, flt, &config, &filterCtx);
+    if (numRanges >= 2) {
+      ASSERT_EQ(it->type, UNION_ITERATOR);
+    }
+    std::vector<t_docId> ids = readIds(it);
+    if (numRanges < 2) {
+      ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+    ASSERT_EQ(ids, expected);
+
+    // Skipping lands on the same documents as reading
+    it = createNumericIdsIterator(NULL, t, flt, &config, &filterCtx);
+    for (size_t i = 0; it && i < expected.size(); i += 37) {
+      ASSERT_EQ(it->SkipTo(it, expected[i]), ITERATOR_OK);
+      ASSERT_EQ(it->lastDocId, expected[i]);
+    }
+    if (it) {
+      it->Free(it);
+    }
+    NumericFilter_Free(flt);
+  }
+  RSGlobalConfig.numericMergeUnionRanges = 0;
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testNumericRangeMatchesAll) {
+  double ranges[][2] = {{-INFINITY, INFINITY}, {0, 100}, {250, 750}, {500, 500}, {2000, 3000}};
+  FieldFilterContext filterCtx = {.field = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}}, .predicate = FIELD_EXPIRATION_DEFAULT};
+
+  // With a single value per document, the count of the ranges covered by the filter is exact
+  NumericRangeTree *t = NewNumericRangeTree();
+  std::vector<double> values(20001);
+  for (size_t i = 1; i <= 20000; i++) {
+    values[i] = prng() % 1000;
+    NumericRangeTree_Add(t, i, values[i], false);
+  }
+  for (auto &range : ranges) {
+    NumericFilter *flt = NewNumericFilter(range[0], range[1], 1, 1, true, NULL);
+    size_t matching = std::count_if(values.begin() + 1, values.end(),
+                                    [&](double v) { return NumericFilter_Match(flt, v); });
+    bool exact;
+    size_t card = NumericRangeTree_Cardinality(t, flt, &exact);
+    if (exact) {
+      ASSERT_EQ(card, matching);
+    } else {
+      ASSERT_EQ(card > 0, matching > 0);
+    }
+    if (range[0] == -INFINITY) {
+      ASSERT_TRUE(exact);
+      ASSERT_EQ(card, 20000);
+    }
+    NumericFilter_Free(flt);
+  }
+  NumericRangeTree_Free(t);
+
+  // Every document has two values, at most 10 apart, so they are mostly in the same range
+  t = NewNumericRangeTree();
+  std::vector<std::vector<double>> multiValues(20001);
+  for (size_t i = 1; i <= 20000; i++) {
+    double value = prng() % 1000;
+    for (double v : {value, value + prng() % 10}) {
+      NumericRangeTree_Add(t, i, v, true);
+      multiValues[i].push_back(v);
+    }
+  }
+  for (auto &range : ranges) {
+    NumericFilter *flt = NewNumericFilter(range[0], range[1], 1, 1, true, NULL);
+    bool exact;
+    size_t card = NumericRangeTree_Cardinality(t, flt, &exact);
+    // A document may be counted in two ranges
+    ASSERT_EQ(exact, card == 0);
+
+    // The batches of the ranges matching the filter skip the values, and yield the same ids
+    Vector *v = NumericRangeTree_Find(t, flt);
+    for (size_t i = 0; i < Vector_Size(v); i++) {
+      NumericRange *rng;
+      Vector_Get(v, i, &rng);
+      QueryIterator *it = NewNumericRangeIterator(NULL, rng, flt, &filterCtx);
+      std::vector<t_docId> expected;
+      while (it->Read(it) == ITERATOR_OK) {
+        expected.push_back(it->lastDocId);
+      }
+      it->Rewind(it);
+      std::vector<t_docId> ids;
+      t_docId batch[64];
+      size_t n;
+      while (it->ReadBatch(it, batch, 64, &n) == ITERATOR_OK) {
+        ids.insert(ids.end(), batch, batch + n);
+        // The current result is the last entry of the batch, with its value
+        ASSERT_EQ(it->current->docId, batch[n - 1]);
+        const std::vector<double> &docValues = multiValues[batch[n - 1]];
+        ASSERT_NE(std::find(docValues.begin(), docValues.end(), IndexResult_NumValue(it->current)), docValues.end());
+      }
+      ASSERT_TRUE(it->atEOF);
+      ASSERT_EQ(ids, expected);
+      it->Free(it);
+    }
+    Vector_Free(v);
+    NumericFilter_Free(flt);
+  }
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testNumericHistogram) {
+  // Skewed values: most of them are small
+  NumericRangeTree *t = NewNumericRangeTree();
+  std::vector<double> values;
+  for (size_t i = 1; i <= 50000; i++) {
+    double v = (prng() % 100) * (prng() % 100);
+    values.push_back(v);
+    NumericRangeTree_Add(t, i, v, false);
+  }
+
+  const NumericHistogram *h = &t->histogram;
+  ASSERT_GT(h->numBuckets, 0);
+  ASSERT_LE(h->numBuckets, NR_HISTOGRAM_BUCKETS);
+  ASSERT_EQ(h->numEntries, t->numEntries);
+  size_t total = 0;
+  for (uint32_t i = 0; i < h->numBuckets; i++) {
+    ASSERT_LE(h->bounds[i], h->bounds[i + 1]);
+    total += h->counts[i];
+  }
+  ASSERT_EQ(total, h->numEntries);
+  ASSERT_EQ(h->bounds[0], *std::min_element(values.begin(), values.end()));
+  ASSERT_EQ(h->bounds[h->numBuckets], *std::max_element(values.begin(), values.end()));
+
+  // A range is estimated within a few buckets of its actual count, whatever its width
+  double ranges[][2] = {{0, 9801}, {0, 100}, {100, 200}, {1000, 5000}, {9000, 9801}, {20000, 30000}};
+  for (auto &range : ranges) {
+    size_t matching = std::count_if(values.begin(), values.end(),
+                                    [&](double v) { return v >= range[0] && v <= range[1]; });
+    size_t estimate = NumericHistogram_Estimate(h, range[0], range[1]);
+    ASSERT_LE(std::abs((double)estimate - (double)matching), 4.0 * h->depth + h->numBuckets);
+  }
+  ASSERT_EQ(NumericHistogram_Estimate(h, 20000, 30000), 0);
+
+  // A rebuild from the leaves keeps the counts
+  NumericRangeTree_RebuildHistogram(t);
+  ASSERT_EQ(h->numEntries, t->numEntries);
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testLowCardinalityLeaves) {
+  // A few distinct values are split to a leaf each, which a filter on a value reads as a whole
+  NumericRangeTree *t = NewNumericRangeTree();
+  double values[] = {0, 1, 2.5, 7};
+  for (size_t i = 1; i <= 5000; i++) {
+    NumericRangeTree_Add(t, i, values[prng() % 4], false);
+  }
+  ASSERT_EQ(t->numLeaves, 4);
+  NumericRangeTreeIterator *iter = NumericRangeTreeIterator_New(t);
+  NumericRangeNode *node;
+  while ((node = NumericRangeTreeIterator_Next(iter))) {
+    if (NumericRangeNode_IsLeaf(node)) {
+      ASSERT_EQ(node->range->minVal, node->range->maxVal);
+    }
+  }
+  NumericRangeTreeIterator_Free(iter);
+  for (double value : values) {
+    NumericFilter *flt = NewNumericFilter(value, value, 1, 1, true, NULL);
+    Vector *v = NumericRangeTree_Find(t, flt);
+    ASSERT_EQ(Vector_Size(v), 1);
+    NumericRange *rng;
+    Vector_Get(v, 0, &rng);
+    ASSERT_TRUE(NumericRange_MatchesAll(rng, flt));
+    Vector_Free(v);
+    NumericFilter_Free(flt);
+  }
+  NumericRangeTree_Free(t);
+}
+
+TEST_F(RangeTest, testExactCardinality) {
+  RSGlobalConfig.numericExactCardinality = true;
+  RSGlobalConfig.numericHllPrecision = 10;
+  NumericRangeTree *t = NewNumericRangeTree();
+  RSGlobalConfig.numericExactCardinality = false;
+  RSGlobalConfig.numericHllPrecision = DEFAULT_NUMERIC_HLL_PRECISION;
+  ASSERT_EQ(t->root->range->hll.bits, 10);
+
+  // The root splits exactly when it gets its 16th distinct value
+  for (size_t i = 1; i <= 900; i++) {
+    NumericRangeTree_Add(t, i, i % 15, false);
+  }
+  ASSERT_EQ(t->numLeaves, 1);
+  ASSERT_EQ(NumericRange_GetCardinality(t->root->range), 15);
+  NumericRangeTree_Add(t, 901, 15, false);
+  ASSERT_EQ(t->numLeaves, 2);
+  ASSERT_EQ(t->root->left->range->hll.bits, 10);
+  ASSERT_EQ(NumericRange_GetCardinality(t->root->left->range) +
+            NumericRange_GetCardinality(t->root->right->range), 16);
+
+  // Once the exact values are dropped, the cardinality is estimated
+  NumericRange *r = t->root->right->range;
+  NumericRange_DropExactValues(r);
+  ASSERT_EQ(r->values, nullptr);
+  ASSERT_GT(NumericRange_GetCardinality(r), 0);
+  NumericRangeTree_Free(t);
+}
+
 /** Currently, a new tree always initialized with a single range node (root).
  * A range node contains an inverted index struct and at least one block with initial block capacity.
  */
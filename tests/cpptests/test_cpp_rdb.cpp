@@ -11,9 +11,16 @@
 #include "common.h"
 #include "redismock/redismock.h"
 
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+
 extern "C" {
 #include "spec.h"
 #include "query_error.h"
+#include "index_segment.h"
+#include "inverted_index.h"
+#include "iterators/inverted_index_iterator.h"
 
 // Forward declarations for RDB functions
 extern void Indexes_RdbSave(RedisModuleIO *rdb, int when);
@@ -258,3 +265,145 @@ TEST_F(RdbMockTest, testIndexSpecStringSerialize) {
     IndexSpec_RemoveFromGlobals(loaded_spec_ref, false);
     RedisModule_FreeString(NULL, serialized);
 }
+
+// Save the index and load it back with the given doc ids encoding, checking it has the same blocks
+static InvertedIndex *rdbReload(const InvertedIndex *idx, bool rawDocIds) {
+  RedisModuleIO *io = RMCK_CreateRdbIO();
+  InvertedIndex_RdbSave(io, idx);
+  io->read_pos = 0;
+  size_t memsize = 0;
+  InvertedIndex *loaded = InvertedIndex_RdbLoad_Ex(io, rawDocIds, false, &memsize);
+  RMCK_FreeRdbIO(io);
+  EXPECT_TRUE(loaded != nullptr);
+  if (!loaded) {
+    return nullptr;
+  }
+  EXPECT_EQ(InvertedIndex_MemUsage(loaded), memsize);
+  EXPECT_EQ(InvertedIndex_NumDocs(idx), InvertedIndex_NumDocs(loaded));
+  EXPECT_EQ(InvertedIndex_NumBlocks(idx), InvertedIndex_NumBlocks(loaded));
+  return loaded;
+}
+
+TEST_F(RdbMockTest, testInvertedIndexDenseAndPackedBlocks) {
+  const int previousConfig = RSGlobalConfig.invertedIndexRawDocidEncoding;
+  RSGlobalConfig.invertedIndexRawDocidEncoding = false;
+  size_t memsize = 0;
+  InvertedIndex *docIds = NewInvertedIndex(Index_DocIdsOnly, &memsize);
+  for (t_docId id = 1; id <= 2001; id++) {
+    RSIndexResult rec = {.docId = id * 2, .data = {.tag = RSResultData_Virtual}};
+    InvertedIndex_WriteEntryGeneric(docIds, &rec);
+  }
+  ASSERT_TRUE(IndexBlock_IsDense(InvertedIndex_BlockRef(docIds, 0)));
+
+  // The dense blocks are kept as they are, with their capacity
+  InvertedIndex *loaded = rdbReload(docIds, false);
+  ASSERT_TRUE(loaded != nullptr);
+  for (size_t i = 0; i < InvertedIndex_NumBlocks(docIds); i++) {
+    const IndexBlock *orig = InvertedIndex_BlockRef(docIds, i);
+    const IndexBlock *blk = InvertedIndex_BlockRef(loaded, i);
+    EXPECT_EQ(IndexBlock_IsDense(orig), IndexBlock_IsDense(blk)) << "block " << i;
+    EXPECT_EQ(IndexBlock_Cap(orig), IndexBlock_Cap(blk)) << "block " << i;
+    ASSERT_EQ(IndexBlock_Len(orig), IndexBlock_Len(blk)) << "block " << i;
+    EXPECT_EQ(0, memcmp(IndexBlock_Data(orig), IndexBlock_Data(blk), IndexBlock_Len(blk)));
+  }
+  InvertedIndex_Free(loaded);
+
+  // Under the other encoding, the ids are written again
+  loaded = rdbReload(docIds, true);
+  ASSERT_TRUE(loaded != nullptr);
+  FieldMaskOrIndex f = {.isFieldMask = true, .value = {.mask = RS_FIELDMASK_ALL}};
+  QueryIterator *it = NewInvIndIterator_TermQuery(loaded, nullptr, f, nullptr, 1);
+  for (t_docId id = 1; id <= 2001; id++) {
+    ASSERT_EQ(ITERATOR_OK, it->Read(it)) << "id " << id;
+    ASSERT_EQ(id * 2, it->lastDocId);
+  }
+  ASSERT_EQ(ITERATOR_EOF, it->Read(it));
+  it->Free(it);
+  InvertedIndex_Free(loaded);
+  InvertedIndex_Free(docIds);
+
+  InvertedIndex *numeric = NewInvertedIndex(Index_StoreNumeric, &memsize);
+  for (size_t i = 1; i <= 1000; i++) {
+    InvertedIndex_WriteNumericEntry(numeric, i, (double)i / 4);
+  }
+  ASSERT_GT(InvertedIndex_PackNumericBlock(numeric, 0), 0);
+
+  loaded = rdbReload(numeric, false);
+  ASSERT_TRUE(loaded != nullptr);
+  EXPECT_TRUE(IndexBlock_IsPacked(InvertedIndex_BlockRef(loaded, 0)));
+  EXPECT_EQ(InvertedIndex_NumEntries(numeric), InvertedIndex_NumEntries(loaded));
+  FieldMaskOrIndex fieldMaskOrIndex = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}};
+  FieldFilterContext fieldCtx = {.field = fieldMaskOrIndex, .predicate = FIELD_EXPIRATION_DEFAULT};
+  it = NewInvIndIterator_NumericQuery(loaded, nullptr, &fieldCtx, nullptr, nullptr, -INFINITY, INFINITY);
+  for (size_t i = 1; i <= 1000; i++) {
+    ASSERT_EQ(ITERATOR_OK, it->Read(it)) << "i=" << i;
+    ASSERT_EQ(i, it->lastDocId);
+    ASSERT_EQ((double)i / 4, IndexResult_NumValue(it->current));
+  }
+  ASSERT_EQ(ITERATOR_EOF, it->Read(it));
+  it->Free(it);
+  InvertedIndex_Free(loaded);
+  InvertedIndex_Free(numeric);
+  RSGlobalConfig.invertedIndexRawDocidEncoding = previousConfig;
+}
+
+TEST_F(RdbMockTest, testInvertedIndexSegment) {
+    size_t memsize = 0;
+    InvertedIndex *idx = NewInvertedIndex(Index_StoreNumeric, &memsize);
+    for (size_t i = 1; i <= 1000; i++) {
+        InvertedIndex_WriteNumericEntry(idx, i * 3, (double)i / 7);
+    }
+    const uint32_t numBlocks = InvertedIndex_NumBlocks(idx);
+    ASSERT_GT(numBlocks, 1);
+
+    const char *name = "redisearch-test.seg";
+    RedisModuleIO *io = RMCK_CreateRdbIO();
+    std::unique_ptr<RedisModuleIO, std::function<void(RedisModuleIO *)>> ioPtr(io, [](RedisModuleIO *io) {
+        RMCK_FreeRdbIO(io);
+    });
+    ASSERT_TRUE(IndexSegment_BeginWrite(name, 42));
+    InvertedIndex_RdbSave(io, idx);
+    ASSERT_TRUE(IndexSegment_EndWrite());
+
+    // The segment of another snapshot is not read
+    ASSERT_FALSE(IndexSegment_BeginRead(name, 43));
+    ASSERT_TRUE(IndexSegment_BeginRead(name, 42));
+    io->read_pos = 0;
+    InvertedIndex *loaded = InvertedIndex_RdbLoad(io, &memsize);
+    IndexSegment_EndRead();
+    unlink(name);
+    ASSERT_TRUE(loaded != nullptr);
+    ASSERT_EQ(numBlocks, InvertedIndex_NumBlocks(loaded));
+    for (uint32_t i = 0; i < numBlocks; i++) {
+        const IndexBlock *orig = InvertedIndex_BlockRef(idx, i);
+        const IndexBlock *blk = InvertedIndex_BlockRef(loaded, i);
+        // The blocks but the last one were copied from the segment, which is unmapped
+        ASSERT_EQ(IndexBlock_Len(orig), IndexBlock_Len(blk)) << "block " << i;
+        EXPECT_EQ(0, memcmp(IndexBlock_Data(orig), IndexBlock_Data(blk), IndexBlock_Len(blk)));
+    }
+
+    FieldMaskOrIndex fieldMaskOrIndex = {.isFieldMask = false, .value = {.index = RS_INVALID_FIELD_INDEX}};
+    FieldFilterContext fieldCtx = {.field = fieldMaskOrIndex, .predicate = FIELD_EXPIRATION_DEFAULT};
+    QueryIterator *it = NewInvIndIterator_NumericQuery(loaded, nullptr, &fieldCtx, nullptr, nullptr, -INFINITY, INFINITY);
+    for (size_t i = 1; i <= 1000; i++) {
+        ASSERT_EQ(ITERATOR_OK, it->Read(it)) << "i=" << i;
+        ASSERT_EQ(i * 3, it->lastDocId);
+        ASSERT_EQ((double)i / 7, IndexResult_NumValue(it->current));
+    }
+    ASSERT_EQ(ITERATOR_EOF, it->Read(it));
+    it->Free(it);
+
+    // The loaded index is written to, and freed, as any other
+    InvertedIndex_WriteNumericEntry(loaded, 3003, 1);
+    ASSERT_EQ(1001, InvertedIndex_NumDocs(loaded));
+    InvertedIndex_Free(loaded);
+
+    // Without the segment, its blocks are counted as missing
+    const size_t missing = IndexSegment_NumMissing();
+    io->read_pos = 0;
+    loaded = InvertedIndex_RdbLoad(io, &memsize);
+    ASSERT_TRUE(loaded != nullptr);
+    ASSERT_EQ(missing + numBlocks - 1, IndexSegment_NumMissing());
+    InvertedIndex_Free(loaded);
+    InvertedIndex_Free(idx);
+}
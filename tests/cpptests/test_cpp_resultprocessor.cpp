@@ -13,6 +13,11 @@
 #include "value.h"
 #include "gtest/gtest.h"
 #include "search_result.h"
+#include "extension.h"
+#include "doc_table.h"
+#include "config.h"
+
+#include <vector>
 
 struct processor1Ctx : public ResultProcessor {
   processor1Ctx() {
@@ -91,6 +96,178 @@ TEST_F(ResultProcessorTest, testProcessorChain) {
   RLookup_Cleanup(&lk);
 }
 
+TEST_F(ResultProcessorTest, testNextBatchFromRows) {
+  QueryProcessingCtx qitr = {0};
+  RLookup lk = {0};
+  processor1Ctx *p = new processor1Ctx();
+  p->Next = p1_Next;
+  p->Free = resultProcessor_GenericFree;
+  p->kout = RLookup_GetKey_Write(&lk, "foo", RLOOKUP_F_NOFLAGS);
+  QITR_PushRP(&qitr, p);
+
+  // The processor has no NextBatch, so the batch is read one result at a time
+  SearchResult batch[3] = {};
+  size_t len = 0;
+  ASSERT_EQ(RP_NextBatch(p, batch, 3, &len), RS_RESULT_OK);
+  ASSERT_EQ(len, 3);
+  for (size_t i = 0; i < len; i++) {
+    ASSERT_EQ(SearchResult_GetDocId(&batch[i]), i + 1);
+    SearchResult_Clear(&batch[i]);
+  }
+  // The last batch is partial, and carries the code that ended the stream
+  ASSERT_EQ(RP_NextBatch(p, batch, 3, &len), RS_RESULT_EOF);
+  ASSERT_EQ(len, NUM_RESULTS - 3);
+  for (size_t i = 0; i < len; i++) {
+    ASSERT_EQ(SearchResult_GetDocId(&batch[i]), i + 4);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    SearchResult_Destroy(&batch[i]);
+  }
+
+  QITR_FreeChain(&qitr);
+  RLookup_Cleanup(&lk);
+}
+
+static size_t numScored = 0;
+
+// Scores results by the order they are scored in, filtering out every second one
+static double filterEvenScorer(const ScoringFunctionArgs *ctx, const RSIndexResult *res,
+                               const RSDocumentMetadata *dmd, double minScore) {
+  numScored++;
+  return numScored % 2 ? numScored : RS_SCORE_FILTEROUT;
+}
+
+TEST_F(ResultProcessorTest, testBatchedChain) {
+  QueryProcessingCtx qitr = {0};
+  RLookup lk = {0};
+  processor1Ctx *p = new processor1Ctx();
+  p->Next = p1_Next;
+  p->Free = resultProcessor_GenericFree;
+  p->kout = RLookup_GetKey_Write(&lk, "foo", RLOOKUP_F_NOFLAGS);
+  QITR_PushRP(&qitr, p);
+
+  processor1Ctx *p2 = new processor1Ctx();
+  p2->Next = p2_Next;
+  p2->Free = resultProcessor_GenericFree;
+  QITR_PushRP(&qitr, p2);
+
+  numScored = 0;
+  ExtScoringFunctionCtx scoring = {.sf = filterEvenScorer};
+  ScoringFunctionArgs scargs = {0};
+  ResultProcessor *scorer = RPScorer_New(&scoring, &scargs, NULL);
+  ASSERT_TRUE(scorer->NextBatch != NULL);
+  QITR_PushRP(&qitr, scorer);
+
+  // The sorter reads the scorer in batches
+  QITR_PushRP(&qitr, RPSorter_NewByScore(10));
+
+  std::vector<t_docId> ids;
+  SearchResult r = {0};
+  ResultProcessor *rpTail = qitr.endProc;
+  while (rpTail->Next(rpTail, &r) == RS_RESULT_OK) {
+    ids.push_back(SearchResult_GetDocId(&r));
+    ASSERT_EQ(SearchResult_GetScore(&r), SearchResult_GetDocId(&r));
+    SearchResult_Clear(&r);
+  }
+  SearchResult_Destroy(&r);
+
+  ASSERT_EQ(ids, std::vector<t_docId>({5, 3, 1}));
+  ASSERT_EQ(numScored, NUM_RESULTS);
+  // The filtered out results are not counted
+  ASSERT_EQ(qitr.totalResults, 3);
+
+  QITR_FreeChain(&qitr);
+  RLookup_Cleanup(&lk);
+}
+
+static size_t numBatches = 0;
+
+// The batch version of filterEvenScorer
+static void filterEvenBatchScorer(const ScoringFunctionArgs *ctx,
+                                  const RSDocumentMetadata *const *dmds, size_t n,
+                                  double minScore, double *scores) {
+  numBatches++;
+  for (size_t i = 0; i < n; i++) {
+    scores[i] = filterEvenScorer(ctx, NULL, dmds[i], minScore);
+  }
+}
+
+TEST_F(ResultProcessorTest, testBatchScorer) {
+  QueryProcessingCtx qitr = {0};
+  RLookup lk = {0};
+  processor1Ctx *p = new processor1Ctx();
+  p->Next = p1_Next;
+  p->Free = resultProcessor_GenericFree;
+  p->kout = RLookup_GetKey_Write(&lk, "foo", RLOOKUP_F_NOFLAGS);
+  QITR_PushRP(&qitr, p);
+
+  processor1Ctx *p2 = new processor1Ctx();
+  p2->Next = p2_Next;
+  p2->Free = resultProcessor_GenericFree;
+  QITR_PushRP(&qitr, p2);
+
+  numScored = numBatches = 0;
+  ExtScoringFunctionCtx scoring = {.sf = filterEvenScorer, .bsf = filterEvenBatchScorer};
+  ScoringFunctionArgs scargs = {0};
+  QITR_PushRP(&qitr, RPScorer_New(&scoring, &scargs, NULL));
+  QITR_PushRP(&qitr, RPSorter_NewByScore(10));
+
+  std::vector<t_docId> ids;
+  SearchResult r = {0};
+  ResultProcessor *rpTail = qitr.endProc;
+  while (rpTail->Next(rpTail, &r) == RS_RESULT_OK) {
+    ids.push_back(SearchResult_GetDocId(&r));
+    ASSERT_EQ(SearchResult_GetScore(&r), SearchResult_GetDocId(&r));
+    SearchResult_Clear(&r);
+  }
+  SearchResult_Destroy(&r);
+
+  // All the results are scored in a single call, and filtered out as they would be one by one
+  ASSERT_EQ(numBatches, 1);
+  ASSERT_EQ(ids, std::vector<t_docId>({5, 3, 1}));
+  ASSERT_EQ(numScored, NUM_RESULTS);
+  ASSERT_EQ(qitr.totalResults, 3);
+
+  QITR_FreeChain(&qitr);
+  RLookup_Cleanup(&lk);
+}
+
+TEST_F(ResultProcessorTest, testSorterScoreThreshold) {
+  QueryProcessingCtx qitr = {0};
+  RLookup lk = {0};
+  processor1Ctx *p = new processor1Ctx();
+  p->Next = p1_Next;
+  p->Free = resultProcessor_GenericFree;
+  p->kout = RLookup_GetKey_Write(&lk, "foo", RLOOKUP_F_NOFLAGS);
+  QITR_PushRP(&qitr, p);
+
+  processor1Ctx *p2 = new processor1Ctx();
+  p2->Next = p2_Next;
+  p2->Free = resultProcessor_GenericFree;
+  QITR_PushRP(&qitr, p2);
+
+  ResultProcessor *sorter = RPSorter_NewByScore(10);
+  RPSorter_SetScoreThreshold(sorter, 3);
+  QITR_PushRP(&qitr, sorter);
+
+  std::vector<t_docId> ids;
+  SearchResult r = {0};
+  ResultProcessor *rpTail = qitr.endProc;
+  while (rpTail->Next(rpTail, &r) == RS_RESULT_OK) {
+    ids.push_back(SearchResult_GetDocId(&r));
+    SearchResult_Clear(&r);
+  }
+  SearchResult_Destroy(&r);
+
+  // The results scoring below the threshold are dropped even though the heap is not full, but
+  // they are still counted
+  ASSERT_EQ(ids, std::vector<t_docId>({5, 4, 3}));
+  ASSERT_EQ(qitr.totalResults, NUM_RESULTS);
+
+  QITR_FreeChain(&qitr);
+  RLookup_Cleanup(&lk);
+}
+
 /*
  * Test SearchResult_mergeFlags function with no flags set
  */
@@ -115,3 +292,174 @@ TEST_F(ResultProcessorTest, testmergeFlags_ExpiredDoc) {
   SearchResult_MergeFlags(&a, &b);
   EXPECT_TRUE(SearchResult_GetFlags(&a) & Result_ExpiredDoc);
 }
+
+/*
+ * A result which borrows its metadata holds no reference to it until it is pinned
+ */
+TEST_F(ResultProcessorTest, testBorrowedDmd) {
+  RSDocumentMetadata *dmd = DMD_Alloc();
+  dmd->ref_count = 1;
+
+  SearchResult r = {0};
+  SearchResult_SetDocumentMetadata(&r, dmd);
+  SearchResult_SetFlags(&r, Result_BorrowedDmd);
+  SearchResult_Clear(&r);
+  ASSERT_EQ(dmd->ref_count, 1);
+  ASSERT_EQ(SearchResult_GetFlags(&r), 0);
+
+  SearchResult_SetDocumentMetadata(&r, dmd);
+  SearchResult_SetFlags(&r, Result_BorrowedDmd | Result_ExpiredDoc);
+  SearchResult_PinDocumentMetadata(&r);
+  ASSERT_EQ(dmd->ref_count, 2);
+  ASSERT_EQ(SearchResult_GetFlags(&r), Result_ExpiredDoc);
+  // Pinning an owned metadata does nothing
+  SearchResult_PinDocumentMetadata(&r);
+  ASSERT_EQ(dmd->ref_count, 2);
+
+  // The borrowed flag is not merged into another result
+  SearchResult b = {0};
+  SearchResult_SetFlags(&b, Result_BorrowedDmd);
+  SearchResult_MergeFlags(&r, &b);
+  ASSERT_EQ(SearchResult_GetFlags(&r), Result_ExpiredDoc);
+
+  SearchResult_Destroy(&r);
+  ASSERT_EQ(dmd->ref_count, 1);
+  DMD_Return(dmd);
+}
+
+/*
+ * A freed result is reused empty, with its row array, by the next one the thread allocates
+ */
+TEST_F(ResultProcessorTest, testPooledResults) {
+  RLookup lk = {0};
+  RLookupKey *k = RLookup_GetKey_Write(&lk, "foo", RLOOKUP_F_NOFLAGS);
+
+  SearchResult *r = SearchResult_New();
+  SearchResult_SetDocId(r, 42);
+  SearchResult_SetScore(r, 4.2);
+  SearchResult_SetFlags(r, Result_ExpiredDoc);
+  RLookup_WriteOwnKey(k, SearchResult_GetRowDataMut(r), RSValue_NewNumber(42));
+  RSValue **dyn = SearchResult_GetRowData(r)->dyn;
+  SearchResult_Free(r);
+
+  SearchResult *r2 = SearchResult_New();
+  ASSERT_EQ(SearchResult_GetDocId(r2), 0);
+  ASSERT_EQ(SearchResult_GetScore(r2), 0);
+  ASSERT_EQ(SearchResult_GetFlags(r2), 0);
+  ASSERT_EQ(SearchResult_GetRowData(r2)->ndyn, 0);
+  ASSERT_EQ(RLookup_GetItem(k, SearchResult_GetRowData(r2)), nullptr);
+  if (!getenv("REDISEARCH_NO_MEMPOOL") && !RSGlobalConfig.noMemPool) {
+    ASSERT_EQ(r2, r);
+    ASSERT_EQ(SearchResult_GetRowData(r2)->dyn, dyn);
+  }
+
+  // Moving a result out of an allocated one leaves the target owning its fields
+  RLookup_WriteOwnKey(k, SearchResult_GetRowDataMut(r2), RSValue_NewNumber(7));
+  SearchResult out = {0};
+  SearchResult_MoveFree(&out, r2);
+  RSValue *v = RLookup_GetItem(k, SearchResult_GetRowData(&out));
+  ASSERT_TRUE(v != NULL);
+  ASSERT_EQ(7, RSValue_Number_Get(v));
+  SearchResult *r3 = SearchResult_New();
+  ASSERT_EQ(SearchResult_GetRowData(r3)->dyn, nullptr);
+  SearchResult_Free(r3);
+
+  SearchResult_Destroy(&out);
+  RLookup_Cleanup(&lk);
+}
+
+// Yields one result per value, writing it (if any) to `key`
+struct SortInput : public ResultProcessor {
+  SortInput(const std::vector<RSValue *> &values, const RLookupKey *key) : values(values), key(key) {
+    memset(static_cast<ResultProcessor *>(this), 0, sizeof(ResultProcessor));
+    Next = NextFn;
+    Free = FreeFn;
+  }
+  static int NextFn(ResultProcessor *rp, SearchResult *res) {
+    SortInput *self = static_cast<SortInput *>(rp);
+    if (self->counter >= self->values.size()) return RS_RESULT_EOF;
+    RSValue *v = self->values[self->counter++];
+    SearchResult_SetDocId(res, self->counter);
+    if (v) {
+      RLookup_WriteKey(self->key, SearchResult_GetRowDataMut(res), v);
+    }
+    return RS_RESULT_OK;
+  }
+  static void FreeFn(ResultProcessor *rp) {
+    delete static_cast<SortInput *>(rp);
+  }
+  const std::vector<RSValue *> &values;
+  const RLookupKey *key;
+  size_t counter = 0;
+};
+
+static std::vector<t_docId> sortValues(const std::vector<RSValue *> &values, RLookupKey *key,
+                                       size_t k, bool asc, bool numeric) {
+  // The numeric selection is picked when the sorter is created
+  if (numeric) {
+    key->flags |= RLOOKUP_T_NUMERIC;
+  } else {
+    key->flags &= ~RLOOKUP_T_NUMERIC;
+  }
+  uint64_t ascMap = SORTASCMAP_INIT;
+  if (!asc) SORTASCMAP_SETDESC(ascMap, 0);
+  const RLookupKey *keys[] = {key};
+
+  QueryProcessingCtx qitr = {0};
+  QITR_PushRP(&qitr, new SortInput(values, key));
+  QITR_PushRP(&qitr, RPSorter_NewByFields(k, keys, 1, ascMap));
+
+  std::vector<t_docId> ids;
+  SearchResult r = {0};
+  while (qitr.endProc->Next(qitr.endProc, &r) == RS_RESULT_OK) {
+    ids.push_back(SearchResult_GetDocId(&r));
+    SearchResult_Clear(&r);
+  }
+  SearchResult_Destroy(&r);
+  QITR_FreeChain(&qitr);
+  return ids;
+}
+
+class NumericSorterTest : public ::testing::TestWithParam<bool> {
+protected:
+  RLookup lk = {0};
+  RLookupKey *key;
+  std::vector<RSValue *> values;
+
+  void SetUp() override {
+    key = RLookup_GetKey_Write(&lk, "n", RLOOKUP_F_NOFLAGS);
+    // Many ties, and some results without a value
+    srand(42);
+    for (size_t i = 0; i < 5000; i++) {
+      values.push_back(i % 7 ? RSValue_NewNumber(rand() % 300 - 100) : NULL);
+    }
+  }
+  void TearDown() override {
+    for (RSValue *v : values) {
+      if (v && v != RSValue_NullStatic()) RSValue_DecrRef(v);
+    }
+    RLookup_Cleanup(&lk);
+  }
+};
+
+TEST_P(NumericSorterTest, MatchesGenericSort) {
+  bool asc = GetParam();
+  for (size_t k : {1, 10, 333, 5000, 10000}) {
+    std::vector<t_docId> expected = sortValues(values, key, k, asc, false);
+    ASSERT_EQ(expected.size(), std::min<size_t>(k, values.size()));
+    ASSERT_EQ(sortValues(values, key, k, asc, true), expected) << "k=" << k;
+  }
+}
+
+TEST_P(NumericSorterTest, FallbackOnNonNumericValue) {
+  bool asc = GetParam();
+  // A value that can't be compared as a plain number moves the sorter to the generic heap
+  RSValue_DecrRef(values[2500]);
+  values[2500] = RSValue_NullStatic();
+  for (size_t k : {10, 3000}) {
+    std::vector<t_docId> expected = sortValues(values, key, k, asc, false);
+    ASSERT_EQ(sortValues(values, key, k, asc, true), expected) << "k=" << k;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(NumericSorter, NumericSorterTest, ::testing::Bool());
@@ -11,6 +11,9 @@
 #include "value.h"
 #include "gtest/gtest.h"
 
+#include <string>
+#include <vector>
+
 class RLookupTest : public ::testing::Test {};
 
 TEST_F(RLookupTest, testInit) {
@@ -37,6 +40,42 @@ TEST_F(RLookupTest, testFlags) {
   RLookup_Cleanup(&lk);
 }
 
+TEST_F(RLookupTest, testManyKeys) {
+  // Lookups with many keys find them through their index, which follows the overridden keys
+  RLookup lk = {0};
+  RLookup_Init(&lk, NULL);
+  const size_t n = 200;
+  std::vector<RLookupKey *> keys;
+  auto name = [](size_t i) { return "key" + std::to_string(i); };
+  for (size_t i = 0; i < n; i++) {
+    std::string nm = name(i);
+    keys.push_back(RLookup_GetKey_WriteEx(&lk, nm.c_str(), nm.size(), RLOOKUP_F_NAMEALLOC));
+    ASSERT_TRUE(keys.back());
+  }
+  for (size_t i = 0; i < n; i++) {
+    std::string nm = name(i);
+    ASSERT_EQ(keys[i], RLookup_GetKey_ReadEx(&lk, nm.c_str(), nm.size(), RLOOKUP_F_NOFLAGS));
+    ASSERT_EQ(NULL, RLookup_GetKey_WriteEx(&lk, nm.c_str(), nm.size(), RLOOKUP_F_NOFLAGS));
+  }
+
+  for (size_t i = 0; i < n; i += 3) {
+    std::string nm = name(i);
+    RLookupKey *k = RLookup_GetKey_WriteEx(&lk, nm.c_str(), nm.size(), RLOOKUP_F_OVERRIDE);
+    ASSERT_TRUE(k);
+    ASSERT_NE(keys[i], k);
+    ASSERT_EQ(keys[i]->dstidx, k->dstidx);
+    keys[i] = k;
+  }
+  for (size_t i = 0; i < n; i++) {
+    std::string nm = name(i);
+    ASSERT_EQ(keys[i], RLookup_GetKey_ReadEx(&lk, nm.c_str(), nm.size(), RLOOKUP_F_NOFLAGS));
+  }
+  ASSERT_EQ(NULL, RLookup_GetKey_Read(&lk, "missing", RLOOKUP_F_NOFLAGS));
+  ASSERT_EQ(n, lk.rowlen);
+
+  RLookup_Cleanup(&lk);
+}
+
 TEST_F(RLookupTest, testRow) {
   RLookup lk = {0};
   RLookup_Init(&lk, NULL);
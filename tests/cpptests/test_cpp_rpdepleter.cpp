@@ -345,6 +345,67 @@ TEST_P(RPDepleterTest, RPDepleter_Error) {
   depleter->Free(depleter);
 }
 
+TEST_P(RPDepleterTest, RPDepleter_StartAll) {
+  // Tests that `RPDepleter_StartAll` runs the pipelines of the depleters at the same time: each
+  // upstream only returns its result once both of them started. Processors which are not depleters
+  // are skipped.
+
+  bool take_index_lock = GetParam();
+  static std::atomic<int> started;
+  started = 0;
+
+  struct ConcurrentUpstream : public ResultProcessor {
+    bool done = false;
+    static int NextFn(ResultProcessor *rp, SearchResult *res) {
+      ConcurrentUpstream *self = (ConcurrentUpstream *)rp;
+      if (self->done) return RS_RESULT_EOF;
+      self->done = true;
+      started++;
+      for (int i = 0; i < 500 && started < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      SearchResult_SetDocId(res, started);
+      return RS_RESULT_OK;
+    }
+    ConcurrentUpstream() {
+      memset(this, 0, sizeof(*this));
+      this->Next = NextFn;
+    }
+  } upstream1, upstream2, notDepleter;
+
+  QueryProcessingCtx qitr1 = {0}, qitr2 = {0};
+  StrongRef sync_ref = DepleterSync_New(2, take_index_lock);
+  ResultProcessor *depleter1 = RPDepleter_New(StrongRef_Clone(sync_ref), &searchContexts[0], &searchContexts[2]);
+  ResultProcessor *depleter2 = RPDepleter_New(StrongRef_Clone(sync_ref), &searchContexts[1], &searchContexts[2]);
+  StrongRef_Release(sync_ref);
+  QITR_PushRP(&qitr1, &upstream1);
+  QITR_PushRP(&qitr1, depleter1);
+  QITR_PushRP(&qitr2, &upstream2);
+  QITR_PushRP(&qitr2, depleter2);
+
+  ResultProcessor *rps[] = {depleter1, &notDepleter, depleter2};
+  RPDepleter_StartAll(rps, 3);
+  // Started once only
+  RPDepleter_StartAll(rps, 3);
+
+  SearchResult res = {0};
+  for (ResultProcessor *depleter : {depleter1, depleter2}) {
+    int rc;
+    while ((rc = depleter->Next(depleter, &res)) == RS_RESULT_DEPLETING) {}
+    ASSERT_EQ(rc, RS_RESULT_OK);
+    // Both upstreams were running when the result was returned
+    ASSERT_EQ(SearchResult_GetDocId(&res), 2);
+    SearchResult_Clear(&res);
+    ASSERT_EQ(depleter->Next(depleter, &res), RS_RESULT_EOF);
+  }
+  ASSERT_EQ(started, 2);
+  ASSERT_FALSE(notDepleter.done);
+
+  SearchResult_Destroy(&res);
+  depleter1->Free(depleter1);
+  depleter2->Free(depleter2);
+}
+
 // Instantiate the parameterized test with both true and false values
 INSTANTIATE_TEST_SUITE_P(
     LockingVariants,
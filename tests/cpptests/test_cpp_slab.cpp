@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "rmutil/alloc.h"
+#include "gtest/gtest.h"
+
+#include "src/util/slab.h"
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+class SlabTest : public ::testing::Test {};
+
+TEST_F(SlabTest, AllocAndFree) {
+  Slab slab = SLAB_INITIALIZER(20);
+  ASSERT_EQ(24, Slab_ObjectSize(&slab));
+  ASSERT_EQ(0, Slab_MemUsage(&slab));
+
+  // Enough objects for several chunks
+  const size_t n = 3 * SLAB_CHUNK_SIZE / 24;
+  std::vector<char *> objs;
+  for (size_t i = 0; i < n; i++) {
+    char *obj = (char *)Slab_Alloc(&slab);
+    ASSERT_EQ(0, (uintptr_t)obj % 8);
+    for (size_t j = 0; j < 24; j++) {
+      ASSERT_EQ(0, obj[j]);
+    }
+    memset(obj, (int)(i % 256), 24);
+    objs.push_back(obj);
+  }
+  ASSERT_EQ(n, Slab_NumObjects(&slab));
+  ASSERT_EQ(n, std::set<char *>(objs.begin(), objs.end()).size());
+  size_t fullMem = Slab_MemUsage(&slab);
+  ASSERT_GE(fullMem, n * 24);
+
+  // The freed objects are reused before any chunk is added
+  for (size_t i = 0; i < n; i += 2) {
+    Slab_Free(&slab, objs[i]);
+  }
+  for (size_t i = 1; i < n; i += 2) {
+    ASSERT_EQ((char)(i % 256), objs[i][23]);
+  }
+  std::set<char *> freed;
+  for (size_t i = 0; i < n; i += 2) {
+    freed.insert(objs[i]);
+  }
+  for (size_t i = 0; i < n; i += 2) {
+    char *obj = (char *)Slab_Alloc(&slab);
+    ASSERT_EQ(1, freed.erase(obj));
+    objs[i] = obj;
+  }
+  ASSERT_EQ(fullMem, Slab_MemUsage(&slab));
+
+  // All the chunks are released with the last object
+  for (char *obj : objs) {
+    Slab_Free(&slab, obj);
+  }
+  ASSERT_EQ(0, Slab_NumObjects(&slab));
+  ASSERT_EQ(0, Slab_MemUsage(&slab));
+}
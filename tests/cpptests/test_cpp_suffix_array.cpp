@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "suffix_array.h"
+#include "redisearch.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class SuffixArrayTest : public ::testing::Test {};
+
+static int collectTerm(const char *s, size_t len, void *ctx, void *payload) {
+  static_cast<std::vector<std::string> *>(ctx)->emplace_back(s, len);
+  return REDISEARCH_OK;
+}
+
+static std::vector<std::string> containing(const SuffixArray *sa, const std::string &str,
+                                           bool suffixOnly = false) {
+  std::vector<std::string> terms;
+  SuffixArray_IterateContains(sa, str.c_str(), str.size(), suffixOnly, collectTerm, &terms, NULL);
+  std::sort(terms.begin(), terms.end());
+  return terms;
+}
+
+TEST_F(SuffixArrayTest, testContains) {
+  SuffixArray *sa = NewSuffixArray();
+  for (const char *term : {"hello", "yellow", "mellow", "low", "hello"}) {
+    SuffixArray_Add(sa, term, strlen(term));
+  }
+  ASSERT_EQ(4, SuffixArray_NumTerms(sa));
+
+  ASSERT_EQ(std::vector<std::string>({"hello", "mellow", "yellow"}), containing(sa, "ell"));
+  ASSERT_EQ(std::vector<std::string>({"low", "mellow", "yellow"}), containing(sa, "low", true));
+  ASSERT_EQ(std::vector<std::string>({"hello"}), containing(sa, "llo", true));
+  // A term containing the string several times is only returned once
+  SuffixArray_Add(sa, "lololo", 6);
+  ASSERT_EQ(std::vector<std::string>({"lololo"}), containing(sa, "lol"));
+  ASSERT_TRUE(containing(sa, "xyz").empty());
+
+  SuffixArray_Delete(sa, "mellow", 6);
+  SuffixArray_Delete(sa, "missing", 7);
+  ASSERT_EQ(std::vector<std::string>({"low", "yellow"}), containing(sa, "low", true));
+  SuffixArray_Free(sa);
+}
+
+TEST_F(SuffixArrayTest, testSegments) {
+  // Enough terms for several segments to be built and merged
+  const size_t n = SUFFIX_ARRAY_PENDING_TERMS * 5 + 17;
+  std::vector<std::string> terms;
+  SuffixArray *sa = NewSuffixArray();
+  for (size_t i = 0; i < n; ++i) {
+    terms.push_back("term" + std::to_string(i));
+    SuffixArray_Add(sa, terms.back().c_str(), terms.back().size());
+  }
+  ASSERT_EQ(n, SuffixArray_NumTerms(sa));
+
+  auto expected = [&](const std::string &str, bool suffixOnly) {
+    std::vector<std::string> res;
+    for (const auto &term : terms) {
+      size_t pos = term.rfind(str);
+      if (pos != std::string::npos && (!suffixOnly || pos + str.size() == term.size())) {
+        res.push_back(term);
+      }
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+  };
+  for (const char *str : {"123", "m12", "0", "term", "5136"}) {
+    ASSERT_EQ(expected(str, false), containing(sa, str)) << str;
+    ASSERT_EQ(expected(str, true), containing(sa, str, true)) << str;
+  }
+
+  // Deleting most of the terms rebuilds their segments without them
+  std::vector<std::string> kept;
+  for (size_t i = 0; i < n; ++i) {
+    if (i % 10) {
+      SuffixArray_Delete(sa, terms[i].c_str(), terms[i].size());
+    } else {
+      kept.push_back(terms[i]);
+    }
+  }
+  terms = kept;
+  ASSERT_EQ(terms.size(), SuffixArray_NumTerms(sa));
+  for (const char *str : {"123", "m12", "0", "term"}) {
+    ASSERT_EQ(expected(str, false), containing(sa, str)) << str;
+    ASSERT_EQ(expected(str, true), containing(sa, str, true)) << str;
+  }
+
+  // A deleted term can be added again
+  SuffixArray_Add(sa, "term1234", 8);
+  terms.push_back("term1234");
+  ASSERT_EQ(expected("123", false), containing(sa, "123"));
+  SuffixArray_Free(sa);
+}
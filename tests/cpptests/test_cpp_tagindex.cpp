@@ -11,6 +11,8 @@
 #include "triemap.h"
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <string>
 
@@ -39,16 +41,15 @@ TEST_F(TagIndexTest, testCreate) {
 
   // expectedTotalSZ should include the memory occupied by the inverted index
   // structure and its blocks.
-
-  // Buffer grows up to 1106 bytes trying to store 1000 bytes - it doubles each time
-  size_t buffer_cap = 1106;
-  size_t num_blocks = N / 1000;
-
-  // The size of the inverted index structure is 40 bytes
-  size_t iv_index_size = 40;
-
-  // Each index block is 48 bytes + its buffer capacity
-  size_t expectedTotalSZ = v.size() * (iv_index_size + ((buffer_cap + 48) * num_blocks));
+  size_t expectedTotalSZ = 0;
+  for (auto s : v) {
+    size_t sz;
+    InvertedIndex *iv = TagIndex_OpenIndex(idx, s, strlen(s), 0, &sz);
+    ASSERT_TRUE(iv != NULL);
+    expectedTotalSZ += InvertedIndex_MemUsage(iv);
+    // Blocks grow with the size of the index, so it takes fewer than N / 1000 of them
+    ASSERT_LT(InvertedIndex_NumBlocks(iv), N / 1000);
+  }
   ASSERT_EQ(expectedTotalSZ, totalSZ);
 
   // Add a new entry to and check the last block size
@@ -97,6 +98,204 @@ TEST_F(TagIndexTest, testSkipToLastId) {
   TagIndex_Free(idx);
 }
 
+static std::vector<std::string> tagValues(const TagIndex *idx, const char *pattern, tm_iter_mode mode) {
+  std::vector<std::string> values;
+  TagValuesIterator *it = TagIndex_IterateValues(idx, pattern, pattern ? strlen(pattern) : 0, mode);
+  char *str;
+  tm_len_t len;
+  InvertedIndex *iv;
+  while (TagValuesIterator_Next(it, &str, &len, &iv)) {
+    values.emplace_back(str, len);
+  }
+  TagValuesIterator_Free(it);
+  return values;
+}
+
+static void collectRange(const char *str, size_t len, void *ctx, void *iv) {
+  static_cast<std::vector<std::string> *>(ctx)->emplace_back(str, len);
+}
+
+TEST_F(TagIndexTest, testCompact) {
+  TagIndex *idx = NewTagIndex();
+  char buf[32];
+  for (t_docId d = 1; d <= 1000; d++) {
+    snprintf(buf, sizeof(buf), "sku:%04d", (int)d - 1);
+    const char *v = buf;
+    TagIndex_Index(idx, &v, 1, d);
+  }
+  size_t trieOverhead = TrieMap_MemUsage(idx->values);
+  TagIndex_Compact(idx);
+  ASSERT_EQ(0, TrieMap_NUniqueKeys(idx->values));
+  ASSERT_EQ(1000, idx->numFrozen);
+  ASSERT_EQ(1000, TagIndex_NumValues(idx));
+  ASSERT_LT(FrontCodedDict_MemUsage(idx->frozen), trieOverhead);
+
+  QueryIterator *it = TagIndex_OpenReader(idx, NULL, "sku:0005", 8, 1, RS_INVALID_FIELD_INDEX);
+  ASSERT_TRUE(it != NULL);
+  ASSERT_EQ(ITERATOR_OK, it->Read(it));
+  ASSERT_EQ(6, it->lastDocId);
+  ASSERT_EQ(ITERATOR_EOF, it->Read(it));
+  it->Free(it);
+
+  // A new value goes to the trie, and a compacted one keeps its inverted index
+  std::vector<const char *> v{"sku:0001", "sku:1000"};
+  TagIndex_Index(idx, &v[0], v.size(), 1001);
+  ASSERT_EQ(1, TrieMap_NUniqueKeys(idx->values));
+  size_t sz;
+  InvertedIndex *iv = TagIndex_OpenIndex(idx, "sku:0001", 8, 0, &sz);
+  ASSERT_EQ(2, InvertedIndex_NumDocs(iv));
+
+  // Both parts are iterated in order
+  std::vector<std::string> expected{"sku:0990", "sku:0991", "sku:0992", "sku:0993", "sku:0994",
+                                    "sku:0995", "sku:0996", "sku:0997", "sku:0998", "sku:0999",
+                                    "sku:1000"};
+  ASSERT_EQ(std::vector<std::string>(expected.begin(), expected.end() - 1),
+            tagValues(idx, "sku:099", TM_PREFIX_MODE));
+  ASSERT_EQ(std::vector<std::string>(expected.begin(), expected.end() - 1),
+            tagValues(idx, "sku:099*", TM_WILDCARD_MODE));
+  std::vector<std::string> values = tagValues(idx, "sku:*0", TM_WILDCARD_MODE);
+  ASSERT_EQ(101, values.size());
+  ASSERT_EQ("sku:0990", values[99]);
+  ASSERT_EQ("sku:1000", values[100]);
+  ASSERT_EQ(std::vector<std::string>({"sku:0999"}), tagValues(idx, "999", TM_SUFFIX_MODE));
+  ASSERT_EQ(std::vector<std::string>({"sku:0100", "sku:1000"}), tagValues(idx, "100", TM_CONTAINS_MODE));
+  ASSERT_EQ(1001, tagValues(idx, NULL, TM_PREFIX_MODE).size());
+
+  std::vector<std::string> range;
+  TagIndex_IterateRange(idx, "sku:0998", 8, false, "sku:1000", 8, true, collectRange, &range);
+  ASSERT_EQ(std::vector<std::string>({"sku:1000", "sku:0999"}), range);
+
+  // A deleted value is skipped, until it is added again
+  TagIndex_DeleteValue(idx, "sku:0002", 8);
+  ASSERT_EQ(1000, TagIndex_NumValues(idx));
+  ASSERT_EQ(TRIEMAP_NOTFOUND, TagIndex_OpenIndex(idx, "sku:0002", 8, 0, &sz));
+  values = tagValues(idx, "sku:000", TM_PREFIX_MODE);
+  ASSERT_EQ(9, values.size());
+  ASSERT_EQ("sku:0003", values[2]);
+  TagIndex_DeleteValue(idx, "sku:1000", 8);
+  ASSERT_EQ(0, TrieMap_NUniqueKeys(idx->values));
+  const char *readded = "sku:0002";
+  TagIndex_Index(idx, &readded, 1, 1002);
+  ASSERT_EQ(1000, TagIndex_NumValues(idx));
+  ASSERT_EQ(0, TrieMap_NUniqueKeys(idx->values));
+
+  // Compacting again merges the trie into the dictionary
+  const char *added = "sku:0002a";
+  TagIndex_Index(idx, &added, 1, 1003);
+  TagIndex_Compact(idx);
+  ASSERT_EQ(1001, idx->numFrozen);
+  ASSERT_EQ(std::vector<std::string>({"sku:0002", "sku:0002a"}), tagValues(idx, "sku:0002", TM_PREFIX_MODE));
+  TagIndex_Free(idx);
+}
+
+static std::vector<t_docId> setIds(TagIndex *idx, std::vector<const char *> values) {
+  std::vector<char *> v;
+  for (auto s : values) {
+    v.push_back(const_cast<char *>(s));
+  }
+  std::vector<t_docId> ids;
+  QueryIterator *it = TagIndex_OpenSetReader(idx, NULL, &v[0], v.size(), 1, RS_INVALID_FIELD_INDEX);
+  if (!it) {
+    return ids;
+  }
+  while (ITERATOR_EOF != it->Read(it)) {
+    ids.push_back(it->lastDocId);
+  }
+  it->Free(it);
+  return ids;
+}
+
+static size_t numCachedSets(const TagIndex *idx) {
+  size_t n = 0;
+  for (size_t i = 0; i < TAG_SET_CACHE_SIZE; i++) {
+    n += idx->setCache.entries[i].key != NULL;
+  }
+  return n;
+}
+
+TEST_F(TagIndexTest, testSetReader) {
+  TagIndex *idx = NewTagIndex();
+  char buf[32];
+  for (t_docId d = 1; d <= 200; d++) {
+    snprintf(buf, sizeof(buf), "u%d", (int)(d % 10));
+    const char *v[] = {buf, "all"};
+    TagIndex_Index(idx, v, 2, d);
+  }
+
+  std::vector<t_docId> expected;
+  for (t_docId d = 1; d <= 200; d++) {
+    if (d % 10 == 1 || d % 10 == 3) {
+      expected.push_back(d);
+    }
+  }
+  // The duplicates and the missing values are ignored, and the set is cached whatever its order
+  ASSERT_EQ(expected, setIds(idx, {"u3", "u1", "missing", "u3"}));
+  ASSERT_EQ(1, numCachedSets(idx));
+  ASSERT_EQ(expected, setIds(idx, {"u1", "missing", "u3"}));
+  ASSERT_EQ(1, numCachedSets(idx));
+  ASSERT_EQ(200, setIds(idx, {"u1", "all"}).size());
+  ASSERT_EQ(2, numCachedSets(idx));
+  ASSERT_TRUE(setIds(idx, {"missing", "other"}).empty());
+
+  // Indexing a document invalidates the cached sets
+  const char *v = "u1";
+  TagIndex_Index(idx, &v, 1, 100000);
+  expected.push_back(100000);
+  ASSERT_EQ(expected, setIds(idx, {"u1", "u3"}));
+
+  // The ids of a sparse set are sorted rather than set in a bitmap
+  const char *sparse[] = {"s1", "s2"};
+  TagIndex_Index(idx, &sparse[1], 1, 150000);
+  TagIndex_Index(idx, &sparse[0], 1, 200000);
+  TagIndex_Index(idx, sparse, 2, 300000);
+  ASSERT_EQ(std::vector<t_docId>({150000, 200000, 300000}), setIds(idx, {"s2", "s1"}));
+  TagIndex_Free(idx);
+}
+
+static std::vector<std::pair<std::string, size_t>> topValues(TagIndex *idx, const uint64_t *docs,
+                                                            size_t nwords, size_t max) {
+  std::vector<std::pair<std::string, size_t>> res;
+  TagValueCount *counts = TagIndex_TopValues(idx, NULL, docs, nwords, max, RS_INVALID_FIELD_INDEX);
+  for (size_t i = 0; i < array_len(counts); i++) {
+    res.emplace_back(std::string(counts[i].value, counts[i].len), counts[i].count);
+  }
+  TagValueCounts_Free(counts);
+  return res;
+}
+
+TEST_F(TagIndexTest, testTopValues) {
+  TagIndex *idx = NewTagIndex();
+  // Document d has the values v1 to v(d % 5 + 1)
+  for (t_docId d = 1; d <= 100; d++) {
+    const char *v[] = {"v1", "v2", "v3", "v4", "v5"};
+    TagIndex_Index(idx, v, d % 5 + 1, d);
+  }
+  typedef std::vector<std::pair<std::string, size_t>> Counts;
+  ASSERT_EQ(Counts({{"v1", 100}, {"v2", 80}, {"v3", 60}}), topValues(idx, NULL, 0, 3));
+  ASSERT_EQ(5, topValues(idx, NULL, 0, 0).size());
+
+  // The cached frequencies are refreshed once the index changes
+  const char *other = "other";
+  for (t_docId d = 101; d <= 190; d++) {
+    TagIndex_Index(idx, &other, 1, d);
+  }
+  ASSERT_EQ(Counts({{"v1", 100}, {"other", 90}}), topValues(idx, NULL, 0, 2));
+
+  // Only the documents of the set are counted: the multiples of 5 only have v1
+  uint64_t docs[3] = {0};
+  for (t_docId d = 5; d <= 190; d += 5) {
+    docs[d / 64] |= 1ULL << (d % 64);
+  }
+  ASSERT_EQ(Counts({{"v1", 20}, {"other", 18}}), topValues(idx, docs, 3, 0));
+  ASSERT_EQ(Counts({{"v1", 20}}), topValues(idx, docs, 3, 1));
+
+  // Ties are ordered by value
+  std::fill(docs, docs + 3, 0);
+  docs[0] = 1ULL << 4;  // v1 to v5
+  ASSERT_EQ(Counts({{"v1", 1}, {"v2", 1}}), topValues(idx, docs, 3, 2));
+  TagIndex_Free(idx);
+}
+
 #define TEST_MY_SEP(sep, str)                            \
   orig = s = strdup(str);                                \
   token = TagIndex_SepString(sep, &s, &tokenLen, false); \
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "rmutil/alloc.h"
+#include "gtest/gtest.h"
+
+#include "src/term_index_cache.h"
+#include "src/util/fnv.h"
+
+#include <string>
+
+class TermIndexCacheTest : public ::testing::Test {
+protected:
+  TermIndexCache *cache;
+
+  void SetUp() override {
+    cache = NewTermIndexCache();
+  }
+  void TearDown() override {
+    TermIndexCache_Free(cache);
+  }
+
+  static uint32_t hash(const std::string &term) {
+    return rs_fnv_32a_buf(term.c_str(), term.size(), 0);
+  }
+  void put(const std::string &term, uintptr_t idx) {
+    TermIndexCache_Put(cache, term.c_str(), term.size(), hash(term), (InvertedIndex *)idx);
+  }
+  uintptr_t get(const std::string &term) {
+    return (uintptr_t)TermIndexCache_Get(cache, term.c_str(), term.size(), hash(term));
+  }
+};
+
+TEST_F(TermIndexCacheTest, GetPutRemove) {
+  ASSERT_EQ(0, get("hello"));
+  put("hello", 1);
+  put("world", 2);
+  ASSERT_EQ(1, get("hello"));
+  ASSERT_EQ(2, get("world"));
+  // The key is the exact term
+  ASSERT_EQ(0, get("hell"));
+  ASSERT_EQ(0, get("hellos"));
+
+  // A term put again replaces its cached index
+  put("hello", 3);
+  ASSERT_EQ(3, get("hello"));
+
+  TermIndexCache_Remove(cache, "hello", 5);
+  ASSERT_EQ(0, get("hello"));
+  ASSERT_EQ(2, get("world"));
+  // Removing a term which is not cached is a no-op
+  TermIndexCache_Remove(cache, "hello", 5);
+  TermIndexCache_Remove(cache, "other", 5);
+  ASSERT_EQ(2, get("world"));
+}
+
+TEST_F(TermIndexCacheTest, Collisions) {
+  // More terms than slots, each slot keeps the last term mapped to it
+  const size_t n = 4 * TERM_INDEX_CACHE_SLOTS;
+  for (size_t i = 1; i <= n; i++) {
+    put("term" + std::to_string(i), i);
+  }
+  size_t cached = 0;
+  for (size_t i = 1; i <= n; i++) {
+    uintptr_t idx = get("term" + std::to_string(i));
+    ASSERT_TRUE(idx == 0 || idx == i);
+    cached += idx != 0;
+  }
+  ASSERT_LE(cached, TERM_INDEX_CACHE_SLOTS);
+  ASSERT_GT(cached, 0);
+  ASSERT_EQ(n, get("term" + std::to_string(n)));
+}
+
+TEST_F(TermIndexCacheTest, NullCache) {
+  ASSERT_EQ(nullptr, TermIndexCache_Get(NULL, "a", 1, hash("a")));
+  TermIndexCache_Put(NULL, "a", 1, hash("a"), (InvertedIndex *)1);
+  TermIndexCache_Remove(NULL, "a", 1);
+}
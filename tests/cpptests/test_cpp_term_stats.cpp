@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "rmutil/alloc.h"
+#include "gtest/gtest.h"
+
+#include "src/term_stats.h"
+
+#include <string>
+
+class TermStatsCacheTest : public ::testing::Test {
+protected:
+  TermStatsCache *cache;
+
+  void SetUp() override {
+    cache = NewTermStatsCache();
+  }
+  void TearDown() override {
+    TermStatsCache_Free(cache);
+  }
+
+  void put(uint64_t revision, const std::string &term, uint32_t numDocs, t_fieldMask fieldMask = 0x1) {
+    TermStats stats = {.hasIndex = true, .numDocs = numDocs, .fieldMask = fieldMask};
+    TermStatsCache_Put(cache, revision, term.c_str(), term.size(), &stats);
+  }
+  bool get(uint64_t revision, const std::string &term, TermStats *stats) {
+    return TermStatsCache_Get(cache, revision, term.c_str(), term.size(), stats);
+  }
+};
+
+TEST_F(TermStatsCacheTest, GetAndPut) {
+  TermStats stats;
+  ASSERT_FALSE(get(1, "hello", &stats));
+  put(1, "hello", 5, 0x3);
+  ASSERT_TRUE(get(1, "hello", &stats));
+  ASSERT_TRUE(stats.hasIndex);
+  ASSERT_EQ(stats.numDocs, 5);
+  ASSERT_EQ(stats.fieldMask, 0x3);
+  // The key is the exact term
+  ASSERT_FALSE(get(1, "hell", &stats));
+  ASSERT_FALSE(get(1, "hellos", &stats));
+
+  // Terms without an inverted index are cached too
+  TermStats missing = {.hasIndex = false};
+  TermStatsCache_Put(cache, 1, "world", 5, &missing);
+  ASSERT_TRUE(get(1, "world", &stats));
+  ASSERT_FALSE(stats.hasIndex);
+}
+
+TEST_F(TermStatsCacheTest, Revisions) {
+  TermStats stats;
+  put(1, "hello", 5);
+  put(1, "world", 2);
+  // A newer revision drops every cached term
+  ASSERT_FALSE(get(2, "hello", &stats));
+  ASSERT_FALSE(get(2, "world", &stats));
+  put(2, "hello", 6);
+  ASSERT_TRUE(get(2, "hello", &stats));
+  ASSERT_EQ(stats.numDocs, 6);
+
+  // Statistics read at an older revision are neither returned nor cached
+  ASSERT_FALSE(get(1, "hello", &stats));
+  put(1, "world", 2);
+  ASSERT_FALSE(get(2, "world", &stats));
+}
+
+TEST_F(TermStatsCacheTest, Capacity) {
+  TermStats stats;
+  for (size_t i = 0; i < TERM_STATS_CACHE_CAPACITY + 10; i++) {
+    put(1, "term" + std::to_string(i), i + 1);
+  }
+  for (size_t i = 0; i < TERM_STATS_CACHE_CAPACITY + 10; i++) {
+    bool found = get(1, "term" + std::to_string(i), &stats);
+    ASSERT_EQ(found, i < TERM_STATS_CACHE_CAPACITY) << i;
+    if (found) {
+      ASSERT_EQ(stats.numDocs, i + 1);
+    }
+  }
+}
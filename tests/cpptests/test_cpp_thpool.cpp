@@ -661,3 +661,46 @@ TEST_P(PriorityThpoolTestBiasAndNonBias, TestTakingTasksAsBias) {
     sign2 = false;
     redisearch_thpool_wait(this->pool);
 }
+
+/* ========================== NUM_THREADS = 2, NUM_HIGH_PRIORITY_BIAS = 0 ========================== */
+THPOOL_TEST_SUITE(PriorityThpoolTestLocalJobs, 2, 0)
+
+/* The purpose of the test is to check that the jobs a thread took in a batch are not stuck behind
+ * a long job it runs: the first job blocks its thread until all the others are done, which happens
+ * only if the other thread steals the jobs batched behind it. */
+TEST_P(PriorityThpoolTestLocalJobs, StealFromBlockedThread) {
+    struct BlockingArg {
+        std::atomic<size_t> &done;
+        size_t n_jobs;
+    };
+    auto blockingFunc = [](void *p) {
+        BlockingArg *arg = (BlockingArg *)p;
+        while (arg->done < arg->n_jobs) {
+            usleep(1);
+        }
+    };
+    auto countFunc = [](void *p) {
+        ++*(std::atomic<size_t> *)p;
+    };
+
+    size_t n_jobs = 100;
+    std::atomic<size_t> done {0};
+    BlockingArg arg = {done, n_jobs};
+
+    // Push all the jobs at once, so that the thread taking the blocking job batches the next ones.
+    redisearch_thpool_pause_threads(this->pool);
+    redisearch_thpool_add_work(this->pool, blockingFunc, &arg, THPOOL_PRIORITY_HIGH);
+    for (size_t i = 0; i < n_jobs; i++) {
+        redisearch_thpool_add_work(this->pool, countFunc, &done, THPOOL_PRIORITY_HIGH);
+    }
+    ASSERT_EQ(redisearch_thpool_get_stats(this->pool).total_pending_jobs, n_jobs + 1);
+    redisearch_thpool_resume_threads(this->pool);
+    redisearch_thpool_wait(this->pool);
+
+    thpool_stats stats = redisearch_thpool_get_stats(this->pool);
+    ASSERT_EQ(done, n_jobs);
+    ASSERT_EQ(stats.total_jobs_done, n_jobs + 1);
+    ASSERT_EQ(stats.total_pending_jobs, 0);
+    ASSERT_EQ(stats.local_pending_jobs, 0);
+    ASSERT_GT(stats.stolen_jobs, 0);
+}
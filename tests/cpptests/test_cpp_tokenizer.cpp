@@ -11,6 +11,7 @@
 #include "gtest/gtest.h"
 #include "stemmer.h"
 #include "tokenize.h"
+#include "snowball/include/libstemmer.h"
 
 #include <set>
 
@@ -151,3 +152,81 @@ TEST_F(TokenizerTest, testEscapedSeparator) {
   free(txt);
   tk->Free(tk);
 }
+
+TEST_F(TokenizerTest, testLongTokens) {
+  // Tokens longer than a chunk of the classification, with the bytes which the scalar loops handle
+  // at various offsets
+  auto tk = NewSimpleTokenizer(NULL, NULL, 0);
+  char *txt = strdup(
+      "ThisIsAVeryLongTokenOfPlainAscii0123456789 x AnotherLongToken_With\\-Escape,"
+      "MixedCaseWITHÄccentsAfterSixteen;short UPPERCASEUPPERCASEUPPER"
+      "\tlast_Token_is_longer_than_sixteen");
+  const char *expected[] = {"thisisaverylongtokenofplainascii0123456789",
+                            "x",
+                            "anotherlongtoken_with-escape",
+                            "mixedcasewithäccentsaftersixteen",
+                            "short",
+                            "uppercaseuppercaseupper",
+                            "last_token_is_longer_than_sixteen"};
+  tk->Start(tk, txt, strlen(txt), 0);
+
+  Token tok;
+  size_t i = 0;
+  while (tk->Next(tk, &tok)) {
+    ASSERT_LT(i, sizeof(expected) / sizeof(*expected));
+    ASSERT_EQ(i + 1, tok.pos);
+    std::string got(tok.tok, tok.tokLen);
+    ASSERT_STREQ(got.c_str(), expected[i]);
+    if (tok.allocatedTok) {
+      rm_free(tok.allocatedTok);
+    }
+    i++;
+  }
+  ASSERT_EQ(i, sizeof(expected) / sizeof(*expected));
+  free(txt);
+  tk->Free(tk);
+}
+
+TEST_F(TokenizerTest, testStemCache) {
+  Stemmer *st = NewStemmer(SnowballStemmer, RS_LANG_ENGLISH);
+  struct sb_stemmer *sb = sb_stemmer_new("english", NULL);
+  auto stem = [&](const std::string &w) {
+    size_t len = 0;
+    const char *s = st->Stem(st->ctx, w.c_str(), w.size(), &len);
+    return s ? std::string(s, len) : std::string();
+  };
+  auto expected = [&](const std::string &w) {
+    const char *s = (const char *)sb_stemmer_stem(sb, (const sb_symbol *)w.c_str(), w.size());
+    std::string ret(s, sb_stemmer_length(sb));
+    return ret == w ? std::string() : "+" + ret;
+  };
+
+  // Words which no other test stems
+  StemmerCacheStats before = StemmerCache_GetStats();
+  ASSERT_EQ("+cachedword", stem("cachedwords"));
+  ASSERT_EQ("", stem("cachedword"));
+  StemmerCacheStats after = StemmerCache_GetStats();
+  ASSERT_EQ(before.misses + 2, after.misses);
+  ASSERT_EQ(before.hits, after.hits);
+
+  // Cached stems, including the words which have no stem
+  ASSERT_EQ("+cachedword", stem("cachedwords"));
+  ASSERT_EQ("", stem("cachedword"));
+  after = StemmerCache_GetStats();
+  ASSERT_EQ(before.misses + 2, after.misses);
+  ASSERT_EQ(before.hits + 2, after.hits);
+
+  // Enough words to evict each other, and words too long to be cached
+  std::string longWord(40, 'a');
+  longWord += "ing";
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 5000; i++) {
+      std::string w = "runn" + std::to_string(i) + (i % 2 ? "ing" : "ers");
+      ASSERT_EQ(expected(w), stem(w)) << w;
+    }
+    ASSERT_EQ(expected(longWord), stem(longWord));
+  }
+
+  sb_stemmer_delete(sb);
+  st->Free(st);
+}
@@ -14,6 +14,7 @@
 #include "redismock/redismock.h"
 
 #include <set>
+#include <vector>
 #include <string>
 #include <memory>
 #include <functional>
@@ -350,6 +351,111 @@ TEST_F(TrieTest, testScoreOrder) {
   TrieType_Free(t);
 }
 
+// Children are looked up 8 keys at a time, check the nodes with more children than that
+TEST_F(TrieTest, testManyChildren) {
+  for (TrieSortMode mode : {Trie_Sort_Lex, Trie_Sort_Score}) {
+    Trie *t = NewTrie(trieFreeCb, mode);
+    std::vector<std::string> terms;
+    // ASCII letters and digits, and 2 byte UTF-8 runes, under the same prefix
+    for (char c = '0'; c <= 'z'; c++) {
+      terms.push_back(std::string("x") + c);
+    }
+    for (unsigned r = 0x400; r < 0x430; r++) {
+      terms.push_back(std::string("x") + (char)(0xc0 | (r >> 6)) + (char)(0x80 | (r & 0x3f)));
+    }
+    float score = 1;
+    for (const auto &term : terms) {
+      ASSERT_TRUE(trieInsertByScore(t, term.c_str(), score++));
+    }
+    ASSERT_EQ(terms.size(), t->size);
+
+    for (const auto &term : terms) {
+      ASSERT_TRUE(trieContains(t, term.c_str())) << term;
+      // adding an existing term does not add a child
+      ASSERT_FALSE(trieInsertByScore(t, term.c_str(), 1)) << term;
+    }
+    ASSERT_FALSE(trieContains(t, "x!"));
+    ASSERT_FALSE(trieContains(t, "x{"));
+    ASSERT_EQ(terms.size(), t->size);
+
+    // delete every other term
+    for (size_t i = 0; i < terms.size(); i += 2) {
+      ASSERT_TRUE(Trie_Delete(t, terms[i].c_str(), terms[i].size())) << terms[i];
+    }
+    for (size_t i = 0; i < terms.size(); i++) {
+      ASSERT_EQ(i % 2 == 1, trieContains(t, terms[i].c_str())) << terms[i];
+    }
+    TrieType_Free(t);
+  }
+}
+
+typedef std::vector<std::pair<std::string, float>> Suggestions;
+
+static Suggestions trieSuggest(Trie *t, const std::string &prefix, size_t num) {
+  Suggestions ret;
+  Vector *res = Trie_Search(t, prefix.c_str(), prefix.size(), num, 0, 1, 0, 0);
+  for (size_t i = 0; i < Vector_Size(res); i++) {
+    TrieSearchResult *e;
+    Vector_Get(res, i, &e);
+    ret.emplace_back(std::string(e->str, e->len), e->score);
+    TrieSearchResult_Free(e);
+  }
+  Vector_Free(res);
+  return ret;
+}
+
+TEST_F(TrieTest, testSuggestCache) {
+  Trie *t = NewTrie(NULL, Trie_Sort_Score);
+  for (int i = 0; i < 1000; i++) {
+    std::string term = "ab" + std::to_string(i);
+    ASSERT_TRUE(Trie_InsertStringBuffer(t, term.c_str(), term.size(), 1 + (i * 7) % 1000, 0, NULL));
+  }
+
+  // More suggestions than cached are always searched, which gives the expected top ones
+  auto check = [&](const std::string &prefix, size_t num) {
+    Suggestions expected = trieSuggest(t, prefix, TRIE_SUGGEST_CACHE_SIZE + 1);
+    expected.resize(std::min(num, expected.size()));
+    ASSERT_EQ(expected, trieSuggest(t, prefix, num)) << prefix;
+  };
+
+  ASSERT_TRUE(t->suggestCache == NULL);
+  check("ab", 5);
+  ASSERT_TRUE(t->suggestCache != NULL);
+  check("ab", 5);
+  check("AB", TRIE_SUGGEST_CACHE_SIZE);
+  check("ab9", 3);
+
+  // A new term, a term moving up from outside the list, and a term moving up inside it
+  ASSERT_TRUE(Trie_InsertStringBuffer(t, "abzz", 4, 5000, 0, NULL));
+  check("ab", 5);
+  ASSERT_FALSE(Trie_InsertStringBuffer(t, "ab3", 3, 3000, 1, NULL));
+  check("a", 5);
+  check("ab", 5);
+  ASSERT_FALSE(Trie_InsertStringBuffer(t, "ab3", 3, 4000, 1, NULL));
+  check("ab", TRIE_SUGGEST_CACHE_SIZE);
+
+  // Deleting a term or lowering its score drops the prefixes it was listed in
+  ASSERT_TRUE(Trie_Delete(t, "abzz", 4));
+  check("ab", 5);
+  ASSERT_FALSE(Trie_InsertStringBuffer(t, "ab3", 3, 1, 0, NULL));
+  check("a", 5);
+  check("ab", 5);
+
+  // The payload of a listed term is updated too
+  RSPayload payload = {.data = (char *)"payload", .len = 7};
+  ASSERT_FALSE(Trie_InsertStringBuffer(t, "ab857", 5, 2000, 0, &payload));
+  Vector *res = Trie_Search(t, "ab", 2, 1, 0, 1, 0, 0);
+  TrieSearchResult *e;
+  Vector_Get(res, 0, &e);
+  ASSERT_EQ("ab857", std::string(e->str, e->len));
+  ASSERT_EQ("payload", std::string(e->payload, e->plen));
+  TrieSearchResult_Free(e);
+  Vector_Free(res);
+  check("ab", 5);
+
+  TrieType_Free(t);
+}
+
 /* leave for future benchmarks if needed
 TEST_F(TrieTest, testbenchmark) {
   Trie *t = NewTrie(trieFreeCb, Trie_Sort_Lex);
@@ -144,3 +144,19 @@ TEST_F(UnicodeToLowerTest, testTurkishDottedI) {
   ASSERT_STREQ(dst, "i̇stanbul");
   rm_free(dst); // Free the allocated memory for dst
 }
+
+TEST_F(UnicodeToLowerTest, testAsciiPrefix) {
+  // Only the first `len` bytes are lowered
+  char str[] = "ABCDEF";
+  size_t newLen = 3;
+  ASSERT_EQ(unicode_tolower(str, &newLen), nullptr);
+  ASSERT_EQ(newLen, 3);
+  ASSERT_STREQ(str, "abcDEF");
+
+  // A string starting with ASCII characters is decoded as a whole once it has another character
+  char mixed[] = "HELLO ÄÖÜ";
+  newLen = strlen(mixed);
+  ASSERT_EQ(unicode_tolower(mixed, &newLen), nullptr);
+  ASSERT_EQ(newLen, strlen("hello äöü"));
+  ASSERT_STREQ(mixed, "hello äöü");
+}
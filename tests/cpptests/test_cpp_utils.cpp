@@ -13,10 +13,32 @@
 
 #include "src/util/heap_doubles.h"
 #include "src/hll/hll.h"
+#include "src/util/sorted_ids.h"
+#include "src/util/numeric_kernels.h"
+#include "src/util/cpu_dispatch.h"
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iterator>
 
 
 class UtilsTest : public ::testing::Test {};
 
+// Run `check` with the kernels of each instruction set the CPU supports, including the scalar ones
+static void forEachKernelImpl(const std::function<void()> &check) {
+  const uint32_t detected = CpuDispatch_DetectFeatures(), selected = CpuDispatch_Features();
+  for (uint32_t features : {0U, (uint32_t)CPU_FEATURE_AVX2, (uint32_t)CPU_FEATURE_AVX512,
+                            (uint32_t)CPU_FEATURE_NEON}) {
+    if ((features & detected) != features) {
+      continue;
+    }
+    CpuDispatch_Init(features);
+    SCOPED_TRACE(CpuDispatch_GetKernel(0)->impl);
+    check();
+  }
+  CpuDispatch_Init(selected);
+}
+
 TEST_F(UtilsTest, testDoublesHeap) {
   size_t n = 100;
   size_t prime = 31; // GCD(100, 31) = 1
@@ -120,3 +142,114 @@ TEST_F(UtilsTest, testHLL) {
   hll_destroy(&hll1);
   hll_destroy(&hll2);
 }
+
+TEST_F(UtilsTest, testHLLKernels) {
+  // The estimates of the scalar kernels, which every implementation must give exactly
+  std::vector<size_t> expected;
+  forEachKernelImpl([&]() {
+    size_t i = 0;
+    for (uint8_t bits : {4, 5, 10, 14}) {
+      struct HLL a, b;
+      ASSERT_EQ(hll_init(&a, bits), 0);
+      ASSERT_EQ(hll_init(&b, bits), 0);
+      for (uint32_t n = 0; n < 20000; n++) {
+        hll_add(&a, &n, sizeof(n));
+        uint32_t m = n * 7 + 1;
+        if (n % 3 == 0) hll_add(&b, &m, sizeof(m));
+      }
+      std::vector<uint8_t> merged(a.size);
+      for (uint32_t r = 0; r < a.size; r++) {
+        merged[r] = std::max(a.registers[r], b.registers[r]);
+      }
+
+      size_t counts[] = {hll_count(&a), 0, 0};
+      ASSERT_EQ(hll_merge(&a, &b), 0);
+      ASSERT_TRUE(std::equal(merged.begin(), merged.end(), a.registers));
+      counts[1] = hll_count(&a);
+      // Merging the same registers again changes nothing, and keeps the cached estimate
+      ASSERT_EQ(hll_merge(&a, &b), 0);
+      ASSERT_EQ(a.cachedCard, counts[1]);
+      // A merge into the cleared HLL copies the registers
+      hll_clear(&b);
+      ASSERT_EQ(hll_merge(&b, &a), 0);
+      counts[2] = hll_count(&b);
+      ASSERT_EQ(counts[2], counts[1]);
+
+      for (size_t count : counts) {
+        if (expected.size() <= i) {
+          expected.push_back(count);
+        }
+        ASSERT_EQ(count, expected[i++]);
+      }
+      hll_destroy(&a);
+      hll_destroy(&b);
+    }
+  });
+}
+
+TEST_F(UtilsTest, testSortedIdsIntersect) {
+  auto check = [](std::vector<t_docId> a, std::vector<t_docId> b) {
+    std::vector<t_docId> expected;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    std::vector<t_docId> out(std::min(a.size(), b.size()));
+    size_t n = SortedIds_Intersect(a.data(), a.size(), b.data(), b.size(), out.data());
+    out.resize(n);
+    ASSERT_EQ(out, expected);
+  };
+  auto multiples = [](t_docId step, size_t count) {
+    std::vector<t_docId> ids;
+    for (size_t i = 1; i <= count; i++) ids.push_back(i * step);
+    return ids;
+  };
+
+  forEachKernelImpl([&]() {
+    check({}, multiples(1, 10));
+    check(multiples(2, 1000), multiples(3, 1000));  // Block compare, with tails of each length
+    check(multiples(3, 997), multiples(2, 1003));
+    check(multiples(5, 7), multiples(1, 10000));    // Galloping
+    check(multiples(1, 10000), {1, 5000, 10000, 10001});
+    check(multiples(7, 100), multiples(7, 100));    // Identical
+  });
+}
+
+TEST_F(UtilsTest, testSortedIdsCountUpTo) {
+  t_docId ids[] = {2, 4, 6, 8};
+  ASSERT_EQ(SortedIds_CountUpTo(ids, 4, 1), 0);
+  ASSERT_EQ(SortedIds_CountUpTo(ids, 4, 4), 2);
+  ASSERT_EQ(SortedIds_CountUpTo(ids, 4, 5), 2);
+  ASSERT_EQ(SortedIds_CountUpTo(ids, 4, 8), 4);
+  ASSERT_EQ(SortedIds_CountUpTo(ids, 0, 8), 0);
+}
+
+TEST_F(UtilsTest, testNumericKernels) {
+  forEachKernelImpl([]() {
+    // Every length up to a few blocks, so that each tail length is covered
+    std::vector<double> vals;
+    for (size_t n = 0; n < 40; n++) {
+      double sum = 0, min = INFINITY, max = -INFINITY;
+      for (double v : vals) {
+        sum += v;
+        min = std::min(min, v);
+        max = std::max(max, v);
+      }
+      ASSERT_DOUBLE_EQ(NumericKernel_Sum(vals.data(), n), sum);
+      ASSERT_EQ(NumericKernel_Min(vals.data(), n), min);
+      ASSERT_EQ(NumericKernel_Max(vals.data(), n), max);
+      double mean = n ? sum / n : 0, ssd = 0;
+      for (double v : vals) {
+        ssd += (v - mean) * (v - mean);
+      }
+      ASSERT_NEAR(NumericKernel_SumSquaredDeviations(vals.data(), n, mean), ssd, 1e-9 * (1 + ssd));
+      vals.push_back((double)((n * 37) % 23) - 11.5);
+    }
+
+    // NaNs are ignored by the minimum and the maximum, and propagate to the sum
+    std::vector<double> nans = {NAN, 3, NAN, -2, 5, NAN, NAN, NAN, 1};
+    ASSERT_EQ(NumericKernel_Min(nans.data(), nans.size()), -2);
+    ASSERT_EQ(NumericKernel_Max(nans.data(), nans.size()), 5);
+    ASSERT_TRUE(std::isnan(NumericKernel_Sum(nans.data(), nans.size())));
+    std::vector<double> allNans(9, NAN);
+    ASSERT_EQ(NumericKernel_Min(allNans.data(), allNans.size()), INFINITY);
+    ASSERT_EQ(NumericKernel_Max(allNans.data(), allNans.size()), -INFINITY);
+  });
+}
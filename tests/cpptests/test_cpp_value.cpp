@@ -10,6 +10,13 @@
 #include "gtest/gtest.h"
 
 #include "value.h"
+#include "value_intern.h"
+
+#include <climits>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
 
 class ValueTest : public ::testing::Test {};
 
@@ -99,3 +106,127 @@ TEST_F(ValueTest, testNumericFormat) {
   ASSERT_STREQ("1581011976800", toString(v).c_str());
   RSValue_DecrRef(v);
 }
+
+TEST_F(ValueTest, testIntegerFormat) {
+  RSValue *v = RSValue_NewNumber(0);
+  ASSERT_STREQ("0", toString(v).c_str());
+  RSValue_SetNumber(v, 7);
+  ASSERT_STREQ("7", toString(v).c_str());
+  RSValue_SetNumber(v, -42);
+  ASSERT_STREQ("-42", toString(v).c_str());
+  RSValue_SetNumber(v, -1581011976800);
+  ASSERT_STREQ("-1581011976800", toString(v).c_str());
+  RSValue_SetNumber(v, 9007199254740992);
+  ASSERT_STREQ("9007199254740992", toString(v).c_str());
+  RSValue_DecrRef(v);
+
+  char buf[32];
+  ASSERT_EQ(RSValue_FormatInteger(LLONG_MIN, buf), 20u);
+  ASSERT_STREQ("-9223372036854775808", buf);
+  ASSERT_EQ(RSValue_FormatInteger(LLONG_MAX, buf), 19u);
+  ASSERT_STREQ("9223372036854775807", buf);
+}
+
+TEST_F(ValueTest, testDoubleFormat) {
+  std::vector<double> values = {0.001, 0.1, 0.5, 1.25, 3.14159265358979, 0.30000000000000004,
+                                9.9999999999995, 99999999999.9, 0.000999999999999, 1e11 - 0.5,
+                                1e11, 1e-4, 123456.7890123456, 1e300, NAN, INFINITY};
+  std::mt19937 rng(46);
+  std::uniform_real_distribution<> dist(-1e6, 1e6);
+  for (int i = 0; i < 10000; i++) {
+    values.push_back(dist(rng) / (1 << (i % 20)));
+  }
+  for (double d : values) {
+    char expected[64], buf[64];
+    size_t n = sprintf(expected, "%.12g", d);
+    ASSERT_EQ(RSValue_FormatDouble(d, buf), n) << expected;
+    ASSERT_STREQ(expected, buf);
+  }
+}
+
+TEST_F(ValueTest, testCopiedString) {
+  // Short strings are stored with their value, the others on their own
+  std::string lengths[] = {"", "short", std::string(RSVALUE_INLINE_STR_MAX, 'a'),
+                           std::string(RSVALUE_INLINE_STR_MAX + 1, 'b')};
+  for (int round = 0; round < 2; round++) {
+    for (const std::string &s : lengths) {
+      RSValue *v = RSValue_NewCopiedString(s.c_str(), s.size());
+      ASSERT_EQ(RSValueType_String, RSValue_Type(v));
+      uint32_t len;
+      const char *str = RSValue_String_Get(v, &len);
+      ASSERT_NE(s.c_str(), str);
+      ASSERT_EQ(s.size(), len);
+      ASSERT_STREQ(s.c_str(), str);
+      RSValue_DecrRef(v);
+    }
+  }
+
+  // A short string value set to another type is still released
+  RSValue *v = RSValue_NewCopiedString("foo", 3);
+  RSValue_IncrRef(v);
+  RSValue_SetNumber(v, 42);
+  ASSERT_EQ(42, RSValue_Number_Get(v));
+  RSValue_DecrRef(v);
+  RSValue_DecrRef(v);
+}
+
+TEST_F(ValueTest, testInterner) {
+  RSValueInterner *in = RSValueInterner_New();
+  RSValue *us = RSValueInterner_Get(in, "US", 2);
+  RSValue *us2 = RSValueInterner_Get(in, "USA", 2);
+  RSValue *active = RSValueInterner_Get(in, "active", 6);
+  ASSERT_EQ(us, us2);
+  ASSERT_NE(us, active);
+  ASSERT_STREQ("US", RSValue_String_Get(us, NULL));
+  ASSERT_STREQ("active", RSValue_String_Get(active, NULL));
+
+  // The hash is the one of any other value of the string
+  RSValue *plain = RSValue_NewCopiedString("active", 6);
+  ASSERT_EQ(RSValue_Hash(plain, 0), RSValue_Hash(active, 0));
+  ASSERT_EQ(RSValue_Hash(plain, 42), RSValue_Hash(active, 42));
+  ASSERT_EQ(0, RSValue_Cmp(plain, active, NULL));
+  RSValue_DecrRef(plain);
+
+  std::string longStr(RSVALUE_INTERN_MAX_LEN + 1, 'x');
+  ASSERT_EQ(nullptr, RSValueInterner_Get(in, longStr.c_str(), longStr.size()));
+
+  // Many distinct strings, until the table is full
+  std::vector<RSValue *> values;
+  for (int i = 0; i < RSVALUE_INTERN_MAX_ENTRIES - 2; i++) {
+    std::string s = "val" + std::to_string(i);
+    values.push_back(RSValueInterner_Get(in, s.c_str(), s.size()));
+    ASSERT_NE(nullptr, values.back());
+  }
+  ASSERT_EQ(nullptr, RSValueInterner_Get(in, "one too many", 12));
+  for (int i = 0; i < RSVALUE_INTERN_MAX_ENTRIES - 2; i++) {
+    std::string s = "val" + std::to_string(i);
+    RSValue *v = RSValueInterner_Get(in, s.c_str(), s.size());
+    ASSERT_EQ(values[i], v);
+    ASSERT_STREQ(s.c_str(), RSValue_String_Get(v, NULL));
+    RSValue_DecrRef(v);
+  }
+
+  // A value with too many references is replaced, and kept alive by its holders
+  std::vector<RSValue *> refs;
+  RSValue *first = RSValueInterner_Get(in, "US", 2);
+  refs.push_back(first);
+  while (refs.back() == first) {
+    refs.push_back(RSValueInterner_Get(in, "US", 2));
+  }
+  ASSERT_STREQ("US", RSValue_String_Get(refs.back(), NULL));
+  ASSERT_LE(refs.size(), RSVALUE_INTERN_MAX_REFS);
+
+  // Freeing the table leaves the held values valid
+  RSValueInterner_Free(in);
+  ASSERT_STREQ("US", RSValue_String_Get(us, NULL));
+  ASSERT_STREQ("active", RSValue_String_Get(active, NULL));
+  for (RSValue *v : refs) {
+    RSValue_DecrRef(v);
+  }
+  for (RSValue *v : values) {
+    RSValue_DecrRef(v);
+  }
+  RSValue_DecrRef(us);
+  RSValue_DecrRef(us2);
+  RSValue_DecrRef(active);
+}
@@ -61,6 +61,26 @@ int testBlockAlloc() {
   return 0;
 }
 
+static int testRecycledCapacity() {
+  BlkAlloc alloc;
+  BlkAlloc_Init(&alloc);
+  BlkAlloc_Alloc(&alloc, 64, 64);
+  BlkAlloc_Clear(&alloc, NULL, NULL, 0);
+
+  // Smaller blocks are served from the whole recycled block
+  for (size_t i = 0; i < 4; i++) {
+    BlkAlloc_Alloc(&alloc, 16, 16);
+    ASSERT(alloc.root == alloc.last);
+    ASSERT(alloc.root->numUsed == 16 * (i + 1));
+  }
+  BlkAlloc_Alloc(&alloc, 16, 16);
+  ASSERT(alloc.root != alloc.last);
+  ASSERT(alloc.last->capacity == 16);
+
+  BlkAlloc_FreeAll(&alloc, NULL, NULL, 0);
+  return 0;
+}
+
 typedef struct {
   char fillerSpace[32];
   uint32_t num;
@@ -92,5 +112,6 @@ static int testFreeFunc() {
 
 TEST_MAIN({
   TESTFUNC(testBlockAlloc);
+  TESTFUNC(testRecycledCapacity);
   TESTFUNC(testFreeFunc);
 })
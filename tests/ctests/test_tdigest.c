@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+*/
+
+#include "src/util/tdigest.h"
+#include "rmalloc.h"
+#include "rmutil/alloc.h"
+#include "test_util.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define NUM_VALUES 100000
+
+// The values 1..NUM_VALUES in a scrambled order, so that the value of quantile q is about
+// q * NUM_VALUES
+static double valueAt(size_t ii) {
+  // 7919 is prime, so this is a permutation of 0..NUM_VALUES-1
+  return (double)((ii * 7919) % NUM_VALUES) + 1;
+}
+
+static int assertAccurate(TDigest *td) {
+  double quantiles[] = {0.01, 0.5, 0.9, 0.99, 0.999};
+  for (size_t ii = 0; ii < sizeof(quantiles) / sizeof(*quantiles); ++ii) {
+    double q = quantiles[ii];
+    double res = TD_Quantile(td, q);
+    // The error is relative to the distance from the closest extreme
+    double tail = q < 0.5 ? q : 1 - q;
+    ASSERT(fabs(res - q * NUM_VALUES) <= tail * NUM_VALUES * 0.05 + 1);
+  }
+  ASSERT_EQUAL(TD_Quantile(td, 0), 1);
+  ASSERT_EQUAL(TD_Quantile(td, 1), NUM_VALUES);
+  ASSERT_EQUAL(TD_GetCount(td), NUM_VALUES);
+  return 0;
+}
+
+static int testAccuracy() {
+  TDigest *td = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  for (size_t ii = 0; ii < NUM_VALUES; ++ii) {
+    TD_Add(td, valueAt(ii), 1);
+  }
+  if (assertAccurate(td)) {
+    return 1;
+  }
+
+  // The serialized digest holds about `compression` centroids, whatever the number of values
+  char *buf;
+  size_t len = TD_Serialize(td, &buf);
+  ASSERT(len <= 24 + 16 * (TDIGEST_DEFAULT_COMPRESSION + 2));
+  rm_free(buf);
+  TD_Free(td);
+  return 0;
+}
+
+static int testMerge() {
+  TDigest *parts[3];
+  for (size_t ii = 0; ii < 3; ++ii) {
+    parts[ii] = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  }
+  for (size_t ii = 0; ii < NUM_VALUES; ++ii) {
+    TD_Add(parts[ii % 3], valueAt(ii), 1);
+  }
+
+  // Merge one part directly, and another one through its serialized form
+  TDigest *td = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  TD_Merge(td, parts[0]);
+  TD_Merge(td, parts[1]);
+  char *buf;
+  size_t len = TD_Serialize(parts[2], &buf);
+  ASSERT(TD_MergeSerialized(td, buf, len));
+  ASSERT(!TD_MergeSerialized(td, buf, len - 1));
+  rm_free(buf);
+  if (assertAccurate(td)) {
+    return 1;
+  }
+
+  for (size_t ii = 0; ii < 3; ++ii) {
+    TD_Free(parts[ii]);
+  }
+  TD_Free(td);
+  return 0;
+}
+
+static int testFewValues() {
+  TDigest *td = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  ASSERT(isnan(TD_Quantile(td, 0.5)));
+
+  TD_Add(td, 42, 1);
+  ASSERT_EQUAL(TD_Quantile(td, 0), 42);
+  ASSERT_EQUAL(TD_Quantile(td, 0.5), 42);
+  ASSERT_EQUAL(TD_Quantile(td, 1), 42);
+
+  // NaNs are not counted
+  TD_Add(td, NAN, 1);
+  ASSERT_EQUAL(TD_GetCount(td), 1);
+  TD_Free(td);
+
+  // Values at the tails are kept as is
+  td = NewTDigest(TDIGEST_DEFAULT_COMPRESSION);
+  for (int ii = 0; ii <= 100; ++ii) {
+    TD_Add(td, ii, 1);
+  }
+  ASSERT_EQUAL(TD_Quantile(td, 0.01), 1);
+  ASSERT_EQUAL(TD_Quantile(td, 0.95), 95);
+  ASSERT_EQUAL(TD_Quantile(td, 0.99), 99);
+  TD_Free(td);
+  return 0;
+}
+
+TEST_MAIN({
+  RMUTil_InitAlloc();
+  TESTFUNC(testAccuracy);
+  TESTFUNC(testMerge);
+  TESTFUNC(testFewValues);
+})
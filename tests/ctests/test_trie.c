@@ -10,6 +10,7 @@
 #include "src/trie/trie.h"
 #include "src/trie/levenshtein.h"
 #include "src/trie/rune_util.h"
+#include "src/util/arr.h"
 #include "libnu/libnu.h"
 #include "rmutil/alloc.h"
 #include "test_util.h"
@@ -194,6 +195,52 @@ int testTrie() {
   return 0;
 }
 
+// Feeds a whole term to the filter, and returns its distance, or -1 if it does not match
+static int dfaDistance(DFAFilter *fc, const char *term) {
+  size_t rlen;
+  rune *runes = strToRunes(term, &rlen);
+  int matched, pushed = 0;
+  while (pushed < rlen && FoldingFilterFunc(runes[pushed], fc, &matched, NULL) == F_CONTINUE) {
+    pushed++;
+  }
+  free(runes);
+  dfaNode *dn = array_tail(fc->stack).n;
+  int dist = pushed == rlen && dn->match ? dn->distance : -1;
+  StackPop(fc, pushed);
+  return dist;
+}
+
+int testDFAStates() {
+  size_t rlen;
+  // repeated runes lead to the same states from different paths
+  rune *runes = strToRunes("mississippimississippi", &rlen);
+  DFAFilter *fc = NewDFAFilter(runes, rlen, 2, 0);
+
+  // every state of the DFA is built once
+  size_t n = Vector_Size(fc->cache);
+  for (size_t i = 0; i < n; i++) {
+    dfaNode *a;
+    Vector_Get(fc->cache, i, &a);
+    for (size_t j = i + 1; j < n; j++) {
+      dfaNode *b;
+      Vector_Get(fc->cache, j, &b);
+      ASSERT(a->v->len != b->v->len ||
+             memcmp(a->v->entries, b->v->entries, a->v->len * sizeof(sparseVectorEntry)));
+    }
+  }
+
+  ASSERT_EQUAL(0, dfaDistance(fc, "mississippimississippi"));
+  ASSERT_EQUAL(1, dfaDistance(fc, "mississippimisissippi"));
+  ASSERT_EQUAL(2, dfaDistance(fc, "misxissippimississipp"));
+  ASSERT_EQUAL(-1, dfaDistance(fc, "mxssxssxppimississippi"));
+  ASSERT_EQUAL(1, array_len(fc->stack));
+
+  DFAFilter_Free(fc);
+  rm_free(fc);
+  free(runes);
+  return 0;
+}
+
 int testUnicode() {
 
   char *str = "\xc4\x8c\xc4\x87";
@@ -336,6 +383,7 @@ TEST_MAIN({
   RMUTil_InitAlloc();
   TESTFUNC(testRuneUtil);
   TESTFUNC(testDFAFilter);
+  TESTFUNC(testDFAStates);
   TESTFUNC(testTrie);
   TESTFUNC(testPayload);
   TESTFUNC(testUnicode);
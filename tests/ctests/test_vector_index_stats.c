@@ -71,10 +71,54 @@ int test_memory_and_marked_deleted_setter() {
     return 0;
 }
 
+int test_vector_indexing_stats() {
+    VectorIndexingStats stats = {0};
+    ASSERT(VectorIndexingStats_GetPending(&stats) == 0);
+    ASSERT(VectorIndexingStats_GetThroughput(&stats) == 0);
+
+    VectorIndexingStats_AddSubmitted(&stats, 3);
+    ASSERT(VectorIndexingStats_GetPending(&stats) == 3);
+    VectorIndexingStats_AddDone(&stats, 500000000);
+    VectorIndexingStats_AddDone(&stats, 500000000);
+    ASSERT(VectorIndexingStats_GetPending(&stats) == 1);
+    ASSERT(VectorIndexingStats_GetDone(&stats) == 2);
+    ASSERT(VectorIndexingStats_GetThroughput(&stats) == 2);
+
+    // A job may be done before it is counted as submitted
+    VectorIndexingStats_AddDone(&stats, 0);
+    VectorIndexingStats_AddDone(&stats, 0);
+    ASSERT(VectorIndexingStats_GetPending(&stats) == 0);
+    return 0;
+}
+
+int test_vector_query_stats() {
+    VectorQueryStats query = {.queries = 1, .indexResults = 10, .distances = 5, .batches = 2,
+                              .adhocSwitches = 1, .bytesRead = 60};
+    VectorQueryStats total = {0};
+    VectorQueryStats_Add(&total, &query);
+    VectorQueryStats_Add(&total, &query);
+
+    VectorIndexStats stats = VectorIndexStats_Init();
+    stats.queries = total;
+    VectorIndexStats other = VectorIndexStats_Init();
+    VectorIndexStats_GetSetter("distance_computations")(&other, 7);
+    VectorIndexStats_Agg(&stats, &other);
+
+    ASSERT(VectorIndexStats_GetGetter("queries")(&stats) == 2);
+    ASSERT(VectorIndexStats_GetGetter("index_results_read")(&stats) == 20);
+    ASSERT(VectorIndexStats_GetGetter("distance_computations")(&stats) == 17);
+    ASSERT(VectorIndexStats_GetGetter("batch_iterations")(&stats) == 4);
+    ASSERT(VectorIndexStats_GetGetter("adhoc_switches")(&stats) == 2);
+    ASSERT(VectorIndexStats_GetGetter("vector_bytes_read")(&stats) == 120);
+    return 0;
+}
+
 TEST_MAIN({
     TESTFUNC(test_memory_and_marked_deleted_invalid_input);
     TESTFUNC(test_memory_and_marked_deleted_setter_getter);
     TESTFUNC(test_memory_and_marked_deleted_getter_setter);
     TESTFUNC(test_memory_and_marked_deleted_getter);
     TESTFUNC(test_memory_and_marked_deleted_setter);
+    TESTFUNC(test_vector_indexing_stats);
+    TESTFUNC(test_vector_query_stats);
 });
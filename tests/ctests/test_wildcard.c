@@ -170,6 +170,10 @@ int _testMatch(char *pattern, char *str, match_t expected) {
   match_t actual = Wildcard_MatchChar(pattern, strlen(pattern), str, strlen(str));
   //printf("%d %s\n", i++, str);
   ASSERT_EQUAL(expected, actual);
+
+  WildcardMatcher matcher;
+  WildcardMatcher_Init(&matcher, pattern, strlen(pattern));
+  ASSERT_EQUAL(expected == FULL_MATCH, WildcardMatcher_Match(&matcher, str, strlen(str)));
   return 0;
 }
 
@@ -217,10 +221,43 @@ int test_match() {
   return 0;
 }
 
+int test_matcher() {
+  WildcardMatcher m;
+  const char *pattern = "ab?c*long*x*yz";
+  WildcardMatcher_Init(&m, pattern, strlen(pattern));
+  ASSERT_EQUAL(11, m.minLen);
+  ASSERT(m.hasStar);
+  ASSERT_EQUAL(2, m.prefixLen);
+  ASSERT_EQUAL(2, m.suffixLen);
+  ASSERT_EQUAL(4, m.chunkLen);
+  ASSERT(!strncmp(m.chunk, "long", 4));
+
+  ASSERT(WildcardMatcher_Match(&m, "abXclongxyz", 11));
+  ASSERT(WildcardMatcher_Match(&m, "abXc_long_x_yz", 14));
+  ASSERT(!WildcardMatcher_Match(&m, "abXclonxyz", 10));
+  ASSERT(!WildcardMatcher_Match(&m, "abXclongyz", 10));
+  // The runs must also come in the order of the pattern
+  ASSERT(!WildcardMatcher_Match(&m, "abXcxlongyz", 11));
+
+  pattern = "a?c";
+  WildcardMatcher_Init(&m, pattern, strlen(pattern));
+  ASSERT(!m.hasStar);
+  ASSERT(WildcardMatcher_Match(&m, "abc", 3));
+  ASSERT(!WildcardMatcher_Match(&m, "abbc", 4));
+
+  pattern = "literal";
+  WildcardMatcher_Init(&m, pattern, strlen(pattern));
+  ASSERT_EQUAL(7, m.prefixLen);
+  ASSERT(WildcardMatcher_Match(&m, "literal", 7));
+  ASSERT(!WildcardMatcher_Match(&m, "literals", 8));
+  return 0;
+}
+
 TEST_MAIN({
   RMUTil_InitAlloc();
   TESTFUNC(test_StarBreak);
   TESTFUNC(test_removeEscape);
   TESTFUNC(test_trimPattern);
-  TESTFUNC(test_match); 
+  TESTFUNC(test_match);
+  TESTFUNC(test_matcher);
 });
\ No newline at end of file
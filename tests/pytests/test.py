@@ -2364,6 +2364,47 @@ def testAlterIndex(env):
     env.expect('FT.ALTER', 'idx', 'ADD', 'SCHEMA', 'f2', 'TEXT').error()
     env.expect('FT.ALTER', 'idx', 'f2', 'TEXT').error()
 
+@skip(cluster=True)
+def testAlterIndexNewFieldsOnly(env):
+    env.cmd('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'f1', 'TEXT')
+    for i in range(300):
+        env.cmd('HSET', f'doc{i}', 'f1', 'hello', 't', f'tag{i % 3}', 'n', i)
+    waitForIndex(env, 'idx')
+    env.cmd('DEL', 'doc7')
+    docId = env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc42')
+
+    # Non text fields are indexed for the documents of the index, which keep their ids
+    env.cmd('FT.ALTER', 'idx', 'SCHEMA', 'ADD', 't', 'TAG', 'n', 'NUMERIC')
+    env.cmd('HSET', 'doc300', 'f1', 'hello', 't', 'tag0', 'n', 300)
+    waitForIndex(env, 'idx')
+    env.assertEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc42'), docId)
+    env.assertEqual(env.cmd('FT.SEARCH', 'idx', '@t:{tag0}', 'LIMIT', 0, 0), [101])
+    env.assertEqual(env.cmd('FT.SEARCH', 'idx', '@n:[100 199]', 'LIMIT', 0, 0), [100])
+    res = env.cmd('FT.SEARCH', 'idx', 'hello @t:{tag1} @n:[0 9]', 'NOCONTENT')
+    env.assertEqual(toSortedFlatList(res), toSortedFlatList([2, 'doc1', 'doc4']))
+
+    # Adding a text field re-indexes the documents
+    env.cmd('FT.ALTER', 'idx', 'SCHEMA', 'ADD', 'f2', 'TEXT')
+    waitForIndex(env, 'idx')
+    env.assertNotEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc42'), docId)
+    env.assertEqual(env.cmd('FT.SEARCH', 'idx', '@t:{tag0}', 'LIMIT', 0, 0), [101])
+
+def testScanBatchesSharedTerms(env):
+    # The documents found by the scan are written by batches, with the entries of their shared terms
+    # merged per term
+    conn = getConnectionByEnv(env)
+    for i in range(500):
+        conn.execute_command('HSET', f'doc{i}', 'f', f'hello world w{i % 7}', 't', f'tag{i % 5}', 'n', i)
+    conn.execute_command('HSET', 'doc3', 'f', 'world')
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'f', 'TEXT', 't', 'TAG', 'n', 'NUMERIC').ok()
+    waitForIndex(env, 'idx')
+    env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal([499])
+    env.expect('FT.SEARCH', 'idx', 'world', 'LIMIT', 0, 0).equal([500])
+    env.expect('FT.SEARCH', 'idx', 'w3', 'LIMIT', 0, 0).equal([70])
+    env.expect('FT.SEARCH', 'idx', 'hello @t:{tag2} @n:[0 99]', 'LIMIT', 0, 0).equal([20])
+    res = env.cmd('FT.SEARCH', 'idx', 'hello w0 @n:[0 20]', 'NOCONTENT')
+    env.assertEqual(toSortedFlatList(res), toSortedFlatList([3, 'doc0', 'doc7', 'doc14']))
+
 def testAlterValidation(env):
     # Test that constraints for ALTER command
     env.cmd('FT.CREATE', 'idx1', 'ON', 'HASH', 'SCHEMA', 'f0', 'TEXT')
@@ -2419,6 +2460,96 @@ def testIssue366_2(env):
     for _ in env.reloadingIterator():
         pass  #
 
+@skip(cluster=True)
+def testUpdateUnchangedContent(env):
+    env.expect(config_cmd(), 'SET', '_SKIP_UNCHANGED_DOCS', 'true').ok()
+    env.cmd('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'f', 'TEXT', 't', 'TAG', 'n', 'NUMERIC', 'SORTABLE')
+    env.cmd('HSET', 'doc1', 'f', 'hello world', 't', 'a,b', 'n', 1, 'other', 'x')
+    docId = env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1')
+
+    # Writes which leave the indexed content as it is keep the id of the document
+    env.cmd('HSET', 'doc1', 'f', 'hello world', 't', 'a,b', 'n', 1)
+    env.cmd('HSET', 'doc1', 'n', 1, 'other', 'y')
+    env.cmd('HDEL', 'doc1', 'other')
+    env.assertEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1'), docId)
+    env.expect('FT.SEARCH', 'idx', 'hello @t:{b} @n:[1 1]', 'NOCONTENT').equal([1, 'doc1'])
+
+    # A change of an indexed field indexes the document again
+    env.cmd('HSET', 'doc1', 'n', 2)
+    env.assertNotEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1'), docId)
+    env.expect('FT.SEARCH', 'idx', '@n:[1 1]', 'NOCONTENT').equal([0])
+    env.expect('FT.SEARCH', 'idx', 'hello @n:[2 2]', 'NOCONTENT').equal([1, 'doc1'])
+
+@skip(cluster=True)
+def testUpdateUnchangedContentDisabled(env):
+    # Without _SKIP_UNCHANGED_DOCS, every write indexes the document again
+    env.cmd('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'f', 'TEXT')
+    env.cmd('HSET', 'doc1', 'f', 'hello')
+    docId = env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1')
+    env.cmd('HSET', 'doc1', 'f', 'hello')
+    env.assertNotEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1'), docId)
+
+@skip(cluster=True)
+def testUpdateUnchangedContentMetadata(env):
+    # A change of the score, payload, language or expiration of a document alone indexes it again
+    env.expect(config_cmd(), 'SET', '_SKIP_UNCHANGED_DOCS', 'true').ok()
+    env.cmd('FT.CREATE', 'idx', 'ON', 'HASH', 'SCORE_FIELD', 's', 'PAYLOAD_FIELD', 'p',
+            'LANGUAGE_FIELD', 'l', 'SCHEMA', 'f', 'TEXT')
+    env.cmd('HSET', 'doc1', 'f', 'hello', 's', 0.5, 'p', 'abc', 'l', 'english')
+
+    def assertReindexed(*cmd):
+        docId = env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1')
+        env.cmd(*cmd)
+        env.assertNotEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1'), docId, message=cmd)
+        env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT').equal([1, 'doc1'])
+
+    docId = env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1')
+    env.cmd('HSET', 'doc1', 'f', 'hello', 's', 0.5, 'p', 'abc', 'l', 'english')
+    env.assertEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'doc1'), docId)
+
+    assertReindexed('HSET', 'doc1', 's', 0.25)
+    assertReindexed('HSET', 'doc1', 'p', 'abd')
+    assertReindexed('HSET', 'doc1', 'l', 'german')
+    assertReindexed('PEXPIRE', 'doc1', 1000000)
+    assertReindexed('PERSIST', 'doc1')
+
+@skip(cluster=True)
+def testTransactionWrites(env):
+    # The writes inside MULTI/EXEC and scripts are indexed once they are over, with the last
+    # content of each key, and the commands reading the index inside them see the writes before them
+    env.expect('FT.CREATE', 'idx', 'PREFIX', 1, 'doc', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+    env.cmd('HSET', 'doc0', 't', 'old', 'n', 0)
+
+    env.expect('MULTI').ok()
+    for i in range(10):
+        env.cmd('HSET', f'doc{i}', 't', f'hello v{i}', 'n', i)
+    env.cmd('HSET', 'doc1', 't', 'world')
+    env.cmd('HINCRBY', 'doc2', 'n', 100)
+    env.cmd('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0)
+    env.cmd('HSET', 'doc3', 't', 'later')
+    env.cmd('DEL', 'doc4')
+    env.cmd('HSET', 'other', 't', 'hello')
+    res = env.cmd('EXEC')
+    env.assertEqual(res[12], [9])
+
+    env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT', 'SORTBY', 'n').equal(
+        [7, 'doc0', 'doc5', 'doc6', 'doc7', 'doc8', 'doc9', 'doc2'])
+    env.expect('FT.SEARCH', 'idx', 'old | world | later', 'NOCONTENT', 'SORTBY', 'n').equal(
+        [2, 'doc1', 'doc3'])
+    env.expect('FT.SEARCH', 'idx', '@n:[102 102]', 'NOCONTENT').equal([1, 'doc2'])
+    env.assertEqual(int(index_info(env)['num_docs']), 9)
+
+    script = """
+    for i = 1, 5 do
+        redis.call('HSET', KEYS[1], 't', 'script' .. i, 'n', i)
+    end
+    return redis.call('FT.SEARCH', 'idx', '@n:[5 5]', 'NOCONTENT')
+    """
+    env.expect('EVAL', script, 1, 'doc20').equal([1, 'doc20'])
+    env.expect('FT.SEARCH', 'idx', 'script1', 'NOCONTENT').equal([0])
+    env.expect('FT.SEARCH', 'idx', 'script5', 'NOCONTENT').equal([1, 'doc20'])
+    env.assertEqual(int(index_info(env)['num_docs']), 10)
+
 def testReplaceReload(env):
     env.cmd('FT.CREATE', 'idx2', 'ON', 'HASH',
             'SCHEMA', 'textfield', 'TEXT', 'numfield', 'NUMERIC')
@@ -3162,6 +3293,33 @@ def testExplainError(env):
     env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'test', 'TEXT').equal('OK')
     env.expect('FT.EXPLAIN', 'idx', '(').error()
 
+@skip(cluster=True)
+def testExplainCost(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TAG').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello,world' if i % 2 else 'hello')
+
+    q = ['@t:{hello} @t:{world}', 'DIALECT', 2]
+    explain = env.cmd('FT.EXPLAIN', 'idx', *q)
+    res = env.cmd('FT.EXPLAIN', 'idx', q[0], 'COST', *q[1:])
+    # The plan of the query is followed by the cost of its iterators, which are run to the end
+    env.assertTrue(res.startswith(explain + 'COST {\n'), message=res)
+    lines = res[len(explain):].split('\n')
+    env.assertTrue(lines[1].startswith('  Optimizer mode: '), message=lines)
+    env.assertTrue(lines[2].startswith('  Estimated cost: '), message=lines)
+    env.assertEqual(lines[3], '  Results: 50')
+    env.assertEqual(lines[4], '  INTERSECT estimated=50 counter=50')
+    env.assertContains('    TAG estimated=50 counter=50', lines)
+    env.assertTrue(any(line.startswith('    TAG estimated=100 ') for line in lines), message=lines)
+    env.assertEqual(lines[-2:], ['}', ''])
+
+    res = env.cmd('FT.EXPLAINCLI', 'idx', q[0], 'COST', *q[1:])
+    env.assertContains('  Results: 50', res)
+
+    # Without the COST keyword right after the query, it is an unknown argument
+    env.expect('FT.EXPLAIN', 'idx', *q, 'COST').error()
+
 def testBadCursor(env):
     env.expect('FT.CURSOR', 'READ', 'idx').error()
     env.expect('FT.CURSOR', 'READ', 'idx', '1111').error()
@@ -1,7 +1,7 @@
 from common import *
 
 READ_SEARCH_COMMANDS = ['FT.SEARCH', 'FT.AGGREGATE', 'FT.CURSOR',
-                 'FT.PROFILE', 'FT.SUGGET', 'FT.SUGLEN', 'FT.HYBRID']
+                 'FT.PROFILE', 'FT.SUGGET', 'FT.SUGLEN', 'FT.HYBRID', 'FT.EXPORT']
 WRITE_SEARCH_COMMANDS = ['FT.DROPINDEX', 'FT.SUGADD', 'FT.SUGDEL']
 
 def test_acl_category(env):
@@ -26,7 +26,7 @@ def test_acl_search_commands(env):
         'FT._ALIASDELIFX', 'FT._CREATEIFNX', 'FT._ALIASADDIFNX', 'FT._ALTERIFNX',
         'FT._DROPINDEXIFX', 'FT.DROPINDEX', 'FT.TAGVALS', 'FT._DROPIFX',
         'FT.DROP', 'FT.GET', 'FT.SYNADD', 'FT.ADD', 'FT.MGET', 'FT.DEL',
-        '_FT.CONFIG', '_FT.DEBUG', 'FT.SAFEADD'
+        '_FT.CONFIG', '_FT.DEBUG', 'FT.SAFEADD', 'FT.SLOWLOG', 'FT.MEMORY', 'FT.EXPORT'
     ]
     if not env.isCluster():
         commands.append('FT.CONFIG')
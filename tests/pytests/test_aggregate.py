@@ -1,6 +1,7 @@
 from common import *
 
 import bz2
+import struct
 import json
 import distro
 import unittest
@@ -1315,6 +1316,40 @@ def test_aggregate_filter_on_missing_values():
      contains('Could not find the value for a parameter name, consider using EXISTS if applicable for num1'))
     env.flush()
 
+def test_aggregate_filter_pushdown():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'm', 'NUMERIC').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 'n', i % 20, 'm', i)
+
+    def aggregate(expr):
+        return conn.execute_command('FT.AGGREGATE', 'idx', '*', 'LOAD', '2', '@n', '@m', 'FILTER', expr,
+                                    'SORTBY', '2', '@m', 'ASC', 'MAX', '200')
+
+    # Filters on the indexed field return the same rows as the equivalent filters the iterators
+    # cannot take
+    for expr, same in [('@n > 15', '@n + 0 > 15'),
+                       ('@n >= 15', '@n + 0 >= 15'),
+                       ('@n < 3', '@n + 0 < 3'),
+                       ('@n <= 3', '@n + 0 <= 3'),
+                       ('@n == 4', '@n + 0 == 4'),
+                       ('@n != 4', '@n + 0 != 4'),
+                       ('12 < @n', '12 < @n + 0'),
+                       ('@n == 9 || @n == 2 || 5 == @n || @n == 2', '@n + 0 == 9 || @n + 0 == 2 || @n + 0 == 5'),
+                       ('@m < 50 && @n < 5', '@m < 50 && @n + 0 < 5'),
+                       ('@n < 5 && @m < 50', '@n + 0 < 5 && @m < 50')]:
+        res = aggregate(expr)
+        env.assertEqual(res, aggregate(same), message=expr)
+        env.assertGreater(len(res), 1, message=expr)
+
+    # Rows missing the field, or missing a field read before it, still fail the filter
+    conn.execute_command('HSET', 'nom', 'n', '7')
+    env.expect('FT.AGGREGATE', 'idx', '*', 'LOAD', '1', '@m', 'FILTER', '@m > 2').error() \
+        .contains('Could not find the value for a parameter name')
+    env.expect('FT.AGGREGATE', 'idx', '*', 'LOAD', '2', '@n', '@m', 'FILTER', '@m > 2 && @n > 15').error() \
+        .contains('Could not find the value for a parameter name')
+
 def test_aggregate_filter_on_missing_indexed_values():
     env = setup_missing_values_index(True)
     # Search for the documents with the indexed fields (sanity)
@@ -1430,3 +1465,315 @@ def testeAggregateBadApplyFunction(env):
         .contains("Unknown function name 'unexisting_function'")
     env.expect('FT.AGGREGATE', 'idx', '*', 'APPLY', '!!unexisting_function(@title)').error() \
         .contains("Unknown function name 'unexisting_function'")
+
+def testSharedApplyCalls(env):
+    """Tests that calls repeated across APPLY and FILTER steps keep their values"""
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'ts', 'NUMERIC', 't', 'TAG').ok()
+    for i in range(20):
+        conn.execute_command('HSET', f'doc{i}', 'ts', 1517417144 + (i % 3) * 86400, 't', f'Ab,c{i % 4}')
+
+    def aggregate():
+        return conn.execute_command(
+            'FT.AGGREGATE', 'idx', '*', 'LOAD', '2', '@ts', '@t',
+            'APPLY', 'timefmt(@ts, "%Y-%m-%d")', 'AS', 'd1',
+            'FILTER', 'timefmt(@ts, "%Y-%m-%d") != "2018-02-02"',
+            'APPLY', 'format("%s|%s", timefmt(@ts, "%Y-%m-%d"), upper(@t))', 'AS', 'd2',
+            # Overriding @t changes the value of the calls that read it
+            'APPLY', 'format("x%s", @t)', 'AS', 't',
+            'APPLY', 'upper(@t)', 'AS', 'u',
+            'SORTBY', '2', '@d2', 'ASC', 'MAX', '100')
+
+    res = aggregate()
+    rows = [dict(zip(row[::2], row[1::2])) for row in res[1:]]
+    env.assertEqual(len(rows), 14)
+    for row in rows:
+        env.assertNotEqual(row['d1'], '2018-02-02')
+        env.assertTrue(row['t'].startswith('xAb,c'))
+        env.assertEqual(row['d2'], f"{row['d1']}|{row['t'][1:].upper()}")
+        env.assertEqual(row['u'], row['t'].upper())
+        # The hidden keys of the shared calls are not returned
+        env.assertEqual(sorted(row.keys()), ['d1', 'd2', 't', 'ts', 'u'])
+
+    # Memoizing the functions across rows returns the same rows
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_EXPR_FUNCTION_MEMO_SIZE', '4')
+    env.assertEqual(aggregate(), res)
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_EXPR_FUNCTION_MEMO_SIZE', '0')
+
+def testMergedReducerStates(env):
+    # In cluster mode, STDDEV and COUNT_DISTINCT are merged from the partial states of the shards
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 't', 'TAG').ok()
+    values = {f'tag{t}': [] for t in range(3)}
+    for i in range(3000):
+        t, n = f'tag{i % 3}', (i * 7919) % 1000
+        values[t].append(n)
+        conn.execute_command('HSET', f'doc{i}', 'n', n, 't', t)
+
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '1', '@t',
+                  'REDUCE', 'STDDEV', '1', '@n', 'AS', 'stddev',
+                  'REDUCE', 'COUNT_DISTINCT', '1', '@n', 'AS', 'distinct',
+                  'REDUCE', 'COUNT', '0', 'AS', 'count',
+                  'SORTBY', '2', '@t', 'ASC')
+    env.assertEqual(res[0], 3)
+    for row in res[1:]:
+        row = dict(zip(row[::2], row[1::2]))
+        nums = values[row['t']]
+        mean = sum(nums) / len(nums)
+        stddev = math.sqrt(sum((x - mean) ** 2 for x in nums) / (len(nums) - 1))
+        env.assertAlmostEqual(float(row['stddev']), stddev, delta=1E-6)
+        env.assertEqual(int(row['distinct']), len(set(nums)))
+        env.assertEqual(int(row['count']), len(nums))
+
+def testQuantileDigest(env):
+    # With a t-digest, the shards send their digests, which the coordinator merges
+    conn = getConnectionByEnv(env)
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_QUANTILE_COMPRESSION', '100')
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC').ok()
+    num_docs = 10000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', (i * 7919) % num_docs)
+
+    for q in ['0', '0.01', '0.5', '0.9', '0.99', '0.999', '1']:
+        res = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '0',
+                      'REDUCE', 'QUANTILE', '2', '@n', q, 'AS', 'q')
+        # The error is relative to the distance from the closest extreme
+        tail = min(float(q), 1 - float(q))
+        env.assertAlmostEqual(float(res[1][1]), float(q) * (num_docs - 1),
+                              delta=tail * num_docs * 0.05 + 2, message=q)
+
+    env.expect('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '0',
+               'REDUCE', 'QUANTILE', '2', '@missing', '0.5', 'AS', 'q').equal([1, ['q', 'nan']])
+    if not env.isCluster():
+        env.expect('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '0',
+                   'REDUCE', 'QUANTILE', '3', '@n', '0.5', '1001', 'AS', 'q').error().contains('Invalid compression')
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_QUANTILE_COMPRESSION', '0')
+
+def testReducerMemoryBudget(env):
+    # Over their memory budget, COUNT_DISTINCT estimates its counts and TOLIST stops adding values
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'NUMERIC', 'g', 'NUMERIC').ok()
+    num_docs = 2000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'v', i, 'g', i % 500)
+
+    query = ['idx', '*', 'GROUPBY', '0',
+             'REDUCE', 'COUNT_DISTINCT', '1', '@v', 'AS', 'distinct',
+             'REDUCE', 'TOLIST', '1', '@v', 'AS', 'list']
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_REDUCER_MEMORY_BUDGET', '1')
+    res = env.cmd('FT.AGGREGATE', *query)
+    row = dict(zip(res[1][::2], res[1][1::2]))
+    env.assertAlmostEqual(int(row['distinct']), num_docs, delta=num_docs * 0.1)
+    env.assertGreater(len(row['list']), 0)
+    env.assertLess(len(row['list']), num_docs)
+
+    # Tables smaller than a HLL are kept, so that small groups are still counted exactly
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '1', '@g',
+                  'REDUCE', 'COUNT_DISTINCT', '1', '@v', 'AS', 'distinct')
+    env.assertEqual(res[0], 500)
+    for row in res[1:]:
+        env.assertEqual(dict(zip(row[::2], row[1::2]))['distinct'], '4')
+
+    if not env.isCluster():
+        res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', *query[1:])
+        env.assertContains('Approximated reducers', str(res))
+
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_REDUCER_MEMORY_BUDGET', '0')
+    res = env.cmd('FT.AGGREGATE', *query)
+    row = dict(zip(res[1][::2], res[1][1::2]))
+    env.assertEqual(row['distinct'], str(num_docs))
+    env.assertEqual(len(row['list']), num_docs)
+    if not env.isCluster():
+        res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', *query[1:])
+        env.assertNotContains('Approximated reducers', str(res))
+
+def testGroupBySortedInput(env):
+    # Results sorted by the group keys are grouped as they stream in, yielding the same groups
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 't', 'TAG', 'SORTABLE',
+               'v', 'NUMERIC').ok()
+    num_docs = 1000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', i % 7, 't', f'tag{i % 13}', 'v', i)
+    conn.execute_command('HSET', 'nokeys', 'v', 1)
+
+    def rows(res):
+        return sorted(str(row) for row in res[1:])
+
+    reducers = ['REDUCE', 'COUNT', '0', 'AS', 'count',
+                'REDUCE', 'SUM', '1', '@v', 'AS', 'sum',
+                'REDUCE', 'COUNT_DISTINCT', '1', '@v', 'AS', 'distinct']
+    for sortby, groupby in [(['1', '@t'], ['1', '@t']),
+                            (['2', '@n', 'DESC'], ['1', '@n']),
+                            (['2', '@n', '@t'], ['2', '@t', '@n']),
+                            (['2', '@n', '@t'], ['1', '@n'])]:
+        expected = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', *groupby, *reducers)
+        res = env.cmd('FT.AGGREGATE', 'idx', '*', 'SORTBY', *sortby, 'MAX', num_docs + 1,
+                      'GROUPBY', *groupby, *reducers)
+        env.assertEqual(rows(res), rows(expected), message=sortby)
+
+    # Groups read through a cursor, a few at a time
+    expected = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '1', '@t', *reducers)
+    res, cursor = env.cmd('FT.AGGREGATE', 'idx', '*', 'SORTBY', '1', '@t', 'MAX', num_docs + 1,
+                          'GROUPBY', '1', '@t', *reducers, 'WITHCURSOR', 'COUNT', 3)
+    groups = res[1:]
+    while cursor:
+        res, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor)
+        groups += res[1:]
+    env.assertEqual(sorted(str(row) for row in groups), rows(expected))
+
+def testCountOnly(env):
+    # LIMIT 0 0 and GROUPBY 0 REDUCE COUNT count the results of the query root without building
+    # them, and must agree with the results themselves, with and without removed documents
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'g', 'TAG', 'n', 'NUMERIC').ok()
+    num_docs = 1000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello' if i % 3 else 'hello world',
+                             'g', f'tag{i % 4}', 'n', i)
+
+    queries = ['*', 'hello', 'world', '@g:{tag1}', 'hello @g:{tag2}', '@n:[100 199]', '-world',
+               'world | @g:{tag3}', 'nothing']
+
+    def check(msg):
+        for query in queries:
+            expected = len(env.cmd('FT.SEARCH', 'idx', query, 'NOCONTENT', 'LIMIT', 0, num_docs)) - 1
+            env.assertEqual(env.cmd('FT.SEARCH', 'idx', query, 'LIMIT', 0, 0), [expected],
+                            message=(msg, query))
+            res = env.cmd('FT.AGGREGATE', 'idx', query, 'GROUPBY', '0', 'REDUCE', 'COUNT', '0', 'AS', 'c')
+            count = int(res[1][1]) if len(res) > 1 else 0
+            env.assertEqual(count, expected, message=(msg, query))
+
+    check('clean')
+
+    # Removed documents leave ids in the inverted indexes until they are collected
+    for i in range(0, num_docs, 5):
+        conn.execute_command('DEL', f'doc{i}')
+    check('deleted')
+
+    # Expiring documents must be checked one by one
+    for i in range(1, num_docs, 7):
+        conn.execute_command('PEXPIRE', f'doc{i}', 1)
+    time.sleep(0.1)
+    check('expired')
+
+def testSample(env):
+    # SAMPLE reads a deterministic sample of the results, whose COUNT and SUM are scaled up
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC').ok()
+    num_docs = 1000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', i % 10)
+
+    def row(res):
+        return dict(zip(res[1][::2], res[1][1::2]))
+
+    reducers = ['GROUPBY', '0', 'REDUCE', 'COUNT', '0', 'AS', 'c', 'REDUCE', 'SUM', '1', '@n', 'AS', 's']
+    res = row(env.cmd('FT.AGGREGATE', 'idx', '*', *reducers, 'SAMPLE', 0.2))
+    count, total = float(res['c']), float(res['s'])
+    env.assertGreater(count, 700, message=res)
+    env.assertLess(count, 1300, message=res)
+    env.assertGreater(total, 3000, message=res)
+    env.assertLess(total, 6000, message=res)
+    # The same documents are sampled by every query
+    env.assertEqual(row(env.cmd('FT.AGGREGATE', 'idx', '*', *reducers, 'SAMPLE', 0.2)), res)
+
+    # Every sampled result stands for 5 results
+    rows = env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', 1, '@n', 'SAMPLE', 0.2, 'LIMIT', 0, num_docs)
+    env.assertEqual(len(rows[1:]) * 5, count)
+
+    # The groups of a GROUPBY over the sampled results are not scaled up
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 1, '@n', 'REDUCE', 'COUNT', 0, 'AS', 'c',
+                  'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'groups', 'SAMPLE', 0.2)
+    env.assertEqual(row(res)['groups'], '10')
+
+    # A ratio of 1 is no sampling
+    res = row(env.cmd('FT.AGGREGATE', 'idx', '*', *reducers, 'SAMPLE', 1))
+    env.assertEqual(res, {'c': str(num_docs), 's': '4500'})
+
+    if not env.isCluster():
+        # The standard errors of the estimates, which the shards of a cluster don't send
+        sampled = count * 0.2
+        res = row(env.cmd('FT.AGGREGATE', 'idx', '*', *reducers, 'SAMPLE', 0.2))
+        env.assertAlmostEqual(float(res['c_stderr']), (sampled * 0.8) ** 0.5 / 0.2, delta=0.01)
+        env.assertGreater(float(res['s_stderr']), 0)
+        # A count of documents is sampled out of those of the index
+        env.assertEqual(row(env.cmd('FT.AGGREGATE', 'idx', '*', *reducers, 'SAMPLE', 200)), res)
+
+    for bad in [0, -1, 1.5, 'foo']:
+        env.expect('FT.AGGREGATE', 'idx', '*', 'SAMPLE', bad).error().contains('SAMPLE requires')
+    env.expect('FT.AGGREGATE', 'idx', '*', 'SAMPLE', 0.1, 'SAMPLE', 0.2).error() \
+        .contains('SAMPLE specified more than once')
+    env.expect('FT.SEARCH', 'idx', '*', 'SAMPLE', 0.2).error()
+
+def _arrowMessages(stream):
+    # The type, the rows (of a record batch) and the body of each message of an Arrow IPC stream
+    def field(buf, table, id, fmt):
+        vtable = table - struct.unpack_from('<i', buf, table)[0]
+        if 4 + 2 * id >= struct.unpack_from('<H', buf, vtable)[0]:
+            return None
+        offset = struct.unpack_from('<H', buf, vtable + 4 + 2 * id)[0]
+        return struct.unpack_from(fmt, buf, table + offset)[0] if offset else None
+
+    def ref(buf, table, id):
+        vtable = table - struct.unpack_from('<i', buf, table)[0]
+        slot = table + struct.unpack_from('<H', buf, vtable + 4 + 2 * id)[0]
+        return slot + struct.unpack_from('<I', buf, slot)[0]
+
+    messages, pos = [], 0
+    while True:
+        marker, length = struct.unpack_from('<Ii', stream, pos)
+        assert marker == 0xFFFFFFFF and length % 8 == 0
+        pos += 8
+        if length == 0:
+            assert pos == len(stream)
+            return messages
+        meta = stream[pos:pos + length]
+        message = struct.unpack_from('<I', meta, 0)[0]
+        kind, body_len = field(meta, message, 1, '<B'), field(meta, message, 3, '<q') or 0
+        rows = field(meta, ref(meta, message, 2), 0, '<q') if kind == 3 else None
+        messages.append((kind, rows, stream[pos + length:pos + length + body_len]))
+        pos += length + body_len
+
+def testExport(env):
+    # FT.EXPORT replies with the rows of an aggregation as an Arrow IPC stream
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 't', 'TAG').ok()
+    num_docs = 100
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', i, 't', f'tag{i % 3}')
+
+    res = env.cmd('FT.EXPORT', 'idx', '*', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'ASC',
+                  'LIMIT', 0, num_docs, **{NEVER_DECODE: []})
+    env.assertEqual(len(res), 2)
+    messages = _arrowMessages(res[1])
+    # The schema, then a record batch
+    env.assertEqual([(kind, rows) for kind, rows, _ in messages], [(1, None), (3, num_docs)])
+    # The Float64 column has no nulls, so its values are the first buffer of the body
+    values = np.frombuffer(messages[1][2][:8 * num_docs], dtype='<f8')
+    env.assertEqual(list(values), list(range(num_docs)))
+
+    # The strings are exported in a Utf8 column
+    res = env.cmd('FT.EXPORT', 'idx', '@t:{tag1}', 'LOAD', 1, '@t', **{NEVER_DECODE: []})
+    messages = _arrowMessages(res[1])
+    env.assertEqual(messages[1][1], 33)
+    env.assertContains(b'tag1' * 33, messages[1][2])
+
+    # With a cursor, the stream is split between the chunks of the reply
+    res, cursor = env.cmd('FT.EXPORT', 'idx', '*', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 30,
+                          **{NEVER_DECODE: []})
+    stream = b''.join(res[1:])
+    while cursor:
+        res, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor, **{NEVER_DECODE: []})
+        stream += b''.join(res[1:])
+    messages = _arrowMessages(stream)
+    env.assertEqual(messages[0][0], 1)
+    env.assertEqual(set(kind for kind, _, _ in messages[1:]), {3})
+    env.assertEqual(sum(rows for _, rows, _ in messages[1:]), num_docs)
+
+    # The same aggregation replies with the same rows as FT.AGGREGATE
+    res = env.cmd('FT.EXPORT', 'idx', '*', 'GROUPBY', 1, '@t', 'REDUCE', 'COUNT', 0, 'AS', 'c',
+                  'SORTBY', 2, '@t', 'ASC', **{NEVER_DECODE: []})
+    messages = _arrowMessages(res[1])
+    env.assertEqual(messages[1][1], 3)
+    env.assertContains(b'tag0tag1tag2', messages[1][2])
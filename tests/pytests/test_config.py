@@ -67,6 +67,9 @@ def testGetConfigOptions(env):
     check_config('PRIVILEGED_THREADS_NUM')
     check_config('WORKERS_PRIORITY_BIAS_THRESHOLD')
     check_config('FRISOINI')
+    check_config('_WORKERS_CPUS')
+    check_config('_IO_THREADS_CPUS')
+    check_config('_FORK_GC_CPUS')
     check_config('MAXSEARCHRESULTS')
     check_config('MAXAGGREGATERESULTS')
     check_config('ON_TIMEOUT')
@@ -94,6 +97,52 @@ def testGetConfigOptions(env):
     check_config('BM25STD_TANH_FACTOR')
     check_config('_BG_INDEX_OOM_PAUSE_TIME')
     check_config('INDEXER_YIELD_EVERY_OPS')
+    check_config('_INDEX_READER_PREFETCH_DISTANCE')
+    check_config('_PARALLEL_QUERY_RANGES')
+    check_config('_HEAVY_QUERY_COST')
+    check_config('_MAX_RUNNING_HEAVY_QUERIES')
+    check_config('_MAX_WAITING_HEAVY_QUERIES')
+    check_config('_EXPR_FUNCTION_MEMO_SIZE')
+    check_config('_GROUPBY_PARTITIONS')
+    check_config('_QUANTILE_COMPRESSION')
+    check_config('_REDUCER_MEMORY_BUDGET')
+    check_config('_NUMERIC_BITMAP_UNION_RANGES')
+    check_config('_NUMERIC_MERGE_UNION_RANGES')
+    check_config('_NUMERIC_HLL_PRECISION')
+    check_config('_NUMERIC_EXACT_CARDINALITY')
+    check_config('_SUFFIX_ARRAY')
+    check_config('_BINARY_SHARD_ROWS')
+    check_config('_HEDGE_SHARD_REQUESTS')
+    check_config('_SHARD_WINDOW_SECOND_ROUND')
+    check_config('_GEO_CELL_COVERING')
+    check_config('_PERSIST_INDEXES')
+    check_config('_INDEX_SEGMENTS')
+    check_config('_LAZY_INDEX_LOADING')
+    check_config('_PROFILE_HW_COUNTERS')
+    check_config('_SPILL_IDLE_CURSORS')
+    check_config('_SPELLCHECK_DELETE_INDEX')
+    check_config('_SKIP_UNCHANGED_DOCS')
+    check_config('_INDEX_DELTA_REPLICATION')
+    check_config('_HOT_INDEXES')
+    check_config('_TAG_COMPACT_THRESHOLD')
+    check_config('_TAG_SET_MIN_VALUES')
+    check_config('_SHARD_WINDOW_TARGET_RECALL')
+    check_config('_COORD_RESULT_CACHE_TTL_MS')
+    check_config('_SCORE_THRESHOLD_MIN_RESULTS')
+    check_config('_HYBRID_FILTER_IDS_MAX')
+    check_config('_KNN_RESULT_CACHE_ENTRIES')
+    check_config('_SEARCH_RESULT_CACHE_BYTES')
+    check_config('_SLOWLOG_THRESHOLD_MS')
+    check_config('_SLOWLOG_MAX_LEN')
+    check_config('_PROFILE_SAMPLE_RATE')
+    check_config('_QUERY_PLAN_CACHE_ENTRIES')
+    check_config('_FILTER_CACHE_MIN_USES')
+    check_config('_SNIPPET_CACHE_BYTES')
+    check_config('_CURSOR_READ_AHEAD_BYTES')
+    check_config('_IMPACT_POSTINGS_MIN_DOCS')
+    check_config('_IMPACT_POSTINGS_SIZE')
+    check_config('_FORK_GC_CYCLE_BUDGET_MS')
+    check_config('_FORK_GC_APPLY_THREADS')
     check_config('ON_OOM')
 
 @skip(cluster=True)
@@ -112,6 +161,8 @@ def testSetConfigOptions(env):
     env.expect(config_cmd(), 'set', 'WORKER_THREADS', 1).equal(not_modifiable) # deprecated
     env.expect(config_cmd(), 'set', 'MT_MODE', 1).equal(not_modifiable) # deprecated
     env.expect(config_cmd(), 'set', 'FRISOINI', 1).equal(not_modifiable)
+    env.expect(config_cmd(), 'set', '_WORKERS_CPUS', 0).equal(not_modifiable)
+    env.expect(config_cmd(), 'set', '_HOT_INDEXES', 'idx').equal(not_modifiable)
     env.expect(config_cmd(), 'set', 'ON_TIMEOUT', 1).equal('Invalid ON_TIMEOUT value')
     env.expect(config_cmd(), 'set', 'GCSCANSIZE', 1).equal('OK')
     env.expect(config_cmd(), 'set', 'MIN_PHONETIC_TERM_LEN', 1).equal('OK')
@@ -125,6 +176,37 @@ def testSetConfigOptions(env):
     env.expect(config_cmd(), 'set', 'BM25STD_TANH_FACTOR', 1).equal('OK')
     env.expect(config_cmd(), 'set', '_BG_INDEX_OOM_PAUSE_TIME', 1).equal('OK')
     env.expect(config_cmd(), 'set', 'INDEXER_YIELD_EVERY_OPS', 1).equal('OK')
+    env.expect(config_cmd(), 'set', '_INDEX_READER_PREFETCH_DISTANCE', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_PARALLEL_QUERY_RANGES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_HEAVY_QUERY_COST', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_MAX_RUNNING_HEAVY_QUERIES', 1).equal('OK')
+    env.expect(config_cmd(), 'set', '_MAX_WAITING_HEAVY_QUERIES', 256).equal('OK')
+    env.expect(config_cmd(), 'set', '_EXPR_FUNCTION_MEMO_SIZE', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_GROUPBY_PARTITIONS', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_QUANTILE_COMPRESSION', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_REDUCER_MEMORY_BUDGET', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_NUMERIC_BITMAP_UNION_RANGES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_NUMERIC_MERGE_UNION_RANGES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_NUMERIC_HLL_PRECISION', 6).equal('OK')
+    env.expect(config_cmd(), 'set', '_TAG_COMPACT_THRESHOLD', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_TAG_SET_MIN_VALUES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_SHARD_WINDOW_TARGET_RECALL', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_COORD_RESULT_CACHE_TTL_MS', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_SCORE_THRESHOLD_MIN_RESULTS', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_HYBRID_FILTER_IDS_MAX', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_KNN_RESULT_CACHE_ENTRIES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_SEARCH_RESULT_CACHE_BYTES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_SLOWLOG_THRESHOLD_MS', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_SLOWLOG_MAX_LEN', 128).equal('OK')
+    env.expect(config_cmd(), 'set', '_PROFILE_SAMPLE_RATE', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_QUERY_PLAN_CACHE_ENTRIES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_FILTER_CACHE_MIN_USES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_SNIPPET_CACHE_BYTES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_CURSOR_READ_AHEAD_BYTES', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_IMPACT_POSTINGS_MIN_DOCS', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_IMPACT_POSTINGS_SIZE', 1000).equal('OK')
+    env.expect(config_cmd(), 'set', '_FORK_GC_CYCLE_BUDGET_MS', 0).equal('OK')
+    env.expect(config_cmd(), 'set', '_FORK_GC_APPLY_THREADS', 0).equal('OK')
     env.expect(config_cmd(), 'set', 'ON_OOM', 1).equal('Invalid ON_OOM value')
 
 @skip(cluster=True)
@@ -170,6 +252,10 @@ def testAllConfig(env):
     env.assertEqual(res_dict['PRIVILEGED_THREADS_NUM'][0], '1')
     env.assertEqual(res_dict['WORKERS_PRIORITY_BIAS_THRESHOLD'][0], '1')
     env.assertEqual(res_dict['FRISOINI'][0], None)
+    env.assertEqual(res_dict['_WORKERS_CPUS'][0], None)
+    env.assertEqual(res_dict['_IO_THREADS_CPUS'][0], None)
+    env.assertEqual(res_dict['_FORK_GC_CPUS'][0], None)
+    env.assertEqual(res_dict['_HOT_INDEXES'][0], None)
     env.assertEqual(res_dict['ON_TIMEOUT'][0], 'return')
     env.assertEqual(res_dict['GCSCANSIZE'][0], '100')
     env.assertEqual(res_dict['MIN_PHONETIC_TERM_LEN'][0], '3')
@@ -194,6 +280,51 @@ def testAllConfig(env):
     env.assertEqual(res_dict['BM25STD_TANH_FACTOR'][0], '4')
     env.assertEqual(res_dict['_BG_INDEX_OOM_PAUSE_TIME'][0], '0')
     env.assertEqual(res_dict['INDEXER_YIELD_EVERY_OPS'][0], '1000')
+    env.assertEqual(res_dict['_INDEX_READER_PREFETCH_DISTANCE'][0], '16')
+    env.assertEqual(res_dict['_PARALLEL_QUERY_RANGES'][0], '0')
+    env.assertEqual(res_dict['_HEAVY_QUERY_COST'][0], '0')
+    env.assertEqual(res_dict['_MAX_RUNNING_HEAVY_QUERIES'][0], '1')
+    env.assertEqual(res_dict['_MAX_WAITING_HEAVY_QUERIES'][0], '256')
+    env.assertEqual(res_dict['_EXPR_FUNCTION_MEMO_SIZE'][0], '0')
+    env.assertEqual(res_dict['_GROUPBY_PARTITIONS'][0], '0')
+    env.assertEqual(res_dict['_QUANTILE_COMPRESSION'][0], '0')
+    env.assertEqual(res_dict['_REDUCER_MEMORY_BUDGET'][0], '0')
+    env.assertEqual(res_dict['_NUMERIC_BITMAP_UNION_RANGES'][0], '0')
+    env.assertEqual(res_dict['_NUMERIC_MERGE_UNION_RANGES'][0], '0')
+    env.assertEqual(res_dict['_NUMERIC_HLL_PRECISION'][0], '6')
+    env.assertEqual(res_dict['_NUMERIC_EXACT_CARDINALITY'][0], 'false')
+    env.assertEqual(res_dict['_SUFFIX_ARRAY'][0], 'false')
+    env.assertEqual(res_dict['_BINARY_SHARD_ROWS'][0], 'true')
+    env.assertEqual(res_dict['_HEDGE_SHARD_REQUESTS'][0], 'false')
+    env.assertEqual(res_dict['_SHARD_WINDOW_SECOND_ROUND'][0], 'false')
+    env.assertEqual(res_dict['_GEO_CELL_COVERING'][0], 'false')
+    env.assertEqual(res_dict['_PERSIST_INDEXES'][0], 'false')
+    env.assertEqual(res_dict['_INDEX_SEGMENTS'][0], 'false')
+    env.assertEqual(res_dict['_LAZY_INDEX_LOADING'][0], 'false')
+    env.assertEqual(res_dict['_PROFILE_HW_COUNTERS'][0], 'false')
+    env.assertEqual(res_dict['_SPILL_IDLE_CURSORS'][0], 'false')
+    env.assertEqual(res_dict['_SPELLCHECK_DELETE_INDEX'][0], 'false')
+    env.assertEqual(res_dict['_SKIP_UNCHANGED_DOCS'][0], 'false')
+    env.assertEqual(res_dict['_INDEX_DELTA_REPLICATION'][0], 'false')
+    env.assertEqual(res_dict['_TAG_COMPACT_THRESHOLD'][0], '0')
+    env.assertEqual(res_dict['_TAG_SET_MIN_VALUES'][0], '0')
+    env.assertEqual(res_dict['_SHARD_WINDOW_TARGET_RECALL'][0], '0')
+    env.assertEqual(res_dict['_COORD_RESULT_CACHE_TTL_MS'][0], '0')
+    env.assertEqual(res_dict['_SCORE_THRESHOLD_MIN_RESULTS'][0], '0')
+    env.assertEqual(res_dict['_HYBRID_FILTER_IDS_MAX'][0], '0')
+    env.assertEqual(res_dict['_KNN_RESULT_CACHE_ENTRIES'][0], '0')
+    env.assertEqual(res_dict['_SEARCH_RESULT_CACHE_BYTES'][0], '0')
+    env.assertEqual(res_dict['_SLOWLOG_THRESHOLD_MS'][0], '0')
+    env.assertEqual(res_dict['_SLOWLOG_MAX_LEN'][0], '128')
+    env.assertEqual(res_dict['_PROFILE_SAMPLE_RATE'][0], '0')
+    env.assertEqual(res_dict['_QUERY_PLAN_CACHE_ENTRIES'][0], '0')
+    env.assertEqual(res_dict['_FILTER_CACHE_MIN_USES'][0], '0')
+    env.assertEqual(res_dict['_SNIPPET_CACHE_BYTES'][0], '0')
+    env.assertEqual(res_dict['_CURSOR_READ_AHEAD_BYTES'][0], '0')
+    env.assertEqual(res_dict['_IMPACT_POSTINGS_MIN_DOCS'][0], '0')
+    env.assertEqual(res_dict['_IMPACT_POSTINGS_SIZE'][0], '1000')
+    env.assertEqual(res_dict['_FORK_GC_CYCLE_BUDGET_MS'][0], '0')
+    env.assertEqual(res_dict['_FORK_GC_APPLY_THREADS'][0], '0')
     env.assertEqual(res_dict['ON_OOM'][0], 'ignore')
 
 @skip(cluster=True)
@@ -223,6 +354,37 @@ def testInitConfig():
     _test_config_num('_BG_INDEX_MEM_PCT_THR', 100)
     _test_config_num('BM25STD_TANH_FACTOR', 4)
     _test_config_num('_BG_INDEX_OOM_PAUSE_TIME', 0)
+    _test_config_num('_INDEX_READER_PREFETCH_DISTANCE', 16)
+    _test_config_num('_PARALLEL_QUERY_RANGES', 0)
+    _test_config_num('_HEAVY_QUERY_COST', 0)
+    _test_config_num('_MAX_RUNNING_HEAVY_QUERIES', 1)
+    _test_config_num('_MAX_WAITING_HEAVY_QUERIES', 256)
+    _test_config_num('_EXPR_FUNCTION_MEMO_SIZE', 0)
+    _test_config_num('_GROUPBY_PARTITIONS', 0)
+    _test_config_num('_QUANTILE_COMPRESSION', 0)
+    _test_config_num('_REDUCER_MEMORY_BUDGET', 0)
+    _test_config_num('_NUMERIC_BITMAP_UNION_RANGES', 0)
+    _test_config_num('_NUMERIC_MERGE_UNION_RANGES', 0)
+    _test_config_num('_NUMERIC_HLL_PRECISION', 6)
+    _test_config_num('_TAG_COMPACT_THRESHOLD', 0)
+    _test_config_num('_TAG_SET_MIN_VALUES', 0)
+    _test_config_num('_SHARD_WINDOW_TARGET_RECALL', 0)
+    _test_config_num('_COORD_RESULT_CACHE_TTL_MS', 0)
+    _test_config_num('_SCORE_THRESHOLD_MIN_RESULTS', 0)
+    _test_config_num('_HYBRID_FILTER_IDS_MAX', 0)
+    _test_config_num('_KNN_RESULT_CACHE_ENTRIES', 0)
+    _test_config_num('_SEARCH_RESULT_CACHE_BYTES', 0)
+    _test_config_num('_SLOWLOG_THRESHOLD_MS', 0)
+    _test_config_num('_SLOWLOG_MAX_LEN', 128)
+    _test_config_num('_PROFILE_SAMPLE_RATE', 0)
+    _test_config_num('_QUERY_PLAN_CACHE_ENTRIES', 0)
+    _test_config_num('_FILTER_CACHE_MIN_USES', 0)
+    _test_config_num('_SNIPPET_CACHE_BYTES', 0)
+    _test_config_num('_CURSOR_READ_AHEAD_BYTES', 0)
+    _test_config_num('_IMPACT_POSTINGS_MIN_DOCS', 10000)
+    _test_config_num('_IMPACT_POSTINGS_SIZE', 100)
+    _test_config_num('_FORK_GC_CYCLE_BUDGET_MS', 0)
+    _test_config_num('_FORK_GC_APPLY_THREADS', 0)
 
 
 # True/False arguments
@@ -248,6 +410,34 @@ def testInitConfig():
     _test_config_str('_FREE_RESOURCE_ON_THREAD', 'true', 'true')
     _test_config_str('_PRIORITIZE_INTERSECT_UNION_CHILDREN', 'true', 'true')
     _test_config_str('_PRIORITIZE_INTERSECT_UNION_CHILDREN', 'false', 'false')
+    _test_config_str('_NUMERIC_EXACT_CARDINALITY', 'true', 'true')
+    _test_config_str('_NUMERIC_EXACT_CARDINALITY', 'false', 'false')
+    _test_config_str('_SUFFIX_ARRAY', 'true', 'true')
+    _test_config_str('_SUFFIX_ARRAY', 'false', 'false')
+    _test_config_str('_BINARY_SHARD_ROWS', 'false', 'false')
+    _test_config_str('_BINARY_SHARD_ROWS', 'true', 'true')
+    _test_config_str('_HEDGE_SHARD_REQUESTS', 'true', 'true')
+    _test_config_str('_HEDGE_SHARD_REQUESTS', 'false', 'false')
+    _test_config_str('_SHARD_WINDOW_SECOND_ROUND', 'true', 'true')
+    _test_config_str('_SHARD_WINDOW_SECOND_ROUND', 'false', 'false')
+    _test_config_str('_GEO_CELL_COVERING', 'true', 'true')
+    _test_config_str('_GEO_CELL_COVERING', 'false', 'false')
+    _test_config_str('_PERSIST_INDEXES', 'true', 'true')
+    _test_config_str('_PERSIST_INDEXES', 'false', 'false')
+    _test_config_str('_INDEX_SEGMENTS', 'true', 'true')
+    _test_config_str('_INDEX_SEGMENTS', 'false', 'false')
+    _test_config_str('_LAZY_INDEX_LOADING', 'true', 'true')
+    _test_config_str('_LAZY_INDEX_LOADING', 'false', 'false')
+    _test_config_str('_PROFILE_HW_COUNTERS', 'true', 'true')
+    _test_config_str('_PROFILE_HW_COUNTERS', 'false', 'false')
+    _test_config_str('_SPILL_IDLE_CURSORS', 'true', 'true')
+    _test_config_str('_SPILL_IDLE_CURSORS', 'false', 'false')
+    _test_config_str('_SPELLCHECK_DELETE_INDEX', 'true', 'true')
+    _test_config_str('_SPELLCHECK_DELETE_INDEX', 'false', 'false')
+    _test_config_str('_SKIP_UNCHANGED_DOCS', 'true', 'true')
+    _test_config_str('_SKIP_UNCHANGED_DOCS', 'false', 'false')
+    _test_config_str('_INDEX_DELTA_REPLICATION', 'true', 'true')
+    _test_config_str('_INDEX_DELTA_REPLICATION', 'false', 'false')
     _test_config_str('ENABLE_UNSTABLE_FEATURES', 'true', 'true')
     _test_config_str('ENABLE_UNSTABLE_FEATURES', 'false', 'false')
     _test_config_str('ON_OOM', 'ignore')
@@ -503,10 +693,42 @@ numericConfigs = [
     ('search-bm25std-tanh-factor', 'BM25STD_TANH_FACTOR', 4, 1, 10000, False, False),
     ('search-_bg-index-oom-pause-time','_BG_INDEX_OOM_PAUSE_TIME', 0, 0, UINT32_MAX, False, False),
     ('search-indexer-yield-every-ops', 'INDEXER_YIELD_EVERY_OPS', 1000, 1, UINT32_MAX, False, False),
+    ('search-_index-reader-prefetch-distance', '_INDEX_READER_PREFETCH_DISTANCE', 16, 0, UINT32_MAX, False, False),
+    ('search-_parallel-query-ranges', '_PARALLEL_QUERY_RANGES', 0, 0, 16, False, False),
+    ('search-_heavy-query-cost', '_HEAVY_QUERY_COST', 0, 0, UINT32_MAX, False, False),
+    ('search-_max-running-heavy-queries', '_MAX_RUNNING_HEAVY_QUERIES', 1, 1, 1024, False, False),
+    ('search-_max-waiting-heavy-queries', '_MAX_WAITING_HEAVY_QUERIES', 256, 0, UINT32_MAX, False, False),
+    ('search-_expr-function-memo-size', '_EXPR_FUNCTION_MEMO_SIZE', 0, 0, 4096, False, False),
+    ('search-_groupby-partitions', '_GROUPBY_PARTITIONS', 0, 0, 64, False, False),
+    ('search-_quantile-compression', '_QUANTILE_COMPRESSION', 0, 0, 1000, False, False),
+    ('search-_reducer-memory-budget', '_REDUCER_MEMORY_BUDGET', 0, 0, 1 << 20, False, False),
+    ('search-_numeric-bitmap-union-ranges', '_NUMERIC_BITMAP_UNION_RANGES', 0, 0, 65536, False, False),
+    ('search-_numeric-merge-union-ranges', '_NUMERIC_MERGE_UNION_RANGES', 0, 0, 65536, False, False),
+    ('search-_numeric-hll-precision', '_NUMERIC_HLL_PRECISION', 6, 4, 12, False, False),
+    ('search-_tag-compact-threshold', '_TAG_COMPACT_THRESHOLD', 0, 0, 1 << 30, False, False),
+    ('search-_tag-set-min-values', '_TAG_SET_MIN_VALUES', 0, 0, 65536, False, False),
+    ('search-_shard-window-target-recall', '_SHARD_WINDOW_TARGET_RECALL', 0, 0, 100, False, False),
+    ('search-_coord-result-cache-ttl-ms', '_COORD_RESULT_CACHE_TTL_MS', 0, 0, 3600000, False, False),
+    ('search-_score-threshold-min-results', '_SCORE_THRESHOLD_MIN_RESULTS', 0, 0, 1 << 30, False, False),
+    ('search-_hybrid-filter-ids-max', '_HYBRID_FILTER_IDS_MAX', 0, 0, 1 << 26, False, False),
+    ('search-_knn-result-cache-entries', '_KNN_RESULT_CACHE_ENTRIES', 0, 0, 4096, False, False),
+    ('search-_search-result-cache-bytes', '_SEARCH_RESULT_CACHE_BYTES', 0, 0, 1 << 30, False, False),
+    ('search-_slowlog-threshold-ms', '_SLOWLOG_THRESHOLD_MS', 0, 0, 24 * 60 * 60 * 1000, False, False),
+    ('search-_slowlog-max-len', '_SLOWLOG_MAX_LEN', 128, 1, 65536, False, False),
+    ('search-_profile-sample-rate', '_PROFILE_SAMPLE_RATE', 0, 0, 1000000, False, False),
+    ('search-_query-plan-cache-entries', '_QUERY_PLAN_CACHE_ENTRIES', 0, 0, 4096, False, False),
+    ('search-_filter-cache-min-uses', '_FILTER_CACHE_MIN_USES', 0, 0, 1024, False, False),
+    ('search-_snippet-cache-bytes', '_SNIPPET_CACHE_BYTES', 0, 0, 1 << 30, False, False),
+    ('search-_cursor-read-ahead-bytes', '_CURSOR_READ_AHEAD_BYTES', 0, 0, 1 << 30, False, False),
+    ('search-_impact-postings-min-docs', '_IMPACT_POSTINGS_MIN_DOCS', 0, 0, 1 << 30, False, False),
+    ('search-_impact-postings-size', '_IMPACT_POSTINGS_SIZE', 1000, 1, 1 << 20, False, False),
+    ('search-_fork-gc-cycle-budget-ms', '_FORK_GC_CYCLE_BUDGET_MS', 0, 0, LLONG_MAX, False, False),
+    ('search-_fork-gc-apply-threads', '_FORK_GC_APPLY_THREADS', 0, 0, 16, False, False),
     # Cluster parameters
     ('search-threads', 'SEARCH_THREADS', 20, 1, LLONG_MAX, True, True),
     ('search-topology-validation-timeout', 'TOPOLOGY_VALIDATION_TIMEOUT', 30_000, 0, LLONG_MAX, False, True),
     ('search-cursor-reply-threshold', 'CURSOR_REPLY_THRESHOLD', 1, 1, LLONG_MAX, False, True),
+    ('search-cursor-read-ahead', 'CURSOR_READ_AHEAD', 1, 1, 1024, False, True),
     ('search-conn-per-shard', 'CONN_PER_SHARD', 0, 0, UINT32_MAX, False, True),
 ]
 
@@ -1303,6 +1525,20 @@ booleanConfigs = [
     ('search-no-mem-pools', 'NO_MEM_POOLS', 'no', True, True),
     ('search-partial-indexed-docs', 'PARTIAL_INDEXED_DOCS', 'no', True, False),
     ('search-_prioritize-intersect-union-children', '_PRIORITIZE_INTERSECT_UNION_CHILDREN', 'no', False, False),
+    ('search-_numeric-exact-cardinality', '_NUMERIC_EXACT_CARDINALITY', 'no', False, False),
+    ('search-_suffix-array', '_SUFFIX_ARRAY', 'no', False, False),
+    ('search-_binary-shard-rows', '_BINARY_SHARD_ROWS', 'yes', False, False),
+    ('search-_hedge-shard-requests', '_HEDGE_SHARD_REQUESTS', 'no', False, False),
+    ('search-_shard-window-second-round', '_SHARD_WINDOW_SECOND_ROUND', 'no', False, False),
+    ('search-_geo-cell-covering', '_GEO_CELL_COVERING', 'no', False, False),
+    ('search-_persist-indexes', '_PERSIST_INDEXES', 'no', False, False),
+    ('search-_index-segments', '_INDEX_SEGMENTS', 'no', False, False),
+    ('search-_lazy-index-loading', '_LAZY_INDEX_LOADING', 'no', False, False),
+    ('search-_profile-hw-counters', '_PROFILE_HW_COUNTERS', 'no', False, False),
+    ('search-_spill-idle-cursors', '_SPILL_IDLE_CURSORS', 'no', False, False),
+    ('search-_spellcheck-delete-index', '_SPELLCHECK_DELETE_INDEX', 'no', False, False),
+    ('search-_skip-unchanged-docs', '_SKIP_UNCHANGED_DOCS', 'no', False, False),
+    ('search-_index-delta-replication', '_INDEX_DELTA_REPLICATION', 'no', False, False),
     ('search-raw-docid-encoding', 'RAW_DOCID_ENCODING', 'no', True, False),
     ('search-enable-unstable-features', 'ENABLE_UNSTABLE_FEATURES', 'no', False, False),
 ]
@@ -330,6 +330,29 @@ def testContainsDebugCommand(env):
   env.expect(debug_cmd(), 'DUMP_SUFFIX_TRIE', 'idx', 'tag_no', 'tag_yes').error(). \
     contains('wrong number of arguments')
 
+@skip(cluster=True)
+def testContainsSuffixArray(env):
+  env.expect(config_cmd(), 'set', 'MINPREFIX', 1).ok()
+  env.expect(config_cmd(), 'set', 'FORK_GC_CLEAN_THRESHOLD', 0).ok()
+  conn = getConnectionByEnv(env)
+  conn.execute_command('FT.CREATE', 'idx_trie', 'SCHEMA', 't', 'TEXT', 'WITHSUFFIXTRIE')
+  env.expect(config_cmd(), 'set', '_SUFFIX_ARRAY', 'true').ok()
+  conn.execute_command('FT.CREATE', 'idx_array', 'SCHEMA', 't', 'TEXT', 'WITHSUFFIXTRIE')
+  env.expect(config_cmd(), 'set', '_SUFFIX_ARRAY', 'false').ok()
+
+  # Enough terms for the suffix array to build and merge segments
+  for i in range(3000):
+    conn.execute_command('HSET', 'doc%d' % i, 't', 'foo%d bar%d' % (i, i % 7))
+  for i in range(0, 3000, 3):
+    conn.execute_command('HSET', 'doc%d' % i, 't', 'baz%d' % i)
+  forceInvokeGC(env, 'idx_array')
+  forceInvokeGC(env, 'idx_trie')
+
+  for query in ['*oo12*', '*12', '*ar3*', '*az1*', "w'*o?12*'", "w'f*2*3'"]:
+    expected = env.cmd('FT.SEARCH', 'idx_trie', query, 'LIMIT', 0, 0)
+    env.assertGreater(expected[0], 0, message=query)
+    env.expect('FT.SEARCH', 'idx_array', query, 'LIMIT', 0, 0).equal(expected)
+
 @skip(cluster=True)
 def testContainsMixedWithSuffix(env):
 
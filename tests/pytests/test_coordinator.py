@@ -79,6 +79,233 @@ def testPendingCommands(env:Env):
         env.cmd('SEARCH.CLUSTERINFO')
     env.expect('FT.SEARCH', 'idx', 'hello').equal([0])
 
+@skip(cluster=False)
+def testConnectionQueueStats(env:Env):
+    verify_shard_init(env)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+    for i in range(10):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello')
+    for _ in range(20):
+        env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT').apply(lambda r: r[0]).equal(10)
+
+    # Every connection reports its state, and the commands it sent and queues
+    states = env.cmd(debug_cmd(), 'SHARD_CONNECTION_STATES')
+    total_sent = 0
+    for conn_states in states[1::2]:
+        for state in conn_states:
+            name, in_flight, max_in_flight, sent = state.split(', ')
+            env.assertContains(name, ['Connected', 'Connecting'], message=state)
+            env.assertEqual(in_flight, 'in flight: 0', message=state)
+            env.assertTrue(max_in_flight.startswith('max in flight: '), message=state)
+            env.assertTrue(sent.startswith('sent: '), message=state)
+            total_sent += int(sent[len('sent: '):])
+    # At least a command for each shard and search
+    env.assertGreaterEqual(total_sent, 20 * env.shardsCount)
+
+def _testBinaryShardRows(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TAG', 'n', 'NUMERIC', 's', 'TEXT').ok()
+    for i in range(100):
+        # Strings both short enough to be in the dictionary of the rows and longer
+        conn.execute_command('HSET', f'doc{i}', 't', f'tag{i % 5}', 'n', i, 's', 'x' * (i % 3) * 40)
+    conn.execute_command('HSET', 'nofields', 'other', 'value')
+
+    queries = [
+        ['FT.AGGREGATE', 'idx', '*', 'LOAD', '3', '@t', '@n', '@s', 'SORTBY', '2', '@n', 'ASC', 'MAX', '200'],
+        ['FT.AGGREGATE', 'idx', '*', 'LOAD', '1', '@__key', 'APPLY', '@n * 2', 'AS', 'm',
+         'SORTBY', '2', '@__key', 'ASC', 'MAX', '200'],
+        ['FT.AGGREGATE', 'idx', '*', 'GROUPBY', '1', '@t', 'REDUCE', 'COUNT', '0', 'AS', 'c',
+         'REDUCE', 'MAX', '1', '@n', 'AS', 'max', 'SORTBY', '2', '@t', 'ASC'],
+        ['FT.AGGREGATE', 'idx', '@n:[0 20]', 'GROUPBY', '1', '@n', 'REDUCE', 'TOLIST', '1', '@t', 'AS', 'ts',
+         'SORTBY', '2', '@n', 'DESC'],
+    ]
+    for query in queries:
+        # The coordinator asks the shards for the binary rows unless disabled
+        env.expect(config_cmd(), 'SET', '_BINARY_SHARD_ROWS', 'false').ok()
+        expected = env.cmd(*query)
+        env.expect(config_cmd(), 'SET', '_BINARY_SHARD_ROWS', 'true').ok()
+        env.assertEqual(env.cmd(*query), expected, message=query)
+
+@skip(cluster=False)
+def testBinaryShardRows():
+    _testBinaryShardRows(Env(protocol=2))
+
+@skip(cluster=False)
+def testBinaryShardRows_resp3():
+    _testBinaryShardRows(Env(protocol=3))
+
+@skip(cluster=False)
+def testSortedShardRows(env):
+    # The shards sort their rows, so the coordinator stops reading a shard once one of its rows
+    # misses the top results. More rows than a cursor read sends are asked for, so that the
+    # cursors of some shards are deleted before they are depleted.
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TAG', 'n', 'NUMERIC', 'SORTABLE').ok()
+    num_docs = 3000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 't', f'tag{i % 7}', 'n', i)
+
+    def rows(res, *fields):
+        return [tuple(dict(zip(row[::2], row[1::2]))[f] for f in fields) for row in res[1:]]
+
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'SORTBY', '2', '@n', 'DESC', 'LIMIT', '0', '10')
+    env.assertEqual(rows(res, 'n'), [(str(i),) for i in range(num_docs - 1, num_docs - 11, -1)])
+
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'SORTBY', '2', '@n', 'ASC', 'LIMIT', '0', '2500')
+    env.assertEqual(rows(res, 'n'), [(str(i),) for i in range(2500)])
+
+    res = env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', '2', '@t', '@n',
+                  'SORTBY', '4', '@t', 'ASC', '@n', 'DESC', 'LIMIT', '5', '1500')
+    expected = sorted(((f'tag{i % 7}', -i) for i in range(num_docs)))[5:1505]
+    env.assertEqual(rows(res, 't', 'n'), [(t, str(-n)) for t, n in expected])
+
+@skip(cluster=False)
+def testHedgedShardRequests(env):
+    # The test clusters have no replicas, so that the requests never get hedged, but the replies
+    # still go through the hedged requests
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE').ok()
+    num_docs = 100
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', i)
+    env.expect(config_cmd(), 'SET', '_HEDGE_SHARD_REQUESTS', 'true').ok()
+
+    before = env.cmd('INFO', 'MODULES')
+    num_queries = 50
+    for _ in range(num_queries):
+        res = env.cmd('FT.SEARCH', 'idx', '*', 'SORTBY', 'n', 'DESC', 'LIMIT', '0', '3', 'NOCONTENT')
+        env.assertEqual(res, [num_docs, 'doc99', 'doc98', 'doc97'])
+    after = env.cmd('INFO', 'MODULES')
+    env.assertEqual(after['search_coord_shard_requests'] - before['search_coord_shard_requests'],
+                    num_queries * env.shardsCount)
+    env.assertEqual(after['search_coord_hedged_shard_requests'], 0)
+    env.assertEqual(after['search_coord_hedged_shard_requests_won'], 0)
+    env.expect(config_cmd(), 'SET', '_HEDGE_SHARD_REQUESTS', 'false').ok()
+
+@skip(cluster=False)
+def testIOThreadsInfo():
+    io_threads = 3
+    env = Env(moduleArgs=f'SEARCH_IO_THREADS {io_threads}')
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 'n', i)
+    # The idle IO threads share the requests
+    for _ in range(10 * io_threads):
+        env.assertEqual(env.cmd('FT.SEARCH', 'idx', '*', 'LIMIT', '0', '0')[0], 100)
+    time.sleep(0.1)
+
+    info = env.cmd('INFO', 'MODULES')
+    buckets = ['lag_le_1ms', 'lag_le_2ms', 'lag_le_5ms', 'lag_le_10ms', 'lag_le_50ms',
+               'lag_le_100ms', 'lag_le_500ms', 'lag_gt_500ms']
+    for i in range(1, io_threads + 1):
+        io_thread = info[f'search_io_thread_{i}']
+        for field in buckets + ['lag_last_us', 'lag_max_us', 'requests_in_flight']:
+            env.assertTrue(field in io_thread, message=(i, field))
+        # The loop of each thread sampled its lag
+        env.assertGreater(sum(io_thread[b] for b in buckets), 0, message=i)
+    env.assertFalse(f'search_io_thread_{io_threads + 1}' in info)
+
+def _testScoreThreshold(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCORE_FIELD', 'sc', 'SCHEMA', 't', 'TEXT').ok()
+    num_docs = 1000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 't', ' '.join(['hello'] * (i % 13 + 1) + ['world'] * (i % 7)),
+                             'sc', (i + 1) / (num_docs + 1))
+
+    queries = [
+        ['FT.SEARCH', 'idx', 'hello', 'SCORER', 'DOCSCORE', 'LIMIT', '0', '100'],
+        ['FT.SEARCH', 'idx', 'hello', 'SCORER', 'DOCSCORE', 'WITHSCORES', 'NOCONTENT', 'LIMIT', '700', '50'],
+        ['FT.SEARCH', 'idx', 'hello | world', 'WITHSCORES', 'RETURN', '1', 't', 'LIMIT', '400', '30'],
+        # Fewer results than the limit
+        ['FT.SEARCH', 'idx', '@t:world', 'SCORER', 'DOCSCORE', 'NOCONTENT', 'LIMIT', '0', '990'],
+    ]
+    for query in queries:
+        expected = env.cmd(*query)
+        env.expect(config_cmd(), 'SET', '_SCORE_THRESHOLD_MIN_RESULTS', '100').ok()
+        before = env.cmd('INFO', 'MODULES')['search_coord_shard_requests']
+        env.assertEqual(env.cmd(*query), expected, message=query)
+        # The scores are read before the results
+        env.assertEqual(env.cmd('INFO', 'MODULES')['search_coord_shard_requests'] - before,
+                        2 * env.shardsCount, message=query)
+        env.expect(config_cmd(), 'SET', '_SCORE_THRESHOLD_MIN_RESULTS', '0').ok()
+
+    # Only the searches sorted by score use a threshold
+    env.expect(config_cmd(), 'SET', '_SCORE_THRESHOLD_MIN_RESULTS', '100').ok()
+    before = env.cmd('INFO', 'MODULES')['search_coord_shard_requests']
+    env.cmd('FT.SEARCH', 'idx', 'hello', 'SORTBY', 't', 'LIMIT', '0', '100')
+    env.cmd('FT.SEARCH', 'idx', 'hello', 'LIMIT', '0', '99')
+    env.assertEqual(env.cmd('INFO', 'MODULES')['search_coord_shard_requests'] - before, 2 * env.shardsCount)
+    env.expect(config_cmd(), 'SET', '_SCORE_THRESHOLD_MIN_RESULTS', '0').ok()
+
+    if env.protocol == 2:
+        # A shard only returns its results scoring at least the threshold
+        shard_query = ['_FT.SEARCH', 'idx', 'hello', 'SCORER', 'DOCSCORE', 'WITHSCORES', 'NOCONTENT',
+                       'LIMIT', '0', '100']
+        scores = env.cmd(*shard_query)[2::2]
+        threshold = scores[len(scores) // 2]
+        env.assertEqual(env.cmd(*shard_query, '_SCORE_THRESHOLD', threshold)[2::2],
+                        [score for score in scores if float(score) >= float(threshold)])
+        env.expect(*shard_query, '_SCORE_THRESHOLD', 'abc').error().contains('Bad arguments for _SCORE_THRESHOLD')
+
+@skip(cluster=False, min_shards=2)
+def testScoreThreshold():
+    _testScoreThreshold(Env(protocol=2))
+
+@skip(cluster=False, min_shards=2)
+def testScoreThreshold_resp3():
+    _testScoreThreshold(Env(protocol=3))
+
+@skip(cluster=False)
+def testResultCache():
+    env = Env(protocol=3)
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TAG', 'n', 'NUMERIC').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 't', f'tag{i % 5}', 'n', i)
+
+    def cache_stats():
+        info = env.cmd('INFO', 'MODULES')
+        return info['search_coord_result_cache_hits'], info['search_coord_result_cache_misses']
+
+    def sums(res):
+        return [(r['extra_attributes']['t'], r['extra_attributes']['sum']) for r in res['results']]
+
+    group = ['FT.AGGREGATE', 'idx', '*', 'GROUPBY', '1', '@t', 'REDUCE', 'SUM', '1', '@n', 'AS', 'sum']
+    query = group + ['SORTBY', '2', '@t', 'ASC']
+    expected = [(f'tag{t}', str(sum(range(t, 100, 5)))) for t in range(5)]
+    env.assertEqual(sums(env.cmd(*query)), expected)
+    # Nothing is cached unless enabled
+    env.assertEqual(cache_stats(), (0, 0))
+
+    env.expect(config_cmd(), 'SET', '_COORD_RESULT_CACHE_TTL_MS', 60000).ok()
+    env.assertEqual(sums(env.cmd(*query)), expected)
+    env.assertEqual(cache_stats(), (0, 1))
+    env.assertEqual(sums(env.cmd(*query)), expected)
+    # The steps of the coordinator are not part of the key, so that the rows of the shards are reused
+    env.assertEqual(sums(env.cmd(*(group + ['SORTBY', '2', '@t', 'DESC']))), expected[::-1])
+    env.assertEqual(cache_stats(), (2, 1))
+    stats = index_info(env)['result_cache_stats']
+    env.assertEqual((stats['hits'], stats['misses'], stats['entries']), (2, 1, 1))
+    env.assertGreater(stats['bytes'], 0)
+    env.assertGreater(env.cmd('INFO', 'MODULES')['search_coord_result_cache_bytes'], 0)
+
+    # Another query reads the revisions of the shards after the write, after which the cached rows
+    # are stale
+    conn.execute_command('HSET', 'doc100', 't', 'tag0', 'n', 1000)
+    env.assertEqual(env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', '0', 'REDUCE', 'COUNT', '0', 'AS', 'c')
+                    ['results'][0]['extra_attributes']['c'], '101')
+    expected[0] = ('tag0', str(int(expected[0][1]) + 1000))
+    env.assertEqual(sums(env.cmd(*query)), expected)
+    env.assertEqual(cache_stats(), (2, 3))
+
+    # Cursors are never cached
+    env.cmd(*(query + ['WITHCURSOR']))
+    env.assertEqual(cache_stats(), (2, 3))
+    env.expect(config_cmd(), 'SET', '_COORD_RESULT_CACHE_TTL_MS', 0).ok()
+
 def test_curly_brackets(env):
     conn = getConnectionByEnv(env)
     env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'SORTABLE').ok()
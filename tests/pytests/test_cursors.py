@@ -358,6 +358,49 @@ def CursorOnCoordinator(env: Env):
                 for i in range(n_docs):
                     env.assertContains(i, result_set)
 
+@skip(cluster=False)
+def testCursorReadAhead(env: Env):
+    env.expect('FT.CREATE idx SCHEMA n NUMERIC').ok()
+    conn = getConnectionByEnv(env)
+
+    read_ahead = 2
+    # Each shard replies with 1000 results per cursor read, have more replies than the read-ahead
+    n_docs = 1000 * (read_ahead + 1) * env.shardsCount
+    for i in range(n_docs):
+        conn.execute_command('HSET', i ,'n', i)
+
+    env.expect(config_cmd(), 'SET', 'CURSOR_READ_AHEAD', read_ahead).ok()
+    result_set = set()
+    def add_results(res):
+        for cur_res in [int(r[1]) for r in res[1:]]:
+            env.assertNotContains(cur_res, result_set)
+            result_set.add(cur_res)
+
+    with env.getConnection() as conn:
+        conn.execute_command('DEBUG', 'MARK-INTERNAL-CLIENT')
+        with conn.monitor() as monitor:
+            def next_shard_cursor_command():
+                while True:
+                    try:
+                        command = monitor.next_command()['command']
+                    except ValueError:
+                        continue
+                    if command.startswith('_FT.CURSOR'):
+                        return command
+
+            res, cursor = env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', '*', 'WITHCURSOR', 'COUNT', 100)
+            add_results(res)
+            # The next reply of the local shard is read before the client reads the cursor again
+            with TimeLimit(5, "the shard cursor was not read ahead"):
+                env.assertTrue(next_shard_cursor_command().startswith('_FT.CURSOR READ'))
+
+    while cursor:
+        res, cursor = env.cmd('FT.CURSOR', 'READ', 'idx', cursor)
+        add_results(res)
+    env.assertEqual(result_set, set(range(n_docs)))
+
+    env.expect(config_cmd(), 'SET', 'CURSOR_READ_AHEAD', 1).ok()
+
 # MOD-8483
 # Upon timeout, the sorter switches to yield mode until its heap is depleted.
 # Before the fix, the timeout flag was not reset after depleting the heap, causing subsequent FT.CURSOR READ
@@ -612,3 +655,84 @@ def testCountArgValidation(env):
     res, cid = env.cmd('FT.CURSOR', 'READ', 'idx', str(cid), 'COUNT', '2')
     env.assertEqual(cid, 0)
     env.assertEqual(res, [0])
+
+@skip(cluster=True)
+def testSpillIdleCursors(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 't', 'TEXT', 'g', 'TAG').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 'n', i, 't', f'text {i % 7}', 'g', f'g{i % 10}')
+
+    queries = [
+        ['LOAD', 2, '@t', '@g', 'SORTBY', 2, '@n', 'DESC', 'APPLY', '@n * 2', 'AS', 'n2',
+         'FILTER', '@n2 > 20', 'LIMIT', 5, 50],
+        ['GROUPBY', 1, '@g', 'REDUCE', 'COUNT', 0, 'AS', 'count',
+         'REDUCE', 'TOLIST', 1, '@n', 'AS', 'ns', 'APPLY', 'upper(@g)', 'AS', 'G'],
+        ['GROUPBY', 1, '@g', 'REDUCE', 'SUM', 1, '@n', 'AS', 'sum',
+         'SORTBY', 2, '@sum', 'ASC', 'MAX', 8],
+    ]
+    def read_all(args):
+        res, cid = env.cmd('FT.AGGREGATE', 'idx', '*', *args, 'WITHCURSOR', 'COUNT', 3)
+        rows = res[1:]
+        while cid:
+            res, cid = env.cmd('FT.CURSOR', 'READ', 'idx', cid)
+            rows += res[1:]
+        return rows
+
+    for args in queries:
+        env.expect(config_cmd(), 'SET', '_SPILL_IDLE_CURSORS', 'false').ok()
+        expected = read_all(args)
+        env.expect(config_cmd(), 'SET', '_SPILL_IDLE_CURSORS', 'true').ok()
+        env.assertEqual(read_all(args), expected, message=args)
+        env.assertGreater(len(expected), 3, message=args)
+
+    # The spilled cursors are still bound to their index
+    _, cid = env.cmd('FT.AGGREGATE', 'idx', '*', *queries[0], 'WITHCURSOR', 'COUNT', 3)
+    env.assertEqual(getCursorStats(env)['index_total'], 1)
+    env.expect('FT.DROPINDEX', 'idx').ok()
+    env.expect('FT.CURSOR', 'READ', 'idx', cid).error().contains('no such index')
+
+@skip(cluster=True)
+def testCursorReadAheadOnWorkers():
+    env = Env(moduleArgs='WORKERS 1')
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 't', 'TAG').ok()
+    for i in range(200):
+        conn.execute_command('HSET', f'doc{i}', 'n', i, 't', f't{i % 3}')
+
+    queries = [
+        ['@n:[10 150]', 'LOAD', 2, '@n', '@t'],
+        ['*', 'LOAD', 1, '@n', 'SORTBY', 2, '@n', 'DESC', 'MAX', 120],
+        ['*', 'GROUPBY', 1, '@t', 'REDUCE', 'COUNT', 0, 'AS', 'c'],
+    ]
+    def read_all(args, count):
+        res, cid = env.cmd('FT.AGGREGATE', 'idx', *args, 'WITHCURSOR', 'COUNT', count)
+        rows = res[1:]
+        while cid:
+            res, cid = env.cmd('FT.CURSOR', 'READ', 'idx', cid, 'COUNT', count)
+            rows += res[1:]
+        return rows
+
+    for args in queries:
+        env.expect(config_cmd(), 'SET', '_CURSOR_READ_AHEAD_BYTES', 0).ok()
+        expected = read_all(args, 7)
+        # The whole next chunk, then a single row as the cap allows
+        for cap in [1 << 20, 1]:
+            env.expect(config_cmd(), 'SET', '_CURSOR_READ_AHEAD_BYTES', cap).ok()
+            env.assertEqual(read_all(args, 7), expected, message=(args, cap))
+            # The chunks may change size between the reads
+            res, cid = env.cmd('FT.AGGREGATE', 'idx', *args, 'WITHCURSOR', 'COUNT', 10)
+            rows = res[1:]
+            count = 1
+            while cid:
+                res, cid = env.cmd('FT.CURSOR', 'READ', 'idx', cid, 'COUNT', count)
+                rows += res[1:]
+                count = count % 15 + 1
+            env.assertEqual(rows, expected, message=(args, cap))
+
+    # A cursor deleted while it is read ahead is gone
+    env.expect(config_cmd(), 'SET', '_CURSOR_READ_AHEAD_BYTES', 1 << 20).ok()
+    _, cid = env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', 1, '@n', 'WITHCURSOR', 'COUNT', 5)
+    env.cmd('FT.CURSOR', 'READ', 'idx', cid)
+    env.expect('FT.CURSOR', 'DEL', 'idx', cid).ok()
+    env.expect('FT.CURSOR', 'READ', 'idx', cid).error().contains('Cursor not found')
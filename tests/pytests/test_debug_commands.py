@@ -63,6 +63,7 @@ class TestDebugCommands(object):
             'INDEXER_SLEEP_BEFORE_YIELD_MICROS',
             'QUERY_CONTROLLER',
             'DUMP_SCHEMA',
+            'PROFILE_STATS',
             'FT.AGGREGATE',
             '_FT.AGGREGATE',
             'FT.SEARCH',
@@ -76,7 +77,8 @@ class TestDebugCommands(object):
         self.env.expect(debug_cmd(), 'help').equal(help_list)
 
         arity_2_cmds = ['GIT_SHA', 'DUMP_PREFIX_TRIE', 'GC_WAIT_FOR_JOBS', 'DELETE_LOCAL_CURSORS', 'SHARD_CONNECTION_STATES',
-                        'PAUSE_TOPOLOGY_UPDATER', 'RESUME_TOPOLOGY_UPDATER', 'CLEAR_PENDING_TOPOLOGY', 'INFO', 'INDEXES', 'GET_HIDE_USER_DATA_FROM_LOGS', 'YIELDS_ON_LOAD_COUNTER']
+                        'PAUSE_TOPOLOGY_UPDATER', 'RESUME_TOPOLOGY_UPDATER', 'CLEAR_PENDING_TOPOLOGY', 'INFO', 'INDEXES', 'GET_HIDE_USER_DATA_FROM_LOGS', 'YIELDS_ON_LOAD_COUNTER',
+                        'PROFILE_STATS']
         for cmd in [c for c in help_list if c not in arity_2_cmds]:
             self.env.expect(debug_cmd(), cmd).error().contains(err_msg)
 
@@ -289,7 +291,10 @@ class TestDebugCommands(object):
                                      'totalPendingJobs': orig_stats['totalPendingJobs']+1,
                                      'highPriorityPendingJobs': orig_stats['highPriorityPendingJobs'],
                                      'lowPriorityPendingJobs': orig_stats['lowPriorityPendingJobs']+1,
-                                     'numThreadsAlive': self.workers_count})
+                                     'numThreadsAlive': self.workers_count,
+                                     'localPendingJobs': 0,
+                                     'lockContentions': ANY,
+                                     'stolenJobs': ANY})
 
         # After resuming, expect that the job is done.
         orig_stats = stats
@@ -300,7 +305,10 @@ class TestDebugCommands(object):
                                      'totalPendingJobs': orig_stats['totalPendingJobs']-1,
                                      'highPriorityPendingJobs': orig_stats['highPriorityPendingJobs'],
                                      'lowPriorityPendingJobs': orig_stats['lowPriorityPendingJobs']-1,
-                                     'numThreadsAlive': self.workers_count})
+                                     'numThreadsAlive': self.workers_count,
+                                     'localPendingJobs': 0,
+                                     'lockContentions': ANY,
+                                     'stolenJobs': ANY})
 
     def testWorkersNumThreads(self):
         # test stats and drain
@@ -50,6 +50,24 @@ def testBasicGCWithEmptyInvIdx(env):
     # check that the gc collected the deleted docs
     env.expect(debug_cmd(), 'DUMP_INVIDX', 'idx', 'world').error().contains('Can not find the inverted index')
 
+@skip(cluster=True)
+def testReindexTermAfterGC(env):
+    """ a term whose inverted index was freed by the GC gets a new one when it is indexed again """
+    env.expect(config_cmd(), 'set', 'FORK_GC_CLEAN_THRESHOLD', 0).equal('OK')
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'title', 'TEXT').ok()
+    conn = getConnectionByEnv(env)
+    for i in range(3):
+        conn.execute_command('HSET', f'doc{i}', 'title', 'hello world')
+    for i in range(3):
+        conn.execute_command('DEL', f'doc{i}')
+    forceInvokeGC(env, 'idx')
+    env.expect(debug_cmd(), 'DUMP_INVIDX', 'idx', 'world').error().contains('Can not find the inverted index')
+
+    conn.execute_command('HSET', 'doc3', 'title', 'hello world')
+    conn.execute_command('HSET', 'doc4', 'title', 'world')
+    env.assertEqual(env.cmd(debug_cmd(), 'DUMP_INVIDX', 'idx', 'world'), [4, 5])
+    env.expect('FT.SEARCH', 'idx', 'world', 'NOCONTENT').equal([2, 'doc3', 'doc4'])
+
 @skip(cluster=True)
 def testNumericGCIntensive(env):
     NumberOfDocs = 1000
@@ -396,6 +414,41 @@ def testGFreeEmpryTerms(env):
     forceInvokeGC(env, 'idx')
     env.expect(debug_cmd(), 'DUMP_TERMS', 'idx').equal([])
 
+@skip(cluster=True)
+def testIncrementalGC(env):
+    if env.env == 'existing-env' or env.env == 'enterprise':
+        env.skip()
+
+    # one block per tick, so that a pass runs over many ticks
+    env = Env(moduleArgs='GC_POLICY INCREMENTAL GCSCANSIZE 1 FORK_GC_CLEAN_THRESHOLD 0')
+    env.expect(config_cmd(), 'get', 'GC_POLICY').equal([['GC_POLICY', 'incremental']])
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH',
+               'SCHEMA', 'title', 'TEXT', 'id', 'NUMERIC', 't', 'TAG').ok()
+    conn = getConnectionByEnv(env)
+    for i in range(100):
+        conn.execute_command('HSET', f'doc{i}', 'title', f'hello world{i % 10}', 'id', i, 't', f'tag{i % 2}')
+
+    # delete all the documents of the odd tag, and of the odd terms
+    for i in range(1, 100, 2):
+        conn.execute_command('DEL', f'doc{i}')
+
+    forceInvokeGC(env, 'idx')
+
+    kept = [i + 1 for i in range(0, 100, 2)]
+    env.assertEqual(env.cmd(debug_cmd(), 'DUMP_INVIDX', 'idx', 'hello'), kept)
+    env.assertEqual(env.cmd(debug_cmd(), 'DUMP_INVIDX', 'idx', 'world0'), [i + 1 for i in range(0, 100, 10)])
+    env.expect(debug_cmd(), 'DUMP_INVIDX', 'idx', 'world1').error().contains('Can not find the inverted index')
+    env.assertEqual(sorted(env.cmd(debug_cmd(), 'DUMP_TERMS', 'idx')),
+                    ['hello', 'world0', 'world2', 'world4', 'world6', 'world8'])
+    env.assertEqual(env.cmd(debug_cmd(), 'DUMP_TAGIDX', 'idx', 't'), [['tag0', kept]])
+    env.assertEqual(sorted(sum(env.cmd(debug_cmd(), 'DUMP_NUMIDX', 'idx', 'id'), [])), kept)
+    env.expect('FT.SEARCH', 'idx', '@id:[0 9]', 'NOCONTENT', 'SORTBY', 'id').equal(
+        [5, 'doc0', 'doc2', 'doc4', 'doc6', 'doc8'])
+
+    gc_dict = to_dict(index_info(env)['gc_stats'])
+    env.assertGreater(int(gc_dict['bytes_collected']), 0)
+    env.assertEqual(int(gc_dict['total_cycles']), 1)
+
 @skip(cluster=True)
 def testAutoMemory_MOD_3951():
     env = Env(moduleArgs='FORK_GC_CLEAN_THRESHOLD 0')
@@ -1,5 +1,6 @@
 from RLTest import Env
 from common import *
+import random
 
 def testGeoHset(env):
   conn = getConnectionByEnv(env)
@@ -167,3 +168,61 @@ def testGeoOnReopen(env:Env):
     checkResults(res)
 
   env.assertEqual(len(ids), n)
+
+def testGeoCellCovering(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'g', 'GEO').ok()
+  random.seed(7)
+  num_docs = 3000
+  for i in range(num_docs):
+    conn.execute_command('HSET', f'doc{i}', 'g', f'{2.35 + random.uniform(-1, 1):.6f},{48.85 + random.uniform(-1, 1):.6f}')
+
+  queries = [(2.35, 48.85, 1, 'km'), (2.35, 48.85, 20, 'km'), (2.1, 49.3, 35, 'km'),
+             (2.35, 48.85, 60, 'mi'), (3.2, 48.1, 5000, 'm'), (2.35, 48.85, 500, 'km')]
+  def search(lon, lat, radius, unit):
+    query = f'@g:[{lon} {lat} {radius} {unit}]'
+    res = env.cmd('FT.SEARCH', 'idx', query, 'NOCONTENT', 'LIMIT', 0, num_docs)
+    return sorted(res[1:])
+
+  expected = [search(*q) for q in queries]
+  run_command_on_all_shards(env, config_cmd(), 'SET', '_GEO_CELL_COVERING', 'true')
+  for q, exp in zip(queries, expected):
+    env.assertEqual(search(*q), exp, message=str(q))
+  # The documents of the cells inside the circle are read as numeric ranges, without their distance
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', '@g:[2.35 48.85 20 km]', 'NOCONTENT')
+  env.assertContains('NUMERIC', str(res))
+  run_command_on_all_shards(env, config_cmd(), 'SET', '_GEO_CELL_COVERING', 'false')
+
+def testGeoNearest(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'g', 'GEO', 't', 'TAG').ok()
+  random.seed(11)
+  num_docs = 5000
+  for i in range(num_docs):
+    conn.execute_command('HSET', f'doc{i}', 'g', f'{2.35 + random.uniform(-1, 1):.6f},{48.85 + random.uniform(-1, 1):.6f}',
+                         't', i % 3)
+
+  def nearest(query, apply, offset, num, filtered):
+    # A FILTER step before the sort disables reading the nearest documents only
+    args = ['FT.AGGREGATE', 'idx', query, 'LOAD', 1, '@t', 'APPLY', apply, 'AS', 'dist']
+    if filtered:
+      args += ['FILTER', '1']
+    args += ['SORTBY', 4, '@dist', 'ASC', '@t', 'ASC', 'LIMIT', offset, num]
+    return env.cmd(*args)[1:]
+
+  for query, apply in [('@g:[2.35 48.85 100 km]', 'geodistance(@g, 2.35, 48.85)'),
+                       ('@g:[2.1 49.3 50 mi]', 'geodistance(@g, "2.1,49.3")'),
+                       ('@g:[2.35 48.85 3 km]', 'geodistance(@g, 2.35, 48.85)')]:
+    for offset, num in [(0, 1), (0, 10), (5, 20), (0, 300)]:
+      env.assertEqual(nearest(query, apply, offset, num, False), nearest(query, apply, offset, num, True),
+                      message=f'{query} {offset} {num}')
+
+  if env.isCluster():
+    return
+  # Only the documents of the ring holding the nearest ones are read
+  res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', '@g:[2.35 48.85 100 km]',
+                'APPLY', 'geodistance(@g, 2.35, 48.85)', 'AS', 'dist', 'SORTBY', 2, '@dist', 'ASC', 'LIMIT', 0, 10)
+  env.assertContains('ID-LIST', str(res))
+  res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', '@g:[2.35 48.85 100 km]',
+                'APPLY', 'geodistance(@g, 2.35, 48.85)', 'AS', 'dist', 'SORTBY', 2, '@dist', 'DESC', 'LIMIT', 0, 10)
+  env.assertNotContains('ID-LIST', str(res))
@@ -1,6 +1,7 @@
 from RLTest import Env
 from common import *
 import json
+import math
 
 def array_of_key_value_to_map(res):
   '''
@@ -372,3 +373,59 @@ def testFtInfo(env):
   else:
     # TODO: in cluster - be able to wait for cleaning of the index (would wait for freeing the geoshape index memory)
     env.assertLess(cur_usage, usage)
+
+@skip(cluster=True)
+def testRepack(env):
+  conn = getConnectionByEnv(env)
+  env.expect(config_cmd(), 'SET', 'FORK_GC_CLEAN_THRESHOLD', 0).ok()
+  square = lambda i: f'POLYGON(({i} {i}, {i} {i+2}, {i+2} {i+2}, {i+2} {i}, {i} {i}))'
+  num_docs = 2000
+  for i in range(num_docs):
+    conn.execute_command('HSET', f'doc{i}', 'geom', square(i))
+
+  # The tree the background scan built is packed
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'geom', 'GEOSHAPE', 'FLAT').ok()
+  waitForIndex(env, 'idx')
+  res = array_of_key_value_to_map(env.cmd(debug_cmd(), 'DUMP_GEOMIDX', 'idx', 'geom'))
+  env.assertEqual(res['num_docs'], num_docs)
+  env.assertEqual(res['unpacked_changes'], 0)
+
+  query = 'POLYGON((99.5 99.5, 99.5 104.5, 104.5 104.5, 104.5 99.5, 99.5 99.5))'
+  expected = [7] + [f'doc{i}' for i in range(98, 105)]
+  res = env.cmd('FT.SEARCH', 'idx', '@geom:[intersects $poly]', 'PARAMS', 2, 'poly', query, 'NOCONTENT', 'DIALECT', 3)
+  env.assertEqual(toSortedFlatList(res), toSortedFlatList(expected))
+
+  # The GC leaves the tree as it is until enough of it changed
+  for i in range(10):
+    conn.execute_command('DEL', f'doc{i}')
+  forceInvokeGC(env, 'idx')
+  res = array_of_key_value_to_map(env.cmd(debug_cmd(), 'DUMP_GEOMIDX', 'idx', 'geom'))
+  env.assertEqual(res['unpacked_changes'], 10)
+
+  for i in range(num_docs, 2 * num_docs):
+    conn.execute_command('HSET', f'doc{i}', 'geom', square(i))
+  forceInvokeGC(env, 'idx')
+  res = array_of_key_value_to_map(env.cmd(debug_cmd(), 'DUMP_GEOMIDX', 'idx', 'geom'))
+  env.assertEqual(res['num_docs'], 2 * num_docs - 10)
+  env.assertEqual(res['unpacked_changes'], 0)
+  res = env.cmd('FT.SEARCH', 'idx', '@geom:[intersects $poly]', 'PARAMS', 2, 'poly', query, 'NOCONTENT', 'DIALECT', 3)
+  env.assertEqual(toSortedFlatList(res), toSortedFlatList(expected))
+
+def testManyPointsWithinIntersects(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'geom', 'GEOSHAPE', 'FLAT').ok()
+  # Polygons of 32 points, tested by their bounding box first
+  def circle(x, y, r):
+    points = [(x + r * math.cos(2 * math.pi * i / 32), y + r * math.sin(2 * math.pi * i / 32)) for i in range(32)]
+    return 'POLYGON((' + ', '.join(f'{px:.6f} {py:.6f}' for px, py in points + points[:1]) + '))'
+  conn.execute_command('HSET', 'inside', 'geom', circle(50, 50, 10))
+  conn.execute_command('HSET', 'crossing', 'geom', circle(70, 50, 10))
+  conn.execute_command('HSET', 'outside', 'geom', circle(200, 50, 10))
+  # The bounding box of the circle crosses the corner of the triangle, but not the circle itself
+  conn.execute_command('HSET', 'corner', 'geom', circle(25, 140, 10))
+
+  query = 'POLYGON((0 0, 0 160, 100 0, 0 0))'
+  res = env.cmd('FT.SEARCH', 'idx', '@geom:[within $poly]', 'PARAMS', 2, 'poly', query, 'NOCONTENT', 'DIALECT', 3)
+  env.assertEqual(toSortedFlatList(res), [1, 'inside'])
+  res = env.cmd('FT.SEARCH', 'idx', '@geom:[intersects $poly]', 'PARAMS', 2, 'poly', query, 'NOCONTENT', 'DIALECT', 3)
+  env.assertEqual(toSortedFlatList(res), [2, 'crossing', 'inside'])
@@ -98,6 +98,24 @@ def test_numeric_info(env):
   env.assertEqual(res4, exp3)  # Numeric field is sortable, explicitly NOINDEX, and automatically UNF
   env.assertEqual(res5, exp3)  # Numeric field is sortable, explicitly NOINDEX, and explicitly UNF
 
+@skip(cluster=True)
+def test_numeric_histogram_info(env):
+  env.cmd('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'm', 'NUMERIC', 't', 'TEXT')
+  # No histogram until a numeric field holds values
+  env.assertNotContains('numeric_histograms', index_info(env, 'idx'))
+
+  conn = getConnectionByEnv(env)
+  for i in range(1000):
+    conn.execute_command('HSET', f'doc{i}', 'n', i % 100, 't', 'hello')
+
+  histograms = to_dict(index_info(env, 'idx')['numeric_histograms'])
+  env.assertEqual(list(histograms.keys()), ['n'])
+  buckets = histograms['n']
+  env.assertLessEqual(len(buckets), 32)
+  env.assertEqual(sum(int(count) for _, _, count in buckets), 1000)
+  env.assertEqual(float(buckets[0][0]), 0)
+  env.assertEqual(float(buckets[-1][1]), 99)
+
 @skip(cluster=True)
 def test_info_text_tag_overhead(env):
   """Tests that the text and tag overhead fields report logic values (non-zero
@@ -197,3 +215,95 @@ def test_vecsim_info_stats_marked_deleted():
   env.assertTrue(all([r == 'DONE' for r in res]))
   info = index_info(env, 'idx')
   env.assertEqual(info["field statistics"][0]["marked_deleted"], 0)
+
+@skip(cluster=True)
+def test_vecsim_info_indexing_stats():
+  env = Env(protocol=3, moduleArgs='WORKERS 1')
+  vec_size = 6
+  data_type = 'FLOAT16'
+  env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'vector', 'VECTOR', 'HNSW', 6, 'DIM', 6, 'TYPE', 'float16', 'DISTANCE_METRIC', 'L2').ok()
+  env.expect(debug_cmd(), 'WORKERS', 'PAUSE').ok()
+  load_vectors_to_redis(env, 100, 0, vec_size, data_type)
+  stats = index_info(env, 'idx')['vector_indexing_stats']
+  env.assertEqual(stats['pending_jobs'], 100)
+  env.assertEqual(stats['completed_jobs'], 0)
+  env.assertEqual(stats['jobs_per_sec'], 0)
+
+  env.expect(debug_cmd(), 'WORKERS', 'resume').ok()
+  env.expect(debug_cmd(), 'WORKERS', 'DRAIN').ok()
+  stats = index_info(env, 'idx')['vector_indexing_stats']
+  env.assertEqual(stats['pending_jobs'], 0)
+  env.assertEqual(stats['completed_jobs'], 100)
+  env.assertGreater(stats['jobs_per_sec'], 0)
+
+  # Indexes without vectors don't report them
+  env.expect('FT.CREATE', 'idx2', 'SCHEMA', 't', 'TEXT').ok()
+  env.assertFalse('vector_indexing_stats' in index_info(env, 'idx2'))
+
+@skip(cluster=True)
+def test_vecsim_info_query_stats():
+  env = Env(protocol=3)
+  conn = getConnectionByEnv(env)
+  vec_size = 6
+  env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'vector', 'VECTOR', 'FLAT', 6, 'DIM', vec_size, 'TYPE', 'float32', 'DISTANCE_METRIC', 'L2', 't', 'TAG').ok()
+  query_vec = load_vectors_to_redis(env, 100, 0, vec_size)
+  for i in range(5):
+    conn.execute_command('HSET', i, 't', 'a')
+  stats = index_info(env, 'idx')['field statistics'][0]
+  env.assertEqual(stats['queries'], 0)
+
+  for _ in range(3):
+    env.cmd('FT.SEARCH', 'idx', '*=>[KNN 10 @vector $b]', 'PARAMS', 2, 'b', query_vec.tobytes(), 'NOCONTENT')
+  stats = index_info(env, 'idx')['field statistics'][0]
+  env.assertEqual(stats['queries'], 3)
+  env.assertEqual(stats['index_results_read'], 30)
+  env.assertEqual(stats['distance_computations'], 0)
+  env.assertGreater(stats['vector_bytes_read'], 0)
+
+  # The ad-hoc search computes the distances of the filtered documents itself
+  env.cmd('FT.SEARCH', 'idx', '@t:{a}=>[KNN 10 @vector $b HYBRID_POLICY ADHOC_BF]', 'PARAMS', 2, 'b', query_vec.tobytes(), 'NOCONTENT')
+  stats = index_info(env, 'idx')['field statistics'][0]
+  env.assertEqual(stats['queries'], 4)
+  env.assertEqual(stats['distance_computations'], 5)
+
+@skip(cluster=True)
+def test_search_result_cache_info(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+  for i in range(20):
+    conn.execute_command('HSET', f'doc{i}', 't', 'hello' if i % 2 else 'hello world', 'n', i)
+  def cache_stats():
+    stats = index_info(env)['search_result_cache_stats']
+    return stats['hits'], stats['misses'], stats['entries']
+  queries = [
+    ['FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'DESC', 'LIMIT', 0, 5],
+    ['FT.SEARCH', 'idx', 'world', 'WITHSCORES', 'RETURN', 1, 't'],
+    ['FT.SEARCH', 'idx', '@n:[3 8]', 'NOCONTENT'],
+  ]
+  expected = [env.cmd(*query) for query in queries]
+  # Nothing is cached unless enabled
+  env.assertNotContains('search_result_cache_stats', index_info(env))
+
+  env.expect(config_cmd(), 'SET', '_SEARCH_RESULT_CACHE_BYTES', 1 << 20).ok()
+  for _ in range(2):
+    for query, res in zip(queries, expected):
+      env.assertEqual(env.cmd(*query), res, message=query)
+  env.assertEqual(cache_stats(), (3, 3, 3))
+  # The arguments are part of the key
+  env.assertEqual(env.cmd(*(queries[0][:-1] + [4])), expected[0][:1] + expected[0][1:9])
+  env.assertEqual(cache_stats(), (3, 4, 4))
+  env.assertGreater(index_info(env)['search_result_cache_stats']['bytes'], 0)
+
+  # The cached rows are dropped once the index changes
+  conn.execute_command('HSET', 'doc100', 't', 'hello world', 'n', 100)
+  res = env.cmd(*queries[0])
+  env.assertEqual(res[0], 21)
+  env.assertEqual(res[1], 'doc100')
+  env.assertEqual(cache_stats(), (3, 5, 1))
+  conn.execute_command('DEL', 'doc100')
+  env.assertEqual(env.cmd(*queries[0]), expected[0])
+
+  # Profiled queries are never cached
+  env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello')
+  env.assertEqual(cache_stats()[:2], (3, 6))
+  env.expect(config_cmd(), 'SET', '_SEARCH_RESULT_CACHE_BYTES', 0).ok()
@@ -492,6 +492,119 @@ def test_counting_queries_BG():
   test_counting_queries(env)
 
 
+@skip(cluster=True)
+def test_latency_histograms(env: Env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE').ok()
+  for i in range(100):
+    conn.execute_command('HSET', f'doc{i}', 'n', i)
+
+  def latency(name):
+    return {k: int(v) for k, v in field_info_to_dict(info_modules_to_dict(conn)['search_latency'][f'search_{name}']).items()}
+
+  for name in ['query_search', 'query_aggregate', 'stage_parse', 'stage_sort', 'stage_reply']:
+    env.assertEqual(latency(name), {'count': 0, 'p50': 0, 'p99': 0, 'p999': 0, 'max': 0}, message=name)
+
+  for _ in range(3):
+    env.cmd('FT.SEARCH', 'idx', '@n:[0 50]', 'SORTBY', 'n')
+  env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', 1, '@n')
+
+  env.assertEqual(latency('query_search')['count'], 3)
+  env.assertEqual(latency('query_aggregate')['count'], 1)
+  env.assertEqual(latency('query_hybrid')['count'], 0)
+  for name in ['query_search', 'stage_parse', 'stage_plan', 'stage_iterators', 'stage_sort', 'stage_reply']:
+    stats = latency(name)
+    env.assertGreater(stats['count'], 0, message=name)
+    env.assertLessEqual(stats['p50'], stats['p99'], message=name)
+    env.assertLessEqual(stats['p99'], stats['p999'], message=name)
+    env.assertLessEqual(stats['p999'], stats['max'], message=name)
+
+
+@skip(cluster=True)
+def test_lock_wait_histograms():
+  env = Env(moduleArgs='WORKERS 2')
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+
+  def wait(name):
+    return {k: int(v) for k, v in field_info_to_dict(info_modules_to_dict(conn)['search_latency'][f'search_wait_{name}']).items()}
+
+  # Only the waits which blocked are counted
+  for name in ['spec_read_lock', 'spec_write_lock', 'gc_lock', 'depleter_sync']:
+    env.assertEqual(wait(name), {'count': 0, 'p50': 0, 'p99': 0, 'p999': 0, 'max': 0, 'total': 0}, message=name)
+
+  for i in range(100):
+    conn.execute_command('HSET', f'doc{i}', 't', f'hello {i}')
+  for _ in range(10):
+    env.cmd('FT.SEARCH', 'idx', 'hello')
+  for name in ['spec_read_lock', 'spec_write_lock', 'gc_lock', 'depleter_sync']:
+    stats = wait(name)
+    env.assertLessEqual(stats['p50'], stats['max'], message=name)
+    env.assertLessEqual(stats['max'], stats['total'], message=name)
+
+
+@skip(cluster=True)
+def test_sampled_profile(env: Env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+  for i in range(100):
+    conn.execute_command('HSET', f'doc{i}', 't', 'hello world', 'n', i)
+
+  def sampled_profile():
+    return info_modules_to_dict(conn)['search_sampled_profile']
+
+  # Disabled by default
+  env.cmd('FT.SEARCH', 'idx', 'hello @n:[0 50]')
+  env.assertEqual(sampled_profile(), {'search_sampled_queries': '0'})
+
+  env.expect(config_cmd(), 'SET', '_PROFILE_SAMPLE_RATE', '1').ok()
+  for _ in range(3):
+    env.cmd('FT.SEARCH', 'idx', 'hello @n:[0 50]')
+  env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', 1, '@n')
+  # The query is profiled without replying with its profile
+  res = env.cmd('FT.SEARCH', 'idx', 'hello', 'NOCONTENT', 'LIMIT', 0, 1)
+  env.assertEqual(res, [100, 'doc0'])
+
+  info = sampled_profile()
+  env.assertEqual(info['search_sampled_queries'], '5')
+  text = {k: float(v) for k, v in field_info_to_dict(info['search_iterator_text']).items()}
+  env.assertEqual(text['count'], 4)
+  env.assertGreater(text['calls'], 0)
+  # The range may be read from a few leaves of the numeric tree
+  env.assertGreaterEqual(int(field_info_to_dict(info['search_iterator_numeric'])['count']), 3)
+  env.assertEqual(field_info_to_dict(info['search_iterator_intersect'])['count'], '3')
+  env.assertEqual(field_info_to_dict(info['search_iterator_wildcard'])['count'], '1')
+  env.assertEqual(field_info_to_dict(info['search_rp_index'])['count'], '5')
+
+  stats = to_dict(env.cmd(debug_cmd(), 'PROFILE_STATS'))
+  env.assertEqual(stats['Sampled queries'], 5)
+  iterators = to_dict(stats['Iterators'])
+  env.assertEqual(to_dict(iterators['TEXT'])['Count'], 4)
+  env.assertNotContains('GEO', iterators)
+  env.assertEqual(to_dict(to_dict(stats['Result processors'])['Index'])['Count'], 5)
+
+  # One in two queries
+  env.expect(debug_cmd(), 'PROFILE_STATS', 'RESET').ok()
+  env.expect(config_cmd(), 'SET', '_PROFILE_SAMPLE_RATE', '2').ok()
+  for _ in range(4):
+    env.cmd('FT.SEARCH', 'idx', 'hello')
+  env.assertEqual(sampled_profile()['search_sampled_queries'], '2')
+
+  env.expect(debug_cmd(), 'PROFILE_STATS', 'FOO').error().contains('Expected RESET')
+  env.expect(config_cmd(), 'SET', '_PROFILE_SAMPLE_RATE', '0').ok()
+
+
+def test_simd_kernels(env: Env):
+  conn = getConnectionByEnv(env)
+  info = info_modules_to_dict(conn)['search_simd']
+  features = info['search_cpu_features'].split(',')
+  env.assertTrue(set(features) <= {'none', 'sse4.2', 'avx2', 'avx512', 'neon'}, message=features)
+  # Every kernel runs one of the implementations the CPU supports
+  for kernel in ['numeric_reducers', 'docid_intersect', 'hll']:
+    impl = info[f'search_kernel_{kernel}']
+    env.assertTrue(impl == 'scalar' or impl in features, message=(kernel, impl))
+
+
 @skip(cluster=True)
 def test_redis_info_modules_vecsim():
   env = Env(moduleArgs='WORKERS 2')
@@ -336,6 +336,36 @@ def testUNF(env):
              'GROUPBY', '4', '@txt', '@txt_unf', '@tag', '@tag_unf') \
      .equal([1, ['txt', u'Maße', 'txt_unf', u'Maße', 'tag', u'Maße', 'tag_unf', 'Maße']])
 
+@skip(cluster=True)
+def testStored(env):
+  conn = getConnectionByEnv(env)
+
+  env.expect('FT.CREATE', 'idx', 'SCHEMA',
+                          'txt', 'TEXT', 'STORED',
+                          'tag', 'TAG', 'SORTABLE', 'STORED',
+                          'n', 'NUMERIC', 'STORED', 'NOINDEX',
+                          'other', 'TEXT').ok()
+  env.expect('FT.CREATE', 'idx2', 'SCHEMA', 'g', 'GEO', 'STORED').error().contains('`STORED` is only supported')
+  attrs = index_info(env, 'idx')['attributes']
+  env.assertEqual(attrs[0], ['identifier', 'txt', 'attribute', 'txt', 'type', 'TEXT', 'WEIGHT', '1', 'SORTABLE', 'UNF', 'STORED'])
+  env.assertEqual(attrs[2], ['identifier', 'n', 'attribute', 'n', 'type', 'NUMERIC', 'SORTABLE', 'UNF', 'STORED', 'NOINDEX'])
+
+  conn.execute_command('HSET', 'doc1', 'txt', u'Maße', 'tag', 'FOO', 'n', '3', 'other', 'bar')
+  conn.execute_command('HSET', 'doc2', 'txt', 'hello', 'tag', 'baz', 'n', '1', 'other', 'bar')
+
+  # The stored values are returned as they are, sorted by them
+  env.expect('FT.SEARCH', 'idx', '*', 'RETURN', 3, 'txt', 'tag', 'n', 'SORTBY', 'n') \
+    .equal([2, 'doc2', ['txt', 'hello', 'tag', 'baz', 'n', '1'], 'doc1', ['txt', u'Maße', 'tag', 'FOO', 'n', '3']])
+  env.expect('FT.AGGREGATE', 'idx', '*', 'LOAD', 2, '@tag', '@n', 'SORTBY', 2, '@n', 'ASC') \
+    .equal([2, ['tag', 'baz', 'n', '1'], ['tag', 'FOO', 'n', '3']])
+
+  # The documents are only opened for the fields which are not stored
+  env.cmd(config_cmd(), 'SET', '_PRINT_PROFILE_CLOCK', 'false')
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', '*', 'RETURN', 3, 'txt', 'tag', 'n')
+  env.assertNotContains('Loader', str(res[1]))
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', '*', 'RETURN', 2, 'txt', 'other')
+  env.assertContains('Loader', str(res[1]))
+
 def test_MOD_1517(env):
   conn = getConnectionByEnv(env)
 
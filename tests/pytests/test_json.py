@@ -1410,3 +1410,36 @@ def testLimitations(env):
 
     env.expect('FT.SEARCH', 'idx', 'abraham', 'SUMMARIZE').error()\
         .contains(error_msg)
+
+@skip(no_json=True)
+def testSharedPathParents(env):
+    """ fields which share a parent path are read relative to its value """
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'JSON', 'SCHEMA',
+               '$.user.name', 'AS', 'name', 'TEXT',
+               '$.user.age', 'AS', 'age', 'NUMERIC',
+               '$.user.tags[*]', 'AS', 'tags', 'TAG',
+               '$.user.address.city', 'AS', 'city', 'TAG',
+               '$.user.address.zip', 'AS', 'zip', 'NUMERIC').ok()
+
+    conn.execute_command('JSON.SET', 'doc:1', '$', json.dumps(
+        {'user': {'name': 'alice', 'age': 30, 'tags': ['a', 'b'], 'address': {'city': 'paris', 'zip': 75001}}}))
+    # A parent without some of its children, and a parent which is not an object
+    conn.execute_command('JSON.SET', 'doc:2', '$', json.dumps({'user': {'name': 'bob'}}))
+    conn.execute_command('JSON.SET', 'doc:3', '$', json.dumps({'user': ['carol']}))
+    # No parent at all
+    conn.execute_command('JSON.SET', 'doc:4', '$', json.dumps({'name': 'dave'}))
+    waitForIndex(env, 'idx')
+
+    env.expect('FT.SEARCH', 'idx', '@name:alice @age:[30 30] @tags:{b} @city:{paris} @zip:[75001 75001]',
+               'NOCONTENT').equal([1, 'doc:1'])
+    env.expect('FT.SEARCH', 'idx', '@name:bob', 'NOCONTENT').equal([1, 'doc:2'])
+    env.expect('FT.SEARCH', 'idx', 'carol|dave', 'NOCONTENT').equal([0])
+
+    # Loading the fields at query time
+    res = env.cmd('FT.AGGREGATE', 'idx', '@name:alice', 'LOAD', 4, '$.user.name', '$.user.age',
+                  '$.user.address.city', '$.user.address.zip')
+    env.assertEqual(res[1], ['$.user.name', 'alice', '$.user.age', '30',
+                             '$.user.address.city', 'paris', '$.user.address.zip', '75001'])
+    res = env.cmd('FT.AGGREGATE', 'idx', '@name:bob', 'LOAD', 2, '$.user.name', '$.user.age')
+    env.assertEqual(res[1], ['$.user.name', 'bob'])
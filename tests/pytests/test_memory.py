@@ -0,0 +1,96 @@
+from common import *
+from RLTest import Env
+
+
+NUM_DOCS = 200
+
+
+def populate(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'NOSTEM', 'tag', 'TAG', 'n', 'NUMERIC',
+             'g', 'GEO').ok()
+  pl = conn.pipeline(transaction=False)
+  for i in range(NUM_DOCS):
+    pl.execute_command('HSET', f'doc{i}', 't', f'hello w{i % 5}', 'tag', 'abc'[i % 3], 'n', i,
+                       'g', f'{i % 90},{i % 45}')
+  pl.execute()
+
+
+def memory(env, *args):
+  return to_dict(env.cmd('FT.MEMORY', 'idx', *args))
+
+
+def field(res, name):
+  return next(f for f in map(to_dict, res['fields']) if f['attribute'] == name)
+
+
+@skip(cluster=True)
+def test_memory(env: Env):
+  populate(env)
+  res = memory(env)
+  env.assertGreater(res['total_bytes'], 0)
+  env.assertGreater(res['doc_table_bytes'], 0)
+  env.assertGreater(res['key_table_bytes'], 0)
+
+  # The terms of the TEXT fields share their inverted indexes
+  text = to_dict(res['text'])
+  env.assertEqual(text['terms'], 6)
+  env.assertGreater(text['terms_trie_bytes'], 0)
+  inverted = to_dict(text['inverted_indexes'])
+  env.assertEqual(inverted['count'], 6)
+  env.assertEqual(inverted['encoding'], 'freqs-fields-offsets')
+  env.assertEqual(inverted['entries'], 2 * NUM_DOCS)
+  env.assertGreater(float(inverted['block_utilization']), 0)
+  env.assertLessEqual(float(inverted['block_utilization']), 1)
+
+  # The largest terms first
+  top = [to_dict(t) for t in res['top_terms']]
+  env.assertEqual(len(top), 6)
+  env.assertEqual(top[0]['term'], 'hello')
+  env.assertEqual(sorted([t['bytes'] for t in top], reverse=True), [t['bytes'] for t in top])
+  top = [to_dict(t)['term'] for t in memory(env, 'TOP', 2)['top_terms']]
+  env.assertEqual(len(top), 2)
+  env.assertEqual(top[0], 'hello')
+  env.assertEqual(memory(env, 'TOP', 0)['top_terms'], [])
+
+  t = field(res, 't')
+  env.assertEqual(t['type'], 'TEXT')
+  env.assertNotContains('inverted_indexes', t)
+
+  tag = field(res, 'tag')
+  env.assertEqual(tag['values'], 3)
+  env.assertGreater(tag['overhead_bytes'], 0)
+  inverted = to_dict(tag['inverted_indexes'])
+  env.assertEqual(inverted['count'], 3)
+  env.assertEqual(inverted['encoding'], 'doc-ids')
+  env.assertEqual(inverted['entries'], NUM_DOCS)
+
+  for name in ['n', 'g']:
+    numeric = field(res, name)
+    env.assertGreaterEqual(numeric['ranges'], 1, message=name)
+    env.assertGreater(numeric['tree_bytes'], 0, message=name)
+    env.assertGreater(numeric['hll_bytes'], 0, message=name)
+    inverted = to_dict(numeric['inverted_indexes'])
+    env.assertEqual(inverted['encoding'], 'numeric', message=name)
+    env.assertGreaterEqual(inverted['entries'], NUM_DOCS, message=name)
+
+
+@skip(cluster=True)
+def test_memory_empty(env: Env):
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'tag', 'TAG').ok()
+  res = memory(env)
+  env.assertEqual(to_dict(to_dict(res['text'])['inverted_indexes'])['count'], 0)
+  env.assertEqual(res['top_terms'], [])
+  # The indexes of the fields are created with their first document
+  env.assertNotContains('values', field(res, 'tag'))
+
+
+@skip(cluster=True)
+def test_memory_errors(env: Env):
+  env.expect('FT.MEMORY').error().contains('wrong number of arguments')
+  env.expect('FT.MEMORY', 'idx').error().contains('Unknown index name')
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT').ok()
+  env.expect('FT.MEMORY', 'idx', 'TOP').error().contains('TOP must be between 0 and 1000')
+  env.expect('FT.MEMORY', 'idx', 'TOP', 'abc').error().contains('TOP must be between 0 and 1000')
+  env.expect('FT.MEMORY', 'idx', 'TOP', 1001).error().contains('TOP must be between 0 and 1000')
+  env.expect('FT.MEMORY', 'idx', 'FOO').error().contains('Unknown argument for FT.MEMORY')
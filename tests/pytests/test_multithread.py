@@ -780,3 +780,220 @@ def test_ft_aggregate_with_coord_10_io_threads():
 @skip(cluster=False)
 def test_ft_aggregate_with_coord_20_io_threads():
     _test_ft_aggregate_with_io_threads(20)
+
+@skip(cluster=True)
+def test_parallel_query_ranges():
+    env = initEnv(moduleArgs='WORKERS 2 DEFAULT_DIALECT 2')
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 't', 'TAG').ok()
+    conn = getConnectionByEnv(env)
+    # Enough documents for the wildcard query to be split into ranges
+    num_docs = 80_000
+    with conn.pipeline(transaction=False) as p:
+        for i in range(num_docs):
+            p.execute_command('HSET', f'doc{i}', 'n', i, 't', f'tag{i % 10}')
+        p.execute()
+
+    queries = [
+        ['*', 'GROUPBY', 1, '@t', 'REDUCE', 'COUNT', 0, 'AS', 'count', 'REDUCE', 'SUM', 1, '@n', 'AS', 'sum',
+         'SORTBY', 2, '@t', 'ASC'],
+        ['@n:[1000 70000]', 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'count'],
+        # Without a sorter, the results come in the order of their ids
+        ['*', 'LOAD', 1, '@n', 'LIMIT', 0, 100],
+        ['-@t:{tag3}', 'SORTBY', 2, '@n', 'DESC', 'LIMIT', 0, 20],
+    ]
+    serial = [env.cmd('FT.AGGREGATE', 'idx', *q) for q in queries]
+    env.expect(config_cmd(), 'SET', '_PARALLEL_QUERY_RANGES', 4).ok()
+    for q, expected in zip(queries, serial):
+        env.assertEqual(env.cmd('FT.AGGREGATE', 'idx', *q), expected, message=q)
+
+@skip(cluster=True)
+def test_parallel_groupby():
+    env = initEnv(moduleArgs='WORKERS 2 DEFAULT_DIALECT 2')
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 't', 'TAG', 'SORTABLE').ok()
+    conn = getConnectionByEnv(env)
+    # Enough documents for the results to be accumulated in several rounds
+    num_docs = 50_000
+    with conn.pipeline(transaction=False) as p:
+        for i in range(num_docs):
+            p.execute_command('HSET', f'doc{i}', 'n', i % 1000, 't', f'tag{i % 7}')
+        p.execute()
+
+    reducers = ['REDUCE', 'COUNT', 0, 'AS', 'count', 'REDUCE', 'SUM', 1, '@n', 'AS', 'sum',
+                'REDUCE', 'MIN', 1, '@n', 'AS', 'min', 'REDUCE', 'MAX', 1, '@n', 'AS', 'max',
+                'REDUCE', 'AVG', 1, '@n', 'AS', 'avg', 'REDUCE', 'COUNT_DISTINCT', 1, '@n', 'AS', 'distinct',
+                'REDUCE', 'COUNT_DISTINCTISH', 1, '@n', 'AS', 'distinctish']
+    queries = [
+        ['*', 'GROUPBY', 1, '@t', *reducers, 'SORTBY', 2, '@t', 'ASC'],
+        ['*', 'GROUPBY', 1, '@n', *reducers, 'SORTBY', 2, '@n', 'ASC', 'MAX', 1000],
+        ['*', 'GROUPBY', 0, *reducers],
+        ['@n:[100 200]', 'GROUPBY', 2, '@t', '@n', 'REDUCE', 'COUNT', 0, 'AS', 'count',
+         'SORTBY', 4, '@t', 'ASC', '@n', 'ASC', 'MAX', 1000],
+        # FIRST_VALUE cannot be merged, so this one is accumulated on a single thread
+        ['*', 'GROUPBY', 1, '@t', 'REDUCE', 'FIRST_VALUE', 4, '@n', 'BY', '@n', 'DESC', 'AS', 'first',
+         'REDUCE', 'COUNT', 0, 'AS', 'count', 'SORTBY', 2, '@t', 'ASC'],
+    ]
+    serial = [env.cmd('FT.AGGREGATE', 'idx', *q) for q in queries]
+    env.expect(config_cmd(), 'SET', '_GROUPBY_PARTITIONS', 3).ok()
+    for q, expected in zip(queries, serial):
+        env.assertEqual(env.cmd('FT.AGGREGATE', 'idx', *q), expected, message=q)
+
+@skip(cluster=True)
+def test_query_yields_to_writers():
+    env = initEnv(moduleArgs='WORKERS 1 DEFAULT_DIALECT 2')
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 't', 'TAG').ok()
+    conn = getConnectionByEnv(env)
+    num_docs = 50_000
+    with conn.pipeline(transaction=False) as p:
+        for i in range(num_docs):
+            p.execute_command('HSET', f'doc{i}', 'n', i, 't', 'a')
+        p.execute()
+
+    # Index documents the queries don't match while they run, so that the queries yield the spec to
+    # the writes and revalidate their iterators
+    stop = threading.Event()
+    def write():
+        writer = env.getConnection()
+        i = 0
+        while not stop.is_set():
+            writer.execute_command('HSET', f'other{i}', 'n', i, 't', 'b')
+            i += 1
+    writer_thread = threading.Thread(target=write)
+    writer_thread.start()
+    try:
+        for _ in range(10):
+            res = env.cmd('FT.AGGREGATE', 'idx', '@t:{a}', 'GROUPBY', 0,
+                          'REDUCE', 'COUNT', 0, 'AS', 'count', 'REDUCE', 'SUM', 1, '@n', 'AS', 'sum')
+            env.assertEqual(res, [1, ['count', str(num_docs), 'sum', str(num_docs * (num_docs - 1) // 2)]])
+    finally:
+        stop.set()
+        writer_thread.join()
+
+@skip(cluster=True)
+def test_heavy_query_admission():
+    env = initEnv(moduleArgs='WORKERS 4 DEFAULT_DIALECT 2 _HEAVY_QUERY_COST 1000 _MAX_RUNNING_HEAVY_QUERIES 1')
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC', 'SORTABLE', 't', 'TAG').ok()
+    conn = getConnectionByEnv(env)
+    num_docs = 10_000
+    with conn.pipeline(transaction=False) as p:
+        for i in range(num_docs):
+            p.execute_command('HSET', f'doc{i}', 'n', i, 't', 'a' if i < 10 else 'b')
+        p.execute()
+
+    # The heavy queries run one at a time, the others waiting for them without failing
+    num_queries = 8
+    errors = []
+    def heavy_query():
+        try:
+            res = env.getConnection().execute_command('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 0,
+                                                      'REDUCE', 'COUNT', 0, 'AS', 'count')
+            if res != [1, ['count', str(num_docs)]]:
+                errors.append(res)
+        except Exception as e:
+            errors.append(e)
+    threads = [threading.Thread(target=heavy_query) for _ in range(num_queries)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    env.assertEqual(errors, [])
+
+    # Cheap queries are admitted right away
+    env.expect('FT.AGGREGATE', 'idx', '@t:{a}', 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'count') \
+        .equal([1, ['count', '10']])
+
+    info = env.cmd('INFO', 'MODULES')
+    env.assertEqual(info['search_heavy_queries_admitted'] + info['search_heavy_queries_queued'], num_queries)
+    env.assertEqual(info['search_heavy_queries_rejected'], 0)
+    env.assertEqual(info['search_heavy_queries_running'], 0)
+    env.assertEqual(info['search_heavy_queries_waiting'], 0)
+    env.assertGreaterEqual(info['search_cheap_queries_admitted'], 1)
+    env.assertEqual(info['search_cheap_queries_running'], 0)
+
+    # With no room to wait, the heavy queries beyond the running one are rejected
+    env.expect(config_cmd(), 'SET', '_MAX_WAITING_HEAVY_QUERIES', 0).ok()
+    threads = [threading.Thread(target=heavy_query) for _ in range(num_queries)]
+    errors.clear()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for e in errors:
+        env.assertContains('Too many heavy queries are waiting to run', str(e))
+    info = env.cmd('INFO', 'MODULES')
+    env.assertEqual(info['search_heavy_queries_rejected'], len(errors))
+
+@skip(cluster=True)
+def test_query_cancelled_on_disconnect():
+    env = initEnv(moduleArgs='WORKERS 1 DEFAULT_DIALECT 2')
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC').ok()
+    conn = getConnectionByEnv(env)
+    num_docs = 1000
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', i)
+
+    # Queue a query, and disconnect its client before it runs
+    env.expect(debug_cmd(), 'WORKERS', 'PAUSE').ok()
+    client = env.getConnection()
+    connection = client.connection_pool.get_connection('FT.AGGREGATE')
+    connection.send_command('FT.AGGREGATE', 'idx', '*', 'LOAD', 1, '@n')
+    with TimeLimit(10, 'Timeout while waiting for the query to be queued'):
+        while getWorkersThpoolStats(env)['totalPendingJobs'] != 1:
+            time.sleep(0.01)
+    num_clients = env.cmd('INFO', 'clients')['connected_clients']
+    connection.disconnect()
+    with TimeLimit(10, 'Timeout while waiting for the client to disconnect'):
+        while env.cmd('INFO', 'clients')['connected_clients'] == num_clients:
+            time.sleep(0.01)
+
+    # The cancelled query gives up its worker without replying
+    env.expect(debug_cmd(), 'WORKERS', 'RESUME').ok()
+    env.expect(debug_cmd(), 'WORKERS', 'drain').ok()
+    env.assertEqual(getWorkersThpoolStats(env)['totalPendingJobs'], 0)
+    env.expect('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'count') \
+        .equal([1, ['count', str(num_docs)]])
+
+@skip(cluster=True)
+def test_workers_pinned_to_cpus():
+    env = initEnv(moduleArgs='WORKERS 2 DEFAULT_DIALECT 2 _WORKERS_CPUS 0 _FORK_GC_CPUS 0')
+    env.expect(config_cmd(), 'GET', '_WORKERS_CPUS').equal([['_WORKERS_CPUS', '0']])
+    env.expect(config_cmd(), 'GET', '_IO_THREADS_CPUS').equal([['_IO_THREADS_CPUS', None]])
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'n', 'NUMERIC').ok()
+    conn = getConnectionByEnv(env)
+    num_docs = 100
+    for i in range(num_docs):
+        conn.execute_command('HSET', f'doc{i}', 'n', i)
+    env.expect('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 0, 'REDUCE', 'COUNT', 0, 'AS', 'count') \
+        .equal([1, ['count', str(num_docs)]])
+    forceInvokeGC(env, 'idx')
+
+    info = env.cmd('INFO', 'MODULES')
+    env.assertEqual(info['search_workers_cpus'], 0)
+    env.assertTrue('search_worker_0_cpu_time_ms' in info)
+    env.assertTrue('search_worker_1_cpu_time_ms' in info)
+    env.assertFalse('search_worker_2_cpu_time_ms' in info)
+    env.assertGreaterEqual(info['search_workers_cpu_time_ms'],
+                           info['search_worker_0_cpu_time_ms'])
+
+@skip(cluster=True)
+def test_parallel_scan_preprocessing():
+    env = initEnv(moduleArgs='WORKERS 3 DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    # Enough documents for the scan steps to be shared with the workers
+    num_docs = 5_000
+    with conn.pipeline(transaction=False) as p:
+        for i in range(num_docs):
+            p.execute_command('HSET', f'doc{i}', 'f', f'hello world w{i % 7}', 't', f'tag{i % 5}', 'n', i)
+        p.execute()
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'f', 'TEXT', 't', 'TAG', 'n', 'NUMERIC').ok()
+    waitForIndex(env, 'idx')
+    env.expect('FT.SEARCH', 'idx', 'hello', 'LIMIT', 0, 0).equal([num_docs])
+    env.expect('FT.SEARCH', 'idx', 'w3', 'LIMIT', 0, 0).equal([714])
+    env.expect('FT.SEARCH', 'idx', 'world @t:{tag2} @n:[0 999]', 'LIMIT', 0, 0).equal([200])
+
+    # A paused pool leaves the shares of the workers to the scanner
+    env.expect(debug_cmd(), 'WORKERS', 'PAUSE').ok()
+    env.expect('FT.CREATE', 'idx2', 'SCHEMA', 'f', 'TEXT').ok()
+    waitForIndex(env, 'idx2')
+    # The queries run on the workers as well
+    env.expect(debug_cmd(), 'WORKERS', 'RESUME').ok()
+    env.expect('FT.SEARCH', 'idx2', 'w3', 'LIMIT', 0, 0).equal([714])
@@ -310,8 +310,8 @@ def testOptimizer(env):
     env.expect('ft.search', 'idx_sortable', '*', 'SORTBY', 'n', 'DESC', 'limit', 0 , 2, *params).equal([2, '99', '98'])
 
     profiler =  {'Iterators profile':
-                    ['Type', 'OPTIMIZER', 'Counter', 10, 'Optimizer mode', 'Query partial range', 'Child iterator',
-                        ['Type', 'WILDCARD', 'Counter', 2600]],
+                    ['Type', 'OPTIMIZER', 'Counter', 10, 'Optimizer mode', 'Index order', 'Child iterator',
+                        ['Type', 'WILDCARD', 'Counter', 0]],
                  'Result processors profile': [
                     ['Type', 'Index', 'Counter', 10],
                     ['Type', 'Loader', 'Counter', 10],
@@ -485,6 +485,7 @@ def testSearch(env):
             ### (11) wildcard with sort ###
             # Search only minimal number of ranges
             compare_optimized_to_not(env, ['ft.search', 'idx', '*', 'SORTBY', 'n'], params, 'case 11')
+            compare_optimized_to_not(env, ['ft.search', 'idx', '*', 'SORTBY', 'n', 'DESC'], params, 'case 11 desc')
 
             ### (12) wildcard w/o sort ###
             # stop after enough results were collected
@@ -702,3 +703,49 @@ def testOptimizeArgsDefault():
     # DEFAULT DIALECT 4 and WITHCOUNT explicitly specified ==> WITHCOUNT
     env.assertEqual(conn.execute_command(*query, 'WITHCOUNT'), conn.execute_command(*query, 'WITHCOUNT'))
     env.assertNotEqual(conn.execute_command(*query, 'WITHCOUNT'), conn.execute_command(*query, 'WITHOUTCOUNT'))
+
+@skip(cluster=True)
+def testImpactPostings(env):
+    ''' Test that ranked queries read the top documents of the common terms, and get the same top results '''
+
+    conn = getConnectionByEnv(env)
+    env.expect(config_cmd(), 'SET', '_IMPACT_POSTINGS_MIN_DOCS', '50').ok()
+    env.expect(config_cmd(), 'SET', '_IMPACT_POSTINGS_SIZE', '10').ok()
+    env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC')
+
+    def add(i):
+        text = ' '.join(['common'] * (i % 7 + 1) + ['filler'] * (i % 11) + (['rare'] if i % 10 == 0 else []))
+        conn.execute_command('HSET', f'doc{i}', 't', text, 'n', i)
+    for i in range(200):
+        add(i)
+
+    def scores(query, *args):
+        res = env.cmd('FT.SEARCH', 'idx', query, 'WITHSCORES', 'NOCONTENT', 'LIMIT', '0', '10', *args)
+        return sorted(float(s) for s in res[2::2])
+
+    def compare(query):
+        optimized = scores(query, 'WITHOUTCOUNT')
+        env.assertEqual(optimized, scores(query, 'WITHCOUNT'), message=query)
+        env.assertEqual(len(optimized), 10, message=query)
+
+    compare('common')
+    compare('common | rare')
+
+    # Intersections and filters read the full postings of the term
+    env.assertEqual(env.cmd('FT.SEARCH', 'idx', 'common rare', 'NOCONTENT', 'LIMIT', '0', '0')[0], 20)
+    res = env.cmd('FT.SEARCH', 'idx', 'common @n:[150 199]', 'NOCONTENT', 'LIMIT', '0', '100', 'WITHOUTCOUNT')
+    env.assertEqual(len(res) - 1, 50)
+
+    # Documents written since the top documents were selected are read as well
+    conn.execute_command('HSET', 'best', 't', 'common common common common common common common common')
+    res = env.cmd('FT.SEARCH', 'idx', 'common', 'NOCONTENT', 'LIMIT', '0', '1', 'WITHOUTCOUNT')
+    env.assertEqual(res[1:], ['best'])
+    compare('common')
+
+    # Enough new documents select the top documents again
+    for i in range(200, 230):
+        add(i)
+    compare('common')
+
+    env.expect(config_cmd(), 'SET', '_IMPACT_POSTINGS_MIN_DOCS', '0').ok()
+    compare('common')
@@ -174,6 +174,17 @@ def testProfileAggregate(env):
   actual_res = env.cmd('ft.profile', 'idx', 'aggregate', 'query', '*', 'sortby', 2, '@t', 'asc', 'limit', 0, 10, 'LOAD', 2, '@__key', '@t')
   env.assertEqual(actual_res[1][1][0][5], expected_res)
 
+  # Fields that are not sorted by are only loaded for the rows that make the page
+  expected_res = [['Type', 'Index', 'Counter', 2],
+                  ['Type', 'Loader', 'Counter', 2],
+                  ['Type', 'Sorter', 'Counter', 1],
+                  ['Type', 'Loader', 'Counter', 1]]
+  conn.execute_command('hset', '1', 'x', 'foo')
+  conn.execute_command('hset', '2', 'x', 'bar')
+  actual_res = env.cmd('ft.profile', 'idx', 'aggregate', 'query', '*', 'LOAD', 2, '@x', '@t', 'sortby', 2, '@t', 'asc', 'limit', 0, 1)
+  env.assertEqual(actual_res[1][1][0][5], expected_res)
+  env.assertEqual(to_dict(actual_res[0][1]), {'t': 'hello', 'x': 'foo'})
+
 def testProfileCursor(env):
   conn = getConnectionByEnv(env)
   env.cmd('ft.create', 'idx', 'SCHEMA', 't', 'text')
@@ -472,7 +483,8 @@ def TimeoutWarningInProfile(env):
           ['Type', 'Scorer', 'Time', ANY, 'Counter', ANY],
           ['Type', 'Sorter', 'Time', ANY, 'Counter', ANY],
           ['Type', 'Loader', 'Time', ANY, 'Counter', ANY],
-         ]
+         ],
+       'Arena bytes', ANY,
       ]],
      'Coordinator', []
     ]
@@ -490,7 +502,8 @@ def TimeoutWarningInProfile(env):
         ['Type', 'WILDCARD', 'Time', ANY, 'Counter', ANY],
        'Result processors profile',
         [['Type', 'Index', 'Time', ANY, 'Counter', ANY],
-         ['Type', 'Pager/Limiter', 'Time', ANY, 'Counter', ANY]]
+         ['Type', 'Pager/Limiter', 'Time', ANY, 'Counter', ANY]],
+       'Arena bytes', ANY,
       ]],
      'Coordinator', []]
   ]
@@ -659,7 +672,7 @@ def testPofileGILTime():
   res = env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'query', 'hello' ,'SORTBY', '1', '@f')
 
   # Record structure:
-  # ['Type', 'Threadsafe-Loader', 'GIL-Time', ANY , 'Time', ANY, 'Counter', 100]
+  # ['Type', 'Threadsafe-Loader', 'GIL-Time', ANY, 'Batches number', ANY, 'Time', ANY, 'Counter', 100]
   # ['Total GIL time', ANY]
 
   env.assertTrue(recursive_contains(res, 'Threadsafe-Loader'), message=f"res: {res}")
@@ -679,6 +692,9 @@ def testPofileGILTime():
   env.assertGreaterEqual(float(rp_GIL_time), 0)
   env.assertGreaterEqual(float(total_GIL_time), float(rp_GIL_time))
 
+  # The whole buffer is loaded under a single lock of Redis
+  env.assertEqual(rp_record[rp_record.index('Batches number') + 1], 1)
+
 def testProfileBM25NormMax(env):
   #create index
   env.cmd('ft.create', 'idx', 'SCHEMA', 't', 'TEXT')
@@ -693,3 +709,56 @@ def testProfileBM25NormMax(env):
   env.assertTrue(recursive_contains(aggregate_response, "Score Max Normalizer"))
   search_response = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'query', 'hello', 'WITHSCORES', 'SCORER', 'BM25STD.NORM')
   env.assertTrue(recursive_contains(search_response, "Score Max Normalizer"))
+
+@skip(cluster=True)
+def testProfileArenaBytes(env):
+  env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC')
+  conn = getConnectionByEnv(env)
+  conn.execute_command('HSET', 'doc1', 't', 'hello world', 'n', 1)
+
+  def arena_bytes(query):
+    res = to_dict(env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', query)[1][1][0])
+    return res['Arena bytes']
+
+  # The nodes of the query tree are taken from the arena of the request
+  single = arena_bytes('hello')
+  env.assertGreater(single, 0)
+  env.assertGreater(arena_bytes('hello world @n:[0 10] -foo'), single)
+
+  # Not printed without the clock
+  env.cmd(config_cmd(), 'SET', '_PRINT_PROFILE_CLOCK', 'false')
+  res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello')
+  env.assertFalse(recursive_contains(res, 'Arena bytes'))
+
+@skip(cluster=True)
+def testProfileHWCounters():
+  env = Env(protocol=3)
+  conn = getConnectionByEnv(env)
+  env.cmd('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT')
+  for i in range(100):
+    conn.execute_command('HSET', f'doc{i}', 't', 'hello world')
+
+  def profile():
+    return env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', 'hello world')['Profile']['Shards'][0]
+
+  # Not read by default
+  env.assertNotContains('Hardware counters', str(profile()))
+
+  env.expect(config_cmd(), 'SET', '_PROFILE_HW_COUNTERS', 'true').ok()
+  shard = profile()
+  root = shard['Iterators profile']
+  if 'Hardware counters' not in root:
+    # The counters can not be read on this system, and the query is profiled as usual
+    env.assertEqual(root['Type'], 'INTERSECT')
+    env.assertNotContains('Hardware counters', str(shard))
+    return
+
+  expected = {'Cycles', 'Instructions', 'LLC misses', 'Branch misses', 'Instructions per cycle'}
+  env.assertEqual(set(root['Hardware counters'].keys()), expected)
+  env.assertGreater(root['Hardware counters']['Instructions'], 0)
+  # The counts of an iterator include those of its children
+  for child in root['Child iterators']:
+    env.assertEqual(set(child['Hardware counters'].keys()), expected)
+    env.assertLessEqual(child['Hardware counters']['Instructions'], root['Hardware counters']['Instructions'])
+  for rp in shard['Result processors profile']:
+    env.assertEqual(set(rp['Hardware counters'].keys()), expected, message=rp['Type'])
@@ -5,7 +5,7 @@ import threading
 import time
 import signal
 import tempfile
-from common import skip, downloadFile, REDISEARCH_CACHE_DIR, debug_cmd
+from common import skip, downloadFile, REDISEARCH_CACHE_DIR, debug_cmd, config_cmd, waitForIndex, forceInvokeGC, index_info
 from RLTest import Env
 
 @skip(cluster=True)
@@ -99,3 +99,148 @@ def test_rdb_load_no_deadlock():
     assert indices_info, "No indices found after RDB load"
     # If there are indices, verify we can get info about the first one
     test_env.expect('FT.INFO', indices_info[0]).noError()
+
+
+def _persisted_queries(env):
+    return [
+        env.cmd('FT.SEARCH', 'idx', 'hello', 'SORTBY', 'n', 'LIMIT', 0, 5),
+        env.cmd('FT.SEARCH', 'idx', '*orl*', 'SORTBY', 'n', 'NOCONTENT'),
+        env.cmd('FT.SEARCH', 'idx', '@t:{blue}', 'SORTBY', 'n', 'NOCONTENT'),
+        env.cmd('FT.SEARCH', 'idx', '@n:[10 20]', 'SORTBY', 'n', 'NOCONTENT'),
+        env.cmd('FT.SEARCH', 'idx', '@g:[1 1 500 km]', 'SORTBY', 'n', 'NOCONTENT', 'LIMIT', 0, 3),
+        env.cmd('FT.SEARCH', 'idx', 'ismissing(@t)', 'SORTBY', 'n', 'NOCONTENT'),
+        env.cmd('FT.AGGREGATE', 'idx', '*', 'GROUPBY', 1, '@t', 'REDUCE', 'COUNT', 0, 'AS', 'c', 'SORTBY', 2, '@t', 'ASC'),
+        env.cmd('FT.INFO', 'idx')['num_docs'],
+    ]
+
+@skip(cluster=True)
+def test_persist_indexes():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    env.expect(config_cmd(), 'SET', '_PERSIST_INDEXES', 'true').ok()
+    env.expect(config_cmd(), 'SET', 'INDEXER_YIELD_EVERY_OPS', '1').ok()
+    env.cmd('FT.CREATE', 'idx', 'INDEXALL', 'ENABLE', 'SCHEMA', 'txt', 'TEXT', 'WITHSUFFIXTRIE',
+            't', 'TAG', 'INDEXMISSING', 'n', 'NUMERIC', 'SORTABLE', 'g', 'GEO')
+    for i in range(100):
+        fields = ['txt', f'hello world {i}', 'n', i, 'g', f'{i % 10},{i % 10}']
+        if i % 7:
+            fields += ['t', 'blue' if i % 2 else 'red']
+        env.cmd('HSET', f'doc{i}', *fields)
+    env.cmd('DEL', 'doc3')
+    waitForIndex(env, 'idx')
+    expected = _persisted_queries(env)
+    # Saved, but expired by the time it is loaded
+    env.cmd('HSET', 'temp', 'txt', 'hello expiring', 'n', 1000)
+    env.cmd('PEXPIRE', 'temp', 500)
+
+    # The contents are loaded along with the index, without indexing its documents again
+    env.expect(debug_cmd(), 'YIELDS_ON_LOAD_COUNTER', 'RESET').ok()
+    env.cmd('SAVE')
+    time.sleep(1)
+    env.cmd('DEBUG', 'RELOAD', 'NOSAVE')
+    waitForIndex(env, 'idx')
+    env.assertEqual(env.cmd(debug_cmd(), 'YIELDS_ON_LOAD_COUNTER'), 0)
+    # The document of the key that expired before it was loaded is deleted
+    env.expect('FT.SEARCH', 'idx', 'expiring').equal([0])
+    env.assertEqual(_persisted_queries(env), expected)
+
+    # And remain writable
+    env.cmd('HSET', 'doc200', 'txt', 'hello again', 't', 'blue', 'n', 15)
+    env.expect('FT.SEARCH', 'idx', 'again', 'NOCONTENT').equal([1, 'doc200'])
+    env.cmd('DEL', 'doc200')
+
+    # Without the contents, the documents are indexed as their keys are loaded
+    env.expect(config_cmd(), 'SET', '_PERSIST_INDEXES', 'false').ok()
+    env.cmd('SAVE')
+    env.cmd('DEBUG', 'RELOAD', 'NOSAVE')
+    waitForIndex(env, 'idx')
+    env.assertGreater(env.cmd(debug_cmd(), 'YIELDS_ON_LOAD_COUNTER'), 0)
+    env.assertEqual(_persisted_queries(env), expected)
+
+@skip(cluster=True)
+def test_index_segments():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    env.expect(config_cmd(), 'SET', '_PERSIST_INDEXES', 'true').ok()
+    env.expect(config_cmd(), 'SET', '_INDEX_SEGMENTS', 'true').ok()
+    env.expect(config_cmd(), 'SET', 'INDEXER_YIELD_EVERY_OPS', '1').ok()
+    env.cmd('FT.CREATE', 'idx', 'INDEXALL', 'ENABLE', 'SCHEMA', 'txt', 'TEXT', 'WITHSUFFIXTRIE',
+            't', 'TAG', 'INDEXMISSING', 'n', 'NUMERIC', 'SORTABLE', 'g', 'GEO')
+    # Enough documents for the indexes to have sealed blocks
+    for i in range(3000):
+        fields = ['txt', f'hello world {i}', 'n', i % 100, 'g', f'{i % 10},{i % 10}']
+        if i % 7:
+            fields += ['t', 'blue' if i % 2 else 'red']
+        env.cmd('HSET', f'doc{i}', *fields)
+    env.cmd('DEL', 'doc3')
+    waitForIndex(env, 'idx')
+    expected = _persisted_queries(env)
+
+    dir = env.cmd('CONFIG', 'GET', 'dir')[1]
+    segments = lambda: sorted(f for f in os.listdir(dir) if f.startswith('redisearch-') and f.endswith('.seg'))
+
+    # The blocks are loaded from the segment of the RDB
+    env.expect(debug_cmd(), 'YIELDS_ON_LOAD_COUNTER', 'RESET').ok()
+    env.cmd('SAVE')
+    saved = segments()
+    env.assertEqual(len(saved), 1)
+    env.cmd('DEBUG', 'RELOAD', 'NOSAVE')
+    waitForIndex(env, 'idx')
+    env.assertEqual(env.cmd(debug_cmd(), 'YIELDS_ON_LOAD_COUNTER'), 0)
+    env.assertEqual(_persisted_queries(env), expected)
+
+    # The GC repairs the loaded blocks, and the new documents are written after them
+    for i in range(0, 3000, 5):
+        env.cmd('DEL', f'doc{i}')
+    env.cmd('HSET', 'doc5', 'txt', 'hello again', 't', 'blue', 'n', 15, 'g', '1,1')
+    forceInvokeGC(env, 'idx')
+    expected = _persisted_queries(env)
+    env.expect('FT.SEARCH', 'idx', 'again', 'NOCONTENT').equal([1, 'doc5'])
+
+    # The next snapshot replaces the segment of the previous one
+    env.cmd('SAVE')
+    env.assertEqual(len(segments()), 1)
+    env.assertNotEqual(segments(), saved)
+    env.cmd('DEBUG', 'RELOAD', 'NOSAVE')
+    waitForIndex(env, 'idx')
+    env.assertEqual(env.cmd(debug_cmd(), 'YIELDS_ON_LOAD_COUNTER'), 0)
+    env.assertEqual(_persisted_queries(env), expected)
+
+    # Without its segment, the documents are indexed again as their keys are loaded
+    env.cmd('SAVE')
+    for f in segments():
+        os.unlink(os.path.join(dir, f))
+    env.cmd('DEBUG', 'RELOAD', 'NOSAVE')
+    waitForIndex(env, 'idx')
+    env.assertGreater(env.cmd(debug_cmd(), 'YIELDS_ON_LOAD_COUNTER'), 0)
+    env.assertEqual(_persisted_queries(env), expected)
+
+@skip(cluster=True)
+def test_lazy_index_loading():
+    env = Env(moduleArgs='_HOT_INDEXES hot')
+    env.expect(config_cmd(), 'SET', '_LAZY_INDEX_LOADING', 'true').ok()
+    for idx in ['hot', 'cold']:
+        env.cmd('FT.CREATE', idx, 'PREFIX', 1, f'{idx}:', 'SCHEMA', 'txt', 'TEXT')
+        for i in range(100):
+            env.cmd('HSET', f'{idx}:{i}', 'txt', f'hello {i}')
+    env.cmd('DEBUG', 'RELOAD')
+
+    # The hot index is built as loading ends, and the other one once it is used
+    waitForIndex(env, 'hot')
+    env.assertEqual(index_info(env, 'hot')['cold'], 0)
+    env.expect('FT.SEARCH', 'hot', 'hello', 'LIMIT', 0, 0).equal([100])
+    info = index_info(env, 'cold')
+    env.assertEqual(info['cold'], 1)
+    env.assertEqual(info['indexing'], 0)
+    env.assertEqual(int(info['num_docs']), 0)
+
+    # The documents written to a cold index are indexed as usual
+    env.cmd('HSET', 'cold:100', 'txt', 'hello again')
+    env.expect('FT.SEARCH', 'cold', 'again', 'NOCONTENT').equal([1, 'cold:100'])
+    waitForIndex(env, 'cold')
+    env.assertEqual(index_info(env, 'cold')['cold'], 0)
+    env.expect('FT.SEARCH', 'cold', 'hello', 'LIMIT', 0, 0).equal([101])
+
+    # Without lazy loading, every index is built as its keys are loaded
+    env.expect(config_cmd(), 'SET', '_LAZY_INDEX_LOADING', 'false').ok()
+    env.cmd('DEBUG', 'RELOAD')
+    env.assertEqual(index_info(env, 'cold')['cold'], 0)
+    env.expect('FT.SEARCH', 'cold', 'hello', 'LIMIT', 0, 0).equal([101])
@@ -382,3 +382,67 @@ def test_WriteCommandsOnReplica():
       env.assertTrue(False, message=f'Command {command} should have failed on the slave')
     except Exception as e:
       env.assertContains("You can't write against a read only replica.", str(e))
+
+def testIndexDeltaReplication():
+  env = initEnv()
+  master = env.getConnection()
+  slave = env.getSlaveConnection()
+  for conn in (master, slave):
+    conn.execute_command('CONFIG', 'SET', 'search-_index-delta-replication', 'yes')
+
+  master.execute_command('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT', 'SORTABLE',
+                         'body', 'TEXT', 'WITHSUFFIXTRIE', 'n', 'NUMERIC', 'tg', 'TAG')
+  for i in range(20):
+    master.execute_command('HSET', f'doc{i}', 't', f'hello world {i}',
+                           'body', f'the running foxes jump over dog{i % 3}', 'n', i, 'tg', f'tag{i % 2}')
+  # Written in a transaction, once for all its writes of each key
+  pipe = master.pipeline(transaction=True)
+  pipe.hset('doc0', 't', 'goodbye world')
+  pipe.hset('doc0', 'body', 'the sleeping dog')
+  pipe.hset('doc20', mapping={'t': 'hello again', 'body': 'running late', 'n': 20, 'tg': 'tag0'})
+  pipe.execute()
+  env.assertEqual(master.execute_command('WAIT', '1', '10000'), 1)
+
+  # The replica got the terms of each indexed document along with its write
+  def deltaCalls():
+    return slave.execute_command('INFO', 'COMMANDSTATS').get('cmdstat__ft._indexdelta', {}).get('calls', 0)
+  env.assertEqual(deltaCalls(), 22)
+
+  # The replica indexed the terms of the deltas as the primary did
+  queries = [
+    ['hello', 'WITHSCORES', 'NOCONTENT', 'SORTBY', 'n'],
+    ['@t:goodbye', 'NOCONTENT'],
+    ['@body:run*', 'NOCONTENT', 'SORTBY', 't'],
+    ['@body:*oxes', 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', '0', '5'],
+    ['"foxes over"', 'SLOP', '1', 'INORDER', 'NOCONTENT', 'SORTBY', 'n'],
+    ['@tg:{tag0} @n:[5 15] dog1', 'NOCONTENT', 'SORTBY', 'n'],
+    ['foxes', 'HIGHLIGHT', 'FIELDS', '1', 'body', 'RETURN', '1', 'body', 'SORTBY', 'n'],
+  ]
+  for query in queries:
+    expected = master.execute_command('FT.SEARCH', 'idx', *query)
+    env.assertGreater(expected[0], 0, message=query)
+    env.assertEqual(slave.execute_command('FT.SEARCH', 'idx', *query), expected, message=query)
+  master_info, slave_info = index_info(env, 'idx'), to_dict(slave.execute_command('FT.INFO', 'idx'))
+  for stat in ['num_docs', 'num_terms', 'num_records']:
+    env.assertEqual(slave_info[stat], master_info[stat], message=stat)
+
+  # Without the setting, the replica tokenizes the documents itself
+  master.execute_command('CONFIG', 'SET', 'search-_index-delta-replication', 'no')
+  master.execute_command('HSET', 'doc21', 't', 'hello there', 'body', 'running', 'n', 21)
+  env.assertEqual(master.execute_command('WAIT', '1', '10000'), 1)
+  env.assertEqual(deltaCalls(), 22)
+  env.assertEqual(slave.execute_command('FT.SEARCH', 'idx', '@t:there', 'NOCONTENT'), [1, 'doc21'])
+
+def testIndexDeltaFromClient():
+  env = initEnv()
+  master = env.getConnection()
+  env.expect('CONFIG', 'SET', 'search-_index-delta-replication', 'yes').ok()
+  env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT').ok()
+
+  # Only the primary sends the deltas, so a client can't forge the terms of a document
+  env.expect('_FT._INDEXDELTA', 'idx', 'doc1', 'forged').error().contains('sent by the primary only')
+  pipe = master.pipeline(transaction=True)
+  pipe.execute_command('_FT._INDEXDELTA', 'idx', 'doc1', 'forged')
+  pipe.hset('doc1', 't', 'hello world')
+  env.assertEqual(pipe.execute(raise_on_error=False)[1], 1)
+  env.expect('FT.SEARCH', 'idx', 'hello', 'NOCONTENT').equal([1, 'doc1'])
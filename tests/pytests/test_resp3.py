@@ -168,6 +168,7 @@ def test_profile(env):
           'Total profile time': ANY,
           'Parsing time': ANY,
           'Pipeline creation time': ANY,
+          'Arena bytes': ANY,
           'Total GIL time': ANY,
           'Warning': 'None',
           'Iterators profile':
@@ -210,7 +211,7 @@ def test_coord_profile():
       },
       'Profile': {
         'Shards': env.shardsCount * [
-                      {'Total profile time': ANY, 'Parsing time': ANY, 'Pipeline creation time': ANY, 'Total GIL time': ANY, 'Warning': 'None',
+                      {'Total profile time': ANY, 'Parsing time': ANY, 'Pipeline creation time': ANY, 'Arena bytes': ANY, 'Total GIL time': ANY, 'Warning': 'None',
                         'Iterators profile': {'Type': 'WILDCARD', 'Time': ANY, 'Counter': ANY},
                         'Result processors profile': [{'Type': 'Index', 'Time': ANY, 'Counter': ANY},
                                                       {'Type': 'Scorer', 'Time': ANY, 'Counter': ANY},
@@ -250,6 +251,7 @@ def test_coord_profile():
       'Total profile time': ANY,
       'Parsing time': ANY,
       'Pipeline creation time': ANY,
+      'Arena bytes': ANY,
       'Total GIL time': ANY,
       'Warning': 'None',
       'Iterators profile': {'Type': 'WILDCARD', 'Time': ANY, 'Counter': ANY},
@@ -434,6 +436,7 @@ def test_info():
           'indexes_all': 'false'
         },
       'indexing': 0,
+      'cold': 0,
       'inverted_sz_mb': ANY,
       'key_table_size_mb': ANY,
       'tag_overhead_sz_mb': ANY,
@@ -637,6 +640,7 @@ def test_profile_crash_mod5323():
             },
           'Parsing time': ANY,
           'Pipeline creation time': ANY,
+          'Arena bytes': ANY,
           'Total GIL time': ANY,
           'Warning': 'None',
           'Result processors profile': [
@@ -686,6 +690,7 @@ def test_profile_child_itrerators_array():
             },
           'Parsing time': ANY,
           'Pipeline creation time': ANY,
+          'Arena bytes': ANY,
           'Total GIL time': ANY,
           'Warning': 'None',
           'Result processors profile': [
@@ -724,6 +729,7 @@ def test_profile_child_itrerators_array():
             },
           'Parsing time': ANY,
           'Pipeline creation time': ANY,
+          'Arena bytes': ANY,
           'Total GIL time': ANY,
           'Warning': 'None',
           'Result processors profile': [
@@ -1249,9 +1255,9 @@ def test_ft_info():
          nodes = float(res['cluster_known_nodes'])
 
       # Initial size = sizeof(DocTable) + (INITIAL_DOC_TABLE_SIZE * sizeof(DMDChain *))
-      #              = 72 + (1000 * 16) = 16072 bytes
-      initial_doc_table_size_mb = 16072 / (1024 * 1024)
-      # Size of an empty TrieMap
+      #              = 96 + (1000 * 8) = 8096 bytes
+      initial_doc_table_size_mb = 8096 / (1024 * 1024)
+      # Size of an empty key map
       key_table_sz_mb = 24 / (1024 * 1024)
       total_index_memory_sz_mb = initial_doc_table_size_mb + key_table_sz_mb
 
@@ -1311,6 +1317,7 @@ def test_ft_info():
         'index_name': 'idx',
         'index_options': [],
         'indexing': 0.0,
+        'cold': 0.0,
         'inverted_sz_mb': 0.0,
         'key_table_size_mb': key_table_sz_mb,
         'tag_overhead_sz_mb': 0.0,
@@ -1391,6 +1398,7 @@ def test_ft_info():
         'index_name': 'idx',
         'index_options': [],
         'indexing': 0,
+        'cold': 0,
         'inverted_sz_mb': 0.0,
         'key_table_size_mb': nodes * key_table_sz_mb,
         'tag_overhead_sz_mb': 0.0,
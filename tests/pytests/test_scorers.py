@@ -361,6 +361,23 @@ def testScoreReplace(env):
         env.expect(debug_cmd(), 'GC_FORCEINVOKE', 'idx').equal('DONE')
         env.expect('FT.SEARCH idx redisearch withscores nocontent').equal([1, 'doc1', '0.3955628932786397'])
 
+def testScoreUnchangedRewrite(env):
+    # With _SKIP_UNCHANGED_DOCS, rewriting a document as it is does not index it again, so the
+    # scores of its matches stay as they are
+    conn = getConnectionByEnv(env)
+    env.assertEqual(run_command_on_all_shards(env, config_cmd(), 'SET', '_SKIP_UNCHANGED_DOCS', 'true'), ['OK'] * env.shardsCount)
+    env.expect('ft.create idx ON HASH schema f text').ok()
+    waitForIndex(env, 'idx')
+    conn.execute_command('HSET', 'doc1', 'f', 'redisearch')
+    res = env.cmd('FT.SEARCH idx redisearch withscores nocontent')
+    env.assertEqual(res[:2], [1, 'doc1'])
+    conn.execute_command('HSET', 'doc1', 'f', 'redisearch')
+    env.expect('FT.SEARCH idx redisearch withscores nocontent').equal(res)
+    if not env.isCluster():
+        env.expect('ft.config set FORK_GC_CLEAN_THRESHOLD 0').ok()
+        env.expect(debug_cmd(), 'GC_FORCEINVOKE', 'idx').equal('DONE')
+        env.expect('FT.SEARCH idx redisearch withscores nocontent').equal(res)
+
 def testScoreDecimal(env):
     env.expect('ft.create idx ON HASH schema title text').ok()
     waitForIndex(env, 'idx')
@@ -1,6 +1,6 @@
 # coding=utf-8
 from includes import *
-from common import getConnectionByEnv, waitForIndex, skip
+from common import getConnectionByEnv, waitForIndex, skip, config_cmd
 from RLTest import Env
 from redis import ResponseError
 
@@ -751,3 +751,37 @@ def test_sortable_unf(env):
 
 def test_sortable_NOunf(env):
     unf(env, is_sortable_unf=False)
+
+
+def test_query_plan_cache(env):
+    env = Env(moduleArgs = 'DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC', 'tag', 'TAG', 'g', 'GEO').ok()
+    for i in range(20):
+        conn.execute_command('HSET', f'doc{i}', 't', 'hello' if i % 2 else 'world', 'n', i,
+                             'tag', f'tag{i % 3}', 'g', f'{29.69 + i / 1000}, 34.95')
+
+    query = '(@t:$word | @tag:{$tag}) @n:[$min $max] -@g:[29.69 34.95 $radius km]'
+    def search(word, tag, min, max, radius):
+        return env.cmd('FT.SEARCH', 'idx', query, 'NOCONTENT', 'SORTBY', 'n', 'LIMIT', 0, 20, 'PARAMS', 10,
+                       'word', word, 'tag', tag, 'min', min, 'max', max, 'radius', radius)
+    params = [('hello', 'tag0', 0, 10, 0.5), ('world', 'tag2', 5, 19, 1), ('foo', 'tag1', 2, 12, 0.1)]
+    expected = [search(*p) for p in params]
+
+    env.expect(config_cmd(), 'SET', '_QUERY_PLAN_CACHE_ENTRIES', 16).ok()
+    # The first query caches the tree, which the others bind their own values to
+    for _ in range(2):
+        for p, res in zip(params, expected):
+            env.assertEqual(search(*p), res, message=p)
+
+    # The cached trees point at the fields, which are moved when fields are added
+    env.expect('FT.ALTER', 'idx', 'SCHEMA', 'ADD', 'other', 'TEXT').ok()
+    waitForIndex(env, 'idx')
+    for p, res in zip(params, expected):
+        env.assertEqual(search(*p), res, message=p)
+
+    # Queries whose attributes read parameters are parsed every time
+    scores = [float(env.cmd('FT.SEARCH', 'idx', '(@t:hello)=>{$weight: $w}', 'WITHSCORES', 'NOCONTENT',
+                            'LIMIT', 0, 1, 'SCORER', 'TFIDF', 'PARAMS', 2, 'w', weight)[2]) for weight in [1, 2]]
+    env.assertAlmostEqual(scores[1], 2 * scores[0], delta=1e-6)
+    env.expect(config_cmd(), 'SET', '_QUERY_PLAN_CACHE_ENTRIES', 0).ok()
@@ -260,3 +260,68 @@ def test_insufficient_docs_per_shard():
 
     res = env.cmd('FT.AGGREGATE', "idx", query, *params_and_args)
     env.assertEqual(len(res[1:]), expected_k)
+
+@skip(cluster=False)
+def test_learned_shard_window():
+    """The per-shard K of the index shrinks toward what the shards contribute to the top results"""
+    env = Env(moduleArgs='DEFAULT_DIALECT 2', protocol=3)
+
+    dim = 1
+    datatype = 'FLOAT32'
+    k = 100
+    num_docs = k * env.shardsCount * 3
+    set_up_database_with_vectors(env, dim, num_docs=num_docs, index_name='idx', datatype='FLOAT32')
+    env.expect(config_cmd(), 'SET', '_SHARD_WINDOW_TARGET_RECALL', 50).ok()
+
+    query = f'*=>[KNN {k} @v $query_vec]'
+    for _ in range(30):
+        query_vec = create_random_np_array_typed(dim, datatype)
+        res = env.cmd('FT.SEARCH', 'idx', query, 'PARAMS', 2, 'query_vec', query_vec.tobytes(),
+                      'nocontent', 'LIMIT', 0, k)
+        env.assertEqual(len(res['results']), k)
+
+    query_vec = create_random_np_array_typed(dim, datatype)
+    profile_res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', query, 'PARAMS', 2,
+                          'query_vec', query_vec.tobytes(), 'nocontent', 'LIMIT', 0, k)
+    env.assertEqual(len(profile_res['Results']['results']), k)
+    for shard in profile_res['Profile']['Shards']:
+        shard_result_count = shard['Result processors profile'][0]['Counter']
+        env.assertLess(shard_result_count, k)
+        env.assertGreaterEqual(shard_result_count, math.ceil(k / env.shardsCount))
+
+    # Queries setting their own ratio are left alone
+    ratio = 1 / float(env.shardsCount)
+    profile_res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY',
+                          f'{query}=>{{$shard_k_ratio: {ratio}}}', 'PARAMS', 2,
+                          'query_vec', query_vec.tobytes(), 'nocontent', 'LIMIT', 0, k + 1)
+    _validate_individual_shard_results(env, profile_res['Profile'], k, ratio, 'explicit ratio')
+
+@skip(cluster=False)
+def test_shard_window_second_round():
+    """The shards are asked again for the full K when one of them gave its whole window"""
+    env = Env(moduleArgs='DEFAULT_DIALECT 2', protocol=3)
+    conn = getConnectionByEnv(env)
+    k = 10
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'FLAT', 6, 'TYPE', 'FLOAT32', 'DIM', 1,
+               'DISTANCE_METRIC', 'L2').ok()
+    # The closest vectors are all in the shard of the hash tag
+    for i in range(k):
+        conn.execute_command('HSET', f'{{near}}:{i}', 'v', np.array([i], dtype=np.float32).tobytes())
+    for i in range(k * env.shardsCount):
+        conn.execute_command('HSET', f'far:{i}', 'v', np.array([1000 + i], dtype=np.float32).tobytes())
+    expected = [f'{{near}}:{i}' for i in range(k)]
+
+    ratio = 1 / float(env.shardsCount)
+    query = f'*=>[KNN {k} @v $query_vec]=>{{$shard_k_ratio: {ratio}}}'
+    args = ['PARAMS', 2, 'query_vec', np.array([0], dtype=np.float32).tobytes(), 'nocontent',
+            'LIMIT', 0, k]
+
+    # The shard of the closest vectors only gives its window of them
+    res = env.cmd('FT.SEARCH', 'idx', query, *args)
+    near = [r['id'] for r in res['results'] if r['id'].startswith('{near}')]
+    env.assertEqual(len(near), calculate_effective_k(k, ratio, env.shardsCount))
+
+    env.expect(config_cmd(), 'SET', '_SHARD_WINDOW_SECOND_ROUND', 'true').ok()
+    res = env.cmd('FT.SEARCH', 'idx', query, *args)
+    env.assertEqual(sorted(r['id'] for r in res['results']), expected)
+    env.expect(config_cmd(), 'SET', '_SHARD_WINDOW_SECOND_ROUND', 'false').ok()
@@ -0,0 +1,108 @@
+from common import *
+from RLTest import Env
+
+
+NUM_DOCS = 5000
+
+
+def populate(env):
+  conn = getConnectionByEnv(env)
+  env.expect('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC').ok()
+  pl = conn.pipeline(transaction=False)
+  for i in range(NUM_DOCS):
+    pl.execute_command('HSET', f'doc{i}', 't', 'hello world', 'n', i)
+  pl.execute()
+
+
+def slow_search(env):
+  # Replying with every document takes well over a millisecond
+  return env.cmd('FT.SEARCH', 'idx', '@t:hello @n:[0 +inf]', 'LIMIT', 0, NUM_DOCS)
+
+
+@skip(cluster=True)
+def test_slowlog_disabled(env: Env):
+  populate(env)
+  slow_search(env)
+  env.expect('FT.SLOWLOG', 'LEN').equal(0)
+  env.expect('FT.SLOWLOG', 'GET').equal([])
+
+
+@skip(cluster=True)
+def test_slowlog(env: Env):
+  populate(env)
+  env.expect(config_cmd(), 'SET', '_SLOWLOG_THRESHOLD_MS', '1').ok()
+
+  res = slow_search(env)
+  env.assertEqual(res[0], NUM_DOCS)
+  env.expect('FT.SLOWLOG', 'LEN').equal(1)
+
+  entries = env.cmd('FT.SLOWLOG', 'GET')
+  env.assertEqual(len(entries), 1)
+  entry = to_dict(entries[0])
+  env.assertEqual(entry['command'], 'FT.SEARCH')
+  env.assertEqual(entry['total_results'], NUM_DOCS)
+  env.assertGreaterEqual(float(entry['duration_ms']), 1)
+
+  # Neither the index name nor the terms are logged
+  env.assertNotEqual(entry['index'], 'idx')
+  env.assertTrue(entry['index'].startswith('Index@'), message=entry['index'])
+  env.assertEqual(entry['query'], 'Phrase{Token Numeric}')
+  env.assertNotContains('hello', entry['query'])
+
+  # The iterators, with their estimates and the number of results they read
+  plan = entry['plan']
+  env.assertTrue(plan[0].startswith('INTERSECT estimated='), message=plan)
+  env.assertContains(f'  TEXT estimated={NUM_DOCS} counter={NUM_DOCS}', plan)
+
+  times = to_dict(entry['times_ms'])
+  env.assertEqual(set(times.keys()), {'iterators', 'load', 'sort', 'reply', 'lock_wait'})
+  env.assertGreater(float(times['reply']), 0)
+
+  # The newest first
+  env.cmd('FT.AGGREGATE', 'idx', '*', 'LOAD', 1, '@n', 'LIMIT', 0, NUM_DOCS)
+  entries = env.cmd('FT.SLOWLOG', 'GET')
+  env.assertEqual(len(entries), 2)
+  newest, oldest = to_dict(entries[0]), to_dict(entries[1])
+  env.assertEqual(newest['command'], 'FT.AGGREGATE')
+  env.assertEqual(newest['query'], 'Wildcard')
+  env.assertEqual(newest['id'], oldest['id'] + 1)
+  env.assertEqual(len(env.cmd('FT.SLOWLOG', 'GET', 1)), 1)
+  env.assertEqual(len(env.cmd('FT.SLOWLOG', 'GET', -1)), 2)
+
+  env.expect('FT.SLOWLOG', 'RESET').ok()
+  env.expect('FT.SLOWLOG', 'LEN').equal(0)
+
+  # Fast queries are not logged
+  env.expect(config_cmd(), 'SET', '_SLOWLOG_THRESHOLD_MS', str(60 * 1000)).ok()
+  slow_search(env)
+  env.expect('FT.SLOWLOG', 'LEN').equal(0)
+
+
+@skip(cluster=True)
+def test_slowlog_max_len(env: Env):
+  populate(env)
+  env.expect(config_cmd(), 'SET', '_SLOWLOG_THRESHOLD_MS', '1').ok()
+  env.expect(config_cmd(), 'SET', '_SLOWLOG_MAX_LEN', '2').ok()
+
+  for _ in range(3):
+    slow_search(env)
+  env.expect('FT.SLOWLOG', 'LEN').equal(2)
+  ids = [to_dict(entry)['id'] for entry in env.cmd('FT.SLOWLOG', 'GET')]
+  env.assertEqual(len(ids), 2)
+  env.assertEqual(ids[0], ids[1] + 1)
+  newest = ids[0]
+
+  # The oldest entries are dropped when the log shrinks
+  env.expect(config_cmd(), 'SET', '_SLOWLOG_MAX_LEN', '1').ok()
+  slow_search(env)
+  ids = [to_dict(entry)['id'] for entry in env.cmd('FT.SLOWLOG', 'GET')]
+  env.assertEqual(ids, [newest + 1])
+
+
+@skip(cluster=True)
+def test_slowlog_errors(env: Env):
+  env.expect('FT.SLOWLOG').error().contains('wrong number of arguments')
+  env.expect('FT.SLOWLOG', 'FOO').error().contains('Unknown FT.SLOWLOG subcommand')
+  env.expect('FT.SLOWLOG', 'GET', 'abc').error().contains('Count must be a non-negative integer')
+  env.expect('FT.SLOWLOG', 'GET', -2).error().contains('Count must be a non-negative integer')
+  env.expect('FT.SLOWLOG', 'LEN', 1).error().contains('wrong number of arguments')
@@ -176,3 +176,51 @@ def testSpellCheckIssue437(env):
                'Tooni toque kerfuffle', 'TERMS',
                'EXCLUDE', 'slang', 'TERMS',
                'INCLUDE', 'slang').equal([['TERM', 'tooni', [['0', 'toonie']]]])
+
+@skip(cluster=True)
+def testSpellCheckScoresFollowIndexChanges(env):
+    # The document frequencies of the suggestions are cached until the index changes
+    env.cmd('ft.create', 'idx', 'ON', 'HASH', 'SCHEMA', 'name', 'TEXT', 'body', 'TEXT')
+    env.cmd('hset', 'doc1', 'name', 'name1', 'body', 'body1')
+    env.expect('ft.spellcheck', 'idx', 'name').equal([['TERM', 'name', [['1', 'name1']]]])
+    env.cmd('hset', 'doc2', 'name', 'name2', 'body', 'body2')
+    env.cmd('hset', 'doc3', 'name', 'name2', 'body', 'name2')
+    compare_lists(env, env.cmd('ft.spellcheck', 'idx', 'name'),
+                  [['TERM', 'name', [['0.66666666666666663', 'name2'], ['0.33333333333333331', 'name1']]]])
+    # Terms found in some of the queried fields only
+    compare_lists(env, env.cmd('ft.spellcheck', 'idx', '@body:name'),
+                  [['TERM', 'name', [['0.66666666666666663', 'name2']]]])
+    compare_lists(env, env.cmd('ft.spellcheck', 'idx', '@name:name'),
+                  [['TERM', 'name', [['0.66666666666666663', 'name2'], ['0.33333333333333331', 'name1']]]])
+
+@skip(cluster=True)
+def testSpellCheckDeleteIndex(env):
+    # The suggestions found in the deletion index of the terms are those found in their trie
+    env.cmd(config_cmd(), 'SET', 'FORK_GC_CLEAN_THRESHOLD', '0')
+    env.cmd('ft.create', 'idx', 'ON', 'HASH', 'SCHEMA', 'name', 'TEXT', 'body', 'TEXT')
+    words = ['spell', 'spells', 'spelling', 'shell', 'smell', 'spill', 'spoil', 'sell', 'spa',
+             'hello', 'help', 'helm', 'yellow', 'fellow', 'follow', 'hollow', 'a', 'ab', 'ba']
+    for i, w in enumerate(words):
+        env.cmd('hset', f'doc{i}', 'name', w, 'body', words[(i + 1) % len(words)])
+
+    queries = ['spel', 'speling', 'shel', 'helo', 'yelow', 'folow', 'xa', 'b', 'spellingz', 'hxllx']
+    def suggestions(enabled):
+        env.cmd(config_cmd(), 'SET', '_SPELLCHECK_DELETE_INDEX', 'true' if enabled else 'false')
+        res = []
+        for q in queries:
+            for distance in (1, 2, 3):
+                res.append(sorted(map(sorted, env.cmd('ft.spellcheck', 'idx', q, 'DISTANCE', distance))))
+        return res
+
+    expected = suggestions(False)
+    env.assertEqual(suggestions(True), expected)
+
+    # The index follows the terms added and removed while it is enabled
+    env.cmd('hset', 'doc100', 'name', 'spelt')
+    for key in ('doc0', 'doc17', 'doc18'):
+        env.cmd('del', key)
+    forceInvokeGC(env)
+    actual = suggestions(True)
+    env.assertEqual(actual, suggestions(False))
+    env.assertContains("'spelt'", str(actual))
+    env.assertNotContains("'spell'", str(actual))
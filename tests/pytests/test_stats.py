@@ -327,8 +327,8 @@ def testDocTableInfo(env):
     n = env.shardsCount
 
     # Initial size = sizeof(DocTable) + (INITIAL_DOC_TABLE_SIZE * sizeof(DMDChain *))
-    #              = 72 + (1000 * 16) = 16072 bytes
-    doc_table_size_mb = 16072 / (1024 * 1024)
+    #              = 96 + (1000 * 8) = 8096 bytes
+    doc_table_size_mb = 8096 / (1024 * 1024)
 
     d = index_info(env)
     env.assertEqual(int(d['num_docs']), 0)
@@ -344,12 +344,11 @@ def testDocTableInfo(env):
     doctable_size1 = float(d['doc_table_size_mb'])
     # exp_doc_table_size:
     # For each hash, the doc_table_size is increased by:
-    # = leanSize + sdsAllocSize(keyPtr)
-    # = (sizeof(RSDocumentMetadata) - sizeof(RSPayload *))  (No payload)
-    #   + (strlen(key) + 2)
-    # = (72 - 8) + 3 = 67
-    # 2 docs * 67 = 134
-    exp_doc_table_size = (n * doc_table_size_mb) + (134 / (1024 * 1024))
+    # = sizeof(RSDocumentMetadata) + sdsAllocSize(keyPtr)
+    # = 72 + (strlen(key) + 2)
+    # = 72 + 3 = 75
+    # 2 docs * 75 = 150
+    exp_doc_table_size = (n * doc_table_size_mb) + (150 / (1024 * 1024))
     env.assertEqual(doctable_size1, exp_doc_table_size)
     sortable_size1 = float(d['sortable_values_size_mb'])
     env.assertGreater(sortable_size1, 0)
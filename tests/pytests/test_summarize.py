@@ -1,6 +1,6 @@
 import os.path
 from includes import *
-from common import waitForIndex,toSortedFlatList, skip
+from common import waitForIndex,toSortedFlatList, skip, index_info, config_cmd, getConnectionByEnv
 
 
 GENTEXT = os.path.dirname(os.path.abspath(__file__)) + '/../ctests/genesis.txt'
@@ -249,3 +249,47 @@ def testHighlightAlias(env):
     # With explicit RETURN, the alias is returned as expected
     env.assertEqual(toSortedFlatList(env.cmd('ft.search idx foo highlight fields 1 f1_alias RETURN 1 f1_alias')),
                     toSortedFlatList([1, 'doc', ['f1_alias', '<b>foo</b> <b>foo</b> <b>foo</b>']]))
+
+
+@skip(cluster=True)
+def testSnippetCache(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'SCHEMA', 'txt', 'TEXT', 'n', 'NUMERIC', 'SORTABLE').ok()
+    for i in range(10):
+        conn.execute_command('HSET', f'doc{i}', 'txt', f'the quick brown fox {i} jumps over the lazy dog', 'n', i)
+    def cache_stats():
+        stats = index_info(env)['snippet_cache_stats']
+        return stats['hits'], stats['misses'], stats['entries']
+    queries = [
+        ['FT.SEARCH', 'idx', 'fox', 'HIGHLIGHT', 'FIELDS', 1, 'txt', 'SORTBY', 'n'],
+        ['FT.SEARCH', 'idx', 'fox dog', 'SUMMARIZE', 'FIELDS', 1, 'txt', 'LEN', 3, 'SORTBY', 'n'],
+        ['FT.SEARCH', 'idx', 'lazy', 'HIGHLIGHT', 'FIELDS', 1, 'txt', 'TAGS', '<i>', '</i>',
+         'SORTBY', 'n', 'LIMIT', 0, 3],
+    ]
+    expected = [env.cmd(*query) for query in queries]
+    # Nothing is cached unless enabled
+    env.assertNotContains('snippet_cache_stats', index_info(env))
+
+    env.expect(config_cmd(), 'SET', '_SNIPPET_CACHE_BYTES', 1 << 20).ok()
+    for query, res in zip(queries, expected):
+        env.assertEqual(env.cmd(*query), res, message=query)
+    # Each returned field is cached under its query terms and options
+    env.assertEqual(cache_stats(), (0, 23, 23))
+    for query, res in zip(queries, expected):
+        env.assertEqual(env.cmd(*query), res, message=query)
+    env.assertEqual(cache_stats(), (23, 23, 23))
+    env.assertGreater(index_info(env)['snippet_cache_stats']['bytes'], 0)
+
+    # An updated document is highlighted again
+    conn.execute_command('HSET', 'doc3', 'txt', 'a fox in a box')
+    res = env.cmd(*queries[0])
+    env.assertEqual(res[7], 'doc3')
+    env.assertEqual(dict(zip(res[8][::2], res[8][1::2]))['txt'], 'a <b>fox</b> in a box')
+    env.expect(config_cmd(), 'SET', '_SNIPPET_CACHE_BYTES', 0).ok()
+    env.assertEqual(env.cmd(*queries[0]), res)
+
+    # Snippets taking too much of the memory of the cache are not cached
+    env.expect(config_cmd(), 'SET', '_SNIPPET_CACHE_BYTES', 16).ok()
+    env.assertEqual(env.cmd(*queries[2]), expected[2])
+    env.assertEqual(cache_stats()[2], 0)
+    env.expect(config_cmd(), 'SET', '_SNIPPET_CACHE_BYTES', 0).ok()
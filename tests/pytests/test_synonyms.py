@@ -186,6 +186,30 @@ def testSkipInitialIndex(env):
     env.expect('FT.SEARCH idx1 @foo:xyz').equal([1, 'doc1', ['foo', 'bar']])
     env.expect('FT.SEARCH idx2 @foo:xyz').equal([0])
 
+def testSynonymUpdateRebuildsGroup(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE idx SCHEMA title text body text').ok()
+    conn.execute_command('HSET', 'doc1', 'title', 'red car', 'body', 'fast')
+    conn.execute_command('HSET', 'doc2', 'title', 'red auto', 'body', 'slow vehicle')
+    conn.execute_command('HSET', 'doc3', 'title', 'blue bike')
+
+    # The group is built from the documents indexed before it was defined, with the positions of all
+    # of its terms in each of them
+    env.expect('FT.SYNUPDATE idx g1 car auto vehicle').ok()
+    waitForIndex(env, 'idx')
+    env.expect('FT.SEARCH idx vehicle NOCONTENT SORTBY title').equal([2, 'doc2', 'doc1'])
+    env.expect('FT.SEARCH idx "red vehicle" NOCONTENT SORTBY title').equal([2, 'doc2', 'doc1'])
+    env.expect('FT.SEARCH idx @body:car NOCONTENT').equal([1, 'doc2'])
+    env.expect('FT.SEARCH idx bike NOCONTENT').equal([1, 'doc3'])
+
+    # The group is rebuilt with the terms added to it, along with the documents indexed since
+    conn.execute_command('HSET', 'doc4', 'title', 'green truck')
+    env.expect('FT.SYNUPDATE idx g1 truck').ok()
+    waitForIndex(env, 'idx')
+    env.expect('FT.SEARCH idx car NOCONTENT SORTBY title').equal([3, 'doc4', 'doc2', 'doc1'])
+    conn.execute_command('HSET', 'doc5', 'title', 'old car')
+    env.expect('FT.SEARCH idx truck NOCONTENT SORTBY title').equal([4, 'doc4', 'doc5', 'doc2', 'doc1'])
+
 def testDoubleDefinition(env):
     env.expect('FT.CREATE idx SCHEMA t text').ok()
     # Add the same synonym twice
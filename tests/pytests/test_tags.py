@@ -1005,3 +1005,84 @@ def testTagUNF():
     res = env.cmd('FT.AGGREGATE', 'idx_unf', '*', 'GROUPBY', '1', '@tag',
                   'REDUCE', 'COUNT', '0')
     env.assertEqual(res[0], 3)
+
+def testTagSetValues(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'perm', 'TAG').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc:{i}', 'perm', f'g{i % 10},all')
+
+    expected = sorted(f'doc:{i}' for i in range(100) if i % 10 in (1, 3))
+    def search(query, *params):
+        res = env.cmd('FT.SEARCH', 'idx', query, *params, 'NOCONTENT', 'LIMIT', 0, 100, 'DIALECT', 2)
+        return res[0], sorted(res[1:])
+
+    def check():
+        # A list of values passed in a parameter is split by the separator of the field
+        for query, params in [('@perm:{g1 | g3 | missing}', []),
+                              ('@perm:{$perm}', ['PARAMS', 2, 'perm', 'g1,g3,missing']),
+                              ('@perm:{$perm | g3}', ['PARAMS', 2, 'perm', 'G1, missing']),
+                              ('@perm:{g1 | g3 | g1}=>{$weight: 0}', []),
+                              ('-@perm:{$perm}', ['PARAMS', 2, 'perm', 'g0,g2,g4,g5,g6,g7,g8,g9'])]:
+            env.assertEqual(search(query, *params), (len(expected), expected), message=query)
+
+    check()
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_TAG_SET_MIN_VALUES', 2)
+    check()
+    # The cached sets are invalidated when the documents change
+    conn.execute_command('HSET', 'doc:3', 'perm', 'g5')
+    expected.remove('doc:3')
+    env.assertEqual(search('@perm:{g1 | g3}=>{$weight: 0}'), (len(expected), expected))
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_TAG_SET_MIN_VALUES', 0)
+
+def testFilterCache(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 't', 'TEXT', 'tenant', 'TAG', 'visible', 'NUMERIC').ok()
+    for i in range(100):
+        conn.execute_command('HSET', f'doc:{i}', 't', 'hello' if i % 2 else 'world',
+                             'tenant', f'tenant{i % 4}', 'visible', int(i % 3 != 0))
+
+    def search(query):
+        res = env.cmd('FT.SEARCH', 'idx', query, 'NOCONTENT', 'SORTBY', 'visible', 'LIMIT', 0, 100, 'DIALECT', 2)
+        return res[0], sorted(res[1:])
+    queries = ['@tenant:{tenant1} @visible:[1 1]', '@visible:[1 1] @tenant:{tenant1} hello',
+               '@tenant:{tenant1 | tenant2} @visible:[1 1] -world', '@tenant:{tenant1} @visible:[(0 1]']
+    expected = [search(query) for query in queries]
+
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_FILTER_CACHE_MIN_USES', 2)
+    # The filters are materialized by the second use, and read from the cache by the third
+    for _ in range(3):
+        for query, res in zip(queries, expected):
+            env.assertEqual(search(query), res, message=query)
+
+    # The cached filters are invalidated when the documents change
+    conn.execute_command('HSET', 'doc:1', 'visible', 0)
+    for query in queries:
+        env.assertNotContains('doc:1', search(query)[1], message=query)
+
+    if not env.isCluster():
+        conn.execute_command('HSET', 'doc:1', 'visible', 1)
+        profile = lambda: str(env.cmd('FT.PROFILE', 'idx', 'AGGREGATE', 'QUERY', '@tenant:{tenant1} @visible:[1 1]'))
+        env.assertNotContains('ID-LIST', profile())
+        env.assertContains('ID-LIST', profile())
+    run_command_on_all_shards(env, config_cmd(), 'SET', '_FILTER_CACHE_MIN_USES', 0)
+
+def testTagValsWithCounts(env):
+    conn = getConnectionByEnv(env)
+    env.expect('FT.CREATE', 'idx', 'ON', 'HASH', 'SCHEMA', 'color', 'TAG', 'n', 'NUMERIC').ok()
+    colors = ['red', 'red', 'red', 'blue', 'blue', 'green']
+    for i, color in enumerate(colors * 10):
+        conn.execute_command('HSET', f'doc:{i}', 'color', color, 'n', i)
+
+    env.expect('FT.TAGVALS', 'idx', 'color', 'WITHCOUNTS').equal([['red', 30], ['blue', 20], ['green', 10]])
+    env.expect('FT.TAGVALS', 'idx', 'color', 'WITHCOUNTS', 'MAX', 2).equal([['red', 30], ['blue', 20]])
+    env.expect('FT.TAGVALS', 'idx', 'color', 'WITHCOUNTS', 'QUERY', '*').equal([['red', 30], ['blue', 20], ['green', 10]])
+    # Only the documents matching the query are counted
+    env.expect('FT.TAGVALS', 'idx', 'color', 'WITHCOUNTS', 'QUERY', '@n:[0 11]').equal([['red', 6], ['blue', 4], ['green', 2]])
+    env.expect('FT.TAGVALS', 'idx', 'color', 'WITHCOUNTS', 'QUERY', '-@color:{red}').equal([['blue', 20], ['green', 10]])
+    env.expect('FT.TAGVALS', 'idx', 'color', 'WITHCOUNTS', 'QUERY', '@n:[1000 2000]').equal([])
+
+    env.expect('FT.TAGVALS', 'idx', 'color', 'MAX', 2).error().contains('QUERY and MAX require WITHCOUNTS')
+    env.expect('FT.TAGVALS', 'idx', 'color', 'WITHCOUNTS', 'MAX', 0).error().contains('MAX must be a positive integer')
+    env.expect('FT.TAGVALS', 'idx', 'color', 'WITHCOUNTS', 'QUERY', '@n:[').error()
+    env.expect('FT.TAGVALS', 'idx', 'color', 'BAD').error().contains('Unknown argument')
@@ -284,6 +284,30 @@ def test_del_reuse():
     env.expect('FT.SEARCH', 'idx', '*=>[KNN 4 @v $b]', 'PARAMS', '2', 'b', 'abcdefgh', 'RETURN', '1', 'v').equal(res)
 
 
+@skip(cluster=True)
+def test_update_vector_in_place():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 't', 'TEXT', 'n', 'NUMERIC',
+                         'v', 'VECTOR', 'HNSW', '6', 'TYPE', 'FLOAT32', 'DIM', '2', 'DISTANCE_METRIC', 'L2')
+    conn.execute_command('HSET', 'a', 't', 'hello', 'n', 1, 'v', 'aaaaaaaa')
+    conn.execute_command('HSET', 'b', 't', 'hello', 'n', 2, 'v', 'zzzzzzzz')
+    docId = env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'a')
+
+    # A change of the vector alone keeps the id of the document
+    conn.execute_command('HSET', 'a', 'v', 'zzzzzzzy')
+    env.assertEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'a'), docId)
+    env.expect('FT.SEARCH', 'idx', 'hello=>[KNN 1 @v $b]', 'PARAMS', '2', 'b', 'zzzzzzzy',
+               'RETURN', '1', 'v').equal([1, 'a', ['v', 'zzzzzzzy']])
+    env.expect('FT.SEARCH', 'idx', '@n:[1 1]=>[KNN 2 @v $b]', 'PARAMS', '2', 'b', 'aaaaaaaa',
+               'NOCONTENT').equal([1, 'a'])
+
+    # Removing the vector indexes the document again
+    conn.execute_command('HDEL', 'a', 'v')
+    env.assertNotEqual(env.cmd(debug_cmd(), 'DOCIDTOID', 'idx', 'a'), docId)
+    env.expect('FT.SEARCH', 'idx', '*=>[KNN 2 @v $b]', 'PARAMS', '2', 'b', 'aaaaaaaa',
+               'NOCONTENT').equal([1, 'b'])
+
 # test for issue https://github.com/RediSearch/RediSearch/pull/2705
 @skip(no_json=True)
 def test_update_with_bad_value():
@@ -1083,6 +1107,211 @@ def test_hybrid_query_batches_mode_with_tags():
                             sort_by_vector=False, scorer='TFIDF').equal(expected_res)
 
 
+def test_hybrid_query_batches_mode_filter_ids():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 2
+    index_size = 6000 * env.shardsCount
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '6', 'TYPE', 'FLOAT32',
+                         'DIM', dim, 'DISTANCE_METRIC', 'L2', 'tags', 'TAG', 'n', 'NUMERIC')
+    p = conn.pipeline(transaction=False)
+    for i in range(1, index_size + 1):
+        vector = create_np_array_typed([i] * dim, 'FLOAT32')
+        p.execute_command('HSET', i, 'v', vector.tobytes(), 'tags', 'even' if i % 2 == 0 else 'odd', 'n', i % 97)
+    p.execute()
+    query_data = create_np_array_typed([index_size / 2] * dim, 'FLOAT32')
+
+    queries = [
+        '(@tags:{even})=>[KNN 10 @v $vec_param]',
+        '(@tags:{odd} @n:[0 3])=>[KNN 10 @v $vec_param HYBRID_POLICY BATCHES]',
+        '(@n:[5 5])=>[KNN 20 @v $vec_param HYBRID_POLICY BATCHES BATCH_SIZE 50]',
+        # Fewer results than K
+        '(@tags:{even} @n:[1 1])=>[KNN 100 @v $vec_param HYBRID_POLICY BATCHES]',
+        '(@tags:{nothing})=>[KNN 10 @v $vec_param HYBRID_POLICY BATCHES]',
+    ]
+    for query in queries:
+        expected = env.cmd('FT.SEARCH', 'idx', query, 'SORTBY', '__v_score', 'PARAMS', 2,
+                           'vec_param', query_data.tobytes(), 'RETURN', 2, '__v_score', 'n', 'LIMIT', 0, 100)
+        env.expect(config_cmd(), 'SET', '_HYBRID_FILTER_IDS_MAX', index_size).ok()
+        env.expect('FT.SEARCH', 'idx', query, 'SORTBY', '__v_score', 'PARAMS', 2,
+                   'vec_param', query_data.tobytes(), 'RETURN', 2, '__v_score', 'n', 'LIMIT', 0, 100) \
+            .equal(expected)
+        env.expect(config_cmd(), 'SET', '_HYBRID_FILTER_IDS_MAX', 0).ok()
+
+    if env.isCluster():
+        return
+    # The batches are the same when matched against the ids of the filter
+    query = '(@n:[5 5])=>[KNN 20 @v $vec_param HYBRID_POLICY BATCHES BATCH_SIZE 50]'
+    def profile():
+        res = env.cmd('FT.PROFILE', 'idx', 'SEARCH', 'QUERY', query, 'SORTBY', '__v_score',
+                      'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT')
+        return to_dict(to_dict(res[1][1][0])['Iterators profile'])
+    before = profile()
+    env.expect(config_cmd(), 'SET', '_HYBRID_FILTER_IDS_MAX', index_size).ok()
+    after = profile()
+    env.expect(config_cmd(), 'SET', '_HYBRID_FILTER_IDS_MAX', 0).ok()
+    env.assertEqual(after['Batches number'], before['Batches number'])
+    env.assertGreater(before['Batches number'], 1)
+
+def test_knn_rerank_factor():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 4
+    index_size = 1000
+    for algo in ['FLAT', 'HNSW']:
+        conn.execute_command('FT.CREATE', algo, 'PREFIX', 1, algo, 'SCHEMA', 'v', 'VECTOR', algo, '6',
+                             'TYPE', 'FLOAT32', 'DIM', dim, 'DISTANCE_METRIC', 'COSINE')
+        p = conn.pipeline(transaction=False)
+        for i in range(1, index_size + 1):
+            vector = create_np_array_typed([i, i % 7, i % 13, 1], 'FLOAT32')
+            p.execute_command('HSET', f'{algo}:{i}', 'v', vector.tobytes())
+        p.execute()
+    query_data = create_np_array_typed([index_size / 2, 3, 5, 1], 'FLOAT32')
+
+    def scores(algo, attributes=None):
+        query = '*=>[KNN 10 @v $vec_param]' + (f'=>{{{attributes}}}' if attributes else '')
+        res = conn.execute_command('FT.SEARCH', algo, query,
+                                   'SORTBY', '__v_score', 'PARAMS', 2, 'vec_param', query_data.tobytes(),
+                                   'RETURN', 1, '__v_score')
+        return [row[1] for row in res[2::2]]
+
+    # The exact results
+    expected = scores('FLAT')
+    env.assertEqual(len(expected), 10)
+    for algo in ['FLAT', 'HNSW']:
+        for factor in [1, 1.5, 4, 100]:
+            env.assertEqual(scores(algo, f'$EF_RUNTIME: 500; $rerank_factor: {factor}' if algo == 'HNSW'
+                                   else f'$rerank_factor: {factor}'), expected, message=f'{algo} {factor}')
+        # K is larger than the index
+        res = env.cmd('FT.SEARCH', algo, f'*=>[KNN {2 * index_size} @v $vec_param]=>{{$rerank_factor: 2}}',
+                      'PARAMS', 2, 'vec_param', query_data.tobytes(), 'NOCONTENT', 'LIMIT', 0, 0)
+        env.assertEqual(res[0], index_size)
+
+    for factor in ['0.5', '101']:
+        env.expect('FT.SEARCH', 'HNSW', f'*=>[KNN 10 @v $vec_param]=>{{$rerank_factor: {factor}}}',
+                   'PARAMS', 2, 'vec_param', query_data.tobytes()).error() \
+            .contains('Rerank factor must be between 1 and 100')
+    env.expect('FT.SEARCH', 'HNSW', '*=>[KNN 10 @v $vec_param]=>{$rerank_factor: ten}',
+               'PARAMS', 2, 'vec_param', query_data.tobytes()).error().contains('Invalid rerank factor value')
+
+
+def test_knn_result_cache():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 4
+    index_size = 1000
+    for algo in ['FLAT', 'HNSW']:
+        conn.execute_command('FT.CREATE', algo, 'PREFIX', 1, algo, 'SCHEMA', 'v', 'VECTOR', algo, '6',
+                             'TYPE', 'FLOAT32', 'DIM', dim, 'DISTANCE_METRIC', 'L2', 'n', 'NUMERIC')
+        p = conn.pipeline(transaction=False)
+        for i in range(1, index_size + 1):
+            vector = create_np_array_typed([i, i % 7, i % 13, 1], 'FLOAT32')
+            p.execute_command('HSET', f'{algo}:{i}', 'v', vector.tobytes(), 'n', i % 10)
+        p.execute()
+    query_data = create_np_array_typed([index_size / 2, 3, 5, 1], 'FLOAT32')
+
+    queries = [
+        '*=>[KNN 10 @v $vec_param]',
+        '*=>[KNN 5 @v $vec_param]',
+        '*=>[KNN 10 @v $vec_param EF_RUNTIME 20]',
+        '*=>[KNN 10 @v $vec_param]=>{$rerank_factor: 2}',
+        # Filtered queries are not cached
+        '@n:[1 3]=>[KNN 10 @v $vec_param]',
+    ]
+    def search(algo, query):
+        return env.cmd('FT.SEARCH', algo, query, 'SORTBY', '__v_score', 'PARAMS', 2,
+                       'vec_param', query_data.tobytes(), 'RETURN', 1, '__v_score')
+
+    for algo in ['FLAT', 'HNSW']:
+        algo_queries = [q for q in queries if 'EF_RUNTIME' not in q or algo == 'HNSW']
+        expected = [search(algo, query) for query in algo_queries]
+        env.expect(config_cmd(), 'SET', '_KNN_RESULT_CACHE_ENTRIES', 16).ok()
+        # Cached by the first round, and read from the cache by the second
+        for _ in range(2):
+            for query, res in zip(algo_queries, expected):
+                env.assertEqual(search(algo, query), res, message=f'{algo} {query}')
+
+        # The cache is dropped once the index changes
+        conn.execute_command('HSET', f'{algo}:new', 'v', query_data.tobytes(), 'n', 0)
+        res = search(algo, queries[0])
+        env.assertEqual(res[1], f'{algo}:new')
+        env.assertEqual(res[2], ['__v_score', '0'])
+        conn.execute_command('DEL', f'{algo}:new')
+        env.assertEqual(search(algo, queries[0]), expected[0])
+        env.expect(config_cmd(), 'SET', '_KNN_RESULT_CACHE_ENTRIES', 0).ok()
+
+
+def test_range_query_filter_scan():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 2
+    index_size = 2000
+    for algo in ['FLAT', 'HNSW']:
+        conn.execute_command('FT.CREATE', algo, 'PREFIX', 1, algo, 'SCHEMA', 'v', 'VECTOR', algo, '6',
+                             'TYPE', 'FLOAT32', 'DIM', dim, 'DISTANCE_METRIC', 'L2', 'n', 'NUMERIC', 't', 'TAG')
+        p = conn.pipeline(transaction=False)
+        for i in range(1, index_size + 1):
+            vector = create_np_array_typed([i] * dim, 'FLOAT32')
+            p.execute_command('HSET', f'{algo}:{i}', 'v', vector.tobytes(), 'n', i % 100, 't', 'all')
+        p.execute()
+    query_data = create_np_array_typed([index_size / 2] * dim, 'FLOAT32')
+    # The vectors of 1000 +- 50
+    radius = 2 * 50 * 50
+
+    def search(algo, query):
+        res = env.cmd('FT.SEARCH', algo, f'{query} @v:[VECTOR_RANGE {radius} $vec]=>{{$yield_distance_as: dist}}',
+                      'SORTBY', 'dist', 'PARAMS', 2, 'vec', query_data.tobytes(), 'RETURN', 1, 'dist', 'LIMIT', 0, 200)
+        return res[0], sorted(res[1::2])
+
+    # A small filter is scanned, rather than intersected with the results of a range search
+    for query, matches, modes in [('@n:[7 7]', lambda i: i % 100 == 7, ['ADHOC_BF']),
+                                  ('@t:{all}', lambda i: True, ['ADHOC_BF', 'RANGE_QUERY'])]:
+        for algo in ['FLAT', 'HNSW']:
+            expected = sorted(f'{algo}:{i}' for i in range(950, 1051) if matches(i))
+            env.assertEqual(search(algo, query), (len(expected), expected), message=f'{algo} {query}')
+
+            if env.isCluster():
+                continue
+            res = env.cmd('FT.PROFILE', algo, 'SEARCH', 'QUERY',
+                          f'{query} @v:[VECTOR_RANGE {radius} $vec]=>{{$yield_distance_as: dist}}',
+                          'PARAMS', 2, 'vec', query_data.tobytes(), 'NOCONTENT')
+            iterators = to_dict(to_dict(res[1][1][0])['Iterators profile'])
+            metric = [to_dict(it) for it in iterators['Child iterators']
+                      if to_dict(it)['Type'] == 'METRIC - VECTOR DISTANCE'][0]
+            env.assertContains(metric['Vector search mode'], modes, message=f'{algo} {query}')
+
+
+@skip(cluster=True)
+def test_knn_search_batch():
+    env = Env(moduleArgs='DEFAULT_DIALECT 2')
+    conn = getConnectionByEnv(env)
+    dim = 2
+    conn.execute_command('FT.CREATE', 'idx', 'SCHEMA', 'v', 'VECTOR', 'HNSW', '6', 'TYPE', 'FLOAT32',
+                         'DIM', dim, 'DISTANCE_METRIC', 'L2', 't', 'TAG')
+    for i in range(1, 101):
+        conn.execute_command('HSET', i, 'v', create_np_array_typed([i] * dim, 'FLOAT32').tobytes(),
+                             't', 'even' if i % 2 == 0 else 'odd')
+    vectors = [create_np_array_typed([i] * dim, 'FLOAT32').tobytes() for i in [3, 50, 97]]
+    query = '(@t:{even})=>[KNN 3 @v $vec]'
+    args = ['SORTBY', '__v_score', 'RETURN', 1, '__v_score']
+
+    expected = [env.cmd('FT.SEARCH', 'idx', query, *args, 'PARAMS', 2, 'vec', vec) for vec in vectors]
+    env.expect('FT.SEARCH', 'idx', query, *args, 'BATCH', 'vec', len(vectors), *vectors).equal(expected)
+    # Along with other parameters
+    env.expect('FT.SEARCH', 'idx', '(@t:{$tag})=>[KNN 3 @v $vec]', *args, 'PARAMS', 2, 'tag', 'even',
+               'BATCH', 'vec', len(vectors), *vectors).equal(expected)
+
+    # A query which fails has its error in the reply
+    res = env.cmd('FT.SEARCH', 'idx', query, *args, 'BATCH', 'vec', 2, vectors[0], 'bad')
+    env.assertEqual(res[0], expected[0])
+    env.assertIsInstance(res[1], ResponseError)
+
+    env.expect('FT.SEARCH', 'idx', query, 'PARAMS', 2, 'vec', vectors[0], 'BATCH', 'vec', 1, vectors[1]) \
+        .error().contains('Duplicate parameter')
+    env.expect('FT.SEARCH', 'idx', query, 'BATCH', 'vec', 0).error().contains('BATCH takes between 1 and 1024 values')
+    env.expect('FT.SEARCH', 'idx', query, 'BATCH', 'vec', 2, vectors[0]).error().contains('Unknown argument')
+
+
 def test_hybrid_query_with_numeric():
     env = Env(moduleArgs='DEFAULT_DIALECT 2')
     conn = getConnectionByEnv(env)